@@ -0,0 +1,175 @@
+#include "AStarQuery.h"
+
+#include <GameEngine\FrameStats.h>
+#include <algorithm>
+
+void AStarQuery::Begin(int _start, int _end, const Grid & _grid, const Diagonal & _diagonal, OpenSet _openSet, const LandmarkTable* _landmarks)
+{
+		m_grid = &_grid;
+		m_diagonal = _diagonal;
+		m_openSet = _openSet;
+		//the distances of a table only hold for its own grid and movement
+		m_landmarks = _landmarks != nullptr && &_landmarks->GetGrid() == &_grid && _landmarks->GetDiagonal() == _diagonal ? _landmarks : nullptr;
+		m_start = _start;
+		m_end = _end;
+		m_numExpanded = 0;
+		GameEngine::FrameStats::Get().Add(GameEngine::STAT_PATH_QUERIES);
+		m_context->Begin(_grid.GetNumNodes());
+
+		const glm::ivec2 startCoord = _grid.GetCoord(_start);
+		const glm::ivec2 endCoord = _grid.GetCoord(_end);
+		if (!_grid.IsWalkable(_start) || !_grid.IsWalkable(_end))
+		{
+				m_status = Status::FAILED;
+				return;
+		}
+
+		SearchNode& startState = m_context->Visit(_start);
+		startState.h = PathFinder::SelectHeuristic(_diagonal)(startCoord, endCoord);
+		startState.inOpenSet = true;
+		if (m_openSet == OpenSet::BUCKETS)
+		{
+				m_context->GetBucketOpenSet().Push(_start);
+		}
+		else
+		{
+				m_context->GetOpenSet().Push(_start);
+		}
+		m_status = Status::IN_PROGRESS;
+}
+
+AStarQuery::Status AStarQuery::Step(size_t _maxExpansions)
+{
+		if (m_status != Status::IN_PROGRESS)
+		{
+				return m_status;
+		}
+		switch (m_diagonal)
+		{
+				case Diagonal::ALWAYS: return Step<Diagonal::ALWAYS>(_maxExpansions);
+				case Diagonal::IFNOWALLS: return Step<Diagonal::IFNOWALLS>(_maxExpansions);
+				case Diagonal::IFLESSTHANTWOWALLS: return Step<Diagonal::IFLESSTHANTWOWALLS>(_maxExpansions);
+				default: return Step<Diagonal::NEVER>(_maxExpansions);
+		}
+}
+
+template <Diagonal D>
+AStarQuery::Status AStarQuery::Step(size_t _maxExpansions)
+{
+		using HeuristicType = typename DiagonalHeuristic<D>::Type;
+		if (m_openSet == OpenSet::BUCKETS)
+		{
+				return Expand<D, HeuristicType>(m_context->GetBucketOpenSet(), _maxExpansions);
+		}
+		return Expand<D, HeuristicType>(m_context->GetOpenSet(), _maxExpansions);
+}
+
+template <Diagonal D, class HeuristicType, class OpenSetType>
+AStarQuery::Status AStarQuery::Expand(OpenSetType& _openSet, size_t _maxExpansions)
+{
+		const HeuristicType heuristic{};
+		const glm::ivec2 endCoord = m_grid->GetCoord(m_end);
+		//the landmark distances of the goal are taken again every step, so a landmark rebuilt between two steps is never mixed up
+		std::shared_lock<std::shared_timed_mutex> landmarkLock;
+		LandmarkTable::Goal landmarkGoal;
+		bool useLandmarks = false;
+		if (m_landmarks != nullptr)
+		{
+				landmarkLock = m_landmarks->LockShared();
+				useLandmarks = m_landmarks->GetGoal(m_end, landmarkGoal);
+		}
+		auto estimate = [&](int _node, const glm::ivec2& _coord)
+		{
+				const int h = heuristic(_coord, endCoord);
+				return useLandmarks ? std::max(h, m_landmarks->Estimate(landmarkGoal, _node)) : h;
+		};
+
+		for (size_t expansion = 0; expansion < _maxExpansions; expansion++)
+		{
+				if (_openSet.IsEmpty())
+				{
+						m_status = Status::FAILED;
+						return m_status;
+				}
+
+				const int current = _openSet.Front();
+				SearchNode& currentState = m_context->At(current);
+				const glm::ivec2 currentCoord = m_grid->GetCoord(current);
+				currentState.inOpenSet = false;
+				_openSet.Pop();
+
+				currentState.inClosedSet = true;
+				m_numExpanded++;
+				GameEngine::FrameStats::Get().Add(GameEngine::STAT_EXPANDED_NODES);
+
+				//check if the end was found
+				if (current == m_end)
+				{
+						m_status = Status::FOUND;
+						return m_status;
+				}
+
+				//get all the walkable neightbors
+				m_grid->GetNeighbors<D>(current, m_neighbors);
+				for (int neighbor : m_neighbors)
+				{
+						SearchNode& neighborState = m_context->Visit(neighbor);
+						const glm::ivec2 neighborCoord = m_grid->GetCoord(neighbor);
+						//get the g cost of the neighbor
+						int newG = currentState.g + heuristic(currentCoord, neighborCoord) + m_grid->GetTerrainCost(neighbor);
+
+						if (neighborState.inOpenSet)
+						{
+								//node already generated, but not expanded
+								if (newG < neighborState.g)
+								{
+										//new path is cheaper
+										neighborState.g = newG;
+										neighborState.h = estimate(neighbor, neighborCoord);
+										neighborState.parent = current;
+										//move the node up the open set with its lowered cost
+										_openSet.Update(neighbor);
+								}
+						}
+						else if (neighborState.inClosedSet)
+						{
+								if (newG < neighborState.g)
+								{
+										//new path is cheaper
+										neighborState.g = newG;
+										neighborState.h = estimate(neighbor, neighborCoord);
+										neighborState.parent = current;
+										neighborState.inClosedSet = false;
+										neighborState.inOpenSet = true;
+										_openSet.Push(neighbor);
+								}
+						}
+						else
+						{
+								neighborState.g = newG;
+								neighborState.h = estimate(neighbor, neighborCoord);
+								neighborState.parent = current;
+								neighborState.inOpenSet = true;
+								_openSet.Push(neighbor);
+						}
+				}
+		}
+		return m_status;
+}
+
+AStarQuery::Status AStarQuery::Run()
+{
+		while (Step(static_cast<size_t>(-1)) == Status::IN_PROGRESS)
+		{
+		}
+		return m_status;
+}
+
+std::vector<int> AStarQuery::GetPath() const
+{
+		if (m_status != Status::FOUND)
+		{
+				return std::vector<int>();
+		}
+		return PathFinder::Backtrace(m_start, m_end, *m_context);
+}
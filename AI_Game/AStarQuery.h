@@ -0,0 +1,60 @@
+#pragma once
+
+#include "PathFinder.h"
+
+/** \brief A suspendable A* search over the flat node indices of a grid.
+	*  Step() expands a limited number of nodes and returns, the next call carries on from the open and closed state saved in the context,
+	*  so a long search can be spread over several frames instead of giving up after a fixed number of iterations */
+class AStarQuery
+{
+public:
+		enum class Status
+		{
+				IN_PROGRESS,
+				FOUND,
+				FAILED
+		};
+
+		/** \brief \param _context - the search state of the query, it must not be used by anything else until the query is done */
+		AStarQuery(SearchContext& _context) : m_context(&_context) {}
+		~AStarQuery() {}
+
+		/** \brief Starts a new search from _start to _end (the grid is only read and has to stay alive until the query is done)
+			*  \param _openSet - the container of the open set in the context, see OpenSet
+			*  \param _landmarks - the landmark distances of the grid for a closer heuristic (ignored unless they are for _grid and _diagonal),
+			*  they have to stay alive until the query is done */
+		void Begin(int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, OpenSet _openSet = OpenSet::BINARY_HEAP,
+				const LandmarkTable* _landmarks = nullptr);
+
+		/** \brief Expands up to _maxExpansions nodes
+			*  \return IN_PROGRESS if the budget ran out before the search finished */
+		Status Step(size_t _maxExpansions);
+
+		/** \brief Runs the search to the end */
+		Status Run();
+
+		Status GetStatus() const noexcept { return m_status; }
+		/** \brief Gets the number of nodes expanded so far */
+		size_t GetNumExpanded() const noexcept { return m_numExpanded; }
+
+		/** \brief The node indices of the path from the end to (not including) the start, empty unless the status is FOUND */
+		std::vector<int> GetPath() const;
+
+private:
+		/** \brief Step specialized on the diagonal mode (the neighbors and the heuristic) and the open set, picked once per Step */
+		template <Diagonal D>
+		Status Step(size_t _maxExpansions);
+		template <Diagonal D, class HeuristicType, class OpenSetType>
+		Status Expand(OpenSetType& _openSet, size_t _maxExpansions);
+
+		SearchContext* m_context{ nullptr };
+		const Grid* m_grid{ nullptr };
+		Diagonal m_diagonal{ Diagonal::NEVER };
+		OpenSet m_openSet{ OpenSet::BINARY_HEAP };
+		const LandmarkTable* m_landmarks{ nullptr };
+		int m_start{ -1 };
+		int m_end{ -1 };
+		Status m_status{ Status::FAILED };
+		size_t m_numExpanded{ 0 };
+		Grid::NeighborList m_neighbors;
+};
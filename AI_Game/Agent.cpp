@@ -14,7 +14,7 @@ Agent::Agent(float _speed, float _health, const glm::vec2 & _startPos,
 
 Agent::~Agent() {}
 
-void Agent::Draw(GameEngine::SpriteBatch & _batch)
+void Agent::Draw(GameEngine::GlyphRecorder & _batch)
 {
 		const glm::vec4 uvRect(0.0f, 0.0f, 1.0f, 1.0f);
 
@@ -29,22 +29,25 @@ void Agent::Draw(GameEngine::SpriteBatch & _batch)
 
 bool Agent::CollideWithLevel()
 {
-		std::vector<glm::vec2> collideTilePositions;
+		const std::shared_ptr<Grid> grid = m_world.lock()->GetWorldGrid().lock();
+		//at most one tile per corner, so they fit on the stack
+		std::array<glm::vec2, 4> collideTilePositions;
+		size_t numCollideTiles = 0;
 		// Check the four corners
 		// First corner (bottom left)
-		CheckTilePosition(collideTilePositions, m_worldPos.x, m_worldPos.y);
+		CheckTilePosition(*grid, collideTilePositions, numCollideTiles, m_worldPos.x, m_worldPos.y);
 
 		// Second Corner (bottom right)
-		CheckTilePosition(collideTilePositions, m_worldPos.x + AGENT_DIAMETER, m_worldPos.y);
+		CheckTilePosition(*grid, collideTilePositions, numCollideTiles, m_worldPos.x + AGENT_DIAMETER, m_worldPos.y);
 
 		// Third Corner (top left)
-		CheckTilePosition(collideTilePositions, m_worldPos.x, m_worldPos.y + AGENT_DIAMETER);
+		CheckTilePosition(*grid, collideTilePositions, numCollideTiles, m_worldPos.x, m_worldPos.y + AGENT_DIAMETER);
 
 		// Fourth Corner (top right)
-		CheckTilePosition(collideTilePositions, m_worldPos.x + AGENT_DIAMETER, m_worldPos.y + AGENT_DIAMETER);
+		CheckTilePosition(*grid, collideTilePositions, numCollideTiles, m_worldPos.x + AGENT_DIAMETER, m_worldPos.y + AGENT_DIAMETER);
 
 		// Check if there was no collision
-		if (collideTilePositions.empty())
+		if (numCollideTiles == 0)
 		{
 				return false;
 		}
@@ -52,18 +55,19 @@ bool Agent::CollideWithLevel()
 		glm::vec2 localWorld = m_worldPos + glm::vec2(AGENT_RADIUS); 
 
 		/*sort the tiles to collide based on distance from the center of the player,
-		so that you collide with the nearest walls first and avoid the getting stuck on walls bug */
-		std::sort(collideTilePositions.begin(), collideTilePositions.end(), [&localWorld](const glm::vec2& _p1, const glm::vec2& _p2) 
-		{ 
-				auto distance1 = glm::distance(localWorld, _p1);
-				auto distance2 = glm::distance(localWorld, _p2);
-				return distance1 < distance2;
+		so that you collide with the nearest walls first and avoid the getting stuck on walls bug
+		(the squared distances sort the same, without a square root per comparison) */
+		std::sort(collideTilePositions.begin(), collideTilePositions.begin() + numCollideTiles, [&localWorld](const glm::vec2& _p1, const glm::vec2& _p2)
+		{
+				const glm::vec2 offset1 = _p1 - localWorld;
+				const glm::vec2 offset2 = _p2 - localWorld;
+				return glm::dot(offset1, offset1) < glm::dot(offset2, offset2);
 		});
 
 		// Do the collision starting from closes tile to collide with to furthest
-		for (auto& tilePos : collideTilePositions)
+		for (size_t i = 0; i < numCollideTiles; i++)
 		{
-				CollideWithTile(tilePos);
+				CollideWithTile(collideTilePositions[i]);
 		}
 		return true;
 }
@@ -99,14 +103,14 @@ void Agent::ApplyDamage(float _damage)
 		m_health -= _damage;
 }
 
-void Agent::CheckTilePosition(std::vector<glm::vec2>& _collideTilePositions, float _x, float _y)
+void Agent::CheckTilePosition(const Grid& _grid, std::array<glm::vec2, 4>& _collideTilePositions, size_t& _numCollideTiles, float _x, float _y)
 {
 		//Get the node/tile at this agent's world pos
-		std::weak_ptr<Node> node = m_world.lock()->GetWorldGrid().lock()->GetNodeAt(glm::vec2(_x, _y));
+		const int node = _grid.GetIndexAt(glm::vec2(_x, _y));
 		//if this is not a walkable tile, then collide with it
-		if (!node.lock()->walkable)
+		if (!_grid.IsWalkable(node))
 		{
-				_collideTilePositions.push_back(node.lock()->worldPos);
+				_collideTilePositions[_numCollideTiles++] = _grid.GetWorldPos(node);
 		}
 }
 
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 
 #include <glm\vec2.hpp>
 
@@ -28,8 +29,8 @@ public:
 		virtual void Update(float _deltaTime) = 0;
 
 		/** \brief The Draw function to be called every frame by the agents
-		 *  \param _batch - the batch which this agent's sprite will be submitted to */
-		virtual void Draw(GameEngine::SpriteBatch& _batch);
+		 *  \param _batch - the batch (or per-thread recorder of a batch) which this agent's sprite will be submitted to */
+		virtual void Draw(GameEngine::GlyphRecorder& _batch);
 
 		/** \brief Collision handler with the world (current level) */
 		bool CollideWithLevel();
@@ -55,8 +56,8 @@ public:
 		void SetSpeed(float _newSpeed)														   { m_movementSpeed = _newSpeed; }
 
 protected:
-		/** \brief Checks the tile at position _x, _y if it's collidable */
-		void CheckTilePosition(std::vector<glm::vec2>& _collideTilePositions, float _x, float _y);
+		/** \brief Checks the tile at position _x, _y if it's collidable, and adds its center to the first _numCollideTiles positions if it is */
+		void CheckTilePosition(const Grid& _grid, std::array<glm::vec2, 4>& _collideTilePositions, size_t& _numCollideTiles, float _x, float _y);
 
 		/** \brief Collision handler with 1 tile at position _tilePos */
 		void CollideWithTile(const glm::vec2& _tilePos);
@@ -1,11 +1,9 @@
 #include "AlertState.h"
 #include "Zombie.h"
-#include "PatrolState.h"
-#include "ChaseState.h"
 
-AlertState::AlertState(Zombie* _ownerZombie) : ZombieState(_ownerZombie)
+AlertState::AlertState()
 {
-		m_timer.Start();
+		m_clock.Start();
 }
 
 
@@ -13,15 +11,21 @@ AlertState::~AlertState()
 {
 }
 
-void AlertState::Update(float _deltaTime)
+void AlertState::Enter(Zombie&, ZombieStateData& _data)
 {
-		if (!CheckForPlayer())
+		_data.alertStart = m_clock.Seconds();
+}
+
+unsigned char AlertState::Update(Zombie& _zombie, ZombieStateData& _data, float)
+{
+		if (!CheckForPlayer(_zombie))
 		{
 				//player went outside of sight
-				m_zombie->m_stateManager.SetState(new PatrolState(m_zombie));
+				return PLAYER_LOST;
 		}
-		else if (m_timer.Seconds() >= 3.0f)
+		else if (m_clock.Seconds() - _data.alertStart >= 3.0f && CanSeePlayer(_zombie))
 		{
-				m_zombie->m_stateManager.SetState(new ChaseState(m_zombie));
+				return ALERT_TIMEOUT;
 		}
-}
\ No newline at end of file
+		return NO_EVENT;
+}
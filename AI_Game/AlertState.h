@@ -7,12 +7,12 @@
 class AlertState :	public ZombieState
 {
 public:
-		AlertState(Zombie* _ownerZombie);
+		AlertState();
 		~AlertState();
 
-		void Update(float _deltaTime) override;
+		void Enter(Zombie& _zombie, ZombieStateData& _data) override;
+		unsigned char Update(Zombie& _zombie, ZombieStateData& _data, float _deltaTime) override;
 
 private:
-		GameEngine::HRTimer m_timer;
+		GameEngine::HRTimer m_clock; ///< runs from the creation of the state, the zombies keep when they got alerted on it
 };
-
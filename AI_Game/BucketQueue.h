@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cassert>
+#include <vector>
+
+/** \brief Priority queue of integer keys in [0, capacity) with small non-negative integer priorities (Dial's algorithm): one bucket per
+	*  priority, the keys of a bucket in a linked list threaded through arrays by key, and a cursor on the lowest bucket which isn't empty.
+	*  Push, Remove and Update are O(1), Pop only walks the empty buckets up to the next priority, so when the priorities popped never
+	*  decrease (Dijkstra, or A* with a consistent heuristic) a whole search walks every bucket once. A priority under the cursor still works,
+	*  the cursor just moves back to it. It has the interface of IndexedHeap, so the searches can use either.
+	*  Priority gives the priority of a key (lower pops first) and is read when the key is pushed or updated. The keys of a bucket pop
+	*  newest first, which for A* prefers the nodes deepest in the search like the h tie break of ComparePriority does */
+template <class Priority>
+class BucketQueue
+{
+public:
+		BucketQueue(const Priority& _priority = Priority()) : m_priority(_priority) {}
+		//Cleanup
+		~BucketQueue() { m_heads.clear(); }
+
+		/** \brief Makes room for the keys 0 to _numKeys - 1 and empties the queue */
+		void Reserve(size_t _numKeys)
+		{
+				Clear();
+				if (m_buckets.size() != _numKeys)
+				{
+						m_buckets.assign(_numKeys, NOT_IN_QUEUE);
+						m_next.assign(_numKeys, NONE);
+						m_previous.assign(_numKeys, NONE);
+				}
+		}
+
+		/** \brief Replaces the priority function (e.g. when the array it reads was reallocated) */
+		void SetComparator(const Priority& _priority) { m_priority = _priority; }
+
+		/** \brief Check if the container is empty
+			*		\return true if empty */
+		bool IsEmpty() const { return m_size == 0; }
+
+		/** \brief Getter for the container size
+			*		\return number of elements in the container */
+		size_t Size() const { return m_size; }
+
+		/** \brief Gets the element with the highest priority (the lowest value) */
+		int Front() const { return m_heads[m_cursor]; }
+
+		/** \brief Checks if the key is in the queue in O(1) */
+		bool Contains(int _item) const { return m_buckets[_item] != NOT_IN_QUEUE; }
+
+		/** \brief Adds a key (which must not be in the queue yet) */
+		void Push(int _item)
+		{
+				const int bucket = m_priority(_item);
+				assert(bucket >= 0 && "BucketQueue: the priorities can't be negative");
+				if (static_cast<size_t>(bucket) >= m_heads.size())
+				{
+						m_heads.resize(bucket + 1, NONE);
+				}
+				Link(_item, bucket);
+				if (m_size == 0 || bucket < m_cursor)
+				{
+						m_cursor = bucket;
+				}
+				if (bucket > m_last)
+				{
+						m_last = bucket;
+				}
+				m_size++;
+		}
+
+		/** \brief Removes the element with the highest priority */
+		void Pop()
+		{
+				Remove(m_heads[m_cursor]);
+		}
+
+		/** \brief Removes a specific key from the queue in O(1) */
+		void Remove(int _item)
+		{
+				Unlink(_item);
+				m_buckets[_item] = NOT_IN_QUEUE;
+				m_size--;
+				AdvanceCursor();
+		}
+
+		/** \brief Moves _item to the bucket of its new priority (O(1) decrease-key, an increase works too) */
+		void Update(int _item)
+		{
+				Remove(_item);
+				Push(_item);
+		}
+
+		/** \brief Clears the container, only touching the buckets between the lowest and the highest priority pushed */
+		void Clear()
+		{
+				if (m_size > 0)
+				{
+						for (int bucket = m_cursor; bucket <= m_last; bucket++)
+						{
+								for (int item = m_heads[bucket]; item != NONE; item = m_next[item])
+								{
+										m_buckets[item] = NOT_IN_QUEUE;
+								}
+								m_heads[bucket] = NONE;
+						}
+				}
+				m_size = 0;
+				m_cursor = 0;
+				m_last = -1;
+		}
+
+private:
+		enum : int { NOT_IN_QUEUE = -1, NONE = -1 }; ///< the bucket of the keys that aren't in the queue, the end of a bucket's list
+
+		void Link(int _item, int _bucket)
+		{
+				m_buckets[_item] = _bucket;
+				m_previous[_item] = NONE;
+				m_next[_item] = m_heads[_bucket];
+				if (m_heads[_bucket] != NONE)
+				{
+						m_previous[m_heads[_bucket]] = _item;
+				}
+				m_heads[_bucket] = _item;
+		}
+
+		void Unlink(int _item)
+		{
+				const int next = m_next[_item];
+				const int previous = m_previous[_item];
+				if (next != NONE)
+				{
+						m_previous[next] = previous;
+				}
+				if (previous != NONE)
+				{
+						m_next[previous] = next;
+				}
+				else
+				{
+						m_heads[m_buckets[_item]] = next;
+				}
+		}
+
+		//keeps the cursor on the lowest bucket with a key, the buckets under it are always empty
+		void AdvanceCursor()
+		{
+				if (m_size == 0)
+				{
+						m_cursor = 0;
+						m_last = -1;
+						return;
+				}
+				while (m_heads[m_cursor] == NONE)
+				{
+						m_cursor++;
+				}
+		}
+
+		std::vector<int> m_heads;    ///< the newest key of every bucket (NONE if it's empty), grown to the highest priority pushed
+		std::vector<int> m_buckets;  ///< the bucket of every key (NOT_IN_QUEUE if it isn't in it)
+		std::vector<int> m_next;     ///< the next (older) key in the same bucket
+		std::vector<int> m_previous; ///< the previous (newer) key in the same bucket
+		size_t m_size{ 0 };
+		int m_cursor{ 0 };  ///< the lowest bucket which isn't empty
+		int m_last{ -1 };   ///< the highest bucket pushed to since the queue was last empty, Clear stops there
+		Priority m_priority; ///< gives the bucket of a key
+};
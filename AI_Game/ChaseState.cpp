@@ -1,8 +1,7 @@
 #include "ChaseState.h"
-#include "AlertState.h"
 #include "Zombie.h"
 
-ChaseState::ChaseState(Zombie* _ownerZombie) : ZombieState(_ownerZombie)
+ChaseState::ChaseState()
 {
 }
 
@@ -11,20 +10,21 @@ ChaseState::~ChaseState()
 {
 }
 
-void ChaseState::Update(float _deltaTime)
+unsigned char ChaseState::Update(Zombie& _zombie, ZombieStateData&, float _deltaTime)
 {
 		//chase the player by just going in its direction
-		glm::vec2 directionToPlayer = glm::normalize(m_zombie->m_player.lock()->GetCenterPos() - m_zombie->GetCenterPos());
-		m_zombie->m_direction = directionToPlayer;
-		m_zombie->m_worldPos += directionToPlayer * m_zombie->m_movementSpeed * _deltaTime;
+		glm::vec2 directionToPlayer = glm::normalize(_zombie.m_player.lock()->GetCenterPos() - _zombie.GetCenterPos());
+		_zombie.m_direction = directionToPlayer;
+		_zombie.m_worldPos += directionToPlayer * _zombie.m_movementSpeed * _deltaTime;
 
-		if (!m_zombie->CollideWithAgent(m_zombie->m_player.lock().get()))
+		if (!_zombie.CollideWithAgent(_zombie.m_player.lock().get()))
 		{
 				//collision handle
 		}
 
-		if (!CheckForPlayer())
+		if (!CheckForPlayer(_zombie))
 		{
-				m_zombie->m_stateManager.SetState(new AlertState(m_zombie));
+				return PLAYER_LOST;
 		}
-}
\ No newline at end of file
+		return NO_EVENT;
+}
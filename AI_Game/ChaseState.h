@@ -7,9 +7,8 @@
 class ChaseState :	public ZombieState
 {
 public:
-		ChaseState(Zombie* _ownerZombie);
+		ChaseState();
 		~ChaseState();
 
-		void Update(float _deltaTime) override;
+		unsigned char Update(Zombie& _zombie, ZombieStateData& _data, float _deltaTime) override;
 };
-
@@ -0,0 +1,283 @@
+#include "DStarLite.h"
+
+#include <algorithm>
+
+#include <GameEngine\FrameStats.h>
+
+void DStarLite::Begin(int _start, int _goal, const Grid & _grid, const Diagonal & _diagonal)
+{
+		m_grid = &_grid;
+		m_diagonal = _diagonal;
+		m_heuristic = PathFinder::SelectHeuristic(_diagonal);
+		m_start = _start;
+		m_goal = _goal;
+		m_keyModifier = 0;
+		m_changeVersion = _grid.GetChangeVersion();
+		m_numExpanded = 0;
+		GameEngine::FrameStats::Get().Add(GameEngine::STAT_PATH_QUERIES);
+
+		const DStarNode unreached{ INFINITE_COST, INFINITE_COST, INFINITE_COST, INFINITE_COST };
+		m_nodes.assign(_grid.GetNumNodes(), unreached);
+		//the open set compares through m_nodes, which may just have been reallocated
+		m_openSet.Reserve(_grid.GetNumNodes());
+		m_openSet.SetComparator(CompareKey(m_nodes.data()));
+
+		//the search grows from the goal, an unwalkable goal isn't an error yet because it might become walkable
+		m_nodes[_goal].rhs = ComputeRhs(_goal);
+		UpdateNode(_goal);
+		m_status = Status::IN_PROGRESS;
+}
+
+void DStarLite::SetStart(int _start)
+{
+		if (m_grid && _start != m_start)
+		{
+				//the keys in the open set were computed with the old start, the distance it moved keeps them lower bounds
+				m_keyModifier += m_heuristic(m_grid->GetCoord(m_start), m_grid->GetCoord(_start));
+				m_start = _start;
+				if (m_status == Status::FOUND)
+				{
+						m_status = Status::IN_PROGRESS;
+				}
+		}
+}
+
+DStarLite::Status DStarLite::Update(size_t _maxExpansions)
+{
+		if (!m_grid)
+		{
+				return m_status;
+		}
+		ApplyChanges();
+
+		for (size_t expansion = 0; ; expansion++)
+		{
+				//done once the start is consistent and nothing in the open set can lower its cost anymore
+				const DStarNode& start = m_nodes[m_start];
+				bool done = m_openSet.IsEmpty();
+				if (!done && start.rhs == start.g)
+				{
+						//the key of the start is only computed here, it may be in the open set with an older one
+						int startKey1 = 0;
+						int startKey2 = 0;
+						CalculateKey(m_start, startKey1, startKey2);
+						const DStarNode& front = m_nodes[m_openSet.Front()];
+						done = front.key1 > startKey1 || (front.key1 == startKey1 && front.key2 >= startKey2);
+				}
+				if (done)
+				{
+						m_status = start.g < INFINITE_COST ? Status::FOUND : Status::FAILED;
+						return m_status;
+				}
+				if (expansion == _maxExpansions)
+				{
+						m_status = Status::IN_PROGRESS;
+						return m_status;
+				}
+
+				const int current = m_openSet.Front();
+				DStarNode& currentState = m_nodes[current];
+				int key1 = 0;
+				int key2 = 0;
+				CalculateKey(current, key1, key2);
+				if (currentState.key1 < key1 || (currentState.key1 == key1 && currentState.key2 < key2))
+				{
+						//the key was older than the last move of the start, put it back where it belongs now
+						currentState.key1 = key1;
+						currentState.key2 = key2;
+						m_openSet.Update(current);
+						continue;
+				}
+				m_numExpanded++;
+				GameEngine::FrameStats::Get().Add(GameEngine::STAT_EXPANDED_NODES);
+
+				m_grid->GetNeighbors(current, m_diagonal, m_neighbors);
+				if (currentState.g > currentState.rhs)
+				{
+						//the cost went down, pass it on to the neighbors
+						currentState.g = currentState.rhs;
+						m_openSet.Pop();
+						for (int neighbor : m_neighbors)
+						{
+								if (neighbor != m_goal)
+								{
+										DStarNode& neighborState = m_nodes[neighbor];
+										neighborState.rhs = std::min(neighborState.rhs, GetStepCost(neighbor, current) + currentState.g);
+										UpdateNode(neighbor);
+								}
+						}
+				}
+				else
+				{
+						//the cost went up, so every node which might have gone through this one has to look again
+						currentState.g = INFINITE_COST;
+						currentState.rhs = ComputeRhs(current);
+						UpdateNode(current);
+						for (int neighbor : m_neighbors)
+						{
+								m_nodes[neighbor].rhs = ComputeRhs(neighbor);
+								UpdateNode(neighbor);
+						}
+				}
+		}
+}
+
+DStarLite::Status DStarLite::Run()
+{
+		return Update(static_cast<size_t>(-1));
+}
+
+int DStarLite::GetNextNode() const
+{
+		if (m_status != Status::FOUND || m_start == m_goal)
+		{
+				return -1;
+		}
+		//step to the neighbor the cost of the start came from
+		Grid::NeighborList neighbors;
+		m_grid->GetNeighbors(m_start, m_diagonal, neighbors);
+		int next = -1;
+		int bestCost = INFINITE_COST;
+		for (int neighbor : neighbors)
+		{
+				const int cost = GetStepCost(m_start, neighbor) + m_nodes[neighbor].g;
+				if (cost < bestCost)
+				{
+						bestCost = cost;
+						next = neighbor;
+				}
+		}
+		return next;
+}
+
+std::vector<int> DStarLite::GetPath() const
+{
+		std::vector<int> path;
+		if (m_status != Status::FOUND)
+		{
+				return path;
+		}
+		Grid::NeighborList neighbors;
+		int current = m_start;
+		//the costs are consistent along the path once it's found, the limit only guards against a loop
+		while (current != m_goal && path.size() < m_nodes.size())
+		{
+				m_grid->GetNeighbors(current, m_diagonal, neighbors);
+				int next = -1;
+				int bestCost = INFINITE_COST;
+				for (int neighbor : neighbors)
+				{
+						const int cost = GetStepCost(current, neighbor) + m_nodes[neighbor].g;
+						if (cost < bestCost)
+						{
+								bestCost = cost;
+								next = neighbor;
+						}
+				}
+				if (next == -1)
+				{
+						return std::vector<int>();
+				}
+				path.push_back(next);
+				current = next;
+		}
+		//from the end to the start like the other searches
+		std::reverse(path.begin(), path.end());
+		return path;
+}
+
+int DStarLite::GetStepCost(int _from, int _to) const
+{
+		return m_heuristic(m_grid->GetCoord(_from), m_grid->GetCoord(_to)) + m_grid->GetTerrainCost(_to);
+}
+
+int DStarLite::ComputeRhs(int _index) const
+{
+		if (!m_grid->IsWalkable(_index))
+		{
+				return INFINITE_COST;
+		}
+		if (_index == m_goal)
+		{
+				return 0;
+		}
+		Grid::NeighborList neighbors;
+		m_grid->GetNeighbors(_index, m_diagonal, neighbors);
+		int rhs = INFINITE_COST;
+		for (int neighbor : neighbors)
+		{
+				const int g = m_nodes[neighbor].g;
+				if (g < INFINITE_COST)
+				{
+						rhs = std::min(rhs, GetStepCost(_index, neighbor) + g);
+				}
+		}
+		return rhs;
+}
+
+void DStarLite::CalculateKey(int _index, int & _key1, int & _key2) const
+{
+		const DStarNode& node = m_nodes[_index];
+		const int cost = std::min(node.g, node.rhs);
+		if (cost >= INFINITE_COST)
+		{
+				_key1 = INFINITE_COST;
+				_key2 = INFINITE_COST;
+				return;
+		}
+		_key1 = cost + m_heuristic(m_grid->GetCoord(m_start), m_grid->GetCoord(_index)) + m_keyModifier;
+		_key2 = cost;
+}
+
+void DStarLite::UpdateNode(int _index)
+{
+		if (m_nodes[_index].g != m_nodes[_index].rhs)
+		{
+				DStarNode& node = m_nodes[_index];
+				CalculateKey(_index, node.key1, node.key2);
+				if (m_openSet.Contains(_index))
+				{
+						m_openSet.Update(_index);
+				}
+				else
+				{
+						m_openSet.Push(_index);
+				}
+		}
+		else if (m_openSet.Contains(_index))
+		{
+				m_openSet.Remove(_index);
+		}
+}
+
+void DStarLite::ApplyChanges()
+{
+		if (!m_grid->GetChangesSince(m_changeVersion, m_changedNodes))
+		{
+				//too many changes to repair them one by one
+				Begin(m_start, m_goal, *m_grid, m_diagonal);
+				return;
+		}
+		m_changeVersion = m_grid->GetChangeVersion();
+
+		const int numXNodes = m_grid->GetNumXNodes();
+		const int numYNodes = m_grid->GetNumYNodes();
+		for (int changed : m_changedNodes)
+		{
+				//the node itself and its neighbors, the moves into the node and the diagonal moves past it changed with it
+				const glm::ivec2 coord = m_grid->GetCoord(changed);
+				for (int y = std::max(coord.y - 1, 0); y <= std::min(coord.y + 1, numYNodes - 1); y++)
+				{
+						for (int x = std::max(coord.x - 1, 0); x <= std::min(coord.x + 1, numXNodes - 1); x++)
+						{
+								const int index = m_grid->GetIndex(glm::ivec2(x, y));
+								m_nodes[index].rhs = ComputeRhs(index);
+								UpdateNode(index);
+						}
+				}
+		}
+		if (!m_changedNodes.empty() && m_status == Status::FOUND)
+		{
+				m_status = Status::IN_PROGRESS;
+		}
+}
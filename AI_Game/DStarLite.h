@@ -0,0 +1,102 @@
+#pragma once
+#include <limits>
+
+#include "PathFinder.h"
+
+/** \brief An incremental search (D* Lite) for one agent heading for a fixed goal, which keeps its state between the searches.
+	*  It searches from the goal towards the agent, so the start can move along the path without invalidating anything,
+	*  and when nodes change (SetWalkableAt, SetTerrainCost) only the nodes around them are re-evaluated and the costs repaired
+	*  from there, which usually touches a few nodes instead of a full search. Every agent needs its own planner */
+class DStarLite
+{
+public:
+		enum class Status
+		{
+				IN_PROGRESS,
+				FOUND,
+				FAILED
+		};
+
+		DStarLite() {}
+		~DStarLite() {}
+
+		/** \brief Plans from scratch from _start to _goal (the grid is only read and has to stay alive while the planner is used),
+			*  nothing is searched until Update() or Run() */
+		void Begin(int _start, int _goal, const Grid& _grid, const Diagonal& _diagonal);
+
+		/** \brief Moves the start (e.g. to the node the agent walked into), the costs found so far stay valid,
+			*  Update() gives the path from there */
+		void SetStart(int _start);
+
+		/** \brief Takes in the nodes the grid changed since the last call and repairs the path for up to _maxExpansions nodes.
+			*  If more nodes changed than the change log of the grid keeps, the search starts over
+			*  \return IN_PROGRESS if the budget ran out before the path was repaired (the next call carries on) */
+		Status Update(size_t _maxExpansions);
+		/** \brief Repairs the path to the end */
+		Status Run();
+
+		Status GetStatus() const noexcept { return m_status; }
+		/** \brief Gets the number of nodes expanded since Begin() */
+		size_t GetNumExpanded() const noexcept { return m_numExpanded; }
+		int GetStart() const noexcept { return m_start; }
+		int GetGoal() const noexcept { return m_goal; }
+
+		/** \brief The cost of the path from the start to the goal, only meaningful if the status is FOUND */
+		int GetCost() const { return m_nodes[m_start].g; }
+		/** \brief Gets the node to step to from the start, -1 if the status isn't FOUND or the start is the goal */
+		int GetNextNode() const;
+		/** \brief The node indices of the path from the goal to (not including) the start like PathFinder returns them,
+			*  empty unless the status is FOUND */
+		std::vector<int> GetPath() const;
+
+private:
+		/** \brief The search state of a node, g is the cost to the goal and rhs the one seen from its neighbors */
+		struct DStarNode
+		{
+				int g;
+				int rhs;
+				int key1; ///< min(g, rhs) + the heuristic to the start + m_keyModifier, the priority in the open set
+				int key2; ///< min(g, rhs), the tie breaker
+		};
+
+		/** \brief Orders the open set by the keys of the nodes, the lowest first */
+		struct CompareKey
+		{
+				CompareKey(const DStarNode* _nodes = nullptr) : m_nodes(_nodes) {}
+				bool operator()(int _lhs, int _rhs) const noexcept
+				{
+						const DStarNode& lhs = m_nodes[_lhs];
+						const DStarNode& rhs = m_nodes[_rhs];
+						return lhs.key1 > rhs.key1 || (lhs.key1 == rhs.key1 && lhs.key2 > rhs.key2);
+				}
+				const DStarNode* m_nodes;
+		};
+
+		enum : int { INFINITE_COST = std::numeric_limits<int>::max() / 2 }; ///< the cost of the nodes which can't reach the goal
+
+		/** \brief The cost of the move from _from to its neighbor _to, the same the path finder uses */
+		int GetStepCost(int _from, int _to) const;
+		/** \brief Computes the rhs of a node from the g of its neighbors */
+		int ComputeRhs(int _index) const;
+		/** \brief Computes the key of a node from its g and rhs */
+		void CalculateKey(int _index, int& _key1, int& _key2) const;
+		/** \brief Puts the node in the open set if it's inconsistent (g != rhs), or takes it out if it isn't */
+		void UpdateNode(int _index);
+		/** \brief Re-evaluates the nodes around the ones which changed since m_changeVersion */
+		void ApplyChanges();
+
+		const Grid* m_grid{ nullptr };
+		Diagonal m_diagonal{ Diagonal::NEVER };
+		PathFinder::Heuristic m_heuristic{ nullptr };
+		int m_start{ -1 };
+		int m_goal{ -1 };
+		int m_keyModifier{ 0 }; ///< the heuristic distance the start moved since Begin(), keeps the old keys in the open set lower bounds
+		unsigned int m_changeVersion{ 0 }; ///< the change version of the grid which was last taken in
+		Status m_status{ Status::FAILED };
+		size_t m_numExpanded{ 0 };
+
+		std::vector<DStarNode> m_nodes;
+		IndexedHeap<CompareKey> m_openSet;
+		Grid::NeighborList m_neighbors;
+		std::vector<int> m_changedNodes;
+};
@@ -0,0 +1,100 @@
+#include "FlowField.h"
+
+#include <limits>
+#include <utility>
+
+FlowField::FlowField(std::weak_ptr<Grid> _grid, const Diagonal & _diagonal) :
+		m_grid(_grid), m_diagonal(_diagonal), m_heuristic(PathFinder::SelectHeuristic(_diagonal))
+{
+}
+
+void FlowField::SetGoal(const glm::vec2 & _worldPos)
+{
+		std::shared_ptr<Grid> grid = m_grid.lock();
+		if (!grid || !grid->IsPosInside(_worldPos / grid->GetNodeDiameter()))
+		{
+				return;
+		}
+		const int goal = grid->GetIndexAt(_worldPos);
+		//the goal node didn't change (or its field is already on the way), or it's a wall which was only touched, keep the old field
+		if (goal == (m_pendingGoal != -1 ? m_pendingGoal : m_goal) || !grid->IsWalkable(goal))
+		{
+				return;
+		}
+		Begin(goal);
+}
+
+void FlowField::Begin(int _goal)
+{
+		const int numNodes = m_grid.lock()->GetNumNodes();
+		m_pendingGoal = _goal;
+		m_pendingNext.assign(numNodes, -1);
+		m_pendingCosts.assign(numNodes, std::numeric_limits<int>::max());
+		m_openSet.Reserve(numNodes);
+		m_openSet.SetComparator(CompareCost(m_pendingCosts.data()));
+
+		m_pendingCosts[_goal] = 0;
+		m_openSet.Push(_goal);
+}
+
+void FlowField::Update(size_t _maxExpansions)
+{
+		if (m_pendingGoal == -1)
+		{
+				return;
+		}
+		std::shared_ptr<Grid> grid = m_grid.lock();
+
+		for (size_t expansion = 0; expansion < _maxExpansions && !m_openSet.IsEmpty(); expansion++)
+		{
+				const int current = m_openSet.Front();
+				m_openSet.Pop();
+				const glm::ivec2 currentCoord = grid->GetCoord(current);
+
+				//the neighbors are symmetric, so they are also the nodes which can step onto the current one
+				grid->GetNeighbors(current, m_diagonal, m_neighbors);
+				for (int neighbor : m_neighbors)
+				{
+						const glm::ivec2 neighborCoord = grid->GetCoord(neighbor);
+						//stepping from the neighbor onto the current node costs the distance plus the current node's terrain
+						const int cost = m_pendingCosts[current] + m_heuristic(neighborCoord, currentCoord) + grid->GetTerrainCost(current);
+						if (cost < m_pendingCosts[neighbor])
+						{
+								const bool inOpenSet = m_pendingCosts[neighbor] != std::numeric_limits<int>::max() && m_openSet.Contains(neighbor);
+								m_pendingCosts[neighbor] = cost;
+								m_pendingNext[neighbor] = current;
+								if (inOpenSet)
+								{
+										m_openSet.Update(neighbor);
+								}
+								else
+								{
+										m_openSet.Push(neighbor);
+								}
+						}
+				}
+		}
+
+		if (m_openSet.IsEmpty())
+		{
+				//the field is complete, swap it in
+				std::swap(m_next, m_pendingNext);
+				m_goal = m_pendingGoal;
+				m_pendingGoal = -1;
+		}
+}
+
+glm::vec2 FlowField::GetDirection(const glm::vec2 & _worldPos) const
+{
+		std::shared_ptr<Grid> grid = m_grid.lock();
+		if (!grid || m_next.empty() || !grid->IsPosInside(_worldPos / grid->GetNodeDiameter()))
+		{
+				return glm::vec2(0.0f);
+		}
+		const int next = m_next[grid->GetIndexAt(_worldPos)];
+		if (next == -1)
+		{
+				return glm::vec2(0.0f);
+		}
+		return glm::normalize(grid->GetWorldPos(next) - _worldPos);
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "PathFinder.h"
+
+/** \brief A flow field towards one goal: a single Dijkstra pass from the goal node gives every node of the grid the neighbor
+	*  to step to, so any number of agents heading for the same goal can look up their direction in O(1).
+	*  When the goal moves to another node the new field is computed over several Update() calls, and the old one
+	*  (which leads to the neighboring node) is used until it is complete */
+class FlowField
+{
+public:
+		FlowField() {}
+		FlowField(std::weak_ptr<Grid> _grid, const Diagonal& _diagonal);
+		~FlowField() {}
+
+		/** \brief Moves the goal, nothing is recomputed until it's in another node */
+		void SetGoal(const glm::vec2& _worldPos);
+
+		/** \brief Continues computing the pending field for up to _maxExpansions nodes and swaps it in once it's done */
+		void Update(size_t _maxExpansions);
+
+		/** \brief Gets the normalized direction to move in from _worldPos towards the goal,
+			*  zero in the goal node, outside of the grid, where the goal can't be reached or before the first field is done */
+		glm::vec2 GetDirection(const glm::vec2& _worldPos) const;
+
+		/** \brief Gets the flat index of the node to move to from node _index, -1 for none */
+		int GetNextNode(int _index) const { return m_next.empty() ? -1 : m_next[_index]; }
+		/** \brief Check if a field is available */
+		bool IsValid() const noexcept { return !m_next.empty(); }
+		/** \brief Check if a new field is being computed */
+		bool IsUpdating() const noexcept { return m_pendingGoal != -1; }
+
+private:
+		/** \brief Orders the open set by the cost to the goal, the cheapest first */
+		struct CompareCost
+		{
+				CompareCost(const int* _costs = nullptr) : m_costs(_costs) {}
+				bool operator()(int _lhs, int _rhs) const noexcept { return m_costs[_lhs] > m_costs[_rhs]; }
+				const int* m_costs;
+		};
+
+		/** \brief Starts computing the field of a new goal node */
+		void Begin(int _goal);
+
+		std::weak_ptr<Grid> m_grid;
+		Diagonal m_diagonal{ Diagonal::NEVER };
+		PathFinder::Heuristic m_heuristic{ nullptr }; ///< the step costs, the same the path finder uses
+
+		std::vector<int> m_next; ///< the completed field: the node to move to from every node (-1 for none)
+		int m_goal{ -1 };        ///< the goal node of m_next
+
+		std::vector<int> m_pendingNext;  ///< the field being computed
+		std::vector<int> m_pendingCosts; ///< the cost from every node to the pending goal
+		IndexedHeap<CompareCost> m_openSet;
+		Grid::NeighborList m_neighbors;
+		int m_pendingGoal{ -1 }; ///< -1 if nothing is being computed
+};
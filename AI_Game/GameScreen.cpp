@@ -2,9 +2,53 @@
 #include "ScreenIndices.h"
 #include "SmartZombie.h"
 
+#include <GameEngine\Allocators.h>
+#include <GameEngine\FrameStats.h>
 #include <GameEngine\IMainGame.h>
+#include <GameEngine\Profiler.h>
+#include <GameEngine\RenderState.h>
 #include <GameEngine\ResourceManager.h>
 #include <iostream>
+#include <future>
+#include <thread>
+#include <algorithm>
+
+//number of zombies a single worker records, smaller crowds are drawn on the render thread
+constexpr size_t ZOMBIES_PER_WORKER = 256;
+//the nodes of the influence map propagated per frame (see InfluenceMap::Update)
+constexpr size_t INFLUENCE_NODES_PER_FRAME = 4096;
+
+namespace
+{
+		/** \brief Runs one of the node index searches of PathFinder, the algorithms which have none (HPA*, the flow field) run A* */
+		std::vector<int> RunSearch(Algorithm _algorithm, PathFinder& _pathFinder, int _start, int _end, const Grid& _grid, SearchContext& _context)
+		{
+				const Diagonal diagonal = Diagonal::IFNOWALLS;
+				switch (_algorithm)
+				{
+				case Algorithm::ASTARe:
+						return _pathFinder.AStarEpsilon(_start, _end, _grid, diagonal, _context);
+				case Algorithm::BEST_FIRST:
+						return _pathFinder.BestFirst(_start, _end, _grid, diagonal, _context);
+				case Algorithm::BREADTH_FIRST:
+						return _pathFinder.BreadthFirst(_start, _end, _grid, diagonal, _context);
+				case Algorithm::DEPTH_FIRST:
+						return _pathFinder.DepthFirst(_start, _end, _grid, diagonal, _context);
+				case Algorithm::DIJKSTRA:
+						return _pathFinder.Dijkstra(_start, _end, _grid, diagonal, _context);
+				case Algorithm::GREEDY_BEST_FIRST:
+						return _pathFinder.GreedyBFirst(_start, _end, _grid, diagonal, _context);
+				case Algorithm::JUMP_POINT:
+						return _pathFinder.JumpPoint(_start, _end, _grid, diagonal, _context);
+				case Algorithm::BIDIRECTIONAL_ASTAR:
+						return _pathFinder.BiAStar(_start, _end, _grid, diagonal, _context);
+				case Algorithm::BIDIRECTIONAL_BREADTH_FIRST:
+						return _pathFinder.BiBreadthFirst(_start, _end, _grid, diagonal, _context);
+				default:
+						return _pathFinder.AStar(_start, _end, _grid, diagonal, _context);
+				}
+		}
+}
 
 GameScreen::GameScreen(GameEngine::Window * _window) : m_window(_window)
 {
@@ -49,12 +93,22 @@ void GameScreen::OnEntry()
 
 		/* Initialize the shaders */
 		m_shader.CompileShaders("Shaders/textureShading.vert", "Shaders/textureShading.frag");
+		m_debugRenderer.Init();
+		m_gridOverlay.Init();
+		//a frame over these is logged once and shown in red by the stats overlay (F5)
+		GameEngine::FrameStats::Get().SetBudget(GameEngine::STAT_DRAW_CALLS, 200);
+		GameEngine::FrameStats::Get().SetBudget(GameEngine::STAT_EXPANDED_NODES, 50000);
 
 		/* Initialize the first level */
 		m_gameWorlds.push_back(std::make_shared<World>());
 		m_gameWorlds.back()->LoadTerrainFromFile("Levels/level1.txt");
 		m_currentLevel = 0;
-		m_pathRequestManger = std::make_shared<PathRequestManager>(m_gameWorlds.at(m_currentLevel)->GetWorldGrid());
+		m_pathRequestManger = std::make_shared<PathRequestManager>(m_gameWorlds.at(m_currentLevel)->GetWorldGrid(),
+				m_gameWorlds.at(m_currentLevel)->GetWorldHierarchy());
+		m_pathRequestManger->SetLandmarks(m_gameWorlds.at(m_currentLevel)->GetWorldLandmarks());
+		//the zombies walk straight lines instead of every node of the paths
+		m_pathRequestManger->SetPathSmoothing(true);
+		m_influence = InfluenceMap(m_gameWorlds.at(m_currentLevel)->GetWorldGrid(), Diagonal::IFNOWALLS);
 
 		/* Initialize the player */
 		m_player = std::make_shared<Player>(3.0f, 100.0f, m_gameWorlds.at(m_currentLevel)->GetStartPlayerPos(),
@@ -82,6 +136,9 @@ void GameScreen::OnEntry()
 								m_player, m_pathRequestManger,
 								m_gameWorlds.at(m_currentLevel)->GetPatrolWaypoints()));
 				}
+				//moved along its paths together with the others
+				m_zombies.back()->SetPathFollowing(&m_zombieMovement);
+				m_zombies.back()->SetInfluenceMap(&m_influence);
 		}
 		//Generate the seed for rng
 }
@@ -92,12 +149,18 @@ void GameScreen::OnExit()
 		m_spriteBatch.Dispose();
 		m_hudSpriteBatch.Dispose();
 		m_spriteFont.dispose();
+		m_debugRenderer.Dispose();
+		m_gridOverlay.Dispose();
+		m_hasDebugSearch = false;
+		m_debugPath.clear();
+		m_overlayWalkableVersion = NO_OVERLAY;
 		m_zombies.clear();
 		m_gameWorlds.clear();
 }
 
 void GameScreen::Update()
 {
+		PROFILE_SCOPE("GameScreen::Update");
 		if (m_window->WasResized())
 		{
 				m_camera.Resize(m_window->GetScreenWidth(), m_window->GetScreenHeight());
@@ -112,16 +175,57 @@ void GameScreen::Update()
 		}
 
 		m_player->Update(deltaTime);
+		m_pathRequestManger->SetFlowFieldGoal(m_player->GetCenterPos());
 		m_pathRequestManger->Update();
+		//the states only decide where to go, the zombies which follow a path are moved together afterwards
+		m_zombieMovement.Clear();
+		//the zombies far from the player only run their states every few frames, and keep moving in between
+		m_zombieThinking.BeginFrame(m_player->GetCenterPos(), m_camera);
+		for (size_t i = 0; i < m_zombies.size(); i++)
+		{
+				if (m_zombieThinking.ShouldThink(i, m_zombies[i]->GetPosition(), glm::vec2(AGENT_DIAMETER)))
+				{
+						m_zombies.at(i)->Update(deltaTime);
+				}
+				else
+				{
+						m_zombies.at(i)->Coast(deltaTime);
+				}
+		}
+		m_zombieMovement.Update(deltaTime, *m_gameWorlds.at(m_currentLevel)->GetWorldGrid().lock());
+		for (size_t i = 0; i < m_zombies.size(); i++)
+		{
+				m_zombies.at(i)->ApplyPathFollowing();
+		}
+		//collide the zombies only with the ones in the same or the adjacent cells (the cells are an agent wide, so no overlap is missed)
+		m_zombieHash.Clear(m_zombies.size());
+		for (size_t i = 0; i < m_zombies.size(); i++)
+		{
+				m_zombieHash.Insert(static_cast<int>(i), m_zombies[i]->GetCenterPos());
+		}
+		m_zombieHash.ForEachPair([this](int _first, int _second) { m_zombies[_first]->CollideWithAgent(m_zombies[_second].get()); });
+		//where the zombies ended up, whether they see the player is used by their states next frame
+		m_zombieSight.Clear();
+		for (size_t i = 0; i < m_zombies.size(); i++)
+		{
+				m_zombies[i]->LookForPlayer(m_zombieSight, i);
+		}
+		m_zombieSight.Update(*m_gameWorlds.at(m_currentLevel)->GetWorldGrid().lock());
+		for (size_t i = 0; i < m_zombies.size(); i++)
+		{
+				m_zombies[i]->ApplySight(m_zombieSight);
+		}
+		//what the smart zombies sense next frame: the player, where the zombies saw him and where they crowd
+		m_influence.AddSource(InfluenceMap::THREAT, m_player->GetCenterPos(), 1.0f);
 		for (size_t i = 0; i < m_zombies.size(); i++)
 		{
-				m_zombies.at(i)->Update(deltaTime);
-				//collide with all other zombies
-				for (size_t j = i + 1; j < m_zombies.size(); j++)
+				m_influence.AddSource(InfluenceMap::ZOMBIE_DENSITY, m_zombies[i]->GetCenterPos(), 1.0f);
+				if (m_zombies[i]->SeesPlayer())
 				{
-						m_zombies.at(i)->CollideWithAgent(m_zombies.at(j).get());
+						m_influence.AddSource(InfluenceMap::PLAYER_SIGHTING, m_player->GetCenterPos(), 1.0f);
 				}
 		}
+		m_influence.Update(INFLUENCE_NODES_PER_FRAME);
 		m_camera.SetPosition(m_player->GetCenterPos());
 		m_camera.Update();
 		m_hudCamera.Update();
@@ -130,6 +234,7 @@ void GameScreen::Update()
 
 void GameScreen::Draw()
 {
+		PROFILE_SCOPE("GameScreen::Draw");
 		// Set the base depth to 1.0
 		glClearDepth(1.0);
 		// Clear the color and depth buffer
@@ -137,17 +242,35 @@ void GameScreen::Draw()
 
 		if (m_debugMode)
 		{
-				m_gameWorlds.at(m_currentLevel)->GetWorldGrid().lock()->DrawGrid(m_camera.GetCameraMatrix());
+				const glm::vec4 view = m_camera.GetViewRect();
+				std::shared_ptr<Grid> grid = m_gameWorlds.at(m_currentLevel)->GetWorldGrid().lock();
+				m_debugRenderer.SetCullRect(view);
+				if (m_useGridOverlay)
+				{
+						//written again only when a node changed, a new debug search writes it itself
+						if (grid->GetWalkableVersion() != m_overlayWalkableVersion)
+						{
+								m_gridOverlay.Update(*grid, m_hasDebugSearch ? &m_debugSearch : nullptr, m_debugPath);
+								m_overlayWalkableVersion = grid->GetWalkableVersion();
+						}
+						m_gridOverlay.Draw(m_camera.GetCameraMatrix());
+				}
+				else
+				{
+						grid->DrawGrid(m_debugRenderer, view);
+				}
 				for (size_t i = 0; i < m_zombies.size(); i++)
 				{
-						m_gameWorlds.at(m_currentLevel)->GetWorldGrid().lock()->DrawPath(m_zombies.at(i)->GetPath(), m_camera.GetCameraMatrix());
+						grid->DrawPath(m_zombies.at(i)->GetPath(), m_debugRenderer);
 				}
+				m_debugRenderer.End();
+				m_debugRenderer.Render(m_camera.GetCameraMatrix(), 2.0f);
 		}
 
 
 		m_shader.Use();
 
-		glActiveTexture(GL_TEXTURE0);
+		GameEngine::RenderState::Get().ActiveTexture(0);
 
 		// Make sure the shader uses texture 0
 		glUniform1i(m_shader.GetUniformLocation("diffuseTexture"), 0);
@@ -157,19 +280,49 @@ void GameScreen::Draw()
 		// upload the camera matrix
 		m_shader.UploadValue("projection", m_camera.GetCameraMatrix());
 
-		m_spriteBatch.Begin();
+		//cull the agents outside the camera view
+		m_spriteBatch.Begin(GameEngine::GlyphSortType::TEXTURE, m_camera);
 
 		m_player->Draw(m_spriteBatch);
-		for (size_t i = 0; i < m_zombies.size(); i++)
+
+		const size_t numWorkers = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+				(m_zombies.size() + ZOMBIES_PER_WORKER - 1) / ZOMBIES_PER_WORKER);
+		if (numWorkers <= 1)
 		{
-				m_zombies.at(i)->Draw(m_spriteBatch);
+				for (size_t i = 0; i < m_zombies.size(); i++)
+				{
+						m_zombies.at(i)->Draw(m_spriteBatch);
+				}
+		}
+		else
+		{
+				//every worker records a disjoint range of zombies into its own recorder, they are merged in End()
+				GameEngine::ArenaVector<std::future<void>> workers(GameEngine::FrameAllocator::Get().MakeAllocator<std::future<void>>());
+				workers.reserve(numWorkers);
+				for (size_t worker = 0; worker < numWorkers; worker++)
+				{
+						GameEngine::GlyphRecorder& recorder = m_spriteBatch.GetRecorder(worker);
+						const size_t begin = worker * m_zombies.size() / numWorkers;
+						const size_t end = (worker + 1) * m_zombies.size() / numWorkers;
+						workers.push_back(std::async(std::launch::async, [this, &recorder, begin, end]()
+						{
+								for (size_t i = begin; i < end; i++)
+								{
+										m_zombies[i]->Draw(recorder);
+								}
+						}));
+				}
+				for (auto& worker : workers)
+				{
+						worker.wait();
+				}
 		}
 
 		m_spriteBatch.End();
 		m_spriteBatch.RenderBatch();
 
 		// Draw the level
-		m_gameWorlds.at(m_currentLevel)->Draw();
+		m_gameWorlds.at(m_currentLevel)->Draw(m_camera);
 		m_shader.UnUse();
 }
 
@@ -192,9 +345,26 @@ void GameScreen::CheckInput()
 		{
 				m_debugMode = !m_debugMode;
 		}
+		if (m_game->inputManager.IsKeyPressed(SDLK_F2))
+		{
+				m_useGridOverlay = !m_useGridOverlay;
+		}
+		if (m_game->inputManager.IsKeyPressed(SDLK_F3))
+		{
+				GameEngine::Profiler::Get().SetEnabled(!GameEngine::Profiler::Get().IsEnabled());
+		}
+		if (m_game->inputManager.IsKeyPressed(SDLK_F4))
+		{
+				//the last frames the profiler kept, for chrome://tracing or Perfetto
+				GameEngine::Profiler::Get().WriteChromeTrace("Profile.json");
+		}
+		if (m_game->inputManager.IsKeyPressed(SDLK_F5))
+		{
+				m_showFrameStats = !m_showFrameStats;
+		}
 		if (m_game->inputManager.IsKeyPressed(SDLK_SPACE))
 		{
-				int rand = m_random.GenRandInt(0, 6);
+				int rand = m_random.GenRandInt(0, 11);
 				Algorithm algoToUse;
 				switch (rand)
 				{
@@ -240,6 +410,36 @@ void GameScreen::CheckInput()
 						m_currentAlgo = "GREEDY.BEST.FIRST";
 						break;
 				}
+				case 7:
+				{
+						algoToUse = Algorithm::JUMP_POINT;
+						m_currentAlgo = "JUMP.POINT";
+						break;
+				}
+				case 8:
+				{
+						algoToUse = Algorithm::HIERARCHICAL;
+						m_currentAlgo = "HPA.STAR";
+						break;
+				}
+				case 9:
+				{
+						algoToUse = Algorithm::FLOW_FIELD;
+						m_currentAlgo = "FLOW.FIELD";
+						break;
+				}
+				case 10:
+				{
+						algoToUse = Algorithm::BIDIRECTIONAL_ASTAR;
+						m_currentAlgo = "BI.ASTAR";
+						break;
+				}
+				case 11:
+				{
+						algoToUse = Algorithm::BIDIRECTIONAL_BREADTH_FIRST;
+						m_currentAlgo = "BI.BREADTH.FIRST";
+						break;
+				}
 				default:
 				{
 						break;
@@ -249,6 +449,7 @@ void GameScreen::CheckInput()
 				{
 						zombie->SetPFAlgo(algoToUse);
 				}
+				m_currentAlgorithm = algoToUse;
 		}
 
 		if (m_game->inputManager.IsKeyPressed(SDLK_LSHIFT))
@@ -272,6 +473,9 @@ void GameScreen::CheckInput()
 								m_player, m_pathRequestManger,
 								m_gameWorlds.at(m_currentLevel)->GetPatrolWaypoints()));
 				}
+				//moved along its paths together with the others
+				m_zombies.back()->SetPathFollowing(&m_zombieMovement);
+				m_zombies.back()->SetInfluenceMap(&m_influence);
 		}
 
 		if (m_game->inputManager.IsKeyPressed(SDL_BUTTON_LEFT))
@@ -281,12 +485,24 @@ void GameScreen::CheckInput()
 						glm::ivec2 screenCoords;
 						SDL_GetMouseState(&screenCoords.x, &screenCoords.y);
 						glm::vec2 worldCoords = m_camera.ConvertScreenToWorld(screenCoords);
-						std::weak_ptr<Node> node = m_gameWorlds.at(m_currentLevel)->GetWorldGrid().lock()->GetNodeAt(worldCoords);
+						const Node node = m_gameWorlds.at(m_currentLevel)->GetWorldGrid().lock()->GetNodeAt(worldCoords);
 						std::cout << node << std::endl;
+						RunDebugSearch(worldCoords);
 				}
 		}
 }
 
+void GameScreen::RunDebugSearch(const glm::vec2& _target)
+{
+		std::shared_ptr<Grid> grid = m_gameWorlds.at(m_currentLevel)->GetWorldGrid().lock();
+		const int start = grid->GetIndexAt(m_player->GetCenterPos());
+		const int end = grid->GetIndexAt(_target);
+		m_debugPath = RunSearch(m_currentAlgorithm, m_debugPathFinder, start, end, *grid, m_debugSearch);
+		m_hasDebugSearch = true;
+		m_gridOverlay.Update(*grid, &m_debugSearch, m_debugPath);
+		m_overlayWalkableVersion = grid->GetWalkableVersion();
+}
+
 void GameScreen::DrawUI(GameEngine::GLSLProgram& _shader)
 {
 		_shader.UploadValue("projection", m_hudCamera.GetCameraMatrix());
@@ -294,6 +510,15 @@ void GameScreen::DrawUI(GameEngine::GLSLProgram& _shader)
 		m_hudSpriteBatch.Begin();
 
 		m_spriteFont.draw(m_hudSpriteBatch, m_currentAlgo.c_str(), glm::vec2(1, 1), glm::vec2(1.0f), 0.0, GameEngine::ColorRGBA8(255, 255, 255, 255));
+		if (GameEngine::Profiler::Get().IsEnabled())
+		{
+				GameEngine::Profiler::Get().DrawSummary(m_hudSpriteBatch, m_spriteFont, glm::vec2(1.0f, static_cast<float>(m_window->GetScreenHeight())), 0.5f, 0.0f);
+		}
+		if (m_showFrameStats)
+		{
+				GameEngine::FrameStats::Get().DrawOverlay(m_hudSpriteBatch, m_spriteFont,
+						glm::vec2(m_window->GetScreenWidth() * 0.75f, static_cast<float>(m_window->GetScreenHeight())), 0.5f, 0.0f);
+		}
 
 		m_hudSpriteBatch.End();
 		m_hudSpriteBatch.RenderBatch();
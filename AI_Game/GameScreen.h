@@ -6,10 +6,15 @@
 #include <GameEngine\GLSLProgram.h>
 #include <GameEngine\Timing.h>
 #include <GameEngine\Random.h>
+#include <GameEngine\SpatialHash2D.h>
+#include <GameEngine\DebugRenderer.h>
 #include "World.h"
 #include "Player.h"
 #include "Zombie.h"
 #include "PathRequestManager.h"
+#include "ThinkScheduler.h"
+#include "GridOverlay.h"
+#include "PathFinder.h"
 
 // Our custom gameplay screen that inherits from IGameScreen
 class GameScreen : public GameEngine::IGameScreen
@@ -49,6 +54,9 @@ private:
 		 * \param  _shader - shader to use */
 		void DrawUI(GameEngine::GLSLProgram& _shader);
 
+		/** \brief Runs the current algorithm from the player to _target for the overlay of debug mode, keeping its open and closed sets */
+		void RunDebugSearch(const glm::vec2& _target);
+
 private:
 		std::shared_ptr<PathRequestManager> m_pathRequestManger; ///< the path request manager for pathfinding
 		
@@ -59,6 +67,11 @@ private:
 
 		std::shared_ptr<Player> m_player;															///< the Player
 		std::vector<std::unique_ptr<Zombie>> m_zombies; ///< The set of zombies
+		GameEngine::SpatialHash2D m_zombieHash{ AGENT_DIAMETER }; ///< the broadphase of the zombie collisions, rebuilt every frame
+		PathFollowingBatch m_zombieMovement; ///< moves all the zombies which follow a path in one pass
+		LineOfSightBatch m_zombieSight; ///< whether the zombies can see the player, the rays of all of them are walked together
+		InfluenceMap m_influence; ///< the threat of the player, where he was seen and the crowds of zombies, for the smart zombies
+		ThinkScheduler m_zombieThinking{ AGENT_DIAMETER * 30.0f, AGENT_DIAMETER * 60.0f }; ///< which zombies run their states this frame (the ones in view always)
 
 		GameEngine::SpriteBatch m_spriteBatch; ///< The spritebatch for batched rendering for agents
 		GameEngine::SpriteBatch m_hudSpriteBatch; ///< The spritebatch for batched rendering for UI		
@@ -74,6 +87,17 @@ private:
 		int m_currentLevel{ -1 }; ///< index of the current level
 
 		bool m_debugMode{ false }; ///< flag whether to have debug code on or off
+		GameEngine::DebugRenderer m_debugRenderer; ///< the grid and the paths of debug mode, culled to the view and drawn at once
+		GridOverlay m_gridOverlay; ///< the states of all the nodes in one quad, the grid of debug mode unless F2 switches to the line boxes
+		bool m_useGridOverlay{ true };
+		bool m_showFrameStats{ false }; ///< the counters of the last frame (F5), see GameEngine::FrameStats
+		enum : unsigned int { NO_OVERLAY = static_cast<unsigned int>(-1) };
+		unsigned int m_overlayWalkableVersion{ NO_OVERLAY }; ///< the Grid::GetWalkableVersion the overlay was written with
+		PathFinder m_debugPathFinder; ///< the search shown by the overlay (left click in debug mode)
+		SearchContext m_debugSearch;
+		std::vector<int> m_debugPath;
+		bool m_hasDebugSearch{ false };
+		Algorithm m_currentAlgorithm{ Algorithm::ASTAR }; ///< the algorithm of m_currentAlgo
 
 		GameEngine::Random m_random; ///< random number generator
 };
\ No newline at end of file
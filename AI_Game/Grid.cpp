@@ -1,12 +1,84 @@
 #include "Grid.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace
+{
+		//the directions a neighbor mask allows, in the order GetNeighbors has always returned them
+		struct NeighborDirections
+		{
+				unsigned char m_count{ 0 };
+				unsigned char m_directions[8];
+		};
+
+		//bits 0 to 3 are the sides (above, right, below, left), bits 4 to 7 the diagonals (top-left, top-right, bottom-right, bottom-left)
+		NeighborDirections ComputeDirections(const Diagonal& _diagonal, unsigned int _mask)
+		{
+				NeighborDirections result;
+				const bool side[4] = { (_mask & 1) != 0, (_mask & 2) != 0, (_mask & 4) != 0, (_mask & 8) != 0 };
+				for (unsigned char i = 0; i < 4; i++)
+				{
+						if (side[i])
+						{
+								result.m_directions[result.m_count++] = i;
+						}
+				}
+				for (unsigned char i = 0; i < 4; i++)
+				{
+						//diagonal i lies between the sides i and i - 1 (diagonal 0 between above and left)
+						const bool first = side[i];
+						const bool second = side[(i + 3) % 4];
+						bool allowed = false;
+						switch (_diagonal)
+						{
+						case Diagonal::ALWAYS: allowed = true; break;
+						case Diagonal::IFNOWALLS: allowed = first && second; break;
+						case Diagonal::IFLESSTHANTWOWALLS: allowed = first || second; break;
+						default: break;
+						}
+						if (allowed && (_mask & (16u << i)))
+						{
+								result.m_directions[result.m_count++] = 4 + i;
+						}
+				}
+				return result;
+		}
+
+		//the directions of every mask for every diagonal mode, built once
+		const NeighborDirections& GetDirections(const Diagonal& _diagonal, unsigned char _mask)
+		{
+				static const std::vector<NeighborDirections> table = []()
+				{
+						std::vector<NeighborDirections> directions(4 * 256);
+						for (size_t mode = 0; mode < 4; mode++)
+						{
+								for (unsigned int mask = 0; mask < 256; mask++)
+								{
+										directions[mode * 256 + mask] = ComputeDirections(static_cast<Diagonal>(mode + 1), mask);
+								}
+						}
+						return directions;
+				}();
+				return table[(static_cast<size_t>(_diagonal) - 1) * 256 + _mask];
+		}
+}
+
 Grid::Grid(const Grid & _obj)
 {
-		m_nodeMap							=	_obj.m_nodeMap;
+		//the chunks are shared, GetMutableChunk copies them once either grid changes them
+		m_chunks = _obj.m_chunks;
 		m_gridWorldSize = _obj.m_gridWorldSize; 
 		m_nodeDiameter  = _obj.m_nodeDiameter;
 		m_numXNodes					= _obj.m_numXNodes;
 		m_numYNodes					= _obj.m_numYNodes;
+		m_terrainCostCounts = _obj.m_terrainCostCounts;
+		m_numXRegions = _obj.m_numXRegions;
+		m_regionVersions = _obj.m_regionVersions;
+		m_walkableVersion = _obj.m_walkableVersion;
+		m_changeLog = _obj.m_changeLog;
+		m_changeVersion = _obj.m_changeVersion;
 }
 
 Grid::Grid()
@@ -16,7 +88,6 @@ Grid::Grid()
 
 Grid::~Grid()
 {
-		m_nodeMap.clear();
 }
 
 Grid::Grid(const glm::vec2& _gridWorldSize, float _nodeDiameter, std::vector<bool>& _walkableMatrix) :
@@ -25,7 +96,6 @@ Grid::Grid(const glm::vec2& _gridWorldSize, float _nodeDiameter, std::vector<boo
 		m_numXNodes = (int)ceil((m_gridWorldSize.x / _nodeDiameter));
 		m_numYNodes = (int)ceil((m_gridWorldSize.y / _nodeDiameter));
 		CreateGrid(_walkableMatrix);
-		m_debugRenderer.Init();
 }
 
 Grid::Grid(const glm::vec2& _gridWorldSize, float _nodeDiameter) :
@@ -34,7 +104,6 @@ Grid::Grid(const glm::vec2& _gridWorldSize, float _nodeDiameter) :
 		m_numXNodes = (int)ceil((m_gridWorldSize.x / _nodeDiameter));
 		m_numYNodes = (int)ceil((m_gridWorldSize.y / _nodeDiameter));
 		CreateGrid();
-		m_debugRenderer.Init();
 }
 
 Grid::Grid(size_t _numXNodes, size_t _numYNodes, float _nodeDiameter, std::vector<bool>& _walkableMatrix) :
@@ -43,7 +112,6 @@ Grid::Grid(size_t _numXNodes, size_t _numYNodes, float _nodeDiameter, std::vecto
 		m_gridWorldSize.x = float(m_numXNodes * m_nodeDiameter);
 		m_gridWorldSize.y = float(m_numYNodes * m_nodeDiameter);
 		CreateGrid(_walkableMatrix);
-		m_debugRenderer.Init();
 }
 
 Grid::Grid(size_t _numXNodes, size_t _numYNodes, float _nodeDiameter) :
@@ -52,10 +120,27 @@ Grid::Grid(size_t _numXNodes, size_t _numYNodes, float _nodeDiameter) :
 		m_gridWorldSize.x = float(m_numXNodes * m_nodeDiameter);
 		m_gridWorldSize.y = float(m_numYNodes * m_nodeDiameter);
 		CreateGrid();
-		m_debugRenderer.Init();
 }
 
-std::weak_ptr<Node> Grid::GetNodeAt(const glm::vec2& _worldPos)
+Grid::Grid(size_t _numXNodes, size_t _numYNodes, float _nodeDiameter, std::vector<bool>& _walkableMatrix, const std::vector<unsigned char>& _terrainCosts) :
+		m_numXNodes(_numXNodes), m_numYNodes(_numYNodes), m_nodeDiameter(_nodeDiameter)
+{
+		m_gridWorldSize.x = float(m_numXNodes * m_nodeDiameter);
+		m_gridWorldSize.y = float(m_numYNodes * m_nodeDiameter);
+		CreateGrid(_walkableMatrix, _terrainCosts);
+}
+
+Node Grid::GetNodeAt(const glm::vec2& _worldPos) const
+{
+		return GetNode(GetIndexAt(_worldPos));
+}
+
+Node Grid::GetNodeAt(const glm::ivec2 & _index) const
+{
+		return GetNode(GetIndex(_index));
+}
+
+int Grid::GetIndexAt(const glm::vec2& _worldPos) const
 {
 		//the position on the x coordinate (0 to m_numXNodes)
 		float posX = (_worldPos.x / m_nodeDiameter);
@@ -68,36 +153,25 @@ std::weak_ptr<Node> Grid::GetNodeAt(const glm::vec2& _worldPos)
 				throw std::runtime_error("Requested node is out of range");
 		}
 
-		//cast the indices for the node vector to ints to get the Node
-		return GetNodeAt(glm::ivec2(int(posX), int(posY)));
-}
-
-std::weak_ptr<Node> Grid::GetNodeAt(const glm::ivec2 & _index)
-{
-		return m_nodeMap[int(_index.y) * m_numXNodes + int(_index.x)];
+		//cast the indices for the node vector to ints to get the index
+		return GetIndex(glm::ivec2(int(posX), int(posY)));
 }
 
-bool Grid::IsWalkableAt(const glm::vec2& _worldPos)
+bool Grid::IsWalkableAt(const glm::vec2& _worldPos) const
 {
-		std::weak_ptr<Node> nodeToCheck = GetNodeAt(_worldPos);
-		//make sure the node exists in the node vector
-		if (nodeToCheck.expired())
-		{
-				return false;
-		}
-		return nodeToCheck.lock()->walkable;
+		return IsWalkable(GetIndexAt(_worldPos));
 }
 
-bool Grid::IsWalkableAt(const glm::ivec2 & _index)
+bool Grid::IsWalkableAt(const glm::ivec2 & _index) const
 {
 		if (!IsPosInside(_index))
 		{
 				return false;
 		}
-		return GetNodeAt(_index).lock()->walkable;
+		return IsWalkable(GetIndex(_index));
 }
 
-bool Grid::IsPosInside(const glm::vec2& _index)
+bool Grid::IsPosInside(const glm::vec2& _index) const
 {
 		if (_index.x < 0.0f || _index.x >= m_numXNodes)
 		{
@@ -112,134 +186,142 @@ bool Grid::IsPosInside(const glm::vec2& _index)
 
 void Grid::SetWalkableAt(const glm::vec2& _worldPos, bool _walkable)
 {
-		GetNodeAt(_worldPos).lock()->walkable = _walkable;
+		SetNodeWalkable(GetIndexAt(_worldPos), _walkable);
 }
 void Grid::SetWalkableAt(const glm::ivec2 & _index, bool _walkable)
 {
-		GetNodeAt(_index).lock()->walkable = _walkable;
-}
-void Grid::SetTerrainCost(const glm::vec2 & _worldPos, int _cost)
-{
-		GetNodeAt(_worldPos).lock()->terrainCost = _cost;
+		SetNodeWalkable(GetIndex(_index), _walkable);
 }
-void Grid::SetTerrainCost(const glm::ivec2 & _index, int _cost)
+void Grid::SetNodeWalkable(int _index, bool _walkable)
 {
-		GetNodeAt(_index).lock()->terrainCost = _cost;
+		if (IsWalkable(_index) != _walkable)
+		{
+				const int local = _index & (CHUNK_SIZE - 1);
+				GetMutableChunk(_index).m_walkableBits[local >> 6] ^= std::uint64_t(1) << (local & 63);
+				const glm::ivec2 index = GetCoord(_index);
+				UpdateNeighborMasks(index - glm::ivec2(1), index + glm::ivec2(1));
+				BumpRegionVersions(index);
+				m_walkableVersion++;
+				NotifyNodeChanged(_index);
+		}
 }
-std::vector<std::weak_ptr<Node>> Grid::GetNeighbors(std::weak_ptr<Node> _node, const Diagonal & _diagonal)
+
+void Grid::UpdateNeighborMasks(const glm::ivec2 & _first, const glm::ivec2 & _last)
 {
-		/**
-		* Get the neighbors of the given node.
-		*
-		*     sides											diagonals:
-		*  +---+---+---+    +---+---+---+
-		*  |   | 0 |   |    | 0 |   | 1 |
-		*  +---+---+---+    +---+---+---+
-		*  | 3 |   | 1 |    |   |   |   |
-		*  +---+---+---+    +---+---+---+
-		*  |   | 2 |   |    | 3 |   | 2 |
-		*  +---+---+---+    +---+---+---+
-		*/
-		std::vector<std::weak_ptr<Node>> neighbors;
-		bool side0 = false;
-		bool side1 = false;
-		bool side2 = false;
-		bool side3 = false;
-
-		bool diagonal0 = false;
-		bool diagonal1 = false;
-		bool diagonal2 = false;
-		bool diagonal3 = false;
-
-		//check if the node above is walkable
-		if (IsWalkableAt(glm::ivec2(_node.lock()->nodeIndex.x, _node.lock()->nodeIndex.y + 1)))
+		//the offsets of the neighbors in the order of the mask bits
+		const glm::ivec2 offsets[8] = { glm::ivec2(0, 1), glm::ivec2(1, 0), glm::ivec2(0, -1), glm::ivec2(-1, 0),
+				glm::ivec2(-1, 1), glm::ivec2(1, 1), glm::ivec2(1, -1), glm::ivec2(-1, -1) };
+		for (int y = std::max(_first.y, 0); y <= std::min(_last.y, m_numYNodes - 1); y++)
 		{
-				//if the node ^above^ is walkable then push it to the neighbors
-				neighbors.push_back(GetNodeAt(glm::ivec2(_node.lock()->nodeIndex.x, _node.lock()->nodeIndex.y + 1)));
-				side0 = true;
+				for (int x = std::max(_first.x, 0); x <= std::min(_last.x, m_numXNodes - 1); x++)
+				{
+						unsigned char mask = 0;
+						for (int i = 0; i < 8; i++)
+						{
+								if (IsWalkableAt(glm::ivec2(x, y) + offsets[i]))
+								{
+										mask |= static_cast<unsigned char>(1 << i);
+								}
+						}
+						const int index = GetIndex(glm::ivec2(x, y));
+						GetMutableChunk(index).m_neighborMasks[index & (CHUNK_SIZE - 1)] = mask;
+				}
 		}
-		if (IsWalkableAt(glm::ivec2(_node.lock()->nodeIndex.x + 1, _node.lock()->nodeIndex.y)))
+}
+
+void Grid::BumpRegionVersions(const glm::ivec2 & _index)
+{
+		//the neighbors are included, because a wall next to a node also changes the diagonal moves through it
+		const glm::ivec2 first(std::max(_index.x - 1, 0), std::max(_index.y - 1, 0));
+		const glm::ivec2 last(std::min(_index.x + 1, m_numXNodes - 1), std::min(_index.y + 1, m_numYNodes - 1));
+		for (int y = first.y / REGION_SIZE; y <= last.y / REGION_SIZE; y++)
 		{
-				//if the node >To the right> is walkable then push it to the neighbors
-				neighbors.push_back(GetNodeAt(glm::ivec2(_node.lock()->nodeIndex.x + 1, _node.lock()->nodeIndex.y)));
-				side1 = true;
+				for (int x = first.x / REGION_SIZE; x <= last.x / REGION_SIZE; x++)
+				{
+						m_regionVersions[y * m_numXRegions + x]++;
+				}
 		}
-		if (IsWalkableAt(glm::ivec2(_node.lock()->nodeIndex.x, _node.lock()->nodeIndex.y - 1)))
+}
+void Grid::SetTerrainCost(const glm::vec2 & _worldPos, int _cost)
+{
+		SetNodeTerrainCost(GetIndexAt(_worldPos), _cost);
+}
+void Grid::SetTerrainCost(const glm::ivec2 & _index, int _cost)
+{
+		SetNodeTerrainCost(GetIndex(_index), _cost);
+}
+void Grid::SetNodeTerrainCost(int _index, int _cost)
+{
+		//the cost has to fit in its byte, so stacked penalties saturate
+		_cost = std::min(std::max(_cost, 0), int(MAX_TERRAIN_COST));
+		if (GetTerrainCost(_index) == _cost)
 		{
-				//if the node \/below\/ is walkable then push it to the neighbors
-				neighbors.push_back(GetNodeAt(glm::ivec2(_node.lock()->nodeIndex.x, _node.lock()->nodeIndex.y - 1)));
-				side2 = true;
+				return;
 		}
-		if (IsWalkableAt(glm::ivec2(_node.lock()->nodeIndex.x - 1, _node.lock()->nodeIndex.y)))
+		//move the node from the count of its old cost to the new one
+		auto oldCost = m_terrainCostCounts.find(GetTerrainCost(_index));
+		if (--oldCost->second == 0)
 		{
-				//if the node <to the left< is walkable then push it to the neighbors
-				neighbors.push_back(GetNodeAt(glm::ivec2(_node.lock()->nodeIndex.x - 1, _node.lock()->nodeIndex.y)));
-				side3 = true;
+				m_terrainCostCounts.erase(oldCost);
 		}
+		m_terrainCostCounts[_cost]++;
+		GetMutableChunk(_index).m_terrainCosts[_index & (CHUNK_SIZE - 1)] = static_cast<unsigned char>(_cost);
+		NotifyNodeChanged(_index);
+}
 
-		//Check the diagonal movement state
-		switch (_diagonal)
-		{
-		case Diagonal::ALWAYS:
-		{
-				//always allow diagonals
-				diagonal0 = true;
-				diagonal1 = true;
-				diagonal2 = true;
-				diagonal3 = true;
-				break;
-		}
-		case Diagonal::NEVER:
-		{
-				//if it is just return the current walkable neighbors
-				return neighbors;
-		}
-		case Diagonal::IFNOWALLS:
+bool Grid::GetChangesSince(unsigned int _version, std::vector<int>& _changed) const
+{
+		_changed.clear();
+		//unsigned, so this still works once the version wrapped
+		if (m_changeVersion - _version > CHANGE_LOG_SIZE)
 		{
-				//diagonals are available if the 2 tiles adjacent to it are walkable
-				diagonal0 = side0 && side3;
-				diagonal1 = side0 && side1;
-				diagonal2 = side1 && side2;
-				diagonal3 = side2 && side3;
-				break;
+				return false;
 		}
-		case Diagonal::IFLESSTHANTWOWALLS:
+		for (unsigned int version = _version; version != m_changeVersion; version++)
 		{
-				//diagonals are available if at least 1 of the 2 adjacent tiles are free
-				diagonal0 = side0 || side3;
-				diagonal1 = side0 || side1;
-				diagonal2 = side1 || side2;
-				diagonal3 = side2 || side3;
-				break;
-		}
-		default:
-				//error
-				break;
+				_changed.push_back(m_changeLog[version % CHANGE_LOG_SIZE]);
 		}
+		return true;
+}
 
-		//add all the walkable diagonals
-
-		if (diagonal0 && IsWalkableAt(glm::ivec2(_node.lock()->nodeIndex.x - 1, _node.lock()->nodeIndex.y + 1)))
+std::shared_ptr<const Grid> Grid::GetSnapshot()
+{
+		if (!m_snapshot)
 		{
-				neighbors.push_back(GetNodeAt(glm::ivec2(_node.lock()->nodeIndex.x - 1, _node.lock()->nodeIndex.y + 1)));
+				m_snapshot = std::make_shared<const Grid>(*this);
 		}
-		if (diagonal1 && IsWalkableAt(glm::ivec2(_node.lock()->nodeIndex.x + 1, _node.lock()->nodeIndex.y + 1)))
+		return m_snapshot;
+}
+
+Grid::Chunk& Grid::GetMutableChunk(int _index)
+{
+		//a new version, the snapshot of the old one is only kept by the searches still holding it
+		m_snapshot.reset();
+		std::shared_ptr<Chunk>& chunk = m_chunks[_index >> CHUNK_SHIFT];
+		if (chunk.use_count() > 1)
 		{
-				neighbors.push_back(GetNodeAt(glm::ivec2(_node.lock()->nodeIndex.x + 1, _node.lock()->nodeIndex.y + 1)));
+				//a snapshot shares it, which keeps the old nodes
+				chunk = std::make_shared<Chunk>(*chunk);
 		}
-		if (diagonal2 && IsWalkableAt(glm::ivec2(_node.lock()->nodeIndex.x + 1, _node.lock()->nodeIndex.y - 1)))
+		else
 		{
-				neighbors.push_back(GetNodeAt(glm::ivec2(_node.lock()->nodeIndex.x + 1, _node.lock()->nodeIndex.y - 1)));
+				//the last snapshot may have been dropped on another thread, its reads of the chunk happen before the change
+				std::atomic_thread_fence(std::memory_order_acquire);
 		}
-		if (diagonal3 && IsWalkableAt(glm::ivec2(_node.lock()->nodeIndex.x - 1, _node.lock()->nodeIndex.y - 1)))
+		return *chunk;
+}
+
+void Grid::NotifyNodeChanged(int _index)
+{
+		m_changeLog[m_changeVersion % CHANGE_LOG_SIZE] = _index;
+		m_changeVersion++;
+		if (m_nodeChangedCallback)
 		{
-				neighbors.push_back(GetNodeAt(glm::ivec2(_node.lock()->nodeIndex.x - 1, _node.lock()->nodeIndex.y - 1)));
+				m_nodeChangedCallback(_index);
 		}
-
-		return neighbors;
 }
 
-std::vector<Node> Grid::GetNeighbors(const Node & _node, const Diagonal & _diagonal)
+void Grid::GetNeighbors(int _node, const Diagonal & _diagonal, NeighborList& _neighbors) const
 {
 		/**
 		* Get the neighbors of the given node.
@@ -253,155 +335,55 @@ std::vector<Node> Grid::GetNeighbors(const Node & _node, const Diagonal & _diago
 		*  |   | 2 |   |    | 3 |   | 2 |
 		*  +---+---+---+    +---+---+---+
 		*/
-		std::vector<Node> neighbors;
-		bool side0 = false;
-		bool side1 = false;
-		bool side2 = false;
-		bool side3 = false;
-
-		bool diagonal0 = false;
-		bool diagonal1 = false;
-		bool diagonal2 = false;
-		bool diagonal3 = false;
-
-		//check if the node above is walkable
-		if (IsWalkableAt(glm::ivec2(_node.nodeIndex.x, _node.nodeIndex.y + 1)))
-		{
-				//if the node ^above^ is walkable then push it to the neighbors
-				Node neighbor = *GetNodeAt(glm::ivec2(_node.nodeIndex.x, _node.nodeIndex.y + 1)).lock();
-				neighbors.push_back(neighbor);
-				side0 = true;
-		}
-		if (IsWalkableAt(glm::ivec2(_node.nodeIndex.x + 1, _node.nodeIndex.y)))
-		{
-				//if the node >To the right> is walkable then push it to the neighbors
-				Node neighbor = *GetNodeAt(glm::ivec2(_node.nodeIndex.x + 1, _node.nodeIndex.y)).lock();
-				neighbors.push_back(neighbor);
-				side1 = true;
-		}
-		if (IsWalkableAt(glm::ivec2(_node.nodeIndex.x, _node.nodeIndex.y - 1)))
-		{
-				//if the node \/below\/ is walkable then push it to the neighbors
-				Node neighbor = *GetNodeAt(glm::ivec2(_node.nodeIndex.x, _node.nodeIndex.y - 1)).lock();
-				neighbors.push_back(neighbor);
-				side2 = true;
-		}
-		if (IsWalkableAt(glm::ivec2(_node.nodeIndex.x - 1, _node.nodeIndex.y)))
+		//the flat index offsets of the neighbors in the order of the mask bits
+		const int offsets[8] = { m_numXNodes, 1, -m_numXNodes, -1, m_numXNodes - 1, m_numXNodes + 1, -m_numXNodes + 1, -m_numXNodes - 1 };
+		const NeighborDirections& directions = GetDirections(_diagonal, static_cast<unsigned char>(GetNeighborMask(_node)));
+		_neighbors.m_count = directions.m_count;
+		for (int i = 0; i < directions.m_count; i++)
 		{
-				//if the node <to the left< is walkable then push it to the neighbors
-				Node neighbor = *GetNodeAt(glm::ivec2(_node.nodeIndex.x - 1, _node.nodeIndex.y)).lock();
-				neighbors.push_back(neighbor);
-				side3 = true;
+				_neighbors.m_nodes[i] = _node + offsets[directions.m_directions[i]];
 		}
-
-		//Check the diagonal movement state
-		switch (_diagonal)
-		{
-		case Diagonal::ALWAYS:
-		{
-				//always allow diagonals
-				diagonal0 = true;
-				diagonal1 = true;
-				diagonal2 = true;
-				diagonal3 = true;
-				break;
-		}
-		case Diagonal::NEVER:
-		{
-				//if it is just return the current walkable neighbors
-				return neighbors;
-		}
-		case Diagonal::IFNOWALLS:
-		{
-				//diagonals are available if the 2 tiles adjacent to it are walkable
-				diagonal0 = side0 && side3;
-				diagonal1 = side0 && side1;
-				diagonal2 = side1 && side2;
-				diagonal3 = side2 && side3;
-				break;
-		}
-		case Diagonal::IFLESSTHANTWOWALLS:
-		{
-				//diagonals are available if at least 1 of the 2 adjacent tiles are free
-				diagonal0 = side0 || side3;
-				diagonal1 = side0 || side1;
-				diagonal2 = side1 || side2;
-				diagonal3 = side2 || side3;
-				break;
-		}
-		default:
-				//error
-				break;
-		}
-
-		//add all the walkable diagonals
-
-		if (diagonal0 && IsWalkableAt(glm::ivec2(_node.nodeIndex.x - 1, _node.nodeIndex.y + 1)))
-		{
-				Node neighbor = *GetNodeAt(glm::ivec2(_node.nodeIndex.x - 1, _node.nodeIndex.y + 1)).lock();
-				neighbors.push_back(neighbor);
-		}
-		if (diagonal1 && IsWalkableAt(glm::ivec2(_node.nodeIndex.x + 1, _node.nodeIndex.y + 1)))
-		{
-				Node neighbor = *GetNodeAt(glm::ivec2(_node.nodeIndex.x + 1, _node.nodeIndex.y + 1)).lock();
-				neighbors.push_back(neighbor);
-		}
-		if (diagonal2 && IsWalkableAt(glm::ivec2(_node.nodeIndex.x + 1, _node.nodeIndex.y - 1)))
-		{
-				Node neighbor = *GetNodeAt(glm::ivec2(_node.nodeIndex.x + 1, _node.nodeIndex.y - 1)).lock();
-				neighbors.push_back(neighbor);
-		}
-		if (diagonal3 && IsWalkableAt(glm::ivec2(_node.nodeIndex.x - 1, _node.nodeIndex.y - 1)))
-		{
-				Node neighbor = *GetNodeAt(glm::ivec2(_node.nodeIndex.x - 1, _node.nodeIndex.y - 1)).lock();
-				neighbors.push_back(neighbor);
-		}
-
-		return neighbors;
 }
 
-void Grid::DrawGrid(const glm::mat4& _projection)
+void Grid::GetNeighbors(int _node, const Diagonal & _diagonal, std::vector<int>& _neighbors) const
 {
-		for (size_t i = 0; i < m_nodeMap.size(); i++)
-		{
-				std::weak_ptr<Node> currentNode = m_nodeMap.at(i);
-
-				float radius = m_nodeDiameter / 2.0f;
-
-				//set the position minus the radius, because the world space position of the node is at the center, while we want to render it from the bottom left
-				glm::vec4 destRect(currentNode.lock()->worldPos.x - radius, currentNode.lock()->worldPos.y - radius, m_nodeDiameter - 1.0f, m_nodeDiameter - 1.0f);
-
-				GameEngine::ColorRGBA8 color;
+		NeighborList neighbors;
+		GetNeighbors(_node, _diagonal, neighbors);
+		_neighbors.assign(neighbors.begin(), neighbors.end());
+}
 
-				//draw the node with red color if it's collidable and green if it's not
-				if (!currentNode.lock()->walkable)
-				{
-						color.r = 255;
-						color.g = 0;
-						color.b = 0;
-						color.a = 255;
-				}
-				else
+void Grid::DrawGrid(GameEngine::DebugRenderer& _renderer, const glm::vec4& _viewRect) const
+{
+		//the nodes under the view, clamped to the grid
+		const int firstX = std::max(static_cast<int>(std::floor(_viewRect.x / m_nodeDiameter)), 0);
+		const int firstY = std::max(static_cast<int>(std::floor(_viewRect.y / m_nodeDiameter)), 0);
+		const int lastX = std::min(static_cast<int>(std::floor((_viewRect.x + _viewRect.z) / m_nodeDiameter)), m_numXNodes - 1);
+		const int lastY = std::min(static_cast<int>(std::floor((_viewRect.y + _viewRect.w) / m_nodeDiameter)), m_numYNodes - 1);
+		const float radius = m_nodeDiameter / 2.0f;
+		//draw the node with red color if it's collidable and green if it's not
+		const GameEngine::ColorRGBA8 blockedColor(255, 0, 0, 255);
+		const GameEngine::ColorRGBA8 walkableColor(0, 255, 0, 255);
+		for (int y = firstY; y <= lastY; y++)
+		{
+				for (int x = firstX; x <= lastX; x++)
 				{
-						color.r = 0;
-						color.g = 255;
-						color.b = 0;
-						color.a = 255;
+						const int i = y * m_numXNodes + x;
+						const glm::vec2 worldPos = GetWorldPos(i);
+						//set the position minus the radius, because the world space position of the node is at the center, while we want to render it from the bottom left
+						const glm::vec4 destRect(worldPos.x - radius, worldPos.y - radius, m_nodeDiameter - 1.0f, m_nodeDiameter - 1.0f);
+						_renderer.DrawBox(destRect, IsWalkable(i) ? walkableColor : blockedColor, 0.0f);
 				}
-				m_debugRenderer.DrawBox(destRect, color, 0.0f);
 		}
-		m_debugRenderer.End();
-		m_debugRenderer.Render(_projection, 1.0f);
 }
 
-void Grid::DrawPath(const std::vector<glm::vec2>& _path, const glm::mat4& _projection)
+void Grid::DrawPath(const std::vector<glm::vec2>& _path, GameEngine::DebugRenderer& _renderer) const
 {
 		if (!_path.empty())
 		{
 				for (size_t i = 0; i < _path.size() - 1; i++)
 				{
-						std::weak_ptr<Node> currentNode = GetNodeAt(_path.at(i));
-						std::weak_ptr<Node> nextNode = GetNodeAt(_path.at(i + 1));
+						const glm::vec2 currentPos = GetWorldPos(GetIndexAt(_path.at(i)));
+						const glm::vec2 nextPos = GetWorldPos(GetIndexAt(_path.at(i + 1)));
 
 						GameEngine::ColorRGBA8 color;
 
@@ -410,76 +392,65 @@ void Grid::DrawPath(const std::vector<glm::vec2>& _path, const glm::mat4& _proje
 						color.b = 0;
 						color.a = 255;
 
-						m_debugRenderer.DrawLine(currentNode.lock()->worldPos, nextNode.lock()->worldPos, color);
+						_renderer.DrawLine(currentPos, nextPos, color);
 				}
-				m_debugRenderer.End();
-				m_debugRenderer.Render(_projection, 3.0f);
-		}
-}
-
-void Grid::CleanGrid()
-{
-		for (auto& node : m_nodeMap)
-		{
-				node->g = 0;
-				node->h = 0;
-				node->inClosedSet = false;
-				node->inOpenSet = false;
-				node->parent.reset();
 		}
 }
 
-int Grid::GetNumNodes()
+int Grid::GetNumNodes() const
 {
 		return m_numXNodes * m_numYNodes;
 }
 
 void Grid::CreateGrid(std::vector<bool>& _walkableMatrix)
 {
-		size_t nodeMapSize = m_numXNodes * m_numYNodes;
-		m_nodeMap.reserve(nodeMapSize);
-
-		//The bottom left is always 0.0f, 0.0f here because the tile generation starts at origin position (0.0f, 0.0f)
-		glm::vec2 worldBottomLeft{ 0.0f, 0.0f };
+		const int numNodes = GetNumNodes();
 
-		for (size_t i = 0; i < nodeMapSize; i++)
+		//the world positions aren't stored, GetWorldPos derives them from the index
+		//all the nodes start with the default terrain cost (the chunks are zeroed)
+		m_snapshot.reset();
+		m_chunks.clear();
+		for (int i = 0; i < numNodes; i += CHUNK_SIZE)
 		{
-				int x = i % m_numXNodes;
-				int y = i / m_numXNodes;
-
-				float radius = m_nodeDiameter / 2.0f;
-
-				/*x or y * diameter so that it can correctly offset in each axis (node at index 0 will be from 0 to node diameter,
-				index 2 will start from 2 * diameter which means it will start at the end of the previous node and the added radius
-				in both axis is so that its world space position is at the center of the node and not at the bottom left (feels better) */
-				glm::vec2 worldPoint = worldBottomLeft + glm::vec2(x * m_nodeDiameter + radius, y * m_nodeDiameter + radius);
-
-				std::shared_ptr<Node> node = std::make_shared<Node>(worldPoint, glm::ivec2(x, y), _walkableMatrix.at(i));
-
-				m_nodeMap.push_back(std::move(node));
+				m_chunks.push_back(std::make_shared<Chunk>());
+		}
+		for (int i = 0; i < numNodes; i++)
+		{
+				if (_walkableMatrix.at(i))
+				{
+						const int local = i & (CHUNK_SIZE - 1);
+						m_chunks[i >> CHUNK_SHIFT]->m_walkableBits[local >> 6] |= std::uint64_t(1) << (local & 63);
+				}
 		}
+		m_terrainCostCounts.clear();
+		m_terrainCostCounts[0] = numNodes;
+		m_numXRegions = (m_numXNodes + REGION_SIZE - 1) / REGION_SIZE;
+		m_regionVersions.assign(m_numXRegions * ((m_numYNodes + REGION_SIZE - 1) / REGION_SIZE), 0);
+		m_walkableVersion++;
+		m_changeLog.assign(CHANGE_LOG_SIZE, -1);
+		UpdateNeighborMasks(glm::ivec2(0), glm::ivec2(m_numXNodes - 1, m_numYNodes - 1));
 }
 void Grid::CreateGrid()
 {
-		size_t nodeMapSize = m_numXNodes * m_numYNodes;
-		m_nodeMap.reserve(nodeMapSize);
-
-		glm::vec2 worldBottomLeft{ 0.0f, 0.0f };
-
-		for (size_t i = 0; i < nodeMapSize; i++)
+		std::vector<bool> walkableMatrix(GetNumNodes(), true);
+		CreateGrid(walkableMatrix);
+}
+void Grid::CreateGrid(std::vector<bool>& _walkableMatrix, const std::vector<unsigned char>& _terrainCosts)
+{
+		CreateGrid(_walkableMatrix);
+		//count the costs in a flat table first, the map only gets the few costs in use
+		std::array<int, MAX_TERRAIN_COST + 1> costCounts{};
+		for (int i = 0; i < GetNumNodes(); i++)
 		{
-				int x = i % m_numXNodes;
-				int y = i / m_numXNodes;
-
-				float radius = m_nodeDiameter / 2.0f;
-
-				/*x or y * diameter so that it can correctly offset in each axis (node at index 0 will be from 0 to node diameter,
-				index 2 will start from 2 * diameter which means it will start at the end of the previous node and the added radius
-				in both axis is so that its world space position is at the center of the node and not at the bottom left (feels better) */
-				glm::vec2 worldPoint = worldBottomLeft + glm::vec2(x * m_nodeDiameter + radius, y * m_nodeDiameter + radius);
-
-				std::shared_ptr<Node> node = std::make_shared<Node>(worldPoint, glm::ivec2(x, y), true);
-
-				m_nodeMap.push_back(std::move(node));
+				m_chunks[i >> CHUNK_SHIFT]->m_terrainCosts[i & (CHUNK_SIZE - 1)] = _terrainCosts[i];
+				costCounts[_terrainCosts[i]]++;
+		}
+		m_terrainCostCounts.clear();
+		for (int cost = 0; cost <= MAX_TERRAIN_COST; cost++)
+		{
+				if (costCounts[cost] > 0)
+				{
+						m_terrainCostCounts[cost] = costCounts[cost];
+				}
 		}
 }
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
+#include <array>
+#include <cstdint>
 #include <vector>
+#include <map>
 #include <memory>
+#include <functional>
 #include <GameEngine\DebugRenderer.h>
 
 #include "Node.h"
@@ -8,6 +12,19 @@
 class Grid
 {
 public:
+		/** \brief The neighbors of a node as flat indices, a fixed array so filling it never allocates */
+		struct NeighborList
+		{
+				const int* begin() const noexcept { return m_nodes.data(); }
+				const int* end() const noexcept { return m_nodes.data() + m_count; }
+				int size() const noexcept { return m_count; }
+				bool empty() const noexcept { return m_count == 0; }
+
+				std::array<int, 8> m_nodes;
+				int m_count{ 0 };
+		};
+
+		/** \brief Copies the grid without its callback. The copy shares the chunks of the layers (see CHUNK_SIZE) until either grid changes one */
 		Grid(const Grid& _obj);
 		Grid();
 		~Grid();
@@ -35,6 +52,11 @@ public:
 		*/
 		Grid(size_t _numXNodes, size_t _numYNodes, float _nodeDiameter, std::vector<bool>& _walkableMatrix);
 		Grid(size_t _numXNodes, size_t _numYNodes, float _nodeDiameter);
+		/** \brief Create the grid with preset walkable flags and terrain costs in one go (e.g. for a generated level),
+		* instead of setting them node by node, which updates the neighbor masks, versions and change log every time
+		* \param _terrainCosts - the terrain cost of every node (needs to be the same size as the grid)
+		*/
+		Grid(size_t _numXNodes, size_t _numYNodes, float _nodeDiameter, std::vector<bool>& _walkableMatrix, const std::vector<unsigned char>& _terrainCosts);
 
 		/** \brief Gets node based on world coordinate
 		* \param _worldPos - the x,y coordinate in world space
@@ -42,28 +64,60 @@ public:
 		* eg. world coordinate of 0,0 to diameter, diameter (32,32 for example)
 		* will be converted to 0, 0 and 0 + diameter, 0 + diameter to diameter * 2, diameter * 2 (diagonal top-right of index 0, 0)
 		* will be converted to 1, 1
-		* \return Node* -  a pointer to the node at this coordinate
+		* \return Node -  a copy of the node at this coordinate, see GetNode
 		*/
-		std::weak_ptr<Node> GetNodeAt(const glm::vec2& _worldPos);
+		Node GetNodeAt(const glm::vec2& _worldPos) const;
 
 		/** \brief Gets node based on its index in the node vector
 		* \param _index - the x,y index in the vector
 		* index 0,0 return the bottom left node, while index m_numXNodes, m_numyNodes will return the top right node
-		* \return Node* -  a pointer to the node at this index
+		* \return Node -  a copy of the node at this index
+		*/
+		Node GetNodeAt(const glm::ivec2& _index) const;
+
+		/** \brief Gets the flat index of the node at a world coordinate (throws if it's outside of the grid)
+		* The pathfinding works on these indices, index = y * m_numXNodes + x
 		*/
-		std::weak_ptr<Node> GetNodeAt(const glm::ivec2& _index);
+		int GetIndexAt(const glm::vec2& _worldPos) const;
+		/** \brief Converts the x,y index of a node to its flat index */
+		int GetIndex(const glm::ivec2& _index) const noexcept { return _index.y * m_numXNodes + _index.x; }
+		/** \brief Converts the flat index of a node back to its x,y index */
+		glm::ivec2 GetCoord(int _index) const noexcept { return glm::ivec2(_index % m_numXNodes, _index / m_numXNodes); }
+
+		/** \brief Gets the node with flat index _index (no range checks)
+		* The grid doesn't keep Node objects, only a walkable bit, a terrain cost byte and a neighbor mask per node,
+		* so this builds a copy of them. The searches read the layers with the accessors below instead
+		*/
+		Node GetNode(int _index) const noexcept { return Node(GetWorldPos(_index), GetCoord(_index), IsWalkable(_index), GetTerrainCost(_index)); }
+		/** \brief Check if the node with flat index _index can be walked on (no range checks) */
+		bool IsWalkable(int _index) const noexcept
+		{
+				const int local = _index & (CHUNK_SIZE - 1);
+				return ((GetChunk(_index).m_walkableBits[local >> 6] >> (local & 63)) & 1) != 0;
+		}
+		/** \brief Gets the terrain cost of the node with flat index _index (no range checks) */
+		int GetTerrainCost(int _index) const noexcept { return GetChunk(_index).m_terrainCosts[_index & (CHUNK_SIZE - 1)]; }
+		/** \brief Gets the world position of the center of the node with flat index _index
+		* The bottom left of the grid is always at 0,0, so node x,y spans x * diameter to (x + 1) * diameter and its center is half a diameter further
+		*/
+		glm::vec2 GetWorldPos(int _index) const noexcept
+		{
+				const glm::ivec2 coord = GetCoord(_index);
+				const float radius = m_nodeDiameter / 2.0f;
+				return glm::vec2(coord.x * m_nodeDiameter + radius, coord.y * m_nodeDiameter + radius);
+		}
 
 		/** \brief Check if the node at a certain world coordinate can be walked on
 		* \param _worldPos - the world coordinate of the node
 		* \return bool					-	true if walkable, false if coordinate isn't in the node map or node isn't walkable
 		*/
-		bool IsWalkableAt(const glm::vec2& _worldPos);
+		bool IsWalkableAt(const glm::vec2& _worldPos) const;
 
 		/** \brief Check if the node at a certain index in the node vector can be walked on
 		* \param _index - the x,y index in the vector
 		* \return bool  - true if walkable, false if coordinate isn't in the node map or node isn't walkable
 		*/
-		bool IsWalkableAt(const glm::ivec2& _index);
+		bool IsWalkableAt(const glm::ivec2& _index) const;
 
 		/** \brief Check if this index exists in the vector
 		* \param _x - the x index (node on the x axis
@@ -72,7 +126,7 @@ public:
 		* the index should not have coordinates below 0 or above the specified m_numXNodes and m_numyNodes of the map
 		* \return bool -  true if the coordinate exists
 		*/
-		bool IsPosInside(const glm::vec2& _index);
+		bool IsPosInside(const glm::vec2& _index) const;
 
 		/** \brief Sets the node at set world coordinate to _walkable
 		* \param _worldPos - the world coordinate of the node
@@ -85,50 +139,157 @@ public:
 		* \param _walkable - the flag whether to set it to walkable or not
 		*/
 		void SetWalkableAt(const glm::ivec2& _index, bool _walkable);
-		
+
 		/** \brief Sets the terrain cost of node at set world coordinate to _cost
 		* \param _worldPos - the world coordinate of the node
-		* \param _cost - the terrain cost
+		* \param _cost - the terrain cost (clamped to 0 - MAX_TERRAIN_COST)
 		*/
 		void SetTerrainCost(const glm::vec2& _worldPos, int _cost);
 
 		/** \brief Sets the terrain cost of node at set index to _cost
 		* \param _index - the index of the node in the vector
-		* \param _cost - the terrain cost
+		* \param _cost - the terrain cost (clamped to 0 - MAX_TERRAIN_COST)
 		*/
 		void SetTerrainCost(const glm::ivec2& _index, int _cost);
 
-		/** \brief Gets all the available neighbors of the certain node
-		* \param _node - pointer to the node to be checked
-		* \param _diagonal - flag for diagonal movement
-		* \return std::vector<Node*> - a vector of all available neighbors
+		/** \brief The terrain costs are kept in one byte per node */
+		enum : int { MAX_TERRAIN_COST = 255 };
+
+		/** \brief Check if every node has the same terrain cost (e.g. for Jump Point Search, which needs uniform costs) */
+		bool HasUniformTerrainCost() const noexcept { return m_terrainCostCounts.size() <= 1; }
+
+		/** \brief The grid is split into square regions of REGION_SIZE nodes, each with a version which is bumped whenever the walkability
+			* of one of its nodes (or of a node right next to it) changes, so cached paths can tell if they are still valid */
+		enum : int { REGION_SIZE = 16 };
+		/** \brief Gets the region of the node with flat index _index */
+		int GetRegion(int _index) const noexcept { return (_index / m_numXNodes / REGION_SIZE) * m_numXRegions + (_index % m_numXNodes) / REGION_SIZE; }
+		unsigned int GetRegionVersion(int _region) const noexcept { return m_regionVersions[_region]; }
+		/** \brief Bumped whenever the walkability of any node changes (the terrain costs don't), so what only depends on the walls
+			* (like the line of sight results) can tell if it is still valid */
+		unsigned int GetWalkableVersion() const noexcept { return m_walkableVersion; }
+
+		/** \brief Sets the function called with the flat index of a node after SetWalkableAt or SetTerrainCost changed it
+			* (e.g. for the HierarchicalGrid built on this grid), nullptr removes it */
+		void SetNodeChangedCallback(std::function<void(int)> _callback) { m_nodeChangedCallback = _callback; }
+
+		/** \brief The last CHANGE_LOG_SIZE changed nodes are also kept in a log, so any number of incremental searches (e.g. a DStarLite
+			* per agent) can find out what changed since they last looked, without a callback of their own */
+		enum : unsigned int { CHANGE_LOG_SIZE = 1024 };
+		/** \brief Gets the number of node changes so far, to pass to GetChangesSince later */
+		unsigned int GetChangeVersion() const noexcept { return m_changeVersion; }
+		/** \brief Gets the flat indices of the nodes changed since _version (in order, a node can be in it more than once)
+		* \return false if more than CHANGE_LOG_SIZE changes happened since, so some of them were dropped from the log
 		*/
-		std::vector<std::weak_ptr<Node>> GetNeighbors(std::weak_ptr<Node> _node, const Diagonal& _diagonal);
-		std::vector<Node> GetNeighbors(const Node& _node, const Diagonal& _diagonal);
+		bool GetChangesSince(unsigned int _version, std::vector<int>& _changed) const;
 
-		std::vector<std::shared_ptr<Node>> GetNodemap() const noexcept { return m_nodeMap; }
+		/** \brief The layers are kept in chunks of CHUNK_SIZE nodes (by flat index), which the copies of the grid share until one of them
+			* changes a node of the chunk: only that chunk is copied then, so copying the grid doesn't copy the nodes */
+		enum : int { CHUNK_SHIFT = 12, CHUNK_SIZE = 1 << CHUNK_SHIFT };
+		/** \brief An immutable copy of the grid as it is now, for the searches of other threads while this grid keeps changing.
+			* The same copy is returned until a node changes. A search pins the version by holding on to it (the changes copy the chunks
+			* it shares), the version is freed with its last holder. Call it on the thread which changes the grid
+			*/
+		std::shared_ptr<const Grid> GetSnapshot();
 
-		/** \brief Render the outlines of the nodes as rectangles for debugging
-		* \param _projection - the projection matrix to be used in the shader
+		/** \brief Gets all the available neighbors of the certain node
+			* \param _node - the flat index of the node to be checked
+			* \param _diagonal - flag for diagonal movement
+		* \param _neighbors - filled with the flat indices of all available neighbors (cleared first)
+		* The walkable neighbors of every node are kept as a bit mask, so this is a table lookup without any walkability checks
 		*/
-		void DrawGrid(const glm::mat4& _projection);
-		void DrawPath(const std::vector<glm::vec2>& _path, const glm::mat4& _projection);
+		void GetNeighbors(int _node, const Diagonal& _diagonal, NeighborList& _neighbors) const;
+		void GetNeighbors(int _node, const Diagonal& _diagonal, std::vector<int>& _neighbors) const;
+		/** \brief GetNeighbors for a diagonal mode known at compile time (the searches specialized on it, see PathFinder::Dijkstra):
+		* the checks of the other modes fold away and the eight directions are unrolled. The same neighbors in the same order
+		*/
+		template <Diagonal D>
+		void GetNeighbors(int _node, NeighborList& _neighbors) const
+		{
+				const unsigned int mask = GetNeighborMask(_node);
+				int count = 0;
+				//the sides (above, right, below, left)
+				if (mask & 1u) { _neighbors.m_nodes[count++] = _node + m_numXNodes; }
+				if (mask & 2u) { _neighbors.m_nodes[count++] = _node + 1; }
+				if (mask & 4u) { _neighbors.m_nodes[count++] = _node - m_numXNodes; }
+				if (mask & 8u) { _neighbors.m_nodes[count++] = _node - 1; }
+				if (D != Diagonal::NEVER)
+				{
+						//the diagonals (top-left, top-right, bottom-right, bottom-left), each one between two of the sides
+						if (IsDiagonalAllowed<D>(mask, 16u, 1u, 8u)) { _neighbors.m_nodes[count++] = _node + m_numXNodes - 1; }
+						if (IsDiagonalAllowed<D>(mask, 32u, 2u, 1u)) { _neighbors.m_nodes[count++] = _node + m_numXNodes + 1; }
+						if (IsDiagonalAllowed<D>(mask, 64u, 4u, 2u)) { _neighbors.m_nodes[count++] = _node - m_numXNodes + 1; }
+						if (IsDiagonalAllowed<D>(mask, 128u, 8u, 4u)) { _neighbors.m_nodes[count++] = _node - m_numXNodes - 1; }
+				}
+				_neighbors.m_count = count;
+		}
 
-		/** \brief Cleans the values of the nodes in the grid (except for terrain cost) */
-		void CleanGrid();
+		/** \brief Adds the outlines of the nodes as rectangles to _renderer for debugging, only the ones _viewRect overlaps are visited
+		* \param _viewRect - the visible world rect (bottom left x, y, width, height), see Camera2D::GetViewRect
+		*/
+		void DrawGrid(GameEngine::DebugRenderer& _renderer, const glm::vec4& _viewRect) const;
+		/** \brief Adds the lines of _path to _renderer for debugging */
+		void DrawPath(const std::vector<glm::vec2>& _path, GameEngine::DebugRenderer& _renderer) const;
 
 		/** \brief Gets the total number of nodes in the node map */
-		int GetNumNodes();
+		int GetNumNodes() const;
+		int GetNumXNodes() const noexcept { return m_numXNodes; }
+		int GetNumYNodes() const noexcept { return m_numYNodes; }
+		float GetNodeDiameter() const noexcept { return m_nodeDiameter; }
 
 private:
+		/** \brief CHUNK_SIZE nodes of every layer, addressed by index & (CHUNK_SIZE - 1) */
+		struct Chunk
+		{
+				std::array<std::uint64_t, CHUNK_SIZE / 64> m_walkableBits{}; ///< node i is bit i % 64 of word i / 64
+				std::array<unsigned char, CHUNK_SIZE> m_terrainCosts{};
+				std::array<unsigned char, CHUNK_SIZE> m_neighborMasks{}; ///< the walkable neighbors, bit i for neighbor i of GetNeighbors (sides, then diagonals)
+		};
+
+		const Chunk& GetChunk(int _index) const noexcept { return *m_chunks[_index >> CHUNK_SHIFT]; }
+		/** \brief The chunk of the node for changing it, copied first if another grid (a snapshot) shares it */
+		Chunk& GetMutableChunk(int _index);
+		unsigned int GetNeighborMask(int _index) const noexcept { return GetChunk(_index).m_neighborMasks[_index & (CHUNK_SIZE - 1)]; }
+
+		/** \brief The rule of ComputeDirections in Grid.cpp for one diagonal mode: the diagonal is walkable and the mode allows it
+			*  with the walls of the two sides next to it */
+		template <Diagonal D>
+		static bool IsDiagonalAllowed(unsigned int _mask, unsigned int _diagonal, unsigned int _firstSide, unsigned int _secondSide) noexcept
+		{
+				if ((_mask & _diagonal) == 0)
+				{
+						return false;
+				}
+				switch (D)
+				{
+				case Diagonal::ALWAYS: return true;
+				case Diagonal::IFNOWALLS: return (_mask & _firstSide) != 0 && (_mask & _secondSide) != 0;
+				case Diagonal::IFLESSTHANTWOWALLS: return (_mask & _firstSide) != 0 || (_mask & _secondSide) != 0;
+				default: return false;
+				}
+		}
+
 		void CreateGrid(std::vector<bool>& _walkableMatrix); ///< create the grid with preset collidable flags
 		void CreateGrid(); ///< create the grid with all nodes set to collidable
+		void CreateGrid(std::vector<bool>& _walkableMatrix, const std::vector<unsigned char>& _terrainCosts); ///< and with preset terrain costs
+		void SetNodeTerrainCost(int _index, int _cost); ///< sets the cost and keeps m_terrainCostCounts up to date
+		void SetNodeWalkable(int _index, bool _walkable);
+		void BumpRegionVersions(const glm::ivec2& _index); ///< bumps the regions of the node and its neighbors
+		void UpdateNeighborMasks(const glm::ivec2& _first, const glm::ivec2& _last); ///< recomputes the masks of the nodes in [_first, _last]
+		void NotifyNodeChanged(int _index); ///< logs the change and calls the callback
 
 private:
-		std::vector<std::shared_ptr<Node>> m_nodeMap; ///< a 1D vector representing a 2D vector for better performance
-		glm::vec2 m_gridWorldSize{ 0.0f, 0.0f }; ///< the size of the grid world (width * node diameter and height * nodeDiameter) 
+		//the layers of the nodes, flat 1D arrays representing 2D ones, addressed by index = y * m_numXNodes + x and split into chunks
+		std::vector<std::shared_ptr<Chunk>> m_chunks; ///< node i is in chunk i >> CHUNK_SHIFT, shared with the copies of the grid
+		glm::vec2 m_gridWorldSize{ 0.0f, 0.0f }; ///< the size of the grid world (width * node diameter and height * nodeDiameter)
 		float m_nodeDiameter; /// the diameter of each node
-		int m_numXNodes; ///< the number of nodes on the x axis (width) 
+		int m_numXNodes; ///< the number of nodes on the x axis (width)
 		int m_numYNodes; ///< the number of nodes on the y axis (height)
-		GameEngine::DebugRenderer m_debugRenderer; ///< a debug renderer to render the nodes for debugging
-};
\ No newline at end of file
+		std::map<int, int> m_terrainCostCounts; ///< how many nodes have each terrain cost (only the costs in use are kept)
+		int m_numXRegions{ 0 }; ///< the number of regions on the x axis
+		std::vector<unsigned int> m_regionVersions; ///< the version of every region, see REGION_SIZE
+		unsigned int m_walkableVersion{ 0 }; ///< see GetWalkableVersion
+		std::function<void(int)> m_nodeChangedCallback; ///< called when a node changed (not copied with the grid)
+		std::vector<int> m_changeLog; ///< a ring of the last CHANGE_LOG_SIZE changed nodes, change v is at v % CHANGE_LOG_SIZE
+		unsigned int m_changeVersion{ 0 }; ///< the number of changes so far
+		std::shared_ptr<const Grid> m_snapshot; ///< the snapshot of the current version, dropped when a node changes (not copied with the grid)
+};
@@ -0,0 +1,130 @@
+#include "GridOverlay.h"
+#include <GameEngine\RenderState.h>
+
+namespace
+{
+		const char* OVERLAY_VERT_SRC = R"(#version 130
+uniform mat4 P;
+uniform vec2 gridSize;
+uniform float nodeDiameter;
+//in nodes
+out vec2 nodePosition;
+void main() {
+    //the corners of the grid as a strip of two triangles
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    nodePosition = corner * gridSize;
+    //the z position is zero since we are in 2D
+    gl_Position = vec4((P * vec4(nodePosition * nodeDiameter, 0.0, 1.0)).xy, 0.0, 1.0);
+})";
+
+		const char* OVERLAY_FRAG_SRC = R"(#version 130
+in vec2 nodePosition;
+out vec4 color;
+uniform sampler2D states;
+//by GridOverlay::NodeState
+const vec4 STATE_COLORS[5] = vec4[5](
+    vec4(1.0, 0.0, 0.0, 0.35),
+    vec4(0.0, 1.0, 0.0, 0.1),
+    vec4(1.0, 1.0, 0.0, 0.45),
+    vec4(0.0, 0.4, 1.0, 0.45),
+    vec4(1.0, 1.0, 1.0, 0.7));
+void main() {
+    int state = int(texelFetch(states, ivec2(nodePosition), 0).r * 255.0 + 0.5);
+    color = STATE_COLORS[min(state, 4)];
+    //the outlines of the nodes, a pixel wide at any zoom
+    vec2 edge = fract(nodePosition);
+    if (any(lessThan(edge, fwidth(nodePosition)))) {
+        color.a = min(color.a + 0.3, 1.0);
+    }
+})";
+}
+
+void GridOverlay::Init()
+{
+		m_program.CompileShadersFromSource(OVERLAY_VERT_SRC, OVERLAY_FRAG_SRC);
+		m_projectionUniform = m_program.GetUniformLocation("P");
+		m_gridSizeUniform = m_program.GetUniformLocation("gridSize");
+		m_nodeDiameterUniform = m_program.GetUniformLocation("nodeDiameter");
+		m_program.Use();
+		glUniform1i(m_program.GetUniformLocation("states"), 0);
+		m_program.UnUse();
+
+		glGenVertexArrays(1, &m_vao);
+		glGenTextures(1, &m_texture);
+		GameEngine::RenderState::Get().BindTexture(0, GL_TEXTURE_2D, m_texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		GameEngine::RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+}
+
+void GridOverlay::Dispose()
+{
+		if (m_texture)
+		{
+				GameEngine::RenderState::Get().DeleteTextures(1, &m_texture);
+				m_texture = 0;
+		}
+		if (m_vao)
+		{
+				GameEngine::RenderState::Get().DeleteVertexArrays(1, &m_vao);
+				m_vao = 0;
+		}
+		m_program.Dispose();
+		m_size = glm::ivec2(0);
+}
+
+void GridOverlay::Update(const Grid& _grid, const SearchContext* _search, const std::vector<int>& _path)
+{
+		const int numNodes = _grid.GetNumNodes();
+		m_states.resize(numNodes);
+		for (int i = 0; i < numNodes; i++)
+		{
+				NodeState state = _grid.IsWalkable(i) ? WALKABLE : BLOCKED;
+				if (_search != nullptr && _search->IsVisited(i))
+				{
+						const SearchNode& node = _search->At(i);
+						state = node.inClosedSet ? CLOSED : (node.inOpenSet ? OPEN : state);
+				}
+				m_states[i] = state;
+		}
+		for (int node : _path)
+		{
+				m_states[node] = PATH;
+		}
+		m_nodeDiameter = _grid.GetNodeDiameter();
+
+		//a row of bytes isn't a multiple of 4 for every width
+		const glm::ivec2 size(_grid.GetNumXNodes(), _grid.GetNumYNodes());
+		GameEngine::RenderState::Get().BindTexture(0, GL_TEXTURE_2D, m_texture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		if (size != m_size)
+		{
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, size.x, size.y, 0, GL_RED, GL_UNSIGNED_BYTE, m_states.data());
+				m_size = size;
+		}
+		else
+		{
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size.x, size.y, GL_RED, GL_UNSIGNED_BYTE, m_states.data());
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		GameEngine::RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+}
+
+void GridOverlay::Draw(const glm::mat4& _projection)
+{
+		if (m_size.x == 0 || m_size.y == 0)
+		{
+				return;
+		}
+		m_program.Use();
+		glUniformMatrix4fv(m_projectionUniform, 1, GL_FALSE, &_projection[0][0]);
+		glUniform2f(m_gridSizeUniform, static_cast<float>(m_size.x), static_cast<float>(m_size.y));
+		glUniform1f(m_nodeDiameterUniform, m_nodeDiameter);
+		GameEngine::RenderState::Get().BindTexture(0, GL_TEXTURE_2D, m_texture);
+		GameEngine::RenderState::Get().BindVertexArray(m_vao);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		GameEngine::RenderState::Get().BindVertexArray(0);
+		m_program.UnUse();
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <glm\glm.hpp>
+#include <GameEngine\GLSLProgram.h>
+
+#include "Grid.h"
+#include "SearchContext.h"
+
+/** \brief Shows the state of every node of a grid at once: Update() writes one byte per node into a texture, Draw() covers the grid with
+	*  a single quad whose fragments look their node up in it. Drawing costs the same for any size of grid, only an Update() walks the nodes,
+	*  so it's called when the grid or the shown search changed and not every frame */
+class GridOverlay
+{
+public:
+		/** \brief The state of a node, the value of its texel */
+		enum NodeState : unsigned char
+		{
+				BLOCKED,
+				WALKABLE,
+				OPEN,   ///< in the open set of the shown search
+				CLOSED, ///< in the closed set of the shown search
+				PATH    ///< on the shown path
+		};
+
+		GridOverlay() {}
+		~GridOverlay() { Dispose(); }
+
+		/** \brief Compiles the shader and makes the texture, needs a GL context */
+		void Init();
+		void Dispose();
+
+		/** \brief Writes the states of the nodes and uploads them
+			*  \param _search - the search to show the open and closed sets of, nullptr for none
+			*  \param _path   - the node indices of the path to show (see PathFinder), may be empty */
+		void Update(const Grid& _grid, const SearchContext* _search, const std::vector<int>& _path);
+		/** \brief Draws the states over the grid, which has its bottom left at 0,0 in world space
+			*  \param _projection - the camera matrix */
+		void Draw(const glm::mat4& _projection);
+
+private:
+		GameEngine::GLSLProgram m_program;
+		GLint m_projectionUniform{ -1 };
+		GLint m_gridSizeUniform{ -1 };
+		GLint m_nodeDiameterUniform{ -1 };
+		GLuint m_texture{ 0 };
+		GLuint m_vao{ 0 };    ///< no attributes, the shader makes the corners of the quad from gl_VertexID
+		glm::ivec2 m_size{ 0, 0 }; ///< the nodes of the grid, the size of the texture
+		float m_nodeDiameter{ 1.0f };
+		std::vector<unsigned char> m_states; ///< one NodeState per node, addressed like the grid
+};
@@ -0,0 +1,456 @@
+#include "HierarchicalGrid.h"
+#include "AStarQuery.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+//runs of border nodes at least this long get an entrance at both ends instead of one in the middle
+constexpr int LONG_ENTRANCE = 6;
+constexpr int UNREACHABLE = std::numeric_limits<int>::max();
+
+HierarchicalGrid::HierarchicalGrid(std::shared_ptr<Grid> _grid, int _clusterSize, const Diagonal& _diagonal) :
+		m_grid(_grid), m_clusterSize(_clusterSize), m_diagonal(_diagonal), m_heuristic(PathFinder::SelectHeuristic(_diagonal))
+{
+		Rebuild();
+		m_grid->SetNodeChangedCallback([this](int _index) { OnNodeChanged(_index); });
+}
+
+HierarchicalGrid::~HierarchicalGrid()
+{
+		m_grid->SetNodeChangedCallback(nullptr);
+}
+
+void HierarchicalGrid::Rebuild()
+{
+		std::unique_lock<std::shared_timed_mutex> lock(m_mutex);
+		m_numXClusters = (m_grid->GetNumXNodes() + m_clusterSize - 1) / m_clusterSize;
+		m_numYClusters = (m_grid->GetNumYNodes() + m_clusterSize - 1) / m_clusterSize;
+		const int numClusters = m_numXClusters * m_numYClusters;
+
+		m_nodes.clear();
+		m_freeNodes.clear();
+		m_abstractIndex.assign(m_grid->GetNumNodes(), -1);
+		m_clusterNodes.assign(numClusters, std::vector<int>());
+		m_borderEntrances.assign(numClusters * 2, std::vector<Entrance>());
+
+		for (int border = 0; border < numClusters * 2; border++)
+		{
+				BuildBorder(border);
+		}
+		for (int cluster = 0; cluster < numClusters; cluster++)
+		{
+				BuildIntraEdges(cluster);
+		}
+}
+
+void HierarchicalGrid::OnNodeChanged(int _index)
+{
+		std::unique_lock<std::shared_timed_mutex> lock(m_mutex);
+		const glm::ivec2 coord = m_grid->GetCoord(_index);
+		const int cluster = GetCluster(coord);
+		const glm::ivec2 clusterMin = GetClusterMin(cluster);
+		const glm::ivec2 clusterMax = GetClusterMax(cluster);
+
+		//the entrances only change if the node is on the edge of its cluster, the neighbor across gets new costs as well
+		std::vector<int> changedClusters{ cluster };
+		auto rebuildBorder = [this, &changedClusters](int _border, int _neighbor)
+		{
+				ClearBorder(_border);
+				BuildBorder(_border);
+				changedClusters.push_back(_neighbor);
+		};
+		const int clusterX = cluster % m_numXClusters;
+		const int clusterY = cluster / m_numXClusters;
+		if (coord.x == clusterMax.x - 1 && clusterX + 1 < m_numXClusters)
+		{
+				rebuildBorder(cluster * 2, cluster + 1);
+		}
+		if (coord.y == clusterMax.y - 1 && clusterY + 1 < m_numYClusters)
+		{
+				rebuildBorder(cluster * 2 + 1, cluster + m_numXClusters);
+		}
+		if (coord.x == clusterMin.x && clusterX > 0)
+		{
+				rebuildBorder((cluster - 1) * 2, cluster - 1);
+		}
+		if (coord.y == clusterMin.y && clusterY > 0)
+		{
+				rebuildBorder((cluster - m_numXClusters) * 2 + 1, cluster - m_numXClusters);
+		}
+
+		for (int changedCluster : changedClusters)
+		{
+				BuildIntraEdges(changedCluster);
+		}
+}
+
+std::vector<int> HierarchicalGrid::FindPath(int _start, int _end, SearchContext& _context) const
+{
+		std::shared_lock<std::shared_timed_mutex> lock(m_mutex);
+		const Grid& grid = *m_grid;
+		if (!grid.IsWalkable(_start) || !grid.IsWalkable(_end) || _start == _end)
+		{
+				return std::vector<int>();
+		}
+
+		//connect the start and the end to the entrances of their clusters
+		const int startCluster = GetCluster(grid.GetCoord(_start));
+		const int endCluster = GetCluster(grid.GetCoord(_end));
+		std::vector<int> startCosts, startParents, endCosts, endParents;
+		SearchCluster(startCluster, _start, false, startCosts, startParents);
+		SearchCluster(endCluster, _end, true, endCosts, endParents);
+
+		//the start and the end are two extra nodes after the abstract ones
+		const int startNode = static_cast<int>(m_nodes.size());
+		const int endNode = startNode + 1;
+		auto gridIndexOf = [&](int _node) { return _node == startNode ? _start : (_node == endNode ? _end : m_nodes[_node].gridIndex); };
+
+		_context.Begin(endNode + 1);
+		IndexedHeap<ComparePriority>& openSet = _context.GetOpenSet();
+		const glm::ivec2 endCoord = grid.GetCoord(_end);
+
+		auto relax = [&](int _from, int _to, int _cost)
+		{
+				SearchNode& toState = _context.Visit(_to);
+				if (toState.inClosedSet)
+				{
+						return;
+				}
+				const int newG = _context.At(_from).g + _cost;
+				if (!toState.inOpenSet)
+				{
+						toState.g = newG;
+						toState.h = m_heuristic(grid.GetCoord(gridIndexOf(_to)), endCoord);
+						toState.parent = _from;
+						toState.inOpenSet = true;
+						openSet.Push(_to);
+				}
+				else if (newG < toState.g)
+				{
+						toState.g = newG;
+						toState.parent = _from;
+						openSet.Update(_to);
+				}
+		};
+
+		SearchNode& startState = _context.Visit(startNode);
+		startState.h = m_heuristic(grid.GetCoord(_start), endCoord);
+		startState.inOpenSet = true;
+		openSet.Push(startNode);
+
+		bool found = false;
+		while (!openSet.IsEmpty())
+		{
+				const int current = openSet.Front();
+				SearchNode& currentState = _context.At(current);
+				currentState.inOpenSet = false;
+				currentState.inClosedSet = true;
+				openSet.Pop();
+
+				if (current == endNode)
+				{
+						found = true;
+						break;
+				}
+
+				if (current == startNode)
+				{
+						for (int node : m_clusterNodes[startCluster])
+						{
+								const int cost = startCosts[GetLocalIndex(startCluster, m_nodes[node].gridIndex)];
+								if (cost != UNREACHABLE)
+								{
+										relax(current, node, cost);
+								}
+						}
+						//the direct path if both are in the same cluster
+						if (startCluster == endCluster && startCosts[GetLocalIndex(startCluster, _end)] != UNREACHABLE)
+						{
+								relax(current, endNode, startCosts[GetLocalIndex(startCluster, _end)]);
+						}
+						continue;
+				}
+
+				const AbstractNode& node = m_nodes[current];
+				for (const AbstractEdge& edge : node.interEdges)
+				{
+						relax(current, edge.target, edge.cost);
+				}
+				for (const AbstractEdge& edge : node.intraEdges)
+				{
+						relax(current, edge.target, edge.cost);
+				}
+				if (node.cluster == endCluster)
+				{
+						const int cost = endCosts[GetLocalIndex(endCluster, node.gridIndex)];
+						if (cost != UNREACHABLE)
+						{
+								relax(current, endNode, cost);
+						}
+				}
+		}
+
+		if (!found)
+		{
+				//with ALWAYS and IFLESSTHANTWOWALLS a path can cross a border only diagonally, which has no entrance, so make sure with a plain search
+				if (m_diagonal == Diagonal::ALWAYS || m_diagonal == Diagonal::IFLESSTHANTWOWALLS)
+				{
+						AStarQuery query(_context);
+						query.Begin(_start, _end, grid, m_diagonal);
+						query.Run();
+						return query.GetPath();
+				}
+				return std::vector<int>();
+		}
+
+		//the grid nodes of the abstract path, from the start to the end
+		std::vector<int> waypoints;
+		for (int node = endNode; node != -1; node = _context.At(node).parent)
+		{
+				waypoints.push_back(gridIndexOf(node));
+		}
+		std::reverse(waypoints.begin(), waypoints.end());
+
+		//refine every abstract edge into the grid nodes it stands for
+		std::vector<int> path;
+		std::vector<int> segment, costs, parents;
+		for (size_t i = 0; i + 1 < waypoints.size(); i++)
+		{
+				const int from = waypoints[i];
+				const int to = waypoints[i + 1];
+				segment.clear();
+				if (i + 2 == waypoints.size() && i > 0)
+				{
+						//into the end, the backward search already knows the way
+						for (int node = from; node != _end;)
+						{
+								node = endParents[GetLocalIndex(endCluster, node)];
+								segment.push_back(node);
+						}
+				}
+				else if (GetCluster(grid.GetCoord(from)) != GetCluster(grid.GetCoord(to)))
+				{
+						//an entrance, the nodes are neighbors
+						segment.push_back(to);
+				}
+				else
+				{
+						//inside a cluster, the start already has its search, the others search again
+						const int cluster = GetCluster(grid.GetCoord(from));
+						const std::vector<int>* clusterParents = &startParents;
+						if (i > 0)
+						{
+								SearchCluster(cluster, from, false, costs, parents);
+								clusterParents = &parents;
+						}
+						for (int node = to; node != from; node = (*clusterParents)[GetLocalIndex(cluster, node)])
+						{
+								segment.push_back(node);
+						}
+						std::reverse(segment.begin(), segment.end());
+				}
+				path.insert(path.end(), segment.begin(), segment.end());
+		}
+		//the same order as the other algorithms: from the end to the start
+		std::reverse(path.begin(), path.end());
+		return path;
+}
+
+int HierarchicalGrid::StepCost(int _from, int _to) const
+{
+		return m_heuristic(m_grid->GetCoord(_from), m_grid->GetCoord(_to)) + m_grid->GetTerrainCost(_to);
+}
+
+glm::ivec2 HierarchicalGrid::GetClusterMin(int _cluster) const noexcept
+{
+		return glm::ivec2((_cluster % m_numXClusters) * m_clusterSize, (_cluster / m_numXClusters) * m_clusterSize);
+}
+
+glm::ivec2 HierarchicalGrid::GetClusterMax(int _cluster) const noexcept
+{
+		//the last clusters can be smaller when the grid isn't a multiple of the cluster size
+		const glm::ivec2 clusterMin = GetClusterMin(_cluster);
+		return glm::ivec2(std::min(clusterMin.x + m_clusterSize, m_grid->GetNumXNodes()), std::min(clusterMin.y + m_clusterSize, m_grid->GetNumYNodes()));
+}
+
+int HierarchicalGrid::GetLocalIndex(int _cluster, int _gridIndex) const noexcept
+{
+		const glm::ivec2 clusterMin = GetClusterMin(_cluster);
+		const glm::ivec2 coord = m_grid->GetCoord(_gridIndex);
+		return (coord.y - clusterMin.y) * m_clusterSize + (coord.x - clusterMin.x);
+}
+
+void HierarchicalGrid::SearchCluster(int _cluster, int _source, bool _backward, std::vector<int>& _costs, std::vector<int>& _parents) const
+{
+		const glm::ivec2 clusterMin = GetClusterMin(_cluster);
+		const glm::ivec2 clusterMax = GetClusterMax(_cluster);
+		_costs.assign(m_clusterSize * m_clusterSize, UNREACHABLE);
+		_parents.assign(m_clusterSize * m_clusterSize, -1);
+
+		//(cost, grid index), the smallest cost first; stale entries are skipped instead of updated
+		Heap<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> openSet;
+		Grid::NeighborList neighbors;
+		_costs[GetLocalIndex(_cluster, _source)] = 0;
+		openSet.Push(std::make_pair(0, _source));
+
+		while (!openSet.IsEmpty())
+		{
+				const std::pair<int, int> current = openSet.Front();
+				openSet.Pop();
+				if (current.first > _costs[GetLocalIndex(_cluster, current.second)])
+				{
+						continue;
+				}
+				//the neighbors are symmetric, so the same ones are the predecessors of a backward search
+				m_grid->GetNeighbors(current.second, m_diagonal, neighbors);
+				for (int neighbor : neighbors)
+				{
+						const glm::ivec2 coord = m_grid->GetCoord(neighbor);
+						if (coord.x < clusterMin.x || coord.y < clusterMin.y || coord.x >= clusterMax.x || coord.y >= clusterMax.y)
+						{
+								continue;
+						}
+						const int cost = current.first + (_backward ? StepCost(neighbor, current.second) : StepCost(current.second, neighbor));
+						const int local = GetLocalIndex(_cluster, neighbor);
+						if (cost < _costs[local])
+						{
+								_costs[local] = cost;
+								_parents[local] = current.second;
+								openSet.Push(std::make_pair(cost, neighbor));
+						}
+				}
+		}
+}
+
+void HierarchicalGrid::BuildBorder(int _border)
+{
+		const int cluster = _border / 2;
+		const bool right = _border % 2 == 0;
+		const int clusterX = cluster % m_numXClusters;
+		const int clusterY = cluster / m_numXClusters;
+		if ((right && clusterX + 1 >= m_numXClusters) || (!right && clusterY + 1 >= m_numYClusters))
+		{
+				return;
+		}
+
+		const glm::ivec2 clusterMin = GetClusterMin(cluster);
+		const glm::ivec2 clusterMax = GetClusterMax(cluster);
+		//walk along the border: the node on this side and the one across
+		const glm::ivec2 first = right ? glm::ivec2(clusterMax.x - 1, clusterMin.y) : glm::ivec2(clusterMin.x, clusterMax.y - 1);
+		const glm::ivec2 along = right ? glm::ivec2(0, 1) : glm::ivec2(1, 0);
+		const glm::ivec2 across = right ? glm::ivec2(1, 0) : glm::ivec2(0, 1);
+		const int length = right ? clusterMax.y - clusterMin.y : clusterMax.x - clusterMin.x;
+
+		std::vector<Entrance>& entrances = m_borderEntrances[_border];
+		auto addEntrance = [&](int _offset)
+		{
+				const glm::ivec2 side = first + along * _offset;
+				const int a = m_grid->GetIndex(side);
+				const int b = m_grid->GetIndex(side + across);
+				Entrance entrance{ AcquireNode(a), AcquireNode(b) };
+				m_nodes[entrance.nodeA].interEdges.push_back(AbstractEdge{ entrance.nodeB, StepCost(a, b) });
+				m_nodes[entrance.nodeB].interEdges.push_back(AbstractEdge{ entrance.nodeA, StepCost(b, a) });
+				entrances.push_back(entrance);
+		};
+
+		//every run of open node pairs is an entrance
+		int runStart = -1;
+		for (int i = 0; i <= length; i++)
+		{
+				const glm::ivec2 side = first + along * i;
+				const bool open = i < length && m_grid->IsWalkableAt(side) && m_grid->IsWalkableAt(side + across);
+				if (open && runStart == -1)
+				{
+						runStart = i;
+				}
+				else if (!open && runStart != -1)
+				{
+						const int runEnd = i - 1;
+						if (runEnd - runStart + 1 >= LONG_ENTRANCE)
+						{
+								addEntrance(runStart);
+								addEntrance(runEnd);
+						}
+						else
+						{
+								addEntrance((runStart + runEnd) / 2);
+						}
+						runStart = -1;
+				}
+		}
+}
+
+void HierarchicalGrid::ClearBorder(int _border)
+{
+		auto removeEdge = [](std::vector<AbstractEdge>& _edges, int _target)
+		{
+				_edges.erase(std::remove_if(_edges.begin(), _edges.end(), [_target](const AbstractEdge& _edge) { return _edge.target == _target; }), _edges.end());
+		};
+		for (const Entrance& entrance : m_borderEntrances[_border])
+		{
+				removeEdge(m_nodes[entrance.nodeA].interEdges, entrance.nodeB);
+				removeEdge(m_nodes[entrance.nodeB].interEdges, entrance.nodeA);
+				ReleaseNode(entrance.nodeA);
+				ReleaseNode(entrance.nodeB);
+		}
+		m_borderEntrances[_border].clear();
+}
+
+void HierarchicalGrid::BuildIntraEdges(int _cluster)
+{
+		std::vector<int> costs, parents;
+		const std::vector<int>& clusterNodes = m_clusterNodes[_cluster];
+		for (int node : clusterNodes)
+		{
+				m_nodes[node].intraEdges.clear();
+				SearchCluster(_cluster, m_nodes[node].gridIndex, false, costs, parents);
+				for (int other : clusterNodes)
+				{
+						const int cost = costs[GetLocalIndex(_cluster, m_nodes[other].gridIndex)];
+						if (other != node && cost != UNREACHABLE)
+						{
+								m_nodes[node].intraEdges.push_back(AbstractEdge{ other, cost });
+						}
+				}
+		}
+}
+
+int HierarchicalGrid::AcquireNode(int _gridIndex)
+{
+		int node = m_abstractIndex[_gridIndex];
+		if (node == -1)
+		{
+				if (m_freeNodes.empty())
+				{
+						node = static_cast<int>(m_nodes.size());
+						m_nodes.emplace_back();
+				}
+				else
+				{
+						node = m_freeNodes.back();
+						m_freeNodes.pop_back();
+				}
+				m_nodes[node].gridIndex = _gridIndex;
+				m_nodes[node].cluster = GetCluster(m_grid->GetCoord(_gridIndex));
+				m_clusterNodes[m_nodes[node].cluster].push_back(node);
+				m_abstractIndex[_gridIndex] = node;
+		}
+		m_nodes[node].numEntrances++;
+		return node;
+}
+
+void HierarchicalGrid::ReleaseNode(int _node)
+{
+		AbstractNode& node = m_nodes[_node];
+		if (--node.numEntrances > 0)
+		{
+				return;
+		}
+		//the intra edges pointing at it go away when its cluster is rebuilt
+		std::vector<int>& clusterNodes = m_clusterNodes[node.cluster];
+		clusterNodes.erase(std::find(clusterNodes.begin(), clusterNodes.end(), _node));
+		m_abstractIndex[node.gridIndex] = -1;
+		node = AbstractNode();
+		m_freeNodes.push_back(_node);
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+
+#include "Grid.h"
+#include "SearchContext.h"
+
+/** \brief Hierarchical pathfinding (HPA*) over a grid split into square clusters.
+	*  Neighboring clusters are connected by abstract nodes at the entrances along their border, and the path costs between
+	*  the entrances of a cluster are precomputed. A query searches this small abstract graph and only refines the result
+	*  inside the clusters it passes, so its cost stays flat as the map grows. The paths are near optimal.
+	*  The clusters around a node are rebuilt whenever the grid reports that its walkability or terrain cost changed */
+class HierarchicalGrid
+{
+public:
+		/** \brief Builds the hierarchy of the grid
+			* \param _clusterSize - the width and height of a cluster in nodes
+			* \param _diagonal - the diagonal movement the costs are computed for (a hierarchy only answers queries with this movement)
+			*/
+		HierarchicalGrid(std::shared_ptr<Grid> _grid, int _clusterSize, const Diagonal& _diagonal);
+		~HierarchicalGrid();
+
+		HierarchicalGrid(const HierarchicalGrid&) = delete;
+		HierarchicalGrid& operator=(const HierarchicalGrid&) = delete;
+
+		/** \brief Finds a path between the flat node indices _start and _end.
+			*  It only reads the grid and the hierarchy and keeps the abstract search in _context, so queries with different contexts can run concurrently (they share a lock with the rebuilds)
+			*  \return the node indices of the path from the end to (not including) the start like PathFinder, empty if there is no path */
+		std::vector<int> FindPath(int _start, int _end, SearchContext& _context) const;
+
+		/** \brief Rebuilds the entrances and costs around a node after it changed (called by the grid) */
+		void OnNodeChanged(int _index);
+		/** \brief Rebuilds the whole hierarchy */
+		void Rebuild();
+
+		const Grid& GetGrid() const noexcept { return *m_grid; }
+		const Diagonal& GetDiagonal() const noexcept { return m_diagonal; }
+		/** \brief Gets the number of abstract (entrance) nodes */
+		int GetNumAbstractNodes() const noexcept { return static_cast<int>(m_nodes.size() - m_freeNodes.size()); }
+
+private:
+		struct AbstractEdge
+		{
+				int target; ///< the abstract node the edge leads to
+				int cost;   ///< the cost of the path to it
+		};
+
+		struct AbstractNode
+		{
+				int gridIndex{ -1 }; ///< the grid node, -1 while the abstract node is free
+				int cluster{ -1 };
+				int numEntrances{ 0 }; ///< the number of entrances using the node (a node in the corner of a cluster can be on two borders)
+				std::vector<AbstractEdge> interEdges; ///< to the nodes right across a border
+				std::vector<AbstractEdge> intraEdges; ///< to the other nodes of the same cluster
+		};
+
+		/** \brief The two abstract nodes (one on each side) of an entrance between neighboring clusters */
+		struct Entrance
+		{
+				int nodeA;
+				int nodeB;
+		};
+
+		/** \brief The cost of stepping from a node to its neighbor (the same the search algorithms use) */
+		int StepCost(int _from, int _to) const;
+		int GetCluster(const glm::ivec2& _coord) const noexcept { return (_coord.y / m_clusterSize) * m_numXClusters + _coord.x / m_clusterSize; }
+		/** \brief The first node of a cluster and the node after its last one on both axes */
+		glm::ivec2 GetClusterMin(int _cluster) const noexcept;
+		glm::ivec2 GetClusterMax(int _cluster) const noexcept;
+		/** \brief The index of a grid node within the arrays of a SearchCluster() call */
+		int GetLocalIndex(int _cluster, int _gridIndex) const noexcept;
+
+		/** \brief Dijkstra from _source which never leaves the cluster
+			* \param _backward - search the costs to _source instead of from it
+			* \param _costs - the cost of every node of the cluster (by local index), INT_MAX if unreachable
+			* \param _parents - the grid node every node was reached from (when searching backward, the next one on the way to _source)
+			*/
+		void SearchCluster(int _cluster, int _source, bool _backward, std::vector<int>& _costs, std::vector<int>& _parents) const;
+
+		/** \brief Borders are numbered 2 * cluster for the one to the right and 2 * cluster + 1 for the one above */
+		void BuildBorder(int _border);
+		void ClearBorder(int _border);
+		/** \brief Recomputes the costs between all the abstract nodes of the cluster */
+		void BuildIntraEdges(int _cluster);
+		int AcquireNode(int _gridIndex);
+		void ReleaseNode(int _node);
+
+		std::shared_ptr<Grid> m_grid; ///< the grid the hierarchy is built on
+		int m_clusterSize;
+		Diagonal m_diagonal;
+		int (*m_heuristic)(const glm::ivec2&, const glm::ivec2&);
+		int m_numXClusters{ 0 };
+		int m_numYClusters{ 0 };
+
+		std::vector<AbstractNode> m_nodes;
+		std::vector<int> m_freeNodes;     ///< released abstract nodes, reused before the array grows
+		std::vector<int> m_abstractIndex; ///< the abstract node of every grid node, -1 for none
+		std::vector<std::vector<int>> m_clusterNodes;       ///< the abstract nodes of every cluster
+		std::vector<std::vector<Entrance>> m_borderEntrances; ///< the entrances of every border
+		mutable std::shared_timed_mutex m_mutex; ///< shared by the queries on the path worker threads, exclusive while rebuilding
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <vector>
+
+/** \brief Priority queue of integer keys in [0, capacity) (e.g. the node indices of a grid) which knows the position of every key in the heap.
+	*  This makes Contains O(1) and Remove and Update (decrease-key) O(log n), instead of the linear searches and full re-heapify of Heap.
+	*  Compare follows the std heap convention: _comparator(a, b) is true when a has less priority than b */
+template <class Compare>
+class IndexedHeap
+{
+public:
+		IndexedHeap(const Compare& _comparator = Compare()) : m_comparator(_comparator) {}
+		//Cleanup
+		~IndexedHeap() { m_container.clear(); }
+
+		/** \brief Makes room for the keys 0 to _numKeys - 1 and empties the heap */
+		void Reserve(size_t _numKeys)
+		{
+				Clear();
+				if (m_positions.size() != _numKeys)
+				{
+						m_positions.assign(_numKeys, NOT_IN_HEAP);
+				}
+		}
+
+		/** \brief Replaces the comparator (e.g. when the array it compares through was reallocated) */
+		void SetComparator(const Compare& _comparator) { m_comparator = _comparator; }
+
+		/** \brief Check if the container is empty
+			*		\return true if empty */
+		bool IsEmpty() const { return m_container.empty(); }
+
+		/** \brief Getter for the container size
+			*		\return number of elements in the container */
+		size_t Size() const { return m_container.size(); }
+
+		/** \brief Gets the element with the highest priority */
+		int Front() const { return m_container.front(); }
+
+		/** \brief Gets the element at position _index of the heap array */
+		int At(size_t _index) const { return m_container[_index]; }
+
+		/** \brief Checks if the key is in the heap in O(1) */
+		bool Contains(int _item) const { return m_positions[_item] != NOT_IN_HEAP; }
+
+		/** \brief Adds a key (which must not be in the heap yet) */
+		void Push(int _item)
+		{
+				m_positions[_item] = static_cast<int>(m_container.size());
+				m_container.push_back(_item);
+				SiftUp(m_container.size() - 1);
+		}
+
+		/** \brief Removes the element with the highest priority */
+		void Pop()
+		{
+				Remove(m_container.front());
+		}
+
+		/** \brief Removes a specific key from the heap in O(log n) */
+		void Remove(int _item)
+		{
+				const size_t position = m_positions[_item];
+				const size_t last = m_container.size() - 1;
+				if (position != last)
+				{
+						Swap(position, last);
+				}
+				m_container.pop_back();
+				m_positions[_item] = NOT_IN_HEAP;
+				if (position < m_container.size())
+				{
+						//the element moved into the hole can belong either above or below it
+						SiftUp(position);
+						SiftDown(m_positions[m_container[position]]);
+				}
+		}
+
+		/** \brief Restores the heap order after the priority of _item changed (O(log n) decrease-key) */
+		void Update(int _item)
+		{
+				SiftUp(m_positions[_item]);
+				SiftDown(m_positions[_item]);
+		}
+
+		/** \brief Clears the container, only touching the positions of the keys still in it */
+		void Clear()
+		{
+				for (int item : m_container)
+				{
+						m_positions[item] = NOT_IN_HEAP;
+				}
+				m_container.clear();
+		}
+
+private:
+		enum : int { NOT_IN_HEAP = -1 }; ///< position of the keys that aren't in the heap
+
+		void SiftUp(size_t _position)
+		{
+				while (_position > 0)
+				{
+						const size_t parent = (_position - 1) / 2;
+						//stop once the parent has at least the priority of the element
+						if (!m_comparator(m_container[parent], m_container[_position]))
+						{
+								break;
+						}
+						Swap(parent, _position);
+						_position = parent;
+				}
+		}
+
+		void SiftDown(size_t _position)
+		{
+				const size_t size = m_container.size();
+				while (true)
+				{
+						size_t best = _position;
+						const size_t left = 2 * _position + 1;
+						const size_t right = left + 1;
+						if (left < size && m_comparator(m_container[best], m_container[left]))
+						{
+								best = left;
+						}
+						if (right < size && m_comparator(m_container[best], m_container[right]))
+						{
+								best = right;
+						}
+						if (best == _position)
+						{
+								break;
+						}
+						Swap(best, _position);
+						_position = best;
+				}
+		}
+
+		void Swap(size_t _a, size_t _b)
+		{
+				std::swap(m_container[_a], m_container[_b]);
+				m_positions[m_container[_a]] = static_cast<int>(_a);
+				m_positions[m_container[_b]] = static_cast<int>(_b);
+		}
+
+		std::vector<int> m_container; ///< the binary heap of keys
+		std::vector<int> m_positions; ///< the position of every key in m_container (NOT_IN_HEAP if it isn't in it)
+		Compare m_comparator; ///< the comparator used for sorting
+};
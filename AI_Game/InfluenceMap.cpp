@@ -0,0 +1,129 @@
+#include "InfluenceMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+//the values below this are dropped to 0, so a faded source doesn't linger as tiny (denormal) values
+constexpr float MIN_INFLUENCE = 1e-4f;
+
+InfluenceMap::InfluenceMap(std::weak_ptr<const Grid> _grid, const Diagonal & _diagonal) :
+		m_grid(_grid), m_diagonal(_diagonal)
+{
+		//the player is felt a long way off, a sighting lingers for a while after it and the crowds are only felt close by
+		SetSpread(THREAT, 0.9f, 0.5f);
+		SetSpread(PLAYER_SIGHTING, 0.85f, 0.9f);
+		SetSpread(ZOMBIE_DENSITY, 0.5f, 0.3f);
+		if (std::shared_ptr<const Grid> grid = m_grid.lock())
+		{
+				Reset(*grid);
+		}
+}
+
+void InfluenceMap::SetSpread(Layer _layer, float _falloff, float _momentum)
+{
+		m_sideFalloffs[_layer] = _falloff;
+		m_diagonalFalloffs[_layer] = std::pow(_falloff, std::sqrt(2.0f));
+		m_momentums[_layer] = _momentum;
+}
+
+void InfluenceMap::AddSource(Layer _layer, const glm::vec2 & _worldPos, float _amount)
+{
+		const glm::vec2 coord = _worldPos / m_nodeDiameter;
+		if (_amount <= 0.0f || coord.x < 0.0f || coord.y < 0.0f || coord.x >= m_numXNodes || coord.y >= m_numYNodes)
+		{
+				return;
+		}
+		const int slot = (static_cast<int>(coord.y) * m_numXNodes + static_cast<int>(coord.x)) * NUM_LAYERS + _layer;
+		if (m_sources[slot] == 0.0f)
+		{
+				m_sourceSlots.push_back(slot);
+		}
+		m_sources[slot] += _amount;
+}
+
+void InfluenceMap::Update(size_t _maxNodes)
+{
+		std::shared_ptr<const Grid> grid = m_grid.lock();
+		if (!grid)
+		{
+				return;
+		}
+		if (grid->GetNumXNodes() != m_numXNodes || grid->GetNumYNodes() != m_numYNodes)
+		{
+				//another level, the sources of this frame were for the old one
+				Reset(*grid);
+				return;
+		}
+
+		const int numNodes = grid->GetNumNodes();
+		const int lastNode = static_cast<int>(std::min<size_t>(static_cast<size_t>(m_nextNode) + _maxNodes, static_cast<size_t>(numNodes)));
+		for (int node = m_nextNode; node < lastNode; node++)
+		{
+				float* pending = &m_pending[node * NUM_LAYERS];
+				if (!grid->IsWalkable(node))
+				{
+						//nothing spreads through the walls
+						std::fill(pending, pending + NUM_LAYERS, 0.0f);
+						continue;
+				}
+				//the strongest influence a neighbor spreads to the node
+				std::array<float, NUM_LAYERS> spread{};
+				grid->GetNeighbors(node, m_diagonal, m_neighbors);
+				for (int neighbor : m_neighbors)
+				{
+						const int offset = std::abs(neighbor - node);
+						const std::array<float, NUM_LAYERS>& falloffs = offset == 1 || offset == m_numXNodes ? m_sideFalloffs : m_diagonalFalloffs;
+						const float* values = &m_values[neighbor * NUM_LAYERS];
+						for (int layer = 0; layer < NUM_LAYERS; layer++)
+						{
+								spread[layer] = std::max(spread[layer], values[layer] * falloffs[layer]);
+						}
+				}
+				const float* values = &m_values[node * NUM_LAYERS];
+				for (int layer = 0; layer < NUM_LAYERS; layer++)
+				{
+						const float value = m_momentums[layer] * values[layer] + (1.0f - m_momentums[layer]) * spread[layer];
+						pending[layer] = value < MIN_INFLUENCE ? 0.0f : value;
+				}
+		}
+		m_nextNode = lastNode;
+		if (m_nextNode == numNodes)
+		{
+				//the pass is complete, swap it in and start the next one from it
+				std::swap(m_values, m_pending);
+				m_nextNode = 0;
+		}
+
+		//into both passes, so a source is neither lost with the swap nor faded by the rest of the pass
+		for (int slot : m_sourceSlots)
+		{
+				m_values[slot] = std::max(m_values[slot], m_sources[slot]);
+				m_pending[slot] = std::max(m_pending[slot], m_sources[slot]);
+				m_sources[slot] = 0.0f;
+		}
+		m_sourceSlots.clear();
+}
+
+float InfluenceMap::GetInfluence(Layer _layer, const glm::vec2 & _worldPos) const noexcept
+{
+		const glm::vec2 coord = _worldPos / m_nodeDiameter;
+		if (coord.x < 0.0f || coord.y < 0.0f || coord.x >= m_numXNodes || coord.y >= m_numYNodes)
+		{
+				return 0.0f;
+		}
+		return GetInfluence(_layer, static_cast<int>(coord.y) * m_numXNodes + static_cast<int>(coord.x));
+}
+
+void InfluenceMap::Reset(const Grid & _grid)
+{
+		m_numXNodes = _grid.GetNumXNodes();
+		m_numYNodes = _grid.GetNumYNodes();
+		m_nodeDiameter = _grid.GetNodeDiameter();
+		const size_t numSlots = static_cast<size_t>(_grid.GetNumNodes()) * NUM_LAYERS;
+		m_values.assign(numSlots, 0.0f);
+		m_pending.assign(numSlots, 0.0f);
+		m_sources.assign(numSlots, 0.0f);
+		m_sourceSlots.clear();
+		m_nextNode = 0;
+}
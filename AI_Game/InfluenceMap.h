@@ -0,0 +1,60 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "Grid.h"
+
+/** \brief Influence maps over the grid for the tactics of the agents: every layer has a value per node which the sources stamp
+	*  (the player, where he was seen, the zombies) and which spreads to the neighbors, fading with every step and every pass.
+	*  A pass over the grid is spread over several Update() calls within a node budget, like the flow field, and a lookup is O(1),
+	*  so an agent can sense what's around it without scanning the player and the other agents itself */
+class InfluenceMap
+{
+public:
+		/** \brief The layers, every node has one value per layer */
+		enum Layer : unsigned char { THREAT, PLAYER_SIGHTING, ZOMBIE_DENSITY, NUM_LAYERS };
+
+		InfluenceMap() {}
+		InfluenceMap(std::weak_ptr<const Grid> _grid, const Diagonal& _diagonal);
+		~InfluenceMap() {}
+
+		/** \brief Sets how a layer spreads and fades
+			*  \param _falloff - the share of a node's value its side neighbors get (0 - 1), the diagonal ones get it to the power of sqrt(2)
+			*  \param _momentum - the share of its old value a node keeps every pass (0 - 1), the rest is what the neighbors spread to it.
+			*  The lower it is the faster the layer follows its sources, and forgets the ones which are gone */
+		void SetSpread(Layer _layer, float _falloff, float _momentum);
+
+		/** \brief Adds _amount to the source of the layer at _worldPos for this frame (the sources in the same node add up).
+			*  Update() stamps them: a node is at least the sum of its sources. Ignored outside of the grid */
+		void AddSource(Layer _layer, const glm::vec2& _worldPos, float _amount);
+
+		/** \brief Continues the pass for up to _maxNodes nodes (swapping it in once it's complete) and stamps the sources of the frame */
+		void Update(size_t _maxNodes);
+
+		/** \brief The value of the layer at node _index (no range checks) */
+		float GetInfluence(Layer _layer, int _index) const noexcept { return m_values[_index * NUM_LAYERS + _layer]; }
+		/** \brief The value of the layer at _worldPos, 0 outside of the grid */
+		float GetInfluence(Layer _layer, const glm::vec2& _worldPos) const noexcept;
+
+private:
+		/** \brief Clears the map for the size of _grid */
+		void Reset(const Grid& _grid);
+
+		std::weak_ptr<const Grid> m_grid;
+		Diagonal m_diagonal{ Diagonal::NEVER };
+		int m_numXNodes{ 0 };
+		int m_numYNodes{ 0 };
+		float m_nodeDiameter{ 1.0f };
+
+		std::array<float, NUM_LAYERS> m_sideFalloffs{};
+		std::array<float, NUM_LAYERS> m_diagonalFalloffs{};
+		std::array<float, NUM_LAYERS> m_momentums{};
+
+		std::vector<float> m_values;  ///< the last complete pass (and the sources since), NUM_LAYERS values per node
+		std::vector<float> m_pending; ///< the pass being computed, from m_values
+		int m_nextNode{ 0 };          ///< the next node of the pass
+		std::vector<float> m_sources; ///< the sources of the frame, like m_values
+		std::vector<int> m_sourceSlots; ///< the slots of m_sources which aren't 0
+		Grid::NeighborList m_neighbors;
+};
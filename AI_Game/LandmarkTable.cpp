@@ -0,0 +1,174 @@
+#include "LandmarkTable.h"
+#include "PathFinder.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+
+constexpr int UNREACHABLE = std::numeric_limits<int>::max();
+
+LandmarkTable::LandmarkTable(std::shared_ptr<Grid> _grid, int _numLandmarks, const Diagonal& _diagonal) :
+		m_grid(_grid), m_diagonal(_diagonal), m_numLandmarks(std::min(std::max(_numLandmarks, 0), static_cast<int>(MAX_LANDMARKS)))
+{
+		const int numNodes = m_grid->GetNumNodes();
+		m_distances.assign(static_cast<size_t>(numNodes) * m_numLandmarks * 2, UNKNOWN);
+		m_versions.assign(m_numLandmarks, m_grid->GetChangeVersion());
+
+		int first = 0;
+		while (first < numNodes && !m_grid->IsWalkable(first))
+		{
+				first++;
+		}
+		if (first == numNodes)
+		{
+				m_numLandmarks = 0;
+				return;
+		}
+
+		//the farthest first pick: every landmark is the node farthest from the ones before (from an arbitrary node for the first one)
+		std::vector<int> nearest;
+		Search(first, false, nearest);
+		for (int landmark = 0; landmark < m_numLandmarks; landmark++)
+		{
+				int farthest = -1;
+				for (int node = 0; node < numNodes; node++)
+				{
+						if (nearest[node] != UNREACHABLE && (farthest == -1 || nearest[node] > nearest[farthest]))
+						{
+								farthest = node;
+						}
+				}
+				if (farthest == -1 || (landmark > 0 && nearest[farthest] == 0))
+				{
+						//fewer distinct reachable nodes than landmarks
+						m_numLandmarks = landmark;
+						break;
+				}
+				m_landmarks.push_back(farthest);
+				BuildLandmark(landmark);
+				for (int node = 0; node < numNodes; node++)
+				{
+						nearest[node] = landmark == 0 ? m_costs[node] : std::min(nearest[node], m_costs[node]);
+				}
+		}
+		//keep the layout of the distances if some landmarks were dropped
+		if (static_cast<size_t>(m_numLandmarks) < m_versions.size())
+		{
+				std::vector<std::uint16_t> distances(static_cast<size_t>(numNodes) * m_numLandmarks * 2);
+				const size_t oldStride = m_versions.size() * 2;
+				for (int node = 0; node < numNodes; node++)
+				{
+						std::copy_n(&m_distances[node * oldStride], m_numLandmarks * 2, &distances[static_cast<size_t>(node) * m_numLandmarks * 2]);
+				}
+				m_distances.swap(distances);
+				m_versions.resize(m_numLandmarks);
+		}
+		std::vector<int>().swap(m_costs);
+}
+
+bool LandmarkTable::Update(int _maxLandmarks)
+{
+		const unsigned int version = m_grid->GetChangeVersion();
+		for (int landmark = 0; landmark < m_numLandmarks; landmark++)
+		{
+				if (m_versions[landmark] == version)
+				{
+						continue;
+				}
+				if (_maxLandmarks-- <= 0)
+				{
+						return false;
+				}
+				std::unique_lock<std::shared_timed_mutex> lock(m_mutex);
+				BuildLandmark(landmark);
+		}
+		std::vector<int>().swap(m_costs);
+		return true;
+}
+
+bool LandmarkTable::GetGoal(int _goal, Goal& _result) const
+{
+		_result.m_landmarks = 0;
+		if (m_numLandmarks == 0)
+		{
+				return false;
+		}
+		const unsigned int version = m_grid->GetChangeVersion();
+		const std::uint16_t* distances = &m_distances[static_cast<size_t>(_goal) * m_numLandmarks * 2];
+		for (int landmark = 0; landmark < m_numLandmarks; landmark++)
+		{
+				//a stale landmark could overestimate, and an unknown distance of the goal bounds nothing
+				if (m_versions[landmark] != version || distances[landmark * 2] == UNKNOWN || distances[landmark * 2 + 1] == UNKNOWN)
+				{
+						continue;
+				}
+				_result.m_from[landmark] = distances[landmark * 2];
+				_result.m_to[landmark] = distances[landmark * 2 + 1];
+				_result.m_landmarks |= 1u << landmark;
+		}
+		return _result.m_landmarks != 0;
+}
+
+void LandmarkTable::BuildLandmark(int _landmark)
+{
+		const int numNodes = m_grid->GetNumNodes();
+		const size_t stride = static_cast<size_t>(m_numLandmarks) * 2;
+		const int source = m_landmarks[_landmark];
+		//the searches need the landmark walkable, a landmark walled in since knows nothing until it's free again
+		for (int direction = 1; direction >= 0; direction--)
+		{
+				if (m_grid->IsWalkable(source))
+				{
+						Search(source, direction == 1, m_costs);
+				}
+				else
+				{
+						m_costs.assign(numNodes, UNREACHABLE);
+				}
+				for (int node = 0; node < numNodes; node++)
+				{
+						const int cost = m_costs[node];
+						m_distances[node * stride + _landmark * 2 + direction] = cost < UNKNOWN ? static_cast<std::uint16_t>(cost) : std::uint16_t(UNKNOWN);
+				}
+		}
+		//m_costs is left with the distances from the landmark, for the picking in the constructor
+		m_versions[_landmark] = m_grid->GetChangeVersion();
+}
+
+void LandmarkTable::Search(int _source, bool _backward, std::vector<int>& _costs) const
+{
+		const Grid& grid = *m_grid;
+		const PathFinder::Heuristic stepCost = PathFinder::SelectHeuristic(m_diagonal);
+		_costs.assign(grid.GetNumNodes(), UNREACHABLE);
+
+		using Entry = std::pair<int, int>; ///< cost, node
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+		_costs[_source] = 0;
+		open.push(Entry(0, _source));
+		Grid::NeighborList neighbors;
+		while (!open.empty())
+		{
+				const Entry current = open.top();
+				open.pop();
+				if (current.first != _costs[current.second])
+				{
+						//an older entry of a node reached cheaper since
+						continue;
+				}
+				const glm::ivec2 currentCoord = grid.GetCoord(current.second);
+				grid.GetNeighbors(current.second, m_diagonal, neighbors);
+				for (int neighbor : neighbors)
+				{
+						//the costs of the searches: the step and the terrain of the node stepped onto. The neighbors are symmetric,
+						//so backward the step is from the neighbor onto the current node
+						const int step = stepCost(currentCoord, grid.GetCoord(neighbor)) + grid.GetTerrainCost(_backward ? current.second : neighbor);
+						const int cost = current.first + step;
+						if (cost < _costs[neighbor])
+						{
+								_costs[neighbor] = cost;
+								open.push(Entry(cost, neighbor));
+						}
+				}
+		}
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include "Grid.h"
+
+/** \brief The distances from and to a few landmark nodes, for the ALT heuristic (A*, Landmarks, Triangle inequality).
+	*  By the triangle inequality the cost of a path from a node to the goal is at least d(L, goal) - d(L, node) and d(node, L) - d(goal, L)
+	*  for every landmark L, which on a maze-like map is far closer to the real cost than the octile distance, so A* expands far fewer nodes
+	*  and its paths stay optimal. The landmarks are picked far apart (each one the farthest node from the ones before) and one Dijkstra
+	*  from and one to every landmark runs when the table is built.
+	*  The distances are 16 bit (UNKNOWN for the nodes too far or unreachable), the ones of a node next to each other so the bound of a
+	*  node reads one cache line. When the grid changes every landmark is stale until Update rebuilds it, the stale ones are left out
+	*  of the bound so it never overestimates */
+class LandmarkTable
+{
+public:
+		/** \brief The most landmarks a table can have */
+		enum : int { MAX_LANDMARKS = 16 };
+		/** \brief The distance of the nodes too far or unreachable */
+		enum : std::uint16_t { UNKNOWN = 0xFFFF };
+
+		/** \brief The distances of the goal of a search from and to the usable landmarks, see GetGoal */
+		struct Goal
+		{
+				std::uint32_t m_landmarks{ 0 }; ///< bit k for landmark k if it's up to date and the goal is reachable both ways
+				int m_from[MAX_LANDMARKS];
+				int m_to[MAX_LANDMARKS];
+		};
+
+		/** \brief Picks the landmarks and builds their distances
+			* \param _diagonal - the movement the distances are computed for (a table only helps the searches with this movement)
+			*/
+		LandmarkTable(std::shared_ptr<Grid> _grid, int _numLandmarks, const Diagonal& _diagonal);
+		~LandmarkTable() {}
+
+		LandmarkTable(const LandmarkTable&) = delete;
+		LandmarkTable& operator=(const LandmarkTable&) = delete;
+
+		/** \brief Rebuilds up to _maxLandmarks of the landmarks which the changes of the grid made stale (main thread, like the changes)
+			* \return true if none is stale anymore */
+		bool Update(int _maxLandmarks);
+
+		/** \brief Shared by the searches reading the table, Update takes it exclusively while it rebuilds a landmark */
+		std::shared_lock<std::shared_timed_mutex> LockShared() const { return std::shared_lock<std::shared_timed_mutex>(m_mutex); }
+
+		/** \brief Takes the distances of _goal for Estimate (with the shared lock held)
+			* \return false if no landmark can bound the costs to it */
+		bool GetGoal(int _goal, Goal& _result) const;
+		/** \brief The lower bound of the cost from _node to the goal (with the shared lock held, and the goal taken under the same lock) */
+		int Estimate(const Goal& _goal, int _node) const noexcept
+		{
+				const std::uint16_t* distances = &m_distances[static_cast<size_t>(_node) * m_numLandmarks * 2];
+				int bound = 0;
+				for (int landmark = 0; landmark < m_numLandmarks; landmark++)
+				{
+						if ((_goal.m_landmarks & (1u << landmark)) == 0)
+						{
+								continue;
+						}
+						const int from = distances[landmark * 2];
+						const int to = distances[landmark * 2 + 1];
+						if (from != UNKNOWN && _goal.m_from[landmark] - from > bound)
+						{
+								bound = _goal.m_from[landmark] - from;
+						}
+						if (to != UNKNOWN && to - _goal.m_to[landmark] > bound)
+						{
+								bound = to - _goal.m_to[landmark];
+						}
+				}
+				return bound;
+		}
+
+		const Grid& GetGrid() const noexcept { return *m_grid; }
+		const Diagonal& GetDiagonal() const noexcept { return m_diagonal; }
+		int GetNumLandmarks() const noexcept { return m_numLandmarks; }
+		int GetLandmark(int _landmark) const noexcept { return m_landmarks[_landmark]; }
+
+private:
+		/** \brief Dijkstra over the whole grid from _source (or to it when _backward), the costs of the unreachable nodes are INT_MAX */
+		void Search(int _source, bool _backward, std::vector<int>& _costs) const;
+		/** \brief Computes the distances of landmark _landmark */
+		void BuildLandmark(int _landmark);
+
+		std::shared_ptr<Grid> m_grid;
+		Diagonal m_diagonal;
+		int m_numLandmarks{ 0 };
+		std::vector<int> m_landmarks;              ///< the node of every landmark
+		std::vector<std::uint16_t> m_distances;    ///< by node, then landmark: the distance from the landmark, then the one to it
+		std::vector<unsigned int> m_versions;      ///< the change version of the grid (see Grid::GetChangeVersion) every landmark was built at
+		std::vector<int> m_costs;                  ///< the scratch costs of Search
+		mutable std::shared_timed_mutex m_mutex;
+};
@@ -0,0 +1,68 @@
+#include "LineOfSightBatch.h"
+
+#include <GameEngine\JobSystem.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "PathFinder.h"
+
+namespace
+{
+		//below this many rays per thread the threads would cost more than they save
+		constexpr size_t RAYS_PER_WORKER = 128;
+}
+
+void LineOfSightBatch::Clear()
+{
+		m_requesters.clear();
+		m_from.clear();
+		m_to.clear();
+		m_visible.clear();
+}
+
+size_t LineOfSightBatch::Add(size_t _requester, const glm::vec2 & _from, const glm::vec2 & _to)
+{
+		if (_requester >= m_cache.size())
+		{
+				m_cache.resize(_requester + 1);
+		}
+		m_requesters.push_back(_requester);
+		m_from.push_back(_from);
+		m_to.push_back(_to);
+		m_visible.push_back(0);
+		return m_requesters.size() - 1;
+}
+
+void LineOfSightBatch::Update(const Grid & _grid)
+{
+		const size_t size = GetSize();
+		//every chunk answers a disjoint range of the queries, rethrows if a ray ended outside of the grid
+		std::atomic<size_t> numCastRays{ 0 };
+		GameEngine::JobSystem::Get().ParallelFor(size, RAYS_PER_WORKER, [this, &numCastRays, &_grid](size_t _begin, size_t _end)
+		{
+				numCastRays += UpdateRange(_begin, _end, _grid);
+		});
+		m_numCastRays = numCastRays;
+}
+
+size_t LineOfSightBatch::UpdateRange(size_t _begin, size_t _end, const Grid & _grid)
+{
+		size_t numCastRays = 0;
+		for (size_t i = _begin; i < _end; i++)
+		{
+				const int from = _grid.GetIndexAt(m_from[i]);
+				const int to = _grid.GetIndexAt(m_to[i]);
+				CachedSight& cached = m_cache[m_requesters[i]];
+				if (cached.from != from || cached.to != to || cached.walkableVersion != _grid.GetWalkableVersion())
+				{
+						cached.from = from;
+						cached.to = to;
+						cached.walkableVersion = _grid.GetWalkableVersion();
+						cached.visible = PathFinder::HasLineOfSight(_grid.GetCoord(from), _grid.GetCoord(to), _grid);
+						numCastRays++;
+				}
+				m_visible[i] = cached.visible ? 1 : 0;
+		}
+		return numCastRays;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+
+#include "Grid.h"
+
+/** \brief Answers many line of sight queries at once, e.g. whether every zombie can see the player.
+	*  The queries are added during the frame, Update() walks their rays over the walkable nodes of the grid (see PathFinder::HasLineOfSight),
+	*  in parallel once there are enough of them. The last result of every requester is kept: while both ends of its ray stay in the same
+	*  nodes and no walkability changed, the ray isn't walked again */
+class LineOfSightBatch
+{
+public:
+		enum : size_t { NO_SLOT = static_cast<size_t>(-1) };
+
+		LineOfSightBatch() {}
+		~LineOfSightBatch() {}
+
+		/** \brief Removes all the queries, done at the start of every frame (keeps the cached results) */
+		void Clear();
+
+		/** \brief Adds a query from _from to _to (world positions in the grid)
+			*  \param _requester - a small number which stays the same for the requester (like its index), at most one query per requester and frame
+			*  \return the slot of the result */
+		size_t Add(size_t _requester, const glm::vec2& _from, const glm::vec2& _to);
+
+		/** \brief Answers all the queries, only reads the grid */
+		void Update(const Grid& _grid);
+
+		size_t GetSize() const noexcept { return m_requesters.size(); }
+		/** \brief Check if nothing blocks the ray of the query in _slot */
+		bool IsVisible(size_t _slot) const { return m_visible[_slot] != 0; }
+		/** \brief The number of rays the last Update walked, the other results were still cached */
+		size_t GetNumCastRays() const noexcept { return m_numCastRays; }
+
+private:
+		/** \brief The last result of a requester, with the nodes and the walkable version of the grid it was found for */
+		struct CachedSight
+		{
+				int from{ -1 };
+				int to{ -1 };
+				unsigned int walkableVersion{ 0 };
+				bool visible{ false };
+		};
+
+		/** \brief Answers the queries in [_begin, _end)
+			*  \return the number of rays walked */
+		size_t UpdateRange(size_t _begin, size_t _end, const Grid& _grid);
+
+private:
+		std::vector<size_t> m_requesters;
+		std::vector<glm::vec2> m_from;
+		std::vector<glm::vec2> m_to;
+		std::vector<unsigned char> m_visible; ///< not bool, so the workers can write next to each other
+
+		std::vector<CachedSight> m_cache; ///< by requester, every requester is only written by the worker of its query
+		size_t m_numCastRays{ 0 };
+};
@@ -17,8 +17,8 @@ enum class Diagonal : size_t
 struct Node
 {
 		Node() {}
-		Node(const glm::vec2& _worldPos, const glm::ivec2& _index, bool _walkable) :
-				worldPos(_worldPos), nodeIndex(_index), walkable(_walkable), inOpenSet(false), inClosedSet(false) {}
+		Node(const glm::vec2& _worldPos, const glm::ivec2& _index, bool _walkable, int _terrainCost = 0) :
+				worldPos(_worldPos), nodeIndex(_index), terrainCost(_terrainCost), walkable(_walkable) {}
 		~Node() { }
 
 		/** All operator overloads */
@@ -38,28 +38,6 @@ struct Node
 				}
 				return true;
 		}
-		bool operator>  (const Node& _rhs) const
-		{
-				if (f() == _rhs.f())
-				{
-						return (h < _rhs.h);
-				}
-				else
-				{
-						return (f() < _rhs.f());
-				}
-		}
-		bool operator<  (const Node& _rhs) const
-		{
-				if (f() == _rhs.f())
-				{
-						return (h > _rhs.h);
-				}
-				else
-				{
-						return (f() > _rhs.f());
-				}
-		}
 		bool operator== (const Node* _rhs) const
 		{
 				if (nodeIndex == _rhs->nodeIndex)
@@ -76,70 +54,10 @@ struct Node
 				}
 				return true;
 		}
-		bool operator<  (const Node* _rhs) const
-		{
-				if (f() == _rhs->f())
-				{
-						return (h > _rhs->h);
-				}
-				else
-				{
-						return (f() > _rhs->f());
-				}
-		}
-		bool operator>  (const Node* _rhs) const
-		{
-				if (f() == _rhs->f())
-				{
-						return (h < _rhs->h);
-				}
-				else
-				{
-						return (f() < _rhs->f());
-				}
-		}
-		bool operator== (const std::weak_ptr<Node> _rhs) const
-		{
-				if (nodeIndex == _rhs.lock()->nodeIndex)
-				{
-						return true;
-				}
-				return false;
-		}
-		bool operator!= (const std::weak_ptr<Node> _rhs) const
-		{
-				if (nodeIndex == _rhs.lock()->nodeIndex)
-				{
-						return false;
-				}
-				return true;
-		}
-		bool operator>  (const std::weak_ptr<Node> _rhs) const
-		{
-				if (f() == _rhs.lock()->f())
-				{
-						return (h < _rhs.lock()->h);
-				}
-				else
-				{
-						return (f() < _rhs.lock()->f());
-				}
-		}
-		bool operator<  (const std::weak_ptr<Node> _rhs) const
-		{
-				if (f() == _rhs.lock()->f())
-				{
-						return (h > _rhs.lock()->h);
-				}
-				else
-				{
-						return (f() > _rhs.lock()->f());
-				}
-		}
-		friend std::ostream &operator<<(std::ostream &out, const std::weak_ptr<Node>& _node)
+		friend std::ostream &operator<<(std::ostream &out, const Node& _node)
 		{
 				out << "Clicked node info: " << std::endl;
-				if (_node.lock()->walkable)
+				if (_node.walkable)
 				{
 						out << "\twalkable: " << "true" << std::endl;
 				}
@@ -147,14 +65,11 @@ struct Node
 				{
 						out << "\twalkable: " << "false" << std::endl;
 				}
-				out << "\tcoordinate x: " << _node.lock()->worldPos.x << std::endl;
-				out << "\tcoordinate y: " << _node.lock()->worldPos.y << std::endl;
-				out << "\tindex x: " << _node.lock()->nodeIndex.x << std::endl;
-				out << "\tindex y: " << _node.lock()->nodeIndex.y << std::endl;
-				out << "\tg cost: " << _node.lock()->g << std::endl;
-				out << "\th cost: " << _node.lock()->h << std::endl;
-				out << "\tf cost: " << _node.lock()->f() << std::endl;
-				out << "\tterrain cost: " << _node.lock()->terrainCost << std::endl;
+				out << "\tcoordinate x: " << _node.worldPos.x << std::endl;
+				out << "\tcoordinate y: " << _node.worldPos.y << std::endl;
+				out << "\tindex x: " << _node.nodeIndex.x << std::endl;
+				out << "\tindex y: " << _node.nodeIndex.y << std::endl;
+				out << "\tterrain cost: " << _node.terrainCost << std::endl;
 				return out;
 		}
 
@@ -162,36 +77,39 @@ struct Node
 		glm::ivec2 nodeIndex{ -1 }; ///< the index of the node in the nodemap vector for the grid
 
 		int terrainCost{ 0 }; ///< the terrain cost of the node
+
+		bool walkable{ false }; ///flag whether you can walk through this node
+};
+
+/** \brief The per query state of a node, kept in a SearchContext so the Grid itself is never written by a search */
+struct SearchNode
+{
 		int g{ 0 }; ///< distance from start to current node
 		int h{ 0 }; ///< distance from end to current node
 		int f() const noexcept { return g + h; }; ///< g + h
 
-		bool walkable{ false }; ///flag whether you can walk through this node
+		int parent{ -1 }; ///< flat index of the node this one was reached from (-1 for none)
+
+		//these flags are the open and closed sets, they are reset with the rest of the node whenever a new query first visits it
 		bool inOpenSet{ false }; ///Flag for a log(1) check if in open set
 		bool inClosedSet{ false }; ///Flag for a log(1) check if in closed set
+		bool reverse{ false }; ///< reached by the search from the end (the bidirectional searches)
 
-		std::weak_ptr<Node> parent;
+		unsigned int visitGeneration{ 0 }; ///< the query which last touched the node, the values above are stale if it isn't the current one
 };
 
 /** \brief Comparator for priority queues */
 struct ComparePriority
 {
-		bool operator()(const std::weak_ptr<Node> _lhs, const std::weak_ptr<Node> _rhs) const noexcept
+		ComparePriority(const SearchNode* _nodes = nullptr) : m_nodes(_nodes) {}
+
+		/** \brief Compares the flat indices of two nodes in the m_nodes array */
+		bool operator()(int _lhs, int _rhs) const noexcept
 		{
-				// return "true" if "_lhs" is ordered before "_rhs" (_lhs has less priority)
-				if (_lhs.lock()->f() == _rhs.lock()->f())
-				{
-						//have a tie breaker just in case
-						return (_lhs.lock()->h > _rhs.lock()->h);
-				}
-				else
-				{
-						//have a tie breaker just in case
-						return (_lhs.lock()->f() > _rhs.lock()->f());
-				}
+				return (*this)(&m_nodes[_lhs], &m_nodes[_rhs]);
 		}
 
-		bool operator()(const Node & _lhs, const Node & _rhs) const noexcept
+		bool operator()(const SearchNode & _lhs, const SearchNode & _rhs) const noexcept
 		{
 				// return "true" if "_lhs" is ordered before "_rhs" (_lhs has less priority)
 				if (_lhs.f() == _rhs.f())
@@ -204,7 +122,7 @@ struct ComparePriority
 				}
 		}
 
-		bool operator()(const Node * _lhs, const Node * _rhs) const noexcept
+		bool operator()(const SearchNode * _lhs, const SearchNode * _rhs) const noexcept
 		{
 				// return "true" if "_lhs" is ordered before "_rhs" (_lhs has less priority)
 				if (_lhs->f() == _rhs->f())
@@ -216,26 +134,32 @@ struct ComparePriority
 						return (_lhs->f() > _rhs->f());
 				}
 		}
+
+		const SearchNode* m_nodes{ nullptr }; ///< the search state the indices refer to
+};
+
+/** \brief The bucket of a node in a BucketQueue: its f, which is g alone for Dijkstra (h stays 0) */
+struct FPriority
+{
+		FPriority(const SearchNode* _nodes = nullptr) : m_nodes(_nodes) {}
+
+		int operator()(int _index) const noexcept { return m_nodes[_index].f(); }
+
+		const SearchNode* m_nodes{ nullptr }; ///< the search state the indices refer to
 };
 
 /** \brief Secondary comparator for Astar epsilon */
 struct SecondaryComparator
 {
-		bool operator()(const std::weak_ptr<Node> _lhs, const std::weak_ptr<Node> _rhs) const noexcept
+		SecondaryComparator(const SearchNode* _nodes = nullptr) : m_nodes(_nodes) {}
+
+		/** \brief Compares the flat indices of two nodes in the m_nodes array */
+		bool operator()(int _lhs, int _rhs) const noexcept
 		{
-				// return "true" if "_lhs" is ordered before "_rhs" (_lhs has less priority(depending on g))
-				if (_lhs.lock()->g == _rhs.lock()->g)
-				{
-						//have a tie breaker just in case
-						return (_lhs.lock()->h > _rhs.lock()->h);
-				}
-				else
-				{
-						return (_lhs.lock()->g > _rhs.lock()->g);
-				}
+				return (*this)(&m_nodes[_lhs], &m_nodes[_rhs]);
 		}
 
-		bool operator()(const Node & _lhs, const Node & _rhs) const noexcept
+		bool operator()(const SearchNode & _lhs, const SearchNode & _rhs) const noexcept
 		{
 				// return "true" if "_lhs" is ordered before "_rhs" (_lhs has less priority(depending on g))
 				if (_lhs.g == _rhs.g)
@@ -249,7 +173,7 @@ struct SecondaryComparator
 				}
 		}
 
-		bool operator()(const Node * _lhs, const Node * _rhs) const noexcept
+		bool operator()(const SearchNode * _lhs, const SearchNode * _rhs) const noexcept
 		{
 				// return "true" if "_lhs" is ordered before "_rhs" (_lhs has less priority(depending on g))
 				if (_lhs->g == _rhs->g)
@@ -262,78 +186,6 @@ struct SecondaryComparator
 						return (_lhs->g > _rhs->g);
 				}
 		}
-};
-
-// custom hash can be a standalone function object:
-// http://en.cppreference.com/w/cpp/utility/hash
-/** \brief Hasher for the nodes to use in unordered sets */
-struct NodeHasher
-{
-		std::size_t operator()(const Node & _node) const noexcept
-		{
-				//hash the world pos and node index (both are different for every node)
-				std::size_t hash0 = std::hash<int>{}(_node.nodeIndex.x);
-				std::size_t hash1 = std::hash<int>{}(_node.nodeIndex.y);
-
-				std::size_t hash2 = std::hash<float>{}(_node.worldPos.x);
-				std::size_t hash3 = std::hash<float>{}(_node.worldPos.y);
-
-				return (hash0 ^ hash1) ^ ((hash2 ^ hash3) << 1);
-		}
-		std::size_t operator()(std::weak_ptr<Node> _node) const noexcept
-		{
-				//hash the world pos and node index (both are different for every node)
-				std::size_t hash0 = std::hash<int>{}(_node.lock()->nodeIndex.x);
-				std::size_t hash1 = std::hash<int>{}(_node.lock()->nodeIndex.y);
-
-				std::size_t hash2 = std::hash<float>{}(_node.lock()->worldPos.x);
-				std::size_t hash3 = std::hash<float>{}(_node.lock()->worldPos.y);
-
-				return (hash0 ^ hash1) ^ ((hash2 ^ hash3) << 1);
-		}
-		std::size_t operator()(Node* _node) const noexcept
-		{
-				//hash the world pos and node index (both are different for every node)
-				std::size_t hash0 = std::hash<int>{}(_node->nodeIndex.x);
-				std::size_t hash1 = std::hash<int>{}(_node->nodeIndex.y);
-
-				std::size_t hash2 = std::hash<float>{}(_node->worldPos.x);
-				std::size_t hash3 = std::hash<float>{}(_node->worldPos.y);
-
-				return (hash0 ^ hash1) ^ ((hash2 ^ hash3) << 1);
-		}
-};
-
-/** \brief The comparator to be used for the unordered set, it must return true for var a == var b*/
-struct HashComparator
-{
-		bool operator()(const std::weak_ptr<Node> _lhs, const std::weak_ptr<Node> _rhs) const noexcept
-		{
-				//check if their index in the nodemap is the same, if it is then it means they are the same node
-				if (_lhs.lock()->nodeIndex == _rhs.lock()->nodeIndex)
-				{
-						return true;
-				}
-				return false;
-		}
 
-		bool operator()(const Node & _lhs, const Node & _rhs) const noexcept
-		{
-				//check if their index in the nodemap is the same, if it is then it means they are the same node
-				if (_lhs.nodeIndex == _rhs.nodeIndex)
-				{
-						return true;
-				}
-				return false;
-		}
-
-		bool operator()(const Node * _lhs, const Node * _rhs) const noexcept
-		{
-				//check if their index in the nodemap is the same, if it is then it means they are the same node
-				if (_lhs->nodeIndex == _rhs->nodeIndex)
-				{
-						return true;
-				}
-				return false;
-		}
+		const SearchNode* m_nodes{ nullptr }; ///< the search state the indices refer to
 };
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "PathFinder.h"
+#include "AStarQuery.h"
 
-#define EMPTY_VECTOR std::vector<glm::vec2>()
+#include <GameEngine\Profiler.h>
+#include <algorithm>
+
+#define EMPTY_VECTOR std::vector<int>()
 
 //Set the max iterations based on compile mode
 #ifdef _DEBUG
@@ -15,135 +19,135 @@ PathFinder::PathFinder() { }
 
 PathFinder::~PathFinder() { }
 
-std::vector<glm::vec2> PathFinder::AStar(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<Grid> _grid, const Diagonal& _diagonal)
+std::vector<glm::vec2> PathFinder::AStar(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<const Grid> _grid, const Diagonal& _diagonal)
 {
-		if (_diagonal == Diagonal::NEVER)
-		{
-				m_heuristic = ManhattanDistance;
-		}
-		else
-		{
-				m_heuristic = OctileDistance;
-		}
-		unsigned char counter = 0;
-		_grid.lock()->CleanGrid();
-
-		std::weak_ptr<Node> m_startNode;
-		std::weak_ptr<Node> m_endNode;
-		Heap<std::weak_ptr<Node>, std::vector<std::weak_ptr<Node>>, ComparePriority> m_openSet;
-		std::unordered_set<std::weak_ptr<Node>, NodeHasher, HashComparator> m_closedSet;
+		std::shared_ptr<const Grid> grid = _grid.lock();
+		return ToWorldPath(AStar(grid->GetIndexAt(_start), grid->GetIndexAt(_end), *grid, _diagonal, m_context), *grid);
+}
 
-		m_startNode = _grid.lock()->GetNodeAt(_start);
-		m_endNode = _grid.lock()->GetNodeAt(_end);
-		if (!m_startNode.lock()->walkable || !m_endNode.lock()->walkable)
-		{
-				return EMPTY_VECTOR;
-		}
+std::vector<glm::vec2> PathFinder::AStarEpsilon(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<const Grid> _grid, const Diagonal & _diagonal)
+{
+		std::shared_ptr<const Grid> grid = _grid.lock();
+		return ToWorldPath(AStarEpsilon(grid->GetIndexAt(_start), grid->GetIndexAt(_end), *grid, _diagonal, m_context), *grid);
+}
 
-		m_startNode.lock()->h = m_heuristic(m_startNode.lock()->nodeIndex, m_endNode.lock()->nodeIndex);
-		m_startNode.lock()->inOpenSet = true;
-		m_openSet.Push(m_startNode);
+std::vector<glm::vec2> PathFinder::BestFirst(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<const Grid> _grid, const Diagonal& _diagonal)
+{
+		std::shared_ptr<const Grid> grid = _grid.lock();
+		return ToWorldPath(BestFirst(grid->GetIndexAt(_start), grid->GetIndexAt(_end), *grid, _diagonal, m_context), *grid);
+}
 
-		while (!m_openSet.IsEmpty())
-		{
-				std::weak_ptr<Node> currentNode = m_openSet.Front();
-				currentNode.lock()->inOpenSet = false;
-				m_openSet.Pop();
+std::vector<glm::vec2> PathFinder::BreadthFirst(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<const Grid> _grid, const Diagonal& _diagonal)
+{
+		std::shared_ptr<const Grid> grid = _grid.lock();
+		return ToWorldPath(BreadthFirst(grid->GetIndexAt(_start), grid->GetIndexAt(_end), *grid, _diagonal, m_context), *grid);
+}
 
-				currentNode.lock()->inClosedSet = true;
-				m_closedSet.insert(currentNode);
+std::vector<glm::vec2> PathFinder::DepthFirst(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<const Grid> _grid, const Diagonal & _diagonal)
+{
+		std::shared_ptr<const Grid> grid = _grid.lock();
+		return ToWorldPath(DepthFirst(grid->GetIndexAt(_start), grid->GetIndexAt(_end), *grid, _diagonal, m_context), *grid);
+}
 
-				//check if the end was found
-				if (currentNode.lock() == m_endNode.lock())
-				{
-						std::vector<glm::vec2> result = Backtrace(m_startNode, m_endNode);
-						//result = CompressPath(result);
-						return result;
-				}
+std::vector<glm::vec2> PathFinder::Dijkstra(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<const Grid> _grid, const Diagonal & _diagonal)
+{
+		std::shared_ptr<const Grid> grid = _grid.lock();
+		return ToWorldPath(Dijkstra(grid->GetIndexAt(_start), grid->GetIndexAt(_end), *grid, _diagonal, m_context), *grid);
+}
 
-				//get all the walkable neightbors
-				for (auto neighbor : _grid.lock()->GetNeighbors(currentNode, _diagonal))
-				{
-						//get the g cost of the neighbor 
-						int newG = currentNode.lock()->g + m_heuristic(currentNode.lock()->nodeIndex, neighbor.lock()->nodeIndex) + neighbor.lock()->terrainCost;
+std::vector<glm::vec2> PathFinder::GreedyBFirst(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<const Grid> _grid, const Diagonal & _diagonal)
+{
+		std::shared_ptr<const Grid> grid = _grid.lock();
+		return ToWorldPath(GreedyBFirst(grid->GetIndexAt(_start), grid->GetIndexAt(_end), *grid, _diagonal, m_context), *grid);
+}
 
-						if (neighbor.lock()->inOpenSet)
-						{
-								//node already generated, but not expanded
-								if (newG < neighbor.lock()->g)
-								{
-										//new path is cheaper
-										neighbor.lock()->g = newG;
-										neighbor.lock()->h = m_heuristic(neighbor.lock()->nodeIndex, m_endNode.lock()->nodeIndex);
-										neighbor.lock()->parent = currentNode;
-										//Re-heapify the open set with the updated costs
-										m_openSet.UpdateHeap();
-								}
-						}
-						else if (neighbor.lock()->inClosedSet)
-						{
-								if (newG < neighbor.lock()->g)
-								{
-										//new path is cheaper
-										neighbor.lock()->g = newG;
-										neighbor.lock()->h = m_heuristic(neighbor.lock()->nodeIndex, m_endNode.lock()->nodeIndex);
-										neighbor.lock()->parent = currentNode;
-										neighbor.lock()->inClosedSet = false;
-										m_closedSet.erase(neighbor);
-										neighbor.lock()->inOpenSet = true;
-										m_openSet.Push(neighbor);
-								}
-						}
-						else
-						{
-								neighbor.lock()->g = newG;
-								neighbor.lock()->h = m_heuristic(neighbor.lock()->nodeIndex, m_endNode.lock()->nodeIndex);
-								neighbor.lock()->parent = currentNode;
-								neighbor.lock()->inOpenSet = true;
-								m_openSet.Push(neighbor);
-						}
-				}
-				counter++;
-				if (counter > MAX_ITERATIONS)
-				{
-						std::vector<glm::vec2> result = Backtrace(m_startNode, currentNode);
-						//result = CompressPath(result);
-						return result;
-				}
-		}
-		return EMPTY_VECTOR;
+std::vector<glm::vec2> PathFinder::JumpPoint(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<const Grid> _grid, const Diagonal & _diagonal)
+{
+		std::shared_ptr<const Grid> grid = _grid.lock();
+		return ToWorldPath(JumpPoint(grid->GetIndexAt(_start), grid->GetIndexAt(_end), *grid, _diagonal, m_context), *grid);
 }
 
-std::vector<glm::vec2> PathFinder::AStarEpsilon(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<Grid> _grid, const Diagonal & _diagonal)
+std::vector<std::vector<glm::vec2>> PathFinder::DijkstraToGoal(const std::vector<glm::vec2>& _starts, const glm::vec2 & _end, std::weak_ptr<const Grid> _grid, const Diagonal & _diagonal)
 {
-		if (_diagonal == Diagonal::NEVER)
+		std::shared_ptr<const Grid> grid = _grid.lock();
+		std::vector<int> starts;
+		for (const glm::vec2& start : _starts)
 		{
-				m_heuristic = ManhattanDistance;
+				starts.push_back(grid->GetIndexAt(start));
 		}
-		else
+		std::vector<std::vector<int>> paths = DijkstraToGoal(starts, grid->GetIndexAt(_end), *grid, _diagonal, m_context);
+
+		std::vector<std::vector<glm::vec2>> worldPaths;
+		for (const auto& path : paths)
 		{
-				m_heuristic = OctileDistance;
+				worldPaths.push_back(ToWorldPath(path, *grid));
 		}
-		unsigned char counter = 0;
-		_grid.lock()->CleanGrid();
+		return worldPaths;
+}
 
-		std::weak_ptr<Node> m_startNode;
-		std::weak_ptr<Node> m_endNode;
+std::vector<glm::vec2> PathFinder::DijkstraToNearest(const glm::vec2 & _start, const std::vector<glm::vec2>& _goals, std::weak_ptr<const Grid> _grid, const Diagonal & _diagonal,
+		int & _goalIndex, std::vector<int>* _costs)
+{
+		std::shared_ptr<const Grid> grid = _grid.lock();
+		std::vector<int> goals;
+		for (const glm::vec2& goal : _goals)
+		{
+				goals.push_back(grid->IsPosInside(goal / grid->GetNodeDiameter()) ? grid->GetIndexAt(goal) : -1);
+		}
+		return ToWorldPath(DijkstraToNearest(grid->GetIndexAt(_start), goals, *grid, _diagonal, m_context, _goalIndex, _costs), *grid);
+}
 
-		m_startNode = _grid.lock()->GetNodeAt(_start);
-		m_endNode = _grid.lock()->GetNodeAt(_end);
-		if (!m_startNode.lock()->walkable || !m_endNode.lock()->walkable)
+std::vector<glm::vec2> PathFinder::BiAStar(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<const Grid> _grid, const Diagonal & _diagonal)
+{
+		std::shared_ptr<const Grid> grid = _grid.lock();
+		return ToWorldPath(BiAStar(grid->GetIndexAt(_start), grid->GetIndexAt(_end), *grid, _diagonal, m_context), *grid);
+}
+
+std::vector<glm::vec2> PathFinder::BiBreadthFirst(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<const Grid> _grid, const Diagonal & _diagonal)
+{
+		std::shared_ptr<const Grid> grid = _grid.lock();
+		return ToWorldPath(BiBreadthFirst(grid->GetIndexAt(_start), grid->GetIndexAt(_end), *grid, _diagonal, m_context), *grid);
+}
+
+std::vector<glm::vec2> PathFinder::Hierarchical(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<HierarchicalGrid> _hierarchy)
+{
+		std::shared_ptr<HierarchicalGrid> hierarchy = _hierarchy.lock();
+		const Grid& grid = hierarchy->GetGrid();
+		return ToWorldPath(hierarchy->FindPath(grid.GetIndexAt(_start), grid.GetIndexAt(_end), m_context), grid);
+}
+
+std::vector<int> PathFinder::AStar(int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context)
+{
+		PROFILE_SCOPE("PathFinder::AStar");
+		//no iteration cap, the caller decides how long a search may take by stepping the query itself
+		AStarQuery query(_context);
+		const std::shared_ptr<const LandmarkTable> landmarks = m_landmarks.lock();
+		query.Begin(_start, _end, _grid, _diagonal, m_aStarOpenSet, landmarks.get());
+		query.Run();
+		return query.GetPath();
+}
+
+std::vector<int> PathFinder::AStarEpsilon(int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context)
+{
+		const Heuristic heuristic = SelectHeuristic(_diagonal);
+		unsigned char counter = 0;
+		_context.Begin(_grid.GetNumNodes());
+
+		const glm::ivec2 startCoord = _grid.GetCoord(_start);
+		const glm::ivec2 endCoord = _grid.GetCoord(_end);
+		if (!_grid.IsWalkable(_start) || !_grid.IsWalkable(_end))
 		{
 				return EMPTY_VECTOR;
 		}
 
-		Heap<std::weak_ptr<Node>, std::vector<std::weak_ptr<Node>>, ComparePriority> m_openSet;
-		std::unordered_set<std::weak_ptr<Node>, NodeHasher, HashComparator> m_closedSet;
-		Heap<std::weak_ptr<Node>, std::vector<std::weak_ptr<Node>>, SecondaryComparator> m_focal;
+		IndexedHeap<ComparePriority>& m_openSet = _context.GetOpenSet();
+		Heap<int, std::vector<int>, SecondaryComparator> m_focal{ std::vector<int>(), SecondaryComparator(_context.GetNodes()) };
+		Grid::NeighborList neighbors;
 
-		m_startNode.lock()->h = m_heuristic(m_startNode.lock()->nodeIndex, m_endNode.lock()->nodeIndex);
-		m_startNode.lock()->inOpenSet = true;
-		m_openSet.Push(m_startNode);
+		SearchNode& startState = _context.Visit(_start);
+		startState.h = heuristic(startCoord, endCoord);
+		startState.inOpenSet = true;
+		m_openSet.Push(_start);
 
 		while (!m_openSet.IsEmpty())
 		{
@@ -151,7 +155,7 @@ std::vector<glm::vec2> PathFinder::AStarEpsilon(const glm::vec2 & _start, const
 				for (size_t i = 0; i < m_openSet.Size(); i++)
 				{
 						//focal = set{currentnode.f() <= (1 + epsilon) * smallest f()}
-						if (m_openSet.At(i).lock()->f() <= (EPSILON) * m_openSet.Front().lock()->f())
+						if (_context.At(m_openSet.At(i)).f() <= (EPSILON) * _context.At(m_openSet.Front()).f())
 						{
 								m_focal.Push(m_openSet.At(i));
 						}
@@ -161,443 +165,1100 @@ std::vector<glm::vec2> PathFinder::AStarEpsilon(const glm::vec2 & _start, const
 						}
 				}
 				//get the best node from the secondary heuristic
-				std::weak_ptr<Node> currentNode = m_focal.Front();
-				currentNode.lock()->inOpenSet = false;
-				
+				const int current = m_focal.Front();
+				SearchNode& currentState = _context.At(current);
+				const glm::ivec2 currentCoord = _grid.GetCoord(current);
+				currentState.inOpenSet = false;
+
 				//pop the current node from the open set
-				for (size_t i = 0; i < m_openSet.Size(); i++)
-				{
-						//use the operator overloaded function which takes a weak ptr as rhs
-						if (*currentNode.lock().get() == m_openSet.At(i))
-						{
-								m_openSet.Remove(i);
-								break;
-						}
-				}
+				m_openSet.Remove(current);
 
 				//set the node to the closed set
-				currentNode.lock()->inClosedSet = true;
-				m_closedSet.insert(currentNode);
+				currentState.inClosedSet = true;
 
 				//check if the end was found
-				if (currentNode.lock() == m_endNode.lock())
+				if (current == _end)
 				{
-						std::vector<glm::vec2> result = Backtrace(m_startNode, m_endNode);
-						//result = CompressPath(result);
-						return result;
+						return Backtrace(_start, _end, _context);
 				}
 
 				//get all the walkable neightbors
-				for (auto neighbor : _grid.lock()->GetNeighbors(currentNode, _diagonal))
+				_grid.GetNeighbors(current, _diagonal, neighbors);
+				for (int neighbor : neighbors)
 				{
-						//get the g cost of the neighbor 
-						int newG = currentNode.lock()->g + m_heuristic(currentNode.lock()->nodeIndex, neighbor.lock()->nodeIndex) + neighbor.lock()->terrainCost;
+						SearchNode& neighborState = _context.Visit(neighbor);
+						const glm::ivec2 neighborCoord = _grid.GetCoord(neighbor);
+						//get the g cost of the neighbor
+						int newG = currentState.g + heuristic(currentCoord, neighborCoord) + _grid.GetTerrainCost(neighbor);
 
-						if (neighbor.lock()->inOpenSet)
+						if (neighborState.inOpenSet)
 						{
 								//node already generated, but not expanded
-								if (newG < neighbor.lock()->g)
+								if (newG < neighborState.g)
 								{
 										//new path is cheaper
-										neighbor.lock()->g = newG;
-										neighbor.lock()->h = m_heuristic(neighbor.lock()->nodeIndex, m_endNode.lock()->nodeIndex);
-										neighbor.lock()->parent = currentNode;
-										//Re-heapify the open set with the updated costs
-										m_openSet.UpdateHeap();
+										neighborState.g = newG;
+										neighborState.h = heuristic(neighborCoord, endCoord);
+										neighborState.parent = current;
+										//move the node up the open set with its lowered cost
+										m_openSet.Update(neighbor);
 								}
 						}
-						else if (neighbor.lock()->inClosedSet)
+						else if (neighborState.inClosedSet)
 						{
-								if (newG < neighbor.lock()->g)
+								if (newG < neighborState.g)
 								{
 										//new path is cheaper
-										neighbor.lock()->g = newG;
-										neighbor.lock()->h = m_heuristic(neighbor.lock()->nodeIndex, m_endNode.lock()->nodeIndex);
-										neighbor.lock()->parent = currentNode;
-										neighbor.lock()->inClosedSet = false;
-										m_closedSet.erase(neighbor);
-										neighbor.lock()->inOpenSet = true;
+										neighborState.g = newG;
+										neighborState.h = heuristic(neighborCoord, endCoord);
+										neighborState.parent = current;
+										neighborState.inClosedSet = false;
+										neighborState.inOpenSet = true;
 										m_openSet.Push(neighbor);
 								}
 						}
 						else
 						{
-								neighbor.lock()->g = newG;
-								neighbor.lock()->h = m_heuristic(neighbor.lock()->nodeIndex, m_endNode.lock()->nodeIndex);
-								neighbor.lock()->parent = currentNode;
-								neighbor.lock()->inOpenSet = true;
+								neighborState.g = newG;
+								neighborState.h = heuristic(neighborCoord, endCoord);
+								neighborState.parent = current;
+								neighborState.inOpenSet = true;
 								m_openSet.Push(neighbor);
 						}
 				}
 				counter++;
 				if (counter > MAX_ITERATIONS)
 				{
-						std::vector<glm::vec2> result = Backtrace(m_startNode, currentNode);
-						//result = CompressPath(result);
-						return result;
+						return Backtrace(_start, current, _context);
 				}
 		}
 		return EMPTY_VECTOR;
 }
 
-std::vector<glm::vec2> PathFinder::BestFirst(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<Grid> _grid, const Diagonal& _diagonal)
+std::vector<int> PathFinder::BestFirst(int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context)
 {
-		if (_diagonal == Diagonal::NEVER)
-		{
-				m_heuristic = ManhattanDistance;
-		}
-		else
-		{
-				m_heuristic = OctileDistance;
-		}
+		const Heuristic heuristic = SelectHeuristic(_diagonal);
 		unsigned char counter = 0;
-		_grid.lock()->CleanGrid();
+		_context.Begin(_grid.GetNumNodes());
 
-		std::weak_ptr<Node> m_startNode;
-		std::weak_ptr<Node> m_endNode;
-		Heap<std::weak_ptr<Node>, std::vector<std::weak_ptr<Node>>, ComparePriority> m_openSet;
-		std::vector<std::weak_ptr<Node>> m_closedSet;
+		Heap<int, std::vector<int>, ComparePriority> m_openSet{ std::vector<int>(), ComparePriority(_context.GetNodes()) };
+		Grid::NeighborList neighbors;
 
-		m_startNode = _grid.lock()->GetNodeAt(_start);
-		m_endNode = _grid.lock()->GetNodeAt(_end);
-		if (!m_startNode.lock()->walkable || !m_endNode.lock()->walkable)
+		const glm::ivec2 startCoord = _grid.GetCoord(_start);
+		const glm::ivec2 endCoord = _grid.GetCoord(_end);
+		if (!_grid.IsWalkable(_start) || !_grid.IsWalkable(_end))
 		{
 				return EMPTY_VECTOR;
 		}
 
-		m_startNode.lock()->h = m_heuristic(m_startNode.lock()->nodeIndex, m_endNode.lock()->nodeIndex);
-		m_startNode.lock()->inOpenSet = true;
-		m_openSet.Push(m_startNode);
+		SearchNode& startState = _context.Visit(_start);
+		startState.h = heuristic(startCoord, endCoord);
+		startState.inOpenSet = true;
+		m_openSet.Push(_start);
 
 		while (!m_openSet.IsEmpty())
 		{
-				std::weak_ptr<Node> currentNode = m_openSet.Front();
-				currentNode.lock()->inOpenSet = false;
+				const int current = m_openSet.Front();
+				SearchNode& currentState = _context.At(current);
+				const glm::ivec2 currentCoord = _grid.GetCoord(current);
+				currentState.inOpenSet = false;
 				m_openSet.Pop();
 
-				currentNode.lock()->inClosedSet = true;
-				m_closedSet.push_back(currentNode);
+				currentState.inClosedSet = true;
 
 				//check if the end was found
-				if (currentNode.lock() == m_endNode.lock())
+				if (current == _end)
 				{
-						std::vector<glm::vec2> result = Backtrace(m_startNode, m_endNode);
-						//result = CompressPath(result);
-						return result;
+						return Backtrace(_start, _end, _context);
 				}
 
 				//get all the walkable neightbors
-				for (auto neighbor : _grid.lock()->GetNeighbors(currentNode, _diagonal))
+				_grid.GetNeighbors(current, _diagonal, neighbors);
+				for (int neighbor : neighbors)
 				{
+						SearchNode& neighborState = _context.Visit(neighbor);
+						const glm::ivec2 neighborCoord = _grid.GetCoord(neighbor);
 						//check if the neighbor has already been checked (in closed list)
-						if (neighbor.lock()->inClosedSet || neighbor.lock()->inOpenSet)
+						if (neighborState.inClosedSet || neighborState.inOpenSet)
 						{
 								continue;
 						}
-						int newG = currentNode.lock()->g + m_heuristic(currentNode.lock()->nodeIndex, neighbor.lock()->nodeIndex) + neighbor.lock()->terrainCost;
-						neighbor.lock()->g = newG;
-						neighbor.lock()->h = m_heuristic(neighbor.lock()->nodeIndex, m_endNode.lock()->nodeIndex);
-						neighbor.lock()->parent = currentNode;
-						neighbor.lock()->inOpenSet = true;
+						int newG = currentState.g + heuristic(currentCoord, neighborCoord) + _grid.GetTerrainCost(neighbor);
+						neighborState.g = newG;
+						neighborState.h = heuristic(neighborCoord, endCoord);
+						neighborState.parent = current;
+						neighborState.inOpenSet = true;
 						m_openSet.Push(neighbor);
 				}
 				counter++;
 				if (counter > MAX_ITERATIONS)
 				{
-						std::vector<glm::vec2> result = Backtrace(m_startNode, currentNode);
-						//result = CompressPath(result);
-						return result;
+						return Backtrace(_start, current, _context);
 				}
 		}
 		return EMPTY_VECTOR;
 }
 
-std::vector<glm::vec2> PathFinder::BreadthFirst(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<Grid> _grid, const Diagonal& _diagonal)
+std::vector<int> PathFinder::BreadthFirst(int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context)
 {
 		unsigned char counter = 0;
-		_grid.lock()->CleanGrid();
-
-		std::weak_ptr<Node> m_startNode;
-		std::weak_ptr<Node> m_endNode;
+		_context.Begin(_grid.GetNumNodes());
 
-		m_startNode = _grid.lock()->GetNodeAt(_start);
-		m_endNode			= _grid.lock()->GetNodeAt(_end);
-		if (!m_startNode.lock()->walkable || !m_endNode.lock()->walkable)
+		if (!_grid.IsWalkable(_start) || !_grid.IsWalkable(_end))
 		{
 				return EMPTY_VECTOR;
 		}
-		
-		std::queue<std::weak_ptr<Node>> m_visited;
-		m_startNode.lock()->inOpenSet = true;
-		m_visited.push(m_startNode);
+
+		std::queue<int> m_visited;
+		Grid::NeighborList neighbors;
+		SearchNode& startState = _context.Visit(_start);
+		startState.inOpenSet = true;
+		m_visited.push(_start);
 
 		while (!m_visited.empty())
 		{
-				std::weak_ptr<Node> currentNode = m_visited.front();
+				const int current = m_visited.front();
 				m_visited.pop();
 
 				//check if the end was found
-				if (currentNode.lock() == m_endNode.lock())
+				if (current == _end)
 				{
-						std::vector<glm::vec2> result = Backtrace(m_startNode, m_endNode);
-						//result = CompressPath(result);
-						return result;
+						return Backtrace(_start, _end, _context);
 				}
 
 				//get all the walkable neightbors
-				for (auto neighbor : _grid.lock()->GetNeighbors(currentNode, _diagonal))
+				_grid.GetNeighbors(current, _diagonal, neighbors);
+				for (int neighbor : neighbors)
 				{
-						//check if the neighbor has already been inspected 
-						if (!neighbor.lock()->inOpenSet)
+						SearchNode& neighborState = _context.Visit(neighbor);
+						//check if the neighbor has already been inspected
+						if (!neighborState.inOpenSet)
 						{
 								//if not, add it to the visited list
-								neighbor.lock()->inOpenSet = true;
-								neighbor.lock()->parent = currentNode;
+								neighborState.inOpenSet = true;
+								neighborState.parent = current;
 								m_visited.push(neighbor);
 						}
 				}
 				counter++;
 				if (counter > MAX_ITERATIONS)
 				{
-						std::vector<glm::vec2> result = Backtrace(m_startNode, currentNode);
-						//result = CompressPath(result);
-						return result;
+						return Backtrace(_start, current, _context);
 				}
 		}
 		return EMPTY_VECTOR;
 }
 
-std::vector<glm::vec2> PathFinder::DepthFirst(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<Grid> _grid, const Diagonal & _diagonal)
+std::vector<int> PathFinder::BiBreadthFirst(int _start, int _end, const Grid & _grid, const Diagonal & _diagonal, SearchContext & _context)
 {
-		unsigned char counter = 0;
-		_grid.lock()->CleanGrid();
+		_context.Begin(_grid.GetNumNodes());
+
+		if (!_grid.IsWalkable(_start) || !_grid.IsWalkable(_end) || _start == _end)
+		{
+				return EMPTY_VECTOR;
+		}
+
+		//one queue for the search from the start and one for the search from the end
+		std::queue<int> m_startVisited;
+		std::queue<int> m_endVisited;
+		Grid::NeighborList neighbors;
+		SearchNode& startState = _context.Visit(_start);
+		startState.inOpenSet = true;
+		m_startVisited.push(_start);
+		SearchNode& endState = _context.Visit(_end);
+		endState.inOpenSet = true;
+		endState.reverse = true;
+		m_endVisited.push(_end);
+
+		int meetStart = -1;
+		int meetEnd = -1;
+		//visits the neighbors of the next node of one side, true if they touched a node of the other side
+		auto expand = [&](std::queue<int>& _visited, bool _reverse)
+		{
+				const int current = _visited.front();
+				_visited.pop();
 
-		std::weak_ptr<Node> m_startNode;
-		std::weak_ptr<Node> m_endNode;
+				_grid.GetNeighbors(current, _diagonal, neighbors);
+				for (int neighbor : neighbors)
+				{
+						SearchNode& neighborState = _context.Visit(neighbor);
+						if (neighborState.inOpenSet)
+						{
+								if (neighborState.reverse != _reverse)
+								{
+										//the searches met
+										meetStart = _reverse ? neighbor : current;
+										meetEnd = _reverse ? current : neighbor;
+										return true;
+								}
+								continue;
+						}
+						neighborState.inOpenSet = true;
+						neighborState.reverse = _reverse;
+						neighborState.parent = current;
+						_visited.push(neighbor);
+				}
+				return false;
+		};
 
-		m_startNode = _grid.lock()->GetNodeAt(_start);
-		m_endNode = _grid.lock()->GetNodeAt(_end);
-		if (!m_startNode.lock()->walkable || !m_endNode.lock()->walkable)
+		while (!m_startVisited.empty() && !m_endVisited.empty())
+		{
+				if (expand(m_startVisited, false) || expand(m_endVisited, true))
+				{
+						return BiBacktrace(_start, meetStart, meetEnd, _context);
+				}
+		}
+		return EMPTY_VECTOR;
+}
+
+std::vector<int> PathFinder::DepthFirst(int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context)
+{
+		unsigned char counter = 0;
+		_context.Begin(_grid.GetNumNodes());
+
+		if (!_grid.IsWalkable(_start) || !_grid.IsWalkable(_end))
 		{
 				return EMPTY_VECTOR;
 		}
 
-		std::vector<std::weak_ptr<Node>> m_openSet;
-		std::vector<std::weak_ptr<Node>> m_closedSet;
-		m_startNode.lock()->inOpenSet = true;
-		m_openSet.push_back(m_startNode);
+		std::vector<int> m_openSet;
+		Grid::NeighborList neighbors;
+		SearchNode& startState = _context.Visit(_start);
+		startState.inOpenSet = true;
+		m_openSet.push_back(_start);
 
 		while (!m_openSet.empty())
 		{
-				std::weak_ptr<Node> currentNode = m_openSet.back();
+				const int current = m_openSet.back();
+				SearchNode& currentState = _context.At(current);
 				m_openSet.pop_back();
-				currentNode.lock()->inOpenSet = false;
+				currentState.inOpenSet = false;
 
-				currentNode.lock()->inClosedSet = true;
-				m_closedSet.push_back(currentNode);
+				currentState.inClosedSet = true;
 				//check if the end was found
-				if (currentNode.lock() == m_endNode.lock())
+				if (current == _end)
 				{
-						std::vector<glm::vec2> result = Backtrace(m_startNode, m_endNode);
-						//result = CompressPath(result);
-						return result;
+						return Backtrace(_start, _end, _context);
 				}
 
 				//get all the walkable neightbors
-				for (auto neighbor : _grid.lock()->GetNeighbors(currentNode, _diagonal))
+				_grid.GetNeighbors(current, _diagonal, neighbors);
+				for (int neighbor : neighbors)
 				{
-						//check if the neighbor has already been inspected 
-						if (neighbor.lock()->inClosedSet || neighbor.lock()->inOpenSet)
+						SearchNode& neighborState = _context.Visit(neighbor);
+						//check if the neighbor has already been inspected
+						if (neighborState.inClosedSet || neighborState.inOpenSet)
 						{
 								continue;
 						}
-						neighbor.lock()->inOpenSet = true;
-						neighbor.lock()->parent = currentNode;
+						neighborState.inOpenSet = true;
+						neighborState.parent = current;
 						m_openSet.push_back(neighbor);
 				}
 				counter++;
 				if (counter > MAX_ITERATIONS)
 				{
-						std::vector<glm::vec2> result = Backtrace(m_startNode, currentNode);
-						//result = CompressPath(result);
-						return result;
+						return Backtrace(_start, current, _context);
 				}
 		}
 		return EMPTY_VECTOR;
 }
 
-std::vector<glm::vec2> PathFinder::Dijkstra(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<Grid> _grid, const Diagonal & _diagonal)
+std::vector<int> PathFinder::Dijkstra(int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context)
 {
-		if (_diagonal == Diagonal::NEVER)
+		//picked once per query, the loop itself has no branches on the mode
+		switch (_diagonal)
 		{
-				m_heuristic = ManhattanDistance;
+				case Diagonal::ALWAYS: return Dijkstra<Diagonal::ALWAYS>(_start, _end, _grid, _context);
+				case Diagonal::IFNOWALLS: return Dijkstra<Diagonal::IFNOWALLS>(_start, _end, _grid, _context);
+				case Diagonal::IFLESSTHANTWOWALLS: return Dijkstra<Diagonal::IFLESSTHANTWOWALLS>(_start, _end, _grid, _context);
+				default: return Dijkstra<Diagonal::NEVER>(_start, _end, _grid, _context);
 		}
-		else
+}
+
+template <Diagonal D>
+std::vector<int> PathFinder::Dijkstra(int _start, int _end, const Grid& _grid, SearchContext& _context)
+{
+		using HeuristicType = typename DiagonalHeuristic<D>::Type;
+		if (m_dijkstraOpenSet == OpenSet::BUCKETS)
 		{
-				m_heuristic = OctileDistance;
+				return DijkstraSearch<D, HeuristicType>(_start, _end, _grid, _context, _context.GetBucketOpenSet());
 		}
+		return DijkstraSearch<D, HeuristicType>(_start, _end, _grid, _context, _context.GetOpenSet());
+}
+
+template <Diagonal D, class HeuristicType, class OpenSetType>
+std::vector<int> PathFinder::DijkstraSearch(int _start, int _end, const Grid& _grid, SearchContext& _context, OpenSetType& _openSet)
+{
+		const HeuristicType heuristic{};
 		unsigned char counter = 0;
-		_grid.lock()->CleanGrid();
+		_context.Begin(_grid.GetNumNodes());
 
-		std::weak_ptr<Node> m_startNode;
-		std::weak_ptr<Node> m_endNode;
-		Heap<std::weak_ptr<Node>, std::vector<std::weak_ptr<Node>>, ComparePriority> m_openSet;
-		std::unordered_set<std::weak_ptr<Node>, NodeHasher, HashComparator> m_closedSet;
+		Grid::NeighborList neighbors;
 
-		m_startNode = _grid.lock()->GetNodeAt(_start);
-		m_endNode = _grid.lock()->GetNodeAt(_end);
-		if (!m_startNode.lock()->walkable || !m_endNode.lock()->walkable)
+		if (!_grid.IsWalkable(_start) || !_grid.IsWalkable(_end))
 		{
 				return EMPTY_VECTOR;
 		}
 
-		m_startNode.lock()->inOpenSet = true;
-		m_openSet.Push(m_startNode);
+		SearchNode& startState = _context.Visit(_start);
+		startState.inOpenSet = true;
+		_openSet.Push(_start);
 
-		while (!m_openSet.IsEmpty())
+		while (!_openSet.IsEmpty())
 		{
-				std::weak_ptr<Node> currentNode = m_openSet.Front();
-				currentNode.lock()->inOpenSet = false;
-				m_openSet.Pop();
+				const int current = _openSet.Front();
+				SearchNode& currentState = _context.At(current);
+				const glm::ivec2 currentCoord = _grid.GetCoord(current);
+				currentState.inOpenSet = false;
+				_openSet.Pop();
 
-				currentNode.lock()->inClosedSet = true;
-				m_closedSet.insert(currentNode);
+				currentState.inClosedSet = true;
 
 				//check if the end was found
-				if (currentNode.lock() == m_endNode.lock())
+				if (current == _end)
 				{
-						std::vector<glm::vec2> result = Backtrace(m_startNode, m_endNode);
-						//result = CompressPath(result);
-						return result;
+						return Backtrace(_start, _end, _context);
 				}
 
 				//get all the walkable neightbors
-				for (auto neighbor : _grid.lock()->GetNeighbors(currentNode, _diagonal))
+				_grid.GetNeighbors<D>(current, neighbors);
+				for (int neighbor : neighbors)
 				{
-						//get the g cost of the neighbor 
-						int newG = currentNode.lock()->g + m_heuristic(currentNode.lock()->nodeIndex, neighbor.lock()->nodeIndex) + neighbor.lock()->terrainCost;
+						SearchNode& neighborState = _context.Visit(neighbor);
+						const glm::ivec2 neighborCoord = _grid.GetCoord(neighbor);
+						//get the g cost of the neighbor
+						int newG = currentState.g + heuristic(currentCoord, neighborCoord) + _grid.GetTerrainCost(neighbor);
 
-						if (neighbor.lock()->inOpenSet)
+						if (neighborState.inOpenSet)
 						{
 								//node already generated, but not expanded
-								if (newG < neighbor.lock()->g)
+								if (newG < neighborState.g)
 								{
 										//new path is cheaper
-										neighbor.lock()->g = newG;
-										neighbor.lock()->parent = currentNode;
-										//Re-heapify the open set with the updated costs
-										m_openSet.UpdateHeap();
+										neighborState.g = newG;
+										neighborState.parent = current;
+										//move the node up the open set with its lowered cost
+										_openSet.Update(neighbor);
 								}
 						}
-						else if (neighbor.lock()->inClosedSet)
+						else if (neighborState.inClosedSet)
 						{
-								if (newG < neighbor.lock()->g)
+								if (newG < neighborState.g)
 								{
 										//new path is cheaper
-										neighbor.lock()->g = newG;
-										neighbor.lock()->parent = currentNode;
-										neighbor.lock()->inClosedSet = false;
-										m_closedSet.erase(neighbor);
-										neighbor.lock()->inOpenSet = true;
-										m_openSet.Push(neighbor);
+										neighborState.g = newG;
+										neighborState.parent = current;
+										neighborState.inClosedSet = false;
+										neighborState.inOpenSet = true;
+										_openSet.Push(neighbor);
 								}
 						}
 						else
 						{
-								neighbor.lock()->g = newG;
-								neighbor.lock()->parent = currentNode;
-								neighbor.lock()->inOpenSet = true;
-								m_openSet.Push(neighbor);
+								neighborState.g = newG;
+								neighborState.parent = current;
+								neighborState.inOpenSet = true;
+								_openSet.Push(neighbor);
 						}
 				}
 				counter++;
 				if (counter > MAX_ITERATIONS)
 				{
-						std::vector<glm::vec2> result = Backtrace(m_startNode, currentNode);
-						//result = CompressPath(result);
-						return result;
+						return Backtrace(_start, current, _context);
 				}
 		}
 		return EMPTY_VECTOR;
 }
 
-//Greedy Best-First Search
-std::vector<glm::vec2> PathFinder::GreedyBFirst(const glm::vec2 & _start, const glm::vec2 & _end, std::weak_ptr<Grid> _grid, const Diagonal & _diagonal)
+std::vector<std::vector<int>> PathFinder::DijkstraToGoal(const std::vector<int>& _starts, int _end, const Grid & _grid, const Diagonal & _diagonal, SearchContext & _context)
 {
-		if (_diagonal == Diagonal::NEVER)
+		const Heuristic heuristic = SelectHeuristic(_diagonal);
+		_context.Begin(_grid.GetNumNodes());
+
+		IndexedHeap<ComparePriority>& m_openSet = _context.GetOpenSet();
+		Grid::NeighborList neighbors;
+		std::vector<std::vector<int>> paths(_starts.size());
+
+		if (!_grid.IsWalkable(_end))
 		{
-				m_heuristic = ManhattanDistance;
+				return paths;
 		}
-		else
+
+		//the search stops once all the (distinct) starts are closed
+		std::vector<int> starts = _starts;
+		std::sort(starts.begin(), starts.end());
+		starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+		size_t numClosedStarts = 0;
+
+		SearchNode& endState = _context.Visit(_end);
+		endState.inOpenSet = true;
+		m_openSet.Push(_end);
+
+		while (!m_openSet.IsEmpty() && numClosedStarts < starts.size())
 		{
-				m_heuristic = OctileDistance;
+				const int current = m_openSet.Front();
+				SearchNode& currentState = _context.At(current);
+				const glm::ivec2 currentCoord = _grid.GetCoord(current);
+				currentState.inOpenSet = false;
+				m_openSet.Pop();
+
+				currentState.inClosedSet = true;
+				if (std::binary_search(starts.begin(), starts.end(), current))
+				{
+						numClosedStarts++;
+				}
+
+				//the neighbors are symmetric, so they are also the nodes which can step onto the current one
+				_grid.GetNeighbors(current, _diagonal, neighbors);
+				for (int neighbor : neighbors)
+				{
+						SearchNode& neighborState = _context.Visit(neighbor);
+						if (neighborState.inClosedSet)
+						{
+								//the costs are never negative, so a closed node already has its cheapest path
+								continue;
+						}
+						const glm::ivec2 neighborCoord = _grid.GetCoord(neighbor);
+						//the cost of stepping from the neighbor onto the current node
+						int newG = currentState.g + heuristic(neighborCoord, currentCoord) + _grid.GetTerrainCost(current);
+
+						if (!neighborState.inOpenSet)
+						{
+								neighborState.g = newG;
+								neighborState.parent = current;
+								neighborState.inOpenSet = true;
+								m_openSet.Push(neighbor);
+						}
+						else if (newG < neighborState.g)
+						{
+								neighborState.g = newG;
+								neighborState.parent = current;
+								m_openSet.Update(neighbor);
+						}
+				}
+		}
+
+		for (size_t i = 0; i < _starts.size(); i++)
+		{
+				if (_starts[i] == _end || !_context.Visit(_starts[i]).inClosedSet)
+				{
+						continue;
+				}
+				//the parents lead from the start to the end, the path is returned from the end like Backtrace's
+				for (int node = _context.At(_starts[i]).parent; node != -1; node = _context.At(node).parent)
+				{
+						paths[i].push_back(node);
+				}
+				std::reverse(paths[i].begin(), paths[i].end());
+		}
+		return paths;
+}
+
+std::vector<int> PathFinder::DijkstraToNearest(int _start, const std::vector<int>& _goals, const Grid & _grid, const Diagonal & _diagonal, SearchContext & _context,
+		int & _goalIndex, std::vector<int>* _costs)
+{
+		const Heuristic heuristic = SelectHeuristic(_diagonal);
+		_context.Begin(_grid.GetNumNodes());
+		_goalIndex = -1;
+		if (_costs)
+		{
+				_costs->assign(_goals.size(), -1);
+		}
+
+		IndexedHeap<ComparePriority>& m_openSet = _context.GetOpenSet();
+		Grid::NeighborList neighbors;
+
+		if (!_grid.IsWalkable(_start))
+		{
+				return EMPTY_VECTOR;
 		}
+
+		//the (distinct) goals which can be reached at all, the search stops once the first one (or with _costs all of them) is closed
+		std::vector<int> goals;
+		for (int goal : _goals)
+		{
+				if (goal != -1 && _grid.IsWalkable(goal))
+				{
+						goals.push_back(goal);
+				}
+		}
+		std::sort(goals.begin(), goals.end());
+		goals.erase(std::unique(goals.begin(), goals.end()), goals.end());
+		const size_t numGoalsWanted = _costs ? goals.size() : std::min<size_t>(goals.size(), 1);
+		size_t numClosedGoals = 0;
+		int nearest = -1;
+
+		SearchNode& startState = _context.Visit(_start);
+		startState.inOpenSet = true;
+		m_openSet.Push(_start);
+
+		while (!m_openSet.IsEmpty() && numClosedGoals < numGoalsWanted)
+		{
+				const int current = m_openSet.Front();
+				SearchNode& currentState = _context.At(current);
+				const glm::ivec2 currentCoord = _grid.GetCoord(current);
+				currentState.inOpenSet = false;
+				m_openSet.Pop();
+
+				currentState.inClosedSet = true;
+				if (std::binary_search(goals.begin(), goals.end(), current))
+				{
+						if (nearest == -1)
+						{
+								nearest = current;
+						}
+						if (++numClosedGoals == numGoalsWanted)
+						{
+								break;
+						}
+				}
+
+				_grid.GetNeighbors(current, _diagonal, neighbors);
+				for (int neighbor : neighbors)
+				{
+						SearchNode& neighborState = _context.Visit(neighbor);
+						if (neighborState.inClosedSet)
+						{
+								continue;
+						}
+						const glm::ivec2 neighborCoord = _grid.GetCoord(neighbor);
+						int newG = currentState.g + heuristic(currentCoord, neighborCoord) + _grid.GetTerrainCost(neighbor);
+
+						if (!neighborState.inOpenSet)
+						{
+								neighborState.g = newG;
+								neighborState.parent = current;
+								neighborState.inOpenSet = true;
+								m_openSet.Push(neighbor);
+						}
+						else if (newG < neighborState.g)
+						{
+								neighborState.g = newG;
+								neighborState.parent = current;
+								m_openSet.Update(neighbor);
+						}
+				}
+		}
+
+		for (size_t i = 0; i < _goals.size(); i++)
+		{
+				if (_goals[i] == -1 || !_context.Visit(_goals[i]).inClosedSet)
+				{
+						continue;
+				}
+				if (_goals[i] == nearest && _goalIndex == -1)
+				{
+						_goalIndex = static_cast<int>(i);
+				}
+				if (_costs)
+				{
+						(*_costs)[i] = _context.At(_goals[i]).g;
+				}
+		}
+		return nearest == -1 ? EMPTY_VECTOR : Backtrace(_start, nearest, _context);
+}
+
+std::vector<int> PathFinder::BiAStar(int _start, int _end, const Grid & _grid, const Diagonal & _diagonal, SearchContext & _context)
+{
+		const Heuristic heuristic = SelectHeuristic(_diagonal);
+		_context.Begin(_grid.GetNumNodes());
+
+		IndexedHeap<ComparePriority>& m_startOpenSet = _context.GetOpenSet();
+		IndexedHeap<ComparePriority>& m_endOpenSet = _context.GetReverseOpenSet();
+		Grid::NeighborList neighbors;
+
+		const glm::ivec2 startCoord = _grid.GetCoord(_start);
+		const glm::ivec2 endCoord = _grid.GetCoord(_end);
+		if (!_grid.IsWalkable(_start) || !_grid.IsWalkable(_end) || _start == _end)
+		{
+				return EMPTY_VECTOR;
+		}
+
+		SearchNode& startState = _context.Visit(_start);
+		startState.h = heuristic(startCoord, endCoord);
+		startState.inOpenSet = true;
+		m_startOpenSet.Push(_start);
+		SearchNode& endState = _context.Visit(_end);
+		endState.h = startState.h;
+		endState.inOpenSet = true;
+		endState.reverse = true;
+		m_endOpenSet.Push(_end);
+
+		int meetStart = -1;
+		int meetEnd = -1;
+		//expands the best node of one side towards _target, true if it touched an open node of the other side
+		auto expand = [&](IndexedHeap<ComparePriority>& _openSet, bool _reverse, const glm::ivec2& _target)
+		{
+				const int current = _openSet.Front();
+				SearchNode& currentState = _context.At(current);
+				const glm::ivec2 currentCoord = _grid.GetCoord(current);
+				currentState.inOpenSet = false;
+				_openSet.Pop();
+				currentState.inClosedSet = true;
+
+				_grid.GetNeighbors(current, _diagonal, neighbors);
+				for (int neighbor : neighbors)
+				{
+						SearchNode& neighborState = _context.Visit(neighbor);
+						if (neighborState.inClosedSet)
+						{
+								continue;
+						}
+						if (neighborState.inOpenSet && neighborState.reverse != _reverse)
+						{
+								//the searches met
+								meetStart = _reverse ? neighbor : current;
+								meetEnd = _reverse ? current : neighbor;
+								return true;
+						}
+
+						const glm::ivec2 neighborCoord = _grid.GetCoord(neighbor);
+						//the search from the end walks the path backwards, so a step costs the terrain of the node it comes from
+						const int newG = currentState.g + heuristic(currentCoord, neighborCoord) +
+								(_reverse ? _grid.GetTerrainCost(current) : _grid.GetTerrainCost(neighbor));
+						if (!neighborState.inOpenSet)
+						{
+								neighborState.g = newG;
+								neighborState.h = heuristic(neighborCoord, _target);
+								neighborState.parent = current;
+								neighborState.inOpenSet = true;
+								neighborState.reverse = _reverse;
+								_openSet.Push(neighbor);
+						}
+						else if (newG < neighborState.g)
+						{
+								neighborState.g = newG;
+								neighborState.parent = current;
+								_openSet.Update(neighbor);
+						}
+				}
+				return false;
+		};
+
+		while (!m_startOpenSet.IsEmpty() && !m_endOpenSet.IsEmpty())
+		{
+				if (expand(m_startOpenSet, false, endCoord) || expand(m_endOpenSet, true, startCoord))
+				{
+						return BiBacktrace(_start, meetStart, meetEnd, _context);
+				}
+		}
+		return EMPTY_VECTOR;
+}
+
+//Greedy Best-First Search
+std::vector<int> PathFinder::GreedyBFirst(int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context)
+{
+		const Heuristic heuristic = SelectHeuristic(_diagonal);
 		unsigned char counter = 0;
-		_grid.lock()->CleanGrid();
+		_context.Begin(_grid.GetNumNodes());
 
-		std::weak_ptr<Node> m_startNode;
-		std::weak_ptr<Node> m_endNode;
-		Heap<std::weak_ptr<Node>, std::vector<std::weak_ptr<Node>>, ComparePriority> m_openSet;
-		std::vector<std::weak_ptr<Node>> m_closedSet;
+		Heap<int, std::vector<int>, ComparePriority> m_openSet{ std::vector<int>(), ComparePriority(_context.GetNodes()) };
+		Grid::NeighborList neighbors;
 
-		m_startNode = _grid.lock()->GetNodeAt(_start);
-		m_endNode = _grid.lock()->GetNodeAt(_end);
-		if (!m_startNode.lock()->walkable || !m_endNode.lock()->walkable)
+		const glm::ivec2 startCoord = _grid.GetCoord(_start);
+		const glm::ivec2 endCoord = _grid.GetCoord(_end);
+		if (!_grid.IsWalkable(_start) || !_grid.IsWalkable(_end))
 		{
 				return EMPTY_VECTOR;
 		}
 
-		m_startNode.lock()->h = m_heuristic(m_startNode.lock()->nodeIndex, m_endNode.lock()->nodeIndex);
-		m_startNode.lock()->inOpenSet = true;
-		m_openSet.Push(m_startNode);
+		SearchNode& startState = _context.Visit(_start);
+		startState.h = heuristic(startCoord, endCoord);
+		startState.inOpenSet = true;
+		m_openSet.Push(_start);
 
 		while (!m_openSet.IsEmpty())
 		{
-				std::weak_ptr<Node> currentNode = m_openSet.Front();
-				currentNode.lock()->inOpenSet = false;
+				const int current = m_openSet.Front();
+				SearchNode& currentState = _context.At(current);
+				currentState.inOpenSet = false;
 				m_openSet.Pop();
 
-				currentNode.lock()->inClosedSet = true;
-				m_closedSet.push_back(currentNode);
+				currentState.inClosedSet = true;
 
 				//check if the end was found
-				if (currentNode.lock() == m_endNode.lock())
+				if (current == _end)
 				{
-						std::vector<glm::vec2> result = Backtrace(m_startNode, m_endNode);
-						//result = CompressPath(result);
-						return result;
+						return Backtrace(_start, _end, _context);
 				}
 
 				//get all the walkable neightbors
-				for (auto neighbor : _grid.lock()->GetNeighbors(currentNode, _diagonal))
+				_grid.GetNeighbors(current, _diagonal, neighbors);
+				for (int neighbor : neighbors)
 				{
+						SearchNode& neighborState = _context.Visit(neighbor);
+						const glm::ivec2 neighborCoord = _grid.GetCoord(neighbor);
 						//check if the neighbor has already been checked (in closed list)
-						if (neighbor.lock()->inClosedSet || neighbor.lock()->inOpenSet)
+						if (neighborState.inClosedSet || neighborState.inOpenSet)
 						{
 								continue;
 						}
-						neighbor.lock()->h = m_heuristic(neighbor.lock()->nodeIndex, m_endNode.lock()->nodeIndex);
-						neighbor.lock()->parent = currentNode;
-						neighbor.lock()->inOpenSet = true;
+						neighborState.h = heuristic(neighborCoord, endCoord);
+						neighborState.parent = current;
+						neighborState.inOpenSet = true;
 						m_openSet.Push(neighbor);
 				}
 				counter++;
 				if (counter > MAX_ITERATIONS)
 				{
-						std::vector<glm::vec2> result = Backtrace(m_startNode, currentNode);
-						//result = CompressPath(result);
-						return result;
+						return Backtrace(_start, current, _context);
 				}
 		}
 		return EMPTY_VECTOR;
 }
 
-int PathFinder::ManhattanDistance(const glm::ivec2& _nodeAIndex, const glm::ivec2& _nodeBIndex)
+std::vector<int> PathFinder::JumpPoint(int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context)
 {
-		int distanceX = abs(_nodeAIndex.x - _nodeBIndex.x);
-		int distanceY = abs(_nodeAIndex.y - _nodeBIndex.y);
+		//the pruning rules are only optimal if every step costs the same
+		if (!_grid.HasUniformTerrainCost())
+		{
+				return AStar(_start, _end, _grid, _diagonal, _context);
+		}
+
+		const Heuristic heuristic = SelectHeuristic(_diagonal);
+		_context.Begin(_grid.GetNumNodes());
+
+		IndexedHeap<ComparePriority>& m_openSet = _context.GetOpenSet();
+		Grid::NeighborList neighbors;
+		std::vector<glm::ivec2> directions;
+
+		const glm::ivec2 startCoord = _grid.GetCoord(_start);
+		const glm::ivec2 endCoord = _grid.GetCoord(_end);
+		if (!_grid.IsWalkable(_start) || !_grid.IsWalkable(_end))
+		{
+				return EMPTY_VECTOR;
+		}
+		//the cost every node adds when it is stepped on
+		const int stepCost = _grid.GetTerrainCost(_start);
+
+		SearchNode& startState = _context.Visit(_start);
+		startState.h = heuristic(startCoord, endCoord);
+		startState.inOpenSet = true;
+		m_openSet.Push(_start);
+
+		while (!m_openSet.IsEmpty())
+		{
+				const int current = m_openSet.Front();
+				SearchNode& currentState = _context.At(current);
+				const glm::ivec2 currentCoord = _grid.GetCoord(current);
+				currentState.inOpenSet = false;
+				m_openSet.Pop();
+
+				currentState.inClosedSet = true;
+
+				//check if the end was found
+				if (current == _end)
+				{
+						return ExpandJumpPath(_start, Backtrace(_start, _end, _context), _grid);
+				}
+
+				//the start has no parent to prune against, so it searches in the direction of all its neighbors
+				directions.clear();
+				if (currentState.parent == -1)
+				{
+						_grid.GetNeighbors(current, _diagonal, neighbors);
+						for (int neighbor : neighbors)
+						{
+								directions.push_back(_grid.GetCoord(neighbor) - currentCoord);
+						}
+				}
+				else
+				{
+						FindJumpDirections(currentCoord, _grid.GetCoord(currentState.parent), _grid, _diagonal, directions);
+				}
+
+				for (const glm::ivec2& direction : directions)
+				{
+						const int jumpPoint = Jump(currentCoord, direction, _end, _grid, _diagonal);
+						if (jumpPoint == -1)
+						{
+								continue;
+						}
+						SearchNode& jumpState = _context.Visit(jumpPoint);
+						if (jumpState.inClosedSet)
+						{
+								continue;
+						}
+						const glm::ivec2 jumpCoord = _grid.GetCoord(jumpPoint);
+						//the jump is a straight or diagonal line, so its length in steps is the longer axis
+						const glm::ivec2 delta = glm::abs(jumpCoord - currentCoord);
+						const int newG = currentState.g + heuristic(currentCoord, jumpCoord) + stepCost * std::max(delta.x, delta.y);
+
+						if (!jumpState.inOpenSet)
+						{
+								jumpState.g = newG;
+								jumpState.h = heuristic(jumpCoord, endCoord);
+								jumpState.parent = current;
+								jumpState.inOpenSet = true;
+								m_openSet.Push(jumpPoint);
+						}
+						else if (newG < jumpState.g)
+						{
+								jumpState.g = newG;
+								jumpState.parent = current;
+								m_openSet.Update(jumpPoint);
+						}
+				}
+		}
+		return EMPTY_VECTOR;
+}
+
+void PathFinder::FindJumpDirections(const glm::ivec2& _node, const glm::ivec2& _parent, const Grid& _grid, const Diagonal& _diagonal, std::vector<glm::ivec2>& _directions)
+{
+		//the natural neighbors in the direction of travel and the forced ones next to blocked nodes, the rest is reached faster through another path
+		const int x = _node.x;
+		const int y = _node.y;
+		const int dx = glm::sign(x - _parent.x);
+		const int dy = glm::sign(y - _parent.y);
+		auto walkable = [&_grid](int _x, int _y) { return _grid.IsWalkableAt(glm::ivec2(_x, _y)); };
+		auto add = [&_directions](int _dx, int _dy) { _directions.emplace_back(_dx, _dy); };
+
+		switch (_diagonal)
+		{
+				case Diagonal::ALWAYS:
+				{
+						if (dx != 0 && dy != 0)
+						{
+								add(0, dy);
+								add(dx, 0);
+								add(dx, dy);
+								if (!walkable(x - dx, y)) { add(-dx, dy); }
+								if (!walkable(x, y - dy)) { add(dx, -dy); }
+						}
+						else if (dx == 0)
+						{
+								add(0, dy);
+								if (!walkable(x + 1, y)) { add(1, dy); }
+								if (!walkable(x - 1, y)) { add(-1, dy); }
+						}
+						else
+						{
+								add(dx, 0);
+								if (!walkable(x, y + 1)) { add(dx, 1); }
+								if (!walkable(x, y - 1)) { add(dx, -1); }
+						}
+						break;
+				}
+				case Diagonal::NEVER:
+				{
+						if (dx != 0)
+						{
+								add(dx, 0);
+								add(0, 1);
+								add(0, -1);
+						}
+						else
+						{
+								add(0, dy);
+								add(1, 0);
+								add(-1, 0);
+						}
+						break;
+				}
+				case Diagonal::IFNOWALLS:
+				{
+						if (dx != 0 && dy != 0)
+						{
+								add(0, dy);
+								add(dx, 0);
+								if (walkable(x, y + dy) && walkable(x + dx, y)) { add(dx, dy); }
+						}
+						else if (dx != 0)
+						{
+								const bool top = walkable(x, y + 1);
+								const bool bottom = walkable(x, y - 1);
+								add(dx, 0);
+								if (walkable(x + dx, y))
+								{
+										if (top) { add(dx, 1); }
+										if (bottom) { add(dx, -1); }
+								}
+								if (top) { add(0, 1); }
+								if (bottom) { add(0, -1); }
+						}
+						else
+						{
+								const bool right = walkable(x + 1, y);
+								const bool left = walkable(x - 1, y);
+								add(0, dy);
+								if (walkable(x, y + dy))
+								{
+										if (right) { add(1, dy); }
+										if (left) { add(-1, dy); }
+								}
+								if (right) { add(1, 0); }
+								if (left) { add(-1, 0); }
+						}
+						break;
+				}
+				case Diagonal::IFLESSTHANTWOWALLS:
+				{
+						if (dx != 0 && dy != 0)
+						{
+								const bool vertical = walkable(x, y + dy);
+								const bool horizontal = walkable(x + dx, y);
+								add(0, dy);
+								add(dx, 0);
+								if (vertical || horizontal) { add(dx, dy); }
+								if (!walkable(x - dx, y) && vertical) { add(-dx, dy); }
+								if (!walkable(x, y - dy) && horizontal) { add(dx, -dy); }
+						}
+						else if (dx == 0)
+						{
+								if (walkable(x, y + dy))
+								{
+										add(0, dy);
+										if (!walkable(x + 1, y)) { add(1, dy); }
+										if (!walkable(x - 1, y)) { add(-1, dy); }
+								}
+						}
+						else
+						{
+								if (walkable(x + dx, y))
+								{
+										add(dx, 0);
+										if (!walkable(x, y + 1)) { add(dx, 1); }
+										if (!walkable(x, y - 1)) { add(dx, -1); }
+								}
+						}
+						break;
+				}
+				default:
+						//error
+						break;
+		}
+}
+
+int PathFinder::Jump(const glm::ivec2& _from, const glm::ivec2& _direction, int _end, const Grid& _grid, const Diagonal& _diagonal)
+{
+		const int dx = _direction.x;
+		const int dy = _direction.y;
+		auto walkable = [&_grid](int _x, int _y) { return _grid.IsWalkableAt(glm::ivec2(_x, _y)); };
+
+		//walk in the direction until a node with a forced neighbor (a jump point), a wall or the end is hit
+		glm::ivec2 position = _from + _direction;
+		while (true)
+		{
+				const int x = position.x;
+				const int y = position.y;
+				if (!walkable(x, y))
+				{
+						return -1;
+				}
+				const int index = _grid.GetIndex(position);
+				if (index == _end)
+				{
+						return index;
+				}
 
-		return 10 * (distanceX + distanceY);
+				if (dx != 0 && dy != 0)
+				{
+						//moving diagonally: forced neighbors appear behind the walls the line passes
+						if (_diagonal == Diagonal::ALWAYS || _diagonal == Diagonal::IFLESSTHANTWOWALLS)
+						{
+								if ((walkable(x - dx, y + dy) && !walkable(x - dx, y)) ||
+										(walkable(x + dx, y - dy) && !walkable(x, y - dy)))
+								{
+										return index;
+								}
+						}
+						//and a node is a jump point if one of the straight lines out of it finds one
+						if (Jump(position, glm::ivec2(dx, 0), _end, _grid, _diagonal) != -1 ||
+								Jump(position, glm::ivec2(0, dy), _end, _grid, _diagonal) != -1)
+						{
+								return index;
+						}
+				}
+				else if (_diagonal == Diagonal::IFNOWALLS || _diagonal == Diagonal::NEVER)
+				{
+						//without corner cutting, the forced neighbors are the sides that open up after a wall
+						if (dx != 0)
+						{
+								if ((walkable(x, y - 1) && !walkable(x - dx, y - 1)) ||
+										(walkable(x, y + 1) && !walkable(x - dx, y + 1)))
+								{
+										return index;
+								}
+						}
+						else
+						{
+								if ((walkable(x - 1, y) && !walkable(x - 1, y - dy)) ||
+										(walkable(x + 1, y) && !walkable(x + 1, y - dy)))
+								{
+										return index;
+								}
+								//with only straight moves, the horizontal lines have to be checked while moving vertically
+								if (_diagonal == Diagonal::NEVER &&
+										(Jump(position, glm::ivec2(1, 0), _end, _grid, _diagonal) != -1 ||
+										Jump(position, glm::ivec2(-1, 0), _end, _grid, _diagonal) != -1))
+								{
+										return index;
+								}
+						}
+				}
+				else if (dx != 0)
+				{
+						if ((walkable(x + dx, y + 1) && !walkable(x, y + 1)) ||
+								(walkable(x + dx, y - 1) && !walkable(x, y - 1)))
+						{
+								return index;
+						}
+				}
+				else
+				{
+						if ((walkable(x + 1, y + dy) && !walkable(x + 1, y)) ||
+								(walkable(x - 1, y + dy) && !walkable(x - 1, y)))
+						{
+								return index;
+						}
+				}
+
+				//check that the next diagonal step is allowed by the movement rule
+				if (dx != 0 && dy != 0)
+				{
+						if (_diagonal == Diagonal::IFNOWALLS && !(walkable(x + dx, y) && walkable(x, y + dy)))
+						{
+								return -1;
+						}
+						if (_diagonal == Diagonal::IFLESSTHANTWOWALLS && !(walkable(x + dx, y) || walkable(x, y + dy)))
+						{
+								return -1;
+						}
+				}
+				position += _direction;
+		}
+}
+
+std::vector<int> PathFinder::ExpandJumpPath(int _start, const std::vector<int>& _jumpPoints, const Grid& _grid)
+{
+		//fill in the nodes between the jump points, every segment is a straight or diagonal line
+		std::vector<int> path;
+		for (size_t i = 0; i < _jumpPoints.size(); i++)
+		{
+				const glm::ivec2 from = _grid.GetCoord(_jumpPoints[i]);
+				const glm::ivec2 to = _grid.GetCoord(i + 1 < _jumpPoints.size() ? _jumpPoints[i + 1] : _start);
+				const glm::ivec2 step = glm::sign(to - from);
+				for (glm::ivec2 position = from; position != to; position += step)
+				{
+						path.push_back(_grid.GetIndex(position));
+				}
+		}
+		return path;
+}
+
+PathFinder::Heuristic PathFinder::SelectHeuristic(const Diagonal& _diagonal)
+{
+		if (_diagonal == Diagonal::NEVER)
+		{
+				return ManhattanDistance;
+		}
+		return OctileDistance;
+}
+
+int PathFinder::ManhattanDistance(const glm::ivec2& _nodeAIndex, const glm::ivec2& _nodeBIndex)
+{
+		return ManhattanHeuristic()(_nodeAIndex, _nodeBIndex);
 }
 
 int PathFinder::EuclideanDistance(const glm::ivec2 & _nodeAIndex, const glm::ivec2 & _nodeBIndex)
@@ -608,35 +1269,54 @@ int PathFinder::EuclideanDistance(const glm::ivec2 & _nodeAIndex, const glm::ive
 }
 
 int PathFinder::OctileDistance(const glm::ivec2 & _nodeAIndex, const glm::ivec2 & _nodeBIndex)
+{
+		return OctileHeuristic()(_nodeAIndex, _nodeBIndex);
+}
+
+int PathFinder::ChebyshevDistance(const glm::ivec2 & _nodeAIndex, const glm::ivec2 & _nodeBIndex)
 {
 		int distanceX = abs(_nodeAIndex.x - _nodeBIndex.x);
 		int distanceY = abs(_nodeAIndex.y - _nodeBIndex.y);
+		return 10 * (distanceX + distanceY) + (10 - 2 * 10) * std::min(distanceX, distanceY);
+}
 
-		if (distanceX > distanceY)
+std::vector<int> PathFinder::Backtrace(int _startNode, int _endNode, const SearchContext& _context)
+{
+		//create the vector of node indices and push the current (last) node
+		std::vector<int> path;
+		int currentNode = _endNode;
+		while (currentNode != _startNode)
 		{
-				return 14 * distanceY + 10 * (distanceX - distanceY);
+				path.push_back(currentNode);
+				currentNode = _context.At(currentNode).parent;
 		}
-		return 14 * distanceX + 10 * (distanceY - distanceX);
+		//std::reverse(path.begin(), path.end());
+		return path;
 }
 
-int PathFinder::ChebyshevDistance(const glm::ivec2 & _nodeAIndex, const glm::ivec2 & _nodeBIndex)
+std::vector<int> PathFinder::BiBacktrace(int _startNode, int _meetStart, int _meetEnd, const SearchContext & _context)
 {
-		int distanceX = abs(_nodeAIndex.x - _nodeBIndex.x);
-		int distanceY = abs(_nodeAIndex.y - _nodeBIndex.y);
-		return 10 * (distanceX + distanceY) + (10 - 2 * 10) * std::min(distanceX, distanceY);
+		//the parents of the end's search lead from the meeting point to the end, reversed they are the first part of the path (which runs from the end)
+		std::vector<int> path;
+		for (int currentNode = _meetEnd; currentNode != -1; currentNode = _context.At(currentNode).parent)
+		{
+				path.push_back(currentNode);
+		}
+		std::reverse(path.begin(), path.end());
+
+		const std::vector<int> startPart = Backtrace(_startNode, _meetStart, _context);
+		path.insert(path.end(), startPart.begin(), startPart.end());
+		return path;
 }
 
-std::vector<glm::vec2> PathFinder::Backtrace(std::weak_ptr<Node> _startNode, std::weak_ptr<Node> _endNode)
+std::vector<glm::vec2> PathFinder::ToWorldPath(const std::vector<int>& _path, const Grid& _grid)
 {
-		//create the vector of glm::vec2 coordinates and push the current (last) coordinate
 		std::vector<glm::vec2> path;
-		std::weak_ptr<Node> currentNode = _endNode;
-		while (currentNode.lock() != _startNode.lock())
+		path.reserve(_path.size());
+		for (int node : _path)
 		{
-				path.push_back(currentNode.lock()->worldPos);
-				currentNode = currentNode.lock()->parent;
+				path.push_back(_grid.GetWorldPos(node));
 		}
-		//std::reverse(path.begin(), path.end());
 		return path;
 }
 
@@ -718,18 +1398,102 @@ std::vector<glm::vec2> PathFinder::CompressPath(const std::vector<glm::vec2>& _p
 				return _path;
 		}
 
-		std::vector<glm::vec2> waypoints(_path.size());
-		glm::vec2 directionOld{ 0.0f, 0.0f };
+		std::vector<glm::vec2> waypoints{ _path.front() };
+		for (size_t i = 1; i < _path.size() - 1; i++)
+		{
+				//only keep the node if the path turns there (the steps aren't parallel, or they point in opposite ways)
+				const glm::vec2 directionOld = _path[i] - _path[i - 1];
+				const glm::vec2 directionNew = _path[i + 1] - _path[i];
+				if (directionOld.x * directionNew.y != directionOld.y * directionNew.x || glm::dot(directionOld, directionNew) <= 0.0f)
+				{
+						waypoints.push_back(_path[i]);
+				}
+		}
+		waypoints.push_back(_path.back());
+
+		return waypoints;
+}
+
+std::vector<glm::vec2> PathFinder::SmoothenPath(const glm::vec2& _start, const std::vector<glm::vec2>& _path, const Grid& _grid)
+{
+		if (_path.size() < 2)
+		{
+				return _path;
+		}
+
+		//walk the path from the start, only the turns are candidates for the waypoints
+		std::vector<glm::vec2> points{ _start };
+		points.insert(points.end(), _path.rbegin(), _path.rend());
+		points = CompressPath(points);
 
-		for (size_t i = 1; i < _path.size(); i++)
+		std::vector<glm::ivec2> coords;
+		coords.reserve(points.size());
+		for (const glm::vec2& point : points)
 		{
-				glm::vec2 directionNew = glm::normalize(glm::vec2(_path.at(i - 1).x - _path.at(i).x, _path.at(i - 1).y - _path.at(i).y));
-				if (directionNew != directionOld)
+				coords.push_back(_grid.GetCoord(_grid.GetIndexAt(point)));
+		}
+
+		//skip every point the last kept one can see past
+		std::vector<glm::vec2> waypoints;
+		size_t anchor = 0;
+		for (size_t i = 1; i < points.size(); i++)
+		{
+				if (i + 1 < points.size() && HasLineOfSight(coords[anchor], coords[i + 1], _grid))
 				{
-						waypoints.push_back(_path.at(i));
+						continue;
 				}
-				directionOld = directionNew;
+				waypoints.push_back(points[i]);
+				anchor = i;
 		}
+		//back to the order of the searches, the end first
+		std::reverse(waypoints.begin(), waypoints.end());
 
 		return waypoints;
+}
+
+bool PathFinder::HasLineOfSight(const glm::ivec2& _from, const glm::ivec2& _to, const Grid& _grid)
+{
+		const int numX = std::abs(_to.x - _from.x);
+		const int numY = std::abs(_to.y - _from.y);
+		const int stepX = _to.x > _from.x ? 1 : -1;
+		const int stepY = _to.y > _from.y ? 1 : -1;
+
+		glm::ivec2 coord{ _from };
+		if (!_grid.IsWalkable(_grid.GetIndex(coord)))
+		{
+				return false;
+		}
+		for (int x = 0, y = 0; x < numX || y < numY;)
+		{
+				//which node edge the line crosses next, the vertical or the horizontal one (scaled by 2 * numX * numY, so it stays integer)
+				const int decision = (1 + 2 * x) * numY - (1 + 2 * y) * numX;
+				if (decision == 0)
+				{
+						//exactly through a corner, so the line touches both nodes next to it
+						if (!_grid.IsWalkable(_grid.GetIndex(glm::ivec2(coord.x + stepX, coord.y))) ||
+								!_grid.IsWalkable(_grid.GetIndex(glm::ivec2(coord.x, coord.y + stepY))))
+						{
+								return false;
+						}
+						coord.x += stepX;
+						coord.y += stepY;
+						x++;
+						y++;
+				}
+				else if (decision < 0)
+				{
+						coord.x += stepX;
+						x++;
+				}
+				else
+				{
+						coord.y += stepY;
+						y++;
+				}
+				if (!_grid.IsWalkable(_grid.GetIndex(coord)))
+				{
+						return false;
+				}
+		}
+		return true;
 }
\ No newline at end of file
@@ -2,30 +2,131 @@
 
 #include "Grid.h"
 #include "Heap.h"
+#include "SearchContext.h"
+#include "HierarchicalGrid.h"
+#include "LandmarkTable.h"
 
+#include <cstdlib>
 #include <functional>
-#include <unordered_set>
+
+/** \brief The heuristics of the searches as functors, so a search templated on one gets the call inlined */
+struct ManhattanHeuristic
+{
+		int operator()(const glm::ivec2& _nodeAIndex, const glm::ivec2& _nodeBIndex) const noexcept
+		{
+				return 10 * (std::abs(_nodeAIndex.x - _nodeBIndex.x) + std::abs(_nodeAIndex.y - _nodeBIndex.y));
+		}
+};
+
+struct OctileHeuristic
+{
+		int operator()(const glm::ivec2& _nodeAIndex, const glm::ivec2& _nodeBIndex) const noexcept
+		{
+				const int distanceX = std::abs(_nodeAIndex.x - _nodeBIndex.x);
+				const int distanceY = std::abs(_nodeAIndex.y - _nodeBIndex.y);
+				return distanceX > distanceY ? 14 * distanceY + 10 * (distanceX - distanceY) : 14 * distanceX + 10 * (distanceY - distanceX);
+		}
+};
+
+/** \brief The heuristic PathFinder::SelectHeuristic picks for a diagonal mode, at compile time */
+template <Diagonal D>
+struct DiagonalHeuristic
+{
+		using Type = OctileHeuristic;
+};
+
+template <>
+struct DiagonalHeuristic<Diagonal::NEVER>
+{
+		using Type = ManhattanHeuristic;
+};
 
 /** \brief The pathfinder class to contain the algorithms */
 class PathFinder
 {
+		friend class AStarQuery;
+
 public:
 		PathFinder();
 		~PathFinder();
 
-		/** \brief All pathfinding algorithms this finder supports.
+		/** \brief All pathfinding algorithms this finder supports (they use the finder's own SearchContext, so one query at a time).
 		 *  \param _start				- start position in world space 
 			*  \param _end				 	- end position in world space 
 			*  \param _grid				 - the grid to be used 
 			*  \param _diagonal - state of diagonal allowing */
 
-		std::vector<glm::vec2> AStar						 (const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<Grid> _grid, const Diagonal& _diagonal);
-		std::vector<glm::vec2> AStarEpsilon(const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<Grid> _grid, const Diagonal& _diagonal);
-		std::vector<glm::vec2> BestFirst		 (const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<Grid> _grid, const Diagonal& _diagonal);
-		std::vector<glm::vec2> BreadthFirst(const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<Grid> _grid, const Diagonal& _diagonal);
-		std::vector<glm::vec2> DepthFirst  (const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<Grid> _grid, const Diagonal& _diagonal);
-		std::vector<glm::vec2> Dijkstra    (const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<Grid> _grid, const Diagonal& _diagonal);
-		std::vector<glm::vec2> GreedyBFirst(const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<Grid> _grid, const Diagonal& _diagonal);
+		std::vector<glm::vec2> AStar						 (const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<const Grid> _grid, const Diagonal& _diagonal);
+		std::vector<glm::vec2> AStarEpsilon(const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<const Grid> _grid, const Diagonal& _diagonal);
+		std::vector<glm::vec2> BestFirst		 (const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<const Grid> _grid, const Diagonal& _diagonal);
+		std::vector<glm::vec2> BreadthFirst(const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<const Grid> _grid, const Diagonal& _diagonal);
+		std::vector<glm::vec2> DepthFirst  (const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<const Grid> _grid, const Diagonal& _diagonal);
+		std::vector<glm::vec2> Dijkstra    (const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<const Grid> _grid, const Diagonal& _diagonal);
+		std::vector<glm::vec2> GreedyBFirst(const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<const Grid> _grid, const Diagonal& _diagonal);
+		std::vector<glm::vec2> JumpPoint   (const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<const Grid> _grid, const Diagonal& _diagonal);
+		std::vector<glm::vec2> BiAStar       (const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<const Grid> _grid, const Diagonal& _diagonal);
+		std::vector<glm::vec2> BiBreadthFirst(const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<const Grid> _grid, const Diagonal& _diagonal);
+		/** \brief HPA* on the hierarchy (with the diagonal movement it was built for) */
+		std::vector<glm::vec2> Hierarchical(const glm::vec2& _start, const glm::vec2& _end, std::weak_ptr<HierarchicalGrid> _hierarchy);
+		/** \brief The paths from every start to the same end, see the index version */
+		std::vector<std::vector<glm::vec2>> DijkstraToGoal(const std::vector<glm::vec2>& _starts, const glm::vec2& _end, std::weak_ptr<const Grid> _grid, const Diagonal& _diagonal);
+		/** \brief The path to the nearest of the goals, see the index version (the goals outside of the grid are never reached) */
+		std::vector<glm::vec2> DijkstraToNearest(const glm::vec2& _start, const std::vector<glm::vec2>& _goals, std::weak_ptr<const Grid> _grid, const Diagonal& _diagonal,
+				int& _goalIndex, std::vector<int>* _costs = nullptr);
+
+		/** \brief The same algorithms on the flat node indices of the grid (see Grid::GetIndexAt), without any world space conversions.
+			*  They only read the grid and keep their state in _context, so queries with different contexts can run concurrently.
+			*  AStar runs an AStarQuery to the end, use one directly to spread a search over several frames
+			*  \return the node indices of the path from the end to (not including) the start, empty if there is no path */
+		std::vector<int> AStar       (int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context);
+		std::vector<int> AStarEpsilon(int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context);
+		std::vector<int> BestFirst   (int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context);
+		std::vector<int> BreadthFirst(int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context);
+		std::vector<int> DepthFirst  (int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context);
+		std::vector<int> Dijkstra    (int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context);
+		std::vector<int> GreedyBFirst(int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context);
+		/** \brief Jump Point Search: A* which only expands the nodes where the direction of an optimal path can change.
+			*  It needs uniform terrain costs and falls back to AStar otherwise, the returned path has every node like the others */
+		std::vector<int> JumpPoint   (int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context);
+		/** \brief Bidirectional A* and breadth first search: one search from each end, taking turns, until they meet.
+			*  They save the most where a one sided search floods (BFS, or A* behind obstacles),
+			*  but stop at the first meeting, so the path isn't always the shortest */
+		std::vector<int> BiAStar       (int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context);
+		std::vector<int> BiBreadthFirst(int _start, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context);
+		/** \brief One reverse Dijkstra from _end until every start is reached, so many agents heading for the same node
+			*  share a single search. The paths are optimal like Dijkstra's, one per start in the same order */
+		std::vector<std::vector<int>> DijkstraToGoal(const std::vector<int>& _starts, int _end, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context);
+		/** \brief One Dijkstra from _start which stops at the first of the goals it closes, so picking the nearest of N candidates
+			*  (cover, waypoints) is one search instead of N. With _costs it carries on until every goal is closed instead
+			*  \param _goalIndex - set to the index in _goals of the nearest goal, -1 if none can be reached
+			*  \param _costs - if given, filled with the cost from the start to every goal in the same order (-1 for the unreachable ones)
+			*  \return the path to the nearest goal like the others return it, empty if there is none or the start is the goal */
+		std::vector<int> DijkstraToNearest(int _start, const std::vector<int>& _goals, const Grid& _grid, const Diagonal& _diagonal, SearchContext& _context,
+				int& _goalIndex, std::vector<int>* _costs = nullptr);
+
+		/** \brief Converts a path of node indices to the world positions of the nodes */
+		static std::vector<glm::vec2> ToWorldPath(const std::vector<int>& _path, const Grid& _grid);
+
+		/** \brief Post-processing of a found path (from the end to, not including, the start like the searches return them)
+			*  CompressPath only keeps the nodes where the direction changes (and the end).
+			*  SmoothenPath compresses the path and then pulls it straight: a waypoint is dropped whenever the one before it can see the one after it,
+			*  so the agents walk straight lines instead of staircases. The shortcuts never cut a wall corner, whatever the diagonal rule of the search */
+		static std::vector<glm::vec2> CompressPath(const std::vector<glm::vec2>& _path);
+		static std::vector<glm::vec2> SmoothenPath(const glm::vec2& _start, const std::vector<glm::vec2>& _path, const Grid& _grid);
+		/** \brief Check if the straight line between the centers of two nodes only crosses walkable nodes
+			*  (both nodes of a corner it passes exactly through have to be walkable too), integer only Bresenham style walk */
+		static bool HasLineOfSight(const glm::ivec2& _from, const glm::ivec2& _to, const Grid& _grid);
+
+		using Heuristic = int(*)(const glm::ivec2& _nodeAIndex, const glm::ivec2& _nodeBIndex);
+		static Heuristic SelectHeuristic(const Diagonal& _diagonal); ///< Manhattan without diagonals, Octile with them
+
+		/** \brief The container of the open set of AStar (and the AStarQuery it runs) and of Dijkstra, the binary heap by default */
+		void SetAStarOpenSet(OpenSet _openSet) noexcept { m_aStarOpenSet = _openSet; }
+		void SetDijkstraOpenSet(OpenSet _openSet) noexcept { m_dijkstraOpenSet = _openSet; }
+		OpenSet GetAStarOpenSet() const noexcept { return m_aStarOpenSet; }
+		OpenSet GetDijkstraOpenSet() const noexcept { return m_dijkstraOpenSet; }
+		/** \brief The landmark distances AStar bounds its heuristic with (see LandmarkTable), for the queries on their grid and movement */
+		void SetLandmarks(std::weak_ptr<const LandmarkTable> _landmarks) { m_landmarks = _landmarks; }
 
 private:
 		/* Heuristics */
@@ -35,15 +136,25 @@ private:
 		static int ChebyshevDistance(const glm::ivec2& _nodeAIndex, const glm::ivec2& _nodeBIndex);
 
 		/* Utils */
-		std::vector<glm::vec2> Backtrace   (std::weak_ptr<Node> _startNode, std::weak_ptr<Node> _endNode);
+		static std::vector<int> Backtrace  (int _startNode, int _endNode, const SearchContext& _context);
+		/** \brief The path of a bidirectional search, _meetStart was reached from the start and _meetEnd (its neighbor) from the end */
+		static std::vector<int> BiBacktrace(int _startNode, int _meetStart, int _meetEnd, const SearchContext& _context);
+		/** \brief Dijkstra specialized on the diagonal mode (the neighbors and the step costs), with the open set of m_dijkstraOpenSet */
+		template <Diagonal D>
+		std::vector<int> Dijkstra(int _start, int _end, const Grid& _grid, SearchContext& _context);
+		template <Diagonal D, class HeuristicType, class OpenSetType>
+		static std::vector<int> DijkstraSearch(int _start, int _end, const Grid& _grid, SearchContext& _context, OpenSetType& _openSet);
+		/* Jump Point Search */
+		static int  Jump              (const glm::ivec2& _from, const glm::ivec2& _direction, int _end, const Grid& _grid, const Diagonal& _diagonal); ///< the next jump point in _direction, -1 for none
+		static void FindJumpDirections(const glm::ivec2& _node, const glm::ivec2& _parent, const Grid& _grid, const Diagonal& _diagonal, std::vector<glm::ivec2>& _directions); ///< the pruned directions to search from _node
+		static std::vector<int> ExpandJumpPath(int _start, const std::vector<int>& _jumpPoints, const Grid& _grid); ///< adds the nodes between the jump points
 		std::vector<glm::vec2> Interpolate (const glm::vec2& _startCoord, const glm::vec2& _endCoord);
 		std::vector<glm::vec2> ExpandPath  (const std::vector<glm::vec2>& _path);
-		std::vector<glm::vec2> CompressPath(const std::vector<glm::vec2>& _path);
-		//std::vector<glm::vec2> SmoothenPath(const std::vector<glm::vec2>& _path, std::weak_ptr<Grid> _grid);
-		//std::vector<glm::vec2> BiBacktrace	(std::weak_ptr<Node> _startNode, std::weak_ptr<Node> _endNode);
 
 private:
-		/** \brief function pointer to the heuristic function to be used */
-		std::function<int(const glm::ivec2& _nodeAIndex, const glm::ivec2& _nodeBIndex)> m_heuristic; 
+		SearchContext m_context; ///< the scratch state of the world space queries
+		OpenSet m_aStarOpenSet{ OpenSet::BINARY_HEAP };
+		OpenSet m_dijkstraOpenSet{ OpenSet::BINARY_HEAP };
+		std::weak_ptr<const LandmarkTable> m_landmarks;
 };
 
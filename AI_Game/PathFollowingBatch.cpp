@@ -0,0 +1,76 @@
+#include "PathFollowingBatch.h"
+
+#include <GameEngine\JobSystem.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+		//below this many agents per thread the threads would cost more than they save
+		constexpr size_t AGENTS_PER_WORKER = 256;
+}
+
+void PathFollowingBatch::Clear()
+{
+		m_positionsX.clear();
+		m_positionsY.clear();
+		m_directionsX.clear();
+		m_directionsY.clear();
+		m_speeds.clear();
+		m_radii.clear();
+		m_waypoints.clear();
+		m_nextWaypoints.clear();
+		m_reached.clear();
+}
+
+size_t PathFollowingBatch::Add(const glm::vec2 & _position, float _radius, float _speed, const std::vector<glm::vec2>& _path)
+{
+		m_positionsX.push_back(_position.x);
+		m_positionsY.push_back(_position.y);
+		m_directionsX.push_back(0.0f);
+		m_directionsY.push_back(0.0f);
+		m_speeds.push_back(_speed);
+		m_radii.push_back(_radius);
+		m_waypoints.push_back(_path.back());
+		m_nextWaypoints.push_back(_path.size() > 1 ? _path[_path.size() - 2] : _path.back());
+		m_reached.push_back(0);
+		return m_speeds.size() - 1;
+}
+
+void PathFollowingBatch::Update(float _deltaTime, const Grid & _grid)
+{
+		const size_t size = GetSize();
+		m_targetsX.resize(size);
+		m_targetsY.resize(size);
+
+		//every chunk is a disjoint range of the agents, rethrows if an agent was outside of the grid
+		GameEngine::JobSystem::Get().ParallelFor(size, AGENTS_PER_WORKER, [this, _deltaTime, &_grid](size_t _begin, size_t _end)
+		{
+				UpdateRange(_begin, _end, _deltaTime, _grid);
+		});
+}
+
+void PathFollowingBatch::UpdateRange(size_t _begin, size_t _end, float _deltaTime, const Grid & _grid)
+{
+		//pick the waypoints, this needs the grid
+		for (size_t i = _begin; i < _end; i++)
+		{
+				const bool reached = _grid.GetIndexAt(glm::vec2(m_positionsX[i], m_positionsY[i])) == _grid.GetIndexAt(m_waypoints[i]);
+				const glm::vec2& target = reached ? m_nextWaypoints[i] : m_waypoints[i];
+				m_reached[i] = reached ? 1 : 0;
+				m_targetsX[i] = target.x;
+				m_targetsY[i] = target.y;
+		}
+		//steer the centers to the targets and move, only arithmetic on the arrays so the compiler can vectorize it
+		for (size_t i = _begin; i < _end; i++)
+		{
+				const float x = m_targetsX[i] - (m_positionsX[i] + m_radii[i]);
+				const float y = m_targetsY[i] - (m_positionsY[i] + m_radii[i]);
+				const float inverseLength = 1.0f / std::sqrt(x * x + y * y);
+				m_directionsX[i] = x * inverseLength;
+				m_directionsY[i] = y * inverseLength;
+				m_positionsX[i] += m_directionsX[i] * m_speeds[i] * _deltaTime;
+				m_positionsY[i] += m_directionsY[i] * m_speeds[i] * _deltaTime;
+		}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+
+#include "Grid.h"
+
+/** \brief Moves many agents one frame along their paths in a single pass.
+	*  The agents which follow a path this frame are added with their position, speed and the next two waypoints, which are kept
+	*  in flat arrays (one per value, so the steering loop runs over contiguous floats). Update() steers and moves all of them,
+	*  in parallel once there are enough, and only reads the grid. The rest (leaving the waypoints, the terrain costs) is left
+	*  to the agents, which read their results back on the main thread */
+class PathFollowingBatch
+{
+public:
+		enum : size_t { NO_SLOT = static_cast<size_t>(-1) };
+
+		PathFollowingBatch() {}
+		~PathFollowingBatch() {}
+
+		/** \brief Removes all the agents, done at the start of every frame (keeps the capacity of the arrays) */
+		void Clear();
+
+		/** \brief Adds an agent which follows a path this frame
+			*  \param _position - the bottom left of the agent, _radius from its center
+			*  \param _path - the waypoints from the end to the next one like the path requests return them (not empty)
+			*  \return the slot of the results of the agent */
+		size_t Add(const glm::vec2& _position, float _radius, float _speed, const std::vector<glm::vec2>& _path);
+
+		/** \brief Moves every agent towards its waypoint, or towards the one after it if the agent is already in the node of the waypoint */
+		void Update(float _deltaTime, const Grid& _grid);
+
+		size_t GetSize() const noexcept { return m_speeds.size(); }
+		glm::vec2 GetPosition(size_t _slot) const { return glm::vec2(m_positionsX[_slot], m_positionsY[_slot]); }
+		glm::vec2 GetDirection(size_t _slot) const { return glm::vec2(m_directionsX[_slot], m_directionsY[_slot]); }
+		/** \brief Check if the agent was in the node of its waypoint, so the waypoint is done with */
+		bool ReachedWaypoint(size_t _slot) const { return m_reached[_slot] != 0; }
+
+private:
+		/** \brief Updates the agents in [_begin, _end) */
+		void UpdateRange(size_t _begin, size_t _end, float _deltaTime, const Grid& _grid);
+
+		std::vector<float> m_positionsX;
+		std::vector<float> m_positionsY;
+		std::vector<float> m_directionsX;
+		std::vector<float> m_directionsY;
+		std::vector<float> m_speeds;
+		std::vector<float> m_radii;
+		std::vector<glm::vec2> m_waypoints;     ///< the waypoint every agent heads for
+		std::vector<glm::vec2> m_nextWaypoints; ///< the one after it, the same waypoint if it's the last one
+		std::vector<float> m_targetsX;          ///< scratch, the point every agent steers to this frame
+		std::vector<float> m_targetsY;
+		std::vector<unsigned char> m_reached;
+};
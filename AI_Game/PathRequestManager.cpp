@@ -1,74 +1,586 @@
 #include "PathRequestManager.h"
 
+#include <algorithm>
+#include <stdexcept>
 
+//the number of A* queries Update() time slices at once without workers
+constexpr size_t MAX_ACTIVE_QUERIES = 8;
+//the number of nodes a query expands before the next one gets its turn
+constexpr size_t EXPANSIONS_PER_SLICE = 64;
+//the number of nodes of the pending flow field computed per frame
+constexpr size_t FLOW_FIELD_EXPANSIONS_PER_FRAME = 2048;
+//the number of paths kept in the cache, the least recently used is evicted beyond that
+constexpr size_t MAX_CACHED_PATHS = 256;
+//the most requests to the same node solved together
+constexpr size_t MAX_BATCH_SIZE = 32;
+//the number of stale landmarks rebuilt per frame, each one is two searches over the whole grid
+constexpr int LANDMARKS_PER_FRAME = 1;
 
 PathRequestManager::PathRequestManager()
 {
 		m_pathFinder = std::make_unique<PathFinder>();
 }
 
-PathRequestManager::PathRequestManager(std::weak_ptr<Grid> _grid) : m_grid(_grid)
+PathRequestManager::PathRequestManager(std::weak_ptr<Grid> _grid, size_t _numWorkers /* = DefaultNumWorkers() */) :
+		PathRequestManager(_grid, std::weak_ptr<HierarchicalGrid>(), _numWorkers)
+{
+}
+
+PathRequestManager::PathRequestManager(std::weak_ptr<Grid> _grid, std::weak_ptr<HierarchicalGrid> _hierarchy, size_t _numWorkers /* = DefaultNumWorkers() */) :
+		m_grid(_grid), m_hierarchy(_hierarchy), m_flowField(_grid, Diagonal::IFNOWALLS)
 {
 		m_pathFinder = std::make_unique<PathFinder>();
+		for (size_t i = 0; i < _numWorkers; i++)
+		{
+				m_workers.emplace_back(&PathRequestManager::WorkerLoop, this);
+		}
 }
 
 
 PathRequestManager::~PathRequestManager()
 {
+		{
+				std::lock_guard<std::mutex> lock(m_requestMutex);
+				m_stopWorkers = true;
+		}
+		m_requestAvailable.notify_all();
+		for (auto& worker : m_workers)
+		{
+				worker.join();
+		}
+}
+
+void PathRequestManager::SetLandmarks(std::weak_ptr<LandmarkTable> _landmarks)
+{
+		std::lock_guard<std::mutex> lock(m_requestMutex);
+		m_landmarks = _landmarks;
+		m_pathFinder->SetLandmarks(_landmarks);
+}
+
+size_t PathRequestManager::DefaultNumWorkers()
+{
+		const size_t hardwareThreads = std::thread::hardware_concurrency();
+		return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+}
+
+void PathRequestManager::RequestPath(const glm::vec2 & _start, const glm::vec2 & _end, const Algorithm & _algo, const Diagonal& _diagonal,
+	std::function<void(std::vector<glm::vec2>&, bool)> _callback, const void* _requester /* = nullptr */)
+{
+		PathRequest request(_start, _end, _algo, _diagonal, _callback);
+		request.m_requester = _requester;
+		RequestPath(request);
 }
 
-void PathRequestManager::RequestPath(const glm::vec2 & _start, const glm::vec2 & _end, const Algorithm & _algo, const Diagonal& _diagonal, std::function<void(std::vector<glm::vec2>&, bool)> _callback)
+void PathRequestManager::RequestNearest(const glm::vec2 & _start, const std::vector<glm::vec2>& _goals, const Diagonal & _diagonal,
+	std::function<void(std::vector<glm::vec2>&, bool, int)> _callback, const void* _requester /* = nullptr */)
 {
-		m_pathRequestQueue.emplace(_start, _end, _algo, _diagonal, _callback);
+		PathRequest request;
+		request.m_start = _start;
+		request.m_end = _start;
+		request.m_goals = _goals;
+		request.m_algorithm = Algorithm::DIJKSTRA;
+		request.m_diagonal = _diagonal;
+		request.m_nearestCallback = _callback;
+		request.m_requester = _requester;
+		RequestPath(request);
 }
 
 void PathRequestManager::RequestPath(const PathRequest & _request)
 {
-		m_pathRequestQueue.emplace(_request);
+		PathRequest request = _request;
+		if (request.m_requester)
+		{
+				//the older requests of the agent are stale now, the solved ones are dropped in Update()
+				request.m_requesterGeneration = ++m_requesterGenerations[request.m_requester];
+				std::lock_guard<std::mutex> lock(m_requestMutex);
+				m_pathRequestQueue.erase(std::remove_if(m_pathRequestQueue.begin(), m_pathRequestQueue.end(),
+						[&request](const PathRequest& _queued) { return _queued.m_requester == request.m_requester; }), m_pathRequestQueue.end());
+		}
+
+		//a nearest goal request keeps the -1 start of its cache key, so it's neither cached nor batched
+		std::shared_ptr<Grid> grid = m_grid.lock();
+		if (grid && request.m_goals.empty() &&
+				grid->IsPosInside(request.m_start / grid->GetNodeDiameter()) && grid->IsPosInside(request.m_end / grid->GetNodeDiameter()))
+		{
+				request.m_cacheKey.m_start = grid->GetIndexAt(request.m_start);
+				request.m_cacheKey.m_end = grid->GetIndexAt(request.m_end);
+				request.m_cacheKey.m_algorithm = request.m_algorithm;
+				request.m_cacheKey.m_diagonal = request.m_diagonal;
+
+				const CachedPath* cachedPath = FindCachedPath(request.m_cacheKey);
+				if (cachedPath)
+				{
+						//no search, the callback fires with the next Update() like for any other request
+						PathResult result = MakeResult(request);
+						result.m_path = cachedPath->m_path;
+						result.m_found = true;
+						result.m_cacheKey = PathCacheKey();
+						m_readyPaths.push(std::move(result));
+						return;
+				}
+		}
+
+		std::shared_ptr<const Grid> snapshot = GetGridSnapshot();
+		{
+				std::lock_guard<std::mutex> lock(m_requestMutex);
+				m_pathRequestQueue.push_back(std::move(request));
+				m_gridSnapshot = std::move(snapshot);
+		}
+		m_requestAvailable.notify_one();
+}
+
+void PathRequestManager::SetPathSmoothing(bool _smooth)
+{
+		if (m_smoothPaths != _smooth)
+		{
+				//the cached paths were (or weren't) smoothed
+				m_smoothPaths = _smooth;
+				m_pathCache.clear();
+		}
 }
 
 void PathRequestManager::Update()
 {
-		if (!m_pathRequestQueue.empty())
+		using Clock = std::chrono::steady_clock;
+		const Clock::time_point deadline = Clock::now() + std::chrono::microseconds(static_cast<long long>(m_frameBudget * 1000.0f));
+
+		//a fixed share per frame, so a moving goal can't take the whole budget from the requests
+		m_flowField.Update(FLOW_FIELD_EXPANSIONS_PER_FRAME);
+		if (std::shared_ptr<LandmarkTable> landmarks = m_landmarks.lock())
+		{
+				landmarks->Update(LANDMARKS_PER_FRAME);
+		}
+
+		if (m_workers.empty())
+		{
+				//no workers, solve the requests here until the budget runs out
+				UpdateQueries(deadline);
+		}
+		else
+		{
+				//take everything the workers finished since the last frame
+				std::vector<PathResult> completedPaths;
+				{
+						std::lock_guard<std::mutex> lock(m_completedMutex);
+						completedPaths.swap(m_completedPaths);
+				}
+				for (auto& result : completedPaths)
+				{
+						m_readyPaths.push(std::move(result));
+				}
+		}
+
+		//the callbacks may request new paths, so they are fired without holding any lock
+		bool firstPath = true;
+		while (!m_readyPaths.empty() && (firstPath || Clock::now() < deadline))
 		{
-				PathRequest currentPathRequest = m_pathRequestQueue.front();
-				m_pathRequestQueue.pop();
-				std::vector<glm::vec2> pathResult;
-				switch (currentPathRequest.m_algorithm)
+				PathResult result = std::move(m_readyPaths.front());
+				m_readyPaths.pop();
+				if (result.m_found && result.m_cacheKey.m_start != -1)
+				{
+						CachePath(result);
+				}
+				if (result.m_requester && m_requesterGenerations[result.m_requester] != result.m_requesterGeneration)
+				{
+						//superseded by a newer request of the same agent
+						continue;
+				}
+				if (result.m_nearestCallback)
+				{
+						result.m_nearestCallback(result.m_path, result.m_found, result.m_goalIndex);
+				}
+				else
+				{
+						result.m_callback(result.m_path, result.m_found);
+				}
+				firstPath = false;
+		}
+}
+
+void PathRequestManager::UpdateQueries(const std::chrono::steady_clock::time_point& _deadline)
+{
+		do
+		{
+				//fill the free query slots, the algorithms which can't be suspended are solved right away
+				while (m_activeQueries.size() < MAX_ACTIVE_QUERIES && std::chrono::steady_clock::now() < _deadline)
+				{
+						std::vector<PathRequest> batch;
+						{
+								std::lock_guard<std::mutex> lock(m_requestMutex);
+								if (m_pathRequestQueue.empty())
+								{
+										break;
+								}
+								batch = PopRequestBatch();
+						}
+						const Algorithm algorithm = batch.front().m_algorithm;
+						if (batch.size() == 1 && (algorithm == Algorithm::ASTAR || algorithm == Algorithm::FLOW_FIELD))
+						{
+								StartQuery(batch.front());
+						}
+						else
+						{
+								//a shared search finishes right away, it's one search for the whole batch
+								for (auto& result : SolveBatch(*m_pathFinder, batch, GetGridSnapshot()))
+								{
+										m_readyPaths.push(std::move(result));
+								}
+						}
+				}
+				if (m_activeQueries.empty())
+				{
+						return;
+				}
+
+				//one slice for every query in turn, so a long search can't hold up the short ones
+				for (size_t i = 0; i < m_activeQueries.size();)
+				{
+						ActivePathQuery& active = m_activeQueries[i];
+						const AStarQuery::Status status = active.m_query.Step(EXPANSIONS_PER_SLICE);
+						if (status == AStarQuery::Status::IN_PROGRESS)
+						{
+								i++;
+								continue;
+						}
+
+						PathResult result = MakeResult(active.m_request);
+						result.m_path = PathFinder::ToWorldPath(active.m_query.GetPath(), *active.m_grid);
+						result.m_found = status == AStarQuery::Status::FOUND && !result.m_path.empty();
+						PostProcess(result, active.m_grid);
+						m_readyPaths.push(std::move(result));
+
+						//recycle the context and swap-remove the query
+						m_freeContexts.push_back(std::move(active.m_context));
+						if (i + 1 != m_activeQueries.size())
+						{
+								m_activeQueries[i] = std::move(m_activeQueries.back());
+						}
+						m_activeQueries.pop_back();
+				}
+		} while (std::chrono::steady_clock::now() < _deadline);
+}
+
+void PathRequestManager::StartQuery(PathRequest& _request)
+{
+		//the query searches the version of the grid it started on, whatever changes during its frames
+		std::shared_ptr<const Grid> grid = GetGridSnapshot();
+		int start = -1;
+		int end = -1;
+		try
+		{
+				start = grid->GetIndexAt(_request.m_start);
+				end = grid->GetIndexAt(_request.m_end);
+		}
+		catch (const std::runtime_error& _error)
+		{
+				//a position outside of the grid, fail the request like Solve() does
+				printf("%s\n", _error.what());
+				m_readyPaths.push(MakeResult(_request));
+				return;
+		}
+
+		std::unique_ptr<SearchContext> context;
+		if (m_freeContexts.empty())
+		{
+				context = std::make_unique<SearchContext>();
+		}
+		else
+		{
+				context = std::move(m_freeContexts.back());
+				m_freeContexts.pop_back();
+		}
+		m_activeQueries.emplace_back(_request, grid, std::move(context));
+		ActivePathQuery& query = m_activeQueries.back();
+		query.m_landmarks = m_landmarks.lock();
+		query.m_query.Begin(start, end, *grid, _request.m_diagonal, OpenSet::BINARY_HEAP, query.m_landmarks.get());
+}
+
+const CachedPath* PathRequestManager::FindCachedPath(const PathCacheKey & _key)
+{
+		auto cachedPath = m_pathCache.find(_key);
+		if (cachedPath == m_pathCache.end())
+		{
+				return nullptr;
+		}
+		std::shared_ptr<Grid> grid = m_grid.lock();
+		for (const auto& region : cachedPath->second.m_regionVersions)
+		{
+				if (grid->GetRegionVersion(region.first) != region.second)
+				{
+						//a wall was placed or removed around the path
+						m_pathCache.erase(cachedPath);
+						return nullptr;
+				}
+		}
+		cachedPath->second.m_lastUsed = ++m_pathCacheClock;
+		return &cachedPath->second;
+}
+
+void PathRequestManager::CachePath(const PathResult & _result)
+{
+		std::shared_ptr<Grid> grid = m_grid.lock();
+		CachedPath cachedPath;
+		cachedPath.m_path = _result.m_path;
+		cachedPath.m_lastUsed = ++m_pathCacheClock;
+
+		//the path was solved on a worker, so check it's still clear before the current versions are taken
+		std::vector<glm::ivec2> coords{ grid->GetCoord(_result.m_cacheKey.m_start) };
+		for (const glm::vec2& waypoint : _result.m_path)
+		{
+				coords.push_back(grid->GetCoord(grid->GetIndexAt(waypoint)));
+		}
+		for (size_t i = 0; i < coords.size(); i++)
+		{
+				if (!grid->IsWalkableAt(coords[i]))
+				{
+						return;
+				}
+				//a smoothed path skips nodes, so the line between two waypoints has to be clear and all the regions it can cross are watched
+				glm::ivec2 first{ coords[i] };
+				glm::ivec2 last{ coords[i] };
+				if (i > 0)
+				{
+						const glm::ivec2 difference = coords[i] - coords[i - 1];
+						if ((std::abs(difference.x) > 1 || std::abs(difference.y) > 1) && !PathFinder::HasLineOfSight(coords[i - 1], coords[i], *grid))
+						{
+								return;
+						}
+						first = glm::ivec2(std::min(coords[i].x, coords[i - 1].x), std::min(coords[i].y, coords[i - 1].y));
+						last = glm::ivec2(std::max(coords[i].x, coords[i - 1].x), std::max(coords[i].y, coords[i - 1].y));
+				}
+				for (int y = first.y / Grid::REGION_SIZE; y <= last.y / Grid::REGION_SIZE; y++)
+				{
+						for (int x = first.x / Grid::REGION_SIZE; x <= last.x / Grid::REGION_SIZE; x++)
+						{
+								const int region = grid->GetRegion(grid->GetIndex(glm::ivec2(x, y) * int(Grid::REGION_SIZE)));
+								if (std::find_if(cachedPath.m_regionVersions.begin(), cachedPath.m_regionVersions.end(),
+										[region](const std::pair<int, unsigned int>& _region) { return _region.first == region; }) == cachedPath.m_regionVersions.end())
+								{
+										cachedPath.m_regionVersions.emplace_back(region, grid->GetRegionVersion(region));
+								}
+						}
+				}
+		}
+
+		if (m_pathCache.size() >= MAX_CACHED_PATHS && m_pathCache.find(_result.m_cacheKey) == m_pathCache.end())
+		{
+				auto leastRecentlyUsed = std::min_element(m_pathCache.begin(), m_pathCache.end(),
+						[](const std::pair<const PathCacheKey, CachedPath>& _lhs, const std::pair<const PathCacheKey, CachedPath>& _rhs)
+				{
+						return _lhs.second.m_lastUsed < _rhs.second.m_lastUsed;
+				});
+				m_pathCache.erase(leastRecentlyUsed);
+		}
+		m_pathCache[_result.m_cacheKey] = std::move(cachedPath);
+}
+
+void PathRequestManager::WorkerLoop()
+{
+		//every worker searches with its own path finder (and so its own search context)
+		PathFinder pathFinder;
+		while (true)
+		{
+				std::vector<PathRequest> batch;
+				std::shared_ptr<const Grid> grid;
+				{
+						std::unique_lock<std::mutex> lock(m_requestMutex);
+						m_requestAvailable.wait(lock, [this]() { return m_stopWorkers || !m_pathRequestQueue.empty(); });
+						if (m_stopWorkers)
+						{
+								return;
+						}
+						batch = PopRequestBatch();
+						pathFinder.SetLandmarks(m_landmarks);
+						//the batch is solved on this version of the grid, while the main thread goes on changing the grid itself
+						grid = m_gridSnapshot;
+						if (m_pathRequestQueue.empty())
+						{
+								//no one else needs it, so the next changes of the grid don't have to copy its chunks
+								m_gridSnapshot.reset();
+						}
+				}
+
+				std::vector<PathResult> results = SolveBatch(pathFinder, batch, grid);
+
+				std::lock_guard<std::mutex> lock(m_completedMutex);
+				for (auto& result : results)
+				{
+						m_completedPaths.push_back(std::move(result));
+				}
+		}
+}
+
+std::vector<PathRequest> PathRequestManager::PopRequestBatch()
+{
+		std::vector<PathRequest> batch;
+		batch.push_back(std::move(m_pathRequestQueue.front()));
+		m_pathRequestQueue.pop_front();
+
+		const PathRequest& first = batch.front();
+		if (first.m_cacheKey.m_start == -1)
+		{
+				//outside of the grid, it fails on its own
+				return batch;
+		}
+		for (auto request = m_pathRequestQueue.begin(); request != m_pathRequestQueue.end() && batch.size() < MAX_BATCH_SIZE;)
+		{
+				if (request->m_cacheKey.m_start != -1 && request->m_cacheKey.m_end == first.m_cacheKey.m_end &&
+						request->m_algorithm == first.m_algorithm && request->m_diagonal == first.m_diagonal)
+				{
+						batch.push_back(std::move(*request));
+						request = m_pathRequestQueue.erase(request);
+				}
+				else
+				{
+						++request;
+				}
+		}
+		return batch;
+}
+
+std::vector<PathResult> PathRequestManager::SolveBatch(PathFinder & _pathFinder, std::vector<PathRequest>& _batch, const std::shared_ptr<const Grid>& _grid) const
+{
+		std::vector<PathResult> results;
+		const Algorithm algorithm = _batch.front().m_algorithm;
+		//these give optimal paths, so any optimal path (like the reverse Dijkstra's) is as good as their own
+		const bool optimal = algorithm == Algorithm::ASTAR || algorithm == Algorithm::DIJKSTRA ||
+				algorithm == Algorithm::JUMP_POINT || algorithm == Algorithm::FLOW_FIELD;
+
+		size_t numStarts = 0;
+		for (size_t i = 0; i < _batch.size(); i++)
+		{
+				if (std::none_of(_batch.begin(), _batch.begin() + i,
+						[&_batch, i](const PathRequest& _other) { return _other.m_cacheKey.m_start == _batch[i].m_cacheKey.m_start; }))
+				{
+						numStarts++;
+				}
+		}
+
+		if (optimal && numStarts > 1)
+		{
+				std::vector<glm::vec2> worldStarts;
+				for (const auto& request : _batch)
+				{
+						worldStarts.push_back(request.m_start);
+				}
+				std::vector<std::vector<glm::vec2>> paths = _pathFinder.DijkstraToGoal(worldStarts, _batch.front().m_end, _grid, _batch.front().m_diagonal);
+				for (size_t i = 0; i < _batch.size(); i++)
+				{
+						results.push_back(MakeResult(_batch[i]));
+						results.back().m_path = std::move(paths[i]);
+						results.back().m_found = !results.back().m_path.empty();
+						PostProcess(results.back(), _grid);
+				}
+				return results;
+		}
+
+		//one search per start node, the duplicates get a copy
+		for (size_t i = 0; i < _batch.size(); i++)
+		{
+				auto same = std::find_if(_batch.begin(), _batch.begin() + i,
+						[&_batch, i](const PathRequest& _other) { return _other.m_cacheKey.m_start == _batch[i].m_cacheKey.m_start; });
+				if (same == _batch.begin() + i)
+				{
+						results.push_back(Solve(_pathFinder, _batch[i], _grid));
+				}
+				else
+				{
+						const PathResult& solved = results[same - _batch.begin()];
+						std::vector<glm::vec2> path = solved.m_path;
+						const bool found = solved.m_found;
+						results.push_back(MakeResult(_batch[i]));
+						results.back().m_path = std::move(path);
+						results.back().m_found = found;
+				}
+		}
+		return results;
+}
+
+PathResult PathRequestManager::MakeResult(PathRequest & _request)
+{
+		PathResult result;
+		result.m_callback = std::move(_request.m_callback);
+		result.m_nearestCallback = std::move(_request.m_nearestCallback);
+		result.m_cacheKey = _request.m_cacheKey;
+		result.m_requester = _request.m_requester;
+		result.m_requesterGeneration = _request.m_requesterGeneration;
+		return result;
+}
+
+PathResult PathRequestManager::Solve(PathFinder& _pathFinder, PathRequest& _request, const std::shared_ptr<const Grid>& _grid) const
+{
+		if (!_request.m_goals.empty())
+		{
+				return SolveNearest(_pathFinder, _request, _grid);
+		}
+
+		PathResult result = MakeResult(_request);
+		try
+		{
+				switch (_request.m_algorithm)
 				{
 						case Algorithm::BEST_FIRST:
 						{
-								pathResult = m_pathFinder->BestFirst(currentPathRequest.m_start, currentPathRequest.m_end, m_grid, currentPathRequest.m_diagonal);
+								result.m_path = _pathFinder.BestFirst(_request.m_start, _request.m_end, _grid, _request.m_diagonal);
 								break;
 						}
 						case Algorithm::ASTAR:
+						case Algorithm::FLOW_FIELD:
 						{
-								pathResult = m_pathFinder->AStar(currentPathRequest.m_start, currentPathRequest.m_end, m_grid, currentPathRequest.m_diagonal);
+								result.m_path = _pathFinder.AStar(_request.m_start, _request.m_end, _grid, _request.m_diagonal);
 								break;
 						}
 						case Algorithm::ASTARe:
 						{
-								pathResult = m_pathFinder->AStarEpsilon(currentPathRequest.m_start, currentPathRequest.m_end, m_grid, currentPathRequest.m_diagonal);
+								result.m_path = _pathFinder.AStarEpsilon(_request.m_start, _request.m_end, _grid, _request.m_diagonal);
 								break;
 						}
 						case Algorithm::BREADTH_FIRST:
 						{
-								pathResult = m_pathFinder->BreadthFirst(currentPathRequest.m_start, currentPathRequest.m_end, m_grid, currentPathRequest.m_diagonal);
+								result.m_path = _pathFinder.BreadthFirst(_request.m_start, _request.m_end, _grid, _request.m_diagonal);
 								break;
 						}
 						case Algorithm::DEPTH_FIRST:
 						{
-								pathResult = m_pathFinder->DepthFirst(currentPathRequest.m_start, currentPathRequest.m_end, m_grid, currentPathRequest.m_diagonal);
+								result.m_path = _pathFinder.DepthFirst(_request.m_start, _request.m_end, _grid, _request.m_diagonal);
 								break;
 						}
 						case Algorithm::DIJKSTRA:
 						{
-								pathResult = m_pathFinder->Dijkstra(currentPathRequest.m_start, currentPathRequest.m_end, m_grid, currentPathRequest.m_diagonal);
+								result.m_path = _pathFinder.Dijkstra(_request.m_start, _request.m_end, _grid, _request.m_diagonal);
 								break;
 						}
 						case Algorithm::GREEDY_BEST_FIRST:
 						{
-								pathResult = m_pathFinder->GreedyBFirst(currentPathRequest.m_start, currentPathRequest.m_end, m_grid, currentPathRequest.m_diagonal);
+								result.m_path = _pathFinder.GreedyBFirst(_request.m_start, _request.m_end, _grid, _request.m_diagonal);
+								break;
+						}
+						case Algorithm::JUMP_POINT:
+						{
+								result.m_path = _pathFinder.JumpPoint(_request.m_start, _request.m_end, _grid, _request.m_diagonal);
+								break;
+						}
+						case Algorithm::BIDIRECTIONAL_ASTAR:
+						{
+								result.m_path = _pathFinder.BiAStar(_request.m_start, _request.m_end, _grid, _request.m_diagonal);
+								break;
+						}
+						case Algorithm::BIDIRECTIONAL_BREADTH_FIRST:
+						{
+								result.m_path = _pathFinder.BiBreadthFirst(_request.m_start, _request.m_end, _grid, _request.m_diagonal);
+								break;
+						}
+						case Algorithm::HIERARCHICAL:
+						{
+								std::shared_ptr<HierarchicalGrid> hierarchy = m_hierarchy.lock();
+								if (hierarchy && hierarchy->GetDiagonal() == _request.m_diagonal)
+								{
+										result.m_path = _pathFinder.Hierarchical(_request.m_start, _request.m_end, hierarchy);
+								}
+								else
+								{
+										result.m_path = _pathFinder.AStar(_request.m_start, _request.m_end, _grid, _request.m_diagonal);
+								}
 								break;
 						}
 						default:
@@ -77,15 +589,54 @@ void PathRequestManager::Update()
 								break;
 						}
 				}
-				if (pathResult.empty())
-				{
-						//Failed to find path
-						currentPathRequest.m_callback(pathResult, false);
-				}
-				else
-				{
-						//Successfully found path
-						currentPathRequest.m_callback(pathResult, true);
-				}
 		}
+		catch (const std::runtime_error& _error)
+		{
+				//a position outside of the grid, report it as a failed path instead of taking the worker down
+				printf("%s\n", _error.what());
+				result.m_path.clear();
+		}
+		//Failed to find path if it's empty
+		result.m_found = !result.m_path.empty();
+		PostProcess(result, _grid);
+		return result;
+}
+
+PathResult PathRequestManager::SolveNearest(PathFinder & _pathFinder, PathRequest & _request, const std::shared_ptr<const Grid>& _grid) const
+{
+		PathResult result = MakeResult(_request);
+		try
+		{
+				result.m_path = _pathFinder.DijkstraToNearest(_request.m_start, _request.m_goals, _grid, _request.m_diagonal, result.m_goalIndex);
+		}
+		catch (const std::runtime_error& _error)
+		{
+				printf("%s\n", _error.what());
+				result.m_path.clear();
+				result.m_goalIndex = -1;
+		}
+		//standing on a goal already is found too, with an empty path
+		result.m_found = result.m_goalIndex != -1;
+
+		if (m_smoothPaths && !result.m_path.empty() && _grid)
+		{
+				//PostProcess() takes the start from the cache key, which this request doesn't have
+				result.m_path = PathFinder::SmoothenPath(_grid->GetWorldPos(_grid->GetIndexAt(_request.m_start)), result.m_path, *_grid);
+		}
+		return result;
+}
+
+void PathRequestManager::PostProcess(PathResult & _result, const std::shared_ptr<const Grid>& _grid) const
+{
+		if (!m_smoothPaths || !_result.m_found || _result.m_cacheKey.m_start < 0 || !_grid)
+		{
+				return;
+		}
+		_result.m_path = PathFinder::SmoothenPath(_grid->GetWorldPos(_result.m_cacheKey.m_start), _result.m_path, *_grid);
+}
+
+std::shared_ptr<const Grid> PathRequestManager::GetGridSnapshot()
+{
+		std::shared_ptr<Grid> grid = m_grid.lock();
+		return grid ? grid->GetSnapshot() : nullptr;
 }
@@ -1,7 +1,15 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
 
-#include "PathFinder.h"
+#include "AStarQuery.h"
+#include "FlowField.h"
 
 /** \brief all supported algorithms */
 enum class Algorithm : size_t
@@ -12,7 +20,38 @@ enum class Algorithm : size_t
 		BREADTH_FIRST,
 		DEPTH_FIRST,
 		DIJKSTRA,
-		GREEDY_BEST_FIRST
+		GREEDY_BEST_FIRST,
+		JUMP_POINT,
+		HIERARCHICAL,
+		FLOW_FIELD, ///< chasing agents follow the shared flow field towards the goal set with SetFlowFieldGoal, path requests use A*
+		BIDIRECTIONAL_ASTAR,
+		BIDIRECTIONAL_BREADTH_FIRST
+};
+
+/** \brief Identifies the paths the manager caches: the same nodes, algorithm and movement give the same path */
+struct PathCacheKey
+{
+		bool operator==(const PathCacheKey& _rhs) const noexcept
+		{
+				return m_start == _rhs.m_start && m_end == _rhs.m_end && m_algorithm == _rhs.m_algorithm && m_diagonal == _rhs.m_diagonal;
+		}
+
+		int m_start{ -1 }; ///< the flat index of the start node, -1 if the request isn't cached
+		int m_end{ -1 };
+		Algorithm m_algorithm{ Algorithm::ASTAR };
+		Diagonal m_diagonal{ Diagonal::NEVER };
+};
+
+/** \brief Hasher for the path cache */
+struct PathCacheKeyHasher
+{
+		size_t operator()(const PathCacheKey& _key) const noexcept
+		{
+				size_t hash = std::hash<int>()(_key.m_start);
+				hash = hash * 31 + std::hash<int>()(_key.m_end);
+				hash = hash * 31 + static_cast<size_t>(_key.m_algorithm);
+				return hash * 31 + static_cast<size_t>(_key.m_diagonal);
+		}
 };
 
 /** \brief Path request data */
@@ -28,29 +67,156 @@ struct PathRequest
 		Algorithm m_algorithm;
 		Diagonal m_diagonal;
 		std::function<void(std::vector<glm::vec2>&, bool)> m_callback;
+		const void* m_requester{ nullptr }; ///< the agent asking, a newer request of the same agent drops this one (nullptr for none)
+		std::vector<glm::vec2> m_goals; ///< the candidates of a nearest goal request (see RequestNearest), m_end isn't used then
+		std::function<void(std::vector<glm::vec2>&, bool, int)> m_nearestCallback; ///< replaces m_callback for a nearest goal request
+
+		PathCacheKey m_cacheKey; ///< filled in by the manager
+		unsigned int m_requesterGeneration{ 0 }; ///< filled in by the manager
+};
+
+/** \brief A solved path request, waiting for its callback to be fired on the main thread */
+struct PathResult
+{
+		std::vector<glm::vec2> m_path;
+		bool m_found{ false };
+		std::function<void(std::vector<glm::vec2>&, bool)> m_callback;
+		std::function<void(std::vector<glm::vec2>&, bool, int)> m_nearestCallback; ///< fired instead of m_callback if set
+		int m_goalIndex{ -1 }; ///< the goal a nearest goal request reached
+		PathCacheKey m_cacheKey; ///< where the path is cached once its callback fires (-1 start for nowhere)
+		const void* m_requester{ nullptr };
+		unsigned int m_requesterGeneration{ 0 }; ///< the callback isn't fired if the requester asked for another path since
+};
+
+/** \brief A found path in the cache, valid as long as the regions of the grid it passes keep their versions */
+struct CachedPath
+{
+		std::vector<glm::vec2> m_path;
+		std::vector<std::pair<int, unsigned int>> m_regionVersions; ///< the regions of the path and their versions when it was cached
+		unsigned long long m_lastUsed{ 0 }; ///< for evicting the least recently used path
 };
 
-/** \brief Path request manager which finds 1 path per frame */
+/** \brief An A* request which is solved over several frames */
+struct ActivePathQuery
+{
+		ActivePathQuery(const PathRequest& _request, std::shared_ptr<const Grid> _grid, std::unique_ptr<SearchContext> _context) :
+				m_request(_request), m_grid(_grid), m_context(std::move(_context)), m_query(*m_context) {}
+
+		PathRequest m_request;
+		std::shared_ptr<const Grid> m_grid; ///< the snapshot of the grid the query reads, pinned until it finishes (see Grid::GetSnapshot)
+		std::shared_ptr<const LandmarkTable> m_landmarks; ///< the same for the landmarks of its heuristic, can be empty
+		std::unique_ptr<SearchContext> m_context; ///< on the heap, so the query's pointer to it survives moving this around
+		AStarQuery m_query;
+};
+
+/** \brief Path request manager which solves the requests on a pool of worker threads.
+	*  The workers only read snapshots of the grid (every one has its own PathFinder), so the main thread can change the grid while they search.
+	*  The callbacks are always fired on the thread calling Update() */
 class PathRequestManager
 {
 public:
 		PathRequestManager();
-		PathRequestManager(std::weak_ptr<Grid> _grid);
+		/** \brief \param _numWorkers - the number of worker threads, 0 solves the requests in Update() instead (within the frame budget) */
+		PathRequestManager(std::weak_ptr<Grid> _grid, size_t _numWorkers = DefaultNumWorkers());
+		/** \brief \param _hierarchy - the HPA* hierarchy of the grid for the HIERARCHICAL requests (they use A* if its movement doesn't match) */
+		PathRequestManager(std::weak_ptr<Grid> _grid, std::weak_ptr<HierarchicalGrid> _hierarchy, size_t _numWorkers = DefaultNumWorkers());
+		/** \brief Stops and joins the workers, the requests which weren't solved yet are dropped without a callback */
 		~PathRequestManager();
 
-		/** \brief Emplace a path in the queue */
+		/** \brief Emplace a path in the queue (main thread only).
+			*  A path which was found before for the same nodes is taken from the cache, its callback still fires in Update().
+			*  The cached paths stay until the walkability around them changes, a change of the terrain costs doesn't evict them.
+			*  The queued requests to the same node are solved together, with one search for all of them where the algorithm allows it
+			*  \param _requester - the agent asking (or nullptr), its older request is dropped without a callback */
 		void RequestPath(const glm::vec2& _start, const glm::vec2& _end, const Algorithm& _algo,
-				const Diagonal& _diagonal, std::function<void(std::vector<glm::vec2>&, bool)> _callback);
+				const Diagonal& _diagonal, std::function<void(std::vector<glm::vec2>&, bool)> _callback, const void* _requester = nullptr);
 		/** \brief Emplace a path in the queue */
 		void RequestPath(const PathRequest& _request);
-		/** \brief Called every frame to find 1 path on the top of the queue */
+		/** \brief Emplace a request for the path to the nearest of several goals (e.g. cover spots, patrol waypoints), solved with one
+			*  Dijkstra which stops at the first goal it reaches instead of one search per goal (see PathFinder::DijkstraToNearest).
+			*  These paths aren't cached or batched with the others, a newer request of the requester drops this one like any other
+			*  \param _callback - gets the path, whether a goal was reached and the index in _goals of the one reached (-1 for none) */
+		void RequestNearest(const glm::vec2& _start, const std::vector<glm::vec2>& _goals, const Diagonal& _diagonal,
+				std::function<void(std::vector<glm::vec2>&, bool, int)> _callback, const void* _requester = nullptr);
+		/** \brief Called every frame to fire the callbacks of the finished paths (or to solve the requests without workers).
+			*  Without workers the A* requests are time sliced: the frame budget is shared between the running queries,
+			*  which carry on where they stopped in the next frame. Update() always makes some progress so nothing starves */
 		void Update();
 
+		/** \brief Sets how many milliseconds Update() may take per frame */
+		void SetFrameBudget(float _milliseconds) { m_frameBudget = _milliseconds; }
+		size_t GetNumWorkers() const { return m_workers.size(); }
+
+		/** \brief Turns the post-processing of the found paths on or off (off by default, clears the cache): the paths are compressed
+			*  and pulled straight (see PathFinder::SmoothenPath), so the callbacks get a few waypoints instead of every node */
+		void SetPathSmoothing(bool _smooth);
+		bool GetPathSmoothing() const { return m_smoothPaths; }
+
+		/** \brief The landmark distances of the grid for the heuristic of the A* requests (see LandmarkTable), none by default.
+			*  Update() rebuilds the landmarks the changes of the grid made stale, one per frame */
+		void SetLandmarks(std::weak_ptr<LandmarkTable> _landmarks);
+
+		/** \brief Moves the goal of the shared flow field (e.g. to the player every frame), Update() computes the new field
+			*  over a few frames once the goal enters another node */
+		void SetFlowFieldGoal(const glm::vec2& _worldPos) { m_flowField.SetGoal(_worldPos); }
+		/** \brief The flow field towards the goal, any number of agents can sample it instead of requesting paths (main thread only) */
+		const FlowField& GetFlowField() const noexcept { return m_flowField; }
+
+		/** \brief One worker less than the hardware threads (the main thread keeps running the game), at least 1 */
+		static size_t DefaultNumWorkers();
+
 private:
-		std::queue<PathRequest> m_pathRequestQueue; ///< The queue of all path requests
+		/** \brief Takes requests off the queue and solves them until the manager is destroyed */
+		void WorkerLoop();
+		/** \brief Takes the request at the front of the queue and the queued ones which can share its search (m_requestMutex must be locked) */
+		std::vector<PathRequest> PopRequestBatch();
+		/** \brief Solves a batch of PopRequestBatch(): the requests from the same start node share one search,
+			*  and the optimal algorithms answer all the starts with one reverse Dijkstra */
+		std::vector<PathResult> SolveBatch(PathFinder& _pathFinder, std::vector<PathRequest>& _batch, const std::shared_ptr<const Grid>& _grid) const;
+		/** \brief Solves a request with the given path finder (each thread passes its own) on a snapshot of the grid */
+		PathResult Solve(PathFinder& _pathFinder, PathRequest& _request, const std::shared_ptr<const Grid>& _grid) const;
+		/** \brief Solves a request of RequestNearest() */
+		PathResult SolveNearest(PathFinder& _pathFinder, PathRequest& _request, const std::shared_ptr<const Grid>& _grid) const;
+		/** \brief An empty result for the request, taking its callback */
+		static PathResult MakeResult(PathRequest& _request);
+		/** \brief Smoothens the path of a found result if the smoothing is on (on the thread which solved it) */
+		void PostProcess(PathResult& _result, const std::shared_ptr<const Grid>& _grid) const;
+		/** \brief The snapshot of the current version of the grid, nullptr without a grid (main thread only) */
+		std::shared_ptr<const Grid> GetGridSnapshot();
+		/** \brief Starts and steps the A* queries (and solves the other requests) until _deadline, used without workers */
+		void UpdateQueries(const std::chrono::steady_clock::time_point& _deadline);
+		/** \brief Starts an A* query for the request, reusing a free search context */
+		void StartQuery(PathRequest& _request);
+		/** \brief Looks the path up in the cache, evicting it if the grid changed around it
+			*  \return the cached path or nullptr */
+		const CachedPath* FindCachedPath(const PathCacheKey& _key);
+		/** \brief Caches a found path (if the grid didn't change under it since it was solved) */
+		void CachePath(const PathResult& _result);
+
+		std::deque<PathRequest> m_pathRequestQueue; ///< The queue of all path requests (guarded by m_requestMutex)
+		std::mutex m_requestMutex;
+		std::condition_variable m_requestAvailable; ///< signaled when a request is queued or the workers have to stop
+		bool m_stopWorkers{ false };
+
+		std::vector<PathResult> m_completedPaths; ///< the results of the workers (guarded by m_completedMutex)
+		std::mutex m_completedMutex;
+		std::queue<PathResult> m_readyPaths; ///< results taken from the workers whose callbacks the frame budget didn't reach yet (main thread only)
+
+		std::vector<std::thread> m_workers;
+		float m_frameBudget{ 2.0f }; ///< the milliseconds Update() may take per frame
+		std::atomic<bool> m_smoothPaths{ false }; ///< see SetPathSmoothing, read by the workers
 
-		std::unique_ptr<PathFinder> m_pathFinder;   ///< The pathfinder class to find the paths
+		std::unique_ptr<PathFinder> m_pathFinder;   ///< The pathfinder used by Update() when there are no workers
+		std::vector<ActivePathQuery> m_activeQueries; ///< the A* queries being time sliced (main thread only)
+		std::vector<std::unique_ptr<SearchContext>> m_freeContexts; ///< the contexts of the finished queries, kept for the next ones
 
 		std::weak_ptr<Grid> m_grid; ///< reference (weak pointer) to the grid of the world
+		std::shared_ptr<const Grid> m_gridSnapshot; ///< the version of the grid the workers solve the queued requests on (guarded by m_requestMutex)
+		std::weak_ptr<HierarchicalGrid> m_hierarchy; ///< the hierarchy of the grid, can be empty
+		std::weak_ptr<LandmarkTable> m_landmarks; ///< the landmarks of the grid, can be empty (written on the main thread, read by the workers under m_requestMutex)
+		std::unordered_map<PathCacheKey, CachedPath, PathCacheKeyHasher> m_pathCache; ///< the found paths by their nodes (main thread only)
+		unsigned long long m_pathCacheClock{ 0 }; ///< counts the cache accesses, for m_lastUsed
+		std::unordered_map<const void*, unsigned int> m_requesterGenerations; ///< the latest request of every requester (main thread only)
+		FlowField m_flowField; ///< the field the FLOW_FIELD agents follow, with the movement of the chasing zombies (main thread only)
 };
 
@@ -1,96 +1,97 @@
 #include "PatrolState.h"
-#include "AlertState.h"
 #include "Zombie.h"
 
 
 #define PENALIZE_COST 25
 
-PatrolState::PatrolState(Zombie * _ownerZombie) : ZombieState(_ownerZombie)
+PatrolState::PatrolState()
 {
 		m_rng.GenSeed(GameEngine::SeedType::CLOCK_TICKS);
-		m_nextWaypointIndex = m_rng.GenRandInt(0, m_zombie->m_patrolWaypoints.size() - 1);
 }
 
 PatrolState::~PatrolState()
 {
-		m_zombie->m_pathToTake.clear();
 }
 
-void PatrolState::Update(float _deltaTime)
+void PatrolState::Enter(Zombie&, ZombieStateData& _data)
 {
-		if (!m_zombie->m_pathToTake.empty())
+		//back onto the route at the nearest waypoint, the random ones follow from there
+		_data.nextWaypointIndex = NEAREST_WAYPOINT;
+}
+
+unsigned char PatrolState::Update(Zombie& _zombie, ZombieStateData& _data, float _deltaTime)
+{
+		if (!_zombie.m_pathToTake.empty())
 		{
-				FollowPath(_deltaTime);
+				_zombie.FollowPath(_deltaTime);
 		}
 		else
 		{
-				if (!m_requestedPath)
+				if (!_data.requestedPath)
 				{
-						FindPath();
+						FindPath(_zombie, _data);
 				}
 		}
 
-		if (CheckForPlayer())
+		if (CanSeePlayer(_zombie))
 		{
 				//chase player
-				if (!m_requestedPath)
+				if (!_data.requestedPath)
 				{
-						//only switch states if there is no path requested (or the callback will try to access deleted memory)
-						m_zombie->m_stateManager.SetState(new AlertState(m_zombie));
+						//only switch states if there is no path requested (or the callback would give a path to the next state)
+						return PLAYER_SEEN;
 				}
 		}
+		return NO_EVENT;
 }
 
-void PatrolState::FindPath()
+void PatrolState::Exit(Zombie& _zombie, ZombieStateData&)
 {
-		m_zombie->m_prManager.lock()->RequestPath(m_zombie->m_worldPos, m_zombie->m_patrolWaypoints.at(m_nextWaypointIndex),
-				m_zombie->m_algoToUse, Diagonal::IFNOWALLS,
-				[this](std::vector<glm::vec2>& _path, bool _success)
-		{
-				if (_success)
-				{
-						m_zombie->m_pathToTake = _path;
-						PenalizePath();
-				}
-				m_requestedPath = false;
-		});
-		m_requestedPath = true;
-		m_nextWaypointIndex = m_rng.GenRandInt(0, m_zombie->m_patrolWaypoints.size() - 1);
+		_zombie.m_pathToTake.clear();
 }
 
-void PatrolState::FollowPath(float _deltaTime)
+void PatrolState::FindPath(Zombie& _zombie, ZombieStateData& _data)
 {
-		glm::vec2 currentWaypoint = m_zombie->m_pathToTake.back();
-
-		if (m_zombie->m_world.lock()->GetWorldGrid().lock()->GetNodeAt(m_zombie->m_worldPos).lock() ==
-				m_zombie->m_world.lock()->GetWorldGrid().lock()->GetNodeAt(m_zombie->m_pathToTake.back()).lock())
+		Zombie* zombie = &_zombie;
+		if (_data.nextWaypointIndex == NEAREST_WAYPOINT)
 		{
-				//Remove the penalizing after exiting this waypoint
-				std::weak_ptr<Node> nodeToLeave =
-						m_zombie->m_world.lock()->GetWorldGrid().lock()->GetNodeAt(m_zombie->m_pathToTake.back());
-
-				nodeToLeave.lock()->terrainCost =
-						m_zombie->m_world.lock()->GetTile(nodeToLeave.lock()->nodeIndex.x, nodeToLeave.lock()->nodeIndex.y).lock()->MovementCost();
-
-				m_zombie->m_pathToTake.pop_back();
-
-				if (m_zombie->m_pathToTake.empty())
+				//one search for all the waypoints instead of a request per waypoint
+				_zombie.m_prManager.lock()->RequestNearest(_zombie.m_worldPos, _zombie.m_patrolWaypoints, Diagonal::IFNOWALLS,
+						[zombie](std::vector<glm::vec2>& _path, bool _success, int)
 				{
-						m_zombie->m_direction = glm::normalize(currentWaypoint - m_zombie->GetCenterPos());
-						m_zombie->m_worldPos += m_zombie->m_direction * m_zombie->m_movementSpeed * _deltaTime;
-						//m_zombie->m_stateManager.SetState(new SearchState(m_zombie));
-						return;
-				}
-				currentWaypoint = m_zombie->m_pathToTake.back();
+						if (_success)
+						{
+								zombie->m_pathToTake = _path;
+								PenalizePath(*zombie);
+						}
+						zombie->m_stateManager.GetData().requestedPath = false;
+				}, zombie);
+				_data.requestedPath = true;
+				_data.nextWaypointIndex = m_rng.GenRandInt(0, _zombie.m_patrolWaypoints.size() - 1);
+				return;
 		}
-		m_zombie->m_direction = glm::normalize(currentWaypoint - m_zombie->GetCenterPos());
-		m_zombie->m_worldPos += m_zombie->m_direction * m_zombie->m_movementSpeed * _deltaTime;
+		_zombie.m_prManager.lock()->RequestPath(_zombie.m_worldPos, _zombie.m_patrolWaypoints.at(_data.nextWaypointIndex),
+				_zombie.m_algoToUse, Diagonal::IFNOWALLS,
+				[zombie](std::vector<glm::vec2>& _path, bool _success)
+		{
+				if (_success)
+				{
+						zombie->m_pathToTake = _path;
+						PenalizePath(*zombie);
+				}
+				zombie->m_stateManager.GetData().requestedPath = false;
+		}, zombie);
+		_data.requestedPath = true;
+		_data.nextWaypointIndex = m_rng.GenRandInt(0, _zombie.m_patrolWaypoints.size() - 1);
 }
 
-void PatrolState::PenalizePath()
+void PatrolState::PenalizePath(Zombie& _zombie)
 {
-		for (size_t i = 0; i < m_zombie->m_pathToTake.size(); i++)
+		std::shared_ptr<Grid> grid = _zombie.m_world.lock()->GetWorldGrid().lock();
+		for (size_t i = 0; i < _zombie.m_pathToTake.size(); i++)
 		{
-				m_zombie->m_world.lock()->GetWorldGrid().lock()->GetNodeAt(m_zombie->m_pathToTake.at(i)).lock()->terrainCost += PENALIZE_COST;
+				//through the grid, so its terrain cost bookkeeping stays right
+				const Node node = grid->GetNodeAt(_zombie.m_pathToTake.at(i));
+				grid->SetTerrainCost(node.nodeIndex, node.terrainCost + PENALIZE_COST);
 		}
 }
@@ -9,20 +9,19 @@
 class PatrolState : public ZombieState
 {
 public:
-		PatrolState(Zombie* _ownerZombie);
+		PatrolState();
 		virtual ~PatrolState();
 
-		void Update(float _deltaTime) override;
+		void Enter(Zombie& _zombie, ZombieStateData& _data) override;
+		unsigned char Update(Zombie& _zombie, ZombieStateData& _data, float _deltaTime) override;
+		void Exit(Zombie& _zombie, ZombieStateData& _data) override;
 
 protected:
-		void FindPath();
-		void FollowPath(float _deltaTime);
-		void PenalizePath();
+		static constexpr int NEAREST_WAYPOINT{ -1 }; ///< the nextWaypointIndex of a zombie heading for whichever waypoint is nearest
 
-protected:
-		bool m_requestedPath{ false };	///< flag whether the zombie has already send a path request manager, in order to avoid request flooding
-		int m_nextWaypointIndex{ 0 };
+		void FindPath(Zombie& _zombie, ZombieStateData& _data);
+		static void PenalizePath(Zombie& _zombie);
 
-		GameEngine::Random m_rng;
+protected:
+		GameEngine::Random m_rng; ///< picks the patrol waypoints of all the zombies in the state
 };
-
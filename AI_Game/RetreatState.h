@@ -5,9 +5,8 @@
 class RetreatState : public ZombieState
 {
 public:
-		RetreatState(Zombie* _ownerZombie);
+		RetreatState();
 		~RetreatState();
 
-		void Update(float _deltaTime) override;
+		unsigned char Update(Zombie& _zombie, ZombieStateData& _data, float _deltaTime) override;
 };
-
@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+
+#include "BucketQueue.h"
+#include "IndexedHeap.h"
+#include "Node.h"
+
+#include <GameEngine\MemoryTracker.h>
+
+/** \brief The container of the open set of AStar and Dijkstra (see PathFinder::SetOpenSet). The binary heap orders by f and breaks
+	*  the ties by h, the buckets (all the costs are integers) push and pop in O(1) */
+enum class OpenSet : unsigned char
+{
+		BINARY_HEAP,
+		BUCKETS
+};
+
+/** \brief The scratch state of one path query (g, h, parent and the open/closed flags of every node).
+	*  Every search gets its own context, so many of them can run at the same time against one Grid that is only read.
+	*  The context is meant to be reused: Begin() bumps a generation counter instead of clearing all the nodes,
+	*  and a node is only reset the first time the new query touches it */
+class SearchContext
+{
+public:
+		SearchContext() {}
+		~SearchContext() {}
+
+		/** \brief Starts a new query over a grid of _numNodes nodes (O(1) unless the size changed or the generation wrapped) */
+		void Begin(int _numNodes)
+		{
+				m_generation++;
+				if (m_nodes.size() != static_cast<size_t>(_numNodes) || m_generation == 0)
+				{
+						//the stamps of the old nodes can't be trusted anymore, so start over from generation 1
+						m_nodes.assign(_numNodes, SearchNode());
+						m_generation = 1;
+				}
+				//the open set compares through m_nodes, which may just have been reallocated
+				m_openSet.Reserve(_numNodes);
+				m_openSet.SetComparator(ComparePriority(m_nodes.data()));
+				m_reverseOpenSet.Reserve(_numNodes);
+				m_reverseOpenSet.SetComparator(ComparePriority(m_nodes.data()));
+				m_bucketOpenSet.Reserve(_numNodes);
+				m_bucketOpenSet.SetComparator(FPriority(m_nodes.data()));
+		}
+
+		/** \brief Gets the state of node _index in the current query, resetting it if this query hasn't touched it yet */
+		SearchNode& Visit(int _index)
+		{
+				SearchNode& node = m_nodes[_index];
+				if (node.visitGeneration != m_generation)
+				{
+						node = SearchNode();
+						node.visitGeneration = m_generation;
+				}
+				return node;
+		}
+
+		/** \brief Check if the current query touched node _index, the state of the others is stale */
+		bool IsVisited(int _index) const noexcept { return static_cast<size_t>(_index) < m_nodes.size() && m_nodes[_index].visitGeneration == m_generation; }
+
+		/** \brief Gets the state of a node this query already visited (no stamp check) */
+		SearchNode& At(int _index) noexcept { return m_nodes[_index]; }
+		const SearchNode& At(int _index) const noexcept { return m_nodes[_index]; }
+
+		/** \brief Counts the nodes the current query touched and the ones it closed (goes over every node, for statistics only) */
+		void CountNodes(int& _visited, int& _closed) const noexcept
+		{
+				_visited = 0;
+				_closed = 0;
+				for (const SearchNode& node : m_nodes)
+				{
+						if (node.visitGeneration == m_generation)
+						{
+								_visited++;
+								_closed += node.inClosedSet ? 1 : 0;
+						}
+				}
+		}
+
+		/** \brief The raw state array, for the comparators of the open sets */
+		const SearchNode* GetNodes() const noexcept { return m_nodes.data(); }
+
+		/** \brief The f-ordered open set of the query, emptied by Begin() (reusing its position array) */
+		IndexedHeap<ComparePriority>& GetOpenSet() noexcept { return m_openSet; }
+		/** \brief The open set of the search from the end, for the bidirectional searches */
+		IndexedHeap<ComparePriority>& GetReverseOpenSet() noexcept { return m_reverseOpenSet; }
+		/** \brief The open set of the query as buckets of f, for OpenSet::BUCKETS */
+		BucketQueue<FPriority>& GetBucketOpenSet() noexcept { return m_bucketOpenSet; }
+
+private:
+		GameEngine::TrackedVector<SearchNode, GameEngine::MEMORY_AI> m_nodes; ///< one entry per grid node, indexed by the flat node index
+		unsigned int m_generation{ 0 };  ///< the current query, nodes with an older visitGeneration are stale
+		IndexedHeap<ComparePriority> m_openSet; ///< the open set of AStar, AStarEpsilon and Dijkstra
+		IndexedHeap<ComparePriority> m_reverseOpenSet; ///< the second open set of BiAStar
+		BucketQueue<FPriority> m_bucketOpenSet; ///< the open set of AStar and Dijkstra with OpenSet::BUCKETS
+};
@@ -1,109 +1,109 @@
 #include "SmartChaseState.h"
 
 #include "Zombie.h"
-#include "SmartPatrolState.h"
-#include "RetreatState.h"
 
 #define PENALIZE_COST 25
 
-SmartChaseState::SmartChaseState(Zombie* _ownerZombie) : ChaseState(_ownerZombie)
+SmartChaseState::SmartChaseState()
 {
 }
 
 
 SmartChaseState::~SmartChaseState()
 {
-		m_zombie->m_pathToTake.clear();
 }
 
-void SmartChaseState::Update(float _deltaTime)
+unsigned char SmartChaseState::Update(Zombie& _zombie, ZombieStateData& _data, float _deltaTime)
 {
-		if (!m_zombie->m_pathToTake.empty())
+		if (!_zombie.m_pathToTake.empty())
 		{
-				FollowPath(_deltaTime);
+				_zombie.FollowPath(_deltaTime);
+		}
+		else if (_zombie.m_algoToUse == Algorithm::FLOW_FIELD)
+		{
+				FollowFlowField(_zombie, _deltaTime);
+		}
+		else if (CanSeePlayer(_zombie))
+		{
+				//nothing in between, so no path is needed to get to the player
+				_zombie.m_direction = glm::normalize(_zombie.m_player.lock()->GetCenterPos() - _zombie.GetCenterPos());
+				_zombie.m_worldPos += _zombie.m_direction * _zombie.m_movementSpeed * _deltaTime;
 		}
 		else
 		{
-				if (!m_requestedPath)
+				if (!_data.requestedPath)
 				{
-						FindPath();
+						FindPath(_zombie, _data);
 				}
 		}
 
-		if (!m_zombie->CollideWithAgent(m_zombie->m_player.lock().get()))
+		if (!_zombie.CollideWithAgent(_zombie.m_player.lock().get()))
 		{
 				//collision handle
 		}
 
-		if (m_zombie->m_health <= 50.0f)
+		if (_zombie.m_health <= 50.0f)
 		{
 				//The zombie is low health, he wants to run !
-				if (!m_requestedPath)
+				if (!_data.requestedPath)
 				{
-						//only switch states if there is no path requested (or the callback will try to access deleted memory)
-						m_zombie->m_stateManager.SetState(new RetreatState(m_zombie));
+						//only switch states if there is no path requested (or the callback would give a path to the next state)
+						return LOW_HEALTH;
 				}
 		}
-		else if (!CheckForPlayer())
+		else if (!CheckForPlayer(_zombie) && !SensesPlayer(_zombie))
 		{
-				//The player is out of zombie chase range
-				if (!m_requestedPath)
+				//The player is out of zombie chase range, and no zombie near this one has seen him lately
+				if (!_data.requestedPath)
 				{
-						//only switch states if there is no path requested (or the callback will try to access deleted memory)
-						m_zombie->m_stateManager.SetState(new SmartPatrolState(m_zombie));
+						//only switch states if there is no path requested (or the callback would give a path to the next state)
+						return PLAYER_LOST;
 				}
 		}
+		return NO_EVENT;
+}
+
+void SmartChaseState::Exit(Zombie& _zombie, ZombieStateData&)
+{
+		_zombie.m_pathToTake.clear();
 }
 
-void SmartChaseState::FindPath()
+void SmartChaseState::FindPath(Zombie& _zombie, ZombieStateData& _data)
 {
-		m_zombie->m_prManager.lock()->RequestPath(m_zombie->m_worldPos, m_zombie->m_player.lock()->GetCenterPos(),
-				m_zombie->m_algoToUse, Diagonal::IFNOWALLS,
-				[this](std::vector<glm::vec2>& _path, bool _success)
+		Zombie* zombie = &_zombie;
+		_zombie.m_prManager.lock()->RequestPath(_zombie.m_worldPos, _zombie.m_player.lock()->GetCenterPos(),
+				_zombie.m_algoToUse, Diagonal::IFNOWALLS,
+				[zombie](std::vector<glm::vec2>& _path, bool _success)
 		{
 				if (_success)
 				{
-						m_zombie->m_pathToTake = _path;
-						PenalizePath();
+						zombie->m_pathToTake = _path;
+						PenalizePath(*zombie);
 				}
-				m_requestedPath = false;
-		});
-		m_requestedPath = true;
+				zombie->m_stateManager.GetData().requestedPath = false;
+		}, zombie);
+		_data.requestedPath = true;
 }
 
-void SmartChaseState::FollowPath(float _deltaTime)
+void SmartChaseState::FollowFlowField(Zombie& _zombie, float _deltaTime)
 {
-		glm::vec2 currentWaypoint = m_zombie->m_pathToTake.back();
-
-		if (m_zombie->m_world.lock()->GetWorldGrid().lock()->GetNodeAt(m_zombie->m_worldPos).lock() ==
-				m_zombie->m_world.lock()->GetWorldGrid().lock()->GetNodeAt(m_zombie->m_pathToTake.back()).lock())
+		glm::vec2 direction = _zombie.m_prManager.lock()->GetFlowField().GetDirection(_zombie.GetCenterPos());
+		if (direction == glm::vec2(0.0f))
 		{
-				//Remove the penalizing after exiting this waypoint
-				std::weak_ptr<Node> nodeToLeave =
-						m_zombie->m_world.lock()->GetWorldGrid().lock()->GetNodeAt(m_zombie->m_pathToTake.back());
-
-				nodeToLeave.lock()->terrainCost =
-						m_zombie->m_world.lock()->GetTile(nodeToLeave.lock()->nodeIndex.x, nodeToLeave.lock()->nodeIndex.y).lock()->MovementCost();
-
-				m_zombie->m_pathToTake.pop_back();
-
-				if (m_zombie->m_pathToTake.empty())
-				{
-						m_zombie->m_direction = glm::normalize(currentWaypoint - m_zombie->GetCenterPos());
-						m_zombie->m_worldPos += m_zombie->m_direction * m_zombie->m_movementSpeed * _deltaTime;
-						//m_zombie->m_stateManager.SetState(new SearchState(m_zombie));
-						return;
-				}
-				currentWaypoint = m_zombie->m_pathToTake.back();
+				//in the player's node (or no field yet), go straight for him
+				direction = glm::normalize(_zombie.m_player.lock()->GetCenterPos() - _zombie.GetCenterPos());
 		}
-		m_zombie->m_direction = glm::normalize(currentWaypoint - m_zombie->GetCenterPos());
-		m_zombie->m_worldPos += m_zombie->m_direction * m_zombie->m_movementSpeed * _deltaTime;
+		_zombie.m_direction = direction;
+		_zombie.m_worldPos += _zombie.m_direction * _zombie.m_movementSpeed * _deltaTime;
 }
 
-void SmartChaseState::PenalizePath()
+void SmartChaseState::PenalizePath(Zombie& _zombie)
 {
-		for (size_t i = 0; i < m_zombie->m_pathToTake.size(); i++)
+		std::shared_ptr<Grid> grid = _zombie.m_world.lock()->GetWorldGrid().lock();
+		for (size_t i = 0; i < _zombie.m_pathToTake.size(); i++)
 		{
-				m_zombie->m_world.lock()->GetWorldGrid().lock()->GetNodeAt(m_zombie->m_pathToTake.at(i)).lock()->terrainCost += PENALIZE_COST;
+				//through the grid, so its terrain cost bookkeeping stays right
+				const Node node = grid->GetNodeAt(_zombie.m_pathToTake.at(i));
+				grid->SetTerrainCost(node.nodeIndex, node.terrainCost + PENALIZE_COST);
 		}
 }
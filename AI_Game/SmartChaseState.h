@@ -5,17 +5,15 @@
 class SmartChaseState : public ChaseState
 {
 public:
-		SmartChaseState(Zombie* _ownerZombie);
+		SmartChaseState();
 		~SmartChaseState();
 
-		void Update(float _deltaTime) override;
-		
-private:
-		void FindPath();
-		void FollowPath(float _deltaTime);
-		void PenalizePath();
+		unsigned char Update(Zombie& _zombie, ZombieStateData& _data, float _deltaTime) override;
+		void Exit(Zombie& _zombie, ZombieStateData& _data) override;
 
 private:
-		bool m_requestedPath{ false };	///< flag whether the zombie has already send a path request manager, in order to avoid request flooding
+		void FindPath(Zombie& _zombie, ZombieStateData& _data);
+		/** \brief Moves along the shared flow field of the path request manager (towards the player), no path is requested */
+		void FollowFlowField(Zombie& _zombie, float _deltaTime);
+		static void PenalizePath(Zombie& _zombie);
 };
-
@@ -1,10 +1,8 @@
 #include "SmartPatrolState.h"
 
-#include "SmartChaseState.h"
-#include "RetreatState.h"
 #include "Zombie.h"
 
-SmartPatrolState::SmartPatrolState(Zombie* _ownerZombie) : PatrolState(_ownerZombie)
+SmartPatrolState::SmartPatrolState()
 {
 }
 
@@ -13,36 +11,37 @@ SmartPatrolState::~SmartPatrolState()
 {
 }
 
-void SmartPatrolState::Update(float _deltaTime)
+unsigned char SmartPatrolState::Update(Zombie& _zombie, ZombieStateData& _data, float _deltaTime)
 {
-		if (!m_zombie->m_pathToTake.empty())
+		if (!_zombie.m_pathToTake.empty())
 		{
-				FollowPath(_deltaTime);
+				_zombie.FollowPath(_deltaTime);
 		}
 		else
 		{
-				if (!m_requestedPath)
+				if (!_data.requestedPath)
 				{
-						FindPath();
+						FindPath(_zombie, _data);
 				}
 		}
 
-		if (m_zombie->m_health <= 50.0f)
+		if (_zombie.m_health <= 50.0f)
 		{
 				//chase player
-				if (!m_requestedPath)
+				if (!_data.requestedPath)
 				{
-						//only switch states if there is no path requested (or the callback will try to access deleted memory)
-						m_zombie->m_stateManager.SetState(new RetreatState(m_zombie));
+						//only switch states if there is no path requested (or the callback would give a path to the next state)
+						return LOW_HEALTH;
 				}
 		}
-		else if (CheckForPlayer())
+		else if (CanSeePlayer(_zombie) || SensesPlayer(_zombie))
 		{
-				//chase player
-				if (!m_requestedPath)
+				//chase player, also when another zombie close by has just seen him
+				if (!_data.requestedPath)
 				{
-						//only switch states if there is no path requested (or the callback will try to access deleted memory)
-						m_zombie->m_stateManager.SetState(new SmartChaseState(m_zombie));
+						//only switch states if there is no path requested (or the callback would give a path to the next state)
+						return PLAYER_SEEN;
 				}
 		}
+		return NO_EVENT;
 }
@@ -5,9 +5,8 @@
 class SmartPatrolState : public PatrolState
 {
 public:
-		SmartPatrolState(Zombie* _ownerZombie);
+		SmartPatrolState();
 		~SmartPatrolState();
 
-		void Update(float _deltaTime) override;
+		unsigned char Update(Zombie& _zombie, ZombieStateData& _data, float _deltaTime) override;
 };
-
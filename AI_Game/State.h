@@ -1,14 +1,23 @@
 #pragma once
 
-class StateManager;
-
+/** \brief One state of a StateManager. A state keeps nothing of the agents in it, so one instance of every state is shared
+	*  by all of them, what a state remembers of an agent is in the Data blob of the agent's StateManager */
+template <class Owner, class Data>
 class State
 {
 public:
+		enum : unsigned char { NO_EVENT = 0xFF };
+
 		State() {}
-		virtual ~State() {	 }
+		virtual ~State() {   }
+
+		/** \brief Called when an agent switches to the state */
+		virtual void Enter(Owner&, Data&) {}
 
-		virtual void Update(float _deltaTime) = 0;
+		/** \brief Updates an agent in the state
+		* @return the event which happened (a column of the transition table), or NO_EVENT */
+		virtual unsigned char Update(Owner& _owner, Data& _data, float _deltaTime) = 0;
 
-protected:
-};
\ No newline at end of file
+		/** \brief Called when an agent leaves the state */
+		virtual void Exit(Owner&, Data&) {}
+};
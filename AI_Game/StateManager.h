@@ -1,18 +1,89 @@
 #pragma once
 
-class State;
+#include "State.h"
 
+/** \brief Table driven FSM of one agent. The states are shared (one instance per state for all the agents) and the transitions
+	*  are a table of the next state for every state and event, so switching states doesn't allocate anything.
+	*  What the states need to remember of the agent is the Data blob (a small POD) */
+template <class Owner, class Data>
 class StateManager
 {
 public:
-		StateManager();
-		~StateManager();
+		typedef State<Owner, Data> StateType;
 
-		void Update(float _deltaTime);
+		enum : unsigned char { NO_STATE = 0xFF };
 
-		void SetState(State* _state);
+		/** \brief The states and the transitions of a kind of agent, static and shared by all of them */
+		struct Definition
+		{
+				StateType* const* states;         ///< the state of every id
+				const unsigned char* transitions; ///< numStates * numEvents, the next state of [state * numEvents + event] (NO_STATE to stay)
+				unsigned char numStates;
+				unsigned char numEvents;
+		};
+
+		StateManager() {}
+		~StateManager() { m_owner = nullptr; }
+
+		/** \brief Leaves the current state (if any) and enters _state of _definition
+		* \param _owner - the agent, passed to the states
+		* \param _definition - has to outlive the manager
+		* \param _state - the id to start in, NO_STATE for none */
+		void Start(Owner& _owner, const Definition& _definition, unsigned char _state)
+		{
+				Leave();
+				m_owner = &_owner;
+				m_definition = &_definition;
+				Switch(_state);
+		}
+
+		/** \brief Updates the current state and takes the transition of the event it returned */
+		void Update(float _deltaTime)
+		{
+				if (m_state == NO_STATE)
+				{
+						return;
+				}
+				const unsigned char event = m_definition->states[m_state]->Update(*m_owner, m_data, _deltaTime);
+				if (event < m_definition->numEvents)
+				{
+						const unsigned char next = m_definition->transitions[m_state * m_definition->numEvents + event];
+						if (next != NO_STATE)
+						{
+								Leave();
+								Switch(next);
+						}
+				}
+		}
+
+		/** \brief The id of the current state (NO_STATE before Start) */
+		unsigned char GetState() const noexcept { return m_state; }
+
+		Data& GetData() noexcept { return m_data; }
+		const Data& GetData() const noexcept { return m_data; }
 
 private:
-		State* m_currentState{ nullptr };
-};
+		void Leave()
+		{
+				if (m_state != NO_STATE)
+				{
+						m_definition->states[m_state]->Exit(*m_owner, m_data);
+						m_state = NO_STATE;
+				}
+		}
+
+		void Switch(unsigned char _state)
+		{
+				m_state = _state < m_definition->numStates ? _state : static_cast<unsigned char>(NO_STATE);
+				if (m_state != NO_STATE)
+				{
+						m_definition->states[m_state]->Enter(*m_owner, m_data);
+				}
+		}
 
+private:
+		Owner* m_owner{ nullptr };
+		const Definition* m_definition{ nullptr };
+		unsigned char m_state{ NO_STATE };
+		Data m_data{};
+};
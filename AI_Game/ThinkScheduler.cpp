@@ -0,0 +1,44 @@
+#include "ThinkScheduler.h"
+
+ThinkScheduler::ThinkScheduler(float _nearDistance, float _farDistance) :
+		m_nearDistance2(_nearDistance * _nearDistance), m_farDistance2(_farDistance * _farDistance)
+{
+}
+
+void ThinkScheduler::BeginFrame(const glm::vec2& _focus, const GameEngine::Camera2D& _camera)
+{
+		m_frame++;
+		m_focus = _focus;
+		m_viewRect = _camera.GetViewRect();
+		m_numThinking = 0;
+}
+
+unsigned int ThinkScheduler::GetInterval(const glm::vec2& _position, const glm::vec2& _dimensions) const
+{
+		//in view, so every frame
+		if (_position.x + _dimensions.x > m_viewRect.x && _position.x < m_viewRect.x + m_viewRect.z &&
+				_position.y + _dimensions.y > m_viewRect.y && _position.y < m_viewRect.y + m_viewRect.w)
+		{
+				return 1;
+		}
+
+		const glm::vec2 toFocus = _position + _dimensions / 2.0f - m_focus;
+		const float distance2 = toFocus.x * toFocus.x + toFocus.y * toFocus.y;
+		if (distance2 < m_nearDistance2)
+		{
+				return 2;
+		}
+		return distance2 < m_farDistance2 ? 4 : MAX_INTERVAL;
+}
+
+bool ThinkScheduler::ShouldThink(size_t _id, const glm::vec2& _position, const glm::vec2& _dimensions)
+{
+		//the intervals are powers of 2, so every agent of an interval thinks on the frame its id picks out of it
+		const unsigned int interval = GetInterval(_position, _dimensions);
+		if (((m_frame + _id) & (interval - 1)) != 0)
+		{
+				return false;
+		}
+		m_numThinking++;
+		return true;
+}
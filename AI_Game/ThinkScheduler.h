@@ -0,0 +1,47 @@
+#pragma once
+
+#include <glm\vec2.hpp>
+#include <glm\vec4.hpp>
+
+#include <GameEngine\Camera2D.h>
+
+/** \brief Decides which agents run their full logic (think) this frame, by their level of detail.
+	*  The agents in view think every frame, the others every 2, 4 or MAX_INTERVAL frames the further they are from the focus
+	*  (the player). Every agent thinks on another frame of its interval (by its id), so the thinking of the far agents is spread
+	*  over the frames instead of all of them thinking on the same one. The agents which don't think only keep moving (see Zombie::Coast) */
+class ThinkScheduler
+{
+public:
+		enum : unsigned int { MAX_INTERVAL = 8 }; ///< the most frames between two thinks, a power of 2 like the other intervals
+
+		/** \brief Sets the distances to the focus of the levels of detail
+		* \param _nearDistance - the agents out of view closer than this think every 2 frames
+		* \param _farDistance - every 4 frames closer than this, every MAX_INTERVAL frames further away */
+		ThinkScheduler(float _nearDistance, float _farDistance);
+		~ThinkScheduler() {}
+
+		/** \brief Starts the next frame
+		* \param _focus - the world position the distances are taken to
+		* \param _camera - the agents in its view think every frame */
+		void BeginFrame(const glm::vec2& _focus, const GameEngine::Camera2D& _camera);
+
+		/** \brief The number of frames between two thinks of an agent
+		* \param _position - the bottom left of the agent
+		* \param _dimensions - the size of the agent */
+		unsigned int GetInterval(const glm::vec2& _position, const glm::vec2& _dimensions) const;
+
+		/** \brief Check if the agent _id (any number which stays the same for the agent, like its index) thinks this frame */
+		bool ShouldThink(size_t _id, const glm::vec2& _position, const glm::vec2& _dimensions);
+
+		/** \brief The number of ShouldThink calls which returned true since BeginFrame */
+		size_t GetNumThinking() const noexcept { return m_numThinking; }
+
+private:
+		float m_nearDistance2{ 0.0f }; ///< squared
+		float m_farDistance2{ 0.0f };  ///< squared
+
+		unsigned int m_frame{ 0 };
+		glm::vec2 m_focus{ 0.0f, 0.0f };
+		glm::vec4 m_viewRect{ 0.0f, 0.0f, 0.0f, 0.0f }; ///< the bottom left x, y, width and height of the camera view this frame
+		size_t m_numThinking{ 0 };
+};
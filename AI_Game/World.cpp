@@ -1,110 +1,141 @@
 #include "World.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
 #include <fstream>
 #include <GameEngine\ResourceManager.h>
+#include <GameEngine\JobSystem.h>
 
-World::World() :																				//Terrain(cost, isWater, isWalkable, texture)
-		m_grassTerrain(std::make_shared<Terrain>(1, false, true, GameEngine::ResourceManager::GetTexture("Textures/grass.png"))),
-		m_redBrickTerrain(std::make_shared<Terrain>(1, false, false, GameEngine::ResourceManager::GetTexture("Textures/red_bricks.png"))),
-		m_lightBrickTerrain(std::make_shared<Terrain>(1, false, false, GameEngine::ResourceManager::GetTexture("Textures/light_bricks.png"))),
-		m_glassTerrain(std::make_shared<Terrain>(1, false, false, GameEngine::ResourceManager::GetTexture("Textures/glass.png"))),
-		m_riverTerrain(std::make_shared<Terrain>(5, true, true, GameEngine::ResourceManager::GetTexture("Textures/water.png")))
+namespace
 {
+		//the chunks out of view which are built ahead of time per frame, a chunk costs CHUNK_SIZE * CHUNK_SIZE sprites
+		constexpr int CHUNK_PREFETCHES_PER_FRAME = 1;
+		//how many chunks a built chunk can get away from the view before it's evicted, more than the prefetch band of 1 so going back and forth doesn't rebuild it
+		constexpr int CHUNK_EVICT_DISTANCE = 2;
+		//below this many tiles per thread the generation threads would cost more than they save
+		constexpr size_t TILES_PER_WORKER = 64 * 1024;
+
+		//a hash of the seed and the tile index (lowbias32), cheap and free of state unlike a generator
+		inline unsigned int TileNoise(unsigned int _seed, int _index)
+		{
+				unsigned int x = _seed ^ (static_cast<unsigned int>(_index) * 0x9E3779B9u);
+				x ^= x >> 16;
+				x *= 0x7FEB352Du;
+				x ^= x >> 15;
+				x *= 0x846CA68Bu;
+				x ^= x >> 16;
+				return x;
+		}
+}
+
+World::World()
+{
+		//the terrain table, indexed by TerrainType (Terrain(cost, isWater, isWalkable, texture))
+		m_terrains.emplace_back(1, false, true, GameEngine::ResourceManager::GetTexture("Textures/grass.png"));
+		m_terrains.emplace_back(1, false, false, GameEngine::ResourceManager::GetTexture("Textures/red_bricks.png"));
+		m_terrains.emplace_back(1, false, false, GameEngine::ResourceManager::GetTexture("Textures/light_bricks.png"));
+		m_terrains.emplace_back(1, false, false, GameEngine::ResourceManager::GetTexture("Textures/glass.png"));
+		m_terrains.emplace_back(5, true, true, GameEngine::ResourceManager::GetTexture("Textures/water.png"));
 		m_randomGenerator.GenSeed(GameEngine::SeedType::CLOCK_TICKS);
 }
 World::~World()
 {
-		m_terrainBatch.Dispose();
+		ClearTerrainChunks();
 		m_tiles.clear();
 		m_zombieSpawnPositions.clear();
 }
-void World::GenerateRandomTerrain()
-{
-		m_width = m_randomGenerator.GenRandInt(50, 150);
-		m_height = m_randomGenerator.GenRandInt(25, 75);
-		m_tiles.resize(m_width * m_height);
-
-		m_worldGrid = std::make_shared<Grid>(m_width, m_height, TILE_WIDTH);
-
-		for (size_t i = 0; i < m_tiles.size(); i++)
-		{
-				//get the 2d coordinates from the 1d array
-				int x = i % m_width;
-				int y = i / m_width;
-
-				int randNum = m_randomGenerator.GenRandInt(0, 20);
-				// Sprinkle some hills.
-				switch (randNum)
-				{
-				case 0:
-				{
-						m_tiles.at(i) = m_redBrickTerrain;
-						m_worldGrid->SetWalkableAt(glm::ivec2(x, y), m_tiles.at(i).lock()->IsWalkable());
-						m_worldGrid->SetTerrainCost(glm::ivec2(x, y), m_tiles.at(i).lock()->MovementCost());
-						break;
-				}
-				case 1:
-				{
-						m_tiles.at(i) = m_lightBrickTerrain;
-						m_worldGrid->SetWalkableAt(glm::ivec2(x, y), m_tiles.at(i).lock()->IsWalkable());
-						m_worldGrid->SetTerrainCost(glm::ivec2(x, y), m_tiles.at(i).lock()->MovementCost());
-						break;
-				}
-				case 2:
-				{
-						m_tiles.at(i) = m_glassTerrain;
-						m_worldGrid->SetWalkableAt(glm::ivec2(x, y), m_tiles.at(i).lock()->IsWalkable());
-						m_worldGrid->SetTerrainCost(glm::ivec2(x, y), m_tiles.at(i).lock()->MovementCost());
-						break;
-				}
-				default:
-				{
-						m_tiles.at(i) = m_grassTerrain;
-						m_worldGrid->SetWalkableAt(glm::ivec2(x, y), m_tiles.at(i).lock()->IsWalkable());
-						m_worldGrid->SetTerrainCost(glm::ivec2(x, y), m_tiles.at(i).lock()->MovementCost());
-						break;
-				}
-				}
-		}
-
-		// Lay a river.
-		{
-				int x = m_randomGenerator.GenRandInt(0, m_width);
-				for (int y = 0; y < m_height; y++)
-				{
-						int index = y * m_width + x;
-
-						m_tiles.at(index) = m_riverTerrain;
-						m_worldGrid->SetWalkableAt(glm::ivec2(x, y), m_tiles.at(index).lock()->IsWalkable());
-						m_worldGrid->SetTerrainCost(glm::ivec2(x, y), m_tiles.at(index).lock()->MovementCost());
-				}
-		}
-
-		//set the start player pos
-		{
-				int index = m_randomGenerator.GenRandInt(0, m_tiles.size());
-				while (!m_tiles.at(index).lock()->IsWalkable())
-				{
-						index = m_randomGenerator.GenRandInt(0, m_tiles.size());
-				}
-				int x = index % m_width;
-				int y = index / m_width;
-				m_startPlayerPos = glm::vec2((x * TILE_WIDTH), (y * TILE_WIDTH));
-		}
-
-		//set a couple of zombie spawn points
-		for (size_t i = 0; i < 3; i++)
-		{
-				int index = m_randomGenerator.GenRandInt(0, m_tiles.size());
-				while (!m_tiles.at(index).lock()->IsWalkable() && index != (m_startPlayerPos.y * m_width + m_startPlayerPos.x))
-				{
-						index = m_randomGenerator.GenRandInt(0, m_tiles.size());
-				}
-				int x = index % m_width;
-				int y = index / m_width;
-				m_zombieSpawnPositions.emplace_back(x * TILE_WIDTH, y * TILE_WIDTH);
-		}
-}
-
+void World::GenerateRandomTerrain()
+{
+		m_width = m_randomGenerator.GenRandInt(50, 150);
+		m_height = m_randomGenerator.GenRandInt(25, 75);
+		ClearTerrainChunks();
+
+		//the tiles and the grid in bulk, instead of going through the grid tile by tile
+		GenerateTiles(m_width, m_height, static_cast<unsigned int>(m_randomGenerator.GenRandInt(0, INT_MAX)), m_tiles);
+		m_worldGrid = BuildGrid(m_width, m_height, m_tiles);
+
+		//set the start player pos
+		{
+				int index = m_randomGenerator.GenRandInt(0, m_tiles.size() - 1);
+				while (!GetTile(index).IsWalkable())
+				{
+						index = m_randomGenerator.GenRandInt(0, m_tiles.size() - 1);
+				}
+				int x = index % m_width;
+				int y = index / m_width;
+				m_startPlayerPos = glm::vec2((x * TILE_WIDTH), (y * TILE_WIDTH));
+		}
+
+		//set a couple of zombie spawn points
+		for (size_t i = 0; i < 3; i++)
+		{
+				int index = m_randomGenerator.GenRandInt(0, m_tiles.size() - 1);
+				while (!GetTile(index).IsWalkable() && index != (m_startPlayerPos.y * m_width + m_startPlayerPos.x))
+				{
+						index = m_randomGenerator.GenRandInt(0, m_tiles.size() - 1);
+				}
+				int x = index % m_width;
+				int y = index / m_width;
+				m_zombieSpawnPositions.emplace_back(x * TILE_WIDTH, y * TILE_WIDTH);
+		}
+
+		//the pathfinding abstraction and the landmarks of the new grid
+		m_worldHierarchy = std::make_shared<HierarchicalGrid>(m_worldGrid, CLUSTER_SIZE, Diagonal::IFNOWALLS);
+		m_worldLandmarks = std::make_shared<LandmarkTable>(m_worldGrid, NUM_LANDMARKS, Diagonal::IFNOWALLS);
+}
+
+void World::GenerateTiles(int _width, int _height, unsigned int _seed, std::vector<std::uint8_t>& _tiles)
+{
+		_tiles.resize(_width * _height);
+		//a river runs along one column
+		const int riverX = static_cast<int>(TileNoise(_seed, -1) % static_cast<unsigned int>(_width));
+
+		//every tile only depends on the seed and its index, so the rows can be filled in any order and by any thread
+		auto fillRows = [&_tiles, _width, _seed, riverX](int _firstRow, int _lastRow)
+		{
+				// Sprinkle some hills, 1 in 21 tiles of each kind like before
+				static const TerrainType HILLS[3] = { TerrainType::RED_BRICK, TerrainType::LIGHT_BRICK, TerrainType::GLASS };
+				for (int y = _firstRow; y < _lastRow; y++)
+				{
+						std::uint8_t* row = _tiles.data() + y * _width;
+						for (int x = 0; x < _width; x++)
+						{
+								const unsigned int roll = TileNoise(_seed, y * _width + x) % 21;
+								row[x] = static_cast<std::uint8_t>(roll < 3 ? HILLS[roll] : TerrainType::GRASS);
+						}
+						row[riverX] = static_cast<std::uint8_t>(TerrainType::RIVER);
+				}
+		};
+
+		const size_t rowsPerChunk = std::max<size_t>(1, TILES_PER_WORKER / std::max(1, _width));
+		GameEngine::JobSystem::Get().ParallelFor(static_cast<size_t>(_height), rowsPerChunk, [&fillRows](size_t _begin, size_t _end)
+		{
+				fillRows(static_cast<int>(_begin), static_cast<int>(_end));
+		});
+}
+
+std::shared_ptr<Grid> World::BuildGrid(int _width, int _height, const std::vector<std::uint8_t>& _tiles) const
+{
+		//the walkability and cost of every terrain type, looked up once instead of per tile
+		std::array<bool, 256> walkableByType{};
+		std::array<unsigned char, 256> costByType{};
+		for (size_t type = 0; type < m_terrains.size(); type++)
+		{
+				walkableByType[type] = m_terrains[type].IsWalkable();
+				costByType[type] = static_cast<unsigned char>(std::min(std::max(m_terrains[type].MovementCost(), 0), int(Grid::MAX_TERRAIN_COST)));
+		}
+
+		//a single pass deriving both layers of the grid
+		std::vector<bool> walkableMatrix(_tiles.size());
+		std::vector<unsigned char> terrainCosts(_tiles.size());
+		for (size_t i = 0; i < _tiles.size(); i++)
+		{
+				walkableMatrix[i] = walkableByType[_tiles[i]];
+				terrainCosts[i] = costByType[_tiles[i]];
+		}
+		return std::make_shared<Grid>(_width, _height, TILE_WIDTH, walkableMatrix, terrainCosts);
+}
+
 void World::LoadTerrainFromFile(const std::string & _filePath)
 {
 		std::ifstream file;
@@ -116,152 +147,181 @@ void World::LoadTerrainFromFile(const std::string & _filePath)
 				throw std::runtime_error("File " + _filePath + " failed to load");
 		}
 
-		std::vector<std::string> terrainData;
-		std::string terrainLine;
+		ClearTerrainChunks();
+		m_tiles.clear();
+		m_width = 0;
+		m_height = 0;
 
-		// Read the level data
+		//parse the level line by line straight into the tiles, so only one line of the text is in memory
+		std::string terrainLine;
 		while (std::getline(file, terrainLine))
 		{
-				terrainData.push_back(terrainLine);
-		}
-
-		m_width = terrainData.at(0).size();
-		m_height = terrainData.size();
-		m_tiles.resize(m_width * m_height);
-
-		m_worldGrid = std::make_shared<Grid>(m_width, m_height, TILE_WIDTH);
-
-		//Submit all the tiles to the spritebatch
-		for (size_t i = 0; i < m_tiles.size(); i++)
-		{
-				//get the 2d coordinates from the 1d array
-				int x = i % m_width;
-				int y = i / m_width;
-
-				// Grab the tile
-				char tile = terrainData.at(y).at(x);
-
-				// Process the tile
-				switch (tile)
-				{
-				case 'b':
-				case 'B':
-				{
-						m_tiles.at(i) = m_redBrickTerrain;
-						m_worldGrid->SetWalkableAt(glm::ivec2(x, y), m_tiles.at(i).lock()->IsWalkable());
-						m_worldGrid->SetTerrainCost(glm::ivec2(x, y), m_tiles.at(i).lock()->MovementCost());
-						break;
-				}
-				case 'g':
-				case 'G':
-				{
-						m_tiles.at(i) = m_glassTerrain;
-						m_worldGrid->SetWalkableAt(glm::ivec2(x, y), m_tiles.at(i).lock()->IsWalkable());
-						m_worldGrid->SetTerrainCost(glm::ivec2(x, y), m_tiles.at(i).lock()->MovementCost());
-						break;
-				}
-				case 'l':
-				case 'L':
+				if (m_height == 0)
 				{
-						m_tiles.at(i) = m_lightBrickTerrain;
-						m_worldGrid->SetWalkableAt(glm::ivec2(x, y), m_tiles.at(i).lock()->IsWalkable());
-						m_worldGrid->SetTerrainCost(glm::ivec2(x, y), m_tiles.at(i).lock()->MovementCost());
-						break;
+						m_width = terrainLine.size();
 				}
-				case 'w':
-				case 'W':
+				else if (terrainLine.size() < static_cast<size_t>(m_width))
 				{
-						m_tiles.at(i) = m_riverTerrain;
-						m_worldGrid->SetWalkableAt(glm::ivec2(x, y), m_tiles.at(i).lock()->IsWalkable());
-						m_worldGrid->SetTerrainCost(glm::ivec2(x, y), m_tiles.at(i).lock()->MovementCost());
-						break;
+						throw std::runtime_error("Line " + std::to_string(m_height) + " of " + _filePath + " is shorter than the first one");
 				}
-				case '@':
-				{
-						m_tiles.at(i) = m_grassTerrain;
-						m_worldGrid->SetWalkableAt(glm::ivec2(x, y), m_tiles.at(i).lock()->IsWalkable());
-						m_worldGrid->SetTerrainCost(glm::ivec2(x, y), m_tiles.at(i).lock()->MovementCost());
-						m_startPlayerPos = glm::vec2((x * TILE_WIDTH), (y * TILE_WIDTH));
-						break;
-				}
-				case 'z':
-				case 'Z':
-				{
-						m_tiles.at(i) = m_grassTerrain;
-						m_worldGrid->SetWalkableAt(glm::ivec2(x, y), m_tiles.at(i).lock()->IsWalkable());
-						m_worldGrid->SetTerrainCost(glm::ivec2(x, y), m_tiles.at(i).lock()->MovementCost());
-						m_zombieSpawnPositions.emplace_back(x * TILE_WIDTH, y * TILE_WIDTH);
-						break;
-				}
-				case 'p':
-				case 'P':
-				{
-						m_tiles.at(i) = m_grassTerrain;
-						m_worldGrid->SetWalkableAt(glm::ivec2(x, y), m_tiles.at(i).lock()->IsWalkable());
-						m_worldGrid->SetTerrainCost(glm::ivec2(x, y), m_tiles.at(i).lock()->MovementCost());
-						m_patrolWaypoints.emplace_back(x * TILE_WIDTH, y * TILE_WIDTH);
-						break;
-				}
-				case '.':
+
+				const int y = m_height;
+				for (int x = 0; x < m_width; x++)
 				{
-						m_tiles.at(i) = m_grassTerrain;
-						m_worldGrid->SetWalkableAt(glm::ivec2(x, y), m_tiles.at(i).lock()->IsWalkable());
-						m_worldGrid->SetTerrainCost(glm::ivec2(x, y), m_tiles.at(i).lock()->MovementCost());
-						break;
-				}
-				default:
-						std::printf("Unexpected symbol %c at (%d,%d)", tile, x, y);
-						break;
+						// Grab the tile
+						char tile = terrainLine[x];
+
+						// Process the tile
+						TerrainType type = TerrainType::GRASS;
+						switch (tile)
+						{
+						case 'b':
+						case 'B':
+								type = TerrainType::RED_BRICK;
+								break;
+						case 'g':
+						case 'G':
+								type = TerrainType::GLASS;
+								break;
+						case 'l':
+						case 'L':
+								type = TerrainType::LIGHT_BRICK;
+								break;
+						case 'w':
+						case 'W':
+								type = TerrainType::RIVER;
+								break;
+						case '@':
+								m_startPlayerPos = glm::vec2((x * TILE_WIDTH), (y * TILE_WIDTH));
+								break;
+						case 'z':
+						case 'Z':
+								m_zombieSpawnPositions.emplace_back(x * TILE_WIDTH, y * TILE_WIDTH);
+								break;
+						case 'p':
+						case 'P':
+								m_patrolWaypoints.emplace_back(x * TILE_WIDTH, y * TILE_WIDTH);
+								break;
+						case '.':
+								break;
+						default:
+								std::printf("Unexpected symbol %c at (%d,%d)", tile, x, y);
+								break;
+						}
+						m_tiles.push_back(static_cast<std::uint8_t>(type));
 				}
+				m_height++;
 		}
+
+		//the grid only once the size is known
+		m_worldGrid = BuildGrid(m_width, m_height, m_tiles);
+
+		//the pathfinding abstraction and the landmarks of the new grid
+		m_worldHierarchy = std::make_shared<HierarchicalGrid>(m_worldGrid, CLUSTER_SIZE, Diagonal::IFNOWALLS);
+		m_worldLandmarks = std::make_shared<LandmarkTable>(m_worldGrid, NUM_LANDMARKS, Diagonal::IFNOWALLS);
 }
 
-void World::DrawUnsaved()
+void World::BuildTerrainChunk(int _x, int _y)
 {
-		//Initialize the spritebatch
-		m_terrainBatch.Init();
-		//Clear it and set the sort type
-		m_terrainBatch.Begin();
+		GameEngine::StaticSpriteLayer& chunk = m_terrainChunks[_y * m_numXChunks + _x];
+		//Initialize the layer
+		chunk.Init();
+		chunk.Clear();
 
 		//UV coordinates for all sprites
 		glm::vec4 uvRect(0.0f, 0.0f, 1.0f, 1.0f);
 
-		//Sumbit all the sprites to the batch
-		for (size_t i = 0; i < m_tiles.size(); i++)
+		//Sumbit the sprites of the chunk's tiles
+		for (int y = _y * CHUNK_SIZE; y < std::min((_y + 1) * CHUNK_SIZE, m_height); y++)
 		{
-				//get the 2d coordinates from the 1d array
-				int x = i % m_width;
-				int y = i / m_width;
-
-				// Get dest rect
-				glm::vec4 destRect(x * TILE_WIDTH, y * TILE_WIDTH, TILE_WIDTH, TILE_WIDTH);
+				for (int x = _x * CHUNK_SIZE; x < std::min((_x + 1) * CHUNK_SIZE, m_width); x++)
+				{
+						// Get dest rect
+						glm::vec4 destRect(x * TILE_WIDTH, y * TILE_WIDTH, TILE_WIDTH, TILE_WIDTH);
 
-				m_terrainBatch.Draw(destRect,
-						uvRect,
-						m_tiles.at(i).lock()->GetTexture().id,
-						0.0f,
-						GameEngine::ColorRGBA8(255, 255));
+						chunk.Add(destRect,
+								uvRect,
+								GetTile(x, y).GetTexture().id,
+								0.0f,
+								GameEngine::ColorRGBA8(255, 255));
+				}
 		}
-		//Sort the sprites and create the batches
-		m_terrainBatch.End();
+		/* No need to submit the sprites every frame considering the world is unchanging,
+				the layer keeps the vertices on the GPU until the chunk is evicted */
+		m_chunkBuilt[_y * m_numXChunks + _x] = 1;
+		m_builtChunks.push_back(_y * m_numXChunks + _x);
+}
 
-		//Render all the sprite batches
-		m_terrainBatch.RenderBatch();
+void World::EvictTerrainChunk(int _index)
+{
+		//a new layer gives the CPU copy of the vertices back too
+		m_terrainChunks[_index].Dispose();
+		m_terrainChunks[_index] = GameEngine::StaticSpriteLayer();
+		m_chunkBuilt[_index] = 0;
+}
 
-		/* No need to submit the sprites every frame considering the world is unchanging,
-				 so save the spritebatch (by not clearing it in Begin() and just use the render call in the future */
-		m_savedBatch = true;
+void World::ClearTerrainChunks()
+{
+		for (int index : m_builtChunks)
+		{
+				EvictTerrainChunk(index);
+		}
+		m_builtChunks.clear();
+		//sized again by the next Draw, for the size of the new world
+		m_terrainChunks.clear();
+		m_chunkBuilt.clear();
 }
 
-void World::Draw()
+void World::Draw(const GameEngine::Camera2D& _camera)
 {
-		if (!m_savedBatch)
+		if (m_chunkBuilt.empty())
 		{
-				DrawUnsaved();
+				m_numXChunks = (m_width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+				m_numYChunks = (m_height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+				m_terrainChunks.resize(m_numXChunks * m_numYChunks);
+				m_chunkBuilt.assign(m_numXChunks * m_numYChunks, 0);
 		}
-		else
+		//only render the chunks the view overlaps, so the cost follows the screen size instead of the world size
+		const glm::vec4 view = _camera.GetViewRect();
+		const float chunkWidth = CHUNK_SIZE * TILE_WIDTH;
+		const int firstX = static_cast<int>(std::floor(view.x / chunkWidth));
+		const int firstY = static_cast<int>(std::floor(view.y / chunkWidth));
+		const int lastX = static_cast<int>(std::floor((view.x + view.z) / chunkWidth));
+		const int lastY = static_cast<int>(std::floor((view.y + view.w) / chunkWidth));
+
+		//the chunks in view are built right away, the ones around it ahead of time but only a few per frame so moving doesn't stall
+		int numPrefetches = CHUNK_PREFETCHES_PER_FRAME;
+		for (int y = std::max(firstY - 1, 0); y <= std::min(lastY + 1, m_numYChunks - 1); y++)
 		{
-				//render the whole world in the saved terrain batch
-				m_terrainBatch.RenderBatch();
+				for (int x = std::max(firstX - 1, 0); x <= std::min(lastX + 1, m_numXChunks - 1); x++)
+				{
+						const bool inView = x >= firstX && x <= lastX && y >= firstY && y <= lastY;
+						if (!m_chunkBuilt[y * m_numXChunks + x] && (inView || numPrefetches-- > 0))
+						{
+								BuildTerrainChunk(x, y);
+						}
+						if (inView)
+						{
+								m_terrainChunks[y * m_numXChunks + x].Render();
+						}
+				}
 		}
-}
+
+		//the chunks which got further than CHUNK_EVICT_DISTANCE from the view are freed, so the memory follows the view too
+		for (size_t i = 0; i < m_builtChunks.size();)
+		{
+				const int index = m_builtChunks[i];
+				const int x = index % m_numXChunks;
+				const int y = index / m_numXChunks;
+				if (x < firstX - CHUNK_EVICT_DISTANCE || x > lastX + CHUNK_EVICT_DISTANCE || y < firstY - CHUNK_EVICT_DISTANCE || y > lastY + CHUNK_EVICT_DISTANCE)
+				{
+						EvictTerrainChunk(index);
+						m_builtChunks[i] = m_builtChunks.back();
+						m_builtChunks.pop_back();
+				}
+				else
+				{
+						i++;
+				}
+		}
+}
\ No newline at end of file
@@ -1,11 +1,32 @@
 #pragma once
+#include <cstdint>
+
 #include "Terrain.h"
 #include "Grid.h"
+#include "HierarchicalGrid.h"
+#include "LandmarkTable.h"
 
 #include <GameEngine\Random.h>
-#include <GameEngine\SpriteBatch.h>
+#include <GameEngine\StaticSpriteLayer.h>
+#include <GameEngine\Camera2D.h>
 
 constexpr float TILE_WIDTH = 32.0f;
+//width and height (in tiles) of the clusters of the pathfinding hierarchy
+constexpr int CLUSTER_SIZE = 16;
+//the landmarks of the A* heuristic on the world grid
+constexpr int NUM_LANDMARKS = 8;
+//width and height (in tiles) of the chunks the terrain is drawn in
+constexpr int CHUNK_SIZE = 32;
+
+/** \brief The terrains of the tiles, the indices of the terrain table of the world */
+enum class TerrainType : std::uint8_t
+{
+		GRASS,
+		RED_BRICK,
+		LIGHT_BRICK,
+		GLASS,
+		RIVER
+};
 
 /** \brief World class for the world generation.*/
 class World
@@ -16,42 +37,56 @@ public:
 		/** \brief Generates a random terrain */
 		void GenerateRandomTerrain();
 
+		/** \brief The stages of GenerateRandomTerrain, they don't touch the world (or the GPU), so a level can be made on a background thread
+		* GenerateTiles fills _tiles with the TerrainType of every tile, it only depends on _seed */
+		static void GenerateTiles(int _width, int _height, unsigned int _seed, std::vector<std::uint8_t>& _tiles);
+		/** \brief Builds the grid of _tiles in one go, with the walkability and cost of their terrains */
+		std::shared_ptr<Grid> BuildGrid(int _width, int _height, const std::vector<std::uint8_t>& _tiles) const;
+
 		/** \brief Loads a premade world from a file */
 		void LoadTerrainFromFile(const std::string& _filePath);
 
-		/** \brief Draws the world */
-		void Draw();
+		/** \brief Draws the chunks of the world which are in the view of _camera */
+		void Draw(const GameEngine::Camera2D& _camera);
 
 		/** \brief Getters */
 		int GetWidth() 																																									const { return m_width; }
 		int GetHeight() 																																								const { return m_height; }
-		const std::weak_ptr<Terrain> GetTile(int _x, int _y)				const { return m_tiles.at(_y * m_width + _x);}
-		const std::weak_ptr<Terrain> GetTile(int _index)								const { return m_tiles.at(_index); }
+		const Terrain& GetTile(int _x, int _y)                  const { return m_terrains[m_tiles[_y * m_width + _x]]; }
+		const Terrain& GetTile(int _index)                      const { return m_terrains[m_tiles[_index]]; }
+		TerrainType GetTileType(int _index)                     const { return static_cast<TerrainType>(m_tiles[_index]); }
 		const glm::vec2& GetStartPlayerPos() 																			const { return m_startPlayerPos; }
 		const std::vector<glm::vec2>& GetZombieStartPositions() const { return m_zombieSpawnPositions; }
 		const std::vector<glm::vec2>& GetPatrolWaypoints()						const { return m_patrolWaypoints; }
 		std::weak_ptr<Grid> GetWorldGrid()																						const { return m_worldGrid; }
+		std::weak_ptr<HierarchicalGrid> GetWorldHierarchy()          const { return m_worldHierarchy; }
+		std::weak_ptr<LandmarkTable> GetWorldLandmarks()             const { return m_worldLandmarks; }
 
 private:
-		/** \brief Draw the world normally and save it for faster drawing in the future */
-		void DrawUnsaved();
+		/** \brief Submit the tiles of chunk (_x, _y) to its terrain layer (the layer stays on the GPU until the chunk is evicted) */
+		void BuildTerrainChunk(int _x, int _y);
+		/** \brief Frees the terrain layer of chunk _index */
+		void EvictTerrainChunk(int _index);
+		/** \brief Evicts all the chunks, before the world changes */
+		void ClearTerrainChunks();
 private:
 		int m_width{ 0 }; ///< width of the world (in tile-space)
 		int m_height{ 0 }; ///< height of the world (in tile-space)
-		bool m_savedBatch{ false }; ///< flag whether the spritebatch for drawing has been saved
+		int m_numXChunks{ 0 }; ///< the number of chunks on the x axis
+		int m_numYChunks{ 0 }; ///< the number of chunks on the y axis
 
-		std::shared_ptr<Terrain> m_grassTerrain;						///< shared pointer for the grass terrain for the Flyweight pattern
-		std::shared_ptr<Terrain> m_redBrickTerrain;			///< shared pointer for the red brick terrain for the Flyweight pattern
-		std::shared_ptr<Terrain> m_lightBrickTerrain; ///< shared pointer for the light brick terrain for the Flyweight pattern
-		std::shared_ptr<Terrain> m_glassTerrain;						///< shared pointer for the glass terrain for the Flyweight pattern
-		std::shared_ptr<Terrain> m_riverTerrain;						///< shared pointer for the river terrain for the Flyweight pattern
 		std::shared_ptr<Grid>				m_worldGrid;									///< shared pointer for the whole world
+		std::shared_ptr<HierarchicalGrid> m_worldHierarchy; ///< the HPA* clusters of m_worldGrid (for the zombies' movement)
+		std::shared_ptr<LandmarkTable> m_worldLandmarks;    ///< the ALT landmarks of m_worldGrid (for the zombies' movement)
 
-		std::vector<std::weak_ptr<Terrain>> m_tiles;   ///< set of weak pointers to the shared terrain tiles (the flyweight pattern)
+		std::vector<Terrain> m_terrains; ///< the terrain of every TerrainType, shared by all the tiles of the type (the flyweight pattern)
+		std::vector<std::uint8_t> m_tiles; ///< the TerrainType of every tile, row by row
 		std::vector<glm::vec2> m_zombieSpawnPositions; ///< set of world space spawn positions for the zombies
 		std::vector<glm::vec2> m_patrolWaypoints; ///< set of world space spawn positions for the zombies
 		glm::vec2 m_startPlayerPos;																				///< world space spawn position for the player
 		GameEngine::Random m_randomGenerator;										///< random number generator
-		GameEngine::SpriteBatch m_terrainBatch;							 ///< the spritebatch for the terrain(world) rendering
+		std::vector<GameEngine::StaticSpriteLayer> m_terrainChunks; ///< the sprite layer of every chunk (row by row) for the terrain(world) rendering, only the ones near the view are built
+		std::vector<unsigned char> m_chunkBuilt; ///< by chunk, whether its layer is built
+		std::vector<int> m_builtChunks; ///< the indices of the built chunks, so the eviction doesn't walk all of them
 };
 
@@ -1,5 +1,4 @@
 #include "Zombie.h"
-#include "PatrolState.h"
 
 Zombie::Zombie()
 {
@@ -11,7 +10,7 @@ Zombie::Zombie(float _speed, float _health, const glm::vec2 & _startPos, const G
 		Agent(_speed, _health, _startPos, _texture, _color, _world), m_player(_player), m_prManager(_prManager), m_patrolWaypoints(_patrolWaypoints)
 {
 		m_algoToUse = Algorithm::ASTAR;
-		m_stateManager.SetState(new PatrolState(this));
+		m_stateManager.Start(*this, ZombieState::GetDefinition(), ZombieState::PATROL);
 }
 
 
@@ -38,7 +37,108 @@ void Zombie::Init(float _speed, float _health, const glm::vec2 & _startPos, cons
 
 void Zombie::Update(float _deltaTime)
 {
+		m_pathFollowingSlot = PathFollowingBatch::NO_SLOT;
 		m_stateManager.Update(_deltaTime);
-		// Do collision
+		// Do collision (in ApplyPathFollowing if the batch moves the zombie)
+		if (m_pathFollowingSlot == PathFollowingBatch::NO_SLOT)
+		{
+				CollideWithLevel();
+		}
+}
+
+void Zombie::Coast(float _deltaTime)
+{
+		m_pathFollowingSlot = PathFollowingBatch::NO_SLOT;
+		if (!m_pathToTake.empty())
+		{
+				FollowPath(_deltaTime);
+		}
+		else
+		{
+				m_worldPos += m_direction * m_movementSpeed * _deltaTime;
+		}
+		if (m_pathFollowingSlot == PathFollowingBatch::NO_SLOT)
+		{
+				CollideWithLevel();
+		}
+}
+
+void Zombie::ApplyPathFollowing()
+{
+		if (m_pathFollowingSlot == PathFollowingBatch::NO_SLOT)
+		{
+				return;
+		}
+		m_worldPos = m_pathFollowing->GetPosition(m_pathFollowingSlot);
+		m_direction = m_pathFollowing->GetDirection(m_pathFollowingSlot);
+		//the path is gone if the zombie switched states after it was added
+		if (m_pathFollowing->ReachedWaypoint(m_pathFollowingSlot) && !m_pathToTake.empty())
+		{
+				LeaveWaypoint();
+		}
+		m_pathFollowingSlot = PathFollowingBatch::NO_SLOT;
 		CollideWithLevel();
+}
+
+bool Zombie::IsPlayerInRange() const
+{
+		constexpr glm::vec2 zombieRange = glm::vec2(AGENT_DIAMETER * 15.0f);
+
+		auto upperBoundary = glm::greaterThanEqual(m_worldPos + zombieRange, m_player.lock()->GetCenterPos());
+		auto lowerBoundary = glm::lessThanEqual(m_worldPos - zombieRange, m_player.lock()->GetCenterPos());
+
+		return upperBoundary.x && lowerBoundary.x && upperBoundary.y && lowerBoundary.y;
+}
+
+void Zombie::LookForPlayer(LineOfSightBatch& _sight, size_t _id)
+{
+		m_sightSlot = LineOfSightBatch::NO_SLOT;
+		if (!IsPlayerInRange())
+		{
+				m_seesPlayer = false;
+				return;
+		}
+		m_sightSlot = _sight.Add(_id, GetCenterPos(), m_player.lock()->GetCenterPos());
+}
+
+void Zombie::ApplySight(const LineOfSightBatch& _sight)
+{
+		if (m_sightSlot != LineOfSightBatch::NO_SLOT)
+		{
+				m_seesPlayer = _sight.IsVisible(m_sightSlot);
+				m_sightSlot = LineOfSightBatch::NO_SLOT;
+		}
+}
+
+void Zombie::FollowPath(float _deltaTime)
+{
+		if (m_pathFollowing)
+		{
+				m_pathFollowingSlot = m_pathFollowing->Add(m_worldPos, AGENT_RADIUS, m_movementSpeed, m_pathToTake);
+				return;
+		}
+
+		glm::vec2 currentWaypoint = m_pathToTake.back();
+		std::shared_ptr<Grid> grid = m_world.lock()->GetWorldGrid().lock();
+		if (grid->GetIndexAt(m_worldPos) == grid->GetIndexAt(currentWaypoint))
+		{
+				LeaveWaypoint();
+				//head for the next waypoint (or keep going for the last one)
+				if (!m_pathToTake.empty())
+				{
+						currentWaypoint = m_pathToTake.back();
+				}
+		}
+		m_direction = glm::normalize(currentWaypoint - GetCenterPos());
+		m_worldPos += m_direction * m_movementSpeed * _deltaTime;
+}
+
+void Zombie::LeaveWaypoint()
+{
+		//Remove the penalizing after exiting this waypoint
+		std::shared_ptr<World> world = m_world.lock();
+		const glm::ivec2 nodeToLeave = world->GetWorldGrid().lock()->GetNodeAt(m_pathToTake.back()).nodeIndex;
+		world->GetWorldGrid().lock()->SetTerrainCost(nodeToLeave, world->GetTile(nodeToLeave.x, nodeToLeave.y).MovementCost());
+
+		m_pathToTake.pop_back();
 }
\ No newline at end of file
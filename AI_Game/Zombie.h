@@ -2,7 +2,10 @@
 #include "Agent.h"
 #include "Player.h"
 #include "PathRequestManager.h"
-#include "StateManager.h"
+#include "PathFollowingBatch.h"
+#include "LineOfSightBatch.h"
+#include "InfluenceMap.h"
+#include "ZombieState.h"
 
 class Zombie :	public Agent
 {
@@ -33,6 +36,10 @@ public:
 
 		/** \brief Update function for the zombie */
 		virtual void Update(float _deltaTime) override;
+
+		/** \brief Moves the zombie one frame without running its state (for the frames the ThinkScheduler skips):
+			*  along its path if it has one (with the batch like FollowPath), straight on in its direction otherwise */
+		void Coast(float _deltaTime);
 		
 		/** \brief Sets the pathfinding algorithm to use */
 		void SetPFAlgo(const Algorithm& _algo) { m_algoToUse = _algo; }
@@ -42,12 +49,42 @@ public:
 		/** \brief Returns the path the zombie is currently following */
 		const std::vector<glm::vec2>& GetPath() { return m_pathToTake; }
 
+		/** \brief Moves the zombie along its paths with _batch instead of on its own (nullptr for on its own, the default).
+			*  Whoever owns the batch clears it before the zombies' Update, updates it after and then calls ApplyPathFollowing */
+		void SetPathFollowing(PathFollowingBatch* _batch) { m_pathFollowing = _batch; }
+		/** \brief Takes the movement the batch computed (if the zombie followed its path this frame) and collides with the level */
+		void ApplyPathFollowing();
+
+		/** \brief Check if the player is close enough for the zombie to notice him (walls aren't checked) */
+		bool IsPlayerInRange() const;
+		/** \brief Adds the ray from the zombie to the player to _sight if the player is in range, the zombie can't see him otherwise
+			*  (a zombie which never looks only checks the range) */
+		void LookForPlayer(LineOfSightBatch& _sight, size_t _id);
+		/** \brief Takes the result of the ray LookForPlayer added, the states use it from the next Update */
+		void ApplySight(const LineOfSightBatch& _sight);
+		/** \brief Check if the player is in range and no wall was between them the last time the zombie looked */
+		bool SeesPlayer() const { return m_seesPlayer && IsPlayerInRange(); }
+
+		/** \brief The influence map the smart states sense the player and the other zombies with (nullptr for none, the default) */
+		void SetInfluenceMap(const InfluenceMap* _influence) { m_influence = _influence; }
+
+protected:
+		/** \brief Moves one frame along m_pathToTake (not empty), or adds the zombie to the batch to be moved with the others */
+		void FollowPath(float _deltaTime);
+		/** \brief Removes the waypoint at the back of the path, and the penalty the path put on its node */
+		void LeaveWaypoint();
+
 protected:
 		std::weak_ptr<Player> m_player;																///< reference to the player so the zombie can always find him (and collide with him)
 		std::weak_ptr<PathRequestManager> m_prManager; ///< reference to the main path request manager in the game screen
 		Algorithm m_algoToUse{ Algorithm::ASTAR };					///< the algorithm the zombie will send in his request
-		StateManager m_stateManager;																			///< FSM of the zombie
+		ZombieStateManager m_stateManager;																			///< FSM of the zombie
 		std::vector<glm::vec2> m_pathToTake;											///< set of world position waypoints the zombie will follow, if any
 		std::vector<glm::vec2> m_patrolWaypoints;						///< set of world position waypoints the zombie will follow, if any
+		PathFollowingBatch* m_pathFollowing{ nullptr }; ///< moves the zombie along its path if set
+		size_t m_pathFollowingSlot{ PathFollowingBatch::NO_SLOT }; ///< the slot of the zombie in m_pathFollowing this frame
+		size_t m_sightSlot{ LineOfSightBatch::NO_SLOT }; ///< the slot of the ray to the player this frame
+		bool m_seesPlayer{ true }; ///< whether no wall was between the zombie and the player the last time it looked
+		const InfluenceMap* m_influence{ nullptr }; ///< see SetInfluenceMap
 };
 
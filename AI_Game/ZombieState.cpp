@@ -1,20 +1,52 @@
 #include "ZombieState.h"
 #include "Zombie.h"
+#include "PatrolState.h"
+#include "AlertState.h"
+#include "ChaseState.h"
+#include "SmartPatrolState.h"
+#include "SmartChaseState.h"
+#include "RetreatState.h"
 
-ZombieState::ZombieState(Zombie * _ownerZombie) : m_zombie(_ownerZombie) { }
+const ZombieStateManager::Definition& ZombieState::GetDefinition()
+{
+		constexpr unsigned char STAY = ZombieStateManager::NO_STATE;
+
+		static PatrolState patrol;
+		static AlertState alert;
+		static ChaseState chase;
+		static SmartPatrolState smartPatrol;
+		static SmartChaseState smartChase;
+		static RetreatState retreat;
+		static ZombieStateManager::StateType* const states[NUM_STATES] = { &patrol, &alert, &chase, &smartPatrol, &smartChase, &retreat };
+
+		static const unsigned char transitions[NUM_STATES * NUM_EVENTS] =
+		{
+				//PLAYER_SEEN  PLAYER_LOST   ALERT_TIMEOUT  LOW_HEALTH
+				ALERT,         STAY,         STAY,          STAY,    //PATROL
+				STAY,          PATROL,       CHASE,         STAY,    //ALERT
+				STAY,          ALERT,        STAY,          STAY,    //CHASE
+				SMART_CHASE,   STAY,         STAY,          RETREAT, //SMART_PATROL
+				STAY,          SMART_PATROL, STAY,          RETREAT, //SMART_CHASE
+				SMART_CHASE,   SMART_PATROL, STAY,          STAY,    //RETREAT (once healed)
+		};
 
-bool ZombieState::CheckForPlayer()
+		static const ZombieStateManager::Definition definition{ states, transitions, NUM_STATES, NUM_EVENTS };
+		return definition;
+}
 
+bool ZombieState::CheckForPlayer(const Zombie& _zombie)
 {
-		constexpr glm::vec2 zombieRange = glm::vec2(AGENT_DIAMETER * 15.0f);
+		return _zombie.IsPlayerInRange();
+}
 
-		auto upperBoundary = glm::greaterThanEqual(m_zombie->m_worldPos + zombieRange, m_zombie->m_player.lock()->GetCenterPos());
-		auto lowerBoundary = glm::lessThanEqual(m_zombie->m_worldPos - zombieRange, m_zombie->m_player.lock()->GetCenterPos());
+bool ZombieState::CanSeePlayer(const Zombie& _zombie)
+{
+		return _zombie.SeesPlayer();
+}
 
-		if (upperBoundary.x && lowerBoundary.x && upperBoundary.y && lowerBoundary.y)
-		{
-				//player in range
-				return true;
-		}
-		return false;
+bool ZombieState::SensesPlayer(const Zombie& _zombie)
+{
+		//a sighting fades by the falloff per node, so this is about ten nodes around the zombie which saw him
+		constexpr float SIGHTING_THRESHOLD = 0.2f;
+		return _zombie.m_influence && _zombie.m_influence->GetInfluence(InfluenceMap::PLAYER_SIGHTING, _zombie.GetCenterPos()) >= SIGHTING_THRESHOLD;
 }
\ No newline at end of file
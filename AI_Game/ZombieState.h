@@ -1,21 +1,40 @@
 #pragma once
 
-#include "State.h"
+#include "StateManager.h"
 
 class Zombie;
 
-class ZombieState : public State
+/** \brief What the zombie states remember of one zombie, kept by its StateManager */
+struct ZombieStateData
+{
+		bool requestedPath;    ///< flag whether the zombie has already send a path request manager, in order to avoid request flooding
+		int nextWaypointIndex; ///< the patrol waypoint of the next path request (-1 for the nearest one)
+		float alertStart;      ///< when the zombie got alerted, in seconds of the AlertState clock
+};
+
+typedef StateManager<Zombie, ZombieStateData> ZombieStateManager;
+
+class ZombieState : public State<Zombie, ZombieStateData>
 {
 public:
-		ZombieState(Zombie* _ownerZombie);
-		virtual ~ZombieState() { m_zombie = nullptr; }
+		/** \brief The ids of the zombie states, the rows of the transition table */
+		enum : unsigned char { PATROL, ALERT, CHASE, SMART_PATROL, SMART_CHASE, RETREAT, NUM_STATES };
+		/** \brief The events the states return from Update, the columns of the transition table */
+		enum : unsigned char { PLAYER_SEEN, PLAYER_LOST, ALERT_TIMEOUT, LOW_HEALTH, NUM_EVENTS };
 
-		virtual void Update(float _deltaTime) = 0;
+		ZombieState() {}
+		virtual ~ZombieState() {}
 
-protected:
-		virtual bool CheckForPlayer();
+		virtual unsigned char Update(Zombie& _zombie, ZombieStateData& _data, float _deltaTime) = 0;
+
+		/** \brief The states shared by all the zombies and the transitions between them */
+		static const ZombieStateManager::Definition& GetDefinition();
 
 protected:
-		Zombie* m_zombie{ nullptr };
+		/** \brief Check if the player is in range of the zombie */
+		static bool CheckForPlayer(const Zombie& _zombie);
+		/** \brief Check if the player is in range and no wall was between them the last time the zombie looked (see Zombie::LookForPlayer) */
+		static bool CanSeePlayer(const Zombie& _zombie);
+		/** \brief Check if a zombie near this one saw the player a moment ago (the PLAYER_SIGHTING of its InfluenceMap), false without a map */
+		static bool SensesPlayer(const Zombie& _zombie);
 };
-
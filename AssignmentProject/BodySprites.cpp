@@ -0,0 +1,28 @@
+#include "BodySprites.h"
+
+void BodySprites::Draw(const PhysicsSnapshot& _snapshot, float _interpolation, const GameEngine::Camera2D& _camera,
+  GameEngine::SpriteBatch& _spriteBatch)
+{
+  //the transforms of all the sprites first
+  m_destRects.resize(m_sprites.size());
+  m_angles.resize(m_sprites.size());
+  m_cullBoxes.resize(m_sprites.size());
+  for (size_t i = 0; i < m_sprites.size(); i++)
+  {
+    const BodySprite& sprite = m_sprites[i];
+    const BodyState state = _snapshot.Get(sprite.snapshotIndex, _interpolation);
+    m_destRects[i] = glm::vec4(state.position - sprite.dimensions / 2.0f, sprite.dimensions);
+    m_angles[i] = state.angle;
+    //the square of the diagonal holds the sprite at any rotation
+    const float halfDiagonal = glm::length(sprite.dimensions) / 2.0f;
+    m_cullBoxes[i] = glm::vec4(state.position - glm::vec2(halfDiagonal), glm::vec2(2.0f * halfDiagonal));
+  }
+  m_visible.clear();
+  _camera.CullBoxes(m_cullBoxes, m_visible);
+  //then the glyphs of the visible ones
+  for (std::uint32_t i : m_visible)
+  {
+    const BodySprite& sprite = m_sprites[i];
+    _spriteBatch.Draw(m_destRects[i], sprite.uvRect, sprite.texture, 0.0f, sprite.color, m_angles[i]);
+  }
+}
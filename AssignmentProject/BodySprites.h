@@ -0,0 +1,40 @@
+#pragma once
+
+#include <GameEngine/Camera2D.h>
+#include <GameEngine/SpriteBatch.h>
+#include <cstdint>
+#include <vector>
+#include "PhysicsSnapshot.h"
+
+//a sprite centered on a body, what the extraction pass needs of a box, an obstacle or a coin
+struct BodySprite
+{
+  int snapshotIndex = -1;  ///< the body in the PhysicsSnapshot
+  glm::vec2 dimensions{ 0.0f, 0.0f };
+  glm::vec4 uvRect{ 0.0f, 0.0f, 1.0f, 1.0f };
+  GLuint texture = 0;
+  GameEngine::ColorRGBA8 color;
+};
+
+//The render extraction of the objects whose sprites only follow their bodies: they're written in one contiguous array a frame,
+//then the transforms are read from the snapshot, culled together by Camera2D::CullBoxes and the visible sprites go to the batch in
+//one loop, without a Draw call per object
+class BodySprites
+{
+public:
+  void Clear() { m_sprites.clear(); }
+  void Add(const BodySprite& _sprite) { m_sprites.push_back(_sprite); }
+
+  //draws the visible sprites where the bodies are, between the last two copies of the snapshot
+  void Draw(const PhysicsSnapshot& _snapshot, float _interpolation, const GameEngine::Camera2D& _camera, GameEngine::SpriteBatch& _spriteBatch);
+
+  size_t GetNumSprites() const { return m_sprites.size(); }
+
+private:
+  std::vector<BodySprite> m_sprites;
+  //scratch, by sprite
+  std::vector<glm::vec4> m_destRects;
+  std::vector<float> m_angles;
+  std::vector<glm::vec4> m_cullBoxes;
+  std::vector<std::uint32_t> m_visible;
+};
@@ -19,7 +19,8 @@ void Box::Init(b2World* _world,
       bool _isDynamic,
       bool _isSensor,
       float _angle, /* = 0.0f */
-      glm::vec4 _uvRect /*= glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)*/) 
+      glm::vec4 _uvRect /*= glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)*/,
+      bool _active /*= true*/) 
 {
   //set all the member variables
   m_dimensions = _dimensions;
@@ -44,6 +45,8 @@ void Box::Init(b2World* _world,
   bodyDef.position.Set(_position.x, _position.y);
   bodyDef.fixedRotation = _fixedRotation;
   bodyDef.angle = _angle;
+  //an inactive body gets its broadphase proxies when it's activated (see LevelReaderWriter)
+  bodyDef.active = _active;
   m_body = _world->CreateBody(&bodyDef);
 
   b2PolygonShape boxShape;
@@ -68,12 +71,28 @@ void Box::Destroy(b2World* _world)
 }
 
 void Box::Draw(GameEngine::SpriteBatch& _spriteBatch)
+{
+  Draw(_spriteBatch, BodyState::Of(m_body));
+}
+
+void Box::Draw(GameEngine::SpriteBatch& _spriteBatch, const BodyState& _state)
 {
   //Draw the body
   glm::vec4 destRect;
-  destRect.x = m_body->GetPosition().x - m_dimensions.x / 2.0f;
-  destRect.y = m_body->GetPosition().y - m_dimensions.y / 2.0f;
+  destRect.x = _state.position.x - m_dimensions.x / 2.0f;
+  destRect.y = _state.position.y - m_dimensions.y / 2.0f;
   destRect.z = m_dimensions.x;
   destRect.w = m_dimensions.y;
-  _spriteBatch.Draw(destRect, m_uvRect, m_texture.id, 0.0f, m_color, m_body->GetAngle());
+  _spriteBatch.Draw(destRect, m_uvRect, m_texture.id, 0.0f, m_color, _state.angle);
+}
+
+void Box::Extract(BodySprites& _sprites) const
+{
+  BodySprite sprite;
+  sprite.snapshotIndex = m_snapshotIndex;
+  sprite.dimensions = m_dimensions;
+  sprite.uvRect = m_uvRect;
+  sprite.texture = m_texture.id;
+  sprite.color = m_color;
+  _sprites.Add(sprite);
 }
@@ -6,6 +6,8 @@
 #include <GameEngine/Vertex.h>
 #include <GameEngine/SpriteBatch.h>
 #include <GameEngine/GLTexture.h>
+#include "PhysicsSnapshot.h"
+#include "BodySprites.h"
 
 class Box
 {
@@ -22,13 +24,21 @@ public:
     bool _isDynamic,
     bool _isSensor,
     float angle = 0.0f,
-    glm::vec4 _uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+    glm::vec4 _uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f),
+    bool _active = true);
 
   //Destroy the box
   void Destroy(b2World* _world);
 
   //Draw the box
   void Draw(GameEngine::SpriteBatch& _spriteBatch);
+  //Draw the box where a copy of its body is, while the world steps
+  void Draw(GameEngine::SpriteBatch& _spriteBatch, const BodyState& _state);
+  //copy the body into the snapshot, before the world steps
+  void Capture(PhysicsSnapshot& _snapshot) { _snapshot.Capture(m_body, m_snapshotIndex); }
+  int GetSnapshotIndex() const { return m_snapshotIndex; }
+  //write the sprite for the extraction pass, it's drawn with the others
+  void Extract(BodySprites& _sprites) const;
 
   //See if the body is dynamic
   bool IsDynamic() const { return m_body->GetType() == b2_dynamicBody; }
@@ -60,6 +70,7 @@ private:
   bool m_fixedRotation;
   bool m_isDynamic;
   bool m_isSensor;
+  int m_snapshotIndex = -1;
 };
 
 #endif
\ No newline at end of file
@@ -46,6 +46,22 @@ void BulletBody::Destroy(b2World* _world)
   }
 }
 
+void BulletBody::Activate(const glm::vec2& _position)
+{
+  //teleport it, and drop whatever speed it had when it was deactivated
+  m_body->SetTransform(b2Vec2(_position.x, _position.y), 0.0f);
+  m_body->SetLinearVelocity(b2Vec2(0.0f, 0.0f));
+  m_body->SetAngularVelocity(0.0f);
+  m_body->SetActive(true);
+  m_body->SetAwake(true);
+}
+
+void BulletBody::Deactivate()
+{
+  //an inactive body has no contacts and is out of the broadphase, the step skips it
+  m_body->SetActive(false);
+}
+
 void BulletBody::DrawDebug(GameEngine::DebugRenderer& _debugRenderer)
 {
   //white color
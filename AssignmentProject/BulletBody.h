@@ -17,6 +17,12 @@ public:
   //Destroy the bullet
   void Destroy(b2World* _world);
 
+  //Reuse the bullet (see ProjectilePool): it's put at _position, still, and collides again
+  void Activate(const glm::vec2& _position);
+  //Take the bullet out of the simulation until it's reused, the body stays in the world
+  void Deactivate();
+  bool IsActive() const { return m_body && m_body->IsActive(); }
+
   //Outline's the bullet collision box
   void DrawDebug(GameEngine::DebugRenderer& _debugRenderer);
 
@@ -5,7 +5,8 @@ void Capsule::Init(b2World* _world,
           const glm::vec2& _dimensions,
           float _density,
           float _friction,
-          bool _fixedRotation)
+          bool _fixedRotation,
+          bool _active /*= true*/)
 {
   m_dimensions = _dimensions;
 
@@ -14,6 +15,7 @@ void Capsule::Init(b2World* _world,
   bodyDef.type = b2_dynamicBody;
   bodyDef.position.Set(_position.x, _position.y);
   bodyDef.fixedRotation = _fixedRotation;
+  bodyDef.active = _active;
   m_body = _world->CreateBody(&bodyDef);
 
   //create the box
@@ -14,7 +14,8 @@ public:
         const glm::vec2& _dimensions,
         float _density,
         float _friction,
-        bool _fixedRotation);
+        bool _fixedRotation,
+        bool _active = true);
 
   //Destroy the capsule
   void Destroy(b2World* _world);
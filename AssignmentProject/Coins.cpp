@@ -1,13 +1,13 @@
 #include "Coins.h"
 #include <GameEngine\ResourceManager.h>
 
-Coins::Coins(b2World* _world, const glm::vec2& _position, const glm::vec2& _dimensions, GameEngine::ColorRGBA8 _color)
+Coins::Coins(b2World* _world, const glm::vec2& _position, const glm::vec2& _dimensions, GameEngine::ColorRGBA8 _color, bool _active)
 {
   //set the member variables and initialize the box and texture
   GameEngine::GLTexture texture = GameEngine::ResourceManager::GetTexture("Assets/Objects/coin_sheet.png");
   m_color = _color;
   m_dimensions = _dimensions;
-  m_box.Init(_world, _position, _dimensions, texture, _color, true, false, true);
+  m_box.Init(_world, _position, _dimensions, texture, _color, true, false, true, 0.0f, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), _active);
   m_texture.Init(texture, glm::ivec2(6, 1));
 }
 
@@ -17,12 +17,16 @@ Coins::~Coins()
 }
 
 void Coins::Draw(GameEngine::SpriteBatch& _spriteBatch)
+{
+  Draw(_spriteBatch, BodyState::Of(m_box.GetBody()));
+}
+
+void Coins::Draw(GameEngine::SpriteBatch& _spriteBatch, const BodyState& _state)
 {
   glm::vec4 destRect;
-  b2Body* body = m_box.GetBody();
   //set up the destRect
-  destRect.x = body->GetPosition().x - m_dimensions.x / 2.0f;
-  destRect.y = body->GetPosition().y - m_box.GetDimensions().y / 2.0f;
+  destRect.x = _state.position.x - m_dimensions.x / 2.0f;
+  destRect.y = _state.position.y - m_box.GetDimensions().y / 2.0f;
   destRect.z = m_dimensions.x;
   destRect.w = m_dimensions.y;
 
@@ -41,7 +45,21 @@ void Coins::Draw(GameEngine::SpriteBatch& _spriteBatch)
   glm::vec4 uvRect = m_texture.GetUVs(tileIndex);
 
   //draw the sprite
-  _spriteBatch.Draw(destRect, uvRect, m_texture.texture.id, 0.0f, m_color, body->GetAngle());
+  _spriteBatch.Draw(destRect, uvRect, m_texture.texture.id, 0.0f, m_color, _state.angle);
+}
+void Coins::Extract(BodySprites& _sprites)
+{
+  //the same animation as Draw
+  const int numTiles = 6;
+  m_animTime += 0.2f;
+
+  BodySprite sprite;
+  sprite.snapshotIndex = m_box.GetSnapshotIndex();
+  sprite.dimensions = m_dimensions;
+  sprite.uvRect = m_texture.GetUVs((int)m_animTime % numTiles);
+  sprite.texture = m_texture.texture.id;
+  sprite.color = m_color;
+  _sprites.Add(sprite);
 }
 void Coins::Destroy(b2World* _world)
 {
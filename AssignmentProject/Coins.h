@@ -7,11 +7,18 @@
 class Coins
 {
 public:
-  Coins(b2World* _world, const glm::vec2& _position, const glm::vec2& _dimensions, GameEngine::ColorRGBA8 _color);
+  Coins(b2World* _world, const glm::vec2& _position, const glm::vec2& _dimensions, GameEngine::ColorRGBA8 _color, bool _active = true);
   ~Coins();
 
   //void Init(b2World* _world, const glm::vec2& _pos, const glm::vec2& _drawDims, glm::vec2& _collisionDims, GameEngine::ColorRGBA8 _color);
   void Draw(GameEngine::SpriteBatch& _spriteBatch);
+  //draw it where a copy of its body is, while the world steps
+  void Draw(GameEngine::SpriteBatch& _spriteBatch, const BodyState& _state);
+  //copy the body into the snapshot, before the world steps
+  void Capture(PhysicsSnapshot& _snapshot) { m_box.Capture(_snapshot); }
+  int GetSnapshotIndex() const { return m_box.GetSnapshotIndex(); }
+  //write the sprite for the extraction pass with the next frame of the animation
+  void Extract(BodySprites& _sprites);
   void Destroy(b2World* _world);
   void DrawDebug(GameEngine::DebugRenderer& _debugRenderer);
 
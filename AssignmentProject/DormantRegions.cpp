@@ -0,0 +1,195 @@
+#include "DormantRegions.h"
+#include <algorithm>
+
+void DormantRegions::Init(float _activeRadius, float _margin)
+{
+  m_activeRadius = _activeRadius;
+  m_margin = _margin;
+}
+
+void DormantRegions::Clear()
+{
+  m_bodies.clear();
+  m_groups.clear();
+  m_isCandidate.clear();
+  m_ids.clear();
+  m_active.clear();
+  m_groupMembers.clear();
+  m_freeGroups.clear();
+  m_dormantHash.Clear(0);
+  m_isHashDirty = false;
+}
+
+void DormantRegions::Add(b2Body* _body)
+{
+  if (_body == nullptr || _body->GetType() == b2_staticBody)
+  {
+    return;
+  }
+  const int id = static_cast<int>(m_bodies.size());
+  m_bodies.push_back(_body);
+  m_groups.push_back(NO_GROUP);
+  m_isCandidate.push_back(false);
+  m_ids[_body] = id;
+  m_active.push_back(id);
+}
+
+void DormantRegions::Update(const glm::vec2& _center)
+{
+  Deactivate(_center);
+  Activate(_center);
+}
+
+bool DormantRegions::IsHeldAwake(int _id) const
+{
+  for (const b2ContactEdge* edge = m_bodies[_id]->GetContactList(); edge != nullptr; edge = edge->next)
+  {
+    if (!edge->contact->IsTouching() || edge->other->GetType() == b2_staticBody)
+    {
+      continue;
+    }
+    auto it = m_ids.find(edge->other);
+    //touching something which isn't managed or which stays active
+    if (it == m_ids.end() || !m_isCandidate[it->second])
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void DormantRegions::Deactivate(const glm::vec2& _center)
+{
+  const float radius = m_activeRadius + m_margin;
+  const float radiusSquared = radius * radius;
+  //the sleeping bodies out of the radius
+  m_candidates.clear();
+  for (int id : m_active)
+  {
+    const b2Vec2& position = m_bodies[id]->GetPosition();
+    const glm::vec2 offset(position.x - _center.x, position.y - _center.y);
+    if (!m_bodies[id]->IsAwake() && glm::dot(offset, offset) > radiusSquared)
+    {
+      m_isCandidate[id] = true;
+      m_candidates.push_back(id);
+    }
+  }
+  if (m_candidates.empty())
+  {
+    return;
+  }
+  //a body touching one which stays active stays too, until nothing changes
+  bool changed = true;
+  while (changed)
+  {
+    changed = false;
+    for (int id : m_candidates)
+    {
+      if (m_isCandidate[id] && IsHeldAwake(id))
+      {
+        m_isCandidate[id] = false;
+        changed = true;
+      }
+    }
+  }
+  //the touching candidates make a group, the contacts are gone once they're deactivated
+  for (int id : m_candidates)
+  {
+    if (!m_isCandidate[id] || m_groups[id] != NO_GROUP)
+    {
+      continue;
+    }
+    int group;
+    if (m_freeGroups.empty())
+    {
+      group = static_cast<int>(m_groupMembers.size());
+      m_groupMembers.emplace_back();
+    }
+    else
+    {
+      group = m_freeGroups.back();
+      m_freeGroups.pop_back();
+    }
+    m_groups[id] = group;
+    m_stack.clear();
+    m_stack.push_back(id);
+    while (!m_stack.empty())
+    {
+      const int member = m_stack.back();
+      m_stack.pop_back();
+      m_groupMembers[group].push_back(member);
+      for (const b2ContactEdge* edge = m_bodies[member]->GetContactList(); edge != nullptr; edge = edge->next)
+      {
+        if (!edge->contact->IsTouching())
+        {
+          continue;
+        }
+        auto it = m_ids.find(edge->other);
+        if (it != m_ids.end() && m_isCandidate[it->second] && m_groups[it->second] == NO_GROUP)
+        {
+          m_groups[it->second] = group;
+          m_stack.push_back(it->second);
+        }
+      }
+    }
+  }
+  for (int id : m_candidates)
+  {
+    if (m_isCandidate[id])
+    {
+      m_bodies[id]->SetActive(false);
+      m_isCandidate[id] = false;
+      m_isHashDirty = true;
+    }
+  }
+  m_active.erase(std::remove_if(m_active.begin(), m_active.end(), [this](int _id) { return m_groups[_id] != NO_GROUP; }), m_active.end());
+}
+
+void DormantRegions::Activate(const glm::vec2& _center)
+{
+  if (m_isHashDirty)
+  {
+    RebuildHash();
+  }
+  m_dormantHash.Query(_center, m_activeRadius, m_nearby);
+  const float radiusSquared = m_activeRadius * m_activeRadius;
+  for (int id : m_nearby)
+  {
+    const int group = m_groups[id];
+    if (group == NO_GROUP)
+    {
+      //woke up with an earlier one of its group
+      continue;
+    }
+    const b2Vec2& position = m_bodies[id]->GetPosition();
+    const glm::vec2 offset(position.x - _center.x, position.y - _center.y);
+    if (glm::dot(offset, offset) > radiusSquared)
+    {
+      continue;
+    }
+    //the whole group, still asleep, the broadphase finds their contacts again on the next step
+    for (int member : m_groupMembers[group])
+    {
+      m_bodies[member]->SetActive(true);
+      m_groups[member] = NO_GROUP;
+      m_active.push_back(member);
+    }
+    m_groupMembers[group].clear();
+    m_freeGroups.push_back(group);
+    m_isHashDirty = true;
+  }
+}
+
+void DormantRegions::RebuildHash()
+{
+  m_dormantHash.Clear(m_bodies.size() - m_active.size());
+  for (int id = 0; id < static_cast<int>(m_bodies.size()); id++)
+  {
+    if (m_groups[id] != NO_GROUP)
+    {
+      const b2Vec2& position = m_bodies[id]->GetPosition();
+      m_dormantHash.Insert(id, glm::vec2(position.x, position.y));
+    }
+  }
+  m_isHashDirty = false;
+}
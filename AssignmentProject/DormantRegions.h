@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Box2D/Box2D.h>
+#include <glm/glm.hpp>
+#include <GameEngine/SpatialHash2D.h>
+#include <unordered_map>
+#include <vector>
+
+//Keeps the dynamic bodies of a level out of the simulation while they're far from the camera: a body which went to sleep outside
+//of the active radius is deactivated (SetActive(false), out of the broadphase and skipped by the step) and it's activated again
+//once the camera comes within the radius, so the cost of a step follows what's around the view instead of the size of the level.
+//The dormant bodies are found in a spatial hash which is only rebuilt when some of them change. Bodies which touch each other go
+//dormant together and wake up together, a box never stands on one which isn't simulated. A body touching one which isn't
+//managed here (the player, the enemies) stays active
+class DormantRegions
+{
+public:
+  //the cells of the hash, a few screens of the camera fit in the active radius
+  static constexpr float CELL_SIZE = 16.0f;
+
+  //_margin is added to the radius to deactivate, so a body on the edge doesn't go back and forth
+  void Init(float _activeRadius, float _margin);
+  //forgets the bodies without touching them, for a new level or when the world is gone
+  void Clear();
+  //manages the body, the static ones are ignored (they don't cost the step anything)
+  void Add(b2Body* _body);
+
+  //deactivates and activates the bodies around _center, once a tick before the world steps
+  void Update(const glm::vec2& _center);
+
+  int GetNumBodies() const { return static_cast<int>(m_bodies.size()); }
+  int GetNumDormant() const { return static_cast<int>(m_bodies.size() - m_active.size()); }
+
+private:
+  enum : int { NO_GROUP = -1 };
+
+  void Deactivate(const glm::vec2& _center);
+  void Activate(const glm::vec2& _center);
+  void RebuildHash();
+  //the body touches one which stays active (or which isn't managed here)
+  bool IsHeldAwake(int _id) const;
+
+  float m_activeRadius = 64.0f;
+  float m_margin = 8.0f;
+
+  std::vector<b2Body*> m_bodies;
+  std::vector<int> m_groups;           ///< by id, the group the dormant body woke up with (NO_GROUP while it's active)
+  std::vector<bool> m_isCandidate;     ///< by id, scratch of Deactivate
+  std::unordered_map<const b2Body*, int> m_ids;
+  std::vector<int> m_active;           ///< the ids of the active bodies
+  std::vector<std::vector<int>> m_groupMembers; ///< the dormant groups, the empty ones are reused
+  std::vector<int> m_freeGroups;
+
+  GameEngine::SpatialHash2D m_dormantHash{ CELL_SIZE };
+  bool m_isHashDirty = false;
+  //scratch
+  std::vector<int> m_candidates;
+  std::vector<int> m_stack;
+  std::vector<int> m_nearby;
+};
@@ -0,0 +1,206 @@
+#include "EditorJournal.h"
+
+#include <GameEngine/IOManager.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+  const std::uint32_t JOURNAL_MAGIC = 0x4C4E4A45; ///< EJNL
+  const std::uint32_t JOURNAL_VERSION = 1;
+
+  struct JournalHeader
+  {
+    std::uint32_t magic;
+    std::uint32_t version;
+  };
+
+  bool WriteHeader(std::ofstream& _file)
+  {
+    JournalHeader header;
+    header.magic = JOURNAL_MAGIC;
+    header.version = JOURNAL_VERSION;
+    _file.write(reinterpret_cast<const char*>(&header), sizeof(JournalHeader));
+    return !_file.fail();
+  }
+
+  bool WriteCommands(std::ofstream& _file, const std::vector<EditorCommand>& _commands)
+  {
+    _file.write(reinterpret_cast<const char*>(_commands.data()), _commands.size() * sizeof(EditorCommand));
+    return !_file.fail();
+  }
+
+  //the command which undoes _command
+  EditorCommand Invert(const EditorCommand& _command)
+  {
+    EditorCommand inverse = _command;
+    inverse.before = _command.after;
+    inverse.after = _command.before;
+    if (_command.type == EditorCommand::ADD)
+    {
+      inverse.type = EditorCommand::REMOVE;
+    }
+    else if (_command.type == EditorCommand::REMOVE)
+    {
+      inverse.type = EditorCommand::ADD;
+    }
+    return inverse;
+  }
+}
+
+void EditorJournal::Init(const std::string& _journalPath)
+{
+  m_journalPath = _journalPath;
+  m_numJournaled = 0;
+  m_pending.clear();
+  ClearHistory();
+}
+
+void EditorJournal::Destroy()
+{
+  GameEngine::JobSystem::Get().Wait(m_counter);
+  m_pending.clear();
+  ClearHistory();
+}
+
+void EditorJournal::Record(const EditorCommand& _command)
+{
+  m_redo.clear();
+  const bool merge = m_canMerge && _command.type == EditorCommand::MODIFY && !m_undo.empty() &&
+    m_undo.back().type == EditorCommand::MODIFY && m_undo.back().kind == _command.kind && m_undo.back().index == _command.index;
+  m_canMerge = _command.type == EditorCommand::MODIFY;
+  if (!merge)
+  {
+    m_undo.push_back(_command);
+    m_pending.push_back(_command);
+    return;
+  }
+  m_undo.back().after = _command.after;
+  //a part flushed already stays in the file, the rest of the change is appended after it
+  if (!m_pending.empty() && m_pending.back().type == EditorCommand::MODIFY && m_pending.back().kind == _command.kind &&
+    m_pending.back().index == _command.index)
+  {
+    m_pending.back().after = _command.after;
+  }
+  else
+  {
+    m_pending.push_back(_command);
+  }
+}
+
+bool EditorJournal::Undo(EditorCommand& _command)
+{
+  m_canMerge = false;
+  if (m_undo.empty())
+  {
+    return false;
+  }
+  _command = m_undo.back();
+  m_undo.pop_back();
+  m_redo.push_back(_command);
+  m_pending.push_back(Invert(_command));
+  return true;
+}
+
+bool EditorJournal::Redo(EditorCommand& _command)
+{
+  m_canMerge = false;
+  if (m_redo.empty())
+  {
+    return false;
+  }
+  _command = m_redo.back();
+  m_redo.pop_back();
+  m_undo.push_back(_command);
+  m_pending.push_back(_command);
+  return true;
+}
+
+void EditorJournal::ClearHistory()
+{
+  m_undo.clear();
+  m_redo.clear();
+  m_canMerge = false;
+}
+
+void EditorJournal::Flush()
+{
+  if (m_pending.empty())
+  {
+    return;
+  }
+  m_numJournaled += m_pending.size();
+  std::vector<EditorCommand> commands;
+  commands.swap(m_pending);
+  const std::string path = m_journalPath;
+  Write([path, commands]()
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    if (file.fail() || !WriteCommands(file, commands))
+    {
+      perror(path.c_str());
+    }
+  });
+}
+
+void EditorJournal::Compact(std::vector<EditorCommand> _snapshot)
+{
+  m_pending.clear();
+  m_numJournaled = 0;
+  const std::string path = m_journalPath;
+  Write([path, _snapshot]()
+  {
+    //written next to the journal and swapped in, a crash while writing leaves the old one
+    const std::string tempPath = path + ".tmp";
+    {
+      std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+      if (file.fail() || !WriteHeader(file) || !WriteCommands(file, _snapshot))
+      {
+        perror(tempPath.c_str());
+        return;
+      }
+    }
+    std::remove(path.c_str());
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+    {
+      perror(path.c_str());
+    }
+  });
+}
+
+void EditorJournal::Remove()
+{
+  GameEngine::JobSystem::Get().Wait(m_counter);
+  m_pending.clear();
+  m_numJournaled = 0;
+  std::remove(m_journalPath.c_str());
+}
+
+bool EditorJournal::Read(const std::string& _journalPath, std::vector<EditorCommand>& _commands)
+{
+  std::vector<unsigned char> data;
+  if (!GameEngine::IOManager::ReadFileToBuffer(_journalPath, data) || data.size() < sizeof(JournalHeader))
+  {
+    return false;
+  }
+  JournalHeader header;
+  std::memcpy(&header, data.data(), sizeof(JournalHeader));
+  if (header.magic != JOURNAL_MAGIC || header.version != JOURNAL_VERSION)
+  {
+    puts("Unknown editor journal. File may be corrupted...");
+    return false;
+  }
+  //a command cut short by a crash is dropped
+  const size_t count = (data.size() - sizeof(JournalHeader)) / sizeof(EditorCommand);
+  _commands.resize(count);
+  std::memcpy(_commands.data(), data.data() + sizeof(JournalHeader), count * sizeof(EditorCommand));
+  return true;
+}
+
+void EditorJournal::Write(GameEngine::Job _job)
+{
+  //the writes are small, waiting for the last one keeps them in order
+  GameEngine::JobSystem::Get().Wait(m_counter);
+  GameEngine::JobSystem::Get().Run(std::move(_job), &m_counter);
+}
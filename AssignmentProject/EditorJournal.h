@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <GameEngine/JobSystem.h>
+#include <GameEngine/Vertex.h>
+
+//the objects the editor edits, the containers of objects then the ones a level has one of
+enum class EditorObjectKind : std::uint8_t { LIGHT, BOX, OBSTACLE, COIN, ENEMY, PLAYER, EXIT, TRIGGER };
+
+//the state of an object, what the editor needs to make it again. Stored as it is in the journal file
+struct EditorObject
+{
+  glm::vec2 position;
+  glm::vec2 dimensions;          ///< the size of a light is in x
+  GameEngine::ColorRGBA8 color;
+  float angle;
+  std::uint8_t isDynamic;
+  std::uint8_t exists;           ///< the player, the exit and the trigger can be missing
+  std::uint8_t padding[2];
+};
+static_assert(sizeof(EditorObject) == 28, "EditorObject is stored as it is");
+
+//an edit: an object added to or removed from its container at index, or changed from before to after
+struct EditorCommand
+{
+  enum Type : std::uint8_t { ADD, REMOVE, MODIFY };
+
+  Type type;
+  EditorObjectKind kind;
+  std::uint8_t padding[2];
+  std::uint32_t index;           ///< 0 for the player, the exit and the trigger
+  EditorObject before;           ///< REMOVE and MODIFY
+  EditorObject after;            ///< ADD and MODIFY
+};
+static_assert(sizeof(EditorCommand) == 64, "EditorCommand is stored as it is");
+
+//The undo/redo log of the editor and its autosave. Every edit is recorded as a command; the undo and the redo of one are edits
+//too, so the journal file is the edits in the order they were done and replaying it onto an empty level gives the level back.
+//The autosave appends only the commands since the last one to the file, on a JobSystem worker, instead of writing the whole
+//level. The compaction folds the file into a snapshot of the level (a command adding each object) once it holds many edits
+class EditorJournal
+{
+public:
+  void Init(const std::string& _journalPath);
+  //waits for the writes, the file stays
+  void Destroy();
+
+  //an edit the editor did, the redo log is dropped. A MODIFY of the object the last edit modified is folded into it until
+  //EndMerge, so a drag or the spinners make one edit
+  void Record(const EditorCommand& _command);
+  void EndMerge() { m_canMerge = false; }
+  //the edit to revert (the editor applies it backwards), false if there's none
+  bool Undo(EditorCommand& _command);
+  //the edit undone last, to apply again
+  bool Redo(EditorCommand& _command);
+  //forgets the undo and redo logs, e.g. when a level is loaded
+  void ClearHistory();
+
+  //appends the edits since the last flush to the journal file, on a worker. The file is started by Compact
+  void Flush();
+  //replaces the journal file with the snapshot of the level, on a worker. The edits not flushed yet are in the snapshot
+  void Compact(std::vector<EditorCommand> _snapshot);
+  //deletes the journal file, the editor was left normally
+  void Remove();
+
+  //the edits written since the last compaction, and the ones not flushed yet
+  size_t GetNumJournaled() const { return m_numJournaled; }
+  size_t GetNumPending() const { return m_pending.size(); }
+
+  //the edits of a journal file in the order they were done, false if there's no file or it's broken
+  static bool Read(const std::string& _journalPath, std::vector<EditorCommand>& _commands);
+
+private:
+  //queues the write after the one in flight, the file is written in order
+  void Write(GameEngine::Job _job);
+
+  std::string m_journalPath;
+  std::vector<EditorCommand> m_undo;
+  std::vector<EditorCommand> m_redo;
+  std::vector<EditorCommand> m_pending;   ///< done since the last flush
+  size_t m_numJournaled{ 0 };
+  bool m_canMerge{ false };
+  GameEngine::JobCounter m_counter;       ///< the write in flight
+};
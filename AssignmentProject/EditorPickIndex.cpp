@@ -0,0 +1,53 @@
+#include "EditorPickIndex.h"
+
+#include <algorithm>
+
+void EditorPickIndex::Clear()
+{
+  for (LayerTree& layer : m_layers)
+  {
+    layer.tree.Clear();
+    layer.proxies.clear();
+  }
+}
+
+void EditorPickIndex::Set(Layer _layer, size_t _index, const glm::vec2& _center, const glm::vec2& _halfExtents)
+{
+  LayerTree& layer = m_layers[_layer];
+  const AABB box(_center - _halfExtents, _center + _halfExtents);
+  if (_index < layer.proxies.size())
+  {
+    layer.tree.Move(layer.proxies[_index], box);
+    return;
+  }
+  //the containers only grow at their end
+  layer.proxies.push_back(layer.tree.Insert(box, static_cast<int>(layer.proxies.size())));
+}
+
+void EditorPickIndex::Erase(Layer _layer, size_t _index)
+{
+  LayerTree& layer = m_layers[_layer];
+  if (_index >= layer.proxies.size())
+  {
+    return;
+  }
+  layer.tree.Remove(layer.proxies[_index]);
+  layer.proxies.erase(layer.proxies.begin() + _index);
+  //deleting is rare, the ids after it are fixed one by one
+  for (size_t i = _index; i < layer.proxies.size(); i++)
+  {
+    layer.tree.SetId(layer.proxies[i], static_cast<int>(i));
+  }
+}
+
+void EditorPickIndex::QueryPoint(Layer _layer, const glm::vec2& _point, std::vector<int>& _indices) const
+{
+  QueryBox(_layer, _point, _point, _indices);
+}
+
+void EditorPickIndex::QueryBox(Layer _layer, const glm::vec2& _min, const glm::vec2& _max, std::vector<int>& _indices) const
+{
+  _indices.clear();
+  m_layers[_layer].tree.QueryBox(AABB(_min, _max), _indices);
+  std::sort(_indices.begin(), _indices.end());
+}
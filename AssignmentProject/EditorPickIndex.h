@@ -0,0 +1,42 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <GameEngine/AABBTree.h>
+#include <vector>
+
+//The bounds of the objects the editor picks, an AABBTree per kind of object so a click (or a drag of a selection box) only tests the
+//objects around it instead of all of them. The trees report the index of an object in its container, the editor keeps them up to
+//date where it changes the containers: placing, refreshing the selected object, deleting and loading
+class EditorPickIndex
+{
+public:
+  //one tree each, in the order the editor picks them
+  enum Layer : int { LIGHTS, BOXES, OBSTACLES, COINS, ENEMIES, NUM_LAYERS };
+
+  //forgets all the objects
+  void Clear();
+  //sets the bounds of the object at _index in its container, a new index is added
+  void Set(Layer _layer, size_t _index, const glm::vec2& _center, const glm::vec2& _halfExtents);
+  //the object at _index was erased from its container, the ones after it move down an index
+  void Erase(Layer _layer, size_t _index);
+
+  //the indices of the objects whose bounds hold _point, ascending (the order the editor tested them in before). A superset of the
+  //objects hit, the caller tests their shapes
+  void QueryPoint(Layer _layer, const glm::vec2& _point, std::vector<int>& _indices) const;
+  //the indices of the objects whose bounds overlap the box, ascending
+  void QueryBox(Layer _layer, const glm::vec2& _min, const glm::vec2& _max, std::vector<int>& _indices) const;
+
+  size_t GetNumObjects(Layer _layer) const { return m_layers[_layer].proxies.size(); }
+
+private:
+  struct LayerTree
+  {
+    //the objects are dragged around, a fat box saves moving them in the tree on every motion event
+    LayerTree() : tree(0.5f) {}
+
+    GameEngine::AABBTree tree;
+    std::vector<int> proxies; ///< by the index of the object
+  };
+
+  LayerTree m_layers[NUM_LAYERS];
+};
@@ -1,12 +1,19 @@
 #include "EditorScreen.h"
 
+#include <GameEngine/RenderState.h>
 #include <GameEngine/ResourceManager.h>
 #include <GameEngine/IOManager.h>
 #include "LevelReaderWriter.h"
+#include <SDL/SDL.h>
+#include <cmath>
 
 const int MOUSE_LEFT = 0;
 const int MOUSE_RIGHT = 1;
 const float LIGHT_SELECT_RADIUS = 0.5f;
+//the journal of the edits, flushed every interval (in ms) and compacted once it holds that many edits
+const std::string AUTOSAVE_PATH = "Autosave/editor.journal";
+const unsigned int AUTOSAVE_INTERVAL = 2000;
+const size_t AUTOSAVE_COMPACT_AFTER = 512;
 
 const b2Vec2 GRAVITY(0.0f, -25.0f);
 
@@ -54,6 +61,8 @@ void EditorScreen::OnEntry()
 {
   //Initialize the audio engine and play the music
   m_audio.Init();
+  //the click of the widgets is decoded in the background, not on the first click
+  m_audio.LoadSoundEffectAsync("Sound/Blip_Select11.ogg", nullptr);
   m_music = m_audio.LoadMusic("Sound/Post-Punk-1.ogg");
   m_music.Play(-1);
   //Initalialize the spritefont
@@ -90,6 +99,14 @@ void EditorScreen::OnEntry()
 
   //set the blank texture (just used to show the player where he will put some box by outlining it
   m_blankTexture = GameEngine::ResourceManager::GetTexture("Assets/Bricks/blank.png");
+
+  //start with an empty level, the one of a session which didn't end normally is brought back from its journal
+  m_hasPlayer = false;
+  m_hasExit = false;
+  m_hasTrigger = false;
+  GameEngine::IOManager::MakeDirectory("Autosave");
+  m_journal.Init(AUTOSAVE_PATH);
+  RestoreAutosave();
 }
 
 void EditorScreen::OnExit()
@@ -116,6 +133,10 @@ void EditorScreen::OnExit()
   m_widgetLabels.clear();
   m_audio.Destroy();
 
+  //the editor was left normally, nothing to bring back
+  m_journal.Remove();
+  m_journal.Destroy();
+
   ClearLevel();
   m_world.reset();
   m_gui.DestroyGUI();
@@ -215,34 +236,58 @@ void EditorScreen::Update()
   {
     if (m_selectedLight != NO_LIGHT)
     {
+      RecordEdit(EditorCommand::REMOVE, EditorObjectKind::LIGHT, m_selectedLight, GetObjectState(EditorObjectKind::LIGHT, m_selectedLight));
       m_lights.erase(m_lights.begin() + m_selectedLight);
+      m_pickIndex.Erase(EditorPickIndex::LIGHTS, m_selectedLight);
       m_selectedLight = NO_LIGHT;
     }
     else if (m_selectedBox != NO_BOX)
     {
+      RecordEdit(EditorCommand::REMOVE, EditorObjectKind::BOX, m_selectedBox, GetObjectState(EditorObjectKind::BOX, m_selectedBox));
       m_boxes[m_selectedBox].Destroy(m_world.get());
       m_boxes.erase(m_boxes.begin() + m_selectedBox);
+      m_pickIndex.Erase(EditorPickIndex::BOXES, m_selectedBox);
       m_selectedBox = NO_BOX;
     }
     else if (m_selectedObstacle != NO_OBSTACLE)
     {
+      RecordEdit(EditorCommand::REMOVE, EditorObjectKind::OBSTACLE, m_selectedObstacle, GetObjectState(EditorObjectKind::OBSTACLE, m_selectedObstacle));
       m_obstacles[m_selectedObstacle].Destroy(m_world.get());
       m_obstacles.erase(m_obstacles.begin() + m_selectedObstacle);
+      m_pickIndex.Erase(EditorPickIndex::OBSTACLES, m_selectedObstacle);
       m_selectedObstacle = NO_OBSTACLE;
     }
     else if (m_selectedEnemy != NO_ENEMY)
     {
+      RecordEdit(EditorCommand::REMOVE, EditorObjectKind::ENEMY, m_selectedEnemy, GetObjectState(EditorObjectKind::ENEMY, m_selectedEnemy));
       m_enemies[m_selectedEnemy].Destroy(m_world.get());
       m_enemies.erase(m_enemies.begin() + m_selectedEnemy);
+      m_pickIndex.Erase(EditorPickIndex::ENEMIES, m_selectedEnemy);
       m_selectedEnemy = NO_ENEMY;
     }
     else if (m_selectedCoin != NO_COIN)
     {
+      RecordEdit(EditorCommand::REMOVE, EditorObjectKind::COIN, m_selectedCoin, GetObjectState(EditorObjectKind::COIN, m_selectedCoin));
       m_coins[m_selectedCoin].Destroy(m_world.get());
       m_coins.erase(m_coins.begin() + m_selectedCoin);
+      m_pickIndex.Erase(EditorPickIndex::COINS, m_selectedCoin);
       m_selectedCoin = NO_COIN;
     }
   }
+  //undo and redo the edits
+  if (m_inputManager.IsKeyDown(SDLK_LCTRL) || m_inputManager.IsKeyDown(SDLK_RCTRL))
+  {
+    EditorCommand command;
+    if (m_inputManager.IsKeyPressed(SDLK_z) && m_journal.Undo(command))
+    {
+      ApplyEdit(command, true);
+    }
+    else if (m_inputManager.IsKeyPressed(SDLK_y) && m_journal.Redo(command))
+    {
+      ApplyEdit(command, false);
+    }
+  }
+  Autosave();
   //update the gui
   m_gui.Update();
 }
@@ -476,7 +521,7 @@ void EditorScreen::DrawWorld()
   //upload texture uniform
   GLint textureUniform = m_textureProgram.GetUniformLocation("mySampler");
   glUniform1i(textureUniform, 0);
-  glActiveTexture(GL_TEXTURE0);
+  GameEngine::RenderState::Get().ActiveTexture(0);
 
   //camera matrix
   glm::mat4 projectionMatrix = m_camera.GetCameraMatrix();
@@ -649,6 +694,7 @@ void EditorScreen::ClearLevel()
   m_lights.clear();
   m_obstacles.clear();
   m_enemies.clear();
+  m_pickIndex.Clear();
   m_hasPlayer = false;
   m_hasExit = false;
   m_hasTrigger = false;
@@ -996,6 +1042,489 @@ bool inEnemySelect(const EnemyRobot& _enemy, const glm::vec2& _pos)
   return false;
 }
 
+//the half extents of the bounds of a rotated box
+glm::vec2 getBoxHalfExtents(const Box& _box)
+{
+  const float c = std::abs(std::cos(_box.GetAngle()));
+  const float s = std::abs(std::sin(_box.GetAngle()));
+  const glm::vec2 halfDims = _box.GetDimensions() / 2.0f;
+  return glm::vec2(c * halfDims.x + s * halfDims.y, s * halfDims.x + c * halfDims.y);
+}
+
+void EditorScreen::IndexLight(size_t _index)
+{
+  m_pickIndex.Set(EditorPickIndex::LIGHTS, _index, m_lights[_index].position, glm::vec2(LIGHT_SELECT_RADIUS));
+}
+void EditorScreen::IndexBox(size_t _index)
+{
+  m_pickIndex.Set(EditorPickIndex::BOXES, _index, m_boxes[_index].GetPosition(), getBoxHalfExtents(m_boxes[_index]));
+}
+void EditorScreen::IndexObstacle(size_t _index)
+{
+  m_pickIndex.Set(EditorPickIndex::OBSTACLES, _index, m_obstacles[_index].GetPosition(), getBoxHalfExtents(m_obstacles[_index]));
+}
+void EditorScreen::IndexCoin(size_t _index)
+{
+  m_pickIndex.Set(EditorPickIndex::COINS, _index, m_coins[_index].GetBox().GetPosition(), getBoxHalfExtents(m_coins[_index].GetBox()));
+}
+void EditorScreen::IndexEnemy(size_t _index)
+{
+  m_pickIndex.Set(EditorPickIndex::ENEMIES, _index, m_enemies[_index].GetPosition(), m_enemies[_index].GetDrawDims() / 2.0f);
+}
+void EditorScreen::BuildPickIndex()
+{
+  m_pickIndex.Clear();
+  for (size_t i = 0; i < m_lights.size(); i++)
+  {
+    IndexLight(i);
+  }
+  for (size_t i = 0; i < m_boxes.size(); i++)
+  {
+    IndexBox(i);
+  }
+  for (size_t i = 0; i < m_obstacles.size(); i++)
+  {
+    IndexObstacle(i);
+  }
+  for (size_t i = 0; i < m_coins.size(); i++)
+  {
+    IndexCoin(i);
+  }
+  for (size_t i = 0; i < m_enemies.size(); i++)
+  {
+    IndexEnemy(i);
+  }
+}
+
+EditorObject EditorScreen::GetObjectState(EditorObjectKind _kind, size_t _index) const
+{
+  EditorObject object = EditorObject();
+  const Box* box = nullptr;
+  const Entity* entity = nullptr;
+  switch (_kind)
+  {
+  case EditorObjectKind::LIGHT:
+    object.position = m_lights[_index].position;
+    object.dimensions = glm::vec2(m_lights[_index].size);
+    object.color = m_lights[_index].color;
+    object.exists = 1;
+    return object;
+  case EditorObjectKind::COIN:
+    object.position = m_coins[_index].GetPosition();
+    object.dimensions = m_coins[_index].GetDimensions();
+    object.color = m_coins[_index].GetColor();
+    object.exists = 1;
+    return object;
+  case EditorObjectKind::BOX:
+    box = &m_boxes[_index];
+    break;
+  case EditorObjectKind::OBSTACLE:
+    box = &m_obstacles[_index];
+    break;
+  case EditorObjectKind::ENEMY:
+    entity = &m_enemies[_index];
+    break;
+  case EditorObjectKind::PLAYER:
+    entity = m_hasPlayer ? &m_player : nullptr;
+    break;
+  case EditorObjectKind::EXIT:
+    box = m_hasExit ? &m_exit : nullptr;
+    break;
+  case EditorObjectKind::TRIGGER:
+    box = m_hasTrigger ? &m_trigger : nullptr;
+    break;
+  }
+  if (box != nullptr)
+  {
+    object.position = box->GetPosition();
+    object.dimensions = box->GetDimensions();
+    object.color = box->GetColor();
+    object.angle = box->GetAngle();
+    object.isDynamic = box->IsDynamic() ? 1 : 0;
+    object.exists = 1;
+  }
+  else if (entity != nullptr)
+  {
+    object.position = entity->GetPosition();
+    object.dimensions = entity->GetDrawDims();
+    object.color = entity->GetColor();
+    object.exists = 1;
+  }
+  return object;
+}
+
+Box EditorScreen::MakeBox(EditorObjectKind _kind, const EditorObject& _object)
+{
+  //as they're placed
+  Box box;
+  switch (_kind)
+  {
+  case EditorObjectKind::BOX:
+    box.Init(m_world.get(), _object.position, _object.dimensions, GameEngine::ResourceManager::GetTexture("Assets/Tiles/MetalTexture.png", false),
+      _object.color, false, _object.isDynamic != 0, false, _object.angle,
+      glm::vec4(_object.position.x, _object.position.y, _object.dimensions.x, _object.dimensions.y));
+    break;
+  case EditorObjectKind::OBSTACLE:
+    box.Init(m_world.get(), _object.position, _object.dimensions, GameEngine::ResourceManager::GetTexture("Assets/Tiles/Spike.png"),
+      _object.color, false, _object.isDynamic != 0, false, _object.angle);
+    break;
+  case EditorObjectKind::EXIT:
+    box.Init(m_world.get(), _object.position, _object.dimensions, GameEngine::ResourceManager::GetTexture("Assets/Objects/DoorLocked.png"),
+      _object.color, false, false, true, _object.angle);
+    break;
+  case EditorObjectKind::TRIGGER:
+    box.Init(m_world.get(), _object.position, _object.dimensions, GameEngine::ResourceManager::GetTexture("Assets/Objects/Switch2.png"),
+      _object.color, false, false, true, _object.angle);
+    break;
+  default:
+    break;
+  }
+  return box;
+}
+
+void EditorScreen::SetObjectState(EditorObjectKind _kind, size_t _index, const EditorObject& _object)
+{
+  glm::vec2 playerColDims(1.0f, 1.8f);
+  glm::vec2 enemyColDims(2.0f, 2.8f);
+  switch (_kind)
+  {
+  case EditorObjectKind::LIGHT:
+    if (_index < m_lights.size())
+    {
+      m_lights[_index].position = _object.position;
+      m_lights[_index].size = _object.dimensions.x;
+      m_lights[_index].color = _object.color;
+      IndexLight(_index);
+    }
+    break;
+  case EditorObjectKind::BOX:
+    if (_index < m_boxes.size())
+    {
+      m_boxes[_index].Destroy(m_world.get());
+      m_boxes[_index] = MakeBox(_kind, _object);
+      IndexBox(_index);
+    }
+    break;
+  case EditorObjectKind::OBSTACLE:
+    if (_index < m_obstacles.size())
+    {
+      m_obstacles[_index].Destroy(m_world.get());
+      m_obstacles[_index] = MakeBox(_kind, _object);
+      IndexObstacle(_index);
+    }
+    break;
+  case EditorObjectKind::COIN:
+    if (_index < m_coins.size())
+    {
+      m_coins[_index].Destroy(m_world.get());
+      m_coins[_index] = Coins(m_world.get(), _object.position, _object.dimensions, _object.color);
+      IndexCoin(_index);
+    }
+    break;
+  case EditorObjectKind::ENEMY:
+    if (_index < m_enemies.size())
+    {
+      m_enemies[_index].Destroy(m_world.get());
+      m_enemies[_index] = EnemyRobot();
+      m_enemies[_index].Init(m_world.get(), _object.position, _object.dimensions, enemyColDims, _object.color);
+      IndexEnemy(_index);
+    }
+    break;
+  case EditorObjectKind::PLAYER:
+    if (m_hasPlayer)
+    {
+      m_player.Destroy(m_world.get());
+    }
+    m_hasPlayer = _object.exists != 0;
+    if (m_hasPlayer)
+    {
+      m_player.Init(m_world.get(), _object.position, _object.dimensions, playerColDims, _object.color);
+    }
+    break;
+  case EditorObjectKind::EXIT:
+    if (m_hasExit)
+    {
+      m_exit.Destroy(m_world.get());
+    }
+    m_hasExit = _object.exists != 0;
+    if (m_hasExit)
+    {
+      m_exit = MakeBox(_kind, _object);
+    }
+    break;
+  case EditorObjectKind::TRIGGER:
+    if (m_hasTrigger)
+    {
+      m_trigger.Destroy(m_world.get());
+    }
+    m_hasTrigger = _object.exists != 0;
+    if (m_hasTrigger)
+    {
+      m_trigger = MakeBox(_kind, _object);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void EditorScreen::InsertObject(EditorObjectKind _kind, size_t _index, const EditorObject& _object)
+{
+  glm::vec2 enemyColDims(2.0f, 2.8f);
+  Light light;
+  EnemyRobot enemy;
+  //an object added at the end (the replay of the journal) only needs its own bounds, the ones after it move up an index otherwise
+  bool isAppended = false;
+  switch (_kind)
+  {
+  case EditorObjectKind::LIGHT:
+    if (_index > m_lights.size())
+    {
+      return;
+    }
+    light.position = _object.position;
+    light.size = _object.dimensions.x;
+    light.color = _object.color;
+    m_lights.insert(m_lights.begin() + _index, light);
+    isAppended = _index + 1 == m_lights.size();
+    if (isAppended)
+    {
+      IndexLight(_index);
+    }
+    break;
+  case EditorObjectKind::BOX:
+    if (_index > m_boxes.size())
+    {
+      return;
+    }
+    m_boxes.insert(m_boxes.begin() + _index, MakeBox(_kind, _object));
+    isAppended = _index + 1 == m_boxes.size();
+    if (isAppended)
+    {
+      IndexBox(_index);
+    }
+    break;
+  case EditorObjectKind::OBSTACLE:
+    if (_index > m_obstacles.size())
+    {
+      return;
+    }
+    m_obstacles.insert(m_obstacles.begin() + _index, MakeBox(_kind, _object));
+    isAppended = _index + 1 == m_obstacles.size();
+    if (isAppended)
+    {
+      IndexObstacle(_index);
+    }
+    break;
+  case EditorObjectKind::COIN:
+    if (_index > m_coins.size())
+    {
+      return;
+    }
+    m_coins.insert(m_coins.begin() + _index, Coins(m_world.get(), _object.position, _object.dimensions, _object.color));
+    isAppended = _index + 1 == m_coins.size();
+    if (isAppended)
+    {
+      IndexCoin(_index);
+    }
+    break;
+  case EditorObjectKind::ENEMY:
+    if (_index > m_enemies.size())
+    {
+      return;
+    }
+    enemy.Init(m_world.get(), _object.position, _object.dimensions, enemyColDims, _object.color);
+    m_enemies.insert(m_enemies.begin() + _index, enemy);
+    isAppended = _index + 1 == m_enemies.size();
+    if (isAppended)
+    {
+      IndexEnemy(_index);
+    }
+    break;
+  default:
+    //the player, the exit and the trigger are only modified
+    SetObjectState(_kind, _index, _object);
+    return;
+  }
+  if (!isAppended)
+  {
+    BuildPickIndex();
+  }
+}
+
+void EditorScreen::EraseObject(EditorObjectKind _kind, size_t _index)
+{
+  EditorObject none = EditorObject();
+  switch (_kind)
+  {
+  case EditorObjectKind::LIGHT:
+    if (_index < m_lights.size())
+    {
+      m_lights.erase(m_lights.begin() + _index);
+      m_pickIndex.Erase(EditorPickIndex::LIGHTS, _index);
+    }
+    break;
+  case EditorObjectKind::BOX:
+    if (_index < m_boxes.size())
+    {
+      m_boxes[_index].Destroy(m_world.get());
+      m_boxes.erase(m_boxes.begin() + _index);
+      m_pickIndex.Erase(EditorPickIndex::BOXES, _index);
+    }
+    break;
+  case EditorObjectKind::OBSTACLE:
+    if (_index < m_obstacles.size())
+    {
+      m_obstacles[_index].Destroy(m_world.get());
+      m_obstacles.erase(m_obstacles.begin() + _index);
+      m_pickIndex.Erase(EditorPickIndex::OBSTACLES, _index);
+    }
+    break;
+  case EditorObjectKind::COIN:
+    if (_index < m_coins.size())
+    {
+      m_coins[_index].Destroy(m_world.get());
+      m_coins.erase(m_coins.begin() + _index);
+      m_pickIndex.Erase(EditorPickIndex::COINS, _index);
+    }
+    break;
+  case EditorObjectKind::ENEMY:
+    if (_index < m_enemies.size())
+    {
+      m_enemies[_index].Destroy(m_world.get());
+      m_enemies.erase(m_enemies.begin() + _index);
+      m_pickIndex.Erase(EditorPickIndex::ENEMIES, _index);
+    }
+    break;
+  default:
+    SetObjectState(_kind, _index, none);
+    break;
+  }
+}
+
+void EditorScreen::RecordEdit(EditorCommand::Type _type, EditorObjectKind _kind, size_t _index, const EditorObject& _before)
+{
+  EditorCommand command = EditorCommand();
+  command.type = _type;
+  command.kind = _kind;
+  command.index = static_cast<std::uint32_t>(_index);
+  command.before = _before;
+  if (_type != EditorCommand::REMOVE)
+  {
+    command.after = GetObjectState(_kind, _index);
+  }
+  m_journal.Record(command);
+}
+
+void EditorScreen::ApplyEdit(const EditorCommand& _command, bool _isUndo)
+{
+  switch (_command.type)
+  {
+  case EditorCommand::ADD:
+    if (_isUndo)
+    {
+      EraseObject(_command.kind, _command.index);
+    }
+    else
+    {
+      InsertObject(_command.kind, _command.index, _command.after);
+    }
+    break;
+  case EditorCommand::REMOVE:
+    if (_isUndo)
+    {
+      InsertObject(_command.kind, _command.index, _command.before);
+    }
+    else
+    {
+      EraseObject(_command.kind, _command.index);
+    }
+    break;
+  case EditorCommand::MODIFY:
+    SetObjectState(_command.kind, _command.index, _isUndo ? _command.before : _command.after);
+    break;
+  default:
+    break;
+  }
+  //the indices may have moved, nothing stays selected
+  m_selectedLight = NO_LIGHT;
+  m_selectedBox = NO_BOX;
+  m_selectedObstacle = NO_OBSTACLE;
+  m_selectedCoin = NO_COIN;
+  m_selectedEnemy = NO_ENEMY;
+  m_isDragging = false;
+}
+
+void EditorScreen::MakeSnapshot(std::vector<EditorCommand>& _snapshot) const
+{
+  EditorCommand command = EditorCommand();
+  auto add = [&](EditorObjectKind _kind, size_t _count)
+  {
+    command.type = EditorCommand::ADD;
+    command.kind = _kind;
+    for (size_t i = 0; i < _count; i++)
+    {
+      command.index = static_cast<std::uint32_t>(i);
+      command.after = GetObjectState(_kind, i);
+      _snapshot.push_back(command);
+    }
+  };
+  add(EditorObjectKind::LIGHT, m_lights.size());
+  add(EditorObjectKind::BOX, m_boxes.size());
+  add(EditorObjectKind::OBSTACLE, m_obstacles.size());
+  add(EditorObjectKind::COIN, m_coins.size());
+  add(EditorObjectKind::ENEMY, m_enemies.size());
+  //the ones a level has one of are placed on the empty level
+  command.type = EditorCommand::MODIFY;
+  command.index = 0;
+  for (EditorObjectKind kind : { EditorObjectKind::PLAYER, EditorObjectKind::EXIT, EditorObjectKind::TRIGGER })
+  {
+    command.kind = kind;
+    command.after = GetObjectState(kind, 0);
+    if (command.after.exists != 0)
+    {
+      _snapshot.push_back(command);
+    }
+  }
+}
+
+void EditorScreen::Autosave()
+{
+  const unsigned int now = SDL_GetTicks();
+  if (now - m_lastAutosaveTime < AUTOSAVE_INTERVAL)
+  {
+    return;
+  }
+  m_lastAutosaveTime = now;
+  if (m_journal.GetNumJournaled() + m_journal.GetNumPending() < AUTOSAVE_COMPACT_AFTER)
+  {
+    m_journal.Flush();
+    return;
+  }
+  std::vector<EditorCommand> snapshot;
+  MakeSnapshot(snapshot);
+  m_journal.Compact(std::move(snapshot));
+}
+
+void EditorScreen::RestoreAutosave()
+{
+  std::vector<EditorCommand> commands;
+  if (EditorJournal::Read(AUTOSAVE_PATH, commands) && !commands.empty())
+  {
+    puts("Restoring the autosaved level. . .");
+    for (const EditorCommand& command : commands)
+    {
+      ApplyEdit(command, false);
+    }
+  }
+  //the session starts from here, the journal is its level
+  m_journal.ClearHistory();
+  std::vector<EditorCommand> snapshot;
+  MakeSnapshot(snapshot);
+  m_journal.Compact(std::move(snapshot));
+  m_lastAutosaveTime = SDL_GetTicks();
+}
+
 void EditorScreen::UpdateMouseDown(const SDL_Event& _evnt)
 {
   //texture for boxes
@@ -1018,6 +1547,8 @@ void EditorScreen::UpdateMouseDown(const SDL_Event& _evnt)
     {
       //select mode
       pos = m_camera.ConvertScreenToWorld(glm::vec2(_evnt.button.x, _evnt.button.y));
+      //the edits of the object selected before were one edit
+      m_journal.EndMerge();
       /* Lights have selection priority, so check lights first */
       /* If a light is already selected, check to see if we clicked it again */
       /******************************
@@ -1032,7 +1563,8 @@ void EditorScreen::UpdateMouseDown(const SDL_Event& _evnt)
         //unselect
         m_selectedLight = NO_LIGHT;
         //find the light that is selected (if none selected light stays NO_LIGHT)
-        for (size_t i = 0; i < m_lights.size(); i++)
+        m_pickIndex.QueryPoint(EditorPickIndex::LIGHTS, pos, m_pickCandidates);
+        for (int i : m_pickCandidates)
         {
           if (inLightSelect(m_lights[i], pos))
           {
@@ -1079,7 +1611,8 @@ void EditorScreen::UpdateMouseDown(const SDL_Event& _evnt)
         //unselect
         m_selectedBox = NO_BOX;
         //find the box that is selected (if none selectedBOx stays NO_BOX)
-        for (size_t i = 0; i < m_boxes.size(); i++)
+        m_pickIndex.QueryPoint(EditorPickIndex::BOXES, pos, m_pickCandidates);
+        for (int i : m_pickCandidates)
         {
           if (m_boxes[i].TestPoint(pos.x, pos.y))
           {
@@ -1137,7 +1670,8 @@ void EditorScreen::UpdateMouseDown(const SDL_Event& _evnt)
         //unselect
         m_selectedObstacle = NO_OBSTACLE;
         //find the obstacle that is selected (if none, selectedObstacle stays NO_OBSTACLE)
-        for (size_t i = 0; i < m_obstacles.size(); i++)
+        m_pickIndex.QueryPoint(EditorPickIndex::OBSTACLES, pos, m_pickCandidates);
+        for (int i : m_pickCandidates)
         {
           if (m_obstacles[i].TestPoint(pos.x, pos.y))
           {
@@ -1195,7 +1729,8 @@ void EditorScreen::UpdateMouseDown(const SDL_Event& _evnt)
         //unselect
         m_selectedCoin = NO_COIN;
         //find the obstacle that is selected (if none, selectedObstacle stays NO_OBSTACLE)
-        for (size_t i = 0; i < m_coins.size(); i++)
+        m_pickIndex.QueryPoint(EditorPickIndex::COINS, pos, m_pickCandidates);
+        for (int i : m_pickCandidates)
         {
           if (m_coins[i].GetBox().TestPoint(pos.x, pos.y))
           {
@@ -1252,7 +1787,8 @@ void EditorScreen::UpdateMouseDown(const SDL_Event& _evnt)
         //unselect
         m_selectedEnemy = NO_ENEMY;
         //find the enemy that is selected (if none, selectedEnemy stays NO_ENEMY)
-        for (size_t i = 0; i < m_enemies.size(); i++)
+        m_pickIndex.QueryPoint(EditorPickIndex::ENEMIES, pos, m_pickCandidates);
+        for (int i : m_pickCandidates)
         {
           if (inEnemySelect(m_enemies[i], pos))
           {
@@ -1288,11 +1824,13 @@ void EditorScreen::UpdateMouseDown(const SDL_Event& _evnt)
       Box newBox;
       Light newLight;
       EnemyRobot newEnemy;
+      EditorObject before;
       //Place
       switch (m_objectMode)
       {
       case ObjectMode::PLAYER:
         //just remove the current player = easiest way
+        before = GetObjectState(EditorObjectKind::PLAYER, 0);
         if (m_hasPlayer)
         {
           m_player.Destroy(m_world.get());
@@ -1304,6 +1842,7 @@ void EditorScreen::UpdateMouseDown(const SDL_Event& _evnt)
           GameEngine::ColorRGBA8((GLubyte)m_colorPickerRed, (GLubyte)m_colorPickerGreen, (GLubyte)m_colorPickerBlue, 255));
 
         m_hasPlayer = true;
+        RecordEdit(EditorCommand::MODIFY, EditorObjectKind::PLAYER, 0, before);
         break;
       case ObjectMode::PLATFORM:
         pos = m_camera.ConvertScreenToWorld(glm::vec2(_evnt.button.x, _evnt.button.y));
@@ -1316,9 +1855,12 @@ void EditorScreen::UpdateMouseDown(const SDL_Event& _evnt)
           (GLubyte)m_colorPickerGreen, (GLubyte)m_colorPickerBlue, 255), false, m_physicsMode == PhysicsMode::DYNAMIC, false, m_rotation, uvRect);
 
         m_boxes.push_back(newBox);
+        IndexBox(m_boxes.size() - 1);
+        RecordEdit(EditorCommand::ADD, EditorObjectKind::BOX, m_boxes.size() - 1, EditorObject());
         break;
       case ObjectMode::TRIGGER:
         //just remove the current trigger = easiest way
+        before = GetObjectState(EditorObjectKind::TRIGGER, 0);
         if (m_hasTrigger)
         {
           m_trigger.Destroy(m_world.get());
@@ -1331,6 +1873,7 @@ void EditorScreen::UpdateMouseDown(const SDL_Event& _evnt)
           false, false, true, m_rotation);
 
         m_hasTrigger = true;
+        RecordEdit(EditorCommand::MODIFY, EditorObjectKind::TRIGGER, 0, before);
         break;
       case ObjectMode::LIGHT:
         newLight.position = m_camera.ConvertScreenToWorld(glm::vec2(_evnt.button.x, _evnt.button.y));
@@ -1338,9 +1881,12 @@ void EditorScreen::UpdateMouseDown(const SDL_Event& _evnt)
         newLight.color = GameEngine::ColorRGBA8((GLubyte)m_colorPickerRed, (GLubyte)m_colorPickerGreen, (GLubyte)m_colorPickerBlue, (GLubyte)m_colorPickerAlpha);
         //push back the light
         m_lights.push_back(newLight);
+        IndexLight(m_lights.size() - 1);
+        RecordEdit(EditorCommand::ADD, EditorObjectKind::LIGHT, m_lights.size() - 1, EditorObject());
         break;
       case ObjectMode::FINISH:
         //destroy the current exit if there is one
+        before = GetObjectState(EditorObjectKind::EXIT, 0);
         if (m_hasExit)
         {
           m_exit.Destroy(m_world.get());
@@ -1353,6 +1899,7 @@ void EditorScreen::UpdateMouseDown(const SDL_Event& _evnt)
           false, false, true, m_rotation);
 
         m_hasExit = true;
+        RecordEdit(EditorCommand::MODIFY, EditorObjectKind::EXIT, 0, before);
         break;
       case ObjectMode::OBSTACLE:
         pos = m_camera.ConvertScreenToWorld(glm::vec2(_evnt.button.x, _evnt.button.y));
@@ -1362,6 +1909,8 @@ void EditorScreen::UpdateMouseDown(const SDL_Event& _evnt)
           false, m_physicsMode == PhysicsMode::DYNAMIC, false, m_rotation);
 
         m_obstacles.push_back(newBox);
+        IndexObstacle(m_obstacles.size() - 1);
+        RecordEdit(EditorCommand::ADD, EditorObjectKind::OBSTACLE, m_obstacles.size() - 1, EditorObject());
         break;
       case ObjectMode::ENEMY:
         pos = m_camera.ConvertScreenToWorld(glm::vec2(_evnt.button.x, _evnt.button.y));
@@ -1370,12 +1919,16 @@ void EditorScreen::UpdateMouseDown(const SDL_Event& _evnt)
           GameEngine::ColorRGBA8((GLubyte)m_colorPickerRed, (GLubyte)m_colorPickerGreen, (GLubyte)m_colorPickerBlue, 255));
 
         m_enemies.push_back(newEnemy);
+        IndexEnemy(m_enemies.size() - 1);
+        RecordEdit(EditorCommand::ADD, EditorObjectKind::ENEMY, m_enemies.size() - 1, EditorObject());
         break;
       case ObjectMode::COIN:
         pos = m_camera.ConvertScreenToWorld(glm::vec2(_evnt.button.x, _evnt.button.y));
         //emplace the new coin
         m_coins.emplace_back(m_world.get(), pos, m_boxDims, GameEngine::ColorRGBA8((GLubyte)m_colorPickerRed,
           (GLubyte)m_colorPickerGreen, (GLubyte)m_colorPickerBlue, 255));
+        IndexCoin(m_coins.size() - 1);
+        RecordEdit(EditorCommand::ADD, EditorObjectKind::COIN, m_coins.size() - 1, EditorObject());
         break;
       default:
         break;
@@ -1403,6 +1956,8 @@ void EditorScreen::UpdateMouseUp(const SDL_Event& _evnt)
     break;
   }
   m_isDragging = false;
+  //a drag is one edit
+  m_journal.EndMerge();
 }
 void EditorScreen::UpdateMouseMotion(const SDL_Event& _evnt)
 {
@@ -1467,6 +2022,7 @@ void EditorScreen::RefreshSelectedBox(const glm::vec2& _newPos)
   {
     return;
   }
+  const EditorObject before = GetObjectState(EditorObjectKind::BOX, m_selectedBox);
   //Texture for boxes
   static GameEngine::GLTexture texture = GameEngine::ResourceManager::GetTexture("Assets/Tiles/MetalTexture.png", false);
   Box newBox;
@@ -1484,6 +2040,8 @@ void EditorScreen::RefreshSelectedBox(const glm::vec2& _newPos)
   //destroy old box and replace with new one
   m_boxes[m_selectedBox].Destroy(m_world.get());
   m_boxes[m_selectedBox] = newBox;
+  IndexBox(m_selectedBox);
+  RecordEdit(EditorCommand::MODIFY, EditorObjectKind::BOX, m_selectedBox, before);
 }
 void EditorScreen::RefreshSelectedLight()
 {
@@ -1499,12 +2057,15 @@ void EditorScreen::RefreshSelectedLight(const glm::vec2& _newPos)
   {
     return;
   }
+  const EditorObject before = GetObjectState(EditorObjectKind::LIGHT, m_selectedLight);
   Light newLight;
   newLight.position = _newPos;
   newLight.size = m_lightSize;
   newLight.color = GameEngine::ColorRGBA8((GLubyte)m_colorPickerRed, (GLubyte)m_colorPickerGreen, (GLubyte)m_colorPickerBlue, (GLubyte)m_colorPickerAlpha);
   //set the current light to the new one
   m_lights[m_selectedLight] = newLight;
+  IndexLight(m_selectedLight);
+  RecordEdit(EditorCommand::MODIFY, EditorObjectKind::LIGHT, m_selectedLight, before);
 }
 void EditorScreen::RefreshSelectedObstacle()
 {
@@ -1520,6 +2081,7 @@ void EditorScreen::RefreshSelectedObstacle(const glm::vec2& _newPos)
   {
     return;
   }
+  const EditorObject before = GetObjectState(EditorObjectKind::OBSTACLE, m_selectedObstacle);
   //Texture for obstacles
   static GameEngine::GLTexture texture = GameEngine::ResourceManager::GetTexture("Assets/Tiles/Spike.png");
   Box newObstacle;
@@ -1531,6 +2093,8 @@ void EditorScreen::RefreshSelectedObstacle(const glm::vec2& _newPos)
   //destroy old pbstacle and replace with new one
   m_obstacles[m_selectedObstacle].Destroy(m_world.get());
   m_obstacles[m_selectedObstacle] = newObstacle;
+  IndexObstacle(m_selectedObstacle);
+  RecordEdit(EditorCommand::MODIFY, EditorObjectKind::OBSTACLE, m_selectedObstacle, before);
 }
 void EditorScreen::RefreshSelectedEnemy()
 {
@@ -1546,6 +2110,7 @@ void EditorScreen::RefreshSelectedEnemy(const glm::vec2& _newPos)
   {
     return;
   }
+  const EditorObject before = GetObjectState(EditorObjectKind::ENEMY, m_selectedEnemy);
   EnemyRobot newEnemy;
 
   //init the new enemy
@@ -1555,6 +2120,8 @@ void EditorScreen::RefreshSelectedEnemy(const glm::vec2& _newPos)
   //destroy the old enemy and replace it with the new one
   m_enemies[m_selectedEnemy].Destroy(m_world.get());
   m_enemies[m_selectedEnemy] = newEnemy;
+  IndexEnemy(m_selectedEnemy);
+  RecordEdit(EditorCommand::MODIFY, EditorObjectKind::ENEMY, m_selectedEnemy, before);
 }
 void EditorScreen::RefreshSelectedCoin()
 {
@@ -1570,6 +2137,7 @@ void EditorScreen::RefreshSelectedCoin(const glm::vec2& _newPos)
   {
     return;
   }
+  const EditorObject before = GetObjectState(EditorObjectKind::COIN, m_selectedCoin);
   //Create the new updated coin
   Coins newCoin(m_world.get(), _newPos, m_boxDims, GameEngine::ColorRGBA8((GLubyte)m_colorPickerRed,
     (GLubyte)m_colorPickerGreen, (GLubyte)m_colorPickerBlue, 255));
@@ -1577,6 +2145,8 @@ void EditorScreen::RefreshSelectedCoin(const glm::vec2& _newPos)
   //destroy old coin and replace with new one
   m_coins[m_selectedCoin].Destroy(m_world.get());
   m_coins[m_selectedCoin] = newCoin;
+  IndexCoin(m_selectedCoin);
+  RecordEdit(EditorCommand::MODIFY, EditorObjectKind::COIN, m_selectedCoin, before);
 }
 // not the best way to do this
 bool EditorScreen::isMouseInUI()
@@ -1819,8 +2389,8 @@ bool EditorScreen::OnSaveMouseClick(const CEGUI::EventArgs& e)
   //add all files to the list box
   for (auto& entry : entries)
   {
-    //don't add directories
-    if (!entry.isDirectory)
+    //don't add directories, nor the cooked binaries of the levels
+    if (!entry.isDirectory && LevelReaderWriter::IsLevelFile(entry.path))
     {
       //remove the "Levels/" substring
       entry.path.erase(0, std::string("Levels/").size());
@@ -1856,8 +2426,8 @@ bool EditorScreen::OnLoadMouseClick(const CEGUI::EventArgs& e)
   //add all files to list box
   for (auto& entry : entries)
   {
-    //don't add directories
-    if (!entry.isDirectory)
+    //don't add directories, nor the cooked binaries of the levels
+    if (!entry.isDirectory && LevelReaderWriter::IsLevelFile(entry.path))
     {
       //remove "Levels/" substring
       entry.path.erase(0, std::string("Levels/").size());
@@ -1970,7 +2540,7 @@ bool EditorScreen::OnSave(const CEGUI::EventArgs& e)
 
   //save in text mode
   std::string text = "Levels/" + std::string(m_saveWindowCombobox->getText().c_str());
-  if (LevelReaderWriter::SaveAsText(text, m_player, m_boxes, m_obstacles, m_coins, m_exit, m_trigger, m_lights, m_enemies))
+  if (LevelReaderWriter::Save(text, m_player, m_boxes, m_obstacles, m_coins, m_exit, m_trigger, m_lights, m_enemies))
   {
     m_saveWindow->disable();
     m_saveWindow->setAlpha(0.0f);
@@ -1989,12 +2559,18 @@ bool EditorScreen::OnLoad(const CEGUI::EventArgs& e)
 
   ClearLevel();
 
-  if (LevelReaderWriter::LoadAsText(path, m_world.get(), m_player, m_boxes, m_obstacles, m_coins, m_exit, m_trigger, m_lights, m_enemies))
+  if (LevelReaderWriter::Load(path, m_world.get(), m_player, m_boxes, m_obstacles, m_coins, m_exit, m_trigger, m_lights, m_enemies))
   {
+    BuildPickIndex();
     m_hasPlayer = true;
     m_hasExit = true;
     m_hasTrigger = true;
   }
+  //the edits before the load can't be undone, the journal starts again from the loaded level
+  m_journal.ClearHistory();
+  std::vector<EditorCommand> snapshot;
+  MakeSnapshot(snapshot);
+  m_journal.Compact(std::move(snapshot));
   puts("Load successful!");
   m_loadWindow->disable();
   m_loadWindow->setAlpha(0.0f);
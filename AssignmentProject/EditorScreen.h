@@ -6,6 +6,8 @@
 #include "Light.h"
 #include "EnemyRobot.h"
 #include "Coins.h"
+#include "EditorPickIndex.h"
+#include "EditorJournal.h"
 #include <GameEngine/Camera2D.h>
 #include <GameEngine/DebugRenderer.h>
 #include <GameEngine/GLSLProgram.h>
@@ -96,6 +98,31 @@ private:
   void RefreshSelectedCoin();
   void RefreshSelectedCoin(const glm::vec2& _newPos);
   bool isMouseInUI();
+  //keep the bounds of an object in the pick index up to date, after it's placed or refreshed
+  void IndexLight(size_t _index);
+  void IndexBox(size_t _index);
+  void IndexObstacle(size_t _index);
+  void IndexCoin(size_t _index);
+  void IndexEnemy(size_t _index);
+  //indexes every object, after a level is loaded
+  void BuildPickIndex();
+
+  //the state of an object for the journal, and making the object from one
+  EditorObject GetObjectState(EditorObjectKind _kind, size_t _index) const;
+  void SetObjectState(EditorObjectKind _kind, size_t _index, const EditorObject& _object);
+  void InsertObject(EditorObjectKind _kind, size_t _index, const EditorObject& _object);
+  void EraseObject(EditorObjectKind _kind, size_t _index);
+  Box MakeBox(EditorObjectKind _kind, const EditorObject& _object);
+  //records an edit of the object at _index, _before is its state before it (the state after is read from the object)
+  void RecordEdit(EditorCommand::Type _type, EditorObjectKind _kind, size_t _index, const EditorObject& _before);
+  //applies an edit again (redo, the replay of the journal) or backwards (undo)
+  void ApplyEdit(const EditorCommand& _command, bool _isUndo);
+  //the level as edits which add every object, what the journal is compacted into
+  void MakeSnapshot(std::vector<EditorCommand>& _snapshot) const;
+  //flushes the journal every AUTOSAVE_INTERVAL, or compacts it once it has grown
+  void Autosave();
+  //replays the journal left by a session which didn't end normally
+  void RestoreAutosave();
 
   void SetPlatformWidgetVisibility(bool _visible);
   void SetLightWidgetVisibility(bool _visible);
@@ -242,6 +269,12 @@ private:
   int m_selectedObstacle = NO_OBSTACLE;
   int m_selectedEnemy = NO_ENEMY;
   int m_selectedCoin = NO_COIN;
+  //the bounds of the objects for picking, and the objects a click reaches
+  EditorPickIndex m_pickIndex;
+  std::vector<int> m_pickCandidates;
+  //the undo/redo log and the autosave
+  EditorJournal m_journal;
+  unsigned int m_lastAutosaveTime = 0;
   //check if the player is dragging objects around
   bool m_isDragging = false;
   //a vector of the selected offset when dragging
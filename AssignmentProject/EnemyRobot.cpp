@@ -2,23 +2,28 @@
 #include "GameStats.h"
 #include <GameEngine\ResourceManager.h>
 
-void EnemyRobot::Init(b2World* _world, const glm::vec2& _pos, const glm::vec2& _drawDims, glm::vec2& _collisionDims, GameEngine::ColorRGBA8 _color)
+void EnemyRobot::Init(b2World* _world, const glm::vec2& _pos, const glm::vec2& _drawDims, glm::vec2& _collisionDims, GameEngine::ColorRGBA8 _color,
+  bool _active /*= true*/)
 {
   //set up the member variables and initialize the body (capsule) and the starting texture
   GameEngine::GLTexture texture = GameEngine::ResourceManager::GetTexture("Assets/EnemyRobot/appear/appear_1.png");
   m_color = _color;
   m_collisionDims = _collisionDims;
   m_drawDims = _drawDims;
-  m_capsule.Init(_world, _pos, _collisionDims, 1.0f, 0.1f, true);
+  m_capsule.Init(_world, _pos, _collisionDims, 1.0f, 0.1f, true, _active);
   m_texture.Init(texture, glm::ivec2(1, 1));
 }
 
 void EnemyRobot::Draw(GameEngine::SpriteBatch& _spriteBatch)
+{
+  Draw(_spriteBatch, BodyState::Of(m_capsule.GetBody()));
+}
+
+void EnemyRobot::Draw(GameEngine::SpriteBatch& _spriteBatch, const BodyState& _state)
 {
   glm::vec4 destRect;
-  b2Body* body = m_capsule.GetBody();
-  destRect.x = body->GetPosition().x - m_drawDims.x / 2.0f;
-  destRect.y = body->GetPosition().y - m_capsule.GetDimensions().y / 2.0f;
+  destRect.x = _state.position.x - m_drawDims.x / 2.0f;
+  destRect.y = _state.position.y - m_capsule.GetDimensions().y / 2.0f;
   destRect.z = m_drawDims.x;
   destRect.w = m_drawDims.y;
 
@@ -26,9 +31,7 @@ void EnemyRobot::Draw(GameEngine::SpriteBatch& _spriteBatch)
   int numTiles = 0;
 
   float animSpeed = 0.2f;
-  glm::vec2 velocity;
-  velocity.x = body->GetLinearVelocity().x;
-  velocity.y = body->GetLinearVelocity().y;
+  const glm::vec2 velocity = _state.velocity;
 
   //do the animation calculations
   if (m_isTriggered && !m_hasSpawned)
@@ -142,7 +145,7 @@ void EnemyRobot::Draw(GameEngine::SpriteBatch& _spriteBatch)
     uvRect.z *= -1;
   }
   //draw the sprite
-  _spriteBatch.Draw(destRect, uvRect, m_texture.texture.id, 0.0f, m_color, body->GetAngle());
+  _spriteBatch.Draw(destRect, uvRect, m_texture.texture.id, 0.0f, m_color, _state.angle);
 
 }
 
@@ -10,9 +10,12 @@ class EnemyRobot : public Entity
 {
 public:
   //Initialize the enemy
-  virtual void Init(b2World* _world, const glm::vec2& _pos, const glm::vec2& _drawDims, glm::vec2& _collisionDims, GameEngine::ColorRGBA8 _color) override;
+  virtual void Init(b2World* _world, const glm::vec2& _pos, const glm::vec2& _drawDims, glm::vec2& _collisionDims, GameEngine::ColorRGBA8 _color,
+    bool _active = true) override;
   //Draw the enemy
   virtual void Draw(GameEngine::SpriteBatch& _spriteBatch) override;
+  //Draw the enemy where a copy of its body is, while the world steps
+  void Draw(GameEngine::SpriteBatch& _spriteBatch, const BodyState& _state);
   //Update him every frame
   void Update(const glm::vec2& _playerPos);
 
@@ -2,6 +2,7 @@
 #define _ENTITY_
 
 #include "Capsule.h"
+#include "PhysicsSnapshot.h"
 #include <GameEngine/SpriteBatch.h>
 #include <GameEngine/TileSheet.h>
 
@@ -13,7 +14,9 @@ public:
   virtual ~Entity() {/*Empty*/}
 
   //The functions an entity would need (Update would also be here, but the player and Enemy take different parameters)
-  virtual void Init(b2World* _world, const glm::vec2& _pos, const glm::vec2& _drawDims, glm::vec2& _collisionDims, GameEngine::ColorRGBA8 _color) = 0;
+  //an inactive entity is activated by whoever made it, e.g. once a whole level is made
+  virtual void Init(b2World* _world, const glm::vec2& _pos, const glm::vec2& _drawDims, glm::vec2& _collisionDims, GameEngine::ColorRGBA8 _color,
+    bool _active = true) = 0;
   virtual void Draw(GameEngine::SpriteBatch& _spriteBatch) = 0;
   virtual void Destroy(b2World* _world);
   virtual void DrawDebug(GameEngine::DebugRenderer& _debugRenderer);
@@ -26,6 +29,8 @@ public:
     rv.y = m_capsule.GetBody()->GetPosition().y;
     return rv;
   }
+  //where the entity is in the last copy of the bodies (see PhysicsSnapshot)
+  int GetSnapshotIndex() const { return m_snapshotIndex; }
   const Capsule GetCapsule()               const { return m_capsule; }
   const glm::vec2& GetDrawDims()           const { return m_drawDims; }
   const glm::vec2& GetColDims()            const { return m_collisionDims; }
@@ -43,6 +48,9 @@ public:
   //apply damage to the entity
   void ApplyDamage(float _damage) { m_healthPoints -= _damage; }
 
+  //copies the body into the snapshot, call it right before the world steps
+  void Capture(PhysicsSnapshot& _snapshot) { _snapshot.Capture(m_capsule.GetBody(), m_snapshotIndex); }
+
 protected:
   //stuff that every entity should have
   glm::vec2 m_drawDims;
@@ -55,6 +63,7 @@ protected:
   float m_attackDamage = 0.25f;
   int m_direction = 1; // 1 or -1
   bool m_isDead = false;
+  int m_snapshotIndex = -1;
 };
 
 #endif
@@ -1,10 +1,14 @@
 #include "GameplayScreen.h"
 #include <SDL/SDL.h>
 #include <GameEngine/IMainGame.h>
+#include <GameEngine/RenderState.h>
 #include <GameEngine/ResourceManager.h>
 #include <GameEngine\IOManager.h>
 #include <GameEngine/GameEngineErrors.h>
 #include <random>
+#include <algorithm>
+#include <functional>
+#include <iostream>
 
 #include "ScreenIndices.h"
 #include "LevelReaderWriter.h"
@@ -12,6 +16,9 @@
 #include "GameStats.h"
 
 const b2Vec2 GRAVITY(0.0f, -25.0);
+//the bullet bodies made with a world, more than the player can have in flight at once
+const int PROJECTILE_POOL_SIZE = 8;
+const glm::vec2 PROJECTILE_COLLISION_DIMS(0.9f, 0.9f);
 
 GameplayScreen::GameplayScreen(GameEngine::Window* _window) : m_window(_window)
 {
@@ -39,19 +46,42 @@ void GameplayScreen::Build()
 
 void GameplayScreen::Destroy()
 {
-
+  //the preloaded textures go before the GL context
+  LevelPreloader::Get().Clear();
 }
 
 void GameplayScreen::OnEntry()
 {
+  //the keys of the player
+  GameEngine::InputActions& actions = m_game->inputActions;
+  actions.Bind(ACTION_SHOOT, SDLK_SPACE);
+  actions.Bind(ACTION_LEFT, SDLK_a);
+  actions.Bind(ACTION_RIGHT, SDLK_d);
+  actions.Bind(ACTION_JUMP, SDLK_w);
   //Initialize the audio
   m_audio.Init();
+  //the pickups and the UI clicks take the voices of the shots when the mixer is full
+  GameEngine::SoundSettings coinSettings;
+  coinSettings.priority = 1;
+  coinSettings.maxInstances = 3;
+  m_audio.SetSoundSettings("Sound/Pickup_Coin4.ogg", coinSettings);
+  GameEngine::SoundSettings clickSettings;
+  clickSettings.priority = 2;
+  clickSettings.maxInstances = 1;
+  m_audio.SetSoundSettings("Sound/Blip_Select11.ogg", clickSettings);
+  //load the textures and sounds of the screen up front, not on the first frame that uses each one
+  if (!GameEngine::ResourceManager::Preload("Assets/Gameplay.manifest", m_preloadedAssets, &m_audio))
+  {
+    std::cout << "Failed to preload Assets/Gameplay.manifest, the assets load on first use\n";
+  }
   //set up the world
   m_world = std::make_unique<b2World>(GRAVITY);
 
   //Initialize the camera
   m_camera.Init(m_window->GetScreenWidth(), m_window->GetScreenHeight());
   m_camera.SetScale(32.0f);
+  //the bodies are simulated a screen around the view, the rest sleep until the camera comes close
+  m_dormantRegions.Init(glm::length(glm::vec2(m_window->GetScreenWidth(), m_window->GetScreenHeight())) / m_camera.GetScale(), 8.0f);
   m_HUDCamera.Init(m_window->GetScreenWidth(), m_window->GetScreenHeight());
   m_HUDCamera.SetPosition(glm::vec2(m_window->GetScreenWidth() / 2.0f, m_window->GetScreenHeight() / 2.0f));
   //Initialize the debug renderer
@@ -62,14 +92,16 @@ void GameplayScreen::OnEntry()
 
   //Initialize the spritebatch
   m_spriteBatch.Init();
+  //and the background, drawn apart from it
+  m_background.Init();
 
   //Initialize the spritefont
   m_spriteFont.init("Fonts/chintzy.ttf", 32);
   // Shader init
   // Compile our texture shader
   m_textureProgram.CompileShaders("Shaders/textureShading.vert", "Shaders/textureShading.frag");
-  // Compile our light shader
-  m_lightProgram.CompileShaders("Shaders/lightShading.vert", "Shaders/lightShading.frag");
+  // The light buffer, with its shaders
+  m_lightBuffer.Init(m_window->GetScreenWidth(), m_window->GetScreenHeight());
   /************************************
   *        Loading the game           *
   *************************************/
@@ -77,11 +109,14 @@ void GameplayScreen::OnEntry()
   puts("Loading game");
   //Clear the level just in case
   ClearLevel();
-  //Load the game
-  if (LevelReaderWriter::LoadAsText(levelPath, m_world.get(), m_player, m_boxes, m_obstacles, m_coins, m_exit, m_trigger, m_lights, m_enemies))
+  //Load the game, what the preloader read of it only has to be made
+  if (LevelPreloader::Get().Load(levelPath, m_world.get(), m_player, m_boxes, m_obstacles, m_coins, m_exit, m_trigger, m_lights, m_enemies,
+    m_preloadedAssets))
   {
     m_enemiesKilled = 0;
     m_coinsCollected = 0;
+    BuildCoinTree();
+    BuildDormantRegions();
     m_hasPlayer = true;
     m_hasTrigger = true;
     m_hasExit = true;
@@ -93,54 +128,29 @@ void GameplayScreen::OnEntry()
     /////////////////////////////////Set up the background layers
     //center the position of the camera to the player for the background setups
     m_camera.SetPosition(m_player.GetPosition());
-    //bottomleft position of the screen in world coords
-    glm::vec2 bottomLeft = m_camera.ConvertScreenToWorld(glm::vec2(0.0f, m_window->GetScreenHeight()));
-    //screen dimension in world coords
-    glm::vec2 screenDims = glm::vec2(m_window->GetScreenWidth() / m_camera.GetScale(), m_window->GetScreenHeight() / m_camera.GetScale());
-    //3 foreground layers positions at the center and 1 to the right and 1 to the left
-    m_backgroundLayers.emplace_back(0.1f, -1.0f, "Assets/layers/skill-desc_0000_foreground.png",
-      bottomLeft, screenDims, m_player.GetPosition().x, 0);
-
-    m_backgroundLayers.emplace_back(0.1f, -1.0f, "Assets/layers/skill-desc_0000_foreground.png",
-      glm::vec2(bottomLeft.x + screenDims.x, bottomLeft.y), screenDims, m_player.GetPosition().x, 1);
-
-    m_backgroundLayers.emplace_back(0.1f, -1.0f, "Assets/layers/skill-desc_0000_foreground.png",
-      glm::vec2(bottomLeft.x - screenDims.x, bottomLeft.y), screenDims, m_player.GetPosition().x, -1);
-    //////////////////////////////////////////////////////////////////////////////////
-
-    //3 buildings layers positions at the center and 1 to the right and 1 to the left
-    m_backgroundLayers.emplace_back(0.3f, -2.0f, "Assets/layers/skill-desc_0001_buildings.png",
-      bottomLeft, screenDims, m_player.GetPosition().x, 0);
-
-    m_backgroundLayers.emplace_back(0.1f, -2.0f, "Assets/layers/skill-desc_0001_buildings.png",
-      glm::vec2(bottomLeft.x + screenDims.x, bottomLeft.y), screenDims, m_player.GetPosition().x, 1);
-
-    m_backgroundLayers.emplace_back(0.1f, -2.0f, "Assets/layers/skill-desc_0001_buildings.png",
-      glm::vec2(bottomLeft.x - screenDims.x, bottomLeft.y), screenDims, m_player.GetPosition().x, -1);
-    //////////////////////////////////////////////////////////////////////////////////
-
-    //3 far buildings layers positions at the center and 1 to the right and 1 to the left
-    m_backgroundLayers.emplace_back(0.5f, -3.0f, "Assets/layers/skill-desc_0002_far-buildings.png",
-      bottomLeft, screenDims, m_player.GetPosition().x, 0);
-
-    m_backgroundLayers.emplace_back(0.1f, -3.0f, "Assets/layers/skill-desc_0002_far-buildings.png",
-      glm::vec2(bottomLeft.x + screenDims.x, bottomLeft.y), screenDims, m_player.GetPosition().x, 1);
-
-    m_backgroundLayers.emplace_back(0.1f, -3.0f, "Assets/layers/skill-desc_0002_far-buildings.png",
-      glm::vec2(bottomLeft.x - screenDims.x, bottomLeft.y), screenDims, m_player.GetPosition().x, -1);
-    //////////////////////////////////////////////////////////////////////////////////
-
-    //Only 1 background needed as it always follows the player
-    m_backgroundLayers.emplace_back(1.0f, -4.0f, "Assets/layers/skill-desc_0003_bg.png",
-      bottomLeft, screenDims, m_player.GetPosition().x, 0);
+    //not drawn from where the player was in the last level
+    m_physics.Reset();
+    //the layers back to front, the farther the slower they scroll by
+    m_background.Clear();
+    m_background.AddLayer("Assets/layers/skill-desc_0003_bg.png", 1.0f);
+    m_background.AddLayer("Assets/layers/skill-desc_0002_far-buildings.png", 0.5f);
+    m_background.AddLayer("Assets/layers/skill-desc_0001_buildings.png", 0.3f);
+    m_background.AddLayer("Assets/layers/skill-desc_0000_foreground.png", 0.1f);
+    m_background.Reset(m_player.GetPosition().x);
 
     /////////////////////////////////////////////////////////////
   }
+  //a retry plays the level again, it's read back while this one is played
+  LevelPreloader::Get().Preload(levelPath);
   puts("Load successful!");
 }
 
 void GameplayScreen::OnExit()
 {
+  //the world is destroyed below, its last step finishes first
+  m_physics.WaitForStep();
+  m_game->inputActions.ClearBindings();
+  m_preloadedAssets.Release();
   for (auto& item : m_saveListBoxItems)
   {
     // We don't have to call delete since removeItem does it for us
@@ -172,23 +182,31 @@ void GameplayScreen::OnExit()
   m_obstacles.clear();
   for (auto& projectile : m_projectiles)
   {
-    projectile.Destroy(m_world.get());
+    projectile.Destroy(m_projectilePool);
   }
   m_projectiles.clear();
 
   //Dispose and Destroy all the programs
   m_textureProgram.Dispose();
-  m_lightProgram.Dispose();
+  m_lightBuffer.Dispose();
+  m_background.Dispose();
   m_audio.Destroy();
 
   m_spriteBatch.Dispose();
   m_spriteFont.dispose();
+  //the runs hold the texture of the disposed font
+  for (auto& text : m_hudTexts)
+  {
+    text.Clear();
+  }
 
   //Destroy the player
   m_player.Destroy(m_world.get());
   //Clear the level
   ClearLevel();
-  //Reset the world
+  //Reset the world, the pooled bodies go with it
+  m_projectilePool.Clear();
+  m_dormantRegions.Clear();
   m_world.reset();
   m_debugRenderer.Dispose();
   m_lights.clear();
@@ -199,13 +217,8 @@ void GameplayScreen::OnExit()
 
 void GameplayScreen::Update()
 {
-  /////////Update the background
-  for (auto& bg : m_backgroundLayers)
-  {
-    //update the parallaxing
-    bg.Update(m_player.GetPosition(), m_camera.ConvertScreenToWorld(glm::vec2(0.0f, m_window->GetScreenHeight())));
-  }
-
+  //the step started by the last tick is done before anything touches the world
+  m_physics.WaitForStep();
   //Check if the player is alive
   if (m_player.GetIsDead())
   {
@@ -213,14 +226,16 @@ void GameplayScreen::Update()
   }
   // Make sure the camera is bound to the player position
   m_camera.SetPosition(m_player.GetPosition());
+  //the sounds are heard from the player
+  GameEngine::AudioMixer::Get().SetListener(glm::vec3(m_player.GetPosition(), 0.0f));
   //Update the camera
   m_camera.Update();
   //Check for user input
   CheckInput();
   //update the player
-  m_player.Update(m_game->inputManager);
+  m_player.Update(m_game->inputActions);
   //increase the elapsed time
-  m_elapsedTime += 1.0f / m_game->GetFPS();
+  m_elapsedTime += m_game->GetFixedTimeStep();
   //Update the projectiles
   for (int i = m_projectiles.size() - 1; i >= 0; i--)
   {
@@ -228,7 +243,7 @@ void GameplayScreen::Update()
     if (m_projectiles[i].GetIsDestroyed())
     {
       //Destroy the projectile and increment the possible shots
-      m_projectiles[i].Destroy(m_world.get());
+      m_projectiles[i].Destroy(m_projectilePool);
       m_projectiles[i] = m_projectiles.back();
       m_projectiles.pop_back();
       m_player.IncrementShots();
@@ -243,8 +258,9 @@ void GameplayScreen::Update()
   if (m_player.GetPlayerShot())
   {
     //Instantiate the new projectile
-    m_projectiles.emplace_back(m_world.get(), glm::vec2(m_player.GetPosition().x + 2.0f * m_player.GetDirection(), m_player.GetPosition().y),
-      glm::vec2(1.0f, 1.0f), glm::vec2(0.9f, 0.9f), GameEngine::ColorRGBA8(255, 255, 255, 255), m_player.GetDirection(), 0.008f);
+    glm::vec2 collisionDims = PROJECTILE_COLLISION_DIMS;
+    m_projectiles.emplace_back(m_projectilePool, glm::vec2(m_player.GetPosition().x + 2.0f * m_player.GetDirection(), m_player.GetPosition().y),
+      glm::vec2(1.0f, 1.0f), collisionDims, GameEngine::ColorRGBA8(255, 255, 255, 255), m_player.GetDirection(), 0.008f);
     m_player.SetPlayerShot(false);
   }
   //Update all alive enemies
@@ -303,7 +319,14 @@ void GameplayScreen::Update()
     }
   }
   //////////////coins collission
-  for (int i = m_coins.size() - 1; i >= 0; i--)
+  //only the coins whose boxes overlap the player's can touch him (grown like box2d grows them for its contacts), from the back so
+  //removing one doesn't move the ones left to check
+  const glm::vec2 playerHalfDims = m_player.GetCapsule().GetDimensions() / 2.0f + glm::vec2(b2_aabbExtension);
+  const glm::vec2 playerPos = m_player.GetPosition();
+  m_nearbyCoins.clear();
+  m_coinTree.QueryBox(AABB(playerPos - playerHalfDims, playerPos + playerHalfDims), m_nearbyCoins);
+  std::sort(m_nearbyCoins.begin(), m_nearbyCoins.end(), std::greater<int>());
+  for (int i : m_nearbyCoins)
   {
     for (b2ContactEdge* ce = m_coins[i].GetBox().GetBody()->GetContactList(); ce != nullptr; ce = ce->next)
     {
@@ -319,6 +342,13 @@ void GameplayScreen::Update()
         m_coins[i].Destroy(m_world.get());
         m_coins[i] = m_coins.back();
         m_coins.pop_back();
+        m_coinTree.Remove(m_coinProxies[i]);
+        m_coinProxies[i] = m_coinProxies.back();
+        m_coinProxies.pop_back();
+        if (i < static_cast<int>(m_coinProxies.size()))
+        {
+          m_coinTree.SetId(m_coinProxies[i], i);
+        }
         break;
       }
     }
@@ -349,7 +379,7 @@ void GameplayScreen::Update()
     if (c->GetFixtureB()->GetBody() == m_player.GetCapsule().GetBody())
     {
       //if the player collides with the exit, the level is cleared
-      if (m_exit.GetTexture().filePath == "Assets/Objects/DoorOpen.png")
+      if (m_exit.GetTexture().asset == GameEngine::AssetIds::Hash("Assets/Objects/DoorOpen.png"))
       {
         OnLevelClear(CEGUI::EventArgs());
         break;
@@ -364,7 +394,7 @@ void GameplayScreen::Update()
     if (c->GetFixtureB()->GetBody() == m_player.GetCapsule().GetBody())
     {
       //check if it's not unlocked
-      if (m_exit.GetTexture().filePath != "Assets/Objects/DoorOpen.png")
+      if (m_exit.GetTexture().asset != GameEngine::AssetIds::Hash("Assets/Objects/DoorOpen.png"))
       {
         glm::vec2 pos = m_trigger.GetPosition();
         glm::vec2 dims = m_trigger.GetDimensions();
@@ -386,20 +416,75 @@ void GameplayScreen::Update()
       }
     }
   }
-  //update the physics simulation (using fixed deltatime, because everything else looks bad with box2d)
-  m_world->Step(1.0f / 60.0f, 6, 2);
+  //only the bodies around the view are stepped
+  m_dormantRegions.Update(m_camera.GetPosition());
+  //the frames draw the copy of the bodies while the world steps
+  CaptureBodies();
+  //update the physics simulation on a worker, a step a tick of the game loop
+  m_physics.Step(m_world.get(), m_game->GetFixedTimeStep(), 6, 2);
+}
+
+void GameplayScreen::BuildDormantRegions()
+{
+  m_dormantRegions.Clear();
+  for (auto& box : m_boxes)
+  {
+    m_dormantRegions.Add(box.GetBody());
+  }
+  for (auto& obs : m_obstacles)
+  {
+    m_dormantRegions.Add(obs.GetBody());
+  }
+}
+
+void GameplayScreen::CaptureBodies()
+{
+  m_physics.BeginCapture();
+  m_player.Capture(m_physics);
+  for (auto& enemy : m_enemies)
+  {
+    enemy.Capture(m_physics);
+  }
+  for (auto& projectile : m_projectiles)
+  {
+    projectile.Capture(m_physics);
+  }
+  for (auto& box : m_boxes)
+  {
+    box.Capture(m_physics);
+  }
+  for (auto& obs : m_obstacles)
+  {
+    obs.Capture(m_physics);
+  }
+  for (auto& coin : m_coins)
+  {
+    coin.Capture(m_physics);
+  }
+  m_exit.Capture(m_physics);
+  m_trigger.Capture(m_physics);
 }
 void GameplayScreen::Draw()
 {
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   glClearColor(0.125f, 0.298f, 0.137f, 1.0f);
+
+  //the frame is between the last two copies of the bodies, the camera follows the player there so it moves smoothly at any refresh rate
+  const float interpolation = m_game->GetInterpolation();
+  const BodyState playerState = m_physics.Get(m_player.GetSnapshotIndex(), interpolation);
+  m_camera.SetPosition(playerState.position);
+  m_camera.Update();
+
+  //Draw the background, one screen quad behind everything
+  m_background.Draw(playerState.position.x, m_window->GetScreenWidth() / m_camera.GetScale());
+
   //use the texture program
   m_textureProgram.Use();
 
   //upload texture uniform
   GLint textureUniform = m_textureProgram.GetUniformLocation("mySampler");
   glUniform1i(textureUniform, 0);
-  glActiveTexture(GL_TEXTURE0);
+  GameEngine::RenderState::Get().ActiveTexture(0);
 
   //camera matrix
   glm::mat4 projectionMatrix = m_camera.GetCameraMatrix();
@@ -407,56 +492,36 @@ void GameplayScreen::Draw()
   glUniformMatrix4fv(pUniform, 1, GL_FALSE, &projectionMatrix[0][0]);
 
   {
-    //draw everything except lights, because they use a different shader program
-    m_spriteBatch.Begin(GameEngine::GlyphSortType::FRONT_TO_BACK);
+    //draw everything except lights, they're accumulated in the light buffer
+    //the batch culls everything outside the camera view
+    m_spriteBatch.Begin(GameEngine::GlyphSortType::FRONT_TO_BACK, m_camera);
 
-    //Draw the background
-    for (auto& bg : m_backgroundLayers)
+    //Draw the boxes, the obstacles and the coins in view, extracted into one array and drawn in one loop
+    m_bodySprites.Clear();
+    for (const auto& box : m_boxes)
     {
-      bg.Draw(m_spriteBatch);
+      box.Extract(m_bodySprites);
     }
-
-    //Draw the boxes
-    for (auto& box : m_boxes)
-    {
-      box.Draw(m_spriteBatch);
-    }
-    //draw the obstacles
-    for (auto& obstacle : m_obstacles)
+    for (const auto& obs : m_obstacles)
     {
-      obstacle.Draw(m_spriteBatch);
+      obs.Extract(m_bodySprites);
     }
     for (auto& coin : m_coins)
     {
-      //apply camera culling for optimization
-      if (m_camera.IsBoxInView(coin.GetPosition(), coin.GetDimensions()))
-      {
-        coin.Draw(m_spriteBatch);
-      }
+      coin.Extract(m_bodySprites);
     }
+    m_bodySprites.Draw(m_physics, interpolation, m_camera, m_spriteBatch);
     for (auto& enemy : m_enemies)
     {
-      //apply camera culling for optimization
-      if (m_camera.IsBoxInView(enemy.GetPosition(), enemy.GetDrawDims()))
-      {
-        enemy.Draw(m_spriteBatch);
-      }
+      enemy.Draw(m_spriteBatch, m_physics.Get(enemy.GetSnapshotIndex(), interpolation));
     }
     for (auto& projectile : m_projectiles)
     {
-      projectile.Draw(m_spriteBatch);
-    }
-    //apply camera culling for optimization
-    if (m_camera.IsBoxInView(m_exit.GetPosition(), m_exit.GetDimensions()))
-    {
-      m_exit.Draw(m_spriteBatch);
-    }
-    //apply camera culling for optimization
-    if (m_camera.IsBoxInView(m_trigger.GetPosition(), m_trigger.GetDimensions()))
-    {
-      m_trigger.Draw(m_spriteBatch);
+      projectile.Draw(m_spriteBatch, m_physics.Get(projectile.GetSnapshotIndex(), interpolation));
     }
-    m_player.Draw(m_spriteBatch);
+    m_exit.Draw(m_spriteBatch, m_physics.Get(m_exit.GetSnapshotIndex(), interpolation));
+    m_trigger.Draw(m_spriteBatch, m_physics.Get(m_trigger.GetSnapshotIndex(), interpolation));
+    m_player.Draw(m_spriteBatch, playerState);
 
     m_spriteBatch.End();
     m_spriteBatch.RenderBatch();
@@ -467,38 +532,21 @@ void GameplayScreen::Draw()
   }
 
   {
-    //Draw the lights
-
-    m_lightProgram.Use();
-    pUniform = m_textureProgram.GetUniformLocation("P");
-    glUniformMatrix4fv(pUniform, 1, GL_FALSE, &projectionMatrix[0][0]);
-
-    //additive blending
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-
-    //begin the spritebatch
-    m_spriteBatch.Begin();
-
-    //draw all the lights
-    for (auto& light : m_lights)
+    //Draw the lights, in one instanced draw into the light buffer and one screen quad adding it over the scene
+    m_lightBuffer.Resize(m_window->GetScreenWidth(), m_window->GetScreenHeight());
+    m_lightBuffer.Begin();
+    for (const auto& light : m_lights)
     {
-      light.Draw(m_spriteBatch);
+      m_lightBuffer.Add(light);
     }
-    //end the spritebatch
-    m_spriteBatch.End();
-    //render the batch
-    m_spriteBatch.RenderBatch();
-    //unuse the lights shader program
-    m_lightProgram.UnUse();
-
-    //restore alpha blending
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
+    m_lightBuffer.Render(projectionMatrix);
   }
 
   //Debug rendering
   if (m_renderDebug)
   {
+    //the outlines are read from the bodies, the step has to be done (debugging only, it's drawn without the overlap)
+    m_physics.WaitForStep();
     //use destRect for the box outlining
     glm::vec4 destRect;
     {
@@ -665,12 +713,24 @@ void GameplayScreen::CheckInput()
 
 void GameplayScreen::ClearLevel()
 {
+  //the UI loads a level from its events, the world may still be stepping
+  m_physics.WaitForStep();
   //clear the current level
   m_boxes.clear();
   m_obstacles.clear();
   m_coins.clear();
+  m_coinTree.Clear();
+  m_coinProxies.clear();
   m_lights.clear();
   m_enemies.clear();
+  //the shots in flight are gone with the world, the player gets them back
+  for (size_t i = 0; i < m_projectiles.size(); i++)
+  {
+    m_player.IncrementShots();
+  }
+  m_projectiles.clear();
+  m_projectilePool.Clear();
+  m_dormantRegions.Clear();
   m_isUnlocked = false;
   m_hasPlayer = false;
   m_player.SetHealth(100.0f);
@@ -678,9 +738,22 @@ void GameplayScreen::ClearLevel()
   m_hasExit = false;
   m_hasTrigger = false;
   m_world.reset();
-  m_backgroundLayers.clear();
+  m_background.Clear();
   m_world = std::make_unique<b2World>(GRAVITY);
+  m_projectilePool.Init(m_world.get(), PROJECTILE_POOL_SIZE, PROJECTILE_COLLISION_DIMS, 0.01f, 0.1f);
 }
+void GameplayScreen::BuildCoinTree()
+{
+  m_coinTree.Clear();
+  m_coinProxies.clear();
+  for (int i = 0; i < static_cast<int>(m_coins.size()); i++)
+  {
+    const glm::vec2 halfDims = m_coins[i].GetBox().GetDimensions() / 2.0f;
+    const glm::vec2 pos = m_coins[i].GetPosition();
+    m_coinProxies.push_back(m_coinTree.Insert(AABB(pos - halfDims, pos + halfDims), i));
+  }
+}
+
 void GameplayScreen::DrawHUD()
 {
   //Draw the HUD
@@ -699,13 +772,19 @@ void GameplayScreen::DrawHUD()
   std::string coinsCollected = "Coins collected: " + std::to_string((m_coinsCollected)); //< coins collected text
 
 
+  //shape the texts which changed, the others keep their glyphs
+  const GameEngine::ColorRGBA8 white(255, 255, 255, 255);
+  m_hudTexts[FPS_TEXT].Set(m_spriteFont, fps, glm::vec2(-1.0f, -1.0f), glm::vec2(0.002f), 0.0f, white);
+  m_hudTexts[HEALTH_TEXT].Set(m_spriteFont, playerHealth, glm::vec2(0.6, 0.9), glm::vec2(0.0015f), 0.0f, white);
+  m_hudTexts[VOLUME_TEXT].Set(m_spriteFont, musicVolume, glm::vec2(-0.99f, -0.8f), glm::vec2(0.0015f), 0.0f, white);
+  m_hudTexts[TIME_TEXT].Set(m_spriteFont, elapsedTime, glm::vec2(0.5, 0.85), glm::vec2(0.0015f), 0.0f, white);
+  m_hudTexts[KILLS_TEXT].Set(m_spriteFont, enemiesKilled, glm::vec2(0.5, 0.8), glm::vec2(0.0015f), 0.0f, white);
+  m_hudTexts[COINS_TEXT].Set(m_spriteFont, coinsCollected, glm::vec2(0.5, 0.75), glm::vec2(0.0015f), 0.0f, white);
   //Draw all the texts
-  m_spriteFont.draw(m_spriteBatch, fps.c_str(), glm::vec2(-1.0f, -1.0f), glm::vec2(0.002f), 0.0f, GameEngine::ColorRGBA8(255, 255, 255, 255));
-  m_spriteFont.draw(m_spriteBatch, playerHealth.c_str(), glm::vec2(0.6, 0.9), glm::vec2(0.0015f), 0.0f, GameEngine::ColorRGBA8(255, 255, 255, 255));
-  m_spriteFont.draw(m_spriteBatch, musicVolume.c_str(), glm::vec2(-0.99f, -0.8f), glm::vec2(0.0015f), 0.0f, GameEngine::ColorRGBA8(255, 255, 255, 255));
-  m_spriteFont.draw(m_spriteBatch, elapsedTime.c_str(), glm::vec2(0.5, 0.85), glm::vec2(0.0015f), 0.0f, GameEngine::ColorRGBA8(255, 255, 255, 255));
-  m_spriteFont.draw(m_spriteBatch, enemiesKilled.c_str(), glm::vec2(0.5, 0.8), glm::vec2(0.0015f), 0.0f, GameEngine::ColorRGBA8(255, 255, 255, 255));
-  m_spriteFont.draw(m_spriteBatch, coinsCollected.c_str(), glm::vec2(0.5, 0.75), glm::vec2(0.0015f), 0.0f, GameEngine::ColorRGBA8(255, 255, 255, 255));
+  for (const auto& text : m_hudTexts)
+  {
+    text.Draw(m_spriteBatch);
+  }
   //end the spritebatch
   m_spriteBatch.End();
   //render the batch
@@ -746,8 +825,8 @@ bool GameplayScreen::OnLoadMouseClick(const CEGUI::EventArgs& e)
   //add all files to list box
   for (auto& e : entries)
   {
-    //Don't add directories
-    if (!e.isDirectory)
+    //Don't add directories, nor the cooked binaries of the levels
+    if (!e.isDirectory && LevelReaderWriter::IsLevelFile(e.path))
     {
       //Remove "Levels/" substring
       e.path.erase(0, std::string("Levels/").size());
@@ -785,10 +864,13 @@ bool GameplayScreen::OnLoad(const CEGUI::EventArgs& e)
 
   ClearLevel();
 
-  if (LevelReaderWriter::LoadAsText(levelPath, m_world.get(), m_player, m_boxes, m_obstacles, m_coins, m_exit, m_trigger, m_lights, m_enemies))
+  if (LevelPreloader::Get().Load(levelPath, m_world.get(), m_player, m_boxes, m_obstacles, m_coins, m_exit, m_trigger, m_lights, m_enemies,
+    m_preloadedAssets))
   {
     m_enemiesKilled = 0;
     m_coinsCollected = 0;
+    BuildCoinTree();
+    BuildDormantRegions();
     m_hasPlayer = true;
     m_hasTrigger = true;
     m_hasExit = true;
@@ -797,49 +879,19 @@ bool GameplayScreen::OnLoad(const CEGUI::EventArgs& e)
     ////////////////////////////////////////////////////////////Set up the background layers
     //center the camera position to the player
     m_camera.SetPosition(m_player.GetPosition());
-    //the bottom left position of the screen in world coordinates
-    glm::vec2 bottomLeft = m_camera.ConvertScreenToWorld(glm::vec2(0.0f, m_window->GetScreenHeight()));
-    //the screen dimension in world coordinates
-    glm::vec2 screenDims = glm::vec2(m_window->GetScreenWidth() / m_camera.GetScale(), m_window->GetScreenHeight() / m_camera.GetScale());
-    //3 foreground layers positions at the center and 1 to the right and 1 to the left
-    m_backgroundLayers.emplace_back(0.1f, -1.0f, "Assets/layers/skill-desc_0000_foreground.png",
-      bottomLeft, screenDims, m_player.GetPosition().x, 0);
-
-    m_backgroundLayers.emplace_back(0.1f, -1.0f, "Assets/layers/skill-desc_0000_foreground.png",
-      glm::vec2(bottomLeft.x + screenDims.x, bottomLeft.y), screenDims, m_player.GetPosition().x, 1);
-
-    m_backgroundLayers.emplace_back(0.1f, -1.0f, "Assets/layers/skill-desc_0000_foreground.png",
-      glm::vec2(bottomLeft.x - screenDims.x, bottomLeft.y), screenDims, m_player.GetPosition().x, -1);
-    //////////////////////////////////////////////////////////////////////////////////
-
-    //3 buildings layers positions at the center and 1 to the right and 1 to the left
-    m_backgroundLayers.emplace_back(0.3f, -2.0f, "Assets/layers/skill-desc_0001_buildings.png",
-      bottomLeft, screenDims, m_player.GetPosition().x, 0);
-
-    m_backgroundLayers.emplace_back(0.1f, -2.0f, "Assets/layers/skill-desc_0001_buildings.png",
-      glm::vec2(bottomLeft.x + screenDims.x, bottomLeft.y), screenDims, m_player.GetPosition().x, 1);
-
-    m_backgroundLayers.emplace_back(0.1f, -2.0f, "Assets/layers/skill-desc_0001_buildings.png",
-      glm::vec2(bottomLeft.x - screenDims.x, bottomLeft.y), screenDims, m_player.GetPosition().x, -1);
-    //////////////////////////////////////////////////////////////////////////////////
-
-    //3 far buildings layers positions at the center and 1 to the right and 1 to the left
-    m_backgroundLayers.emplace_back(0.5f, -3.0f, "Assets/layers/skill-desc_0002_far-buildings.png",
-      bottomLeft, screenDims, m_player.GetPosition().x, 0);
-
-    m_backgroundLayers.emplace_back(0.1f, -3.0f, "Assets/layers/skill-desc_0002_far-buildings.png",
-      glm::vec2(bottomLeft.x + screenDims.x, bottomLeft.y), screenDims, m_player.GetPosition().x, 1);
-
-    m_backgroundLayers.emplace_back(0.1f, -3.0f, "Assets/layers/skill-desc_0002_far-buildings.png",
-      glm::vec2(bottomLeft.x - screenDims.x, bottomLeft.y), screenDims, m_player.GetPosition().x, -1);
-    //////////////////////////////////////////////////////////////////////////////////
-
-    //Only 1 background needed as it always follows the player
-    m_backgroundLayers.emplace_back(1.0f, -4.0f, "Assets/layers/skill-desc_0003_bg.png",
-      bottomLeft, screenDims, m_player.GetPosition().x, 0);
+    //not drawn from where the player was in the last level
+    m_physics.Reset();
+    //the layers back to front, the farther the slower they scroll by
+    m_background.Clear();
+    m_background.AddLayer("Assets/layers/skill-desc_0003_bg.png", 1.0f);
+    m_background.AddLayer("Assets/layers/skill-desc_0002_far-buildings.png", 0.5f);
+    m_background.AddLayer("Assets/layers/skill-desc_0001_buildings.png", 0.3f);
+    m_background.AddLayer("Assets/layers/skill-desc_0000_foreground.png", 0.1f);
+    m_background.Reset(m_player.GetPosition().x);
 
     /////////////////////////////////////////////////////////////
   }
+  LevelPreloader::Get().Preload(levelPath);
   puts("Load successful!");
 
   //hide the load window
@@ -874,8 +926,8 @@ bool GameplayScreen::OnSaveMouseClick(const CEGUI::EventArgs& e)
   //add all files to list box
   for (auto& e : entries)
   {
-    //Don't add directories
-    if (!e.isDirectory)
+    //Don't add directories, nor the cooked binaries of the levels
+    if (!e.isDirectory && LevelReaderWriter::IsLevelFile(e.path))
     {
       //Remove "Levels/" substring
       e.path.erase(0, std::string("Levels/").size());
@@ -916,7 +968,7 @@ bool GameplayScreen::OnSave(const CEGUI::EventArgs& e)
   GameEngine::IOManager::MakeDirectory("Levels");
   //save in text mode
   std::string text = "Levels/" + std::string(m_saveWindowCombobox->getText().c_str());
-  if (LevelReaderWriter::SaveAsText(text, m_player, m_boxes, m_obstacles, m_coins, m_exit, m_trigger, m_lights, m_enemies))
+  if (LevelReaderWriter::Save(text, m_player, m_boxes, m_obstacles, m_coins, m_exit, m_trigger, m_lights, m_enemies))
   {
     m_saveWindow->disable();
     m_saveWindow->setAlpha(0.0f);
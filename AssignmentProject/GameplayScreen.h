@@ -9,6 +9,10 @@
 #include "Coins.h"
 #include "ScreenIndices.h"
 #include "ParallaxBackground.h"
+#include "PhysicsSnapshot.h"
+#include "DormantRegions.h"
+#include "BodySprites.h"
+#include "LightBuffer.h"
 
 #include <GameEngine/IGameScreen.h>
 #include <Box2D/Box2D.h>
@@ -20,7 +24,10 @@
 #include <GameEngine/Window.h>
 #include <GameEngine/DebugRenderer.h>
 #include <GameEngine\SpriteFont.h>
+#include <GameEngine/TextRun.h>
 #include <GameEngine/AudioEngine.h>
+#include <GameEngine/AssetManifest.h>
+#include <GameEngine/AABBTree.h>
 
 #include <GameEngine/GUI.h>
 
@@ -52,6 +59,12 @@ private:
   void InitUI();
   void CheckInput();
   void ClearLevel();
+  //puts the coins of the loaded level in m_coinTree
+  void BuildCoinTree();
+  //puts the dynamic boxes and obstacles of the loaded level in m_dormantRegions
+  void BuildDormantRegions();
+  //copies the bodies into m_physics before the world steps
+  void CaptureBodies();
   
   void DrawHUD();
 
@@ -93,9 +106,13 @@ private:
   GameEngine::SpriteBatch m_spriteBatch;
   //the spritefont
   GameEngine::SpriteFont m_spriteFont;
-  //the texturing program for sprites and lights
+  //the HUD strings, shaped again only when they change
+  enum HUDText { FPS_TEXT, HEALTH_TEXT, VOLUME_TEXT, TIME_TEXT, KILLS_TEXT, COINS_TEXT, NUM_HUD_TEXTS };
+  GameEngine::TextRun m_hudTexts[NUM_HUD_TEXTS];
+  //the texturing program for sprites
   GameEngine::GLSLProgram m_textureProgram;
-  GameEngine::GLSLProgram m_lightProgram;
+  //the lights, accumulated at a lower resolution and added over the scene
+  LightBuffer m_lightBuffer;
   //the cameras
   GameEngine::Camera2D m_camera;
   GameEngine::Camera2D m_HUDCamera;
@@ -108,6 +125,8 @@ private:
   //the audio engine
   GameEngine::AudioEngine m_audio;
   GameEngine::Music m_music;
+  //the assets of Assets/Gameplay.manifest, loaded while the screen is active
+  GameEngine::PreloadedAssets m_preloadedAssets;
   //a bunch of booleans for the game
   bool m_renderDebug = false;
   bool m_hasPlayer = false;
@@ -123,15 +142,27 @@ private:
   std::vector<Light> m_lights;
   std::vector<Box> m_obstacles;
   std::vector<Coins> m_coins;
+  //the boxes of the coins, so only the coins near the player have their contacts checked. m_coinProxies[i] is the proxy of m_coins[i]
+  GameEngine::AABBTree m_coinTree;
+  std::vector<int> m_coinProxies;
+  std::vector<int> m_nearbyCoins;
+  //the sprites of the boxes, the obstacles and the coins, extracted every frame
+  BodySprites m_bodySprites;
   std::vector<EnemyRobot> m_enemies;
   std::vector<Projectile> m_projectiles;
-  std::vector<ParallaxBackground> m_backgroundLayers;
+  //the bodies of the projectiles, made with the world
+  ProjectilePool m_projectilePool;
+  ParallaxBackground m_background;
 
   // a single exit and trigger
   Box m_exit;
   Box m_trigger;
   // a unique pointer to the box2d world
   std::unique_ptr<b2World> m_world;
+  // steps the world on a worker while the frame draws the copy of the bodies, destroyed before the world
+  PhysicsSnapshot m_physics;
+  //deactivates the bodies far from the camera
+  DormantRegions m_dormantRegions;
 };
 
 #endif
\ No newline at end of file
@@ -1,3 +1,86 @@
 #include "LevelPathContainer.h"
 
-std::string levelPath = "Levels/ALevel1ALevel1";
\ No newline at end of file
+#include <GameEngine/ResourceManager.h>
+
+std::string levelPath = "Levels/ALevel1ALevel1";
+
+LevelPreloader& LevelPreloader::Get()
+{
+  static LevelPreloader preloader;
+  return preloader;
+}
+
+void LevelPreloader::Preload(const std::string& _filePath)
+{
+  if (m_result && m_filePath == _filePath)
+  {
+    return;
+  }
+  Clear();
+  m_filePath = _filePath;
+  std::shared_ptr<Result> result = std::make_shared<Result>();
+  m_result = result;
+  GameEngine::JobSystem::Get().Run([this, result, _filePath]()
+  {
+    result->isParsed = LevelReaderWriter::Parse(_filePath, result->level);
+    if (result->isParsed)
+    {
+      LevelReaderWriter::GetTextures(result->level, result->textures);
+    }
+    //the textures are loaded through the cache, on the main thread. A level preloaded since then drops them
+    GameEngine::JobSystem::Get().RunOnMainThread([this, result]()
+    {
+      if (result == m_result)
+      {
+        LoadTextures();
+      }
+    });
+  }, &m_counter);
+}
+
+bool LevelPreloader::Load(const std::string& _filePath, b2World* _world, Player& _player, std::vector<Box>& _boxes,
+  std::vector<Box>& _obstacles, std::vector<Coins>& _coins, Box& _exit, Box& _trigger,
+  std::vector<Light>& _lights, std::vector<EnemyRobot>& _enemies, GameEngine::PreloadedAssets& _assets)
+{
+  if (m_result && m_filePath == _filePath)
+  {
+    GameEngine::JobSystem::Get().Wait(m_counter);
+    bool isLoaded = false;
+    if (m_result->isParsed)
+    {
+      LoadTextures();
+      //the textures still decoding are finished and uploaded, the level gets them from the cache
+      GameEngine::ResourceManager::Preload(m_result->textures, _assets);
+      isLoaded = LevelReaderWriter::Instantiate(m_result->level, _world, _player, _boxes, _obstacles, _coins, _exit, _trigger,
+        _lights, _enemies);
+    }
+    Clear();
+    if (isLoaded)
+    {
+      return true;
+    }
+  }
+  return LevelReaderWriter::Load(_filePath, _world, _player, _boxes, _obstacles, _coins, _exit, _trigger, _lights, _enemies);
+}
+
+void LevelPreloader::Clear()
+{
+  GameEngine::JobSystem::Get().Wait(m_counter);
+  m_filePath.clear();
+  m_result.reset();
+  m_assets.Release();
+  m_hasTextures = false;
+}
+
+void LevelPreloader::LoadTextures()
+{
+  if (m_hasTextures || !m_result->isParsed)
+  {
+    return;
+  }
+  for (const auto& asset : m_result->textures.GetAssets())
+  {
+    m_assets.textures.push_back(GameEngine::ResourceManager::LoadTextureAsync(asset.path, asset.alpha));
+  }
+  m_hasTextures = true;
+}
@@ -1,9 +1,52 @@
 #ifndef _LEVELPATHCONTAINER_
 #define _LEVELPATHCONTAINER_
 
+#include <memory>
 #include <string>
+#include <GameEngine/AssetManifest.h>
+#include <GameEngine/JobSystem.h>
+
+#include "LevelReaderWriter.h"
+
 //extern string for the levelpath
 //used so that it can be remembered and used by multiple screens
 extern std::string levelPath;
 
+/** \brief Reads the level the game goes to next (the one of levelPath) while the current one is played or a screen between them is
+* shown: its file is parsed on a JobSystem worker, then its textures are decoded on the loader thread of the ResourceManager. When
+* GameplayScreen loads the level only the textures still decoding are finished, and they're uploaded and the bodies are made */
+class LevelPreloader
+{
+public:
+  static LevelPreloader& Get();
+
+  //starts reading the level, nothing if it's the one read already
+  void Preload(const std::string& _filePath);
+  //loads the level from what was preloaded (waiting for the parse if it's still going), or from its file if another level was
+  //preloaded or it failed. The textures of the level are kept in _assets
+  bool Load(const std::string& _filePath, b2World* _world, Player& _player, std::vector<Box>& _boxes,
+            std::vector<Box>& _obstacles, std::vector<Coins>& _coins, Box& _exit, Box& _trigger,
+            std::vector<Light>& _lights, std::vector<EnemyRobot>& _enemies, GameEngine::PreloadedAssets& _assets);
+  //waits for the parse and drops the preloaded level and its textures, before the GL context goes
+  void Clear();
+
+private:
+  //written by the job, read once m_counter is done
+  struct Result
+  {
+    ParsedLevel level;
+    GameEngine::AssetManifest textures;
+    bool isParsed{ false };
+  };
+
+  //starts decoding the textures of the parsed level, on the main thread
+  void LoadTextures();
+
+  std::string m_filePath;
+  std::shared_ptr<Result> m_result;
+  GameEngine::JobCounter m_counter;
+  GameEngine::PreloadedAssets m_assets; ///< the textures of the level, kept in the cache while they're decoded
+  bool m_hasTextures{ false };
+};
+
 #endif // !_LEVELPATHCONTAINER_
@@ -1,15 +1,470 @@
 #include "LevelReaderWriter.h"
 
 #include <GameEngine/ResourceManager.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <unordered_map>
 
 // When you want to make a new version, add it here
 const unsigned int TEXT_VERSION_0 = 100;
-const unsigned int BINARY_VERSION_0 = 200;
+const unsigned int BINARY_VERSION_0 = 200; // never written, its writer was a stub
+const unsigned int BINARY_VERSION_1 = 201;
 
 // Make sure this is set to the current version
 const unsigned int TEXT_VERSION = TEXT_VERSION_0;
-const unsigned int BINARY_VERSION = BINARY_VERSION_0;
+const unsigned int BINARY_VERSION = BINARY_VERSION_1;
+
+namespace
+{
+  const std::uint32_t LEVEL_MAGIC = 0x4C564C47; ///< GLVL
+
+  //the records of the binary level, laid out as they're stored (4 byte fields, no padding) so the mapped file is read in place
+  struct LevelArray
+  {
+    std::uint32_t offset; ///< from the start of the file, aligned to the record
+    std::uint32_t count;
+  };
+
+  struct LevelEntityRecord
+  {
+    glm::vec2 position;
+    glm::vec2 drawDims;
+    glm::vec2 colDims;
+    GameEngine::ColorRGBA8 color;
+  };
+  static_assert(sizeof(LevelEntityRecord) == 28, "LevelEntityRecord is stored as it is");
+
+  struct LevelBoxRecord
+  {
+    glm::vec2 position;
+    glm::vec2 dimensions;
+    glm::vec4 uvRect;
+    GameEngine::ColorRGBA8 color;
+    float angle;
+    std::uint32_t texture; ///< the index in the texture table
+    std::uint8_t isDynamic;
+    std::uint8_t fixedRotation;
+    std::uint8_t isSensor;
+    std::uint8_t padding;
+  };
+  static_assert(sizeof(LevelBoxRecord) == 48, "LevelBoxRecord is stored as it is");
+
+  struct LevelCoinRecord
+  {
+    glm::vec2 position;
+    glm::vec2 dimensions;
+    GameEngine::ColorRGBA8 color;
+  };
+  static_assert(sizeof(LevelCoinRecord) == 20, "LevelCoinRecord is stored as it is");
+
+  struct LevelLightRecord
+  {
+    glm::vec2 position;
+    float size;
+    GameEngine::ColorRGBA8 color;
+  };
+  static_assert(sizeof(LevelLightRecord) == 16, "LevelLightRecord is stored as it is");
+
+  //a texture path in the names blob, every path is stored once and the boxes refer to it by index
+  struct LevelNameRecord
+  {
+    std::uint32_t offset; ///< from the start of the names
+    std::uint32_t length;
+  };
+
+  struct LevelHeader
+  {
+    std::uint32_t magic;
+    std::uint32_t version;
+    LevelEntityRecord player;
+    LevelBoxRecord exit;
+    LevelBoxRecord trigger;
+    LevelArray boxes;     ///< LevelBoxRecord
+    LevelArray obstacles; ///< LevelBoxRecord
+    LevelArray coins;     ///< LevelCoinRecord
+    LevelArray lights;    ///< LevelLightRecord
+    LevelArray enemies;   ///< LevelEntityRecord
+    LevelArray textures;  ///< LevelNameRecord
+    LevelArray names;     ///< the chars of the texture paths
+  };
+
+  //the texture paths of the boxes as the table of the file, every path is stored once. They're kept as paths, not interned, so a
+  //table can be made on a worker
+  class TextureTable
+  {
+  public:
+    std::uint32_t Add(const std::string& _path)
+    {
+      auto it = m_indices.find(_path);
+      if (it != m_indices.end())
+      {
+        return it->second;
+      }
+      LevelNameRecord record;
+      record.offset = static_cast<std::uint32_t>(m_names.size());
+      record.length = static_cast<std::uint32_t>(_path.size());
+      m_names.insert(m_names.end(), _path.begin(), _path.end());
+      const std::uint32_t index = static_cast<std::uint32_t>(m_records.size());
+      m_records.push_back(record);
+      m_indices.emplace(_path, index);
+      return index;
+    }
+    const std::vector<LevelNameRecord>& GetRecords() const { return m_records; }
+    const std::vector<char>& GetNames() const { return m_names; }
+
+  private:
+    std::unordered_map<std::string, std::uint32_t> m_indices;
+    std::vector<LevelNameRecord> m_records;
+    std::vector<char> m_names;
+  };
+
+  LevelEntityRecord MakeEntityRecord(const Entity& _entity)
+  {
+    LevelEntityRecord record;
+    record.position = _entity.GetPosition();
+    record.drawDims = _entity.GetDrawDims();
+    record.colDims = _entity.GetColDims();
+    record.color = _entity.GetColor();
+    return record;
+  }
+
+  LevelBoxRecord MakeBoxRecord(const Box& _box, TextureTable& _textures)
+  {
+    LevelBoxRecord record;
+    record.position = _box.GetPosition();
+    record.dimensions = _box.GetDimensions();
+    record.uvRect = _box.GetUvRect();
+    record.color = _box.GetColor();
+    record.angle = _box.GetAngle();
+    record.texture = _textures.Add(GameEngine::AssetIds::GetName(_box.GetTexture().asset));
+    record.isDynamic = _box.GetIsDynamic() ? 1 : 0;
+    record.fixedRotation = _box.GetFixedRotation() ? 1 : 0;
+    record.isSensor = _box.GetIsSensor() ? 1 : 0;
+    record.padding = 0;
+    return record;
+  }
+
+  //appends the records aligned to their type and points _array at them
+  template <class T>
+  void WriteArray(std::vector<unsigned char>& _out, const std::vector<T>& _records, LevelArray& _array)
+  {
+    while (_out.size() % alignof(T) != 0)
+    {
+      _out.push_back(0);
+    }
+    _array.offset = static_cast<std::uint32_t>(_out.size());
+    _array.count = static_cast<std::uint32_t>(_records.size());
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(_records.data());
+    _out.insert(_out.end(), bytes, bytes + _records.size() * sizeof(T));
+  }
+
+  //the records of _array in the mapped file, nullptr if they're out of it
+  template <class T>
+  const T* GetArray(const GameEngine::FileSpan& _data, const LevelArray& _array)
+  {
+    if (_array.offset % alignof(T) != 0 || _array.offset > _data.size || (_data.size - _array.offset) / sizeof(T) < _array.count)
+    {
+      return nullptr;
+    }
+    return reinterpret_cast<const T*>(_data.data + _array.offset);
+  }
+
+  //the data starts with the header of a binary level, whichever its version
+  bool IsBinaryLevel(const GameEngine::FileSpan& _data)
+  {
+    if (_data.size < sizeof(LevelHeader))
+    {
+      puts("Level file too small. File may be corrupted...");
+      return false;
+    }
+    LevelHeader header;
+    std::memcpy(&header, _data.data, sizeof(LevelHeader));
+    if (header.magic != LEVEL_MAGIC)
+    {
+      puts("Not a binary level file. File may be corrupted...");
+      return false;
+    }
+    return true;
+  }
+
+  bool WriteFile(const std::string& _filePath, const std::vector<unsigned char>& _data)
+  {
+    std::ofstream file(_filePath, std::ios::binary);
+    if (file.fail())
+    {
+      perror(_filePath.c_str());
+      return false;
+    }
+    file.write(reinterpret_cast<const char*>(_data.data()), _data.size());
+    return !file.fail();
+  }
+
+  //the level as arrays of records, where they are in the binary (mapped, or in memory for a parsed level)
+  struct LevelView
+  {
+    const LevelEntityRecord* player;
+    const LevelBoxRecord* exit;
+    const LevelBoxRecord* trigger;
+    const LevelBoxRecord* boxes;
+    size_t numBoxes;
+    const LevelBoxRecord* obstacles;
+    size_t numObstacles;
+    const LevelCoinRecord* coins;
+    size_t numCoins;
+    const LevelLightRecord* lights;
+    size_t numLights;
+    const LevelEntityRecord* enemies;
+    size_t numEnemies;
+    std::vector<GameEngine::AssetId> textures; ///< by the index in the records
+  };
+
+  //a level as records, made from its objects to save it or parsed from its text. Nothing in it is interned, the text can be parsed
+  //on a worker (see LevelReaderWriter::Parse)
+  struct LevelData
+  {
+    LevelEntityRecord player;
+    LevelBoxRecord exit;
+    LevelBoxRecord trigger;
+    std::vector<LevelBoxRecord> boxes;
+    std::vector<LevelBoxRecord> obstacles;
+    std::vector<LevelCoinRecord> coins;
+    std::vector<LevelLightRecord> lights;
+    std::vector<LevelEntityRecord> enemies;
+    TextureTable textures;
+
+    //the binary of the level, the header then the arrays one after the other
+    void Write(std::vector<unsigned char>& _out) const
+    {
+      LevelHeader header;
+      std::memset(&header, 0, sizeof(LevelHeader));
+      header.magic = LEVEL_MAGIC;
+      header.version = BINARY_VERSION;
+      header.player = player;
+      header.exit = exit;
+      header.trigger = trigger;
+      _out.assign(sizeof(LevelHeader), 0);
+      WriteArray(_out, boxes, header.boxes);
+      WriteArray(_out, obstacles, header.obstacles);
+      WriteArray(_out, coins, header.coins);
+      WriteArray(_out, lights, header.lights);
+      WriteArray(_out, enemies, header.enemies);
+      WriteArray(_out, textures.GetRecords(), header.textures);
+      WriteArray(_out, textures.GetNames(), header.names);
+      std::memcpy(_out.data(), &header, sizeof(LevelHeader));
+    }
+  };
+
+  //gets the texture of a table index from the ResourceManager the first time it's used, with or without alpha
+  class TextureResolver
+  {
+  public:
+    explicit TextureResolver(const std::vector<GameEngine::AssetId>& _ids) : m_ids(_ids)
+    {
+      for (int alpha = 0; alpha < 2; alpha++)
+      {
+        m_textures[alpha].resize(_ids.size());
+        m_isResolved[alpha].assign(_ids.size(), false);
+      }
+    }
+    const GameEngine::GLTexture& Get(std::uint32_t _index, bool _alpha)
+    {
+      const int alpha = _alpha ? 1 : 0;
+      if (!m_isResolved[alpha][_index])
+      {
+        m_textures[alpha][_index] = GameEngine::ResourceManager::GetTexture(m_ids[_index], _alpha);
+        m_isResolved[alpha][_index] = true;
+      }
+      return m_textures[alpha][_index];
+    }
+
+  private:
+    const std::vector<GameEngine::AssetId>& m_ids;
+    std::vector<GameEngine::GLTexture> m_textures[2];
+    std::vector<bool> m_isResolved[2];
+  };
+
+  /* The instantiation stage of both loaders: the containers are sized once, every texture of the table is resolved once, and the
+  *  bodies are made inactive so none of them goes in the broadphase while the others are made. They're all activated at the end,
+  *  the proxies are made in one pass over the finished level */
+  void InstantiateLevel(const LevelView& _level, b2World* _world, Player& _player, std::vector<Box>& _boxes,
+    std::vector<Box>& _obstacles, std::vector<Coins>& _coins, Box& _exit, Box& _trigger, std::vector<Light>& _lights, std::vector<EnemyRobot>& _enemies)
+  {
+    TextureResolver textures(_level.textures);
+    auto initBox = [&](Box& _box, const LevelBoxRecord& _record, bool _alpha)
+    {
+      _box.Init(_world, _record.position, _record.dimensions, textures.Get(_record.texture, _alpha), _record.color, _record.fixedRotation != 0,
+        _record.isDynamic != 0, _record.isSensor != 0, _record.angle, _record.uvRect, false);
+    };
+    auto initEntity = [&](Entity& _entity, const LevelEntityRecord& _record)
+    {
+      glm::vec2 colDims = _record.colDims;
+      _entity.Init(_world, _record.position, _record.drawDims, colDims, _record.color, false);
+    };
+    const size_t firstBox = _boxes.size();
+    const size_t firstObstacle = _obstacles.size();
+    const size_t firstCoin = _coins.size();
+    const size_t firstEnemy = _enemies.size();
+    _boxes.reserve(firstBox + _level.numBoxes);
+    _obstacles.reserve(firstObstacle + _level.numObstacles);
+    _coins.reserve(firstCoin + _level.numCoins);
+    _lights.reserve(_lights.size() + _level.numLights);
+    _enemies.reserve(firstEnemy + _level.numEnemies);
+
+    initEntity(_player, *_level.player);
+    //the exit, the trigger and the obstacles have alpha, the boxes are loaded without it
+    initBox(_exit, *_level.exit, true);
+    initBox(_trigger, *_level.trigger, true);
+    for (size_t i = 0; i < _level.numBoxes; i++)
+    {
+      _boxes.emplace_back();
+      initBox(_boxes.back(), _level.boxes[i], false);
+    }
+    for (size_t i = 0; i < _level.numObstacles; i++)
+    {
+      _obstacles.emplace_back();
+      initBox(_obstacles.back(), _level.obstacles[i], true);
+    }
+    for (size_t i = 0; i < _level.numLights; i++)
+    {
+      _lights.emplace_back();
+      _lights.back().color = _level.lights[i].color;
+      _lights.back().position = _level.lights[i].position;
+      _lights.back().size = _level.lights[i].size;
+    }
+    for (size_t i = 0; i < _level.numEnemies; i++)
+    {
+      _enemies.emplace_back();
+      initEntity(_enemies.back(), _level.enemies[i]);
+    }
+    for (size_t i = 0; i < _level.numCoins; i++)
+    {
+      _coins.emplace_back(_world, _level.coins[i].position, _level.coins[i].dimensions, _level.coins[i].color, false);
+    }
+
+    //all the bodies are there, now they go in the broadphase
+    _player.GetCapsule().GetBody()->SetActive(true);
+    _exit.GetBody()->SetActive(true);
+    _trigger.GetBody()->SetActive(true);
+    for (size_t i = firstBox; i < _boxes.size(); i++)
+    {
+      _boxes[i].GetBody()->SetActive(true);
+    }
+    for (size_t i = firstObstacle; i < _obstacles.size(); i++)
+    {
+      _obstacles[i].GetBody()->SetActive(true);
+    }
+    for (size_t i = firstEnemy; i < _enemies.size(); i++)
+    {
+      _enemies[i].GetCapsule().GetBody()->SetActive(true);
+    }
+    for (size_t i = firstCoin; i < _coins.size(); i++)
+    {
+      _coins[i].GetBox().GetBody()->SetActive(true);
+    }
+  }
+}
+
+bool LevelReaderWriter::Save(const std::string& _filePath, const Player& _player,
+  const std::vector<Box>& _boxes, const std::vector<Box>& _obstacles, const std::vector<Coins>& _coins, const Box& _exit,
+  const Box& _trigger, const std::vector<Light>& _lights, const std::vector<EnemyRobot>& _enemies)
+{
+  if (!SaveAsText(_filePath, _player, _boxes, _obstacles, _coins, _exit, _trigger, _lights, _enemies))
+  {
+    return false;
+  }
+  //the text is saved, a binary which failed is cooked again on the next load
+  SaveAsBinary(GetBinaryPath(_filePath), _player, _boxes, _obstacles, _coins, _exit, _trigger, _lights, _enemies);
+  return true;
+}
+
+bool LevelReaderWriter::Load(const std::string& _filePath, b2World* _world, Player& _player, std::vector<Box>& _boxes,
+  std::vector<Box>& _obstacles, std::vector<Coins>& _coins, Box& _exit, Box& _trigger, std::vector<Light>& _lights, std::vector<EnemyRobot>& _enemies)
+{
+  const std::string binaryPath = GetBinaryPath(_filePath);
+  if (GameEngine::IOManager::IsNewerThan(binaryPath, _filePath) &&
+    LoadAsBinary(binaryPath, _world, _player, _boxes, _obstacles, _coins, _exit, _trigger, _lights, _enemies))
+  {
+    return true;
+  }
+  return LoadAsText(_filePath, _world, _player, _boxes, _obstacles, _coins, _exit, _trigger, _lights, _enemies);
+}
+
+bool LevelReaderWriter::Parse(const std::string& _filePath, ParsedLevel& _level)
+{
+  //the binary is only read here, it's checked when the level is made
+  _level.filePath = _filePath;
+  const std::string binaryPath = GetBinaryPath(_filePath);
+  if (GameEngine::IOManager::IsNewerThan(binaryPath, _filePath) && GameEngine::IOManager::ReadFileToBuffer(binaryPath, _level.data))
+  {
+    return true;
+  }
+  return ParseText(_filePath, _level);
+}
+
+bool LevelReaderWriter::Instantiate(const ParsedLevel& _level, b2World* _world, Player& _player, std::vector<Box>& _boxes,
+  std::vector<Box>& _obstacles, std::vector<Coins>& _coins, Box& _exit, Box& _trigger, std::vector<Light>& _lights, std::vector<EnemyRobot>& _enemies)
+{
+  GameEngine::FileSpan data;
+  data.data = _level.data.data();
+  data.size = _level.data.size();
+  return LoadBinaryData(data, _world, _player, _boxes, _obstacles, _coins, _exit, _trigger, _lights, _enemies);
+}
+
+void LevelReaderWriter::GetTextures(const ParsedLevel& _level, GameEngine::AssetManifest& _manifest)
+{
+  GameEngine::FileSpan data;
+  data.data = _level.data.data();
+  data.size = _level.data.size();
+  if (!IsBinaryLevel(data))
+  {
+    return;
+  }
+  const LevelHeader& header = *reinterpret_cast<const LevelHeader*>(data.data);
+  if (header.version != BINARY_VERSION_1)
+  {
+    return;
+  }
+  const LevelBoxRecord* boxes = GetArray<LevelBoxRecord>(data, header.boxes);
+  const LevelBoxRecord* obstacles = GetArray<LevelBoxRecord>(data, header.obstacles);
+  const LevelNameRecord* textures = GetArray<LevelNameRecord>(data, header.textures);
+  const char* names = GetArray<char>(data, header.names);
+  if (!boxes || !obstacles || !textures || !names)
+  {
+    return;
+  }
+  //a broken record is skipped, the level fails its checks when it's made
+  auto addTexture = [&](const LevelBoxRecord& _box, bool _alpha)
+  {
+    if (_box.texture >= header.textures.count)
+    {
+      return;
+    }
+    const LevelNameRecord& name = textures[_box.texture];
+    if (name.offset <= header.names.count && header.names.count - name.offset >= name.length)
+    {
+      _manifest.Add(GameEngine::AssetManifest::AssetType::TEXTURE, std::string(names + name.offset, name.length), _alpha);
+    }
+  };
+  //with the alpha InstantiateLevel loads them with
+  addTexture(header.exit, true);
+  addTexture(header.trigger, true);
+  for (std::uint32_t i = 0; i < header.boxes.count; i++)
+  {
+    addTexture(boxes[i], false);
+  }
+  for (std::uint32_t i = 0; i < header.obstacles.count; i++)
+  {
+    addTexture(obstacles[i], true);
+  }
+}
+
+bool LevelReaderWriter::IsLevelFile(const std::string& _filePath)
+{
+  const std::string extension = ".bin";
+  return _filePath.size() < extension.size() || _filePath.compare(_filePath.size() - extension.size(), extension.size(), extension) != 0;
+}
 
 bool LevelReaderWriter::SaveAsText(const std::string& _filePath, const Player& _player,
   const std::vector<Box>& _boxes, const std::vector<Box>& _obstacles, const std::vector<Coins>& _coins, const Box& _exit,
@@ -19,15 +474,37 @@ bool LevelReaderWriter::SaveAsText(const std::string& _filePath, const Player& _
   return SaveAsTextV0(_filePath, _player, _boxes, _obstacles, _coins, _exit, _trigger, _lights, _enemies);
 }
 
-bool LevelReaderWriter::SaveAsBinary(const std::string& _filePath, const Player& _player, const std::vector<Box>& _boxes)
+bool LevelReaderWriter::SaveAsBinary(const std::string& _filePath, const Player& _player, const std::vector<Box>& _boxes,
+  const std::vector<Box>& _obstacles, const std::vector<Coins>& _coins, const Box& _exit, const Box& _trigger,
+  const std::vector<Light>& _lights, const std::vector<EnemyRobot>& _enemies)
 {
   //always up to date with newest version
-  return SaveAsBinaryV0(_filePath, _player, _boxes);
+  return SaveAsBinaryV1(_filePath, _player, _boxes, _obstacles, _coins, _exit, _trigger, _lights, _enemies);
 }
 
 bool LevelReaderWriter::LoadAsText(const std::string& _filePath, b2World* _world, Player& _player, std::vector<Box>& _boxes,
   std::vector<Box>& _obstacles, std::vector<Coins>& _coins, Box& _exit, Box& _trigger, std::vector<Light>& _lights, std::vector<EnemyRobot>& _enemies)
 {
+  ParsedLevel level;
+  return ParseText(_filePath, level) && Instantiate(level, _world, _player, _boxes, _obstacles, _coins, _exit, _trigger, _lights, _enemies);
+}
+
+bool LevelReaderWriter::LoadAsBinary(const std::string& _filePath, b2World* _world, Player& _player, std::vector<Box>& _boxes,
+  std::vector<Box>& _obstacles, std::vector<Coins>& _coins, Box& _exit, Box& _trigger, std::vector<Light>& _lights, std::vector<EnemyRobot>& _enemies)
+{
+  //map the file, the records are read where they are
+  GameEngine::MappedFile file;
+  if (!file.Open(_filePath))
+  {
+    perror(_filePath.c_str());
+    return false;
+  }
+  return LoadBinaryData(file.GetSpan(), _world, _player, _boxes, _obstacles, _coins, _exit, _trigger, _lights, _enemies);
+}
+
+bool LevelReaderWriter::ParseText(const std::string& _filePath, ParsedLevel& _level)
+{
+  _level.filePath = _filePath;
   //open file and error check
   std::ifstream file(_filePath);
   if (file.fail())
@@ -44,42 +521,37 @@ bool LevelReaderWriter::LoadAsText(const std::string& _filePath, b2World* _world
   switch (version)
   {
   case TEXT_VERSION_0:
-    LoadAsTextV0(file, _world, _player, _boxes, _obstacles, _coins, _exit, _trigger, _lights, _enemies);
+    ParseTextV0(file, _level.data);
     break;
   default:
     puts("Unknown version number in level file. File may be corrupted...");
     return false;
   }
 
+  //the binary is cooked for the next time, a packed level can't get one next to it
+  if (!GameEngine::IOManager::IsPacked(_filePath))
+  {
+    WriteFile(GetBinaryPath(_filePath), _level.data);
+  }
   return true;
 }
 
-bool LevelReaderWriter::LoadAsBinary(const std::string& _filePath, b2World* _world, Player& _player, std::vector<Box>& _boxes)
+bool LevelReaderWriter::LoadBinaryData(const GameEngine::FileSpan& _data, b2World* _world, Player& _player, std::vector<Box>& _boxes,
+  std::vector<Box>& _obstacles, std::vector<Coins>& _coins, Box& _exit, Box& _trigger, std::vector<Light>& _lights, std::vector<EnemyRobot>& _enemies)
 {
-  //not implemented
-  std::fstream file(_filePath + ".bin", std::ios::out | std::ios::binary);
-  if (file.fail())
+  if (!IsBinaryLevel(_data))
   {
-    perror((_filePath + ".bin").c_str());
     return false;
   }
-  //get version
-  unsigned int version = NULL;
-  //read the version
-  file.read((char*)version, sizeof(unsigned int));
   //read level based on version
-  switch (version)
-  {
-  case BINARY_VERSION_0:
+  switch (reinterpret_cast<const LevelHeader*>(_data.data)->version)
   {
-    LoadAsBinaryV0(file, _world, _player, _boxes);
-    break;
-  }
-  default: puts("Unknown version number in level file.File may be corrupted...");
+  case BINARY_VERSION_1:
+    return LoadAsBinaryV1(_data, _world, _player, _boxes, _obstacles, _coins, _exit, _trigger, _lights, _enemies);
+  default:
+    puts("Unknown version number in level file. File may be corrupted...");
     return false;
-    break;
   }
-  return true;
 }
 
 bool LevelReaderWriter::SaveAsTextV0(const std::string& _filePath, const Player& _player, const std::vector<Box>& _boxes,
@@ -109,7 +581,7 @@ bool LevelReaderWriter::SaveAsTextV0(const std::string& _filePath, const Player&
     << _exit.GetColor().b << ' ' << _exit.GetColor().a << ' '
     << _exit.GetUvRect().x << ' ' << _exit.GetUvRect().y << ' '
     << _exit.GetUvRect().z << ' ' << _exit.GetUvRect().w << ' '
-    << _exit.GetAngle() << ' ' << _exit.GetTexture().filePath << ' '
+    << _exit.GetAngle() << ' ' << GameEngine::AssetIds::GetName(_exit.GetTexture().asset) << ' '
     << _exit.GetIsDynamic() << ' ' << _exit.GetFixedRotation() << ' '
     << _exit.GetIsSensor() << '\n';
 
@@ -120,7 +592,7 @@ bool LevelReaderWriter::SaveAsTextV0(const std::string& _filePath, const Player&
     << _trigger.GetColor().b << ' ' << _trigger.GetColor().a << ' '
     << _trigger.GetUvRect().x << ' ' << _trigger.GetUvRect().y << ' '
     << _trigger.GetUvRect().z << ' ' << _trigger.GetUvRect().w << ' '
-    << _trigger.GetAngle() << ' ' << _trigger.GetTexture().filePath << ' '
+    << _trigger.GetAngle() << ' ' << GameEngine::AssetIds::GetName(_trigger.GetTexture().asset) << ' '
     << _trigger.GetIsDynamic() << ' ' << _trigger.GetFixedRotation() << ' '
     << _trigger.GetIsSensor() << '\n';
 
@@ -136,7 +608,7 @@ bool LevelReaderWriter::SaveAsTextV0(const std::string& _filePath, const Player&
       << b.GetColor().b << ' ' << b.GetColor().a << ' '
       << b.GetUvRect().x << ' ' << b.GetUvRect().y << ' '
       << b.GetUvRect().z << ' ' << b.GetUvRect().w << ' '
-      << b.GetAngle() << ' ' << b.GetTexture().filePath << ' '
+      << b.GetAngle() << ' ' << GameEngine::AssetIds::GetName(b.GetTexture().asset) << ' '
       << b.GetIsDynamic() << ' ' << b.GetFixedRotation() << ' '
       << b.GetIsSensor() << '\n';
   }
@@ -152,7 +624,7 @@ bool LevelReaderWriter::SaveAsTextV0(const std::string& _filePath, const Player&
       << obs.GetColor().b << ' ' << obs.GetColor().a << ' '
       << obs.GetUvRect().x << ' ' << obs.GetUvRect().y << ' '
       << obs.GetUvRect().z << ' ' << obs.GetUvRect().w << ' '
-      << obs.GetAngle() << ' ' << obs.GetTexture().filePath << ' '
+      << obs.GetAngle() << ' ' << GameEngine::AssetIds::GetName(obs.GetTexture().asset) << ' '
       << obs.GetIsDynamic() << ' ' << obs.GetFixedRotation() << ' '
       << obs.GetIsSensor() << '\n';
   }
@@ -191,261 +663,184 @@ bool LevelReaderWriter::SaveAsTextV0(const std::string& _filePath, const Player&
   return true;
 }
 
-bool LevelReaderWriter::LoadAsTextV0(std::ifstream& _file, b2World* _world, Player& _player, std::vector<Box>& _boxes,
-         std::vector<Box>& _obstacles, std::vector<Coins>& _coins, Box& _exit, Box& _trigger, std::vector<Light>& _lights, std::vector<EnemyRobot>& _enemies)
+void LevelReaderWriter::ParseTextV0(std::ifstream& _file, std::vector<unsigned char>& _level)
 {
+  //the text is parsed into records and written as the binary, both loaders make the level from that
+  LevelData level;
+  auto readEntity = [&_file](LevelEntityRecord& _record)
   {
-    //read the player
-    glm::vec2 pos;
-    glm::vec2 drawDims;
-    glm::vec2 colDims;
-    GameEngine::ColorRGBA8 color;
-    _file >> pos.x >> pos.y >> drawDims.x >> drawDims.y >> colDims.x >> colDims.y >> color.r >> color.g >> color.b >> color.a;
-
-    _player.Init(_world, pos, drawDims, colDims, color);
-  }
-
+    _file >> _record.position.x >> _record.position.y >> _record.drawDims.x >> _record.drawDims.y >> _record.colDims.x >> _record.colDims.y
+      >> _record.color.r >> _record.color.g >> _record.color.b >> _record.color.a;
+  };
+  auto readBox = [&_file, &level](LevelBoxRecord& _record)
   {
-    //read the exit
-    //read exits
-    glm::vec2 pos;
-    glm::vec2 dims;
-    glm::vec4 uvRect;
-    GameEngine::ColorRGBA8 color;
-    bool fixedRotation;
-    bool isDynamic;
-    bool isSensor;
-    float angle;
-
-    GameEngine::GLTexture texture;
     std::string texturePath;
-
-      _file >> pos.x >> pos.y >> dims.x >> dims.y >> color.r >> color.g >> color.b >> color.a
-        >> uvRect.x >> uvRect.y >> uvRect.z >> uvRect.w
-        >> angle >> texturePath >> isDynamic >> fixedRotation >> isSensor;
-
-      texture = GameEngine::ResourceManager::GetTexture(texturePath);
-      _exit.Init(_world, pos, dims, texture, color, fixedRotation, isDynamic, isSensor, angle, uvRect);
-  }
-  
-  {
-    //read the trigger(switch)
-    //read triggers
-    glm::vec2 pos;
-    glm::vec2 dims;
-    glm::vec4 uvRect;
-    GameEngine::ColorRGBA8 color;
-    bool fixedRotation;
     bool isDynamic;
-    bool isSensor;
-    float angle;
-
-    GameEngine::GLTexture texture;
-    std::string texturePath;
-
-      _file >> pos.x >> pos.y >> dims.x >> dims.y >> color.r >> color.g >> color.b >> color.a
-        >> uvRect.x >> uvRect.y >> uvRect.z >> uvRect.w
-        >> angle >> texturePath >> isDynamic >> fixedRotation >> isSensor;
-
-      texture = GameEngine::ResourceManager::GetTexture(texturePath);
-      _trigger.Init(_world, pos, dims, texture, color, fixedRotation, isDynamic, isSensor, angle, uvRect);
-  }
-
-  {
-    //read boxes
-    glm::vec2 pos;
-    glm::vec2 dims;
-    glm::vec4 uvRect;
-    GameEngine::ColorRGBA8 color;
     bool fixedRotation;
-    bool isDynamic;
     bool isSensor;
-    float angle;
-
-    GameEngine::GLTexture texture;
-    std::string texturePath;
-    size_t numBoxes;
-    _file >> numBoxes;
-
-    for (size_t i = 0; i < numBoxes; i++)
-    {
-      _file >> pos.x >> pos.y >> dims.x >> dims.y >> color.r >> color.g >> color.b >> color.a
-        >> uvRect.x >> uvRect.y >> uvRect.z >> uvRect.w
-        >> angle >> texturePath >> isDynamic >> fixedRotation >> isSensor;
-
-      texture = GameEngine::ResourceManager::GetTexture(texturePath, false);
-      _boxes.emplace_back();
-      _boxes.back().Init(_world, pos, dims, texture, color, fixedRotation, isDynamic, isSensor, angle, uvRect);
-    }
+    _file >> _record.position.x >> _record.position.y >> _record.dimensions.x >> _record.dimensions.y
+      >> _record.color.r >> _record.color.g >> _record.color.b >> _record.color.a
+      >> _record.uvRect.x >> _record.uvRect.y >> _record.uvRect.z >> _record.uvRect.w
+      >> _record.angle >> texturePath >> isDynamic >> fixedRotation >> isSensor;
+    _record.texture = level.textures.Add(texturePath);
+    _record.isDynamic = isDynamic ? 1 : 0;
+    _record.fixedRotation = fixedRotation ? 1 : 0;
+    _record.isSensor = isSensor ? 1 : 0;
+    _record.padding = 0;
+  };
+
+  //read the player, the exit and the trigger(switch)
+  readEntity(level.player);
+  readBox(level.exit);
+  readBox(level.trigger);
+
+  //read boxes
+  size_t numBoxes;
+  _file >> numBoxes;
+  level.boxes.resize(numBoxes);
+  for (auto& box : level.boxes)
+  {
+    readBox(box);
   }
 
+  //read obstacles
+  size_t numObstacles;
+  _file >> numObstacles;
+  level.obstacles.resize(numObstacles);
+  for (auto& obs : level.obstacles)
   {
-    //read obstacles
-    glm::vec2 pos;
-    glm::vec2 dims;
-    glm::vec4 uvRect;
-    GameEngine::ColorRGBA8 color;
-    bool fixedRotation;
-    bool isDynamic;
-    bool isSensor;
-    float angle;
-
-    GameEngine::GLTexture texture;
-    std::string texturePath;
-    size_t numObstacles;
-    _file >> numObstacles;
-
-    for (size_t i = 0; i < numObstacles; i++)
-    {
-      _file >> pos.x >> pos.y >> dims.x >> dims.y >> color.r >> color.g >> color.b >> color.a
-        >> uvRect.x >> uvRect.y >> uvRect.z >> uvRect.w
-        >> angle >> texturePath >> isDynamic >> fixedRotation >> isSensor;
-
-      texture = GameEngine::ResourceManager::GetTexture(texturePath);
-      _obstacles.emplace_back();
-      _obstacles.back().Init(_world, pos, dims, texture, color, fixedRotation, isDynamic, isSensor, angle, uvRect);
-    }
+    readBox(obs);
   }
 
+  //read lights
+  size_t numLights;
+  _file >> numLights;
+  level.lights.resize(numLights);
+  for (auto& light : level.lights)
   {
-    //read lights
-    glm::vec2 pos;
-    GameEngine::ColorRGBA8 color;
-    float size;
-
-    size_t numLights;
-    _file >> numLights;
-
-    for (size_t i = 0; i < numLights; i++)
-    {
-      _file >> pos.x >> pos.y >> size >> color.r >> color.g >> color.b >> color.a;
-
-      _lights.emplace_back();
-      _lights.back().color = color;
-      _lights.back().position = pos;
-      _lights.back().size = size;
-    }
+    _file >> light.position.x >> light.position.y >> light.size >> light.color.r >> light.color.g >> light.color.b >> light.color.a;
   }
 
+  //read the enemies
+  size_t numEnemies;
+  _file >> numEnemies;
+  level.enemies.resize(numEnemies);
+  for (auto& enemy : level.enemies)
   {
-    //read the enemies
-    glm::vec2 pos;
-    glm::vec2 drawDims;
-    glm::vec2 colDims;
-    GameEngine::ColorRGBA8 color;
-
-    size_t numEnemies;
-    _file >> numEnemies;
-
-    for (size_t i = 0; i < numEnemies; i++)
-    {
-      _file >> pos.x >> pos.y >> drawDims.x >> drawDims.y >> colDims.x >> colDims.y >> color.r >> color.g >> color.b >> color.a;
-      _enemies.emplace_back();
-      _enemies.back().Init(_world, pos, drawDims, colDims, color);
-    }
+    readEntity(enemy);
   }
 
+  //read coins
+  size_t numCoins;
+  _file >> numCoins;
+  level.coins.resize(numCoins);
+  for (auto& coin : level.coins)
   {
-    //read coins
-    glm::vec2 pos;
-    glm::vec2 dims;
-    GameEngine::ColorRGBA8 color;
-
-    GameEngine::GLTexture texture;
-    size_t numCoins;
-    _file >> numCoins;
-
-    for (size_t i = 0; i < numCoins; i++)
-    {
-      _file >> pos.x >> pos.y >> dims.x >> dims.y >> color.r >> color.g >> color.b >> color.a ;
-
-      _coins.emplace_back(_world, pos, dims, color);
-    }
+    _file >> coin.position.x >> coin.position.y >> coin.dimensions.x >> coin.dimensions.y >> coin.color.r >> coin.color.g >> coin.color.b >> coin.color.a;
   }
   _file.close();
-  return true;
+
+  level.Write(_level);
 }
 
-bool LevelReaderWriter::LoadAsBinaryV0(std::fstream& _file, b2World* _world, Player& _player, std::vector<Box>& _boxes)
+bool LevelReaderWriter::LoadAsBinaryV1(const GameEngine::FileSpan& _data, b2World* _world, Player& _player, std::vector<Box>& _boxes,
+  std::vector<Box>& _obstacles, std::vector<Coins>& _coins, Box& _exit, Box& _trigger, std::vector<Light>& _lights, std::vector<EnemyRobot>& _enemies)
 {
+  const LevelHeader& header = *reinterpret_cast<const LevelHeader*>(_data.data);
+  const LevelBoxRecord* boxes = GetArray<LevelBoxRecord>(_data, header.boxes);
+  const LevelBoxRecord* obstacles = GetArray<LevelBoxRecord>(_data, header.obstacles);
+  const LevelCoinRecord* coins = GetArray<LevelCoinRecord>(_data, header.coins);
+  const LevelLightRecord* lights = GetArray<LevelLightRecord>(_data, header.lights);
+  const LevelEntityRecord* enemies = GetArray<LevelEntityRecord>(_data, header.enemies);
+  const LevelNameRecord* textures = GetArray<LevelNameRecord>(_data, header.textures);
+  const char* names = GetArray<char>(_data, header.names);
+  //everything is checked before the level is built, a broken file doesn't leave half a level
+  if (!boxes || !obstacles || !coins || !lights || !enemies || !textures || !names)
   {
-    //raed the player
-    glm::vec2 pos;
-    glm::vec2 ddims;
-    glm::vec2 cdims;
-    GameEngine::ColorRGBA8 color;
-
-    _file.read((char*)&pos, sizeof(glm::vec2));
-    _file.read((char*)&ddims, sizeof(glm::vec2));
-    _file.read((char*)&cdims, sizeof(glm::vec2));
-    _file.read((char*)&color, sizeof(GameEngine::ColorRGBA8));
-
-    _player.Init(_world, pos, ddims, cdims, color);
+    puts("Level file arrays out of the file. File may be corrupted...");
+    return false;
   }
-
+  //the paths of the table are interned once, the boxes get the textures by id
+  std::vector<GameEngine::AssetId> textureIds(header.textures.count);
+  for (std::uint32_t i = 0; i < header.textures.count; i++)
   {
-    //read the boxes
-    glm::vec2 pos;
-    glm::vec2 dims;
-    glm::vec4 uvRect;
-    GameEngine::ColorRGBA8 color;
-    bool fixedRotation;
-    bool isDynamic;
-    bool isSensor;
-    float angle;
-
-    GameEngine::GLTexture texture;
-    std::string texturePath;
-    size_t numBoxes;
-
-    _file.read((char*)&numBoxes, sizeof(size_t));
-
-    for (size_t i = 0; i < numBoxes; i++)
+    if (textures[i].offset > header.names.count || header.names.count - textures[i].offset < textures[i].length)
     {
-      _file.read((char*)&pos, sizeof(glm::vec2));
-      _file.read((char*)&dims, sizeof(glm::vec2));
-      _file.read((char*)&color, sizeof(GameEngine::ColorRGBA8));
-      _file.read((char*)&uvRect, sizeof(glm::vec4));
-      _file.read((char*)&angle, sizeof(float));
-      _file.read((char*)&texturePath, sizeof(std::string));
-      _file.read((char*)&fixedRotation, sizeof(bool));
-      _file.read((char*)&isDynamic, sizeof(bool));
-      _file.read((char*)&isSensor, sizeof(bool));
-
-      texture = GameEngine::ResourceManager::GetTexture(texturePath);
-      _boxes.emplace_back();
-      _boxes.back().Init(_world, pos, dims, texture, color, fixedRotation, isDynamic, isSensor, angle, uvRect);
+      puts("Level file texture name out of the file. File may be corrupted...");
+      return false;
     }
+    textureIds[i] = GameEngine::AssetIds::Intern(std::string(names + textures[i].offset, textures[i].length));
   }
-  _file.close();
+  auto isValidBox = [&header](const LevelBoxRecord& _box) { return _box.texture < header.textures.count; };
+  if (!isValidBox(header.exit) || !isValidBox(header.trigger) || !std::all_of(boxes, boxes + header.boxes.count, isValidBox) ||
+    !std::all_of(obstacles, obstacles + header.obstacles.count, isValidBox))
+  {
+    puts("Level file texture index out of the table. File may be corrupted...");
+    return false;
+  }
+  //the records are made into the level where they are
+  LevelView level;
+  level.player = &header.player;
+  level.exit = &header.exit;
+  level.trigger = &header.trigger;
+  level.boxes = boxes;
+  level.numBoxes = header.boxes.count;
+  level.obstacles = obstacles;
+  level.numObstacles = header.obstacles.count;
+  level.coins = coins;
+  level.numCoins = header.coins.count;
+  level.lights = lights;
+  level.numLights = header.lights.count;
+  level.enemies = enemies;
+  level.numEnemies = header.enemies.count;
+  level.textures = std::move(textureIds);
+  InstantiateLevel(level, _world, _player, _boxes, _obstacles, _coins, _exit, _trigger, _lights, _enemies);
   return true;
 }
 
-bool LevelReaderWriter::SaveAsBinaryV0(const std::string& _filePath, const Player& _player, const std::vector<Box>& _boxes)
+bool LevelReaderWriter::SaveAsBinaryV1(const std::string& _filePath, const Player& _player, const std::vector<Box>& _boxes,
+  const std::vector<Box>& _obstacles, const std::vector<Coins>& _coins, const Box& _exit, const Box& _trigger,
+  const std::vector<Light>& _lights, const std::vector<EnemyRobot>& _enemies)
 {
-  //not implemented
-  std::fstream file(_filePath + ".bin", std::ios::in | std::ios::binary);
-  if (file.fail())
+  LevelData level;
+  level.player = MakeEntityRecord(_player);
+  level.exit = MakeBoxRecord(_exit, level.textures);
+  level.trigger = MakeBoxRecord(_trigger, level.textures);
+  level.boxes.reserve(_boxes.size());
+  for (auto& b : _boxes)
   {
-    perror((_filePath + ".bin").c_str());
-    return false;
+    level.boxes.push_back(MakeBoxRecord(b, level.textures));
   }
-  std::string newLine = "\n";
-  //write version
-  file.write((char*)&BINARY_VERSION, sizeof(unsigned int));
-  //newline
-  file.write((char*)&newLine, sizeof(std::string));
-  //player
-  file.write((char*)&_player, sizeof(Player));
-  //newline
-  file.write((char*)&newLine, sizeof(std::string));
-  //Number of boxes
-  file.write((char*)_boxes.size(), sizeof(size_t));
-  //boxes
-  for (Box box : _boxes)
-  {
-    file.write((char*)&box, sizeof(Box));
+  level.obstacles.reserve(_obstacles.size());
+  for (auto& obs : _obstacles)
+  {
+    level.obstacles.push_back(MakeBoxRecord(obs, level.textures));
   }
-  file.close();
-  return true;
-}
+  level.coins.reserve(_coins.size());
+  for (auto& coin : _coins)
+  {
+    LevelCoinRecord record;
+    record.position = coin.GetPosition();
+    record.dimensions = coin.GetDimensions();
+    record.color = coin.GetColor();
+    level.coins.push_back(record);
+  }
+  level.lights.reserve(_lights.size());
+  for (auto& light : _lights)
+  {
+    LevelLightRecord record;
+    record.position = light.position;
+    record.size = light.size;
+    record.color = light.color;
+    level.lights.push_back(record);
+  }
+  level.enemies.reserve(_enemies.size());
+  for (auto& enemy : _enemies)
+  {
+    level.enemies.push_back(MakeEntityRecord(enemy));
+  }
+
+  std::vector<unsigned char> data;
+  level.Write(data);
+  return WriteFile(_filePath, data);
+}
\ No newline at end of file
@@ -2,6 +2,9 @@
 #define _LEVELREADERWRITER_
 
 #include <string>
+#include <vector>
+#include <GameEngine/IOManager.h>
+#include <GameEngine/AssetManifest.h>
 
 #include "Player.h"
 #include "Box.h"
@@ -9,21 +12,55 @@
 #include "EnemyRobot.h"
 #include "Coins.h"
 
+//a level read from its file but not made yet: its binary, in memory (see LevelReaderWriter::Parse)
+struct ParsedLevel
+{
+  std::string filePath;
+  std::vector<unsigned char> data;
+};
+
 class LevelReaderWriter
 {
 public:
+  //Saves the level as text (the one edited) and cooks its binary next to it
+  static bool Save(const std::string& _filePath, const Player& _player, const std::vector<Box>& _boxes,
+                   const std::vector<Box>& _obstacles, const std::vector<Coins>& _coins, const Box& _exit,
+                   const Box& _trigger, const std::vector<Light>& _lights, const std::vector<EnemyRobot>& _enemies);
+  //Loads the binary of the level if it's up to date with the text, the text otherwise (and cooks the binary for the next time)
+  static bool Load(const std::string& _filePath, b2World* _world, Player& _player, std::vector<Box>& _boxes,
+                   std::vector<Box>& _obstacles, std::vector<Coins>& _coins, Box& _exit,
+                   Box& _trigger, std::vector<Light>& _lights, std::vector<EnemyRobot>& _enemies);
+  //Reads the level into memory, the binary if it's up to date and the text parsed (and cooked) otherwise. It only touches the files,
+  //it can run on a worker (see LevelPreloader)
+  static bool Parse(const std::string& _filePath, ParsedLevel& _level);
+  //Makes a parsed level into the world, on the main thread: the texture paths are interned and the textures got here
+  static bool Instantiate(const ParsedLevel& _level, b2World* _world, Player& _player, std::vector<Box>& _boxes,
+                          std::vector<Box>& _obstacles, std::vector<Coins>& _coins, Box& _exit,
+                          Box& _trigger, std::vector<Light>& _lights, std::vector<EnemyRobot>& _enemies);
+  //adds the textures of a parsed level to the manifest, with the alpha they're loaded with
+  static void GetTextures(const ParsedLevel& _level, GameEngine::AssetManifest& _manifest);
+  //the binary of a level, next to its text
+  static std::string GetBinaryPath(const std::string& _filePath) { return _filePath + ".bin"; }
+  //false for the cooked binaries, the level lists only show the levels themselves
+  static bool IsLevelFile(const std::string& _filePath);
+
   //Static functions for level loading and saving (public ones just call the private ones which actually do the job
   static bool SaveAsText(const std::string& _filePath, const Player& _player, const std::vector<Box>& _boxes,
                          const std::vector<Box>& _obstacles, const std::vector<Coins>& _coins, const Box& _exit,
                         const Box& _trigger, const std::vector<Light>& _lights, const std::vector<EnemyRobot>& _enemies);
 
-  static bool SaveAsBinary(const std::string& _filePath, const Player& _player, const std::vector<Box>& _boxes);
+  static bool SaveAsBinary(const std::string& _filePath, const Player& _player, const std::vector<Box>& _boxes,
+                           const std::vector<Box>& _obstacles, const std::vector<Coins>& _coins, const Box& _exit,
+                           const Box& _trigger, const std::vector<Light>& _lights, const std::vector<EnemyRobot>& _enemies);
 
   static bool LoadAsText(const std::string& _filePath, b2World* _world, Player& _player, std::vector<Box>& _boxes,
                           std::vector<Box>& _obstacles, std::vector<Coins>& _coins, Box& _exit,
                           Box& _trigger, std::vector<Light>& _lights, std::vector<EnemyRobot>& _enemies);
 
-  static bool LoadAsBinary(const std::string& _filePath, b2World* _world,  Player& _player, std::vector<Box>& _boxes);
+  //maps the file and builds the level straight from its arrays, nothing is parsed
+  static bool LoadAsBinary(const std::string& _filePath, b2World* _world, Player& _player, std::vector<Box>& _boxes,
+                           std::vector<Box>& _obstacles, std::vector<Coins>& _coins, Box& _exit,
+                           Box& _trigger, std::vector<Light>& _lights, std::vector<EnemyRobot>& _enemies);
 
 private:
   //Static functions for level loading and saving (the private ones which actually do the job)
@@ -31,13 +68,22 @@ private:
                             const std::vector<Box>& _obstacles, const std::vector<Coins>& _coins, const Box& _exit,
                             const Box& _trigger, const std::vector<Light>& _lights, const std::vector<EnemyRobot>& _enemies);
 
-  static bool SaveAsBinaryV0(const std::string& _filePath, const Player& _player, const std::vector<Box>& _boxes);
+  static bool SaveAsBinaryV1(const std::string& _filePath, const Player& _player, const std::vector<Box>& _boxes,
+                              const std::vector<Box>& _obstacles, const std::vector<Coins>& _coins, const Box& _exit,
+                              const Box& _trigger, const std::vector<Light>& _lights, const std::vector<EnemyRobot>& _enemies);
+
+  //parses the text into the binary and cooks it next to the text
+  static bool ParseText(const std::string& _filePath, ParsedLevel& _level);
+  static void ParseTextV0(std::ifstream& _file, std::vector<unsigned char>& _level);
 
-  static bool LoadAsTextV0(std::ifstream& _file, b2World* _world, Player& _player, std::vector<Box>& _boxes,
-                            std::vector<Box>& _obstacles, std::vector<Coins>& _coins, Box& _exit,
-                            Box& _trigger, std::vector<Light>& _lights, std::vector<EnemyRobot>& _enemies);
+  //checks the header of the binary and loads it by its version
+  static bool LoadBinaryData(const GameEngine::FileSpan& _data, b2World* _world, Player& _player, std::vector<Box>& _boxes,
+                             std::vector<Box>& _obstacles, std::vector<Coins>& _coins, Box& _exit,
+                             Box& _trigger, std::vector<Light>& _lights, std::vector<EnemyRobot>& _enemies);
 
-  static bool LoadAsBinaryV0(std::fstream& _file, b2World* _world, Player& _player, std::vector<Box>& _boxes);
+  static bool LoadAsBinaryV1(const GameEngine::FileSpan& _data, b2World* _world, Player& _player, std::vector<Box>& _boxes,
+                              std::vector<Box>& _obstacles, std::vector<Coins>& _coins, Box& _exit,
+                              Box& _trigger, std::vector<Light>& _lights, std::vector<EnemyRobot>& _enemies);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "LightBuffer.h"
+
+#include <GameEngine/FrameStats.h>
+#include <GameEngine/RenderState.h>
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+
+void LightBuffer::Init(int _screenWidth, int _screenHeight, float _scale /* = DEFAULT_SCALE */)
+{
+  m_lightProgram.CompileShaders("Shaders/lightInstanced.vert", "Shaders/lightInstanced.frag");
+  m_compositeProgram.CompileShaders("Shaders/lightComposite.vert", "Shaders/lightComposite.frag");
+  m_quad.Init();
+
+  glGenVertexArrays(1, &m_vao);
+  glGenBuffers(1, &m_vbo);
+  GameEngine::RenderState::Get().BindVertexArray(m_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  //position and size as one vec3, then the color
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(LightInstance), (void*)offsetof(LightInstance, position));
+  glVertexAttribDivisor(0, 1);
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(LightInstance), (void*)offsetof(LightInstance, color));
+  glVertexAttribDivisor(1, 1);
+  GameEngine::RenderState::Get().BindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  m_scale = std::min(std::max(_scale, 0.01f), 1.0f);
+  Resize(_screenWidth, _screenHeight);
+}
+
+void LightBuffer::Dispose()
+{
+  m_framebuffer.Destroy();
+  m_quad.Dispose();
+  if (m_vao != 0)
+  {
+    GameEngine::RenderState::Get().DeleteVertexArrays(1, &m_vao);
+    m_vao = 0;
+  }
+  if (m_vbo != 0)
+  {
+    glDeleteBuffers(1, &m_vbo);
+    m_vbo = 0;
+  }
+  m_lightProgram.Dispose();
+  m_compositeProgram.Dispose();
+  m_instances.clear();
+  m_bufferWidth = 0;
+  m_bufferHeight = 0;
+}
+
+void LightBuffer::Resize(int _screenWidth, int _screenHeight)
+{
+  m_screenWidth = _screenWidth;
+  m_screenHeight = _screenHeight;
+  CreateBuffer();
+}
+
+void LightBuffer::SetScale(float _scale)
+{
+  m_scale = std::min(std::max(_scale, 0.01f), 1.0f);
+  CreateBuffer();
+}
+
+void LightBuffer::Add(const Light& _light)
+{
+  LightInstance instance;
+  instance.position = _light.position;
+  instance.size = _light.size;
+  instance.color = _light.color;
+  m_instances.push_back(instance);
+}
+
+void LightBuffer::Render(const glm::mat4& _projection)
+{
+  if (m_instances.empty())
+  {
+    return;
+  }
+  GameEngine::RenderState& state = GameEngine::RenderState::Get();
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  //orphan the buffer, the lights of the frame before may still be drawn from it
+  glBufferData(GL_ARRAY_BUFFER, m_instances.size() * sizeof(LightInstance), nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, m_instances.size() * sizeof(LightInstance), m_instances.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  GameEngine::FrameStats::Get().Add(GameEngine::STAT_BYTES_UPLOADED, m_instances.size() * sizeof(LightInstance));
+
+  //accumulate the lights, premultiplied by their falloff, into the cleared buffer
+  GLint previousFbo = 0;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+  m_framebuffer.Bind(GL_FRAMEBUFFER, m_bufferWidth, m_bufferHeight);
+  glViewport(0, 0, m_bufferWidth, m_bufferHeight);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glBlendFunc(GL_ONE, GL_ONE);
+
+  m_lightProgram.Use();
+  m_lightProgram.UploadValue("P", _projection);
+  state.BindVertexArray(m_vao);
+  GameEngine::FrameStats::Get().Add(GameEngine::STAT_DRAW_CALLS);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(m_instances.size()));
+  state.BindVertexArray(0);
+  m_lightProgram.UnUse();
+
+  //then add the buffer over the scene, filtered up to the screen
+  glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+  glViewport(0, 0, m_screenWidth, m_screenHeight);
+  m_compositeProgram.Use();
+  m_compositeProgram.UploadValue("lightBuffer", 0);
+  state.BindTexture(0, GL_TEXTURE_2D, m_framebuffer.GetColorTexture(0).id);
+  m_quad.Render(m_framebuffer.GetColorTexture(0).id);
+  state.BindTexture(0, GL_TEXTURE_2D, 0);
+  m_compositeProgram.UnUse();
+
+  //restore alpha blending
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void LightBuffer::CreateBuffer()
+{
+  if (m_screenWidth <= 0 || m_screenHeight <= 0)
+  {
+    return;
+  }
+  const int width = std::max(1, static_cast<int>(static_cast<float>(m_screenWidth) * m_scale));
+  const int height = std::max(1, static_cast<int>(static_cast<float>(m_screenHeight) * m_scale));
+  if (width == m_bufferWidth && height == m_bufferHeight)
+  {
+    return;
+  }
+  m_bufferWidth = width;
+  m_bufferHeight = height;
+
+  GLint previousFbo = 0;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+  m_framebuffer.Destroy();
+  m_framebuffer.Init();
+  m_framebuffer.Bind(GL_FRAMEBUFFER, m_bufferWidth, m_bufferHeight);
+  //half floats, the lights overlapping add up past 1 and are only clamped on the screen, as they were blended one by one
+  m_framebuffer.AttachColorTexture(m_bufferWidth, m_bufferHeight, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT);
+  GameEngine::RenderState::Get().BindTexture(0, GL_TEXTURE_2D, m_framebuffer.GetColorTexture(0).id);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  GameEngine::RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+  if (!m_framebuffer.CheckFramebufferStatus())
+  {
+    std::cout << "ERROR::LIGHT_BUFFER:: The light buffer is not complete!" << std::endl;
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+}
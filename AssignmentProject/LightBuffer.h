@@ -0,0 +1,58 @@
+#pragma once
+
+#include <GameEngine/Framebuffer.h>
+#include <GameEngine/GLSLProgram.h>
+#include <GameEngine/ScreenQuad.h>
+#include <GameEngine/Vertex.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "Light.h"
+
+//The lights of a frame accumulated in one pass: they're drawn instanced, in one draw call, into a light buffer a fraction of the
+//screen size (the falloff is smooth, it doesn't show the lower resolution) and the buffer is added over the scene with one screen
+//quad, instead of a full resolution sprite per light blended into the screen
+class LightBuffer
+{
+public:
+  //of the screen size, a quarter of the pixels
+  static constexpr float DEFAULT_SCALE{ 0.5f };
+
+  void Init(int _screenWidth, int _screenHeight, float _scale = DEFAULT_SCALE);
+  void Dispose();
+  //the buffer is made again at the new size, the scale is clamped to (0, 1]
+  void Resize(int _screenWidth, int _screenHeight);
+  void SetScale(float _scale);
+
+  void Begin() { m_instances.clear(); }
+  void Add(const Light& _light);
+  //draws the lights of the frame into the buffer and adds it over what's bound (the screen, of the size given to Init or Resize)
+  void Render(const glm::mat4& _projection);
+
+  float GetScale() const { return m_scale; }
+  size_t GetNumLights() const { return m_instances.size(); }
+
+private:
+  //one record a light, expanded to its quad in the vertex shader
+  struct LightInstance
+  {
+    glm::vec2 position;
+    float size;
+    GameEngine::ColorRGBA8 color;
+  };
+
+  void CreateBuffer();
+
+  GameEngine::Framebuffer m_framebuffer;
+  GameEngine::ScreenQuad m_quad;
+  GameEngine::GLSLProgram m_lightProgram;
+  GameEngine::GLSLProgram m_compositeProgram;
+  GLuint m_vao = 0;
+  GLuint m_vbo = 0;
+
+  std::vector<LightInstance> m_instances;
+  int m_screenWidth = 0;
+  int m_screenHeight = 0;
+  int m_bufferWidth = 0;
+  int m_bufferHeight = 0;
+  float m_scale = DEFAULT_SCALE;
+};
@@ -42,20 +42,20 @@ void MainMenuScreen::OnEntry()
   m_camera.Init(m_window->GetScreenWidth(), m_window->GetScreenHeight());
   m_camera.SetScale(32.0f);
 
-  //Init audio
+  //Init audio, the click is decoded in the background so the first one doesn't hitch
   m_audio.Init();
+  m_audio.LoadSoundEffectAsync("Sound/Blip_Select11.ogg", nullptr);
 
   //Init UI
   InitUI();
 
+  //the level New Game plays is read while the menu is shown
+  LevelPreloader::Get().Preload(levelPath);
+
   //Init spritebatch
   m_spriteBatch.Init();
-  //Init spritefont
-  m_spriteFont.init("Fonts/chintzy.ttf", 32);
-
-  // Shader init
-  // Compile our texture shader
-  m_textureProgram.CompileShaders("Shaders/textureShading.vert", "Shaders/textureShading.frag");
+  //Init the font, it has its own program
+  m_font.Init("Fonts/chintzy.ttf");
 
   //load the main menu music
   m_music = m_audio.LoadMusic("Sound/Post-Punk-1.ogg");
@@ -68,8 +68,7 @@ void MainMenuScreen::OnExit()
   m_gui.DestroyGUI();
   m_audio.Destroy();
   m_spriteBatch.Dispose();
-  m_spriteFont.dispose();
-  m_textureProgram.Dispose();
+  m_font.Dispose();
 }
 
 void MainMenuScreen::Update()
@@ -86,13 +85,8 @@ void MainMenuScreen::Draw()
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   glClearColor(0.0f, 0.0f, 0.2f, 1.0f);
 
-  //begin using the texture program
-  m_textureProgram.Use();
-
-  //camera matrix
-  glm::mat4 projectionMatrix = m_camera.GetCameraMatrix();
-  GLint pUniform = m_textureProgram.GetUniformLocation("P");
-  glUniformMatrix4fv(pUniform, 1, GL_FALSE, &projectionMatrix[0][0]);
+  //begin using the program of the font with the camera matrix
+  m_font.Use(m_camera.GetCameraMatrix());
 
   //start up the spritebatch
   m_spriteBatch.Begin();
@@ -101,18 +95,18 @@ void MainMenuScreen::Draw()
   std::string mainMenuText = "Main Menu";
   std::string instructionText = "Use W,A,D to move and SPACE to shoot!";
   //draw the music volume text, which is located above the volume spinner
-  m_spriteFont.draw(m_spriteBatch, volumeText.c_str(), glm::vec2(10.0f, -7.0f), glm::vec2(0.02f), 0.0f, GameEngine::ColorRGBA8(255, 255, 255, 255), GameEngine::Justification::MIDDLE);
-  m_spriteFont.draw(m_spriteBatch, mainMenuText.c_str(), glm::vec2(0.0f, 2.0f), glm::vec2(0.1f), 0.0f, GameEngine::ColorRGBA8(255, 255, 255, 255), GameEngine::Justification::MIDDLE);
-  m_spriteFont.draw(m_spriteBatch, instructionText.c_str(), glm::vec2(0.0f, -6.0f), glm::vec2(0.02f), 0.0f, GameEngine::ColorRGBA8(255, 255, 255, 255), GameEngine::Justification::MIDDLE);
+  m_font.Draw(m_spriteBatch, volumeText.c_str(), glm::vec2(10.0f, -7.0f), 0.75f, 0.0f, GameEngine::ColorRGBA8(255, 255, 255, 255), GameEngine::Justification::MIDDLE);
+  m_font.Draw(m_spriteBatch, mainMenuText.c_str(), glm::vec2(0.0f, 2.0f), 3.75f, 0.0f, GameEngine::ColorRGBA8(255, 255, 255, 255), GameEngine::Justification::MIDDLE);
+  m_font.Draw(m_spriteBatch, instructionText.c_str(), glm::vec2(0.0f, -6.0f), 0.75f, 0.0f, GameEngine::ColorRGBA8(255, 255, 255, 255), GameEngine::Justification::MIDDLE);
 
   //end the spritebatch usage
   m_spriteBatch.End();
   //render the batches ( just the text )
   m_spriteBatch.RenderBatch();
+  //unuse the font program
+  m_font.UnUse();
   //draw the gui
   m_gui.Draw();
-  //unuse the texture program
-  m_textureProgram.UnUse();
 }
 
 void MainMenuScreen::InitUI()
@@ -225,8 +219,8 @@ bool MainMenuScreen::OnLoadMouseClick(const CEGUI::EventArgs& e)
   //add all files to list box
   for (auto& e : entries)
   {
-    //Don't add directories
-    if (!e.isDirectory)
+    //Don't add directories, nor the cooked binaries of the levels
+    if (!e.isDirectory && LevelReaderWriter::IsLevelFile(e.path))
     {
       //Remove "Levels/" substring
       e.path.erase(0, std::string("Levels/").size());
@@ -254,6 +248,7 @@ bool MainMenuScreen::OnLoad(const CEGUI::EventArgs& e)
   std::string path = "Levels/" + std::string(m_loadWindowCombobox->getText().c_str());
 
   levelPath = path;
+  LevelPreloader::Get().Preload(levelPath);
 
   m_currentState = GameEngine::ScreenState::CHANGE_NEXT;
 
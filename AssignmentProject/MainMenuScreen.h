@@ -13,7 +13,7 @@
 #include <GameEngine/Window.h>
 #include <GameEngine/DebugRenderer.h>
 #include <GameEngine\AudioEngine.h>
-#include <GameEngine\SpriteFont.h>
+#include <GameEngine/SdfFont.h>
 
 #include <GameEngine/GUI.h>
 
@@ -76,8 +76,8 @@ private:
   GameEngine::AudioEngine m_audio;
   GameEngine::Music m_music;
   GameEngine::SpriteBatch m_spriteBatch;
-  GameEngine::SpriteFont m_spriteFont;
-  GameEngine::GLSLProgram m_textureProgram;
+  //one distance field font for the texts of every size
+  GameEngine::SdfFont m_font;
 };
 
 #endif
\ No newline at end of file
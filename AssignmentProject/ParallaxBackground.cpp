@@ -1,74 +1,73 @@
 #include "ParallaxBackground.h"
 #include <GameEngine\ResourceManager.h>
+#include <GameEngine/RenderState.h>
+#include <GameEngine/SamplerCache.h>
+#include <string>
 
-ParallaxBackground::ParallaxBackground(float _scrollSpeed, float _depth, const std::string& _texturePath,
-  const glm::vec2& _position, const glm::vec2& _dimensions, float _playerPosX, int _index) :
-
-  m_scrollSpeed(_scrollSpeed), m_depth(_depth), m_position(_position),
-  m_dimensions(_dimensions), m_previousPlayerPosX(_playerPosX), m_backgroundIndex(_index)
+void ParallaxBackground::Init()
 {
-  m_texture = GameEngine::ResourceManager::GetTexture(_texturePath);
-  m_startPosX = m_position.x;
-  m_endPosX = m_position.x + m_dimensions.x;
-  m_position.y = _position.y;
-}
-
+  m_program.CompileShaders("Shaders/parallax.vert", "Shaders/parallax.frag");
+  m_numLayersUniform = m_program.GetUniform("numLayers");
+  m_offsetsUniform = m_program.GetUniform("offsets");
+  m_program.Use();
+  for (int i = 0; i < MAX_LAYERS; i++)
+  {
+    m_program.UploadValue("layer" + std::to_string(i), i);
+  }
+  m_program.UnUse();
+  m_quad.Init();
 
-ParallaxBackground::~ParallaxBackground()
-{
+  //the layers wrap around horizontally whatever they were loaded with
+  GameEngine::SamplerDesc desc;
+  desc.wrap = GL_REPEAT;
+  m_sampler = GameEngine::SamplerCache::Get().GetSampler(desc);
 }
 
-void ParallaxBackground::Draw(GameEngine::SpriteBatch& _spritebatch)
+void ParallaxBackground::Dispose()
 {
-  glm::vec4 destRect(m_position.x, m_position.y, m_dimensions.x, m_dimensions.y);
-
-  glm::vec4 uvRect(0.0f, 0.0f, 1.0f, 1.0f);
-
-  GameEngine::ColorRGBA8 color(255, 255, 255, 255);
-
-  _spritebatch.Draw(destRect, uvRect, m_texture.id, m_depth, color);
+  m_program.Dispose();
+  m_quad.Dispose();
+  m_layers.clear();
 }
 
-void ParallaxBackground::Update(const glm::vec2& _newPlayerPos, const glm::vec2& _bottomLeft)
+bool ParallaxBackground::AddLayer(const std::string& _texturePath, float _scrollSpeed)
 {
-  static float firstSecond = 0;
-  if (firstSecond < 60.0f)
+  if (m_layers.size() >= MAX_LAYERS)
   {
-    m_position.x = _bottomLeft.x + m_dimensions.x * m_backgroundIndex;
-    m_position.y = _bottomLeft.y;
-    m_startPosX = m_position.x;
-    m_endPosX = m_position.x + m_dimensions.x;
-    firstSecond += 1.0f;
+    return false;
   }
-  if (m_scrollSpeed != 1.0f)
+  Layer layer;
+  layer.texture = GameEngine::ResourceManager::GetTexture(_texturePath);
+  layer.scrollSpeed = _scrollSpeed;
+  m_layers.push_back(layer);
+  return true;
+}
+
+void ParallaxBackground::Draw(float _cameraPosX, float _viewWidth)
+{
+  if (m_layers.empty() || _viewWidth <= 0.0f)
   {
-    if (_newPlayerPos.x > m_endPosX + m_dimensions.x)
-    {
-      m_position.x = m_endPosX + m_dimensions.x * 2.0f;
-      m_position.x -= 6.2f;
-      m_startPosX = m_position.x;
-      m_endPosX = m_position.x + m_dimensions.x;
-    }
-    else if (_newPlayerPos.x < m_startPosX - m_dimensions.x)
-    {
-      m_position.x = m_startPosX - m_dimensions.x * 3.0f;
-      m_position.x += 6.2f;
-      m_startPosX = m_position.x;
-      m_endPosX = m_position.x + m_dimensions.x;
-    }
+    return;
   }
-  m_position.y = _bottomLeft.y;
+  GameEngine::RenderState& state = GameEngine::RenderState::Get();
 
-  if (m_previousPlayerPosX < _newPlayerPos.x)
+  //a layer moves by its speed as the camera moves, so on the screen it scrolls back by the rest, in widths of the screen
+  float offsets[MAX_LAYERS] = { 0.0f };
+  for (size_t i = 0; i < m_layers.size(); i++)
   {
-    m_position.x += ((_newPlayerPos.x - m_previousPlayerPosX) * m_scrollSpeed);
+    offsets[i] = (1.0f - m_layers[i].scrollSpeed) * (_cameraPosX - m_startPosX) / _viewWidth;
+    state.BindTexture(static_cast<GLuint>(i), GL_TEXTURE_2D, m_layers[i].texture.id, m_sampler);
   }
-  else if (m_previousPlayerPosX > _newPlayerPos.x)
+
+  m_program.Use();
+  m_program.UploadValue(m_numLayersUniform, static_cast<int>(m_layers.size()));
+  m_program.UploadValues(m_offsetsUniform, offsets, MAX_LAYERS);
+  m_quad.Render(0);
+  m_program.UnUse();
+
+  for (size_t i = 0; i < m_layers.size(); i++)
   {
-    m_position.x -= ((m_previousPlayerPosX - _newPlayerPos.x) * m_scrollSpeed);
+    state.BindTexture(static_cast<GLuint>(i), GL_TEXTURE_2D, 0);
   }
-  m_previousPlayerPosX = _newPlayerPos.x;
-
-  //std::cout << "Sprite: " + m_texture.filePath + "\n" + "start pox x: " + std::to_string(m_startPosX) + " Index: " << m_backgroundIndex << std::endl;
-  //std::cout << "Player pos x: " << _newPlayerPos.x << std::endl;
-}
\ No newline at end of file
+  state.ActiveTexture(0);
+}
@@ -1,30 +1,48 @@
 #ifndef _PARALLAXBACKGROUND_
 #define _PARALLAXBACKGROUND_
 
-#include <GameEngine/SpriteBatch.h>
+#include <GameEngine/GLSLProgram.h>
+#include <GameEngine/ScreenQuad.h>
 #include <GameEngine\GLTexture.h>
+#include <string>
+#include <vector>
 
+//The parallax layers behind the level, drawn in one screen quad: the shader samples every layer with its horizontal uv offset and
+//blends them back to front, so the cost is the same wherever the camera is and however far the layers scrolled (the textures repeat,
+//no tiles are moved around to cover the view)
 class ParallaxBackground
 {
 public:
-  ParallaxBackground(float _scrollSpeed, float _depth, const std::string& _texturePath,
-    const glm::vec2& _position, const glm::vec2& _dimensions, float _playerPosX, int _index);
+  static constexpr int MAX_LAYERS{ 4 };
 
-  ~ParallaxBackground();
+  void Init();
+  void Dispose();
 
-  void Draw(GameEngine::SpriteBatch& _spritebatch);
-  void Update(const glm::vec2& _newPlayerPos, const glm::vec2& _bottomLeft);
+  //adds a layer in front of the ones added before. The scroll speed is how far it moves with the camera, 1 stays in place on the
+  //screen and the lower it is the faster the layer scrolls by. Returns false past MAX_LAYERS
+  bool AddLayer(const std::string& _texturePath, float _scrollSpeed);
+  void Clear() { m_layers.clear(); }
+  //the layers are at their start where the camera is now
+  void Reset(float _cameraPosX) { m_startPosX = _cameraPosX; }
+
+  //draws the layers over the whole screen, _viewWidth is the width of the screen in world coordinates
+  void Draw(float _cameraPosX, float _viewWidth);
 
 private:
+  struct Layer
+  {
+    GameEngine::GLTexture texture;
+    float scrollSpeed = 1.0f;
+  };
+
+  std::vector<Layer> m_layers; ///< back to front
   float m_startPosX = 0.0f;
-  float m_endPosX = 0.0f;
-  float m_scrollSpeed = 1.0f;
-  float m_depth = 0.0f;
-  float m_previousPlayerPosX = 0.0f;
-  int m_backgroundIndex = 0;
-  GameEngine::GLTexture m_texture;
-  glm::vec2 m_position;
-  glm::vec2 m_dimensions;
+
+  GameEngine::GLSLProgram m_program;
+  GameEngine::ScreenQuad m_quad;
+  GameEngine::UniformHandle m_numLayersUniform;
+  GameEngine::UniformHandle m_offsetsUniform;
+  GLuint m_sampler = 0;
 };
 
 #endif // !_PARALLAXBACKGROUND_
@@ -0,0 +1,62 @@
+#include "PhysicsSnapshot.h"
+
+BodyState BodyState::Of(const b2Body* _body)
+{
+  BodyState state;
+  state.position = glm::vec2(_body->GetPosition().x, _body->GetPosition().y);
+  state.velocity = glm::vec2(_body->GetLinearVelocity().x, _body->GetLinearVelocity().y);
+  state.angle = _body->GetAngle();
+  return state;
+}
+
+void PhysicsSnapshot::BeginCapture()
+{
+  m_lastCurrent.swap(m_current);
+  m_current.clear();
+  m_previous.clear();
+}
+
+void PhysicsSnapshot::Capture(const b2Body* _body, int& _index)
+{
+  const BodyState state = BodyState::Of(_body);
+  const bool wasCaptured = _index >= 0 && _index < static_cast<int>(m_lastCurrent.size());
+  m_previous.push_back(wasCaptured ? m_lastCurrent[_index] : state);
+  m_current.push_back(state);
+  _index = static_cast<int>(m_current.size()) - 1;
+}
+
+void PhysicsSnapshot::Reset()
+{
+  m_previous.clear();
+  m_current.clear();
+  m_lastCurrent.clear();
+}
+
+BodyState PhysicsSnapshot::Get(int _index, float _interpolation) const
+{
+  if (_index < 0 || _index >= static_cast<int>(m_current.size()))
+  {
+    return BodyState();
+  }
+  const BodyState& previous = m_previous[_index];
+  const BodyState& current = m_current[_index];
+  BodyState state;
+  state.position = glm::mix(previous.position, current.position, _interpolation);
+  state.velocity = current.velocity;
+  state.angle = glm::mix(previous.angle, current.angle, _interpolation);
+  return state;
+}
+
+void PhysicsSnapshot::Step(b2World* _world, float _timeStep, int _velocityIterations, int _positionIterations)
+{
+  WaitForStep();
+  GameEngine::JobSystem::Get().Run([_world, _timeStep, _velocityIterations, _positionIterations]()
+  {
+    _world->Step(_timeStep, _velocityIterations, _positionIterations);
+  }, &m_stepCounter);
+}
+
+void PhysicsSnapshot::WaitForStep()
+{
+  GameEngine::JobSystem::Get().Wait(m_stepCounter);
+}
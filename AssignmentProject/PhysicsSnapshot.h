@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Box2D/Box2D.h>
+#include <glm/glm.hpp>
+#include <GameEngine/JobSystem.h>
+#include <vector>
+
+//what the drawing needs of a body, copied from it before the world steps
+struct BodyState
+{
+  glm::vec2 position{ 0.0f, 0.0f };
+  glm::vec2 velocity{ 0.0f, 0.0f };
+  float angle = 0.0f;
+
+  static BodyState Of(const b2Body* _body);
+};
+
+//Steps the box2d world on a worker of the JobSystem while the frame draws: the bodies which are drawn are copied into a compact
+//buffer before the step, and the frames interpolate between the last two copies instead of reading the bodies. Nothing may touch
+//the world between Step and WaitForStep, the gameplay waits at the start of its tick
+class PhysicsSnapshot
+{
+public:
+  ~PhysicsSnapshot() { WaitForStep(); }
+
+  //starts a copy of the bodies, the last one becomes the one the objects are interpolated from
+  void BeginCapture();
+  //copies the body, _index is where the object was in the last copy (-1 for a new object, which starts where it is) and becomes
+  //where it is in this one
+  void Capture(const b2Body* _body, int& _index);
+  //forgets the copies, e.g. for a new level: every object starts where it is with the next one
+  void Reset();
+
+  //the object at _index of the last copy, between the copy before (0) and the last one (1)
+  BodyState Get(int _index, float _interpolation) const;
+
+  //steps the world on a worker, once the bodies are copied
+  void Step(b2World* _world, float _timeStep, int _velocityIterations, int _positionIterations);
+  //blocks until the step is done, before anything reads or changes the world
+  void WaitForStep();
+
+private:
+  std::vector<BodyState> m_previous;    ///< by index, where the object was in the copy before
+  std::vector<BodyState> m_current;     ///< by index
+  std::vector<BodyState> m_lastCurrent; ///< the last copy, the previous states are taken from it by the old indices
+  GameEngine::JobCounter m_stepCounter;
+};
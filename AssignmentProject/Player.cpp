@@ -8,26 +8,35 @@ void Player::Init(b2World* _world,
   const glm::vec2& _position,
   const glm::vec2& _drawDims,
   glm::vec2& _collisionDims,
-  GameEngine::ColorRGBA8 _color)
+  GameEngine::ColorRGBA8 _color,
+  bool _active /*= true*/)
 {
   //set the member variables and initialize the capsule and texture
   GameEngine::GLTexture texture = GameEngine::ResourceManager::GetTexture("Assets/Char2/IDLE.png");
   m_color = _color;
   m_drawDims = _drawDims;
   m_collisionDims = _collisionDims;
-  m_capsule.Init(_world, _position, _collisionDims, 1.0f, 0.1f, true);
+  m_capsule.Init(_world, _position, _collisionDims, 1.0f, 0.1f, true, _active);
   m_texture.Init(texture, glm::ivec2(10, 1));
   //hardcode some damage so it's not the default
   m_attackDamage = 0.50f;
+  //a burst of shots restarts its oldest ones instead of taking every voice, the other sounds win over them
+  GameEngine::SoundSettings shotSettings;
+  shotSettings.maxInstances = 4;
+  m_audio.SetSoundSettings("Sound/Laser_Shoot6.ogg", shotSettings);
 }
 
 void Player::Draw(GameEngine::SpriteBatch& _spriteBatch)
+{
+  Draw(_spriteBatch, BodyState::Of(m_capsule.GetBody()));
+}
+
+void Player::Draw(GameEngine::SpriteBatch& _spriteBatch, const BodyState& _state)
 {
   glm::vec4 destRect;
   //set the player destination rectangle
-  b2Body* body = m_capsule.GetBody();
-  destRect.x = body->GetPosition().x - m_drawDims.x / 2.0f;
-  destRect.y = body->GetPosition().y - m_capsule.GetDimensions().y / 2.0f;
+  destRect.x = _state.position.x - m_drawDims.x / 2.0f;
+  destRect.y = _state.position.y - m_capsule.GetDimensions().y / 2.0f;
   destRect.z = m_drawDims.x;
   destRect.w = m_drawDims.y;
 
@@ -35,9 +44,7 @@ void Player::Draw(GameEngine::SpriteBatch& _spriteBatch)
   int numTiles;
 
   float animSpeed = 0.2f;
-  glm::vec2 velocity;
-  velocity.x = body->GetLinearVelocity().x;
-  velocity.y = body->GetLinearVelocity().y;
+  const glm::vec2 velocity = _state.velocity;
 
   //Calculate animation
   if (m_healthPoints <= 0.0f)
@@ -126,16 +133,17 @@ void Player::Draw(GameEngine::SpriteBatch& _spriteBatch)
   }
 
   //Draw the sprite
-  _spriteBatch.Draw(destRect, uvRect, m_texture.texture.id, 1.0f, m_color, body->GetAngle());
+  _spriteBatch.Draw(destRect, uvRect, m_texture.texture.id, 1.0f, m_color, _state.angle);
 }
 
-void Player::Update(GameEngine::InputManager& _inputManager)
+void Player::Update(const GameEngine::InputActions& _actions)
 {
   //check if the player is alive
   if (m_healthPoints > 0.0f)
   {
     b2Body* body = m_capsule.GetBody();
-    if (_inputManager.IsKeyPressed(SDLK_SPACE) && m_maxShots > 0)
+    //a shot tapped between two ticks still counts
+    if (_actions.WasPressed(ACTION_SHOOT) && m_maxShots > 0)
     {
       //player shoot
       m_playerShot = true;
@@ -144,13 +152,13 @@ void Player::Update(GameEngine::InputManager& _inputManager)
       GameEngine::SoundEffect soundEffect = m_audio.LoadSoundEffect("Sound/Laser_Shoot6.ogg");
       soundEffect.Play();
     }
-    if (_inputManager.IsKeyDown(SDLK_a))
+    if (_actions.IsDown(ACTION_LEFT))
     {
       //walking left
       body->ApplyForceToCenter(b2Vec2(-100.0f, 0.0f), true);
       m_direction = -1;
     }
-    else if (_inputManager.IsKeyDown(SDLK_d))
+    else if (_actions.IsDown(ACTION_RIGHT))
     {
       //walking right
       body->ApplyForceToCenter(b2Vec2(100.0f, 0.0f), true);
@@ -197,7 +205,7 @@ void Player::Update(GameEngine::InputManager& _inputManager)
         {
           m_onGround = true;
           //player can jump
-          if (_inputManager.IsKeyPressed(SDLK_w))
+          if (_actions.WasPressed(ACTION_JUMP))
           {
             GameEngine::SoundEffect soundEffect = m_audio.LoadSoundEffect("Sound/Jump17.ogg");
             soundEffect.Play();
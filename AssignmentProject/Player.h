@@ -3,11 +3,14 @@
 
 #include "Entity.h"
 
-#include <GameEngine/InputManager.h>
+#include <GameEngine/InputActions.h>
 #include <GameEngine\AudioEngine.h>
 
 enum class PlayerMoveState { STANDING, RUNNING, JUMPING, DYING };
 
+//the actions the player is controlled with, the gameplay screen binds the keys
+enum PlayerAction : GameEngine::ActionID { ACTION_SHOOT, ACTION_LEFT, ACTION_RIGHT, ACTION_JUMP };
+
 class Player : public Entity
 {
 public:
@@ -16,11 +19,14 @@ public:
         const glm::vec2& _position,
         const glm::vec2& _drawDims,
         glm::vec2& _collisionDims,
-        GameEngine::ColorRGBA8 _color) override;
+        GameEngine::ColorRGBA8 _color,
+        bool _active = true) override;
   //Draw the player
   virtual void Draw(GameEngine::SpriteBatch& _spriteBatch) override;
-  //Update the player
-  void Update(GameEngine::InputManager& _inputManager);
+  //Draw the player where a copy of its body is, while the world steps
+  void Draw(GameEngine::SpriteBatch& _spriteBatch, const BodyState& _state);
+  //Update the player, a tick of the actions
+  void Update(const GameEngine::InputActions& _actions);
 
   // returns true if the player shot
   bool GetPlayerShot() { return m_playerShot; }
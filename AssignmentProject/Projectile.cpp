@@ -2,7 +2,7 @@
 #include <GameEngine/ResourceManager.h>
 
 
-Projectile::Projectile(b2World* _world, const glm::vec2& _pos, const glm::vec2& _drawDims, glm::vec2& _collisionDims,
+Projectile::Projectile(ProjectilePool& _pool, const glm::vec2& _pos, const glm::vec2& _drawDims, glm::vec2& _collisionDims,
   GameEngine::ColorRGBA8 _color, int _direction, float _speed)
 {
   //Initialize the projectile's body and texture and set the member vars
@@ -12,7 +12,7 @@ Projectile::Projectile(b2World* _world, const glm::vec2& _pos, const glm::vec2&
   m_collisionDims = _collisionDims;
   m_direction = _direction;
   m_travelSpeed = _speed;
-  m_bulletBody.Init(_world, _pos, _collisionDims, 0.01f, 0.1f);
+  m_bulletBody = _pool.Acquire(_pos);
   m_texture.Init(texture, glm::ivec2(5, 1));
 }
 Projectile::~Projectile()
@@ -21,12 +21,16 @@ Projectile::~Projectile()
 }
 
 void Projectile::Draw(GameEngine::SpriteBatch& _spriteBatch)
+{
+  Draw(_spriteBatch, BodyState::Of(m_bulletBody.GetBody()));
+}
+
+void Projectile::Draw(GameEngine::SpriteBatch& _spriteBatch, const BodyState& _state)
 {
   glm::vec4 destRect;
-  b2Body* body = m_bulletBody.GetBody();
   //Set up the destRect
-  destRect.x = body->GetPosition().x - m_drawDims.x / 2.0f;
-  destRect.y = body->GetPosition().y - m_bulletBody.GetDimensions().y / 2.0f;
+  destRect.x = _state.position.x - m_drawDims.x / 2.0f;
+  destRect.y = _state.position.y - m_bulletBody.GetDimensions().y / 2.0f;
   destRect.z = m_drawDims.x;
   destRect.w = m_drawDims.y;
 
@@ -34,9 +38,7 @@ void Projectile::Draw(GameEngine::SpriteBatch& _spriteBatch)
   int numTiles;
 
   float animSpeed = 0.2f;
-  glm::vec2 velocity;
-  velocity.x = body->GetLinearVelocity().x;
-  velocity.y = body->GetLinearVelocity().y;
+  const glm::vec2 velocity = _state.velocity;
 
   //Calculate animation
   if (m_hasCollided)
@@ -89,14 +91,14 @@ void Projectile::Draw(GameEngine::SpriteBatch& _spriteBatch)
     uvRect.z *= -1;
   }
   //Draw the sprite
-  _spriteBatch.Draw(destRect, uvRect, m_texture.texture.id, 0.0f, m_color, body->GetAngle());
+  _spriteBatch.Draw(destRect, uvRect, m_texture.texture.id, 0.0f, m_color, _state.angle);
 }
 
 
-void Projectile::Destroy(b2World* _world)
+void Projectile::Destroy(ProjectilePool& _pool)
 {
-  //Destroy the body
-  m_bulletBody.Destroy(_world);
+  //Give the body back
+  _pool.Release(m_bulletBody);
 }
 
 void Projectile::DrawDebug(GameEngine::DebugRenderer& _debugRenderer)
@@ -2,6 +2,8 @@
 #define _PROJECTILE_
 
 #include "BulletBody.h"
+#include "PhysicsSnapshot.h"
+#include "ProjectilePool.h"
 #include <GameEngine/SpriteBatch.h>
 #include <GameEngine/TileSheet.h>
 
@@ -10,14 +12,19 @@ enum class BulletState { TRAVELLING, COLLIDED };
 class Projectile
 {
 public:
-  //Constructor
-  Projectile(b2World* _world, const glm::vec2& _pos, const glm::vec2& _drawDims,
+  //Constructor, the body is taken from the pool (its dimensions are the collision ones)
+  Projectile(ProjectilePool& _pool, const glm::vec2& _pos, const glm::vec2& _drawDims,
     glm::vec2& _collisionDims, GameEngine::ColorRGBA8 _color, int _direction, float _speed);
   ~Projectile();
   //Draw it every frame
   void Draw(GameEngine::SpriteBatch& _spriteBatch);
-  //Destroy it
-  void Destroy(b2World* _world);
+  //Draw it where a copy of its body is, while the world steps
+  void Draw(GameEngine::SpriteBatch& _spriteBatch, const BodyState& _state);
+  //copy the body into the snapshot, before the world steps
+  void Capture(PhysicsSnapshot& _snapshot) { _snapshot.Capture(m_bulletBody.GetBody(), m_snapshotIndex); }
+  int GetSnapshotIndex() const { return m_snapshotIndex; }
+  //Destroy it, the body goes back to the pool
+  void Destroy(ProjectilePool& _pool);
   //Show collision outlines
   void DrawDebug(GameEngine::DebugRenderer& _debugRenderer);
   //Update it
@@ -51,6 +58,7 @@ private:
   //number of frames the projectile can live in
   int m_lifeTime = 180; // 3 seconds in 60 fps
   int m_direction;
+  int m_snapshotIndex = -1;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "ProjectilePool.h"
+
+void ProjectilePool::Init(b2World* _world, int _size, const glm::vec2& _dimensions, float _density, float _friction)
+{
+  Clear();
+  m_world = _world;
+  m_dimensions = _dimensions;
+  m_density = _density;
+  m_friction = _friction;
+  m_bodies.resize(_size);
+  for (auto& body : m_bodies)
+  {
+    //made out of the way, they're teleported when they're shot
+    body.Init(m_world, glm::vec2(0.0f, 0.0f), m_dimensions, m_density, m_friction);
+    body.Deactivate();
+  }
+  m_free = m_bodies;
+}
+
+void ProjectilePool::Destroy()
+{
+  for (auto& body : m_bodies)
+  {
+    body.Destroy(m_world);
+  }
+  Clear();
+}
+
+void ProjectilePool::Clear()
+{
+  m_bodies.clear();
+  m_free.clear();
+  m_world = nullptr;
+}
+
+BulletBody ProjectilePool::Acquire(const glm::vec2& _position)
+{
+  if (m_free.empty())
+  {
+    //every body is in flight, the pool grows by one
+    BulletBody body;
+    body.Init(m_world, _position, m_dimensions, m_density, m_friction);
+    m_bodies.push_back(body);
+    return body;
+  }
+  BulletBody body = m_free.back();
+  m_free.pop_back();
+  body.Activate(_position);
+  return body;
+}
+
+void ProjectilePool::Release(BulletBody& _body)
+{
+  if (_body.GetBody() == nullptr)
+  {
+    return;
+  }
+  _body.Deactivate();
+  m_free.push_back(_body);
+  //the projectile doesn't hold it anymore
+  _body = BulletBody();
+}
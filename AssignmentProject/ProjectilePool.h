@@ -0,0 +1,34 @@
+#pragma once
+
+#include "BulletBody.h"
+#include <vector>
+
+//The bullet bodies of a world, made once and reused by the projectiles: a shot takes a free body and teleports it instead of
+//creating a body and fixture, a hit puts it back deactivated instead of destroying it, so firing doesn't go through box2d's
+//allocator and broadphase every time. If every body is in flight another one is made, it's kept for the next shots
+class ProjectilePool
+{
+public:
+  //makes _size bodies in the world, all deactivated
+  void Init(b2World* _world, int _size, const glm::vec2& _dimensions, float _density, float _friction);
+  //destroys the bodies, the ones in flight too (the projectiles holding them mustn't be used after)
+  void Destroy();
+  //forgets the bodies without destroying them, for when their world is gone already
+  void Clear();
+
+  //a free body put at _position, activated
+  BulletBody Acquire(const glm::vec2& _position);
+  //gives the body of a projectile back, deactivated
+  void Release(BulletBody& _body);
+
+  int GetNumBodies() const { return static_cast<int>(m_bodies.size()); }
+  int GetNumFree() const { return static_cast<int>(m_free.size()); }
+
+private:
+  b2World* m_world = nullptr;
+  glm::vec2 m_dimensions;
+  float m_density = 0.0f;
+  float m_friction = 0.0f;
+  std::vector<BulletBody> m_bodies; ///< all of them, for Destroy
+  std::vector<BulletBody> m_free;
+};
@@ -0,0 +1,12 @@
+#version 330 core
+//The fragment shader adds the light buffer over the scene
+
+in vec2 fragmentUV;
+
+out vec4 color;
+
+uniform sampler2D lightBuffer;
+
+void main() {
+    color = vec4(texture(lightBuffer, fragmentUV).rgb, 0.0);
+}
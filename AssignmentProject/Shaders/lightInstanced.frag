@@ -0,0 +1,14 @@
+#version 330 core
+//The fragment shader adds a light to the light buffer
+
+in vec4 fragmentColor;
+in vec2 fragmentUV;
+
+out vec4 color;
+
+void main() {
+    float distance = length(fragmentUV);
+    //premultiplied, the buffer sums what additive blending (src alpha, one) added to the screen
+    float alpha = fragmentColor.a * (pow(0.01, distance) - 0.01);
+    color = vec4(fragmentColor.rgb * alpha, alpha);
+}
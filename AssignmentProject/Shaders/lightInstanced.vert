@@ -0,0 +1,23 @@
+#version 330 core
+//The vertex shader expands every light (one instance) to its quad
+
+//per-instance data: the center and the size, and the color
+layout (location = 0) in vec3 positionSize;
+layout (location = 1) in vec4 vertexColor;
+
+out vec4 fragmentColor;
+out vec2 fragmentUV;
+
+uniform mat4 P;
+
+void main() {
+    //corners of the triangle strip: (0,0) (1,0) (0,1) (1,1)
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    vec2 position = positionSize.xy + (corner - 0.5) * positionSize.z;
+
+    gl_Position = vec4((P * vec4(position, 0.0, 1.0)).xy, 0.0, 1.0);
+
+    fragmentColor = vertexColor;
+    //from -1 to 1 across the light, the distance to its center
+    fragmentUV = corner * 2.0 - 1.0;
+}
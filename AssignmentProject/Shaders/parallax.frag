@@ -0,0 +1,30 @@
+#version 330 core
+//The fragment shader blends the parallax layers back to front
+
+in vec2 fragmentUV;
+
+out vec4 color;
+
+uniform int numLayers;
+uniform float offsets[4];
+uniform sampler2D layer0;
+uniform sampler2D layer1;
+uniform sampler2D layer2;
+uniform sampler2D layer3;
+
+//the layer over what's behind it, premultiplied
+vec4 over(vec4 behind, sampler2D layer, float offset) {
+    //the texture is upside down, like the sprites
+    vec4 texel = texture(layer, vec2(fragmentUV.x + offset, 1.0 - fragmentUV.y));
+    return vec4(texel.rgb * texel.a, texel.a) + behind * (1.0 - texel.a);
+}
+
+void main() {
+    vec4 sum = vec4(0.0);
+    if (numLayers > 0) sum = over(sum, layer0, offsets[0]);
+    if (numLayers > 1) sum = over(sum, layer1, offsets[1]);
+    if (numLayers > 2) sum = over(sum, layer2, offsets[2]);
+    if (numLayers > 3) sum = over(sum, layer3, offsets[3]);
+    //back to straight alpha for the alpha blending
+    color = vec4(sum.rgb / max(sum.a, 0.0001), sum.a);
+}
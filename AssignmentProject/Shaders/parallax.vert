@@ -0,0 +1,12 @@
+#version 330 core
+//The vertex shader of the screen quad, already in normalized coordinates
+
+layout (location = 0) in vec2 vertexPosition;
+layout (location = 1) in vec2 vertexUV;
+
+out vec2 fragmentUV;
+
+void main() {
+    gl_Position = vec4(vertexPosition, 0.0, 1.0);
+    fragmentUV = vertexUV;
+}
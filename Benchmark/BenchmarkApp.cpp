@@ -0,0 +1,39 @@
+#include "BenchmarkApp.h"
+
+#include <GameEngine\ScreenList.h>
+
+BenchmarkApp::BenchmarkApp(const BenchmarkSettings& _settings, const InputReplay& _replay) :
+		m_settings(_settings), m_replay(_replay)
+{
+}
+
+BenchmarkApp::~BenchmarkApp()
+{
+}
+
+// called on initialization
+void BenchmarkApp::OnInit()
+{
+		m_gameName = "Benchmark";
+		m_screenWidth = m_settings.m_screenWidth;
+		m_screenHeight = m_settings.m_screenHeight;
+		//GL needs a window for its context, it just isn't shown
+		m_windowFlags = GameEngine::WindowCreationFlags::INVISIBLE;
+		m_maxFPS = 0.0f;
+		m_vsync = false;
+		m_tickPerFrame = true;
+		//the results shouldn't depend on what an earlier run left in the cache
+		m_shaderCachePath.clear();
+}
+// called when exiting
+void BenchmarkApp::OnExit()
+{
+		//empty
+}
+// used to add screens
+void BenchmarkApp::AddScreens()
+{
+		std::shared_ptr<BenchmarkScreen> screen = std::make_shared<BenchmarkScreen>(m_settings, m_replay);
+		m_screenList->SetScreen(screen->GetScreenIndex());
+		m_screenList->AddScreen(std::move(screen));
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <GameEngine\IMainGame.h>
+
+#include "BenchmarkScreen.h"
+
+/** \brief The game the benchmark runs in: a hidden window, no frame limit and exactly one tick per frame, so every run of the
+	*  scenes simulates the same ticks and the frame times are what the machine takes */
+class BenchmarkApp : public GameEngine::IMainGame
+{
+public:
+		BenchmarkApp(const BenchmarkSettings& _settings, const InputReplay& _replay);
+		~BenchmarkApp();
+		// called on initialization
+		virtual void OnInit() override;
+		// called when exiting
+		virtual void OnExit() override;
+		// used to add screens
+		virtual void AddScreens() override;
+
+private:
+		BenchmarkSettings m_settings;
+		InputReplay m_replay;
+};
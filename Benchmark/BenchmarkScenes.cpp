@@ -0,0 +1,464 @@
+#include "BenchmarkScenes.h"
+
+#include <SDL\SDL.h>
+#include <GameEngine\Camera2D.h>
+#include <GameEngine\Camera3D.h>
+#include <GameEngine\GeometryPool.h>
+#include <GameEngine\GLSLProgram.h>
+#include <GameEngine\LightClusters.h>
+#include <GameEngine\Lights.h>
+#include <GameEngine\Model.h>
+#include <GameEngine\ParticleBatch2D.h>
+#include <GameEngine\ParticleEngine2D.h>
+#include <GameEngine\Random.h>
+#include <GameEngine\RenderState.h>
+#include <GameEngine\ResourceManager.h>
+#include <GameEngine\SpriteBatch.h>
+#include <GameEngine\UniformBlocks.h>
+#include <AI_Game\PathRequestManager.h>
+
+#include <algorithm>
+
+namespace
+{
+		//the assets of the games, the benchmark runs from its own folder next to them
+		const char* const SPRITE_TEXTURE = "../AI_Game/Textures/zombie.png";
+		const char* const SPRITE_VERTEX_SHADER = "../AI_Game/Shaders/textureShading.vert";
+		const char* const SPRITE_FRAGMENT_SHADER = "../AI_Game/Shaders/textureShading.frag";
+		const char* const BOX_MODEL = "../Playground3D/Assets/Box/box.obj";
+		const char* const LIT_VERTEX_SHADER = "../Playground3D/Shaders/PointLighting.vert";
+		const char* const LIT_FRAGMENT_SHADER = "../Playground3D/Shaders/PointLighting.frag";
+		const char* const CLUSTERED_FRAGMENT_SHADER = "../Playground3D/Shaders/ClusteredLighting.frag";
+
+		const glm::vec4 FULL_UV{ 0.0f, 0.0f, 1.0f, 1.0f };
+
+		/** \brief The direction WASD moves the camera in */
+		glm::vec2 GetPanDirection(GameEngine::InputManager& _input)
+		{
+				glm::vec2 direction(0.0f);
+				if (_input.IsKeyDown(SDLK_w)) direction.y += 1.0f;
+				if (_input.IsKeyDown(SDLK_s)) direction.y -= 1.0f;
+				if (_input.IsKeyDown(SDLK_a)) direction.x -= 1.0f;
+				if (_input.IsKeyDown(SDLK_d)) direction.x += 1.0f;
+				return direction;
+		}
+
+		/** \brief A scene drawn with the sprite shader and a SpriteBatch of the AI game, over a 2D world of _worldSize */
+		class SpriteScene2D : public BenchmarkScene
+		{
+		public:
+				virtual void Dispose() override
+				{
+						m_spriteBatch.Dispose();
+						m_shader.Dispose();
+				}
+
+		protected:
+				void Init2D(const SceneContext& _context, const glm::vec2& _worldSize)
+				{
+						m_random.Seed(_context.m_seed);
+						m_spriteBatch.Init();
+						m_shader.CompileShaders(SPRITE_VERTEX_SHADER, SPRITE_FRAGMENT_SHADER);
+						m_texture = GameEngine::ResourceManager::GetTexture(SPRITE_TEXTURE);
+						//the whole world fits the screen
+						m_camera.Init(_context.m_screenWidth, _context.m_screenHeight);
+						m_camera.SetPosition(_worldSize / 2.0f);
+						m_camera.SetScale(std::min(_context.m_screenWidth / _worldSize.x, _context.m_screenHeight / _worldSize.y));
+						m_camera.Update();
+				}
+				void UpdateCamera(GameEngine::InputManager& _input)
+				{
+						m_camera.OffsetPosition(GetPanDirection(_input) * (8.0f / m_camera.GetScale()));
+						m_camera.Update();
+				}
+				void BeginDraw()
+				{
+						glClearDepth(1.0);
+						glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+						m_shader.Use();
+						GameEngine::RenderState::Get().ActiveTexture(0);
+						glUniform1i(m_shader.GetUniformLocation("diffuseTexture"), 0);
+						m_shader.UploadValue("projection", m_camera.GetCameraMatrix());
+				}
+				void EndDraw()
+				{
+						m_shader.UnUse();
+				}
+
+				GameEngine::Camera2D m_camera;
+				GameEngine::GLSLProgram m_shader;
+				GameEngine::SpriteBatch m_spriteBatch;
+				GameEngine::GLTexture m_texture;
+				GameEngine::Random m_random;
+		};
+
+		/** \brief 100k sprites scattered over the world, all of them drawn every frame (the batch doesn't cull) */
+		class SpritesScene : public SpriteScene2D
+		{
+		public:
+				virtual const char* GetName() const override { return "sprites"; }
+
+				virtual bool Init(const SceneContext& _context) override
+				{
+						Init2D(_context, WORLD_SIZE);
+						m_sprites.resize(NUM_SPRITES);
+						for (glm::vec4& sprite : m_sprites)
+						{
+								sprite = glm::vec4(m_random.GenRandFloat(0.0f, WORLD_SIZE.x), m_random.GenRandFloat(0.0f, WORLD_SIZE.y), SPRITE_SIZE, SPRITE_SIZE);
+						}
+						m_spriteBatch.Reserve(NUM_SPRITES);
+						return true;
+				}
+				virtual void Update(GameEngine::InputManager& _input) override
+				{
+						UpdateCamera(_input);
+				}
+				virtual void Draw() override
+				{
+						BeginDraw();
+						m_spriteBatch.Begin(GameEngine::GlyphSortType::TEXTURE);
+						for (const glm::vec4& sprite : m_sprites)
+						{
+								m_spriteBatch.Draw(sprite, FULL_UV, m_texture.id, 0.0f, GameEngine::ColorRGBA8(255, 255));
+						}
+						m_spriteBatch.End();
+						m_spriteBatch.RenderBatch();
+						EndDraw();
+				}
+
+		private:
+				const size_t NUM_SPRITES{ 100000 };
+				const float SPRITE_SIZE{ 16.0f };
+				const glm::vec2 WORLD_SIZE{ 4096.0f, 4096.0f };
+
+				std::vector<glm::vec4> m_sprites;
+		};
+
+		/** \brief 1k zombies walking between random nodes of a random 128x128 grid, their paths solved by the PathRequestManager
+			*  like the game's (on its workers, so when a path arrives depends on the machine) */
+		class ZombiesScene : public SpriteScene2D
+		{
+		public:
+				virtual const char* GetName() const override { return "zombies"; }
+
+				virtual bool Init(const SceneContext& _context) override
+				{
+						Init2D(_context, glm::vec2(GRID_SIZE * NODE_DIAMETER));
+
+						std::vector<bool> walkable(GRID_SIZE * GRID_SIZE);
+						for (size_t i = 0; i < walkable.size(); i++)
+						{
+								walkable[i] = m_random.GenRandInt(0, 99) >= WALL_PERCENT;
+						}
+						m_grid = std::make_shared<Grid>(GRID_SIZE, GRID_SIZE, NODE_DIAMETER, walkable);
+						m_pathRequests = std::make_unique<PathRequestManager>(m_grid);
+
+						//the callbacks keep pointers into it, it isn't resized from here on
+						m_zombies.resize(NUM_ZOMBIES);
+						for (Zombie& zombie : m_zombies)
+						{
+								zombie.m_position = GetRandomWalkablePosition();
+						}
+						return true;
+				}
+				virtual void Update(GameEngine::InputManager& _input) override
+				{
+						UpdateCamera(_input);
+						m_pathRequests->Update();
+						for (size_t i = 0; i < m_zombies.size(); i++)
+						{
+								Zombie& zombie = m_zombies[i];
+								if (zombie.m_waiting)
+								{
+										continue;
+								}
+								if (zombie.m_nextWaypoint >= zombie.m_path.size())
+								{
+										zombie.m_waiting = true;
+										m_pathRequests->RequestPath(zombie.m_position, GetRandomWalkablePosition(), Algorithm::ASTAR, Diagonal::IFNOWALLS,
+												[this, i](std::vector<glm::vec2>& _path, bool _found)
+												{
+														Zombie& zombie = m_zombies[i];
+														zombie.m_waiting = false;
+														zombie.m_path.swap(_path);
+														zombie.m_nextWaypoint = _found ? 0 : zombie.m_path.size();
+												}, &zombie);
+										continue;
+								}
+								const glm::vec2 toWaypoint = zombie.m_path[zombie.m_nextWaypoint] - zombie.m_position;
+								const float distance = glm::length(toWaypoint);
+								if (distance <= ZOMBIE_SPEED)
+								{
+										zombie.m_position = zombie.m_path[zombie.m_nextWaypoint++];
+								}
+								else
+								{
+										zombie.m_position += toWaypoint * (ZOMBIE_SPEED / distance);
+								}
+						}
+				}
+				virtual void Draw() override
+				{
+						BeginDraw();
+						m_spriteBatch.Begin(GameEngine::GlyphSortType::TEXTURE);
+						for (const Zombie& zombie : m_zombies)
+						{
+								const glm::vec4 destRect(zombie.m_position - glm::vec2(NODE_DIAMETER / 2.0f), glm::vec2(NODE_DIAMETER));
+								m_spriteBatch.Draw(destRect, FULL_UV, m_texture.id, 0.0f, GameEngine::ColorRGBA8(255, 255));
+						}
+						m_spriteBatch.End();
+						m_spriteBatch.RenderBatch();
+						EndDraw();
+				}
+				virtual void Dispose() override
+				{
+						//joins the workers, so no callback comes after the zombies are gone
+						m_pathRequests.reset();
+						m_zombies.clear();
+						m_grid.reset();
+						SpriteScene2D::Dispose();
+				}
+
+		private:
+				struct Zombie
+				{
+						glm::vec2 m_position{ 0.0f };
+						std::vector<glm::vec2> m_path;
+						size_t m_nextWaypoint{ 0 };
+						bool m_waiting{ false }; ///< for its path
+				};
+
+				glm::vec2 GetRandomWalkablePosition()
+				{
+						glm::ivec2 node;
+						do
+						{
+								node = glm::ivec2(m_random.GenRandInt(0, GRID_SIZE - 1), m_random.GenRandInt(0, GRID_SIZE - 1));
+						} while (!m_grid->IsWalkableAt(node));
+						return m_grid->GetWorldPos(m_grid->GetIndex(node));
+				}
+
+				const size_t NUM_ZOMBIES{ 1000 };
+				const int GRID_SIZE{ 128 };
+				const float NODE_DIAMETER{ 16.0f };
+				const int WALL_PERCENT{ 20 };
+				const float ZOMBIE_SPEED{ 2.0f }; ///< per tick
+
+				std::shared_ptr<Grid> m_grid;
+				std::unique_ptr<PathRequestManager> m_pathRequests;
+				std::vector<Zombie> m_zombies;
+		};
+
+		/** \brief A fountain keeping about 10k particles alive, updated and drawn by the ParticleEngine2D */
+		class ParticlesScene : public SpriteScene2D
+		{
+		public:
+				virtual const char* GetName() const override { return "particles"; }
+
+				virtual bool Init(const SceneContext& _context) override
+				{
+						Init2D(_context, WORLD_SIZE);
+						//a particle lives 1 / DECAY_RATE ticks, as many are emitted every tick as die
+						GameEngine::ParticleBatch2D* batch = new GameEngine::ParticleBatch2D();
+						batch->Init(NUM_PARTICLES, DECAY_RATE, m_texture);
+						m_particleBatch = batch;
+						m_particleEngine = std::make_unique<GameEngine::ParticleEngine2D>();
+						m_particleEngine->AddParticleBatch(batch);
+
+						m_emitter.m_position = WORLD_SIZE / 2.0f;
+						m_emitter.m_speedRange = glm::vec2(1.0f, 6.0f);
+						m_emitter.m_startColor = GameEngine::ColorRGBA8(255, 200, 0, 255);
+						m_emitter.m_endColor = GameEngine::ColorRGBA8(255, 0, 0, 255);
+						m_emitter.m_widthRange = glm::vec2(4.0f, 12.0f);
+						return true;
+				}
+				virtual void Update(GameEngine::InputManager& _input) override
+				{
+						UpdateCamera(_input);
+						m_particleBatch->Emit(static_cast<int>(NUM_PARTICLES * DECAY_RATE), m_emitter, m_random);
+						m_particleEngine->Update(1.0f);
+				}
+				virtual void Draw() override
+				{
+						BeginDraw();
+						m_particleEngine->Draw(&m_spriteBatch);
+						EndDraw();
+				}
+				virtual void Dispose() override
+				{
+						//deletes the batch
+						m_particleEngine.reset();
+						m_particleBatch = nullptr;
+						SpriteScene2D::Dispose();
+				}
+
+		private:
+				const int NUM_PARTICLES{ 10000 };
+				const float DECAY_RATE{ 0.01f };
+				const glm::vec2 WORLD_SIZE{ 1280.0f, 720.0f };
+
+				std::unique_ptr<GameEngine::ParticleEngine2D> m_particleEngine;
+				GameEngine::ParticleBatch2D* m_particleBatch{ nullptr }; ///< owned by the engine
+				GameEngine::EmitterDesc m_emitter;
+		};
+
+		/** \brief Boxes of the Playground3D lit by point lights: one GeometryPool multi draw for all of them where it's supported,
+			*  a draw each otherwise. More lights than the LightBlock holds need the clustered shading, without it the scene is skipped */
+		class ModelsScene : public BenchmarkScene
+		{
+		public:
+				ModelsScene(const char* _name, size_t _numModels, size_t _numLights) :
+						m_name(_name), m_numModels(_numModels), m_numLights(_numLights) {}
+
+				virtual const char* GetName() const override { return m_name; }
+
+				virtual bool Init(const SceneContext& _context) override
+				{
+						m_clustered = m_numLights > 1;
+						if (m_clustered && !GameEngine::LightClusters::IsSupported())
+						{
+								return false;
+						}
+						GameEngine::Random random;
+						random.Seed(_context.m_seed);
+
+						m_camera.Init(45.0f, _context.m_screenWidth, _context.m_screenHeight);
+						m_camera.SetPosition(glm::vec3(0.0f, 0.0f, FIELD_SIZE));
+						m_shader.CompileShaders(LIT_VERTEX_SHADER, m_clustered ? CLUSTERED_FRAGMENT_SHADER : LIT_FRAGMENT_SHADER);
+						m_frameUniforms.Init();
+						m_lightBlock.Init();
+						if (m_clustered)
+						{
+								m_lightClusters.Init();
+						}
+
+						GameEngine::ResourceManager::GetStaticModel(BOX_MODEL, &m_box);
+						m_placements.resize(m_numModels);
+						for (Placement& placement : m_placements)
+						{
+								placement.m_position = glm::vec3(random.GenRandFloat(-FIELD_SIZE, FIELD_SIZE), random.GenRandFloat(-FIELD_SIZE, FIELD_SIZE),
+										random.GenRandFloat(-FIELD_SIZE, FIELD_SIZE));
+								placement.m_rotation = glm::vec3(random.GenRandFloat(0.0f, 360.0f));
+						}
+						m_usePool = GameEngine::GeometryPool::IsSupported();
+						if (m_usePool)
+						{
+								//they don't move, the draws are recorded once
+								const std::vector<size_t> boxMeshes = m_pool.AddModel(m_box);
+								m_pool.Begin();
+								for (const Placement& placement : m_placements)
+								{
+										m_box.SetPosition(placement.m_position);
+										m_box.SetRotation(placement.m_rotation);
+										m_pool.Add(boxMeshes, m_box.GetModelMatrix());
+								}
+								m_pool.End();
+						}
+
+						m_lights.resize(std::max<size_t>(m_numLights, 1));
+						for (GameEngine::PointLight& light : m_lights)
+						{
+								light.Init(glm::vec3(random.GenRandFloat(-FIELD_SIZE, FIELD_SIZE), random.GenRandFloat(-FIELD_SIZE, FIELD_SIZE),
+										random.GenRandFloat(-FIELD_SIZE, FIELD_SIZE)), 0.05f, 0.8f, 1.0f, 1.0f, 0.09f, 0.032f);
+						}
+						return true;
+				}
+				virtual void Update(GameEngine::InputManager& _input) override
+				{
+						const glm::vec2 direction = GetPanDirection(_input);
+						if (direction.y > 0.0f) m_camera.Move(GameEngine::MoveState::FORWARD, 1.0f);
+						if (direction.y < 0.0f) m_camera.Move(GameEngine::MoveState::BACKWARD, 1.0f);
+						if (direction.x < 0.0f) m_camera.Move(GameEngine::MoveState::LEFT, 1.0f);
+						if (direction.x > 0.0f) m_camera.Move(GameEngine::MoveState::RIGHT, 1.0f);
+						m_camera.Update();
+						m_seconds += 1.0f / 60.0f;
+				}
+				virtual void Draw() override
+				{
+						glClearDepth(1.0);
+						glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+						glEnable(GL_DEPTH_TEST);
+
+						m_frameUniforms.Update(m_camera, m_seconds);
+						m_lightBlock.Clear();
+						m_lightBlock.Add(m_lights.front());
+						m_lightBlock.Upload();
+						if (m_clustered)
+						{
+								m_lightClusters.Clear();
+								for (const GameEngine::PointLight& light : m_lights)
+								{
+										m_lightClusters.Add(light);
+								}
+								m_lightClusters.Build(m_camera);
+						}
+
+						m_shader.Use();
+						if (m_usePool)
+						{
+								m_pool.Draw(m_shader);
+						}
+						else
+						{
+								for (const Placement& placement : m_placements)
+								{
+										m_box.SetPosition(placement.m_position);
+										m_box.SetRotation(placement.m_rotation);
+										m_box.Draw(m_shader);
+								}
+						}
+						m_shader.UnUse();
+						glDisable(GL_DEPTH_TEST);
+				}
+				virtual void Dispose() override
+				{
+						m_pool.Dispose();
+						m_box.Dispose();
+						m_lightClusters.Dispose();
+						m_lightBlock.Dispose();
+						m_frameUniforms.Dispose();
+						m_shader.Dispose();
+				}
+
+		private:
+				struct Placement
+				{
+						glm::vec3 m_position{ 0.0f };
+						glm::vec3 m_rotation{ 0.0f };
+				};
+
+				const float FIELD_SIZE{ 40.0f }; ///< the boxes and lights are within [-FIELD_SIZE, FIELD_SIZE] on every axis
+
+				const char* m_name;
+				size_t m_numModels;
+				size_t m_numLights;
+				bool m_clustered{ false };
+				bool m_usePool{ false };
+				float m_seconds{ 0.0f };
+
+				GameEngine::Camera3D m_camera;
+				GameEngine::GLSLProgram m_shader;
+				GameEngine::FrameUniforms m_frameUniforms;
+				GameEngine::LightBlock m_lightBlock;
+				GameEngine::LightClusters m_lightClusters;
+				GameEngine::StaticModel m_box;
+				GameEngine::GeometryPool m_pool;
+				std::vector<Placement> m_placements;
+				std::vector<GameEngine::PointLight> m_lights;
+		};
+}
+
+std::vector<std::string> GetSceneNames()
+{
+		return { "sprites", "zombies", "particles", "models", "lights" };
+}
+
+std::unique_ptr<BenchmarkScene> CreateScene(const std::string& _name)
+{
+		if (_name == "sprites") return std::make_unique<SpritesScene>();
+		if (_name == "zombies") return std::make_unique<ZombiesScene>();
+		if (_name == "particles") return std::make_unique<ParticlesScene>();
+		if (_name == "models") return std::make_unique<ModelsScene>("models", 500, 1);
+		if (_name == "lights") return std::make_unique<ModelsScene>("lights", 100, 50);
+		return nullptr;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <GameEngine\InputManager.h>
+
+/** \brief What a scene is set up with, the same for every scene of a run */
+struct SceneContext
+{
+		int m_screenWidth{ 1280 };
+		int m_screenHeight{ 720 };
+		unsigned int m_seed{ 1 }; ///< every random placement of the scene comes from it, so two runs draw the same frames
+};
+
+/** \brief A stress scene of the benchmark: it loads its assets in Init, then is updated and drawn for the frames of the run.
+	*  The scenes pan their camera with WASD, which the input replay holds down */
+class BenchmarkScene
+{
+public:
+		virtual ~BenchmarkScene() {}
+
+		/** \brief The name on the command line and in the results */
+		virtual const char* GetName() const = 0;
+
+		/** \brief Loads the assets and places everything, returns false if the scene can't run here (e.g. a missing GL feature),
+			*  it's then skipped without Dispose */
+		virtual bool Init(const SceneContext& _context) = 0;
+		/** \brief One tick of the scene, with the keys of the replay */
+		virtual void Update(GameEngine::InputManager& _input) = 0;
+		virtual void Draw() = 0;
+		virtual void Dispose() = 0;
+};
+
+/** \brief The names of all the scenes, in the order they run */
+std::vector<std::string> GetSceneNames();
+
+/** \brief Creates the scene _name, nullptr if there is no such scene */
+std::unique_ptr<BenchmarkScene> CreateScene(const std::string& _name);
@@ -0,0 +1,204 @@
+#include "BenchmarkScreen.h"
+
+#include <GameEngine\FrameStats.h>
+#include <GameEngine\IMainGame.h>
+#include <GL\glew.h>
+#include <SDL\SDL.h>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+namespace
+{
+		/** \brief The value below which _percent of the sorted values are */
+		double GetPercentile(const std::vector<double>& _sorted, int _percent)
+		{
+				return _sorted[std::min(_sorted.size() - 1, _sorted.size() * _percent / 100)];
+		}
+}
+
+BenchmarkScreen::BenchmarkScreen(const BenchmarkSettings& _settings, const InputReplay& _replay) :
+		m_settings(_settings), m_replay(_replay)
+{
+		m_screenIndex = 0;
+}
+
+BenchmarkScreen::~BenchmarkScreen()
+{
+}
+
+int BenchmarkScreen::GetNextScreenIndex() const
+{
+		return SCREEN_INDEX_NO_SCREEN;
+}
+
+int BenchmarkScreen::GetPreviousScreenIndex() const
+{
+		return SCREEN_INDEX_NO_SCREEN;
+}
+
+void BenchmarkScreen::Build()
+{
+}
+
+void BenchmarkScreen::Destroy()
+{
+}
+
+void BenchmarkScreen::OnEntry()
+{
+		m_nextScene = 0;
+		m_results.clear();
+}
+
+void BenchmarkScreen::OnExit()
+{
+		if (m_scene)
+		{
+				m_scene->Dispose();
+				m_scene.reset();
+		}
+}
+
+void BenchmarkScreen::Update()
+{
+		//only closing the window gets through, the keys are the replay's
+		SDL_Event evnt;
+		while (SDL_PollEvent(&evnt))
+		{
+				if (evnt.type == SDL_QUIT || evnt.type == SDL_WINDOWEVENT)
+				{
+						m_game->OnSDLEvent(evnt);
+				}
+		}
+
+		const Clock::time_point now = Clock::now();
+		if (!m_scene)
+		{
+				if (!StartNextScene())
+				{
+						WriteResults();
+						m_currentState = GameEngine::ScreenState::EXIT_APPLICATION;
+						return;
+				}
+				//the loading isn't in the first frame
+				m_frameStart = Clock::now();
+		}
+		else
+		{
+				if (m_frame > m_settings.m_numWarmupFrames)
+				{
+						//the frame before was drawn and its counters ended since the last Update
+						SceneResult& result = m_results.back();
+						result.m_frameTimes.push_back(std::chrono::duration<double, std::milli>(now - m_frameStart).count());
+						const GameEngine::FrameStats& stats = GameEngine::FrameStats::Get();
+						result.m_statTotals.resize(stats.GetNumStats(), 0);
+						result.m_statMaxima.resize(stats.GetNumStats(), 0);
+						for (unsigned int i = 0; i < stats.GetNumStats(); i++)
+						{
+								result.m_statTotals[i] += stats.GetLastFrame(i);
+								result.m_statMaxima[i] = std::max(result.m_statMaxima[i], stats.GetLastFrame(i));
+						}
+				}
+				m_frameStart = now;
+		}
+
+		if (m_frame == m_settings.m_numWarmupFrames + m_settings.m_numFrames)
+		{
+				EndScene();
+				return;
+		}
+		m_replay.Apply(m_frame, m_game->inputManager);
+		m_scene->Update(m_game->inputManager);
+		m_frame++;
+}
+
+void BenchmarkScreen::Draw()
+{
+		if (m_scene)
+		{
+				m_scene->Draw();
+		}
+		else
+		{
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		}
+}
+
+bool BenchmarkScreen::StartNextScene()
+{
+		SceneContext context;
+		context.m_screenWidth = m_settings.m_screenWidth;
+		context.m_screenHeight = m_settings.m_screenHeight;
+		context.m_seed = m_settings.m_seed;
+		while (m_nextScene < m_settings.m_scenes.size())
+		{
+				const std::string& name = m_settings.m_scenes[m_nextScene++];
+				m_results.push_back(SceneResult());
+				m_results.back().m_name = name;
+
+				std::unique_ptr<BenchmarkScene> scene = CreateScene(name);
+				std::cout << "Running " << name << std::endl;
+				if (scene && scene->Init(context))
+				{
+						m_scene = std::move(scene);
+						m_frame = 0;
+						return true;
+				}
+				std::cout << "Skipping " << name << ", it can't run here" << std::endl;
+				m_results.back().m_skipped = true;
+		}
+		return false;
+}
+
+void BenchmarkScreen::EndScene()
+{
+		m_replay.ReleaseAll(m_game->inputManager);
+		m_scene->Dispose();
+		m_scene.reset();
+}
+
+void BenchmarkScreen::WriteResults() const
+{
+		FILE* file = std::fopen(m_settings.m_outputPath.c_str(), "w");
+		if (!file)
+		{
+				std::cout << "ERROR::BENCHMARK::OUTPUT_FAILED_TO_OPEN\n" << m_settings.m_outputPath << std::endl;
+				return;
+		}
+
+		const GameEngine::FrameStats& stats = GameEngine::FrameStats::Get();
+		std::fprintf(file, "{\n  \"seed\": %u,\n  \"frames\": %d,\n  \"warmup\": %d,\n  \"width\": %d,\n  \"height\": %d,\n  \"scenes\": [",
+				m_settings.m_seed, m_settings.m_numFrames, m_settings.m_numWarmupFrames, m_settings.m_screenWidth, m_settings.m_screenHeight);
+		for (size_t i = 0; i < m_results.size(); i++)
+		{
+				const SceneResult& result = m_results[i];
+				std::fprintf(file, "%s\n    {\n      \"name\": \"%s\",\n      \"skipped\": %s", i > 0 ? "," : "", result.m_name.c_str(),
+						result.m_skipped ? "true" : "false");
+				if (!result.m_frameTimes.empty())
+				{
+						std::vector<double> sorted = result.m_frameTimes;
+						std::sort(sorted.begin(), sorted.end());
+						double total = 0.0;
+						for (double frameTime : sorted)
+						{
+								total += frameTime;
+						}
+						std::fprintf(file, ",\n      \"frame_ms\": { \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f }",
+								total / sorted.size(), GetPercentile(sorted, 50), GetPercentile(sorted, 90), GetPercentile(sorted, 99), sorted.back());
+
+						std::fprintf(file, ",\n      \"stats\": {");
+						for (size_t stat = 0; stat < result.m_statTotals.size(); stat++)
+						{
+								std::fprintf(file, "%s\n        \"%s\": { \"mean\": %.2f, \"max\": %llu }", stat > 0 ? "," : "",
+										stats.GetName(static_cast<unsigned int>(stat)).c_str(), double(result.m_statTotals[stat]) / sorted.size(),
+										static_cast<unsigned long long>(result.m_statMaxima[stat]));
+						}
+						std::fprintf(file, "\n      }");
+				}
+				std::fprintf(file, "\n    }");
+		}
+		std::fprintf(file, "\n  ]\n}\n");
+		std::fclose(file);
+		std::cout << "Results written to " << m_settings.m_outputPath << std::endl;
+}
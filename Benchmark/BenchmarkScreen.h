@@ -0,0 +1,75 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <GameEngine\IGameScreen.h>
+#include "BenchmarkScenes.h"
+#include "InputReplay.h"
+
+/** \brief What the command line asks the benchmark to run */
+struct BenchmarkSettings
+{
+		std::vector<std::string> m_scenes; ///< in the order they run
+		int m_numFrames{ 600 };            ///< the frames measured per scene
+		int m_numWarmupFrames{ 60 };       ///< the frames run before them (shader compiles, first uploads, the buffers growing)
+		unsigned int m_seed{ 1 };
+		std::string m_replayPath;          ///< the input script, empty for the default one
+		std::string m_outputPath{ "benchmark.json" };
+		int m_screenWidth{ 1280 };
+		int m_screenHeight{ 720 };
+};
+
+/** \brief What one scene measured */
+struct SceneResult
+{
+		std::string m_name;
+		bool m_skipped{ false };           ///< it couldn't run here, nothing was measured
+		std::vector<double> m_frameTimes;  ///< milliseconds, from one Update to the next, so the drawing and the buffer swap are in it
+		std::vector<std::uint64_t> m_statTotals; ///< the FrameStats counters summed over the measured frames
+		std::vector<std::uint64_t> m_statMaxima;
+};
+
+/** \brief Runs the scenes one after the other for a fixed number of frames each, with the replayed input, and writes what the
+	*  frames took and their FrameStats counters as JSON once the last one is done, then exits the game */
+class BenchmarkScreen : public GameEngine::IGameScreen
+{
+public:
+		BenchmarkScreen(const BenchmarkSettings& _settings, const InputReplay& _replay);
+		~BenchmarkScreen();
+
+		virtual int GetNextScreenIndex() const override;
+		virtual int GetPreviousScreenIndex() const override;
+
+		virtual void Build() override;
+		virtual void Destroy() override;
+
+		virtual void OnEntry() override;
+		virtual void OnExit() override;
+
+		/** \brief Measures the frame before, then ticks the current scene, or moves on to the next one when it's done */
+		virtual void Update() override;
+		virtual void Draw() override;
+
+private:
+		using Clock = std::chrono::steady_clock;
+
+		/** \brief Initializes the next scene which can run here, returns false when there are none left */
+		bool StartNextScene();
+		/** \brief Disposes the current scene after its last frame */
+		void EndScene();
+		/** \brief Writes the results to the output file */
+		void WriteResults() const;
+
+		BenchmarkSettings m_settings;
+		InputReplay m_replay;
+
+		std::unique_ptr<BenchmarkScene> m_scene; ///< nullptr between the scenes
+		size_t m_nextScene{ 0 };                 ///< the index in m_settings.m_scenes
+		int m_frame{ 0 };                        ///< of the current scene, the warmup frames included
+		Clock::time_point m_frameStart;
+
+		std::vector<SceneResult> m_results;
+};
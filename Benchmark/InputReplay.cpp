@@ -0,0 +1,85 @@
+#include "InputReplay.h"
+
+#include <SDL\SDL.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+void InputReplay::LoadDefault(int _numFrames)
+{
+		const SDL_Keycode keys[] = { SDLK_d, SDLK_w, SDLK_a, SDLK_s };
+		const int quarter = std::max(_numFrames / 4, 1);
+		m_events.clear();
+		for (int i = 0; i < 4; i++)
+		{
+				ReplayEvent event;
+				event.m_key = static_cast<GameEngine::KeyID>(keys[i]);
+				event.m_frame = i * quarter;
+				event.m_down = true;
+				m_events.push_back(event);
+				event.m_frame = (i + 1) * quarter;
+				event.m_down = false;
+				m_events.push_back(event);
+		}
+}
+
+void InputReplay::Load(const std::string& _filePath)
+{
+		std::ifstream file(_filePath.c_str());
+		if (file.fail())
+		{
+				throw std::runtime_error("File " + _filePath + " failed to load");
+		}
+
+		m_events.clear();
+		std::string line;
+		while (std::getline(file, line))
+		{
+				if (line.empty() || line[0] == '#')
+				{
+						continue;
+				}
+				std::istringstream stream(line);
+				ReplayEvent event;
+				std::string state;
+				std::string keyName;
+				stream >> event.m_frame >> state;
+				std::getline(stream >> std::ws, keyName);
+				const SDL_Keycode key = SDL_GetKeyFromName(keyName.c_str());
+				if (stream.fail() || (state != "down" && state != "up") || key == SDLK_UNKNOWN)
+				{
+						throw std::runtime_error("File " + _filePath + " has an invalid line: " + line);
+				}
+				event.m_down = state == "down";
+				event.m_key = static_cast<GameEngine::KeyID>(key);
+				m_events.push_back(event);
+		}
+		//a key released and pressed again on the same frame keeps the order of the file
+		std::stable_sort(m_events.begin(), m_events.end(), [](const ReplayEvent& _a, const ReplayEvent& _b) { return _a.m_frame < _b.m_frame; });
+}
+
+void InputReplay::Apply(int _frame, GameEngine::InputManager& _input) const
+{
+		auto event = std::lower_bound(m_events.begin(), m_events.end(), _frame,
+				[](const ReplayEvent& _event, int _value) { return _event.m_frame < _value; });
+		for (; event != m_events.end() && event->m_frame == _frame; ++event)
+		{
+				if (event->m_down)
+				{
+						_input.PressKey(event->m_key);
+				}
+				else
+				{
+						_input.ReleaseKey(event->m_key);
+				}
+		}
+}
+
+void InputReplay::ReleaseAll(GameEngine::InputManager& _input) const
+{
+		for (const ReplayEvent& event : m_events)
+		{
+				_input.ReleaseKey(event.m_key);
+		}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include <GameEngine\InputManager.h>
+
+/** \brief A key going down or up at a frame of a scene */
+struct ReplayEvent
+{
+		int m_frame{ 0 };
+		bool m_down{ true };
+		GameEngine::KeyID m_key{ 0 };
+};
+
+/** \brief The scripted input of the benchmark: it presses and releases the keys through the InputManager at the same frames
+	*  every run, so the camera of a scene takes the same path whatever the machine. Every scene plays it from its first frame */
+class InputReplay
+{
+public:
+		/** \brief Replaces the script with the default one: WASD held one after the other, a quarter of _numFrames each,
+			*  which pans the camera around a square */
+		void LoadDefault(int _numFrames);
+		/** \brief Replaces the script with a recorded one, one "frame down|up key" line per event where key is the SDL name
+			*  of the key (e.g. "120 down W"). Throws std::runtime_error if the file can't be read or a line can't be parsed */
+		void Load(const std::string& _filePath);
+
+		/** \brief Presses and releases the keys of _frame */
+		void Apply(int _frame, GameEngine::InputManager& _input) const;
+		/** \brief Releases every key of the script, for the next scene to start without any */
+		void ReleaseAll(GameEngine::InputManager& _input) const;
+
+private:
+		std::vector<ReplayEvent> m_events; ///< sorted by frame
+};
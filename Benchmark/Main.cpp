@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include "BenchmarkApp.h"
+
+namespace
+{
+		void PrintUsage()
+		{
+				std::printf("usage: Benchmark [-scene name[,name...]] [-frames n] [-warmup n] [-seed n] [-replay file] [-output file]\n"
+						"                 [-width n] [-height n]\n"
+						"  -scene  - the scenes to run, all of them by default: sprites, zombies, particles, models, lights\n"
+						"  -frames - the frames measured per scene (600 by default)\n"
+						"  -warmup - the frames run before them (60 by default)\n"
+						"  -seed   - the seed of the placements in the scenes (1 by default)\n"
+						"  -replay - the input script, one \"frame down|up key\" line per event (WASD around a square by default)\n"
+						"  -output - the JSON file the results are written to (benchmark.json by default)\n"
+						"  -width  - the size of the hidden window (1280x720 by default)\n"
+						"  -height\n");
+		}
+
+		bool ParseScenes(const std::string& _list, std::vector<std::string>& _scenes)
+		{
+				size_t start = 0;
+				while (start <= _list.size())
+				{
+						const size_t end = std::min(_list.find(',', start), _list.size());
+						const std::string name = _list.substr(start, end - start);
+						if (!CreateScene(name))
+						{
+								std::printf("Unknown scene %s\n", name.c_str());
+								return false;
+						}
+						_scenes.push_back(name);
+						start = end + 1;
+				}
+				return true;
+		}
+}
+
+int main(int argc, char** argv)
+{
+		BenchmarkSettings settings;
+		for (int i = 1; i < argc; i++)
+		{
+				const std::string argument = argv[i];
+				const bool hasValue = i + 1 < argc;
+				if (argument == "-scene" && hasValue)
+				{
+						if (!ParseScenes(argv[++i], settings.m_scenes))
+						{
+								PrintUsage();
+								return 1;
+						}
+				}
+				else if (argument == "-frames" && hasValue)
+				{
+						settings.m_numFrames = std::max(std::atoi(argv[++i]), 1);
+				}
+				else if (argument == "-warmup" && hasValue)
+				{
+						settings.m_numWarmupFrames = std::max(std::atoi(argv[++i]), 0);
+				}
+				else if (argument == "-seed" && hasValue)
+				{
+						settings.m_seed = std::strtoul(argv[++i], nullptr, 10);
+				}
+				else if (argument == "-replay" && hasValue)
+				{
+						settings.m_replayPath = argv[++i];
+				}
+				else if (argument == "-output" && hasValue)
+				{
+						settings.m_outputPath = argv[++i];
+				}
+				else if (argument == "-width" && hasValue)
+				{
+						settings.m_screenWidth = std::max(std::atoi(argv[++i]), 1);
+				}
+				else if (argument == "-height" && hasValue)
+				{
+						settings.m_screenHeight = std::max(std::atoi(argv[++i]), 1);
+				}
+				else
+				{
+						PrintUsage();
+						return 1;
+				}
+		}
+		if (settings.m_scenes.empty())
+		{
+				settings.m_scenes = GetSceneNames();
+		}
+
+		InputReplay replay;
+		try
+		{
+				if (settings.m_replayPath.empty())
+				{
+						replay.LoadDefault(settings.m_numWarmupFrames + settings.m_numFrames);
+				}
+				else
+				{
+						replay.Load(settings.m_replayPath);
+				}
+		}
+		catch (const std::runtime_error& _error)
+		{
+				std::printf("%s\n", _error.what());
+				return 1;
+		}
+
+		BenchmarkApp app(settings, replay);
+		app.Run();
+		return 0;
+}
@@ -66,6 +66,19 @@ glm::vec3 AABB::Center() const
 		return glm::vec3((m_min + m_max) * 0.5f);
 }
 
+AABB AABB::Transformed(const glm::mat4 & _transform) const
+{
+		//the new half size on an axis is the sum of the old ones scaled by how far the matrix turns them onto it (Arvo)
+		const glm::vec3 center(_transform * glm::vec4(Center(), 1.0f));
+		const glm::vec3 halfSize = (m_max - m_min) * 0.5f;
+		glm::vec3 newHalfSize(0.0f);
+		for (int column = 0; column < 3; column++)
+		{
+				newHalfSize += glm::abs(glm::vec3(_transform[column])) * halfSize[column];
+		}
+		return AABB(center - newHalfSize, center + newHalfSize);
+}
+
 bool AABB::operator==(const AABB & _other) const
 {
 		return (m_min == _other.GetMin()) && (m_max == _other.GetMax());
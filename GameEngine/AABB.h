@@ -62,6 +62,11 @@ public:
 		/** \return the center vec3 of the AABB*/
 		glm::vec3 Center() const;
 
+		/** \brief The box around this one moved by a matrix, e.g. the bounds of a mesh in world space from its model matrix
+		*  \param _transform - the matrix (an affine one), a rotated box gets the box around its corners
+		*/
+		AABB Transformed(const glm::mat4& _transform) const;
+
 		/** Operator overloaders */
 		bool operator==(const AABB& _other) const;
 		bool operator!=(const AABB& _other) const;
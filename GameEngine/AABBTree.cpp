@@ -0,0 +1,483 @@
+#include "AABBTree.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace GameEngine
+{
+  namespace
+  {
+    enum class Containment { OUTSIDE, INSIDE, INTERSECTS };
+
+    AABB Merge(const AABB& _a, const AABB& _b)
+    {
+      return AABB(glm::min(_a.GetMin(), _b.GetMin()), glm::max(_a.GetMax(), _b.GetMax()));
+    }
+
+    //the cost of a node for the insertion, the chance of a random ray or query reaching it
+    float SurfaceArea(const AABB& _box)
+    {
+      const glm::vec3 size = _box.GetMax() - _box.GetMin();
+      return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    bool Overlaps(const AABB& _a, const AABB& _b)
+    {
+      return glm::all(glm::lessThanEqual(_a.GetMin(), _b.GetMax())) && glm::all(glm::lessThanEqual(_b.GetMin(), _a.GetMax()));
+    }
+
+    Containment Classify(const std::array<glm::vec4, 6>& _planes, const AABB& _box)
+    {
+      const glm::vec3& min = _box.GetMin();
+      const glm::vec3& max = _box.GetMax();
+      Containment result = Containment::INSIDE;
+      for (const glm::vec4& plane : _planes)
+      {
+        //the corners furthest along and against the normal
+        const glm::vec3 positive(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y, plane.z >= 0.0f ? max.z : min.z);
+        const glm::vec3 negative(plane.x >= 0.0f ? min.x : max.x, plane.y >= 0.0f ? min.y : max.y, plane.z >= 0.0f ? min.z : max.z);
+        if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+        {
+          return Containment::OUTSIDE;
+        }
+        if (glm::dot(glm::vec3(plane), negative) + plane.w < 0.0f)
+        {
+          result = Containment::INTERSECTS;
+        }
+      }
+      return result;
+    }
+
+    //the infinities of the axes the ray is parallel to make the slab test skip them
+    glm::vec3 InverseDirection(const glm::vec3& _direction)
+    {
+      const float infinity = std::numeric_limits<float>::infinity();
+      return glm::vec3(_direction.x != 0.0f ? 1.0f / _direction.x : infinity, _direction.y != 0.0f ? 1.0f / _direction.y : infinity,
+        _direction.z != 0.0f ? 1.0f / _direction.z : infinity);
+    }
+
+    //the slab test, _inverseDirection has the infinities of the axes the ray is parallel to
+    bool RayHits(const glm::vec3& _origin, const glm::vec3& _inverseDirection, float _maxDistance, const AABB& _box)
+    {
+      const glm::vec3 t0 = (_box.GetMin() - _origin) * _inverseDirection;
+      const glm::vec3 t1 = (_box.GetMax() - _origin) * _inverseDirection;
+      const glm::vec3 tNear = glm::min(t0, t1);
+      const glm::vec3 tFar = glm::max(t0, t1);
+      const float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+      const float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, _maxDistance));
+      return enter <= exit;
+    }
+  }
+
+  AABBTree::AABBTree(float _margin) : m_margin(_margin)
+  {
+  }
+
+  AABBTree::~AABBTree()
+  {
+  }
+
+  int AABBTree::Insert(const AABB& _box, int _id)
+  {
+    const int leaf = AllocateNode();
+    Node& node = m_nodes[leaf];
+    node.box = AABB(_box.GetMin() - glm::vec3(m_margin), _box.GetMax() + glm::vec3(m_margin));
+    node.id = _id;
+    node.height = 0;
+    InsertLeaf(leaf);
+    m_numObjects++;
+    return leaf;
+  }
+
+  void AABBTree::Remove(int _proxy)
+  {
+    RemoveLeaf(_proxy);
+    FreeNode(_proxy);
+    m_numObjects--;
+  }
+
+  bool AABBTree::Move(int _proxy, const AABB& _box)
+  {
+    if (m_nodes[_proxy].box.Contains(_box))
+    {
+      return false;
+    }
+    RemoveLeaf(_proxy);
+    m_nodes[_proxy].box = AABB(_box.GetMin() - glm::vec3(m_margin), _box.GetMax() + glm::vec3(m_margin));
+    InsertLeaf(_proxy);
+    return true;
+  }
+
+  void AABBTree::Clear()
+  {
+    m_nodes.clear();
+    m_root = NO_NODE;
+    m_freeList = NO_NODE;
+    m_numObjects = 0;
+  }
+
+  void AABBTree::QueryFrustum(const std::array<glm::vec4, 6>& _planes, std::vector<int>& _ids) const
+  {
+    if (m_root == NO_NODE)
+    {
+      return;
+    }
+    m_stack.clear();
+    m_stack.push_back(m_root);
+    while (!m_stack.empty())
+    {
+      const int index = m_stack.back();
+      m_stack.pop_back();
+      const Node& node = m_nodes[index];
+      const Containment containment = Classify(_planes, node.box);
+      if (containment == Containment::OUTSIDE)
+      {
+        continue;
+      }
+      //a node whole inside has all its leaves inside too
+      if (containment == Containment::INSIDE || node.IsLeaf())
+      {
+        CollectLeaves(index, _ids);
+        continue;
+      }
+      m_stack.push_back(node.children[0]);
+      m_stack.push_back(node.children[1]);
+    }
+  }
+
+  void AABBTree::QueryBox(const AABB& _box, std::vector<int>& _ids) const
+  {
+    if (m_root == NO_NODE)
+    {
+      return;
+    }
+    m_stack.clear();
+    m_stack.push_back(m_root);
+    while (!m_stack.empty())
+    {
+      const Node& node = m_nodes[m_stack.back()];
+      m_stack.pop_back();
+      if (!Overlaps(node.box, _box))
+      {
+        continue;
+      }
+      if (node.IsLeaf())
+      {
+        _ids.push_back(node.id);
+        continue;
+      }
+      m_stack.push_back(node.children[0]);
+      m_stack.push_back(node.children[1]);
+    }
+  }
+
+  void AABBTree::QueryRay(const glm::vec3& _origin, const glm::vec3& _direction, float _maxDistance, std::vector<int>& _ids) const
+  {
+    if (m_root == NO_NODE)
+    {
+      return;
+    }
+    const glm::vec3 inverseDirection = InverseDirection(_direction);
+    m_stack.clear();
+    m_stack.push_back(m_root);
+    while (!m_stack.empty())
+    {
+      const Node& node = m_nodes[m_stack.back()];
+      m_stack.pop_back();
+      if (!RayHits(_origin, inverseDirection, _maxDistance, node.box))
+      {
+        continue;
+      }
+      if (node.IsLeaf())
+      {
+        _ids.push_back(node.id);
+        continue;
+      }
+      m_stack.push_back(node.children[0]);
+      m_stack.push_back(node.children[1]);
+    }
+  }
+
+  void AABBTree::QueryPairs(std::vector<std::pair<int, int>>& _pairs) const
+  {
+    if (m_root == NO_NODE)
+    {
+      return;
+    }
+    //every leaf against the tree, a pair is kept from the leaf of the lower index only
+    for (int leaf = 0; leaf < static_cast<int>(m_nodes.size()); leaf++)
+    {
+      const Node& leafNode = m_nodes[leaf];
+      if (leafNode.height != 0)
+      {
+        continue;
+      }
+      m_stack.clear();
+      m_stack.push_back(m_root);
+      while (!m_stack.empty())
+      {
+        const int index = m_stack.back();
+        m_stack.pop_back();
+        const Node& node = m_nodes[index];
+        if (!Overlaps(node.box, leafNode.box))
+        {
+          continue;
+        }
+        if (node.IsLeaf())
+        {
+          if (index > leaf)
+          {
+            _pairs.emplace_back(leafNode.id, node.id);
+          }
+          continue;
+        }
+        m_stack.push_back(node.children[0]);
+        m_stack.push_back(node.children[1]);
+      }
+    }
+  }
+
+  void AABBTree::QueryBoxes(const std::vector<AABB>& _boxes, std::vector<std::pair<int, int>>& _hits) const
+  {
+    if (m_root == NO_NODE)
+    {
+      return;
+    }
+    for (int i = 0; i < static_cast<int>(_boxes.size()); i++)
+    {
+      const AABB& box = _boxes[i];
+      m_stack.clear();
+      m_stack.push_back(m_root);
+      while (!m_stack.empty())
+      {
+        const Node& node = m_nodes[m_stack.back()];
+        m_stack.pop_back();
+        if (!Overlaps(node.box, box))
+        {
+          continue;
+        }
+        if (node.IsLeaf())
+        {
+          _hits.emplace_back(i, node.id);
+          continue;
+        }
+        m_stack.push_back(node.children[0]);
+        m_stack.push_back(node.children[1]);
+      }
+    }
+  }
+
+  void AABBTree::QueryRays(const std::vector<Ray>& _rays, std::vector<std::pair<int, int>>& _hits) const
+  {
+    if (m_root == NO_NODE)
+    {
+      return;
+    }
+    for (int i = 0; i < static_cast<int>(_rays.size()); i++)
+    {
+      const Ray& ray = _rays[i];
+      const glm::vec3 inverseDirection = InverseDirection(ray.direction);
+      m_stack.clear();
+      m_stack.push_back(m_root);
+      while (!m_stack.empty())
+      {
+        const Node& node = m_nodes[m_stack.back()];
+        m_stack.pop_back();
+        if (!RayHits(ray.origin, inverseDirection, ray.maxDistance, node.box))
+        {
+          continue;
+        }
+        if (node.IsLeaf())
+        {
+          _hits.emplace_back(i, node.id);
+          continue;
+        }
+        m_stack.push_back(node.children[0]);
+        m_stack.push_back(node.children[1]);
+      }
+    }
+  }
+
+  int AABBTree::AllocateNode()
+  {
+    if (m_freeList == NO_NODE)
+    {
+      m_nodes.emplace_back();
+      return static_cast<int>(m_nodes.size()) - 1;
+    }
+    const int node = m_freeList;
+    m_freeList = m_nodes[node].parent;
+    m_nodes[node] = Node();
+    return node;
+  }
+
+  void AABBTree::FreeNode(int _node)
+  {
+    m_nodes[_node].parent = m_freeList;
+    m_nodes[_node].height = -1;
+    m_freeList = _node;
+  }
+
+  void AABBTree::InsertLeaf(int _leaf)
+  {
+    if (m_root == NO_NODE)
+    {
+      m_root = _leaf;
+      m_nodes[_leaf].parent = NO_NODE;
+      return;
+    }
+
+    //down the children which grow the least, until making a new parent here is cheaper than going on
+    const AABB leafBox = m_nodes[_leaf].box;
+    int index = m_root;
+    while (!m_nodes[index].IsLeaf())
+    {
+      const Node& node = m_nodes[index];
+      const float area = SurfaceArea(node.box);
+      const float combinedArea = SurfaceArea(Merge(node.box, leafBox));
+      //a new parent of this node and the leaf
+      const float cost = 2.0f * combinedArea;
+      //what every node below grows by, the box of this one has to take the leaf
+      const float inheritedCost = 2.0f * (combinedArea - area);
+      float childCosts[2];
+      for (int i = 0; i < 2; i++)
+      {
+        const Node& child = m_nodes[node.children[i]];
+        const float childArea = SurfaceArea(Merge(child.box, leafBox));
+        childCosts[i] = (child.IsLeaf() ? childArea : childArea - SurfaceArea(child.box)) + inheritedCost;
+      }
+      if (cost < childCosts[0] && cost < childCosts[1])
+      {
+        break;
+      }
+      index = childCosts[0] < childCosts[1] ? node.children[0] : node.children[1];
+    }
+
+    const int sibling = index;
+    const int oldParent = m_nodes[sibling].parent;
+    const int newParent = AllocateNode();
+    Node& parent = m_nodes[newParent];
+    parent.parent = oldParent;
+    parent.box = Merge(leafBox, m_nodes[sibling].box);
+    parent.height = m_nodes[sibling].height + 1;
+    parent.children[0] = sibling;
+    parent.children[1] = _leaf;
+    m_nodes[sibling].parent = newParent;
+    m_nodes[_leaf].parent = newParent;
+    if (oldParent != NO_NODE)
+    {
+      int* children = m_nodes[oldParent].children;
+      children[children[0] == sibling ? 0 : 1] = newParent;
+    }
+    else
+    {
+      m_root = newParent;
+    }
+    Refit(oldParent);
+  }
+
+  void AABBTree::RemoveLeaf(int _leaf)
+  {
+    if (_leaf == m_root)
+    {
+      m_root = NO_NODE;
+      return;
+    }
+    //the sibling takes the place of the parent
+    const int parent = m_nodes[_leaf].parent;
+    const int grandParent = m_nodes[parent].parent;
+    const int sibling = m_nodes[parent].children[m_nodes[parent].children[0] == _leaf ? 1 : 0];
+    m_nodes[sibling].parent = grandParent;
+    FreeNode(parent);
+    if (grandParent != NO_NODE)
+    {
+      int* children = m_nodes[grandParent].children;
+      children[children[0] == parent ? 0 : 1] = sibling;
+      Refit(grandParent);
+    }
+    else
+    {
+      m_root = sibling;
+    }
+  }
+
+  void AABBTree::Refit(int _node)
+  {
+    for (int index = _node; index != NO_NODE; index = m_nodes[index].parent)
+    {
+      index = Balance(index);
+      Node& node = m_nodes[index];
+      const Node& child0 = m_nodes[node.children[0]];
+      const Node& child1 = m_nodes[node.children[1]];
+      node.height = 1 + std::max(child0.height, child1.height);
+      node.box = Merge(child0.box, child1.box);
+    }
+  }
+
+  int AABBTree::Balance(int _node)
+  {
+    Node& a = m_nodes[_node];
+    if (a.IsLeaf() || a.height < 2)
+    {
+      return _node;
+    }
+    //the taller child (up) takes the place of a, a takes the shorter grandchild under up
+    const int b = a.children[0];
+    const int c = a.children[1];
+    const int balance = m_nodes[c].height - m_nodes[b].height;
+    if (balance >= -1 && balance <= 1)
+    {
+      return _node;
+    }
+    const int up = balance > 1 ? c : b;
+    const int other = balance > 1 ? b : c;
+    const int upSlot = balance > 1 ? 1 : 0;
+    Node& upNode = m_nodes[up];
+    const int f = upNode.children[0];
+    const int g = upNode.children[1];
+
+    upNode.children[0] = _node;
+    upNode.parent = a.parent;
+    a.parent = up;
+    if (upNode.parent != NO_NODE)
+    {
+      int* children = m_nodes[upNode.parent].children;
+      children[children[0] == _node ? 0 : 1] = up;
+    }
+    else
+    {
+      m_root = up;
+    }
+
+    //the taller grandchild stays under up, the other moves under a
+    const int kept = m_nodes[f].height > m_nodes[g].height ? f : g;
+    const int moved = kept == f ? g : f;
+    upNode.children[1] = kept;
+    a.children[upSlot] = moved;
+    m_nodes[moved].parent = _node;
+    a.box = Merge(m_nodes[other].box, m_nodes[moved].box);
+    a.height = 1 + std::max(m_nodes[other].height, m_nodes[moved].height);
+    upNode.box = Merge(a.box, m_nodes[kept].box);
+    upNode.height = 1 + std::max(a.height, m_nodes[kept].height);
+    return up;
+  }
+
+  void AABBTree::CollectLeaves(int _node, std::vector<int>& _ids) const
+  {
+    //its own stack, the one of the query is in use
+    const size_t base = m_stack.size();
+    m_stack.push_back(_node);
+    while (m_stack.size() > base)
+    {
+      const Node& node = m_nodes[m_stack.back()];
+      m_stack.pop_back();
+      if (node.IsLeaf())
+      {
+        _ids.push_back(node.id);
+        continue;
+      }
+      m_stack.push_back(node.children[0]);
+      m_stack.push_back(node.children[1]);
+    }
+  }
+}
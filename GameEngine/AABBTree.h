@@ -0,0 +1,109 @@
+#pragma once
+#include <array>
+#include <utility>
+#include <vector>
+#include <glm\glm.hpp>
+
+#include "AABB.h"
+
+namespace GameEngine
+{
+  /** \brief A dynamic AABB tree, the broadphase of the engine for the queries which would otherwise test every object: the frustum of
+  * the camera, the bounds of the shadow casters of a light (see LightCamera::GetCasterBounds), the rays of picking and the overlaps of
+  * pickups and triggers. 2D objects use boxes with a depth of 0. A query only descends into the nodes it reaches, and a node whole
+  * inside the frustum reports its objects without testing them, so the cost follows what is found instead of the number of objects.
+  * The batched queries run many boxes or rays in one call and report (query index, id) pairs.
+  * The leaves keep boxes fattened by a margin, an object moving inside its fat box doesn't change the tree. Every insert picks the
+  * sibling which grows the surface area the least and the tree is balanced by rotations on the way up, as in Box2D's dynamic tree.
+  * The nodes live in one array with a free list, a proxy (the index of the leaf) stays valid until it's removed */
+  class AABBTree
+  {
+  public:
+    enum : int { NO_NODE = -1 };
+
+    /** \brief \param _margin - how much the boxes are fattened on every side, more for objects which move a lot */
+    AABBTree(float _margin = 0.1f);
+    ~AABBTree();
+
+    /** \brief Adds an object
+    * \param _box - its box in world space (e.g. StaticModel::GetBoundingBox transformed by the model matrix)
+    * \param _id - the id reported by the queries (e.g. the index of the object in its container)
+    * \return the proxy of the object, for Move and Remove
+    */
+    int Insert(const AABB& _box, int _id);
+    /** \brief Removes the object of _proxy, the proxy can be handed out again */
+    void Remove(int _proxy);
+    /** \brief Updates the box of a moved object
+    * \return true if it left its fat box and was inserted again
+    */
+    bool Move(int _proxy, const AABB& _box);
+    /** \brief Changes the id the queries report for _proxy, e.g. when the object moved in its container */
+    void SetId(int _proxy, int _id) { m_nodes[_proxy].id = _id; }
+    /** \brief Removes all the objects, the nodes are kept for the next ones */
+    void Clear();
+
+    /** \brief Gets the ids of the objects whose fat boxes reach into the frustum (see Camera3D::GetFrustumPlanes)
+    * \param _ids - the ids are appended, not cleared first
+    */
+    void QueryFrustum(const std::array<glm::vec4, 6>& _planes, std::vector<int>& _ids) const;
+    /** \brief Gets the ids of the objects whose fat boxes overlap _box (touching counts), appended to _ids */
+    void QueryBox(const AABB& _box, std::vector<int>& _ids) const;
+    /** \brief Gets the ids of the objects whose fat boxes the ray hits before _maxDistance, appended to _ids in no particular order.
+    * A superset of the hit objects, the caller tests their shapes
+    * \param _direction - the direction of the ray, needn't be normalized (_maxDistance is in its lengths)
+    */
+    void QueryRay(const glm::vec3& _origin, const glm::vec3& _direction, float _maxDistance, std::vector<int>& _ids) const;
+
+    /** \brief A ray of QueryRays, see QueryRay */
+    struct Ray
+    {
+      glm::vec3 origin;
+      glm::vec3 direction;
+      float maxDistance;
+    };
+    /** \brief Gets every pair of objects whose fat boxes overlap, each pair once, appended to _pairs as (id, id) */
+    void QueryPairs(std::vector<std::pair<int, int>>& _pairs) const;
+    /** \brief QueryBox for every box of _boxes, the hits are appended to _hits as (index in _boxes, id) */
+    void QueryBoxes(const std::vector<AABB>& _boxes, std::vector<std::pair<int, int>>& _hits) const;
+    /** \brief QueryRay for every ray of _rays, the hits are appended to _hits as (index in _rays, id) */
+    void QueryRays(const std::vector<Ray>& _rays, std::vector<std::pair<int, int>>& _hits) const;
+
+    int GetId(int _proxy) const { return m_nodes[_proxy].id; }
+    const AABB& GetFatBox(int _proxy) const { return m_nodes[_proxy].box; }
+    size_t GetNumObjects() const noexcept { return m_numObjects; }
+    /** \brief The height of the tree, 0 for a single leaf. About log2 of the objects when it's balanced */
+    int GetHeight() const { return m_root != NO_NODE ? m_nodes[m_root].height : 0; }
+
+  private:
+    struct Node
+    {
+      AABB box;
+      int parent{ NO_NODE }; ///< the next free node while the node is free
+      int children[2]{ NO_NODE, NO_NODE };
+      int id{ -1 };      ///< leaves only
+      int height{ 0 };   ///< 0 for a leaf, -1 for a free node
+
+      bool IsLeaf() const { return children[0] == NO_NODE; }
+    };
+
+    int AllocateNode();
+    void FreeNode(int _node);
+    void InsertLeaf(int _leaf);
+    void RemoveLeaf(int _leaf);
+    /** \brief Walks up from _node to the root, balancing and fixing the boxes and the heights */
+    void Refit(int _node);
+    /** \brief Rotates the taller grandchild of _node up if its children differ by more than 1 in height
+    * \return the node now at the place of _node
+    */
+    int Balance(int _node);
+    /** \brief Appends the ids of all the leaves under _node, no tests */
+    void CollectLeaves(int _node, std::vector<int>& _ids) const;
+
+    std::vector<Node> m_nodes;
+    int m_root{ NO_NODE };
+    int m_freeList{ NO_NODE };
+    size_t m_numObjects{ 0 };
+    float m_margin{ 0.1f };
+    mutable std::vector<int> m_stack; ///< the nodes left to visit by a query, kept so the queries don't allocate
+  };
+}
@@ -0,0 +1,33 @@
+#include "FrameStats.h"
+
+#include <cstdlib>
+#include <new>
+
+//in a file of its own, so a program with its own operator new (like the PathBenchmark) doesn't get this one linked in as well
+#ifdef GAME_ENGINE_ALLOCATION_STATS
+//the replaced global allocation functions, the others (nothrow, arrays) are defined through these by the standard library
+void* operator new(std::size_t _size)
+{
+  GameEngine::g_frameAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* memory = std::malloc(_size ? _size : 1))
+  {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t _size)
+{
+  return ::operator new(_size);
+}
+
+void operator delete(void* _memory) noexcept
+{
+  std::free(_memory);
+}
+
+void operator delete[](void* _memory) noexcept
+{
+  std::free(_memory);
+}
+#endif
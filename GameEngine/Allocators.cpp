@@ -0,0 +1,162 @@
+#include "Allocators.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+
+namespace GameEngine
+{
+  FrameArena::FrameArena(std::size_t _capacity, MemoryTag _tag) :
+    m_tag(_tag)
+  {
+    if (_capacity > 0)
+    {
+      AddBlock(_capacity);
+    }
+  }
+
+  FrameArena::~FrameArena()
+  {
+    for (const Block& block : m_blocks)
+    {
+      MemoryTracker::Get().Free(block.memory, block.size, alignof(std::max_align_t), m_tag);
+    }
+  }
+
+  void* FrameArena::Allocate(std::size_t _size, std::size_t _alignment)
+  {
+    std::size_t offset = m_offset;
+    if (!m_blocks.empty())
+    {
+      const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(m_blocks.back().memory) + m_offset;
+      offset += static_cast<std::size_t>(((address + _alignment - 1) & ~static_cast<std::uintptr_t>(_alignment - 1)) - address);
+    }
+    if (m_blocks.empty() || offset + _size > m_blocks.back().size)
+    {
+      //at least twice the last block, so a frame which keeps growing only takes a few more
+      AddBlock(std::max(m_blocks.empty() ? 0 : m_blocks.back().size * 2, _size + _alignment));
+      const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(m_blocks.back().memory);
+      offset = static_cast<std::size_t>(((address + _alignment - 1) & ~static_cast<std::uintptr_t>(_alignment - 1)) - address);
+    }
+    void* memory = m_blocks.back().memory + offset;
+    m_used += offset - m_offset + _size;
+    m_offset = offset + _size;
+    m_highWater = std::max(m_highWater, m_used);
+    return memory;
+  }
+
+  void FrameArena::Reset()
+  {
+    if (m_blocks.size() > 1 || m_rewoundBlocks > 0)
+    {
+      //one block which fits everything this frame took
+      std::size_t size = m_rewoundBlocks;
+      for (const Block& block : m_blocks)
+      {
+        size += block.size;
+        MemoryTracker::Get().Free(block.memory, block.size, alignof(std::max_align_t), m_tag);
+      }
+      m_blocks.clear();
+      AddBlock(size);
+      m_rewoundBlocks = 0;
+    }
+    m_offset = 0;
+    m_used = 0;
+  }
+
+  void FrameArena::Rewind(const Marker& _marker)
+  {
+    if (m_blocks.empty())
+    {
+      return;
+    }
+    while (m_blocks.size() > _marker.block + 1)
+    {
+      const Block& block = m_blocks.back();
+      m_rewoundBlocks += block.size;
+      MemoryTracker::Get().Free(block.memory, block.size, alignof(std::max_align_t), m_tag);
+      m_blocks.pop_back();
+    }
+    m_offset = _marker.offset;
+    m_used = _marker.used;
+  }
+
+  FrameAllocator& FrameAllocator::Get()
+  {
+    static FrameAllocator allocator;
+    return allocator;
+  }
+
+  void FrameAllocator::BeginFrame()
+  {
+    m_current = 1 - m_current;
+    m_arenas[m_current].Reset();
+  }
+
+  void FrameArena::AddBlock(std::size_t _size)
+  {
+    Block block;
+    block.memory = static_cast<char*>(MemoryTracker::Get().Allocate(_size, alignof(std::max_align_t), m_tag));
+    block.size = _size;
+    m_blocks.push_back(block);
+    m_offset = 0;
+  }
+
+  PoolAllocator::PoolAllocator(std::size_t _blockSize, std::size_t _alignment, std::size_t _blocksPerPage, MemoryTag _tag) :
+    m_alignment(std::max(_alignment, alignof(void*))),
+    m_blocksPerPage(std::max<std::size_t>(_blocksPerPage, 1)),
+    m_tag(_tag)
+  {
+    //a free block holds the free list link, and every block of a page has to stay aligned
+    m_blockSize = std::max(_blockSize, sizeof(void*));
+    m_blockSize = (m_blockSize + m_alignment - 1) / m_alignment * m_alignment;
+  }
+
+  PoolAllocator::~PoolAllocator()
+  {
+    if (m_numUsed > 0)
+    {
+      std::cout << "ERROR::POOLALLOCATOR::BLOCKS_STILL_IN_USE\n" << m_numUsed << " of " << m_blockSize << " bytes" << std::endl;
+    }
+    for (char* page : m_pages)
+    {
+      MemoryTracker::Get().Free(page, m_blockSize * m_blocksPerPage, m_alignment, m_tag);
+    }
+  }
+
+  void* PoolAllocator::Allocate()
+  {
+    if (!m_freeList)
+    {
+      AddPage();
+    }
+    void* block = m_freeList;
+    m_freeList = *static_cast<void**>(block);
+    m_numUsed++;
+    return block;
+  }
+
+  void PoolAllocator::Free(void* _block) noexcept
+  {
+    if (!_block)
+    {
+      return;
+    }
+    *static_cast<void**>(_block) = m_freeList;
+    m_freeList = _block;
+    m_numUsed--;
+  }
+
+  void PoolAllocator::AddPage()
+  {
+    char* page = static_cast<char*>(MemoryTracker::Get().Allocate(m_blockSize * m_blocksPerPage, m_alignment, m_tag));
+    m_pages.push_back(page);
+    //linked in reverse, so the blocks are handed out front to back
+    for (std::size_t i = m_blocksPerPage; i > 0; i--)
+    {
+      void* block = page + (i - 1) * m_blockSize;
+      *static_cast<void**>(block) = m_freeList;
+      m_freeList = block;
+    }
+  }
+}
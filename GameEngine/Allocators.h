@@ -0,0 +1,210 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "MemoryTracker.h"
+
+namespace GameEngine
+{
+  /** \brief A linear allocator for the memory of a frame (or any other span): an allocation moves an offset forward and Reset frees
+   *  them all at once, without destructors. When a frame needs more than the capacity another block is taken, and the next Reset merges
+   *  them into one block of the size the frame needed, so a steady frame allocates nothing. Not thread safe, one arena per thread */
+  class FrameArena
+  {
+  public:
+    explicit FrameArena(std::size_t _capacity = 64 * 1024, MemoryTag _tag = MEMORY_GENERAL);
+    ~FrameArena();
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* Allocate(std::size_t _size, std::size_t _alignment = alignof(std::max_align_t));
+
+    // _count uninitialized Ts, they aren't destroyed so T has to be trivially destructible
+    template<typename T>
+    T* AllocateArray(std::size_t _count)
+    {
+      static_assert(std::is_trivially_destructible<T>::value, "the arena doesn't destroy what it holds");
+      return static_cast<T*>(Allocate(_count * sizeof(T), alignof(T)));
+    }
+    template<typename T, typename... TArgs>
+    T* New(TArgs&&... _args)
+    {
+      static_assert(std::is_trivially_destructible<T>::value, "the arena doesn't destroy what it holds");
+      return new (Allocate(sizeof(T), alignof(T))) T(std::forward<TArgs>(_args)...);
+    }
+
+    // Frees all the allocations
+    void Reset();
+
+    // Where the arena is at, the allocations after it can be freed with Rewind (see ArenaScope)
+    struct Marker
+    {
+      std::size_t block{ 0 };
+      std::size_t offset{ 0 };
+      std::size_t used{ 0 };
+    };
+    Marker GetMarker() const noexcept { return Marker{ m_blocks.empty() ? 0 : m_blocks.size() - 1, m_offset, m_used }; }
+    // Frees the allocations made since the marker was taken, the blocks taken since are kept in mind for the next Reset
+    void Rewind(const Marker& _marker);
+
+    // The bytes allocated since the last Reset, and the most allocated between two
+    std::size_t GetUsed() const noexcept { return m_used; }
+    std::size_t GetHighWater() const noexcept { return m_highWater; }
+
+  private:
+    struct Block
+    {
+      char* memory{ nullptr };
+      std::size_t size{ 0 };
+    };
+
+    void AddBlock(std::size_t _size);
+
+    std::vector<Block> m_blocks; ///< allocated from the last one
+    std::size_t m_offset{ 0 };   ///< into the last block
+    std::size_t m_used{ 0 };
+    std::size_t m_highWater{ 0 };
+    std::size_t m_rewoundBlocks{ 0 }; ///< the size of the blocks Rewind freed since the last Reset
+    MemoryTag m_tag;
+  };
+
+  //frees what was allocated from the arena during its lifetime, for the temporaries of a function within a frame
+  class ArenaScope
+  {
+  public:
+    explicit ArenaScope(FrameArena& _arena) : m_arena(_arena), m_marker(_arena.GetMarker()) {}
+    ~ArenaScope() { m_arena.Rewind(m_marker); }
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+  private:
+    FrameArena& m_arena;
+    FrameArena::Marker m_marker;
+  };
+
+  /** \brief A standard allocator taking its memory from a FrameArena, deallocate does nothing: the memory goes with the next Reset (or
+   *  Rewind). A container using it mustn't outlive the frame, and growing it leaves the old storage in the arena, so it's best reserved */
+  template<typename T>
+  class ArenaAllocator
+  {
+  public:
+    typedef T value_type;
+    template<typename U>
+    struct rebind { typedef ArenaAllocator<U> other; };
+
+    explicit ArenaAllocator(FrameArena& _arena) noexcept : m_arena(&_arena) {}
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& _other) noexcept : m_arena(_other.GetArena()) {}
+
+    T* allocate(std::size_t _count) { return static_cast<T*>(m_arena->Allocate(_count * sizeof(T), alignof(T))); }
+    void deallocate(T*, std::size_t) noexcept {}
+
+    FrameArena* GetArena() const noexcept { return m_arena; }
+
+  private:
+    FrameArena* m_arena;
+  };
+
+  template<typename T, typename U>
+  bool operator==(const ArenaAllocator<T>& _a, const ArenaAllocator<U>& _b) noexcept { return _a.GetArena() == _b.GetArena(); }
+  template<typename T, typename U>
+  bool operator!=(const ArenaAllocator<T>& _a, const ArenaAllocator<U>& _b) noexcept { return _a.GetArena() != _b.GetArena(); }
+
+  template<typename T>
+  using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+  /** \brief The frame arenas of the simulation thread, two of them: IMainGame::Run calls BeginFrame at the start of every frame, which
+   *  switches to the other arena and resets it. What was allocated in a frame stays valid through the next one, so a frame packet drawn
+   *  by the render thread while the next frame is built can point into it. Only used from the thread running the game loop */
+  class FrameAllocator
+  {
+  public:
+    static FrameAllocator& Get();
+
+    void BeginFrame();
+
+    // The arena of this frame, and the one of the frame before
+    FrameArena& GetArena() noexcept { return m_arenas[m_current]; }
+    FrameArena& GetPreviousArena() noexcept { return m_arenas[1 - m_current]; }
+
+    // An allocator for a container of this frame, e.g. ArenaVector<int> ints(FrameAllocator::Get().MakeAllocator<int>())
+    template<typename T>
+    ArenaAllocator<T> MakeAllocator() noexcept { return ArenaAllocator<T>(GetArena()); }
+
+  private:
+    FrameAllocator() {}
+
+    FrameArena m_arenas[2]; ///< grown to what the frames need by their Reset
+    unsigned int m_current{ 0 };
+  };
+
+  /** \brief Hands out blocks of one size from pages of _blocksPerPage blocks, the freed blocks are kept on a free list and reused first,
+   *  so the many small objects of a subsystem cost an allocation per page rather than one each. Not thread safe */
+  class PoolAllocator
+  {
+  public:
+    PoolAllocator(std::size_t _blockSize, std::size_t _alignment = alignof(std::max_align_t), std::size_t _blocksPerPage = 256,
+      MemoryTag _tag = MEMORY_GENERAL);
+    ~PoolAllocator();
+    PoolAllocator(const PoolAllocator&) = delete;
+    PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+    void* Allocate();
+    void Free(void* _block) noexcept;
+
+    std::size_t GetNumUsed() const noexcept { return m_numUsed; }
+    std::size_t GetBlockSize() const noexcept { return m_blockSize; }
+
+  private:
+    void AddPage();
+
+    std::size_t m_blockSize;
+    std::size_t m_alignment;
+    std::size_t m_blocksPerPage;
+    MemoryTag m_tag;
+    std::vector<char*> m_pages;
+    void* m_freeList{ nullptr }; ///< every free block starts with the pointer to the next one
+    std::size_t m_numUsed{ 0 };
+  };
+
+  /** \brief A PoolAllocator for the objects of type T, constructed and destroyed through it */
+  template<typename T>
+  class ObjectPool
+  {
+  public:
+    explicit ObjectPool(std::size_t _objectsPerPage = 256, MemoryTag _tag = MEMORY_GENERAL) :
+      m_pool(sizeof(T), alignof(T), _objectsPerPage, _tag)
+    {
+    }
+
+    template<typename... TArgs>
+    T* Create(TArgs&&... _args)
+    {
+      void* memory = m_pool.Allocate();
+      try
+      {
+        return new (memory) T(std::forward<TArgs>(_args)...);
+      }
+      catch (...)
+      {
+        m_pool.Free(memory);
+        throw;
+      }
+    }
+    void Destroy(T* _object)
+    {
+      if (_object)
+      {
+        _object->~T();
+        m_pool.Free(_object);
+      }
+    }
+
+    std::size_t GetNumUsed() const noexcept { return m_pool.GetNumUsed(); }
+
+  private:
+    PoolAllocator m_pool;
+  };
+}
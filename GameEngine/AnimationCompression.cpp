@@ -0,0 +1,178 @@
+#include "AnimationCompression.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace GameEngine
+{
+  namespace
+  {
+    //the smallest three components of a unit quaternion are within +-1/sqrt(2)
+    constexpr float PACKED_RANGE = 0.707106781f;
+    constexpr float PACKED_STEPS = 32767.0f;
+    //how far off its spot a key may be for the keys to count as evenly spaced (in intervals)
+    constexpr float UNIFORM_SLACK = 0.001f;
+
+    float Difference(const glm::vec3& _a, const glm::vec3& _b)
+    {
+      return std::max(std::abs(_a.x - _b.x), std::max(std::abs(_a.y - _b.y), std::abs(_a.z - _b.z)));
+    }
+    float Difference(const glm::quat& _a, const glm::quat& _b)
+    {
+      //q and -q are the same rotation
+      const float sign = glm::dot(_a, _b) < 0.0f ? -1.0f : 1.0f;
+      return std::max(std::max(std::abs(_a.x - sign * _b.x), std::abs(_a.y - sign * _b.y)),
+        std::max(std::abs(_a.z - sign * _b.z), std::abs(_a.w - sign * _b.w)));
+    }
+
+    //the same interpolations as the evaluation in AnimationInstance
+    glm::vec3 Interpolate(const glm::vec3& _a, const glm::vec3& _b, float _factor) { return _a + (_b - _a) * _factor; }
+    glm::quat Interpolate(const glm::quat& _a, const glm::quat& _b, float _factor) { return glm::normalize(glm::slerp(_a, _b, _factor)); }
+
+    glm::vec3 ToValue(const aiVector3D& _value) { return glm::vec3(_value.x, _value.y, _value.z); }
+    glm::quat ToValue(const aiQuaternion& _value) { return glm::normalize(glm::quat(_value.w, _value.x, _value.y, _value.z)); }
+
+    glm::vec3 ToStored(const glm::vec3& _value) { return _value; }
+    PackedQuat ToStored(const glm::quat& _value) { return PackQuat(_value); }
+
+    //the indices of the keys kept by the reduction: from the last kept key the next one is pushed on as long as
+    //the interpolation between them rebuilds all the keys in between within _tolerance, the first and the last key are always kept
+    template <typename Value>
+    std::vector<GLuint> ReduceKeys(const std::vector<float>& _times, const std::vector<Value>& _values, float _tolerance)
+    {
+      std::vector<GLuint> kept{ 0 };
+      const GLuint lastKey = _values.size() - 1;
+      GLuint start = 0;
+      for (GLuint end = 2; end <= lastKey; end++)
+      {
+        for (GLuint i = start + 1; i < end; i++)
+        {
+          const float factor = (_times[i] - _times[start]) / (_times[end] - _times[start]);
+          if (Difference(Interpolate(_values[start], _values[end], factor), _values[i]) > _tolerance)
+          {
+            //the key before end is needed, the next span starts from it
+            start = end - 1;
+            kept.push_back(start);
+            break;
+          }
+        }
+      }
+      if (lastKey > 0)
+      {
+        kept.push_back(lastKey);
+      }
+      return kept;
+    }
+
+    template <typename Key, typename Stored>
+    void Compress(const Key* _keys, GLuint _numKeys, float _tolerance, AnimationTrack<Stored>& _track)
+    {
+      _track = AnimationTrack<Stored>();
+      if (_numKeys == 0)
+      {
+        return;
+      }
+
+      std::vector<float> times(_numKeys);
+      std::vector<decltype(ToValue(_keys[0].mValue))> values(_numKeys);
+      for (GLuint i = 0; i < _numKeys; i++)
+      {
+        times[i] = (float)_keys[i].mTime;
+        values[i] = ToValue(_keys[i].mValue);
+      }
+
+      std::vector<GLuint> kept = ReduceKeys(times, values, _tolerance);
+      if (kept.size() == 1 || (kept.size() == 2 && Difference(values[0], values[kept[1]]) <= _tolerance))
+      {
+        //doesn't move, a constant track
+        _track.m_values.push_back(ToStored(values[0]));
+        return;
+      }
+
+      bool uniform = true;
+      const float interval = (times.back() - times.front()) / (_numKeys - 1);
+      for (GLuint i = 0; i < _numKeys && uniform; i++)
+      {
+        uniform = interval > 0.0f && std::abs(times[i] - (times.front() + i * interval)) <= UNIFORM_SLACK * interval;
+      }
+
+      //a uniform track doesn't keep the times, so it's smaller per key
+      if (uniform && _numKeys * sizeof(Stored) <= kept.size() * (sizeof(Stored) + sizeof(float)))
+      {
+        _track.m_start = times.front();
+        _track.m_interval = interval;
+        _track.m_values.reserve(_numKeys);
+        for (GLuint i = 0; i < _numKeys; i++)
+        {
+          _track.m_values.push_back(ToStored(values[i]));
+        }
+        return;
+      }
+
+      _track.m_values.reserve(kept.size());
+      _track.m_times.reserve(kept.size());
+      for (GLuint i : kept)
+      {
+        _track.m_values.push_back(ToStored(values[i]));
+        _track.m_times.push_back(times[i]);
+      }
+    }
+  }
+
+  PackedQuat PackQuat(const glm::quat& _rotation)
+  {
+    float components[4] = { _rotation.x, _rotation.y, _rotation.z, _rotation.w };
+    GLuint largest = 0;
+    for (GLuint i = 1; i < 4; i++)
+    {
+      if (std::abs(components[i]) > std::abs(components[largest]))
+      {
+        largest = i;
+      }
+    }
+    //the dropped component has to be positive, the negated quaternion is the same rotation
+    const float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+    PackedQuat packed;
+    for (GLuint i = 0, slot = 0; i < 4; i++)
+    {
+      if (i == largest)
+      {
+        continue;
+      }
+      const float normalized = (std::min(std::max(sign * components[i], -PACKED_RANGE), PACKED_RANGE) + PACKED_RANGE) / (2.0f * PACKED_RANGE);
+      packed.m_bits[slot++] = static_cast<std::uint16_t>(normalized * PACKED_STEPS + 0.5f);
+    }
+    packed.m_bits[0] |= static_cast<std::uint16_t>((largest & 1) << 15);
+    packed.m_bits[1] |= static_cast<std::uint16_t>((largest >> 1) << 15);
+    return packed;
+  }
+
+  glm::quat UnpackQuat(const PackedQuat& _packed)
+  {
+    const GLuint largest = (_packed.m_bits[0] >> 15) | ((_packed.m_bits[1] >> 15) << 1);
+    float components[4];
+    float sum = 0.0f;
+    for (GLuint i = 0, slot = 0; i < 4; i++)
+    {
+      if (i == largest)
+      {
+        continue;
+      }
+      components[i] = (_packed.m_bits[slot++] & 0x7FFF) / PACKED_STEPS * 2.0f * PACKED_RANGE - PACKED_RANGE;
+      sum += components[i] * components[i];
+    }
+    components[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+    return glm::quat(components[3], components[0], components[1], components[2]);
+  }
+
+  void CompressTrack(const aiVectorKey* _keys, GLuint _numKeys, float _tolerance, AnimationTrack<glm::vec3>& _track)
+  {
+    Compress(_keys, _numKeys, _tolerance, _track);
+  }
+
+  void CompressTrack(const aiQuatKey* _keys, GLuint _numKeys, float _tolerance, AnimationTrack<PackedQuat>& _track)
+  {
+    Compress(_keys, _numKeys, _tolerance, _track);
+  }
+}
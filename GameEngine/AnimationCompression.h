@@ -0,0 +1,50 @@
+#pragma once
+
+#include <GL\glew.h>
+#include <assimp\anim.h>
+#include <glm\vec3.hpp>
+#include <glm\gtc\quaternion.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace GameEngine
+{
+  /** \brief A unit quaternion in 6 bytes: its three smallest components, 15 bits each, the fourth follows from the unit length.
+  * The index of the dropped (largest) component is in the top bits of the first two, its sign is always made positive */
+  struct PackedQuat
+  {
+    std::uint16_t m_bits[3];
+  };
+
+  PackedQuat PackQuat(const glm::quat& _rotation);
+  glm::quat UnpackQuat(const PackedQuat& _packed);
+
+  /** \brief The compressed keys of one property (position, rotation or scaling) of a channel.
+  * A uniform track has a key every m_interval ticks from m_start and stores no times, so the key at a time is found without a search.
+  * A keyed track only has the keys which the interpolation of the keys around them couldn't rebuild within the error threshold, with their times.
+  * A track with one value is constant */
+  template <typename Value>
+  struct AnimationTrack
+  {
+    std::vector<Value> m_values;
+    std::vector<float> m_times; ///< empty for a uniform track
+    float m_start{ 0.0f };      ///< uniform only, the time of the first value
+    float m_interval{ 0.0f };   ///< uniform only, the ticks between two values
+
+    bool IsUniform() const noexcept { return m_times.empty(); }
+    size_t GetMemorySize() const noexcept { return m_values.size() * sizeof(Value) + m_times.size() * sizeof(float); }
+  };
+
+  /** \brief The largest error a removed key may have, in the units of the property (rotations by quaternion component) */
+  struct AnimationCompressionSettings
+  {
+    float m_positionTolerance{ 0.001f };
+    float m_rotationTolerance{ 0.0005f };
+    float m_scalingTolerance{ 0.001f };
+  };
+
+  /** \brief Compresses the loaded keys of a property into _track, it keeps the evenly spaced keys as a uniform track
+  * unless the keyframe reduction makes the keyed track smaller */
+  void CompressTrack(const aiVectorKey* _keys, GLuint _numKeys, float _tolerance, AnimationTrack<glm::vec3>& _track);
+  void CompressTrack(const aiQuatKey* _keys, GLuint _numKeys, float _tolerance, AnimationTrack<PackedQuat>& _track);
+}
@@ -0,0 +1,130 @@
+#include "AnimationSystem.h"
+#include "FrameStats.h"
+#include "Model.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+namespace GameEngine
+{
+  //the models one worker takes at a time, evaluating a pose is a few hundred matrix products
+  constexpr std::size_t MODELS_PER_CHUNK = 8;
+
+  void AnimationSystem::Init()
+  {
+    if (m_boneBuffer == 0)
+    {
+      glGenBuffers(1, &m_boneBuffer);
+      //the start of every palette has to be aligned for glBindBufferRange
+      GLint alignment = 256;
+      glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+      const std::size_t paletteBytes = SkeletonAsset::MAX_BONES * sizeof(glm::mat4);
+      const std::size_t strideBytes = (paletteBytes + alignment - 1) / static_cast<std::size_t>(alignment) * alignment;
+      m_paletteStride = (strideBytes + sizeof(glm::mat4) - 1) / sizeof(glm::mat4);
+      m_skinningMatrices.resize(m_models.size() * m_paletteStride, glm::mat4(1.0f));
+    }
+  }
+
+  void AnimationSystem::Dispose()
+  {
+    if (m_boneBuffer != 0)
+    {
+      glDeleteBuffers(1, &m_boneBuffer);
+      m_boneBuffer = 0;
+    }
+    m_models.clear();
+    m_skinningMatrices.clear();
+  }
+
+  void AnimationSystem::Add(SkinnedModel* _model)
+  {
+    m_models.push_back(_model);
+    m_skinningMatrices.resize(m_models.size() * m_paletteStride, glm::mat4(1.0f));
+  }
+
+  void AnimationSystem::Remove(SkinnedModel* _model)
+  {
+    auto it = std::find(m_models.begin(), m_models.end(), _model);
+    if (it != m_models.end())
+    {
+      m_models.erase(it);
+      m_skinningMatrices.resize(m_models.size() * m_paletteStride);
+    }
+  }
+  void AnimationSystem::Update(float _elapsed)
+  {
+    PROFILE_SCOPE("AnimationSystem::Update");
+    //the models only share their (read only) assets, so the workers (and this thread) can update any of them
+    JobSystem::Get().ParallelFor(m_models.size(), MODELS_PER_CHUNK, [this, _elapsed](std::size_t _begin, std::size_t _end)
+    {
+      UpdateRange(_begin, _end, _elapsed);
+    });
+
+    //one upload for all the models
+    if (m_boneBuffer != 0 && !m_skinningMatrices.empty())
+    {
+      glBindBuffer(GL_UNIFORM_BUFFER, m_boneBuffer);
+      FrameStats::Get().Add(STAT_BYTES_UPLOADED, m_skinningMatrices.size() * sizeof(glm::mat4));
+      glBufferData(GL_UNIFORM_BUFFER, m_skinningMatrices.size() * sizeof(glm::mat4), m_skinningMatrices.data(), GL_STREAM_DRAW);
+      glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+  }
+
+  void AnimationSystem::UpdateRange(std::size_t _begin, std::size_t _end, float _elapsed)
+  {
+    for (std::size_t i = _begin; i < _end; i++)
+    {
+      SkinnedModel& model = *m_models[i];
+      model.Update(_elapsed);
+      if (m_paletteStride == 0)
+      {
+        //not initialized, so there is no buffer to gather into
+        continue;
+      }
+      const std::vector<glm::mat4>& pose = model.m_animation.GetPose();
+      std::copy(pose.begin(), pose.begin() + std::min<std::size_t>(pose.size(), SkeletonAsset::MAX_BONES),
+        m_skinningMatrices.begin() + i * m_paletteStride);
+    }
+  }
+
+  void AnimationSystem::Draw(GLSLProgram& _shader)
+  {
+    if (m_boneBuffer == 0)
+    {
+      return;
+    }
+    //the program bound its BonePalette block to BONE_PALETTE_BINDING when it linked
+    for (std::size_t i = 0; i < m_models.size(); i++)
+    {
+      BindPalette(i);
+      m_models[i]->DrawMeshes(_shader);
+    }
+    glBindBufferBase(GL_UNIFORM_BUFFER, BONE_PALETTE_BINDING, 0);
+  }
+
+  void AnimationSystem::Draw(GLSLProgram& _shader, const Camera3D& _camera)
+  {
+    if (m_boneBuffer == 0)
+    {
+      return;
+    }
+    for (std::size_t i = 0; i < m_models.size(); i++)
+    {
+      BindPalette(i);
+      m_models[i]->DrawMeshes(_shader, _camera);
+    }
+    glBindBufferBase(GL_UNIFORM_BUFFER, BONE_PALETTE_BINDING, 0);
+  }
+
+  bool AnimationSystem::BindPalette(std::size_t _index) const
+  {
+    if (m_boneBuffer == 0)
+    {
+      return false;
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, BONE_PALETTE_BINDING, m_boneBuffer, _index * m_paletteStride * sizeof(glm::mat4),
+      SkeletonAsset::MAX_BONES * sizeof(glm::mat4));
+    return true;
+  }
+}
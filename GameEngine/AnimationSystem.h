@@ -0,0 +1,58 @@
+#pragma once
+
+#include <GL\glew.h>
+#include <glm\mat4x4.hpp>
+#include <vector>
+
+namespace GameEngine
+{
+  class SkinnedModel;
+  class GLSLProgram;
+  class Camera3D;
+
+  /** Updates the animations of all the added skinned models at once, spread over worker threads, and gathers their poses
+  * into one contiguous uniform buffer of bone palettes which is uploaded to the GPU once per frame.
+  * Model i owns palette i (SkeletonAsset::MAX_BONES matrices, padded to the uniform buffer offset alignment of the GPU).
+  * Draw binds the palette of every model to the std140 uniform block "BonePalette" (holding mat4 gBones[MAX_BONES]),
+  * so a draw costs one buffer range bind instead of uploading the matrices */
+  class AnimationSystem
+  {
+  public:
+    AnimationSystem() {}
+    ~AnimationSystem() { Dispose(); }
+
+    //creates the GPU buffer of the skinning matrices
+    void Init();
+    void Dispose();
+
+    //the models stay owned by the caller, they have to be removed before they're destroyed
+    void Add(SkinnedModel* _model);
+    void Remove(SkinnedModel* _model);
+
+    //updates every model to _elapsed (see SkinnedModel::Update) and uploads the skinning matrices
+    void Update(float _elapsed);
+
+    //draws all the models with _shader, which reads the skinning matrices from the BonePalette block instead of a gBones uniform
+    void Draw(GLSLProgram& _shader);
+    //same as Draw, every model at the LOD for its size on the screen of _camera (see SkinnedModel::SetLodScreenSize)
+    void Draw(GLSLProgram& _shader, const Camera3D& _camera);
+
+    //the uniform buffer binding point of the BonePalette block
+    enum : GLuint { BONE_PALETTE_BINDING = 1 };
+
+    std::size_t GetNumModels() const noexcept { return m_models.size(); }
+    const std::vector<SkinnedModel*>& GetModels() const noexcept { return m_models; }
+    //binds the palette of model _index to BONE_PALETTE_BINDING, false before Init
+    bool BindPalette(std::size_t _index) const;
+    const std::vector<glm::mat4>& GetSkinningMatrices() const noexcept { return m_skinningMatrices; }
+
+  private:
+    //updates models [_begin, _end) and copies their poses into their ranges of the buffer
+    void UpdateRange(std::size_t _begin, std::size_t _end, float _elapsed);
+
+    std::vector<SkinnedModel*> m_models;
+    std::vector<glm::mat4> m_skinningMatrices; ///< the palettes of all the models, back to back in the order of m_models
+    std::size_t m_paletteStride{ 0 }; ///< the matrices from one palette to the next (MAX_BONES and the alignment padding)
+    GLuint m_boneBuffer{ 0 }; ///< the GL_UNIFORM_BUFFER holding m_skinningMatrices
+  };
+}
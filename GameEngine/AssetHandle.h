@@ -0,0 +1,33 @@
+#pragma once
+#include <memory>
+
+namespace GameEngine
+{
+  /** \brief A counted reference to an asset loaded by the ResourceManager. Copies share the asset, which is freed (its GPU data too)
+  * when the last handle to it is reset or destroyed; the cache itself doesn't keep it alive. An empty handle is what a failed load returns */
+  template <typename T>
+  class Handle
+  {
+  public:
+    Handle() {}
+    explicit Handle(std::shared_ptr<T> _asset) : m_asset(std::move(_asset)) {}
+
+    T* operator->() const { return m_asset.get(); }
+    T& operator*() const  { return *m_asset; }
+    T* Get() const        { return m_asset.get(); }
+
+    bool IsValid() const           { return m_asset != nullptr; }
+    explicit operator bool() const { return m_asset != nullptr; }
+
+    /** \brief The handles sharing the asset, including this one (0 for an empty handle) */
+    long GetUseCount() const { return m_asset.use_count(); }
+
+    /** \brief Lets go of the asset, it's freed if this was its last handle */
+    void Reset() { m_asset.reset(); }
+
+    bool operator==(const Handle& _other) const { return m_asset == _other.m_asset; }
+    bool operator!=(const Handle& _other) const { return m_asset != _other.m_asset; }
+  private:
+    std::shared_ptr<T> m_asset;
+  };
+}
@@ -0,0 +1,52 @@
+#include "AssetId.h"
+#include "GameEngineErrors.h"
+
+#include <unordered_map>
+
+namespace GameEngine
+{
+  namespace
+  {
+    //node based, the names GetName returns never move
+    std::unordered_map<AssetId, std::string>& GetNames()
+    {
+      static std::unordered_map<AssetId, std::string> names;
+      return names;
+    }
+  }
+
+  AssetId AssetIds::Hash(const std::string& _name)
+  {
+    //64-bit FNV-1a
+    AssetId hash = 14695981039346656037ull;
+    for (char c : _name)
+    {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 1099511628211ull;
+    }
+    //0 is NONE, and the empty slot of an AssetMap
+    return hash != NONE ? hash : 1;
+  }
+
+  AssetId AssetIds::Intern(const std::string& _name)
+  {
+    const AssetId id = Hash(_name);
+    std::string& name = GetNames()[id];
+    if (name.empty())
+    {
+      name = _name;
+    }
+    else if (name != _name)
+    {
+      FatalError("The asset names " + name + " and " + _name + " have the same id");
+    }
+    return id;
+  }
+
+  const std::string& AssetIds::GetName(AssetId _id)
+  {
+    static const std::string none;
+    auto it = GetNames().find(_id);
+    return it != GetNames().end() ? it->second : none;
+  }
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace GameEngine
+{
+  /** \brief The 64-bit hash of an asset path (or another name, like a texture type), see AssetIds. 0 is no asset */
+  typedef std::uint64_t AssetId;
+
+  /** \brief Interns the asset names: the caches and textures carry the AssetId, the name is only kept once here for the code which
+  * needs it back (loading, saving, messages). Interning happens on the main thread, like the loads that do it */
+  class AssetIds
+  {
+  public:
+    static constexpr AssetId NONE{ 0 };
+
+    /** \brief The id of _name (FNV-1a), without remembering the name, e.g. to compare with an id */
+    static AssetId Hash(const std::string& _name);
+    /** \brief The id of _name, remembering the name for GetName. Two names with one id are a fatal error */
+    static AssetId Intern(const std::string& _name);
+    /** \brief The name _id was interned from, empty for NONE or an id that never was */
+    static const std::string& GetName(AssetId _id);
+  };
+}
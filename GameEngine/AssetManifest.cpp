@@ -0,0 +1,121 @@
+#include "AssetManifest.h"
+#include "IOManager.h"
+#include "ModelCooker.h"
+
+#include <iostream>
+#include <sstream>
+
+namespace GameEngine
+{
+  size_t AssetManifest::Add(AssetType _type, const std::string& _path, bool _alpha)
+  {
+    size_t& index = m_indices[AssetIds::Hash(_path)];
+    if (index == 0)
+    {
+      Asset asset;
+      asset.type = _type;
+      asset.path = _path;
+      asset.alpha = _alpha;
+      m_assets.push_back(asset);
+      index = m_assets.size();
+    }
+    return index - 1;
+  }
+
+  bool AssetManifest::Load(const std::string& _manifestPath)
+  {
+    //an include cycle, or a manifest included twice, stops here
+    bool& loaded = m_loadedManifests[AssetIds::Hash(_manifestPath)];
+    if (loaded)
+    {
+      return true;
+    }
+    loaded = true;
+
+    std::string text;
+    if (!IOManager::ReadFileToBuffer(_manifestPath, text))
+    {
+      return false;
+    }
+    std::istringstream lines(text);
+    std::string line;
+    for (int number = 1; std::getline(lines, line); number++)
+    {
+      //the keyword, then the rest of the line is the path (they may have spaces)
+      const size_t keywordStart = line.find_first_not_of(" \t\r");
+      if (keywordStart == std::string::npos || line[keywordStart] == '#')
+      {
+        continue;
+      }
+      const size_t keywordEnd = line.find_first_of(" \t", keywordStart);
+      const size_t pathStart = keywordEnd != std::string::npos ? line.find_first_not_of(" \t", keywordEnd) : std::string::npos;
+      const size_t pathEnd = line.find_last_not_of(" \t\r");
+      const std::string keyword = line.substr(keywordStart, keywordEnd - keywordStart);
+      const std::string path = pathStart != std::string::npos ? line.substr(pathStart, pathEnd + 1 - pathStart) : std::string();
+
+      bool known = !path.empty();
+      if (keyword == "texture" || keyword == "opaque_texture")
+      {
+        Add(AssetType::TEXTURE, path, keyword == "texture");
+      }
+      else if (keyword == "model")
+      {
+        Add(AssetType::STATIC_MODEL, path);
+      }
+      else if (keyword == "skinned")
+      {
+        Add(AssetType::SKINNED_MODEL, path);
+      }
+      else if (keyword == "sound")
+      {
+        Add(AssetType::SOUND_EFFECT, path);
+      }
+      else if (keyword == "music")
+      {
+        Add(AssetType::MUSIC, path);
+      }
+      else if (keyword == "include")
+      {
+        known = known && Load(path);
+      }
+      else
+      {
+        known = false;
+      }
+      if (!known)
+      {
+        std::cout << "ERROR::ASSET_MANIFEST::" << _manifestPath << " line " << number << ": " << line << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void AssetManifest::ResolveDependencies()
+  {
+    //the textures added here are appended, they have no dependencies of their own
+    const size_t numAssets = m_assets.size();
+    for (size_t i = 0; i < numAssets; i++)
+    {
+      const AssetType type = m_assets[i].type;
+      if (type != AssetType::STATIC_MODEL && type != AssetType::SKINNED_MODEL)
+      {
+        continue;
+      }
+      const std::string cookedPath = ModelCooker::GetCookedPath(m_assets[i].path);
+      std::vector<std::string> texturePaths;
+      if (!IOManager::IsNewerThan(cookedPath, m_assets[i].path) ||
+        !ModelCooker::ReadTexturePaths(cookedPath, type == AssetType::SKINNED_MODEL, texturePaths))
+      {
+        continue;
+      }
+      std::vector<size_t> dependencies;
+      for (const auto& path : texturePaths)
+      {
+        //the models load their textures with alpha (see AssimpLoader), the preload has to match
+        dependencies.push_back(Add(AssetType::TEXTURE, path, true));
+      }
+      m_assets[i].dependencies = dependencies;
+    }
+  }
+}
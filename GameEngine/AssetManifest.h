@@ -0,0 +1,69 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "AssetHandle.h"
+#include "AssetMap.h"
+
+namespace GameEngine
+{
+  struct GLTexture;
+  class StaticModel;
+  class SkeletonAsset;
+
+  /** \brief The assets a screen (or a level) needs, so ResourceManager::Preload can load all of them before it starts instead of
+  * stalling on each one the first time the code touches it. It's a dependency graph: a model depends on the textures of its
+  * materials (see ResolveDependencies), which load with it, and a manifest file can include others, e.g. a screen the one of its level.
+  * A manifest file has one asset a line, # starts a comment:
+  *   texture Assets/Objects/coin_sheet.png
+  *   opaque_texture Assets/Tiles/MetalTexture.png    (loaded without alpha)
+  *   model Assets/Box/box.obj                        (shared, see ResourceManager::LoadStaticModel)
+  *   skinned Assets/MD5/Bob.md5mesh
+  *   sound Sound/Jump.ogg
+  *   music Sound/NoHope.ogg
+  *   include Levels/Level2.manifest */
+  class AssetManifest
+  {
+  public:
+    enum class AssetType { TEXTURE, STATIC_MODEL, SKINNED_MODEL, SOUND_EFFECT, MUSIC };
+
+    struct Asset
+    {
+      AssetType type;
+      std::string path;
+      bool alpha{ true };               ///< textures only
+      std::vector<size_t> dependencies; ///< the assets it loads itself, indices into GetAssets
+    };
+
+    /** \brief Adds the asset once, an asset added again only gets its index back */
+    size_t Add(AssetType _type, const std::string& _path, bool _alpha = true);
+    /** \brief Adds the assets of the manifest file and of the ones it includes, every file is read once. False if one is missing or
+    * has a line it doesn't know */
+    bool Load(const std::string& _manifestPath);
+    /** \brief Adds the textures of the models as their dependencies, from their cooked files. A model not cooked yet has none, its
+    * textures are only known once it's imported */
+    void ResolveDependencies();
+
+    const std::vector<Asset>& GetAssets() const noexcept { return m_assets; }
+  private:
+    std::vector<Asset> m_assets;
+    AssetMap<size_t> m_indices;        ///< by path hash, the index of the asset + 1
+    AssetMap<bool> m_loadedManifests;
+  };
+
+  /** \brief Keeps the assets of a preloaded manifest loaded (see ResourceManager::Preload), e.g. a screen from OnEntry to OnExit */
+  struct PreloadedAssets
+  {
+    std::vector<Handle<GLTexture>> textures;
+    std::vector<Handle<StaticModel>> models;
+    std::vector<Handle<SkeletonAsset>> skeletons;
+
+    /** \brief Lets go of the assets, the ones nothing else uses are freed */
+    void Release()
+    {
+      textures.clear();
+      models.clear();
+      skeletons.clear();
+    }
+  };
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <utility>
+#include <vector>
+
+#include "AssetId.h"
+
+namespace GameEngine
+{
+  /** \brief A flat hash map from AssetId to T, for the asset caches. The ids are hashes already, so their low bits pick the slot and
+  * collisions probe the next slots (linear probing), all in one array. Nothing is erased, the caches only clear it; growing moves the
+  * values, so pointers from Find are valid until the next insert */
+  template <typename T>
+  class AssetMap
+  {
+  public:
+    /** \brief The value of _id, nullptr if there's none */
+    T* Find(AssetId _id)
+    {
+      if (m_slots.empty())
+      {
+        return nullptr;
+      }
+      Slot& slot = m_slots[IndexOf(_id)];
+      return slot.id == _id ? &slot.value : nullptr;
+    }
+    const T* Find(AssetId _id) const
+    {
+      return const_cast<AssetMap*>(this)->Find(_id);
+    }
+
+    /** \brief The value of _id, default constructed if there wasn't one. _id can't be AssetIds::NONE, that marks the empty slots */
+    T& operator[](AssetId _id)
+    {
+      //grow at 3/4 full, the probes stay short
+      if ((m_size + 1) * 4 > m_slots.size() * 3)
+      {
+        Grow();
+      }
+      Slot& slot = m_slots[IndexOf(_id)];
+      if (slot.id != _id)
+      {
+        slot.id = _id;
+        m_size++;
+      }
+      return slot.value;
+    }
+
+    /** \brief Calls _function(id, value) for every value, in no particular order */
+    template <typename F>
+    void ForEach(F _function)
+    {
+      for (Slot& slot : m_slots)
+      {
+        if (slot.id != AssetIds::NONE)
+        {
+          _function(slot.id, slot.value);
+        }
+      }
+    }
+
+    void Clear()
+    {
+      m_slots.clear();
+      m_size = 0;
+    }
+    size_t Size() const noexcept { return m_size; }
+
+  private:
+    struct Slot
+    {
+      AssetId id{ AssetIds::NONE };
+      T value{};
+    };
+
+    /** \brief The slot holding _id, or the empty one where it would go */
+    size_t IndexOf(AssetId _id) const
+    {
+      const size_t mask = m_slots.size() - 1;
+      size_t index = static_cast<size_t>(_id) & mask;
+      while (m_slots[index].id != _id && m_slots[index].id != AssetIds::NONE)
+      {
+        index = (index + 1) & mask;
+      }
+      return index;
+    }
+
+    void Grow()
+    {
+      //a power of two, so the index is a mask of the id
+      std::vector<Slot> old(m_slots.empty() ? 16 : m_slots.size() * 2);
+      old.swap(m_slots);
+      for (Slot& slot : old)
+      {
+        if (slot.id != AssetIds::NONE)
+        {
+          m_slots[IndexOf(slot.id)] = std::move(slot);
+        }
+      }
+    }
+
+    std::vector<Slot> m_slots;
+    size_t m_size{ 0 };
+  };
+}
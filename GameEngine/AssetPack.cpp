@@ -0,0 +1,330 @@
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace GameEngine
+{
+  namespace
+  {
+    const std::uint32_t PACK_MAGIC = 0x4B415047; ///< GPAK
+    const std::uint32_t PACK_VERSION = 1;
+
+    struct PackHeader
+    {
+      std::uint32_t magic;
+      std::uint32_t version;
+      std::uint32_t numEntries;
+      std::uint32_t padding;
+      std::uint64_t tocOffset; ///< the PackEntry array, sorted by id
+      std::uint64_t reserved;
+    };
+
+    //the LZ4 block format: sequences of literals followed by a match (offset and length) into the bytes before them
+    const size_t LZ4_MIN_MATCH = 4;
+    const size_t LZ4_LAST_LITERALS = 5;  ///< the block ends with literals
+    const size_t LZ4_MATCH_LIMIT = 12;   ///< no match starts this close to the end
+    const size_t LZ4_MAX_OFFSET = 65535;
+    const unsigned int LZ4_HASH_BITS = 12;
+
+    std::uint32_t Read32(const unsigned char* _data)
+    {
+      std::uint32_t value;
+      std::memcpy(&value, _data, 4);
+      return value;
+    }
+
+    void WriteLength(std::vector<unsigned char>& _out, size_t _length)
+    {
+      //a nibble of 15 continues in bytes, 255 continues further
+      for (; _length >= 255; _length -= 255)
+      {
+        _out.push_back(255);
+      }
+      _out.push_back(static_cast<unsigned char>(_length));
+    }
+
+    void WriteSequence(std::vector<unsigned char>& _out, const unsigned char* _literals, size_t _numLiterals, size_t _offset, size_t _matchLength)
+    {
+      const bool last = _matchLength == 0;
+      const size_t matchCode = last ? 0 : _matchLength - LZ4_MIN_MATCH;
+      _out.push_back(static_cast<unsigned char>((std::min<size_t>(_numLiterals, 15) << 4) | std::min<size_t>(matchCode, 15)));
+      if (_numLiterals >= 15)
+      {
+        WriteLength(_out, _numLiterals - 15);
+      }
+      _out.insert(_out.end(), _literals, _literals + _numLiterals);
+      if (last)
+      {
+        return;
+      }
+      _out.push_back(static_cast<unsigned char>(_offset & 0xFF));
+      _out.push_back(static_cast<unsigned char>(_offset >> 8));
+      if (matchCode >= 15)
+      {
+        WriteLength(_out, matchCode - 15);
+      }
+    }
+
+    //greedy, one candidate per hash of the next 4 bytes: fast and good enough for a pack built once
+    void CompressLZ4(const unsigned char* _data, size_t _size, std::vector<unsigned char>& _out)
+    {
+      _out.clear();
+      std::vector<size_t> table(size_t(1) << LZ4_HASH_BITS, SIZE_MAX);
+      size_t anchor = 0;
+      size_t position = 0;
+      while (_size > LZ4_MATCH_LIMIT && position + LZ4_MATCH_LIMIT <= _size)
+      {
+        const std::uint32_t sequence = Read32(_data + position);
+        const size_t hash = (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+        const size_t candidate = table[hash];
+        table[hash] = position;
+        if (candidate == SIZE_MAX || position - candidate > LZ4_MAX_OFFSET || Read32(_data + candidate) != sequence)
+        {
+          position++;
+          continue;
+        }
+        size_t length = LZ4_MIN_MATCH;
+        while (position + length < _size - LZ4_LAST_LITERALS && _data[candidate + length] == _data[position + length])
+        {
+          length++;
+        }
+        WriteSequence(_out, _data + anchor, position - anchor, position - candidate, length);
+        position += length;
+        anchor = position;
+      }
+      WriteSequence(_out, _data + anchor, _size - anchor, 0, 0);
+    }
+
+    bool ReadLength(const unsigned char*& _in, const unsigned char* _end, size_t& _length)
+    {
+      unsigned char byte = 255;
+      while (byte == 255)
+      {
+        if (_in == _end)
+        {
+          return false;
+        }
+        byte = *_in++;
+        _length += byte;
+      }
+      return true;
+    }
+
+    //checks every length and offset, a broken pack fails instead of writing out of _out
+    bool DecompressLZ4(const unsigned char* _in, size_t _inSize, unsigned char* _out, size_t _outSize)
+    {
+      const unsigned char* inEnd = _in + _inSize;
+      unsigned char* out = _out;
+      unsigned char* outEnd = _out + _outSize;
+      while (_in < inEnd)
+      {
+        const unsigned char token = *_in++;
+        size_t numLiterals = token >> 4;
+        if (numLiterals == 15 && !ReadLength(_in, inEnd, numLiterals))
+        {
+          return false;
+        }
+        if (numLiterals > static_cast<size_t>(inEnd - _in) || numLiterals > static_cast<size_t>(outEnd - out))
+        {
+          return false;
+        }
+        std::memcpy(out, _in, numLiterals);
+        _in += numLiterals;
+        out += numLiterals;
+        //the last sequence has no match
+        if (_in == inEnd)
+        {
+          break;
+        }
+        if (inEnd - _in < 2)
+        {
+          return false;
+        }
+        const size_t offset = _in[0] | (_in[1] << 8);
+        _in += 2;
+        size_t length = token & 15;
+        if (length == 15 && !ReadLength(_in, inEnd, length))
+        {
+          return false;
+        }
+        length += LZ4_MIN_MATCH;
+        if (offset == 0 || offset > static_cast<size_t>(out - _out) || length > static_cast<size_t>(outEnd - out))
+        {
+          return false;
+        }
+        //byte by byte, a match may overlap the bytes it writes
+        const unsigned char* match = out - offset;
+        for (size_t i = 0; i < length; i++)
+        {
+          out[i] = match[i];
+        }
+        out += length;
+      }
+      return out == outEnd;
+    }
+
+    void CollectFiles(const std::string& _directory, std::vector<std::string>& _filePaths)
+    {
+      std::vector<DirEntry> entries;
+      if (!IOManager::GetDirectoryEntries(_directory.c_str(), entries))
+      {
+        return;
+      }
+      for (const auto& entry : entries)
+      {
+        if (entry.isDirectory)
+        {
+          CollectFiles(entry.path, _filePaths);
+        }
+        else
+        {
+          _filePaths.push_back(entry.path);
+        }
+      }
+    }
+  }
+
+  bool AssetPack::Open(const std::string& _packPath)
+  {
+    Close();
+    //the pack itself is always a loose file
+    if (!m_file.OpenLoose(_packPath) || m_file.GetSize() < sizeof(PackHeader))
+    {
+      m_file.Close();
+      return false;
+    }
+    PackHeader header;
+    std::memcpy(&header, m_file.GetData(), sizeof(header));
+    if (header.magic != PACK_MAGIC || header.version != PACK_VERSION || header.tocOffset % alignof(PackEntry) != 0 ||
+      header.tocOffset > m_file.GetSize() || (m_file.GetSize() - header.tocOffset) / sizeof(PackEntry) < header.numEntries)
+    {
+      m_file.Close();
+      return false;
+    }
+    m_entries = reinterpret_cast<const PackEntry*>(m_file.GetData() + header.tocOffset);
+    m_numEntries = header.numEntries;
+    return true;
+  }
+
+  void AssetPack::Close()
+  {
+    m_file.Close();
+    m_entries = nullptr;
+    m_numEntries = 0;
+  }
+
+  const PackEntry* AssetPack::Find(const std::string& _filePath) const
+  {
+    const AssetId id = AssetIds::Hash(NormalizePath(_filePath));
+    const PackEntry* end = m_entries + m_numEntries;
+    const PackEntry* entry = std::lower_bound(m_entries, end, id, [](const PackEntry& _entry, AssetId _id) { return _entry.id < _id; });
+    return entry != end && entry->id == id ? entry : nullptr;
+  }
+
+  bool AssetPack::GetSpan(const PackEntry& _entry, FileSpan& _span) const
+  {
+    if (_entry.IsCompressed() || _entry.offset + _entry.storedSize > m_file.GetSize())
+    {
+      return false;
+    }
+    _span.data = m_file.GetData() + _entry.offset;
+    _span.size = _entry.size;
+    return true;
+  }
+
+  bool AssetPack::Read(const PackEntry& _entry, std::vector<unsigned char>& _data) const
+  {
+    if (_entry.offset + _entry.storedSize > m_file.GetSize())
+    {
+      return false;
+    }
+    const unsigned char* stored = m_file.GetData() + _entry.offset;
+    if (!_entry.IsCompressed())
+    {
+      _data.assign(stored, stored + _entry.size);
+      return true;
+    }
+    _data.resize(_entry.size);
+    return DecompressLZ4(stored, _entry.storedSize, _data.data(), _data.size());
+  }
+
+  std::string AssetPack::NormalizePath(const std::string& _filePath)
+  {
+    std::string path = _filePath;
+    std::replace(path.begin(), path.end(), '\\', '/');
+    std::transform(path.begin(), path.end(), path.begin(), [](char _c) { return (_c >= 'A' && _c <= 'Z') ? char(_c - 'A' + 'a') : _c; });
+    while (path.compare(0, 2, "./") == 0)
+    {
+      path.erase(0, 2);
+    }
+    return path;
+  }
+
+  bool AssetPack::Build(const std::string& _packPath, const std::vector<std::string>& _directories, bool _compress)
+  {
+    std::vector<std::string> filePaths;
+    for (const auto& directory : _directories)
+    {
+      CollectFiles(directory, filePaths);
+    }
+
+    std::ofstream file(_packPath, std::ios::binary);
+    if (file.fail())
+    {
+      perror(_packPath.c_str());
+      return false;
+    }
+    PackHeader header = {};
+    header.magic = PACK_MAGIC;
+    header.version = PACK_VERSION;
+    header.numEntries = static_cast<std::uint32_t>(filePaths.size());
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<PackEntry> entries;
+    entries.reserve(filePaths.size());
+    std::vector<unsigned char> data;
+    std::vector<unsigned char> compressed;
+    std::uint64_t offset = sizeof(header);
+    const char padding[ALIGNMENT] = {};
+    for (const auto& path : filePaths)
+    {
+      if (!IOManager::ReadFileToBuffer(path, data))
+      {
+        return false;
+      }
+      PackEntry entry = {};
+      //interned, two paths with the same hash stop the build
+      entry.id = AssetIds::Intern(NormalizePath(path));
+      entry.offset = offset;
+      entry.size = static_cast<std::uint32_t>(data.size());
+      const unsigned char* stored = data.data();
+      entry.storedSize = entry.size;
+      if (_compress)
+      {
+        CompressLZ4(data.data(), data.size(), compressed);
+        //only worth a decompression when it saves an eighth
+        if (compressed.size() < data.size() - data.size() / 8)
+        {
+          entry.flags |= PackEntry::COMPRESSED;
+          entry.storedSize = static_cast<std::uint32_t>(compressed.size());
+          stored = compressed.data();
+        }
+      }
+      file.write(reinterpret_cast<const char*>(stored), entry.storedSize);
+      offset += entry.storedSize;
+      const size_t numPadding = static_cast<size_t>((ALIGNMENT - offset % ALIGNMENT) % ALIGNMENT);
+      file.write(padding, numPadding);
+      offset += numPadding;
+      entries.push_back(entry);
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const PackEntry& _a, const PackEntry& _b) { return _a.id < _b.id; });
+    file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(PackEntry));
+    header.tocOffset = offset;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return !file.fail();
+  }
+}
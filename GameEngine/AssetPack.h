@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "AssetId.h"
+#include "IOManager.h"
+
+namespace GameEngine
+{
+  /** \brief An entry of the table of contents of a pack */
+  struct PackEntry
+  {
+    AssetId id;                 ///< the hash of the normalized path (see AssetPack::NormalizePath)
+    std::uint64_t offset;       ///< where the stored bytes start in the pack, aligned to AssetPack::ALIGNMENT
+    std::uint32_t size;         ///< the size of the file
+    std::uint32_t storedSize;   ///< the size in the pack, less than size if it's LZ4 compressed
+    std::uint32_t flags;
+    std::uint32_t padding;
+
+    bool IsCompressed() const noexcept { return (flags & COMPRESSED) != 0; }
+
+    enum : std::uint32_t { COMPRESSED = 1 };
+  };
+
+  /** \brief A read only archive of asset files, mapped into memory. The table of contents is sorted by the path hashes, so a lookup
+  * is a binary search without any strings, and the files stored as they are can be used in place. A file is LZ4 (block format)
+  * compressed when it shrinks enough, the already compressed images and sounds don't. IOManager::MountPack puts a pack in front of
+  * the loose files */
+  class AssetPack
+  {
+  public:
+    //the files start at multiples of it in the pack
+    static constexpr size_t ALIGNMENT{ 16 };
+
+    bool Open(const std::string& _packPath);
+    void Close();
+
+    /** \brief The entry of the file, nullptr if it's not in the pack */
+    const PackEntry* Find(const std::string& _filePath) const;
+    /** \brief The bytes of a file stored as it is, no copy. False for a compressed one */
+    bool GetSpan(const PackEntry& _entry, FileSpan& _span) const;
+    /** \brief Copies (or decompresses) the file into _data */
+    bool Read(const PackEntry& _entry, std::vector<unsigned char>& _data) const;
+
+    size_t GetNumEntries() const noexcept { return m_numEntries; }
+
+    /** \brief The path as the pack keys it: forward slashes, lower case, no leading ./ (the paths are case insensitive on Windows) */
+    static std::string NormalizePath(const std::string& _filePath);
+    /** \brief Packs every file under the directories (e.g. Assets, Shaders), keyed by their paths as the game loads them.
+    * _compress tries LZ4 on every file */
+    static bool Build(const std::string& _packPath, const std::vector<std::string>& _directories, bool _compress);
+  private:
+    MappedFile m_file;
+    const PackEntry* m_entries{ nullptr }; ///< inside the mapping
+    size_t m_numEntries{ 0 };
+  };
+}
@@ -7,7 +7,6 @@
 namespace GameEngine
 {
   constexpr int INVALID_BONE_ID = -999;
-  constexpr int MAX_BONES = 100;
 
   /*
     Load a static model
@@ -26,7 +25,7 @@ namespace GameEngine
     }
 
     m_directory = _path.substr(0, _path.find_last_of('/'));
-    _model->m_meshes.resize(scene->mNumMeshes);
+    _model->m_meshes.reserve(scene->mNumMeshes);
 
     //Process all the nodes(setup the meshes)
     ProcessNode(scene->mRootNode, scene, _model);
@@ -36,7 +35,7 @@ namespace GameEngine
   /*
     Load a skined model
   */
-  bool AssimpLoader::LoadSkinnedModel(const std::string & _path, SkinnedModel* _model)
+  bool AssimpLoader::LoadSkinnedModel(const std::string & _path, SkeletonAsset* _model)
   {
     //use assimp to import the model
     Assimp::Importer importer;
@@ -60,10 +59,10 @@ namespace GameEngine
     //Process all the nodes(setup the meshes)
     ProcessNode(scene->mRootNode, scene, _model);
 
-    //Build the bone trees for all animations
-    for (GLuint i = 0; i < _model->m_animations.size(); i++)
+    //Bake the bone hierarchies for all animations
+    for (GLuint i = 0; i < _model->m_clips.size(); i++)
     {
-      _model->m_animations.at(i).BuildBoneTree(scene, scene->mRootNode, &_model->m_animations.at(i).root, _model);
+      _model->m_clips.at(i).BuildBones(scene, _model->m_findBoneIDbyName);
     }
     return true;
 
@@ -89,7 +88,7 @@ namespace GameEngine
     }
   }
 
-  void AssimpLoader::ProcessNode(aiNode * _node, const aiScene * _scene, SkinnedModel* _model)
+  void AssimpLoader::ProcessNode(aiNode * _node, const aiScene * _scene, SkeletonAsset* _model)
   {
     // Process all the node's meshes (if any)
     for (GLuint i = 0; i < _node->mNumMeshes; i++)
@@ -134,11 +133,12 @@ namespace GameEngine
     //set the material textures
     ProcessTextures(_scene, _mesh, textures);
 
-
-    return Mesh(vertices, indices, textures, false, baseModelMatrix);
+    //the LODs are appended to the indices and share the vertices
+    const std::vector<Mesh::Lod> lods = ProcessLods(vertices, indices);
+    return Mesh(std::move(vertices), std::move(indices), textures, false, baseModelMatrix, m_keepCpuData, lods);
   }
 
-  Mesh AssimpLoader::ProcessMesh(aiMesh * _mesh, const aiScene * _scene, aiNode * _node, SkinnedModel* _model)
+  Mesh AssimpLoader::ProcessMesh(aiMesh * _mesh, const aiScene * _scene, aiNode * _node, SkeletonAsset* _model)
   {
     std::vector<Vertex> vertices;
     std::vector<GLuint> indices;
@@ -183,15 +183,18 @@ namespace GameEngine
       //Set the ID of the current bone name to the bone index (whether it be new or the same)
       _model->m_findBoneIDbyName[boneName] = boneIndex;
 
-      //iterate through all the channels(bones)
-      for (GLuint y = 0; y < _model->m_animations.at(_model->m_currentAnimation).m_channels.size(); y++)
+      //iterate through all the channels(bones) of every clip, so the clips can be blended with the same offsets
+      for (AnimationClip& clip : _model->m_clips)
       {
-        //check which channel corresponds to this bone
-        if (_model->m_animations.at(_model->m_currentAnimation).m_channels[y].m_name == boneName)
+        for (GLuint y = 0; y < clip.m_channels.size(); y++)
         {
-          //Set the bone offset of this bone name to the corresponding offset matrix from the aimesh
-          _model->m_animations.at(_model->m_currentAnimation).m_findBoneOffsetByName[boneName] =
-            AssimpToGlmMat4(&_mesh->mBones[x]->mOffsetMatrix);
+          //check which channel corresponds to this bone
+          if (clip.m_channels[y].m_name == boneName)
+          {
+            //Set the bone offset of this bone name to the corresponding offset matrix from the aimesh
+            clip.m_findBoneOffsetByName[boneName] =
+              AssimpToGlmMat4(&_mesh->mBones[x]->mOffsetMatrix);
+          }
         }
       }
 
@@ -231,15 +234,17 @@ namespace GameEngine
     //set the material textures
     ProcessTextures(_scene, _mesh, textures);
 
-    return Mesh(vertices, indices, textures, true, baseModelMatrix);
+    //the LODs are appended to the indices and share the vertices, with their bone weights
+    const std::vector<Mesh::Lod> lods = ProcessLods(vertices, indices);
+    return Mesh(std::move(vertices), std::move(indices), textures, true, baseModelMatrix, m_keepCpuData, lods);
   }
 
-  void AssimpLoader::ProcessAnimations(const aiScene * _scene, SkinnedModel* _model)
+  void AssimpLoader::ProcessAnimations(const aiScene * _scene, SkeletonAsset* _model)
   {
     for (GLuint animationIndex = 0; animationIndex < _scene->mNumAnimations; animationIndex++)
     {
       //set up the animation
-      SkinnedModel::Animation tempAnim;
+      AnimationClip tempAnim;
       tempAnim.m_name = _scene->mAnimations[animationIndex]->mName.data;
       tempAnim.m_duration = _scene->mAnimations[animationIndex]->mDuration;
       tempAnim.m_ticksPerSecond = (_scene->mAnimations[animationIndex]->mTicksPerSecond) != 0 ? _scene->mAnimations[animationIndex]->mTicksPerSecond : 25.0f;
@@ -247,35 +252,19 @@ namespace GameEngine
       // load in required data for animation so that we don't have to save the entire scene
       for (GLuint channelIndex = 0; channelIndex < _scene->mAnimations[animationIndex]->mNumChannels; channelIndex++)
       {
-        SkinnedModel::Animation::Channel tempChan;
+        AnimationClip::Channel tempChan;
         tempChan.m_name = _scene->mAnimations[animationIndex]->mChannels[channelIndex]->mNodeName.data;
 
-        for (GLuint keyIndex = 0; keyIndex < _scene->mAnimations[animationIndex]->mChannels[channelIndex]->mNumPositionKeys; keyIndex++)
-        {
-          tempChan.m_positionKeys.push_back(_scene->mAnimations[animationIndex]->mChannels[channelIndex]->mPositionKeys[keyIndex]);
-        }
-
-        for (GLuint keyIndex = 0; keyIndex < _scene->mAnimations[animationIndex]->mChannels[channelIndex]->mNumRotationKeys; keyIndex++)
-        {
-          tempChan.m_rotationKeys.push_back(_scene->mAnimations[animationIndex]->mChannels[channelIndex]->mRotationKeys[keyIndex]);
-        }
-        for (GLuint keyIndex = 0; keyIndex < _scene->mAnimations[animationIndex]->mChannels[channelIndex]->mNumScalingKeys; keyIndex++)
-        {
-          tempChan.m_scalingKeys.push_back(_scene->mAnimations[animationIndex]->mChannels[channelIndex]->mScalingKeys[keyIndex]);
-        }
+        //compressed right away, the raw keys of the scene aren't kept
+        const aiNodeAnim* nodeAnim = _scene->mAnimations[animationIndex]->mChannels[channelIndex];
+        CompressTrack(nodeAnim->mPositionKeys, nodeAnim->mNumPositionKeys, m_compression.m_positionTolerance, tempChan.m_positions);
+        CompressTrack(nodeAnim->mRotationKeys, nodeAnim->mNumRotationKeys, m_compression.m_rotationTolerance, tempChan.m_rotations);
+        CompressTrack(nodeAnim->mScalingKeys, nodeAnim->mNumScalingKeys, m_compression.m_scalingTolerance, tempChan.m_scalings);
         tempAnim.m_channels.push_back(tempChan);
       }
 
-      for (GLuint z = 0; z < MAX_BONES; z++)
-      {
-        tempAnim.m_boneTrans.push_back(glm::mat4(1.0f));
-      }
-
-      _model->m_animations.push_back(tempAnim);
+      _model->m_clips.push_back(tempAnim);
     }
-
-    _model->m_currentAnimation = 0;
-    _model->m_animations.at(_model->m_currentAnimation).root.m_name = "rootBoneTreeNode";
   }
 
   std::vector<GLTexture> AssimpLoader::LoadMaterialTextures(aiMaterial * _mat, const aiTextureType & _type, const std::string & _typeName)
@@ -289,7 +278,7 @@ namespace GameEngine
       GLTexture texture;
       std::cout << m_directory + '/' + str.C_Str() << std::endl;
       texture = ResourceManager::GetTexture(m_directory + '/' + str.C_Str());
-      texture.type = _typeName;
+      texture.type = AssetIds::Intern(_typeName);
       textures.push_back(texture);
     }
     return textures;
@@ -360,6 +349,26 @@ namespace GameEngine
     }
   }
 
+  std::vector<Mesh::Lod> AssimpLoader::ProcessLods(std::vector<Vertex>& _vertices, std::vector<GLuint>& _indices)
+  {
+    //LOD 0 is ordered for the cache and overdraw and the LODs are simplified from it, they're only ordered for the cache again
+    if (m_optimizeMeshes)
+    {
+      MeshOptimizer::OptimizeTriangles(_vertices, _indices.data(), _indices.size(), true);
+    }
+    const std::vector<Mesh::Lod> lods = MeshSimplifier::GenerateLods(_vertices, _indices, m_lodSettings);
+    if (m_optimizeMeshes)
+    {
+      for (size_t i = 1; i < lods.size(); i++)
+      {
+        MeshOptimizer::OptimizeTriangles(_vertices, _indices.data() + lods[i].m_firstIndex, lods[i].m_numIndices, false);
+      }
+      //LOD 0 comes first in the indices, so its vertices end up at the front of the buffer
+      MeshOptimizer::OptimizeVertexFetch(_vertices, _indices);
+    }
+    return lods;
+  }
+
   glm::mat4 AssimpLoader::AssimpToGlmMat4(const aiMatrix4x4 * _aiMatrix)
   {
     glm::mat4 mat;
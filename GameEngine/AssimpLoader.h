@@ -1,5 +1,7 @@
 #pragma once
 
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
 #include "Model.h"
 
 namespace GameEngine
@@ -8,25 +10,40 @@ namespace GameEngine
   {
   public:
     bool LoadStaticModel(const std::string& _path, StaticModel* _model);
-    bool LoadSkinnedModel(const std::string& _path, SkinnedModel* _model);
+    bool LoadSkinnedModel(const std::string& _path, SkeletonAsset* _model);
+
+    //the error thresholds of the keyframe reduction of the clips loaded from now on
+    void SetCompression(const AnimationCompressionSettings& _compression) { m_compression = _compression; }
+    //keep the CPU copies of the vertices of the meshes loaded from now on (see Mesh::HasCpuData)
+    void SetKeepCpuData(bool _keepCpuData) { m_keepCpuData = _keepCpuData; }
+    //the LOD chains generated for the meshes loaded from now on, m_numLods 1 imports only the triangles of the file
+    void SetLodSettings(const LodSettings& _lodSettings) { m_lodSettings = _lodSettings; }
+    //reorder the triangles and vertices of the meshes loaded from now on for the vertex cache, overdraw and vertex fetch (see MeshOptimizer)
+    void SetOptimizeMeshes(bool _optimizeMeshes) { m_optimizeMeshes = _optimizeMeshes; }
 
   private:
     void ProcessNode(aiNode* _node, const aiScene* _scene, StaticModel* _model);
-    void ProcessNode(aiNode* _node, const aiScene* _scene, SkinnedModel* _model);
+    void ProcessNode(aiNode* _node, const aiScene* _scene, SkeletonAsset* _model);
 
     Mesh ProcessMesh(aiMesh* _mesh, const aiScene* _scene, aiNode* _node);
-    Mesh ProcessMesh(aiMesh* _mesh, const aiScene* _scene, aiNode* _node, SkinnedModel* _model);
+    Mesh ProcessMesh(aiMesh* _mesh, const aiScene* _scene, aiNode* _node, SkeletonAsset* _model);
 
-    void ProcessAnimations(const aiScene* _scene, SkinnedModel* _model);
+    void ProcessAnimations(const aiScene* _scene, SkeletonAsset* _model);
 
     std::vector<GLTexture> LoadMaterialTextures(aiMaterial* _mat, const aiTextureType& _type, const std::string& _typeName);
 
     void ProcessVertices(aiMesh* _mesh, std::vector<Vertex>& _vertices);
     void ProcessFaces(aiMesh* _mesh, std::vector<GLuint>& _indices);
     void ProcessTextures(const aiScene* _scene, aiMesh* _mesh, std::vector<GLTexture>& _textures);
+    //optimizes the mesh and appends its LODs to _indices, returns their ranges
+    std::vector<Mesh::Lod> ProcessLods(std::vector<Vertex>& _vertices, std::vector<GLuint>& _indices);
 
     glm::mat4 AssimpToGlmMat4(const aiMatrix4x4* _aiMatrix);
 
     std::string m_directory{ "" }; ///< the directory of the loading model
+    AnimationCompressionSettings m_compression;
+    bool m_keepCpuData{ false };
+    LodSettings m_lodSettings;
+    bool m_optimizeMeshes{ true };
   };
 }
\ No newline at end of file
@@ -0,0 +1,206 @@
+#include "AsyncTextureLoader.h"
+#include "GLTexture.h"
+#include "ImageLoader.h"
+#include "TextureCooker.h"
+#include "SamplerCache.h"
+#include "GameEngineErrors.h"
+
+#include <algorithm>
+
+namespace GameEngine
+{
+  AsyncTextureLoader::AsyncTextureLoader()
+  {
+  }
+
+  AsyncTextureLoader::~AsyncTextureLoader()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_queuedCondition.notify_all();
+    if (m_worker.joinable())
+    {
+      m_worker.join();
+    }
+    for (Job& job : m_decoded)
+    {
+      ImageLoader::FreeImage(job.pixels);
+    }
+  }
+
+  std::shared_ptr<GLTexture> AsyncTextureLoader::Load(const std::string& _filePath, bool _alpha, bool _compress)
+  {
+    if (m_placeholder == 0)
+    {
+      const unsigned char white[4] = { 255, 255, 255, 255 };
+      m_placeholder = ImageLoader::UploadTexture(white, 1, 1, true);
+      m_worker = std::thread(&AsyncTextureLoader::Run, this);
+    }
+
+    //the placeholder is shared, only the real texture is deleted with the last reference
+    const GLuint placeholder = m_placeholder;
+    std::shared_ptr<GLTexture> texture(new GLTexture(), [placeholder](GLTexture* _texture)
+    {
+      if (_texture->id != placeholder)
+      {
+        _texture->Dispose();
+      }
+      delete _texture;
+    });
+    texture->id = m_placeholder;
+    texture->sampler = SamplerCache::Get().GetTextureSampler(_alpha);
+    texture->width = 1;
+    texture->height = 1;
+    texture->asset = AssetIds::Intern(_filePath);
+
+    Job job;
+    job.filePath = _filePath;
+    job.asset = texture->asset;
+    job.alpha = _alpha;
+    job.compress = _compress || TextureCooker::IsCompressed(_filePath);
+    job.texture = texture;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_queued.push_back(std::move(job));
+      m_numPending++;
+    }
+    m_queuedCondition.notify_one();
+    return texture;
+  }
+
+  void AsyncTextureLoader::Upload()
+  {
+    std::deque<Job> decoded;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      decoded.swap(m_decoded);
+    }
+    for (Job& job : decoded)
+    {
+      Stream(job);
+    }
+    m_streamer.Update();
+  }
+
+  void AsyncTextureLoader::Finish(const GLTexture& _texture)
+  {
+    const AssetId asset = _texture.asset;
+    auto isPath = [asset](const Job& _job) { return _job.asset == asset; };
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      //a queued image goes to the front, so the worker decodes it next
+      auto queued = std::find_if(m_queued.begin(), m_queued.end(), isPath);
+      if (queued != m_queued.end() && queued != m_queued.begin())
+      {
+        Job moved = std::move(*queued);
+        m_queued.erase(queued);
+        m_queued.push_front(std::move(moved));
+      }
+      m_decodedCondition.wait(lock, [&]()
+      {
+        return std::any_of(m_decoded.begin(), m_decoded.end(), isPath) ||
+          (std::none_of(m_queued.begin(), m_queued.end(), isPath) && m_decoding != asset);
+      });
+      auto decoded = std::find_if(m_decoded.begin(), m_decoded.end(), isPath);
+      if (decoded != m_decoded.end())
+      {
+        job = std::move(*decoded);
+        m_decoded.erase(decoded);
+      }
+    }
+    //the decoded image goes to the streamer like any other, which then finishes it right away
+    if (job.asset != AssetIds::NONE)
+    {
+      Stream(job);
+    }
+    m_streamer.Finish(&_texture);
+  }
+
+  bool AsyncTextureLoader::IsPending(const GLTexture& _texture) const
+  {
+    return m_placeholder != 0 && _texture.id == m_placeholder;
+  }
+
+  size_t AsyncTextureLoader::GetNumPending() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numPending + m_streamer.GetNumUploads();
+  }
+
+  void AsyncTextureLoader::DisposeStreaming()
+  {
+    m_streamer.Dispose();
+  }
+
+  void AsyncTextureLoader::Run()
+  {
+    for (;;)
+    {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_queuedCondition.wait(lock, [this]() { return m_stop || !m_queued.empty(); });
+        if (m_stop)
+        {
+          return;
+        }
+        job = std::move(m_queued.front());
+        m_queued.pop_front();
+        m_decoding = job.asset;
+      }
+      //no one waits for a texture whose handles are all gone
+      if (!job.texture.expired())
+      {
+        if (job.compress)
+        {
+          //cooking compresses on this thread too, only the first load of a texture pays for it
+          TextureCooker::LoadCompressed(job.filePath, job.alpha, job.compressed);
+        }
+        else
+        {
+          job.pixels = ImageLoader::DecodeImage(job.filePath, job.alpha, job.width, job.height);
+        }
+      }
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_decoding = AssetIds::NONE;
+        m_decoded.push_back(std::move(job));
+      }
+      m_decodedCondition.notify_all();
+    }
+  }
+
+  void AsyncTextureLoader::Stream(Job& _job)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_numPending--;
+    }
+    if (_job.texture.expired())
+    {
+      ImageLoader::FreeImage(_job.pixels);
+      _job.pixels = nullptr;
+      return;
+    }
+    if (_job.pixels == nullptr && _job.compressed.data.empty())
+    {
+      FatalError("Failed to load " + _job.filePath);
+    }
+    if (_job.compress)
+    {
+      //a compressed chain is small and complete, it needs neither the streamer nor mipmap generation
+      std::shared_ptr<GLTexture> texture = _job.texture.lock();
+      texture->id = ImageLoader::UploadCompressed(_job.compressed, _job.alpha);
+      texture->width = _job.compressed.width;
+      texture->height = _job.compressed.height;
+      _job.compressed = CompressedImage();
+      return;
+    }
+    //the streamer frees the pixels
+    m_streamer.Add(_job.pixels, _job.width, _job.height, _job.alpha, _job.texture);
+    _job.pixels = nullptr;
+  }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <GL\glew.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "AssetId.h"
+#include "ImageLoader.h"
+#include "TextureStreamer.h"
+
+namespace GameEngine
+{
+  struct GLTexture;
+
+  /** \brief Loads textures without stalling the frame: a worker thread reads and decodes the images, the main thread streams the decoded
+  * ones to the GPU in Upload (see TextureStreamer). Until then a texture shows a 1x1 white placeholder; the upload writes the real id and size
+  * into the texture the handles share, so everything drawing through a handle picks it up the next frame. Copies of the texture taken
+  * before that keep the placeholder */
+  class AsyncTextureLoader
+  {
+  public:
+    AsyncTextureLoader();
+    ~AsyncTextureLoader();
+
+    AsyncTextureLoader(const AsyncTextureLoader&) = delete;
+    AsyncTextureLoader& operator=(const AsyncTextureLoader&) = delete;
+
+    /** \brief Queues the image for decoding and returns its texture right away, with the placeholder in it. The last reference to the
+    * texture deletes the GL texture, a load whose texture is gone by then is skipped
+    * \param _compress - the worker loads (or cooks) the compressed image instead, it's uploaded in one go (see TextureCooker) */
+    std::shared_ptr<GLTexture> Load(const std::string& _filePath, bool _alpha, bool _compress = false);
+
+    /** \brief Hands the decoded images to the streamer and streams its next section, once per frame */
+    void Upload();
+
+    /** \brief Blocks until the image of the texture is decoded and uploads all of it, for the callers that need the real texture now */
+    void Finish(const GLTexture& _texture);
+
+    bool IsPending(const GLTexture& _texture) const;
+    /** \brief The loads queued, decoding or still streaming */
+    size_t GetNumPending() const;
+
+    /** \brief Finishes the streaming uploads and frees the streaming buffer, while the GL context is still there */
+    void DisposeStreaming();
+
+  private:
+    struct Job
+    {
+      std::string filePath;
+      AssetId asset{ AssetIds::NONE }; ///< the interned path, the texture's too
+      bool alpha{ true };
+      bool compress{ false };
+      std::weak_ptr<GLTexture> texture;
+      CompressedImage compressed; ///< the levels of a compressed load, the pixels stay null
+      unsigned char* pixels{ nullptr };
+      int width{ 0 };
+      int height{ 0 };
+    };
+
+    void Run();
+    void Stream(Job& _job);
+
+    GLuint m_placeholder{ 0 }; ///< created with the first load, shared by all the pending textures and never deleted
+    TextureStreamer m_streamer; ///< used on the main thread only
+
+    std::thread m_worker; ///< started with the first load
+    mutable std::mutex m_mutex;
+    std::condition_variable m_queuedCondition;  ///< the worker waits on it for jobs
+    std::condition_variable m_decodedCondition; ///< Finish waits on it for its image
+    std::deque<Job> m_queued;
+    std::deque<Job> m_decoded;
+    AssetId m_decoding{ AssetIds::NONE }; ///< the image the worker is decoding, NONE while it waits
+    size_t m_numPending{ 0 }; ///< the jobs not handed to the streamer yet
+    bool m_stop{ false };
+  };
+}
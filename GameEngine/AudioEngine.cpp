@@ -1,18 +1,66 @@
 #include "AudioEngine.h"
 #include "GameEngineErrors.h"
+#include "IOManager.h"
+
+#include <iostream>
 
 namespace GameEngine
 {
+  //the deleter of the effects, the last reference frees the chunk
+  static void FreeChunk(Mix_Chunk* _chunk)
+  {
+    //the voices playing it stop first, Mix_FreeChunk halts the channels of SDL_mixer itself
+    AudioMixer::Get().Stop(_chunk);
+    Mix_FreeChunk(_chunk);
+  }
+
+  //decodes the whole effect from its mapping (which may be in a pack), on any thread. nullptr if it failed, with why in _error
+  static Mix_Chunk* DecodeEffect(const std::string& _filePath, std::string& _error)
+  {
+    MappedFile file;
+    if (!file.Open(_filePath))
+    {
+      _error = "Failed to open sound effect " + _filePath;
+      return nullptr;
+    }
+    Mix_Chunk* chunk = Mix_LoadWAV_RW(SDL_RWFromConstMem(file.GetData(), static_cast<int>(file.GetSize())), 1);
+    if (chunk == nullptr)
+    {
+      _error = "Mix_LoadWAV error: " + std::string(Mix_GetError());
+    }
+    return chunk;
+  }
+
   void SoundEffect::Play(int _loops /* = 0 */)
   {
-    //play the mix and error check
-    if (Mix_PlayChannel(-1, m_chunk, _loops) == -1)
+    Play(AudioMixer::Get().GetListener(), _loops);
+  }
+
+  void SoundEffect::Play(const glm::vec3& _position, int _loops /* = 0 */)
+  {
+    AudioMixer& mixer = AudioMixer::Get();
+    if (mixer.IsInitialized())
     {
-      if (Mix_PlayChannel(0, m_chunk, _loops) == -1)
-      {
-        FatalError("Mix_PlayChannel error: " + std::string(Mix_GetError()));
-      }
+      //a busy mixer drops the sound or steals a voice, it never fails
+      mixer.Play(m_chunk.get(), m_settings, _loops, _position);
+    }
+    else if (Mix_PlayChannel(-1, m_chunk.get(), _loops) == -1)
+    {
+      //every channel is busy, the sound is dropped
+      std::cout << "WARNING::AUDIO::NO_FREE_CHANNEL\n" << Mix_GetError() << std::endl;
+    }
+  }
+
+  int SoundEffect::AddSource(const glm::vec3& _position) const
+  {
+    AudioMixer& mixer = AudioMixer::Get();
+    if (!mixer.IsInitialized())
+    {
+      //SDL_mixer's channels can't be virtualized, the sources need the mixer
+      std::cout << "WARNING::AUDIO::NO_MIXER_FOR_SOURCE" << std::endl;
+      return -1;
     }
+    return mixer.AddSource(m_chunk.get(), m_settings, _position);
   }
 
   void Music::Play(int _loops /* = 1 */)
@@ -72,24 +120,29 @@ namespace GameEngine
     {
       FatalError("Mix_OpenAudio error: " + std::string(Mix_GetError()));
     }
+    //the sound effects are mixed by the engine, SDL_mixer keeps the music
+    AudioMixer::Get().Init();
     m_isInitialized = true;
   }
   void AudioEngine::Destroy()
   {
+    //the decoders are unloaded below, the loads they're running finish first. The ones not cached yet are dropped
+    JobSystem::Get().Wait(m_loadCounter);
+    m_loadToken = std::make_shared<bool>(true);
+    m_pendingLoads.clear();
     if (m_isInitialized)
     {
       m_isInitialized = false;
-      //iterate through the effectmap and free the chunks
-      for (auto& it : m_effectMap)
-      {
-        Mix_FreeChunk(it.second);
-      }
-      //iterate through the musicmap and free the music
+      //the mixer stops reading the chunks before they're freed
+      AudioMixer::Get().Destroy();
+      //the chunks go with their last reference, a SoundEffect kept after this frees its own
+      m_effectMap.clear();
+      m_effectBytes = 0;
+      //iterate through the musicmap and free the music, then its stream
       for (auto& it : m_musicMap)
       {
-        Mix_FreeMusic(it.second);
+        Mix_FreeMusic(it.second.music);
       }
-      m_effectMap.clear();
       m_musicMap.clear();
 
       Mix_CloseAudio();
@@ -103,28 +156,160 @@ namespace GameEngine
     //try to find the audio in the cache
     auto it = m_effectMap.find(_filePath);
 
-    SoundEffect effect;
-
     if (it == m_effectMap.end())
     {
       //failed to find it, must load
-      Mix_Chunk* chunk = Mix_LoadWAV(_filePath.c_str());
+      std::string error;
+      Mix_Chunk* chunk = DecodeEffect(_filePath, error);
       //check for errors
       if (chunk == nullptr)
       {
-        FatalError("Mix_LoadWAV error: " + std::string(Mix_GetError()));
+        FatalError(error);
       }
+      return CreateEffect(_filePath, CacheEffect(_filePath, chunk));
+    }
+    //it's already cached
+    it->second.lastUsed = ++m_numLoads;
+    return CreateEffect(_filePath, it->second.chunk);
+  }
 
-      effect.m_chunk = chunk;
-      m_effectMap[_filePath] = chunk;
+  void AudioEngine::LoadSoundEffectAsync(const std::string& _filePath, const std::function<void(const SoundEffect&)>& _onReady)
+  {
+    auto it = m_effectMap.find(_filePath);
+    if (it != m_effectMap.end())
+    {
+      it->second.lastUsed = ++m_numLoads;
+      if (_onReady)
+      {
+        _onReady(CreateEffect(_filePath, it->second.chunk));
+      }
+      return;
     }
-    else
+    //a load of the file already on its way calls this one back too
+    auto pending = m_pendingLoads.find(_filePath);
+    if (pending != m_pendingLoads.end())
     {
-      //it's already cached
-      effect.m_chunk = it->second;
+      pending->second.push_back(_onReady);
+      return;
+    }
+    m_pendingLoads[_filePath].push_back(_onReady);
+
+    std::weak_ptr<bool> token = m_loadToken;
+    JobSystem::Get().Run([this, _filePath, token]()
+    {
+      std::string error;
+      Mix_Chunk* chunk = DecodeEffect(_filePath, error);
+      //the cache belongs to the game thread, the effect joins it there
+      JobSystem::Get().RunOnMainThread([this, _filePath, token, chunk, error]()
+      {
+        if (token.expired())
+        {
+          if (chunk != nullptr)
+          {
+            Mix_FreeChunk(chunk);
+          }
+          return;
+        }
+        FinishAsyncLoad(_filePath, chunk, error);
+      });
+    }, &m_loadCounter);
+  }
+
+  SoundEffect AudioEngine::CreateEffect(const std::string& _filePath, const std::shared_ptr<Mix_Chunk>& _chunk) const
+  {
+    SoundEffect effect;
+    effect.m_chunk = _chunk;
+    auto settings = m_settingsMap.find(_filePath);
+    if (settings != m_settingsMap.end())
+    {
+      effect.m_settings = settings->second;
     }
     return effect;
   }
+
+  std::shared_ptr<Mix_Chunk> AudioEngine::CacheEffect(const std::string& _filePath, Mix_Chunk* _chunk)
+  {
+    std::shared_ptr<Mix_Chunk> chunk(_chunk, &FreeChunk);
+    CachedEffect& cached = m_effectMap[_filePath];
+    cached.chunk = chunk;
+    cached.lastUsed = ++m_numLoads;
+    m_effectBytes += _chunk->alen;
+    //the new effect is held by the returned pointer, it isn't evicted
+    EvictEffects();
+    return chunk;
+  }
+
+  void AudioEngine::FinishAsyncLoad(const std::string& _filePath, Mix_Chunk* _chunk, const std::string& _error)
+  {
+    std::vector<ReadyCallback> callbacks;
+    auto pending = m_pendingLoads.find(_filePath);
+    if (pending != m_pendingLoads.end())
+    {
+      callbacks.swap(pending->second);
+      m_pendingLoads.erase(pending);
+    }
+    if (_chunk == nullptr)
+    {
+      std::cout << "ERROR::AUDIO::ASYNC_LOAD_FAILED\n" << _error << std::endl;
+      return;
+    }
+
+    std::shared_ptr<Mix_Chunk> chunk;
+    auto it = m_effectMap.find(_filePath);
+    if (it != m_effectMap.end())
+    {
+      //a synchronous load of the file got there first
+      Mix_FreeChunk(_chunk);
+      chunk = it->second.chunk;
+      it->second.lastUsed = ++m_numLoads;
+    }
+    else
+    {
+      chunk = CacheEffect(_filePath, _chunk);
+    }
+    const SoundEffect effect = CreateEffect(_filePath, chunk);
+    for (const ReadyCallback& callback : callbacks)
+    {
+      if (callback)
+      {
+        callback(effect);
+      }
+    }
+  }
+
+  void AudioEngine::SetEffectBudget(size_t _bytes)
+  {
+    m_effectBudget = _bytes;
+    EvictEffects();
+  }
+
+  void AudioEngine::EvictEffects()
+  {
+    AudioMixer& mixer = AudioMixer::Get();
+    while (m_effectBytes > m_effectBudget)
+    {
+      //the least recently loaded of the ones only the cache holds, a playing one would be cut off
+      auto victim = m_effectMap.end();
+      for (auto it = m_effectMap.begin(); it != m_effectMap.end(); ++it)
+      {
+        if (it->second.chunk.use_count() > 1 || mixer.IsPlaying(it->second.chunk.get()))
+        {
+          continue;
+        }
+        if (victim == m_effectMap.end() || it->second.lastUsed < victim->second.lastUsed)
+        {
+          victim = it;
+        }
+      }
+      if (victim == m_effectMap.end())
+      {
+        //everything left is in use, the cache stays over its budget until it isn't
+        return;
+      }
+      m_effectBytes -= victim->second.chunk->alen;
+      m_effectMap.erase(victim);
+    }
+  }
   Music AudioEngine::LoadMusic(const std::string& _filePath)
   {
     //try to find the audio in the cache
@@ -134,8 +319,13 @@ namespace GameEngine
 
     if (it == m_musicMap.end())
     {
-      //failed to find it, must load
-      Mix_Music* mixMusic = Mix_LoadMUS(_filePath.c_str());
+      //failed to find it, must load, only the header is read now, the rest is streamed while it plays
+      std::unique_ptr<AudioStream> stream = std::make_unique<AudioStream>();
+      if (!stream->Open(_filePath))
+      {
+        FatalError("Failed to open music " + _filePath);
+      }
+      Mix_Music* mixMusic = Mix_LoadMUS_RW(stream->CreateRWops(), 1);
       //check for errors
       if (mixMusic == nullptr)
       {
@@ -143,12 +333,14 @@ namespace GameEngine
       }
 
       music.m_music = mixMusic;
-      m_musicMap[_filePath] = mixMusic;
+      StreamedMusic& streamed = m_musicMap[_filePath];
+      streamed.stream = std::move(stream);
+      streamed.music = mixMusic;
     }
     else
     {
       //it's already cached
-      music.m_music = it->second;
+      music.m_music = it->second.music;
     }
     return music;
   }
@@ -1,8 +1,16 @@
 #pragma once
 
 #include <SDL\SDL_mixer.h>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <map>
+#include <memory>
+#include <vector>
+
+#include "AudioMixer.h"
+#include "AudioStream.h"
+#include "JobSystem.h"
 
 namespace GameEngine
 {
@@ -11,13 +19,22 @@ namespace GameEngine
   {
   public:
     friend class AudioEngine;
-    /// plays the effect file
+    /// plays the effect file through the AudioMixer, a busy mixer may drop it (see SoundSettings)
     /// @param loops: if loops == -1, loop forever,
     ///  otherwise it loops + 1 times
     void Play(int _loops = 0);
+    /// plays the effect at a position, culled by its distance to the listener (see AudioMixer::SetListener)
+    void Play(const glm::vec3& _position, int _loops = 0);
+    /// loops the effect at a position until AudioMixer::RemoveSource, mixed only while it's in range of the listener
+    /// @return the id of the source, -1 without the AudioMixer
+    int AddSource(const glm::vec3& _position) const;
+
+    const SoundSettings& GetSettings() const noexcept { return m_settings; }
+    void SetSettings(const SoundSettings& _settings) { m_settings = _settings; }
 
   private:
-    Mix_Chunk* m_chunk = nullptr;
+    std::shared_ptr<Mix_Chunk> m_chunk; ///< freed with its last reference, the cache may have dropped it before
+    SoundSettings m_settings;
   };
 
   class Music
@@ -38,7 +55,7 @@ namespace GameEngine
     ///edit the music volue
     static void EditVolume(int _volume);
   private:
-    Mix_Music* m_music = nullptr;
+    Mix_Music* m_music = nullptr; ///< owned by the cache of the AudioEngine
   };
 
   class AudioEngine
@@ -50,12 +67,57 @@ namespace GameEngine
     void Init();
     void Destroy();
 
+    /// the whole effect is decoded, from the file or the pack (see IOManager::MountPack)
     SoundEffect LoadSoundEffect(const std::string& _filePath);
+    /// the effect is decoded on a worker of the JobSystem and cached on the game thread (in RunMainThreadJobs), which calls _onReady
+    /// with it then, right away if it's already cached. Preload the effects of a screen with it so their first play doesn't decode them.
+    /// _onReady may be empty, it isn't called if the load fails or the engine is destroyed first
+    void LoadSoundEffectAsync(const std::string& _filePath, const std::function<void(const SoundEffect&)>& _onReady);
+    /// the song is streamed from the file or the pack while it plays, only a small buffer of it is in memory (see AudioStream)
     Music LoadMusic(const std::string& _filePath);
+    /// the settings the effects of the file are loaded with from then on
+    void SetSoundSettings(const std::string& _filePath, const SoundSettings& _settings) { m_settingsMap[_filePath] = _settings; }
+
+    /// the bytes of decoded effects the cache keeps: above it the least recently loaded ones are freed, except the ones playing
+    /// or still held by a SoundEffect, which are loaded again the next time
+    void SetEffectBudget(size_t _bytes);
+    size_t GetEffectBudget() const noexcept { return m_effectBudget; }
+    size_t GetEffectBytes() const noexcept { return m_effectBytes; }
+
+    static constexpr size_t DEFAULT_EFFECT_BUDGET{ 16 * 1024 * 1024 };
   private:
+    struct CachedEffect
+    {
+      std::shared_ptr<Mix_Chunk> chunk;
+      std::uint64_t lastUsed = 0; ///< the load it was last returned by
+    };
+    struct StreamedMusic
+    {
+      std::unique_ptr<AudioStream> stream;
+      Mix_Music* music = nullptr; ///< reads the stream, freed before it
+    };
+
+    typedef std::function<void(const SoundEffect&)> ReadyCallback;
+
+    // The effect of a cached chunk, with the settings of its file
+    SoundEffect CreateEffect(const std::string& _filePath, const std::shared_ptr<Mix_Chunk>& _chunk) const;
+    // Caches a decoded chunk, which may evict others
+    std::shared_ptr<Mix_Chunk> CacheEffect(const std::string& _filePath, Mix_Chunk* _chunk);
+    // Frees the least recently loaded effects until the cache is within its budget
+    void EvictEffects();
+    // Caches an async load on the game thread and calls back the ones waiting for it, _chunk is nullptr if it failed
+    void FinishAsyncLoad(const std::string& _filePath, Mix_Chunk* _chunk, const std::string& _error);
+
+    std::map<std::string, CachedEffect> m_effectMap; ///< Effects cache
+    std::map<std::string, SoundSettings> m_settingsMap; ///< the effects without settings have the default ones
+    std::map<std::string, StreamedMusic> m_musicMap; ///< Music cache
+    size_t m_effectBudget = DEFAULT_EFFECT_BUDGET;
+    size_t m_effectBytes = 0; ///< the decoded bytes of the cached effects
+    std::uint64_t m_numLoads = 0;
 
-    std::map<std::string, Mix_Chunk*> m_effectMap; ///< Effects cache
-    std::map<std::string, Mix_Music*> m_musicMap; ///< Music cache
+    std::map<std::string, std::vector<ReadyCallback>> m_pendingLoads; ///< the async loads on their way, and who waits for them
+    JobCounter m_loadCounter; ///< the decoding jobs, Destroy waits for them before the decoders are unloaded
+    std::shared_ptr<bool> m_loadToken = std::make_shared<bool>(true); ///< the async loads hold it weakly, replaced by Destroy to drop them
 
     bool m_isInitialized = false;
   };
@@ -0,0 +1,452 @@
+#include "AudioMixer.h"
+#include "Camera2D.h"
+#include "Camera3D.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace GameEngine
+{
+  //how much of the far channel fades out for a sound all the way to one side, it never goes silent
+  static constexpr float PAN_DEPTH{ 0.7f };
+
+  AudioMixer& AudioMixer::Get()
+  {
+    static AudioMixer mixer;
+    return mixer;
+  }
+
+  bool AudioMixer::Init()
+  {
+    int frequency = 0;
+    Uint16 format = 0;
+    int channels = 0;
+    //the chunks are converted to the output format when they're loaded, they're mixed as they are
+    if (Mix_QuerySpec(&frequency, &format, &channels) == 0 || format != AUDIO_S16SYS)
+    {
+      std::cout << "ERROR::AUDIOMIXER::UNSUPPORTED_FORMAT\n" << format << std::endl;
+      return false;
+    }
+    StopAll();
+    m_numChannels = channels;
+    m_mixedFrames = 0;
+    m_numDropped = 0;
+    m_numStolen = 0;
+    Mix_SetPostMix(&AudioMixer::MixCallback, this);
+    m_isInitialized = true;
+    return true;
+  }
+
+  void AudioMixer::Destroy()
+  {
+    if (m_isInitialized)
+    {
+      Mix_SetPostMix(nullptr, nullptr);
+      StopAll();
+      m_sourceChunks.clear();
+      m_sourcePositions.clear();
+      m_sourceSettings.clear();
+      m_sourceStarts.clear();
+      m_sourceVoices.clear();
+      m_freeSources.clear();
+      m_numAudibleSources = 0;
+      m_isInitialized = false;
+    }
+  }
+
+  int AudioMixer::Play(Mix_Chunk* _chunk, const SoundSettings& _settings, int _loops, const glm::vec3& _position)
+  {
+    if (!_chunk || _chunk->alen < sizeof(Sint16))
+    {
+      return -1;
+    }
+    const glm::ivec2 gains = ComputeGains(_settings, _position);
+    const int gain = std::max(gains.x, gains.y);
+    if (gain == 0)
+    {
+      return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int voice = -1;
+    if (_settings.maxInstances > 0)
+    {
+      //at the limit the oldest instance starts over, a rapid fire keeps its latest shots
+      int numInstances = 0;
+      for (int i = 0; i < MAX_VOICES; i++)
+      {
+        if (m_voices[i].chunk == _chunk && m_voices[i].source == -1)
+        {
+          numInstances++;
+          if (voice == -1 || m_voices[i].order < m_voices[voice].order)
+          {
+            voice = i;
+          }
+        }
+      }
+      if (numInstances < _settings.maxInstances)
+      {
+        voice = -1;
+      }
+    }
+    if (voice == -1)
+    {
+      voice = FindFreeVoice();
+    }
+    if (voice == -1)
+    {
+      voice = FindVoiceToSteal(_settings.priority, gain);
+      if (voice == -1)
+      {
+        m_numDropped++;
+        return -1;
+      }
+      m_numStolen++;
+    }
+
+    Voice& newVoice = m_voices[voice];
+    newVoice.chunk = _chunk;
+    newVoice.position = 0;
+    newVoice.loops = _loops;
+    newVoice.priority = _settings.priority;
+    newVoice.gain = gain;
+    newVoice.channelGains[0] = gains.x;
+    newVoice.channelGains[1] = gains.y;
+    newVoice.source = -1;
+    newVoice.order = m_nextOrder++;
+    return voice;
+  }
+
+  void AudioMixer::Stop(Mix_Chunk* _chunk)
+  {
+    for (size_t i = 0; i < m_sourceChunks.size(); i++)
+    {
+      if (m_sourceChunks[i] == _chunk)
+      {
+        RemoveSource(static_cast<int>(i));
+      }
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (Voice& voice : m_voices)
+    {
+      if (voice.chunk == _chunk)
+      {
+        voice.chunk = nullptr;
+      }
+    }
+  }
+
+  void AudioMixer::StopAll()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (Voice& voice : m_voices)
+    {
+      voice.chunk = nullptr;
+    }
+  }
+
+  bool AudioMixer::IsPlaying(const Mix_Chunk* _chunk) const
+  {
+    if (std::find(m_sourceChunks.begin(), m_sourceChunks.end(), _chunk) != m_sourceChunks.end())
+    {
+      return true;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const Voice& voice : m_voices)
+    {
+      if (voice.chunk == _chunk)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  int AudioMixer::AddSource(Mix_Chunk* _chunk, const SoundSettings& _settings, const glm::vec3& _position)
+  {
+    if (!_chunk || _chunk->alen < static_cast<Uint32>(m_numChannels * sizeof(Sint16)))
+    {
+      return -1;
+    }
+    int source = -1;
+    if (!m_freeSources.empty())
+    {
+      source = m_freeSources.back();
+      m_freeSources.pop_back();
+    }
+    else
+    {
+      source = static_cast<int>(m_sourceChunks.size());
+      m_sourceChunks.push_back(nullptr);
+      m_sourcePositions.emplace_back(0.0f);
+      m_sourceSettings.emplace_back();
+      m_sourceStarts.push_back(0);
+      m_sourceVoices.push_back(-1);
+    }
+    m_sourceChunks[source] = _chunk;
+    m_sourcePositions[source] = _position;
+    m_sourceSettings[source] = _settings;
+    m_sourceVoices[source] = -1;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sourceStarts[source] = m_mixedFrames;
+    return source;
+  }
+
+  void AudioMixer::RemoveSource(int _source)
+  {
+    if (!m_sourceChunks[_source])
+    {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      ReleaseSourceVoice(_source);
+    }
+    m_sourceChunks[_source] = nullptr;
+    m_sourceVoices[_source] = -1;
+    m_freeSources.push_back(_source);
+  }
+
+  void AudioMixer::UpdateSources()
+  {
+    //the gains of all the sources first, one pass over the positions without the lock
+    const size_t numSources = m_sourceChunks.size();
+    m_sourceGains.resize(numSources);
+    for (size_t i = 0; i < numSources; i++)
+    {
+      m_sourceGains[i] = m_sourceChunks[i] ? ComputeGains(m_sourceSettings[i], m_sourcePositions[i]) : glm::ivec2(0);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_numAudibleSources = 0;
+    for (size_t i = 0; i < numSources; i++)
+    {
+      Mix_Chunk* chunk = m_sourceChunks[i];
+      if (!chunk)
+      {
+        continue;
+      }
+      const int source = static_cast<int>(i);
+      const glm::ivec2 gains = m_sourceGains[i];
+      const int gain = std::max(gains.x, gains.y);
+      if (gain == 0)
+      {
+        //out of range, virtual: its voice goes to the others and its loop goes on with the clock
+        ReleaseSourceVoice(source);
+        m_sourceVoices[i] = -1;
+        continue;
+      }
+      m_numAudibleSources++;
+
+      //a sound of Play or another source may have taken its voice
+      int voice = m_sourceVoices[i];
+      if (voice != -1 && (m_voices[voice].source != source || !m_voices[voice].chunk))
+      {
+        voice = -1;
+      }
+      if (voice == -1)
+      {
+        voice = FindFreeVoice();
+        if (voice == -1)
+        {
+          voice = FindVoiceToSteal(m_sourceSettings[i].priority, gain);
+          if (voice == -1)
+          {
+            m_sourceVoices[i] = -1;
+            continue;
+          }
+          m_numStolen++;
+        }
+        //it joins its loop where it would be if it had played all along
+        const Uint32 frameBytes = static_cast<Uint32>(m_numChannels * sizeof(Sint16));
+        const std::uint64_t numFrames = chunk->alen / frameBytes;
+        Voice& newVoice = m_voices[voice];
+        newVoice.chunk = chunk;
+        newVoice.position = static_cast<Uint32>((m_mixedFrames - m_sourceStarts[i]) % numFrames) * frameBytes;
+        newVoice.loops = -1;
+        newVoice.priority = m_sourceSettings[i].priority;
+        newVoice.source = source;
+        newVoice.order = m_nextOrder++;
+      }
+      Voice& sourceVoice = m_voices[voice];
+      sourceVoice.gain = gain;
+      sourceVoice.channelGains[0] = gains.x;
+      sourceVoice.channelGains[1] = gains.y;
+      m_sourceVoices[i] = voice;
+    }
+  }
+
+  void AudioMixer::SetListener(const glm::vec3& _position, const glm::vec3& _right)
+  {
+    m_listener = _position;
+    m_listenerRight = _right;
+  }
+
+  void AudioMixer::SetListener(const Camera2D& _camera)
+  {
+    SetListener(glm::vec3(_camera.GetPosition(), 0.0f));
+  }
+
+  void AudioMixer::SetListener(const Camera3D& _camera)
+  {
+    SetListener(_camera.GetPosition(), _camera.GetRight());
+  }
+
+  void AudioMixer::SetMasterVolume(float _volume)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_masterGain = static_cast<int>(glm::clamp(_volume, 0.0f, 1.0f) * 256.0f);
+  }
+
+  int AudioMixer::GetNumActiveVoices() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int numActive = 0;
+    for (const Voice& voice : m_voices)
+    {
+      numActive += voice.chunk ? 1 : 0;
+    }
+    return numActive;
+  }
+
+  glm::ivec2 AudioMixer::ComputeGains(const SoundSettings& _settings, const glm::vec3& _position) const
+  {
+    const glm::vec3 offset = _position - m_listener;
+    const float distance = glm::length(offset);
+    //fades out linearly up to the max distance, not played from there on
+    float volume = _settings.volume;
+    if (_settings.maxDistance > 0.0f)
+    {
+      if (distance >= _settings.maxDistance)
+      {
+        return glm::ivec2(0);
+      }
+      volume *= 1.0f - distance / _settings.maxDistance;
+    }
+    const float gain = glm::clamp(volume, 0.0f, 1.0f) * 256.0f;
+    if (m_numChannels != 2 || distance <= 0.0f)
+    {
+      return glm::ivec2(static_cast<int>(gain));
+    }
+    //-1 all the way left of the listener to 1 all the way right, the channel away from the sound fades
+    const float pan = glm::clamp(glm::dot(offset, m_listenerRight) / distance, -1.0f, 1.0f);
+    return glm::ivec2(static_cast<int>(gain * (1.0f - std::max(pan, 0.0f) * PAN_DEPTH)),
+      static_cast<int>(gain * (1.0f - std::max(-pan, 0.0f) * PAN_DEPTH)));
+  }
+
+  int AudioMixer::FindFreeVoice() const
+  {
+    for (int i = 0; i < MAX_VOICES; i++)
+    {
+      if (!m_voices[i].chunk)
+      {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  void AudioMixer::ReleaseSourceVoice(int _source)
+  {
+    const int voice = m_sourceVoices[_source];
+    if (voice != -1 && m_voices[voice].source == _source)
+    {
+      m_voices[voice].chunk = nullptr;
+      m_voices[voice].source = -1;
+    }
+  }
+
+  int AudioMixer::FindVoiceToSteal(int _priority, int _gain) const
+  {
+    int victim = 0;
+    for (int i = 1; i < MAX_VOICES; i++)
+    {
+      const Voice& voice = m_voices[i];
+      const Voice& best = m_voices[victim];
+      if (voice.priority != best.priority)
+      {
+        if (voice.priority < best.priority) victim = i;
+      }
+      else if (voice.gain != best.gain)
+      {
+        if (voice.gain < best.gain) victim = i;
+      }
+      else if (voice.order < best.order)
+      {
+        victim = i;
+      }
+    }
+    //a sound of the same priority only cuts one which isn't louder than itself
+    const Voice& voice = m_voices[victim];
+    if (voice.priority < _priority || (voice.priority == _priority && voice.gain <= _gain))
+    {
+      return victim;
+    }
+    return -1;
+  }
+
+  void AudioMixer::MixCallback(void* _mixer, Uint8* _stream, int _length)
+  {
+    static_cast<AudioMixer*>(_mixer)->Mix(reinterpret_cast<Sint16*>(_stream), _length / static_cast<int>(sizeof(Sint16)));
+  }
+
+  void AudioMixer::Mix(Sint16* _stream, int _numSamples)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    //only grows when the device asks for more than before, which it doesn't after the first mix
+    if (static_cast<int>(m_accumulator.size()) < _numSamples)
+    {
+      m_accumulator.resize(_numSamples);
+    }
+    std::fill(m_accumulator.begin(), m_accumulator.begin() + _numSamples, 0);
+
+    m_mixedFrames += _numSamples / m_numChannels;
+    bool mixedAny = false;
+    for (Voice& voice : m_voices)
+    {
+      if (!voice.chunk)
+      {
+        continue;
+      }
+      mixedAny = true;
+      //the samples are interleaved left and right, a mono output has the same gain in both
+      const int* gains = voice.channelGains;
+      int sample = 0;
+      while (sample < _numSamples && voice.chunk)
+      {
+        const Sint16* source = reinterpret_cast<const Sint16*>(voice.chunk->abuf + voice.position);
+        const int available = static_cast<int>((voice.chunk->alen - voice.position) / sizeof(Sint16));
+        const int count = std::min(available, _numSamples - sample);
+        for (int i = 0; i < count; i++)
+        {
+          m_accumulator[sample + i] += source[i] * gains[(sample + i) & 1];
+        }
+        sample += count;
+        voice.position += static_cast<Uint32>(count * sizeof(Sint16));
+        if (voice.chunk->alen - voice.position < sizeof(Sint16))
+        {
+          //the end of a play, it starts over or the voice is free
+          voice.position = 0;
+          if (voice.loops == 0)
+          {
+            voice.chunk = nullptr;
+          }
+          else if (voice.loops > 0)
+          {
+            voice.loops--;
+          }
+        }
+      }
+    }
+    if (!mixedAny)
+    {
+      return;
+    }
+    //the gains are 8 bit fixed point, the master volume shifts in another 8
+    for (int i = 0; i < _numSamples; i++)
+    {
+      const int mixed = _stream[i] + static_cast<int>((static_cast<long long>(m_accumulator[i]) * m_masterGain) >> 16);
+      _stream[i] = static_cast<Sint16>(std::min(std::max(mixed, -32768), 32767));
+    }
+  }
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <SDL\SDL_mixer.h>
+#include <glm\glm.hpp>
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace GameEngine
+{
+  class Camera2D;
+  class Camera3D;
+
+  //how a sound effect competes for the voices of the mixer
+  struct SoundSettings
+  {
+    int priority = 0;          ///< a sound only takes the voice of one with a lower priority (or the same, if it's as loud)
+    int maxInstances = 0;      ///< the most voices playing it at once, the oldest is restarted for a new one, 0 for no limit
+    float volume = 1.0f;       ///< 0 to 1
+    float maxDistance = 0.0f;  ///< from the listener, it's quieter the farther it is and not played (or virtualized) beyond, 0 plays it anywhere
+  };
+
+  /** \brief Mixes the sound effects itself, after SDL_mixer mixed the music (Mix_SetPostMix): a fixed pool of MAX_VOICES voices, so
+   *  the cost of a mix is bounded whatever is played. When the pool is full a new sound steals the voice of the least important one:
+   *  the lowest priority, then the quietest, then the oldest, or isn't played if they all matter more. A sound is culled by its
+   *  distance to the listener before it takes a voice, and panned by where it is from the listener.
+   *  The looping sounds placed in the world are sources: UpdateSources computes their gains in one pass and only the ones in range
+   *  take a voice, the others are virtual, so a scene can have hundreds of them. Played from the game's thread, mixed on the audio thread */
+  class AudioMixer
+  {
+  public:
+    static AudioMixer& Get();
+
+    enum : int { MAX_VOICES = 32 };
+
+    // Called by AudioEngine once the audio is open, returns false if the output format can't be mixed (the sounds then go to
+    // SDL_mixer's channels)
+    bool Init();
+    // Stops every voice and unhooks the mixer, before the audio is closed
+    void Destroy();
+    bool IsInitialized() const noexcept { return m_isInitialized; }
+
+    /** \brief Plays _chunk, _loops like Mix_PlayChannel (-1 forever, otherwise _loops + 1 times)
+     *  \param _position - where it's heard from, at the listener (see SetListener) it's in the middle
+     *  \return the voice, -1 if the sound was culled or every voice matters more */
+    int Play(Mix_Chunk* _chunk, const SoundSettings& _settings, int _loops, const glm::vec3& _position);
+    // Stops the voices playing _chunk and removes its sources, before it's freed
+    void Stop(Mix_Chunk* _chunk);
+    void StopAll();
+    // Whether a voice plays _chunk or a source (virtual or not) has it
+    bool IsPlaying(const Mix_Chunk* _chunk) const;
+
+    /** \brief Places _chunk looping at _position until RemoveSource. It's heard from the next UpdateSources, from wherever its loop
+     *  is: the loop goes on while the source is virtual, so it doesn't start over when the listener comes back in range
+     *  \return the id of the source, -1 if the chunk is empty */
+    int AddSource(Mix_Chunk* _chunk, const SoundSettings& _settings, const glm::vec3& _position);
+    void SetSourcePosition(int _source, const glm::vec3& _position) { m_sourcePositions[_source] = _position; }
+    void RemoveSource(int _source);
+    /** \brief Computes the gains of all the sources from the listener in one pass, then gives a voice to the ones in range and frees
+     *  the voices of the others (they're virtual, not mixed). IMainGame calls it every tick */
+    void UpdateSources();
+    int GetNumSources() const noexcept { return static_cast<int>(m_sourceChunks.size() - m_freeSources.size()); }
+    // The sources in range of the listener at the last UpdateSources, the rest are virtual
+    int GetNumAudibleSources() const noexcept { return m_numAudibleSources; }
+
+    /** \brief Where the sounds are heard from, the distance culling and the pan are relative to it
+     *  \param _right - the direction of the right ear, normalized */
+    void SetListener(const glm::vec3& _position, const glm::vec3& _right = glm::vec3(1.0f, 0.0f, 0.0f));
+    // The listener at the center of the camera, in the z = 0 plane of the 2D world
+    void SetListener(const Camera2D& _camera);
+    void SetListener(const Camera3D& _camera);
+    const glm::vec3& GetListener() const noexcept { return m_listener; }
+    // 0 to 1, applied to all the voices
+    void SetMasterVolume(float _volume);
+
+    int GetNumActiveVoices() const;
+    // The sounds which weren't played since Init because every voice mattered more, and the voices taken from a playing sound
+    std::uint64_t GetNumDropped() const noexcept { return m_numDropped; }
+    std::uint64_t GetNumStolen() const noexcept { return m_numStolen; }
+
+  private:
+    AudioMixer() {}
+
+    struct Voice
+    {
+      Mix_Chunk* chunk = nullptr; ///< nullptr for a free voice
+      Uint32 position = 0;        ///< the bytes of the chunk already mixed
+      int loops = 0;              ///< the plays left after this one, -1 forever
+      int priority = 0;
+      int gain = 0;               ///< the volume of the voice, the louder channel, 256 is 1
+      int channelGains[2]{ 0, 0 }; ///< left and right, panned
+      int source = -1;            ///< the source it plays, -1 for a sound of Play
+      std::uint64_t order = 0;    ///< when it started, the lowest is the oldest
+    };
+
+    //the post mix hook of SDL_mixer, adds the voices to the mixed stream
+    static void MixCallback(void* _mixer, Uint8* _stream, int _length);
+    void Mix(Sint16* _stream, int _numSamples);
+    //the gains of the left and right channels of a sound at _position, 256 is 1, both 0 if it's out of range
+    glm::ivec2 ComputeGains(const SoundSettings& _settings, const glm::vec3& _position) const;
+    //the first voice which doesn't play anything, -1 if none
+    int FindFreeVoice() const;
+    //the voice a sound of _priority and _gain takes when there isn't a free one, -1 if every voice matters more
+    int FindVoiceToSteal(int _priority, int _gain) const;
+    //releases the voice of the source if it still has it, with the lock
+    void ReleaseSourceVoice(int _source);
+
+    std::array<Voice, MAX_VOICES> m_voices;
+    std::vector<int> m_accumulator; ///< the voices are summed in it before they're clamped into the stream
+    mutable std::mutex m_mutex;     ///< the voices are shared with the audio thread
+    int m_numChannels{ 2 };         ///< of the output, a mono one isn't panned
+    std::uint64_t m_mixedFrames{ 0 }; ///< the clock of the sources, the sample frames mixed since Init
+
+    //the sources, by id, only touched by the game's thread. A free id has no chunk
+    std::vector<Mix_Chunk*> m_sourceChunks;
+    std::vector<glm::vec3> m_sourcePositions;
+    std::vector<SoundSettings> m_sourceSettings;
+    std::vector<std::uint64_t> m_sourceStarts; ///< m_mixedFrames when it was added, where it is in its loop follows from it
+    std::vector<int> m_sourceVoices;           ///< -1 while it's virtual
+    std::vector<glm::ivec2> m_sourceGains;     ///< computed by UpdateSources
+    std::vector<int> m_freeSources;
+    int m_numAudibleSources{ 0 };
+
+    glm::vec3 m_listener{ 0.0f };
+    glm::vec3 m_listenerRight{ 1.0f, 0.0f, 0.0f };
+    int m_masterGain{ 256 };
+    std::uint64_t m_nextOrder{ 0 };
+    std::uint64_t m_numDropped{ 0 };
+    std::uint64_t m_numStolen{ 0 };
+    bool m_isInitialized{ false };
+  };
+}
@@ -0,0 +1,196 @@
+#include "AudioStream.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace GameEngine
+{
+  //the most the thread copies at a time, so a read isn't held up by a long copy
+  static constexpr size_t FILL_CHUNK{ 16 * 1024 };
+
+  bool AudioStream::Open(const std::string& _filePath, size_t _ringSize)
+  {
+    Close();
+    if (!m_file.Open(_filePath))
+    {
+      return false;
+    }
+    m_data = m_file.GetData();
+    m_size = m_file.GetSize();
+    m_ring.resize(std::max<size_t>(_ringSize, 1));
+    m_head = 0;
+    m_position = 0;
+    m_generation = 0;
+    m_numUnderruns = 0;
+    m_stop = false;
+    //the decoder reads the header as soon as it's opened, the first bytes are already there for it
+    m_buffered = std::min(m_ring.size(), m_size);
+    std::memcpy(m_ring.data(), m_data, m_buffered);
+    m_thread = std::thread(&AudioStream::Fill, this);
+    return true;
+  }
+
+  void AudioStream::Close()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_readCondition.notify_one();
+    if (m_thread.joinable())
+    {
+      m_thread.join();
+    }
+    m_file.Close();
+    m_data = nullptr;
+    m_size = 0;
+    m_buffered = 0;
+    std::vector<unsigned char>().swap(m_ring);
+  }
+
+  SDL_RWops* AudioStream::CreateRWops()
+  {
+    SDL_RWops* rwops = SDL_AllocRW();
+    if (rwops == nullptr)
+    {
+      return nullptr;
+    }
+    rwops->type = SDL_RWOPS_UNKNOWN;
+    rwops->size = &AudioStream::RWSize;
+    rwops->seek = &AudioStream::RWSeek;
+    rwops->read = &AudioStream::RWRead;
+    rwops->write = &AudioStream::RWWrite;
+    rwops->close = &AudioStream::RWClose;
+    rwops->hidden.unknown.data1 = this;
+    return rwops;
+  }
+
+  size_t AudioStream::Read(void* _destination, size_t _bytes)
+  {
+    unsigned char* destination = static_cast<unsigned char*>(_destination);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    _bytes = std::min(_bytes, m_size - m_position);
+    size_t read = 0;
+    while (read < _bytes && m_buffered > 0)
+    {
+      const size_t count = std::min(std::min(_bytes - read, m_buffered), m_ring.size() - m_head);
+      std::memcpy(destination + read, m_ring.data() + m_head, count);
+      m_head = (m_head + count) % m_ring.size();
+      m_buffered -= count;
+      m_position += count;
+      read += count;
+    }
+    if (read < _bytes)
+    {
+      //the thread fell behind, the rest comes from the mapping and the filling starts over after it
+      std::memcpy(destination + read, m_data + m_position, _bytes - read);
+      m_position += _bytes - read;
+      m_generation++;
+      m_numUnderruns++;
+      read = _bytes;
+    }
+    m_readCondition.notify_one();
+    return read;
+  }
+
+  Sint64 AudioStream::Seek(Sint64 _offset, int _whence)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Sint64 target = _offset;
+    if (_whence == RW_SEEK_CUR)
+    {
+      target += static_cast<Sint64>(m_position);
+    }
+    else if (_whence == RW_SEEK_END)
+    {
+      target += static_cast<Sint64>(m_size);
+    }
+    if (target < 0 || target > static_cast<Sint64>(m_size))
+    {
+      SDL_SetError("AudioStream: seek out of the file");
+      return -1;
+    }
+    const size_t position = static_cast<size_t>(target);
+    if (position >= m_position && position - m_position <= m_buffered)
+    {
+      //forward into the buffered bytes, the ones skipped are dropped
+      const size_t skipped = position - m_position;
+      m_head = (m_head + skipped) % m_ring.size();
+      m_buffered -= skipped;
+    }
+    else
+    {
+      //anywhere else (the decoders look for the length at the end when they open) the ring is filled again from there
+      m_buffered = 0;
+      m_generation++;
+    }
+    m_position = position;
+    m_readCondition.notify_one();
+    return target;
+  }
+
+  void AudioStream::Fill()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+      m_readCondition.wait(lock, [this] { return m_stop || (m_buffered < m_ring.size() && m_position + m_buffered < m_size); });
+      if (m_stop)
+      {
+        return;
+      }
+      //the free bytes after the buffered ones, the reads never touch them
+      const size_t tail = (m_head + m_buffered) % m_ring.size();
+      const size_t offset = m_position + m_buffered;
+      const size_t count = std::min(std::min(m_ring.size() - m_buffered, m_ring.size() - tail), std::min(m_size - offset, FILL_CHUNK));
+      const std::uint64_t generation = m_generation;
+      lock.unlock();
+      //the pages of the mapping are read from the disk here, not on the audio thread
+      std::memcpy(m_ring.data() + tail, m_data + offset, count);
+      lock.lock();
+      if (generation == m_generation)
+      {
+        m_buffered += count;
+      }
+    }
+  }
+
+  Sint64 SDLCALL AudioStream::RWSize(SDL_RWops* _context)
+  {
+    return static_cast<Sint64>(static_cast<AudioStream*>(_context->hidden.unknown.data1)->GetSize());
+  }
+
+  Sint64 SDLCALL AudioStream::RWSeek(SDL_RWops* _context, Sint64 _offset, int _whence)
+  {
+    return static_cast<AudioStream*>(_context->hidden.unknown.data1)->Seek(_offset, _whence);
+  }
+
+  size_t SDLCALL AudioStream::RWRead(SDL_RWops* _context, void* _destination, size_t _size, size_t _count)
+  {
+    if (_size == 0)
+    {
+      return 0;
+    }
+    //SDL counts whole objects, a partial one at the end of the file is left unread
+    AudioStream* stream = static_cast<AudioStream*>(_context->hidden.unknown.data1);
+    size_t count = _count;
+    {
+      std::lock_guard<std::mutex> lock(stream->m_mutex);
+      count = std::min(count, (stream->m_size - stream->m_position) / _size);
+    }
+    return stream->Read(_destination, count * _size) / _size;
+  }
+
+  size_t SDLCALL AudioStream::RWWrite(SDL_RWops*, const void*, size_t, size_t)
+  {
+    SDL_SetError("AudioStream: the stream is read only");
+    return 0;
+  }
+
+  int SDLCALL AudioStream::RWClose(SDL_RWops* _context)
+  {
+    //the stream belongs to its owner, only the RWops goes
+    SDL_FreeRW(_context);
+    return 0;
+  }
+}
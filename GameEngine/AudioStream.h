@@ -0,0 +1,69 @@
+#pragma once
+#include <SDL\SDL_rwops.h>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "IOManager.h"
+
+namespace GameEngine
+{
+  /** \brief Streams a file to a decoder in chunks instead of loading it whole: the file is mapped (the loose one or its span in a pack,
+  * see MappedFile) and a thread of the stream copies the bytes ahead of the read into a small ring buffer, so the disk is read on that
+  * thread and the decoder on the audio thread only copies from memory. Only the ring buffer is resident, the OS drops the mapped pages
+  * already played when it needs them. A seek outside of the buffered bytes restarts the filling there, a read the thread didn't keep
+  * up with copies straight from the mapping */
+  class AudioStream
+  {
+  public:
+    //the bytes read ahead, a few seconds of a compressed song
+    static constexpr size_t DEFAULT_RING_SIZE{ 64 * 1024 };
+
+    AudioStream() {}
+    ~AudioStream() { Close(); }
+    AudioStream(const AudioStream&) = delete;
+    AudioStream& operator=(const AudioStream&) = delete;
+
+    // Maps the file and starts filling the ring buffer, false if it can't be opened
+    bool Open(const std::string& _filePath, size_t _ringSize = DEFAULT_RING_SIZE);
+    // Stops the thread and unmaps the file, the RWops of the stream mustn't be read after
+    void Close();
+
+    /** \brief An SDL_RWops reading the stream, for Mix_LoadMUS_RW. Closing it only frees the RWops, the stream stays open until Close */
+    SDL_RWops* CreateRWops();
+
+    size_t GetSize() const noexcept { return m_size; }
+    // The reads the thread didn't keep up with since Open, they were copied from the mapping on the reading thread
+    std::uint64_t GetNumUnderruns() const noexcept { return m_numUnderruns; }
+
+  private:
+    size_t Read(void* _destination, size_t _bytes);
+    Sint64 Seek(Sint64 _offset, int _whence);
+    void Fill();
+
+    static Sint64 SDLCALL RWSize(SDL_RWops* _context);
+    static Sint64 SDLCALL RWSeek(SDL_RWops* _context, Sint64 _offset, int _whence);
+    static size_t SDLCALL RWRead(SDL_RWops* _context, void* _destination, size_t _size, size_t _count);
+    static size_t SDLCALL RWWrite(SDL_RWops* _context, const void* _source, size_t _size, size_t _count);
+    static int SDLCALL RWClose(SDL_RWops* _context);
+
+    MappedFile m_file;
+    const unsigned char* m_data{ nullptr };
+    size_t m_size{ 0 };
+
+    std::vector<unsigned char> m_ring;
+    size_t m_head{ 0 };          ///< the index in the ring of the next byte read
+    size_t m_buffered{ 0 };      ///< the bytes in the ring from m_head on
+    size_t m_position{ 0 };      ///< the offset in the file of the next byte read, the ring holds the bytes after it
+    std::uint64_t m_generation{ 0 }; ///< bumped when the buffered bytes are dropped, a fill started before is thrown away
+    std::uint64_t m_numUnderruns{ 0 };
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_readCondition; ///< the thread waits on it for room in the ring
+    bool m_stop{ false };
+  };
+}
@@ -1,7 +1,17 @@
 #include "Cache.h"
+#include "GameEngine.h"
 #include "ImageLoader.h"
+#include "TextureCooker.h"
 #include "GLTexture.h"
 #include "AssimpLoader.h"
+#include "IOManager.h"
+#include "ModelCooker.h"
+#include "RenderState.h"
+#include "SamplerCache.h"
+#include "AudioEngine.h"
+#include "GameEngineErrors.h"
+
+#include <cstdio>
 
 namespace GameEngine
 {
@@ -16,29 +26,179 @@ namespace GameEngine
 
   GLTexture Cache::GetTexture(const std::string& _texturePath, bool _alpha)
   {
-    //lookup the texture and see if it's in the map
-    //std::map<std::string, GLTexture>::iterator mit = m_textureMap.find(_filePath);
-    auto mit = m_textureCache.find(_texturePath);
-    //check if it's not in the map
-    if (mit == m_textureCache.end())
+    return GetTexture(GetTextureId(_texturePath), _alpha);
+  }
+  GLTexture Cache::GetTexture(AssetId _texture, bool _alpha)
+  {
+    //nothing counts the copies handed out, so the texture is pinned until the cache is cleared
+    std::shared_ptr<GLTexture> texture = FindOrLoadTexture(_texture, _alpha);
+    m_pinnedTextures[_texture] = texture;
+    return *texture;
+  }
+  Handle<GLTexture> Cache::LoadTexture(const std::string& _texturePath, bool _alpha)
+  {
+    return LoadTexture(GetTextureId(_texturePath), _alpha);
+  }
+  Handle<GLTexture> Cache::LoadTexture(AssetId _texture, bool _alpha)
+  {
+    return Handle<GLTexture>(FindOrLoadTexture(_texture, _alpha));
+  }
+  Handle<GLTexture> Cache::LoadTextureAsync(const std::string& _texturePath, bool _alpha)
+  {
+    const AssetId id = AssetIds::Hash(_texturePath);
+    std::weak_ptr<GLTexture>* cached = m_textureCache.Find(id);
+    if (cached != nullptr)
     {
-      //if it's not in the map, then load the texture
-      GLTexture newTexture = ImageLoader::LoadPNG(_texturePath, _alpha);
-      //insert it into the map
-      m_textureCache.insert(std::make_pair(_texturePath, newTexture));
-      //return the new texture
-      return newTexture;
+      if (std::shared_ptr<GLTexture> texture = cached->lock())
+      {
+        return Handle<GLTexture>(texture);
+      }
     }
-    //if the texture is in the map, then
-    //return the already existing (cached) texture
-    return mit->second;
+    //nothing to stream to without a GPU, the size is read right away
+    if (IsHeadless())
+    {
+      return LoadTexture(AssetIds::Intern(_texturePath), _alpha);
+    }
+    std::shared_ptr<GLTexture> texture = m_asyncLoader.Load(_texturePath, _alpha, m_compressTextures);
+    m_textureCache[id] = texture;
+    AddTextureSource(id, _texturePath, _alpha);
+    return Handle<GLTexture>(texture);
+  }
+  GLTexture Cache::LoadTextureFile(const std::string& _texturePath, bool _alpha)
+  {
+    if (IsHeadless())
+    {
+      return LoadTextureSize(_texturePath, _alpha);
+    }
+    if (!m_compressTextures && !m_streamTextures && !TextureCooker::IsCompressed(_texturePath))
+    {
+      return ImageLoader::LoadPNG(_texturePath, _alpha);
+    }
+    CompressedImage image;
+    if (!TextureCooker::LoadCompressed(_texturePath, _alpha, image))
+    {
+      FatalError("Failed to load the compressed texture " + _texturePath);
+    }
+    GLTexture texture = {};
+    texture.width = image.width;
+    texture.height = image.height;
+    texture.id = m_streamTextures ? m_mipStreamer.Load(std::move(image), _alpha) : ImageLoader::UploadCompressed(image, _alpha);
+    texture.sampler = SamplerCache::Get().GetTextureSampler(_alpha);
+    texture.asset = AssetIds::Intern(_texturePath);
+    return texture;
+  }
+  GLTexture Cache::LoadTextureSize(const std::string& _texturePath, bool _alpha)
+  {
+    //the game logic may size things by their texture (e.g. the sprites' bounds), so the image is read for it and dropped
+    GLTexture texture = {};
+    texture.asset = AssetIds::Intern(_texturePath);
+    CompressedImage image;
+    if (TextureCooker::IsCompressed(_texturePath) && TextureCooker::LoadCompressed(_texturePath, _alpha, image))
+    {
+      texture.width = image.width;
+      texture.height = image.height;
+      return texture;
+    }
+    unsigned char* pixels = ImageLoader::DecodeImage(_texturePath, _alpha, texture.width, texture.height);
+    if (pixels == nullptr)
+    {
+      FatalError("Failed to load the texture " + _texturePath);
+    }
+    ImageLoader::FreeImage(pixels);
+    return texture;
+  }
+  void Cache::UpdateAsyncLoads()
+  {
+    m_asyncLoader.Upload();
+    m_mipStreamer.Update();
+  }
+  AssetId Cache::GetTextureId(const std::string& _texturePath) const
+  {
+    const AssetId id = AssetIds::Hash(_texturePath);
+    return m_textureCache.Find(id) != nullptr ? id : AssetIds::Intern(_texturePath);
+  }
+  std::shared_ptr<GLTexture> Cache::FindTexture(AssetId _texture)
+  {
+    //lookup the texture and see if it's still loaded
+    std::weak_ptr<GLTexture>* cached = m_textureCache.Find(_texture);
+    std::shared_ptr<GLTexture> texture = cached != nullptr ? cached->lock() : nullptr;
+    //a texture still loading asynchronously is finished now, the caller wants the real one
+    if (texture && m_asyncLoader.IsPending(*texture))
+    {
+      m_asyncLoader.Finish(*texture);
+    }
+    return texture;
+  }
+  std::shared_ptr<GLTexture> Cache::FindOrLoadTexture(AssetId _texture, bool _alpha)
+  {
+    if (std::shared_ptr<GLTexture> texture = FindTexture(_texture))
+    {
+      return texture;
+    }
+    //if it's not, then load the texture, the last reference to it deletes the GL texture
+    const std::string& texturePath = AssetIds::GetName(_texture);
+    MipStreamer* mipStreamer = &m_mipStreamer;
+    std::shared_ptr<GLTexture> texture(new GLTexture(LoadTextureFile(texturePath, _alpha)), [mipStreamer](GLTexture* _texture)
+    {
+      //a headless texture has no GL object
+      if (_texture->id != 0)
+      {
+        mipStreamer->Forget(_texture->id);
+        _texture->Dispose();
+      }
+      delete _texture;
+    });
+    m_textureCache[_texture] = texture;
+    AddTextureSource(_texture, texturePath, _alpha);
+    return texture;
+  }
+  void Cache::AddTextureSource(AssetId _texture, const std::string& _texturePath, bool _alpha)
+  {
+    TextureSource& source = m_textureSources[_texture];
+    source.alpha = _alpha;
+    source.compressed = m_compressTextures || m_streamTextures || TextureCooker::IsCompressed(_texturePath);
+    IOManager::WatchFile(_texturePath);
+  }
+  void Cache::PackTextureArray(const std::vector<std::string>& _texturePaths, bool _alpha)
+  {
+    std::vector<std::string> toPack;
+    for (const auto& path : _texturePaths)
+    {
+      const std::weak_ptr<GLTexture>* cached = m_textureCache.Find(AssetIds::Hash(path));
+      if (cached == nullptr || cached->expired())
+      {
+        toPack.push_back(path);
+      }
+    }
+    std::vector<GLTexture> layers = ImageLoader::LoadTextureArray(toPack, _alpha);
+    if (layers.empty())
+    {
+      return;
+    }
+    m_textureArrays.push_back(layers.front().id);
+    for (const auto& layer : layers)
+    {
+      //the layers share the id of their array, which is deleted with the others in ClearCache, so they're pinned until then
+      auto texture = std::make_shared<GLTexture>(layer);
+      m_textureCache[layer.asset] = texture;
+      m_pinnedTextures[layer.asset] = texture;
+    }
+  }
+  AtlasRegion Cache::GetAtlasRegion(const std::string& _texturePath)
+  {
+    return m_atlas.Add(_texturePath);
+  }
+  void Cache::FinalizeAtlas()
+  {
+    m_atlas.Finalize();
   }
   GLCubemap Cache::GetCubemap(const std::string& _directory, const std::string& _posXFilename, const std::string& _negXFilename, const std::string& _posYFilename,
     const std::string& _negYFilename, const std::string& _posZFilename, const std::string& _negZFilename, const std::string& _cubemapName)
   {
-    auto it = m_cubemapCache.find(_cubemapName);
+    const AssetId id = AssetIds::Hash(_cubemapName);
+    const GLCubemap* cached = m_cubemapCache.Find(id);
     //check if it's not in the map
-    if (it == m_cubemapCache.end())
+    if (cached == nullptr)
     {
       //if it's not in the map, then load the texture
       GLCubemap newCubemap = ImageLoader::LoadCubemap( _directory,
@@ -49,82 +209,321 @@ namespace GameEngine
         _posZFilename,
         _negZFilename);
       //insert it into the map
-      m_cubemapCache.insert(std::make_pair(_cubemapName, newCubemap));
+      m_cubemapCache[id] = newCubemap;
       //return the new texture
       return newCubemap;
     }
     //if the texture is in the map, then
     //return the already existing (cached) texture
-    return it->second;
+    return *cached;
   }
-  void Cache::GetSkinnedModel(const std::string& _filePath, SkinnedModel* _model)
+  void Cache::GetSkinnedModel(const std::string& _filePath, SkinnedModel* _model, bool _keepCpuData)
   {
-    auto it = m_skinnedModelCache.find(_filePath);
-    //check if it's not in the map
-    if (it == m_skinnedModelCache.end())
+    std::shared_ptr<SkeletonAsset> asset = FindOrLoadSkeleton(_filePath, _keepCpuData);
+    if (asset)
     {
-      //if it's not in the map, then load the texture
-      AssimpLoader loader;
-      if (loader.LoadSkinnedModel(_filePath, _model))
+      //the model only gets its own animation state, the meshes and clips are the cached ones
+      _model->SetAsset(asset);
+    }
+  }
+  Handle<SkeletonAsset> Cache::LoadSkinnedAsset(const std::string& _filePath, bool _keepCpuData)
+  {
+    return Handle<SkeletonAsset>(FindOrLoadSkeleton(_filePath, _keepCpuData));
+  }
+  std::shared_ptr<SkeletonAsset> Cache::FindOrLoadSkeleton(const std::string& _filePath, bool _keepCpuData)
+  {
+    const AssetId id = AssetIds::Hash(_filePath);
+    std::weak_ptr<SkeletonAsset>* cached = m_skinnedModelCache.Find(id);
+    std::shared_ptr<SkeletonAsset> asset = cached != nullptr ? cached->lock() : nullptr;
+    //check if it's not loaded (or all the models using it are gone)
+    if (!asset)
+    {
+      //then load the asset, from the cooked file unless the source changed since it was cooked
+      asset = std::make_shared<SkeletonAsset>();
+      const std::string cookedPath = ModelCooker::GetCookedPath(_filePath);
+      if (!IOManager::IsNewerThan(cookedPath, _filePath) || !ModelCooker::LoadSkinnedModel(cookedPath, asset.get(), _keepCpuData))
       {
-        //insert it into the map
-        m_skinnedModelCache.insert(std::make_pair(_filePath, _model));
-        return;
+        //the cooking needs the vertices, they're freed after it unless they're kept anyway
+        AssimpLoader loader;
+        loader.SetKeepCpuData(true);
+        if (!loader.LoadSkinnedModel(_filePath, asset.get()))
+        {
+          return nullptr;
+        }
+        ModelCooker::WriteSkinnedModel(cookedPath, *asset);
+        if (!_keepCpuData)
+        {
+          asset->ReleaseCpuData();
+        }
       }
-      return;
+      m_skinnedModelCache[id] = asset;
+      IOManager::WatchFile(_filePath);
     }
-    //if the texture is in the map, then
-    //return the already existing (cached) texture
-    _model = it->second;
-    return;
+    return asset;
   }
 
-  void Cache::GetStaticModel(const std::string & _filePath, StaticModel* _model)
+  void Cache::GetStaticModel(const std::string & _filePath, StaticModel* _model, bool _keepCpuData)
   {
-    auto it = m_staticModelCache.find(_filePath);
-    //check if it's not in the map
-    if (it == m_staticModelCache.end())
+    //the caller owns the model (and changes its transform), so it's loaded into it instead of sharing one, LoadStaticModel shares
+    LoadStaticModelFile(_filePath, _model, _keepCpuData);
+  }
+
+  Handle<StaticModel> Cache::LoadStaticModel(const std::string& _filePath, bool _keepCpuData)
+  {
+    const AssetId id = AssetIds::Hash(_filePath);
+    std::weak_ptr<StaticModel>* cached = m_staticModelCache.Find(id);
+    if (cached != nullptr)
     {
-      //if it's not in the map, then load the texture
-      AssimpLoader loader;
-      if (loader.LoadStaticModel(_filePath, _model))
+      if (std::shared_ptr<StaticModel> model = cached->lock())
       {
-        //insert it into the map
-        m_staticModelCache.insert(std::make_pair(_filePath, _model));
+        return Handle<StaticModel>(model);
+      }
+    }
+    //not loaded, or the last handle to it is gone
+    auto model = std::make_shared<StaticModel>();
+    if (!LoadStaticModelFile(_filePath, model.get(), _keepCpuData))
+    {
+      return Handle<StaticModel>();
+    }
+    m_staticModelCache[id] = model;
+    IOManager::WatchFile(_filePath);
+    return Handle<StaticModel>(model);
+  }
+
+  bool Cache::LoadStaticModelFile(const std::string& _filePath, StaticModel* _model, bool _keepCpuData)
+  {
+    //from the cooked file unless the source changed since it was cooked
+    const std::string cookedPath = ModelCooker::GetCookedPath(_filePath);
+    if (IOManager::IsNewerThan(cookedPath, _filePath) && ModelCooker::LoadStaticModel(cookedPath, _model, _keepCpuData))
+    {
+      return true;
+    }
+    //the cooking needs the vertices, they're freed after it unless they're kept anyway
+    AssimpLoader loader;
+    loader.SetKeepCpuData(true);
+    if (!loader.LoadStaticModel(_filePath, _model))
+    {
+      return false;
+    }
+    ModelCooker::WriteStaticModel(cookedPath, *_model);
+    if (!_keepCpuData)
+    {
+      _model->ReleaseCpuData();
+    }
+    return true;
+  }
+  void Cache::Preload(const AssetManifest& _manifest, PreloadedAssets& _assets, AudioEngine* _audio)
+  {
+    //the textures first, all of them: the loader thread decodes them while the models load here, and the models find the textures of
+    //their materials on their way (see AssetManifest::ResolveDependencies)
+    const std::vector<AssetManifest::Asset>& assets = _manifest.GetAssets();
+    for (const auto& asset : assets)
+    {
+      if (asset.type == AssetManifest::AssetType::TEXTURE)
+      {
+        _assets.textures.push_back(LoadTextureAsync(asset.path, asset.alpha));
+      }
+    }
+    for (const auto& asset : assets)
+    {
+      switch (asset.type)
+      {
+      case AssetManifest::AssetType::STATIC_MODEL:
+      {
+        Handle<StaticModel> model = LoadStaticModel(asset.path);
+        if (model)
+        {
+          _assets.models.push_back(model);
+        }
+        break;
+      }
+      case AssetManifest::AssetType::SKINNED_MODEL:
+      {
+        Handle<SkeletonAsset> skeleton = LoadSkinnedAsset(asset.path);
+        if (skeleton)
+        {
+          _assets.skeletons.push_back(skeleton);
+        }
+        break;
+      }
+      case AssetManifest::AssetType::SOUND_EFFECT:
+        if (_audio != nullptr)
+        {
+          _audio->LoadSoundEffect(asset.path);
+        }
+        break;
+      case AssetManifest::AssetType::MUSIC:
+        if (_audio != nullptr)
+        {
+          _audio->LoadMusic(asset.path);
+        }
+        break;
+      default:
+        break;
+      }
+    }
+    //the screen starts with the real textures, not the placeholders
+    for (const auto& texture : _assets.textures)
+    {
+      if (m_asyncLoader.IsPending(*texture))
+      {
+        m_asyncLoader.Finish(*texture);
+      }
+    }
+  }
+  void Cache::ReloadChangedFiles(const std::vector<std::string>& _changedFiles)
+  {
+    for (const auto& filePath : _changedFiles)
+    {
+      //a file may be used as more than one kind of asset
+      const AssetId id = AssetIds::Hash(filePath);
+      if (std::weak_ptr<GLTexture>* cached = m_textureCache.Find(id))
+      {
+        if (std::shared_ptr<GLTexture> texture = cached->lock())
+        {
+          ReloadTexture(filePath, *texture);
+        }
+      }
+      if (std::weak_ptr<StaticModel>* cached = m_staticModelCache.Find(id))
+      {
+        if (std::shared_ptr<StaticModel> model = cached->lock())
+        {
+          ReloadStaticModel(filePath, *model);
+        }
+      }
+      if (std::weak_ptr<SkeletonAsset>* cached = m_skinnedModelCache.Find(id))
+      {
+        if (std::shared_ptr<SkeletonAsset> asset = cached->lock())
+        {
+          ReloadSkinnedAsset(filePath, *asset);
+        }
+      }
+    }
+  }
+  void Cache::ReloadTexture(const std::string& _texturePath, GLTexture& _texture)
+  {
+    //the layers share their array, and a texture still loading reads the new file anyway
+    const TextureSource* source = m_textureSources.Find(_texture.asset);
+    if (source == nullptr || _texture.layer >= 0 || m_asyncLoader.IsPending(_texture))
+    {
+      return;
+    }
+    GLuint id = 0;
+    int width = 0;
+    int height = 0;
+    if (source->compressed)
+    {
+      CompressedImage image;
+      if (!TextureCooker::LoadCompressed(_texturePath, source->alpha, image))
+      {
+        std::printf("ERROR::HOT_RELOAD::Failed to load the compressed texture %s\n", _texturePath.c_str());
+        return;
+      }
+      id = ImageLoader::UploadCompressed(image, source->alpha);
+      width = image.width;
+      height = image.height;
+    }
+    else
+    {
+      unsigned char* pixels = ImageLoader::DecodeImage(_texturePath, source->alpha, width, height);
+      if (pixels == nullptr)
+      {
+        std::printf("ERROR::HOT_RELOAD::Failed to decode the texture %s\n", _texturePath.c_str());
+        return;
+      }
+      //the same size fits the storage it has, then even the copies handed out by value show the new pixels
+      if (width == _texture.width && height == _texture.height)
+      {
+        ImageLoader::UpdateTexture(_texture.id, pixels, width, height, source->alpha);
+        ImageLoader::FreeImage(pixels);
         return;
       }
+      id = ImageLoader::UploadTexture(pixels, width, height, source->alpha);
+      ImageLoader::FreeImage(pixels);
+    }
+    //a new texture in the same object: the handles see it, the copies by value keep the old one until they fetch it again.
+    //The reloaded one has all its levels, the old one isn't streamed anymore
+    const GLuint oldId = _texture.id;
+    m_mipStreamer.Forget(oldId);
+    _texture.id = id;
+    _texture.width = width;
+    _texture.height = height;
+    const std::shared_ptr<GLTexture>* pinned = m_pinnedTextures.Find(_texture.asset);
+    if (pinned != nullptr && *pinned)
+    {
+      m_retiredTextures.push_back(oldId);
+    }
+    else
+    {
+      RenderState::Get().DeleteTextures(1, &oldId);
+    }
+  }
+  void Cache::ReloadStaticModel(const std::string& _filePath, StaticModel& _model)
+  {
+    //the source is newer than its cooked file now, so it's imported and cooked again
+    const bool keepCpuData = !_model.GetMeshes().empty() && _model.GetMeshes().front().HasCpuData();
+    StaticModel reloaded;
+    if (!LoadStaticModelFile(_filePath, &reloaded, keepCpuData))
+    {
+      std::printf("ERROR::HOT_RELOAD::Failed to load the model %s\n", _filePath.c_str());
       return;
     }
-    //if the texture is in the map, then
-    //return the already existing (cached) texture
-    _model = it->second;
-    return;
+    //the old meshes are freed with reloaded
+    _model.SwapMeshes(reloaded);
   }
-  void Cache::ClearCache()
+  void Cache::ReloadSkinnedAsset(const std::string& _filePath, SkeletonAsset& _asset)
   {
-    for (auto& texture : m_textureCache)
+    const bool keepCpuData = !_asset.GetMeshes().empty() && _asset.GetMeshes().front().HasCpuData();
+    SkeletonAsset reloaded;
+    AssimpLoader loader;
+    loader.SetKeepCpuData(true);
+    if (!loader.LoadSkinnedModel(_filePath, &reloaded))
     {
-      texture.second.Dispose();
+      std::printf("ERROR::HOT_RELOAD::Failed to load the skinned model %s\n", _filePath.c_str());
+      return;
     }
-    m_textureCache.clear();
-
-    for (auto& cubemap : m_cubemapCache)
+    //the models playing it keep their animation state, which only fits clips of the same shape
+    if (!_asset.HasSameClips(reloaded))
+    {
+      std::printf("ERROR::HOT_RELOAD::The clips of %s changed, restart to load them\n", _filePath.c_str());
+      return;
+    }
+    ModelCooker::WriteSkinnedModel(ModelCooker::GetCookedPath(_filePath), reloaded);
+    if (!keepCpuData)
     {
-      cubemap.second.Dispose();
+      reloaded.ReleaseCpuData();
     }
-    m_cubemapCache.clear();
-
-    for (auto& staticModel : m_staticModelCache)
+    _asset.Swap(reloaded);
+  }
+  void Cache::ClearCache()
+  {
+    //the textures only the pins hold are deleted here, the ones handles still refer to go with their last handle
+    m_pinnedTextures.Clear();
+    m_textureCache.Clear();
+    m_textureSources.Clear();
+    if (!m_retiredTextures.empty())
     {
-      staticModel.second->Dispose();
+      RenderState::Get().DeleteTextures(static_cast<GLsizei>(m_retiredTextures.size()), m_retiredTextures.data());
+      m_retiredTextures.clear();
     }
-    m_staticModelCache.clear();
 
-    for (auto& skinnedModel : m_skinnedModelCache)
+    if (!m_textureArrays.empty())
     {
-      skinnedModel.second->Dispose();
+      RenderState::Get().DeleteTextures(static_cast<GLsizei>(m_textureArrays.size()), m_textureArrays.data());
+      m_textureArrays.clear();
     }
-    m_skinnedModelCache.clear();
+
+    m_atlas.Dispose();
+    m_asyncLoader.DisposeStreaming();
+
+    m_cubemapCache.ForEach([](AssetId, GLCubemap& _cubemap) { _cubemap.Dispose(); });
+    m_cubemapCache.Clear();
+
+    //the models belong to their handles (and the skinned models pointing to the assets), they're only forgotten here
+    m_staticModelCache.Clear();
+    m_skinnedModelCache.Clear();
+
+    SamplerCache::Get().Dispose();
   }
 }
 
@@ -1,14 +1,25 @@
 #pragma once
-#include <map>
+#include <GL\glew.h>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include "AssetHandle.h"
+#include "AssetManifest.h"
+#include "AssetMap.h"
+#include "AsyncTextureLoader.h"
+#include "MipStreamer.h"
+#include "TextureAtlas.h"
+
 namespace GameEngine
 {
   //This caches the textures so that multiple sprites can use the same textures
   struct GLTexture;
   struct GLCubemap;
   class SkinnedModel;
+  class SkeletonAsset;
   class StaticModel;
+  class AudioEngine;
 
   class Cache
   {
@@ -16,19 +27,91 @@ namespace GameEngine
     Cache();
     ~Cache();
     //gets the texture in the filepath passed(or returns an already cached texture without loading a new one)
+    //a texture fetched by value can't be counted, so it stays loaded until ClearCache
     GLTexture GetTexture(const std::string& _texturePath, bool _alpha);
+    //like the path version, without hashing the path (the id has to come from AssetIds::Intern, its name is loaded)
+    GLTexture GetTexture(AssetId _texture, bool _alpha);
+    //gets a counted handle to the texture, loaded once and freed with the last handle (unless GetTexture pinned it)
+    Handle<GLTexture> LoadTexture(const std::string& _texturePath, bool _alpha);
+    Handle<GLTexture> LoadTexture(AssetId _texture, bool _alpha);
+    //like LoadTexture, but the image is decoded on the loader thread and the handle shows a placeholder until UpdateAsyncLoads uploads it
+    Handle<GLTexture> LoadTextureAsync(const std::string& _texturePath, bool _alpha);
+    //streams the decoded async loads to the GPU and the requested mip levels of the streamed textures, once per frame
+    void UpdateAsyncLoads();
+    size_t GetNumPendingLoads() const { return m_asyncLoader.GetNumPending(); }
+    //the textures loaded from then on are block compressed, through their cooked files (see TextureCooker)
+    void SetCompressTextures(bool _compress) { m_compressTextures = _compress; }
+    //the textures loaded from then on (not the async ones) stream their large mip levels as the screen needs them, through their
+    //cooked files like the compressed ones (see MipStreamer)
+    void SetStreamTextures(bool _stream) { m_streamTextures = _stream; }
+    MipStreamer& GetMipStreamer() noexcept { return m_mipStreamer; }
+    //packs the textures into one texture array, GetTexture then returns the array id and the layer (already cached paths are left as they are)
+    void PackTextureArray(const std::vector<std::string>& _texturePaths, bool _alpha);
+    //gets the atlas region of the texture, packing it into the atlas on the first request
+    AtlasRegion GetAtlasRegion(const std::string& _texturePath);
+    //generates the mipmaps of the atlas pages (after the level load has packed everything)
+    void FinalizeAtlas();
     GLCubemap GetCubemap(const std::string& _directory, const std::string& _posXFilename, const std::string& _negXFilename,
       const std::string& _posYFilename, const std::string& _negYFilename, const std::string& _posZFilename,
       const std::string& _negZFilename, const std::string& _cubemapName);
-    void GetSkinnedModel(const std::string& _filePath, SkinnedModel* _model);
-    void GetStaticModel(const std::string& _filePath, StaticModel* _model);
+    //points the skinned model to the asset of the filepath (loaded once, all the models of a file share its meshes and clips)
+    //the meshes only keep their vertices on the CPU with _keepCpuData, for a shared asset the first request decides
+    void GetSkinnedModel(const std::string& _filePath, SkinnedModel* _model, bool _keepCpuData = false);
+    //gets a counted handle to the skinned model asset of the filepath, the one GetSkinnedModel points the models to (an empty handle if it fails)
+    Handle<SkeletonAsset> LoadSkinnedAsset(const std::string& _filePath, bool _keepCpuData = false);
+    //loads the static model of the filepath into the passed model, every model passed gets its own copy of the meshes
+    void GetStaticModel(const std::string& _filePath, StaticModel* _model, bool _keepCpuData = false);
+    //gets a counted handle to the static model of the filepath, all the handles of a file share one model (an empty handle if it fails)
+    //the meshes only keep their vertices on the CPU with _keepCpuData, for a shared model the first request decides
+    Handle<StaticModel> LoadStaticModel(const std::string& _filePath, bool _keepCpuData = false);
+
+    //loads all the assets of the manifest into _assets, the images decode in the background while the models load
+    //the sounds go to the cache of _audio, they're skipped without one
+    void Preload(const AssetManifest& _manifest, PreloadedAssets& _assets, AudioEngine* _audio);
+
+    //loads the changed files of the loaded textures and shared models again, into the same objects so their handles stay valid
+    //(the texture arrays, atlas pages, cubemaps and the models loaded into the caller's own StaticModel aren't reloaded)
+    void ReloadChangedFiles(const std::vector<std::string>& _changedFiles);
 
+    //lets go of everything the cache holds itself, the assets still referenced by handles stay until their last handle is gone
     void ClearCache();
   private:
-    std::map<std::string, GLTexture> m_textureCache; //< texture cache
-    std::map<std::string, GLCubemap> m_cubemapCache;
-    std::map<std::string, SkinnedModel*> m_skinnedModelCache;
-    std::map<std::string, StaticModel*> m_staticModelCache;
+    //the id of the path, it's only interned when the texture isn't cached (its load needs the name then)
+    AssetId GetTextureId(const std::string& _texturePath) const;
+    std::shared_ptr<GLTexture> FindTexture(AssetId _texture);
+    std::shared_ptr<GLTexture> FindOrLoadTexture(AssetId _texture, bool _alpha);
+    std::shared_ptr<SkeletonAsset> FindOrLoadSkeleton(const std::string& _filePath, bool _keepCpuData);
+    GLTexture LoadTextureFile(const std::string& _texturePath, bool _alpha);
+    //the texture without a GL object, only its size, for the headless runs
+    GLTexture LoadTextureSize(const std::string& _texturePath, bool _alpha);
+    bool LoadStaticModelFile(const std::string& _filePath, StaticModel* _model, bool _keepCpuData);
+    //remembers how the texture was loaded and watches its file for the reloads
+    void AddTextureSource(AssetId _texture, const std::string& _texturePath, bool _alpha);
+    void ReloadTexture(const std::string& _texturePath, GLTexture& _texture);
+    void ReloadStaticModel(const std::string& _filePath, StaticModel& _model);
+    void ReloadSkinnedAsset(const std::string& _filePath, SkeletonAsset& _asset);
+
+    //how a texture was loaded, a reload loads it the same way
+    struct TextureSource
+    {
+      bool alpha{ true };
+      bool compressed{ false };
+    };
+
+    //all keyed by the hash of the path (or the name of the cubemap)
+    AssetMap<std::weak_ptr<GLTexture>> m_textureCache; ///< every loaded texture, alive while a handle or a pin refers to it
+    AssetMap<std::shared_ptr<GLTexture>> m_pinnedTextures; ///< the textures handed out by value and the array layers
+    AssetMap<TextureSource> m_textureSources;
+    std::vector<GLuint> m_retiredTextures; ///< replaced by a reload while copies of them were handed out by value, deleted with the cache
+    AsyncTextureLoader m_asyncLoader;
+    bool m_compressTextures{ false };
+    MipStreamer m_mipStreamer;
+    bool m_streamTextures{ false };
+    std::vector<GLuint> m_textureArrays; ///< texture arrays created by PackTextureArray (shared by all their layers)
+    TextureAtlas m_atlas; ///< runtime atlas for the textures requested with GetAtlasRegion
+    AssetMap<GLCubemap> m_cubemapCache;
+    AssetMap<std::weak_ptr<SkeletonAsset>> m_skinnedModelCache; ///< alive while a skinned model points to it
+    AssetMap<std::weak_ptr<StaticModel>> m_staticModelCache;    ///< alive while a handle refers to it
   };
 }
 
@@ -1,5 +1,10 @@
 #include "Camera2D.h"
 
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#include <xmmintrin.h>
+#define CAMERA_USE_SSE
+#endif
+
 namespace GameEngine
 { //initialize the camera with some default values to avoid errors
   Camera2D::Camera2D()
@@ -83,4 +88,47 @@ namespace GameEngine
     }
     return false;
   }
+
+  void Camera2D::CullBoxes(const std::vector<glm::vec4>& _boxes, std::vector<std::uint32_t>& _visible) const
+  {
+    //the same test as IsBoxInView against the edges of the view: the box starts before the view ends and ends after it starts
+    const glm::vec4 view = GetViewRect();
+    const glm::vec2 viewMin(view.x, view.y);
+    const glm::vec2 viewMax = viewMin + glm::vec2(view.z, view.w);
+    const std::uint32_t numBoxes = static_cast<std::uint32_t>(_boxes.size());
+    std::uint32_t i = 0;
+#ifdef CAMERA_USE_SSE
+    const __m128 minX = _mm_set1_ps(viewMin.x);
+    const __m128 minY = _mm_set1_ps(viewMin.y);
+    const __m128 maxX = _mm_set1_ps(viewMax.x);
+    const __m128 maxY = _mm_set1_ps(viewMax.y);
+    for (; i + 4 <= numBoxes; i += 4)
+    {
+      //four boxes in, four x, y, widths and heights out
+      __m128 x = _mm_loadu_ps(&_boxes[i].x);
+      __m128 y = _mm_loadu_ps(&_boxes[i + 1].x);
+      __m128 width = _mm_loadu_ps(&_boxes[i + 2].x);
+      __m128 height = _mm_loadu_ps(&_boxes[i + 3].x);
+      _MM_TRANSPOSE4_PS(x, y, width, height);
+      const __m128 inX = _mm_and_ps(_mm_cmplt_ps(x, maxX), _mm_cmpgt_ps(_mm_add_ps(x, width), minX));
+      const __m128 inY = _mm_and_ps(_mm_cmplt_ps(y, maxY), _mm_cmpgt_ps(_mm_add_ps(y, height), minY));
+      int mask = _mm_movemask_ps(_mm_and_ps(inX, inY));
+      for (std::uint32_t lane = i; mask != 0; mask >>= 1, lane++)
+      {
+        if (mask & 1)
+        {
+          _visible.push_back(lane);
+        }
+      }
+    }
+#endif
+    for (; i < numBoxes; i++)
+    {
+      const glm::vec4& box = _boxes[i];
+      if (box.x < viewMax.x && box.x + box.z > viewMin.x && box.y < viewMax.y && box.y + box.w > viewMin.y)
+      {
+        _visible.push_back(i);
+      }
+    }
+  }
 }
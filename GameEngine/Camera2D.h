@@ -2,6 +2,8 @@
 
 #include <glm\glm.hpp>
 #include <glm\gtc\matrix_transform.hpp>
+#include <cstdint>
+#include <vector>
 
 namespace GameEngine
 {
@@ -25,6 +27,17 @@ namespace GameEngine
     //checks if the box is in view
     bool IsBoxInView(const glm::vec2& _position, const glm::vec2& _dimensions);
 
+    //IsBoxInView for many boxes in one pass, four at a time with SSE. The boxes are (bottom left x, y, width, height) and the indices
+    //of the visible ones are appended to _visible in order
+    void CullBoxes(const std::vector<glm::vec4>& _boxes, std::vector<std::uint32_t>& _visible) const;
+
+    //the visible world space rect (bottom left x, y, width, height)
+    glm::vec4 GetViewRect() const
+    {
+      glm::vec2 scaledScreenDimensions = glm::vec2(m_screenWidth, m_screenHeight) / m_scale;
+      return glm::vec4(m_position - scaledScreenDimensions / 2.0f, scaledScreenDimensions);
+    }
+
     //offsets the position of the camera
     void OffsetPosition(const glm::vec2& _offset) { m_position += _offset; m_needsMatrixUpdate = true; }
 
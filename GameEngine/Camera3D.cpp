@@ -2,6 +2,7 @@
 #include <SDL\SDL_mouse.h>
 #include <SDL\SDL_events.h>
 #include <iostream>
+#include <limits>
 namespace GameEngine
 {
   Camera3D::Camera3D()
@@ -34,7 +35,8 @@ namespace GameEngine
     m_screenHeight = _screenHeight;
     m_initialFoV = _fov;
     //projection matrix
-    m_projectionMatrix = glm::perspective(glm::radians(m_initialFoV), GetAspectRatio(), 0.1f, 100.0f);
+    m_projectionMatrix = glm::perspective(glm::radians(m_initialFoV), GetAspectRatio(), m_nearPlane, m_farPlane);
+    m_needsMatrixUpdate = true;
 
     SDL_SetRelativeMouseMode(_relativeMM);
   }
@@ -44,9 +46,67 @@ namespace GameEngine
     if (m_needsMatrixUpdate)
     {
       m_viewMatrix = glm::lookAt(m_position, m_position + m_direction, m_up);
+      //once per change instead of for every culled draw
+      m_frustumPlanes = ExtractFrustumPlanes(m_projectionMatrix * m_viewMatrix);
       m_needsMatrixUpdate = false;
     }
   }
+
+  std::array<glm::vec4, 6> Camera3D::ExtractFrustumPlanes(const glm::mat4& _viewProjection)
+  {
+    //the planes are sums of the rows of the view projection matrix (Gribb & Hartmann)
+    const glm::vec4 rowX(_viewProjection[0][0], _viewProjection[1][0], _viewProjection[2][0], _viewProjection[3][0]);
+    const glm::vec4 rowY(_viewProjection[0][1], _viewProjection[1][1], _viewProjection[2][1], _viewProjection[3][1]);
+    const glm::vec4 rowZ(_viewProjection[0][2], _viewProjection[1][2], _viewProjection[2][2], _viewProjection[3][2]);
+    const glm::vec4 rowW(_viewProjection[0][3], _viewProjection[1][3], _viewProjection[2][3], _viewProjection[3][3]);
+
+    std::array<glm::vec4, 6> planes = { rowW + rowX, rowW - rowX, rowW + rowY, rowW - rowY, rowW + rowZ, rowW - rowZ };
+    for (auto& plane : planes)
+    {
+      plane /= glm::length(glm::vec3(plane));
+    }
+    return planes;
+  }
+
+  bool Camera3D::IsSphereInFrustum(const std::array<glm::vec4, 6>& _planes, const glm::vec3& _center, float _radius)
+  {
+    for (const glm::vec4& plane : _planes)
+    {
+      if (glm::dot(glm::vec3(plane), _center) + plane.w < -_radius)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool Camera3D::IsBoxInFrustum(const std::array<glm::vec4, 6>& _planes, const AABB& _box)
+  {
+    const glm::vec3& min = _box.GetMin();
+    const glm::vec3& max = _box.GetMax();
+    for (const glm::vec4& plane : _planes)
+    {
+      //the corner furthest along the normal, the box is outside when even it is behind the plane
+      const glm::vec3 corner(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y, plane.z >= 0.0f ? max.z : min.z);
+      if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  float Camera3D::GetScreenSize(const glm::vec3& _center, float _radius) const
+  {
+    const float distance = glm::length(_center - m_position);
+    if (distance <= _radius)
+    {
+      return std::numeric_limits<float>::max();
+    }
+    //[1][1] is 1 / tan(fov / 2), the half height of the screen at distance 1
+    return _radius * m_projectionMatrix[1][1] / distance;
+  }
+
   void Camera3D::Move(const MoveState& _ms, float _deltaTime)
   {
     switch (_ms)
@@ -3,6 +3,8 @@
 #include <glm\glm.hpp>
 #include <glm\gtc\matrix_transform.hpp>
 #include <SDL\SDL_video.h>
+#include <array>
+#include "AABB.h"
 #include "InputManager.h"
 
 namespace GameEngine
@@ -25,7 +27,7 @@ namespace GameEngine
      */
     void Init(float _fov, int _screenWidth, int _screenHeight, const SDL_bool& _relativeMM = SDL_FALSE);
 
-    /** \brief The per-frame function for the camera which updates the view matrix if needed */
+    /** \brief The per-frame function for the camera which updates the view matrix and the frustum planes if needed */
     void Update();
 
     /** \brief Sets the camera position to a specific one
@@ -108,7 +110,8 @@ namespace GameEngine
         m_initialFoV = 120.0f;
       }
       printf("fov: %f \n", m_initialFoV);
-      m_projectionMatrix = glm::perspective(glm::radians(m_initialFoV), GetAspectRatio(), 0.1f, 100.0f);
+      m_projectionMatrix = glm::perspective(glm::radians(m_initialFoV), GetAspectRatio(), m_nearPlane, m_farPlane);
+      m_needsMatrixUpdate = true;
     }
 
     /** \brief Increase (or decreases) the mouse sensitivity
@@ -135,6 +138,11 @@ namespace GameEngine
       return (float)m_screenWidth / (float)m_screenHeight;
     }
 
+    /** \brief Gets the height of the screen in pixels, what GetScreenSize is a part of
+     * \return the height of the last Resize
+     */
+    int GetScreenHeight() const noexcept { return m_screenHeight; }
+
     /** \brief Sets the screen width and height for the camera and updates the proj matrix
     * \param _screenWidth - the new width
     * \param _screenHeight - the new height
@@ -144,7 +152,8 @@ namespace GameEngine
 						m_screenWidth = _screenWidth;
 						m_screenHeight = _screenHeight;
 						//projection matrix
-						m_projectionMatrix = glm::perspective(glm::radians(m_initialFoV), GetAspectRatio(), 0.1f, 100.0f);
+						m_projectionMatrix = glm::perspective(glm::radians(m_initialFoV), GetAspectRatio(), m_nearPlane, m_farPlane);
+						m_needsMatrixUpdate = true;
     }
 
     /** \brief Gets the projection matrix of the camera
@@ -173,11 +182,45 @@ namespace GameEngine
       */
     glm::vec3 GetDirection() const noexcept { return m_direction; }
 
+    /** \brief Gets the axis to the right of where the camera faces, e.g. for the pan of the sounds
+      * \return the right vec3
+      */
+    glm::vec3 GetRight() const noexcept { return m_right; }
+
+    /** \brief Gets the distances of the near and far planes of the projection, e.g. to split the frustum into shadow cascades */
+    float GetNearPlane() const noexcept { return m_nearPlane; }
+    float GetFarPlane() const noexcept { return m_farPlane; }
+
+    /** \brief Gets the planes of the view frustum in world space (left, right, bottom, top, near, far), extracted by Update when the view
+      * or the projection changed
+      * \return the planes as (normal, distance), normalized and pointing inside, a point p is inside a plane when dot(normal, p) + distance >= 0
+      */
+    const std::array<glm::vec4, 6>& GetFrustumPlanes() const noexcept { return m_frustumPlanes; }
+    /** \brief The same planes for any view projection matrix, e.g. a face of a shadow cubemap (see LightCamera::GetLightTransforms) */
+    static std::array<glm::vec4, 6> ExtractFrustumPlanes(const glm::mat4& _viewProjection);
+
+    /** \brief Check if a sphere in world space reaches into the view frustum, to skip the draws of what's off the screen
+      * \return true for a sphere inside or crossing a plane. A sphere near a corner outside of the frustum can still pass
+      */
+    bool IsSphereVisible(const glm::vec3& _center, float _radius) const { return IsSphereInFrustum(m_frustumPlanes, _center, _radius); }
+    /** \brief Check if a box in world space (see AABB::Transformed for the box of a model) reaches into the view frustum */
+    bool IsBoxVisible(const AABB& _box) const { return IsBoxInFrustum(m_frustumPlanes, _box); }
+    /** \brief The tests of IsSphereVisible and IsBoxVisible against any planes, e.g. from ExtractFrustumPlanes */
+    static bool IsSphereInFrustum(const std::array<glm::vec4, 6>& _planes, const glm::vec3& _center, float _radius);
+    static bool IsBoxInFrustum(const std::array<glm::vec4, 6>& _planes, const AABB& _box);
+
+    /** \brief Gets how much of the screen height a sphere covers, used to pick the LODs of the models
+      * \return the projected diameter over the screen height, from the distance and not the direction so a turn doesn't change it,
+      * the largest float with the camera inside the sphere
+      */
+    float GetScreenSize(const glm::vec3& _center, float _radius) const;
+
   private:
     void CalculateOrientation(bool _limit); ///< calculate the orientation of the camera
 
     glm::mat4 m_projectionMatrix{ 1.0f }; ///< The projection matrix
     glm::mat4 m_viewMatrix{ 1.0f }; ///< Camera matrix
+    std::array<glm::vec4, 6> m_frustumPlanes{}; ///< of m_projectionMatrix * m_viewMatrix, see GetFrustumPlanes
 
     glm::vec3 m_position{ 0.0f, 0.0f, 0.0f }; ///< camera position
 
@@ -198,6 +241,10 @@ namespace GameEngine
     /// Initial Field of View
     float m_initialFoV{ 60.0f };
 
+    //the clipping planes of the projection
+    float m_nearPlane{ 0.1f };
+    float m_farPlane{ 100.0f };
+
     //the movement speed of the camera 
     float m_speed{ 0.1f }; ///< speed of 10.0f units / second
 
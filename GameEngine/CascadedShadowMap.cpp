@@ -0,0 +1,97 @@
+#include "CascadedShadowMap.h"
+#include "FrameStats.h"
+#include "Camera3D.h"
+#include "RenderQueue3D.h"
+#include "RenderState.h"
+
+#include <algorithm>
+
+namespace GameEngine
+{
+  bool CascadedShadowMap::Init(int _resolution, int _numCascades)
+  {
+    m_resolution = _resolution;
+    m_numCascades = std::min<int>(_numCascades, CascadeBlockData::MAX_CASCADES);
+    m_layered = RenderQueue3D::IsLayeredSupported();
+    m_depthMap.Init();
+    m_depthMap.Bind(GL_FRAMEBUFFER, m_resolution, m_resolution);
+    m_depthMap.AttachDepthTextureArray(m_resolution, m_resolution, m_numCascades);
+    const bool complete = m_depthMap.CheckFramebufferStatus();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete)
+    {
+      m_depthMap.Destroy();
+      return false;
+    }
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(CascadeBlockData), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    return true;
+  }
+
+  void CascadedShadowMap::Dispose()
+  {
+    if (m_buffer != 0)
+    {
+      glDeleteBuffers(1, &m_buffer);
+      m_buffer = 0;
+    }
+    m_depthMap.Destroy();
+  }
+
+  void CascadedShadowMap::Update(const Camera3D& _camera, const glm::vec3& _direction, float _shadowDistance, float _splitLambda/*= 0.75f*/)
+  {
+    m_lightCamera.InitForCascades(_camera, _direction, m_numCascades, m_resolution, _shadowDistance, _splitLambda);
+    const std::vector<glm::mat4>& transforms = m_lightCamera.GetLightTransforms();
+    const std::vector<float>& splits = m_lightCamera.GetCascadeSplits();
+    for (int cascade = 0; cascade < m_numCascades; cascade++)
+    {
+      m_data.cascadeMatrices[cascade] = transforms[cascade];
+      m_data.cascadeSplits[cascade] = splits[cascade];
+    }
+    m_data.cascadeParams = glm::vec4(static_cast<float>(m_numCascades), 1.0f / static_cast<float>(m_resolution), 0.0f, 0.0f);
+    if (m_buffer != 0)
+    {
+      glBindBufferBase(GL_UNIFORM_BUFFER, CASCADE_BLOCK_BINDING, m_buffer);
+      FrameStats::Get().Add(STAT_BYTES_UPLOADED, sizeof(m_data));
+      glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(m_data), &m_data);
+    }
+  }
+
+  void CascadedShadowMap::Render(RenderQueue3D& _queue, unsigned int _pass, int _screenWidth, int _screenHeight)
+  {
+    const std::vector<glm::mat4>& transforms = m_lightCamera.GetLightTransforms();
+    //clears every layer, the texture array is attached layered
+    m_depthMap.Bind(GL_FRAMEBUFFER, m_resolution, m_resolution);
+    //the slope scaled bias against the acne, the shaders don't need one of their own
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+    if (m_layered)
+    {
+      _queue.ExecuteLayered(_pass, transforms);
+    }
+    else
+    {
+      //one layer attached at a time, the instance of each draw picks the matrix of the cascade from _firstLayer
+      const GLuint texture = m_depthMap.GetDepthTexture().id;
+      std::vector<glm::mat4> cascadeTransform(1);
+      for (int cascade = 0; cascade < m_numCascades; cascade++)
+      {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, cascade);
+        cascadeTransform[0] = transforms[cascade];
+        _queue.ExecuteLayered(_pass, cascadeTransform, static_cast<unsigned int>(cascade));
+      }
+      glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0);
+    }
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, _screenWidth, _screenHeight);
+  }
+
+  void CascadedShadowMap::BindTexture(GLuint _unit) const
+  {
+    RenderState::Get().BindTexture(_unit, GL_TEXTURE_2D_ARRAY, m_depthMap.GetDepthTexture().id);
+  }
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <GL\glew.h>
+#include <glm\vec3.hpp>
+
+#include "DepthMapFBO.h"
+#include "LightCamera.h"
+#include "UniformBlocks.h"
+
+namespace GameEngine
+{
+  class Camera3D;
+  class RenderQueue3D;
+
+  /** \brief The shadow of a directional light for large scenes: the view frustum is split into cascades, each with its own shadow map
+  * fitted to its slice (see LightCamera::InitForCascades), so the near geometry gets the texels instead of one huge map covering everything.
+  * The maps are the layers of one depth texture array, a caster is one instanced draw reaching the cascades it overlaps (see
+  * RenderQueue3D::ExecuteLayered). The shaders read the cascades from the CascadeBlock (see CascadeBlockData) and the maps from a
+  * sampler2DArrayShadow; the caster vertex shader transforms by cascadeMatrices[(layerFaces >> (3 * gl_InstanceID)) & 7] */
+  class CascadedShadowMap
+  {
+  public:
+    CascadedShadowMap() {}
+    ~CascadedShadowMap() { Dispose(); }
+
+    /** \brief Creates the maps, _numCascades layers of _resolution x _resolution, and the CascadeBlock buffer. False if the driver can't
+    * render to them */
+    bool Init(int _resolution = 2048, int _numCascades = CascadeBlockData::MAX_CASCADES);
+    void Dispose();
+
+    /** \brief Fits the cascades to _camera for a light shining along _direction, up to _shadowDistance from the camera, and writes the
+    * CascadeBlock (bound to CASCADE_BLOCK_BINDING) */
+    void Update(const Camera3D& _camera, const glm::vec3& _direction, float _shadowDistance, float _splitLambda = 0.75f);
+
+    /** \brief Renders the casters of _pass into the maps with the shaders they were submitted with, then goes back to the screen with a
+    * _screenWidth x _screenHeight viewport. Without gl_Layer in the vertex shader (see RenderQueue3D::IsLayeredSupported) it's a pass a cascade */
+    void Render(RenderQueue3D& _queue, unsigned int _pass, int _screenWidth, int _screenHeight);
+
+    /** \brief Binds the maps to the texture _unit */
+    void BindTexture(GLuint _unit) const;
+
+    bool IsInitialized() const noexcept { return m_buffer != 0; }
+    const LightCamera& GetLightCamera() const noexcept { return m_lightCamera; }
+  private:
+    LightCamera m_lightCamera;
+    DepthMapFBO m_depthMap;
+    CascadeBlockData m_data{};
+    GLuint m_buffer{ 0 };
+    int m_resolution{ 0 };
+    int m_numCascades{ 0 };
+    bool m_layered{ false };
+  };
+}
@@ -1,9 +1,22 @@
 #pragma once
 
+#include <atomic>
+#include <bitset>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+//the entities only store the components they have, so this can grow without making them larger
+constexpr std::size_t MAX_COMPONENTS{ 64 };
+//the IDs below this are reserved for the types registered with GAMEENGINE_REGISTER_COMPONENT, the rest are handed out on first use
+constexpr std::size_t MAX_REGISTERED_COMPONENTS{ 32 };
+
 namespace GameEngine
 {
   //define a typedef for the component ID type
   using ComponentID = unsigned int;
+  //one bit for every component type an entity has (its signature)
+  using ComponentBitset = std::bitset<MAX_COMPONENTS>;
 
   //forward declare the entity class
   class Entity;
@@ -22,6 +35,16 @@ namespace GameEngine
 
     //Store the parent entity containing this component in a pointer due to forward declaration
     Entity* m_entity{ nullptr };
+    //The slot of the component in its ComponentPool
+    unsigned int m_poolSlot{ 0 };
+  };
+
+  /** The compile time ID of a component type, specialized by GAMEENGINE_REGISTER_COMPONENT.
+  * Unregistered types get their ID lazily on first use instead */
+  template<typename T>
+  struct ComponentTypeRegistry
+  {
+    static constexpr bool REGISTERED{ false };
   };
 
   //Hide implementation details
@@ -30,20 +53,89 @@ namespace GameEngine
     inline ComponentID GetUniqueComponentID() noexcept
     {
       //by using a static variable every time this function is called it will refer to the same "lastID" instance
-      //THis way it will always return a unique ID
-      static ComponentID lastID{ 0u };
-      return lastID++;
+      //THis way it will always return a unique ID (atomic, the systems may run on several threads)
+      static std::atomic<ComponentID> lastID{ static_cast<ComponentID>(MAX_REGISTERED_COMPONENTS) };
+      const ComponentID id = lastID++;
+      assert(id < MAX_COMPONENTS && "too many component types, raise MAX_COMPONENTS");
+      return id;
+    }
+
+    //registered type: the ID is a constant, so there is no static guard check
+    template<typename T>
+    inline ComponentID GetComponentTypeID(std::true_type) noexcept
+    {
+      return ComponentTypeRegistry<T>::ID;
+    }
+
+    template<typename T>
+    inline ComponentID GetComponentTypeID(std::false_type) noexcept
+    {
+      //every time this function is called with specific type "T"
+      //it is instantiating this template with its own unique "typeID" variable
+      static ComponentID typeID{ GetUniqueComponentID() };
+      return typeID;
     }
   }
 
   template<typename T>
   inline ComponentID GetComponentTypeID() noexcept
   {
-    //every time this function is called with specific type "T"
-    //it is instantiating this template with its own unique "typeID" variable
     static_assert(std::is_base_of<Component, T>::value, "Must inherit from Component");
+    return Internal::GetComponentTypeID<T>(std::integral_constant<bool, ComponentTypeRegistry<T>::REGISTERED>());
+  }
+
+  //the number of components with an ID below _id, which is the index of component _id in the entity's component list
+  inline std::size_t GetComponentRank(const ComponentBitset& _signature, ComponentID _id) noexcept
+  {
+    return (_signature & ~(ComponentBitset().set() << _id)).count();
+  }
+
+  //the signature with the bits of all the types in Ts set
+  template<typename... Ts>
+  inline ComponentBitset GetComponentSignature() noexcept
+  {
+    ComponentBitset signature;
+    //expands to one set() call per type
+    int expand[] = { 0, (signature.set(GetComponentTypeID<Ts>()), 0)... };
+    (void)expand;
+    return signature;
+  }
+}
+
+namespace GameEngine
+{
+  /** Whether the pool of T can be snapshotted by copying its bytes (see EntityManager::SaveSnapshot), set by GAMEENGINE_SNAPSHOT_COMPONENT */
+  template<typename T>
+  struct ComponentSnapshotPolicy
+  {
+    static constexpr bool BYTE_COPY{ false };
+  };
+}
+
+/** Gives the component type a fixed, dense ID in [0, MAX_REGISTERED_COMPONENTS), known at compile time.
+* Use it once per type at global scope, right after the type is defined, e.g. GAMEENGINE_REGISTER_COMPONENT(PositionComponent, 0)
+* Every registered type needs its own ID */
+#define GAMEENGINE_REGISTER_COMPONENT(_type, _id) \
+  namespace GameEngine \
+  { \
+    template<> \
+    struct ComponentTypeRegistry<_type> \
+    { \
+      static_assert((_id) < MAX_REGISTERED_COMPONENTS, "registered component IDs have to be below MAX_REGISTERED_COMPONENTS"); \
+      static constexpr bool REGISTERED{ true }; \
+      static constexpr ComponentID ID{ (_id) }; \
+    }; \
+  }
 
-    static ComponentID typeID{ Internal::GetUniqueComponentID() };
-    return typeID;
+/** Lets the world snapshots copy the components of the type as bytes. Only for plain data: the members are values (no owning
+* pointers, containers or strings) and the pointers are to things which outlive a rollback (e.g. the entity, another component of it).
+* A component is polymorphic so it's never trivially copyable, but its virtual table stays the same in the same slot */
+#define GAMEENGINE_SNAPSHOT_COMPONENT(_type) \
+  namespace GameEngine \
+  { \
+    template<> \
+    struct ComponentSnapshotPolicy<_type> \
+    { \
+      static constexpr bool BYTE_COPY{ true }; \
+    }; \
   }
-}
\ No newline at end of file
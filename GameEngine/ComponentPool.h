@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Component.h"
+#include "MemoryTracker.h"
+
+namespace GameEngine
+{
+  //type erased interface, so the EntityManager can keep the pools of all the component types in one array
+  class IComponentPool
+  {
+  public:
+    virtual ~IComponentPool() {}
+
+    //destroys the component and frees its slot for reuse
+    virtual void Destroy(Component* _component) = 0;
+    //updates all the components in the pool
+    virtual void UpdateAll(float _deltaTime) = 0;
+    //draws all the components in the pool
+    virtual void DrawAll() = 0;
+    //number of live components
+    virtual std::size_t Size() const = 0;
+
+    //the components can be snapshotted as bytes (see GAMEENGINE_SNAPSHOT_COMPONENT)
+    virtual bool IsSnapshotSafe() const = 0;
+    //the bytes of the state of the pool, its blocks as they are
+    virtual std::size_t GetStateSize() const = 0;
+    virtual void SaveState(unsigned char* _buffer) const = 0;
+    //the pool must have the same blocks and the same live slots as when the state was saved
+    virtual void RestoreState(const unsigned char* _buffer) = 0;
+
+    //the components may have changed since the last snapshot, they're copied into the next one
+    void MarkDirty() noexcept { m_dirty = true; }
+
+  private:
+    friend class EntityManager;
+    bool m_dirty{ true };
+    std::uint64_t m_stateVersion{ 0 }; ///< numbers the states of the pool which were snapshotted, see EntityManager::SaveSnapshot
+  };
+
+  /** \brief Stores all the components of type T in contiguous blocks.
+   *  The blocks never move, so pointers to the components stay valid until they are destroyed,
+   *  and destroyed slots are reused by the next Create(). The blocks are counted as ECS memory (see MemoryTracker) */
+  template<typename T>
+  class ComponentPool : public IComponentPool
+  {
+  public:
+    //number of components in one block
+    static constexpr std::size_t BLOCK_SIZE{ 256 };
+
+    ComponentPool() {}
+    ComponentPool(const ComponentPool&) = delete;
+    ComponentPool& operator=(const ComponentPool&) = delete;
+
+    ~ComponentPool()
+    {
+      for (std::size_t i = 0; i < m_blocks.size() * BLOCK_SIZE; i++)
+      {
+        if (IsAlive(i))
+        {
+          Slot(i)->~T();
+        }
+      }
+      for (Block* block : m_blocks)
+      {
+        MemoryTracker::Get().Free(block, sizeof(Block), alignof(Block), MEMORY_ECS);
+      }
+    }
+
+    /** \brief Constructs a component in a free slot by forwarding _args to its constructor */
+    template<typename... TArgs>
+    T* Create(TArgs&&... _args)
+    {
+      if (m_freeSlots.empty())
+      {
+        AddBlock();
+      }
+      const unsigned int slot = m_freeSlots.back();
+      m_freeSlots.pop_back();
+
+      T* component = new (Slot(slot)) T(std::forward<TArgs>(_args)...);
+      component->m_poolSlot = slot;
+      m_blocks[slot / BLOCK_SIZE]->m_alive[slot % BLOCK_SIZE] = true;
+      m_size++;
+      MarkDirty();
+      return component;
+    }
+
+    //makes sure the next _count Create() calls don't allocate
+    void Reserve(std::size_t _count)
+    {
+      while (m_freeSlots.size() < _count)
+      {
+        AddBlock();
+      }
+    }
+
+    void Destroy(Component* _component) override
+    {
+      const unsigned int slot = _component->m_poolSlot;
+      Slot(slot)->~T();
+      m_blocks[slot / BLOCK_SIZE]->m_alive[slot % BLOCK_SIZE] = false;
+      m_freeSlots.push_back(slot);
+      m_size--;
+      MarkDirty();
+    }
+
+    /** \brief Calls _function(T&) for every live component, in memory order. The pool counts as changed (see MarkDirty) */
+    template<typename F>
+    void ForEach(F&& _function)
+    {
+      MarkDirty();
+      ForEachAlive(std::forward<F>(_function));
+    }
+
+    void UpdateAll(float _deltaTime) override
+    {
+      //the qualified call is resolved at compile time, so there is no virtual dispatch per component
+      ForEach([_deltaTime](T& _component) { _component.T::Update(_deltaTime); });
+    }
+
+    void DrawAll() override
+    {
+      //drawing doesn't change them
+      ForEachAlive([](T& _component) { _component.T::Draw(); });
+    }
+
+    std::size_t Size() const override { return m_size; }
+
+    bool IsSnapshotSafe() const override { return ComponentSnapshotPolicy<T>::BYTE_COPY; }
+    std::size_t GetStateSize() const override { return m_blocks.size() * sizeof(Block); }
+
+    void SaveState(unsigned char* _buffer) const override
+    {
+      for (const Block* block : m_blocks)
+      {
+        std::memcpy(_buffer, block, sizeof(Block));
+        _buffer += sizeof(Block);
+      }
+    }
+
+    void RestoreState(const unsigned char* _buffer) override
+    {
+      for (Block* block : m_blocks)
+      {
+        std::memcpy(block, _buffer, sizeof(Block));
+        _buffer += sizeof(Block);
+      }
+    }
+
+  private:
+    struct Block
+    {
+      typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage[BLOCK_SIZE];
+      bool m_alive[BLOCK_SIZE]{};
+    };
+
+    template<typename F>
+    void ForEachAlive(F&& _function)
+    {
+      for (auto& block : m_blocks)
+      {
+        T* components = reinterpret_cast<T*>(block->m_storage);
+        for (std::size_t i = 0; i < BLOCK_SIZE; i++)
+        {
+          if (block->m_alive[i])
+          {
+            _function(components[i]);
+          }
+        }
+      }
+    }
+
+    void AddBlock()
+    {
+      const unsigned int first = static_cast<unsigned int>(m_blocks.size() * BLOCK_SIZE);
+      m_blocks.push_back(new (MemoryTracker::Get().Allocate(sizeof(Block), alignof(Block), MEMORY_ECS)) Block());
+      //push the slots in reverse, so they are handed out front to back
+      for (unsigned int i = BLOCK_SIZE; i > 0; i--)
+      {
+        m_freeSlots.push_back(first + i - 1);
+      }
+    }
+
+    T* Slot(std::size_t _slot) { return reinterpret_cast<T*>(&m_blocks[_slot / BLOCK_SIZE]->m_storage[_slot % BLOCK_SIZE]); }
+    bool IsAlive(std::size_t _slot) const { return m_blocks[_slot / BLOCK_SIZE]->m_alive[_slot % BLOCK_SIZE]; }
+
+    std::vector<Block*> m_blocks; ///< trivially destructible, only freed
+    std::vector<unsigned int> m_freeSlots;
+    std::size_t m_size{ 0 };
+  };
+}
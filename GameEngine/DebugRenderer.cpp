@@ -1,4 +1,10 @@
 #include "DebugRenderer.h"
+#include "FrameStats.h"
+#include "RenderState.h"
+#include "Camera3D.h"
+#include "GameEngineErrors.h"
+
+#include <algorithm>
 
 const float PI = 3.14159265359f;
 
@@ -6,29 +12,26 @@ namespace GameEngine
 {
 		const char* VERT_SRC = R"(#version 130
 //The vertex shader operates on each vertex
-//input data from the VBO. Each vertex is 2 floats
-in vec2 vertexPosition;
+//input data from the VBO. Each vertex is 3 floats, z is 0 for the 2D lines
+in vec3 vertexPosition;
 in vec4 vertexColor;
-out vec2 fragmentPosition;
 out vec4 fragmentColor;
 uniform mat4 P;
+//the 2D lines are kept on the screen plane whatever the depth range of P
+uniform bool flatten;
 void main() {
-    //Set the x,y position on the screen
-    gl_Position.xy = (P * vec4(vertexPosition, 0.0, 1.0)).xy;
-    //the z position is zero since we are in 2D
-    gl_Position.z = 0.0;
-    
-    //Indicate that the coordinates are normalized
-    gl_Position.w = 1.0;
-    
-    fragmentPosition = vertexPosition;
-    
+    if (flatten) {
+        //Set the x,y position on the screen, the z position is zero since we are in 2D
+        gl_Position = vec4((P * vec4(vertexPosition.xy, 0.0, 1.0)).xy, 0.0, 1.0);
+    } else {
+        gl_Position = P * vec4(vertexPosition, 1.0);
+    }
+
     fragmentColor = vertexColor;
 })";
 
 		const char* FRAG_SRC = R"(#version 130
 //The fragment shader operates on each pixel in a given polygon
-in vec2 fragmentPosition;
 in vec4 fragmentColor;
 //This is the 3 component float vector that gets outputted to the screen
 //for each pixel.
@@ -51,50 +54,52 @@ void DebugRenderer::Init()
 {
 		// Shader init
 		m_program.CompileShadersFromSource(VERT_SRC, FRAG_SRC);
+		m_matrixUniform = m_program.GetUniformLocation("P");
+		m_flattenUniform = m_program.GetUniformLocation("flatten");
 
-		// Set up buffers
+		//persistent mapping needs immutable buffer storage (core in 4.4), the buffer is only reused otherwise
+		m_persistent = GLEW_ARB_buffer_storage != 0;
 		glGenVertexArrays(1, &m_vao);
-		glGenBuffers(1, &m_vbo);
-		glGenBuffers(1, &m_ibo);
-		//bind the vertex array object
-		glBindVertexArray(m_vao);
-		//bind the vertex buffer object
-		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-		//bind the index buffer object
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
-		//enable the vertex attrib array on index 0
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (void*)offsetof(DebugVertex, DebugVertex::m_position));
-		//enable the vertex attrib array on index 1
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DebugVertex), (void*)offsetof(DebugVertex, DebugVertex::m_color));
-		//unbind the vao
-		glBindVertexArray(0);
+		CreateBuffer(DEBUG_RING_SECTION_VERTICES);
 }
 
 void DebugRenderer::End()
 {
-		//bind the vbo
-		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-		// Orphan the buffer
-		glBufferData(GL_ARRAY_BUFFER, m_verts.size() * sizeof(DebugVertex), nullptr, GL_DYNAMIC_DRAW);
-		// Upload the data
-		glBufferSubData(GL_ARRAY_BUFFER, 0, m_verts.size() * sizeof(DebugVertex), m_verts.data());
-		//unbind the vbo
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		//bind the ibo
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
-		// Orphan the buffer
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
-		// Upload the data
-		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, m_indices.size() * sizeof(GLuint), m_indices.data());
-		//unbind the ibo
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-		//set up the numelements to be the same as indices.size
-		m_numElements = m_indices.size();
-		//clear the inices and vertices vectors
-		m_indices.clear();
+		m_numVerts = static_cast<GLsizei>(m_verts.size());
+		m_numVerts3D = static_cast<GLsizei>(m_verts3D.size());
+		const GLsizei numVertices = m_numVerts + m_numVerts3D;
+		if (numVertices == 0)
+		{
+				m_first = 0;
+				return;
+		}
+		if (m_persistent)
+		{
+				//write straight into the mapped memory, the mapping is coherent so there is nothing left to upload
+				DebugVertex* destVertices = AcquireRingSection(numVertices);
+				FrameStats::Get().Add(STAT_BYTES_UPLOADED, numVertices * sizeof(DebugVertex));
+				std::copy(m_verts.begin(), m_verts.end(), destVertices);
+				std::copy(m_verts3D.begin(), m_verts3D.end(), destVertices + m_numVerts);
+				m_first = m_currentSection * m_sectionCapacity;
+		}
+		else
+		{
+				glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+				//the storage is only specified again when this frame has more lines than any before it
+				if (numVertices > m_sectionCapacity)
+				{
+						m_sectionCapacity = std::max(numVertices, m_sectionCapacity * 2);
+						glBufferData(GL_ARRAY_BUFFER, m_sectionCapacity * sizeof(DebugVertex), nullptr, GL_DYNAMIC_DRAW);
+				}
+				FrameStats::Get().Add(STAT_BYTES_UPLOADED, numVertices * sizeof(DebugVertex));
+				glBufferSubData(GL_ARRAY_BUFFER, 0, m_numVerts * sizeof(DebugVertex), m_verts.data());
+				glBufferSubData(GL_ARRAY_BUFFER, m_numVerts * sizeof(DebugVertex), m_numVerts3D * sizeof(DebugVertex), m_verts3D.data());
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+				m_first = 0;
+		}
+		//clear the vertices vectors, they keep their capacity for the next frame
 		m_verts.clear();
+		m_verts3D.clear();
 }
 
 glm::vec2 RotatePoint(const glm::vec2& _pos, float _angle)
@@ -108,26 +113,26 @@ glm::vec2 RotatePoint(const glm::vec2& _pos, float _angle)
 
 void DebugRenderer::DrawLine(const glm::vec2& _a, const glm::vec2& _b, const ColorRGBA8& _color)
 {
-		int i = m_verts.size();
-		//resize the verts to +2 in size
-		m_verts.resize(m_verts.size() + 2);
-
-		m_verts[i].m_position = _a;
-		m_verts[i].m_color = _color;
-		m_verts[i + 1].m_position = _b;
-		m_verts[i + 1].m_color = _color;
-		//push back the indices
-		m_indices.push_back(i);
-		m_indices.push_back(i + 1);
+		if (!IsInCullRect(glm::min(_a, _b), glm::max(_a, _b)))
+		{
+				return;
+		}
+		m_verts.push_back({ glm::vec3(_a, 0.0f), _color });
+		m_verts.push_back({ glm::vec3(_b, 0.0f), _color });
 }
 
 void DebugRenderer::DrawBox(const glm::vec4& _destRect, const ColorRGBA8& _color, float _angle)
 {
-		int i = m_verts.size();
-		//resize the verts to size + 4
-		m_verts.resize(m_verts.size() + 4);
 		//the half of the box dimensions
 		glm::vec2 halfDims(_destRect.z / 2.0f, _destRect.w / 2.0f);
+		glm::vec2 positionOffset(_destRect.x, _destRect.y);
+		//the rotated box stays inside the circle of its corners
+		const glm::vec2 center = positionOffset + halfDims;
+		const glm::vec2 halfDiagonal(glm::length(halfDims));
+		if (!IsInCullRect(center - halfDiagonal, center + halfDiagonal))
+		{
+				return;
+		}
 
 		// Get points centered at origin
 		glm::vec2 tl(-halfDims.x, halfDims.y);
@@ -135,77 +140,118 @@ void DebugRenderer::DrawBox(const glm::vec4& _destRect, const ColorRGBA8& _color
 		glm::vec2 br(halfDims.x, -halfDims.y);
 		glm::vec2 tr(halfDims.x, halfDims.y);
 
-		glm::vec2 positionOffset(_destRect.x, _destRect.y);
-
 		// Rotate the points
-		m_verts[i].m_position = RotatePoint(tl, _angle) + halfDims + positionOffset;
-		m_verts[i + 1].m_position = RotatePoint(bl, _angle) + halfDims + positionOffset;
-		m_verts[i + 2].m_position = RotatePoint(br, _angle) + halfDims + positionOffset;
-		m_verts[i + 3].m_position = RotatePoint(tr, _angle) + halfDims + positionOffset;
-		//set up the colors
-		for (int j = i; j < i + 4; j++)
+		const glm::vec3 corners[4] = {
+				glm::vec3(RotatePoint(tl, _angle) + center, 0.0f),
+				glm::vec3(RotatePoint(bl, _angle) + center, 0.0f),
+				glm::vec3(RotatePoint(br, _angle) + center, 0.0f),
+				glm::vec3(RotatePoint(tr, _angle) + center, 0.0f)
+		};
+		//the 4 sides as lines
+		for (int i = 0; i < 4; i++)
 		{
-				m_verts[j].m_color = _color;
+				m_verts.push_back({ corners[i], _color });
+				m_verts.push_back({ corners[(i + 1) % 4], _color });
 		}
-		//reserve the indices size needed
-		m_indices.reserve(m_indices.size() + 8);
-		//push back the 6 indices (2 triangles)
-		m_indices.push_back(i);
-		m_indices.push_back(i + 1);
-
-		m_indices.push_back(i + 1);
-		m_indices.push_back(i + 2);
-
-		m_indices.push_back(i + 2);
-		m_indices.push_back(i + 3);
-
-		m_indices.push_back(i + 3);
-		m_indices.push_back(i);
 }
 
 void DebugRenderer::DrawCircle(const glm::vec2& _center, const ColorRGBA8& _color, float _radius)
 {
 		static const int NUM_VERTS = 100;
-		// Set up vertices
-		int start = m_verts.size();
-		m_verts.resize(m_verts.size() + NUM_VERTS);
-		for (int i = 0; i < NUM_VERTS; i++)
+		if (!IsInCullRect(_center - glm::vec2(_radius), _center + glm::vec2(_radius)))
+		{
+				return;
+		}
+		m_verts.reserve(m_verts.size() + NUM_VERTS * 2);
+		glm::vec3 previous(_center.x + _radius, _center.y, 0.0f);
+		for (int i = 1; i <= NUM_VERTS; i++)
 		{
 				//formula to make a circle by setting it's positions
 				float angle = ((float)i / NUM_VERTS) * PI * 2.0f;
-				m_verts[start + i].m_position.x = cos(angle) * _radius + _center.x;
-				m_verts[start + i].m_position.y = sin(angle) * _radius + _center.y;
-				//also set it's color
-				m_verts[start + i].m_color = _color;
+				const glm::vec3 position(cos(angle) * _radius + _center.x, sin(angle) * _radius + _center.y, 0.0f);
+				m_verts.push_back({ previous, _color });
+				m_verts.push_back({ position, _color });
+				previous = position;
+		}
+}
+
+void DebugRenderer::DrawLine(const glm::vec3& _a, const glm::vec3& _b, const ColorRGBA8& _color)
+{
+		if (!IsInCullFrustum(AABB(glm::min(_a, _b), glm::max(_a, _b))))
+		{
+				return;
 		}
+		m_verts3D.push_back({ _a, _color });
+		m_verts3D.push_back({ _b, _color });
+}
 
-		// Set up indices for indexed drawing
-		m_indices.reserve(m_indices.size() + NUM_VERTS * 2);
-		for (int i = 0; i < NUM_VERTS - 1; i++)
+void DebugRenderer::DrawBox(const AABB& _box, const ColorRGBA8& _color)
+{
+		if (!IsInCullFrustum(_box))
+		{
+				return;
+		}
+		//corner i has the max x if bit 0 is set, the max y for bit 1 and the max z for bit 2
+		const glm::vec3& min = _box.GetMin();
+		const glm::vec3& max = _box.GetMax();
+		glm::vec3 corners[8];
+		for (int i = 0; i < 8; i++)
+		{
+				corners[i] = glm::vec3((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+		}
+		//the edges join the corners which differ by one bit
+		for (int i = 0; i < 8; i++)
 		{
-				m_indices.push_back(start + i);
-				m_indices.push_back(start + i + 1);
+				for (int bit = 1; bit < 8; bit <<= 1)
+				{
+						if ((i & bit) == 0)
+						{
+								m_verts3D.push_back({ corners[i], _color });
+								m_verts3D.push_back({ corners[i | bit], _color });
+						}
+				}
 		}
-		m_indices.push_back(start + NUM_VERTS - 1);
-		m_indices.push_back(start);
 }
 
 void DebugRenderer::Render(const glm::mat4& _projectionMatrix, float _lineWidth)
 {
+		Draw(m_first, m_numVerts, _projectionMatrix, true, _lineWidth);
+}
+
+void DebugRenderer::Render3D(const glm::mat4& _viewProjection, float _lineWidth)
+{
+		//the lines are hidden behind the scene, without writing the depth they are tested against
+		const GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+		glEnable(GL_DEPTH_TEST);
+		glDepthMask(GL_FALSE);
+		Draw(m_first + m_numVerts, m_numVerts3D, _viewProjection, false, _lineWidth);
+		glDepthMask(GL_TRUE);
+		if (!depthTest)
+		{
+				glDisable(GL_DEPTH_TEST);
+		}
+}
+
+void DebugRenderer::Draw(GLint _first, GLsizei _count, const glm::mat4& _matrix, bool _flatten, float _lineWidth)
+{
+		if (_count == 0)
+		{
+				return;
+		}
 		//begin using the shader program
 		m_program.Use();
-		//get the uniform location
-		GLint pUniform = m_program.GetUniformLocation("P");
 		//set up the projection matrix
-		glUniformMatrix4fv(pUniform, 1, GL_FALSE, &_projectionMatrix[0][0]);
+		glUniformMatrix4fv(m_matrixUniform, 1, GL_FALSE, &_matrix[0][0]);
+		glUniform1i(m_flattenUniform, _flatten ? 1 : 0);
 		//set up the line width
 		glLineWidth(_lineWidth);
 		//bind the vertex array object
-		glBindVertexArray(m_vao);
-		//draw the elements
-		glDrawElements(GL_LINES, m_numElements, GL_UNSIGNED_INT, 0);
+		RenderState::Get().BindVertexArray(m_vao);
+		//draw the lines
+		FrameStats::Get().Add(STAT_DRAW_CALLS);
+		glDrawArrays(GL_LINES, _first, _count);
 		//unbind the vao
-		glBindVertexArray(0);
+		RenderState::Get().BindVertexArray(0);
 		//stop using the shader program
 		m_program.UnUse();
 }
@@ -213,19 +259,123 @@ void DebugRenderer::Render(const glm::mat4& _projectionMatrix, float _lineWidth)
 void DebugRenderer::Dispose()
 {
 		//delete all the buffers
+		DestroyBuffer();
 		if (m_vao)
 		{
-				glDeleteVertexArrays(1, &m_vao);
+				RenderState::Get().DeleteVertexArrays(1, &m_vao);
+				m_vao = 0;
+		}
+		//dispose of the shader program
+		m_program.Dispose();
+}
+
+bool DebugRenderer::IsInCullRect(const glm::vec2& _min, const glm::vec2& _max) const
+{
+		if (m_cullRect.z <= 0.0f || m_cullRect.w <= 0.0f)
+		{
+				return true;
+		}
+		return _max.x >= m_cullRect.x && _min.x <= m_cullRect.x + m_cullRect.z && _max.y >= m_cullRect.y && _min.y <= m_cullRect.y + m_cullRect.w;
+}
+
+bool DebugRenderer::IsInCullFrustum(const AABB& _box) const
+{
+		return !m_hasCullFrustum || Camera3D::IsBoxInFrustum(m_cullFrustum, _box);
+}
+
+void DebugRenderer::CreateBuffer(GLsizei _sectionCapacity)
+{
+		m_sectionCapacity = _sectionCapacity;
+		m_currentSection = 0;
+		glGenBuffers(1, &m_vbo);
+		//bind the vertex array object, the attributes point into the new vbo
+		RenderState::Get().BindVertexArray(m_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		if (m_persistent)
+		{
+				const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+				const GLsizeiptr bufferSize = DEBUG_RING_SECTIONS * m_sectionCapacity * sizeof(DebugVertex);
+				//immutable storage, so the buffer can stay mapped while it's being drawn from
+				glBufferStorage(GL_ARRAY_BUFFER, bufferSize, nullptr, flags);
+				m_mappedVertices = static_cast<DebugVertex*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferSize, flags));
+				if (m_mappedVertices == nullptr)
+				{
+						FatalError("Failed to persistently map the DebugRenderer ring buffer");
+				}
+		}
+		else
+		{
+				glBufferData(GL_ARRAY_BUFFER, m_sectionCapacity * sizeof(DebugVertex), nullptr, GL_DYNAMIC_DRAW);
+		}
+		//enable the vertex attrib array on index 0
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (void*)offsetof(DebugVertex, DebugVertex::m_position));
+		//enable the vertex attrib array on index 1
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DebugVertex), (void*)offsetof(DebugVertex, DebugVertex::m_color));
+		//unbind the vao
+		RenderState::Get().BindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void DebugRenderer::DestroyBuffer()
+{
+		for (GLuint i = 0; i < DEBUG_RING_SECTIONS; i++)
+		{
+				if (m_sectionFences[i])
+				{
+						glDeleteSync(m_sectionFences[i]);
+						m_sectionFences[i] = nullptr;
+				}
+		}
+		if (m_mappedVertices != nullptr)
+		{
+				glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+				glUnmapBuffer(GL_ARRAY_BUFFER);
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+				m_mappedVertices = nullptr;
 		}
 		if (m_vbo)
 		{
 				glDeleteBuffers(1, &m_vbo);
+				m_vbo = 0;
 		}
-		if (m_ibo)
+}
+
+DebugRenderer::DebugVertex* DebugRenderer::AcquireRingSection(GLsizei _numVertices)
+{
+		if (_numVertices > m_sectionCapacity)
 		{
-				glDeleteBuffers(1, &m_ibo);
+				/* The storage is immutable, so a bigger ring needs a new buffer.
+						Wait for the GPU to finish with all the sections before deleting it. */
+				glFinish();
+				DestroyBuffer();
+				CreateBuffer(std::max(_numVertices, m_sectionCapacity * 2));
 		}
-		//dispose of the shader program
-		m_program.Dispose();
+		else
+		{
+				//the last frame's section is drawn from until this fence
+				GLsync& lastFence = m_sectionFences[m_currentSection];
+				if (lastFence)
+				{
+						glDeleteSync(lastFence);
+				}
+				lastFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				m_currentSection = (m_currentSection + 1) % DEBUG_RING_SECTIONS;
+		}
+
+		//block until the GPU has finished reading the section from DEBUG_RING_SECTIONS frames ago
+		GLsync& fence = m_sectionFences[m_currentSection];
+		if (fence)
+		{
+				GLenum waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+				while (waitResult == GL_TIMEOUT_EXPIRED)
+				{
+						waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+				}
+				glDeleteSync(fence);
+				fence = nullptr;
+		}
+		return m_mappedVertices + m_currentSection * m_sectionCapacity;
 }
 }
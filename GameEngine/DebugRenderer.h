@@ -2,11 +2,23 @@
 
 #include "GLSLProgram.h"
 #include "Vertex.h"
+#include "AABB.h"
 #include <glm/glm.hpp>
+#include <array>
 #include <vector>
 
 namespace GameEngine
 {
+  //the frames of lines the persistent buffer holds, one is written while the GPU still draws the ones before it
+  constexpr GLuint DEBUG_RING_SECTIONS{ 3 };
+  //the vertices a ring section holds at first, it grows with the frames which draw more
+  constexpr GLsizei DEBUG_RING_SECTION_VERTICES{ 8 * 4096 };
+
+  /** \brief Immediate mode debug drawing: the lines of a frame are gathered by the Draw calls, uploaded once by End and drawn with a
+  * single draw for the 2D ones (Render) and one for the 3D ones (Render3D, depth tested against the scene). One renderer is meant to
+  * be shared by everything a screen debugs, with one End a frame. The vertices go into a persistently mapped ring buffer when the
+  * driver has GL_ARB_buffer_storage, otherwise into a buffer which keeps its size across frames. The primitives outside the cull rect
+  * or frustum are dropped as they are drawn, so debugging a big map costs what's on the screen */
   class DebugRenderer
   {
   public:
@@ -15,32 +27,69 @@ namespace GameEngine
 
     //initialize the renderer
     void Init();
-    //ends the rendering
+    //ends the rendering, uploads the lines drawn since the last End for Render and Render3D
     void End();
+    //the 2D primitives outside _rect (bottom left x, y, width, height, e.g. Camera2D::GetViewRect) are dropped, a rect of size 0 keeps all
+    void SetCullRect(const glm::vec4& _rect) { m_cullRect = _rect; }
+    //the 3D primitives outside the frustum (see Camera3D::GetFrustumPlanes) are dropped
+    void SetCullFrustum(const std::array<glm::vec4, 6>& _planes) { m_cullFrustum = _planes; m_hasCullFrustum = true; }
+    //keeps all the primitives again
+    void ClearCulling() { m_cullRect = glm::vec4(0.0f); m_hasCullFrustum = false; }
     //draw a single line from point a to point b
     void DrawLine(const glm::vec2& _a, const glm::vec2& _b, const ColorRGBA8& _color);
     //draw a box
     void DrawBox(const glm::vec4& _destRect, const ColorRGBA8& _color, float _angle);
     //draw a circle
     void DrawCircle(const glm::vec2& _center, const ColorRGBA8& _color, float _radius);
-    //renders it
+    //draw a 3D line from point a to point b
+    void DrawLine(const glm::vec3& _a, const glm::vec3& _b, const ColorRGBA8& _color);
+    //draw the 12 edges of a 3D box
+    void DrawBox(const AABB& _box, const ColorRGBA8& _color);
+    //renders the 2D lines
     void Render(const glm::mat4& _projectionMatrix, float _lineWidth);
+    //renders the 3D lines, hidden by what's in the bound depth buffer
+    void Render3D(const glm::mat4& _viewProjection, float _lineWidth);
     //disposes the debug renderer
     void Dispose();
     //the debug vertex struct ( a vertex has a position and a color)
     struct DebugVertex
     {
-      glm::vec2 m_position;
+      glm::vec3 m_position;
       ColorRGBA8 m_color;
     };
 
   private:
+    //false if the 2D bounds are outside the cull rect
+    bool IsInCullRect(const glm::vec2& _min, const glm::vec2& _max) const;
+    //false if the 3D box is outside the cull frustum
+    bool IsInCullFrustum(const AABB& _box) const;
+    //creates the vbo, and its immutable storage when it's persistent
+    void CreateBuffer(GLsizei _sectionCapacity);
+    //unmaps the ring buffer, deletes the fences and the vbo
+    void DestroyBuffer();
+    //fences the section of the last frame and waits until the next one is no longer drawn from
+    DebugVertex* AcquireRingSection(GLsizei _numVertices);
+    void Draw(GLint _first, GLsizei _count, const glm::mat4& _matrix, bool _flatten, float _lineWidth);
+
     GLSLProgram m_program;
-    std::vector<DebugVertex> m_verts;
-    std::vector<GLuint> m_indices;
-    GLuint m_vbo = 0, m_vao = 0, m_ibo = 0;
-    int m_numElements{ 0 };
+    GLint m_matrixUniform{ -1 };
+    GLint m_flattenUniform{ -1 };
+    std::vector<DebugVertex> m_verts;   ///< the 2D lines of the frame, two vertices each
+    std::vector<DebugVertex> m_verts3D; ///< the 3D lines of the frame
+    GLuint m_vbo = 0, m_vao = 0;
+    GLint m_first{ 0 };                 ///< where the uploaded lines start in the buffer
+    GLsizei m_numVerts{ 0 };            ///< the uploaded 2D vertices, the 3D ones follow them
+    GLsizei m_numVerts3D{ 0 };
+
+    bool m_persistent{ false };
+    DebugVertex* m_mappedVertices{ nullptr }; ///< base pointer of the persistently mapped ring buffer
+    GLsizei m_sectionCapacity{ 0 };           ///< the vertices of a ring section, or of the whole buffer when it isn't persistent
+    GLuint m_currentSection{ 0 };
+    GLsync m_sectionFences[DEBUG_RING_SECTIONS]{};
+
+    glm::vec4 m_cullRect{ 0.0f };
+    std::array<glm::vec4, 6> m_cullFrustum;
+    bool m_hasCullFrustum{ false };
   };
 }
 
-
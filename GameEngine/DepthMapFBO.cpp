@@ -1,4 +1,5 @@
 #include "DepthMapFBO.h"
+#include "RenderState.h"
 
 namespace GameEngine
 {
@@ -35,14 +36,14 @@ namespace GameEngine
 
     if (_multisampled)
     {
-      glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_textureBuffer.id);
+      RenderState::Get().BindTexture(0, GL_TEXTURE_2D_MULTISAMPLE, m_textureBuffer.id);
       glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, _samples, GL_DEPTH_COMPONENT, _bufferWidth, _bufferHeight, GL_TRUE);
-      glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+      RenderState::Get().BindTexture(0, GL_TEXTURE_2D_MULTISAMPLE, 0);
       glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D_MULTISAMPLE, m_textureBuffer.id, 0);
     }
     else
     {
-      glBindTexture(GL_TEXTURE_2D, m_textureBuffer.id);
+      RenderState::Get().BindTexture(0, GL_TEXTURE_2D, m_textureBuffer.id);
       glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, _bufferWidth, _bufferHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -50,7 +51,7 @@ namespace GameEngine
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
       GLfloat borderColor[] = { 1.0, 1.0, 1.0, 1.0 };
       glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-      glBindTexture(GL_TEXTURE_2D, 0);
+      RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
       glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_textureBuffer.id, 0);
     }
     glDrawBuffer(GL_NONE);
@@ -58,8 +59,10 @@ namespace GameEngine
   }
   void DepthMapFBO::AttachDepthCubemap(int _bufferWidth/*= 1024*/, int _bufferHeight/*= 1024*/)
   {
+    m_cubemapWidth = _bufferWidth;
+    m_cubemapHeight = _bufferHeight;
     glGenTextures(1, &m_depthCubemap.id);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_depthCubemap.id);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_CUBE_MAP, m_depthCubemap.id);
     for (size_t i = 0; i < 6; i++)
     {
       glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT,
@@ -74,4 +77,102 @@ namespace GameEngine
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
   }
+  void DepthMapFBO::AttachStaticCache()
+  {
+    glGenTextures(1, &m_staticCubemap.id);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_CUBE_MAP, m_staticCubemap.id);
+    for (size_t i = 0; i < 6; i++)
+    {
+      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT,
+        m_cubemapWidth, m_cubemapHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_CUBE_MAP, 0);
+
+    GLint previousFbo = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+    glGenFramebuffers(1, &m_staticFboID);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_staticFboID);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_staticCubemap.id, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+    m_staticCacheValid = false;
+  }
+
+  void DepthMapFBO::DisposeStaticCache()
+  {
+    if (m_staticFboID != 0)
+    {
+      glDeleteFramebuffers(1, &m_staticFboID);
+      m_staticFboID = 0;
+    }
+    if (m_staticCubemap.id != 0)
+    {
+      RenderState::Get().DeleteTextures(1, &m_staticCubemap.id);
+      m_staticCubemap.id = 0;
+    }
+    m_staticCacheValid = false;
+  }
+
+  void DepthMapFBO::BindStaticCache()
+  {
+    glViewport(0, 0, m_cubemapWidth, m_cubemapHeight);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_staticFboID);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    m_staticCacheValid = m_staticFboID != 0;
+  }
+
+  void DepthMapFBO::BindWithStaticCache(GLenum _target)
+  {
+    glViewport(0, 0, m_cubemapWidth, m_cubemapHeight);
+    if (!m_staticCacheValid)
+    {
+      Bind(_target, m_cubemapWidth, m_cubemapHeight);
+      return;
+    }
+    if (GLEW_VERSION_4_3 || GLEW_ARB_copy_image)
+    {
+      //the 6 faces in one copy, no framebuffer involved
+      glCopyImageSubData(m_staticCubemap.id, GL_TEXTURE_CUBE_MAP, 0, 0, 0, 0,
+        m_depthCubemap.id, GL_TEXTURE_CUBE_MAP, 0, 0, 0, 0, m_cubemapWidth, m_cubemapHeight, 6);
+      glBindFramebuffer(_target, m_fboID);
+      return;
+    }
+    //a blit reads the first layer of a layered attachment only, so a face at a time and the cubemaps attached back after
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_staticFboID);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_fboID);
+    for (GLenum face = 0; face < 6; face++)
+    {
+      glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, m_staticCubemap.id, 0);
+      glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, m_depthCubemap.id, 0);
+      glBlitFramebuffer(0, 0, m_cubemapWidth, m_cubemapHeight, 0, 0, m_cubemapWidth, m_cubemapHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    }
+    glFramebufferTexture(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_staticCubemap.id, 0);
+    glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depthCubemap.id, 0);
+    glBindFramebuffer(_target, m_fboID);
+  }
+
+  void DepthMapFBO::AttachDepthTextureArray(int _bufferWidth, int _bufferHeight, int _layers)
+  {
+    glGenTextures(1, &m_depthTexture.id);
+    m_depthTexture.width = _bufferWidth;
+    m_depthTexture.height = _bufferHeight;
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D_ARRAY, m_depthTexture.id);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, _bufferWidth, _bufferHeight, _layers, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    //linear with the comparison filters the 4 nearest results, a 2x2 PCF for free
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    GLfloat borderColor[] = { 1.0, 1.0, 1.0, 1.0 };
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depthTexture.id, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+  }
 }
\ No newline at end of file
@@ -20,9 +20,34 @@ namespace GameEngine
 
     void AttachDepthCubemap(int _bufferWidth = 1024, int _bufferHeight = 1024);
 
+    /** Attaches a GL_TEXTURE_2D_ARRAY of depths, all of its layers (a shader picks one with gl_Layer). It's the depth texture (see
+    * GetDepthTexture), with the depth comparison on, for a sampler2DArrayShadow */
+    void AttachDepthTextureArray(int _bufferWidth, int _bufferHeight, int _layers);
+
+    /** Attaches a second depth cubemap keeping the static casters, of the size of the one of AttachDepthCubemap (call it first). The
+    * static casters are rendered into it only when it's invalid (BindStaticCache), then every frame starts from a copy of it
+    * (BindWithStaticCache) and only the dynamic casters are drawn over */
+    void AttachStaticCache();
+    /** Frees the cache, the fbo keeps working without it */
+    void DisposeStaticCache();
+
+    /** The cache has to be rendered again when the light or a static caster moves */
+    void InvalidateStaticCache() { m_staticCacheValid = false; }
+    bool IsStaticCacheValid() const noexcept { return m_staticCacheValid; }
+
+    /** Binds the cache and clears it to render the static casters, it's valid again after */
+    void BindStaticCache();
+    /** Binds this fbo and copies the static casters into its cubemap instead of clearing it, the dynamic casters are drawn over */
+    void BindWithStaticCache(GLenum _target);
+
     GLCubemap GetCubemap() const noexcept { return m_depthCubemap; }
   private:
     GLCubemap m_depthCubemap;
+    GLCubemap m_staticCubemap;   ///< the static casters, see AttachStaticCache
+    GLuint m_staticFboID{ 0 };
+    int m_cubemapWidth{ 0 };
+    int m_cubemapHeight{ 0 };
+    bool m_staticCacheValid{ false };
   };
 
 }
@@ -0,0 +1,108 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace GameEngine
+{
+  //how much of a new frame time goes into the smoothed one
+  static constexpr float TIME_SMOOTHING{ 0.2f };
+  //the scale grows only under this much of the target, so it doesn't go up and down around it
+  static constexpr float GROW_THRESHOLD{ 0.85f };
+  //the most one change scales by, a spike doesn't drop the resolution all the way at once
+  static constexpr float MAX_CHANGE{ 0.15f };
+
+  void DynamicResolution::Init(float _targetMilliseconds, float _minScale /*= 0.5f*/, float _maxScale /*= 1.0f*/)
+  {
+    Dispose();
+    m_targetMilliseconds = _targetMilliseconds;
+    m_minScale = std::min(_minScale, _maxScale);
+    m_maxScale = _maxScale;
+    m_scale = m_maxScale;
+    m_gpuMilliseconds = 0.0f;
+    m_framesSinceChange = 0;
+    m_frame = 0;
+    glGenQueries(static_cast<GLsizei>(QUERY_FRAMES * 2), &m_queries[0][0]);
+  }
+
+  void DynamicResolution::Dispose()
+  {
+    if (IsInitialized())
+    {
+      glDeleteQueries(static_cast<GLsizei>(QUERY_FRAMES * 2), &m_queries[0][0]);
+    }
+    for (size_t i = 0; i < QUERY_FRAMES; i++)
+    {
+      m_queries[i][0] = 0;
+      m_queries[i][1] = 0;
+      m_issued[i] = false;
+    }
+  }
+
+  void DynamicResolution::BeginFrame()
+  {
+    if (!IsInitialized())
+    {
+      return;
+    }
+    m_framesSinceChange++;
+    //the queries of this slot are the frame QUERY_FRAMES ago, the GPU is done with it unless it's very far behind
+    if (m_issued[m_frame])
+    {
+      GLint available = 0;
+      glGetQueryObjectiv(m_queries[m_frame][1], GL_QUERY_RESULT_AVAILABLE, &available);
+      if (available != 0)
+      {
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(m_queries[m_frame][0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(m_queries[m_frame][1], GL_QUERY_RESULT, &end);
+        const float milliseconds = static_cast<float>(end - begin) * 1e-6f;
+        m_gpuMilliseconds = m_gpuMilliseconds == 0.0f ? milliseconds : m_gpuMilliseconds + (milliseconds - m_gpuMilliseconds) * TIME_SMOOTHING;
+        //the frames still in flight after a change were drawn at the old scale
+        if (m_framesSinceChange >= CHANGE_INTERVAL + static_cast<int>(QUERY_FRAMES))
+        {
+          const float scale = ChooseScale(m_gpuMilliseconds);
+          if (scale != m_scale)
+          {
+            m_scale = scale;
+            m_framesSinceChange = 0;
+          }
+        }
+      }
+    }
+    glQueryCounter(m_queries[m_frame][0], GL_TIMESTAMP);
+  }
+
+  void DynamicResolution::EndFrame()
+  {
+    if (!IsInitialized())
+    {
+      return;
+    }
+    glQueryCounter(m_queries[m_frame][1], GL_TIMESTAMP);
+    m_issued[m_frame] = true;
+    m_frame = (m_frame + 1) % QUERY_FRAMES;
+  }
+
+  float DynamicResolution::ChooseScale(float _milliseconds) const
+  {
+    if (_milliseconds <= 0.0f || (_milliseconds <= m_targetMilliseconds && _milliseconds >= m_targetMilliseconds * GROW_THRESHOLD))
+    {
+      return m_scale;
+    }
+    //the cost goes with the pixels, the square of the scale
+    const float change = std::min(std::max(std::sqrt(m_targetMilliseconds / _milliseconds), 1.0f - MAX_CHANGE), 1.0f + MAX_CHANGE);
+    float scale = std::round(m_scale * change / SCALE_STEP) * SCALE_STEP;
+    //a step at least, the rounding mustn't keep it where it is
+    if (_milliseconds > m_targetMilliseconds)
+    {
+      scale = std::min(scale, m_scale - SCALE_STEP);
+    }
+    else
+    {
+      scale = std::max(scale, m_scale + SCALE_STEP);
+    }
+    return std::min(std::max(scale, m_minScale), m_maxScale);
+  }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <GL\glew.h>
+#include <cstddef>
+
+namespace GameEngine
+{
+  /** \brief Picks the scale the scene is rendered at from how long the GPU took for the last frames, so a heavy scene or a weak GPU
+  * drops the resolution instead of the frame rate. The frame is timed with two timestamp queries (they don't clash with GL_TIME_ELAPSED
+  * or the GpuProfiler), read a few frames later without waiting. The pixels cost about the square of the scale, so the scale moves by
+  * the square root of the target over the smoothed time. It only drops when the frame is over the target and only grows when it's well
+  * under it, and it moves in steps and not every frame, so the targets of the scaled size aren't made again all the time.
+  * The caller renders the scene into a target of GetScale() times the screen and upscales it (see Playground3D's GameplayScreen) */
+  class DynamicResolution
+  {
+  public:
+    //the frames of queries in flight, a frame's time is read when its queries come around again
+    static constexpr size_t QUERY_FRAMES{ 3 };
+    //the scale is a multiple of this
+    static constexpr float SCALE_STEP{ 0.05f };
+    //the frames between two changes of the scale, the frames after a change measure the new scale first
+    static constexpr int CHANGE_INTERVAL{ 8 };
+
+    DynamicResolution() {}
+    ~DynamicResolution() { Dispose(); }
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+    /** \brief Creates the queries, the scale starts at _maxScale
+    * \param[in] _targetMilliseconds The GPU time of a frame to stay under, e.g. 16.6 for 60 fps with some margin kept by the controller
+    */
+    void Init(float _targetMilliseconds, float _minScale = 0.5f, float _maxScale = 1.0f);
+    void Dispose();
+
+    /** \brief Reads the time of the oldest frame in flight, adjusts the scale and starts timing this frame, before its first GL command */
+    void BeginFrame();
+    /** \brief Stops timing the frame, after its last GL command (before the swap) */
+    void EndFrame();
+
+    /** \brief The scale of the screen size to render the scene at this frame, in [min, max] */
+    float GetScale() const noexcept { return m_scale; }
+    /** \brief The smoothed GPU time of the frames, 0 before the first one is read */
+    float GetGpuMilliseconds() const noexcept { return m_gpuMilliseconds; }
+    void SetTargetMilliseconds(float _milliseconds) noexcept { m_targetMilliseconds = _milliseconds; }
+    float GetTargetMilliseconds() const noexcept { return m_targetMilliseconds; }
+
+    bool IsInitialized() const noexcept { return m_queries[0][0] != 0; }
+
+  private:
+    //the scale a time of _milliseconds asks for, or the current one while it's within the band
+    float ChooseScale(float _milliseconds) const;
+
+    GLuint m_queries[QUERY_FRAMES][2]{}; ///< the begin and end timestamps of every frame in flight
+    bool m_issued[QUERY_FRAMES]{};       ///< the queries of the frame were issued, so they can be read
+    size_t m_frame{ 0 };                 ///< the index of the current frame's queries
+    float m_scale{ 1.0f };
+    float m_minScale{ 0.5f };
+    float m_maxScale{ 1.0f };
+    float m_targetMilliseconds{ 16.0f };
+    float m_gpuMilliseconds{ 0.0f };
+    int m_framesSinceChange{ 0 };
+  };
+}
@@ -1,34 +1,73 @@
 #pragma once
 
+#include <array>
 #include <bitset>
 #include <cassert>
+#include <cstdint>
 #include "Component.h"
 #include "EntityManager.h"
 
-constexpr std::size_t MAX_COMPONENTS{ 32 };
-
 namespace GameEngine
 {
   //using Group = std::size_t;
-  //using ComponentBitset = std::bitset<MAX_COMPONENTS>;
   //using GroupBitset = std::bitset<MAX_GROUPS>;
   //using ComponentArray = std::array<Component*, MAX_COMPONENTS>;
 
-  //The entity class is used to contain components and to Update and Draw them
+  /** The entity class is used to contain components and to Update and Draw them.
+  * The components themselves live in the per type pools of the EntityManager */
   class Entity
   {
+    //the manager keeps the intrusive group and entity list indices up to date
+    friend class EntityManager;
   public:
-    Entity(EntityManager& _manager) : m_manager(_manager) {}
-    ~Entity() {}
+    Entity(EntityManager& _manager) : m_manager(_manager) { m_groupSlots.fill(INVALID_SLOT); }
+    //give the components back to their pools
+    ~Entity() { ReleaseComponents(); }
 
-    //Update the Entity
-    void Update(float _deltaTime) { for (auto& component : m_components) { component->Update(_deltaTime); } }
+    //gives all the components back to their pools (the slot of a destroyed entity is recycled by the EntityManager)
+    void ReleaseComponents()
+    {
+      //the components are stored in the order of their IDs
+      std::size_t index = 0;
+      for (ComponentID id = 0; index < m_components.size(); id++)
+      {
+        if (m_componentBitset[id])
+        {
+          m_manager.DestroyComponent(id, m_components[index++]);
+        }
+      }
+      m_components.clear();
+      m_componentBitset.reset();
+      m_groupBitset.reset();
+    }
+
+    //prepares a recycled slot for a new entity
+    void Revive(EntityHandle _handle) noexcept
+    {
+      m_handle = _handle;
+      m_alive = true;
+      m_entitySlot = INVALID_SLOT;
+      m_groupSlots.fill(INVALID_SLOT);
+    }
+
+    //the handle which refers to this entity
+    EntityHandle GetHandle() const noexcept { return m_handle; }
+
+    //Update the Entity (the EntityManager updates whole pools instead)
+    void Update(float _deltaTime) { for (Component* component : m_components) { component->Update(_deltaTime); } }
 
     //Draw the entity
-    void Draw() { for (auto& component : m_components) { component->Draw(); } }
+    void Draw() { for (Component* component : m_components) { component->Draw(); } }
 
-    //Destroy the entity
-    void Destroy() { m_alive = false; }
+    //Destroy the entity (it's removed from the manager and its groups on the next Refresh)
+    void Destroy()
+    {
+      if (m_alive)
+      {
+        m_alive = false;
+        m_manager.QueueRemoval(this);
+      }
+    }
     //Get the isAlive flag
     bool IsAlive() const noexcept { return m_alive; }
 
@@ -38,6 +77,9 @@ namespace GameEngine
       return m_componentBitset[GetComponentTypeID<T>()];
     }
 
+    //the bits of all the component types this entity has
+    const ComponentBitset& GetComponentBitset() const noexcept { return m_componentBitset; }
+
     bool HasGroup(std::size_t _group) const noexcept
     {
       return m_groupBitset[_group];
@@ -46,10 +88,22 @@ namespace GameEngine
     void AddGroup(std::size_t _group) noexcept
     {
       m_groupBitset[_group] = true;
-      m_manager.AddToGroup(this, _group);
+      //it may still be in the group vector if it was removed from the group since the last Refresh
+      if (m_groupSlots[_group] == INVALID_SLOT)
+      {
+        m_manager.AddToGroup(this, _group);
+      }
     }
 
-    void DelGroup(std::size_t _group) noexcept { m_groupBitset[_group] = false; }
+    //the entity leaves the group vector on the next Refresh
+    void DelGroup(std::size_t _group) noexcept
+    {
+      if (m_groupBitset[_group])
+      {
+        m_groupBitset[_group] = false;
+        m_manager.QueueGroupRemoval(this, _group);
+      }
+    }
 
     /** \brief Add components to this element of any type
     * \param[in] T is the component type
@@ -60,18 +114,12 @@ namespace GameEngine
       //check if this component is not already added
       assert(!HasComponent<T>());
 
-      //begin by allocating component of type T on the heap by forwarding the passed arguments to its constructor
-      T* c(new T(std::forward<TArgs>(_args)...));
-      c->m_entity = this;
-      //wrap the raw pointer into a smart one to make sure there are no memory leaks
-      std::unique_ptr<Component> component{ c };
-
-      //Add the component to the vector (std::move is required as unique pointers cannot be copied)
-      m_components.emplace_back(std::move(component));
+      //construct the component in the contiguous pool of type T by forwarding the passed arguments to its constructor
+      T* c(m_manager.GetPool<T>().Create(std::forward<TArgs>(_args)...));
 
-      //when a component of type T is added, add it to the bitset and the array
-      m_componentArray[GetComponentTypeID<T>()] = c;
-      m_componentBitset[GetComponentTypeID<T>()] = true;
+      AttachComponent(c);
+      //the entity may match different queries now
+      m_manager.InvalidateQueries();
 
       //call the constructor of this component
       c->Init();
@@ -82,29 +130,100 @@ namespace GameEngine
 
     template<typename T> T& GetComponent() const
     {
-      //get a specific component from the m_componentArray;
+      //get a specific component from the m_components;
       //check if it has this component
       assert(HasComponent<T>());
-      //get the component pointer
-      auto componentPointer(m_componentArray[GetComponentTypeID<T>()]);
+      //get the component pointer, its index is the number of the entity's components with a lower ID
+      auto componentPointer(m_components[GetComponentRank(m_componentBitset, GetComponentTypeID<T>())]);
       //return the dereferenced component pointer (casted to the derived type T)
       return *reinterpret_cast<T*>(componentPointer);
     }
 
   private:
+    template<typename T>
+    void AttachComponent(T* _component)
+    {
+      _component->m_entity = this;
+      //when a component of type T is added, insert it at its ID's rank and add it to the bitset
+      const ComponentID id = GetComponentTypeID<T>();
+      m_components.insert(m_components.begin() + GetComponentRank(m_componentBitset, id), _component);
+      m_componentBitset[id] = true;
+    }
+
     //Keep track whether the entity is alive or dead with a boolean flag
     bool m_alive{ true };
 
+    EntityHandle m_handle;
+
+    //position of the entity in the EntityManager vectors, so it can be swap-removed in O(1)
+    enum : std::uint32_t { INVALID_SLOT = 0xFFFFFFFFu };
+    std::uint32_t m_entitySlot{ INVALID_SLOT };
+    std::array<std::uint32_t, MAX_GROUPS> m_groupSlots;
+
     EntityManager& m_manager;
 
-    //An entity is also composed of numerous components
-    //Therefore the components will be stored in an std::vector as unique pointers to allow polymorphism
-    std::vector<std::unique_ptr<Component>> m_components;
+    //An entity is also composed of numerous components, only the ones it owns are stored (sorted by their type ID)
+    std::vector<Component*> m_components;
 
     // A bitset to check the existance of a component with a specific ID
-    std::bitset<MAX_COMPONENTS> m_componentBitset;
+    ComponentBitset m_componentBitset;
     std::bitset<MAX_GROUPS> m_groupBitset;
-    // An array to get a component with specific ID
-    std::array<Component*, MAX_COMPONENTS> m_componentArray;
   };
+
+  //defined here because it needs the complete Entity
+  template<typename... Ts, typename F>
+  void EntityManager::Each(F&& _function)
+  {
+    //the components are handed out writable
+    int expand[] = { 0, (GetPool<Ts>().MarkDirty(), 0)... };
+    (void)expand;
+    for (Entity* entity : GetMatchingEntities(GetComponentSignature<Ts...>()))
+    {
+      if (entity->IsAlive())
+      {
+        _function(entity->GetComponent<Ts>()...);
+      }
+    }
+  }
+
+  template<typename... Ts>
+  std::vector<Entity*> EntityManager::Instantiate(const Prefab<Ts...>& _prefab, std::size_t _count)
+  {
+    std::vector<Entity*> entities;
+    entities.reserve(_count);
+    m_toAdd.reserve(m_toAdd.size() + _count);
+    for (std::size_t i = 0; i < _count; i++)
+    {
+      Entity* entity = AddEntity();
+      entity->m_components.reserve(sizeof...(Ts));
+      entities.push_back(entity);
+    }
+
+    //one pass per component type, each one copies the prototype into a reserved run of its pool
+    std::vector<Component*> components;
+    components.reserve(_count * sizeof...(Ts));
+    int expand[] = { 0, (InstantiateComponents<Ts>(_prefab.template Get<Ts>(), entities, components), 0)... };
+    (void)expand;
+    InvalidateQueries();
+
+    //every entity has all its components now, so Init can look up its siblings
+    for (Component* component : components)
+    {
+      component->Init();
+    }
+    return entities;
+  }
+
+  template<typename T>
+  void EntityManager::InstantiateComponents(const T& _prototype, const std::vector<Entity*>& _entities, std::vector<Component*>& _components)
+  {
+    ComponentPool<T>& pool = GetPool<T>();
+    pool.Reserve(_entities.size());
+    for (Entity* entity : _entities)
+    {
+      T* component = pool.Create(_prototype);
+      entity->AttachComponent(component);
+      _components.push_back(component);
+    }
+  }
 }
\ No newline at end of file
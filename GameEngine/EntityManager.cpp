@@ -1,5 +1,6 @@
 #include "EntityManager.h"
 #include "Entity.h"
+#include "FrameStats.h"
 
 #include <algorithm>
 
@@ -7,6 +8,10 @@ namespace GameEngine
 {
   EntityManager::EntityManager()
   {
+    for (WorldSnapshot& snapshot : m_snapshots)
+    {
+      snapshot.m_poolVersions.fill(0);
+    }
   }
 
 
@@ -16,55 +21,240 @@ namespace GameEngine
 
   void EntityManager::Update(float _deltaTime)
   {
-    for (auto& entity : m_entities)
+    FrameStats::Get().Set(STAT_ENTITIES, m_entities.size());
+    //one type at a time, so each pass streams through a single contiguous pool
+    for (auto& pool : m_pools)
     {
-      entity->Update(_deltaTime);
+      if (pool)
+      {
+        pool->UpdateAll(_deltaTime);
+      }
     }
   }
 
   void EntityManager::Draw()
   {
-    for (auto& entity : m_entities)
+    for (auto& pool : m_pools)
     {
-      entity->Draw();
+      if (pool)
+      {
+        pool->DrawAll();
+      }
     }
   }
 
   void EntityManager::Refresh()
   {
-    for (auto i(0u); i < MAX_GROUPS; ++i)
+    //nothing happened since the last Refresh, so there is nothing to sweep
+    if (m_toAdd.empty() && m_pendingRemovals.empty() && m_pendingGroupRemovals.empty())
     {
-      auto& vectorOfEntities(m_groupedEntities[i]);
+      return;
+    }
 
-      vectorOfEntities.erase(std::remove_if(std::begin(vectorOfEntities), std::end(vectorOfEntities),
-        [i](Entity* _entity)
+    //entities which left a group (and didn't rejoin it since)
+    for (auto& removal : m_pendingGroupRemovals)
+    {
+      Entity* entity = removal.first;
+      if (entity->IsAlive() && !entity->HasGroup(removal.second) && entity->m_groupSlots[removal.second] != Entity::INVALID_SLOT)
       {
-        return !_entity->IsAlive() ||
-          !_entity->HasGroup(i);
-      }),
-        std::end(vectorOfEntities));
+        RemoveFromGroup(entity, removal.second);
+      }
     }
+    m_pendingGroupRemovals.clear();
 
-    m_entities.erase(
-      std::remove_if(std::begin(m_entities), std::end(m_entities),
-        [](const std::unique_ptr<Entity>& _entity)
-    {
-      return !_entity->IsAlive();
-    }),
-      std::end(m_entities));
+    //any entity joining or leaving changes what the queries match
+    InvalidateQueries();
 
-    for (auto& entity : m_toAdd)
+    //the new entities join the updates, the ones destroyed before they were ever refreshed are in the removals
+    for (Entity* entity : m_toAdd)
     {
-      m_entities.emplace_back(std::move(entity));
+      if (entity->IsAlive())
+      {
+        entity->m_entitySlot = static_cast<std::uint32_t>(m_entities.size());
+        m_entities.push_back(entity);
+      }
     }
     m_toAdd.clear();
+
+    for (Entity* entity : m_pendingRemovals)
+    {
+      for (std::size_t group = 0; group < MAX_GROUPS; group++)
+      {
+        if (entity->m_groupSlots[group] != Entity::INVALID_SLOT)
+        {
+          RemoveFromGroup(entity, group);
+        }
+      }
+      const std::uint32_t slot = entity->m_entitySlot;
+      if (slot != Entity::INVALID_SLOT)
+      {
+        //swap-remove from the entity list
+        Entity* last = m_entities.back();
+        m_entities[slot] = last;
+        last->m_entitySlot = slot;
+        m_entities.pop_back();
+      }
+      RecycleSlot(entity);
+    }
+    m_pendingRemovals.clear();
+  }
+
+  void EntityManager::AddToGroup(Entity* _entity, std::size_t _group)
+  {
+    m_structureVersion++;
+    _entity->m_groupSlots[_group] = static_cast<std::uint32_t>(m_groupedEntities[_group].size());
+    m_groupedEntities[_group].emplace_back(_entity);
+  }
+
+  void EntityManager::RemoveFromGroup(Entity* _entity, std::size_t _group)
+  {
+    auto& group = m_groupedEntities[_group];
+    const std::uint32_t slot = _entity->m_groupSlots[_group];
+    Entity* last = group.back();
+    group[slot] = last;
+    last->m_groupSlots[_group] = slot;
+    group.pop_back();
+    _entity->m_groupSlots[_group] = Entity::INVALID_SLOT;
+  }
+
+  const std::vector<Entity*>& EntityManager::GetMatchingEntities(const ComponentBitset& _signature)
+  {
+    //the references to the results stay valid, unordered_map never moves its elements
+    std::lock_guard<std::mutex> lock(m_queryMutex);
+    if (m_queriesDirty)
+    {
+      m_queryVersion++;
+      m_queriesDirty = false;
+    }
+    Query& query = m_queries[_signature];
+    if (query.m_version != m_queryVersion)
+    {
+      query.m_entities.clear();
+      for (auto& entity : m_entities)
+      {
+        if ((entity->GetComponentBitset() & _signature) == _signature)
+        {
+          query.m_entities.push_back(entity);
+        }
+      }
+      query.m_version = m_queryVersion;
+    }
+    return query.m_entities;
   }
 
   Entity* EntityManager::AddEntity()
   {
-    //create the new entity unique pointer
-    m_toAdd.emplace_back(std::make_unique<Entity>(*this));
+    //reuse a free slot, the table only grows when all of them are taken
+    std::uint32_t index;
+    if (!m_freeSlots.empty())
+    {
+      index = m_freeSlots.back();
+      m_freeSlots.pop_back();
+    }
+    else
+    {
+      index = static_cast<std::uint32_t>(m_entityTable.size());
+      assert(index <= EntityHandle::INDEX_MASK);
+      m_entityTable.emplace_back(*this);
+      m_generations.push_back(0);
+      m_slotAlive.push_back(false);
+    }
+    m_slotAlive[index] = true;
+    m_structureVersion++;
+
+    Entity* entity = &m_entityTable[index];
+    entity->Revive(EntityHandle(index, m_generations[index]));
+    m_toAdd.push_back(entity);
     //return a reference of the new entity so that the user may use it for something
-    return m_toAdd.back().get();
+    return entity;
+  }
+
+  void EntityManager::RecycleSlot(Entity* _entity)
+  {
+    const std::uint32_t index = _entity->GetHandle().GetIndex();
+    _entity->ReleaseComponents();
+    //the new generation makes the old handles stale
+    m_generations[index] = (m_generations[index] + 1) & EntityHandle::GENERATION_MASK;
+    m_slotAlive[index] = false;
+    m_freeSlots.push_back(index);
+  }
+
+  Entity* EntityManager::GetEntity(EntityHandle _handle)
+  {
+    return IsValid(_handle) ? &m_entityTable[_handle.GetIndex()] : nullptr;
+  }
+
+  void EntityManager::SaveSnapshot(std::uint32_t _frame)
+  {
+    WorldSnapshot& snapshot = m_snapshots[m_nextSnapshot];
+    m_nextSnapshot = (m_nextSnapshot + 1) % SNAPSHOT_RING_SIZE;
+    snapshot.m_frame = _frame;
+    snapshot.m_isValid = true;
+    snapshot.m_structureVersion = m_structureVersion;
+    for (std::size_t id = 0; id < MAX_COMPONENTS; id++)
+    {
+      IComponentPool* pool = m_pools[id].get();
+      if (!pool || !pool->IsSnapshotSafe())
+      {
+        snapshot.m_poolVersions[id] = 0;
+        continue;
+      }
+      //a changed pool is a new state, the versions are unique across the pools and the ring
+      if (pool->m_dirty)
+      {
+        pool->m_stateVersion = ++m_lastStateVersion;
+        pool->m_dirty = false;
+      }
+      //the ring slot still has this very state from an earlier save
+      if (snapshot.m_poolVersions[id] == pool->m_stateVersion)
+      {
+        continue;
+      }
+      std::vector<unsigned char>& buffer = snapshot.m_pools[id];
+      buffer.resize(pool->GetStateSize());
+      pool->SaveState(buffer.data());
+      snapshot.m_poolVersions[id] = pool->m_stateVersion;
+    }
+  }
+
+  bool EntityManager::RestoreSnapshot(std::uint32_t _frame)
+  {
+    WorldSnapshot* snapshot = FindSnapshot(_frame);
+    if (snapshot == nullptr || snapshot->m_structureVersion != m_structureVersion)
+    {
+      return false;
+    }
+    for (std::size_t id = 0; id < MAX_COMPONENTS; id++)
+    {
+      IComponentPool* pool = m_pools[id].get();
+      if (!pool || snapshot->m_poolVersions[id] == 0)
+      {
+        continue;
+      }
+      //untouched since it was in this state
+      if (!pool->m_dirty && pool->m_stateVersion == snapshot->m_poolVersions[id])
+      {
+        continue;
+      }
+      assert(snapshot->m_pools[id].size() == pool->GetStateSize());
+      pool->RestoreState(snapshot->m_pools[id].data());
+      pool->m_stateVersion = snapshot->m_poolVersions[id];
+      pool->m_dirty = false;
+    }
+    return true;
+  }
+
+  EntityManager::WorldSnapshot* EntityManager::FindSnapshot(std::uint32_t _frame)
+  {
+    //the newest first, a frame simulated again after a rollback is saved again
+    for (std::size_t i = 1; i <= SNAPSHOT_RING_SIZE; i++)
+    {
+      WorldSnapshot& snapshot = m_snapshots[(m_nextSnapshot + SNAPSHOT_RING_SIZE - i) % SNAPSHOT_RING_SIZE];
+      if (snapshot.m_isValid && snapshot.m_frame == _frame)
+      {
+        return &snapshot;
+      }
+    }
+    return nullptr;
   }
 }
\ No newline at end of file
@@ -3,16 +3,45 @@
 #include <memory>
 #include <vector>
 #include <array>
+#include <deque>
+#include <cstdint>
+#include <unordered_map>
+#include <mutex>
+#include "ComponentPool.h"
+#include "Prefab.h"
 
 constexpr std::size_t MAX_GROUPS{ 32 };
 
 namespace GameEngine
 {
+  /** A 32-bit reference to an entity: the index of its slot in the entity table and the generation of the slot.
+  * The generation is bumped every time the slot is recycled, so a handle to a destroyed entity never resolves to its successor */
+  struct EntityHandle
+  {
+    static constexpr std::uint32_t INDEX_BITS{ 20 };
+    static constexpr std::uint32_t INDEX_MASK{ (1u << INDEX_BITS) - 1 };
+    static constexpr std::uint32_t GENERATION_MASK{ (1u << (32 - INDEX_BITS)) - 1 };
+
+    EntityHandle() {}
+    EntityHandle(std::uint32_t _index, std::uint32_t _generation) : m_value((_generation << INDEX_BITS) | (_index & INDEX_MASK)) {}
+
+    std::uint32_t GetIndex() const noexcept { return m_value & INDEX_MASK; }
+    std::uint32_t GetGeneration() const noexcept { return m_value >> INDEX_BITS; }
+
+    bool operator==(const EntityHandle& _other) const noexcept { return m_value == _other.m_value; }
+    bool operator!=(const EntityHandle& _other) const noexcept { return m_value != _other.m_value; }
+
+    std::uint32_t m_value{ 0xFFFFFFFFu }; ///< the default handle is invalid
+  };
+
   class Entity;
   //The entity manager class is used to contain the entities and to Update and Draw them
   class EntityManager
   {
   public:
+    //the world snapshots kept for a rollback, the oldest is overwritten
+    static constexpr std::size_t SNAPSHOT_RING_SIZE{ 8 };
+
     EntityManager();
     ~EntityManager();
 
@@ -22,23 +51,139 @@ namespace GameEngine
 
     void Refresh();
 
+    //creates an entity in a free slot of the entity table (it joins the updates on the next Refresh)
     Entity* AddEntity();
 
-    void AddToGroup(Entity* _entity, std::size_t _group)
+    /** \brief Creates _count entities with copies of the prefab's components in one go.
+    * The pool storage is reserved up front, the components are created type by type (so they end up next to each other)
+    * and then all of them are initialized in one loop, after every entity has its full component set
+    * \return the new entities (they join the updates on the next Refresh) */
+    template<typename... Ts>
+    std::vector<Entity*> Instantiate(const Prefab<Ts...>& _prefab, std::size_t _count);
+
+    /** \brief Resolves a handle in O(1)
+    * \return the entity, or nullptr if Refresh already removed it (even if its slot was reused since) */
+    Entity* GetEntity(EntityHandle _handle);
+    bool IsValid(EntityHandle _handle) const noexcept
     {
-      m_groupedEntities[_group].emplace_back(_entity);
+      const std::uint32_t index = _handle.GetIndex();
+      return index < m_generations.size() && m_generations[index] == _handle.GetGeneration() && m_slotAlive[index];
     }
 
+    //adds the entity to the group vector right away (called by Entity::AddGroup)
+    void AddToGroup(Entity* _entity, std::size_t _group);
+    //the entity left the group, it's swap-removed from the group vector on the next Refresh
+    void QueueGroupRemoval(Entity* _entity, std::size_t _group) { m_pendingGroupRemovals.emplace_back(_entity, _group); m_structureVersion++; }
+    //the entity was destroyed, it's removed on the next Refresh
+    void QueueRemoval(Entity* _entity) { m_pendingRemovals.push_back(_entity); m_structureVersion++; }
+
     std::vector<Entity*>& getEntitiesByGroup(std::size_t _group)
     {
       return m_groupedEntities[_group];
     }
+
+    /** \brief The contiguous storage of all the components of type T, created on first use */
+    template<typename T>
+    ComponentPool<T>& GetPool()
+    {
+      auto& pool = m_pools[GetComponentTypeID<T>()];
+      if (!pool)
+      {
+        pool = std::make_unique<ComponentPool<T>>();
+      }
+      return *static_cast<ComponentPool<T>*>(pool.get());
+    }
+
+    /** \brief Calls _function(T&) for every component of type T, straight from its pool */
+    template<typename T, typename F>
+    void ForEach(F&& _function)
+    {
+      GetPool<T>().ForEach(std::forward<F>(_function));
+    }
+
+    /** \brief Calls _function(Ts&...) with the components of every (refreshed, alive) entity that has all of Ts.
+    * The matching entities are cached per signature and only searched again after entities or components were added or removed */
+    template<typename... Ts, typename F>
+    void Each(F&& _function);
+
+    /** \brief The refreshed entities whose signature contains all the bits of _signature (cached until the next change).
+    * Safe to call from the systems running concurrently in a SystemScheduler stage */
+    const std::vector<Entity*>& GetMatchingEntities(const ComponentBitset& _signature);
+
+    //marks the cached query results as stale (called whenever a signature changes)
+    void InvalidateQueries() noexcept { m_queriesDirty = true; m_structureVersion++; }
+
+    /** \brief Copies the components into the snapshot ring under _frame (e.g. the simulation tick), for a rollback or a restart.
+    * Only the pools of the types with GAMEENGINE_SNAPSHOT_COMPONENT are saved, as the bytes of their blocks, and only the ones
+    * which changed since the ring slot last had them: a pool is changed by its Update, ForEach, Each and by its components being
+    * created or destroyed. The buffers of the ring are reused, they only grow with the pools */
+    void SaveSnapshot(std::uint32_t _frame);
+    /** \brief Puts the components back as they were at _frame, only the pools which changed since are copied.
+    * False if _frame isn't in the ring anymore or if entities, groups or components were added or removed since it was saved:
+    * the entities themselves aren't in the snapshot, a restart which spawned or destroyed some rebuilds the level instead */
+    bool RestoreSnapshot(std::uint32_t _frame);
+    //marks the pool of T changed, for the code which writes its components through their pointers (e.g. GetComponent)
+    template<typename T>
+    void MarkChanged() { GetPool<T>().MarkDirty(); }
+
+    //gives the component with type _id back to its pool (called by the Entity destructor)
+    void DestroyComponent(ComponentID _id, Component* _component)
+    {
+      m_pools[_id]->Destroy(_component);
+    }
   private:
-    //An entity manager contains numerous components
-    //Therefore the components will be stored in an std::vector as unique pointers to allow polymorphism
-    std::vector<std::unique_ptr<Entity>> m_entities;
-    std::vector<std::unique_ptr<Entity>> m_toAdd;
+    //gives the components of a dead entity back and puts its slot on the free list with a new generation
+    void RecycleSlot(Entity* _entity);
+    //swap-removes the entity from the group vector, fixing the slot of the entity moved into its place
+    void RemoveFromGroup(Entity* _entity, std::size_t _group);
+    //copies _prototype into every one of _entities (without calling Init), collecting the new components in _components
+    template<typename T>
+    void InstantiateComponents(const T& _prototype, const std::vector<Entity*>& _entities, std::vector<Component*>& _components);
+
+    //the pools are declared first, so they outlive the entities which give their components back on destruction
+    std::array<std::unique_ptr<IComponentPool>, MAX_COMPONENTS> m_pools;
+
+    //The entity table: a deque never moves its elements, so the entity pointers stay valid, and the slots are recycled
+    std::deque<Entity> m_entityTable;
+    std::vector<std::uint32_t> m_generations; ///< current generation of every slot
+    std::vector<bool> m_slotAlive;            ///< whether the slot holds an entity which hasn't been destroyed yet
+    std::vector<std::uint32_t> m_freeSlots;
+
+    //the refreshed entities and the ones waiting for the next Refresh
+    std::vector<Entity*> m_entities;
+    std::vector<Entity*> m_toAdd;
     std::array<std::vector<Entity*>, MAX_GROUPS> m_groupedEntities;
+
+    //only these are processed by Refresh, instead of sweeping all the vectors
+    std::vector<Entity*> m_pendingRemovals;
+    std::vector<std::pair<Entity*, std::size_t>> m_pendingGroupRemovals;
+
+    // A cached query result, rebuilt on use when it is older than the last signature change
+    struct Query
+    {
+      std::vector<Entity*> m_entities;
+      unsigned int m_version{ 0 };
+    };
+    // The components of all the snapshot-safe pools at one frame
+    struct WorldSnapshot
+    {
+      std::uint32_t m_frame{ 0 };
+      bool m_isValid{ false };
+      std::uint64_t m_structureVersion{ 0 };
+      std::array<std::vector<unsigned char>, MAX_COMPONENTS> m_pools;
+      std::array<std::uint64_t, MAX_COMPONENTS> m_poolVersions; ///< the state version of every pool saved, 0 if it isn't
+    };
+    WorldSnapshot* FindSnapshot(std::uint32_t _frame);
+
+    std::array<WorldSnapshot, SNAPSHOT_RING_SIZE> m_snapshots;
+    std::size_t m_nextSnapshot{ 0 };
+    std::uint64_t m_structureVersion{ 1 }; ///< bumped by everything a snapshot can't undo (entities, groups, components)
+    std::uint64_t m_lastStateVersion{ 0 };
+
+    std::unordered_map<ComponentBitset, Query> m_queries;
+    unsigned int m_queryVersion{ 1 }; ///< bumped every time the queries are invalidated
+    bool m_queriesDirty{ false };
+    std::mutex m_queryMutex; ///< the concurrent systems may look up (and rebuild) queries at the same time
   };
 }
 
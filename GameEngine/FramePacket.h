@@ -0,0 +1,63 @@
+#pragma once
+#include <glm\glm.hpp>
+#include <vector>
+
+#include "RenderQueue3D.h"
+#include "SpriteBatch.h"
+#include "UniformBlocks.h"
+
+namespace GameEngine
+{
+  /** \brief Everything a frame is drawn from, built by the simulation thread and drawn by the render thread (see RenderThread).
+   *  Building it makes no GL calls: the sprites are only recorded and the meshes only submitted, the render thread ends the batches
+   *  and executes the queue. A packet is reused every other frame, the vectors keep their capacity */
+  struct FramePacket
+  {
+    //the sprites drawn with one projection, e.g. the world and the HUD
+    struct SpriteList
+    {
+      GlyphRecorder sprites;
+      glm::mat4 projection{ 1.0f };
+      GlyphSortType sortType{ GlyphSortType::TEXTURE };
+    };
+
+    // Empties the packet for the next frame
+    void Clear()
+    {
+      for (size_t i = 0; i < numSpriteLists; i++)
+      {
+        spriteLists[i].sprites.Clear();
+      }
+      numSpriteLists = 0;
+      pointLights.clear();
+      spotLights.clear();
+      directionalLights.clear();
+    }
+
+    // The next sprite list, the ones of the frames before are reused
+    SpriteList& AddSpriteList(const glm::mat4& _projection, GlyphSortType _sortType = GlyphSortType::TEXTURE)
+    {
+      if (numSpriteLists == spriteLists.size())
+      {
+        spriteLists.emplace_back();
+      }
+      SpriteList& list = spriteLists[numSpriteLists++];
+      list.projection = _projection;
+      list.sortType = _sortType;
+      return list;
+    }
+
+    std::vector<SpriteList> spriteLists; ///< only the first numSpriteLists are this frame's
+    size_t numSpriteLists{ 0 };
+    RenderQueue3D meshes;                ///< begun by the screen, it knows the camera and the far plane
+
+    glm::mat4 view{ 1.0f };
+    glm::mat4 projection{ 1.0f };
+    glm::vec3 cameraPosition{ 0.0f };
+    std::vector<PointLightData> pointLights;
+    std::vector<SpotLightData> spotLights;
+    std::vector<DirectionalLightData> directionalLights;
+
+    float interpolation{ 1.0f };         ///< see IMainGame::GetInterpolation
+  };
+}
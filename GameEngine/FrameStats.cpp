@@ -0,0 +1,99 @@
+#include "FrameStats.h"
+#include "SpriteBatch.h"
+#include "SpriteFont.h"
+
+#include <cstdio>
+#include <iostream>
+
+namespace GameEngine
+{
+  std::atomic<std::uint64_t> g_frameAllocations{ 0 };
+
+  namespace
+  {
+    const char* const ENGINE_STAT_NAMES[NUM_ENGINE_STATS] =
+    {
+      "draw calls", "glyphs", "state changes", "bytes uploaded", "path queries", "expanded nodes", "particles", "entities", "allocations"
+    };
+  }
+
+  FrameStats::FrameStats()
+  {
+    for (unsigned int i = 0; i < MAX_FRAME_STATS; i++)
+    {
+      m_current[i].store(0, std::memory_order_relaxed);
+    }
+    for (unsigned int i = 0; i < NUM_ENGINE_STATS; i++)
+    {
+      m_names[i] = ENGINE_STAT_NAMES[i];
+    }
+  }
+
+  FrameStats& FrameStats::Get()
+  {
+    static FrameStats stats;
+    return stats;
+  }
+
+  unsigned int FrameStats::Register(const std::string& _name)
+  {
+    for (unsigned int i = NUM_ENGINE_STATS; i < m_numStats; i++)
+    {
+      if (m_names[i] == _name)
+      {
+        return i;
+      }
+    }
+    if (m_numStats == MAX_FRAME_STATS)
+    {
+      std::cout << "ERROR::FRAMESTATS::TOO_MANY_STATS\n" << _name << std::endl;
+      return MAX_FRAME_STATS;
+    }
+    m_names[m_numStats] = _name;
+    return m_numStats++;
+  }
+
+  void FrameStats::SetBudget(unsigned int _stat, std::uint64_t _budget)
+  {
+    if (_stat < MAX_FRAME_STATS)
+    {
+      m_budgets[_stat] = _budget;
+      m_reported[_stat] = false;
+    }
+  }
+
+  bool FrameStats::IsOverBudget(unsigned int _stat) const
+  {
+    return _stat < MAX_FRAME_STATS && m_budgets[_stat] > 0 && m_last[_stat] > m_budgets[_stat];
+  }
+
+  void FrameStats::EndFrame()
+  {
+    m_current[STAT_ALLOCATIONS].store(g_frameAllocations.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    for (unsigned int i = 0; i < m_numStats; i++)
+    {
+      m_last[i] = m_current[i].exchange(0, std::memory_order_relaxed);
+      const bool overBudget = IsOverBudget(i);
+      //a regression shows up once in the log instead of every frame
+      if (overBudget && !m_reported[i])
+      {
+        std::cout << "WARNING::FRAMESTATS::OVER_BUDGET\n" << m_names[i] << ": " << m_last[i] << " > " << m_budgets[i] << std::endl;
+      }
+      m_reported[i] = overBudget;
+    }
+  }
+
+  void FrameStats::DrawOverlay(SpriteBatch& _batch, SpriteFont& _font, const glm::vec2& _position, float _scale, float _depth) const
+  {
+    char line[128];
+    const float lineHeight = _font.getFontHeight() * _scale;
+    glm::vec2 position = _position;
+    for (unsigned int i = 0; i < m_numStats; i++)
+    {
+      position.y -= lineHeight;
+      std::snprintf(line, sizeof(line), "%s %llu", m_names[i].c_str(), static_cast<unsigned long long>(m_last[i]));
+      const ColorRGBA8 color = IsOverBudget(i) ? ColorRGBA8(255, 64, 64, 255) : ColorRGBA8(255, 255, 255, 255);
+      _font.draw(_batch, line, position, glm::vec2(_scale), _depth, color);
+    }
+  }
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <glm\glm.hpp>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+//the allocations are counted by replacing the global operator new (in AllocationCounter.cpp) unless the project defines
+//GAME_ENGINE_NO_ALLOCATION_STATS. A program which replaces it itself keeps its own: the linker only takes the engine's when it needs one
+#ifndef GAME_ENGINE_NO_ALLOCATION_STATS
+#define GAME_ENGINE_ALLOCATION_STATS
+#endif
+
+namespace GameEngine
+{
+  class SpriteBatch;
+  class SpriteFont;
+
+  //the operator new calls since the last FrameStats::EndFrame, counted outside of FrameStats: the first FrameStats::Get() allocates
+  extern std::atomic<std::uint64_t> g_frameAllocations;
+
+  //the most stats there can be, the engine's and the registered ones
+  constexpr unsigned int MAX_FRAME_STATS{ 64 };
+
+  //the counters of the engine, the registered ones (see FrameStats::Register) follow them
+  enum Stat : unsigned int
+  {
+    STAT_DRAW_CALLS,
+    STAT_GLYPHS,
+    STAT_STATE_CHANGES,    ///< the program, VAO and texture binds which weren't redundant (see RenderState)
+    STAT_BYTES_UPLOADED,   ///< buffer uploads, glBufferData and glBufferSubData with data and the writes to mapped buffers
+    STAT_PATH_QUERIES,
+    STAT_EXPANDED_NODES,
+    STAT_PARTICLES,        ///< the live ones, set instead of counted
+    STAT_ENTITIES,         ///< set instead of counted
+    STAT_ALLOCATIONS,
+    NUM_ENGINE_STATS
+  };
+
+  /** \brief The counters the subsystems add to during a frame, e.g. the draw calls or the nodes a search expanded. EndFrame keeps the
+   *  totals of the frame (GetLastFrame), which the code can check against budgets and the overlay shows. Adding is a relaxed atomic
+   *  add, so any thread can count */
+  class FrameStats
+  {
+  public:
+    static FrameStats& Get();
+
+    // Adds to the counter of this frame
+    void Add(unsigned int _stat, std::uint64_t _amount = 1)
+    {
+      if (_stat < MAX_FRAME_STATS)
+      {
+        m_current[_stat].fetch_add(_amount, std::memory_order_relaxed);
+      }
+    }
+    // Sets the counter of this frame, for the values which are a level rather than a count (live particles, entities)
+    void Set(unsigned int _stat, std::uint64_t _value)
+    {
+      if (_stat < MAX_FRAME_STATS)
+      {
+        m_current[_stat].store(_value, std::memory_order_relaxed);
+      }
+    }
+
+    // A counter of the game, shown after the engine's. Returns its stat, or MAX_FRAME_STATS (which counts nothing) when they're all taken
+    unsigned int Register(const std::string& _name);
+
+    // Keeps the counters of the frame and resets them, checks the budgets
+    void EndFrame();
+
+    // The counter of the last finished frame
+    std::uint64_t GetLastFrame(unsigned int _stat) const { return _stat < MAX_FRAME_STATS ? m_last[_stat] : 0; }
+    const std::string& GetName(unsigned int _stat) const { return m_names[_stat]; }
+    unsigned int GetNumStats() const noexcept { return m_numStats; }
+
+    // The most the counter should reach in a frame, 0 for no budget. A frame over it is reported once until it's back within
+    void SetBudget(unsigned int _stat, std::uint64_t _budget);
+    bool IsOverBudget(unsigned int _stat) const;
+
+    // Lists the counters of the last frame, the top left of the list at _position, the ones over budget in red
+    void DrawOverlay(SpriteBatch& _batch, SpriteFont& _font, const glm::vec2& _position, float _scale, float _depth) const;
+
+  private:
+    FrameStats();
+
+    std::atomic<std::uint64_t> m_current[MAX_FRAME_STATS];
+    std::uint64_t m_last[MAX_FRAME_STATS]{};
+    std::uint64_t m_budgets[MAX_FRAME_STATS]{};
+    bool m_reported[MAX_FRAME_STATS]{};
+    std::string m_names[MAX_FRAME_STATS];
+    unsigned int m_numStats{ NUM_ENGINE_STATS };
+  };
+}
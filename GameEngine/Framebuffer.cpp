@@ -1,4 +1,5 @@
 #include "Framebuffer.h"
+#include "RenderState.h"
 
 namespace GameEngine
 {
@@ -37,6 +38,15 @@ namespace GameEngine
       glDeleteRenderbuffers(1, &m_rboID);
       m_rboID = 0;
     }
+    for (auto& texture : m_colorTextures)
+    {
+      texture.Dispose();
+    }
+    m_colorTextures.clear();
+    if (m_depthTexture.id != 0)
+    {
+      m_depthTexture.Dispose();
+    }
     m_quad.Dispose();
   }
 
@@ -82,14 +92,14 @@ namespace GameEngine
 
     if (_multisampled)
     {
-      glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_textureBuffer.id);
+      RenderState::Get().BindTexture(0, GL_TEXTURE_2D_MULTISAMPLE, m_textureBuffer.id);
       glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, _samples, attachmentType, _bufferWidth, _bufferHeight, GL_TRUE);
-      glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+      RenderState::Get().BindTexture(0, GL_TEXTURE_2D_MULTISAMPLE, 0);
       glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, m_textureBuffer.id, 0);
     }
     else
     {
-      glBindTexture(GL_TEXTURE_2D, m_textureBuffer.id);
+      RenderState::Get().BindTexture(0, GL_TEXTURE_2D, m_textureBuffer.id);
       if (attachmentType == GL_DEPTH24_STENCIL8)
       {
         glTexImage2D(GL_TEXTURE_2D, 0, attachmentType, _bufferWidth, _bufferHeight, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
@@ -100,7 +110,7 @@ namespace GameEngine
       }
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-      glBindTexture(GL_TEXTURE_2D, 0);
+      RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
       glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_textureBuffer.id, 0);
     }
   }
@@ -156,6 +166,49 @@ namespace GameEngine
     }
   }
 
+  size_t Framebuffer::AttachColorTexture(int _bufferWidth, int _bufferHeight, GLenum _internalFormat, GLenum _format, GLenum _type)
+  {
+    GLTexture texture;
+    texture.width = _bufferWidth;
+    texture.height = _bufferHeight;
+    glGenTextures(1, &texture.id);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, texture.id);
+    glTexImage2D(GL_TEXTURE_2D, 0, _internalFormat, _bufferWidth, _bufferHeight, 0, _format, _type, nullptr);
+    //read texel for pixel, a screen pass doesn't filter
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+
+    const size_t index = m_colorTextures.size();
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(index), GL_TEXTURE_2D, texture.id, 0);
+    m_colorTextures.push_back(texture);
+
+    std::vector<GLenum> drawBuffers;
+    for (size_t i = 0; i < m_colorTextures.size(); i++)
+    {
+      drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(i));
+    }
+    glDrawBuffers(static_cast<GLsizei>(drawBuffers.size()), drawBuffers.data());
+    return index;
+  }
+
+  void Framebuffer::AttachDepthTexture(int _bufferWidth, int _bufferHeight)
+  {
+    m_depthTexture.width = _bufferWidth;
+    m_depthTexture.height = _bufferHeight;
+    glGenTextures(1, &m_depthTexture.id);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, m_depthTexture.id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, _bufferWidth, _bufferHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depthTexture.id, 0);
+  }
+
   void Framebuffer::Render()
   {
     glDisable(GL_DEPTH_TEST);
@@ -1,5 +1,6 @@
 #pragma once
 #include <GL\glew.h>
+#include <vector>
 #include "ScreenQuad.h"
 #include "GLTexture.h"
 
@@ -33,6 +34,14 @@ namespace GameEngine
          Therefore, this can be used when you don't want to sample from a certain part of the framebuffer*/
     virtual void AttachRenderbuffer(int _bufferWidth, int _bufferHeight, bool _depth, bool _stencil, bool _multisampled, int _samples = 4);
 
+    /** Attaches a color texture at the next color attachment (GL_COLOR_ATTACHMENT0 + its index) and draws to all of them (glDrawBuffers),
+        so the fragment shader output at location i writes the attachment i. The framebuffer has to be bound.
+        \return the index of the attachment */
+    size_t AttachColorTexture(int _bufferWidth, int _bufferHeight, GLenum _internalFormat, GLenum _format, GLenum _type);
+
+    /** Attaches a depth texture which can be sampled, e.g. to rebuild the positions of the pixels. The framebuffer has to be bound.*/
+    void AttachDepthTexture(int _bufferWidth, int _bufferHeight);
+
     void Render();
      
     /** Checks if the framebuffer is valid
@@ -43,9 +52,14 @@ namespace GameEngine
     /** Accessors */
     GLuint GetFBO()              const noexcept { return m_fboID; }
     GLTexture GetTextureBuffer() const noexcept { return m_textureBuffer; }
+    GLTexture GetColorTexture(size_t _index) const { return m_colorTextures[_index]; }
+    size_t GetNumColorTextures() const noexcept { return m_colorTextures.size(); }
+    GLTexture GetDepthTexture() const noexcept { return m_depthTexture; }
   protected:
     GLuint m_fboID{ 0 }, m_rboID{ 0 };
     GLTexture m_textureBuffer;
+    std::vector<GLTexture> m_colorTextures; ///< the attachments of AttachColorTexture, in order
+    GLTexture m_depthTexture;
     ScreenQuad m_quad;
   };
 }
@@ -0,0 +1,76 @@
+#include "GBuffer.h"
+#include "GLSLProgram.h"
+#include "RenderState.h"
+
+namespace GameEngine
+{
+  bool GBuffer::Init(int _width, int _height)
+  {
+    m_width = _width;
+    m_height = _height;
+    m_framebuffer.Init();
+    m_framebuffer.Bind(GL_FRAMEBUFFER, _width, _height);
+    m_framebuffer.AttachColorTexture(_width, _height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    m_framebuffer.AttachColorTexture(_width, _height, GL_RGBA16F, GL_RGBA, GL_FLOAT);
+    m_framebuffer.AttachColorTexture(_width, _height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    m_framebuffer.AttachDepthTexture(_width, _height);
+    const bool complete = m_framebuffer.CheckFramebufferStatus();
+    m_framebuffer.Unbind(GL_FRAMEBUFFER, _width, _height);
+    if (!complete)
+    {
+      m_framebuffer.Destroy();
+    }
+    return complete;
+  }
+
+  void GBuffer::Dispose()
+  {
+    m_framebuffer.Destroy();
+  }
+
+  bool GBuffer::Resize(int _width, int _height)
+  {
+    Dispose();
+    return Init(_width, _height);
+  }
+
+  void GBuffer::BindForGeometry()
+  {
+    m_framebuffer.Bind(GL_FRAMEBUFFER, m_width, m_height);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  }
+
+  void GBuffer::Unbind(GLuint _output /*= 0*/)
+  {
+    glBindFramebuffer(GL_FRAMEBUFFER, _output);
+  }
+
+  void GBuffer::SetTextureUnits(GLSLProgram& _lightingShader)
+  {
+    _lightingShader.Use();
+    _lightingShader.UploadValue("gAlbedo", static_cast<int>(ALBEDO));
+    _lightingShader.UploadValue("gNormal", static_cast<int>(NORMAL));
+    _lightingShader.UploadValue("gMaterial", static_cast<int>(MATERIAL));
+    _lightingShader.UploadValue("gDepth", static_cast<int>(DEPTH));
+    _lightingShader.UnUse();
+  }
+
+  void GBuffer::RenderLighting()
+  {
+    RenderState& state = RenderState::Get();
+    state.BindTexture(ALBEDO, GL_TEXTURE_2D, m_framebuffer.GetColorTexture(ALBEDO).id);
+    state.BindTexture(NORMAL, GL_TEXTURE_2D, m_framebuffer.GetColorTexture(NORMAL).id);
+    state.BindTexture(MATERIAL, GL_TEXTURE_2D, m_framebuffer.GetColorTexture(MATERIAL).id);
+    state.BindTexture(DEPTH, GL_TEXTURE_2D, m_framebuffer.GetDepthTexture().id);
+    //every pixel once, the depth test would only reject the quad
+    m_framebuffer.Render();
+  }
+
+  void GBuffer::BlitDepth(GLuint _output /*= 0*/)
+  {
+    m_framebuffer.Bind(GL_READ_FRAMEBUFFER, m_width, m_height);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _output);
+    m_framebuffer.Blit(GL_DEPTH_BUFFER_BIT, GL_NEAREST, m_width, m_height);
+    glBindFramebuffer(GL_FRAMEBUFFER, _output);
+  }
+}
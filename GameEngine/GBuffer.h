@@ -0,0 +1,54 @@
+#pragma once
+#include <GL\glew.h>
+
+#include "Framebuffer.h"
+
+namespace GameEngine
+{
+  class GLSLProgram;
+
+  /** \brief The render targets of deferred shading: the geometry pass writes the surface of every pixel (one fragment shader output per
+  * target), then a screen pass lights each pixel once, so the overdraw costs no lighting and the lights cost the pixels, not the triangles.
+  *   layout (location = 0) out vec4 gAlbedo;    // rgb the diffuse color, a the specular intensity    (RGBA8)
+  *   layout (location = 1) out vec4 gNormal;    // xyz the world space normal                         (RGBA16F)
+  *   layout (location = 2) out vec4 gMaterial;  // r the shininess / 256                              (RGBA8)
+  * and the depth, from which the lighting pass rebuilds the world positions. The lighting shader reads them from the samplers gAlbedo,
+  * gNormal, gMaterial and gDepth, bound to the units of the same names */
+  class GBuffer
+  {
+  public:
+    enum : GLuint { ALBEDO = 0, NORMAL = 1, MATERIAL = 2, DEPTH = 3 };
+
+    GBuffer() {}
+    ~GBuffer() { Dispose(); }
+
+    /** \brief Creates the targets, false if the driver can't render to them */
+    bool Init(int _width, int _height);
+    void Dispose();
+    /** \brief Creates the targets again at the new size of the screen */
+    bool Resize(int _width, int _height);
+
+    /** \brief Binds the targets and clears them for the geometry pass */
+    void BindForGeometry();
+    /** \brief Back to the screen, or to _output when the scene is drawn into a target (e.g. at a dynamic resolution) */
+    void Unbind(GLuint _output = 0);
+
+    /** \brief Sets the sampler units of the lighting shader, once after it's compiled */
+    static void SetTextureUnits(GLSLProgram& _lightingShader);
+    /** \brief Binds the targets and draws the lighting shader in use over the whole screen */
+    void RenderLighting();
+    /** \brief Copies the depth of the scene to the screen, so the forward passes after the lighting (lamps, sky, transparent things)
+    * are hidden by it. _output must be the size of the GBuffer */
+    void BlitDepth(GLuint _output = 0);
+
+    bool IsInitialized() const noexcept { return m_framebuffer.GetFBO() != 0; }
+    int GetWidth() const noexcept { return m_width; }
+    int GetHeight() const noexcept { return m_height; }
+    /** \brief The depth of the geometry pass, e.g. to build a HiZBuffer from */
+    GLTexture GetDepthTexture() const noexcept { return m_framebuffer.GetDepthTexture(); }
+  private:
+    Framebuffer m_framebuffer;
+    int m_width{ 0 };
+    int m_height{ 0 };
+  };
+}
@@ -1,11 +1,174 @@
 #include "GLSLProgram.h"
 #include "GameEngineErrors.h"
 #include "IOManager.h"
+#include "RenderState.h"
+#include "AnimationSystem.h"
+#include "UniformBlocks.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <glm\gtc\type_ptr.hpp>
 namespace GameEngine
 {
+  namespace
+  {
+    //the programs compiled from files while the file watch was on (see GLSLProgram::ReloadChangedFiles)
+    std::vector<GLSLProgram*>& GetReloadablePrograms()
+    {
+      static std::vector<GLSLProgram*> programs;
+      return programs;
+    }
+
+    //where the program binaries are kept (see GLSLProgram::EnableBinaryCache), empty while it's off
+    std::string& GetBinaryCacheDirectory()
+    {
+      static std::string directory;
+      return directory;
+    }
+
+    //the programs are only submitted by the Compile functions and checked when they're needed (see GLSLProgram::EnableParallelCompile)
+    bool& GetParallelCompile()
+    {
+      static bool enabled = false;
+      return enabled;
+    }
+
+    const std::uint32_t BINARY_MAGIC = 0x4E425047; ///< GPBN
+
+    //the start of a cached binary file, the binary of glGetProgramBinary follows
+    struct BinaryHeader
+    {
+      std::uint32_t magic;
+      std::uint32_t format; ///< the binaryFormat glProgramBinary needs
+      AssetId key;          ///< the one of the file name, a hash collision of the names can't load another program
+    };
+
+    //_source with a #define NAME 1 for every one of _defines after its #version line (the first line of any GLSL source that has one)
+    std::string InsertDefines(const char* _source, const std::vector<std::string>& _defines)
+    {
+      std::string source(_source);
+      size_t position = 0;
+      const size_t version = source.find("#version");
+      if (version != std::string::npos)
+      {
+        const size_t lineEnd = source.find('\n', version);
+        position = lineEnd != std::string::npos ? lineEnd + 1 : source.size();
+      }
+      std::string defines;
+      //a version line without an end of line is the whole source
+      if (version != std::string::npos && position == source.size())
+      {
+        defines += '\n';
+      }
+      for (const std::string& define : _defines)
+      {
+        defines += "#define " + define + " 1\n";
+      }
+      source.insert(position, defines);
+      return source;
+    }
+
+    //the hash of everything the binary depends on: a binary only loads on the driver that made it, so the driver is part of the key
+    AssetId GetBinaryKey(const char* _vertexSource, const char* _fragmentSource, const char* _geometrySource, const char* _computeSource,
+      const std::vector<std::string>& _feedbackVaryings)
+    {
+      std::string key;
+      for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+      {
+        const GLubyte* value = glGetString(name);
+        key += value != nullptr ? reinterpret_cast<const char*>(value) : "";
+        key += '\n';
+      }
+      //a separator per stage, a missing stage is an empty one
+      for (const char* source : { _vertexSource, _fragmentSource, _geometrySource, _computeSource })
+      {
+        if (source != nullptr)
+        {
+          key += source;
+        }
+        key += '\0';
+      }
+      for (const auto& varying : _feedbackVaryings)
+      {
+        key += varying + '\n';
+      }
+      return AssetIds::Hash(key);
+    }
+
+    std::string GetBinaryPath(AssetId _key)
+    {
+      char name[32];
+      std::snprintf(name, sizeof(name), "/%016llx.bin", static_cast<unsigned long long>(_key));
+      return GetBinaryCacheDirectory() + name;
+    }
+
+    //copies the values of the plain uniforms both programs have, so a reloaded program keeps the ones set once (e.g. the texture
+    //units of the samplers). The ones in uniform blocks live in their buffers, they have no location
+    void CopyUniforms(ProgramID _from, ProgramID _to)
+    {
+      GLint numUniforms = 0;
+      glGetProgramiv(_from, GL_ACTIVE_UNIFORMS, &numUniforms);
+      for (GLint i = 0; i < numUniforms; i++)
+      {
+        GLchar name[256];
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(_from, i, sizeof(name), &length, &size, &type, name);
+        //an array is named after its first element, name[0]
+        std::string baseName(name, length);
+        const size_t bracket = baseName.find('[');
+        if (bracket != std::string::npos)
+        {
+          baseName.resize(bracket);
+        }
+        for (GLint element = 0; element < size; element++)
+        {
+          const std::string elementName = size > 1 ? baseName + "[" + std::to_string(element) + "]" : baseName;
+          const GLint from = glGetUniformLocation(_from, elementName.c_str());
+          const GLint to = glGetUniformLocation(_to, elementName.c_str());
+          if (from < 0 || to < 0)
+          {
+            continue;
+          }
+          GLfloat floats[16];
+          GLint ints[4];
+          GLuint uints[1];
+          switch (type)
+          {
+          case GL_FLOAT:      glGetUniformfv(_from, from, floats); glProgramUniform1fv(_to, to, 1, floats); break;
+          case GL_FLOAT_VEC2: glGetUniformfv(_from, from, floats); glProgramUniform2fv(_to, to, 1, floats); break;
+          case GL_FLOAT_VEC3: glGetUniformfv(_from, from, floats); glProgramUniform3fv(_to, to, 1, floats); break;
+          case GL_FLOAT_VEC4: glGetUniformfv(_from, from, floats); glProgramUniform4fv(_to, to, 1, floats); break;
+          case GL_FLOAT_MAT3: glGetUniformfv(_from, from, floats); glProgramUniformMatrix3fv(_to, to, 1, GL_FALSE, floats); break;
+          case GL_FLOAT_MAT4: glGetUniformfv(_from, from, floats); glProgramUniformMatrix4fv(_to, to, 1, GL_FALSE, floats); break;
+          case GL_INT_VEC2:   glGetUniformiv(_from, from, ints); glProgramUniform2iv(_to, to, 1, ints); break;
+          case GL_INT_VEC3:   glGetUniformiv(_from, from, ints); glProgramUniform3iv(_to, to, 1, ints); break;
+          case GL_INT_VEC4:   glGetUniformiv(_from, from, ints); glProgramUniform4iv(_to, to, 1, ints); break;
+          case GL_UNSIGNED_INT: glGetUniformuiv(_from, from, uints); glProgramUniform1uiv(_to, to, 1, uints); break;
+          //the samplers are the index of their texture unit
+          case GL_INT:
+          case GL_BOOL:
+          case GL_SAMPLER_2D:
+          case GL_SAMPLER_2D_ARRAY:
+          case GL_SAMPLER_2D_SHADOW:
+          case GL_SAMPLER_3D:
+          case GL_SAMPLER_CUBE:
+          case GL_SAMPLER_BUFFER:
+            glGetUniformiv(_from, from, ints);
+            glProgramUniform1iv(_to, to, 1, ints);
+            break;
+          default:
+            break;
+          }
+        }
+      }
+    }
+  }
+
   //inoitialize all the variables to 0
   GLSLProgram::GLSLProgram()
   {
@@ -23,76 +186,471 @@ namespace GameEngine
   //Compiles the shaders into a form that your GPU can understand
   void GLSLProgram::CompileShaders(const std::string& _vsFilePath, const std::string& _fsFilePath, const std::string& _gsFilePath/* = ""*/)
   {
-    std::string vsSource;
-    std::string fsSource;
-    std::string gsSource;
-
-    IOManager::ReadFileToBuffer(_vsFilePath, vsSource);
-    IOManager::ReadFileToBuffer(_fsFilePath, fsSource);
+    //the stages are read in one batch, they're null terminated for GL afterwards
+    std::vector<std::string> filePaths = { _vsFilePath, _fsFilePath };
     if (_gsFilePath != "")
     {
-      IOManager::ReadFileToBuffer(_gsFilePath, gsSource);
-      CompileShadersFromSource(vsSource.c_str(), fsSource.c_str(), gsSource.c_str());
+      filePaths.push_back(_gsFilePath);
     }
-    else
+    std::vector<std::vector<unsigned char>> sources;
+    if (!ReadSources(filePaths, sources))
     {
-      CompileShadersFromSource(vsSource.c_str(), fsSource.c_str());
+      FatalError("Failed to read the shaders " + _vsFilePath + ", " + _fsFilePath + (_gsFilePath != "" ? ", " + _gsFilePath : ""));
     }
+    const char* vsSource = reinterpret_cast<const char*>(sources[0].data());
+    const char* fsSource = reinterpret_cast<const char*>(sources[1].data());
+    CompileShadersFromSource(vsSource, fsSource, sources.size() > 2 ? reinterpret_cast<const char*>(sources[2].data()) : nullptr);
+    WatchFiles(filePaths);
   }
 
   void GLSLProgram::CompileShadersFromSource(const char* _vertexSource, const char* _fragmentSource, const char* _geometrySource /*= nullptr*/)
   {
+    std::string error;
+    if (!BuildProgram(_vertexSource, _fragmentSource, _geometrySource, nullptr, error))
+    {
+      FatalError(error);
+    }
+  }
+
+  void GLSLProgram::CompileComputeShader(const std::string& _csFilePath)
+  {
+    std::string csSource;
+
+    IOManager::ReadFileToBuffer(_csFilePath, csSource);
+    CompileComputeShaderFromSource(csSource.c_str());
+    WatchFiles({ _csFilePath });
+  }
+
+  void GLSLProgram::CompileComputeShaderFromSource(const char* _computeSource)
+  {
+    std::string error;
+    if (!BuildProgram(nullptr, nullptr, nullptr, _computeSource, error))
+    {
+      FatalError(error);
+    }
+  }
+
+  bool GLSLProgram::Reload()
+  {
+    if (m_filePaths.empty())
+    {
+      return false;
+    }
+    std::vector<std::vector<unsigned char>> sources;
+    if (!ReadSources(m_filePaths, sources))
+    {
+      std::printf("ERROR::HOT_RELOAD::Failed to read the shaders of %s, the program stays as it was\n", m_filePaths.front().c_str());
+      return false;
+    }
+    //the old program has to be whole to carry its uniforms over, and the new one is checked right away
+    FinishBuild();
+    //a single file is a compute shader
+    const ProgramID oldProgramID = m_programID;
+    std::string error;
+    const bool built = m_filePaths.size() == 1 ?
+      BuildProgram(nullptr, nullptr, nullptr, reinterpret_cast<const char*>(sources[0].data()), error, false) :
+      BuildProgram(reinterpret_cast<const char*>(sources[0].data()), reinterpret_cast<const char*>(sources[1].data()),
+        sources.size() > 2 ? reinterpret_cast<const char*>(sources[2].data()) : nullptr, error, false);
+    if (!built)
+    {
+      //a typo while editing the shader shouldn't end the game, the old program keeps drawing until the next save
+      m_programID = oldProgramID;
+      std::printf("ERROR::HOT_RELOAD::%s (%s), the program stays as it was\n", error.c_str(), m_filePaths.front().c_str());
+      return false;
+    }
+    //the values set once (e.g. the texture units) carry over, the locations are looked up again
+    CopyUniforms(oldProgramID, m_programID);
+    for (const auto& blockBinding : m_blockBindings)
+    {
+      const GLuint index = glGetUniformBlockIndex(m_programID, blockBinding.first.c_str());
+      if (index != GL_INVALID_INDEX)
+      {
+        glUniformBlockBinding(m_programID, index, blockBinding.second);
+      }
+    }
+    RenderState::Get().DeleteProgram(oldProgramID);
+    m_attribList.clear();
+    return true;
+  }
+
+  bool GLSLProgram::EnableBinaryCache(const std::string& _directory)
+  {
+    GetBinaryCacheDirectory().clear();
+    if (_directory.empty())
+    {
+      return true;
+    }
+    if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+    {
+      return false;
+    }
+    //some drivers have the functions but no format to save in
+    GLint numFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+    if (numFormats <= 0)
+    {
+      return false;
+    }
+    IOManager::MakeDirectory(_directory.c_str());
+    GetBinaryCacheDirectory() = _directory;
+    return true;
+  }
+
+  bool GLSLProgram::EnableParallelCompile(bool _enable)
+  {
+    GetParallelCompile() = false;
+    if (!_enable)
+    {
+      return true;
+    }
+    //as many threads as the driver wants
+    if (GLEW_KHR_parallel_shader_compile)
+    {
+      glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    }
+    else if (GLEW_ARB_parallel_shader_compile)
+    {
+      glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+    }
+    else
+    {
+      return false;
+    }
+    GetParallelCompile() = true;
+    return true;
+  }
+
+  bool GLSLProgram::IsReady() const
+  {
+    if (!m_buildPending)
+    {
+      return true;
+    }
+    //the same value for the KHR and the ARB extensions
+    GLint completed = GL_FALSE;
+    glGetProgramiv(m_programID, GL_COMPLETION_STATUS_KHR, &completed);
+    return completed == GL_TRUE;
+  }
+
+  void GLSLProgram::FinishBuild()
+  {
+    if (!m_buildPending)
+    {
+      return;
+    }
+    m_buildPending = false;
+    //the status queries wait for the driver's threads. The compile errors are checked first, they tell more than the failed link
+    std::string error;
+    const bool compiled = (m_computeShaderID == 0 || CheckCompileStatus("Compute Shader", m_computeShaderID, error)) &&
+      (m_vertexShaderID == 0 || CheckCompileStatus("Vertex Shader", m_vertexShaderID, error)) &&
+      (m_geometryShaderID == 0 || CheckCompileStatus("Geometry Shader", m_geometryShaderID, error)) &&
+      (m_fragmentShaderID == 0 || CheckCompileStatus("Fragment Shader", m_fragmentShaderID, error));
+    if (!compiled)
+    {
+      DeleteFailedBuild();
+      FatalError(error);
+    }
+    if (!CheckLink(error))
+    {
+      FatalError(error);
+    }
+    if (m_pendingBinaryKey != AssetIds::NONE)
+    {
+      SaveBinary(m_pendingBinaryKey);
+    }
+  }
+
+  void GLSLProgram::ReloadChangedFiles(const std::vector<std::string>& _changedFiles)
+  {
+    for (GLSLProgram* program : GetReloadablePrograms())
+    {
+      for (const auto& filePath : program->m_filePaths)
+      {
+        if (std::find(_changedFiles.begin(), _changedFiles.end(), filePath) != _changedFiles.end())
+        {
+          program->Reload();
+          break;
+        }
+      }
+    }
+  }
+
+  bool GLSLProgram::ReadSources(const std::vector<std::string>& _filePaths, std::vector<std::vector<unsigned char>>& _sources)
+  {
+    if (!IOManager::ReadFilesToBuffers(_filePaths, _sources))
+    {
+      return false;
+    }
+    for (auto& source : _sources)
+    {
+      source.push_back('\0');
+    }
+    return true;
+  }
+
+  void GLSLProgram::WatchFiles(const std::vector<std::string>& _filePaths)
+  {
+    //only the programs of the files are reloaded, the ones from source have nothing to watch
+    if (!IOManager::IsWatchingFiles())
+    {
+      return;
+    }
+    m_filePaths = _filePaths;
+    for (const auto& filePath : _filePaths)
+    {
+      IOManager::WatchFile(filePath);
+    }
+    std::vector<GLSLProgram*>& programs = GetReloadablePrograms();
+    if (std::find(programs.begin(), programs.end(), this) == programs.end())
+    {
+      programs.push_back(this);
+    }
+  }
+
+  bool GLSLProgram::BuildProgram(const char* _vertexSource, const char* _fragmentSource, const char* _geometrySource,
+    const char* _computeSource, std::string& _error, bool _allowParallel /*= true*/)
+  {
+    //the defines become part of the sources, so the binary cache keeps the variants of a source apart too
+    std::string definedSources[4];
+    if (!m_defines.empty())
+    {
+      const char** sources[] = { &_vertexSource, &_fragmentSource, &_geometrySource, &_computeSource };
+      for (int i = 0; i < 4; i++)
+      {
+        if (*sources[i] != nullptr)
+        {
+          definedSources[i] = InsertDefines(*sources[i], m_defines);
+          *sources[i] = definedSources[i].c_str();
+        }
+      }
+    }
+    //a binary of the same sources from this driver skips the compilation
+    const AssetId binaryKey = GetBinaryCacheDirectory().empty() ? AssetIds::NONE :
+      GetBinaryKey(_vertexSource, _fragmentSource, _geometrySource, _computeSource, m_feedbackVaryings);
+    if (binaryKey != AssetIds::NONE && LoadBinary(binaryKey))
+    {
+      return true;
+    }
+
     //Create the GLSL program ID
     m_programID = glCreateProgram();
+    m_vertexShaderID = 0;
+    m_fragmentShaderID = 0;
+    m_geometryShaderID = 0;
+    m_computeShaderID = 0;
 
-    //Create the vertex shader object, and store its ID
-    m_vertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-    if (m_vertexShaderID == 0)
+    if (_computeSource != nullptr)
     {
-      FatalError("Vertex shader failed to be created!");
+      //Create the compute shader object, and store its ID
+      m_computeShaderID = glCreateShader(GL_COMPUTE_SHADER);
+      if (m_computeShaderID == 0)
+      {
+        FatalError("Compute shader failed to be created!");
+      }
     }
-
-    //Create the fragment shader object, and store its ID
-    m_fragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
-    if (m_fragmentShaderID == 0) 
+    else
     {
-      FatalError("Fragment shader failed to be created!");
+      //Create the vertex shader object, and store its ID
+      m_vertexShaderID = glCreateShader(GL_VERTEX_SHADER);
+      if (m_vertexShaderID == 0)
+      {
+        FatalError("Vertex shader failed to be created!");
+      }
+
+      //Create the fragment shader object, and store its ID
+      m_fragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+      if (m_fragmentShaderID == 0)
+      {
+        FatalError("Fragment shader failed to be created!");
+      }
+
+      //Check if there is a geometry shader
+      if (_geometrySource != nullptr)
+      {
+        //Create the geometry shader object, and store its ID
+        m_geometryShaderID = glCreateShader(GL_GEOMETRY_SHADER);
+        if (m_geometryShaderID == 0)
+        {
+          FatalError("Geometry shader failed to be created!");
+        }
+      }
     }
 
-    //Check if there is a geometry shader
-    if (_geometrySource != nullptr)
+    //the driver compiles and links on its threads, the statuses are checked by FinishBuild when the program is needed
+    if (_allowParallel && GetParallelCompile())
     {
-      //Create the geometry shader object, and store its ID
-      m_geometryShaderID = glCreateShader(GL_GEOMETRY_SHADER);
-      if (m_geometryShaderID == 0)
+      const std::pair<const char*, GLuint> stages[] = { { _computeSource, m_computeShaderID }, { _vertexSource, m_vertexShaderID },
+        { _geometrySource, m_geometryShaderID }, { _fragmentSource, m_fragmentShaderID } };
+      for (const auto& stage : stages)
       {
-        FatalError("Geometry shader failed to be created!");
+        if (stage.second != 0)
+        {
+          glShaderSource(stage.second, 1, &stage.first, nullptr);
+          glCompileShader(stage.second);
+        }
       }
+      SubmitLink();
+      m_buildPending = true;
+      m_pendingBinaryKey = binaryKey;
+      return true;
     }
 
     //Compile each shader
-    CompileShader(_vertexSource, "Vertex Shader", m_vertexShaderID);
-    if (_geometrySource != nullptr)
+    bool compiled = true;
+    if (_computeSource != nullptr)
+    {
+      compiled = CompileShader(_computeSource, "Compute Shader", m_computeShaderID, _error);
+    }
+    else
+    {
+      compiled = CompileShader(_vertexSource, "Vertex Shader", m_vertexShaderID, _error) &&
+        (_geometrySource == nullptr || CompileShader(_geometrySource, "Geometry Shader", m_geometryShaderID, _error)) &&
+        CompileShader(_fragmentSource, "Fragment Shader", m_fragmentShaderID, _error);
+    }
+    if (!compiled)
     {
-      CompileShader(_geometrySource, "Geometry Shader", m_geometryShaderID);
+      //Don't leak the program or the shaders
+      DeleteFailedBuild();
+      return false;
     }
-    CompileShader(_fragmentSource, "Fragment Shader", m_fragmentShaderID);
-    
-    LinkShaders();
+
+    if (!LinkShaders(_error))
+    {
+      return false;
+    }
+    if (binaryKey != AssetIds::NONE)
+    {
+      SaveBinary(binaryKey);
+    }
+    return true;
+  }
+
+  bool GLSLProgram::LoadBinary(AssetId _key)
+  {
+    //the cache is loose files, a missing one is the usual first run and isn't reported
+    std::ifstream file(GetBinaryPath(_key), std::ios::binary);
+    if (file.fail())
+    {
+      return false;
+    }
+    file.seekg(0, std::ios::end);
+    const std::streamoff fileSize = file.tellg();
+    file.seekg(0, std::ios::beg);
+    if (fileSize <= static_cast<std::streamoff>(sizeof(BinaryHeader)))
+    {
+      return false;
+    }
+    std::vector<char> data(static_cast<size_t>(fileSize));
+    file.read(data.data(), fileSize);
+    BinaryHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (file.fail() || header.magic != BINARY_MAGIC || header.key != _key)
+    {
+      return false;
+    }
+
+    m_programID = glCreateProgram();
+    glProgramBinary(m_programID, header.format, data.data() + sizeof(header), static_cast<GLsizei>(data.size() - sizeof(header)));
+    GLint isLinked = 0;
+    glGetProgramiv(m_programID, GL_LINK_STATUS, &isLinked);
+    if (isLinked == GL_FALSE)
+    {
+      //e.g. the driver was updated, the sources are compiled and the binary written again
+      RenderState::Get().DeleteProgram(m_programID);
+      m_programID = 0;
+      return false;
+    }
+    m_vertexShaderID = 0;
+    m_fragmentShaderID = 0;
+    m_geometryShaderID = 0;
+    m_computeShaderID = 0;
+    ReflectUniforms();
+    BindSharedBlocks();
+    return true;
+  }
+
+  void GLSLProgram::SaveBinary(AssetId _key) const
+  {
+    GLint binaryLength = 0;
+    glGetProgramiv(m_programID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    if (binaryLength <= 0)
+    {
+      return;
+    }
+    std::vector<char> data(sizeof(BinaryHeader) + binaryLength);
+    BinaryHeader header;
+    header.magic = BINARY_MAGIC;
+    header.key = _key;
+    GLenum format = 0;
+    glGetProgramBinary(m_programID, binaryLength, nullptr, &format, data.data() + sizeof(header));
+    header.format = format;
+    std::memcpy(data.data(), &header, sizeof(header));
+
+    std::ofstream file(GetBinaryPath(_key), std::ios::binary);
+    if (file.fail())
+    {
+      perror(GetBinaryPath(_key).c_str());
+      return;
+    }
+    file.write(data.data(), data.size());
+  }
+
+  bool GLSLProgram::LinkShaders(std::string& _error)
+  {
+    SubmitLink();
+    return CheckLink(_error);
   }
 
-  void GLSLProgram::LinkShaders()
+  void GLSLProgram::DeleteFailedBuild()
   {
-    //Attach our shaders to our program
-    glAttachShader(m_programID, m_vertexShaderID);
-    glAttachShader(m_programID, m_fragmentShaderID);
+    RenderState::Get().DeleteProgram(m_programID);
+    m_programID = 0;
+    glDeleteShader(m_vertexShaderID);
+    glDeleteShader(m_fragmentShaderID);
+    glDeleteShader(m_geometryShaderID);
+    glDeleteShader(m_computeShaderID);
+  }
+
+  void GLSLProgram::SubmitLink()
+  {
+    //Attach our shaders to our program, a compute program has no other stages
+    if (m_vertexShaderID != 0)
+    {
+      glAttachShader(m_programID, m_vertexShaderID);
+    }
+    if (m_fragmentShaderID != 0)
+    {
+      glAttachShader(m_programID, m_fragmentShaderID);
+    }
     if (m_geometryShaderID != 0)
     {
       glAttachShader(m_programID, m_geometryShaderID);
     }
+    if (m_computeShaderID != 0)
+    {
+      glAttachShader(m_programID, m_computeShaderID);
+    }
+    //the captured outputs have to be known before linking
+    if (!m_feedbackVaryings.empty())
+    {
+      std::vector<const char*> varyings;
+      for (auto& varying : m_feedbackVaryings)
+      {
+        varyings.push_back(varying.c_str());
+      }
+      glTransformFeedbackVaryings(m_programID, static_cast<GLsizei>(varyings.size()), varyings.data(), m_feedbackBufferMode);
+    }
+    //the binary is only kept if asked for before the link
+    if (!GetBinaryCacheDirectory().empty())
+    {
+      glProgramParameteri(m_programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     //link our program
     glLinkProgram(m_programID);
+  }
 
+  bool GLSLProgram::CheckLink(std::string& _error)
+  {
     //note the different functions here: glGetProgram* instead of glGetShader*
     GLint isLinked = 0;
     glGetProgramiv(m_programID, GL_LINK_STATUS, (int *)&isLinked);
@@ -107,30 +665,100 @@ namespace GameEngine
       std::vector<char> errorLog(maxLength);
       glGetProgramInfoLog(m_programID, maxLength, &maxLength, &errorLog[0]);
 
-      //we don't need this program anymore
-      glDeleteProgram(m_programID);
+      //we don't need this program anymore, and don't leak shaders either
+      DeleteFailedBuild();
 
-      //dont leak shaders either
-      //Don't leak shaders either.
-      glDeleteShader(m_vertexShaderID);
-      glDeleteShader(m_fragmentShaderID);
-      glDeleteShader(m_geometryShaderID);
-
-      //print the error log and quit
+      //print the error log, the caller decides whether to quit
       std::printf("%s\n", &errorLog[0]);
-      FatalError("Shaders failed to link!");
+      _error = "Shaders failed to link!";
+      return false;
     }
     //Always detach shaders after a successful link.
     glDetachShader(m_programID, m_vertexShaderID);
     glDetachShader(m_programID, m_fragmentShaderID);
     glDetachShader(m_programID, m_geometryShaderID);
+    glDetachShader(m_programID, m_computeShaderID);
     glDeleteShader(m_vertexShaderID);
     glDeleteShader(m_fragmentShaderID);
     glDeleteShader(m_geometryShaderID);
+    glDeleteShader(m_computeShaderID);
+    ReflectUniforms();
+    BindSharedBlocks();
+    return true;
+  }
+
+  void GLSLProgram::BindSharedBlocks()
+  {
+    static const std::pair<const char*, GLuint> SHARED_BLOCKS[] = {
+      { "FrameUniforms", FRAME_UNIFORMS_BINDING },
+      { "LightBlock", LIGHT_BLOCK_BINDING },
+      { "CascadeBlock", CASCADE_BLOCK_BINDING },
+      { "BonePalette", AnimationSystem::BONE_PALETTE_BINDING } };
+    for (const auto& block : SHARED_BLOCKS)
+    {
+      const GLuint index = glGetUniformBlockIndex(m_programID, block.first);
+      if (index != GL_INVALID_INDEX)
+      {
+        glUniformBlockBinding(m_programID, index, block.second);
+      }
+    }
+  }
+
+  void GLSLProgram::ReflectUniforms()
+  {
+    //the slots already handed out keep their index, a relink may move their uniforms or drop them
+    for (auto& uniform : m_uniforms)
+    {
+      uniform.location = glGetUniformLocation(m_programID, uniform.name.c_str());
+    }
+    GLint numUniforms = 0;
+    glGetProgramiv(m_programID, GL_ACTIVE_UNIFORMS, &numUniforms);
+    for (GLint i = 0; i < numUniforms; i++)
+    {
+      GLchar name[256];
+      GLsizei length = 0;
+      GLint size = 0;
+      GLenum type = 0;
+      glGetActiveUniform(m_programID, i, sizeof(name), &length, &size, &type, name);
+      const std::string uniformName(name, length);
+      const GLint location = glGetUniformLocation(m_programID, name);
+      //the uniforms of the blocks have no location, they're in buffers
+      if (location < 0)
+      {
+        continue;
+      }
+      AddUniform(uniformName, location);
+      //an array of plain values is reported once as name[0], every element gets its own slot (and the array its name alone)
+      if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+      {
+        const std::string baseName = uniformName.substr(0, uniformName.size() - 3);
+        AddUniform(baseName, location);
+        for (GLint element = 1; element < size; element++)
+        {
+          const std::string elementName = baseName + "[" + std::to_string(element) + "]";
+          AddUniform(elementName, glGetUniformLocation(m_programID, elementName.c_str()));
+        }
+      }
+    }
+  }
+
+  GLuint GLSLProgram::AddUniform(const std::string& _name, GLint _location)
+  {
+    auto it = m_uniformSlots.find(_name);
+    if (it != m_uniformSlots.end())
+    {
+      m_uniforms[it->second].location = _location;
+      return it->second;
+    }
+    const GLuint slot = static_cast<GLuint>(m_uniforms.size());
+    m_uniforms.push_back(Uniform{ _name, _location });
+    m_uniformSlots.emplace(_name, slot);
+    return slot;
   }
 
   GLuint GLSLProgram::GetUniformBlockIndex(const std::string& _uniformBlockName)
   {
+    FinishBuild();
     GLuint index = glGetUniformBlockIndex(m_programID, _uniformBlockName.c_str());
 
     //error check
@@ -156,9 +784,33 @@ namespace GameEngine
     }
   }
 
+  void GLSLProgram::SetDefines(const std::vector<std::string>& _defines)
+  {
+    m_defines = _defines;
+  }
+
+  void GLSLProgram::SetTransformFeedbackVaryings(const std::vector<std::string>& _varyings, GLenum _bufferMode /* = GL_INTERLEAVED_ATTRIBS */)
+  {
+    m_feedbackVaryings = _varyings;
+    m_feedbackBufferMode = _bufferMode;
+  }
+
   void GLSLProgram::BlockUniformBinding(GLuint _uniformBlockIndex, GLuint _uniformBlockBinding)
   {
     glUniformBlockBinding(m_programID, _uniformBlockIndex, _uniformBlockBinding);
+    //by name, a reload may number the blocks differently
+    GLchar name[256];
+    GLsizei length = 0;
+    glGetActiveUniformBlockName(m_programID, _uniformBlockIndex, sizeof(name), &length, name);
+    const std::string blockName(name, length);
+    auto it = std::find_if(m_blockBindings.begin(), m_blockBindings.end(),
+      [&blockName](const std::pair<std::string, GLuint>& _binding) { return _binding.first == blockName; });
+    if (it != m_blockBindings.end())
+    {
+      it->second = _uniformBlockBinding;
+      return;
+    }
+    m_blockBindings.emplace_back(blockName, _uniformBlockBinding);
   }
 
   void GLSLProgram::GetActiveUniformsIndexValues(GLsizei _numUniforms, GLuint * _uniformIndices, GLenum _pname, GLint * _attribute)
@@ -208,20 +860,33 @@ namespace GameEngine
   //enable the shader
   void GLSLProgram::Use()
   {
-    glUseProgram(m_programID);
+    FinishBuild();
+    RenderState::Get().UseProgram(m_programID);
   }
 
   //disable the shader
   void GLSLProgram::UnUse()
   {
-    glUseProgram(0);
+    RenderState::Get().UseProgram(0);
   }
 
   void GLSLProgram::Dispose()
   {
+    //a program disposed before it was needed still has its shaders
+    if (m_buildPending)
+    {
+      m_buildPending = false;
+      glDeleteShader(m_vertexShaderID);
+      glDeleteShader(m_fragmentShaderID);
+      glDeleteShader(m_geometryShaderID);
+      glDeleteShader(m_computeShaderID);
+    }
     //deletes the program ID if there is one (not 0)
-    if (m_programID) glDeleteProgram(m_programID);
+    if (m_programID) RenderState::Get().DeleteProgram(m_programID);
     m_programID = 0;
+    std::vector<GLSLProgram*>& programs = GetReloadablePrograms();
+    programs.erase(std::remove(programs.begin(), programs.end(), this), programs.end());
+    m_filePaths.clear();
   }
 
   void GLSLProgram::RegisterAttribute(const std::string& _attrib)
@@ -232,8 +897,7 @@ namespace GameEngine
 
   void GLSLProgram::RegisterUniform(const std::string& _uniform)
   {
-    //m_unifLocationList.insert(std::make_pair(_uniform, GetUniformLocation(_uniform)));
-    m_unifLocationList[_uniform] = GetUniformLoc(_uniform);
+    GetUniform(_uniform);
   }
 
   AttribLocation GLSLProgram::GetAttribLocation(const std::string& _attrib)
@@ -255,19 +919,23 @@ namespace GameEngine
 
   UniformLocation GLSLProgram::GetUniformLocation(const std::string& _uniform)
   {
-    auto it = m_unifLocationList.find(_uniform);
-    if (it != m_unifLocationList.end())
-    {
-      // Found the location
-      return it->second;
-    }
-    else
+    return static_cast<UniformLocation>(m_uniforms[GetUniform(_uniform).slot].location);
+  }
+
+  UniformHandle GLSLProgram::GetUniform(const std::string& _uniform)
+  {
+    FinishBuild();
+    UniformHandle handle;
+    auto it = m_uniformSlots.find(_uniform);
+    if (it != m_uniformSlots.end())
     {
-      // Didn't find the location
-      // Try to see if it just wasn't registered
-      RegisterUniform(_uniform);
-      return m_unifLocationList.at(_uniform);
+      // Found it in the reflected table
+      handle.slot = it->second;
+      return handle;
     }
+    // Not an active uniform by this name (e.g. a struct spelled differently), GL may still know it
+    handle.slot = AddUniform(_uniform, static_cast<GLint>(GetUniformLoc(_uniform)));
+    return handle;
   }
 
   void GLSLProgram::UploadValue(const std::string & _uniformName, const glm::mat4 & _matrix)
@@ -302,33 +970,95 @@ namespace GameEngine
 
   void GLSLProgram::UploadValue(const std::string & _uniformName, const int & _slot, const GLTexture& _texture)
   {
-    //activate the texture
-    glActiveTexture(GL_TEXTURE0 + _slot);
-    //Bind it
-    glBindTexture(GL_TEXTURE_2D, _texture.id);
+    //activate the texture unit and bind it
+    RenderState::Get().BindTexture(_slot, GL_TEXTURE_2D, _texture.id, _texture.sampler);
     // Now set the sampler to the correct texture unit
     glUniform1i(GetUniformLocation(_uniformName), _slot);
   }
 
   void GLSLProgram::UploadValue(const std::string & _uniformName, const int & _slot, const GLCubemap & _cubemap)
   {
-    //activate the texture
-    glActiveTexture(GL_TEXTURE0 + _slot);
-    //Bind it
-    glBindTexture(GL_TEXTURE_CUBE_MAP, _cubemap.id);
+    //activate the texture unit and bind it
+    RenderState::Get().BindTexture(_slot, GL_TEXTURE_CUBE_MAP, _cubemap.id, _cubemap.sampler);
     // Now set the sampler to the correct texture unit
     glUniform1i(GetUniformLocation(_uniformName), _slot);
   }
 
+  void GLSLProgram::UploadValue(UniformHandle _uniform, const glm::mat4& _matrix)
+  {
+    glUniformMatrix4fv(m_uniforms[_uniform.slot].location, 1, GL_FALSE, glm::value_ptr(_matrix));
+  }
+
+  void GLSLProgram::UploadValue(UniformHandle _uniform, float _float)
+  {
+    glUniform1f(m_uniforms[_uniform.slot].location, _float);
+  }
+
+  void GLSLProgram::UploadValue(UniformHandle _uniform, int _int)
+  {
+    glUniform1i(m_uniforms[_uniform.slot].location, _int);
+  }
+
+  void GLSLProgram::UploadValue(UniformHandle _uniform, const glm::vec2& _vec2)
+  {
+    glUniform2fv(m_uniforms[_uniform.slot].location, 1, glm::value_ptr(_vec2));
+  }
+
+  void GLSLProgram::UploadValue(UniformHandle _uniform, const glm::vec3& _vec3)
+  {
+    glUniform3fv(m_uniforms[_uniform.slot].location, 1, glm::value_ptr(_vec3));
+  }
+
+  void GLSLProgram::UploadValue(UniformHandle _uniform, const glm::vec4& _vec4)
+  {
+    glUniform4fv(m_uniforms[_uniform.slot].location, 1, glm::value_ptr(_vec4));
+  }
+
+  void GLSLProgram::UploadValue(UniformHandle _uniform, int _slot, const GLTexture& _texture)
+  {
+    RenderState::Get().BindTexture(_slot, GL_TEXTURE_2D, _texture.id, _texture.sampler);
+    glUniform1i(m_uniforms[_uniform.slot].location, _slot);
+  }
+
+  void GLSLProgram::UploadValue(UniformHandle _uniform, int _slot, const GLCubemap& _cubemap)
+  {
+    RenderState::Get().BindTexture(_slot, GL_TEXTURE_CUBE_MAP, _cubemap.id, _cubemap.sampler);
+    glUniform1i(m_uniforms[_uniform.slot].location, _slot);
+  }
+
+  void GLSLProgram::UploadValues(UniformHandle _uniform, const glm::mat4* _matrices, GLsizei _count)
+  {
+    glUniformMatrix4fv(m_uniforms[_uniform.slot].location, _count, GL_FALSE, glm::value_ptr(_matrices[0]));
+  }
+
+  void GLSLProgram::UploadValues(UniformHandle _uniform, const glm::vec4* _vec4s, GLsizei _count)
+  {
+    glUniform4fv(m_uniforms[_uniform.slot].location, _count, glm::value_ptr(_vec4s[0]));
+  }
+
+  void GLSLProgram::UploadValues(UniformHandle _uniform, const glm::vec3* _vec3s, GLsizei _count)
+  {
+    glUniform3fv(m_uniforms[_uniform.slot].location, _count, glm::value_ptr(_vec3s[0]));
+  }
+
+  void GLSLProgram::UploadValues(UniformHandle _uniform, const float* _floats, GLsizei _count)
+  {
+    glUniform1fv(m_uniforms[_uniform.slot].location, _count, _floats);
+  }
+
   //Compiles a single shader file
-  void GLSLProgram::CompileShader(const char* _source, const std::string& _name, GLuint _id)
+  bool GLSLProgram::CompileShader(const char* _source, const std::string& _name, GLuint _id, std::string& _error)
   {
     //tell opengl that we want to use fileContents as the contents of the shader file
     glShaderSource(_id, 1, &_source, nullptr);
 
     //compile the shader
     glCompileShader(_id);
+    return CheckCompileStatus(_name, _id, _error);
+  }
 
+  bool GLSLProgram::CheckCompileStatus(const std::string& _name, GLuint _id, std::string& _error)
+  {
     //check for errors
     GLint success = 0;
     glGetShaderiv(_id, GL_COMPILE_STATUS, &success);
@@ -342,18 +1072,18 @@ namespace GameEngine
       std::vector<char> errorLog(maxLength);
       glGetShaderInfoLog(_id, maxLength, &maxLength, &errorLog[0]);
 
-      //Provide the infolog in whatever manor you deem best.
-      //Exit with failure.
-      glDeleteShader(_id); //Don't leak the shader.
-
-      //Print error log and quit
+      //the shaders are deleted by BuildProgram, with the program
+      //Print error log, the caller decides whether to quit
       std::printf("%s\n", &(errorLog[0]));
-      FatalError("Shader " + _name + " failed to compile");
+      _error = "Shader " + _name + " failed to compile";
+      return false;
     }
+    return true;
   }
 
   AttribLocation GLSLProgram::GetAttribLoc(const std::string& _attributeName)
   {
+    FinishBuild();
     AttribLocation location = glGetAttribLocation(m_programID, _attributeName.c_str());
     //error check
     if (location == GL_INVALID_INDEX)
@@ -1,7 +1,9 @@
 #pragma once
+#include "AssetId.h"
 #include "GLTexture.h"
 
 #include <string>
+#include <vector>
 #include <GL/glew.h>
 #include <unordered_map>
 #include <glm\mat4x4.hpp>
@@ -13,6 +15,16 @@ namespace GameEngine
   using ProgramID = GLuint;
   using ShaderID = GLuint;
 
+  /** A uniform of one GLSLProgram, looked up by name once (see GLSLProgram::GetUniform). The uploads through it index the locations the
+  * program reflected when it was linked, no name is built or hashed per frame. It stays valid through the hot reloads of the program */
+  struct UniformHandle
+  {
+    enum : GLuint { INVALID = 0xFFFFFFFF };
+    GLuint slot{ INVALID }; ///< the index in the uniform table of the program
+
+    bool IsValid() const noexcept { return slot != INVALID; }
+  };
+
   /** This class handles the compilation, linking, and usage of a GLSL shader program. */
   class GLSLProgram
   {
@@ -30,6 +42,45 @@ namespace GameEngine
     */
     void CompileShadersFromSource(const char* _vertexSource, const char* _fragmentSource, const char* _geometrySource = nullptr);
 
+    /** Compiles a compute shader as the only stage of the program (needs OpenGL 4.3)
+    * \param[in] _csFilePath the path of the compute shader
+    */
+    void CompileComputeShader(const std::string& _csFilePath);
+
+    /** Compiling a compute shader from source
+    * \param[in] _computeSource the source code of the compute shader
+    */
+    void CompileComputeShaderFromSource(const char* _computeSource);
+
+    /** Compiles the files of the program again (see IOManager::EnableFileWatching), the program keeps its address and the uniforms
+    * set on it, only its ID changes. A shader which fails to compile is reported and the old program stays
+    * \return whether the program was rebuilt
+    */
+    bool Reload();
+
+    /** Keeps the linked programs in _directory (glGetProgramBinary) and loads them from there instead of compiling them, as long as their
+    * sources and the driver are the same. A binary the driver rejects (e.g. after an update) is compiled again and replaced.
+    * An empty _directory turns it off
+    * \return false without the support (OpenGL 4.1 or ARB_get_program_binary, and a binary format)
+    */
+    static bool EnableBinaryCache(const std::string& _directory);
+
+    /** Lets the driver compile and link on its own threads (KHR_parallel_shader_compile): the Compile functions only submit the program
+    * and return, so all the programs of a screen build at once. A program is finished, and a failed one reported, when it's first needed
+    * (Use, GetUniform, the uploads) or by FinishBuild. The hot reloads stay synchronous
+    * \return false without the extension, the programs are then built one after the other as before
+    */
+    static bool EnableParallelCompile(bool _enable);
+    /** Checks whether a submitted program is built, without waiting for it. Always true for one built synchronously */
+    bool IsReady() const;
+    /** Waits for a submitted program and checks it, like the synchronous compile does (a failed one is fatal) */
+    void FinishBuild();
+
+    /** Reloads the programs compiled from files while the file watch was on, which use any of the changed files (see ResourceManager::ReloadChangedAssets)
+    * \param[in] _changedFiles the files changed on the disk, from IOManager::PollChangedFiles
+    */
+    static void ReloadChangedFiles(const std::vector<std::string>& _changedFiles);
+
     /** Returns the index of the named uniform block specified by uniformBlockName associated with the shader program.
     * If uniformBlockName is not a valid uniform block of the shader program, GL_INVALID_INDEX is returned
     * \param[in] _uniformBlockName The name of the requested uniform block
@@ -61,9 +112,23 @@ namespace GameEngine
     */
     void BindBufferRange(GLenum _target, GLuint _index, GLuint _buffer, GLintptr _offset, GLsizeiptr _size);
 
+    /** Captures the named vertex (or geometry) shader outputs into GL_TRANSFORM_FEEDBACK_BUFFER bindings.
+    * Must be called before CompileShaders/CompileShadersFromSource, because the varyings are set right before linking
+    * \param[in] _varyings The names of the captured outputs, in the order they are written to the buffer
+    * \param[in] _bufferMode GL_INTERLEAVED_ATTRIBS (one buffer) or GL_SEPARATE_ATTRIBS (one buffer per varying)
+    */
+    void SetTransformFeedbackVaryings(const std::vector<std::string>& _varyings, GLenum _bufferMode = GL_INTERLEAVED_ATTRIBS);
+
+    /** Defines the macros (#define NAME 1) in every stage right after its #version line, so one source builds a program per set of
+    * features without the code of the others (see ShaderVariants). Must be called before the Compile functions, the reloads keep them
+    * \param[in] _defines The names of the macros
+    */
+    void SetDefines(const std::vector<std::string>& _defines);
+    const std::vector<std::string>& GetDefines() const noexcept { return m_defines; }
+
     /* Explicitly assigns uniformBlockIndex to uniformBlockBinding for the current shader program program.
-    * Use when a specific uniform block is used in many shader programs, so that it avoids having the block be assigned a different index for each program
-    * Must be called before calling LinkShaders
+    * Use when a specific uniform block is used in many shader programs, so that it avoids having the block be assigned a different index for each program.
+    * The shared blocks of UniformBlocks.h (and BonePalette) are bound when the program links, they don't need it
     * \param[in] _uniformBlockIndex The index that the uniform block will be assigned to
     * \param[in] _uniformBlockBinding The uniform block that will be explicitly bound to the uniformBlockIndex
     */
@@ -106,6 +171,8 @@ namespace GameEngine
 
     /** Dispose of the shader*/
     void Dispose();
+
+    ProgramID GetProgramID() const noexcept { return m_programID; }
     // Registers the location of an attribute in this shader (must be called after linking)
     void RegisterAttribute(const std::string& _attrib);
     // Registers the location of a uniform in this shader (must be called after linking)
@@ -114,6 +181,13 @@ namespace GameEngine
     AttribLocation GetAttribLocation(const std::string& _attrib);
     UniformLocation GetUniformLocation(const std::string& _uniform);
 
+    /** Gets the handle of a uniform, for the uploads on the per frame paths. Look it up once after compiling (a missing uniform is a fatal
+    * error, like the uploads by name), every member of a struct and element of an array has its own, e.g. lights[0].position. An array
+    * of plain values is also its first element by its name alone, see UploadValues
+    * \param[in] _uniform The name of the uniform, as the shader spells it
+    */
+    UniformHandle GetUniform(const std::string& _uniform);
+
     void UploadValue(const std::string& _uniformName, const glm::mat4& _matrix);
     void UploadValue(const std::string& _uniformName, const float& _float);
     void UploadValue(const std::string& _uniformName, const int& _int);
@@ -123,13 +197,55 @@ namespace GameEngine
     void UploadValue(const std::string& _uniformName, const int& _slot, const GLTexture& _texture);
     void UploadValue(const std::string& _uniformName, const int& _slot, const GLCubemap& _cubemap);
 
+    void UploadValue(UniformHandle _uniform, const glm::mat4& _matrix);
+    void UploadValue(UniformHandle _uniform, float _float);
+    void UploadValue(UniformHandle _uniform, int _int);
+    void UploadValue(UniformHandle _uniform, const glm::vec2& _vec2);
+    void UploadValue(UniformHandle _uniform, const glm::vec3& _vec3);
+    void UploadValue(UniformHandle _uniform, const glm::vec4& _vec4);
+    void UploadValue(UniformHandle _uniform, int _slot, const GLTexture& _texture);
+    void UploadValue(UniformHandle _uniform, int _slot, const GLCubemap& _cubemap);
+    /** Uploads _count values to an array of plain values in one call, from the element of the handle on */
+    void UploadValues(UniformHandle _uniform, const glm::mat4* _matrices, GLsizei _count);
+    void UploadValues(UniformHandle _uniform, const glm::vec4* _vec4s, GLsizei _count);
+    void UploadValues(UniformHandle _uniform, const glm::vec3* _vec3s, GLsizei _count);
+    void UploadValues(UniformHandle _uniform, const float* _floats, GLsizei _count);
+
   private:
     /// The number of attributes in a shader (the in values)
     //int m_numAttributes;
-    /// Compile a single shader program
-    void CompileShader(const char* _source, const std::string& _name, GLuint _id);
-    /** Links the shaders together */
-    void LinkShaders();
+    /// Compile a single shader program, false with the error in _error
+    bool CompileShader(const char* _source, const std::string& _name, GLuint _id, std::string& _error);
+    /** Checks the compile status of a shader, false with the error in _error */
+    bool CheckCompileStatus(const std::string& _name, GLuint _id, std::string& _error);
+    /** Attaches the shaders and starts the link, the driver may still be compiling them */
+    void SubmitLink();
+    /** Waits for the link and checks it, the shaders are deleted. False with the error in _error and no program left */
+    bool CheckLink(std::string& _error);
+    /** Links the shaders together, false with the error in _error */
+    bool LinkShaders(std::string& _error);
+    /** Deletes the program and its shaders after a failed build */
+    void DeleteFailedBuild();
+    /** Fills the uniform table with every active uniform of the linked program (each element of the arrays), the slots handed out
+    * keep their index and get their new locations */
+    void ReflectUniforms();
+    /** Binds the shared blocks the program declares (FrameUniforms, LightBlock, BonePalette) to their fixed binding points, so the
+    * buffers bound there once a frame serve every program without any per program setup */
+    void BindSharedBlocks();
+    /** Adds the uniform to the table, or sets its location if it's there, and returns its slot */
+    GLuint AddUniform(const std::string& _name, GLint _location);
+    /** Creates, compiles and links the program of the stages (the compute shader alone, or the others), false with the error in _error
+    * and nothing left of the program */
+    bool BuildProgram(const char* _vertexSource, const char* _fragmentSource, const char* _geometrySource, const char* _computeSource,
+      std::string& _error, bool _allowParallel = true);
+    /** Creates the program from the cached binary of _key, false (and no program) if there's none or the driver rejects it */
+    bool LoadBinary(AssetId _key);
+    /** Writes the binary of the linked program to the cache */
+    void SaveBinary(AssetId _key) const;
+    /** Reads the files of the stages, null terminated for GL */
+    static bool ReadSources(const std::vector<std::string>& _filePaths, std::vector<std::vector<unsigned char>>& _sources);
+    /** Remembers the files of the program and watches them, if the file watch is on */
+    void WatchFiles(const std::vector<std::string>& _filePaths);
     /** Gets the location of a specific attribute in the shader program
     * \param[in] _attributeName The name of the searched attribute
     * \return the GLint location of the specified attribute
@@ -148,9 +264,34 @@ namespace GameEngine
     ShaderID m_vertexShaderID{ 0 };
     ShaderID m_fragmentShaderID{ 0 };
     ShaderID m_geometryShaderID{ 0 };
+    ShaderID m_computeShaderID{ 0 };
+    // submitted to the driver's compiler threads and not checked yet (see EnableParallelCompile)
+    bool m_buildPending{ false };
+    // the binary cache key the pending program is saved under once it's built
+    AssetId m_pendingBinaryKey{ AssetIds::NONE };
+
+    // the transform feedback outputs applied in LinkShaders
+    std::vector<std::string> m_feedbackVaryings;
+    // the macros BuildProgram defines in the sources
+    std::vector<std::string> m_defines;
+    GLenum m_feedbackBufferMode{ GL_INTERLEAVED_ATTRIBS };
+
+    // the files the program was compiled from, while the file watch is on (the vertex, fragment and geometry shaders, or the compute shader)
+    std::vector<std::string> m_filePaths;
+    // the uniform block bindings set with BlockUniformBinding, by block name, applied again after a reload
+    std::vector<std::pair<std::string, GLuint>> m_blockBindings;
+
+    // a uniform of the table, -1 for one the program doesn't have (anymore), which GL ignores the uploads to
+    struct Uniform
+    {
+      std::string name;
+      GLint location{ -1 };
+    };
 
     // a map of the locations in the shader for ease of access
     std::unordered_map<std::string, AttribLocation> m_attribList;
-    std::unordered_map<std::string, UniformLocation> m_unifLocationList;
+    // the uniforms the handles index, reflected at link time, and their slots by name for the lookups
+    std::vector<Uniform> m_uniforms;
+    std::unordered_map<std::string, GLuint> m_uniformSlots;
   };
 }
\ No newline at end of file
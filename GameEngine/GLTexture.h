@@ -1,22 +1,25 @@
 #pragma once
 #include <GL/glew.h>
-#include <string>
 #include <array>
+#include "AssetId.h"
+#include "RenderState.h"
 
 namespace GameEngine
 {
+  /** \brief Plain data, copies don't allocate: the path and type are interned (see AssetIds::GetName for the strings) */
   struct GLTexture
   {
-
-    std::string filePath{ "" };
-    std::string type{ "" };
+    AssetId asset{ AssetIds::NONE }; ///< the interned file path
+    AssetId type{ AssetIds::NONE };  ///< the interned material type, e.g. texture_diffuse (see MaterialBindings)
     GLuint id{ 0 };
     int width{ 500 };
     int height{ 500 };
+    int layer{ -1 }; ///< layer inside a GL_TEXTURE_2D_ARRAY (id is then the array), -1 for a plain 2D texture
+    GLuint sampler{ 0 }; ///< the shared sampler it's bound with (see SamplerCache), 0 for the parameters of the texture itself
 
     void Dispose()
     {
-      glDeleteTextures(1, &id);
+      RenderState::Get().DeleteTextures(1, &id);
       id = 0;
     }
   };
@@ -25,10 +28,11 @@ namespace GameEngine
   {
     std::array<GLTexture, 6> textures;
     GLuint id;
+    GLuint sampler{ 0 };
 
     void Dispose()
     {
-      glDeleteTextures(1, &id);
+      RenderState::Get().DeleteTextures(1, &id);
     }
   };
 }
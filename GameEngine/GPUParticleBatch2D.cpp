@@ -0,0 +1,263 @@
+#include "GPUParticleBatch2D.h"
+#include "FrameStats.h"
+#include "RenderState.h"
+#include <algorithm>
+
+namespace GameEngine
+{
+  const char* GPU_PARTICLE_UPDATE_VERT_SRC = R"(#version 330 core
+layout (location = 0) in vec2 inPosition;
+layout (location = 1) in vec2 inVelocity;
+layout (location = 2) in uint inColor;
+layout (location = 3) in vec2 inWidthLife;
+
+//captured with transform feedback in the same layout as GPUParticle
+out vec2 outPosition;
+out vec2 outVelocity;
+flat out uint outColor;
+out vec2 outWidthLife;
+
+uniform float deltaTime;
+uniform float decayRate;
+uniform vec2 acceleration;
+
+void main()
+{
+    outPosition = inPosition;
+    outVelocity = inVelocity;
+    outColor = inColor;
+    outWidthLife = inWidthLife;
+    //dead particles are passed through untouched
+    if (inWidthLife.y > 0.0)
+    {
+        outVelocity += acceleration * deltaTime;
+        outPosition += outVelocity * deltaTime;
+        outWidthLife.y -= decayRate * deltaTime;
+    }
+})";
+
+  //never runs, the simulation pass is drawn with GL_RASTERIZER_DISCARD
+  const char* GPU_PARTICLE_UPDATE_FRAG_SRC = R"(#version 330 core
+out vec4 color;
+void main()
+{
+    color = vec4(0.0);
+})";
+
+  const char* GPU_PARTICLE_RENDER_VERT_SRC = R"(#version 330 core
+//per-instance data, one record for every particle
+layout (location = 0) in vec2 position;
+layout (location = 2) in uint color;
+layout (location = 3) in vec2 widthLife;
+
+out VS_OUT
+{
+	vec4 color;
+	vec2 uv;
+} vs_out;
+
+uniform mat4 projection;
+
+void main()
+{
+    //corners of the triangle strip: (0,0) (1,0) (0,1) (1,1)
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    //dead particles collapse to a zero area quad
+    float width = widthLife.y > 0.0 ? widthLife.x : 0.0;
+    vec2 vertexPosition = position + corner * width;
+
+    gl_Position = vec4((projection * vec4(vertexPosition, 0.0, 1.0)).xy, 0.0, 1.0);
+
+    vs_out.color = vec4(float(color & 0xFFu), float((color >> 8) & 0xFFu), float((color >> 16) & 0xFFu), float(color >> 24)) / 255.0;
+    //pass the uv with the v/y inverted
+    vs_out.uv = vec2(corner.x, 1.0 - corner.y);
+})";
+
+  const char* GPU_PARTICLE_RENDER_FRAG_SRC = R"(#version 330 core
+out vec4 color;
+
+in VS_OUT
+{
+	vec4 color;
+	vec2 uv;
+} fs_in;
+
+uniform sampler2D diffuseTexture;
+
+void main()
+{
+    color = fs_in.color * texture(diffuseTexture, fs_in.uv);
+})";
+
+  GPUParticleBatch2D::GPUParticleBatch2D()
+  {
+  }
+
+  GPUParticleBatch2D::~GPUParticleBatch2D()
+  {
+  }
+
+  void GPUParticleBatch2D::Init(int _maxParticles, float _decayRate, const GLTexture& _texture, const glm::vec2& _acceleration /* = glm::vec2(0.0f) */)
+  {
+    m_maxParticles = _maxParticles;
+    m_decayRate = _decayRate;
+    m_texture = _texture;
+    m_acceleration = _acceleration;
+    m_source = 0;
+    m_nextSlot = 0;
+
+    m_updateProgram.SetTransformFeedbackVaryings({ "outPosition", "outVelocity", "outColor", "outWidthLife" });
+    m_updateProgram.CompileShadersFromSource(GPU_PARTICLE_UPDATE_VERT_SRC, GPU_PARTICLE_UPDATE_FRAG_SRC);
+    m_renderProgram.CompileShadersFromSource(GPU_PARTICLE_RENDER_VERT_SRC, GPU_PARTICLE_RENDER_FRAG_SRC);
+
+    //every particle starts dead (life 0)
+    std::vector<GPUParticle> particles(m_maxParticles);
+    glGenBuffers(2, m_buffers);
+    glGenVertexArrays(2, m_updateVaos);
+    glGenVertexArrays(2, m_renderVaos);
+    for (int i = 0; i < 2; i++)
+    {
+      glBindBuffer(GL_ARRAY_BUFFER, m_buffers[i]);
+      FrameStats::Get().Add(STAT_BYTES_UPLOADED, m_maxParticles * sizeof(GPUParticle));
+      glBufferData(GL_ARRAY_BUFFER, m_maxParticles * sizeof(GPUParticle), particles.data(), GL_DYNAMIC_COPY);
+
+      RenderState::Get().BindVertexArray(m_updateVaos[i]);
+      SetUpdateAttributes(m_buffers[i]);
+      RenderState::Get().BindVertexArray(m_renderVaos[i]);
+      SetRenderAttributes(m_buffers[i]);
+    }
+    RenderState::Get().BindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  void GPUParticleBatch2D::Dispose()
+  {
+    if (m_buffers[0] != 0)
+    {
+      RenderState::Get().DeleteVertexArrays(2, m_renderVaos);
+      RenderState::Get().DeleteVertexArrays(2, m_updateVaos);
+      glDeleteBuffers(2, m_buffers);
+      for (int i = 0; i < 2; i++)
+      {
+        m_renderVaos[i] = m_updateVaos[i] = m_buffers[i] = 0;
+      }
+    }
+    m_updateProgram.Dispose();
+    m_renderProgram.Dispose();
+    m_pending.clear();
+  }
+
+  void GPUParticleBatch2D::AddParticle(const glm::vec2& _position, const glm::vec2& _velocity, const ColorRGBA8& _color, float _width)
+  {
+    GPUParticle particle;
+    particle.m_position = _position;
+    particle.m_velocity = _velocity;
+    particle.m_color = _color;
+    particle.m_width = _width;
+    particle.m_life = 1.0f;
+    m_pending.push_back(particle);
+  }
+
+  void GPUParticleBatch2D::Update(float _deltaTime)
+  {
+    UploadPending();
+
+    const int destination = 1 - m_source;
+
+    m_updateProgram.Use();
+    m_updateProgram.UploadValue("deltaTime", _deltaTime);
+    m_updateProgram.UploadValue("decayRate", m_decayRate);
+    m_updateProgram.UploadValue("acceleration", m_acceleration);
+
+    //one point per particle from the source buffer, captured into the destination buffer
+    glEnable(GL_RASTERIZER_DISCARD);
+    RenderState::Get().BindVertexArray(m_updateVaos[m_source]);
+    //plain buffer binding rather than transform feedback objects, which need GL 4.0
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_buffers[destination]);
+    glBeginTransformFeedback(GL_POINTS);
+    FrameStats::Get().Add(STAT_DRAW_CALLS);
+    glDrawArrays(GL_POINTS, 0, m_maxParticles);
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    RenderState::Get().BindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    m_updateProgram.UnUse();
+
+    m_source = destination;
+  }
+
+  void GPUParticleBatch2D::Draw(const glm::mat4& _projection)
+  {
+    m_renderProgram.Use();
+    m_renderProgram.UploadValue("projection", _projection);
+    m_renderProgram.UploadValue("diffuseTexture", 0);
+
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, m_texture.id, m_texture.sampler);
+    RenderState::Get().BindVertexArray(m_renderVaos[m_source]);
+    //4 vertices per instance, expanded to a quad in the vertex shader
+    FrameStats::Get().Add(STAT_DRAW_CALLS);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, m_maxParticles);
+    RenderState::Get().BindVertexArray(0);
+
+    m_renderProgram.UnUse();
+  }
+
+  void GPUParticleBatch2D::UploadPending()
+  {
+    if (m_pending.empty() || m_maxParticles == 0)
+    {
+      return;
+    }
+    //more particles than slots in one frame: only the newest ones survive anyway
+    size_t first = 0;
+    if (m_pending.size() > static_cast<size_t>(m_maxParticles))
+    {
+      first = m_pending.size() - m_maxParticles;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffers[m_source]);
+    //the slots are consecutive, so the particles go up in at most two ranges (before and after the ring wraps)
+    while (first < m_pending.size())
+    {
+      const size_t count = std::min(m_pending.size() - first, static_cast<size_t>(m_maxParticles - m_nextSlot));
+      FrameStats::Get().Add(STAT_BYTES_UPLOADED, count * sizeof(GPUParticle));
+      glBufferSubData(GL_ARRAY_BUFFER, m_nextSlot * sizeof(GPUParticle), count * sizeof(GPUParticle), &m_pending[first]);
+      first += count;
+      m_nextSlot = (m_nextSlot + static_cast<int>(count)) % m_maxParticles;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_pending.clear();
+  }
+
+  void GPUParticleBatch2D::SetUpdateAttributes(GLuint _buffer)
+  {
+    glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+    for (GLuint i = 0; i < 4; i++)
+    {
+      glEnableVertexAttribArray(i);
+    }
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(GPUParticle), (void*)offsetof(GPUParticle, m_position));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(GPUParticle), (void*)offsetof(GPUParticle, m_velocity));
+    //the color is passed through as one packed integer, transform feedback can't write normalized bytes
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(GPUParticle), (void*)offsetof(GPUParticle, m_color));
+    //width and life are adjacent, so they are read as one vec2
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(GPUParticle), (void*)offsetof(GPUParticle, m_width));
+  }
+
+  void GPUParticleBatch2D::SetRenderAttributes(GLuint _buffer)
+  {
+    glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+    const GLuint attributes[] = { 0, 2, 3 };
+    for (GLuint attribute : attributes)
+    {
+      glEnableVertexAttribArray(attribute);
+      //advance the attributes once per instance rather than per vertex
+      glVertexAttribDivisor(attribute, 1);
+    }
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(GPUParticle), (void*)offsetof(GPUParticle, m_position));
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(GPUParticle), (void*)offsetof(GPUParticle, m_color));
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(GPUParticle), (void*)offsetof(GPUParticle, m_width));
+  }
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include <vector>
+
+#include "GLSLProgram.h"
+#include "GLTexture.h"
+#include "Vertex.h"
+
+namespace GameEngine
+{
+  // The particle record as it is stored in the GPU buffers (matches the transform feedback outputs)
+  struct GPUParticle
+  {
+    glm::vec2 m_position{ 0.0f };
+    glm::vec2 m_velocity{ 0.0f };
+    ColorRGBA8 m_color;
+    float m_width{ 0.0f };
+    float m_life{ 0.0f };  ///< the particle is active while its life is above 0
+  };
+  static_assert(sizeof(GPUParticle) == 28, "GPUParticle has to match the interleaved transform feedback outputs");
+
+  /** \brief Particle batch which lives entirely in GPU buffers. Every Update() runs the simulation
+   *  with transform feedback from one buffer into the other, and Draw() renders straight from the result,
+   *  so the CPU only touches the particles when they are emitted.
+   *  The buffers are a ring: when all the slots are taken the oldest particle gets replaced */
+  class GPUParticleBatch2D
+  {
+  public:
+    GPUParticleBatch2D();
+    ~GPUParticleBatch2D();
+
+    /** \brief Creates the buffers and compiles the shaders
+     *  \param _acceleration - constant acceleration applied to every particle (e.g. gravity) */
+    void Init(int _maxParticles, float _decayRate, const GLTexture& _texture, const glm::vec2& _acceleration = glm::vec2(0.0f));
+    // Deletes the buffers and shaders
+    void Dispose();
+
+    // Queues a particle, it is uploaded with the next Update()
+    void AddParticle(const glm::vec2& _position, const glm::vec2& _velocity, const ColorRGBA8& _color, float _width);
+
+    // Uploads the queued particles and simulates all of them on the GPU
+    void Update(float _deltaTime);
+
+    // Draws all the active particles with the given projection matrix (uses its own shader, texture unit 0)
+    void Draw(const glm::mat4& _projection);
+
+    int GetMaxParticles() const { return m_maxParticles; }
+
+  private:
+    // Writes the queued particles into the ring slots of the current source buffer
+    void UploadPending();
+    // Points the simulation attributes at _buffer
+    void SetUpdateAttributes(GLuint _buffer);
+    // Points the instanced render attributes at _buffer
+    void SetRenderAttributes(GLuint _buffer);
+
+    GLSLProgram m_updateProgram;
+    GLSLProgram m_renderProgram;
+
+    GLuint m_buffers[2]{};       ///< ping-pong particle buffers
+    GLuint m_updateVaos[2]{};    ///< reads buffer i as per vertex input for the simulation
+    GLuint m_renderVaos[2]{};    ///< reads buffer i as per instance input for the rendering
+    int m_source{ 0 };           ///< the buffer holding the latest state
+
+    std::vector<GPUParticle> m_pending; ///< particles added since the last Update()
+    int m_nextSlot{ 0 };                ///< ring slot the next emitted particle goes to
+
+    int m_maxParticles{ 0 };
+    float m_decayRate{ 0.1f };
+    glm::vec2 m_acceleration{ 0.0f };
+    GLTexture m_texture;
+  };
+}
+
@@ -1,12 +1,34 @@
 #include <GL/glew.h> // Include BEFORE GUI.h
+#include "FrameStats.h"
 
 #include "GUI.h"
+#include "RenderState.h"
 
 #include <SDL\SDL_timer.h>
 #include <utf8/utf8.h>
 
 namespace GameEngine
 {
+  namespace
+  {
+    const char* LAYER_VERT_SRC = R"(#version 130
+void main()
+{
+    //the screen as a strip of two triangles
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+})";
+
+    const char* LAYER_FRAG_SRC = R"(#version 130
+out vec4 color;
+uniform sampler2D layer;
+void main()
+{
+    //the layer is as big as the screen, texel for pixel
+    color = texelFetch(layer, ivec2(gl_FragCoord.xy), 0);
+})";
+  }
+
   CEGUI::OpenGL3Renderer* GUI::m_renderer = nullptr;
 
   void GUI::Init(const std::string& _resourceDirectory)
@@ -44,6 +66,15 @@ namespace GameEngine
     CEGUI::WindowManager::getSingleton().destroyWindow(m_root);
     m_context = nullptr;
     m_root = nullptr;
+    m_layer.Destroy();
+    m_layerProgram.Dispose();
+    if (m_layerVao)
+    {
+      RenderState::Get().DeleteVertexArrays(1, &m_layerVao);
+      m_layerVao = 0;
+    }
+    m_layerSize = glm::ivec2(0);
+    m_layerDirty = true;
 				m_freed = true;
   }
 
@@ -51,20 +82,83 @@ namespace GameEngine
   {
     //Render the GUI
     glDisable(GL_DEPTH_TEST);
+    if (!m_useLayer)
+    {
+      RenderContext();
+      return;
+    }
+    //CEGUI marks its context dirty whenever a window is invalidated (hover, text, animations of the time pulse)
+    const CEGUI::Sizef& displaySize = m_renderer->getDisplaySize();
+    const glm::ivec2 size(static_cast<int>(displaySize.d_width), static_cast<int>(displaySize.d_height));
+    if (m_layerDirty || m_context->isDirty() || size != m_layerSize)
+    {
+      //the screen may draw into a framebuffer of its own
+      GLint previousFramebuffer = 0;
+      glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+      if (size != m_layerSize)
+      {
+        CreateLayer(size);
+      }
+      m_layer.Bind(GL_FRAMEBUFFER, size.x, size.y);
+      //without glClear, the clear color belongs to the screen
+      const GLfloat transparent[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+      glClearBufferfv(GL_COLOR, 0, transparent);
+      RenderContext();
+      glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+      m_layerDirty = false;
+    }
+    CompositeLayer();
+  }
+
+  void GUI::RenderContext()
+  {
     m_renderer->beginRendering();
     m_context->draw();
     m_renderer->endRendering();
-    // Clean up after CEGUI
-    glBindVertexArray(0);
+    // Clean up after CEGUI, it doesn't bind through RenderState
+    RenderState::Get().Invalidate();
+    RenderState::Get().BindVertexArray(0);
     glDisable(GL_SCISSOR_TEST);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
     glDisableClientState(GL_VERTEX_ARRAY);
     glDisableClientState(GL_COLOR_ARRAY);
     glDisableClientState(GL_TEXTURE_COORD_ARRAY);
   }
 
+  void GUI::CreateLayer(const glm::ivec2& _size)
+  {
+    m_layer.Destroy();
+    m_layer.Init();
+    m_layer.Bind(GL_FRAMEBUFFER, _size.x, _size.y);
+    m_layer.AttachColorTexture(_size.x, _size.y, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    m_layerSize = _size;
+    if (m_layerVao == 0)
+    {
+      glGenVertexArrays(1, &m_layerVao);
+      m_layerProgram.CompileShadersFromSource(LAYER_VERT_SRC, LAYER_FRAG_SRC);
+      m_layerProgram.Use();
+      glUniform1i(m_layerProgram.GetUniformLocation("layer"), 0);
+      m_layerProgram.UnUse();
+    }
+  }
+
+  void GUI::CompositeLayer()
+  {
+    //CEGUI blends the alpha separately, so the layer's colors are premultiplied
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    m_layerProgram.Use();
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, m_layer.GetColorTexture(0).id);
+    RenderState::Get().BindVertexArray(m_layerVao);
+    FrameStats::Get().Add(STAT_DRAW_CALLS);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    RenderState::Get().BindVertexArray(0);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+    m_layerProgram.UnUse();
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  }
+
   void GUI::Update()
   {
     //Update gets called each frame
@@ -226,6 +320,8 @@ namespace GameEngine
   {
     //handle SDL events
     CEGUI::utf32 codePoint;
+    //the cursor isn't part of the context, so CEGUI doesn't invalidate the layer when it moves
+    m_layerDirty = true;
     switch (_evnt.type)
     {
       //inject the mouse position
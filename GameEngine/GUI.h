@@ -4,8 +4,14 @@
 #include <CEGUI\RendererModules\OpenGL\GL3Renderer.h>
 #include <glm\glm.hpp>
 #include <SDL\SDL_events.h>
+
+#include "Framebuffer.h"
+#include "GLSLProgram.h"
+
 namespace GameEngine
 {
+  /** \brief The CEGUI context of a screen. By default it's rendered into a layer which is only drawn again when CEGUI invalidated a
+  * window or the input moved the cursor or clicked, every other frame it's one textured quad, so a still menu costs next to nothing */
   class GUI
   {
   public:
@@ -15,8 +21,12 @@ namespace GameEngine
     void Init(const std::string& _resourceDirectory);
     //destroy the gui
     void DestroyGUI();
-    //draw the gui
+    //draw the gui, from the layer when it's used
     void Draw();
+    //renders CEGUI straight to the bound framebuffer every Draw instead of through the layer
+    void SetUseLayer(bool _useLayer) { m_useLayer = _useLayer; m_layerDirty = true; }
+    //draws the layer again on the next Draw, for changes CEGUI doesn't see
+    void Invalidate() { m_layerDirty = true; }
     //update the gui
     void Update();
     //sets the mouse cursor to a custom image
@@ -43,10 +53,24 @@ namespace GameEngine
     const CEGUI::GUIContext* GetContext()  const noexcept { return m_context; }
 
   private:
+    //renders the context to the bound framebuffer and cleans the state up after CEGUI
+    void RenderContext();
+    //(re)creates the layer and its composite program when the display size changed
+    void CreateLayer(const glm::ivec2& _size);
+    //draws the layer over the bound framebuffer
+    void CompositeLayer();
+
     static CEGUI::OpenGL3Renderer* m_renderer;
     CEGUI::GUIContext* m_context{ nullptr };
     CEGUI::Window* m_root{ nullptr };
     unsigned int m_lastTime{ 0 };
+
+    Framebuffer m_layer;          ///< what CEGUI drew the last time, premultiplied by its blending
+    GLSLProgram m_layerProgram;
+    GLuint m_layerVao{ 0 };       ///< empty, the quad comes from gl_VertexID
+    glm::ivec2 m_layerSize{ 0 };
+    bool m_useLayer{ true };
+    bool m_layerDirty{ true };
 				bool m_freed{ false };
   };
 }
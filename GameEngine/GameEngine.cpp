@@ -4,11 +4,24 @@
 
 #include "GameEngine.h"
 #include "GameEngineErrors.h"
+#include "JobSystem.h"
+#include "Profiler.h"
 
 namespace GameEngine
 {
-  int Init()
+  static bool s_headless{ false };
+
+  int Init(bool _headless)
   {
+    s_headless = _headless;
+    if (_headless)
+    {
+      //the events (the quit signal) and the timers, nothing which needs a display
+      SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS);
+      Profiler::Get();
+      JobSystem::Get().Init();
+      return 0;
+    }
     //initialize SDL
     SDL_Init(SDL_INIT_EVERYTHING);
     //The color bits
@@ -31,6 +44,16 @@ namespace GameEngine
 
     //set the accelerated visuals (it's possible that it's set by default but doing this just in case)
     SDL_GL_SetAttribute(SDL_GL_ACCELERATED_VISUAL, 1);
+
+    //the profiler names the thread which creates it the main one, before the workers record
+    Profiler::Get();
+    //the worker threads every subsystem shares
+    JobSystem::Get().Init();
     return 0;
   }
+
+  bool IsHeadless()
+  {
+    return s_headless;
+  }
 }
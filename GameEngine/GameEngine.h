@@ -1,4 +1,8 @@
+#pragma once
 namespace GameEngine
 {
-  extern int Init();
+  //initializes SDL and the job system. _headless leaves the video out: no window nor GL context will be made (e.g. a dedicated server)
+  extern int Init(bool _headless = false);
+  //there's no GL context: the loads skip the GPU (a texture only gets its size, a mesh only the vertices it keeps for the CPU)
+  extern bool IsHeadless();
 }
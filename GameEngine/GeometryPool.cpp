@@ -0,0 +1,279 @@
+#include "GeometryPool.h"
+#include "FrameStats.h"
+
+#include <algorithm>
+
+#include "GLSLProgram.h"
+#include "Model.h"
+#include "RenderState.h"
+
+namespace
+{
+  //the first allocation of a page buffer, they grow by doubling from here
+  constexpr GLsizeiptr MIN_BUFFER_BYTES = 1 << 20;
+}
+
+namespace GameEngine
+{
+  bool GeometryPool::IsSupported()
+  {
+    return GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect;
+  }
+
+  size_t GeometryPool::AddMesh(const Mesh& _mesh)
+  {
+    if (_mesh.HasAnimations() || _mesh.GetNumIndices() == 0)
+    {
+      return NO_MESH;
+    }
+    const size_t pageIndex = FindPage(_mesh.GetLayout());
+    Page& page = m_pages[pageIndex];
+
+    //the copies go through the copy targets, binding the VAO targets would change the bound VAO
+    RenderState::Get().BindVertexArray(0);
+    const GLsizeiptr vertexCapacity = page.vertexCapacity;
+    const GLsizeiptr indexCapacity = page.indexCapacity;
+    const GLsizeiptr vertexOffset = AppendBuffer(page.VBO, page.vertexBytes, page.vertexCapacity, _mesh.GetVBO(),
+      static_cast<GLsizeiptr>(_mesh.GetNumVertices()) * page.layout.m_stride);
+    const GLsizeiptr indexOffset = AppendBuffer(page.EBO, page.indexBytes, page.indexCapacity, _mesh.GetEBO(),
+      static_cast<GLsizeiptr>(_mesh.GetNumIndices()) * sizeof(GLuint));
+    if (page.vertexCapacity != vertexCapacity || page.indexCapacity != indexCapacity)
+    {
+      SetupPage(page);
+    }
+
+    PooledMesh pooled;
+    pooled.page = pageIndex;
+    pooled.material = FindMaterial(_mesh.GetTextures());
+    pooled.count = _mesh.GetNumIndices();
+    pooled.firstIndex = static_cast<GLuint>(indexOffset / sizeof(GLuint));
+    pooled.baseVertex = static_cast<GLint>(vertexOffset / page.layout.m_stride);
+    pooled.baseModelMatrix = _mesh.GetBaseModelMatrix();
+    m_meshes.push_back(pooled);
+    return m_meshes.size() - 1;
+  }
+
+  std::vector<size_t> GeometryPool::AddModel(const StaticModel& _model)
+  {
+    std::vector<size_t> meshes;
+    meshes.reserve(_model.GetMeshes().size());
+    for (const Mesh& mesh : _model.GetMeshes())
+    {
+      meshes.push_back(AddMesh(mesh));
+    }
+    return meshes;
+  }
+
+  void GeometryPool::Dispose()
+  {
+    for (Page& page : m_pages)
+    {
+      RenderState::Get().DeleteVertexArrays(1, &page.VAO);
+      glDeleteBuffers(1, &page.VBO);
+      glDeleteBuffers(1, &page.EBO);
+    }
+    m_pages.clear();
+    m_materials.clear();
+    m_meshes.clear();
+    Begin();
+    m_commands.clear();
+    m_batches.clear();
+    m_matrices.clear();
+
+    if (m_MBO != 0)
+    {
+      glDeleteBuffers(1, &m_MBO);
+      m_MBO = 0;
+    }
+    if (m_commandBuffer != 0)
+    {
+      glDeleteBuffers(1, &m_commandBuffer);
+      m_commandBuffer = 0;
+    }
+  }
+
+  void GeometryPool::Begin()
+  {
+    m_instances.clear();
+  }
+
+  void GeometryPool::Add(size_t _mesh, const glm::mat4& _transform)
+  {
+    if (_mesh < m_meshes.size())
+    {
+      m_instances.push_back({ _mesh, m_meshes[_mesh].baseModelMatrix * _transform });
+    }
+  }
+
+  void GeometryPool::Add(const std::vector<size_t>& _meshes, const glm::mat4& _transform)
+  {
+    for (size_t mesh : _meshes)
+    {
+      Add(mesh, _transform);
+    }
+  }
+
+  void GeometryPool::End()
+  {
+    //by page, then material, then mesh, so every mesh is one command with all its instances and every material one multi draw
+    std::stable_sort(m_instances.begin(), m_instances.end(), [this](const Instance& _a, const Instance& _b)
+    {
+      const PooledMesh& a = m_meshes[_a.mesh];
+      const PooledMesh& b = m_meshes[_b.mesh];
+      if (a.page != b.page)
+      {
+        return a.page < b.page;
+      }
+      if (a.material != b.material)
+      {
+        return a.material < b.material;
+      }
+      return _a.mesh < _b.mesh;
+    });
+
+    m_commands.clear();
+    m_batches.clear();
+    m_matrices.clear();
+    m_matrices.reserve(m_instances.size());
+    for (size_t i = 0; i < m_instances.size(); i++)
+    {
+      const PooledMesh& mesh = m_meshes[m_instances[i].mesh];
+      if (i == 0 || m_instances[i].mesh != m_instances[i - 1].mesh)
+      {
+        if (m_batches.empty() || m_batches.back().page != mesh.page || m_batches.back().material != mesh.material)
+        {
+          m_batches.push_back({ mesh.page, mesh.material, m_commands.size(), 0 });
+        }
+        m_commands.push_back({ mesh.count, 0, mesh.firstIndex, mesh.baseVertex, static_cast<GLuint>(m_matrices.size()) });
+        m_batches.back().numCommands++;
+      }
+      m_commands.back().instanceCount++;
+      m_matrices.push_back(m_instances[i].matrix);
+    }
+
+    if (m_commands.empty())
+    {
+      return;
+    }
+    if (m_MBO == 0)
+    {
+      glGenBuffers(1, &m_MBO);
+      for (Page& page : m_pages)
+      {
+        SetupPage(page);
+      }
+    }
+    if (m_commandBuffer == 0)
+    {
+      glGenBuffers(1, &m_commandBuffer);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, m_MBO);
+    FrameStats::Get().Add(STAT_BYTES_UPLOADED, m_matrices.size() * sizeof(glm::mat4) + m_commands.size() * sizeof(DrawElementsIndirectCommand));
+    glBufferData(GL_ARRAY_BUFFER, m_matrices.size() * sizeof(glm::mat4), m_matrices.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, m_commands.size() * sizeof(DrawElementsIndirectCommand), m_commands.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  void GeometryPool::Draw(GLSLProgram& _shader) const
+  {
+    if (m_batches.empty())
+    {
+      return;
+    }
+    _shader.UploadValue("instanced", 1);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+    size_t page = NO_MESH;
+    for (const Batch& batch : m_batches)
+    {
+      if (batch.page != page)
+      {
+        page = batch.page;
+        RenderState::Get().BindVertexArray(m_pages[page].VAO);
+      }
+      m_materials[batch.material].Bind(_shader);
+      FrameStats::Get().Add(STAT_DRAW_CALLS);
+      glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (GLvoid*)(batch.firstCommand * sizeof(DrawElementsIndirectCommand)),
+        batch.numCommands, 0);
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    _shader.UploadValue("instanced", 0);
+  }
+
+  size_t GeometryPool::FindPage(const Mesh::Layout& _layout)
+  {
+    for (size_t i = 0; i < m_pages.size(); i++)
+    {
+      const Mesh::Layout& layout = m_pages[i].layout;
+      if (layout.m_halfPositions == _layout.m_halfPositions && layout.m_unormUVs == _layout.m_unormUVs && layout.m_stride == _layout.m_stride)
+      {
+        return i;
+      }
+    }
+    Page page;
+    page.layout = _layout;
+    glGenVertexArrays(1, &page.VAO);
+    m_pages.push_back(page);
+    return m_pages.size() - 1;
+  }
+
+  size_t GeometryPool::FindMaterial(const std::vector<GLTexture>& _textures)
+  {
+    for (size_t i = 0; i < m_materials.size(); i++)
+    {
+      const std::vector<GLTexture>& material = m_materials[i].GetTextures();
+      if (material.size() == _textures.size() && std::equal(material.begin(), material.end(), _textures.begin(),
+        [](const GLTexture& _a, const GLTexture& _b) { return _a.id == _b.id && _a.type == _b.type; }))
+      {
+        return i;
+      }
+    }
+    m_materials.push_back(MaterialBindings(_textures));
+    return m_materials.size() - 1;
+  }
+
+  GLsizeiptr GeometryPool::AppendBuffer(GLuint& _buffer, GLsizeiptr& _bytes, GLsizeiptr& _capacity, GLuint _source, GLsizeiptr _sourceBytes)
+  {
+    if (_bytes + _sourceBytes > _capacity)
+    {
+      const GLsizeiptr capacity = std::max(std::max(_capacity * 2, _bytes + _sourceBytes), MIN_BUFFER_BYTES);
+      GLuint buffer = 0;
+      glGenBuffers(1, &buffer);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+      glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STATIC_DRAW);
+      if (_buffer != 0)
+      {
+        glBindBuffer(GL_COPY_READ_BUFFER, _buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, _bytes);
+        glDeleteBuffers(1, &_buffer);
+      }
+      _buffer = buffer;
+      _capacity = capacity;
+    }
+    const GLsizeiptr offset = _bytes;
+    glBindBuffer(GL_COPY_READ_BUFFER, _source);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, offset, _sourceBytes);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    _bytes += _sourceBytes;
+    return offset;
+  }
+
+  void GeometryPool::SetupPage(Page& _page) const
+  {
+    RenderState::Get().BindVertexArray(_page.VAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _page.EBO);
+    glBindBuffer(GL_ARRAY_BUFFER, _page.VBO);
+    const GLuint attributeLocation = Mesh::SetVertexAttributes(_page.layout, false);
+    if (m_MBO != 0)
+    {
+      //the instances are picked by the baseInstance of every command
+      glBindBuffer(GL_ARRAY_BUFFER, m_MBO);
+      Mesh::SetInstanceMatrixAttributes(attributeLocation);
+    }
+    RenderState::Get().BindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <GL\glew.h>
+#include <vector>
+#include <glm\mat4x4.hpp>
+
+#include "Mesh.h"
+
+namespace GameEngine
+{
+  class GLSLProgram;
+  class StaticModel;
+
+  /** \brief The geometry of many static meshes copied into a few shared buffers, so a whole frame of them is drawn with one
+  * glMultiDrawElementsIndirect per material instead of a bind and a draw per mesh (needs OpenGL 4.3, see IsSupported).
+  * The meshes are put into pages by their packed layout (see Mesh::Layout), every page has one VAO, one vertex and one index buffer.
+  * Every frame the draws are added between Begin() and End(), End() sorts them by page and material and uploads the indirect commands
+  * and the instance matrices, then Draw() renders them (as often as needed, e.g. for the shadow and the lit pass).
+  * The shader gets "instanced" = 1 and has to take the model matrix from the instance matrix (location 4) instead of the uniforms */
+  class GeometryPool
+  {
+  public:
+    enum : size_t { NO_MESH = static_cast<size_t>(-1) };
+
+    GeometryPool() {}
+    ~GeometryPool() { Dispose(); }
+
+    /** \brief Check if the driver can draw the pool */
+    static bool IsSupported();
+
+    /** \brief Copies the vertices and indices of _mesh on the GPU into the pool, the mesh doesn't need its CPU data
+    * \return the handle of the mesh in the pool, NO_MESH for an animated mesh */
+    size_t AddMesh(const Mesh& _mesh);
+    /** \brief Adds all the meshes of _model
+    * \return the handles by mesh */
+    std::vector<size_t> AddModel(const StaticModel& _model);
+    void Dispose();
+
+    /** \brief Removes the draws of the last frame */
+    void Begin();
+    /** \brief Draws the pooled mesh _mesh with _transform (the transformMatrix it would get as a single draw) */
+    void Add(size_t _mesh, const glm::mat4& _transform);
+    /** \brief Draws all the meshes of a model (the handles AddModel returned) with _transform */
+    void Add(const std::vector<size_t>& _meshes, const glm::mat4& _transform);
+    /** \brief Sorts the draws and uploads their commands and instance matrices */
+    void End();
+
+    /** \brief Renders the draws of the last End() with _shader (used) */
+    void Draw(GLSLProgram& _shader) const;
+
+    size_t GetNumMeshes() const noexcept { return m_meshes.size(); }
+    size_t GetNumPages() const noexcept { return m_pages.size(); }
+    /** \brief The number of multi draw calls Draw() makes */
+    size_t GetNumDrawCalls() const noexcept { return m_batches.size(); }
+    /** \brief The number of indirect commands (one per run of instances of the same mesh) of the last End() */
+    size_t GetNumCommands() const noexcept { return m_commands.size(); }
+
+  private:
+    /** \brief The meshes of one layout */
+    struct Page
+    {
+      Mesh::Layout layout;
+      GLuint VAO{ 0 }, VBO{ 0 }, EBO{ 0 };
+      GLsizeiptr vertexBytes{ 0 }, vertexCapacity{ 0 }; ///< used and allocated bytes of the VBO
+      GLsizeiptr indexBytes{ 0 }, indexCapacity{ 0 };   ///< used and allocated bytes of the EBO
+    };
+
+    /** \brief Where a pooled mesh is */
+    struct PooledMesh
+    {
+      size_t page;
+      size_t material;
+      GLuint count;
+      GLuint firstIndex;
+      GLint baseVertex;
+      glm::mat4 baseModelMatrix;
+    };
+
+    struct Instance
+    {
+      size_t mesh;
+      glm::mat4 matrix;
+    };
+
+    /** \brief The commands of one page and material, one multi draw */
+    struct Batch
+    {
+      size_t page;
+      size_t material;
+      size_t firstCommand;
+      GLsizei numCommands;
+    };
+
+    /** \brief The page of _layout, made if there is none yet */
+    size_t FindPage(const Mesh::Layout& _layout);
+    /** \brief The material of _textures, added if no mesh had the same textures yet */
+    size_t FindMaterial(const std::vector<GLTexture>& _textures);
+    /** \brief Copies _bytes of _source to the end of _buffer, which is doubled when it is too small (copying the old content)
+    * \return the offset of the copy in _buffer */
+    static GLsizeiptr AppendBuffer(GLuint& _buffer, GLsizeiptr& _bytes, GLsizeiptr& _capacity, GLuint _source, GLsizeiptr _sourceBytes);
+    /** \brief Points the VAO of _page into its buffers, again after they were reallocated */
+    void SetupPage(Page& _page) const;
+
+  private:
+    std::vector<Page> m_pages;
+    std::vector<MaterialBindings> m_materials;
+    std::vector<PooledMesh> m_meshes;
+
+    std::vector<Instance> m_instances; ///< the draws since Begin()
+    std::vector<DrawElementsIndirectCommand> m_commands;
+    std::vector<Batch> m_batches;
+    std::vector<glm::mat4> m_matrices; ///< the instance matrices in the order of the commands
+
+    GLuint m_MBO{ 0 };           ///< the instance matrices, shared by the VAOs of all the pages
+    GLuint m_commandBuffer{ 0 }; ///< the GL_DRAW_INDIRECT_BUFFER
+  };
+}
@@ -0,0 +1,134 @@
+#include "GpuProfiler.h"
+
+namespace GameEngine
+{
+  namespace
+  {
+    //the open scopes which aren't timed, so their EndScope is skipped too
+    constexpr size_t UNTIMED_SCOPE{ static_cast<size_t>(-1) };
+  }
+
+  GpuProfiler& GpuProfiler::Get()
+  {
+    //GL is used from one thread at a time, like the rest of the rendering
+    static GpuProfiler profiler;
+    return profiler;
+  }
+
+  void GpuProfiler::BeginFrame()
+  {
+    m_openScopes.clear();
+    m_frameStarted = false;
+    //timestamp queries are core in 3.3
+    if (!Profiler::Get().IsEnabled() || !(GLEW_VERSION_3_3 || GLEW_ARB_timer_query))
+    {
+      return;
+    }
+    if (!m_hasTrack)
+    {
+      m_track = Profiler::Get().AddTrack("GPU");
+      m_hasTrack = true;
+    }
+
+    m_currentPool = (m_currentPool + 1) % GPU_QUERY_POOLS;
+    QueryPool& pool = m_pools[m_currentPool];
+    ReadPool(pool);
+    pool.numUsed = 0;
+    pool.scopes.clear();
+
+    //the GPU clock only differs from the CPU one by an offset, taken once a frame
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    pool.gpuToCpu = Profiler::Now() - static_cast<std::int64_t>(gpuNow);
+    m_frameStarted = true;
+  }
+
+  void GpuProfiler::Dispose()
+  {
+    for (auto& pool : m_pools)
+    {
+      if (!pool.queries.empty())
+      {
+        glDeleteQueries(static_cast<GLsizei>(pool.queries.size()), pool.queries.data());
+      }
+      pool.queries.clear();
+      pool.numUsed = 0;
+      pool.scopes.clear();
+    }
+    m_openScopes.clear();
+    m_frameStarted = false;
+  }
+
+  void GpuProfiler::BeginScope(const char* _name)
+  {
+    if (!m_frameStarted)
+    {
+      m_openScopes.push_back(UNTIMED_SCOPE);
+      return;
+    }
+    QueryPool& pool = m_pools[m_currentPool];
+    Scope scope;
+    scope.name = _name;
+    scope.depth = static_cast<std::uint32_t>(m_openScopes.size());
+    scope.beginQuery = IssueTimestamp(pool);
+    m_openScopes.push_back(pool.scopes.size());
+    pool.scopes.push_back(scope);
+  }
+
+  void GpuProfiler::EndScope()
+  {
+    if (m_openScopes.empty())
+    {
+      return;
+    }
+    const size_t scope = m_openScopes.back();
+    m_openScopes.pop_back();
+    if (scope != UNTIMED_SCOPE && m_frameStarted)
+    {
+      QueryPool& pool = m_pools[m_currentPool];
+      pool.scopes[scope].endQuery = IssueTimestamp(pool);
+    }
+  }
+
+  size_t GpuProfiler::IssueTimestamp(QueryPool& _pool)
+  {
+    if (_pool.numUsed == _pool.queries.size())
+    {
+      GLuint query = 0;
+      glGenQueries(1, &query);
+      _pool.queries.push_back(query);
+    }
+    glQueryCounter(_pool.queries[_pool.numUsed], GL_TIMESTAMP);
+    return _pool.numUsed++;
+  }
+
+  void GpuProfiler::ReadPool(QueryPool& _pool)
+  {
+    if (_pool.scopes.empty())
+    {
+      return;
+    }
+    //the queries finish in order, if the last one is available all are
+    GLint available = 0;
+    glGetQueryObjectiv(_pool.queries[_pool.numUsed - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+    {
+      m_numSkipped++;
+      return;
+    }
+    for (const Scope& scope : _pool.scopes)
+    {
+      //a scope still open at the end of its frame has no end
+      if (scope.endQuery <= scope.beginQuery)
+      {
+        continue;
+      }
+      GLuint64 begin = 0;
+      GLuint64 end = 0;
+      glGetQueryObjectui64v(_pool.queries[scope.beginQuery], GL_QUERY_RESULT, &begin);
+      glGetQueryObjectui64v(_pool.queries[scope.endQuery], GL_QUERY_RESULT, &end);
+      Profiler::Get().RecordOnTrack(m_track, scope.name, static_cast<std::int64_t>(begin) + _pool.gpuToCpu,
+        static_cast<std::int64_t>(end) + _pool.gpuToCpu, scope.depth);
+    }
+  }
+}
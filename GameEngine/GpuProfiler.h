@@ -0,0 +1,80 @@
+#pragma once
+#include <GL\glew.h>
+#include <cstdint>
+#include <vector>
+
+#include "Profiler.h"
+
+namespace GameEngine
+{
+  //the frames of queries in flight, the results of a frame are read when its pool comes around again, by then the GPU is done with it
+  constexpr size_t GPU_QUERY_POOLS{ 2 };
+
+  /** \brief Times the GPU work of scopes with timestamp queries (glQueryCounter), which unlike GL_TIME_ELAPSED can nest. The queries of a
+   *  frame go into a pool, which is read GPU_QUERY_POOLS frames later without waiting: a pool which isn't done yet is skipped. The
+   *  times are moved to the CPU clock and recorded on the "GPU" track of the Profiler, so they line up with the CPU scopes in the
+   *  timeline and the trace. Only times while the Profiler is enabled, and only on the thread with the GL context */
+  class GpuProfiler
+  {
+  public:
+    static GpuProfiler& Get();
+
+    // Reads the pool of GPU_QUERY_POOLS frames ago and starts the pool of this frame, before the frame is drawn
+    void BeginFrame();
+    // Deletes the queries, before the GL context goes
+    void Dispose();
+
+    // Times the GPU commands until the matching EndScope, _name has to be a string literal
+    void BeginScope(const char* _name);
+    void EndScope();
+
+    // The pools which weren't done when they were read again
+    std::uint64_t GetNumSkipped() const noexcept { return m_numSkipped; }
+
+  private:
+    GpuProfiler() {}
+
+    struct Scope
+    {
+      const char* name{ nullptr };
+      size_t beginQuery{ 0 };
+      size_t endQuery{ 0 };
+      std::uint32_t depth{ 0 };
+    };
+    struct QueryPool
+    {
+      std::vector<GLuint> queries;   ///< grows with the scopes of the frame, kept
+      size_t numUsed{ 0 };
+      std::vector<Scope> scopes;
+      std::int64_t gpuToCpu{ 0 };   ///< the CPU time minus the GPU time when the frame began
+    };
+
+    // The next timestamp query of the pool, issued now
+    size_t IssueTimestamp(QueryPool& _pool);
+    // Records the scopes of the pool on the track, if the GPU is done with them
+    void ReadPool(QueryPool& _pool);
+
+    QueryPool m_pools[GPU_QUERY_POOLS];
+    size_t m_currentPool{ 0 };
+    bool m_frameStarted{ false };   ///< the pool of this frame takes scopes
+    std::vector<size_t> m_openScopes;
+    std::uint32_t m_track{ 0 };
+    bool m_hasTrack{ false };
+    std::uint64_t m_numSkipped{ 0 };
+  };
+
+  //times the GPU commands from its construction to its destruction
+  class GpuProfileScope
+  {
+  public:
+    explicit GpuProfileScope(const char* _name) { GpuProfiler::Get().BeginScope(_name); }
+    ~GpuProfileScope() { GpuProfiler::Get().EndScope(); }
+  };
+}
+
+#ifdef GAME_ENGINE_PROFILE
+//times the GPU commands of the rest of the enclosing scope under _name, which has to be a string literal
+#define GPU_PROFILE_SCOPE(_name) GameEngine::GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(_name)
+#else
+#define GPU_PROFILE_SCOPE(_name)
+#endif
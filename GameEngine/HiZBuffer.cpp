@@ -0,0 +1,137 @@
+#include "HiZBuffer.h"
+
+#include <algorithm>
+
+namespace GameEngine
+{
+  namespace
+  {
+    //8x8 texels of the written level a work group
+    constexpr GLuint HIZ_GROUP_SIZE = 8;
+
+    const char* HIZ_COPY_COMP_SRC = R"(#version 430 core
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (r32f, binding = 0) writeonly uniform image2D destination;
+uniform sampler2D depth;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, imageSize(destination))))
+    {
+        return;
+    }
+    imageStore(destination, texel, vec4(texelFetch(depth, texel, 0).r));
+})";
+
+    const char* HIZ_REDUCE_COMP_SRC = R"(#version 430 core
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (r32f, binding = 0) readonly uniform image2D source;
+layout (r32f, binding = 1) writeonly uniform image2D destination;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(destination);
+    ivec2 sourceSize = imageSize(source);
+    if (any(greaterThanEqual(texel, size)))
+    {
+        return;
+    }
+    //the farthest of the 2x2 texels, and of the 3rd row or column the last texel of an odd level has to cover as well
+    ivec2 first = texel * 2;
+    ivec2 last = min(first + ivec2(1) + ivec2(equal(texel, size - 1)) * (sourceSize & 1), sourceSize - 1);
+    float depth = 0.0;
+    for (int y = first.y; y <= last.y; y++)
+    {
+        for (int x = first.x; x <= last.x; x++)
+        {
+            depth = max(depth, imageLoad(source, ivec2(x, y)).r);
+        }
+    }
+    imageStore(destination, texel, vec4(depth));
+})";
+  }
+
+  bool HiZBuffer::IsSupported()
+  {
+    return GLEW_VERSION_4_3 != 0;
+  }
+
+  void HiZBuffer::Init(int _width, int _height)
+  {
+    m_copyProgram.CompileComputeShaderFromSource(HIZ_COPY_COMP_SRC);
+    m_depthUniform = m_copyProgram.GetUniform("depth");
+    m_reduceProgram.CompileComputeShaderFromSource(HIZ_REDUCE_COMP_SRC);
+    Resize(_width, _height);
+  }
+
+  void HiZBuffer::Dispose()
+  {
+    m_copyProgram.Dispose();
+    m_reduceProgram.Dispose();
+    if (m_texture.id != 0)
+    {
+      m_texture.Dispose();
+    }
+    m_numLevels = 0;
+    m_built = false;
+  }
+
+  void HiZBuffer::Resize(int _width, int _height)
+  {
+    if (m_texture.id != 0)
+    {
+      m_texture.Dispose();
+    }
+    m_texture.width = _width;
+    m_texture.height = _height;
+    m_numLevels = 1;
+    while ((std::max(_width, _height) >> m_numLevels) > 0)
+    {
+      m_numLevels++;
+    }
+    glGenTextures(1, &m_texture.id);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, m_texture.id);
+    //immutable, the levels can be bound as images
+    glTexStorage2D(GL_TEXTURE_2D, m_numLevels, GL_R32F, _width, _height);
+    //a lookup reads one level, never a blend of the farthest depths with nearer ones
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+    m_built = false;
+  }
+
+  void HiZBuffer::Build(const GLTexture& _depthTexture, const glm::mat4& _viewProjection)
+  {
+    m_copyProgram.Use();
+    m_copyProgram.UploadValue(m_depthUniform, 0, _depthTexture);
+    glBindImageTexture(0, m_texture.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    glDispatchCompute((m_texture.width + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, (m_texture.height + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+
+    m_reduceProgram.Use();
+    int width = m_texture.width;
+    int height = m_texture.height;
+    for (GLint level = 1; level < m_numLevels; level++)
+    {
+      //every level reads the one written before
+      glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+      width = std::max(width / 2, 1);
+      height = std::max(height / 2, 1);
+      glBindImageTexture(0, m_texture.id, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+      glBindImageTexture(1, m_texture.id, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+      glDispatchCompute((width + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, (height + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+    }
+    //the culling shaders sample it
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+    glBindImageTexture(1, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    m_reduceProgram.UnUse();
+    m_viewProjection = _viewProjection;
+    m_built = true;
+  }
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <GL\glew.h>
+#include <glm\mat4x4.hpp>
+
+#include "GLSLProgram.h"
+#include "GLTexture.h"
+
+namespace GameEngine
+{
+  /** \brief The hierarchical depth of a frame for occlusion culling: a mip chain of the depth in which every texel is the farthest depth
+  * of the 2x2 texels under it, so a single lookup at the level where a bounding box covers 2x2 texels tells whether all of it is behind
+  * what was drawn. It's built by compute shaders from the depth texture of a Framebuffer (e.g. the G-buffer) after the frame, and the
+  * next frame tests its instances against it (see InstanceCuller::SetOcclusion) with the view projection it was built with, the
+  * instances hidden last frame aren't drawn. Something appearing from behind an occluder shows a frame late. Needs OpenGL 4.3 */
+  class HiZBuffer
+  {
+  public:
+    HiZBuffer() {}
+    ~HiZBuffer() { Dispose(); }
+
+    /** \brief Check if the driver supports compute shaders and image load store */
+    static bool IsSupported();
+
+    /** \brief Compiles the shaders and creates the pyramid for a _width x _height depth */
+    void Init(int _width, int _height);
+    void Dispose();
+    /** \brief Creates the pyramid again for the new size of the depth, it's empty until the next Build */
+    void Resize(int _width, int _height);
+
+    /** \brief Reduces _depthTexture (as large as the pyramid) into the pyramid, _viewProjection is the one the depth was drawn with */
+    void Build(const GLTexture& _depthTexture, const glm::mat4& _viewProjection);
+
+    /** \brief The pyramid, R32F with nearest mip filtering */
+    const GLTexture& GetTexture() const noexcept { return m_texture; }
+    GLint GetNumLevels() const noexcept { return m_numLevels; }
+    const glm::mat4& GetViewProjection() const noexcept { return m_viewProjection; }
+    /** \brief Check if the pyramid holds a depth, false after Init and Resize */
+    bool IsBuilt() const noexcept { return m_built; }
+
+  private:
+    GLSLProgram m_copyProgram;   ///< level 0 from the depth texture
+    GLSLProgram m_reduceProgram; ///< every next level from the one before
+    UniformHandle m_depthUniform;
+    GLTexture m_texture;
+    GLint m_numLevels{ 0 };
+    glm::mat4 m_viewProjection{ 1.0f };
+    bool m_built{ false };
+  };
+}
@@ -5,6 +5,7 @@
 namespace GameEngine
 {
   class IMainGame;
+  struct FramePacket;
 
   enum class ScreenState
   {
@@ -34,7 +35,7 @@ namespace GameEngine
     virtual int GetNextScreenIndex() const = 0;
     virtual int GetPreviousScreenIndex() const = 0;
 
-    // Called at beginning and end of application
+    // Called the first time the screen is entered and at the end of application
     virtual void Build() = 0;
     virtual void Destroy() = 0;
 
@@ -46,6 +47,14 @@ namespace GameEngine
     virtual void Update() = 0;
     virtual void Draw() = 0;
 
+    /* The screens which return true are drawn on the render thread when the game has one (see IMainGame::m_useRenderThread):
+       BuildFramePacket is called instead of Draw after the update, on the simulation thread, and must make no GL calls (nor
+       Update, the context is the render thread's), RenderFramePacket draws the packet on the render thread while the next
+       frame is updated */
+    virtual bool UsesFramePackets() const { return false; }
+    virtual void BuildFramePacket(FramePacket& _packet) {}
+    virtual void RenderFramePacket(FramePacket& _packet) {}
+
     // Gets the index of the current screen
     int GetScreenIndex() const noexcept
     {
@@ -65,5 +74,6 @@ namespace GameEngine
     ScreenState m_currentState = ScreenState::NONE;
     IMainGame* m_game{ nullptr };
     int m_screenIndex{ SCREEN_INDEX_NO_SCREEN };
+    bool m_isBuilt{ false }; ///< Build is called by the ScreenList the first time the screen is entered
   };
 }
\ No newline at end of file
@@ -1,7 +1,21 @@
 #include "IMainGame.h"
+#include "Allocators.h"
+#include "AudioMixer.h"
 #include "Timing.h"
 #include "ScreenList.h"
 #include "IGameScreen.h"
+#include "RenderState.h"
+#include "ResourceManager.h"
+#include "IOManager.h"
+#include "GLSLProgram.h"
+#include "JobSystem.h"
+#include "MemoryTracker.h"
+#include "FrameStats.h"
+#include "GpuProfiler.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <limits>
 
 namespace GameEngine
 {
@@ -11,7 +25,9 @@ namespace GameEngine
 		}
 		IMainGame::~IMainGame()
 		{
-				//empty
+				//the screens own the subsystems, the tracked memory still in use once they're gone was leaked
+				m_screenList.reset();
+				MemoryTracker::Get().ReportLeaks();
 		}
 
 		void IMainGame::Run()
@@ -20,7 +36,20 @@ namespace GameEngine
 				if (!Init()) return;
 				//set the max fps
 				FpsLimiter limiter;
-				limiter.SetMaxFPS(60.0f);
+				//headless a frame is a tick, the limiter sleeps the rest of it away
+				limiter.SetMaxFPS(m_headless ? 1.0f / m_fixedTimeStep : m_maxFPS);
+				//without a swap interval the driver doesn't wait, the limiter has to
+				if (m_vsync && m_window.SetVSync(true))
+				{
+						limiter.SetPacing(FramePacing::VSYNC);
+				}
+				//the screens move by GetDT, in frames of 60Hz like the variable frames were
+				m_deltaTime = m_fixedTimeStep * 60.0f;
+
+				//the real time which isn't simulated yet, it starts with a tick so the first frame is updated before it's drawn
+				float accumulator = m_fixedTimeStep;
+				HRTimer frameTimer;
+				frameTimer.Start();
 
 				// Game loop
 				m_isRunning = true;
@@ -28,46 +57,164 @@ namespace GameEngine
 				{
 						//begins the frame
 						limiter.BeginFrame();
-
-						//updates the key map
-						inputManager.Update();
-						// Call the custom update and draw method
-						if (!m_paused)
+						Profiler::Get().BeginFrame();
+						//the temporaries of the frame before last go, the last frame's may still be drawn from
+						FrameAllocator::Get().BeginFrame();
+						if (m_tickPerFrame)
 						{
-								Update();
+								accumulator = m_fixedTimeStep;
 						}
 						else
 						{
-								SDL_Event evnt;
-								while (SDL_PollEvent(&evnt))
+								accumulator += std::min(frameTimer.Seconds(), m_fixedTimeStep * m_maxTicksPerFrame);
+						}
+						frameTimer.Start();
+
+						//the render thread owns the context, it does them itself before it draws (see SyncRenderThread)
+						if (m_headless)
+						{
+								JobSystem::Get().RunMainThreadJobs();
+						}
+						else if (!m_renderThread.IsRunning())
+						{
+								SyncRenderThread();
+						}
+						//the events which came since the last pump are recorded now, before the ticks consume them
+						SDL_PumpEvents();
+						const std::int64_t frameTime = InputEventQueue::Now();
+						// Call the custom update method once a tick
+						while (m_isRunning && accumulator >= m_fixedTimeStep)
+						{
+								accumulator -= m_fixedTimeStep;
+								//a tick takes the events up to the real time it simulates, the last one of the frame takes the rest
+								const std::int64_t tickTime = accumulator >= m_fixedTimeStep ?
+										frameTime - static_cast<std::int64_t>(static_cast<double>(accumulator) * 1e9) : std::numeric_limits<std::int64_t>::max();
+								inputActions.BeginTick(m_inputEvents, tickTime);
+								//updates the key map, a tick at a time so a key is only pressed in the tick it went down
+								inputManager.Update();
+								if (!m_paused)
 								{
-										OnSDLEvent(evnt);
+										Update();
 								}
-								if (inputManager.IsKeyPressed(SDLK_F9))
+								else
 								{
-										m_paused = !m_paused;
+										SDL_Event evnt;
+										while (SDL_PollEvent(&evnt))
+										{
+												OnSDLEvent(evnt);
+										}
+										if (inputManager.IsKeyPressed(SDLK_F9))
+										{
+												m_paused = !m_paused;
+										}
+										if (inputManager.IsKeyPressed(SDLK_ESCAPE))
+										{
+												ExitGame();
+										}
 								}
-								if (inputManager.IsKeyPressed(SDLK_ESCAPE))
+						}
+						m_interpolation = accumulator / m_fixedTimeStep;
+						if (m_headless)
+						{
+								m_fps = limiter.End();
+						}
+						else if (m_isRunning && !m_window.IsMinimized())
+						{
+								std::shared_ptr<IGameScreen> screen = m_currentScreen.lock();
+								const bool usesRenderThread = m_useRenderThread && screen && screen->GetState() == ScreenState::RUNNING &&
+										screen->UsesFramePackets();
+								if (usesRenderThread && !m_renderThread.IsRunning())
+								{
+										StartRenderThread();
+								}
+								else if (!usesRenderThread)
+								{
+										m_renderThread.Stop();
+								}
+
+								if (m_renderThread.IsRunning())
+								{
+										//built while the frame before is drawn, handed over once it's done
+										FramePacket& packet = m_renderThread.GetBuildPacket();
+										packet.interpolation = m_interpolation;
+										{
+												PROFILE_SCOPE("IMainGame::BuildFramePacket");
+												screen->BuildFramePacket(packet);
+										}
+										m_fps = limiter.End();
+										PROFILE_SCOPE("RenderThread::Submit");
+										m_renderThread.Submit();
+								}
+								else
 								{
-										ExitGame();
+										//the redundant GL calls are counted per frame
+										RenderState::Get().BeginFrame();
+										GpuProfiler::Get().BeginFrame();
+										Draw();
+										const RenderState::Stats& glStats = RenderState::Get().GetFrameStats();
+										FrameStats::Get().Set(STAT_STATE_CHANGES, glStats.GetNumCalls() - glStats.GetNumRedundant());
+										//ends the fps limiter at the end of the frame
+										m_fps = limiter.End();
+										//swaps the buffer
+										m_window.SwapBuffer();
 								}
 						}
-						if (m_isRunning && !m_window.IsMinimized())
+						//the scopes of the frame are gathered for the overlay and the trace
+						Profiler::Get().EndFrame();
+						FrameStats::Get().EndFrame();
+				}
+
+				SDL_DelEventWatch(&IMainGame::RecordInputEvent, this);
+				m_renderThread.Stop();
+				if (m_headless)
+				{
+						SDL_Quit();
+				}
+				else
+				{
+						GpuProfiler::Get().Dispose();
+						m_window.Close();
+				}
+				JobSystem::Get().Shutdown();
+		}
+
+		void IMainGame::StartRenderThread()
+		{
+				const bool started = m_renderThread.Start(m_window, [this](FramePacket& _packet)
+				{
+						//the viewport set by a resize on the simulation thread had no context to go to
+						glViewport(0, 0, m_window.GetScreenWidth(), m_window.GetScreenHeight());
+						//the screen only changes while the render thread is stopped
+						std::shared_ptr<IGameScreen> screen = m_currentScreen.lock();
+						if (screen)
 						{
-								Draw();
-								//ends the fps limiter at the end of the frame
-								m_fps = limiter.End();
-								//swaps the buffer
-								m_window.SwapBuffer();
+								screen->RenderFramePacket(_packet);
 						}
-						m_deltaTime = limiter.GetCurrentDT();
+				}, [this]() { SyncRenderThread(); });
+				if (!started)
+				{
+						//drawn on the simulation thread from then on
+						m_useRenderThread = false;
 				}
+		}
 
-				m_window.Close();
+		void IMainGame::SyncRenderThread()
+		{
+				//the textures decoded in the background since the last frame are uploaded before they're used
+				ResourceManager::UpdateAsyncLoads();
+				//the GL work the jobs queued for this thread
+				JobSystem::Get().RunMainThreadJobs();
+				//the assets edited since the last frame are reloaded before it's drawn with them
+				if (m_hotReload)
+				{
+						ResourceManager::ReloadChangedAssets();
+				}
 		}
 
 		void IMainGame::ExitGame()
 		{
+				//the screens dispose their GL objects, the context has to be back on this thread
+				m_renderThread.Stop();
 				//call the custom OnExit function for the current screen
 				m_currentScreen.lock()->OnExit();
 				if (m_screenList)
@@ -81,6 +228,13 @@ namespace GameEngine
 				m_isRunning = false;
 		}
 
+		int SDLCALL IMainGame::RecordInputEvent(void* _game, SDL_Event* _event)
+		{
+				static_cast<IMainGame*>(_game)->m_inputEvents.Record(*_event);
+				//the return value of a watch is ignored, the event stays in the queue for the screens
+				return 1;
+		}
+
 		void IMainGame::OnSDLEvent(SDL_Event& _evnt)
 		{
 				//handles SDL events
@@ -131,26 +285,81 @@ namespace GameEngine
 
 		bool IMainGame::Init()
 		{
-				//Initialize SDL and sets pre-window properties
-				GameEngine::Init();
+				HRTimer startupTimer;
+				startupTimer.Start();
+				HRTimer stepTimer;
+				m_startupReport.Clear();
 
-				//Call on init at the start of the game
+				//Call on init at the start of the game, it may turn m_headless on
+				stepTimer.Start();
 				OnInit();
+				//Initialize SDL and sets pre-window properties
+				GameEngine::Init(m_headless);
+				m_startupReport.Add("GameEngine::Init", stepTimer.Milli());
+
+				//the input events are recorded with their time from then on, for inputActions
+				SDL_AddEventWatch(&IMainGame::RecordInputEvent, this);
+				//the index of the pack is read on a worker while the window is created, nothing reads a file until the jobs are done
+				RunStartupJob("IOManager::MountPack", [this]()
+				{
+						//the packed assets are read from the pack from then on, without one they're the loose files
+						IOManager::MountPack(m_packPath);
+						//the loads register their files from then on
+						IOManager::EnableFileWatching(m_hotReload);
+				});
+				OnStartLoading();
 
 				/*try ti initialize the systems, and if it fails then InitSystems() returns false,
 						so invert it and in the if-statement return false to show that the initialization failed*/
-				if (!InitSystems()) return false;
+				if (!m_headless)
+				{
+						stepTimer.Start();
+						if (!InitSystems())
+						{
+								JobSystem::Get().Wait(m_startupJobs);
+								return false;
+						}
+						//needs the GL context of the window
+						GLSLProgram::EnableBinaryCache(m_shaderCachePath);
+						GLSLProgram::EnableParallelCompile(m_parallelShaderCompile);
+						m_startupReport.Add("Window::Create", stepTimer.Milli());
+				}
+
+				//the screens may use what the jobs loaded, this thread runs the ones left meanwhile
+				stepTimer.Start();
+				JobSystem::Get().Wait(m_startupJobs);
+				m_startupReport.Add("waiting for the startup jobs", stepTimer.Milli());
 
 				//add the screens
+				stepTimer.Start();
 				AddScreens();
+				m_startupReport.Add("AddScreens", stepTimer.Milli());
 				//Get the first default screen ( main menu screen ) and do it's OnEntry custom function and set the game state to running
+				stepTimer.Start();
 				m_currentScreen = m_screenList->GetCurrent();
 				m_currentScreen.lock()->OnEntry();
 				m_currentScreen.lock()->SetRunning();
+				m_startupReport.Add("the first screen's Build and OnEntry", stepTimer.Milli());
 
+				m_startupReport.SetTotal(startupTimer.Milli());
+				if (m_printStartupReport)
+				{
+						m_startupReport.Print();
+				}
 				return true;
 		}
 
+		void IMainGame::RunStartupJob(const std::string& _name, Job _job)
+		{
+				JobSystem::Get().Run([this, _name, _job]()
+				{
+						HRTimer timer;
+						timer.Start();
+						_job();
+						m_startupReport.Add(_name, timer.Milli(), true);
+				}, &m_startupJobs);
+		}
+
 		bool IMainGame::InitSystems()
 		{
 				//create the Window
@@ -161,6 +370,7 @@ namespace GameEngine
 
 		void IMainGame::Update()
 		{
+				PROFILE_SCOPE("IMainGame::Update");
 				//update gets called every frame
 				//check if the current screen isn't NONE (0)
 				if (m_currentScreen.lock())
@@ -172,6 +382,8 @@ namespace GameEngine
 								m_currentScreen.lock()->Update();
 								break;
 						case ScreenState::CHANGE_NEXT:
+								//OnExit and OnEntry create and delete GL objects, the render thread gives the context back first
+								m_renderThread.Stop();
 								//if CHange Next is called, then call the custom OnExit function and Move to the next screen
 								m_currentScreen.lock()->OnExit();
 								m_currentScreen = m_screenList->MoveNext();
@@ -184,6 +396,7 @@ namespace GameEngine
 								}
 								break;
 						case ScreenState::CHANGE_PREVIOUS:
+								m_renderThread.Stop();
 								//if CHange Previous is called, then call the custom OnExit function and Move to the previous screen
 								m_currentScreen.lock()->OnExit();
 								m_currentScreen = m_screenList->MovePrevious();
@@ -202,6 +415,11 @@ namespace GameEngine
 						default:
 								break;
 						}
+						//the sources are panned and culled from where the screen put the listener this tick
+						if (AudioMixer::Get().IsInitialized())
+						{
+								AudioMixer::Get().UpdateSources();
+						}
 				}
 				else
 				{
@@ -212,6 +430,7 @@ namespace GameEngine
 
 		void IMainGame::Draw()
 		{
+				PROFILE_SCOPE("IMainGame::Draw");
 				if (m_currentScreen.lock() && m_currentScreen.lock()->GetState() == ScreenState::RUNNING)
 				{
 						//if the current screen isn't NONE and its state is running, then call its custom draw function
@@ -3,6 +3,10 @@
 #include "GameEngine.h"
 #include "Window.h"
 #include "InputManager.h"
+#include "InputActions.h"
+#include "RenderThread.h"
+#include "JobSystem.h"
+#include "StartupReport.h"
 #include <memory>
 
 namespace GameEngine
@@ -22,20 +26,35 @@ namespace GameEngine
     void ExitGame();
     //called on entry
     virtual void OnInit() = 0;
-    //used when adding screens
+    //used when adding screens, the screens are built the first time they're entered (see ScreenList)
     virtual void AddScreens() = 0;
+    //called once the job system runs and before the window is created, to queue the loads which don't need GL on the workers
+    //(see RunStartupJob), e.g. parsing the levels or decoding the sounds, while the main thread creates the context
+    virtual void OnStartLoading() {}
     //called when exiting
     virtual void OnExit() = 0;
     //handle SDL events
     void OnSDLEvent(SDL_Event& _evnt);
 
     const float GetFPS() const noexcept { return m_fps; }
+    //the length of a simulation tick in frames of 60Hz, 1 unless m_fixedTimeStep is changed
     const float GetDT()  const noexcept { return m_deltaTime; }
+    //the seconds every Update simulates
+    const float GetFixedTimeStep() const noexcept { return m_fixedTimeStep; }
+    //how far the drawn frame is between the last two ticks (0 the one before, 1 the last), to draw the moving objects in between
+    const float GetInterpolation() const noexcept { return m_interpolation; }
+    //the steps of the startup and how long they took
+    const StartupReport& GetStartupReport() const noexcept { return m_startupReport; }
+
+    //no window nor GL (see m_headless), the screens skip their GL objects in OnEntry and nothing is drawn
+    bool IsHeadless() const noexcept { return m_headless; }
 
 				const bool GetPaused() const	noexcept { return m_paused; }
 				void SetPause(bool _paused)  noexcept { m_paused = _paused; }
 
     InputManager inputManager;
+    //the actions the screens bind their keys to, fed a tick at a time from the recorded events
+    InputActions inputActions;
 
   protected:
     //custom update function
@@ -46,6 +65,15 @@ namespace GameEngine
     bool Init();
     //create the window
     bool InitSystems();
+    //runs _job on a worker during the startup, Init waits for all of them before AddScreens. No GL calls (see JobSystem)
+    void RunStartupJob(const std::string& _name, Job _job);
+    //moves the drawing to the render thread
+    void StartRenderThread();
+    //the GL work of the frame which isn't drawing (the async loads, the hot reload, the main thread jobs), done by the render thread
+    //when it runs
+    void SyncRenderThread();
+    //the SDL event watch, records the key and button events into m_inputEvents as SDL takes them in
+    static int SDLCALL RecordInputEvent(void* _game, SDL_Event* _event);
     //list of screens
     std::unique_ptr<ScreenList> m_screenList{ nullptr };
     //current screen
@@ -57,9 +85,43 @@ namespace GameEngine
 
     float m_deltaTime{ 1.0f };
     float m_fps{ 60.0f };
+    float m_interpolation{ 1.0f };
+    //the key and button events with when they came, consumed by inputActions
+    InputEventQueue m_inputEvents;
+    //Update runs at this fixed step whatever the refresh rate, as many ticks a frame as the real time needs
+    float m_fixedTimeStep{ 1.0f / 60.0f };
+    //the most ticks a frame catches up, a longer hitch slows the game down instead of stalling on a burst of ticks
+    int m_maxTicksPerFrame{ 5 };
+    //every frame simulates exactly one tick however long it took, so a replay runs the same ticks on any machine (e.g. a benchmark)
+    bool m_tickPerFrame{ false };
+    //the frame rate Draw is limited to, 0 leaves it to the vsync
+    float m_maxFPS{ 60.0f };
+    //the frames are paced by the buffer swap waiting for the display instead of the limiter's waits
+    bool m_vsync{ false };
+    //the screens which build frame packets (see IGameScreen::UsesFramePackets) are drawn on a render thread while the next frame
+    //is updated, the other screens are drawn after the update as usual
+    bool m_useRenderThread{ false };
+    RenderThread m_renderThread;
+    //runs without a window nor GL, e.g. as a dedicated server (set in OnInit or before Run): the screens are updated every
+    //m_fixedTimeStep and never drawn, the loads skip the GPU (see GameEngine::IsHeadless)
+    bool m_headless{ false };
     //the window
     Window m_window;
     std::string m_gameName{ "Default" };
+    //mounted after OnInit if it exists (see AssetPack::Build to make one)
+    std::string m_packPath{ "Assets.pak" };
+    //watches the loaded files and reloads the edited ones in place (see ResourceManager::ReloadChangedAssets), for development
+    bool m_hotReload{ false };
+    //the linked shader programs are kept there and loaded instead of compiled on the next runs (see GLSLProgram::EnableBinaryCache),
+    //empty turns it off
+    std::string m_shaderCachePath{ "ShaderCache" };
+    //the shader programs build on the driver's threads and are waited for when first used (see GLSLProgram::EnableParallelCompile)
+    bool m_parallelShaderCompile{ true };
+    //the startup jobs not done yet
+    JobCounter m_startupJobs;
+    StartupReport m_startupReport;
+    //prints m_startupReport once the first screen is entered
+    bool m_printStartupReport{ true };
     int m_screenHeight{ 500 };
     int m_screenWidth{ 500 };
     WindowCreationFlags m_windowFlags = WindowCreationFlags::NONE;
@@ -1,15 +1,221 @@
 #include "IOManager.h"
+#include "AssetMap.h"
+#include "AssetPack.h"
+#include "GameEngineErrors.h"
 
+#include <chrono>
 #include <fstream>
 #include <filesystem>
+#include <memory>
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
 
 // Namespace alias
 namespace fs = std::tr2::sys;
 
 namespace GameEngine
 {
+  namespace
+  {
+    //the mounted packs, the last one first. Only changed before the loads start, so the loader threads read it without a lock
+    std::vector<std::unique_ptr<AssetPack>>& GetPacks()
+    {
+      static std::vector<std::unique_ptr<AssetPack>> packs;
+      return packs;
+    }
+
+    const PackEntry* FindPacked(const std::string& _filePath, const AssetPack*& _pack)
+    {
+      for (const auto& pack : GetPacks())
+      {
+        if (const PackEntry* entry = pack->Find(_filePath))
+        {
+          _pack = pack.get();
+          return entry;
+        }
+      }
+      return nullptr;
+    }
+
+    //reads the file from the packs, false if it's not packed (or broken)
+    bool ReadPacked(const std::string& _filePath, std::vector<unsigned char>& _buffer)
+    {
+      const AssetPack* pack = nullptr;
+      const PackEntry* entry = FindPacked(_filePath, pack);
+      return entry != nullptr && pack->Read(*entry, _buffer);
+    }
+
+    //a read of a FileReadBatch, the OVERLAPPED comes first so the one of a completion is the read
+    struct PendingRead
+    {
+      OVERLAPPED overlapped;
+      HANDLE file{ INVALID_HANDLE_VALUE };
+      size_t index{ 0 };
+      std::vector<unsigned char> data;
+    };
+
+    //opens the file on the port and starts reading all of it, false if it can't (the file is closed then)
+    bool IssueRead(PendingRead& _read, const std::string& _filePath, HANDLE _port)
+    {
+      _read.file = CreateFileA(_filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+      if (_read.file == INVALID_HANDLE_VALUE)
+      {
+        return false;
+      }
+      LARGE_INTEGER size;
+      //one ReadFile reads at most 4GB, more than any asset
+      if (!GetFileSizeEx(_read.file, &size) || size.QuadPart > MAXDWORD || CreateIoCompletionPort(_read.file, _port, 0, 0) == nullptr)
+      {
+        CloseHandle(_read.file);
+        _read.file = INVALID_HANDLE_VALUE;
+        return false;
+      }
+      _read.data.resize(static_cast<size_t>(size.QuadPart));
+      ZeroMemory(&_read.overlapped, sizeof(OVERLAPPED));
+      if (_read.data.empty())
+      {
+        //there's nothing to read, the completion is posted right away
+        return PostQueuedCompletionStatus(_port, 0, 0, &_read.overlapped) != FALSE;
+      }
+      if (!ReadFile(_read.file, _read.data.data(), static_cast<DWORD>(_read.data.size()), nullptr, &_read.overlapped) &&
+        GetLastError() != ERROR_IO_PENDING)
+      {
+        CloseHandle(_read.file);
+        _read.file = INVALID_HANDLE_VALUE;
+        return false;
+      }
+      return true;
+    }
+
+    //a directory with watched files, ReadDirectoryChangesW writes the names of the changed files into buffer in the background
+    struct WatchedDirectory
+    {
+      OVERLAPPED overlapped;
+      HANDLE handle{ INVALID_HANDLE_VALUE };
+      std::string path;        ///< with a trailing slash, empty for the working directory
+      DWORD buffer[4096];      ///< FILE_NOTIFY_INFORMATION records, which are DWORD aligned
+    };
+
+    struct FileWatcher
+    {
+      bool enabled{ false };
+      std::vector<std::unique_ptr<WatchedDirectory>> directories; ///< they never move, the OS writes to them
+      AssetMap<std::string> files;    ///< by the hash of the normalized path (see AssetPack::NormalizePath), the path as it was watched
+      AssetMap<bool> directoryIds;    ///< the same for the watched directories
+      std::vector<std::pair<AssetId, std::chrono::steady_clock::time_point>> changes; ///< the changed files and their last write
+    };
+
+    FileWatcher& GetWatcher()
+    {
+      static FileWatcher watcher;
+      return watcher;
+    }
+
+    //starts the next read of the changes of the directory, false if it can't be watched anymore
+    bool WatchChanges(WatchedDirectory& _directory)
+    {
+      ZeroMemory(&_directory.overlapped, sizeof(OVERLAPPED));
+      return ReadDirectoryChangesW(_directory.handle, _directory.buffer, sizeof(_directory.buffer), FALSE,
+        FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE, nullptr, &_directory.overlapped, nullptr) != FALSE;
+    }
+
+    void CloseDirectory(WatchedDirectory& _directory)
+    {
+      //the OS may still write to the buffer until the cancelled read completed
+      CancelIo(_directory.handle);
+      DWORD numBytes = 0;
+      GetOverlappedResult(_directory.handle, &_directory.overlapped, &numBytes, TRUE);
+      CloseHandle(_directory.handle);
+      _directory.handle = INVALID_HANDLE_VALUE;
+    }
+
+    //marks the file changed (again), if it's watched
+    void AddChange(FileWatcher& _watcher, const std::string& _filePath, std::chrono::steady_clock::time_point _now)
+    {
+      const AssetId id = AssetIds::Hash(AssetPack::NormalizePath(_filePath));
+      if (_watcher.files.Find(id) == nullptr)
+      {
+        return;
+      }
+      for (auto& change : _watcher.changes)
+      {
+        if (change.first == id)
+        {
+          change.second = _now;
+          return;
+        }
+      }
+      _watcher.changes.emplace_back(id, _now);
+    }
+
+    //the changes the OS reported since the last read of the directory, or every watched file in it if there were too many to report
+    void ReadChanges(FileWatcher& _watcher, WatchedDirectory& _directory, DWORD _numBytes, std::chrono::steady_clock::time_point _now)
+    {
+      if (_numBytes == 0)
+      {
+        const AssetId directoryId = AssetIds::Hash(AssetPack::NormalizePath(_directory.path));
+        _watcher.files.ForEach([&](AssetId, std::string& _filePath)
+        {
+          const size_t slash = _filePath.find_last_of("/\\");
+          const std::string directory = slash != std::string::npos ? _filePath.substr(0, slash + 1) : std::string();
+          if (AssetIds::Hash(AssetPack::NormalizePath(directory)) == directoryId)
+          {
+            AddChange(_watcher, _filePath, _now);
+          }
+        });
+        return;
+      }
+      const unsigned char* record = reinterpret_cast<const unsigned char*>(_directory.buffer);
+      for (;;)
+      {
+        const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(record);
+        const int numChars = static_cast<int>(info->FileNameLength / sizeof(WCHAR));
+        char name[MAX_PATH * 3];
+        const int length = WideCharToMultiByte(CP_UTF8, 0, info->FileName, numChars, name, sizeof(name), nullptr, nullptr);
+        if (length > 0)
+        {
+          AddChange(_watcher, _directory.path + std::string(name, length), _now);
+        }
+        if (info->NextEntryOffset == 0)
+        {
+          break;
+        }
+        record += info->NextEntryOffset;
+      }
+    }
+  }
+
+  bool IOManager::MountPack(const std::string& _packPath)
+  {
+    std::unique_ptr<AssetPack> pack = std::make_unique<AssetPack>();
+    if (!pack->Open(_packPath))
+    {
+      return false;
+    }
+    GetPacks().insert(GetPacks().begin(), std::move(pack));
+    return true;
+  }
+
+  void IOManager::UnmountPacks()
+  {
+    GetPacks().clear();
+  }
+
+  bool IOManager::IsPacked(const std::string& _filePath)
+  {
+    const AssetPack* pack = nullptr;
+    return FindPacked(_filePath, pack) != nullptr;
+  }
+
   bool IOManager::ReadFileToBuffer(const std::string& _filePath, std::vector<unsigned char>& _buffer)
   {
+    if (ReadPacked(_filePath, _buffer))
+    {
+      return true;
+    }
     std::ifstream file(_filePath, std::ios::binary);
     if (file.fail())
     {
@@ -40,6 +246,12 @@ namespace GameEngine
 
   bool IOManager::ReadFileToBuffer(const std::string& _filePath, std::string& _buffer)
   {
+    std::vector<unsigned char> packed;
+    if (ReadPacked(_filePath, packed))
+    {
+      _buffer.assign(packed.begin(), packed.end());
+      return true;
+    }
     std::ifstream file(_filePath, std::ios::binary);
     if (file.fail())
     {
@@ -96,4 +308,309 @@ namespace GameEngine
   {
     return fs::create_directory(fs::path(_path));
   }
+
+  bool IOManager::IsNewerThan(const std::string& _filePath, const std::string& _otherPath)
+  {
+    if (IsPacked(_filePath))
+    {
+      return true;
+    }
+    std::error_code error;
+    auto fileTime = fs::last_write_time(fs::path(_filePath), error);
+    if (error)
+    {
+      return false;
+    }
+    auto otherTime = fs::last_write_time(fs::path(_otherPath), error);
+    return !error && fileTime >= otherTime;
+  }
+
+  bool IOManager::ReadFilesToBuffers(const std::vector<std::string>& _filePaths, std::vector<std::vector<unsigned char>>& _buffers)
+  {
+    //the packed files are in memory already, only the loose ones go to the batch
+    _buffers.assign(_filePaths.size(), std::vector<unsigned char>());
+    FileReadBatch batch;
+    std::vector<size_t> batchIndices;
+    for (size_t i = 0; i < _filePaths.size(); i++)
+    {
+      if (!ReadPacked(_filePaths[i], _buffers[i]))
+      {
+        batch.Add(_filePaths[i]);
+        batchIndices.push_back(i);
+      }
+    }
+    return batch.Run([&_buffers, &batchIndices](size_t _index, bool, std::vector<unsigned char>& _data)
+    {
+      _buffers[batchIndices[_index]].swap(_data);
+    });
+  }
+
+  void IOManager::EnableFileWatching(bool _enable)
+  {
+    FileWatcher& watcher = GetWatcher();
+    if (!_enable)
+    {
+      for (auto& directory : watcher.directories)
+      {
+        CloseDirectory(*directory);
+      }
+      watcher.directories.clear();
+      watcher.files.Clear();
+      watcher.directoryIds.Clear();
+      watcher.changes.clear();
+    }
+    watcher.enabled = _enable;
+  }
+
+  bool IOManager::IsWatchingFiles()
+  {
+    return GetWatcher().enabled;
+  }
+
+  void IOManager::WatchFile(const std::string& _filePath)
+  {
+    FileWatcher& watcher = GetWatcher();
+    if (!watcher.enabled || IsPacked(_filePath))
+    {
+      return;
+    }
+    std::string& watched = watcher.files[AssetIds::Hash(AssetPack::NormalizePath(_filePath))];
+    if (!watched.empty())
+    {
+      return;
+    }
+    watched = _filePath;
+
+    //one watch for all the files of a directory
+    const size_t slash = _filePath.find_last_of("/\\");
+    const std::string directoryPath = slash != std::string::npos ? _filePath.substr(0, slash + 1) : std::string();
+    bool& isWatched = watcher.directoryIds[AssetIds::Hash(AssetPack::NormalizePath(directoryPath))];
+    if (isWatched)
+    {
+      return;
+    }
+    isWatched = true;
+    std::unique_ptr<WatchedDirectory> directory = std::make_unique<WatchedDirectory>();
+    directory->path = directoryPath;
+    directory->handle = CreateFileA(directoryPath.empty() ? "." : directoryPath.c_str(), FILE_LIST_DIRECTORY,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (directory->handle == INVALID_HANDLE_VALUE)
+    {
+      return;
+    }
+    if (!WatchChanges(*directory))
+    {
+      CloseHandle(directory->handle);
+      return;
+    }
+    watcher.directories.push_back(std::move(directory));
+  }
+
+  void IOManager::PollChangedFiles(std::vector<std::string>& _changedFiles)
+  {
+    _changedFiles.clear();
+    FileWatcher& watcher = GetWatcher();
+    if (!watcher.enabled)
+    {
+      return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    for (auto& directory : watcher.directories)
+    {
+      if (directory->handle == INVALID_HANDLE_VALUE)
+      {
+        continue;
+      }
+      DWORD numBytes = 0;
+      if (!GetOverlappedResult(directory->handle, &directory->overlapped, &numBytes, FALSE))
+      {
+        if (GetLastError() == ERROR_IO_INCOMPLETE)
+        {
+          continue;
+        }
+        //a buffer overflow reports nothing: everything in the directory may have changed
+        numBytes = 0;
+      }
+      ReadChanges(watcher, *directory, numBytes, now);
+      if (!WatchChanges(*directory))
+      {
+        CloseHandle(directory->handle);
+        directory->handle = INVALID_HANDLE_VALUE;
+      }
+    }
+
+    //the files written in the last moment may still be written, e.g. saved as a temporary file and renamed
+    const auto settleTime = std::chrono::milliseconds(200);
+    for (size_t i = 0; i < watcher.changes.size();)
+    {
+      if (now - watcher.changes[i].second < settleTime)
+      {
+        i++;
+        continue;
+      }
+      _changedFiles.push_back(*watcher.files.Find(watcher.changes[i].first));
+      watcher.changes[i] = watcher.changes.back();
+      watcher.changes.pop_back();
+    }
+  }
+
+  bool MappedFile::Open(const std::string& _filePath)
+  {
+    Close();
+    const AssetPack* pack = nullptr;
+    const PackEntry* entry = FindPacked(_filePath, pack);
+    if (entry == nullptr)
+    {
+      return OpenLoose(_filePath);
+    }
+    FileSpan span;
+    if (pack->GetSpan(*entry, span))
+    {
+      m_data = span.data;
+      m_size = span.size;
+      return true;
+    }
+    if (!pack->Read(*entry, m_unpacked))
+    {
+      return false;
+    }
+    m_data = m_unpacked.data();
+    m_size = m_unpacked.size();
+    return true;
+  }
+
+  bool MappedFile::OpenLoose(const std::string& _filePath)
+  {
+    Close();
+    HANDLE file = CreateFileA(_filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+      return false;
+    }
+    m_file = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+      Close();
+      return false;
+    }
+    m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping == nullptr)
+    {
+      Close();
+      return false;
+    }
+    m_data = static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_data == nullptr)
+    {
+      Close();
+      return false;
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+    return true;
+  }
+
+  void MappedFile::Close()
+  {
+    //a packed file only points into the pack or m_unpacked
+    if (m_mapping != nullptr && m_data != nullptr)
+    {
+      UnmapViewOfFile(m_data);
+    }
+    m_data = nullptr;
+    if (m_mapping != nullptr)
+    {
+      CloseHandle(m_mapping);
+      m_mapping = nullptr;
+    }
+    m_unpacked = std::vector<unsigned char>();
+    if (m_file != nullptr)
+    {
+      CloseHandle(m_file);
+      m_file = nullptr;
+    }
+    m_size = 0;
+  }
+
+  size_t FileReadBatch::Add(const std::string& _filePath)
+  {
+    m_filePaths.push_back(_filePath);
+    return m_filePaths.size() - 1;
+  }
+
+  bool FileReadBatch::Run(const Callback& _onRead)
+  {
+    std::vector<unsigned char> none;
+    HANDLE port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+    if (port == nullptr)
+    {
+      for (size_t i = 0; i < m_filePaths.size(); i++)
+      {
+        _onRead(i, false, none);
+      }
+      return m_filePaths.empty();
+    }
+
+    //the reads in flight never move, the OS writes to their OVERLAPPED and buffer
+    std::unique_ptr<PendingRead[]> reads(new PendingRead[MAX_IN_FLIGHT]);
+    std::vector<PendingRead*> freeReads;
+    for (size_t i = 0; i < MAX_IN_FLIGHT; i++)
+    {
+      freeReads.push_back(&reads[i]);
+    }
+
+    bool success = true;
+    size_t next = 0;
+    size_t numInFlight = 0;
+    while (next < m_filePaths.size() || numInFlight > 0)
+    {
+      //keep the queue of the disk full
+      while (next < m_filePaths.size() && !freeReads.empty())
+      {
+        PendingRead* read = freeReads.back();
+        read->index = next++;
+        if (IssueRead(*read, m_filePaths[read->index], port))
+        {
+          freeReads.pop_back();
+          numInFlight++;
+        }
+        else
+        {
+          success = false;
+          _onRead(read->index, false, none);
+        }
+      }
+      if (numInFlight == 0)
+      {
+        break;
+      }
+
+      DWORD numBytes = 0;
+      ULONG_PTR key = 0;
+      OVERLAPPED* overlapped = nullptr;
+      const BOOL completed = GetQueuedCompletionStatus(port, &numBytes, &key, &overlapped, INFINITE);
+      if (overlapped == nullptr)
+      {
+        //the port itself failed, the reads still in flight can't be waited for
+        FatalError("Failed to wait for the file reads");
+      }
+      PendingRead* read = reinterpret_cast<PendingRead*>(overlapped);
+      CloseHandle(read->file);
+      read->file = INVALID_HANDLE_VALUE;
+      numInFlight--;
+
+      const bool readAll = completed && numBytes == read->data.size();
+      if (!readAll)
+      {
+        success = false;
+        read->data.clear();
+      }
+      _onRead(read->index, readAll, read->data);
+      read->data = std::vector<unsigned char>();
+      freeReads.push_back(read);
+    }
+    CloseHandle(port);
+    return success;
+  }
 }
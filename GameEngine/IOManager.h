@@ -1,17 +1,37 @@
 #pragma once
 
+#include <functional>
+#include <string>
 #include <vector>
 namespace GameEngine
 {
+  //read only bytes owned by something else (e.g. a MappedFile), valid as long as it is
+  struct FileSpan
+  {
+    const unsigned char* data{ nullptr };
+    size_t size{ 0 };
+
+    const unsigned char* begin() const noexcept { return data; }
+    const unsigned char* end() const noexcept { return data + size; }
+    bool empty() const noexcept { return size == 0; }
+  };
+
   struct DirEntry
   {
     std::string path;
     bool isDirectory;
   };
 
+  /** \brief Reads the files, from the mounted packs first (see MountPack) and from the disk otherwise */
   class IOManager
   {
   public:
+    //puts the pack in front of the loose files, the packs mounted last are searched first. Mount them before loading anything,
+    //the loader threads read them too. False if it's missing or broken
+    static bool MountPack(const std::string& _packPath);
+    static void UnmountPacks();
+    //checks if the file is in a mounted pack
+    static bool IsPacked(const std::string& _filePath);
     //read the file to the buffer ( a vector of uchars, like a c-string )
     static bool ReadFileToBuffer(const std::string& _filePath, std::vector<unsigned char>& _buffer);
     //read the file to the buffer ( a normal string )
@@ -21,6 +41,68 @@ namespace GameEngine
     static bool GetDirectoryEntries(const char* _path, std::vector<DirEntry>& _rvEntries);
     //creates a directory in the specified path
     static bool MakeDirectory(const char* _path);
+    //check if _filePath exists and was written after _otherPath (false if either is missing). A packed file is always newer, packs
+    //ship the cooked files without their sources
+    static bool IsNewerThan(const std::string& _filePath, const std::string& _otherPath);
+    //reads all the files at once (see FileReadBatch), _buffers gets them in the order of the paths. False if any failed, its buffer is empty
+    static bool ReadFilesToBuffers(const std::vector<std::string>& _filePaths, std::vector<std::vector<unsigned char>>& _buffers);
+
+    //the file watch service of the hot reloads (see ResourceManager::ReloadChangedAssets), off by default. Once it's on, the loaders
+    //register the files they read with WatchFile, and the OS reports the writes to their directories. Turning it off forgets the files
+    static void EnableFileWatching(bool _enable);
+    static bool IsWatchingFiles();
+    //watches the file if the service is on, a packed file can't change and isn't watched
+    static void WatchFile(const std::string& _filePath);
+    //gets the watched files written since the last poll, each once and as they were passed to WatchFile. A file is only reported
+    //once its writes stopped for a moment, an editor saving in steps reloads once
+    static void PollChangedFiles(std::vector<std::string>& _changedFiles);
+  };
+
+  //a file mapped read only into memory, its pages are only read from disk when they're touched
+  //a packed file points into the mapped pack instead, or is decompressed into the MappedFile if it's compressed
+  class MappedFile
+  {
+  public:
+    MappedFile() {}
+    ~MappedFile() { Close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& _filePath);
+    //maps the file on the disk, even if a pack has it
+    bool OpenLoose(const std::string& _filePath);
+    void Close();
+
+    const unsigned char* GetData() const noexcept { return m_data; }
+    size_t GetSize() const noexcept { return m_size; }
+    //the whole file, no copy, valid until the file is closed
+    FileSpan GetSpan() const noexcept { return FileSpan{ m_data, m_size }; }
+  private:
+    void* m_file{ nullptr };    ///< the file handle
+    void* m_mapping{ nullptr }; ///< the file mapping handle
+    const unsigned char* m_data{ nullptr };
+    size_t m_size{ 0 };
+    std::vector<unsigned char> m_unpacked; ///< a compressed packed file, decompressed
+  };
+
+  /** \brief Reads many whole files at once: all the reads are issued to the OS together (overlapped IO on a completion port) so the
+  * disk can order them, and each file is handed over as soon as it's read, in whatever order they complete */
+  class FileReadBatch
+  {
+  public:
+    //the reads issued at a time, each keeps a file open
+    static constexpr size_t MAX_IN_FLIGHT{ 32 };
+    //gets the index of the file in the batch, whether it was read and its bytes (empty if it wasn't), which it may take
+    typedef std::function<void(size_t _index, bool _success, std::vector<unsigned char>& _data)> Callback;
+
+    //adds a file to read, returns its index in the batch
+    size_t Add(const std::string& _filePath);
+    size_t GetSize() const noexcept { return m_filePaths.size(); }
+
+    //issues the reads and blocks until all of them completed, _onRead is called on this thread for each one. False if any failed
+    bool Run(const Callback& _onRead);
+  private:
+    std::vector<std::string> m_filePaths;
   };
 }
 
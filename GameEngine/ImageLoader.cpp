@@ -1,10 +1,41 @@
 #include "ImageLoader.h"
 #include "IOManager.h"
 #include "GameEngineErrors.h"
+#include "RenderState.h"
+#include "SamplerCache.h"
 #include <SOIL\SOIL.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
 namespace GameEngine
 {
+  namespace
+  {
+    //the parts of the DDS header the loader needs, as dword indices after the magic
+    enum : std::uint32_t
+    {
+      DDS_HEADER_DWORDS = 31,
+      DDS_HEIGHT = 2,
+      DDS_WIDTH = 3,
+      DDS_MIPMAP_COUNT = 6,
+      DDS_PIXEL_FORMAT_FLAGS = 19,
+      DDS_FOURCC = 20,
+      DDS_FLAG_MIPMAP_COUNT = 0x20000,
+      DDS_PIXEL_FORMAT_FOURCC = 0x4,
+      DXGI_FORMAT_BC1_UNORM = 71,
+      DXGI_FORMAT_BC3_UNORM = 77,
+      DXGI_FORMAT_BC7_UNORM = 98
+    };
+
+    constexpr std::uint32_t FourCC(char _a, char _b, char _c, char _d)
+    {
+      return std::uint32_t(std::uint8_t(_a)) | (std::uint32_t(std::uint8_t(_b)) << 8) | (std::uint32_t(std::uint8_t(_c)) << 16) |
+        (std::uint32_t(std::uint8_t(_d)) << 24);
+    }
+  }
+
   GLTexture ImageLoader::LoadPNG(const std::string& _filePath, bool _alpha)
   {
     //Create a GLTexture and initialize all its fields to 0
@@ -12,36 +43,247 @@ namespace GameEngine
 
     int width, height;
 
-    unsigned char* image = SOIL_load_image(_filePath.c_str(), &width, &height, 0, _alpha ? SOIL_LOAD_RGBA : SOIL_LOAD_RGB);
+    unsigned char* image = DecodeImage(_filePath, _alpha, width, height);
+
+    texture.id = UploadTexture(image, width, height, _alpha);
+    texture.sampler = SamplerCache::Get().GetTextureSampler(_alpha);
+    FreeImage(image);
+
+    texture.width = width;
+    texture.height = height;
+    texture.asset = AssetIds::Intern(_filePath);
 
+    //Return a copy of the texture data
+    return texture;
+  }
+  unsigned char* ImageLoader::DecodeImage(const std::string& _filePath, bool _alpha, int& _width, int& _height)
+  {
+    //decoded from the mapped file, so packed images load like loose ones (see IOManager::MountPack)
+    MappedFile file;
+    if (!file.Open(_filePath))
+    {
+      return nullptr;
+    }
+    return SOIL_load_image_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &_width, &_height, 0,
+      _alpha ? SOIL_LOAD_RGBA : SOIL_LOAD_RGB);
+  }
+  void ImageLoader::FreeImage(unsigned char* _pixels)
+  {
+    SOIL_free_image_data(_pixels);
+  }
+  GLuint ImageLoader::UploadTexture(const unsigned char* _pixels, int _width, int _height, bool _alpha)
+  {
     //Generate the openGL texture object
-    glGenTextures(1, &(texture.id));
+    GLuint id = 0;
+    glGenTextures(1, &id);
 
     //Bind the texture object
-    glBindTexture(GL_TEXTURE_2D, texture.id);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, id);
 
-    //Upload the pixels to the texture
-    glTexImage2D(GL_TEXTURE_2D, 0, _alpha ? GL_RGBA : GL_RGB, width, height, 0, _alpha ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, image);
+    //Allocate the immutable storage of the whole chain, then upload the pixels to the first level
+    glTexStorage2D(GL_TEXTURE_2D, GetNumMipLevels(_width, _height), _alpha ? GL_RGBA8 : GL_RGB8, _width, _height);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _width, _height, _alpha ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, _pixels);
     //Generate the mipmaps
     glGenerateMipmap(GL_TEXTURE_2D);
 
-    //Set some texture parameters
+    SetTextureParameters(_alpha);
+
+    //Unbind the texture
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+    return id;
+  }
+  void ImageLoader::UpdateTexture(GLuint _id, const unsigned char* _pixels, int _width, int _height, bool _alpha)
+  {
+    //the immutable storage stays, only its contents change
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, _id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _width, _height, _alpha ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, _pixels);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+  }
+  bool ImageLoader::ReadDDS(const std::string& _filePath, bool _alpha, CompressedImage& _image)
+  {
+    //mapped, only the blocks are copied out of the file
+    MappedFile file;
+    if (!file.Open(_filePath))
+    {
+      return false;
+    }
+    const FileSpan buffer = file.GetSpan();
+    if (buffer.size < 4 + DDS_HEADER_DWORDS * 4)
+    {
+      return false;
+    }
+    std::uint32_t header[DDS_HEADER_DWORDS];
+    std::uint32_t magic;
+    std::memcpy(&magic, buffer.data, 4);
+    std::memcpy(header, buffer.data + 4, sizeof(header));
+    if (magic != FourCC('D', 'D', 'S', ' ') || header[0] != DDS_HEADER_DWORDS * 4 || !(header[DDS_PIXEL_FORMAT_FLAGS] & DDS_PIXEL_FORMAT_FOURCC))
+    {
+      return false;
+    }
+
+    size_t offset = 4 + sizeof(header);
+    GLenum format = 0;
+    switch (header[DDS_FOURCC])
+    {
+    case FourCC('D', 'X', 'T', '1'):
+      format = _alpha ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+      break;
+    case FourCC('D', 'X', 'T', '5'):
+      format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+      break;
+    case FourCC('D', 'X', '1', '0'):
+    {
+      //the DXGI format is the first dword of the extended header
+      std::uint32_t dxgiFormat = 0;
+      if (buffer.size < offset + 20)
+      {
+        return false;
+      }
+      std::memcpy(&dxgiFormat, buffer.data + offset, 4);
+      offset += 20;
+      format = dxgiFormat == DXGI_FORMAT_BC1_UNORM ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT :
+        dxgiFormat == DXGI_FORMAT_BC3_UNORM ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT :
+        dxgiFormat == DXGI_FORMAT_BC7_UNORM ? GL_COMPRESSED_RGBA_BPTC_UNORM : 0;
+      break;
+    }
+    default:
+      break;
+    }
+    if (format == 0)
+    {
+      return false;
+    }
+
+    const size_t blockSize = (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) ? 8 : 16;
+    const std::uint32_t numLevels = (header[1] & DDS_FLAG_MIPMAP_COUNT) ? std::max(header[DDS_MIPMAP_COUNT], std::uint32_t(1)) : 1;
+    _image.format = format;
+    _image.width = static_cast<int>(header[DDS_WIDTH]);
+    _image.height = static_cast<int>(header[DDS_HEIGHT]);
+    _image.levelOffsets.assign(1, 0);
+    size_t size = 0;
+    for (std::uint32_t level = 0; level < numLevels; level++)
+    {
+      const size_t width = std::max(_image.width >> level, 1);
+      const size_t height = std::max(_image.height >> level, 1);
+      size += ((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+      _image.levelOffsets.push_back(size);
+    }
+    if (_image.width <= 0 || _image.height <= 0 || buffer.size < offset + size)
+    {
+      return false;
+    }
+    _image.data.assign(buffer.begin() + offset, buffer.begin() + offset + size);
+    return true;
+  }
+  GLuint ImageLoader::UploadCompressed(const CompressedImage& _image, bool _alpha)
+  {
+    GLuint id = 0;
+    glGenTextures(1, &id);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, id);
+
+    //a file may stop its chain early, the immutable storage only has the levels it has, so the texture is complete with them
+    const GLint numLevels = static_cast<GLint>(_image.levelOffsets.size()) - 1;
+    glTexStorage2D(GL_TEXTURE_2D, numLevels, _image.format, _image.width, _image.height);
+    for (GLint level = 0; level < numLevels; level++)
+    {
+      glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, std::max(_image.width >> level, 1), std::max(_image.height >> level, 1), _image.format,
+        static_cast<GLsizei>(_image.levelOffsets[level + 1] - _image.levelOffsets[level]), _image.data.data() + _image.levelOffsets[level]);
+    }
+    SetTextureParameters(_alpha);
+
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+    return id;
+  }
+  GLTexture ImageLoader::LoadDDS(const std::string& _filePath, bool _alpha)
+  {
+    CompressedImage image;
+    if (!ReadDDS(_filePath, _alpha, image))
+    {
+      FatalError("Failed to load the compressed texture " + _filePath);
+    }
+    GLTexture texture = {};
+    texture.id = UploadCompressed(image, _alpha);
+    texture.sampler = SamplerCache::Get().GetTextureSampler(_alpha);
+    texture.width = image.width;
+    texture.height = image.height;
+    texture.asset = AssetIds::Intern(_filePath);
+    return texture;
+  }
+  GLsizei ImageLoader::GetNumMipLevels(int _width, int _height)
+  {
+    GLsizei levels = 1;
+    for (int size = std::max(_width, _height); size > 1; size /= 2)
+    {
+      levels++;
+    }
+    return levels;
+  }
+  void ImageLoader::SetTextureParameters(bool _alpha)
+  {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _alpha ? GL_CLAMP_TO_EDGE : GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _alpha ? GL_CLAMP_TO_EDGE : GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  }
+  std::vector<GLTexture> ImageLoader::LoadTextureArray(const std::vector<std::string>& _filePaths, bool _alpha)
+  {
+    std::vector<GLTexture> layers;
+    if (_filePaths.empty())
+    {
+      return layers;
+    }
 
-    //Unbind the texture
-    glBindTexture(GL_TEXTURE_2D, 0);
-    SOIL_free_image_data(image);
+    GLuint arrayID = 0;
+    glGenTextures(1, &arrayID);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D_ARRAY, arrayID);
 
-    texture.width = width;
-    texture.height = height;
-    texture.filePath = _filePath;
+    int arrayWidth = 0, arrayHeight = 0;
+    for (size_t i = 0; i < _filePaths.size(); i++)
+    {
+      int width, height;
+      unsigned char* image = DecodeImage(_filePaths[i], _alpha, width, height);
+      if (image == nullptr)
+      {
+        FatalError("Failed to load " + _filePaths[i] + " into a texture array");
+      }
 
-    //Return a copy of the texture data
-    return texture;
+      if (i == 0)
+      {
+        //the first image decides the size of all the layers
+        arrayWidth = width;
+        arrayHeight = height;
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, GetNumMipLevels(arrayWidth, arrayHeight), _alpha ? GL_RGBA8 : GL_RGB8, arrayWidth, arrayHeight,
+          static_cast<GLsizei>(_filePaths.size()));
+      }
+      else if (width != arrayWidth || height != arrayHeight)
+      {
+        FatalError("Texture " + _filePaths[i] + " doesn't match the size of the texture array it's packed in");
+      }
+
+      glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(i), width, height, 1, _alpha ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, image);
+      FreeImage(image);
+
+      GLTexture texture;
+      texture.id = arrayID;
+      texture.layer = static_cast<int>(i);
+      texture.width = width;
+      texture.height = height;
+      texture.asset = AssetIds::Intern(_filePaths[i]);
+      texture.sampler = SamplerCache::Get().GetTextureSampler(_alpha);
+      layers.push_back(texture);
+    }
+
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, _alpha ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, _alpha ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+
+    return layers;
   }
+
   GLCubemap ImageLoader::LoadCubemap(const std::string& _directory, const std::string& _posXFilename, const std::string& _negXFilename,
     const std::string& _posYFilename, const std::string& _negYFilename, const std::string& _posZFilename, const std::string& _negZFilename)
   {
@@ -62,19 +304,24 @@ namespace GameEngine
     int width, height;
     unsigned char* image;
 
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubeMap.id);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_CUBE_MAP, cubeMap.id);
 
     for (GLuint i = 0; i < 6; i++)
     {
-      image = SOIL_load_image((_directory + faces.at(i)).c_str(), &width, &height, 0, SOIL_LOAD_RGB);
+      image = DecodeImage(_directory + faces.at(i), false, width, height);
 
-      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-      SOIL_free_image_data(image);
+      if (i == 0)
+      {
+        //the faces are square and all of one size, the first one allocates the storage of all of them
+        glTexStorage2D(GL_TEXTURE_CUBE_MAP, 1, GL_RGB8, width, height);
+      }
+      glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, image);
+      FreeImage(image);
 
       GLTexture texture;
       texture.width = width;
       texture.height = height;
-      texture.filePath = _directory + faces.at(i);
+      texture.asset = AssetIds::Intern(_directory + faces.at(i));
 
       cubeMap.textures.at(i) = texture;
     }
@@ -84,7 +331,13 @@ namespace GameEngine
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_CUBE_MAP, 0);
+
+    SamplerDesc desc;
+    desc.wrap = GL_CLAMP_TO_EDGE;
+    desc.minFilter = GL_LINEAR;
+    desc.anisotropic = false;
+    cubeMap.sampler = SamplerCache::Get().GetSampler(desc);
 
     return cubeMap;
   }
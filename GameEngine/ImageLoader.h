@@ -2,13 +2,43 @@
 
 #include "GLTexture.h"
 #include <string>
+#include <vector>
 namespace GameEngine
 {
+  //a block compressed image with its mip chain, as read from a DDS file
+  struct CompressedImage
+  {
+    GLenum format{ 0 }; ///< GL_COMPRESSED_RGB(A)_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT or GL_COMPRESSED_RGBA_BPTC_UNORM
+    int width{ 0 };
+    int height{ 0 };
+    std::vector<unsigned char> data;  ///< the blocks of all the levels, the largest first
+    std::vector<size_t> levelOffsets; ///< where the levels start in data, one more at the end
+  };
+
   class ImageLoader
   {
   public:
     //png image loader
     static GLTexture LoadPNG(const std::string& _filePath, bool _alpha);
+    //decodes the image without touching GL (safe on any thread), nullptr if it fails. Free the pixels with FreeImage
+    static unsigned char* DecodeImage(const std::string& _filePath, bool _alpha, int& _width, int& _height);
+    static void FreeImage(unsigned char* _pixels);
+    //uploads decoded pixels to a new mipmapped texture, on the GL thread
+    static GLuint UploadTexture(const unsigned char* _pixels, int _width, int _height, bool _alpha);
+    //replaces the pixels of a texture from UploadTexture with ones of the same size and regenerates its mipmaps, the id stays the same
+    static void UpdateTexture(GLuint _id, const unsigned char* _pixels, int _width, int _height, bool _alpha);
+    //sets the wrapping and filtering of the bound GL_TEXTURE_2D, the same for every loaded texture (and its SamplerCache::GetTextureSampler)
+    static void SetTextureParameters(bool _alpha);
+    //the levels of a full mip chain, for the immutable storage
+    static GLsizei GetNumMipLevels(int _width, int _height);
+    //reads a DDS file with BC1 (DXT1), BC3 (DXT5) or BC7 (DX10 header) blocks, no GL involved. False for other formats or broken files
+    static bool ReadDDS(const std::string& _filePath, bool _alpha, CompressedImage& _image);
+    //uploads the compressed levels as they are, no mipmaps are generated
+    static GLuint UploadCompressed(const CompressedImage& _image, bool _alpha);
+    //ReadDDS and UploadCompressed, a fatal error if the file can't be read
+    static GLTexture LoadDDS(const std::string& _filePath, bool _alpha);
+    //loads all the images (which must have the same size) into the layers of one GL_TEXTURE_2D_ARRAY
+    static std::vector<GLTexture> LoadTextureArray(const std::vector<std::string>& _filePaths, bool _alpha);
     static GLCubemap LoadCubemap(const std::string& _directory,
       const std::string& _posXFilename,
       const std::string& _negXFilename,
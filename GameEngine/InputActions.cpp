@@ -0,0 +1,146 @@
+#include "InputActions.h"
+
+#include <SDL\SDL_events.h>
+#include <algorithm>
+#include <chrono>
+
+namespace GameEngine
+{
+  std::int64_t InputEventQueue::Now()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  void InputEventQueue::Record(const SDL_Event& _event)
+  {
+    InputEvent event;
+    event.timestamp = Now();
+    switch (_event.type)
+    {
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+      if (_event.key.repeat != 0)
+      {
+        return;
+      }
+      event.key = _event.key.keysym.sym;
+      event.down = _event.type == SDL_KEYDOWN;
+      break;
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+      event.key = _event.button.button;
+      event.down = _event.type == SDL_MOUSEBUTTONDOWN;
+      break;
+    default:
+      return;
+    }
+    Push(event);
+  }
+
+  void InputEventQueue::Push(const InputEvent& _event)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_count == CAPACITY)
+    {
+      m_head = (m_head + 1) % CAPACITY;
+      m_count--;
+      m_numDropped++;
+    }
+    m_events[(m_head + m_count) % CAPACITY] = _event;
+    m_count++;
+  }
+
+  bool InputEventQueue::Pop(std::int64_t _until, InputEvent& _event)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_count == 0 || m_events[m_head].timestamp > _until)
+    {
+      return false;
+    }
+    _event = m_events[m_head];
+    m_head = (m_head + 1) % CAPACITY;
+    m_count--;
+    return true;
+  }
+
+  void InputEventQueue::Clear()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_head = 0;
+    m_count = 0;
+  }
+
+  void InputActions::Bind(ActionID _action, KeyID _key)
+  {
+    if (_action >= m_actions.size())
+    {
+      m_actions.resize(_action + 1);
+    }
+    Binding binding;
+    binding.key = _key;
+    binding.action = _action;
+    m_bindings.push_back(binding);
+  }
+
+  void InputActions::Unbind(ActionID _action)
+  {
+    m_bindings.erase(std::remove_if(m_bindings.begin(), m_bindings.end(), [_action](const Binding& _binding)
+    {
+      return _binding.action == _action;
+    }), m_bindings.end());
+    if (_action < m_actions.size())
+    {
+      m_actions[_action] = ActionState();
+    }
+  }
+
+  void InputActions::ClearBindings()
+  {
+    m_bindings.clear();
+    m_actions.clear();
+  }
+
+  void InputActions::BeginTick(InputEventQueue& _queue, std::int64_t _until)
+  {
+    //the edges are the tick's own, what's held carries over
+    for (ActionState& action : m_actions)
+    {
+      action.numPresses = 0;
+      action.numReleases = 0;
+      action.pressTime = 0;
+    }
+    InputEvent event;
+    while (_queue.Pop(_until, event))
+    {
+      Apply(event);
+    }
+  }
+
+  void InputActions::Apply(const InputEvent& _event)
+  {
+    for (Binding& binding : m_bindings)
+    {
+      //a key already down (e.g. it was held when the screen bound it) isn't pressed twice
+      if (binding.key != _event.key || binding.down == _event.down)
+      {
+        continue;
+      }
+      binding.down = _event.down;
+      ActionState& action = m_actions[binding.action];
+      if (_event.down)
+      {
+        if (action.numKeysDown++ == 0)
+        {
+          if (action.numPresses++ == 0)
+          {
+            action.pressTime = _event.timestamp;
+          }
+        }
+      }
+      else if (--action.numKeysDown == 0)
+      {
+        action.numReleases++;
+      }
+    }
+  }
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "InputManager.h"
+
+union SDL_Event;
+
+namespace GameEngine
+{
+  using ActionID = unsigned int;
+
+  //a key or a mouse button going down or up, when SDL got it
+  struct InputEvent
+  {
+    std::int64_t timestamp{ 0 }; ///< nanoseconds, see InputEventQueue::Now
+    KeyID key{ 0 };              ///< an SDL key code or mouse button, as for the InputManager
+    bool down{ false };
+  };
+
+  /** \brief The key and mouse button events in the order they came, recorded by IMainGame as SDL takes them in (an event watch, so
+  * whichever screen polls the events) and consumed a tick at a time by InputActions. A fixed ring: when it's full the oldest event
+  * is dropped */
+  class InputEventQueue
+  {
+  public:
+    static constexpr size_t CAPACITY{ 256 };
+
+    //the clock of the timestamps, in nanoseconds
+    static std::int64_t Now();
+
+    //records the key and mouse button events, the others are ignored. The repeats of a held key aren't events
+    void Record(const SDL_Event& _event);
+    void Push(const InputEvent& _event);
+    //takes the oldest event if it happened at or before _until, false otherwise
+    bool Pop(std::int64_t _until, InputEvent& _event);
+    void Clear();
+
+    //the events dropped because the ring was full
+    std::uint64_t GetNumDropped() const noexcept { return m_numDropped; }
+
+  private:
+    InputEvent m_events[CAPACITY];
+    size_t m_head{ 0 };  ///< the oldest event
+    size_t m_count{ 0 };
+    std::uint64_t m_numDropped{ 0 };
+    std::mutex m_mutex;  ///< SDL calls the event watch on the thread which pushes the event
+  };
+
+  /** \brief Maps keys to the actions of the game (e.g. jump, shoot) and keeps their state per simulation tick. Every tick takes the
+  * events of the queue up to the real time it simulates (see IMainGame::Run), so a key tapped between two ticks is still pressed in
+  * one of them even if it's up again by the end of it, and the ticks of a frame which catches up get the events in the order
+  * they came. Several keys can be bound to an action, it's down while any of them is */
+  class InputActions
+  {
+  public:
+    void Bind(ActionID _action, KeyID _key);
+    void Unbind(ActionID _action);
+    void ClearBindings();
+
+    //consumes the events up to _until into the state of the actions, at the start of a tick
+    void BeginTick(InputEventQueue& _queue, std::int64_t _until);
+
+    //the action is held at the end of the tick's events
+    bool IsDown(ActionID _action) const noexcept { return _action < m_actions.size() && m_actions[_action].numKeysDown > 0; }
+    //the action went down during the tick, even if it's up again
+    bool WasPressed(ActionID _action) const noexcept { return GetNumPresses(_action) > 0; }
+    //the action went up during the tick
+    bool WasReleased(ActionID _action) const noexcept { return _action < m_actions.size() && m_actions[_action].numReleases > 0; }
+    //the times the action went down during the tick
+    int GetNumPresses(ActionID _action) const noexcept { return _action < m_actions.size() ? m_actions[_action].numPresses : 0; }
+    //when the action first went down during the tick (see InputEventQueue::Now), 0 if it didn't
+    std::int64_t GetPressTime(ActionID _action) const noexcept { return _action < m_actions.size() ? m_actions[_action].pressTime : 0; }
+
+  private:
+    struct Binding
+    {
+      KeyID key{ 0 };
+      ActionID action{ 0 };
+      bool down{ false };
+    };
+    struct ActionState
+    {
+      int numKeysDown{ 0 };
+      int numPresses{ 0 };
+      int numReleases{ 0 };
+      std::int64_t pressTime{ 0 };
+    };
+
+    void Apply(const InputEvent& _event);
+
+    std::vector<Binding> m_bindings;
+    std::vector<ActionState> m_actions; ///< by id
+  };
+}
@@ -1,5 +1,7 @@
 #include "InputManager.h"
 
+#include <cstring>
+
 namespace GameEngine
 {
   InputManager::InputManager()
@@ -13,25 +15,19 @@ namespace GameEngine
 
   void InputManager::Update()
   {
-    //loop through key map using a for-each loop and copy it over to m_previousKeyMap
-    for (auto& it : m_keyMap)
-    {
-      //use .first to access the first element of the keymap (uint), and .second to access the second (bool)
-      m_previousKeyMap[it.first] = it.second;
-    }
+    //the state of this frame becomes the previous one, a copy of a few words
+    std::memcpy(m_previousKeys, m_keys, sizeof(m_keys));
+    std::memcpy(m_previousMouseButtons, m_mouseButtons, sizeof(m_mouseButtons));
   }
 
   void InputManager::PressKey(KeyID _keyID)
   {
-    // Here we are treating _keyMap as an associative array.
-    // if keyID doesn't already exist in _keyMap, it will get added
-    m_keyMap[_keyID] = true;
+    SetKeyState(_keyID, true);
   }
   void InputManager::ReleaseKey(KeyID _keyID)
   {
-    // Here we are treating _keyMap as an associative array.
     // switch the pressed button from true (being pressed) to false (released)
-    m_keyMap[_keyID] = false;
+    SetKeyState(_keyID, false);
   }
   void InputManager::SetMouseCoords(float _x, float _y)
   {
@@ -49,50 +45,63 @@ namespace GameEngine
     m_mouseWheel.y = _yVal;
   }
 
-  bool InputManager::IsKeyDown(KeyID _keyID)
+  bool InputManager::IsKeyDown(KeyID _keyID) const
   {
-    // We dont want to use the associative array approach here
-    // because we don't want to create a key if it doesnt exist.
-    // So we do it manually
-    auto it = m_keyMap.find(_keyID);
-    if (it != m_keyMap.end())
-    {
-      // Found the key
-      return it->second;
-    }
-    else
-    {
-      // Didn't find the key
-      return false;
-    }
+    return IsSet(m_keys, m_mouseButtons, _keyID);
   }
 
-  bool InputManager::IsKeyPressed(KeyID _keyID)
+  bool InputManager::IsKeyPressed(KeyID _keyID) const
   {
     //check if it was pressed this frame, and wasn't pressed last frame
-    if (IsKeyDown(_keyID) == true && wasKeyDown(_keyID) == false)
+    return IsKeyDown(_keyID) && !wasKeyDown(_keyID);
+  }
+
+  bool InputManager::wasKeyDown(KeyID _keyID) const
+  {
+    return IsSet(m_previousKeys, m_previousMouseButtons, _keyID);
+  }
+
+  int InputManager::GetKeyBit(KeyID _keyID) noexcept
+  {
+    if (_keyID & SDLK_SCANCODE_MASK)
     {
-      return true;
+      //the keys without a character are their scancode with the mask
+      const KeyID scancode = _keyID & ~static_cast<KeyID>(SDLK_SCANCODE_MASK);
+      return scancode < MAX_SCANCODES ? static_cast<int>(MAX_CHARACTER_KEYS + scancode) : -1;
     }
-    return false;
+    return _keyID < MAX_CHARACTER_KEYS ? static_cast<int>(_keyID) : -1;
   }
 
-  bool InputManager::wasKeyDown(KeyID _keyID)
+  void InputManager::SetKeyState(KeyID _keyID, bool _isDown)
   {
-    // We dont want to use the associative array approach here
-    // because we don't want to create a key if it doesnt exist.
-    // So we do it manually
-    auto it = m_previousKeyMap.find(_keyID);
-    if (it != m_previousKeyMap.end())
+    if (_keyID < MAX_MOUSE_BUTTONS)
+    {
+      m_mouseButtons[_keyID] = _isDown;
+      return;
+    }
+    const int bit = GetKeyBit(_keyID);
+    if (bit == -1)
+    {
+      return;
+    }
+    const std::uint64_t mask = std::uint64_t(1) << (bit & 63);
+    if (_isDown)
     {
-      // Found the key
-      return it->second;
+      m_keys[bit >> 6] |= mask;
     }
     else
     {
-      // Didn't find the key
-      return false;
+      m_keys[bit >> 6] &= ~mask;
     }
   }
-}
 
+  bool InputManager::IsSet(const std::uint64_t* _keys, const bool* _mouseButtons, KeyID _keyID) noexcept
+  {
+    if (_keyID < MAX_MOUSE_BUTTONS)
+    {
+      return _mouseButtons[_keyID];
+    }
+    const int bit = GetKeyBit(_keyID);
+    return bit != -1 && ((_keys[bit >> 6] >> (bit & 63)) & 1) != 0;
+  }
+}
@@ -1,11 +1,12 @@
 #pragma once
-#include <unordered_map>
+#include <SDL\SDL_keycode.h>
+#include <cstdint>
 #include <glm\glm.hpp>
 
 namespace GameEngine
 {
-  // Input manager stores a key map that maps SDL_Keys to booleans.
-  // If the value in the key map is true, then the key is pressed.
+  // Input manager stores the state of the SDL keys and mouse buttons in bitsets.
+  // If the bit of a key is set, then the key is pressed.
   // Otherwise, it is released.
 
   using KeyID = unsigned int;
@@ -13,6 +14,12 @@ namespace GameEngine
   class InputManager
   {
   public:
+    //the ids below it are the mouse buttons (SDL_BUTTON_LEFT ...), no key code is that low
+    static constexpr KeyID MAX_MOUSE_BUTTONS{ 8 };
+    //the key codes of the characters below it have a bit, the others (e.g. the arrows, SDLK_SCANCODE_MASK) have the one of their scancode
+    static constexpr KeyID MAX_CHARACTER_KEYS{ 512 };
+    static constexpr KeyID MAX_SCANCODES{ SDL_NUM_SCANCODES };
+
     InputManager();
     ~InputManager();
     //update the key map
@@ -25,10 +32,10 @@ namespace GameEngine
     void SetMouseWheel(int32_t _xVal, int32_t _yVal);
 
     ///return true if the key is held down
-    bool IsKeyDown(KeyID _keyID);
+    bool IsKeyDown(KeyID _keyID) const;
 
     ///returns true if the key is pressed this frame
-    bool IsKeyPressed(KeyID _keyID);
+    bool IsKeyPressed(KeyID _keyID) const;
 
     //getters
     glm::vec2 GetMouseCoords()         const noexcept { return m_mouseCoords; }
@@ -36,10 +43,20 @@ namespace GameEngine
     glm::ivec2 GetMouseWheelValue()     const noexcept { return m_mouseWheel;  }
 
   private:
-    bool wasKeyDown(KeyID _keyID);
+    static constexpr unsigned int NUM_KEY_WORDS{ (MAX_CHARACTER_KEYS + MAX_SCANCODES + 63) / 64 };
+
+    bool wasKeyDown(KeyID _keyID) const;
+    //the bit of a key code in the key sets, -1 for a key without one (a character code past MAX_CHARACTER_KEYS)
+    static int GetKeyBit(KeyID _keyID) noexcept;
+    //sets or clears the bit of the key or the mouse button
+    void SetKeyState(KeyID _keyID, bool _isDown);
+    //the bit of the key or the mouse button in a pair of sets
+    static bool IsSet(const std::uint64_t* _keys, const bool* _mouseButtons, KeyID _keyID) noexcept;
 
-    std::unordered_map<KeyID, bool> m_keyMap;
-    std::unordered_map<KeyID, bool> m_previousKeyMap;
+    std::uint64_t m_keys[NUM_KEY_WORDS]{};
+    std::uint64_t m_previousKeys[NUM_KEY_WORDS]{};
+    bool m_mouseButtons[MAX_MOUSE_BUTTONS]{};
+    bool m_previousMouseButtons[MAX_MOUSE_BUTTONS]{};
 
     glm::vec2 m_mouseCoords{ 0.0f, 0.0f };
     glm::vec2 m_relativeMouseMotion{ 0.0f, 0.0f };
@@ -0,0 +1,195 @@
+#include "InstanceCuller.h"
+#include "FrameStats.h"
+#include "HiZBuffer.h"
+
+#include <algorithm>
+#include <string>
+
+namespace GameEngine
+{
+  namespace
+  {
+    //the threads of a work group, every thread tests one instance for one mesh
+    constexpr GLuint CULL_GROUP_SIZE = 64;
+  }
+
+  const char* INSTANCE_CULL_COMP_SRC = R"(#version 430 core
+layout (local_size_x = 64) in;
+
+struct CullMesh
+{
+    vec4 boundingSphere;
+    mat4 baseModelMatrix;
+};
+
+layout (std430, binding = 0) readonly buffer Instances { mat4 instances[]; };
+layout (std430, binding = 1) writeonly buffer Visible { mat4 visible[]; };
+//5 uints for every mesh, the layout of DrawElementsIndirectCommand, the second is the instance count
+layout (std430, binding = 2) buffer Commands { uint commands[]; };
+layout (std430, binding = 3) readonly buffer Meshes { CullMesh meshes[]; };
+
+uniform int numInstances;
+uniform int meshStride;
+uniform vec4 frustumPlanes[6];
+//the depth pyramid of the last frame (see HiZBuffer) and the view projection it was drawn with
+uniform int useOcclusion;
+uniform mat4 occlusionViewProjection;
+uniform sampler2D hiZ;
+uniform vec2 hiZSize;
+uniform int hiZLevels;
+
+//whether the box around the sphere is behind the farthest depth of the texels it covers
+bool IsOccluded(vec3 center, float radius)
+{
+    vec2 minUV = vec2(1.0);
+    vec2 maxUV = vec2(0.0);
+    float nearestDepth = 1.0;
+    for (int i = 0; i < 8; i++)
+    {
+        vec3 corner = center + radius * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip = occlusionViewProjection * vec4(corner, 1.0);
+        //reaches behind the camera, it can't be projected
+        if (clip.w <= 0.0)
+        {
+            return false;
+        }
+        vec3 ndc = clip.xyz / clip.w;
+        minUV = min(minUV, ndc.xy * 0.5 + 0.5);
+        maxUV = max(maxUV, ndc.xy * 0.5 + 0.5);
+        nearestDepth = min(nearestDepth, ndc.z * 0.5 + 0.5);
+    }
+    minUV = clamp(minUV, vec2(0.0), vec2(1.0));
+    maxUV = clamp(maxUV, vec2(0.0), vec2(1.0));
+    //the level where the rectangle spans 2 texels at most, its 4 corners cover it
+    vec2 size = (maxUV - minUV) * hiZSize;
+    float level = clamp(ceil(log2(max(max(size.x, size.y), 1.0))), 0.0, float(hiZLevels - 1));
+    float depth = max(max(textureLod(hiZ, minUV, level).r, textureLod(hiZ, vec2(maxUV.x, minUV.y), level).r),
+        max(textureLod(hiZ, vec2(minUV.x, maxUV.y), level).r, textureLod(hiZ, maxUV, level).r));
+    return nearestDepth > depth;
+}
+
+void main()
+{
+    uint instance = gl_GlobalInvocationID.x;
+    uint mesh = gl_GlobalInvocationID.y;
+    if (instance >= uint(numInstances))
+    {
+        return;
+    }
+    //the same model matrix the instanced vertex shaders use
+    mat4 model = meshes[mesh].baseModelMatrix * instances[instance];
+    vec3 center = (model * vec4(meshes[mesh].boundingSphere.xyz, 1.0)).xyz;
+    float scale = max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+    float radius = meshes[mesh].boundingSphere.w * scale;
+    for (int i = 0; i < 6; i++)
+    {
+        if (dot(frustumPlanes[i].xyz, center) + frustumPlanes[i].w < -radius)
+        {
+            return;
+        }
+    }
+    if (useOcclusion != 0 && IsOccluded(center, radius))
+    {
+        return;
+    }
+    uint slot = atomicAdd(commands[mesh * 5u + 1u], 1u);
+    visible[mesh * uint(meshStride) + slot] = instances[instance];
+})";
+
+  bool InstanceCuller::IsSupported()
+  {
+    return GLEW_VERSION_4_3 != 0;
+  }
+
+  void InstanceCuller::Init()
+  {
+    m_program.CompileComputeShaderFromSource(INSTANCE_CULL_COMP_SRC);
+    m_numInstancesUniform = m_program.GetUniform("numInstances");
+    m_meshStrideUniform = m_program.GetUniform("meshStride");
+    m_frustumPlanesUniform = m_program.GetUniform("frustumPlanes");
+    m_useOcclusionUniform = m_program.GetUniform("useOcclusion");
+    m_occlusionViewProjectionUniform = m_program.GetUniform("occlusionViewProjection");
+    m_hiZUniform = m_program.GetUniform("hiZ");
+    m_hiZSizeUniform = m_program.GetUniform("hiZSize");
+    m_hiZLevelsUniform = m_program.GetUniform("hiZLevels");
+    glGenBuffers(1, &m_outputBuffer);
+    glGenBuffers(1, &m_commandBuffer);
+    glGenBuffers(1, &m_meshBuffer);
+  }
+
+  void InstanceCuller::Dispose()
+  {
+    m_program.Dispose();
+    if (m_outputBuffer != 0)
+    {
+      glDeleteBuffers(1, &m_outputBuffer);
+      glDeleteBuffers(1, &m_commandBuffer);
+      glDeleteBuffers(1, &m_meshBuffer);
+      m_outputBuffer = 0;
+      m_commandBuffer = 0;
+      m_meshBuffer = 0;
+    }
+    m_meshStride = 0;
+    m_numMeshes = 0;
+  }
+
+  void InstanceCuller::Cull(const std::vector<Mesh>& _meshes, GLuint _instanceBuffer, GLuint _numInstances, const std::array<glm::vec4, 6>& _frustumPlanes)
+  {
+    const GLuint numMeshes = static_cast<GLuint>(_meshes.size());
+    if (_numInstances > m_meshStride || numMeshes != m_numMeshes)
+    {
+      //grows by doubling like the instance buffer of the model, the regions move so all of it is reallocated
+      m_meshStride = std::max(_numInstances, m_meshStride * 2);
+      m_numMeshes = numMeshes;
+      glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_outputBuffer);
+      glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(m_numMeshes) * m_meshStride * sizeof(glm::mat4), nullptr, GL_DYNAMIC_COPY);
+    }
+
+    //the counts start at 0 every cull, the shader adds the visible instances
+    m_commands.resize(numMeshes);
+    m_cullMeshes.resize(numMeshes);
+    for (GLuint i = 0; i < numMeshes; i++)
+    {
+      m_commands[i] = { _meshes[i].GetNumIndices(), 0, 0, 0, i * m_meshStride };
+      m_cullMeshes[i] = { _meshes[i].GetBoundingSphere(), _meshes[i].GetBaseModelMatrix() };
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_commandBuffer);
+    FrameStats::Get().Add(STAT_BYTES_UPLOADED, m_commands.size() * sizeof(DrawElementsIndirectCommand) + m_cullMeshes.size() * sizeof(CullMesh));
+    glBufferData(GL_SHADER_STORAGE_BUFFER, m_commands.size() * sizeof(DrawElementsIndirectCommand), m_commands.data(), GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_meshBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, m_cullMeshes.size() * sizeof(CullMesh), m_cullMeshes.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    if (_numInstances == 0 || numMeshes == 0)
+    {
+      return;
+    }
+
+    m_program.Use();
+    m_program.UploadValue(m_numInstancesUniform, static_cast<int>(_numInstances));
+    m_program.UploadValue(m_meshStrideUniform, static_cast<int>(m_meshStride));
+    m_program.UploadValues(m_frustumPlanesUniform, _frustumPlanes.data(), static_cast<GLsizei>(_frustumPlanes.size()));
+    //a pyramid not built yet (the first frame, after a resize) hides nothing
+    const bool useOcclusion = m_hiZ != nullptr && m_hiZ->IsBuilt();
+    m_program.UploadValue(m_useOcclusionUniform, useOcclusion ? 1 : 0);
+    if (useOcclusion)
+    {
+      const GLTexture& hiZ = m_hiZ->GetTexture();
+      m_program.UploadValue(m_occlusionViewProjectionUniform, m_hiZ->GetViewProjection());
+      m_program.UploadValue(m_hiZUniform, 0, hiZ);
+      m_program.UploadValue(m_hiZSizeUniform, glm::vec2(hiZ.width, hiZ.height));
+      m_program.UploadValue(m_hiZLevelsUniform, static_cast<int>(m_hiZ->GetNumLevels()));
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _instanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_outputBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_meshBuffer);
+    glDispatchCompute((_numInstances + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, numMeshes, 1);
+    //the draws read the commands and the matrices the shader wrote
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+    for (GLuint i = 0; i < 4; i++)
+    {
+      glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, 0);
+    }
+    m_program.UnUse();
+  }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <GL\glew.h>
+#include <array>
+#include <vector>
+#include <glm\mat4x4.hpp>
+
+#include "GLSLProgram.h"
+#include "Mesh.h"
+
+namespace GameEngine
+{
+  class HiZBuffer;
+
+  /** \brief Culls the instances of an instanced draw on the GPU (see StaticModel::DrawInstanced): a compute shader tests the bounding
+  * sphere of every mesh of every instance against the frustum planes and appends the matrices of the survivors to the region of the mesh
+  * in its output buffer, counting them in the indirect draw command of the mesh. The counts never come back to the CPU, so the culled
+  * instances cost no vertex work and the draw no readback. With a HiZBuffer (see SetOcclusion) the instances inside the frustum are
+  * also tested against the depth of the last frame, the ones behind what was drawn are dropped too.
+  * One culler per instanced model, it needs OpenGL 4.3 (see IsSupported) */
+  class InstanceCuller
+  {
+  public:
+    InstanceCuller() {}
+    ~InstanceCuller() { Dispose(); }
+
+    /** \brief Check if the driver supports compute shaders and indirect draws */
+    static bool IsSupported();
+
+    /** \brief Compiles the culling shader */
+    void Init();
+    void Dispose();
+
+    /** \brief Culls the first _numInstances matrices of _instanceBuffer for every mesh of _meshes against _frustumPlanes (see Camera3D::GetFrustumPlanes)
+    * and writes the command of mesh i to i * sizeof(DrawElementsIndirectCommand) of GetCommandBuffer() */
+    void Cull(const std::vector<Mesh>& _meshes, GLuint _instanceBuffer, GLuint _numInstances, const std::array<glm::vec4, 6>& _frustumPlanes);
+    /** \brief Tests the instances of the next culls against _hiZ too, once it's built (kept by the caller), nullptr for the frustum only */
+    void SetOcclusion(const HiZBuffer* _hiZ) { m_hiZ = _hiZ; }
+
+    /** \brief The matrices of the visible instances, the ones of mesh i start at i * GetMeshStride() (the baseInstance of its command) */
+    GLuint GetOutputBuffer() const noexcept { return m_outputBuffer; }
+    GLuint GetCommandBuffer() const noexcept { return m_commandBuffer; }
+    GLuint GetMeshStride() const noexcept { return m_meshStride; }
+
+  private:
+    /** \brief A mesh as the shader reads it (std430) */
+    struct CullMesh
+    {
+      glm::vec4 boundingSphere;
+      glm::mat4 baseModelMatrix;
+    };
+
+    GLSLProgram m_program;
+    UniformHandle m_numInstancesUniform;
+    UniformHandle m_meshStrideUniform;
+    UniformHandle m_frustumPlanesUniform;
+    UniformHandle m_useOcclusionUniform;
+    UniformHandle m_occlusionViewProjectionUniform;
+    UniformHandle m_hiZUniform;
+    UniformHandle m_hiZSizeUniform;
+    UniformHandle m_hiZLevelsUniform;
+    const HiZBuffer* m_hiZ{ nullptr };
+    GLuint m_outputBuffer{ 0 };
+    GLuint m_commandBuffer{ 0 };
+    GLuint m_meshBuffer{ 0 };
+    GLuint m_meshStride{ 0 }; ///< the matrices of a mesh region, the output holds m_numMeshes of them
+    GLuint m_numMeshes{ 0 };
+    std::vector<DrawElementsIndirectCommand> m_commands; ///< the reset commands uploaded before every cull
+    std::vector<CullMesh> m_cullMeshes;
+  };
+}
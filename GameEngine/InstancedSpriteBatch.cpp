@@ -0,0 +1,289 @@
+#include "InstancedSpriteBatch.h"
+#include "FrameStats.h"
+#include "RenderState.h"
+#include <algorithm> // used for sorting
+
+namespace GameEngine
+{
+  const char* INSTANCED_SPRITE_VERT_SRC = R"(#version 330 core
+//per-instance data, one record for every sprite
+layout (location = 0) in vec4 destRect;
+layout (location = 1) in vec4 uvRect;
+layout (location = 2) in vec4 color;
+layout (location = 3) in vec3 angleDepthLayer;
+
+out VS_OUT
+{
+	vec2 position;
+	vec4 color;
+	vec2 uv;
+	flat float layer;
+} vs_out;
+
+uniform mat4 projection;
+
+void main()
+{
+    //corners of the triangle strip: (0,0) (1,0) (0,1) (1,1)
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+    //rotate the corner around the center of the sprite
+    vec2 halfDims = destRect.zw * 0.5;
+    vec2 local = (corner - 0.5) * destRect.zw;
+    float c = cos(angleDepthLayer.x);
+    float s = sin(angleDepthLayer.x);
+    vec2 position = destRect.xy + halfDims + vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+
+    gl_Position = vec4((projection * vec4(position, 0.0, 1.0)).xy, 0.0, 1.0);
+
+    vs_out.position = position;
+    vs_out.color = color;
+    //pass the uv with the v/y inverted
+    vec2 uv = uvRect.xy + corner * uvRect.zw;
+    vs_out.uv = vec2(uv.x, 1.0 - uv.y);
+    vs_out.layer = angleDepthLayer.z;
+})";
+
+  const char* INSTANCED_SPRITE_FRAG_SRC = R"(#version 330 core
+out vec4 color;
+
+in VS_OUT
+{
+	vec2 position;
+	vec4 color;
+	vec2 uv;
+	flat float layer;
+} fs_in;
+
+uniform sampler2D diffuseTexture;
+uniform sampler2DArray diffuseArray;
+
+void main()
+{
+    if (fs_in.layer >= 0.0)
+    {
+        color = fs_in.color * texture(diffuseArray, vec3(fs_in.uv, fs_in.layer));
+    }
+    else
+    {
+        color = fs_in.color * texture(diffuseTexture, fs_in.uv);
+    }
+})";
+
+  InstancedGlyph::InstancedGlyph(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, float _angle, int _layer /* = -1 */) :
+    m_texture(_texture)
+  {
+    m_instance.m_destRect = _destRect;
+    m_instance.m_uvRect = _uvRect;
+    m_instance.m_color = _color;
+    m_instance.m_angle = _angle;
+    m_instance.m_depth = _depth;
+    m_instance.m_layer = static_cast<float>(_layer);
+  }
+
+  InstancedSpriteBatch::InstancedSpriteBatch()
+  {
+  }
+
+  InstancedSpriteBatch::~InstancedSpriteBatch()
+  {
+  }
+
+  void InstancedSpriteBatch::Init()
+  {
+    m_program.CompileShadersFromSource(INSTANCED_SPRITE_VERT_SRC, INSTANCED_SPRITE_FRAG_SRC);
+    CreateVertexArray();
+  }
+
+  void InstancedSpriteBatch::Dispose()
+  {
+    if (m_vao != 0)
+    {
+      RenderState::Get().DeleteVertexArrays(1, &m_vao);
+      m_vao = 0;
+    }
+    if (m_vbo != 0)
+    {
+      glDeleteBuffers(1, &m_vbo);
+      m_vbo = 0;
+    }
+    m_program.Dispose();
+  }
+
+  void InstancedSpriteBatch::Begin(GlyphSortType _sortType/* = GlyphSortType::TEXTURE*/)
+  {
+    m_sortType = _sortType;
+    m_renderBatches.clear();
+    //keeps the capacity, so there is no reallocation in the steady state
+    m_glyphs.clear();
+  }
+
+  void InstancedSpriteBatch::End()
+  {
+    m_glyphPointers.resize(m_glyphs.size());
+    for (size_t i = 0; i < m_glyphs.size(); i++)
+    {
+      m_glyphPointers[i] = &m_glyphs[i];
+    }
+    SortGlyphs();
+    CreateRenderBatches();
+  }
+
+  void InstancedSpriteBatch::Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color)
+  {
+    m_glyphs.emplace_back(_destRect, _uvRect, _texture, _depth, _color, 0.0f);
+  }
+
+  void InstancedSpriteBatch::Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, float _angle)
+  {
+    m_glyphs.emplace_back(_destRect, _uvRect, _texture, _depth, _color, _angle);
+  }
+
+  void InstancedSpriteBatch::Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, const glm::vec2& _dir)
+  {
+    const glm::vec2 right(1.0f, 0.0f);
+
+    float angle = acos(glm::dot(right, _dir));
+
+    if (_dir.y < 0.0f)
+    {
+      angle = -angle;
+    }
+
+    m_glyphs.emplace_back(_destRect, _uvRect, _texture, _depth, _color, angle);
+  }
+
+  void InstancedSpriteBatch::Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, const GLTexture& _texture, float _depth, const ColorRGBA8& _color, float _angle /* = 0.0f */)
+  {
+    m_glyphs.emplace_back(_destRect, _uvRect, _texture.id, _depth, _color, _angle, _texture.layer);
+  }
+
+  void InstancedSpriteBatch::RenderBatch(const glm::mat4& _projection)
+  {
+    m_program.Use();
+    m_program.UploadValue("projection", _projection);
+    m_program.UploadValue("diffuseTexture", 0);
+    m_program.UploadValue("diffuseArray", 1);
+
+    RenderState& state = RenderState::Get();
+    state.BindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    for (size_t i = 0; i < m_renderBatches.size(); i++)
+    {
+      //plain textures go to unit 0 and texture arrays to unit 1
+      if (m_batchIsArray[i])
+      {
+        state.BindTexture(1, GL_TEXTURE_2D_ARRAY, m_renderBatches[i].m_texture);
+      }
+      else
+      {
+        state.BindTexture(0, GL_TEXTURE_2D, m_renderBatches[i].m_texture);
+      }
+      SetInstanceAttributes(m_renderBatches[i].m_offset);
+      //4 vertices per instance, expanded to a quad in the vertex shader
+      FrameStats::Get().Add(STAT_DRAW_CALLS);
+      glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, m_renderBatches[i].m_numVertices);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    state.BindVertexArray(0);
+    state.ActiveTexture(0);
+
+    m_program.UnUse();
+  }
+
+  void InstancedSpriteBatch::CreateRenderBatches()
+  {
+    m_instances.clear();
+    m_batchIsArray.clear();
+    if (m_glyphPointers.empty())
+    {
+      return;
+    }
+    m_instances.reserve(m_glyphPointers.size());
+
+    m_renderBatches.emplace_back(0, 0, m_glyphPointers[0]->m_texture);
+    m_batchIsArray.push_back(m_glyphPointers[0]->m_instance.m_layer >= 0.0f);
+    for (size_t currentGlyph = 0; currentGlyph < m_glyphPointers.size(); currentGlyph++)
+    {
+      //start a new batch when the texture changes
+      if (currentGlyph > 0 && m_glyphPointers[currentGlyph]->m_texture != m_glyphPointers[currentGlyph - 1]->m_texture)
+      {
+        m_renderBatches.emplace_back(static_cast<GLuint>(currentGlyph), 0, m_glyphPointers[currentGlyph]->m_texture);
+        m_batchIsArray.push_back(m_glyphPointers[currentGlyph]->m_instance.m_layer >= 0.0f);
+      }
+      m_renderBatches.back().m_numVertices++;
+      m_instances.push_back(m_glyphPointers[currentGlyph]->m_instance);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    // Orphan the buffer (for speed)
+    glBufferData(GL_ARRAY_BUFFER, m_instances.size() * sizeof(SpriteInstance), nullptr, GL_DYNAMIC_DRAW);
+    //upload the data
+    FrameStats::Get().Add(STAT_BYTES_UPLOADED, m_instances.size() * sizeof(SpriteInstance));
+    glBufferSubData(GL_ARRAY_BUFFER, 0, m_instances.size() * sizeof(SpriteInstance), m_instances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  void InstancedSpriteBatch::CreateVertexArray()
+  {
+    if (m_vao == 0)
+    {
+      glGenVertexArrays(1, &m_vao);
+    }
+    RenderState::Get().BindVertexArray(m_vao);
+
+    if (m_vbo == 0)
+    {
+      glGenBuffers(1, &m_vbo);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+
+    for (GLuint i = 0; i < 4; i++)
+    {
+      glEnableVertexAttribArray(i);
+      //advance the attributes once per instance rather than per vertex
+      glVertexAttribDivisor(i, 1);
+    }
+    SetInstanceAttributes(0);
+
+    RenderState::Get().BindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  void InstancedSpriteBatch::SetInstanceAttributes(GLuint _firstInstance)
+  {
+    const size_t base = _firstInstance * sizeof(SpriteInstance);
+    //dest rect
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(base + offsetof(SpriteInstance, m_destRect)));
+    //uv rect
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(base + offsetof(SpriteInstance, m_uvRect)));
+    //color
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteInstance), (void*)(base + offsetof(SpriteInstance, m_color)));
+    //angle, depth and layer are adjacent, so they are read as one vec3
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(base + offsetof(SpriteInstance, m_angle)));
+  }
+
+  void InstancedSpriteBatch::SortGlyphs()
+  {
+    switch (m_sortType)
+    {
+    case GlyphSortType::FRONT_TO_BACK:
+    {
+      std::stable_sort(m_glyphPointers.begin(), m_glyphPointers.end(), [](InstancedGlyph* _a, InstancedGlyph* _b) { return (_a->m_instance.m_depth < _b->m_instance.m_depth); });
+      break;
+    }
+    case GlyphSortType::BACK_TO_FRONT:
+    {
+      std::stable_sort(m_glyphPointers.begin(), m_glyphPointers.end(), [](InstancedGlyph* _a, InstancedGlyph* _b) { return (_a->m_instance.m_depth > _b->m_instance.m_depth); });
+      break;
+    }
+    case GlyphSortType::TEXTURE:
+    {
+      std::stable_sort(m_glyphPointers.begin(), m_glyphPointers.end(), [](InstancedGlyph* _a, InstancedGlyph* _b) { return (_a->m_texture < _b->m_texture); });
+      break;
+    }
+    default:
+      break;
+    }
+  }
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include <vector>
+
+#include "GLSLProgram.h"
+#include "GLTexture.h"
+#include "SpriteBatch.h"
+#include "Vertex.h"
+
+namespace GameEngine
+{
+  // The per-instance record uploaded for every sprite (the quad corners are generated in the vertex shader)
+  struct SpriteInstance
+  {
+    glm::vec4 m_destRect{ 0.0f }; ///< x, y (bottom left), width, height
+    glm::vec4 m_uvRect{ 0.0f };   ///< u, v (bottom left), width, height
+    ColorRGBA8 m_color;
+    float m_angle{ 0.0f };        ///< rotation around the center of the sprite (radians)
+    float m_depth{ 0.0f };
+    float m_layer{ -1.0f };       ///< layer in the texture array, -1 for a plain 2D texture
+  };
+
+  // A sprite instance with the texture it's drawn with (the texture is only needed on the CPU for batching)
+  struct InstancedGlyph
+  {
+    InstancedGlyph() {}
+    InstancedGlyph(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, float _angle, int _layer = -1);
+
+    SpriteInstance m_instance;
+    GLuint m_texture{ 0 };
+  };
+
+  /** \brief Alternative SpriteBatch backend which uploads one compact record per sprite
+   *  and expands it to a quad with glDrawArraysInstanced, instead of 6 full vertices per sprite.
+   *  It has its own shader, so it uses the same "projection" and "diffuseTexture" uniforms as textureShading.
+   *  Textures packed with ResourceManager::PackTextureArray all share one id, so sprites using any of
+   *  their layers end up in the same batch and draw call */
+  class InstancedSpriteBatch
+  {
+  public:
+    InstancedSpriteBatch();
+    ~InstancedSpriteBatch();
+
+    // Initializes the batch and compiles its shader
+    void Init();
+    // Disposes of the batch
+    void Dispose();
+
+    // Begins the batch and chooses the sort type (by texture is default)
+    void Begin(GlyphSortType _sortType = GlyphSortType::TEXTURE);
+    // Sorts the instances, creates the batches and uploads the instance buffer
+    void End();
+
+    // Adds a sprite
+    void Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color);
+    // Adds a sprite with rotation
+    void Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, float _angle);
+    // Adds a sprite rotated towards _dir
+    void Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, const glm::vec2& _dir);
+    // Adds a sprite from a GLTexture, which may be a layer of a texture array
+    void Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, const GLTexture& _texture, float _depth, const ColorRGBA8& _color, float _angle = 0.0f);
+
+    // Renders all the batches with the given projection matrix
+    void RenderBatch(const glm::mat4& _projection);
+
+  private:
+    // Creates the batches (m_offset is the first instance, m_numVertices the number of instances)
+    void CreateRenderBatches();
+    // Generates the VAO and the instance buffer
+    void CreateVertexArray();
+    // Points the instanced attributes at _firstInstance (glDrawArraysInstancedBaseInstance needs GL 4.2)
+    void SetInstanceAttributes(GLuint _firstInstance);
+    // Sorts glyphs according to _sortType
+    void SortGlyphs();
+
+    GLSLProgram m_program;
+    GLuint m_vbo{ 0 };
+    GLuint m_vao{ 0 };
+
+    GlyphSortType m_sortType{ GlyphSortType::TEXTURE };
+
+    std::vector<InstancedGlyph*> m_glyphPointers; ///< this is for sorting
+    std::vector<InstancedGlyph> m_glyphs;         ///< these are the actual glyphs
+    std::vector<SpriteInstance> m_instances;      ///< the sorted records which get uploaded
+    std::vector<RenderBatches> m_renderBatches;
+    std::vector<bool> m_batchIsArray;             ///< whether the texture of each batch is a GL_TEXTURE_2D_ARRAY
+  };
+}
+
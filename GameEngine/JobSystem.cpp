@@ -0,0 +1,221 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+
+namespace GameEngine
+{
+  namespace
+  {
+    //the deque of the worker running on this thread, -1 on the other threads
+    thread_local int t_workerIndex{ -1 };
+  }
+
+  JobSystem& JobSystem::Get()
+  {
+    static JobSystem jobSystem;
+    return jobSystem;
+  }
+
+  void JobSystem::Init(unsigned int _numWorkers)
+  {
+    if (!m_workers.empty())
+    {
+      return;
+    }
+    if (_numWorkers == 0)
+    {
+      const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+      _numWorkers = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+    m_stop = false;
+    for (unsigned int i = 0; i < _numWorkers; i++)
+    {
+      m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (unsigned int i = 0; i < _numWorkers; i++)
+    {
+      m_workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+  }
+
+  void JobSystem::Shutdown()
+  {
+    if (m_workers.empty())
+    {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_sleepMutex);
+      m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers)
+    {
+      worker.join();
+    }
+    m_workers.clear();
+    m_queues.clear();
+  }
+
+  void JobSystem::Run(Job _job, JobCounter* _counter, JobCounter* _dependency)
+  {
+    if (_counter)
+    {
+      _counter->m_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    QueuedJob queued{ std::move(_job), _counter };
+    if (_dependency)
+    {
+      //started by the last job of the dependency if it isn't done yet
+      std::lock_guard<std::mutex> lock(_dependency->m_mutex);
+      if (_dependency->m_count.load(std::memory_order_acquire) > 0)
+      {
+        _dependency->m_dependents.push_back(std::move(queued));
+        return;
+      }
+    }
+    Schedule(std::move(queued));
+  }
+
+  void JobSystem::Wait(JobCounter& _counter)
+  {
+    PROFILE_SCOPE("JobSystem::Wait");
+    while (!_counter.IsDone())
+    {
+      if (!TryRunJob())
+      {
+        std::this_thread::yield();
+      }
+    }
+    //the last job counted down under the lock, once it's released the counter isn't touched anymore and can go
+    std::lock_guard<std::mutex> lock(_counter.m_mutex);
+  }
+
+  void JobSystem::RunOnMainThread(Job _job, JobCounter* _counter)
+  {
+    if (_counter)
+    {
+      _counter->m_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+    m_mainThreadJobs.push_back({ std::move(_job), _counter });
+  }
+
+  void JobSystem::RunMainThreadJobs()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+      m_runningMainThreadJobs.swap(m_mainThreadJobs);
+    }
+    for (auto& job : m_runningMainThreadJobs)
+    {
+      Execute(job);
+    }
+    m_runningMainThreadJobs.clear();
+  }
+
+  void JobSystem::Schedule(QueuedJob _job)
+  {
+    if (m_queues.empty())
+    {
+      Execute(_job);
+      return;
+    }
+    const unsigned int index = t_workerIndex >= 0 ? static_cast<unsigned int>(t_workerIndex) : m_nextQueue++ % m_queues.size();
+    {
+      std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+      m_queues[index]->jobs.push_back(std::move(_job));
+    }
+    m_numQueued.fetch_add(1, std::memory_order_release);
+    {
+      //taken so a worker can't miss the job between checking the count and going to sleep
+      std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_wake.notify_one();
+  }
+
+  bool JobSystem::TryRunJob()
+  {
+    if (m_queues.empty() || m_numQueued.load(std::memory_order_acquire) == 0)
+    {
+      return false;
+    }
+    const size_t numQueues = m_queues.size();
+    const size_t first = t_workerIndex >= 0 ? static_cast<size_t>(t_workerIndex) : m_nextQueue % numQueues;
+    QueuedJob job;
+    bool found = false;
+    for (size_t i = 0; i < numQueues && !found; i++)
+    {
+      WorkQueue& queue = *m_queues[(first + i) % numQueues];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.jobs.empty())
+      {
+        continue;
+      }
+      //the own newest job, or the oldest of another worker (the biggest part of its work left, and the coldest in its cache)
+      if (i == 0 && t_workerIndex >= 0)
+      {
+        job = std::move(queue.jobs.back());
+        queue.jobs.pop_back();
+      }
+      else
+      {
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+      }
+      found = true;
+    }
+    if (!found)
+    {
+      return false;
+    }
+    m_numQueued.fetch_sub(1, std::memory_order_relaxed);
+    Execute(job);
+    return true;
+  }
+
+  void JobSystem::Execute(QueuedJob& _job)
+  {
+    _job.job();
+    Finish(_job.counter);
+  }
+
+  void JobSystem::Finish(JobCounter* _counter)
+  {
+    if (!_counter)
+    {
+      return;
+    }
+    std::vector<QueuedJob> dependents;
+    {
+      std::lock_guard<std::mutex> lock(_counter->m_mutex);
+      if (_counter->m_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      {
+        dependents.swap(_counter->m_dependents);
+      }
+    }
+    for (auto& dependent : dependents)
+    {
+      Schedule(std::move(dependent));
+    }
+  }
+
+  void JobSystem::WorkerLoop(unsigned int _index)
+  {
+    t_workerIndex = static_cast<int>(_index);
+    Profiler::Get().SetThreadName("Job Worker");
+    while (true)
+    {
+      if (TryRunJob())
+      {
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(m_sleepMutex);
+      m_wake.wait(lock, [this]() { return m_stop || m_numQueued.load(std::memory_order_acquire) > 0; });
+      //the queued jobs are all run before the workers stop
+      if (m_stop && m_numQueued.load(std::memory_order_acquire) == 0)
+      {
+        return;
+      }
+    }
+  }
+}
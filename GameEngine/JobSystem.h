@@ -0,0 +1,155 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+namespace GameEngine
+{
+  //the chunks ParallelFor cuts the work into per thread, more than one so a thread which finishes early steals from the slow ones
+  constexpr size_t JOB_CHUNKS_PER_THREAD{ 4 };
+
+  using Job = std::function<void()>;
+
+  class JobCounter;
+
+  //a job and the counter it counts down when it's done
+  struct QueuedJob
+  {
+    Job job;
+    JobCounter* counter{ nullptr };
+  };
+
+  /** \brief Counts the unfinished jobs it was given to. A job can wait for a counter to reach 0 before it's started (a dependency),
+   *  and a thread waiting on one runs the queued jobs meanwhile (see JobSystem::Wait). A counter has to outlive its jobs */
+  class JobCounter
+  {
+    friend class JobSystem;
+  public:
+    bool IsDone() const noexcept { return m_count.load(std::memory_order_acquire) == 0; }
+
+  private:
+    std::atomic<int> m_count{ 0 };
+    std::mutex m_mutex;
+    std::vector<QueuedJob> m_dependents; ///< the jobs started when the count reaches 0
+  };
+
+  /** \brief The worker threads of the engine, shared by every subsystem instead of each starting threads of its own. Every worker has
+   *  its own deque: it runs its newest job first (still in the cache), and a worker without jobs steals the oldest job of another one,
+   *  so a worker which is handed a lot of work shares it. The jobs must not make GL calls, the GL work goes through RunOnMainThread.
+   *  Initialized by GameEngine::Init with a worker per core but the main thread's */
+  class JobSystem
+  {
+  public:
+    static JobSystem& Get();
+    ~JobSystem() { Shutdown(); }
+
+    // Starts the workers, 0 starts one per core but the calling thread's. Without workers the jobs run in Run
+    void Init(unsigned int _numWorkers = 0);
+    // Runs the queued jobs and joins the workers
+    void Shutdown();
+
+    /** \brief Queues the job, it runs once _dependency (if any) reaches 0
+     *  \param _counter incremented now and decremented once the job is done */
+    void Run(Job _job, JobCounter* _counter = nullptr, JobCounter* _dependency = nullptr);
+    // Runs queued jobs until the counter reaches 0
+    void Wait(JobCounter& _counter);
+
+    /** \brief Calls _func(begin, end) on chunks of [0, _count) of at least _minChunk, on the workers and the calling thread, and
+     *  returns once all are done. The first exception a chunk throws is rethrown */
+    template <typename Func>
+    void ParallelFor(size_t _count, size_t _minChunk, const Func& _func);
+
+    /** \brief Queues a job for the thread with the GL context, which runs them before it draws (see IMainGame), e.g. the upload of
+     *  something a worker built. Don't Wait on its counter from the simulation, it's done by the next frame */
+    void RunOnMainThread(Job _job, JobCounter* _counter = nullptr);
+    // Runs the jobs queued by RunOnMainThread, on the thread with the GL context
+    void RunMainThreadJobs();
+
+    unsigned int GetNumWorkers() const noexcept { return static_cast<unsigned int>(m_workers.size()); }
+
+  private:
+    JobSystem() {}
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    struct WorkQueue
+    {
+      std::mutex mutex;
+      std::deque<QueuedJob> jobs;
+    };
+
+    // Pushes the job to the deque of the calling worker, or of the next worker for the other threads
+    void Schedule(QueuedJob _job);
+    // Runs a job of the own deque or a stolen one, false if all were empty
+    bool TryRunJob();
+    void Execute(QueuedJob& _job);
+    // Counts the job down, starts the jobs which waited for the counter
+    void Finish(JobCounter* _counter);
+    void WorkerLoop(unsigned int _index);
+
+    std::vector<std::thread> m_workers;
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::atomic<unsigned int> m_nextQueue{ 0 };
+    std::atomic<int> m_numQueued{ 0 };
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    bool m_stop{ false };
+
+    std::mutex m_mainThreadMutex;
+    std::vector<QueuedJob> m_mainThreadJobs;
+    std::vector<QueuedJob> m_runningMainThreadJobs; ///< swapped with m_mainThreadJobs, so the jobs can queue more
+  };
+
+  template <typename Func>
+  void JobSystem::ParallelFor(size_t _count, size_t _minChunk, const Func& _func)
+  {
+    const size_t minChunk = std::max<size_t>(_minChunk, 1);
+    const size_t numChunks = std::min((_count + minChunk - 1) / minChunk, (GetNumWorkers() + 1) * JOB_CHUNKS_PER_THREAD);
+    if (numChunks <= 1)
+    {
+      if (_count > 0)
+      {
+        _func(size_t(0), _count);
+      }
+      return;
+    }
+
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto runChunk = [&](size_t _chunk)
+    {
+      try
+      {
+        _func(_chunk * _count / numChunks, (_chunk + 1) * _count / numChunks);
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+        {
+          error = std::current_exception();
+        }
+      }
+    };
+    //this thread runs the first chunk and then helps with the rest
+    JobCounter counter;
+    for (size_t chunk = 1; chunk < numChunks; chunk++)
+    {
+      Run([&runChunk, chunk]() { runChunk(chunk); }, &counter);
+    }
+    runChunk(0);
+    Wait(counter);
+    if (error)
+    {
+      std::rethrow_exception(error);
+    }
+  }
+}
@@ -3,8 +3,13 @@
 #include <glm\vec3.hpp>
 #include <glm\gtc\matrix_transform.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <vector>
 
+#include "Camera3D.h"
+
 namespace GameEngine
 {
   class LightCamera
@@ -36,6 +41,7 @@ namespace GameEngine
         glm::lookAt(_lightPos, _lightPos + glm::vec3(0.0, 0.0, 1.0), glm::vec3(0.0, -1.0, 0.0));
       m_shadowTransforms.at(5) = projection *
         glm::lookAt(_lightPos, _lightPos + glm::vec3(0.0, 0.0, -1.0), glm::vec3(0.0, -1.0, 0.0));
+      UpdateCasterBounds();
     }
 
     void InitForDirLight(float _left, float _right, float _bottom, float _top, float _near, float _far,
@@ -46,12 +52,109 @@ namespace GameEngine
       m_shadowTransforms.resize(1);
       m_shadowTransforms.at(0) = projection *
         glm::lookAt(_lightPos, _lightPos + _direction, glm::vec3(0.0, 1.0, 0.0));
+      UpdateCasterBounds();
+    }
+
+    /** \brief Fits the shadow cameras of a directional light to _numCascades slices of the frustum of _camera, up to _shadowDistance.
+    * The split distances mix a logarithmic and a uniform split by _splitLambda (1 is all logarithmic), so the near cascades get the detail.
+    * A cascade is a square around the bounding sphere of its slice, it keeps its size when the camera turns, and it's moved so the texels
+    * of a _resolution map stay on the same world positions, the edges don't shimmer when the camera moves. _casterDistance moves the
+    * near plane toward the light, for the casters outside of the slice
+    */
+    void InitForCascades(const Camera3D& _camera, const glm::vec3& _direction, int _numCascades, int _resolution,
+      float _shadowDistance, float _splitLambda = 0.75f, float _casterDistance = 50.0f)
+    {
+      const float cameraNear = _camera.GetNearPlane();
+      const float cameraFar = _camera.GetFarPlane();
+      m_far = std::min(cameraFar, _shadowDistance);
+      //the corners of the whole frustum, a slice is between them
+      const glm::mat4 inverseViewProjection = glm::inverse(_camera.GetProjectionMatrix() * _camera.GetViewMatrix());
+      glm::vec3 nearCorners[4];
+      glm::vec3 farCorners[4];
+      for (int i = 0; i < 4; i++)
+      {
+        const glm::vec2 ndc((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f);
+        const glm::vec4 nearCorner = inverseViewProjection * glm::vec4(ndc, -1.0f, 1.0f);
+        const glm::vec4 farCorner = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+        nearCorners[i] = glm::vec3(nearCorner) / nearCorner.w;
+        farCorners[i] = glm::vec3(farCorner) / farCorner.w;
+      }
+
+      const glm::vec3 direction = glm::normalize(_direction);
+      const glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+      const float halfResolution = 0.5f * static_cast<float>(_resolution);
+      m_shadowTransforms.resize(_numCascades);
+      m_cascadeSplits.resize(_numCascades);
+      float sliceNear = cameraNear;
+      for (int cascade = 0; cascade < _numCascades; cascade++)
+      {
+        const float ratio = static_cast<float>(cascade + 1) / static_cast<float>(_numCascades);
+        const float logSplit = cameraNear * std::pow(m_far / cameraNear, ratio);
+        const float uniformSplit = cameraNear + (m_far - cameraNear) * ratio;
+        const float sliceFar = _splitLambda * logSplit + (1.0f - _splitLambda) * uniformSplit;
+        m_cascadeSplits[cascade] = sliceFar;
+
+        //the view depth is linear along the rays from the near to the far corners
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+        for (int i = 0; i < 4; i++)
+        {
+          const glm::vec3 ray = (farCorners[i] - nearCorners[i]) / (cameraFar - cameraNear);
+          corners[i] = nearCorners[i] + ray * (sliceNear - cameraNear);
+          corners[i + 4] = nearCorners[i] + ray * (sliceFar - cameraNear);
+          center += corners[i] + corners[i + 4];
+        }
+        center /= 8.0f;
+        float radius = 0.0f;
+        for (const glm::vec3& corner : corners)
+        {
+          radius = std::max(radius, glm::length(corner - center));
+        }
+        //rounded up, the float noise of the corners doesn't change the size from frame to frame
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        const glm::mat4 view = glm::lookAt(center - direction * (radius + _casterDistance), center, up);
+        glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius + _casterDistance);
+        //snaps the world origin to a texel, the whole map then moves in steps of one texel
+        const glm::vec4 origin = projection * view * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        const glm::vec2 texels = glm::vec2(origin) * halfResolution;
+        const glm::vec2 offset = (glm::round(texels) - texels) / halfResolution;
+        projection[3][0] += offset.x;
+        projection[3][1] += offset.y;
+        m_shadowTransforms[cascade] = projection * view;
+        sliceNear = sliceFar;
+      }
+      UpdateCasterBounds();
     }
 
     std::vector<glm::mat4>& GetLightTransforms() { return m_shadowTransforms; }
+    /** \brief The view depths where the cascades of InitForCascades end */
+    const std::vector<float>& GetCascadeSplits() const noexcept { return m_cascadeSplits; }
     float GetFarPlane() const noexcept { return m_far; }
+    /** \brief The box around the frustums of all the light transforms, what can cast into the shadow map, e.g. to gather the casters
+    * from a AABBTree */
+    const AABB& GetCasterBounds() const noexcept { return m_casterBounds; }
   private:
+    void UpdateCasterBounds()
+    {
+      glm::vec3 min(std::numeric_limits<float>::max());
+      glm::vec3 max(-std::numeric_limits<float>::max());
+      for (const glm::mat4& transform : m_shadowTransforms)
+      {
+        const glm::mat4 inverse = glm::inverse(transform);
+        for (int i = 0; i < 8; i++)
+        {
+          const glm::vec4 corner = inverse * glm::vec4((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 1.0f);
+          min = glm::min(min, glm::vec3(corner) / corner.w);
+          max = glm::max(max, glm::vec3(corner) / corner.w);
+        }
+      }
+      m_casterBounds = AABB(min, max);
+    }
+
     std::vector<glm::mat4> m_shadowTransforms;
+    std::vector<float> m_cascadeSplits;
     float m_far;
+    AABB m_casterBounds;
   };
 }
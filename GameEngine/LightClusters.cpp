@@ -0,0 +1,241 @@
+#include "LightClusters.h"
+#include "FrameStats.h"
+#include "Camera3D.h"
+#include "Lights.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace GameEngine
+{
+  namespace
+  {
+    //the LightGrid buffer starts with gridSize and depthSlicing, the clusters follow
+    const GLsizeiptr GRID_HEADER_SIZE = sizeof(glm::uvec4) + sizeof(glm::vec4);
+
+    /** \brief The distance where the light fades under 1/256 of its strongest intensity, the attenuation is constant, linear, quadratic.
+    * A light that never fades reaches everything */
+    float GetRange(const glm::vec4& _color, const glm::vec4& _intensities, const glm::vec4& _attenuation)
+    {
+      const float brightest = std::max(std::max(_color.r, _color.g), _color.b) *
+        std::max(std::max(_intensities.x, _intensities.y), _intensities.z);
+      //solves constant + linear * d + quadratic * d^2 = 256 * brightest
+      const float c = _attenuation.x - 256.0f * brightest;
+      if (c >= 0.0f)
+      {
+        return 0.0f;
+      }
+      if (_attenuation.z > 0.0f)
+      {
+        return (-_attenuation.y + std::sqrt(_attenuation.y * _attenuation.y - 4.0f * _attenuation.z * c)) / (2.0f * _attenuation.z);
+      }
+      if (_attenuation.y > 0.0f)
+      {
+        return -c / _attenuation.y;
+      }
+      return std::numeric_limits<float>::max();
+    }
+
+    void Upload(GLuint _buffer, GLuint _binding, const void* _data, GLsizeiptr _size)
+    {
+      //a buffer bound to a binding point needs a store, an empty list still gets one element
+      glBindBuffer(GL_SHADER_STORAGE_BUFFER, _buffer);
+      glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<GLsizeiptr>(_size, 16), nullptr, GL_STREAM_DRAW);
+      if (_size > 0)
+      {
+        FrameStats::Get().Add(STAT_BYTES_UPLOADED, _size);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, _size, _data);
+      }
+      glBindBufferBase(GL_SHADER_STORAGE_BUFFER, _binding, _buffer);
+    }
+  }
+
+  bool LightClusters::IsSupported()
+  {
+    return GLEW_VERSION_4_3 != 0;
+  }
+
+  void LightClusters::Init()
+  {
+    if (m_gridBuffer == 0)
+    {
+      glGenBuffers(1, &m_pointLightBuffer);
+      glGenBuffers(1, &m_spotLightBuffer);
+      glGenBuffers(1, &m_gridBuffer);
+      glGenBuffers(1, &m_indexBuffer);
+    }
+  }
+
+  void LightClusters::Dispose()
+  {
+    if (m_gridBuffer != 0)
+    {
+      glDeleteBuffers(1, &m_pointLightBuffer);
+      glDeleteBuffers(1, &m_spotLightBuffer);
+      glDeleteBuffers(1, &m_gridBuffer);
+      glDeleteBuffers(1, &m_indexBuffer);
+      m_pointLightBuffer = 0;
+      m_spotLightBuffer = 0;
+      m_gridBuffer = 0;
+      m_indexBuffer = 0;
+    }
+    Clear();
+    m_clusterBounds.clear();
+    m_projection = glm::mat4(0.0f);
+  }
+
+  void LightClusters::Clear()
+  {
+    m_pointLights.clear();
+    m_spotLights.clear();
+  }
+
+  void LightClusters::Add(const PointLight& _light)
+  {
+    PointLightData data;
+    _light.WriteTo(data);
+    data.position.w = GetRange(data.color, data.intensities, data.attenuation);
+    m_pointLights.push_back(data);
+  }
+
+  void LightClusters::Add(const SpotLight& _light)
+  {
+    //culled by its whole range, the cone only narrows it in the shader
+    SpotLightData data;
+    _light.WriteTo(data);
+    data.position.w = GetRange(data.color, data.intensities, data.attenuation);
+    m_spotLights.push_back(data);
+  }
+
+  void LightClusters::Build(const Camera3D& _camera)
+  {
+    const glm::mat4 projection = _camera.GetProjectionMatrix();
+    if (projection != m_projection)
+    {
+      ComputeClusterBounds(projection);
+    }
+    const glm::mat4 view = _camera.GetViewMatrix();
+
+    m_references.clear();
+    const GLuint numPointLights = static_cast<GLuint>(m_pointLights.size());
+    for (GLuint i = 0; i < numPointLights; i++)
+    {
+      AssignLight(i, glm::vec3(view * glm::vec4(glm::vec3(m_pointLights[i].position), 1.0f)), m_pointLights[i].position.w);
+    }
+    for (GLuint i = 0; i < static_cast<GLuint>(m_spotLights.size()); i++)
+    {
+      AssignLight(numPointLights + i, glm::vec3(view * glm::vec4(glm::vec3(m_spotLights[i].position), 1.0f)), m_spotLights[i].position.w);
+    }
+
+    //a counting sort of the references by cluster, the lists of the clusters end up back to back
+    m_clusters.assign(m_clusterBounds.size(), glm::uvec2(0));
+    for (const auto& reference : m_references)
+    {
+      m_clusters[reference.first].y++;
+    }
+    GLuint offset = 0;
+    for (auto& cluster : m_clusters)
+    {
+      cluster.x = offset;
+      offset += cluster.y;
+      cluster.y = 0;
+    }
+    m_lightIndices.resize(m_references.size());
+    for (const auto& reference : m_references)
+    {
+      glm::uvec2& cluster = m_clusters[reference.first];
+      m_lightIndices[cluster.x + cluster.y++] = reference.second;
+    }
+
+    if (m_gridBuffer == 0)
+    {
+      return;
+    }
+    Upload(m_pointLightBuffer, POINT_LIGHTS_BINDING, m_pointLights.data(), m_pointLights.size() * sizeof(PointLightData));
+    Upload(m_spotLightBuffer, SPOT_LIGHTS_BINDING, m_spotLights.data(), m_spotLights.size() * sizeof(SpotLightData));
+    Upload(m_indexBuffer, LIGHT_INDICES_BINDING, m_lightIndices.data(), m_lightIndices.size() * sizeof(GLuint));
+    const glm::uvec4 gridSize(TILES_X, TILES_Y, DEPTH_SLICES, numPointLights);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_gridBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, GRID_HEADER_SIZE + m_clusters.size() * sizeof(glm::uvec2), nullptr, GL_STREAM_DRAW);
+    FrameStats::Get().Add(STAT_BYTES_UPLOADED, GRID_HEADER_SIZE + m_clusters.size() * sizeof(glm::uvec2));
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(gridSize), &gridSize);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(gridSize), sizeof(m_depthSlicing), &m_depthSlicing);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, GRID_HEADER_SIZE, m_clusters.size() * sizeof(glm::uvec2), m_clusters.data());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_GRID_BINDING, m_gridBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  }
+
+  void LightClusters::ComputeClusterBounds(const glm::mat4& _projection)
+  {
+    m_projection = _projection;
+    //the planes of a perspective projection (glm::perspective, depth -1 to 1)
+    m_near = _projection[3][2] / (_projection[2][2] - 1.0f);
+    m_far = _projection[3][2] / (_projection[2][2] + 1.0f);
+    //slice k spans the depths near * (far / near)^(k / DEPTH_SLICES) to the next, so slice = log(depth) * x - y
+    const float logRatio = std::log(m_far / m_near);
+    m_depthSlicing = glm::vec4(DEPTH_SLICES / logRatio, DEPTH_SLICES * std::log(m_near) / logRatio, m_near, m_far);
+
+    const glm::mat4 inverseProjection = glm::inverse(_projection);
+    m_clusterBounds.resize(TILES_X * TILES_Y * DEPTH_SLICES);
+    for (GLuint slice = 0; slice < DEPTH_SLICES; slice++)
+    {
+      const float sliceNear = m_near * std::pow(m_far / m_near, static_cast<float>(slice) / DEPTH_SLICES);
+      const float sliceFar = m_near * std::pow(m_far / m_near, static_cast<float>(slice + 1) / DEPTH_SLICES);
+      for (GLuint y = 0; y < TILES_Y; y++)
+      {
+        for (GLuint x = 0; x < TILES_X; x++)
+        {
+          glm::vec3 boundsMin(std::numeric_limits<float>::max());
+          glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+          for (GLuint corner = 0; corner < 4; corner++)
+          {
+            //the corner on the near plane, then along its ray (from the eye) to both depths of the slice
+            const float ndcX = 2.0f * (x + (corner & 1)) / TILES_X - 1.0f;
+            const float ndcY = 2.0f * (y + (corner >> 1)) / TILES_Y - 1.0f;
+            glm::vec4 onNear = inverseProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+            const glm::vec3 ray = glm::vec3(onNear) / onNear.w / m_near;
+            for (float depth : { sliceNear, sliceFar })
+            {
+              boundsMin = glm::min(boundsMin, ray * depth);
+              boundsMax = glm::max(boundsMax, ray * depth);
+            }
+          }
+          m_clusterBounds[x + (y + slice * TILES_Y) * TILES_X] = { boundsMin, boundsMax };
+        }
+      }
+    }
+  }
+
+  void LightClusters::AssignLight(GLuint _light, const glm::vec3& _viewCenter, float _range)
+  {
+    //the view looks down -z
+    const float depth = -_viewCenter.z;
+    if (_range <= 0.0f || depth + _range < m_near || depth - _range > m_far)
+    {
+      return;
+    }
+    //the slices the depth range of the sphere covers, then a sphere against box test for the tiles of each
+    const auto sliceOf = [this](float _depth)
+    {
+      const float slice = std::floor(std::log(std::max(_depth, m_near)) * m_depthSlicing.x - m_depthSlicing.y);
+      return static_cast<GLuint>(std::min(std::max(slice, 0.0f), static_cast<float>(DEPTH_SLICES - 1)));
+    };
+    const GLuint firstSlice = sliceOf(depth - _range);
+    const GLuint lastSlice = sliceOf(std::min(depth + _range, m_far));
+    const float rangeSquared = _range * _range;
+    for (GLuint slice = firstSlice; slice <= lastSlice; slice++)
+    {
+      for (GLuint tile = 0; tile < TILES_X * TILES_Y; tile++)
+      {
+        const GLuint cluster = tile + slice * TILES_X * TILES_Y;
+        const glm::vec3 closest = glm::clamp(_viewCenter, m_clusterBounds[cluster].first, m_clusterBounds[cluster].second);
+        const glm::vec3 offset = closest - _viewCenter;
+        if (glm::dot(offset, offset) <= rangeSquared)
+        {
+          m_references.emplace_back(cluster, _light);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <GL\glew.h>
+#include <glm\mat4x4.hpp>
+#include <glm\vec2.hpp>
+#include <glm\vec3.hpp>
+#include <utility>
+#include <vector>
+
+#include "UniformBlocks.h"
+
+namespace GameEngine
+{
+  class Camera3D;
+
+  /** \brief Clustered forward lighting: the view frustum is split into TILES_X * TILES_Y screen tiles times DEPTH_SLICES exponential depth
+  * slices, and every point and spot light is assigned on the CPU to the clusters its range (where it fades under 1/256) reaches. The
+  * fragment shaders look up the cluster of their fragment and only loop over its lights, so hundreds of lights cost about as much as
+  * the few that overlap a pixel. The lights, the grid and the light lists are shader storage buffers at fixed binding points:
+  *   layout (std430, binding = 4) readonly buffer ClusterPointLights { PointLight pointLights[]; };   // position.w the range
+  *   layout (std430, binding = 5) readonly buffer ClusterSpotLights { SpotLight spotLights[]; };      // position.w the range
+  *   layout (std430, binding = 6) readonly buffer LightGrid
+  *   {
+  *     uvec4 gridSize;     // tiles x, tiles y, depth slices, the number of point lights
+  *     vec4 depthSlicing;  // slice = floor(log(view depth) * x - y), z and w the near and far planes
+  *     uvec2 clusters[];   // the offset and count of the lights of the cluster in lightIndices
+  *   };
+  *   layout (std430, binding = 7) readonly buffer LightIndices { uint lightIndices[]; }; // a point light below gridSize.w, else a spot light
+  * the light structs are the ones of the LightBlock (see UniformBlocks.h). The tiles come from the clip space position of the fragment,
+  * so the shader needs the FrameUniforms block too. The directional lights light everything, they stay in the LightBlock.
+  * It needs OpenGL 4.3 for the storage buffers (see IsSupported) */
+  class LightClusters
+  {
+  public:
+    enum : GLuint { TILES_X = 16, TILES_Y = 9, DEPTH_SLICES = 24 };
+    enum : GLuint { POINT_LIGHTS_BINDING = 4, SPOT_LIGHTS_BINDING = 5, LIGHT_GRID_BINDING = 6, LIGHT_INDICES_BINDING = 7 };
+
+    LightClusters() {}
+    ~LightClusters() { Dispose(); }
+
+    /** \brief Check if the driver supports shader storage buffers */
+    static bool IsSupported();
+
+    void Init();
+    void Dispose();
+
+    /** \brief Removes every light */
+    void Clear();
+    void Add(const PointLight& _light);
+    void Add(const SpotLight& _light);
+
+    /** \brief Assigns the added lights to the clusters of the view of _camera, uploads the lights and the lists and binds the buffers */
+    void Build(const Camera3D& _camera);
+
+    size_t GetNumLights() const noexcept { return m_pointLights.size() + m_spotLights.size(); }
+    /** \brief The lights of the last Build, added up over all the clusters */
+    size_t GetNumLightReferences() const noexcept { return m_lightIndices.size(); }
+
+  private:
+    /** \brief The view space bounds of every cluster, only computed again when the projection changes */
+    void ComputeClusterBounds(const glm::mat4& _projection);
+    /** \brief Adds (cluster, _light) to m_references for every cluster the sphere reaches */
+    void AssignLight(GLuint _light, const glm::vec3& _viewCenter, float _range);
+
+    std::vector<PointLightData> m_pointLights;
+    std::vector<SpotLightData> m_spotLights;
+
+    glm::mat4 m_projection{ 0.0f };
+    float m_near{ 0.1f };
+    float m_far{ 100.0f };
+    glm::vec4 m_depthSlicing{ 0.0f };
+    std::vector<std::pair<glm::vec3, glm::vec3>> m_clusterBounds; ///< min and max, cluster (x, y, slice) at x + (y + slice * TILES_Y) * TILES_X
+
+    std::vector<std::pair<GLuint, GLuint>> m_references; ///< (cluster, light) of the last Build, sorted into m_lightIndices
+    std::vector<glm::uvec2> m_clusters;
+    std::vector<GLuint> m_lightIndices;
+
+    GLuint m_pointLightBuffer{ 0 };
+    GLuint m_spotLightBuffer{ 0 };
+    GLuint m_gridBuffer{ 0 };
+    GLuint m_indexBuffer{ 0 };
+  };
+}
@@ -1,7 +1,26 @@
 #include "Lights.h"
+#include "UniformBlocks.h"
 
 namespace GameEngine
 {
+  const std::vector<UniformHandle>& BaseLight::GetMemberUniforms(GLSLProgram& _shader, const std::string& _uniformName,
+    std::initializer_list<const char*> _members)
+  {
+    if (&_shader == m_uniformShader && _shader.GetProgramID() == m_uniformProgram && _uniformName == m_uniformName)
+    {
+      return m_uniforms;
+    }
+    m_uniformShader = &_shader;
+    m_uniformProgram = _shader.GetProgramID();
+    m_uniformName = _uniformName;
+    m_uniforms.clear();
+    for (const char* member : _members)
+    {
+      m_uniforms.push_back(_shader.GetUniform(_uniformName + "." + member));
+    }
+    return m_uniforms;
+  }
+
   // ------------------------- POINT LIGHT ------------------------------------
 
   PointLight::PointLight(const glm::vec3& _position,
@@ -36,15 +55,23 @@ namespace GameEngine
   }
   void PointLight::UploadToShader(GLSLProgram& _shader, const std::string& _uniformName)
   {
-    _shader.UploadValue(_uniformName + ".position", m_position);
-    _shader.UploadValue(_uniformName + ".ambient", m_ambient);
-    _shader.UploadValue(_uniformName + ".diffuse", m_diffuse);
-    _shader.UploadValue(_uniformName + ".specular", m_specular);
-    _shader.UploadValue(_uniformName + ".constant", m_attenuation.m_constant);
-    _shader.UploadValue(_uniformName + ".linear", m_attenuation.m_linear);
-    _shader.UploadValue(_uniformName + ".quadratic", m_attenuation.m_quadratic);
-    _shader.UploadValue(_uniformName + ".color", m_color);
-
+    const std::vector<UniformHandle>& uniforms = GetMemberUniforms(_shader, _uniformName,
+      { "position", "ambient", "diffuse", "specular", "constant", "linear", "quadratic", "color" });
+    _shader.UploadValue(uniforms[0], m_position);
+    _shader.UploadValue(uniforms[1], m_ambient);
+    _shader.UploadValue(uniforms[2], m_diffuse);
+    _shader.UploadValue(uniforms[3], m_specular);
+    _shader.UploadValue(uniforms[4], m_attenuation.m_constant);
+    _shader.UploadValue(uniforms[5], m_attenuation.m_linear);
+    _shader.UploadValue(uniforms[6], m_attenuation.m_quadratic);
+    _shader.UploadValue(uniforms[7], m_color);
+  }
+  void PointLight::WriteTo(PointLightData& _data) const
+  {
+    _data.position = glm::vec4(m_position, 1.0f);
+    _data.color = glm::vec4(m_color, 1.0f);
+    _data.intensities = glm::vec4(m_ambient, m_diffuse, m_specular, 0.0f);
+    _data.attenuation = glm::vec4(m_attenuation.m_constant, m_attenuation.m_linear, m_attenuation.m_quadratic, 0.0f);
   }
 
 
@@ -87,17 +114,28 @@ namespace GameEngine
   }
   void SpotLight::UploadToShader(GLSLProgram& _shader, const std::string& _uniformName)
   {
-    _shader.UploadValue(_uniformName + ".position", m_position);
-    _shader.UploadValue(_uniformName + ".direction", m_direction);
-    _shader.UploadValue(_uniformName + ".ambient", m_ambient);
-    _shader.UploadValue(_uniformName + ".diffuse", m_diffuse);
-    _shader.UploadValue(_uniformName + ".specular", m_specular);
-    _shader.UploadValue(_uniformName + ".constant", m_attenuation.m_constant);
-    _shader.UploadValue(_uniformName + ".linear", m_attenuation.m_linear);
-    _shader.UploadValue(_uniformName + ".quadratic", m_attenuation.m_quadratic);
-    _shader.UploadValue(_uniformName + ".cutOff", m_cutOff);
-    _shader.UploadValue(_uniformName + ".outerCutOff", m_outerCutOff);
-    _shader.UploadValue(_uniformName + ".color", m_color);
+    const std::vector<UniformHandle>& uniforms = GetMemberUniforms(_shader, _uniformName,
+      { "position", "direction", "ambient", "diffuse", "specular", "constant", "linear", "quadratic", "cutOff", "outerCutOff", "color" });
+    _shader.UploadValue(uniforms[0], m_position);
+    _shader.UploadValue(uniforms[1], m_direction);
+    _shader.UploadValue(uniforms[2], m_ambient);
+    _shader.UploadValue(uniforms[3], m_diffuse);
+    _shader.UploadValue(uniforms[4], m_specular);
+    _shader.UploadValue(uniforms[5], m_attenuation.m_constant);
+    _shader.UploadValue(uniforms[6], m_attenuation.m_linear);
+    _shader.UploadValue(uniforms[7], m_attenuation.m_quadratic);
+    _shader.UploadValue(uniforms[8], m_cutOff);
+    _shader.UploadValue(uniforms[9], m_outerCutOff);
+    _shader.UploadValue(uniforms[10], m_color);
+  }
+  void SpotLight::WriteTo(SpotLightData& _data) const
+  {
+    _data.position = glm::vec4(m_position, 1.0f);
+    _data.direction = glm::vec4(m_direction, 0.0f);
+    _data.color = glm::vec4(m_color, 1.0f);
+    _data.intensities = glm::vec4(m_ambient, m_diffuse, m_specular, 0.0f);
+    _data.attenuation = glm::vec4(m_attenuation.m_constant, m_attenuation.m_linear, m_attenuation.m_quadratic, 0.0f);
+    _data.cutOffs = glm::vec4(m_cutOff, m_outerCutOff, 0.0f, 0.0f);
   }
 
   // ------------------------- DIRECTIONAL LIGHT ------------------------------------
@@ -123,10 +161,18 @@ namespace GameEngine
   }
   void DirectionalLight::UploadToShader(GLSLProgram& _shader, const std::string& _uniformName)
   {
-    _shader.UploadValue(_uniformName + ".direction", m_direction);
-    _shader.UploadValue(_uniformName + ".ambient", m_ambient);
-    _shader.UploadValue(_uniformName + ".diffuse", m_diffuse);
-    _shader.UploadValue(_uniformName + ".specular", m_specular);
-    _shader.UploadValue(_uniformName + ".color", m_color);
+    const std::vector<UniformHandle>& uniforms = GetMemberUniforms(_shader, _uniformName,
+      { "direction", "ambient", "diffuse", "specular", "color" });
+    _shader.UploadValue(uniforms[0], m_direction);
+    _shader.UploadValue(uniforms[1], m_ambient);
+    _shader.UploadValue(uniforms[2], m_diffuse);
+    _shader.UploadValue(uniforms[3], m_specular);
+    _shader.UploadValue(uniforms[4], m_color);
+  }
+  void DirectionalLight::WriteTo(DirectionalLightData& _data) const
+  {
+    _data.direction = glm::vec4(m_direction, 0.0f);
+    _data.color = glm::vec4(m_color, 1.0f);
+    _data.intensities = glm::vec4(m_ambient, m_diffuse, m_specular, 0.0f);
   }
 }
\ No newline at end of file
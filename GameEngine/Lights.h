@@ -1,11 +1,17 @@
 #pragma once
 
 #include <glm\vec3.hpp>
+#include <initializer_list>
 #include <string>
+#include <vector>
 #include "GLSLProgram.h"
 
 namespace GameEngine
 {
+  struct PointLightData;
+  struct SpotLightData;
+  struct DirectionalLightData;
+
   struct Attenuation
   {
     Attenuation(float _constant, float _linear, float _quadratic) :
@@ -40,6 +46,17 @@ namespace GameEngine
     float m_diffuse{ 1.0f };
     //the specular intensity
     float m_specular{ 1.0f };
+
+    //gets the handles of the _members of the uniform struct _uniformName, in their order. They're only looked up when the shader or the
+    //struct changed since the last upload, so uploading the light to the same struct every frame builds no names
+    const std::vector<UniformHandle>& GetMemberUniforms(GLSLProgram& _shader, const std::string& _uniformName,
+      std::initializer_list<const char*> _members);
+  private:
+    //what the handles were looked up for
+    const GLSLProgram* m_uniformShader{ nullptr };
+    ProgramID m_uniformProgram{ 0 };
+    std::string m_uniformName;
+    std::vector<UniformHandle> m_uniforms;
   };
 
   class PointLight : public BaseLight
@@ -56,6 +73,8 @@ namespace GameEngine
       float _constant, float _linear, float _quadratic);
 
     void UploadToShader(GLSLProgram& _shader, const std::string& _uniformName) override;
+    //writes the light in the std140 layout of the LightBlock (see UniformBlocks.h)
+    void WriteTo(PointLightData& _data) const;
 
     void SetPosition(const glm::vec3& _position) { m_position = _position; }
 
@@ -89,6 +108,7 @@ namespace GameEngine
       float _cutOff, float _outerCutOff);
 
     void UploadToShader(GLSLProgram& _shader, const std::string& _uniformName) override;
+    void WriteTo(SpotLightData& _data) const;
 
     void SetDirection(const glm::vec3& _direction) { m_direction = _direction; }
     void SetInnerCutoff(float _cutoff) { m_cutOff = _cutoff; }
@@ -113,6 +133,7 @@ namespace GameEngine
     void Init(const glm::vec3& _direction, const float& _ambient, const float& _diffuse, const float& _specular);
 
     void UploadToShader(GLSLProgram& _shader, const std::string& _uniformName) override;
+    void WriteTo(DirectionalLightData& _data) const;
 
     void SetDirection(const glm::vec3& _direction) { m_direction = _direction; }
 
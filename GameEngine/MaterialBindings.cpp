@@ -0,0 +1,53 @@
+#include "MaterialBindings.h"
+
+#include <map>
+
+#include "RenderState.h"
+
+namespace GameEngine
+{
+  MaterialBindings::MaterialBindings(const std::vector<GLTexture>& _textures) :
+    m_textures(_textures)
+  {
+    //the textures of a type are numbered from 1 in their order
+    std::map<AssetId, GLuint> numbers;
+    m_samplerNames.reserve(m_textures.size());
+    for (const GLTexture& texture : m_textures)
+    {
+      m_samplerNames.push_back("material." + AssetIds::GetName(texture.type) + std::to_string(++numbers[texture.type]));
+    }
+  }
+
+  void MaterialBindings::Bind(GLSLProgram& _shaderProgram) const
+  {
+    const ProgramLocations& locations = GetLocations(_shaderProgram);
+    RenderState& state = RenderState::Get();
+    for (GLuint i = 0; i < m_textures.size(); i++)
+    {
+      state.BindTexture(i, GL_TEXTURE_2D, m_textures[i].id, m_textures[i].sampler);
+      glUniform1i(locations.samplers[i], i);
+    }
+    glUniform1f(locations.shininess, m_shininess);
+  }
+
+  const MaterialBindings::ProgramLocations& MaterialBindings::GetLocations(GLSLProgram& _shaderProgram) const
+  {
+    for (const ProgramLocations& locations : m_programs)
+    {
+      if (locations.program == _shaderProgram.GetProgramID())
+      {
+        return locations;
+      }
+    }
+    ProgramLocations locations;
+    locations.program = _shaderProgram.GetProgramID();
+    locations.samplers.reserve(m_samplerNames.size());
+    for (const std::string& name : m_samplerNames)
+    {
+      locations.samplers.push_back(_shaderProgram.GetUniformLocation(name));
+    }
+    locations.shininess = _shaderProgram.GetUniformLocation("material.shininess");
+    m_programs.push_back(std::move(locations));
+    return m_programs.back();
+  }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <GL\glew.h>
+#include <string>
+#include <vector>
+
+#include "GLSLProgram.h"
+#include "GLTexture.h"
+
+namespace GameEngine
+{
+  /** \brief The textures of a material resolved once into what a draw binds: every texture gets its sampler uniform name
+  * ("material." + type + number, e.g. material.texture_diffuse1) and its texture unit when the material is made, the uniform locations
+  * when it is first bound with a shader program. From then on Bind() is only integer GL calls, no strings and no allocations */
+  class MaterialBindings
+  {
+  public:
+    MaterialBindings() {}
+    explicit MaterialBindings(const std::vector<GLTexture>& _textures);
+    ~MaterialBindings() {}
+
+    /** \brief Binds every texture to its unit (through RenderState, so the textures already bound are skipped) and sampler and uploads
+    * material.shininess, the locations of a new _shaderProgram are looked up once */
+    void Bind(GLSLProgram& _shaderProgram) const;
+
+    const std::vector<GLTexture>& GetTextures() const noexcept { return m_textures; }
+
+  private:
+    /** \brief The locations of the uniforms in one shader program */
+    struct ProgramLocations
+    {
+      ProgramID program;
+      std::vector<UniformLocation> samplers; ///< by texture
+      UniformLocation shininess;
+    };
+
+    /** \brief The locations for _shaderProgram, looked up if it wasn't bound before */
+    const ProgramLocations& GetLocations(GLSLProgram& _shaderProgram) const;
+
+    std::vector<GLTexture> m_textures;
+    std::vector<std::string> m_samplerNames; ///< by texture, only for the lookups
+    float m_shininess{ 8.0f };
+    mutable std::vector<ProgramLocations> m_programs; ///< a material is drawn with one or two programs, so a short search beats a map
+  };
+}
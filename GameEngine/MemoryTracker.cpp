@@ -0,0 +1,127 @@
+#include "MemoryTracker.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace GameEngine
+{
+  namespace
+  {
+    const char* const MEMORY_TAG_NAMES[NUM_MEMORY_TAGS] = { "General", "Rendering", "AI", "Assets", "ECS" };
+
+    //operator new already aligns to this, more has to be made room for
+    constexpr std::size_t DEFAULT_ALIGNMENT{ alignof(std::max_align_t) };
+  }
+
+  MemoryTracker& MemoryTracker::Get()
+  {
+    static MemoryTracker tracker;
+    return tracker;
+  }
+
+  void* MemoryTracker::Allocate(std::size_t _size, std::size_t _alignment, MemoryTag _tag)
+  {
+    //through the global operator new, so the allocation is counted by FrameStats as well
+    void* memory = nullptr;
+    if (_alignment <= DEFAULT_ALIGNMENT)
+    {
+      memory = ::operator new(_size);
+    }
+    else
+    {
+      //the block is moved up to the alignment, the pointer operator new gave is kept right before it
+      char* block = static_cast<char*>(::operator new(_size + _alignment + sizeof(void*)));
+      const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(block + sizeof(void*));
+      char* aligned = reinterpret_cast<char*>((address + _alignment - 1) & ~static_cast<std::uintptr_t>(_alignment - 1));
+      std::memcpy(aligned - sizeof(void*), &block, sizeof(void*));
+      memory = aligned;
+    }
+
+    TagCounters& tag = m_tags[_tag];
+    tag.blocks.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t bytes = tag.bytes.fetch_add(_size, std::memory_order_relaxed) + _size;
+    std::size_t highWater = tag.highWater.load(std::memory_order_relaxed);
+    while (bytes > highWater && !tag.highWater.compare_exchange_weak(highWater, bytes, std::memory_order_relaxed))
+    {
+    }
+
+    const std::size_t budget = tag.budget.load(std::memory_order_relaxed);
+    if (budget > 0 && bytes > budget && !tag.reported.exchange(true, std::memory_order_relaxed))
+    {
+      std::cout << "WARNING::MEMORY::OVER_BUDGET\n" << MEMORY_TAG_NAMES[_tag] << ": " << bytes << " > " << budget << std::endl;
+    }
+    return memory;
+  }
+
+  void MemoryTracker::Free(void* _memory, std::size_t _size, std::size_t _alignment, MemoryTag _tag) noexcept
+  {
+    if (!_memory)
+    {
+      return;
+    }
+    TagCounters& tag = m_tags[_tag];
+    tag.blocks.fetch_sub(1, std::memory_order_relaxed);
+    const std::size_t bytes = tag.bytes.fetch_sub(_size, std::memory_order_relaxed) - _size;
+    //back within the budget, the next time over it is reported again
+    if (bytes <= tag.budget.load(std::memory_order_relaxed))
+    {
+      tag.reported.store(false, std::memory_order_relaxed);
+    }
+
+    if (_alignment <= DEFAULT_ALIGNMENT)
+    {
+      ::operator delete(_memory);
+    }
+    else
+    {
+      void* block = nullptr;
+      std::memcpy(&block, static_cast<char*>(_memory) - sizeof(void*), sizeof(void*));
+      ::operator delete(block);
+    }
+  }
+
+  const char* MemoryTracker::GetName(MemoryTag _tag)
+  {
+    return _tag < NUM_MEMORY_TAGS ? MEMORY_TAG_NAMES[_tag] : "Unknown";
+  }
+
+  void MemoryTracker::SetBudget(MemoryTag _tag, std::size_t _budget)
+  {
+    m_tags[_tag].budget.store(_budget, std::memory_order_relaxed);
+    m_tags[_tag].reported.store(false, std::memory_order_relaxed);
+  }
+
+  bool MemoryTracker::IsOverBudget(MemoryTag _tag) const noexcept
+  {
+    const std::size_t budget = m_tags[_tag].budget.load(std::memory_order_relaxed);
+    return budget > 0 && GetBytes(_tag) > budget;
+  }
+
+  void MemoryTracker::PrintReport() const
+  {
+    std::cout << "MEMORY::REPORT\n";
+    for (unsigned int i = 0; i < NUM_MEMORY_TAGS; i++)
+    {
+      const MemoryTag tag = static_cast<MemoryTag>(i);
+      std::cout << MEMORY_TAG_NAMES[i] << ": " << GetBytes(tag) << " bytes in " << GetNumBlocks(tag) << " blocks, high-water "
+        << GetHighWater(tag) << ", budget " << m_tags[i].budget.load(std::memory_order_relaxed) << "\n";
+    }
+    std::cout << std::flush;
+  }
+
+  bool MemoryTracker::ReportLeaks() const
+  {
+    bool clean = true;
+    for (unsigned int i = 0; i < NUM_MEMORY_TAGS; i++)
+    {
+      const MemoryTag tag = static_cast<MemoryTag>(i);
+      if (GetNumBlocks(tag) > 0)
+      {
+        std::cout << "ERROR::MEMORY::LEAK\n" << MEMORY_TAG_NAMES[i] << ": " << GetBytes(tag) << " bytes in " << GetNumBlocks(tag)
+          << " blocks" << std::endl;
+        clean = false;
+      }
+    }
+    return clean;
+  }
+}
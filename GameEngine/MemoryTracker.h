@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <vector>
+
+namespace GameEngine
+{
+  //the subsystems the tracked memory is counted for
+  enum MemoryTag : unsigned int
+  {
+    MEMORY_GENERAL,
+    MEMORY_RENDERING,
+    MEMORY_AI,
+    MEMORY_ASSETS,
+    MEMORY_ECS,
+    NUM_MEMORY_TAGS
+  };
+
+  /** \brief Counts the memory allocated through it per subsystem (MemoryTag): the bytes and blocks in use, the high-water mark of the
+   *  bytes and a budget. Whatever is still in use when the game shuts down is reported as leaked (see IMainGame). The memory goes through
+   *  Allocate and Free, the containers use it through TrackedAllocator and the arenas and pools (Allocators.h) take their blocks from it.
+   *  The counters are relaxed atomics, so any thread can allocate */
+  class MemoryTracker
+  {
+  public:
+    static MemoryTracker& Get();
+
+    // _size bytes aligned to _alignment (a power of two), counted for _tag. Throws std::bad_alloc like operator new
+    void* Allocate(std::size_t _size, std::size_t _alignment, MemoryTag _tag);
+    // Frees memory of Allocate, _size and _alignment have to be the ones it was allocated with
+    void Free(void* _memory, std::size_t _size, std::size_t _alignment, MemoryTag _tag) noexcept;
+
+    std::size_t GetBytes(MemoryTag _tag) const noexcept { return m_tags[_tag].bytes.load(std::memory_order_relaxed); }
+    std::size_t GetHighWater(MemoryTag _tag) const noexcept { return m_tags[_tag].highWater.load(std::memory_order_relaxed); }
+    std::size_t GetNumBlocks(MemoryTag _tag) const noexcept { return m_tags[_tag].blocks.load(std::memory_order_relaxed); }
+    static const char* GetName(MemoryTag _tag);
+
+    // The most bytes the subsystem should use, 0 for no budget. Going over it is reported once until it's back within
+    void SetBudget(MemoryTag _tag, std::size_t _budget);
+    bool IsOverBudget(MemoryTag _tag) const noexcept;
+
+    // Prints the bytes in use, the high-water mark and the budget of every subsystem
+    void PrintReport() const;
+    // Prints the subsystems which still have memory in use, returns false if any has
+    bool ReportLeaks() const;
+
+  private:
+    MemoryTracker() {}
+
+    struct TagCounters
+    {
+      std::atomic<std::size_t> bytes{ 0 };
+      std::atomic<std::size_t> highWater{ 0 };
+      std::atomic<std::size_t> blocks{ 0 };
+      std::atomic<std::size_t> budget{ 0 };
+      std::atomic<bool> reported{ false };
+    };
+
+    TagCounters m_tags[NUM_MEMORY_TAGS];
+  };
+
+  /** \brief A standard allocator counting its memory for _Tag, e.g. std::vector<T, TrackedAllocator<T, MEMORY_AI>> (see TrackedVector).
+   *  Stateless, all the allocators of a tag are interchangeable */
+  template<typename T, MemoryTag _Tag>
+  class TrackedAllocator
+  {
+  public:
+    typedef T value_type;
+    template<typename U>
+    struct rebind { typedef TrackedAllocator<U, _Tag> other; };
+
+    TrackedAllocator() noexcept {}
+    template<typename U>
+    TrackedAllocator(const TrackedAllocator<U, _Tag>&) noexcept {}
+
+    T* allocate(std::size_t _count)
+    {
+      if (_count > std::numeric_limits<std::size_t>::max() / sizeof(T))
+      {
+        throw std::bad_alloc();
+      }
+      return static_cast<T*>(MemoryTracker::Get().Allocate(_count * sizeof(T), alignof(T), _Tag));
+    }
+    void deallocate(T* _memory, std::size_t _count) noexcept
+    {
+      MemoryTracker::Get().Free(_memory, _count * sizeof(T), alignof(T), _Tag);
+    }
+  };
+
+  template<typename T, typename U, MemoryTag _Tag>
+  bool operator==(const TrackedAllocator<T, _Tag>&, const TrackedAllocator<U, _Tag>&) noexcept { return true; }
+  template<typename T, typename U, MemoryTag _Tag>
+  bool operator!=(const TrackedAllocator<T, _Tag>&, const TrackedAllocator<U, _Tag>&) noexcept { return false; }
+
+  template<typename T, MemoryTag _Tag>
+  using TrackedVector = std::vector<T, TrackedAllocator<T, _Tag>>;
+}
@@ -1,65 +1,260 @@
 #include "Mesh.h"
+#include "FrameStats.h"
+#include "GameEngine.h"
+#include "RenderState.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <glm\gtc\matrix_transform.hpp>
 
 namespace GameEngine
 {
-  Mesh::Mesh(const std::vector<Vertex>& _vertices, const std::vector<GLuint>& _indices, const std::vector<GLTexture>& _textures,
-    bool _hasAnim, const glm::mat4& _baseModelMatrix)
+  namespace
   {
-    m_vertices = _vertices;
-    m_indices = _indices;
-    m_textures = _textures;
-    m_hasAnimations = _hasAnim;
-    m_baseModelMatrix = _baseModelMatrix;
-    SetupMesh();
-  }
-  Mesh::~Mesh()
-  {
-  }
+    //the largest error of a half float position, as a part of the size of the mesh, above it the positions stay floats
+    constexpr float HALF_POSITION_TOLERANCE = 1.0f / 4096.0f;
+    constexpr std::uint16_t HALF_ONE = 0x3C00;
 
-  void Mesh::Draw(GLSLProgram& _shaderProgram, int _amount)
-  {
-    GLuint diffuseNr = 1;
-    GLuint specularNr = 1;
-    GLuint reflectionNr = 1;
-    GLuint normalNr = 1;
+    std::uint16_t PackHalf(float _value)
+    {
+      std::uint32_t bits;
+      std::memcpy(&bits, &_value, sizeof(bits));
+      const std::uint16_t sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000);
+      const int exponent = static_cast<int>((bits >> 23) & 0xFF);
+      std::uint32_t mantissa = bits & 0x7FFFFF;
+      if (exponent == 0xFF)
+      {
+        //inf and nan
+        return sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0);
+      }
+      const int halfExponent = exponent - 127 + 15;
+      if (halfExponent >= 31)
+      {
+        return sign | 0x7C00;
+      }
+      if (halfExponent <= 0)
+      {
+        //a denormal half (or 0)
+        if (halfExponent < -10)
+        {
+          return sign;
+        }
+        mantissa |= 0x800000;
+        const int shift = 14 - halfExponent;
+        std::uint16_t half = static_cast<std::uint16_t>(mantissa >> shift);
+        half += (mantissa >> (shift - 1)) & 1;
+        return sign | half;
+      }
+      //rounded to nearest, a carry out of the mantissa correctly bumps the exponent
+      std::uint16_t half = static_cast<std::uint16_t>(sign | (halfExponent << 10) | (mantissa >> 13));
+      half += (mantissa >> 12) & 1;
+      return half;
+    }
 
-    for (GLuint i = 0; i < m_textures.size(); i++)
+    float UnpackHalf(std::uint16_t _half)
     {
-      GLuint number;
-      std::string name = m_textures[i].type;
+      const int exponent = (_half >> 10) & 0x1F;
+      const int mantissa = _half & 0x3FF;
+      const float sign = (_half & 0x8000) != 0 ? -1.0f : 1.0f;
+      if (exponent == 0)
+      {
+        return sign * std::ldexp(static_cast<float>(mantissa), -24);
+      }
+      if (exponent == 31)
+      {
+        return sign * HUGE_VALF;
+      }
+      return sign * std::ldexp(static_cast<float>(mantissa | 0x400), exponent - 25);
+    }
+
+    //GL_INT_2_10_10_10_REV, normalized, w is 0
+    std::uint32_t PackSnorm10(const glm::vec3& _value)
+    {
+      auto component = [](float _c)
+      {
+        const int packed = static_cast<int>(std::round(std::min(std::max(_c, -1.0f), 1.0f) * 511.0f));
+        return static_cast<std::uint32_t>(packed) & 0x3FF;
+      };
+      return component(_value.x) | (component(_value.y) << 10) | (component(_value.z) << 20);
+    }
+
+    std::uint16_t PackUnorm16(float _value)
+    {
+      return static_cast<std::uint16_t>(std::round(std::min(std::max(_value, 0.0f), 1.0f) * 65535.0f));
+    }
+
+    template <typename T>
+    void Append(std::vector<unsigned char>& _buffer, const T& _value)
+    {
+      const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&_value);
+      _buffer.insert(_buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    Mesh::Layout ChooseLayout(const Vertex* _vertices, GLsizeiptr _numVertices, bool _hasAnimations)
+    {
+      Mesh::Layout layout;
+      glm::vec3 min = _numVertices > 0 ? _vertices[0].m_position : glm::vec3(0.0f);
+      glm::vec3 max = min;
+      layout.m_unormUVs = true;
+      for (GLsizeiptr i = 0; i < _numVertices; i++)
+      {
+        const Vertex& vertex = _vertices[i];
+        min = glm::vec3(std::min(min.x, vertex.m_position.x), std::min(min.y, vertex.m_position.y), std::min(min.z, vertex.m_position.z));
+        max = glm::vec3(std::max(max.x, vertex.m_position.x), std::max(max.y, vertex.m_position.y), std::max(max.z, vertex.m_position.z));
+        layout.m_unormUVs = layout.m_unormUVs && vertex.m_uv.x >= 0.0f && vertex.m_uv.x <= 1.0f && vertex.m_uv.y >= 0.0f && vertex.m_uv.y <= 1.0f;
+      }
+      const float extent = std::max(max.x - min.x, std::max(max.y - min.y, max.z - min.z));
 
-      if (name == "texture_diffuse")
+      //halves lose precision away from the origin, so a small mesh far from it keeps its floats
+      layout.m_halfPositions = true;
+      const float tolerance = extent * HALF_POSITION_TOLERANCE;
+      for (GLsizeiptr i = 0; i < _numVertices && layout.m_halfPositions; i++)
       {
-        number = diffuseNr++;
+        const glm::vec3& position = _vertices[i].m_position;
+        layout.m_halfPositions = std::abs(UnpackHalf(PackHalf(position.x)) - position.x) <= tolerance &&
+          std::abs(UnpackHalf(PackHalf(position.y)) - position.y) <= tolerance &&
+          std::abs(UnpackHalf(PackHalf(position.z)) - position.z) <= tolerance;
       }
-      else if (name == "texture_specular")
+
+      layout.m_stride = (layout.m_halfPositions ? 4 * sizeof(std::uint16_t) : 3 * sizeof(float)) + 3 * sizeof(std::uint32_t);
+      if (_hasAnimations)
       {
-        number = specularNr++;
+        layout.m_stride += 4 * sizeof(std::uint8_t) + 4 * sizeof(std::uint16_t);
       }
-      else if (name == "texture_reflection")
+      return layout;
+    }
+
+    /** \brief A sphere around all the vertices, centered on their box (not the smallest one, but close and in two passes) */
+    AABB CalcBoundingBox(const Vertex* _vertices, GLsizeiptr _numVertices)
+    {
+      if (_numVertices == 0)
       {
-        number = reflectionNr++;
+        return AABB();
       }
-      else if (name == "texture_normal")
+      glm::vec3 min = _vertices[0].m_position;
+      glm::vec3 max = min;
+      for (GLsizeiptr i = 1; i < _numVertices; i++)
+      {
+        const glm::vec3& position = _vertices[i].m_position;
+        min = glm::vec3(std::min(min.x, position.x), std::min(min.y, position.y), std::min(min.z, position.z));
+        max = glm::vec3(std::max(max.x, position.x), std::max(max.y, position.y), std::max(max.z, position.z));
+      }
+      return AABB(min, max);
+    }
+
+    //around the center of _box, not the smallest sphere but a close one
+    glm::vec4 CalcBoundingSphere(const Vertex* _vertices, GLsizeiptr _numVertices, const AABB& _box)
+    {
+      if (_numVertices == 0)
+      {
+        return glm::vec4(0.0f);
+      }
+      const glm::vec3 center = _box.Center();
+      float radius2 = 0.0f;
+      for (GLsizeiptr i = 0; i < _numVertices; i++)
+      {
+        const glm::vec3 offset = _vertices[i].m_position - center;
+        radius2 = std::max(radius2, glm::dot(offset, offset));
+      }
+      return glm::vec4(center, std::sqrt(radius2));
+    }
+
+    //the uv units per unit of the vertex positions, the square root of the uv area over the surface of the triangles
+    float CalcUvDensity(const Vertex* _vertices, const GLuint* _indices, GLsizeiptr _numIndices)
+    {
+      float uvArea = 0.0f;
+      float area = 0.0f;
+      for (GLsizeiptr i = 0; i + 2 < _numIndices; i += 3)
       {
-        number = normalNr++;
+        const Vertex& a = _vertices[_indices[i]];
+        const Vertex& b = _vertices[_indices[i + 1]];
+        const Vertex& c = _vertices[_indices[i + 2]];
+        area += glm::length(glm::cross(b.m_position - a.m_position, c.m_position - a.m_position));
+        const glm::vec2 uvB = b.m_uv - a.m_uv;
+        const glm::vec2 uvC = c.m_uv - a.m_uv;
+        uvArea += std::abs(uvB.x * uvC.y - uvB.y * uvC.x);
       }
-      // Upload the texture to the shader
-      _shaderProgram.UploadValue("material." + name + std::to_string(number), i, m_textures.at(i));
+      return area > 0.0f ? std::sqrt(uvArea / area) : 0.0f;
     }
-    glActiveTexture(GL_TEXTURE0); // Always good practice to set everything back to defaults once configured.
+  }
+
+  Mesh::Mesh(std::vector<Vertex> _vertices, std::vector<GLuint> _indices, const std::vector<GLTexture>& _textures,
+    bool _hasAnim, const glm::mat4& _baseModelMatrix, bool _keepCpuData, const std::vector<Lod>& _lods)
+  {
+    m_vertices = std::move(_vertices);
+    m_indices = std::move(_indices);
+    m_numVertices = m_vertices.size();
+    SetLods(_lods, m_indices.size());
+    m_hasCpuData = true;
+    m_material = MaterialBindings(_textures);
+    m_hasAnimations = _hasAnim;
+    m_baseModelMatrix = _baseModelMatrix;
+    SetupMesh(m_vertices.data(), m_vertices.size(), m_indices.data(), m_indices.size());
+    if (!_keepCpuData)
+    {
+      ReleaseCpuData();
+    }
+  }
+  Mesh::Mesh(const Vertex* _vertices, GLuint _numVertices, const GLuint* _indices, GLuint _numIndices, const std::vector<GLTexture>& _textures,
+    bool _hasAnim, const glm::mat4& _baseModelMatrix, bool _keepCpuData, const std::vector<Lod>& _lods)
+  {
+    if (_keepCpuData)
+    {
+      m_vertices.assign(_vertices, _vertices + _numVertices);
+      m_indices.assign(_indices, _indices + _numIndices);
+    }
+    m_numVertices = _numVertices;
+    SetLods(_lods, _numIndices);
+    m_hasCpuData = _keepCpuData;
+    m_material = MaterialBindings(_textures);
+    m_hasAnimations = _hasAnim;
+    m_baseModelMatrix = _baseModelMatrix;
+    SetupMesh(_vertices, _numVertices, _indices, _numIndices);
+  }
+  Mesh::~Mesh()
+  {
+  }
 
-    // Also set each mesh's shininess property to a default value (if you want you could extend this to another mesh property and possibly change this value)
-    _shaderProgram.UploadValue("material.shininess", 8.0f);
+  void Mesh::Draw(GLSLProgram& _shaderProgram, int _amount) const
+  {
+    m_material.Bind(_shaderProgram);
     _shaderProgram.UploadValue("baseModelMatrix", m_baseModelMatrix);
     //Draw mesh
-    glBindVertexArray(m_VAO);
+    RenderState::Get().BindVertexArray(m_VAO);
 
-    glDrawElementsInstanced(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, 0, _amount);
+    FrameStats::Get().Add(STAT_DRAW_CALLS);
+    glDrawElementsInstanced(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, 0, _amount);
+  }
 
-    glBindVertexArray(0);
+  void Mesh::DrawLod(GLSLProgram& _shaderProgram, GLuint _lod, int _amount, GLuint _baseInstance) const
+  {
+    const Lod& lod = m_lods[std::min(_lod, static_cast<GLuint>(m_lods.size()) - 1)];
+    m_material.Bind(_shaderProgram);
+    _shaderProgram.UploadValue("baseModelMatrix", m_baseModelMatrix);
+    RenderState::Get().BindVertexArray(m_VAO);
+
+    const GLvoid* offset = (GLvoid*)(lod.m_firstIndex * sizeof(GLuint));
+    FrameStats::Get().Add(STAT_DRAW_CALLS);
+    if (_baseInstance == 0)
+    {
+      glDrawElementsInstanced(GL_TRIANGLES, lod.m_numIndices, GL_UNSIGNED_INT, offset, _amount);
+    }
+    else
+    {
+      glDrawElementsInstancedBaseInstance(GL_TRIANGLES, lod.m_numIndices, GL_UNSIGNED_INT, offset, _amount, _baseInstance);
+    }
+  }
+
+  void Mesh::DrawIndirect(GLSLProgram& _shaderProgram, GLintptr _commandOffset) const
+  {
+    m_material.Bind(_shaderProgram);
+    _shaderProgram.UploadValue("baseModelMatrix", m_baseModelMatrix);
+    RenderState::Get().BindVertexArray(m_VAO);
+
+    FrameStats::Get().Add(STAT_DRAW_CALLS);
+    glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (GLvoid*)_commandOffset);
   }
 
   void Mesh::Dispose()
@@ -67,7 +262,7 @@ namespace GameEngine
     //delete the vao's and vbo's and reset them to 0
     if (m_VAO != 0)
     {
-      glDeleteVertexArrays(1, &m_VAO);
+      RenderState::Get().DeleteVertexArrays(1, &m_VAO);
       m_VAO = 0;
     }
 
@@ -89,10 +284,82 @@ namespace GameEngine
       m_MBO = 0;
     }
 
+    if (m_TBO != 0)
+    {
+      glDeleteBuffers(1, &m_TBO);
+      m_TBO = 0;
+    }
+
+  }
+
+  GLuint Mesh::SelectLod(float _screenSize, float _lodScreenSize)
+  {
+    GLuint lod = 0;
+    for (float size = _lodScreenSize; _screenSize < size && lod < MAX_LODS - 1; size *= 0.5f)
+    {
+      lod++;
+    }
+    return lod;
+  }
+
+  void Mesh::SetLods(const std::vector<Lod>& _lods, GLuint _numIndices)
+  {
+    m_lods = _lods;
+    if (m_lods.empty())
+    {
+      m_lods.push_back({ 0, _numIndices });
+    }
+    m_numIndices = m_lods[0].m_numIndices;
+  }
+
+  void Mesh::ReleaseCpuData()
+  {
+    //swapped with empty vectors, clear() would keep the memory
+    std::vector<Vertex>().swap(m_vertices);
+    std::vector<GLuint>().swap(m_indices);
+    m_hasCpuData = false;
+  }
+
+  void Mesh::UploadInstanceTimes(const std::vector<float>& _times)
+  {
+    if (m_TBO == 0)
+    {
+      glGenBuffers(1, &m_TBO);
+      RenderState::Get().BindVertexArray(m_VAO);
+      glBindBuffer(GL_ARRAY_BUFFER, m_TBO);
+      glEnableVertexAttribArray(INSTANCE_TIME_ATTRIBUTE);
+      glVertexAttribPointer(INSTANCE_TIME_ATTRIBUTE, 1, GL_FLOAT, GL_FALSE, sizeof(float), (GLvoid*)0);
+      glVertexAttribDivisor(INSTANCE_TIME_ATTRIBUTE, 1);
+      RenderState::Get().BindVertexArray(0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, m_TBO);
+    FrameStats::Get().Add(STAT_BYTES_UPLOADED, _times.size() * sizeof(float));
+    //orphan the old storage, the last draw may still read it
+    glBufferData(GL_ARRAY_BUFFER, _times.size() * sizeof(float), _times.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  void Mesh::SetInstanceBuffer(GLuint _buffer)
+  {
+    if (m_hasAnimations)
+    {
+      return;
+    }
+    m_instanceBuffer = _buffer;
+    RenderState::Get().BindVertexArray(m_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, _buffer != 0 ? _buffer : m_MBO);
+    SetInstanceMatrixAttributes(INSTANCE_MATRIX_ATTRIBUTE);
+    RenderState::Get().BindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
   }
 
-  void Mesh::SetupMesh()
+  void Mesh::SetupMesh(const Vertex* _vertices, GLsizeiptr _numVertices, const GLuint* _indices, GLsizeiptr _numIndices)
   {
+    //no GL context to upload to, the mesh only has what it keeps on the CPU
+    if (IsHeadless())
+    {
+      return;
+    }
     if (m_VAO == 0)
     {
       glGenVertexArrays(1, &m_VAO);
@@ -110,58 +377,113 @@ namespace GameEngine
       glGenBuffers(1, &m_MBO);
     }
 
-    glBindVertexArray(m_VAO);
+    RenderState::Get().BindVertexArray(m_VAO);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
 
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, _numIndices * sizeof(GLuint), _indices, GL_STATIC_DRAW);
 
-    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, m_indices.size() * sizeof(GLuint), m_indices.data());
 
+    //the vertices packed into the layout of this mesh, interleaved
+    m_layout = ChooseLayout(_vertices, _numVertices, m_hasAnimations);
+    m_boundingBox = CalcBoundingBox(_vertices, _numVertices);
+    m_boundingSphere = CalcBoundingSphere(_vertices, _numVertices, m_boundingBox);
+    //of LOD 0, the others cover the same uvs with fewer triangles
+    m_uvDensity = CalcUvDensity(_vertices, _indices, std::min<GLsizeiptr>(m_numIndices, _numIndices));
+    std::vector<unsigned char> packed;
+    packed.reserve(_numVertices * m_layout.m_stride);
+    for (GLsizeiptr i = 0; i < _numVertices; i++)
+    {
+      const Vertex& vertex = _vertices[i];
+      if (m_layout.m_halfPositions)
+      {
+        const std::uint16_t position[4] = { PackHalf(vertex.m_position.x), PackHalf(vertex.m_position.y), PackHalf(vertex.m_position.z), HALF_ONE };
+        Append(packed, position);
+      }
+      else
+      {
+        Append(packed, vertex.m_position);
+      }
+      Append(packed, PackSnorm10(vertex.m_normal));
+      const std::uint16_t uv[2] = { m_layout.m_unormUVs ? PackUnorm16(vertex.m_uv.x) : PackHalf(vertex.m_uv.x),
+        m_layout.m_unormUVs ? PackUnorm16(vertex.m_uv.y) : PackHalf(vertex.m_uv.y) };
+      Append(packed, uv);
+      Append(packed, PackSnorm10(vertex.m_tangents));
+      if (m_hasAnimations)
+      {
+        //the unused slots get bone 0 with no weight
+        std::uint8_t boneIDs[4];
+        std::uint16_t weights[4];
+        for (GLuint b = 0; b < 4; b++)
+        {
+          const bool used = vertex.m_boneIDs[b] >= 0 && vertex.m_boneIDs[b] <= 0xFF;
+          boneIDs[b] = static_cast<std::uint8_t>(used ? vertex.m_boneIDs[b] : 0);
+          weights[b] = used ? PackUnorm16(vertex.m_weights[b]) : 0;
+        }
+        Append(packed, boneIDs);
+        Append(packed, weights);
+      }
+    }
 
     glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
 
-    glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(Vertex), nullptr, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, packed.size(), packed.data(), GL_STATIC_DRAW);
 
-    glBufferSubData(GL_ARRAY_BUFFER, 0, m_vertices.size() * sizeof(Vertex), m_vertices.data());
+    const GLuint attributeLocation = SetVertexAttributes(m_layout, m_hasAnimations);
+    if (!m_hasAnimations)
+    {
+      glBindBuffer(GL_ARRAY_BUFFER, m_MBO);
+      SetInstanceMatrixAttributes(attributeLocation);
+    }
+    RenderState::Get().BindVertexArray(0);
+  }
 
+  GLuint Mesh::SetVertexAttributes(const Layout& _layout, bool _hasAnimations)
+  {
     GLuint attributeLocation = 0;
+    size_t offset = 0;
 
     //Vertex position
     glEnableVertexAttribArray(attributeLocation);
-    glVertexAttribPointer(attributeLocation++, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, m_position));
+    glVertexAttribPointer(attributeLocation++, 3, _layout.m_halfPositions ? GL_HALF_FLOAT : GL_FLOAT, GL_FALSE, _layout.m_stride, (GLvoid*)offset);
+    offset += _layout.m_halfPositions ? 4 * sizeof(std::uint16_t) : 3 * sizeof(float);
 
     //Vertex normals
     glEnableVertexAttribArray(attributeLocation);
-    glVertexAttribPointer(attributeLocation++, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, m_normal));
+    glVertexAttribPointer(attributeLocation++, 4, GL_INT_2_10_10_10_REV, GL_TRUE, _layout.m_stride, (GLvoid*)offset);
+    offset += sizeof(std::uint32_t);
 
     //Vertex texture coords
     glEnableVertexAttribArray(attributeLocation);
-    glVertexAttribPointer(attributeLocation++, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, m_uv));
+    glVertexAttribPointer(attributeLocation++, 2, _layout.m_unormUVs ? GL_UNSIGNED_SHORT : GL_HALF_FLOAT, _layout.m_unormUVs ? GL_TRUE : GL_FALSE,
+      _layout.m_stride, (GLvoid*)offset);
+    offset += 2 * sizeof(std::uint16_t);
 
     //Vertex tangent coords
     glEnableVertexAttribArray(attributeLocation);
-    glVertexAttribPointer(attributeLocation++, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, m_tangents));
+    glVertexAttribPointer(attributeLocation++, 4, GL_INT_2_10_10_10_REV, GL_TRUE, _layout.m_stride, (GLvoid*)offset);
+    offset += sizeof(std::uint32_t);
 
-    if (m_hasAnimations)
+    if (_hasAnimations)
     {
       glEnableVertexAttribArray(attributeLocation);
-      glVertexAttribIPointer(attributeLocation++, 4, GL_INT, sizeof(Vertex), (GLvoid*)offsetof(Vertex, m_boneIDs));
+      glVertexAttribIPointer(attributeLocation++, 4, GL_UNSIGNED_BYTE, _layout.m_stride, (GLvoid*)offset);
+      offset += 4 * sizeof(std::uint8_t);
 
       glEnableVertexAttribArray(attributeLocation);
-      glVertexAttribPointer(attributeLocation++, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, m_weights));
+      glVertexAttribPointer(attributeLocation++, 4, GL_UNSIGNED_SHORT, GL_TRUE, _layout.m_stride, (GLvoid*)offset);
     }
-    else
+    return attributeLocation;
+  }
+
+  void Mesh::SetInstanceMatrixAttributes(GLuint _location, GLintptr _offset)
+  {
+    // Set attribute pointers for matrix (4 times vec4)
+    for (GLuint i = 0; i < 4; i++)
     {
-      glBindBuffer(GL_ARRAY_BUFFER, m_MBO);
-      // Set attribute pointers for matrix (4 times vec4)
-      for (GLint i = 0; i < 4; i++)
-      {
-        glEnableVertexAttribArray(attributeLocation + i);
-        glVertexAttribPointer(attributeLocation + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (GLvoid*)(i * sizeof(glm::vec4)));
-        glVertexAttribDivisor(attributeLocation + i, 1);
-      }
+      glEnableVertexAttribArray(_location + i);
+      glVertexAttribPointer(_location + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (GLvoid*)(_offset + i * sizeof(glm::vec4)));
+      glVertexAttribDivisor(_location + i, 1);
     }
-    glBindVertexArray(0);
   }
 }
\ No newline at end of file
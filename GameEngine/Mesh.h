@@ -1,23 +1,77 @@
 #pragma once
 
+#include "AABB.h"
 #include "Vertex.h"
 #include "GLTexture.h"
 #include "GLSLProgram.h"
+#include "MaterialBindings.h"
 #include <vector>
 #include <glm\mat4x4.hpp>
 
 namespace GameEngine
 {
+  /** \brief The layout glDrawElementsIndirect and glMultiDrawElementsIndirect read from the GL_DRAW_INDIRECT_BUFFER */
+  struct DrawElementsIndirectCommand
+  {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+  };
+
   class Mesh
   {
   public:
+    enum : GLuint { INSTANCE_MATRIX_ATTRIBUTE = 4, INSTANCE_TIME_ATTRIBUTE = 8 }; ///< the instance attributes of static meshes
+    enum : GLuint { MAX_LODS = 8 };
+
+    /** \brief A level of detail of the mesh, a range of its index buffer. All the LODs index the same vertices, LOD 0 comes first */
+    struct Lod
+    {
+      GLuint m_firstIndex;
+      GLuint m_numIndices;
+    };
+
+    /** \brief How the vertices of the mesh are packed on the GPU, picked per mesh from its data by SetupMesh.
+    * Normals and tangents are always signed 10:10:10 (4 bytes each), bone IDs 4 bytes and weights unorm16 only for animated meshes,
+    * the attribute locations are the same as with the CPU Vertex so the shaders don't see a difference */
+    struct Layout
+    {
+      bool m_halfPositions{ false }; ///< half floats when they're precise enough for the size and placement of the mesh, else floats
+      bool m_unormUVs{ false };      ///< unorm16 when all the uvs are in [0, 1], else half floats
+      GLsizei m_stride{ 0 };         ///< bytes per vertex on the GPU
+    };
+
     Mesh() {}
-    Mesh(const std::vector<Vertex>& _vertices, const std::vector<GLuint>& _indices, const std::vector<GLTexture>& _textures,
-      bool _hasAnim, const glm::mat4& _baseModelMatrix);
+    /** \brief Uploads the vertices and indices (moved in) and frees them, unless _keepCpuData keeps them for the CPU (collision, baking, cooking)
+    * \param _lods - the ranges of the LODs in _indices (see MeshSimplifier::GenerateLods), none makes all the indices the only LOD */
+    Mesh(std::vector<Vertex> _vertices, std::vector<GLuint> _indices, const std::vector<GLTexture>& _textures,
+      bool _hasAnim, const glm::mat4& _baseModelMatrix, bool _keepCpuData = false, const std::vector<Lod>& _lods = std::vector<Lod>());
+    /** \brief Uploads the vertices and indices straight from _vertices and _indices (e.g. a mapped cooked model), copies them only if _keepCpuData */
+    Mesh(const Vertex* _vertices, GLuint _numVertices, const GLuint* _indices, GLuint _numIndices, const std::vector<GLTexture>& _textures,
+      bool _hasAnim, const glm::mat4& _baseModelMatrix, bool _keepCpuData = false, const std::vector<Lod>& _lods = std::vector<Lod>());
     ~Mesh();
     /* Mesh functions */
-    void Draw(GLSLProgram& _shaderProgram, int _amount = 1);
+    void Draw(GLSLProgram& _shaderProgram, int _amount = 1) const;
+    /** \brief Draws LOD _lod (the last one if the mesh has fewer) of _amount instances, from instance _baseInstance of the bound instance
+    * buffers on (other than 0 needs OpenGL 4.2) */
+    void DrawLod(GLSLProgram& _shaderProgram, GLuint _lod, int _amount = 1, GLuint _baseInstance = 0) const;
+    /** \brief Draws the mesh with the DrawElementsIndirectCommand at _commandOffset of the bound GL_DRAW_INDIRECT_BUFFER (needs OpenGL 4.0, 4.2 for a baseInstance other than 0) */
+    void DrawIndirect(GLSLProgram& _shaderProgram, GLintptr _commandOffset) const;
     void Dispose();
+    /** \brief Frees the CPU copies of the vertices and indices, the GPU buffers stay */
+    void ReleaseCpuData();
+
+    /** \brief Points the vertex attributes of the bound VAO into the bound GL_ARRAY_BUFFER of vertices in _layout
+    * \return the first location after them (where a static mesh has its instance matrix) */
+    static GLuint SetVertexAttributes(const Layout& _layout, bool _hasAnimations);
+    /** \brief Points the 4 attributes from _location into the bound GL_ARRAY_BUFFER of instance matrices (advanced once per instance),
+    * the first instance at _offset bytes */
+    static void SetInstanceMatrixAttributes(GLuint _location, GLintptr _offset = 0);
+    /** \brief The LOD for a mesh covering _screenSize of the screen height (see Camera3D::GetScreenSize): LOD 0 down to _lodScreenSize,
+    * every next LOD down to half the size of the one before */
+    static GLuint SelectLod(float _screenSize, float _lodScreenSize);
 
     /* Getters */
     GLuint GetVAO() const noexcept { return m_VAO; }
@@ -25,20 +79,61 @@ namespace GameEngine
     GLuint GetEBO() const noexcept { return m_EBO; }
     GLuint GetMBO() const noexcept { return m_MBO; }
 
-    std::vector<GLTexture> GetTextures() const noexcept { return m_textures; }
-    std::vector<Vertex> GetVertices()    const noexcept { return m_vertices; }
+    /** \brief Uploads a float for every instance of the next instanced draws (attribute INSTANCE_TIME_ATTRIBUTE, after the instance matrix),
+    * the first upload adds the attribute, from then on every instanced draw of the mesh needs at least as many floats as instances */
+    void UploadInstanceTimes(const std::vector<float>& _times);
+    /** \brief Points the instance matrices of a static mesh at _buffer (kept by the caller, e.g. shared by all the meshes of a model),
+    * 0 points them back at the own buffer of the mesh */
+    void SetInstanceBuffer(GLuint _buffer);
+    /** \brief The buffer the instance matrices are read from, the own one unless SetInstanceBuffer pointed them elsewhere */
+    GLuint GetInstanceBuffer() const noexcept { return m_instanceBuffer != 0 ? m_instanceBuffer : m_MBO; }
+    /** \brief If UploadInstanceTimes added the time attribute, the instanced draws then need a time for every instance */
+    bool HasInstanceTimes() const noexcept { return m_TBO != 0; }
+
+    const std::vector<GLTexture>& GetTextures() const noexcept { return m_material.GetTextures(); }
+    const MaterialBindings& GetMaterial() const noexcept { return m_material; }
+    /** \brief The CPU copies, empty unless the mesh was made with _keepCpuData (see HasCpuData), the indices of all the LODs */
+    const std::vector<Vertex>& GetVertices() const noexcept { return m_vertices; }
+    const std::vector<GLuint>& GetIndices() const noexcept { return m_indices; }
+    bool HasCpuData() const noexcept { return m_hasCpuData; }
+    GLuint GetNumVertices() const noexcept { return m_numVertices; }
+    /** \brief The indices of LOD 0, what Draw draws */
+    GLuint GetNumIndices() const noexcept { return m_numIndices; }
+    const std::vector<Lod>& GetLods() const noexcept { return m_lods; }
+    GLuint GetNumLods() const noexcept { return static_cast<GLuint>(m_lods.size()); }
+    const glm::mat4& GetBaseModelMatrix() const noexcept { return m_baseModelMatrix; }
+    bool HasAnimations() const noexcept { return m_hasAnimations; }
+    const Layout& GetLayout() const noexcept { return m_layout; }
+    /** \brief The sphere around the vertices before the baseModelMatrix, the center in xyz and the radius in w */
+    const glm::vec4& GetBoundingSphere() const noexcept { return m_boundingSphere; }
+    /** \brief The box around the vertices before the baseModelMatrix, tighter than the sphere for long or flat meshes */
+    const AABB& GetBoundingBox() const noexcept { return m_boundingBox; }
+    /** \brief The uv units per unit of the vertices before the baseModelMatrix, on average over the surface of LOD 0: how many texels of
+    * a texture of the mesh cover a unit (see MipStreamer::Request) */
+    float GetUvDensity() const noexcept { return m_uvDensity; }
 
   private:
     /* Render Data */
     GLuint m_VAO{ 0 }, m_VBO{ 0 }, m_EBO{ 0 }, m_MBO{ 0 };
+    GLuint m_TBO{ 0 }; ///< the instance times, only made by UploadInstanceTimes
+    GLuint m_instanceBuffer{ 0 }; ///< set by SetInstanceBuffer, 0 for m_MBO
 
     /* Mesh data */
-    std::vector<Vertex> m_vertices;
-    std::vector<GLuint> m_indices;
-    std::vector<GLTexture> m_textures;
+    std::vector<Vertex> m_vertices; ///< only with m_hasCpuData
+    std::vector<GLuint> m_indices;  ///< only with m_hasCpuData
+    GLuint m_numVertices{ 0 };
+    GLuint m_numIndices{ 0 }; ///< of LOD 0
+    std::vector<Lod> m_lods;
+    bool m_hasCpuData{ false };
+    MaterialBindings m_material; ///< the textures and their samplers
     glm::mat4 m_baseModelMatrix{ 1.0f };
     bool m_hasAnimations{ false };
+    Layout m_layout;
+    glm::vec4 m_boundingSphere{ 0.0f };
+    AABB m_boundingBox;
+    float m_uvDensity{ 0.0f };
     /* Setup Function */
-    void SetupMesh();
+    void SetLods(const std::vector<Lod>& _lods, GLuint _numIndices);
+    void SetupMesh(const Vertex* _vertices, GLsizeiptr _numVertices, const GLuint* _indices, GLsizeiptr _numIndices);
   };
 }
@@ -0,0 +1,197 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <glm\geometric.hpp>
+
+namespace GameEngine
+{
+  namespace
+  {
+    enum : GLuint { NO_VERTEX = 0xFFFFFFFF };
+
+    //a run of triangles of the Tipsify order between two cache flushes
+    struct Cluster
+    {
+      size_t firstIndex;
+      size_t numIndices;
+      float sortKey;
+    };
+
+    //the next vertex to fan around: the one of _candidates with live triangles which stays in the cache longest while they're emitted
+    GLuint NextCandidate(const std::vector<GLuint>& _candidates, const std::vector<GLuint>& _liveTriangles, const std::vector<GLuint>& _cacheTimes,
+      GLuint _time)
+    {
+      GLuint next = NO_VERTEX;
+      int bestPriority = -1;
+      for (GLuint vertex : _candidates)
+      {
+        if (_liveTriangles[vertex] == 0)
+        {
+          continue;
+        }
+        //every triangle fanned adds at most 2 vertices to the cache, a vertex that would be pushed out first gets no priority
+        int priority = 0;
+        if (_time - _cacheTimes[vertex] + 2 * _liveTriangles[vertex] <= MeshOptimizer::CACHE_SIZE)
+        {
+          priority = static_cast<int>(_time - _cacheTimes[vertex]);
+        }
+        if (priority > bestPriority)
+        {
+          bestPriority = priority;
+          next = vertex;
+        }
+      }
+      return next;
+    }
+  }
+
+  void MeshOptimizer::OptimizeTriangles(const std::vector<Vertex>& _vertices, GLuint* _indices, size_t _numIndices, bool _overdraw)
+  {
+    const GLuint numVertices = static_cast<GLuint>(_vertices.size());
+    const size_t numTriangles = _numIndices / 3;
+    if (numTriangles < 2)
+    {
+      return;
+    }
+
+    //the triangles around every vertex
+    std::vector<GLuint> liveTriangles(numVertices, 0);
+    for (size_t i = 0; i < numTriangles * 3; i++)
+    {
+      liveTriangles[_indices[i]]++;
+    }
+    std::vector<GLuint> offsets(numVertices + 1, 0);
+    for (GLuint v = 0; v < numVertices; v++)
+    {
+      offsets[v + 1] = offsets[v] + liveTriangles[v];
+    }
+    std::vector<GLuint> triangles(numTriangles * 3);
+    std::vector<GLuint> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < numTriangles * 3; i++)
+    {
+      triangles[fill[_indices[i]]++] = static_cast<GLuint>(i / 3);
+    }
+
+    std::vector<GLuint> cacheTimes(numVertices, 0);
+    std::vector<bool> emitted(numTriangles, false);
+    std::vector<GLuint> deadEnds;
+    std::vector<GLuint> candidates;
+    std::vector<GLuint> output;
+    output.reserve(numTriangles * 3);
+    std::vector<Cluster> clusters;
+
+    GLuint time = CACHE_SIZE + 1;
+    GLuint scan = 0;
+    GLuint fanning = _indices[0];
+    while (fanning != NO_VERTEX)
+    {
+      candidates.clear();
+      for (GLuint t = offsets[fanning]; t < offsets[fanning + 1]; t++)
+      {
+        const GLuint triangle = triangles[t];
+        if (emitted[triangle])
+        {
+          continue;
+        }
+        for (GLuint c = 0; c < 3; c++)
+        {
+          const GLuint vertex = _indices[triangle * 3 + c];
+          output.push_back(vertex);
+          deadEnds.push_back(vertex);
+          candidates.push_back(vertex);
+          liveTriangles[vertex]--;
+          //a vertex which isn't in the cache anymore is transformed again
+          if (time - cacheTimes[vertex] > CACHE_SIZE)
+          {
+            cacheTimes[vertex] = time++;
+          }
+        }
+        emitted[triangle] = true;
+      }
+
+      fanning = NextCandidate(candidates, liveTriangles, cacheTimes, time);
+      if (fanning != NO_VERTEX)
+      {
+        continue;
+      }
+      //a dead end: the most recent vertex with triangles left, else the next one in index order. The cache is cold there, so a cluster ends
+      while (!deadEnds.empty() && fanning == NO_VERTEX)
+      {
+        if (liveTriangles[deadEnds.back()] > 0)
+        {
+          fanning = deadEnds.back();
+        }
+        deadEnds.pop_back();
+      }
+      for (; scan < numVertices && fanning == NO_VERTEX; scan++)
+      {
+        if (liveTriangles[scan] > 0)
+        {
+          fanning = scan;
+        }
+      }
+      const size_t clusterStart = clusters.empty() ? 0 : clusters.back().firstIndex + clusters.back().numIndices;
+      clusters.push_back({ clusterStart, output.size() - clusterStart, 0.0f });
+    }
+
+    if (_overdraw && clusters.size() > 1)
+    {
+      //Sander et al.: the clusters facing away from the center of the mesh most are drawn first, they tend to hide the others
+      std::vector<glm::vec3> centers(clusters.size()), normals(clusters.size());
+      glm::vec3 meshCenter(0.0f);
+      float meshArea = 0.0f;
+      for (size_t c = 0; c < clusters.size(); c++)
+      {
+        glm::vec3 center(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t i = clusters[c].firstIndex; i < clusters[c].firstIndex + clusters[c].numIndices; i += 3)
+        {
+          const glm::vec3& p0 = _vertices[output[i]].m_position;
+          const glm::vec3& p1 = _vertices[output[i + 1]].m_position;
+          const glm::vec3& p2 = _vertices[output[i + 2]].m_position;
+          const glm::vec3 triangleNormal = glm::cross(p1 - p0, p2 - p0);
+          const float triangleArea = glm::length(triangleNormal);
+          center += (p0 + p1 + p2) * (triangleArea / 3.0f);
+          normal += triangleNormal;
+          area += triangleArea;
+        }
+        meshCenter += center;
+        meshArea += area;
+        centers[c] = area > 0.0f ? center / area : glm::vec3(_vertices[output[clusters[c].firstIndex]].m_position);
+        normals[c] = normal;
+      }
+      meshCenter = meshArea > 0.0f ? meshCenter / meshArea : meshCenter;
+      for (size_t c = 0; c < clusters.size(); c++)
+      {
+        clusters[c].sortKey = glm::dot(centers[c] - meshCenter, normals[c]);
+      }
+      std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& _a, const Cluster& _b) { return _a.sortKey > _b.sortKey; });
+
+      size_t next = 0;
+      for (const Cluster& cluster : clusters)
+      {
+        std::copy(output.begin() + cluster.firstIndex, output.begin() + cluster.firstIndex + cluster.numIndices, _indices + next);
+        next += cluster.numIndices;
+      }
+      return;
+    }
+    std::copy(output.begin(), output.end(), _indices);
+  }
+
+  void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& _vertices, std::vector<GLuint>& _indices)
+  {
+    std::vector<GLuint> remap(_vertices.size(), NO_VERTEX);
+    std::vector<Vertex> vertices;
+    vertices.reserve(_vertices.size());
+    for (GLuint& index : _indices)
+    {
+      if (remap[index] == NO_VERTEX)
+      {
+        remap[index] = static_cast<GLuint>(vertices.size());
+        vertices.push_back(_vertices[index]);
+      }
+      index = remap[index];
+    }
+    _vertices.swap(vertices);
+  }
+}
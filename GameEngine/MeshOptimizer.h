@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Vertex.h"
+
+namespace GameEngine
+{
+  /** \brief Reorders the triangles and vertices of a mesh for the GPU, done once at import (see AssimpLoader::SetOptimizeMeshes).
+  * The triangles are ordered for the post transform vertex cache with Tipsify (Sander, Nehab and Barczak), the clusters Tipsify leaves
+  * between its cache flushes are then sorted outside in so the front faces are mostly drawn before the ones they hide. The vertices are
+  * finally stored in the order the triangles first use them, so the vertex fetch reads the buffer front to back */
+  class MeshOptimizer
+  {
+  public:
+    /** \brief The entries of the post transform cache the order is made for, small enough for every GPU we run on */
+    enum : unsigned int { CACHE_SIZE = 16 };
+
+    /** \brief Reorders the _numIndices indices (triangles of _vertices) at _indices for the vertex cache, and for less overdraw if _overdraw */
+    static void OptimizeTriangles(const std::vector<Vertex>& _vertices, GLuint* _indices, size_t _numIndices, bool _overdraw);
+
+    /** \brief Sorts _vertices by their first use in _indices and points _indices at the new places, the vertices no triangle uses are dropped */
+    static void OptimizeVertexFetch(std::vector<Vertex>& _vertices, std::vector<GLuint>& _indices);
+  };
+}
@@ -0,0 +1,303 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <glm\common.hpp>
+#include <glm\geometric.hpp>
+
+namespace GameEngine
+{
+  namespace
+  {
+    //the squared distances to the planes of the triangles around a vertex, weighted by their areas
+    struct Quadric
+    {
+      double a2{ 0.0 }, b2{ 0.0 }, c2{ 0.0 }, d2{ 0.0 };
+      double ab{ 0.0 }, ac{ 0.0 }, ad{ 0.0 }, bc{ 0.0 }, bd{ 0.0 }, cd{ 0.0 };
+      double weight{ 0.0 };
+
+      void AddPlane(const glm::vec3& _normal, float _distance, double _weight)
+      {
+        const double a = _normal.x, b = _normal.y, c = _normal.z, d = _distance;
+        a2 += a * a * _weight; b2 += b * b * _weight; c2 += c * c * _weight; d2 += d * d * _weight;
+        ab += a * b * _weight; ac += a * c * _weight; ad += a * d * _weight;
+        bc += b * c * _weight; bd += b * d * _weight; cd += c * d * _weight;
+        weight += _weight;
+      }
+      void Add(const Quadric& _other)
+      {
+        a2 += _other.a2; b2 += _other.b2; c2 += _other.c2; d2 += _other.d2;
+        ab += _other.ab; ac += _other.ac; ad += _other.ad;
+        bc += _other.bc; bd += _other.bd; cd += _other.cd;
+        weight += _other.weight;
+      }
+      //the weighted sum of the squared distances of _position to the planes
+      double Evaluate(const glm::vec3& _position) const
+      {
+        const double x = _position.x, y = _position.y, z = _position.z;
+        return a2 * x * x + b2 * y * y + c2 * z * z + 2.0 * (ab * x * y + ac * x * z + bc * y * z) +
+          2.0 * (ad * x + bd * y + cd * z) + d2;
+      }
+    };
+
+    struct Collapse
+    {
+      GLuint from; ///< the vertex which is removed
+      GLuint to;   ///< the vertex it's moved onto
+      double error;
+    };
+
+    //the vertices which must not move: the ones sharing their position with others (seams) and the ones on open or non-manifold edges
+    std::vector<bool> FindLockedVertices(const std::vector<Vertex>& _vertices, const std::vector<GLuint>& _indices)
+    {
+      std::vector<bool> locked(_vertices.size(), false);
+
+      std::vector<GLuint> byPosition(_vertices.size());
+      for (GLuint i = 0; i < byPosition.size(); i++)
+      {
+        byPosition[i] = i;
+      }
+      auto lessPosition = [&_vertices](GLuint _a, GLuint _b)
+      {
+        const glm::vec3& a = _vertices[_a].m_position;
+        const glm::vec3& b = _vertices[_b].m_position;
+        return a.x != b.x ? a.x < b.x : (a.y != b.y ? a.y < b.y : a.z < b.z);
+      };
+      std::sort(byPosition.begin(), byPosition.end(), lessPosition);
+      for (size_t i = 1; i < byPosition.size(); i++)
+      {
+        if (_vertices[byPosition[i - 1]].m_position == _vertices[byPosition[i]].m_position)
+        {
+          locked[byPosition[i - 1]] = true;
+          locked[byPosition[i]] = true;
+        }
+      }
+
+      //the triangles of every edge, one is a border and more than two is non-manifold
+      std::unordered_map<std::uint64_t, GLuint> edges;
+      edges.reserve(_indices.size());
+      for (size_t t = 0; t + 2 < _indices.size(); t += 3)
+      {
+        for (GLuint e = 0; e < 3; e++)
+        {
+          const GLuint a = _indices[t + e], b = _indices[t + (e + 1) % 3];
+          edges[(static_cast<std::uint64_t>(std::min(a, b)) << 32) | std::max(a, b)]++;
+        }
+      }
+      for (const auto& edge : edges)
+      {
+        if (edge.second != 2)
+        {
+          locked[static_cast<GLuint>(edge.first >> 32)] = true;
+          locked[static_cast<GLuint>(edge.first & 0xFFFFFFFF)] = true;
+        }
+      }
+      return locked;
+    }
+
+    //true if moving _from onto _to turns one of the triangles around _from over (or collapses it without removing it)
+    bool Flips(const std::vector<Vertex>& _vertices, const std::vector<GLuint>& _indices, const GLuint* _triangles, GLuint _numTriangles,
+      GLuint _from, GLuint _to)
+    {
+      for (GLuint i = 0; i < _numTriangles; i++)
+      {
+        const GLuint* triangle = &_indices[_triangles[i] * 3];
+        if (triangle[0] == _to || triangle[1] == _to || triangle[2] == _to)
+        {
+          //removed by the collapse
+          continue;
+        }
+        glm::vec3 before[3], after[3];
+        for (GLuint c = 0; c < 3; c++)
+        {
+          before[c] = _vertices[triangle[c]].m_position;
+          after[c] = triangle[c] == _from ? _vertices[_to].m_position : before[c];
+        }
+        const glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+        const glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+        if (glm::dot(normalBefore, normalAfter) <= 0.25f * glm::length(normalBefore) * glm::length(normalAfter))
+        {
+          return true;
+        }
+      }
+      return false;
+    }
+  }
+
+  std::vector<GLuint> MeshSimplifier::Simplify(const std::vector<Vertex>& _vertices, const std::vector<GLuint>& _indices, size_t _targetIndices,
+    float _maxError)
+  {
+    std::vector<GLuint> result(_indices.begin(), _indices.begin() + _indices.size() / 3 * 3);
+    const std::vector<bool> locked = FindLockedVertices(_vertices, result);
+    const double maxError = static_cast<double>(_maxError) * _maxError;
+
+    std::vector<Quadric> quadrics(_vertices.size());
+    for (size_t t = 0; t < result.size(); t += 3)
+    {
+      const glm::vec3& p0 = _vertices[result[t]].m_position;
+      const glm::vec3 normal = glm::cross(_vertices[result[t + 1]].m_position - p0, _vertices[result[t + 2]].m_position - p0);
+      const float area2 = glm::length(normal);
+      if (area2 <= 0.0f)
+      {
+        continue;
+      }
+      const glm::vec3 unitNormal = normal / area2;
+      for (GLuint c = 0; c < 3; c++)
+      {
+        quadrics[result[t + c]].AddPlane(unitNormal, -glm::dot(unitNormal, p0), area2 * 0.5);
+      }
+    }
+
+    std::vector<GLuint> triangleOffsets(_vertices.size() + 1);
+    std::vector<GLuint> triangles;
+    std::vector<Collapse> collapses;
+    std::vector<GLuint> remap(_vertices.size());
+    std::vector<bool> touched(_vertices.size());
+    //every pass collapses the cheapest edges which don't touch each other, then removes the triangles that became degenerate
+    while (result.size() > _targetIndices)
+    {
+      //the triangles around every vertex
+      std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+      for (GLuint index : result)
+      {
+        triangleOffsets[index + 1]++;
+      }
+      for (size_t i = 1; i < triangleOffsets.size(); i++)
+      {
+        triangleOffsets[i] += triangleOffsets[i - 1];
+      }
+      triangles.resize(result.size());
+      std::vector<GLuint> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+      for (size_t i = 0; i < result.size(); i++)
+      {
+        triangles[fill[result[i]]++] = static_cast<GLuint>(i / 3);
+      }
+
+      collapses.clear();
+      for (size_t t = 0; t < result.size(); t += 3)
+      {
+        for (GLuint e = 0; e < 3; e++)
+        {
+          const GLuint a = result[t + e], b = result[t + (e + 1) % 3];
+          if (!locked[a])
+          {
+            Quadric quadric = quadrics[a];
+            quadric.Add(quadrics[b]);
+            const double error = quadric.weight > 0.0 ? quadric.Evaluate(_vertices[b].m_position) / quadric.weight : 0.0;
+            if (error <= maxError)
+            {
+              collapses.push_back({ a, b, error });
+            }
+          }
+          if (!locked[b])
+          {
+            Quadric quadric = quadrics[b];
+            quadric.Add(quadrics[a]);
+            const double error = quadric.weight > 0.0 ? quadric.Evaluate(_vertices[a].m_position) / quadric.weight : 0.0;
+            if (error <= maxError)
+            {
+              collapses.push_back({ b, a, error });
+            }
+          }
+        }
+      }
+      std::sort(collapses.begin(), collapses.end(), [](const Collapse& _a, const Collapse& _b) { return _a.error < _b.error; });
+
+      for (GLuint i = 0; i < remap.size(); i++)
+      {
+        remap[i] = i;
+      }
+      std::fill(touched.begin(), touched.end(), false);
+      const size_t trianglesToRemove = (result.size() - _targetIndices + 2) / 3;
+      size_t removed = 0;
+      for (const Collapse& collapse : collapses)
+      {
+        if (removed >= trianglesToRemove)
+        {
+          break;
+        }
+        if (touched[collapse.from] || touched[collapse.to])
+        {
+          continue;
+        }
+        const GLuint* around = &triangles[triangleOffsets[collapse.from]];
+        const GLuint numAround = triangleOffsets[collapse.from + 1] - triangleOffsets[collapse.from];
+        if (Flips(_vertices, result, around, numAround, collapse.from, collapse.to))
+        {
+          continue;
+        }
+        remap[collapse.from] = collapse.to;
+        quadrics[collapse.to].Add(quadrics[collapse.from]);
+        //the triangles around the removed vertex change, so none of their vertices takes part in another collapse of this pass
+        for (GLuint i = 0; i < numAround; i++)
+        {
+          const GLuint* triangle = &result[around[i] * 3];
+          touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+          removed += (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) ? 1 : 0;
+        }
+      }
+      if (removed == 0)
+      {
+        //every collapse left is above the error or would flip a triangle
+        break;
+      }
+
+      size_t numIndices = 0;
+      for (size_t t = 0; t < result.size(); t += 3)
+      {
+        const GLuint a = remap[result[t]], b = remap[result[t + 1]], c = remap[result[t + 2]];
+        if (a != b && b != c && a != c)
+        {
+          result[numIndices++] = a;
+          result[numIndices++] = b;
+          result[numIndices++] = c;
+        }
+      }
+      result.resize(numIndices);
+    }
+    return result;
+  }
+
+  std::vector<Mesh::Lod> MeshSimplifier::GenerateLods(const std::vector<Vertex>& _vertices, std::vector<GLuint>& _indices, const LodSettings& _settings)
+  {
+    std::vector<Mesh::Lod> lods;
+    lods.push_back({ 0, static_cast<GLuint>(_indices.size()) });
+    if (_vertices.empty())
+    {
+      return lods;
+    }
+
+    //the errors are relative to the size of the mesh
+    glm::vec3 min = _vertices[0].m_position;
+    glm::vec3 max = min;
+    for (const Vertex& vertex : _vertices)
+    {
+      min = glm::min(min, vertex.m_position);
+      max = glm::max(max, vertex.m_position);
+    }
+    const float maxError = _settings.m_maxError * glm::length(max - min) * 0.5f;
+
+    std::vector<GLuint> previous(_indices);
+    const GLuint numLods = std::min(_settings.m_numLods, static_cast<GLuint>(Mesh::MAX_LODS));
+    for (GLuint lod = 1; lod < numLods; lod++)
+    {
+      const size_t target = static_cast<size_t>(previous.size() / 3 * _settings.m_reduction) * 3;
+      if (target == 0)
+      {
+        break;
+      }
+      std::vector<GLuint> simplified = Simplify(_vertices, previous, target, maxError);
+      //a LOD which saves less than a tenth of the triangles isn't worth its indices, and the ones after it wouldn't be either
+      if (simplified.empty() || simplified.size() * 10 > previous.size() * 9)
+      {
+        break;
+      }
+      lods.push_back({ static_cast<GLuint>(_indices.size()), static_cast<GLuint>(simplified.size()) });
+      _indices.insert(_indices.end(), simplified.begin(), simplified.end());
+      previous.swap(simplified);
+    }
+    return lods;
+  }
+}
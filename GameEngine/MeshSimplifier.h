@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+
+#include "Mesh.h"
+
+namespace GameEngine
+{
+  /** \brief How AssimpLoader generates the LOD chain of the meshes it imports (see AssimpLoader::SetLodSettings) */
+  struct LodSettings
+  {
+    GLuint m_numLods{ 4 };     ///< including LOD 0 (the imported triangles), 1 generates none, at most Mesh::MAX_LODS
+    float m_reduction{ 0.5f }; ///< the triangles of a LOD relative to the LOD before
+    float m_maxError{ 0.02f }; ///< the largest error a collapse may add, relative to the radius of the mesh, a LOD stops above its target at it
+  };
+
+  /** \brief Simplifies triangle meshes by quadric error edge collapses (Garland and Heckbert). A collapse moves a vertex onto one of its
+  * neighbours, so the simplified triangles index the same vertices: the LODs of a mesh share its vertex buffer and skinned meshes keep
+  * their bone weights. The vertices on the open borders of a mesh and on its seams (split vertices at the same position, e.g. where the
+  * uvs are cut) never move, so the LODs have no cracks and no torn uvs */
+  class MeshSimplifier
+  {
+  public:
+    /** \brief The triangles of _indices simplified until at most _targetIndices are left, or until every collapse left would add an error
+    * above _maxError (a distance in the units of the positions) */
+    static std::vector<GLuint> Simplify(const std::vector<Vertex>& _vertices, const std::vector<GLuint>& _indices, size_t _targetIndices, float _maxError);
+
+    /** \brief Appends the LODs after LOD 0 (all of _indices) to _indices, every LOD simplified from the one before
+    * \return the ranges of the LODs in _indices, the chain ends early at a LOD which would barely be smaller than the one before */
+    static std::vector<Mesh::Lod> GenerateLods(const std::vector<Vertex>& _vertices, std::vector<GLuint>& _indices, const LodSettings& _settings);
+  };
+}
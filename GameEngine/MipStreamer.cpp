@@ -0,0 +1,226 @@
+#include "MipStreamer.h"
+#include "Camera3D.h"
+#include "FrameStats.h"
+#include "Mesh.h"
+#include "RenderState.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <glm\geometric.hpp>
+
+namespace GameEngine
+{
+  GLuint MipStreamer::Load(CompressedImage _image, bool _alpha)
+  {
+    StreamedTexture texture;
+    texture.numLevels = static_cast<GLint>(_image.levelOffsets.size()) - 1;
+    texture.image = std::move(_image);
+    //the first level small enough to stay, the last one of a chain which stops early
+    texture.tailLevel = 0;
+    while (texture.tailLevel < texture.numLevels - 1 && std::max(texture.image.width >> texture.tailLevel, texture.image.height >> texture.tailLevel) > RESIDENT_SIZE)
+    {
+      texture.tailLevel++;
+    }
+    texture.residentLevel = texture.tailLevel;
+    texture.wantedLevel = texture.tailLevel;
+    texture.requestedLevel = texture.numLevels;
+
+    GLuint id = 0;
+    glGenTextures(1, &id);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, texture.residentLevel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture.numLevels - 1);
+    for (GLint level = texture.residentLevel; level < texture.numLevels; level++)
+    {
+      const GLsizei bytes = static_cast<GLsizei>(GetLevelBytes(texture, level));
+      glCompressedTexImage2D(GL_TEXTURE_2D, level, texture.image.format, std::max(texture.image.width >> level, 1), std::max(texture.image.height >> level, 1),
+        0, bytes, texture.image.data.data() + texture.image.levelOffsets[level]);
+      FrameStats::Get().Add(STAT_BYTES_UPLOADED, bytes);
+      m_residentBytes += bytes;
+    }
+    ImageLoader::SetTextureParameters(_alpha);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+    m_textures[id] = std::move(texture);
+    return id;
+  }
+
+  void MipStreamer::Forget(GLuint _id)
+  {
+    auto it = m_textures.find(_id);
+    if (it == m_textures.end())
+    {
+      return;
+    }
+    for (GLint level = it->second.residentLevel; level < it->second.numLevels; level++)
+    {
+      m_residentBytes -= GetLevelBytes(it->second, level);
+    }
+    m_textures.erase(it);
+  }
+
+  void MipStreamer::Request(const Mesh& _mesh, const glm::mat4& _transform, const Camera3D& _camera)
+  {
+    const float uvDensity = _mesh.GetUvDensity();
+    if (uvDensity <= 0.0f)
+    {
+      return;
+    }
+    //the world units a unit of the vertices becomes, and the pixels a world unit covers where the mesh is
+    const glm::mat4 model = _transform * _mesh.GetBaseModelMatrix();
+    const float scale = std::sqrt(std::max(glm::dot(glm::vec3(model[0]), glm::vec3(model[0])), std::max(glm::dot(glm::vec3(model[1]), glm::vec3(model[1])),
+      glm::dot(glm::vec3(model[2]), glm::vec3(model[2])))));
+    const glm::vec4& sphere = _mesh.GetBoundingSphere();
+    const float radius = std::max(sphere.w * scale, 1e-4f);
+    const glm::vec3 center(model * glm::vec4(glm::vec3(sphere), 1.0f));
+    const float screenSize = _camera.GetScreenSize(center, radius);
+    const float pixelsPerUnit = screenSize * _camera.GetScreenHeight() / (2.0f * radius);
+    for (const GLTexture& texture : _mesh.GetTextures())
+    {
+      if (m_textures.find(texture.id) == m_textures.end())
+      {
+        continue;
+      }
+      //the camera inside the mesh wants the full size, else the level whose texels are about as many as the pixels
+      GLint level = 0;
+      if (screenSize < std::numeric_limits<float>::max() && pixelsPerUnit > 0.0f)
+      {
+        const float texelsPerUnit = uvDensity * std::max(texture.width, texture.height) / scale;
+        level = static_cast<GLint>(std::max(std::floor(std::log2(texelsPerUnit / pixelsPerUnit)), 0.0f));
+      }
+      Request(texture.id, level);
+    }
+  }
+
+  void MipStreamer::Request(GLuint _id, GLint _level)
+  {
+    auto it = m_textures.find(_id);
+    if (it != m_textures.end())
+    {
+      it->second.requestedLevel = std::min(it->second.requestedLevel, std::max(_level, 0));
+      it->second.lastRequest = m_frame;
+    }
+  }
+
+  void MipStreamer::Update()
+  {
+    //the levels wanted now, a texture not requested for a while only wants its tail
+    std::vector<std::pair<GLuint, StreamedTexture*>> missing;
+    for (auto& entry : m_textures)
+    {
+      StreamedTexture& texture = entry.second;
+      if (texture.requestedLevel < texture.numLevels)
+      {
+        texture.wantedLevel = std::min(texture.requestedLevel, texture.tailLevel);
+      }
+      else if (m_frame - texture.lastRequest > KEEP_FRAMES)
+      {
+        texture.wantedLevel = texture.tailLevel;
+      }
+      texture.requestedLevel = texture.numLevels;
+      if (texture.residentLevel > texture.wantedLevel)
+      {
+        missing.emplace_back(entry.first, &texture);
+      }
+    }
+    m_frame++;
+
+    //a lowered budget drops the unwanted levels right away
+    while (m_residentBytes > m_budget && EvictUnwanted())
+    {
+    }
+
+    //the textures furthest from what they need go first, a level at a time so the others get theirs too
+    std::sort(missing.begin(), missing.end(), [](const std::pair<GLuint, StreamedTexture*>& _a, const std::pair<GLuint, StreamedTexture*>& _b)
+    {
+      return _a.second->residentLevel - _a.second->wantedLevel > _b.second->residentLevel - _b.second->wantedLevel;
+    });
+    size_t streamed = 0;
+    bool progress = true;
+    while (progress && streamed < STREAM_BYTES_PER_FRAME)
+    {
+      progress = false;
+      for (auto& entry : missing)
+      {
+        StreamedTexture& texture = *entry.second;
+        if (texture.residentLevel <= texture.wantedLevel || streamed >= STREAM_BYTES_PER_FRAME)
+        {
+          continue;
+        }
+        const size_t bytes = GetLevelBytes(texture, texture.residentLevel - 1);
+        //the memory comes from the levels nobody wants, without them the budget is full of needed levels
+        while (m_residentBytes + bytes > m_budget && EvictUnwanted())
+        {
+        }
+        if (m_residentBytes + bytes > m_budget)
+        {
+          continue;
+        }
+        StreamIn(entry.first, texture);
+        streamed += bytes;
+        progress = true;
+      }
+    }
+  }
+
+  void MipStreamer::Dispose()
+  {
+    m_textures.clear();
+    m_residentBytes = 0;
+  }
+
+  size_t MipStreamer::GetLevelBytes(const StreamedTexture& _texture, GLint _level)
+  {
+    return _texture.image.levelOffsets[_level + 1] - _texture.image.levelOffsets[_level];
+  }
+
+  void MipStreamer::StreamIn(GLuint _id, StreamedTexture& _texture)
+  {
+    const GLint level = _texture.residentLevel - 1;
+    const GLsizei bytes = static_cast<GLsizei>(GetLevelBytes(_texture, level));
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, _id);
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, _texture.image.format, std::max(_texture.image.width >> level, 1),
+      std::max(_texture.image.height >> level, 1), 0, bytes, _texture.image.data.data() + _texture.image.levelOffsets[level]);
+    //only sampled once it's there
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+    FrameStats::Get().Add(STAT_BYTES_UPLOADED, bytes);
+    m_residentBytes += bytes;
+    _texture.residentLevel = level;
+  }
+
+  void MipStreamer::Evict(GLuint _id, StreamedTexture& _texture)
+  {
+    const GLint level = _texture.residentLevel;
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, _id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+    //an empty level frees the memory of the one it replaces
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, _texture.image.format, 0, 0, 0, 0, nullptr);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+    m_residentBytes -= GetLevelBytes(_texture, level);
+    _texture.residentLevel = level + 1;
+  }
+
+  bool MipStreamer::EvictUnwanted()
+  {
+    GLuint victimId = 0;
+    StreamedTexture* victim = nullptr;
+    for (auto& entry : m_textures)
+    {
+      StreamedTexture& texture = entry.second;
+      const GLint unwanted = texture.wantedLevel - texture.residentLevel;
+      if (unwanted > 0 && (victim == nullptr || unwanted > victim->wantedLevel - victim->residentLevel))
+      {
+        victimId = entry.first;
+        victim = &texture;
+      }
+    }
+    if (victim == nullptr)
+    {
+      return false;
+    }
+    Evict(victimId, *victim);
+    return true;
+  }
+}
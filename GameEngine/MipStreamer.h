@@ -0,0 +1,82 @@
+#pragma once
+#include <GL\glew.h>
+#include <cstdint>
+#include <unordered_map>
+#include <glm\mat4x4.hpp>
+
+#include "ImageLoader.h"
+
+namespace GameEngine
+{
+  class Camera3D;
+  class Mesh;
+
+  /** \brief Keeps only the mip levels of the textures the screen needs on the GPU, within a budget of bytes. A streamed texture starts with
+  * the levels up to RESIDENT_SIZE texels, the small tail that always stays. The renderer requests the level every texture of a drawn mesh
+  * needs, from the size of the mesh on the screen and the texels its uvs spread over it (see Request). Update then streams the larger levels
+  * in, a few per frame, and drops the levels no longer requested when the budget needs their memory.
+  * The compressed image (see TextureCooker) of every streamed texture stays on the CPU, the levels are uploaded from it. Unlike the other
+  * textures the streamed ones have mutable storage: a level is defined when it's streamed in and redefined empty when it's dropped, and
+  * GL_TEXTURE_BASE_LEVEL keeps the texture complete with the ones it has. The id never changes, so the materials holding copies of the
+  * texture draw the new levels too */
+  class MipStreamer
+  {
+  public:
+    enum : int { RESIDENT_SIZE = 64 }; ///< the levels whose larger side is at most this many texels are loaded with the texture and never dropped
+    enum : std::uint32_t { KEEP_FRAMES = 60 }; ///< the frames a level stays wanted after its last request
+    static constexpr size_t STREAM_BYTES_PER_FRAME{ 4 * 1024 * 1024 }; ///< the most uploaded per Update (one level more, to make progress)
+    static constexpr size_t DEFAULT_BUDGET{ 256 * 1024 * 1024 };
+
+    MipStreamer() {}
+    ~MipStreamer() {}
+    MipStreamer(const MipStreamer&) = delete;
+    MipStreamer& operator=(const MipStreamer&) = delete;
+
+    /** \brief Creates a texture with the resident levels of _image (moved in, kept for the streaming), on the GL thread */
+    GLuint Load(CompressedImage _image, bool _alpha);
+    /** \brief Stops streaming the texture, before it's deleted */
+    void Forget(GLuint _id);
+
+    /** \brief Requests the levels the textures of _mesh need with it drawn by _transform (its transformMatrix) on the screen of _camera */
+    void Request(const Mesh& _mesh, const glm::mat4& _transform, const Camera3D& _camera);
+    /** \brief Requests level _level (0 the full size) of the texture, nothing if it isn't streamed. The smallest level requested in a frame wins */
+    void Request(GLuint _id, GLint _level);
+
+    /** \brief Streams in the levels requested since the last Update, once per frame, and drops unwanted ones to stay in the budget */
+    void Update();
+
+    /** \brief The bytes the streamed textures may take on the GPU, including their resident levels. A lower budget drops levels with the next Update */
+    void SetBudget(size_t _bytes) { m_budget = _bytes; }
+    size_t GetBudget() const noexcept { return m_budget; }
+    size_t GetResidentBytes() const noexcept { return m_residentBytes; }
+    size_t GetNumTextures() const noexcept { return m_textures.size(); }
+
+    /** \brief Forgets all the textures (they stay as they are) and frees their images */
+    void Dispose();
+
+  private:
+    struct StreamedTexture
+    {
+      CompressedImage image;
+      GLint numLevels{ 0 };
+      GLint tailLevel{ 0 };     ///< the first level which never goes
+      GLint residentLevel{ 0 }; ///< the largest level on the GPU, all the smaller ones are too
+      GLint wantedLevel{ 0 };   ///< the largest level requested over the last KEEP_FRAMES
+      GLint requestedLevel{ 0 }; ///< the largest level requested since the last Update, numLevels if none
+      std::uint32_t lastRequest{ 0 }; ///< the frame of the last request
+    };
+
+    static size_t GetLevelBytes(const StreamedTexture& _texture, GLint _level);
+    /** \brief Uploads the level above the resident ones */
+    void StreamIn(GLuint _id, StreamedTexture& _texture);
+    /** \brief Drops the largest resident level */
+    void Evict(GLuint _id, StreamedTexture& _texture);
+    /** \brief Drops a level nobody wants, from the texture with the most of them, false if there's none */
+    bool EvictUnwanted();
+
+    std::unordered_map<GLuint, StreamedTexture> m_textures;
+    size_t m_budget{ DEFAULT_BUDGET };
+    size_t m_residentBytes{ 0 };
+    std::uint32_t m_frame{ 0 };
+  };
+}
@@ -1,9 +1,147 @@
 #include "Model.h"
-
+#include "FrameStats.h"
+#include "VertexAnimationTexture.h"
+#include "InstanceCuller.h"
+#include "Camera3D.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <glm\common.hpp>
+#include <glm\geometric.hpp>
 
 namespace GameEngine
 {
+  namespace
+  {
+    //the keys after the cursor which are tried before the binary search, a frame rarely skips more
+    constexpr GLuint CURSOR_STEPS = 4;
+
+    //the first key i with _animTime before key i + 1 (key 0 for times before the first key), _cursor is where the last search ended
+    GLuint FindKey(float _animTime, const std::vector<float>& _times, GLuint& _cursor)
+    {
+      const GLuint lastKey = _times.size() - 1;
+      for (GLuint i = _cursor, steps = 0; i < lastKey && steps < CURSOR_STEPS; i++, steps++)
+      {
+        //the time went back (a loop or a seek)
+        if (i > 0 && _animTime < _times[i])
+        {
+          break;
+        }
+        if (_animTime < _times[i + 1])
+        {
+          _cursor = i;
+          return i;
+        }
+      }
+
+      auto next = std::upper_bound(_times.begin() + 1, _times.end(), _animTime);
+      if (next == _times.end())
+      {
+        //past the last key, stays on it
+        _cursor = lastKey - 1;
+        return _cursor;
+      }
+      _cursor = static_cast<GLuint>(next - _times.begin()) - 1;
+      return _cursor;
+    }
+
+    //the key _animTime is after and how far it is to the next one (0 to 1) in a track with at least two keys,
+    //a uniform track gets it from the time alone, a keyed one searches from _cursor
+    template <typename Value>
+    GLuint FindKey(float _animTime, const AnimationTrack<Value>& _track, GLuint& _cursor, float& _factor)
+    {
+      GLuint key = 0;
+      float start = 0.0f, deltaTime = 0.0f;
+      if (_track.IsUniform())
+      {
+        const float position = std::max((_animTime - _track.m_start) / _track.m_interval, 0.0f);
+        key = std::min(static_cast<GLuint>(position), static_cast<GLuint>(_track.m_values.size()) - 2);
+        start = _track.m_start + key * _track.m_interval;
+        deltaTime = _track.m_interval;
+      }
+      else
+      {
+        key = FindKey(_animTime, _track.m_times, _cursor);
+        start = _track.m_times[key];
+        deltaTime = _track.m_times[key + 1] - start;
+      }
+      _factor = std::min(std::max((_animTime - start) / deltaTime, 0.0f), 1.0f);
+      return key;
+    }
+
+    glm::vec3 Sample(float _animTime, const AnimationTrack<glm::vec3>& _track, GLuint& _cursor, const glm::vec3& _default)
+    {
+      if (_track.m_values.size() < 2)
+      {
+        // we need at least two values to interpolate...
+        return _track.m_values.empty() ? _default : _track.m_values[0];
+      }
+      float factor = 0.0f;
+      const GLuint key = FindKey(_animTime, _track, _cursor, factor);
+      return _track.m_values[key] + (_track.m_values[key + 1] - _track.m_values[key]) * factor;
+    }
+
+    //translate(_t) * mat4_cast(_r) * scale(_s) in one go: the rotation columns scaled by _s, with _t as the last column
+    glm::mat4 ComposeTRS(const glm::vec3& _t, const glm::quat& _r, const glm::vec3& _s)
+    {
+      const float xx = _r.x * _r.x, yy = _r.y * _r.y, zz = _r.z * _r.z;
+      const float xy = _r.x * _r.y, xz = _r.x * _r.z, yz = _r.y * _r.z;
+      const float wx = _r.w * _r.x, wy = _r.w * _r.y, wz = _r.w * _r.z;
+      glm::mat4 result;
+      result[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * _s.x, 2.0f * (xy + wz) * _s.x, 2.0f * (xz - wy) * _s.x, 0.0f);
+      result[1] = glm::vec4(2.0f * (xy - wz) * _s.y, (1.0f - 2.0f * (xx + zz)) * _s.y, 2.0f * (yz + wx) * _s.y, 0.0f);
+      result[2] = glm::vec4(2.0f * (xz + wy) * _s.z, 2.0f * (yz - wx) * _s.z, (1.0f - 2.0f * (xx + yy)) * _s.z, 0.0f);
+      result[3] = glm::vec4(_t, 1.0f);
+      return result;
+    }
+
+    //the largest scale of the axes of _matrix, what it scales the radius of a sphere by
+    float MaxScale(const glm::mat4& _matrix)
+    {
+      return std::sqrt(std::max(glm::dot(glm::vec3(_matrix[0]), glm::vec3(_matrix[0])), std::max(glm::dot(glm::vec3(_matrix[1]), glm::vec3(_matrix[1])),
+        glm::dot(glm::vec3(_matrix[2]), glm::vec3(_matrix[2])))));
+    }
+
+    //the sphere around the bounding spheres of _meshes moved by their baseModelMatrix
+    glm::vec4 CalcBoundingSphere(const std::vector<Mesh>& _meshes)
+    {
+      if (_meshes.empty())
+      {
+        return glm::vec4(0.0f);
+      }
+      std::vector<glm::vec4> spheres;
+      spheres.reserve(_meshes.size());
+      glm::vec3 min(std::numeric_limits<float>::max());
+      glm::vec3 max(-std::numeric_limits<float>::max());
+      for (const Mesh& mesh : _meshes)
+      {
+        const glm::vec4& sphere = mesh.GetBoundingSphere();
+        const glm::vec3 center(mesh.GetBaseModelMatrix() * glm::vec4(glm::vec3(sphere), 1.0f));
+        const float radius = sphere.w * MaxScale(mesh.GetBaseModelMatrix());
+        spheres.push_back(glm::vec4(center, radius));
+        min = glm::min(min, center - radius);
+        max = glm::max(max, center + radius);
+      }
+      const glm::vec3 center = (min + max) * 0.5f;
+      float radius = 0.0f;
+      for (const glm::vec4& sphere : spheres)
+      {
+        radius = std::max(radius, glm::length(glm::vec3(sphere) - center) + sphere.w);
+      }
+      return glm::vec4(center, radius);
+    }
+
+    //the LOD of a model with the bounding sphere _sphere drawn with _modelMatrix
+    GLuint SelectLod(const glm::vec4& _sphere, const glm::mat4& _modelMatrix, const Camera3D& _camera, float _lodScreenSize)
+    {
+      const glm::vec3 center(_modelMatrix * glm::vec4(glm::vec3(_sphere), 1.0f));
+      return Mesh::SelectLod(_camera.GetScreenSize(center, _sphere.w * MaxScale(_modelMatrix)), _lodScreenSize);
+    }
+  }
+
   glm::mat4 AssimpToGlmMat4(const aiMatrix4x4 * _aiMatrix)
   {
     glm::mat4 mat;
@@ -13,39 +151,47 @@ namespace GameEngine
     mat[0][3] = _aiMatrix->d1; mat[1][3] = _aiMatrix->d2; mat[2][3] = _aiMatrix->d3; mat[3][3] = _aiMatrix->d4;
     return mat;
   }
+  void AnimationClip::BuildBones(const aiScene* _scene, const std::map<std::string, GLuint>& _boneIDs)
+  {
+    //the root node of the hierarchy isn't a bone, it has no channel of its own so it gets the first one like the nodes without any
+    m_bones.clear();
+    m_bones.push_back(Bone());
+    BuildBones(_scene, _scene->mRootNode, 0, _boneIDs);
+  }
   //differentiating the nodes and bone nodes
-  void SkinnedModel::Animation::BuildBoneTree(const aiScene* _scene, aiNode* _node, BoneNode* _bNode, SkinnedModel* _model)
+  void AnimationClip::BuildBones(const aiScene* _scene, aiNode* _node, GLint _parent, const std::map<std::string, GLuint>& _boneIDs)
   {
     if (_scene->HasAnimations())
     {
       //Check if the passed node is a bone node, by cheching to see if the name matches with a bone ID 
-      if (_model->m_findBoneIDbyName.find(_node->mName.data) != _model->m_findBoneIDbyName.end())
+      auto boneID = _boneIDs.find(_node->mName.data);
+      if (boneID != _boneIDs.end())
       {
         // This node is a bone node
-        BoneNode tempNode;
-        tempNode.m_name = _node->mName.data;
-        tempNode.m_parent = _bNode;
-        tempNode.m_nodeTransform = AssimpToGlmMat4(&_node->mTransformation);
+        Bone bone;
+        bone.m_parent = _parent;
+        bone.m_boneID = boneID->second;
         // bones and their nodes always share the same name
-        tempNode.m_boneTransform = m_findBoneOffsetByName[tempNode.m_name];
-        _bNode->m_children.push_back(tempNode);
+        bone.m_offset = m_findBoneOffsetByName[boneID->first];
+        for (GLuint x = 0; x < m_channels.size(); x++)
+        {
+          if (m_channels[x].m_name == boneID->first)
+          {
+            bone.m_channel = x;
+          }
+        }
+        m_bones.push_back(bone);
+        // the children of a bone node hang below it, the ones of other nodes go to the bone above
+        _parent = m_bones.size() - 1;
       }
     }
 
     for (GLuint x = 0; x < _node->mNumChildren; x++)
     {
-      // if the node we just found was a bone node then pass it in (current bone node child vector size - 1)
-      if (_model->m_findBoneIDbyName.find(_node->mName.data) != _model->m_findBoneIDbyName.end())
-      {
-        BuildBoneTree(_scene, _node->mChildren[x], &_bNode->m_children[_bNode->m_children.size() - 1], _model);
-      }
-      else
-      {
-        BuildBoneTree(_scene, _node->mChildren[x], _bNode, _model);
-      }
+      BuildBones(_scene, _node->mChildren[x], _parent, _boneIDs);
     }
   }
-  void SkinnedModel::Dispose()
+  void SkeletonAsset::Dispose()
   {
     //delete the vao's and vbo's and reset them to 0
     for (auto& mesh : m_meshes)
@@ -54,40 +200,144 @@ namespace GameEngine
     }
     m_meshes.clear();
   }
+  bool SkeletonAsset::HasSameClips(const SkeletonAsset& _other) const
+  {
+    if (m_clips.size() != _other.m_clips.size())
+    {
+      return false;
+    }
+    for (size_t i = 0; i < m_clips.size(); i++)
+    {
+      if (m_clips[i].m_channels.size() != _other.m_clips[i].m_channels.size() || m_clips[i].m_bones.size() != _other.m_clips[i].m_bones.size())
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+  void SkeletonAsset::Swap(SkeletonAsset& _other)
+  {
+    m_meshes.swap(_other.m_meshes);
+    m_clips.swap(_other.m_clips);
+    std::swap(m_globalInverseTransform, _other.m_globalInverseTransform);
+    m_findBoneIDbyName.swap(_other.m_findBoneIDbyName);
+  }
+  void SkeletonAsset::ReleaseCpuData()
+  {
+    for (auto& mesh : m_meshes)
+    {
+      mesh.ReleaseCpuData();
+    }
+  }
+  glm::vec4 SkeletonAsset::GetBoundingSphere() const
+  {
+    return CalcBoundingSphere(m_meshes);
+  }
+  GLuint SkeletonAsset::FindClip(const std::string& _clipName) const
+  {
+    for (GLuint clipIndex = 0; clipIndex < m_clips.size(); clipIndex++)
+    {
+      if (m_clips[clipIndex].m_name == _clipName)
+      {
+        return clipIndex;
+      }
+    }
+    return NO_CLIP;
+  }
+
+  void SkinnedModel::Dispose()
+  {
+    //the meshes belong to the asset, the last model (or the cache) letting go of it deletes them
+    m_asset.reset();
+  }
+  void SkinnedModel::SetAsset(const std::shared_ptr<const SkeletonAsset>& _asset)
+  {
+    m_asset = _asset;
+    m_animation.SetClip(*m_asset, 0);
+  }
   void SkinnedModel::Update(float _elapsed)
   {
-    if (m_play)
+    if (m_play && m_asset)
     {
-      float timeInTicks = _elapsed * m_animations[m_currentAnimation].m_ticksPerSecond;
-      UpdateBoneTree(timeInTicks, &m_animations[m_currentAnimation].root, glm::mat4(1.0f));
+      m_animation.Update(*m_asset, _elapsed);
     }
   }
+  const std::vector<Mesh>& SkinnedModel::GetMeshes() const
+  {
+    static const std::vector<Mesh> noMeshes;
+    return m_asset ? m_asset->GetMeshes() : noMeshes;
+  }
   void SkinnedModel::Draw(GLSLProgram & _shader)
   {
-    glm::mat4 modelMatrix(1.0f);
+    if (!m_asset)
+    {
+      return;
+    }
+    const std::vector<glm::mat4>& pose = m_animation.GetPose();
+    glUniformMatrix4fv(_shader.GetUniformLocation("gBones"), pose.size(), GL_FALSE, (const GLfloat*)&pose[0][0]);
+    DrawMeshes(_shader);
+  }
+  void SkinnedModel::DrawMeshes(GLSLProgram & _shader)
+  {
+    DrawMeshes(_shader, 0u);
+  }
+  void SkinnedModel::Draw(GLSLProgram& _shader, const Camera3D& _camera)
+  {
+    if (!m_asset)
+    {
+      return;
+    }
+    const std::vector<glm::mat4>& pose = m_animation.GetPose();
+    glUniformMatrix4fv(_shader.GetUniformLocation("gBones"), pose.size(), GL_FALSE, (const GLfloat*)&pose[0][0]);
+    DrawMeshes(_shader, _camera);
+  }
+  void SkinnedModel::DrawMeshes(GLSLProgram& _shader, const Camera3D& _camera)
+  {
+    if (!m_asset)
+    {
+      return;
+    }
+    DrawMeshes(_shader, SelectLod(_camera));
+  }
+  GLuint SkinnedModel::SelectLod(const Camera3D& _camera) const
+  {
+    return m_asset ? GameEngine::SelectLod(m_asset->GetBoundingSphere(), GetModelMatrix(), _camera, m_lodScreenSize) : 0;
+  }
+  void SkinnedModel::DrawMeshes(GLSLProgram& _shader, GLuint _lod)
+  {
+    if (!m_asset)
+    {
+      return;
+    }
+    _shader.UploadValue("transformMatrix", GetModelMatrix());
+    for (const Mesh& mesh : m_asset->GetMeshes())
+    {
+      //Draw each mesh
+      mesh.DrawLod(_shader, _lod);
+    }
+  }
+  glm::mat4 SkinnedModel::GetModelMatrix() const
+  {
     glm::mat4 positionMatrix = glm::translate(glm::mat4(1.0f), m_position);
     glm::mat4 rotationMatrix = glm::mat4_cast(m_rotation);
     glm::mat4 scaleMatrix = glm::scale(glm::mat4(1.0f), m_scale);
 
-    modelMatrix = positionMatrix * rotationMatrix * scaleMatrix;
-    _shader.UploadValue("transformMatrix", modelMatrix);
-    glUniformMatrix4fv(_shader.GetUniformLocation("gBones"), m_animations[m_currentAnimation].m_boneTrans.size(),
-      GL_FALSE, (GLfloat*)&m_animations[m_currentAnimation].m_boneTrans[0][0]);
-    for (GLuint i = 0; i < m_meshes.size(); i++)
+    return positionMatrix * rotationMatrix * scaleMatrix;
+  }
+  void SkinnedModel::SetAnimation(const std::string& _animName)
+  {
+    GLuint clip = m_asset ? m_asset->FindClip(_animName) : SkeletonAsset::NO_CLIP;
+    if (clip != SkeletonAsset::NO_CLIP)
     {
-      //Draw each mesh
-      m_meshes.at(i).Draw(_shader);
+      m_animation.SetClip(*m_asset, clip);
     }
   }
-  void SkinnedModel::SetAnimation(const std::string& _animName)
+  void SkinnedModel::CrossFadeAnimation(const std::string& _animName, float _duration)
   {
-    for (GLuint animIndex = 0; animIndex < m_animations.size(); animIndex++)
+    GLuint clip = m_asset ? m_asset->FindClip(_animName) : SkeletonAsset::NO_CLIP;
+    if (clip != SkeletonAsset::NO_CLIP)
     {
-      if (m_animations[animIndex].m_name == _animName)
-      {
-        m_currentAnimation = animIndex;
-        return;
-      }
+      m_animation.CrossFade(*m_asset, clip, _duration);
     }
   }
 
@@ -121,190 +371,386 @@ namespace GameEngine
     m_scale = _scale;
   }
 
-  void SkinnedModel::UpdateBoneTree(float _deltaTIme, Animation::BoneNode* _node, const glm::mat4& _parentTransform)
+  void AnimationInstance::SetClip(const SkeletonAsset& _asset, GLuint _clip)
   {
-    GLint channelIndex = 0;
-    std::string boneName = _node->m_name;
+    m_layers.clear();
+    m_fadeDuration = 0.0f;
+    PushLayer(_asset, _clip, 1.0f);
+  }
 
-    for (GLuint x = 0; x < m_animations[m_currentAnimation].m_channels.size(); x++)
+  void AnimationInstance::CrossFade(const SkeletonAsset& _asset, GLuint _clip, float _duration)
+  {
+    if (m_layers.empty() || _duration <= 0.0f || _clip >= _asset.GetClips().size())
     {
-      if (boneName == m_animations[m_currentAnimation].m_channels[x].m_name)
-      {
-        channelIndex = x;
-      }
+      SetClip(_asset, _clip);
+      return;
     }
-    float animTime = std::fmod(_deltaTIme, m_animations[m_currentAnimation].m_duration);
-
-    glm::vec3 translation = CalcInterpolatedPosition(animTime, m_animations[m_currentAnimation].m_channels[channelIndex]);
-    glm::vec3 scaling = CalcInterpolatedScaling(animTime, m_animations[m_currentAnimation].m_channels[channelIndex]);
-    glm::mat4 rotation = CalcInterpolatedRotation(animTime, m_animations[m_currentAnimation].m_channels[channelIndex]);
+    //a fade which is still running is finished where it is, and fades out with the rest
+    for (Layer& layer : m_layers)
+    {
+      layer.m_fadeFromWeight = layer.m_weight;
+    }
+    PushLayer(_asset, _clip, 0.0f);
+    m_fadeLayer = m_layers.size() - 1;
+    m_fadeStart = m_time;
+    m_fadeDuration = _duration;
+  }
 
-    _node->m_nodeTransform = glm::translate(glm::mat4(1.0f), translation)
-      * rotation
-      * glm::scale(glm::mat4(1.0f), scaling);
+  GLuint AnimationInstance::AddLayer(const SkeletonAsset& _asset, GLuint _clip, float _weight)
+  {
+    PushLayer(_asset, _clip, _weight);
+    return m_layers.size() - 1;
+  }
 
-    glm::mat4 finalModel = _parentTransform * _node->m_nodeTransform;
+  void AnimationInstance::SetLayerWeight(GLuint _layer, float _weight)
+  {
+    m_layers.at(_layer).m_weight = _weight;
+  }
 
-    m_animations[m_currentAnimation].m_boneTrans[m_findBoneIDbyName[boneName]] =
-      m_globalInverseTransform *
-      finalModel *
-      _node->m_boneTransform;
+  AnimationInstance::Layer& AnimationInstance::PushLayer(const SkeletonAsset& _asset, GLuint _clip, float _weight)
+  {
+    if (m_layers.empty())
+    {
+      m_pose.assign(SkeletonAsset::MAX_BONES, glm::mat4(1.0f));
+      m_globalTransforms.assign(_clip < _asset.GetClips().size() ? _asset.GetClips()[_clip].m_bones.size() : 0, glm::mat4(1.0f));
+    }
+    m_layers.emplace_back();
+    Layer& layer = m_layers.back();
+    layer.m_clip = _clip;
+    layer.m_weight = _weight;
+    layer.m_fadeFromWeight = _weight;
+    if (_clip < _asset.GetClips().size())
+    {
+      layer.m_cursors.assign(_asset.GetClips()[_clip].m_channels.size(), KeyCursors());
+    }
+    return layer;
+  }
 
-    // loop through every child and use this bone's transformations as the parent transform
-    for (GLuint x = 0; x < _node->m_children.size(); x++)
+  void AnimationInstance::UpdateFade()
+  {
+    if (m_fadeDuration <= 0.0f)
+    {
+      return;
+    }
+    const float fade = std::min(std::max((m_time - m_fadeStart) / m_fadeDuration, 0.0f), 1.0f);
+    for (GLuint x = 0; x < m_layers.size(); x++)
+    {
+      Layer& layer = m_layers[x];
+      layer.m_weight = layer.m_fadeFromWeight * (1.0f - fade) + (x == m_fadeLayer ? fade : 0.0f);
+    }
+    if (fade >= 1.0f)
     {
-      UpdateBoneTree(_deltaTIme, &_node->m_children[x], finalModel);
+      //only the faded to layer is left, it becomes the first one (and its clip's hierarchy the one used)
+      Layer layer = std::move(m_layers[m_fadeLayer]);
+      layer.m_weight = 1.0f;
+      m_layers.clear();
+      m_layers.push_back(std::move(layer));
+      m_fadeDuration = 0.0f;
     }
   }
 
-  GLuint SkinnedModel::FindPositionKey(float _animTime, Animation::Channel& _channel)
+  void AnimationInstance::Update(const SkeletonAsset& _asset, float _time)
   {
-    for (GLuint i = 0; i < _channel.m_positionKeys.size() - 1; i++)
+    m_time = _time;
+    UpdateFade();
+    if (m_layers.empty() || m_layers[0].m_clip >= _asset.GetClips().size())
+    {
+      return;
+    }
+    for (Layer& layer : m_layers)
+    {
+      const AnimationClip& clip = _asset.GetClips()[layer.m_clip];
+      layer.m_animTime = std::fmod(_time * clip.m_ticksPerSecond, clip.m_duration);
+    }
+    const AnimationClip& baseClip = _asset.GetClips()[m_layers[0].m_clip];
+    m_globalTransforms.resize(baseClip.m_bones.size());
+
+    // the parents come first, so their transforms are done by the time their children use them
+    for (GLuint x = 0; x < baseClip.m_bones.size(); x++)
     {
-      if (_animTime < (float)_channel.m_positionKeys.at(i + 1).mTime)
+      const AnimationClip::Bone& bone = baseClip.m_bones[x];
+
+      glm::vec3 translation(0.0f);
+      glm::vec3 scaling(0.0f);
+      glm::quat rotation(0.0f, 0.0f, 0.0f, 0.0f);
+      if (m_layers.size() == 1)
       {
-        return i;
+        const AnimationClip::Channel& channel = baseClip.m_channels[bone.m_channel];
+        KeyCursors& cursors = m_layers[0].m_cursors[bone.m_channel];
+        translation = CalcInterpolatedPosition(m_layers[0].m_animTime, channel, cursors);
+        scaling = CalcInterpolatedScaling(m_layers[0].m_animTime, channel, cursors);
+        rotation = CalcInterpolatedRotation(m_layers[0].m_animTime, channel, cursors);
+      }
+      else
+      {
+        //the weighted average of the local transforms of all the layers, the rotations on the same hemisphere and normalized afterwards
+        float totalWeight = 0.0f;
+        for (Layer& layer : m_layers)
+        {
+          const AnimationClip& clip = _asset.GetClips()[layer.m_clip];
+          if (layer.m_weight <= 0.0f || x >= clip.m_bones.size())
+          {
+            continue;
+          }
+          const GLuint channelIndex = clip.m_bones[x].m_channel;
+          const AnimationClip::Channel& channel = clip.m_channels[channelIndex];
+          KeyCursors& cursors = layer.m_cursors[channelIndex];
+          glm::quat layerRotation = CalcInterpolatedRotation(layer.m_animTime, channel, cursors);
+          if (glm::dot(rotation, layerRotation) < 0.0f)
+          {
+            layerRotation = -layerRotation;
+          }
+          translation += CalcInterpolatedPosition(layer.m_animTime, channel, cursors) * layer.m_weight;
+          scaling += CalcInterpolatedScaling(layer.m_animTime, channel, cursors) * layer.m_weight;
+          rotation += layerRotation * layer.m_weight;
+          totalWeight += layer.m_weight;
+        }
+        if (totalWeight <= 0.0f)
+        {
+          translation = glm::vec3(0.0f);
+          scaling = glm::vec3(1.0f);
+          rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        }
+        else
+        {
+          translation /= totalWeight;
+          scaling /= totalWeight;
+          rotation = glm::normalize(rotation);
+        }
       }
-    }
 
-    assert(0);
+      glm::mat4 nodeTransform = ComposeTRS(translation, rotation, scaling);
 
-    return 0;
-  }
+      // the global inverse transform goes into the root, so every bone below it already has it in its parent's transform
+      glm::mat4& finalModel = m_globalTransforms[x];
+      finalModel = (bone.m_parent == AnimationClip::NO_PARENT ? _asset.GetGlobalInverseTransform() : m_globalTransforms[bone.m_parent]) * nodeTransform;
 
-  GLuint SkinnedModel::FindRotationKey(float _animTime, Animation::Channel& _channel)
-  {
-    for (GLuint i = 0; i < _channel.m_rotationKeys.size() - 1; i++)
-    {
-      if (_animTime < (float)_channel.m_rotationKeys.at(i + 1).mTime)
+      if (bone.m_boneID != AnimationClip::NO_BONE)
       {
-        return i;
+        m_pose[bone.m_boneID] = finalModel * bone.m_offset;
       }
     }
+  }
 
-    assert(0);
-
-    return 0;
+  glm::vec3 AnimationInstance::CalcInterpolatedPosition(float _animTime, const AnimationClip::Channel& _channel, KeyCursors& _cursors)
+  {
+    return Sample(_animTime, _channel.m_positions, _cursors.m_position, glm::vec3(0.0f));
   }
-  GLuint SkinnedModel::FindScalingKey(float _animTime, Animation::Channel& _channel)
+
+  glm::quat AnimationInstance::CalcInterpolatedRotation(float _animTime, const AnimationClip::Channel& _channel, KeyCursors& _cursors)
   {
-    for (GLuint i = 0; i < _channel.m_scalingKeys.size() - 1; i++)
+    const AnimationTrack<PackedQuat>& track = _channel.m_rotations;
+    if (track.m_values.size() < 2)
     {
-      if (_animTime < (float)_channel.m_scalingKeys.at(i + 1).mTime)
-      {
-        return i;
-      }
+      // we need at least two values to interpolate...
+      return track.m_values.empty() ? glm::quat(1.0f, 0.0f, 0.0f, 0.0f) : UnpackQuat(track.m_values[0]);
     }
+    float factor = 0.0f;
+    const GLuint key = FindKey(_animTime, track, _cursors.m_rotation, factor);
+    return glm::normalize(glm::slerp(UnpackQuat(track.m_values[key]), UnpackQuat(track.m_values[key + 1]), factor));
+  }
+
+  glm::vec3 AnimationInstance::CalcInterpolatedScaling(float _animTime, const AnimationClip::Channel& _channel, KeyCursors& _cursors)
+  {
+    return Sample(_animTime, _channel.m_scalings, _cursors.m_scaling, glm::vec3(1.0f));
+  }
 
-    assert(0);
+  void StaticModel::Draw(GLSLProgram & _shader)
+  {
+    _shader.UploadValue("transformMatrix", GetModelMatrix());
 
-    return 0;
+    for (auto& mesh : m_meshes)
+    {
+      //Draw each mesh
+      mesh.Draw(_shader);
+    }
   }
 
-  glm::vec3 SkinnedModel::CalcInterpolatedPosition(float _animTime, Animation::Channel& _channel)
+  void StaticModel::Draw(GLSLProgram& _shader, const Camera3D& _camera)
   {
-    glm::vec3 result(0.0f);
-    if (_channel.m_positionKeys.size() == 1)
+    const glm::mat4 modelMatrix = GetModelMatrix();
+    const GLuint lod = SelectLod(GetBoundingSphere(), modelMatrix, _camera, m_lodScreenSize);
+    _shader.UploadValue("transformMatrix", modelMatrix);
+    for (auto& mesh : m_meshes)
     {
-      // we need at least two values to interpolate...
-      result = glm::vec3(_channel.m_positionKeys.at(0).mValue.x, _channel.m_positionKeys.at(0).mValue.y, _channel.m_positionKeys.at(0).mValue.z);
-      return result;
+      mesh.DrawLod(_shader, lod);
     }
+  }
 
-    GLuint positionIndex = FindPositionKey(_animTime, _channel);
-    GLuint nextPositionIndex = (positionIndex + 1);
-    assert(nextPositionIndex < _channel.m_positionKeys.size());
-    float deltaTime = (float)(_channel.m_positionKeys.at(nextPositionIndex).mTime - _channel.m_positionKeys.at(positionIndex).mTime);
-    float factor = (_animTime - (float)_channel.m_positionKeys.at(positionIndex).mTime) / deltaTime;
-    assert(factor >= 0.0f && factor <= 1.0f);
-    const aiVector3D& start = _channel.m_positionKeys.at(positionIndex).mValue;
-    const aiVector3D& end = _channel.m_positionKeys.at(nextPositionIndex).mValue;
-    aiVector3D delta = end - start;
-    aiVector3D resultingVec = start + (factor * delta);
-    result = glm::vec3(resultingVec.x, resultingVec.y, resultingVec.z);
-    return result;
+  void StaticModel::DrawInstanced(GLSLProgram & _shader, std::vector<glm::mat4>& _modelMatrices)
+  {
+    UploadInstances(_modelMatrices);
+    SetInstanceSource(m_instanceBuffer);
+    for (GLuint i = 0; i < m_meshes.size(); i++)
+    {
+      //Draw each mesh
+      m_meshes.at(i).Draw(_shader, _modelMatrices.size());
+    }
   }
 
-  glm::mat4 SkinnedModel::CalcInterpolatedRotation(float _animTime, Animation::Channel& _channel)
+  void StaticModel::DrawInstanced(GLSLProgram& _shader, std::vector<glm::mat4>& _modelMatrices, const VertexAnimationTexture& _animation,
+    const std::vector<float>& _timeOffsets, float _time)
   {
-    glm::quat result;
-    aiQuaternion aiRotation;
+    assert(_timeOffsets.size() >= _modelMatrices.size());
+    _animation.Bind(_shader, _time);
+    UploadInstances(_modelMatrices);
+    SetInstanceSource(m_instanceBuffer);
+    for (GLuint i = 0; i < m_meshes.size(); i++)
+    {
+      m_meshes.at(i).UploadInstanceTimes(_timeOffsets);
+      //the columns of the mesh in the texture
+      _shader.UploadValue("vatVertexOffset", static_cast<int>(_animation.GetVertexOffset(i)));
+      m_meshes.at(i).Draw(_shader, _modelMatrices.size());
+    }
+  }
 
-    if (_channel.m_rotationKeys.size() == 1)
+  void StaticModel::UploadInstances(const std::vector<glm::mat4>& _modelMatrices)
+  {
+    m_numUploadedInstances = 0;
+    if (m_instanceBuffer == 0)
     {
-      // we need at least two values to interpolate...
-      aiRotation = _channel.m_rotationKeys.at(0).mValue;
-      result = glm::quat((GLfloat)aiRotation.w, (GLfloat)aiRotation.x, (GLfloat)aiRotation.y, (GLfloat)aiRotation.z);
-      return glm::mat4_cast(result);
+      glGenBuffers(1, &m_instanceBuffer);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    if (_modelMatrices.size() > m_instanceCapacity)
+    {
+      //grows by doubling, so a slowly growing crowd doesn't reallocate every frame
+      m_instanceCapacity = std::max(_modelMatrices.size(), m_instanceCapacity * 2);
+      glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+      m_instanceMatrices.clear();
     }
 
-    GLuint rotationIndex = FindRotationKey(_animTime, _channel);
-    GLuint nextRotationIndex = (rotationIndex + 1);
-    assert(nextRotationIndex < _channel.m_positionKeys.size());
-    float deltaTime = (float)(_channel.m_rotationKeys.at(nextRotationIndex).mTime - _channel.m_rotationKeys.at(rotationIndex).mTime);
-    float factor = (_animTime - (float)_channel.m_rotationKeys.at(rotationIndex).mTime) / deltaTime;
-    assert(factor >= 0.0f && factor <= 1.0f);
-    const aiQuaternion& StartRotationQ = _channel.m_rotationKeys.at(rotationIndex).mValue;
-    const aiQuaternion& EndRotationQ = _channel.m_rotationKeys.at(nextRotationIndex).mValue;
-    aiQuaternion::Interpolate(aiRotation, StartRotationQ, EndRotationQ, factor);
-    aiRotation = aiRotation.Normalize();
-    result = glm::quat((GLfloat)aiRotation.w, (GLfloat)aiRotation.x, (GLfloat)aiRotation.y, (GLfloat)aiRotation.z);
-    return glm::mat4_cast(result);
+    //the runs of changed matrices, runs closer than MAX_GAP matrices are uploaded as one
+    const size_t MAX_GAP = 8;
+    const size_t numKept = std::min(m_instanceMatrices.size(), _modelMatrices.size());
+    size_t i = 0;
+    while (i < _modelMatrices.size())
+    {
+      if (i < numKept && m_instanceMatrices[i] == _modelMatrices[i])
+      {
+        i++;
+        continue;
+      }
+      const size_t begin = i;
+      size_t end = i + 1;
+      for (size_t j = end; j < _modelMatrices.size() && j < end + MAX_GAP; j++)
+      {
+        if (j >= numKept || m_instanceMatrices[j] != _modelMatrices[j])
+        {
+          end = j + 1;
+        }
+      }
+      FrameStats::Get().Add(STAT_BYTES_UPLOADED, (end - begin) * sizeof(glm::mat4));
+      glBufferSubData(GL_ARRAY_BUFFER, begin * sizeof(glm::mat4), (end - begin) * sizeof(glm::mat4), &_modelMatrices[begin]);
+      m_numUploadedInstances += end - begin;
+      i = end;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_instanceMatrices = _modelMatrices;
   }
 
-  glm::vec3 SkinnedModel::CalcInterpolatedScaling(float _animTime, Animation::Channel& _channel)
+  void StaticModel::DrawInstanced(GLSLProgram& _shader, std::vector<glm::mat4>& _modelMatrices, InstanceCuller& _culler, const Camera3D& _camera)
   {
-    glm::vec3 result(0.0f);
-    if (_channel.m_scalingKeys.size() == 1)
+    UploadInstances(_modelMatrices);
+    _culler.Cull(m_meshes, m_instanceBuffer, static_cast<GLuint>(_modelMatrices.size()), _camera.GetFrustumPlanes());
+    SetInstanceSource(_culler.GetOutputBuffer());
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _culler.GetCommandBuffer());
+    for (GLuint i = 0; i < m_meshes.size(); i++)
     {
-      // we need at least two values to interpolate...
-      result = glm::vec3(_channel.m_scalingKeys.at(0).mValue.x, _channel.m_scalingKeys.at(0).mValue.y, _channel.m_scalingKeys.at(0).mValue.z);
-      return result;
+      m_meshes.at(i).DrawIndirect(_shader, i * sizeof(DrawElementsIndirectCommand));
     }
-
-    GLuint scalingIndex = FindScalingKey(_animTime, _channel);
-    GLuint nextScalingIndex = (scalingIndex + 1);
-    assert(nextScalingIndex < _channel.m_scalingKeys.size());
-    float deltaTime = (float)(_channel.m_scalingKeys.at(nextScalingIndex).mTime - _channel.m_scalingKeys.at(scalingIndex).mTime);
-    float factor = (_animTime - (float)_channel.m_scalingKeys.at(scalingIndex).mTime) / deltaTime;
-    assert(factor >= 0.0f && factor <= 1.0f);
-    const aiVector3D& start = _channel.m_scalingKeys.at(scalingIndex).mValue;
-    const aiVector3D& end = _channel.m_scalingKeys.at(nextScalingIndex).mValue;
-    aiVector3D delta = end - start;
-    aiVector3D resultingVec = start + (factor * delta);
-    result = glm::vec3(resultingVec.x, resultingVec.y, resultingVec.z);
-    return result;
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
   }
 
-  void StaticModel::Draw(GLSLProgram & _shader)
+  void StaticModel::DrawInstanced(GLSLProgram& _shader, std::vector<glm::mat4>& _modelMatrices, const Camera3D& _camera)
   {
-    glm::mat4 modelMatrix(1.0f);
-    glm::mat4 positionMatrix = glm::translate(glm::mat4(1.0f), m_position);
-    glm::mat4 rotationMatrix = glm::mat4_cast(m_rotation);
-    glm::mat4 scaleMatrix = glm::scale(glm::mat4(1.0f), m_scale);
+    const glm::vec4 sphere = GetBoundingSphere();
+    GLuint numInstances[Mesh::MAX_LODS] = { 0 };
+    m_instanceLods.resize(_modelMatrices.size());
+    for (size_t i = 0; i < _modelMatrices.size(); i++)
+    {
+      m_instanceLods[i] = SelectLod(sphere, _modelMatrices[i], _camera, m_lodScreenSize);
+      numInstances[m_instanceLods[i]]++;
+    }
+    GLuint firstInstance[Mesh::MAX_LODS] = { 0 };
+    for (GLuint lod = 1; lod < Mesh::MAX_LODS; lod++)
+    {
+      firstInstance[lod] = firstInstance[lod - 1] + numInstances[lod - 1];
+    }
 
-    modelMatrix = positionMatrix * rotationMatrix * scaleMatrix;
-    _shader.UploadValue("transformMatrix", modelMatrix);
+    //grouped in a stable order, so the instances which keep their LOD mostly keep their place in the buffer and aren't uploaded again
+    GLuint next[Mesh::MAX_LODS];
+    std::copy(firstInstance, firstInstance + Mesh::MAX_LODS, next);
+    m_lodMatrices.resize(_modelMatrices.size());
+    for (size_t i = 0; i < _modelMatrices.size(); i++)
+    {
+      m_lodMatrices[next[m_instanceLods[i]]++] = _modelMatrices[i];
+    }
+    UploadInstances(m_lodMatrices);
+    SetInstanceSource(m_instanceBuffer);
+    for (const Mesh& mesh : m_meshes)
+    {
+      for (GLuint lod = 0; lod < Mesh::MAX_LODS; lod++)
+      {
+        if (numInstances[lod] > 0)
+        {
+          mesh.DrawLod(_shader, lod, numInstances[lod], firstInstance[lod]);
+        }
+      }
+    }
+  }
 
-    for (auto& mesh : m_meshes)
+  glm::vec4 StaticModel::GetBoundingSphere() const
+  {
+    return CalcBoundingSphere(m_meshes);
+  }
+
+  AABB StaticModel::GetBoundingBox() const
+  {
+    if (m_meshes.empty())
     {
-      //Draw each mesh
-      mesh.Draw(_shader);
+      return AABB();
     }
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(-std::numeric_limits<float>::max());
+    for (const Mesh& mesh : m_meshes)
+    {
+      const AABB box = mesh.GetBoundingBox().Transformed(mesh.GetBaseModelMatrix());
+      min = glm::min(min, box.GetMin());
+      max = glm::max(max, box.GetMax());
+    }
+    return AABB(min, max);
   }
 
-  void StaticModel::DrawInstanced(GLSLProgram & _shader, std::vector<glm::mat4>& _modelMatrices)
+  void StaticModel::SwapMeshes(StaticModel& _other)
   {
-    for (GLuint i = 0; i < m_meshes.size(); i++)
+    m_meshes.swap(_other.m_meshes);
+    //the new meshes don't read any instance buffer yet
+    m_instanceSource = 0;
+  }
+
+  void StaticModel::SetInstanceSource(GLuint _buffer)
+  {
+    if (m_instanceSource == _buffer)
     {
-      glBindBuffer(GL_ARRAY_BUFFER, m_meshes.at(i).GetMBO());
-      glBufferData(GL_ARRAY_BUFFER, _modelMatrices.size() * sizeof(glm::mat4), nullptr, GL_STATIC_DRAW);
-      glBufferSubData(GL_ARRAY_BUFFER, 0, _modelMatrices.size() * sizeof(glm::mat4), _modelMatrices.data());
-      //Draw each mesh
-      m_meshes.at(i).Draw(_shader, _modelMatrices.size());
+      return;
+    }
+    m_instanceSource = _buffer;
+    for (auto& mesh : m_meshes)
+    {
+      mesh.SetInstanceBuffer(_buffer);
     }
   }
 
+  glm::mat4 StaticModel::GetModelMatrix() const
+  {
+    glm::mat4 positionMatrix = glm::translate(glm::mat4(1.0f), m_position);
+    glm::mat4 rotationMatrix = glm::mat4_cast(m_rotation);
+    glm::mat4 scaleMatrix = glm::scale(glm::mat4(1.0f), m_scale);
+
+    return positionMatrix * rotationMatrix * scaleMatrix;
+  }
+
   void StaticModel::OffsetPosition(const glm::vec3 _position)
   {
     m_position += _position;
@@ -334,6 +780,14 @@ namespace GameEngine
   {
     m_scale = _scale;
   }
+  void StaticModel::ReleaseCpuData()
+  {
+    for (auto& mesh : m_meshes)
+    {
+      mesh.ReleaseCpuData();
+    }
+  }
+
   void StaticModel::Dispose()
   {
     //delete the vao's and vbo's and reset them to 0
@@ -342,6 +796,14 @@ namespace GameEngine
       mesh.Dispose();
     }
     m_meshes.clear();
+    if (m_instanceBuffer != 0)
+    {
+      glDeleteBuffers(1, &m_instanceBuffer);
+      m_instanceBuffer = 0;
+    }
+    m_instanceSource = 0;
+    m_instanceCapacity = 0;
+    m_instanceMatrices.clear();
   }
   
 }
\ No newline at end of file
@@ -6,26 +6,207 @@
 #include <glm\gtc\matrix_transform.hpp>
 #include <glm\gtc\quaternion.hpp>
 #include <map>
+#include <memory>
 
+#include "AnimationCompression.h"
 #include "Mesh.h"
 
 namespace GameEngine
 {
-  /* Model with skinned bone animation*/
-  class SkinnedModel
+  class VertexAnimationTexture;
+  class InstanceCuller;
+  class Camera3D;
+
+  /** \brief An animation of a skeleton, the data of a clip isn't modified once it's loaded so all the models playing it share it */
+  struct AnimationClip
+  {
+    enum : GLint { NO_PARENT = -1 };
+    enum : GLuint { NO_BONE = 0xFFFFFFFF };
+
+    /** \brief The channel struct used to store bone data.
+    Each channel is actually the bone with all its transformations, name and offset*/
+    struct Channel
+    {
+      ///the name of the bone (the bone node corresponding to a bone has the same name)
+      std::string m_name{ "" };
+      ///The offset matrix of this bone
+      glm::mat4 m_offset{ 1.0f };
+      ///The position, rotation and scaling values for this bone over the animation, compressed when the clip is loaded
+      AnimationTrack<glm::vec3> m_positions;
+      AnimationTrack<PackedQuat> m_rotations;
+      AnimationTrack<glm::vec3> m_scalings;
+    };
+    /** \brief A node of the bone hierarchy, baked at load time so the evaluation needs no names or lookups.
+    The bones are stored parent first (a parent always has a lower index than its children), so one loop over them
+    can multiply every node transform with the already finished transform of its parent.
+    offset is the matrix used in the calculation for the final matrix (which transforms from model space to bone space) */
+    struct Bone
+    {
+      ///the index of the parent bone in m_bones, NO_PARENT for the root
+      GLint m_parent{ NO_PARENT };
+      ///the index of the channel animating this bone in m_channels
+      GLuint m_channel{ 0 };
+      ///the index of this bone in the pose (the ID the vertices use), NO_BONE for the root
+      GLuint m_boneID{ NO_BONE };
+      ///the bone offset of this node
+      glm::mat4 m_offset{ 1.0f };
+    };
+    ///the name of this animation
+    std::string m_name{ "" };
+    ///the durotation of this animation
+    float m_duration{ 0.0f };
+    ///It's ticks per second
+    float m_ticksPerSecond{ 0.0f };
+    ///a map to find a mat4 bone offset by its name (only used while loading)
+    std::map <std::string, glm::mat4> m_findBoneOffsetByName;
+    ///all of the channels (bones and their transforms) for this animation
+    ///assimp calls it a channel, its anims for a node aka bone
+    std::vector <Channel> m_channels;
+    ///the bone hierarchy, parent first, m_bones[0] is the root
+    std::vector <Bone> m_bones;
+
+    ///Bake the bone hierarchy of this one animation
+    void BuildBones(const aiScene* _scene, const std::map<std::string, GLuint>& _boneIDs);
+    void BuildBones(const aiScene* _scene, aiNode* _node, GLint _parent, const std::map<std::string, GLuint>& _boneIDs);
+  };
+
+  /** \brief The shared part of a skinned model: its meshes (on the GPU once), bone IDs and animation clips.
+  The Cache loads it once per file and every SkinnedModel of the file points to it, only their AnimationInstance is their own */
+  class SkeletonAsset
   {
     friend class AssimpLoader;
+    friend class ModelCooker;
+  public:
+    /** \brief The size of the pose (and of the gBones uniform array of the animation shader) */
+    enum : GLuint { MAX_BONES = 100 };
+    enum : GLuint { NO_CLIP = 0xFFFFFFFF };
+
+    SkeletonAsset() {}
+    ~SkeletonAsset() { Dispose(); }
+
+    void Dispose();
+    /** \brief Frees the CPU copies of the vertices of all the meshes */
+    void ReleaseCpuData();
+
+    /** \brief Gets the index of the clip called _clipName, NO_CLIP if there isn't one */
+    GLuint FindClip(const std::string& _clipName) const;
+    /** \brief Whether _other has as many clips, each with the same channels and bones, so the AnimationInstances playing this asset
+    * can play the other one (their layers keep clip indices and a cursor per channel) */
+    bool HasSameClips(const SkeletonAsset& _other) const;
+    /** \brief Exchanges the meshes and clips with _other, for the hot reload of a shared asset in place */
+    void Swap(SkeletonAsset& _other);
+
+    const std::vector<Mesh>& GetMeshes() const noexcept { return m_meshes; }
+    const std::vector<AnimationClip>& GetClips() const noexcept { return m_clips; }
+    /** \brief The sphere around the meshes in the bind pose (with their baseModelMatrix), the center in xyz and the radius in w */
+    glm::vec4 GetBoundingSphere() const;
+    const glm::mat4& GetGlobalInverseTransform() const noexcept { return m_globalInverseTransform; }
+  private:
+    std::vector<Mesh> m_meshes; ///< all the meshes this model consists of
+    std::vector<AnimationClip> m_clips; ///< all the animations this model has
+    glm::mat4 m_globalInverseTransform{ 1.0f }; ///the global inverse transform matrix
+    std::map<std::string, GLuint> m_findBoneIDbyName; ///< a map to find a bone's ID by it's name (only used while loading)
+  };
+
+  /** \brief The state of one model playing clips of a SkeletonAsset: the layers (clips and their weights), their key cursors and the evaluated pose.
+  It's the only part of a skinned model which isn't shared, so hundreds of them can play their own animations on one mesh.
+  All the layers are sampled into the local translation, rotation and scale of every bone and blended there, before the single pass
+  through the hierarchy, so a crossfade or a blend of a few clips costs about one extra sampling per clip and no extra matrix products */
+  class AnimationInstance
+  {
+  public:
+    AnimationInstance() {}
+    ~AnimationInstance() {}
+
+    /** \brief Plays only clip _clip of _asset (from the first keys on) */
+    void SetClip(const SkeletonAsset& _asset, GLuint _clip);
+
+    /** \brief Fades from the current layers to clip _clip over _duration seconds (from the next Update on), then plays only it */
+    void CrossFade(const SkeletonAsset& _asset, GLuint _clip, float _duration);
+
+    /** \brief Adds a layer playing clip _clip, blended with the others by _weight (e.g. for a walk/run blend by speed)
+    * \return the index of the layer, for SetLayerWeight */
+    GLuint AddLayer(const SkeletonAsset& _asset, GLuint _clip, float _weight);
+    /** \brief Sets the weight of layer _layer, the weights are relative to each other (they don't need to add up to 1) */
+    void SetLayerWeight(GLuint _layer, float _weight);
+
+    /** \brief Evaluates the pose at _time seconds (every clip wrapped to its own duration) */
+    void Update(const SkeletonAsset& _asset, float _time);
+
+    /** \brief The clip which was set, faded to or added last */
+    GLuint GetClip() const noexcept { return m_layers.empty() ? 0 : m_layers.back().m_clip; }
+    GLuint GetNumLayers() const noexcept { return m_layers.size(); }
+    /** \brief The final bone transforms, indexed by bone ID (what the vertices use) */
+    const std::vector<glm::mat4>& GetPose() const noexcept { return m_pose; }
+  private:
+    /** \brief The keys the last samples of a channel were at, the next sample starts looking from them */
+    struct KeyCursors
+    {
+      GLuint m_position{ 0 };
+      GLuint m_rotation{ 0 };
+      GLuint m_scaling{ 0 };
+    };
+    /** \brief A clip played by the instance and its share of the blend */
+    struct Layer
+    {
+      GLuint m_clip{ 0 }; ///< the index of the clip in the asset
+      float m_weight{ 1.0f };
+      float m_fadeFromWeight{ 0.0f }; ///< the weight when the crossfade started
+      float m_animTime{ 0.0f }; ///< the time in the clip (in ticks) of the current Update
+      std::vector<KeyCursors> m_cursors; ///< by channel of the clip
+    };
+
+    std::vector<Layer> m_layers; ///< the bone hierarchy is the one of the first layer's clip (all the clips of an asset are built from the same nodes)
+    GLuint m_fadeLayer{ 0 }; ///< the layer faded to while m_fadeDuration > 0
+    float m_fadeStart{ 0.0f };
+    float m_fadeDuration{ 0.0f };
+    float m_time{ 0.0f }; ///< the time of the last Update, crossfades start from it
+    std::vector<glm::mat4> m_globalTransforms; ///< the global inverse times the model space transform of every bone of the clip, modified every frame
+    std::vector<glm::mat4> m_pose; ///< all of the bone transformations, this is modified every frame
+
+    /** \brief Starts a layer with fresh cursors, the bone buffers are sized for the first one */
+    Layer& PushLayer(const SkeletonAsset& _asset, GLuint _clip, float _weight);
+    /** \brief Advances the crossfade to m_time, ending it (and dropping the faded out layers) once it's done */
+    void UpdateFade();
+
+    /** \brief Calculate the interpolated position*/
+    static glm::vec3 CalcInterpolatedPosition(float _animTime, const AnimationClip::Channel& _channel, KeyCursors& _cursors);
+    static glm::quat CalcInterpolatedRotation(float _animTime, const AnimationClip::Channel& _channel, KeyCursors& _cursors);
+    static glm::vec3 CalcInterpolatedScaling(float _animTime, const AnimationClip::Channel& _channel, KeyCursors& _cursors);
+  };
+
+  /* Model with skinned bone animation, a shared SkeletonAsset and an AnimationInstance of its own*/
+  class SkinnedModel
+  {
+    friend class AnimationSystem;
   public:
     SkinnedModel() {}
     ~SkinnedModel() { Dispose(); }
 
+    /** \brief Lets go of the asset (its meshes stay on the GPU while the Cache or other models still use them) */
     void Dispose();
 
+    /** \brief Sets the asset to draw and animate, starting its first clip (done by ResourceManager::GetSkinnedModel) */
+    void SetAsset(const std::shared_ptr<const SkeletonAsset>& _asset);
+
     void Update(float _elapsed);
 
+    /** \brief Uploads the pose to the plain gBones uniform array of _shader and draws the meshes (for a single model,
+    many of them are cheaper through an AnimationSystem) */
     void Draw(GLSLProgram& _shader);
+    /** \brief Draws the meshes without uploading the pose, for shaders which get it from elsewhere (see AnimationSystem) */
+    void DrawMeshes(GLSLProgram& _shader);
+    /** \brief Same as Draw and DrawMeshes, with the meshes at the LOD for the size of the model on the screen of _camera (see SetLodScreenSize) */
+    void Draw(GLSLProgram& _shader, const Camera3D& _camera);
+    void DrawMeshes(GLSLProgram& _shader, const Camera3D& _camera);
+    /** \brief The screen size (see Camera3D::GetScreenSize) below which the LOD draws switch from LOD 0 to LOD 1, every next LOD at half of it */
+    void SetLodScreenSize(float _screenSize) { m_lodScreenSize = _screenSize; }
+    /** \brief The LOD the draws with _camera pick for the size of the model on its screen */
+    GLuint SelectLod(const Camera3D& _camera) const;
 
     void SetAnimation(const std::string& _animName);
+    /** \brief Fades from the playing animation to _animName over _duration seconds */
+    void CrossFadeAnimation(const std::string& _animName, float _duration);
     void SetAnimationPlay(bool _play) { m_play = _play; }
 
     void OffsetPosition(const glm::vec3 _position);
@@ -36,91 +217,29 @@ namespace GameEngine
     void SetRotation(const glm::vec3 _rotation);
     void SetScale(const glm::vec3 _scale);
 
-    std::vector<Mesh> GetMeshes() { return m_meshes; }
+    const std::vector<Mesh>& GetMeshes() const;
+    const std::shared_ptr<const SkeletonAsset>& GetAsset() const noexcept { return m_asset; }
+    /** \brief The transformMatrix the draws upload, from the position, rotation and scale */
+    glm::mat4 GetModelMatrix() const;
   private:
-    /** \brief The animation struct used to store the animation data of the model*/
-    struct Animation
-    {
-      /** \brief The channel struct used to store bone data.
-      Each channel is actually the bone with all its transformations, name and offset*/
-      struct Channel
-      {
-        ///the name of the bone (the bone node corresponding to a bone has the same name)
-        std::string m_name{ "" };
-        ///The offset matrix of this bone
-        glm::mat4 m_offset{ 1.0f };
-        ///The position, rotation and scaling values for this bone for every frame of the current animation
-        std::vector <aiVectorKey> m_positionKeys;
-        std::vector <aiQuatKey> m_rotationKeys;
-        std::vector <aiVectorKey> m_scalingKeys;
-      };
-      /** \brief The bonenode struct used to store bone info in a tree-based way.
-      It stores the name of the node(aiNode), the parent of the bone and its children.
-      nodeTransform is the matrix that contains the translation, rotation and scaling of the bone in the current frame
-      boneTransform is the offset matrix used in the calculation for the final matrix
-      (which transforms from model space to bone space) */
-      struct BoneNode
-      {
-        ///the name of this bone node(same as the name of the bone this node corresponds to)
-        std::string m_name{ "" };
-        ///the parent of this bone node
-        BoneNode* m_parent{ nullptr };
-        ///The children of this bone node
-        std::vector <BoneNode> m_children;
-        ///The container of the translation * rotation * scaling matrix
-        glm::mat4 m_nodeTransform{ 1.0f };
-        ///the container of the bone offset for this node
-        glm::mat4 m_boneTransform{ 1.0f };
-      };
-      ///the name of this animation
-      std::string m_name{ "" };
-      ///the durotation of this animation
-      float m_duration{ 0.0f };
-      ///It's ticks per second
-      float m_ticksPerSecond{ 0.0f };
-      ///a map to find a mat4 bone offset by its name
-      std::map <std::string, glm::mat4> m_findBoneOffsetByName;
-      ///all of the bone transformations, this is modified every frame
-      ///assimp calls it a channel, its anims for a node aka bone
-      std::vector <glm::mat4> m_boneTrans;
-      ///all of the channels (bones and their transforms) for this animation
-      std::vector <Channel> m_channels;
-      ///the bonenode root (start of the tree)
-      BoneNode root;
-
-      ///Build the bone tree of this one animation
-      void BuildBoneTree(const aiScene* _scene, aiNode* _node, BoneNode* _bNode, SkinnedModel* _model);
-    };
+    void DrawMeshes(GLSLProgram& _shader, GLuint _lod);
 
     /* Model parameters */
-    GLuint m_currentAnimation{ 0 }; ///< the current animation this model will play
-    std::vector<Mesh> m_meshes; ///< all the meshes this model consists of
-    std::vector<Animation> m_animations; ///< all the animations this model has
-    glm::mat4 m_globalInverseTransform{ 1.0f }; ///the global inverse transform matrix
-    std::map<std::string, GLuint> m_findBoneIDbyName; ///< a map to find a bone's ID by it's name
+    std::shared_ptr<const SkeletonAsset> m_asset; ///< the meshes and clips, shared with the other models of the same file
+    AnimationInstance m_animation; ///< the clip this model plays and its pose
     bool m_play{ true };
     glm::vec3 m_position{ 0.0f, 0.0f, 0.0f };
     glm::quat m_rotation{ 0.0f, 0.0f, 0.0f, 1.0f };
     glm::vec3 m_scale{ 0.1f, 0.1f, 0.1f };
-
-    /* Model functions */
-    void UpdateBoneTree(float _deltaTIme, Animation::BoneNode* _node, const glm::mat4& _parentTransform);
-
-    /** \brief Find which keyframe the animation is at now for the current channel (bone) */
-    GLuint FindPositionKey(float _animTime, Animation::Channel& _channel);
-    GLuint FindRotationKey(float _animTime, Animation::Channel& _channel);
-    GLuint FindScalingKey(float _animTime, Animation::Channel& _channel);
-
-    /** \brief Calculate the interpolated position*/
-    glm::vec3 CalcInterpolatedPosition(float _animTime, Animation::Channel& _channel);
-    glm::mat4 CalcInterpolatedRotation(float _animTime, Animation::Channel& _channel);
-    glm::vec3 CalcInterpolatedScaling(float _animTime, Animation::Channel& _channel);
+    float m_lodScreenSize{ 0.25f };
   };
 
   /* A Static Model*/
   class StaticModel
   {
     friend class AssimpLoader;
+    friend class ModelCooker;
+    friend class VertexAnimationTexture;
   public:
     StaticModel() {}
     ~StaticModel() { Dispose(); }
@@ -128,9 +247,39 @@ namespace GameEngine
     void Dispose();
 
     void Draw(GLSLProgram& _shader);
+    /** \brief Draws the meshes at the LOD for the size of the model on the screen of _camera (see SetLodScreenSize) */
+    void Draw(GLSLProgram& _shader, const Camera3D& _camera);
+    /** \brief Draws an instance for every model matrix, one draw per mesh. The matrices stay in one buffer shared by the meshes,
+    * a draw only uploads the ones which changed since the last, so a set of instances which doesn't move is only uploaded once */
     void DrawInstanced(GLSLProgram& _shader, std::vector<glm::mat4>& _modelMatrices);
+    /** \brief Draws an instance for every model matrix, playing _animation (baked from a skinned model into this model,
+    * see VertexAnimationTexture::Bake) at _time plus the time offset of the instance, in seconds. All of it is one draw per mesh */
+    void DrawInstanced(GLSLProgram& _shader, std::vector<glm::mat4>& _modelMatrices, const VertexAnimationTexture& _animation,
+      const std::vector<float>& _timeOffsets, float _time);
+    /** \brief Draws the instances whose meshes are in the view of _camera, _culler tests them on the GPU and the meshes are drawn
+    * with indirect commands of the visible ones (see InstanceCuller), for large sets of instances */
+    void DrawInstanced(GLSLProgram& _shader, std::vector<glm::mat4>& _modelMatrices, InstanceCuller& _culler, const Camera3D& _camera);
+    /** \brief Draws an instance for every model matrix, each at the LOD for its size on the screen of _camera. The instances are grouped
+    * by LOD in the instance buffer (in their order within a group), one draw per mesh and LOD (OpenGL 4.2 for the groups after the first) */
+    void DrawInstanced(GLSLProgram& _shader, std::vector<glm::mat4>& _modelMatrices, const Camera3D& _camera);
+    /** \brief The screen size (see Camera3D::GetScreenSize) below which the LOD draws switch from LOD 0 to LOD 1, every next LOD at half of it */
+    void SetLodScreenSize(float _screenSize) { m_lodScreenSize = _screenSize; }
 
-    std::vector<Mesh> GetMeshes() { return m_meshes; }
+    const std::vector<Mesh>& GetMeshes() const noexcept { return m_meshes; }
+    /** \brief Exchanges the meshes with _other, for the hot reload of a shared model in place. The instance buffer stays, the new
+    * meshes are pointed to it on the next instanced draw */
+    void SwapMeshes(StaticModel& _other);
+    /** \brief Frees the CPU copies of the vertices of all the meshes */
+    void ReleaseCpuData();
+    /** \brief The transformMatrix Draw uploads, from the position, rotation and scale */
+    glm::mat4 GetModelMatrix() const;
+    /** \brief The sphere around the meshes in model space (with their baseModelMatrix), the center in xyz and the radius in w */
+    glm::vec4 GetBoundingSphere() const;
+    /** \brief The box around the meshes in model space (with their baseModelMatrix), AABB::Transformed by GetModelMatrix is the one
+    * to test against the frustum (see Camera3D::IsBoxVisible) */
+    AABB GetBoundingBox() const;
+    /** \brief The number of instance matrices the last DrawInstanced uploaded */
+    size_t GetNumUploadedInstances() const noexcept { return m_numUploadedInstances; }
 
     void OffsetPosition(const glm::vec3 _position);
     void OffsetRotation(const glm::vec3 _rotation);
@@ -140,7 +289,20 @@ namespace GameEngine
     void SetRotation(const glm::vec3 _rotation);
     void SetScale(const glm::vec3 _scale);
   private:
+    /** \brief Uploads the matrices of _modelMatrices which differ from m_instanceMatrices, the buffer grows when needed */
+    void UploadInstances(const std::vector<glm::mat4>& _modelMatrices);
+    /** \brief Points the instance matrices of all the meshes at _buffer, if they aren't already */
+    void SetInstanceSource(GLuint _buffer);
+
     std::vector<Mesh> m_meshes; ///< all the meshes this model consists of
+    GLuint m_instanceBuffer{ 0 };              ///< the instance matrices of all the meshes, made by the first DrawInstanced
+    size_t m_instanceCapacity{ 0 };            ///< in matrices
+    std::vector<glm::mat4> m_instanceMatrices; ///< what the buffer holds
+    size_t m_numUploadedInstances{ 0 };
+    GLuint m_instanceSource{ 0 }; ///< the buffer the meshes read their instance matrices from, the own one or the output of a culler
+    std::vector<glm::mat4> m_lodMatrices; ///< the instances of the last LOD draw grouped by LOD
+    std::vector<GLuint> m_instanceLods;   ///< the LOD of every instance of the last LOD draw
+    float m_lodScreenSize{ 0.25f };
     glm::vec3 m_position{ 0.0f, 0.0f, 0.0f };
     glm::quat m_rotation{ 0.0f, 0.0f, 0.0f, 1.0f };
     glm::vec3 m_scale{ 0.1f, 0.1f, 0.1f };
@@ -0,0 +1,408 @@
+#include "ModelCooker.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "AssimpLoader.h"
+#include "IOManager.h"
+#include "Model.h"
+#include "ResourceManager.h"
+
+namespace GameEngine
+{
+  namespace
+  {
+    const char COOKED_MAGIC[4] = { 'G', 'E', 'M', 'F' };
+    const char* COOKED_EXTENSION = ".gem";
+
+    //every block starts on 4 bytes, so the floats and matrices in the mapped file are aligned
+    constexpr size_t COOKED_ALIGNMENT = 4;
+
+    struct FileHeader
+    {
+      char m_magic[4];
+      std::uint32_t m_version;
+      std::uint32_t m_vertexSize; ///< sizeof(Vertex) of the cooker, the vertex blobs are uploaded as they are
+      std::uint32_t m_skinned;
+      std::uint32_t m_numMeshes;
+      std::uint32_t m_numClips;
+    };
+
+    struct MeshHeader
+    {
+      std::uint32_t m_numVertices;
+      std::uint32_t m_numIndices;
+      std::uint32_t m_numTextures;
+      std::uint32_t m_numLods;
+      std::uint32_t m_hasAnimations;
+      glm::mat4 m_baseModelMatrix;
+    };
+
+    struct ClipHeader
+    {
+      float m_duration;
+      float m_ticksPerSecond;
+      std::uint32_t m_numChannels;
+      std::uint32_t m_numBones;
+    };
+
+    struct TrackHeader
+    {
+      std::uint32_t m_numValues;
+      std::uint32_t m_numTimes;
+      float m_start;
+      float m_interval;
+    };
+
+    class Writer
+    {
+    public:
+      void WriteBlock(const void* _data, size_t _size)
+      {
+        const unsigned char* bytes = static_cast<const unsigned char*>(_data);
+        m_buffer.insert(m_buffer.end(), bytes, bytes + _size);
+        m_buffer.resize((m_buffer.size() + COOKED_ALIGNMENT - 1) / COOKED_ALIGNMENT * COOKED_ALIGNMENT, 0);
+      }
+      template <typename T>
+      void Write(const T& _value) { WriteBlock(&_value, sizeof(T)); }
+      void WriteString(const std::string& _string)
+      {
+        Write(static_cast<std::uint32_t>(_string.size()));
+        WriteBlock(_string.data(), _string.size());
+      }
+      template <typename Value>
+      void WriteTrack(const AnimationTrack<Value>& _track)
+      {
+        TrackHeader header{ static_cast<std::uint32_t>(_track.m_values.size()), static_cast<std::uint32_t>(_track.m_times.size()), _track.m_start, _track.m_interval };
+        Write(header);
+        WriteBlock(_track.m_values.data(), _track.m_values.size() * sizeof(Value));
+        WriteBlock(_track.m_times.data(), _track.m_times.size() * sizeof(float));
+      }
+      bool Save(const std::string& _filePath) const
+      {
+        std::ofstream file(_filePath, std::ios::binary);
+        if (file.fail())
+        {
+          perror(_filePath.c_str());
+          return false;
+        }
+        file.write(reinterpret_cast<const char*>(m_buffer.data()), m_buffer.size());
+        return !file.fail();
+      }
+    private:
+      std::vector<unsigned char> m_buffer;
+    };
+
+    //reads the blocks of a mapped file in place, once a read runs past the end all the next ones fail too
+    class Reader
+    {
+    public:
+      Reader(const unsigned char* _data, size_t _size) : m_data(_data), m_size(_size) {}
+
+      const void* ReadBlock(size_t _size)
+      {
+        if (m_failed || _size > m_size - m_offset)
+        {
+          m_failed = true;
+          return nullptr;
+        }
+        const void* data = m_data + m_offset;
+        m_offset = std::min(m_size, (m_offset + _size + COOKED_ALIGNMENT - 1) / COOKED_ALIGNMENT * COOKED_ALIGNMENT);
+        return data;
+      }
+      template <typename T>
+      bool Read(T& _value)
+      {
+        const void* data = ReadBlock(sizeof(T));
+        if (data != nullptr)
+        {
+          std::memcpy(&_value, data, sizeof(T));
+        }
+        return data != nullptr;
+      }
+      std::string ReadString()
+      {
+        std::uint32_t size = 0;
+        Read(size);
+        const char* data = static_cast<const char*>(ReadBlock(size));
+        return data != nullptr ? std::string(data, size) : std::string();
+      }
+      template <typename Value>
+      bool ReadTrack(AnimationTrack<Value>& _track)
+      {
+        TrackHeader header;
+        if (!Read(header))
+        {
+          return false;
+        }
+        const Value* values = static_cast<const Value*>(ReadBlock(header.m_numValues * sizeof(Value)));
+        const float* times = static_cast<const float*>(ReadBlock(header.m_numTimes * sizeof(float)));
+        if (m_failed)
+        {
+          return false;
+        }
+        _track.m_values.assign(values, values + header.m_numValues);
+        _track.m_times.assign(times, times + header.m_numTimes);
+        _track.m_start = header.m_start;
+        _track.m_interval = header.m_interval;
+        return true;
+      }
+      bool Failed() const noexcept { return m_failed; }
+    private:
+      const unsigned char* m_data{ nullptr };
+      size_t m_size{ 0 };
+      size_t m_offset{ 0 };
+      bool m_failed{ false };
+    };
+
+    bool WriteMeshes(Writer& _writer, const std::vector<Mesh>& _meshes)
+    {
+      for (const Mesh& mesh : _meshes)
+      {
+        if (!mesh.HasCpuData())
+        {
+          std::cout << "ERROR::COOKED_MODEL::the meshes have to keep their CPU data to be cooked" << std::endl;
+          return false;
+        }
+        const std::vector<Vertex>& vertices = mesh.GetVertices();
+        const std::vector<GLTexture>& textures = mesh.GetTextures();
+        MeshHeader header{ static_cast<std::uint32_t>(vertices.size()), static_cast<std::uint32_t>(mesh.GetIndices().size()),
+          static_cast<std::uint32_t>(textures.size()), mesh.GetNumLods(), mesh.HasAnimations() ? 1u : 0u, mesh.GetBaseModelMatrix() };
+        _writer.Write(header);
+        _writer.WriteBlock(vertices.data(), vertices.size() * sizeof(Vertex));
+        _writer.WriteBlock(mesh.GetIndices().data(), mesh.GetIndices().size() * sizeof(GLuint));
+        _writer.WriteBlock(mesh.GetLods().data(), mesh.GetLods().size() * sizeof(Mesh::Lod));
+        for (const GLTexture& texture : textures)
+        {
+          _writer.WriteString(AssetIds::GetName(texture.type));
+          _writer.WriteString(AssetIds::GetName(texture.asset));
+        }
+      }
+      return true;
+    }
+
+    bool ReadMeshes(Reader& _reader, GLuint _numMeshes, std::vector<Mesh>& _meshes, bool _keepCpuData)
+    {
+      for (GLuint i = 0; i < _numMeshes; i++)
+      {
+        MeshHeader header;
+        if (!_reader.Read(header))
+        {
+          return false;
+        }
+        const Vertex* vertices = static_cast<const Vertex*>(_reader.ReadBlock(header.m_numVertices * sizeof(Vertex)));
+        const GLuint* indices = static_cast<const GLuint*>(_reader.ReadBlock(header.m_numIndices * sizeof(GLuint)));
+        const Mesh::Lod* lods = static_cast<const Mesh::Lod*>(_reader.ReadBlock(header.m_numLods * sizeof(Mesh::Lod)));
+        std::vector<GLTexture> textures;
+        for (GLuint t = 0; t < header.m_numTextures && !_reader.Failed(); t++)
+        {
+          const std::string type = _reader.ReadString();
+          const std::string filePath = _reader.ReadString();
+          GLTexture texture = ResourceManager::GetTexture(filePath);
+          texture.type = AssetIds::Intern(type);
+          textures.push_back(texture);
+        }
+        if (_reader.Failed())
+        {
+          return false;
+        }
+        //a broken LOD table would draw past the indices
+        std::vector<Mesh::Lod> meshLods(lods, lods + header.m_numLods);
+        for (const Mesh::Lod& lod : meshLods)
+        {
+          if (lod.m_firstIndex > header.m_numIndices || lod.m_numIndices > header.m_numIndices - lod.m_firstIndex)
+          {
+            return false;
+          }
+        }
+        _meshes.emplace_back(vertices, header.m_numVertices, indices, header.m_numIndices, textures, header.m_hasAnimations != 0, header.m_baseModelMatrix,
+          _keepCpuData, meshLods);
+      }
+      return true;
+    }
+
+    bool ReadHeader(Reader& _reader, FileHeader& _header, bool _skinned, const std::string& _cookedPath)
+    {
+      if (!_reader.Read(_header) || std::memcmp(_header.m_magic, COOKED_MAGIC, sizeof(COOKED_MAGIC)) != 0 ||
+        _header.m_version != ModelCooker::VERSION || _header.m_vertexSize != sizeof(Vertex) || (_header.m_skinned != 0) != _skinned)
+      {
+        std::cout << "ERROR::COOKED_MODEL::" << _cookedPath << " isn't a cooked model of this version" << std::endl;
+        return false;
+      }
+      return true;
+    }
+  }
+
+  std::string ModelCooker::GetCookedPath(const std::string& _sourcePath)
+  {
+    return _sourcePath + COOKED_EXTENSION;
+  }
+
+  bool ModelCooker::CookStaticModel(const std::string& _sourcePath, const std::string& _cookedPath)
+  {
+    StaticModel model;
+    AssimpLoader loader;
+    loader.SetKeepCpuData(true);
+    return loader.LoadStaticModel(_sourcePath, &model) && WriteStaticModel(_cookedPath, model);
+  }
+
+  bool ModelCooker::CookSkinnedModel(const std::string& _sourcePath, const std::string& _cookedPath)
+  {
+    SkeletonAsset model;
+    AssimpLoader loader;
+    loader.SetKeepCpuData(true);
+    return loader.LoadSkinnedModel(_sourcePath, &model) && WriteSkinnedModel(_cookedPath, model);
+  }
+
+  bool ModelCooker::WriteStaticModel(const std::string& _cookedPath, const StaticModel& _model)
+  {
+    Writer writer;
+    FileHeader header{ { COOKED_MAGIC[0], COOKED_MAGIC[1], COOKED_MAGIC[2], COOKED_MAGIC[3] }, VERSION, sizeof(Vertex), 0,
+      static_cast<std::uint32_t>(_model.m_meshes.size()), 0 };
+    writer.Write(header);
+    return WriteMeshes(writer, _model.m_meshes) && writer.Save(_cookedPath);
+  }
+
+  bool ModelCooker::WriteSkinnedModel(const std::string& _cookedPath, const SkeletonAsset& _model)
+  {
+    Writer writer;
+    FileHeader header{ { COOKED_MAGIC[0], COOKED_MAGIC[1], COOKED_MAGIC[2], COOKED_MAGIC[3] }, VERSION, sizeof(Vertex), 1,
+      static_cast<std::uint32_t>(_model.m_meshes.size()), static_cast<std::uint32_t>(_model.m_clips.size()) };
+    writer.Write(header);
+    writer.Write(_model.m_globalInverseTransform);
+    if (!WriteMeshes(writer, _model.m_meshes))
+    {
+      return false;
+    }
+    for (const AnimationClip& clip : _model.m_clips)
+    {
+      writer.WriteString(clip.m_name);
+      ClipHeader clipHeader{ clip.m_duration, clip.m_ticksPerSecond, static_cast<std::uint32_t>(clip.m_channels.size()),
+        static_cast<std::uint32_t>(clip.m_bones.size()) };
+      writer.Write(clipHeader);
+      for (const AnimationClip::Channel& channel : clip.m_channels)
+      {
+        writer.WriteString(channel.m_name);
+        writer.Write(channel.m_offset);
+        writer.WriteTrack(channel.m_positions);
+        writer.WriteTrack(channel.m_rotations);
+        writer.WriteTrack(channel.m_scalings);
+      }
+      //the baked hierarchy, so the loader needs no nodes
+      writer.WriteBlock(clip.m_bones.data(), clip.m_bones.size() * sizeof(AnimationClip::Bone));
+    }
+    return writer.Save(_cookedPath);
+  }
+
+  bool ModelCooker::LoadStaticModel(const std::string& _cookedPath, StaticModel* _model, bool _keepCpuData)
+  {
+    MappedFile file;
+    if (!file.Open(_cookedPath))
+    {
+      return false;
+    }
+    Reader reader(file.GetData(), file.GetSize());
+    FileHeader header;
+    if (!ReadHeader(reader, header, false, _cookedPath))
+    {
+      return false;
+    }
+    _model->m_meshes.reserve(header.m_numMeshes);
+    if (!ReadMeshes(reader, header.m_numMeshes, _model->m_meshes, _keepCpuData))
+    {
+      _model->Dispose();
+      return false;
+    }
+    return true;
+  }
+
+  bool ModelCooker::ReadTexturePaths(const std::string& _cookedPath, bool _skinned, std::vector<std::string>& _texturePaths)
+  {
+    MappedFile file;
+    if (!file.Open(_cookedPath))
+    {
+      return false;
+    }
+    Reader reader(file.GetData(), file.GetSize());
+    FileHeader header;
+    glm::mat4 globalInverseTransform;
+    if (!ReadHeader(reader, header, _skinned, _cookedPath) || (_skinned && !reader.Read(globalInverseTransform)))
+    {
+      return false;
+    }
+    //the blobs are skipped, their pages of the mapping aren't even touched
+    for (GLuint i = 0; i < header.m_numMeshes && !reader.Failed(); i++)
+    {
+      MeshHeader meshHeader;
+      if (!reader.Read(meshHeader))
+      {
+        return false;
+      }
+      reader.ReadBlock(meshHeader.m_numVertices * sizeof(Vertex));
+      reader.ReadBlock(meshHeader.m_numIndices * sizeof(GLuint));
+      reader.ReadBlock(meshHeader.m_numLods * sizeof(Mesh::Lod));
+      for (GLuint t = 0; t < meshHeader.m_numTextures && !reader.Failed(); t++)
+      {
+        reader.ReadString(); //the type
+        _texturePaths.push_back(reader.ReadString());
+      }
+    }
+    return !reader.Failed();
+  }
+
+  bool ModelCooker::LoadSkinnedModel(const std::string& _cookedPath, SkeletonAsset* _model, bool _keepCpuData)
+  {
+    MappedFile file;
+    if (!file.Open(_cookedPath))
+    {
+      return false;
+    }
+    Reader reader(file.GetData(), file.GetSize());
+    FileHeader header;
+    if (!ReadHeader(reader, header, true, _cookedPath) || !reader.Read(_model->m_globalInverseTransform))
+    {
+      return false;
+    }
+    _model->m_meshes.reserve(header.m_numMeshes);
+    bool loaded = ReadMeshes(reader, header.m_numMeshes, _model->m_meshes, _keepCpuData);
+    _model->m_clips.resize(header.m_numClips);
+    for (GLuint i = 0; i < header.m_numClips && loaded; i++)
+    {
+      AnimationClip& clip = _model->m_clips[i];
+      clip.m_name = reader.ReadString();
+      ClipHeader clipHeader;
+      loaded = reader.Read(clipHeader);
+      clip.m_duration = clipHeader.m_duration;
+      clip.m_ticksPerSecond = clipHeader.m_ticksPerSecond;
+      clip.m_channels.resize(loaded ? clipHeader.m_numChannels : 0);
+      for (AnimationClip::Channel& channel : clip.m_channels)
+      {
+        channel.m_name = reader.ReadString();
+        loaded = reader.Read(channel.m_offset) && reader.ReadTrack(channel.m_positions) && reader.ReadTrack(channel.m_rotations) &&
+          reader.ReadTrack(channel.m_scalings);
+        if (!loaded)
+        {
+          break;
+        }
+      }
+      const AnimationClip::Bone* bones = loaded ? static_cast<const AnimationClip::Bone*>(reader.ReadBlock(clipHeader.m_numBones * sizeof(AnimationClip::Bone))) : nullptr;
+      loaded = loaded && !reader.Failed();
+      if (loaded)
+      {
+        clip.m_bones.assign(bones, bones + clipHeader.m_numBones);
+      }
+    }
+    if (!loaded)
+    {
+      std::cout << "ERROR::COOKED_MODEL::" << _cookedPath << " is cut off" << std::endl;
+      _model->Dispose();
+      _model->m_clips.clear();
+      return false;
+    }
+    return true;
+  }
+}
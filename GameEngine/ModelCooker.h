@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace GameEngine
+{
+  class StaticModel;
+  class SkeletonAsset;
+
+  /** \brief Converts imported models into the engine's binary model format and loads them back without Assimp.
+  * A cooked file holds the vertex and index blobs of every mesh (Vertex and GLuint arrays, the indices of all the LODs) with its LOD ranges, the texture paths of the materials,
+  * and for skinned models the global inverse transform and the compressed clips with their baked bone hierarchies.
+  * Loading maps the file, the indices go straight to glBufferData and the vertices are packed into the GPU layout of the Mesh from the mapping.
+  * The Cache cooks every model the first time it's imported (next to the source, see GetCookedPath) and loads the cooked file
+  * from then on, as long as it's newer than the source; shipping only the cooked files leaves Assimp a build time tool */
+  class ModelCooker
+  {
+  public:
+    enum : unsigned int { VERSION = 3 };
+
+    /** \brief The path of the cooked file of the model at _sourcePath */
+    static std::string GetCookedPath(const std::string& _sourcePath);
+
+    /** \brief Imports _sourcePath with Assimp and writes it to _cookedPath (needs a GL context, the import creates the meshes) */
+    static bool CookStaticModel(const std::string& _sourcePath, const std::string& _cookedPath);
+    static bool CookSkinnedModel(const std::string& _sourcePath, const std::string& _cookedPath);
+
+    /** \brief Writes an already loaded model to _cookedPath, its meshes need their CPU data (see AssimpLoader::SetKeepCpuData) */
+    static bool WriteStaticModel(const std::string& _cookedPath, const StaticModel& _model);
+    static bool WriteSkinnedModel(const std::string& _cookedPath, const SkeletonAsset& _model);
+
+    /** \brief Loads a cooked model, false if the file is missing, of another version or broken
+    * \param _keepCpuData - copies the vertices out of the mapping for the CPU, otherwise they're only uploaded */
+    static bool LoadStaticModel(const std::string& _cookedPath, StaticModel* _model, bool _keepCpuData = false);
+    static bool LoadSkinnedModel(const std::string& _cookedPath, SkeletonAsset* _model, bool _keepCpuData = false);
+
+    /** \brief Reads only the texture paths of the materials of a cooked model (skipping the mesh blobs), the textures loading the model
+    * loads too. False if the file is missing, of another version or broken */
+    static bool ReadTexturePaths(const std::string& _cookedPath, bool _skinned, std::vector<std::string>& _texturePaths);
+  };
+}
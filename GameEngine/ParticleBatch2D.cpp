@@ -1,8 +1,14 @@
 #include "ParticleBatch2D.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#include <xmmintrin.h>
+#define PARTICLES_USE_SSE
+#endif
 
 namespace GameEngine
 {
-
   ParticleBatch2D::ParticleBatch2D()
   {
     //empty
@@ -18,13 +24,53 @@ namespace GameEngine
   void ParticleBatch2D::Init(int _maxParticles,
                              float _decayRate,
                              const GLTexture& _texture,
-                             std::function<void(Particle2D&, float)> _updateFunc /* = defaultParticleUpdate */)
+                             std::function<void(Particle2D&, float)> _updateFunc /* = defaultParticleUpdate */,
+                             ParticleOverflow _overflow /* = ParticleOverflow::RECYCLE_OLDEST */)
   {
-    m_maxParticles = _maxParticles;
-    m_particles = std::make_unique<Particle2D[]>(_maxParticles);
+    m_numActive = 0;
+    m_overflow = _overflow;
+    Allocate(_maxParticles);
     m_decayRate = _decayRate;
     m_texture = _texture;
     m_updateFunc = _updateFunc;
+    m_batchUpdateFunc = nullptr;
+
+    //the default integrator doesn't need to be called per particle
+    auto target = _updateFunc.target<void(*)(Particle2D&, float)>();
+    m_useDefaultKernel = !_updateFunc || (target != nullptr && *target == DefaultParticleUpdate);
+  }
+
+  void ParticleBatch2D::InitBatchUpdate(int _maxParticles, float _decayRate, const GLTexture& _texture, ParticleBatchUpdate _batchUpdateFunc,
+                                        ParticleOverflow _overflow /* = ParticleOverflow::RECYCLE_OLDEST */)
+  {
+    m_numActive = 0;
+    m_overflow = _overflow;
+    Allocate(_maxParticles);
+    m_decayRate = _decayRate;
+    m_texture = _texture;
+    m_updateFunc = nullptr;
+    m_batchUpdateFunc = _batchUpdateFunc;
+    m_useDefaultKernel = !_batchUpdateFunc;
+  }
+
+  void ParticleBatch2D::Allocate(int _maxParticles)
+  {
+    m_maxParticles = _maxParticles;
+
+    //the slots past m_numActive are never alive, so the kernels can always work on full registers
+    const size_t paddedSize = ((_maxParticles + PARTICLE_SIMD_WIDTH - 1) / PARTICLE_SIMD_WIDTH) * PARTICLE_SIMD_WIDTH;
+    if (m_numActive == 0)
+    {
+      //nothing to keep, so clear the old slots as well
+      m_life.assign(m_life.size(), 0.0f);
+    }
+    m_positionX.resize(paddedSize, 0.0f);
+    m_positionY.resize(paddedSize, 0.0f);
+    m_velocityX.resize(paddedSize, 0.0f);
+    m_velocityY.resize(paddedSize, 0.0f);
+    m_life.resize(paddedSize, 0.0f);
+    m_width.resize(paddedSize, 0.0f);
+    m_color.resize(paddedSize, ColorRGBA8());
   }
 
   //add a particle
@@ -33,36 +79,246 @@ namespace GameEngine
                                     const ColorRGBA8& _color,
                                     float _width)
   {
-    //find a free particle index, or overwrite the first one
-    int particleIndex = FindFreeParticle();
+    if (ApplyEmitLOD(1) == 0)
+    {
+      return;
+    }
+    //the next free slot is always right after the active particles
+    int particleIndex = AcquireParticle();
+    if (particleIndex < 0)
+    {
+      return;
+    }
 
-    //edit the particle index values
-    auto pointerToArray = m_particles.get();
+    m_life[particleIndex] = 1.0f;
 
-    Particle2D& particle = pointerToArray[particleIndex];
+    m_positionX[particleIndex] = _position.x;
+    m_positionY[particleIndex] = _position.y;
 
-    particle.m_life = 1.0f;
+    m_velocityX[particleIndex] = _velocity.x;
+    m_velocityY[particleIndex] = _velocity.y;
+
+    m_color[particleIndex] = _color;
+
+    m_width[particleIndex] = _width;
+  }
+
+  void ParticleBatch2D::Emit(int _count, const EmitterDesc& _desc, Random& _random)
+  {
+    _count = ApplyEmitLOD(_count);
+    if (_count <= 0)
+    {
+      return;
+    }
+    if (m_numActive + _count > m_maxParticles && m_overflow == ParticleOverflow::GROW)
+    {
+      Allocate(std::max(m_maxParticles * 2, m_numActive + _count));
+    }
 
-    particle.m_position = _position;
+    //the free slots are contiguous after the active particles, so they are claimed all at once
+    const int first = m_numActive;
+    const int numFree = std::min(_count, m_maxParticles - m_numActive);
+    m_numActive += numFree;
+    for (int i = first; i < first + numFree; i++)
+    {
+      GenerateParticle(i, _desc, _random);
+    }
 
-    particle.m_velocity = _velocity;
+    //whatever didn't fit only goes in when the oldest particles can be recycled
+    if (m_overflow == ParticleOverflow::RECYCLE_OLDEST)
+    {
+      for (int i = numFree; i < _count; i++)
+      {
+        const int index = AcquireParticle();
+        if (index < 0)
+        {
+          break;
+        }
+        GenerateParticle(index, _desc, _random);
+      }
+    }
+  }
 
-    particle.m_color = _color;
+  int ParticleBatch2D::ApplyEmitLOD(int _count)
+  {
+    if (m_lod >= 1.0f)
+    {
+      return _count;
+    }
+    //accumulate, so a LOD of 0.25 lets every 4th single particle through instead of none of them
+    m_emitCarry += _count * m_lod;
+    const int count = static_cast<int>(m_emitCarry);
+    m_emitCarry -= count;
+    return count;
+  }
 
-    particle.m_width = _width;
+  glm::vec4 ParticleBatch2D::ComputeBounds() const
+  {
+    if (m_numActive == 0)
+    {
+      return glm::vec4(0.0f);
+    }
+    glm::vec4 bounds(m_positionX[0], m_positionY[0], m_positionX[0], m_positionY[0]);
+    for (int i = 1; i < m_numActive; i++)
+    {
+      bounds.x = std::min(bounds.x, m_positionX[i]);
+      bounds.y = std::min(bounds.y, m_positionY[i]);
+      bounds.z = std::max(bounds.z, m_positionX[i] + m_width[i]);
+      bounds.w = std::max(bounds.w, m_positionY[i] + m_width[i]);
+    }
+    return bounds;
+  }
+
+  void ParticleBatch2D::GenerateParticle(int _index, const EmitterDesc& _desc, Random& _random)
+  {
+    glm::vec2 position = _desc.m_position;
+    switch (_desc.m_shape)
+    {
+    case EmitterShape::CIRCLE:
+    {
+      //the square root keeps the points uniform over the area instead of bunching up in the center
+      const float radius = _desc.m_extents.x * std::sqrt(_random.GenRandFloat(0.0f, 1.0f));
+      const float angle = _random.GenRandFloat(0.0f, 6.2831853f);
+      position += glm::vec2(std::cos(angle), std::sin(angle)) * radius;
+      break;
+    }
+    case EmitterShape::RECT:
+    {
+      position.x += _random.GenRandFloat(-0.5f, 0.5f) * _desc.m_extents.x;
+      position.y += _random.GenRandFloat(-0.5f, 0.5f) * _desc.m_extents.y;
+      break;
+    }
+    default:
+      break;
+    }
+    m_positionX[_index] = position.x;
+    m_positionY[_index] = position.y;
+
+    const float halfSpread = _desc.m_spread * 0.5f;
+    const float angle = _desc.m_direction + _random.GenRandFloat(-halfSpread, halfSpread);
+    const float speed = _random.GenRandFloat(_desc.m_speedRange.x, _desc.m_speedRange.y);
+    m_velocityX[_index] = std::cos(angle) * speed;
+    m_velocityY[_index] = std::sin(angle) * speed;
+
+    const float t = _random.GenRandFloat(0.0f, 1.0f);
+    auto lerp = [t](GLubyte _a, GLubyte _b) { return static_cast<GLubyte>(_a + (_b - _a) * t); };
+    m_color[_index] = ColorRGBA8(lerp(_desc.m_startColor.r, _desc.m_endColor.r), lerp(_desc.m_startColor.g, _desc.m_endColor.g),
+                                 lerp(_desc.m_startColor.b, _desc.m_endColor.b), lerp(_desc.m_startColor.a, _desc.m_endColor.a));
+
+    m_width[_index] = _random.GenRandFloat(_desc.m_widthRange.x, _desc.m_widthRange.y);
+    m_life[_index] = 1.0f;
   }
 
   void ParticleBatch2D::Update(float _deltaTime)
   {
-    auto pointerToArray = m_particles.get();
-    for (int i = 0; i < m_maxParticles; i++)
+    if (m_batchUpdateFunc)
+    {
+      m_batchUpdateFunc(GetSpans(), _deltaTime);
+      DecayKernel(0, m_numActive, _deltaTime);
+    }
+    else
+    {
+      UpdateRange(0, m_numActive, _deltaTime);
+    }
+    RemoveDeadParticles();
+  }
+
+  void ParticleBatch2D::UpdateRange(int _begin, int _end, float _deltaTime)
+  {
+    _end = std::min(_end, m_numActive);
+    if (m_useDefaultKernel)
+    {
+      DefaultUpdateKernel(_begin, _end, _deltaTime);
+    }
+    else
     {
-      // check if it is active
-      if (pointerToArray[i].m_life > 0.0f)
+      //custom per particle function: gather, update and scatter every active particle
+      for (int i = _begin; i < _end; i++)
       {
-        // Update using function pointer
-        m_updateFunc(pointerToArray[i], _deltaTime);
-        pointerToArray[i].m_life -= m_decayRate * _deltaTime;
+        Particle2D particle;
+        particle.m_position = glm::vec2(m_positionX[i], m_positionY[i]);
+        particle.m_velocity = glm::vec2(m_velocityX[i], m_velocityY[i]);
+        particle.m_color = m_color[i];
+        particle.m_width = m_width[i];
+        particle.m_life = m_life[i];
+
+        m_updateFunc(particle, _deltaTime);
+
+        m_positionX[i] = particle.m_position.x;
+        m_positionY[i] = particle.m_position.y;
+        m_velocityX[i] = particle.m_velocity.x;
+        m_velocityY[i] = particle.m_velocity.y;
+        m_color[i] = particle.m_color;
+        m_width[i] = particle.m_width;
+        m_life[i] = particle.m_life;
+      }
+      DecayKernel(_begin, _end, _deltaTime);
+    }
+  }
+
+  void ParticleBatch2D::DefaultUpdateKernel(int _begin, int _end, float _deltaTime)
+  {
+    /* Only the registers holding active particles. If _end is in the middle of a register the last lanes
+       are either dead (past m_numActive) and masked out, or skipped by the scalar tail so the next range owns them */
+    int i = _begin;
+#ifdef PARTICLES_USE_SSE
+    const int simdEnd = (_end == m_numActive) ? ((_end + PARTICLE_SIMD_WIDTH - 1) / PARTICLE_SIMD_WIDTH) * PARTICLE_SIMD_WIDTH
+                                              : (_end / PARTICLE_SIMD_WIDTH) * PARTICLE_SIMD_WIDTH;
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 deltaTime = _mm_set1_ps(_deltaTime);
+    const __m128 decay = _mm_set1_ps(m_decayRate * _deltaTime);
+    for (; i < simdEnd; i += PARTICLE_SIMD_WIDTH)
+    {
+      __m128 life = _mm_loadu_ps(&m_life[i]);
+      //only the active lanes move and decay
+      const __m128 active = _mm_cmpgt_ps(life, zero);
+
+      __m128 positionX = _mm_loadu_ps(&m_positionX[i]);
+      __m128 positionY = _mm_loadu_ps(&m_positionY[i]);
+      const __m128 stepX = _mm_mul_ps(_mm_loadu_ps(&m_velocityX[i]), deltaTime);
+      const __m128 stepY = _mm_mul_ps(_mm_loadu_ps(&m_velocityY[i]), deltaTime);
+      positionX = _mm_add_ps(positionX, _mm_and_ps(active, stepX));
+      positionY = _mm_add_ps(positionY, _mm_and_ps(active, stepY));
+      life = _mm_sub_ps(life, _mm_and_ps(active, decay));
+
+      _mm_storeu_ps(&m_positionX[i], positionX);
+      _mm_storeu_ps(&m_positionY[i], positionY);
+      _mm_storeu_ps(&m_life[i], life);
+    }
+#endif
+    const float scalarDecay = m_decayRate * _deltaTime;
+    for (; i < _end; i++)
+    {
+      if (m_life[i] > 0.0f)
+      {
+        m_positionX[i] += m_velocityX[i] * _deltaTime;
+        m_positionY[i] += m_velocityY[i] * _deltaTime;
+        m_life[i] -= scalarDecay;
+      }
+    }
+  }
+
+  void ParticleBatch2D::DecayKernel(int _begin, int _end, float _deltaTime)
+  {
+    int i = _begin;
+#ifdef PARTICLES_USE_SSE
+    const int simdEnd = (_end == m_numActive) ? ((_end + PARTICLE_SIMD_WIDTH - 1) / PARTICLE_SIMD_WIDTH) * PARTICLE_SIMD_WIDTH
+                                              : (_end / PARTICLE_SIMD_WIDTH) * PARTICLE_SIMD_WIDTH;
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 decay = _mm_set1_ps(m_decayRate * _deltaTime);
+    for (; i < simdEnd; i += PARTICLE_SIMD_WIDTH)
+    {
+      __m128 life = _mm_loadu_ps(&m_life[i]);
+      life = _mm_sub_ps(life, _mm_and_ps(_mm_cmpgt_ps(life, zero), decay));
+      _mm_storeu_ps(&m_life[i], life);
+    }
+#endif
+    const float scalarDecay = m_decayRate * _deltaTime;
+    for (; i < _end; i++)
+    {
+      if (m_life[i] > 0.0f)
+      {
+        m_life[i] -= scalarDecay;
       }
     }
   }
@@ -71,42 +327,77 @@ namespace GameEngine
   void ParticleBatch2D::Draw(SpriteBatch* _spritebBatch)
   {
     glm::vec4 uvRect(0.0f, 0.0f, 1.0f, 1.0f);
-    auto pointerToArray = m_particles.get();
-    for (int i = 0; i < m_maxParticles; i++)
+    /* the active particles are dense, so there is nothing to skip. The order of the
+       particles is arbitrary (swap-remove), so drawing the first ones thins them evenly */
+    const int numDrawn = static_cast<int>(std::ceil(m_numActive * m_lod));
+    for (int i = 0; i < numDrawn; i++)
     {
-      // check if it is active
-      Particle2D& particle = pointerToArray[i];
-      if (particle.m_life > 0.0f)
-      {
-        glm::vec4 destRect(particle.m_position.x, particle.m_position.y, particle.m_width, particle.m_width);
-        _spritebBatch->Draw(destRect, uvRect, m_texture.id, 0.0f, particle.m_color);
-      }
+      glm::vec4 destRect(m_positionX[i], m_positionY[i], m_width[i], m_width[i]);
+      _spritebBatch->Draw(destRect, uvRect, m_texture.id, 0.0f, m_color[i]);
     }
   }
 
-  int ParticleBatch2D::FindFreeParticle()
+  ParticleSpans ParticleBatch2D::GetSpans()
   {
-    //check for a free particle from a range between the last free one, and the max possible particles
-    for (int i = m_lastFreeParticle; i < m_maxParticles; i++)
+    ParticleSpans spans;
+    spans.m_positionX = m_positionX.data();
+    spans.m_positionY = m_positionY.data();
+    spans.m_velocityX = m_velocityX.data();
+    spans.m_velocityY = m_velocityY.data();
+    spans.m_life = m_life.data();
+    spans.m_width = m_width.data();
+    spans.m_color = m_color.data();
+    spans.m_count = m_numActive;
+    return spans;
+  }
+
+  int ParticleBatch2D::AcquireParticle()
+  {
+    if (m_numActive < m_maxParticles)
+    {
+      return m_numActive++;
+    }
+    switch (m_overflow)
+    {
+    case ParticleOverflow::GROW:
+    {
+      Allocate(std::max(m_maxParticles * 2, PARTICLE_SIMD_WIDTH));
+      return m_numActive++;
+    }
+    case ParticleOverflow::RECYCLE_OLDEST:
     {
-      if (m_particles[i].m_life <= 0.0f)
+      if (m_numActive == 0)
       {
-        m_lastFreeParticle = i;
-        return i;
+        return -1;
       }
+      //every particle decays at the same rate, so the oldest is the one with the least life (the scan only happens when saturated)
+      return static_cast<int>(std::min_element(m_life.begin(), m_life.begin() + m_numActive) - m_life.begin());
+    }
+    default:
+      return -1;
     }
-    
-    //check for a free particle from a range between the first free, and the last free one
-    for (int i = 0; i < m_lastFreeParticle; i++)
+  }
+
+  void ParticleBatch2D::RemoveDeadParticles()
+  {
+    for (int i = 0; i < m_numActive;)
     {
-      if (m_particles[i].m_life <= 0.0f)
+      if (m_life[i] > 0.0f)
       {
-        m_lastFreeParticle = i;
-        return i;
+        i++;
+        continue;
       }
+      //move the last active particle into the hole, the swapped in one is checked on the next iteration
+      const int last = --m_numActive;
+      m_positionX[i] = m_positionX[last];
+      m_positionY[i] = m_positionY[last];
+      m_velocityX[i] = m_velocityX[last];
+      m_velocityY[i] = m_velocityY[last];
+      m_life[i] = m_life[last];
+      m_width[i] = m_width[last];
+      m_color[i] = m_color[last];
+      //the freed slot must stay dead for the masked kernels
+      m_life[last] = 0.0f;
     }
-    // no particles are free, overwrite first particle 
-    return 0;
   }
 }
-
@@ -2,10 +2,12 @@
 
 #include <functional>
 #include <memory>
+#include <vector>
 #include <glm\glm.hpp>
 #include "Vertex.h"
 #include "SpriteBatch.h"
 #include "GLTexture.h"
+#include "Random.h"
 
 namespace GameEngine
 {
@@ -27,36 +29,142 @@ namespace GameEngine
     _particle.m_position += _particle.m_velocity * _deltaTime;
   }
 
+  //number of particles processed at a time by the kernels, the arrays are padded to a multiple of it
+  constexpr int PARTICLE_SIMD_WIDTH = 4;
+
+  // Views of the structure of arrays storage of a ParticleBatch2D, every array holds m_count elements
+  struct ParticleSpans
+  {
+    float* m_positionX{ nullptr };
+    float* m_positionY{ nullptr };
+    float* m_velocityX{ nullptr };
+    float* m_velocityY{ nullptr };
+    float* m_life{ nullptr };   ///< a particle is active while its life is above 0
+    float* m_width{ nullptr };
+    ColorRGBA8* m_color{ nullptr };
+    int m_count{ 0 };
+  };
+
+  // Batch-level update, called once per frame with the active particles (the life decay is done by the batch)
+  using ParticleBatchUpdate = std::function<void(const ParticleSpans&, float)>;
+
+  // The area new particles are spawned in, around EmitterDesc::m_position
+  enum class EmitterShape
+  {
+    POINT,
+    CIRCLE, ///< uniformly inside m_extents.x radius
+    RECT    ///< uniformly inside the m_extents (full width and height), centered on the position
+  };
+
+  // Describes a burst of particles for ParticleBatch2D::Emit
+  struct EmitterDesc
+  {
+    glm::vec2 m_position{ 0.0f };
+    EmitterShape m_shape{ EmitterShape::POINT };
+    glm::vec2 m_extents{ 0.0f };
+
+    float m_direction{ 0.0f };      ///< center of the velocity cone (radians, 0 is +x)
+    float m_spread{ 6.2831853f };   ///< full angle of the velocity cone (radians, the default is every direction)
+    glm::vec2 m_speedRange{ 1.0f }; ///< min and max speed
+
+    ColorRGBA8 m_startColor{ 255, 255, 255, 255 }; ///< every particle gets a random color of the ramp between these two
+    ColorRGBA8 m_endColor{ 255, 255, 255, 255 };
+    glm::vec2 m_widthRange{ 1.0f }; ///< min and max width
+  };
+
+  // What AddParticle does when all the particles of the batch are active
+  enum class ParticleOverflow
+  {
+    DROP,           ///< the new particle is ignored
+    RECYCLE_OLDEST, ///< the particle with the least life left is replaced
+    GROW            ///< the batch doubles its capacity
+  };
+
   class ParticleBatch2D
   {
   public:
     ParticleBatch2D();
     ~ParticleBatch2D();
-    //initialize the particle batch
-    void Init(int _maxParticles, float _decayRate, const GLTexture& _texture, std::function<void(Particle2D&, float)> _updateFunc = DefaultParticleUpdate);
+    /** \brief initialize the particle batch.
+     *  The default update runs as a SIMD kernel, any other per particle function is still called once per active particle */
+    void Init(int _maxParticles, float _decayRate, const GLTexture& _texture, std::function<void(Particle2D&, float)> _updateFunc = DefaultParticleUpdate,
+              ParticleOverflow _overflow = ParticleOverflow::RECYCLE_OLDEST);
+    // initialize the particle batch with a batch-level update function, which gets the arrays instead of single particles
+    void InitBatchUpdate(int _maxParticles, float _decayRate, const GLTexture& _texture, ParticleBatchUpdate _batchUpdateFunc,
+                         ParticleOverflow _overflow = ParticleOverflow::RECYCLE_OLDEST);
     //add a oarticle
     void AddParticle(const glm::vec2& _position,
                      const glm::vec2& _velocity,
                      const ColorRGBA8& _color,
                      float _width);
+    /** \brief adds _count particles described by _desc in one go (the overflow policy applies like for AddParticle)
+     *  \param _random - the generator the positions, velocities, colors and widths are randomized with */
+    void Emit(int _count, const EmitterDesc& _desc, Random& _random);
     //updates all the active particles
     void Update(float _deltaTime);
+
+    /** \brief Updates the active particles in [_begin, _end) without removing the dead ones.
+     *  Disjoint ranges can run on different threads (_begin has to be a multiple of PARTICLE_SIMD_WIDTH),
+     *  call FinishUpdate() once all of them are done */
+    void UpdateRange(int _begin, int _end, float _deltaTime);
+    // Removes the particles that died in the UpdateRange() calls
+    void FinishUpdate() { RemoveDeadParticles(); }
+    // Whether the update can be split with UpdateRange (a batch-level callback wants all the particles at once)
+    bool CanSplitUpdate() const { return !m_batchUpdateFunc; }
     //draws all the active particles
     void Draw(SpriteBatch* _spritebBatch);
 
+    // The arrays of the active particles
+    ParticleSpans GetSpans();
+
+    int GetNumActive() const { return m_numActive; }
+    int GetMaxParticles() const { return m_maxParticles; }
+
+    /** \brief Sets the level of detail (0 to 1): only this fraction of the emitted particles is added
+     *  and only this fraction of the active particles is drawn. Set by the ParticleEngine2D budget */
+    void SetLOD(float _lod) { m_lod = glm::clamp(_lod, 0.0f, 1.0f); }
+    float GetLOD() const { return m_lod; }
+    // World space bounds of the active particles (min x, min y, max x, max y), all zero when the batch is empty
+    glm::vec4 ComputeBounds() const;
+
   private:
-    //finds a free particle position from all possible particles (maxParticles) or overwrites the first one
-    int FindFreeParticle();
+    //allocates the arrays, padded to the SIMD width (keeps the active particles)
+    void Allocate(int _maxParticles);
+    //returns the slot for a new particle according to the overflow policy, or -1 if it should be dropped
+    int AcquireParticle();
+    //randomizes the particle in slot _index according to _desc
+    void GenerateParticle(int _index, const EmitterDesc& _desc, Random& _random);
+    //thins _count emitted particles by the LOD, carrying the fractions over to the next emission
+    int ApplyEmitLOD(int _count);
+    //swap-removes the dead particles, so [0, m_numActive) stays dense
+    void RemoveDeadParticles();
+    //moves the active particles in [_begin, _end) by their velocity and decays their life, 4 particles at a time
+    void DefaultUpdateKernel(int _begin, int _end, float _deltaTime);
+    //decays the life of the active particles in [_begin, _end), 4 at a time
+    void DecayKernel(int _begin, int _end, float _deltaTime);
 
     std::function<void(Particle2D&, float)> m_updateFunc;
+    ParticleBatchUpdate m_batchUpdateFunc;
+    bool m_useDefaultKernel{ true };
 
     float m_decayRate{ 0.1f };
 
-    std::unique_ptr<Particle2D[]> m_particles{ nullptr };
+    //structure of arrays storage, so the update kernels only stream through what they need
+    std::vector<float> m_positionX;
+    std::vector<float> m_positionY;
+    std::vector<float> m_velocityX;
+    std::vector<float> m_velocityY;
+    std::vector<float> m_life;
+    std::vector<float> m_width;
+    std::vector<ColorRGBA8> m_color;
+
     int m_maxParticles{ 0 };
-    int m_lastFreeParticle{ 0 };
+    int m_numActive{ 0 };  ///< the active particles are always the first m_numActive ones
+    ParticleOverflow m_overflow{ ParticleOverflow::RECYCLE_OLDEST };
+
+    float m_lod{ 1.0f };
+    float m_emitCarry{ 0.0f }; ///< fraction of a particle the LOD has held back so far
     GLTexture m_texture;
   };
 }
 
-
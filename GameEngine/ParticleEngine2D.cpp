@@ -1,6 +1,13 @@
 #include "ParticleEngine2D.h"
 #include "SpriteBatch.h"
 #include "ParticleBatch2D.h"
+#include "GPUParticleBatch2D.h"
+#include "Camera2D.h"
+#include "Timing.h"
+#include "FrameStats.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
 
 namespace GameEngine
 {
@@ -16,6 +23,11 @@ namespace GameEngine
     {
       delete b;
     }
+    for (auto& b : m_gpuBatches)
+    {
+      b->Dispose();
+      delete b;
+    }
 
   }
 
@@ -25,10 +37,51 @@ namespace GameEngine
     m_batches.push_back(_particleBatch);
   }
 
+  void ParticleEngine2D::AddParticleBatch(GPUParticleBatch2D* _particleBatch)
+  {
+    m_gpuBatches.push_back(_particleBatch);
+  }
+
   void ParticleEngine2D::Update(float _deltaTime)
   {
-    //update every batch
+    PROFILE_SCOPE("ParticleEngine2D::Update");
+    //split the batches into chunks, a batch-level update function needs the whole batch in one go
+    m_chunks.clear();
+    for (auto& b : m_batches)
+    {
+      if (!b->CanSplitUpdate())
+      {
+        b->Update(_deltaTime);
+        continue;
+      }
+      for (int begin = 0; begin < b->GetNumActive(); begin += PARTICLE_UPDATE_CHUNK)
+      {
+        m_chunks.push_back({ b, begin, std::min(begin + PARTICLE_UPDATE_CHUNK, b->GetNumActive()) });
+      }
+    }
+
+    //the chunks are disjoint, so the workers (and this thread) can update any of them
+    JobSystem::Get().ParallelFor(m_chunks.size(), 1, [this, _deltaTime](size_t _begin, size_t _end)
+    {
+      for (size_t i = _begin; i < _end; i++)
+      {
+        m_chunks[i].m_batch->UpdateRange(m_chunks[i].m_begin, m_chunks[i].m_end, _deltaTime);
+      }
+    });
+
+    //removing the dead particles reorders the batch, so it waits for all its chunks
+    std::uint64_t numActive = 0;
     for (auto& b : m_batches)
+    {
+      if (b->CanSplitUpdate())
+      {
+        b->FinishUpdate();
+      }
+      numActive += b->GetNumActive();
+    }
+    FrameStats::Get().Set(STAT_PARTICLES, numActive);
+    //the GPU batches only queue a simulation pass
+    for (auto& b : m_gpuBatches)
     {
       b->Update(_deltaTime);
     }
@@ -45,5 +98,80 @@ namespace GameEngine
       _spriteBatch->RenderBatch();
     }
   }
-}
 
+  void ParticleEngine2D::DrawGPUBatches(const glm::mat4& _projection)
+  {
+    for (auto& b : m_gpuBatches)
+    {
+      b->Draw(_projection);
+    }
+  }
+
+  void ParticleEngine2D::SetBudget(int _maxParticles, float _targetFrameTime)
+  {
+    m_budget = _maxParticles;
+    m_targetFrameTime = _targetFrameTime;
+    m_budgetScale = 1.0f;
+    if (m_budget <= 0)
+    {
+      for (auto& b : m_batches)
+      {
+        b->SetLOD(1.0f);
+      }
+    }
+  }
+
+  void ParticleEngine2D::UpdateBudget(const FpsLimiter& _limiter, const Camera2D& _camera)
+  {
+    if (m_budget <= 0)
+    {
+      return;
+    }
+    //back off quickly when the frame is over the target, recover slowly so it doesn't oscillate
+    if (_limiter.GetWorkTime() > m_targetFrameTime)
+    {
+      m_budgetScale = std::max(0.1f, m_budgetScale * 0.9f);
+    }
+    else
+    {
+      m_budgetScale = std::min(1.0f, m_budgetScale * 1.02f);
+    }
+    const float budget = m_budget * m_budgetScale;
+
+    //the on-screen area of every batch, off-screen batches get the minimum straight away
+    const glm::vec4 view = _camera.GetViewRect();
+    m_batchAreas.resize(m_batches.size());
+    float totalArea = 0.0f;
+    float offscreenParticles = 0.0f;
+    for (size_t i = 0; i < m_batches.size(); i++)
+    {
+      const glm::vec4 bounds = m_batches[i]->ComputeBounds();
+      const float width = std::min(bounds.z, view.x + view.z) - std::max(bounds.x, view.x);
+      const float height = std::min(bounds.w, view.y + view.w) - std::max(bounds.y, view.y);
+      //a batch which doesn't emit yet still counts as visible, so it can start at full detail
+      const bool visible = m_batches[i]->GetNumActive() == 0 || (width >= 0.0f && height >= 0.0f);
+      //tiny (or empty) visible batches still get a share
+      m_batchAreas[i] = visible ? std::max(width * height, 1.0f) : 0.0f;
+      totalArea += m_batchAreas[i];
+      if (!visible)
+      {
+        offscreenParticles += m_batches[i]->GetNumActive() * PARTICLE_OFFSCREEN_LOD;
+      }
+    }
+
+    //the visible batches split what is left by their area
+    const float visibleBudget = std::max(0.0f, budget - offscreenParticles);
+    for (size_t i = 0; i < m_batches.size(); i++)
+    {
+      if (m_batchAreas[i] == 0.0f)
+      {
+        m_batches[i]->SetLOD(PARTICLE_OFFSCREEN_LOD);
+        continue;
+      }
+      const float share = visibleBudget * m_batchAreas[i] / totalArea;
+      const int numActive = m_batches[i]->GetNumActive();
+      const float lod = numActive > 0 ? share / numActive : 1.0f;
+      m_batches[i]->SetLOD(glm::clamp(lod, PARTICLE_MIN_LOD, 1.0f));
+    }
+  }
+}
@@ -1,13 +1,24 @@
 #pragma once
 
 #include <vector>
+#include <glm\glm.hpp>
 
 
 namespace GameEngine
 {
 
   class ParticleBatch2D;
+  class GPUParticleBatch2D;
   class SpriteBatch;
+  class Camera2D;
+  class FpsLimiter;
+
+  // Number of particles a single update task works on (a multiple of PARTICLE_SIMD_WIDTH)
+  constexpr int PARTICLE_UPDATE_CHUNK{ 8192 };
+  // LOD of the batches outside the camera view while a budget is set (they still emit a bit so they don't pop when they come back)
+  constexpr float PARTICLE_OFFSCREEN_LOD{ 0.1f };
+  // Lowest LOD the budget gives to a visible batch
+  constexpr float PARTICLE_MIN_LOD{ 0.2f };
 
   class ParticleEngine2D
   {
@@ -17,13 +28,40 @@ namespace GameEngine
 
     //after adding a particle batch the ParticleEngine2D becomes responsible for the allocation
     void AddParticleBatch(ParticleBatch2D* _particleBatch);
-    //updates all the batches
+    //same for the batches simulated on the GPU (they must be initialized and are disposed by the engine)
+    void AddParticleBatch(GPUParticleBatch2D* _particleBatch);
+    /** \brief updates all the batches. The CPU batches are split into chunks of PARTICLE_UPDATE_CHUNK particles,
+     *  which are updated in parallel when there is more than one (custom update functions must be thread safe) */
     void Update(float _deltaTime);
     //draws all the batches
     void Draw(SpriteBatch* _spriteBatch);
+    //draws the GPU batches straight from their buffers (they don't go through a SpriteBatch)
+    void DrawGPUBatches(const glm::mat4& _projection);
+
+    /** \brief Limits the particles drawn by the CPU batches to _maxParticles, and lowers that limit while
+     *  the frames take longer than _targetFrameTime (milliseconds). 0 particles disables the budget */
+    void SetBudget(int _maxParticles, float _targetFrameTime);
+    /** \brief Recomputes the LOD of every batch from the last frame time and the camera view, call once per frame before Update().
+     *  Off-screen batches are thinned first, the visible ones share the budget by their on-screen area */
+    void UpdateBudget(const FpsLimiter& _limiter, const Camera2D& _camera);
 
   private:
+    // A range of particles of one batch, updated by a single task
+    struct UpdateChunk
+    {
+      ParticleBatch2D* m_batch;
+      int m_begin;
+      int m_end;
+    };
+
     std::vector<ParticleBatch2D*> m_batches;
+    std::vector<UpdateChunk> m_chunks; ///< kept across frames so building the chunks doesn't allocate
+    std::vector<GPUParticleBatch2D*> m_gpuBatches;
+
+    int m_budget{ 0 };               ///< max drawn particles, 0 = no budget
+    float m_targetFrameTime{ 16.6f };
+    float m_budgetScale{ 1.0f };     ///< shrinks while the frames are too long, recovers slowly when there is time left
+    std::vector<float> m_batchAreas; ///< on-screen area of every batch (kept across frames)
 
   };
 
@@ -0,0 +1,101 @@
+#include "PostProcessGraph.h"
+#include "RenderState.h"
+
+namespace GameEngine
+{
+  void PostProcessGraph::Init()
+  {
+    m_quad.Init();
+  }
+
+  void PostProcessGraph::Dispose()
+  {
+    m_passes.clear();
+    m_targets.clear();
+    m_quad.Dispose();
+  }
+
+  PostProcessGraph::Resource PostProcessGraph::CreateTarget(const RenderTargetDesc& _desc)
+  {
+    Target target;
+    target.desc = _desc;
+    m_targets.push_back(target);
+    return m_targets.size() - 1;
+  }
+
+  void PostProcessGraph::AddPass(const std::vector<Resource>& _inputs, Resource _output, std::function<void()> _execute)
+  {
+    Pass pass;
+    pass.inputs = _inputs;
+    pass.output = _output;
+    pass.execute = std::move(_execute);
+    m_passes.push_back(std::move(pass));
+  }
+
+  void PostProcessGraph::Execute(RenderTargetPool& _pool, int _screenWidth, int _screenHeight)
+  {
+    //the lifetimes: a target goes back to the pool after the last pass using it
+    for (size_t i = 0; i < m_passes.size(); i++)
+    {
+      for (Resource input : m_passes[i].inputs)
+      {
+        m_targets[input].lastPass = i;
+      }
+      if (m_passes[i].output != SCREEN)
+      {
+        m_targets[m_passes[i].output].lastPass = i;
+      }
+    }
+
+    RenderState& state = RenderState::Get();
+    for (size_t i = 0; i < m_passes.size(); i++)
+    {
+      const Pass& pass = m_passes[i];
+      if (pass.output == SCREEN)
+      {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, _screenWidth, _screenHeight);
+      }
+      else
+      {
+        Target& output = m_targets[pass.output];
+        if (output.framebuffer == nullptr)
+        {
+          output.framebuffer = _pool.Acquire(output.desc);
+        }
+        int width = 0;
+        int height = 0;
+        _pool.GetSize(output.desc, width, height);
+        output.framebuffer->Bind(GL_FRAMEBUFFER, width, height);
+        glViewport(0, 0, width, height);
+      }
+      for (size_t unit = 0; unit < pass.inputs.size(); unit++)
+      {
+        //a target read before any pass wrote it has no texture
+        const Framebuffer* input = m_targets[pass.inputs[unit]].framebuffer;
+        state.BindTexture(static_cast<GLuint>(unit), GL_TEXTURE_2D, input != nullptr ? input->GetColorTexture(0).id : 0);
+      }
+      pass.execute();
+
+      for (Target& target : m_targets)
+      {
+        if (target.framebuffer != nullptr && target.lastPass == i)
+        {
+          _pool.Release(target.framebuffer);
+          target.framebuffer = nullptr;
+        }
+      }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, _screenWidth, _screenHeight);
+    m_passes.clear();
+    m_targets.clear();
+  }
+
+  void PostProcessGraph::DrawQuad()
+  {
+    glDisable(GL_DEPTH_TEST);
+    m_quad.Render(0);
+    glEnable(GL_DEPTH_TEST);
+  }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <functional>
+#include <vector>
+
+#include "RenderTargetPool.h"
+#include "ScreenQuad.h"
+
+namespace GameEngine
+{
+  /** \brief The post-processing passes of a frame, declared again every frame: a pass reads targets and writes one, and the targets are
+  * only declared (CreateTarget), not owned. Execute gives a target a framebuffer of the RenderTargetPool at the pass writing it first and
+  * gives it back after the pass reading it last, so the targets whose passes don't overlap share the textures. E.g. a two step blur
+  * ping-pongs between two half size textures however many times it runs:
+  *   const auto half = graph.CreateTarget(desc);
+  *   graph.AddPass({ scene }, half, [&]() { blurShader.Use(); ...; graph.DrawQuad(); });
+  *   graph.AddPass({ half }, PostProcessGraph::SCREEN, ...); */
+  class PostProcessGraph
+  {
+  public:
+    typedef size_t Resource;
+    /** \brief The default framebuffer */
+    static constexpr Resource SCREEN{ static_cast<size_t>(-1) };
+
+    PostProcessGraph() {}
+    ~PostProcessGraph() { Dispose(); }
+
+    void Init();
+    void Dispose();
+
+    /** \brief Declares a target of this frame */
+    Resource CreateTarget(const RenderTargetDesc& _desc);
+    /** \brief Adds a pass, they run in the order they're added. Before _execute the output is bound with its viewport and the textures of
+    * _inputs are bound to the units 0, 1, ... in order; _execute uses its shader and draws, e.g. with DrawQuad */
+    void AddPass(const std::vector<Resource>& _inputs, Resource _output, std::function<void()> _execute);
+    /** \brief Runs the passes and forgets them, the screen is bound after */
+    void Execute(RenderTargetPool& _pool, int _screenWidth, int _screenHeight);
+
+    /** \brief Draws a quad over the whole output, without the depth test */
+    void DrawQuad();
+  private:
+    struct Pass
+    {
+      std::vector<Resource> inputs;
+      Resource output;
+      std::function<void()> execute;
+    };
+    struct Target
+    {
+      RenderTargetDesc desc;
+      Framebuffer* framebuffer{ nullptr }; ///< from the pool while the passes using it run
+      size_t lastPass{ 0 };               ///< the index of the last pass reading or writing it
+    };
+
+    std::vector<Pass> m_passes;
+    std::vector<Target> m_targets;
+    ScreenQuad m_quad;
+  };
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <tuple>
+#include <utility>
+#include "Component.h"
+
+namespace GameEngine
+{
+  /** \brief Describes an entity as a set of prototype components, which EntityManager::Instantiate copies into every new entity.
+  * e.g. auto enemy = MakePrefab(HealthComponent(100), MoveComponent(2.0f)); manager.Instantiate(enemy, 50); */
+  template<typename... Ts>
+  class Prefab
+  {
+  public:
+    Prefab(Ts... _prototypes) : m_prototypes(std::move(_prototypes)...) {}
+
+    //the prototype of component T, so it can be tweaked between spawns
+    template<typename T> T& Get() { return std::get<T>(m_prototypes); }
+    template<typename T> const T& Get() const { return std::get<T>(m_prototypes); }
+
+  private:
+    std::tuple<Ts...> m_prototypes;
+  };
+
+  template<typename... Ts>
+  inline Prefab<Ts...> MakePrefab(Ts... _prototypes)
+  {
+    return Prefab<Ts...>(std::move(_prototypes)...);
+  }
+}
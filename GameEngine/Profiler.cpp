@@ -0,0 +1,330 @@
+#include "Profiler.h"
+#include "DebugRenderer.h"
+#include "SpriteBatch.h"
+#include "SpriteFont.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <unordered_map>
+
+namespace GameEngine
+{
+  namespace
+  {
+    //the nesting depths the timeline has rows for, the deeper scopes are left out
+    constexpr std::uint32_t TIMELINE_DEPTHS{ 4 };
+
+    //the ring of this thread and the scopes open on it
+    thread_local void* t_ring{ nullptr };
+    thread_local std::uint32_t t_depth{ 0 };
+
+    const std::chrono::steady_clock::time_point g_epoch = std::chrono::steady_clock::now();
+
+    //a color per scope name, the same every frame
+    ColorRGBA8 ScopeColor(const char* _name)
+    {
+      std::uint32_t hash = 2166136261u;
+      for (const char* c = _name; *c; c++)
+      {
+        hash = (hash ^ static_cast<unsigned char>(*c)) * 16777619u;
+      }
+      return ColorRGBA8(128 + (hash & 127), 128 + ((hash >> 8) & 127), 128 + ((hash >> 16) & 127), 255);
+    }
+
+    //the name as a JSON string
+    void WriteJsonString(std::ofstream& _file, const char* _text)
+    {
+      _file << '"';
+      for (const char* c = _text; *c; c++)
+      {
+        if (*c == '"' || *c == '\\')
+        {
+          _file << '\\';
+        }
+        _file << *c;
+      }
+      _file << '"';
+    }
+  }
+
+  Profiler::Profiler()
+  {
+    SetThreadName("Main");
+  }
+
+  Profiler& Profiler::Get()
+  {
+    static Profiler profiler;
+    return profiler;
+  }
+
+  std::int64_t Profiler::Now()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+  }
+
+  void Profiler::SetThreadName(const char* _name)
+  {
+    ThreadRing& ring = GetThreadRing();
+    std::lock_guard<std::mutex> lock(m_ringMutex);
+    ring.name = _name;
+  }
+
+  std::uint32_t Profiler::AddTrack(const char* _name)
+  {
+    return AddRing(_name).index;
+  }
+
+  Profiler::ThreadRing& Profiler::GetThreadRing()
+  {
+    if (!t_ring)
+    {
+      t_ring = &AddRing(nullptr);
+    }
+    return *static_cast<ThreadRing*>(t_ring);
+  }
+
+  Profiler::ThreadRing& Profiler::AddRing(const char* _name)
+  {
+    std::lock_guard<std::mutex> lock(m_ringMutex);
+    m_rings.push_back(std::make_unique<ThreadRing>());
+    m_rings.back()->index = static_cast<std::uint32_t>(m_rings.size() - 1);
+    m_rings.back()->name = _name ? _name : "Thread " + std::to_string(m_rings.size() - 1);
+    return *m_rings.back();
+  }
+
+  void Profiler::Record(const char* _name, std::int64_t _start, std::int64_t _end, std::uint32_t _depth)
+  {
+    Write(GetThreadRing(), _name, _start, _end, _depth);
+  }
+
+  void Profiler::RecordOnTrack(std::uint32_t _track, const char* _name, std::int64_t _start, std::int64_t _end, std::uint32_t _depth)
+  {
+    ThreadRing* ring = nullptr;
+    {
+      //a thread may add its ring meanwhile, which moves the pointers of the list
+      std::lock_guard<std::mutex> lock(m_ringMutex);
+      if (_track >= m_rings.size())
+      {
+        return;
+      }
+      ring = m_rings[_track].get();
+    }
+    Write(*ring, _name, _start, _end, _depth);
+  }
+
+  void Profiler::Write(ThreadRing& _ring, const char* _name, std::int64_t _start, std::int64_t _end, std::uint32_t _depth)
+  {
+    const std::uint64_t written = _ring.written.load(std::memory_order_relaxed);
+    ProfileEvent& event = _ring.events[written % PROFILER_RING_SIZE];
+    event.name = _name;
+    event.start = _start;
+    event.end = _end;
+    event.thread = _ring.index;
+    event.depth = _depth;
+    _ring.written.store(written + 1, std::memory_order_release);
+  }
+
+  void Profiler::BeginFrame()
+  {
+    m_frameStart = Now();
+  }
+
+  void Profiler::EndFrame()
+  {
+    if (!IsEnabled())
+    {
+      return;
+    }
+    Frame& frame = m_frames[m_currentFrame];
+    frame.start = m_frameStart;
+    frame.end = Now();
+    frame.events.clear();
+
+    std::lock_guard<std::mutex> lock(m_ringMutex);
+    for (auto& ring : m_rings)
+    {
+      const std::uint64_t written = ring->written.load(std::memory_order_acquire);
+      std::uint64_t first = ring->read;
+      if (written - first > PROFILER_RING_SIZE)
+      {
+        m_numDropped += written - first - PROFILER_RING_SIZE;
+        first = written - PROFILER_RING_SIZE;
+      }
+      const size_t copied = frame.events.size();
+      for (std::uint64_t i = first; i < written; i++)
+      {
+        frame.events.push_back(ring->events[i % PROFILER_RING_SIZE]);
+      }
+      //the thread kept recording while they were copied, the oldest copied ones may have been overwritten meanwhile
+      const std::uint64_t writtenAfter = ring->written.load(std::memory_order_acquire);
+      if (writtenAfter > PROFILER_RING_SIZE && writtenAfter - PROFILER_RING_SIZE > first)
+      {
+        const std::uint64_t overwritten = std::min(writtenAfter - PROFILER_RING_SIZE, written) - first;
+        frame.events.erase(frame.events.begin() + copied, frame.events.begin() + copied + static_cast<size_t>(overwritten));
+        m_numDropped += overwritten;
+      }
+      ring->read = written;
+    }
+
+    m_currentFrame = (m_currentFrame + 1) % PROFILER_HISTORY_FRAMES;
+    m_numFrames = std::min(m_numFrames + 1, PROFILER_HISTORY_FRAMES);
+  }
+
+  const std::vector<ProfileEvent>& Profiler::GetLastFrame() const
+  {
+    static const std::vector<ProfileEvent> noEvents;
+    if (m_numFrames == 0)
+    {
+      return noEvents;
+    }
+    return m_frames[(m_currentFrame + PROFILER_HISTORY_FRAMES - 1) % PROFILER_HISTORY_FRAMES].events;
+  }
+
+  std::int64_t Profiler::GetLastFrameStart() const
+  {
+    return m_numFrames == 0 ? 0 : m_frames[(m_currentFrame + PROFILER_HISTORY_FRAMES - 1) % PROFILER_HISTORY_FRAMES].start;
+  }
+
+  std::int64_t Profiler::GetLastFrameEnd() const
+  {
+    return m_numFrames == 0 ? 0 : m_frames[(m_currentFrame + PROFILER_HISTORY_FRAMES - 1) % PROFILER_HISTORY_FRAMES].end;
+  }
+
+  void Profiler::DrawTimeline(DebugRenderer& _renderer, const glm::vec4& _rect) const
+  {
+    const std::int64_t frameStart = GetLastFrameStart();
+    const std::int64_t frameLength = GetLastFrameEnd() - frameStart;
+    size_t numThreads = 0;
+    {
+      std::lock_guard<std::mutex> lock(m_ringMutex);
+      numThreads = m_rings.size();
+    }
+    if (frameLength <= 0 || numThreads == 0)
+    {
+      return;
+    }
+    _renderer.DrawBox(_rect, ColorRGBA8(255, 255, 255, 255), 0.0f);
+
+    //the threads top down, the nested scopes below the ones around them
+    const float rowHeight = _rect.w / static_cast<float>(numThreads * TIMELINE_DEPTHS);
+    const float xScale = _rect.z / static_cast<float>(frameLength);
+    for (const ProfileEvent& event : GetLastFrame())
+    {
+      if (event.depth >= TIMELINE_DEPTHS)
+      {
+        continue;
+      }
+      const float row = static_cast<float>(event.thread * TIMELINE_DEPTHS + event.depth + 1);
+      const float left = std::max(static_cast<float>(event.start - frameStart) * xScale, 0.0f);
+      const float right = std::min(static_cast<float>(event.end - frameStart) * xScale, _rect.z);
+      if (right <= left)
+      {
+        continue;
+      }
+      _renderer.DrawBox(glm::vec4(_rect.x + left, _rect.y + _rect.w - row * rowHeight, right - left, rowHeight * 0.9f),
+        ScopeColor(event.name), 0.0f);
+    }
+  }
+
+  void Profiler::DrawSummary(SpriteBatch& _batch, SpriteFont& _font, const glm::vec2& _position, float _scale, float _depth,
+    size_t _numLines) const
+  {
+    //the time of a scope is summed over its calls and threads, a scope nested in itself is counted twice
+    struct ScopeTotal
+    {
+      const char* name;
+      std::int64_t time;
+      int calls;
+    };
+    std::unordered_map<const char*, size_t> totalIndices;
+    std::vector<ScopeTotal> totals;
+    for (const ProfileEvent& event : GetLastFrame())
+    {
+      auto it = totalIndices.find(event.name);
+      if (it == totalIndices.end())
+      {
+        it = totalIndices.emplace(event.name, totals.size()).first;
+        totals.push_back({ event.name, 0, 0 });
+      }
+      totals[it->second].time += event.end - event.start;
+      totals[it->second].calls++;
+    }
+    std::sort(totals.begin(), totals.end(), [](const ScopeTotal& _a, const ScopeTotal& _b) { return _a.time > _b.time; });
+
+    char line[256];
+    const float lineHeight = _font.getFontHeight() * _scale;
+    glm::vec2 position(_position.x, _position.y - lineHeight);
+    std::snprintf(line, sizeof(line), "frame %.2f ms", static_cast<double>(GetLastFrameEnd() - GetLastFrameStart()) / 1e6);
+    _font.draw(_batch, line, position, glm::vec2(_scale), _depth, ColorRGBA8(255, 255, 255, 255));
+    for (size_t i = 0; i < totals.size() && i < _numLines; i++)
+    {
+      position.y -= lineHeight;
+      std::snprintf(line, sizeof(line), "%s %.2f ms (%d)", totals[i].name, static_cast<double>(totals[i].time) / 1e6, totals[i].calls);
+      _font.draw(_batch, line, position, glm::vec2(_scale), _depth, ScopeColor(totals[i].name));
+    }
+  }
+
+  bool Profiler::WriteChromeTrace(const std::string& _filePath) const
+  {
+    std::ofstream file(_filePath);
+    if (file.fail())
+    {
+      std::cout << "ERROR::PROFILER::TRACE_FILE_NOT_OPENED\n" << _filePath << std::endl;
+      return false;
+    }
+    //the times of the format are microseconds
+    file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+    bool first = true;
+    {
+      std::lock_guard<std::mutex> lock(m_ringMutex);
+      for (auto& ring : m_rings)
+      {
+        file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << ring->index << ",\"args\":{\"name\":";
+        WriteJsonString(file, ring->name.c_str());
+        file << "}}";
+        first = false;
+      }
+    }
+    const size_t oldest = (m_currentFrame + PROFILER_HISTORY_FRAMES - m_numFrames) % PROFILER_HISTORY_FRAMES;
+    for (size_t i = 0; i < m_numFrames; i++)
+    {
+      const Frame& frame = m_frames[(oldest + i) % PROFILER_HISTORY_FRAMES];
+      //the frames are a scope of the main thread, around everything recorded in them
+      file << (first ? "" : ",") << "\n{\"name\":\"Frame\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":" << frame.start / 1000.0 <<
+        ",\"dur\":" << (frame.end - frame.start) / 1000.0 << "}";
+      first = false;
+      for (const ProfileEvent& event : frame.events)
+      {
+        file << ",\n{\"name\":";
+        WriteJsonString(file, event.name);
+        file << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" <<
+          (event.end - event.start) / 1000.0 << "}";
+      }
+    }
+    file << "\n]}\n";
+    return !file.fail();
+  }
+
+  ProfileScope::ProfileScope(const char* _name) : m_name(_name)
+  {
+    if (Profiler::Get().IsEnabled())
+    {
+      m_depth = t_depth++;
+      m_start = Profiler::Now();
+    }
+  }
+
+  ProfileScope::~ProfileScope()
+  {
+    if (m_start >= 0)
+    {
+      t_depth--;
+      Profiler::Get().Record(m_name, m_start, Profiler::Now(), m_depth);
+    }
+  }
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <glm\glm.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//the PROFILE_SCOPE markers are compiled in unless the project defines GAME_ENGINE_NO_PROFILE, a compiled in marker costs two clock
+//reads and a store into the ring of its thread while the profiler is enabled, a branch while it isn't
+#ifndef GAME_ENGINE_NO_PROFILE
+#define GAME_ENGINE_PROFILE
+#endif
+
+namespace GameEngine
+{
+  class DebugRenderer;
+  class SpriteBatch;
+  class SpriteFont;
+
+  //the scopes a thread can record between two frame ends before the oldest are overwritten
+  constexpr size_t PROFILER_RING_SIZE{ 16384 };
+  //the frames kept for the overlay and the export
+  constexpr size_t PROFILER_HISTORY_FRAMES{ 300 };
+
+  //a scope which ended, the times are nanoseconds since the profiler was created
+  struct ProfileEvent
+  {
+    const char* name{ nullptr }; ///< a string literal, only the pointer is stored
+    std::int64_t start{ 0 };
+    std::int64_t end{ 0 };
+    std::uint32_t thread{ 0 };   ///< the index of the thread in the profiler
+    std::uint32_t depth{ 0 };    ///< the number of scopes around it on its thread
+  };
+
+  /** \brief An instrumenting CPU profiler. The PROFILE_SCOPE markers write into a ring buffer of their thread without locking, the main
+   *  thread gathers the rings at EndFrame (IMainGame::Run marks the frames) and keeps the last PROFILER_HISTORY_FRAMES frames. They can
+   *  be drawn as a timeline (DrawTimeline), summed up per scope (DrawSummary) or saved as a Chrome trace (chrome://tracing, Perfetto,
+   *  or Tracy through its import-chrome tool) */
+  class Profiler
+  {
+  public:
+    static Profiler& Get();
+
+    // Turns the recording on and off at run time, it's off until enabled
+    void SetEnabled(bool _enabled) { m_enabled.store(_enabled, std::memory_order_relaxed); }
+    bool IsEnabled() const noexcept { return m_enabled.load(std::memory_order_relaxed); }
+
+    // Names the calling thread in the timeline and the trace
+    void SetThreadName(const char* _name);
+    /** \brief A row of its own in the timeline and the trace, for the scopes which aren't timed on a thread (e.g. the GPU's, see
+     *  GpuProfiler). One thread at a time records on it
+     *  \return the track to record on */
+    std::uint32_t AddTrack(const char* _name);
+
+    // Marks the start of a frame, on the main thread
+    void BeginFrame();
+    // Gathers the scopes recorded since the last frame end, on the main thread
+    void EndFrame();
+
+    // The scopes of the last finished frame, of all the threads
+    const std::vector<ProfileEvent>& GetLastFrame() const;
+    std::int64_t GetLastFrameStart() const;
+    std::int64_t GetLastFrameEnd() const;
+    // The scopes overwritten before they were gathered since the profiler was enabled
+    std::uint64_t GetNumDropped() const noexcept { return m_numDropped; }
+
+    /** \brief Draws the last frame as a bar per scope, a row per thread and nesting depth, the frame across the width of _rect (bottom
+     *  left x, y, width, height), with the 2D lines of the renderer */
+    void DrawTimeline(DebugRenderer& _renderer, const glm::vec4& _rect) const;
+    // Lists the scopes of the last frame which took the most time, the top left of the list at _position
+    void DrawSummary(SpriteBatch& _batch, SpriteFont& _font, const glm::vec2& _position, float _scale, float _depth,
+      size_t _numLines = 10) const;
+
+    // Writes the kept frames as a Chrome trace (the JSON trace event format)
+    bool WriteChromeTrace(const std::string& _filePath) const;
+
+    // Records a scope, called by ProfileScope
+    void Record(const char* _name, std::int64_t _start, std::int64_t _end, std::uint32_t _depth);
+    // Records a scope on a track of AddTrack
+    void RecordOnTrack(std::uint32_t _track, const char* _name, std::int64_t _start, std::int64_t _end, std::uint32_t _depth);
+    // Nanoseconds since the profiler was created
+    static std::int64_t Now();
+
+  private:
+    Profiler();
+
+    //the ring a thread writes its scopes into, only the thread writes and only the main thread reads
+    struct ThreadRing
+    {
+      std::uint32_t index{ 0 };
+      std::string name;
+      std::unique_ptr<ProfileEvent[]> events{ new ProfileEvent[PROFILER_RING_SIZE] };
+      std::atomic<std::uint64_t> written{ 0 }; ///< released after the event is stored
+      std::uint64_t read{ 0 };                 ///< the events up to it were gathered
+    };
+    struct Frame
+    {
+      std::int64_t start{ 0 };
+      std::int64_t end{ 0 };
+      std::vector<ProfileEvent> events;
+    };
+
+    // The ring of the calling thread, created the first time it records
+    ThreadRing& GetThreadRing();
+    ThreadRing& AddRing(const char* _name);
+    // Stores the event in the ring, only the thread (or the one recording on the track) writes it
+    void Write(ThreadRing& _ring, const char* _name, std::int64_t _start, std::int64_t _end, std::uint32_t _depth);
+
+    std::atomic<bool> m_enabled{ false };
+    mutable std::mutex m_ringMutex; ///< guards the list of rings, a thread adds its own once
+    std::vector<std::unique_ptr<ThreadRing>> m_rings;
+
+    Frame m_frames[PROFILER_HISTORY_FRAMES]; ///< reused in turn, their vectors keep their capacity
+    size_t m_currentFrame{ 0 };
+    size_t m_numFrames{ 0 };
+    std::int64_t m_frameStart{ 0 };
+    std::uint64_t m_numDropped{ 0 };
+  };
+
+  //records the time from its construction to its destruction
+  class ProfileScope
+  {
+  public:
+    explicit ProfileScope(const char* _name);
+    ~ProfileScope();
+
+  private:
+    const char* m_name;
+    std::int64_t m_start{ -1 }; ///< -1 when the profiler was disabled at the start
+    std::uint32_t m_depth{ 0 };
+  };
+}
+
+#ifdef GAME_ENGINE_PROFILE
+#define PROFILE_CONCAT_INNER(_a, _b) _a##_b
+#define PROFILE_CONCAT(_a, _b) PROFILE_CONCAT_INNER(_a, _b)
+//profiles the rest of the enclosing scope under _name, which has to be a string literal
+#define PROFILE_SCOPE(_name) GameEngine::ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(_name)
+//profiles the rest of the function under its name
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#else
+#define PROFILE_SCOPE(_name)
+#define PROFILE_FUNCTION()
+#endif
@@ -1,23 +1,36 @@
 #include "Random.h"
 
+#include <thread>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define RANDOM_USE_SSE2
+#endif
+
 namespace GameEngine
 {
-  Random::Random(SeedType _seedType)
+  namespace
   {
-    Clock::duration durotation = Clock::now() - m_beginning;
-    switch (_seedType)
+    //spreads a seed over the whole state, as the authors of xoshiro recommend
+    std::uint64_t SplitMix64(std::uint64_t& _x)
     {
-    case GameEngine::SeedType::CLOCK_TICKS:
-      m_generator.seed(durotation.count());
-      break;
-    case GameEngine::SeedType::TRUE_RANDOM:
-      m_generator.seed(m_realRandom());
-      break;
-    default:
-      break;
+      std::uint64_t z = (_x += 0x9E3779B97F4A7C15ull);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      return z ^ (z >> 31);
+    }
+
+    std::uint64_t TrueRandomSeed(std::random_device& _device)
+    {
+      return (static_cast<std::uint64_t>(_device()) << 32) | _device();
     }
   }
 
+  Random::Random(SeedType _seedType)
+  {
+    GenSeed(_seedType);
+  }
+
   Random::~Random()
   {
   }
@@ -28,25 +41,142 @@ namespace GameEngine
     switch (_seedType)
     {
     case GameEngine::SeedType::CLOCK_TICKS:
-      m_generator.seed(durotation.count());
+      Seed(static_cast<std::uint64_t>(durotation.count()));
       break;
     case GameEngine::SeedType::TRUE_RANDOM:
-      m_generator.seed(m_realRandom());
+      Seed(TrueRandomSeed(m_realRandom));
       break;
     default:
       break;
     }
   }
 
-  float Random::GenRandFloat(float _min, float _max)
+  void Random::Seed(std::uint64_t _seed, std::uint32_t _stream)
   {
-    std::uniform_real_distribution<float> realDis(_min, _max);
-    return realDis(m_generator);
+    std::uint64_t x = _seed;
+    for (int i = 0; i < 4; i += 2)
+    {
+      const std::uint64_t value = SplitMix64(x);
+      m_state[i] = static_cast<std::uint32_t>(value);
+      m_state[i + 1] = static_cast<std::uint32_t>(value >> 32);
+    }
+    for (std::uint32_t i = 0; i < _stream; i++)
+    {
+      Jump();
+    }
+    //the lanes go on from the stream's own numbers, so two streams have different lanes too
+    std::uint64_t lanes = (static_cast<std::uint64_t>(Next()) << 32) | Next();
+    for (int lane = 0; lane < 4; lane++)
+    {
+      for (int word = 0; word < 4; word += 2)
+      {
+        const std::uint64_t value = SplitMix64(lanes);
+        m_lanes[word][lane] = static_cast<std::uint32_t>(value);
+        m_lanes[word + 1][lane] = static_cast<std::uint32_t>(value >> 32);
+      }
+    }
+  }
+
+  void Random::Jump()
+  {
+    static const std::uint32_t JUMP[4] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+    std::uint32_t state[4] = { 0, 0, 0, 0 };
+    for (std::uint32_t jump : JUMP)
+    {
+      for (int bit = 0; bit < 32; bit++)
+      {
+        if (jump & (1u << bit))
+        {
+          for (int i = 0; i < 4; i++)
+          {
+            state[i] ^= m_state[i];
+          }
+        }
+        Next();
+      }
+    }
+    for (int i = 0; i < 4; i++)
+    {
+      m_state[i] = state[i];
+    }
+  }
+
+  Random& Random::GetThreadLocal()
+  {
+    static const std::uint64_t seed = []()
+    {
+      std::random_device device;
+      return TrueRandomSeed(device);
+    }();
+    static std::atomic<std::uint32_t> nextStream{ 0 };
+    thread_local Random random(seed, nextStream++);
+    return random;
   }
 
   int Random::GenRandInt(int _min, int _max)
   {
-    std::uniform_int_distribution<int> intDis(_min, _max);
-    return intDis(m_generator);
+    //the whole range of an int when it wraps to 0
+    const std::uint32_t range = static_cast<std::uint32_t>(static_cast<std::int64_t>(_max) - _min + 1);
+    if (range == 0)
+    {
+      return static_cast<int>(Next());
+    }
+    //Lemire's multiply and shift, the few values which would make it biased are drawn again
+    std::uint64_t product = static_cast<std::uint64_t>(Next()) * range;
+    std::uint32_t low = static_cast<std::uint32_t>(product);
+    if (low < range)
+    {
+      const std::uint32_t threshold = (0u - range) % range;
+      while (low < threshold)
+      {
+        product = static_cast<std::uint64_t>(Next()) * range;
+        low = static_cast<std::uint32_t>(product);
+      }
+    }
+    return static_cast<int>(static_cast<std::int64_t>(_min) + static_cast<std::int64_t>(product >> 32));
+  }
+
+  void Random::Fill(float* _values, std::size_t _count, float _min, float _max)
+  {
+    std::size_t i = 0;
+#ifdef RANDOM_USE_SSE2
+    __m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_lanes[0]));
+    __m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_lanes[1]));
+    __m128i s2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_lanes[2]));
+    __m128i s3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_lanes[3]));
+    const __m128 scale = _mm_set1_ps(_max - _min);
+    const __m128 offset = _mm_set1_ps(_min);
+    const __m128i one = _mm_set1_epi32(0x3F800000);
+    for (; i + 4 <= _count; i += 4)
+    {
+      //xoshiro128+, its top bits become the mantissa of a float in [1; 2)
+      const __m128i result = _mm_add_epi32(s0, s3);
+      const __m128i t = _mm_slli_epi32(s1, 9);
+      s2 = _mm_xor_si128(s2, s0);
+      s3 = _mm_xor_si128(s3, s1);
+      s1 = _mm_xor_si128(s1, s2);
+      s0 = _mm_xor_si128(s0, s3);
+      s2 = _mm_xor_si128(s2, t);
+      s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+      const __m128 unit = _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(result, 9), one)), _mm_set1_ps(1.0f));
+      _mm_storeu_ps(_values + i, _mm_add_ps(offset, _mm_mul_ps(unit, scale)));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(m_lanes[0]), s0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(m_lanes[1]), s1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(m_lanes[2]), s2);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(m_lanes[3]), s3);
+#endif
+    for (; i < _count; i++)
+    {
+      _values[i] = GenRandFloat(_min, _max);
+    }
+  }
+
+  void Random::FillInt(int* _values, std::size_t _count, int _min, int _max)
+  {
+    for (std::size_t i = 0; i < _count; i++)
+    {
+      _values[i] = GenRandInt(_min, _max);
+    }
   }
-}
\ No newline at end of file
+}
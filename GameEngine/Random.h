@@ -1,7 +1,10 @@
 #pragma once
 
-#include <random>
+#include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <random>
 
 namespace GameEngine
 {
@@ -10,7 +13,9 @@ namespace GameEngine
     CLOCK_TICKS,
     TRUE_RANDOM
   };
-  /// A seeded random number generator
+  /** \brief A seeded random number generator, xoshiro128** for the single values and four xoshiro128+ side by side in SSE2 lanes
+  * for the batches (see Fill). A seed has 2^64 streams which never overlap (see Seed), the jobs use the stream of their thread
+  * (see GetThreadLocal) so they don't share a generator */
   class Random
   {
   public:
@@ -22,7 +27,13 @@ namespace GameEngine
 
     Random()
     {
+      Seed(0);
+    }
 
+    /** \brief Initialize the random generator with a fixed seed and one of its streams */
+    explicit Random(std::uint64_t _seed, std::uint32_t _stream = 0)
+    {
+      Seed(_seed, _stream);
     }
 
     ~Random();
@@ -32,27 +43,62 @@ namespace GameEngine
     * CLOCK_TICKS = uses the current clock in milliseconds
     * TRUE_RANDOM = generates a true random number for the seed*/
     void GenSeed(SeedType _seedType);
+    /** \brief Reinitialize the random number generator with a fixed seed, the same seed gives the same numbers (e.g. for a replay)
+    * \param _seed - the seed
+    * \param _stream - the generators of the same seed and different streams give sequences which don't overlap */
+    void Seed(std::uint64_t _seed, std::uint32_t _stream = 0);
 
-    /** \brief Generate a random floating point number from [_min; _max] (inclusively)
+    /** \brief The generator of the calling thread, seeded once per process with a true random number and a stream of its own,
+    * so the jobs running at the same time don't share (or lock) a generator */
+    static Random& GetThreadLocal();
+
+    /** \brief Generate a random floating point number from [_min; _max)
     * \param _min - the minimum value:
     * \param _max - the max value:
     * @return the random value*/
-    float GenRandFloat(float _min, float _max);
+    float GenRandFloat(float _min, float _max)
+    {
+      //the top 24 bits, as many as a float has
+      return _min + static_cast<float>(Next() >> 8) * (1.0f / 16777216.0f) * (_max - _min);
+    }
 
     /** \brief Generate a random int number from [_min; _max] (inclusively)
     * \param _min - the minimum value:
     * \param _max - the max value:
     * @return the random value*/
     int GenRandInt(int _min, int _max);
+
+    /** \brief Fills _values with random numbers from [_min; _max), four at a time */
+    void Fill(float* _values, std::size_t _count, float _min, float _max);
+    /** \brief Fills _values with random numbers from [_min; _max] (inclusively) */
+    void FillInt(int* _values, std::size_t _count, int _min, int _max);
+
+    /** \brief The next 32 random bits */
+    std::uint32_t Next()
+    {
+      //xoshiro128**
+      const std::uint32_t result = RotateLeft(m_state[1] * 5, 7) * 9;
+      const std::uint32_t t = m_state[1] << 9;
+      m_state[2] ^= m_state[0];
+      m_state[3] ^= m_state[1];
+      m_state[1] ^= m_state[2];
+      m_state[0] ^= m_state[3];
+      m_state[2] ^= t;
+      m_state[3] = RotateLeft(m_state[3], 11);
+      return result;
+    }
+
   private:
+    static std::uint32_t RotateLeft(std::uint32_t _x, int _k) { return (_x << _k) | (_x >> (32 - _k)); }
+    //advances the state by 2^64 numbers, to the next stream
+    void Jump();
+
     using Clock = std::chrono::high_resolution_clock;
     Clock::time_point m_beginning = Clock::now();
 
-    std::mt19937 m_generator;
-
-    //std::seed_seq m_seed;
+    std::uint32_t m_state[4];
+    std::uint32_t m_lanes[4][4]; ///< the states of the four generators of Fill, word by word (the word of every lane side by side)
 
     std::random_device m_realRandom;
   };
 }
-
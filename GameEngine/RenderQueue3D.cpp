@@ -0,0 +1,374 @@
+#include "RenderQueue3D.h"
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <glm\geometric.hpp>
+#include <glm\gtc\type_ptr.hpp>
+
+#include "Camera3D.h"
+#include "Mesh.h"
+#include "Model.h"
+#include "RenderState.h"
+
+namespace GameEngine
+{
+  namespace
+  {
+    //the bits of the fields of a key, from the most significant: pass, shader, material, mesh, depth
+    constexpr std::uint32_t PASS_BITS = 4;
+    constexpr std::uint32_t SHADER_BITS = 8;
+    constexpr std::uint32_t MATERIAL_BITS = 12;
+    constexpr std::uint32_t MESH_BITS = 16;
+    constexpr std::uint32_t DEPTH_BITS = 24;
+
+    constexpr std::uint32_t DEPTH_SHIFT = 0;
+    constexpr std::uint32_t MESH_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+    constexpr std::uint32_t MATERIAL_SHIFT = MESH_SHIFT + MESH_BITS;
+    constexpr std::uint32_t SHADER_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+    constexpr std::uint32_t PASS_SHIFT = SHADER_SHIFT + SHADER_BITS;
+    static_assert(PASS_SHIFT + PASS_BITS == 64, "the fields have to fill the key");
+  }
+
+  RenderQueue3D::~RenderQueue3D()
+  {
+    if (m_instanceBuffer != 0)
+    {
+      glDeleteBuffers(1, &m_instanceBuffer);
+    }
+  }
+
+  void RenderQueue3D::Begin(const glm::vec3& _cameraPosition, float _maxDepth)
+  {
+    m_cameraPosition = _cameraPosition;
+    m_maxDepth = _maxDepth;
+    m_draws.clear();
+    m_keys.clear();
+    m_sorted = true;
+  }
+
+  void RenderQueue3D::Submit(unsigned int _pass, GLSLProgram& _shader, const Mesh& _mesh, const glm::mat4& _transform, unsigned int _flags)
+  {
+    //the queue uploads no bones, skinned meshes are drawn by their models
+    if (_pass >= MAX_PASSES || _mesh.HasAnimations())
+    {
+      return;
+    }
+    const glm::vec3 position(_transform[3]);
+    const float depth = std::min(glm::length(position - m_cameraPosition) / m_maxDepth, 1.0f);
+
+    std::uint64_t key = static_cast<std::uint64_t>(_pass) << PASS_SHIFT;
+    key |= static_cast<std::uint64_t>(GetId(m_shaderIds, &_shader, (1u << SHADER_BITS) - 1)) << SHADER_SHIFT;
+    key |= static_cast<std::uint64_t>(GetId(m_materialIds, &_mesh.GetMaterial(), (1u << MATERIAL_BITS) - 1)) << MATERIAL_SHIFT;
+    key |= static_cast<std::uint64_t>(GetId(m_meshIds, &_mesh, (1u << MESH_BITS) - 1)) << MESH_SHIFT;
+    key |= static_cast<std::uint64_t>(depth * ((1u << DEPTH_BITS) - 1)) << DEPTH_SHIFT;
+
+    m_keys.push_back({ key, static_cast<std::uint32_t>(m_draws.size()) });
+    m_draws.push_back({ &_shader, &_mesh, _transform, _flags });
+    m_sorted = false;
+  }
+
+  void RenderQueue3D::Submit(unsigned int _pass, GLSLProgram& _shader, const StaticModel& _model, unsigned int _flags)
+  {
+    const glm::mat4 modelMatrix = _model.GetModelMatrix();
+    for (const Mesh& mesh : _model.GetMeshes())
+    {
+      Submit(_pass, _shader, mesh, modelMatrix, _flags);
+    }
+  }
+
+  void RenderQueue3D::Sort()
+  {
+    if (m_sorted)
+    {
+      return;
+    }
+    m_sorted = true;
+    const size_t numKeys = m_keys.size();
+    m_sortScratch.resize(numKeys);
+
+    //LSD radix sort, 8 bits per pass. Every pass is stable, so equal keys keep their submission order
+    SortKey* source = m_keys.data();
+    SortKey* dest = m_sortScratch.data();
+    for (std::uint32_t shift = 0; shift < 64; shift += 8)
+    {
+      size_t counts[256] = { 0 };
+      for (size_t i = 0; i < numKeys; i++)
+      {
+        counts[(source[i].key >> shift) & 0xFF]++;
+      }
+      //all keys share this byte, so the pass would not change the order
+      if (counts[(source[0].key >> shift) & 0xFF] == numKeys)
+      {
+        continue;
+      }
+      size_t offset = 0;
+      for (size_t bucket = 0; bucket < 256; bucket++)
+      {
+        size_t count = counts[bucket];
+        counts[bucket] = offset;
+        offset += count;
+      }
+      for (size_t i = 0; i < numKeys; i++)
+      {
+        dest[counts[(source[i].key >> shift) & 0xFF]++] = source[i];
+      }
+      std::swap(source, dest);
+    }
+    if (source != m_keys.data())
+    {
+      m_keys.swap(m_sortScratch);
+    }
+  }
+
+  void RenderQueue3D::Execute(unsigned int _pass)
+  {
+    RenderState& state = RenderState::Get();
+    const bool cullFace = glIsEnabled(GL_CULL_FACE) == GL_TRUE;
+    bool drawCullFace = cullFace;
+
+    const auto begin = GetPassBegin(_pass);
+    const auto end = std::find_if(begin, m_keys.cend(), [_pass](const SortKey& _key) { return (_key.key >> PASS_SHIFT) != _pass; });
+
+    //the model matrices of all the runs at once, a run then only points the instance attributes at its own
+    m_instanceMatrices.clear();
+    for (auto it = begin; it != end;)
+    {
+      const auto runEnd = GetRunEnd(it, end);
+      if (runEnd - it > 1)
+      {
+        for (; it != runEnd; ++it)
+        {
+          const Draw& draw = m_draws[it->index];
+          m_instanceMatrices.push_back(draw.mesh->GetBaseModelMatrix() * draw.transform);
+        }
+      }
+      it = runEnd;
+    }
+    if (!m_instanceMatrices.empty())
+    {
+      if (m_instanceBuffer == 0)
+      {
+        glGenBuffers(1, &m_instanceBuffer);
+      }
+      glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+      FrameStats::Get().Add(STAT_BYTES_UPLOADED, m_instanceMatrices.size() * sizeof(glm::mat4));
+      //orphan the old storage, the last pass may still read it
+      glBufferData(GL_ARRAY_BUFFER, m_instanceMatrices.size() * sizeof(glm::mat4), m_instanceMatrices.data(), GL_STREAM_DRAW);
+    }
+
+    GLSLProgram* shader = nullptr;
+    const ShaderLocations* locations = nullptr;
+    const MaterialBindings* material = nullptr;
+    bool instanced = false;
+    GLintptr instanceOffset = 0;
+    for (auto it = begin; it != end;)
+    {
+      const Draw& draw = m_draws[it->index];
+      const auto runEnd = GetRunEnd(it, end);
+      const GLsizei numInstances = static_cast<GLsizei>(runEnd - it);
+      if (draw.shader != shader)
+      {
+        //the shaders are left drawing single meshes, as the game draws with them directly too
+        if (instanced)
+        {
+          instanced = false;
+          glUniform1i(locations->instanced, 0);
+        }
+        shader = draw.shader;
+        state.UseProgram(shader->GetProgramID());
+        locations = &GetLocations(*shader);
+        material = nullptr;
+      }
+      //the sampler uniforms belong to the program, so a material is bound again after a shader change
+      if (&draw.mesh->GetMaterial() != material)
+      {
+        material = &draw.mesh->GetMaterial();
+        material->Bind(*shader);
+      }
+      if (((draw.flags & DRAW_NO_CULL_FACE) == 0) != drawCullFace)
+      {
+        drawCullFace = !drawCullFace;
+        drawCullFace ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+      }
+      state.BindVertexArray(draw.mesh->GetVAO());
+
+      if (numInstances > 1)
+      {
+        if (!instanced)
+        {
+          instanced = true;
+          glUniform1i(locations->instanced, 1);
+        }
+        //the VAO reads the run from the buffer of the queue for this draw only, a model drawing the mesh instanced keeps its own
+        glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+        Mesh::SetInstanceMatrixAttributes(Mesh::INSTANCE_MATRIX_ATTRIBUTE, instanceOffset);
+        FrameStats::Get().Add(STAT_DRAW_CALLS);
+        glDrawElementsInstanced(GL_TRIANGLES, draw.mesh->GetNumIndices(), GL_UNSIGNED_INT, 0, numInstances);
+        glBindBuffer(GL_ARRAY_BUFFER, draw.mesh->GetInstanceBuffer());
+        Mesh::SetInstanceMatrixAttributes(Mesh::INSTANCE_MATRIX_ATTRIBUTE);
+        instanceOffset += numInstances * sizeof(glm::mat4);
+      }
+      else
+      {
+        if (instanced)
+        {
+          instanced = false;
+          glUniform1i(locations->instanced, 0);
+        }
+        glUniformMatrix4fv(locations->transformMatrix, 1, GL_FALSE, glm::value_ptr(draw.transform));
+        glUniformMatrix4fv(locations->baseModelMatrix, 1, GL_FALSE, glm::value_ptr(draw.mesh->GetBaseModelMatrix()));
+        FrameStats::Get().Add(STAT_DRAW_CALLS);
+        glDrawElements(GL_TRIANGLES, draw.mesh->GetNumIndices(), GL_UNSIGNED_INT, 0);
+      }
+      it = runEnd;
+    }
+
+    if (instanced)
+    {
+      glUniform1i(locations->instanced, 0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (cullFace != drawCullFace)
+    {
+      cullFace ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+    }
+  }
+
+  bool RenderQueue3D::IsLayeredSupported()
+  {
+    return glewIsSupported("GL_ARB_shader_viewport_layer_array") == GL_TRUE || glewIsSupported("GL_AMD_vertex_shader_layer") == GL_TRUE;
+  }
+
+  void RenderQueue3D::ExecuteLayered(unsigned int _pass, const std::vector<glm::mat4>& _layerTransforms, unsigned int _firstLayer)
+  {
+    //3 bits a layer in the int uniform
+    const size_t numLayers = std::min<size_t>(_layerTransforms.size(), 8 - std::min(_firstLayer, 8u));
+    std::array<std::array<glm::vec4, 6>, 8> layerPlanes;
+    for (size_t layer = 0; layer < numLayers; layer++)
+    {
+      layerPlanes[layer] = Camera3D::ExtractFrustumPlanes(_layerTransforms[layer]);
+    }
+
+    RenderState& state = RenderState::Get();
+    const bool cullFace = glIsEnabled(GL_CULL_FACE) == GL_TRUE;
+    bool drawCullFace = cullFace;
+
+    const auto begin = GetPassBegin(_pass);
+    GLSLProgram* shader = nullptr;
+    ShaderLocations* locations = nullptr;
+    const MaterialBindings* material = nullptr;
+    for (auto it = begin; it != m_keys.end() && (it->key >> PASS_SHIFT) == _pass; ++it)
+    {
+      const Draw& draw = m_draws[it->index];
+      //the bounding sphere in world space, the same model matrix as the shaders
+      const glm::mat4 model = draw.mesh->GetBaseModelMatrix() * draw.transform;
+      const glm::vec4& sphere = draw.mesh->GetBoundingSphere();
+      const glm::vec3 center(model * glm::vec4(glm::vec3(sphere), 1.0f));
+      const float radius = sphere.w * std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+      GLint layerFaces = 0;
+      GLsizei numInstances = 0;
+      for (size_t layer = 0; layer < numLayers; layer++)
+      {
+        if (Camera3D::IsSphereInFrustum(layerPlanes[layer], center, radius))
+        {
+          layerFaces |= static_cast<GLint>(_firstLayer + layer) << (3 * numInstances);
+          numInstances++;
+        }
+      }
+      if (numInstances == 0)
+      {
+        continue;
+      }
+
+      if (draw.shader != shader)
+      {
+        shader = draw.shader;
+        state.UseProgram(shader->GetProgramID());
+        locations = &GetLocations(*shader);
+        if (locations->layerFaces == -1)
+        {
+          locations->layerFaces = static_cast<GLint>(shader->GetUniformLocation("layerFaces"));
+        }
+        material = nullptr;
+      }
+      if (&draw.mesh->GetMaterial() != material)
+      {
+        material = &draw.mesh->GetMaterial();
+        material->Bind(*shader);
+      }
+      if (((draw.flags & DRAW_NO_CULL_FACE) == 0) != drawCullFace)
+      {
+        drawCullFace = !drawCullFace;
+        drawCullFace ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+      }
+      state.BindVertexArray(draw.mesh->GetVAO());
+
+      glUniformMatrix4fv(locations->transformMatrix, 1, GL_FALSE, glm::value_ptr(draw.transform));
+      glUniformMatrix4fv(locations->baseModelMatrix, 1, GL_FALSE, glm::value_ptr(draw.mesh->GetBaseModelMatrix()));
+      glUniform1i(locations->layerFaces, layerFaces);
+      FrameStats::Get().Add(STAT_DRAW_CALLS);
+      glDrawElementsInstanced(GL_TRIANGLES, draw.mesh->GetNumIndices(), GL_UNSIGNED_INT, 0, numInstances);
+    }
+
+    if (cullFace != drawCullFace)
+    {
+      cullFace ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+    }
+  }
+
+  std::vector<RenderQueue3D::SortKey>::const_iterator RenderQueue3D::GetPassBegin(unsigned int _pass)
+  {
+    Sort();
+    //the draws of the pass are one range, the pass is the top of the key
+    return std::lower_bound(m_keys.cbegin(), m_keys.cend(), _pass, [](const SortKey& _key, unsigned int _value)
+    {
+      return (_key.key >> PASS_SHIFT) < _value;
+    });
+  }
+
+  std::vector<RenderQueue3D::SortKey>::const_iterator RenderQueue3D::GetRunEnd(std::vector<SortKey>::const_iterator _first,
+    std::vector<SortKey>::const_iterator _end)
+  {
+    const Draw& first = m_draws[_first->index];
+    auto it = _first + 1;
+    //the instances of a mesh with times would need a time each
+    if (GetLocations(*first.shader).instanced == -1 || first.mesh->HasInstanceTimes())
+    {
+      return it;
+    }
+    //the material is the mesh's, the same mesh draws with the same one
+    while (it != _end && m_draws[it->index].shader == first.shader && m_draws[it->index].mesh == first.mesh && m_draws[it->index].flags == first.flags)
+    {
+      ++it;
+    }
+    return it;
+  }
+
+  std::uint32_t RenderQueue3D::GetId(std::unordered_map<const void*, std::uint32_t>& _ids, const void* _object, std::uint32_t _maxId)
+  {
+    auto it = _ids.find(_object);
+    if (it != _ids.end())
+    {
+      return it->second;
+    }
+    //past the bits of the field the objects share the last id, they are only not sorted among each other anymore
+    const std::uint32_t id = std::min(static_cast<std::uint32_t>(_ids.size()), _maxId);
+    _ids[_object] = id;
+    return id;
+  }
+
+  RenderQueue3D::ShaderLocations& RenderQueue3D::GetLocations(GLSLProgram& _shader)
+  {
+    auto it = m_shaderLocations.find(_shader.GetProgramID());
+    if (it != m_shaderLocations.end())
+    {
+      return it->second;
+    }
+    ShaderLocations& locations = m_shaderLocations[_shader.GetProgramID()];
+    locations.transformMatrix = _shader.GetUniformLocation("transformMatrix");
+    locations.baseModelMatrix = _shader.GetUniformLocation("baseModelMatrix");
+    //looked up directly, GetUniformLocation fails on a shader without it
+    locations.instanced = glGetUniformLocation(_shader.GetProgramID(), "instanced");
+    return locations;
+  }
+}
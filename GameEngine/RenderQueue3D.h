@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm\mat4x4.hpp>
+#include <glm\vec3.hpp>
+
+#include "GLSLProgram.h"
+
+namespace GameEngine
+{
+  class Mesh;
+  class StaticModel;
+
+  /** \brief Collects the draws of static meshes for a frame and executes them sorted by state instead of in code order.
+  * Every draw gets a 64 bit key of (pass, shader, material, mesh, depth), the keys are radix sorted once and every pass is executed
+  * through RenderState, so a shader, a VAO or a texture is only bound when it differs from the draw before.
+  * The per pass uniforms (projection, view, lights...) are uploaded to the shaders before Execute, the queue uploads
+  * transformMatrix and baseModelMatrix of every draw.
+  * Draws of the same mesh with the same shader and flags end up next to each other in the sorted keys, Execute draws such a run as one
+  * instanced draw when the shader has the bool uniform instanced (with the model matrix of an instance at Mesh::INSTANCE_MATRIX_ATTRIBUTE,
+  * as for a GeometryPool), so the game submits every object on its own and still gets one draw call per mesh */
+  class RenderQueue3D
+  {
+  public:
+    enum : unsigned int { MAX_PASSES = 16 };
+    /** \brief The state flags of a draw */
+    enum DrawFlags : unsigned int
+    {
+      DRAW_DEFAULT = 0,
+      DRAW_NO_CULL_FACE = 1 ///< draws both faces, e.g. a room seen from inside
+    };
+
+    RenderQueue3D() {}
+    ~RenderQueue3D();
+    RenderQueue3D(const RenderQueue3D&) = delete;
+    RenderQueue3D& operator=(const RenderQueue3D&) = delete;
+
+    /** \brief Removes the draws of the last frame
+    * \param _cameraPosition - the depths of the draws are the distances to it, up to _maxDepth (the far plane), nearer draws of the same state go first */
+    void Begin(const glm::vec3& _cameraPosition, float _maxDepth);
+
+    /** \brief Adds a draw of _mesh with _shader in _pass (below MAX_PASSES), _transform is its transformMatrix */
+    void Submit(unsigned int _pass, GLSLProgram& _shader, const Mesh& _mesh, const glm::mat4& _transform, unsigned int _flags = DRAW_DEFAULT);
+    /** \brief Adds a draw of every mesh of _model, with the model matrix of the model */
+    void Submit(unsigned int _pass, GLSLProgram& _shader, const StaticModel& _model, unsigned int _flags = DRAW_DEFAULT);
+
+    /** \brief Sorts the draws, done by the first Execute after a Submit */
+    void Sort();
+    /** \brief Draws all the draws of _pass in key order, the runs of the same draw instanced. Leaves the cull face as it was */
+    void Execute(unsigned int _pass);
+
+    /** \brief Check if a vertex shader can pick the layer it renders to (gl_Layer), which ExecuteLayered needs */
+    static bool IsLayeredSupported();
+    /** \brief Draws _pass into the layers of a layered target (the faces of a shadow cubemap), each draw only to the layers whose
+    * frustum (_layerTransforms, e.g. LightCamera::GetLightTransforms) its bounding sphere reaches: one instanced draw with an instance per
+    * reached layer instead of a geometry shader copying every triangle to all of them. The shader gets the layers in the int uniform
+    * layerFaces, 3 bits each, instance i renders layer (layerFaces >> (3 * i)) & 7 and writes it to gl_Layer. _layerTransforms[0] is
+    * layer _firstLayer, so without gl_Layer a pass per layer can still pick its transform (see CascadedShadowMap::Render) */
+    void ExecuteLayered(unsigned int _pass, const std::vector<glm::mat4>& _layerTransforms, unsigned int _firstLayer = 0);
+
+    size_t GetNumDraws() const noexcept { return m_draws.size(); }
+    /** \brief The draws the last Execute drew as instances of a run, they took no draw call of their own */
+    size_t GetNumInstancedDraws() const noexcept { return m_instanceMatrices.size(); }
+
+  private:
+    struct Draw
+    {
+      GLSLProgram* shader;
+      const Mesh* mesh;
+      glm::mat4 transform;
+      unsigned int flags;
+    };
+
+    struct SortKey
+    {
+      std::uint64_t key;
+      std::uint32_t index;
+    };
+
+    /** \brief The locations of the draw uniforms in a shader */
+    struct ShaderLocations
+    {
+      UniformLocation transformMatrix;
+      UniformLocation baseModelMatrix;
+      GLint layerFaces{ -1 }; ///< only looked up by ExecuteLayered
+      GLint instanced{ -1 };  ///< -1 if the shader can't draw instances
+    };
+
+    /** \brief The small sort id of _object, ids are handed out in the order the objects are first seen */
+    static std::uint32_t GetId(std::unordered_map<const void*, std::uint32_t>& _ids, const void* _object, std::uint32_t _maxId);
+    ShaderLocations& GetLocations(GLSLProgram& _shader);
+    /** \brief The first draw of _pass in m_keys, sorted */
+    std::vector<SortKey>::const_iterator GetPassBegin(unsigned int _pass);
+    /** \brief The end of the run of draws from _first on (before _end) which can be one instanced draw, the one after _first if none can */
+    std::vector<SortKey>::const_iterator GetRunEnd(std::vector<SortKey>::const_iterator _first, std::vector<SortKey>::const_iterator _end);
+
+    glm::vec3 m_cameraPosition{ 0.0f };
+    float m_maxDepth{ 100.0f };
+    std::vector<Draw> m_draws;
+    std::vector<SortKey> m_keys;
+    std::vector<SortKey> m_sortScratch;
+    bool m_sorted{ true };
+    std::vector<glm::mat4> m_instanceMatrices; ///< of the runs of the pass, in key order
+    GLuint m_instanceBuffer{ 0 };              ///< made by the first Execute with a run
+
+    //the ids keep over the frames, so the order of the states stays the same too
+    std::unordered_map<const void*, std::uint32_t> m_shaderIds;
+    std::unordered_map<const void*, std::uint32_t> m_materialIds;
+    std::unordered_map<const void*, std::uint32_t> m_meshIds;
+    std::unordered_map<ProgramID, ShaderLocations> m_shaderLocations;
+  };
+}
@@ -0,0 +1,188 @@
+#include "RenderState.h"
+
+#include <numeric>
+
+namespace GameEngine
+{
+  size_t RenderState::Stats::GetNumCalls() const
+  {
+    return std::accumulate(calls.begin(), calls.end(), size_t(0));
+  }
+
+  size_t RenderState::Stats::GetNumRedundant() const
+  {
+    return std::accumulate(redundant.begin(), redundant.end(), size_t(0));
+  }
+
+  RenderState::RenderState()
+  {
+    Invalidate();
+    m_frame.calls.fill(0);
+    m_frame.redundant.fill(0);
+    m_lastFrame = m_frame;
+  }
+
+  RenderState& RenderState::Get()
+  {
+    //GL is used from the main thread only, like the rest of the rendering
+    static RenderState state;
+    return state;
+  }
+
+  void RenderState::BeginFrame()
+  {
+    m_lastFrame = m_frame;
+    m_frame.calls.fill(0);
+    m_frame.redundant.fill(0);
+  }
+
+  void RenderState::Invalidate()
+  {
+    m_program = UNKNOWN;
+    m_vao = UNKNOWN;
+    m_activeUnit = UNKNOWN;
+    for (auto& textures : m_textures)
+    {
+      textures.fill(UNKNOWN);
+    }
+    m_samplers.fill(UNKNOWN);
+  }
+
+  void RenderState::UseProgram(GLuint _program)
+  {
+    if (Change(PROGRAM, m_program, _program))
+    {
+      glUseProgram(_program);
+    }
+  }
+
+  void RenderState::BindVertexArray(GLuint _vao)
+  {
+    if (Change(VERTEX_ARRAY, m_vao, _vao))
+    {
+      glBindVertexArray(_vao);
+    }
+  }
+
+  void RenderState::ActiveTexture(GLuint _unit)
+  {
+    if (Change(ACTIVE_TEXTURE, m_activeUnit, _unit))
+    {
+      glActiveTexture(GL_TEXTURE0 + _unit);
+    }
+  }
+
+  void RenderState::BindTexture(GLuint _unit, GLenum _target, GLuint _texture, GLuint _sampler)
+  {
+    BindSampler(_unit, _sampler);
+    std::array<GLuint, MAX_TEXTURE_UNITS>* textures = _unit < MAX_TEXTURE_UNITS ? GetTextures(_target) : nullptr;
+    if (textures == nullptr)
+    {
+      ActiveTexture(_unit);
+      m_frame.calls[TEXTURE]++;
+      glBindTexture(_target, _texture);
+      return;
+    }
+    if (Change(TEXTURE, (*textures)[_unit], _texture))
+    {
+      ActiveTexture(_unit);
+      glBindTexture(_target, _texture);
+    }
+  }
+
+  void RenderState::BindSampler(GLuint _unit, GLuint _sampler)
+  {
+    if (_unit >= MAX_TEXTURE_UNITS)
+    {
+      m_frame.calls[SAMPLER]++;
+      glBindSampler(_unit, _sampler);
+      return;
+    }
+    //samplers bind to the unit directly, the active one doesn't matter
+    if (Change(SAMPLER, m_samplers[_unit], _sampler))
+    {
+      glBindSampler(_unit, _sampler);
+    }
+  }
+
+  void RenderState::DeleteProgram(GLuint _program)
+  {
+    if (m_program == _program)
+    {
+      m_program = UNKNOWN;
+    }
+    glDeleteProgram(_program);
+  }
+
+  void RenderState::DeleteVertexArrays(GLsizei _count, const GLuint* _vaos)
+  {
+    for (GLsizei i = 0; i < _count; i++)
+    {
+      if (m_vao == _vaos[i])
+      {
+        m_vao = UNKNOWN;
+      }
+    }
+    glDeleteVertexArrays(_count, _vaos);
+  }
+
+  void RenderState::DeleteTextures(GLsizei _count, const GLuint* _textures)
+  {
+    for (GLsizei i = 0; i < _count; i++)
+    {
+      for (auto& textures : m_textures)
+      {
+        for (auto& texture : textures)
+        {
+          if (texture == _textures[i])
+          {
+            texture = UNKNOWN;
+          }
+        }
+      }
+    }
+    glDeleteTextures(_count, _textures);
+  }
+
+  void RenderState::DeleteSamplers(GLsizei _count, const GLuint* _samplers)
+  {
+    for (GLsizei i = 0; i < _count; i++)
+    {
+      for (auto& sampler : m_samplers)
+      {
+        if (sampler == _samplers[i])
+        {
+          sampler = UNKNOWN;
+        }
+      }
+    }
+    glDeleteSamplers(_count, _samplers);
+  }
+
+  bool RenderState::Change(Counter _counter, GLuint& _shadow, GLuint _value)
+  {
+    m_frame.calls[_counter]++;
+    if (_shadow == _value)
+    {
+      m_frame.redundant[_counter]++;
+      return false;
+    }
+    _shadow = _value;
+    return true;
+  }
+
+  std::array<GLuint, RenderState::MAX_TEXTURE_UNITS>* RenderState::GetTextures(GLenum _target)
+  {
+    switch (_target)
+    {
+    case GL_TEXTURE_2D:
+      return &m_textures[0];
+    case GL_TEXTURE_2D_ARRAY:
+      return &m_textures[1];
+    case GL_TEXTURE_CUBE_MAP:
+      return &m_textures[2];
+    default:
+      return nullptr;
+    }
+  }
+}
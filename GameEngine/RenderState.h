@@ -0,0 +1,75 @@
+#pragma once
+
+#include <GL\glew.h>
+#include <array>
+#include <cstddef>
+
+namespace GameEngine
+{
+  /** \brief Shadows the bound program, VAO, active texture unit and the textures and samplers of every unit, and skips the GL calls which wouldn't
+  * change them. The engine binds all of those through RenderState::Get(), so the shadow only goes stale when other code (e.g. CEGUI)
+  * touches the state, which then calls Invalidate(). Counts the calls and the skipped ones per frame (see BeginFrame) to track the
+  * driver overhead. Buffers aren't shadowed: their binds come before uploads and the element buffer is part of the VAO */
+  class RenderState
+  {
+  public:
+    enum : GLuint { MAX_TEXTURE_UNITS = 16 };
+    /** \brief What a counter counts */
+    enum Counter : unsigned int { PROGRAM, VERTEX_ARRAY, ACTIVE_TEXTURE, TEXTURE, SAMPLER, NUM_COUNTERS };
+
+    /** \brief The calls of a frame, by counter */
+    struct Stats
+    {
+      std::array<size_t, NUM_COUNTERS> calls;     ///< all the calls to RenderState
+      std::array<size_t, NUM_COUNTERS> redundant; ///< the ones which were skipped
+
+      size_t GetNumCalls() const;
+      size_t GetNumRedundant() const;
+    };
+
+    /** \brief The state of the GL context of the engine */
+    static RenderState& Get();
+
+    /** \brief Starts counting the calls of the next frame, the ones of the frame before are GetLastFrameStats() */
+    void BeginFrame();
+    /** \brief Forgets the state after other code (not going through RenderState) changed it */
+    void Invalidate();
+
+    void UseProgram(GLuint _program);
+    void BindVertexArray(GLuint _vao);
+    void ActiveTexture(GLuint _unit);
+    /** \brief Makes _unit the active one and binds _texture to its _target, and _sampler to the unit (0 samples with the parameters
+    * of the texture). The targets 2D, 2D array and cube map are shadowed, the others are always bound */
+    void BindTexture(GLuint _unit, GLenum _target, GLuint _texture, GLuint _sampler = 0);
+    void BindSampler(GLuint _unit, GLuint _sampler);
+
+    /** \brief Deletes the objects and forgets their bindings, GL unbinds them and a new object may get the same name */
+    void DeleteProgram(GLuint _program);
+    void DeleteVertexArrays(GLsizei _count, const GLuint* _vaos);
+    void DeleteTextures(GLsizei _count, const GLuint* _textures);
+    void DeleteSamplers(GLsizei _count, const GLuint* _samplers);
+
+    const Stats& GetFrameStats() const noexcept { return m_frame; }
+    const Stats& GetLastFrameStats() const noexcept { return m_lastFrame; }
+
+  private:
+    enum : GLuint { UNKNOWN = static_cast<GLuint>(-1) };
+    enum : unsigned int { NUM_TEXTURE_TARGETS = 3 };
+
+    RenderState();
+
+    /** \brief Counts a call of _counter, returns true if _value differs from _shadow (which then becomes _value) */
+    bool Change(Counter _counter, GLuint& _shadow, GLuint _value);
+    /** \brief The shadowed textures of _target by unit, nullptr for a target which isn't shadowed */
+    std::array<GLuint, MAX_TEXTURE_UNITS>* GetTextures(GLenum _target);
+
+    GLuint m_program{ UNKNOWN };
+    GLuint m_vao{ UNKNOWN };
+    GLuint m_activeUnit{ UNKNOWN };
+    std::array<std::array<GLuint, MAX_TEXTURE_UNITS>, NUM_TEXTURE_TARGETS> m_textures; ///< 2D, 2D array, cube map
+    std::array<GLuint, MAX_TEXTURE_UNITS> m_samplers;
+
+    Stats m_frame;
+    Stats m_lastFrame;
+  };
+}
@@ -0,0 +1,113 @@
+#include "RenderTargetPool.h"
+#include "RenderState.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace GameEngine
+{
+  namespace
+  {
+    //frames a target stays in the pool without being acquired
+    const unsigned int MAX_UNUSED_FRAMES = 120;
+  }
+
+  void RenderTargetPool::Init(int _screenWidth, int _screenHeight)
+  {
+    m_screenWidth = _screenWidth;
+    m_screenHeight = _screenHeight;
+  }
+
+  void RenderTargetPool::Dispose()
+  {
+    m_targets.clear();
+  }
+
+  void RenderTargetPool::Resize(int _screenWidth, int _screenHeight)
+  {
+    m_screenWidth = _screenWidth;
+    m_screenHeight = _screenHeight;
+  }
+
+  Framebuffer* RenderTargetPool::Acquire(const RenderTargetDesc& _desc)
+  {
+    int width = 0;
+    int height = 0;
+    GetSize(_desc, width, height);
+    //one of the right size first, one of an old size is made again
+    Target* found = nullptr;
+    for (Target& target : m_targets)
+    {
+      if (!target.inUse && target.desc == _desc && (found == nullptr || (target.width == width && target.height == height)))
+      {
+        found = &target;
+      }
+    }
+    if (found == nullptr)
+    {
+      m_targets.emplace_back();
+      found = &m_targets.back();
+      found->desc = _desc;
+    }
+    if (found->framebuffer == nullptr || found->width != width || found->height != height)
+    {
+      Create(*found);
+    }
+    found->inUse = true;
+    found->lastFrame = m_frame;
+    return found->framebuffer.get();
+  }
+
+  void RenderTargetPool::Release(Framebuffer* _target)
+  {
+    for (Target& target : m_targets)
+    {
+      if (target.framebuffer.get() == _target)
+      {
+        target.inUse = false;
+        return;
+      }
+    }
+  }
+
+  void RenderTargetPool::EndFrame()
+  {
+    m_frame++;
+    m_targets.erase(std::remove_if(m_targets.begin(), m_targets.end(), [this](const Target& _target)
+    {
+      return !_target.inUse && m_frame - _target.lastFrame > MAX_UNUSED_FRAMES;
+    }), m_targets.end());
+  }
+
+  void RenderTargetPool::GetSize(const RenderTargetDesc& _desc, int& _width, int& _height) const
+  {
+    _width = std::max(1, static_cast<int>(static_cast<float>(m_screenWidth) * _desc.scale));
+    _height = std::max(1, static_cast<int>(static_cast<float>(m_screenHeight) * _desc.scale));
+  }
+
+  void RenderTargetPool::Create(Target& _target)
+  {
+    GetSize(_target.desc, _target.width, _target.height);
+    _target.framebuffer = std::make_unique<Framebuffer>();
+    Framebuffer& framebuffer = *_target.framebuffer;
+
+    GLint previousFbo = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+    framebuffer.Init();
+    framebuffer.Bind(GL_FRAMEBUFFER, _target.width, _target.height);
+    framebuffer.AttachColorTexture(_target.width, _target.height, _target.desc.internalFormat, _target.desc.format, _target.desc.type);
+    if (_target.desc.depth)
+    {
+      framebuffer.AttachDepthTexture(_target.width, _target.height);
+    }
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, framebuffer.GetColorTexture(0).id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+    if (!framebuffer.CheckFramebufferStatus())
+    {
+      std::cout << "ERROR::RENDER_TARGET_POOL:: A render target is not complete!" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+  }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <GL\glew.h>
+#include <memory>
+#include <vector>
+
+#include "Framebuffer.h"
+
+namespace GameEngine
+{
+  /** \brief The format of a render target. Its size is a fraction of the screen, so it follows the window */
+  struct RenderTargetDesc
+  {
+    GLenum internalFormat{ GL_RGBA8 };
+    GLenum format{ GL_RGBA };
+    GLenum type{ GL_UNSIGNED_BYTE };
+    float scale{ 1.0f }; ///< of the screen size, e.g. 0.5f for a half resolution blur
+    bool depth{ false }; ///< with a depth texture
+
+    bool operator==(const RenderTargetDesc& _other) const noexcept
+    {
+      return internalFormat == _other.internalFormat && format == _other.format && type == _other.type &&
+        scale == _other.scale && depth == _other.depth;
+    }
+  };
+
+  /** \brief The render targets of the passes of a frame, shared instead of each effect owning its own. A target given back with Release
+  * is handed to the next Acquire of the same format, so passes that don't overlap alias the same texture (see PostProcessGraph).
+  * Resize only changes the size the targets are made at, a target of the old size is made again when it's acquired */
+  class RenderTargetPool
+  {
+  public:
+    RenderTargetPool() {}
+    ~RenderTargetPool() { Dispose(); }
+
+    void Init(int _screenWidth, int _screenHeight);
+    void Dispose();
+    void Resize(int _screenWidth, int _screenHeight);
+
+    /** \brief A free target of _desc at the current size, made if the pool has none. Its texture is the color attachment 0, filtered
+    * linearly so a pass can read it at another size */
+    Framebuffer* Acquire(const RenderTargetDesc& _desc);
+    /** \brief Gives the target back, the next Acquire of its format may get it */
+    void Release(Framebuffer* _target);
+    /** \brief Frees the targets no frame acquired for a while, e.g. the ones of an effect turned off */
+    void EndFrame();
+
+    /** \brief The size of a target of _desc at the current screen size */
+    void GetSize(const RenderTargetDesc& _desc, int& _width, int& _height) const;
+    size_t GetNumTargets() const noexcept { return m_targets.size(); }
+  private:
+    struct Target
+    {
+      RenderTargetDesc desc;
+      int width{ 0 };
+      int height{ 0 };
+      std::unique_ptr<Framebuffer> framebuffer; ///< on the heap, the pointers given out stay valid when the vector grows
+      bool inUse{ false };
+      unsigned int lastFrame{ 0 };
+    };
+
+    //(re)creates the framebuffer of _target at the current size
+    void Create(Target& _target);
+
+    std::vector<Target> m_targets;
+    int m_screenWidth{ 0 };
+    int m_screenHeight{ 0 };
+    unsigned int m_frame{ 0 };
+  };
+}
@@ -0,0 +1,127 @@
+#include "RenderThread.h"
+#include "FrameStats.h"
+#include "GpuProfiler.h"
+#include "Profiler.h"
+#include "RenderState.h"
+#include "Window.h"
+
+#include <future>
+#include <iostream>
+
+namespace GameEngine
+{
+  bool RenderThread::Start(Window& _window, std::function<void(FramePacket&)> _render, std::function<void()> _sync)
+  {
+    if (IsRunning())
+    {
+      return true;
+    }
+    //a context is current on one thread at a time
+    if (SDL_GL_MakeCurrent(_window.GetWindow(), nullptr) != 0)
+    {
+      std::cout << "ERROR::RENDERTHREAD::RELEASE_CONTEXT_FAILED\n" << SDL_GetError() << std::endl;
+      return false;
+    }
+    m_window = &_window;
+    m_render = std::move(_render);
+    m_sync = std::move(_sync);
+    m_stop = false;
+    m_hasPacket = false;
+    m_buildIndex = 0;
+    m_packets[0].Clear();
+
+    std::promise<bool> current;
+    std::future<bool> isCurrent = current.get_future();
+    m_thread = std::thread([this, &current]()
+    {
+      const bool made = SDL_GL_MakeCurrent(m_window->GetWindow(), m_window->GetGLContext()) == 0;
+      current.set_value(made);
+      if (made)
+      {
+        Loop();
+        SDL_GL_MakeCurrent(m_window->GetWindow(), nullptr);
+      }
+    });
+    if (!isCurrent.get())
+    {
+      std::cout << "ERROR::RENDERTHREAD::MAKE_CURRENT_FAILED\n" << SDL_GetError() << std::endl;
+      m_thread.join();
+      SDL_GL_MakeCurrent(_window.GetWindow(), _window.GetGLContext());
+      return false;
+    }
+    return true;
+  }
+
+  void RenderThread::Stop()
+  {
+    if (!IsRunning())
+    {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+    SDL_GL_MakeCurrent(m_window->GetWindow(), m_window->GetGLContext());
+    m_hasPacket = false;
+  }
+
+  void RenderThread::Submit()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    //the packet before is drawn, it's the next one to build
+    m_condition.wait(lock, [this]() { return !m_hasPacket; });
+    m_buildIndex = 1 - m_buildIndex;
+    m_hasPacket = true;
+    m_synced = false;
+    m_condition.notify_all();
+    //the simulation doesn't touch what the sync uploads or reloads until it ran
+    m_condition.wait(lock, [this]() { return m_synced; });
+    lock.unlock();
+    m_packets[m_buildIndex].Clear();
+  }
+
+  void RenderThread::Loop()
+  {
+    Profiler::Get().SetThreadName("Render");
+    while (true)
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      //the submitted packets are all drawn before it stops
+      m_condition.wait(lock, [this]() { return m_hasPacket || m_stop; });
+      if (!m_hasPacket)
+      {
+        return;
+      }
+      FramePacket& packet = m_packets[1 - m_buildIndex];
+      lock.unlock();
+
+      if (m_sync)
+      {
+        m_sync();
+      }
+      lock.lock();
+      m_synced = true;
+      lock.unlock();
+      m_condition.notify_all();
+
+      {
+        PROFILE_SCOPE("RenderThread::Render");
+        //the redundant GL calls are counted per frame
+        RenderState::Get().BeginFrame();
+        GpuProfiler::Get().BeginFrame();
+        m_render(packet);
+        const RenderState::Stats& glStats = RenderState::Get().GetFrameStats();
+        FrameStats::Get().Set(STAT_STATE_CHANGES, glStats.GetNumCalls() - glStats.GetNumRedundant());
+      }
+      m_window->SwapBuffer();
+
+      lock.lock();
+      m_hasPacket = false;
+      lock.unlock();
+      m_condition.notify_all();
+    }
+  }
+}
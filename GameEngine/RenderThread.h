@@ -0,0 +1,53 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "FramePacket.h"
+
+namespace GameEngine
+{
+  class Window;
+
+  /** \brief Draws the frames on a thread of its own, which owns the GL context while it runs. The simulation builds the next packet
+   *  (GetBuildPacket) while the last one is drawn, Submit hands it over, so a frame costs the longer of the update and the draw
+   *  instead of both. The packets are double buffered: the simulation is at most a frame ahead, and never writes the packet which
+   *  is being drawn */
+  class RenderThread
+  {
+  public:
+    ~RenderThread() { Stop(); }
+
+    /** \brief Moves the GL context of the window to a new thread, which calls _render with every submitted packet and swaps
+     *  \param _sync called on the render thread before a packet is drawn, while the simulation waits, for the GL work the
+     *  simulation would do otherwise (uploading the loaded textures, reloading the assets) */
+    bool Start(Window& _window, std::function<void(FramePacket&)> _render, std::function<void()> _sync);
+    // Waits for the last packet to be drawn and gives the GL context back to the calling thread
+    void Stop();
+
+    // The packet the simulation fills, cleared
+    FramePacket& GetBuildPacket() { return m_packets[m_buildIndex]; }
+    // Hands the built packet over once the one before is drawn, returns once the sync of the render thread ran
+    void Submit();
+
+    bool IsRunning() const noexcept { return m_thread.joinable(); }
+
+  private:
+    void Loop();
+
+    Window* m_window{ nullptr };
+    std::function<void(FramePacket&)> m_render;
+    std::function<void()> m_sync;
+
+    FramePacket m_packets[2];
+    int m_buildIndex{ 0 };
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_hasPacket{ false }; ///< a packet waits for the render thread or is drawn
+    bool m_synced{ false };    ///< the sync of the submitted packet ran
+    bool m_stop{ false };
+  };
+}
@@ -2,6 +2,7 @@
 #include "GLTexture.h"
 #include "Model.h"
 #include "GLSLProgram.h"
+#include "IOManager.h"
 namespace GameEngine
 {
   // Instantiate static variables
@@ -12,6 +13,74 @@ namespace GameEngine
     //use the cache to get the texture
     return s_cache.GetTexture(_texturePath, _alpha);
   }
+  GLTexture ResourceManager::GetTexture(AssetId _texture, bool _alpha)
+  {
+    return s_cache.GetTexture(_texture, _alpha);
+  }
+  Handle<GLTexture> ResourceManager::LoadTexture(const std::string& _texturePath, bool _alpha)
+  {
+    return s_cache.LoadTexture(_texturePath, _alpha);
+  }
+  Handle<GLTexture> ResourceManager::LoadTexture(AssetId _texture, bool _alpha)
+  {
+    return s_cache.LoadTexture(_texture, _alpha);
+  }
+  Handle<GLTexture> ResourceManager::LoadTextureAsync(const std::string& _texturePath, bool _alpha)
+  {
+    return s_cache.LoadTextureAsync(_texturePath, _alpha);
+  }
+  void ResourceManager::UpdateAsyncLoads()
+  {
+    s_cache.UpdateAsyncLoads();
+  }
+  void ResourceManager::ReloadChangedAssets()
+  {
+    std::vector<std::string> changedFiles;
+    IOManager::PollChangedFiles(changedFiles);
+    if (changedFiles.empty())
+    {
+      return;
+    }
+    s_cache.ReloadChangedFiles(changedFiles);
+    GLSLProgram::ReloadChangedFiles(changedFiles);
+  }
+  size_t ResourceManager::GetNumPendingLoads()
+  {
+    return s_cache.GetNumPendingLoads();
+  }
+  void ResourceManager::SetCompressTextures(bool _compress)
+  {
+    s_cache.SetCompressTextures(_compress);
+  }
+  void ResourceManager::SetStreamTextures(bool _stream, size_t _budget)
+  {
+    s_cache.SetStreamTextures(_stream);
+    s_cache.GetMipStreamer().SetBudget(_budget);
+  }
+  void ResourceManager::RequestTextureMips(const Mesh& _mesh, const glm::mat4& _transform, const Camera3D& _camera)
+  {
+    s_cache.GetMipStreamer().Request(_mesh, _transform, _camera);
+  }
+  void ResourceManager::RequestTextureMips(const StaticModel& _model, const Camera3D& _camera)
+  {
+    const glm::mat4 modelMatrix = _model.GetModelMatrix();
+    for (const Mesh& mesh : _model.GetMeshes())
+    {
+      s_cache.GetMipStreamer().Request(mesh, modelMatrix, _camera);
+    }
+  }
+  void ResourceManager::PackTextureArray(const std::vector<std::string>& _texturePaths, bool _alpha)
+  {
+    s_cache.PackTextureArray(_texturePaths, _alpha);
+  }
+  AtlasRegion ResourceManager::GetAtlasRegion(const std::string& _texturePath)
+  {
+    return s_cache.GetAtlasRegion(_texturePath);
+  }
+  void ResourceManager::FinalizeAtlas()
+  {
+    s_cache.FinalizeAtlas();
+  }
   GLCubemap ResourceManager::GetCubemap(const std::string& _directory,
     const std::string& _posXFilename,
     const std::string& _negXFilename,
@@ -24,13 +93,36 @@ namespace GameEngine
     //use the cache to get the cubemap
     return s_cache.GetCubemap(_directory, _posXFilename, _negXFilename, _posYFilename, _negYFilename, _posZFilename, _negZFilename, _cubemapName);
   }
-  void ResourceManager::GetSkinnedModel(const std::string & _filepath, SkinnedModel* _model)
+  void ResourceManager::GetSkinnedModel(const std::string & _filepath, SkinnedModel* _model, bool _keepCpuData)
+  {
+    s_cache.GetSkinnedModel(_filepath, _model, _keepCpuData);
+  }
+  void ResourceManager::GetStaticModel(const std::string & _filepath, StaticModel* _model, bool _keepCpuData)
+  {
+    s_cache.GetStaticModel(_filepath, _model, _keepCpuData);
+  }
+  Handle<StaticModel> ResourceManager::LoadStaticModel(const std::string& _filepath, bool _keepCpuData)
+  {
+    return s_cache.LoadStaticModel(_filepath, _keepCpuData);
+  }
+  Handle<SkeletonAsset> ResourceManager::LoadSkinnedAsset(const std::string& _filepath, bool _keepCpuData)
+  {
+    return s_cache.LoadSkinnedAsset(_filepath, _keepCpuData);
+  }
+  void ResourceManager::Preload(const AssetManifest& _manifest, PreloadedAssets& _assets, AudioEngine* _audio)
   {
-    s_cache.GetSkinnedModel(_filepath, _model);
+    s_cache.Preload(_manifest, _assets, _audio);
   }
-  void ResourceManager::GetStaticModel(const std::string & _filepath, StaticModel* _model)
+  bool ResourceManager::Preload(const std::string& _manifestPath, PreloadedAssets& _assets, AudioEngine* _audio)
   {
-    s_cache.GetStaticModel(_filepath, _model);
+    AssetManifest manifest;
+    if (!manifest.Load(_manifestPath))
+    {
+      return false;
+    }
+    manifest.ResolveDependencies();
+    s_cache.Preload(manifest, _assets, _audio);
+    return true;
   }
   void ResourceManager::Clear()
   {
@@ -10,16 +10,56 @@ namespace GameEngine
   class ResourceManager
   {
   public:
-    //gets the texture from the specified filepath
+    //gets the texture from the specified filepath, it stays loaded until Clear
     static GLTexture GetTexture(const std::string& _texturePath, bool _alpha = true);
+    //gets the texture of an id from AssetIds::Intern(path), for the per frame calls: the path isn't hashed again
+    static GLTexture GetTexture(AssetId _texture, bool _alpha = true);
+    //gets a counted handle to the texture of the filepath, it's freed with its last handle (see Handle)
+    static Handle<GLTexture> LoadTexture(const std::string& _texturePath, bool _alpha = true);
+    static Handle<GLTexture> LoadTexture(AssetId _texture, bool _alpha = true);
+    //returns the handle right away, with a placeholder texture until the image is decoded in the background and uploaded
+    static Handle<GLTexture> LoadTextureAsync(const std::string& _texturePath, bool _alpha = true);
+    //streams the decoded async loads to the GPU, at most TextureStreamer::SECTION_SIZE bytes a frame. IMainGame calls it every frame
+    static void UpdateAsyncLoads();
+    //the async loads not uploaded yet, e.g. for a loading screen
+    static size_t GetNumPendingLoads();
+    //reloads the textures, shared models and shader programs whose files changed on the disk (see IOManager::EnableFileWatching),
+    //in place: the handles and programs stay valid. IMainGame calls it every frame while the file watch is on
+    static void ReloadChangedAssets();
+    //block compresses the textures loaded from then on (BC1, or BC3 with alpha), cooking them on their first load. DDS files always load compressed
+    static void SetCompressTextures(bool _compress);
+    //streams the large mip levels of the textures loaded from then on as the screen needs them, within the budget (see MipStreamer).
+    //UpdateAsyncLoads streams them in, the renderer requests them for what it draws
+    static void SetStreamTextures(bool _stream, size_t _budget = MipStreamer::DEFAULT_BUDGET);
+    //requests the mip levels the textures of the meshes need, drawn with _transform (or the model matrix of _model) on the screen of _camera
+    static void RequestTextureMips(const Mesh& _mesh, const glm::mat4& _transform, const Camera3D& _camera);
+    static void RequestTextureMips(const StaticModel& _model, const Camera3D& _camera);
+    //packs same-sized textures into one GL_TEXTURE_2D_ARRAY (call it on level load, before the textures are fetched)
+    static void PackTextureArray(const std::vector<std::string>& _texturePaths, bool _alpha = true);
+    //gets the texture as a region of a shared atlas page (the page texture plus the uv rect inside it)
+    static AtlasRegion GetAtlasRegion(const std::string& _texturePath);
+    //generates the atlas mipmaps, call once the level load requested all its regions
+    static void FinalizeAtlas();
     //gets the cubemap from the specified 6 faces
     static GLCubemap GetCubemap(const std::string& _directory, const std::string& _posXFilename, const std::string& _negXFilename,
       const std::string& _posYFilename, const std::string& _negYFilename, const std::string& _posZFilename, const std::string& _negZFilename, const std::string& _cubemapName );
-    //Loads the skinned model from the filepath to the passed skinned model
-    static void GetSkinnedModel(const std::string& _filepath, SkinnedModel* _model);
-    //Loads the static model from the filepath to the passed static model
-    static void GetStaticModel(const std::string& _filepath, StaticModel* _model);
+    //Points the passed skinned model to the (cached) skinned model asset of the filepath
+    //_keepCpuData keeps the vertices in RAM after the upload, for collision or baking (see Mesh::HasCpuData)
+    static void GetSkinnedModel(const std::string& _filepath, SkinnedModel* _model, bool _keepCpuData = false);
+    //Loads the static model from the filepath to the passed static model, which gets its own copy of the meshes
+    static void GetStaticModel(const std::string& _filepath, StaticModel* _model, bool _keepCpuData = false);
+    //gets a counted handle to the static model of the filepath, loaded once for all its handles and freed with the last one
+    static Handle<StaticModel> LoadStaticModel(const std::string& _filepath, bool _keepCpuData = false);
+    //gets a counted handle to the skinned model asset of the filepath, shared with the skinned models pointing to it
+    static Handle<SkeletonAsset> LoadSkinnedAsset(const std::string& _filepath, bool _keepCpuData = false);
 
+    //loads every asset of the manifest (and its dependencies) into _assets before a screen starts, so nothing loads on first use
+    //the sounds go to the cache of _audio, without one they're skipped
+    static void Preload(const AssetManifest& _manifest, PreloadedAssets& _assets, AudioEngine* _audio = nullptr);
+    //reads the manifest file (see AssetManifest), resolves the textures of its models and preloads all of it. False if the file failed
+    static bool Preload(const std::string& _manifestPath, PreloadedAssets& _assets, AudioEngine* _audio = nullptr);
+
+    //lets go of the cached assets, the ones handles still refer to are freed with their last handle
     static void Clear();
   private:
     //the cache
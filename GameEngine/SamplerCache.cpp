@@ -0,0 +1,80 @@
+#include "SamplerCache.h"
+#include "RenderState.h"
+
+#include <algorithm>
+
+namespace GameEngine
+{
+  SamplerCache& SamplerCache::Get()
+  {
+    //GL is used from the main thread only, like the RenderState
+    static SamplerCache cache;
+    return cache;
+  }
+
+  GLuint SamplerCache::GetSampler(const SamplerDesc& _desc)
+  {
+    auto it = std::find(m_descs.begin(), m_descs.end(), _desc);
+    if (it != m_descs.end())
+    {
+      return m_samplers[it - m_descs.begin()];
+    }
+
+    GLuint sampler = 0;
+    glGenSamplers(1, &sampler);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, _desc.wrap);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, _desc.wrap);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, _desc.wrap);
+    glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, _desc.minFilter);
+    glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, _desc.magFilter);
+    if (_desc.anisotropic)
+    {
+      ApplyAnisotropy(sampler);
+    }
+    m_descs.push_back(_desc);
+    m_samplers.push_back(sampler);
+    return sampler;
+  }
+
+  GLuint SamplerCache::GetTextureSampler(bool _alpha)
+  {
+    SamplerDesc desc;
+    desc.wrap = _alpha ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+    return GetSampler(desc);
+  }
+
+  void SamplerCache::SetMaxAnisotropy(float _anisotropy)
+  {
+    float supported = 1.0f;
+    if (GLEW_EXT_texture_filter_anisotropic)
+    {
+      glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &supported);
+    }
+    m_anisotropy = std::min(std::max(_anisotropy, 1.0f), supported);
+    for (size_t i = 0; i < m_samplers.size(); i++)
+    {
+      if (m_descs[i].anisotropic)
+      {
+        ApplyAnisotropy(m_samplers[i]);
+      }
+    }
+  }
+
+  void SamplerCache::Dispose()
+  {
+    if (!m_samplers.empty())
+    {
+      RenderState::Get().DeleteSamplers(static_cast<GLsizei>(m_samplers.size()), m_samplers.data());
+    }
+    m_samplers.clear();
+    m_descs.clear();
+  }
+
+  void SamplerCache::ApplyAnisotropy(GLuint _sampler) const
+  {
+    if (GLEW_EXT_texture_filter_anisotropic)
+    {
+      glSamplerParameterf(_sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, m_anisotropy);
+    }
+  }
+}
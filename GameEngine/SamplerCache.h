@@ -0,0 +1,51 @@
+#pragma once
+
+#include <GL\glew.h>
+#include <vector>
+
+namespace GameEngine
+{
+  /** \brief How a sampler filters and wraps */
+  struct SamplerDesc
+  {
+    GLenum wrap{ GL_REPEAT };
+    GLenum minFilter{ GL_LINEAR_MIPMAP_LINEAR };
+    GLenum magFilter{ GL_LINEAR };
+    bool anisotropic{ true }; ///< uses the global anisotropy (see SamplerCache::SetMaxAnisotropy)
+
+    bool operator==(const SamplerDesc& _other) const
+    {
+      return wrap == _other.wrap && minFilter == _other.minFilter && magFilter == _other.magFilter && anisotropic == _other.anisotropic;
+    }
+  };
+
+  /** \brief The sampler objects the textures share, one per SamplerDesc. A texture keeps its sampler in GLTexture::sampler and is bound
+  * with it (see RenderState::BindTexture), so the filtering of every texture changes in one place, e.g. the anisotropy as a quality
+  * setting. The textures still carry the same parameters themselves, for the code which binds a bare id and sampler 0 */
+  class SamplerCache
+  {
+  public:
+    static SamplerCache& Get();
+
+    /** \brief The sampler of _desc, created on the first request */
+    GLuint GetSampler(const SamplerDesc& _desc);
+    /** \brief The sampler of the loaded textures: trilinear, clamped to the edge with alpha and repeated without (like ImageLoader) */
+    GLuint GetTextureSampler(bool _alpha);
+
+    /** \brief Sets the anisotropy of all the anisotropic samplers, 1 turns it off. Clamped to what the GPU supports */
+    void SetMaxAnisotropy(float _anisotropy);
+    float GetMaxAnisotropy() const noexcept { return m_anisotropy; }
+
+    /** \brief Deletes the samplers, while the GL context still exists */
+    void Dispose();
+
+  private:
+    SamplerCache() {}
+
+    void ApplyAnisotropy(GLuint _sampler) const;
+
+    std::vector<SamplerDesc> m_descs; ///< a handful at most, searched linearly
+    std::vector<GLuint> m_samplers;
+    float m_anisotropy{ 1.0f };
+  };
+}
@@ -52,8 +52,7 @@ namespace GameEngine
   {
     //set its screen index
     _newScreen->m_screenIndex = m_screens.size();
-    //do the custom build function
-    _newScreen->Build();
+    //the custom build function waits until the screen is first entered (see GetCurrent), a screen never entered is never built
     //set the parent game
     _newScreen->SetParentGame(m_game);
 				//push it bck to the vector of screens
@@ -65,8 +64,12 @@ namespace GameEngine
   {
     for (size_t i = 0; i < m_screens.size(); i++)
     {
-      //call every screens destrou function
-      m_screens.at(i)->Destroy();
+      //call every built screens destroy function
+      if (m_screens.at(i)->m_isBuilt)
+      {
+        m_screens.at(i)->Destroy();
+        m_screens.at(i)->m_isBuilt = false;
+      }
     }
     //resize the screens vector to 0 and make the current screen index to no screen
     m_screens.resize(0);
@@ -77,7 +80,14 @@ namespace GameEngine
   {
     //check if the current screen isn't SCREEN_INDEX_NO_SCREEN and if not, return the current screen index
     if (m_currentScreenIndex == SCREEN_INDEX_NO_SCREEN) return nullptr;
-    return m_screens[m_currentScreenIndex];
+    const std::shared_ptr<IGameScreen>& screen = m_screens[m_currentScreenIndex];
+    //do the custom build function the first time the screen is about to be entered
+    if (!screen->m_isBuilt)
+    {
+      screen->Build();
+      screen->m_isBuilt = true;
+    }
+    return screen;
   }
 }
 
@@ -1,4 +1,6 @@
 #include "ScreenQuad.h"
+#include "FrameStats.h"
+#include "RenderState.h"
 namespace GameEngine
 {
   ScreenQuad::ScreenQuad()
@@ -38,7 +40,7 @@ namespace GameEngine
        1.0f, 1.0f,  1.0f, 1.0f
     };
 
-    glBindVertexArray(m_VAO);
+    RenderState::Get().BindVertexArray(m_VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
 
@@ -53,14 +55,14 @@ namespace GameEngine
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid*)(2 * sizeof(GLfloat)));
 
-    glBindVertexArray(0);
+    RenderState::Get().BindVertexArray(0);
   }
   void ScreenQuad::Dispose()
   {
     //delete the vao's and vbo's and reset them to 0
     if (m_VAO != 0)
     {
-      glDeleteVertexArrays(1, &m_VAO);
+      RenderState::Get().DeleteVertexArrays(1, &m_VAO);
       m_VAO = 0;
     }
 
@@ -78,12 +80,13 @@ namespace GameEngine
   }
   void ScreenQuad::Render(GLuint _textureID)
   {
-    glBindVertexArray(m_VAO);
+    RenderState::Get().BindVertexArray(m_VAO);
 
     /*glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, _textureID);*/
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, _textureID);*/
+    FrameStats::Get().Add(STAT_DRAW_CALLS);
     glDrawArrays(GL_TRIANGLES, 0, 6);
 
-    glBindVertexArray(0);
+    RenderState::Get().BindVertexArray(0);
   }
 }
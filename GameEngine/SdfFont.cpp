@@ -0,0 +1,314 @@
+#include "SdfFont.h"
+#include "SpriteBatch.h"
+#include "RenderState.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace GameEngine
+{
+  namespace
+  {
+    //the vertices of SpriteBatch
+    const char* SDF_VERT_SRC = R"(#version 330 core
+layout (location = 0) in vec2 vertexPosition;
+layout (location = 1) in vec4 vertexColor;
+layout (location = 2) in vec2 vertexUV;
+
+out vec4 fragmentColor;
+out vec2 fragmentUV;
+
+uniform mat4 P;
+
+void main()
+{
+    gl_Position = vec4((P * vec4(vertexPosition, 0.0, 1.0)).xy, 0.0, 1.0);
+    fragmentColor = vertexColor;
+    //the atlas rows go up already
+    fragmentUV = vertexUV;
+})";
+
+    const char* SDF_FRAG_SRC = R"(#version 330 core
+in vec4 fragmentColor;
+in vec2 fragmentUV;
+
+out vec4 color;
+
+uniform sampler2D distanceField;
+
+void main()
+{
+    //0.5 is the outline, the edge is smoothed over about a pixel of the screen whatever the size of the text
+    float distance = texture(distanceField, fragmentUV).r;
+    float width = max(fwidth(distance) * 0.7, 0.0001);
+    color = vec4(fragmentColor.rgb, fragmentColor.a * smoothstep(0.5 - width, 0.5 + width, distance));
+})";
+
+    const std::uint32_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+    //decodes the code point _text starts with and moves past it, a broken sequence is one replacement character a byte
+    std::uint32_t NextCodePoint(const char*& _text)
+    {
+      const unsigned char lead = static_cast<unsigned char>(*_text++);
+      if (lead < 0x80)
+      {
+        return lead;
+      }
+      int numContinuations = 0;
+      std::uint32_t codePoint = 0;
+      if ((lead & 0xE0) == 0xC0)
+      {
+        numContinuations = 1;
+        codePoint = lead & 0x1F;
+      }
+      else if ((lead & 0xF0) == 0xE0)
+      {
+        numContinuations = 2;
+        codePoint = lead & 0x0F;
+      }
+      else if ((lead & 0xF8) == 0xF0)
+      {
+        numContinuations = 3;
+        codePoint = lead & 0x07;
+      }
+      else
+      {
+        return REPLACEMENT_CHARACTER;
+      }
+      for (int i = 0; i < numContinuations; i++)
+      {
+        const unsigned char next = static_cast<unsigned char>(_text[i]);
+        if ((next & 0xC0) != 0x80)
+        {
+          return REPLACEMENT_CHARACTER;
+        }
+        codePoint = (codePoint << 6) | (next & 0x3F);
+      }
+      _text += numContinuations;
+      return codePoint;
+    }
+  }
+
+  bool SdfFont::Init(const char* _fontPath, int _rasterSize /* = 32 */)
+  {
+    if (!TTF_WasInit())
+    {
+      TTF_Init();
+    }
+    //from the mapped file (or pack), it stays open with the font since the glyphs are rasterized when they're first drawn
+    m_font = m_file.Open(_fontPath) ? TTF_OpenFontRW(SDL_RWFromConstMem(m_file.GetData(), static_cast<int>(m_file.GetSize())), 1, _rasterSize) : nullptr;
+    if (m_font == nullptr)
+    {
+      std::cout << "ERROR::SDF_FONT::Failed to open the font " << _fontPath << std::endl;
+      m_file.Close();
+      return false;
+    }
+    m_fontHeight = TTF_FontHeight(m_font);
+
+    //cleared, the filtering of a cell reads the gap around it
+    const std::vector<unsigned char> empty(SDF_ATLAS_SIZE * SDF_ATLAS_SIZE, 0);
+    glGenTextures(1, &m_texture);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, m_texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, SDF_ATLAS_SIZE, SDF_ATLAS_SIZE, 0, GL_RED, GL_UNSIGNED_BYTE, empty.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+    m_shelfX = 1;
+    m_shelfY = 1;
+    m_shelfHeight = 0;
+    m_atlasFull = false;
+
+    //a blank space, the corner texel of the atlas is never written
+    m_missingGlyph.uvRect = glm::vec4(0.0f);
+    m_missingGlyph.size = glm::vec2(m_fontHeight / 2 + 2 * SDF_SPREAD, m_fontHeight + 2 * SDF_SPREAD);
+    m_missingGlyph.advance = m_fontHeight / 2.0f;
+
+    m_program.CompileShadersFromSource(SDF_VERT_SRC, SDF_FRAG_SRC);
+    m_projectionUniform = m_program.GetUniformLocation("P");
+    m_program.Use();
+    glUniform1i(m_program.GetUniformLocation("distanceField"), 0);
+    m_program.UnUse();
+    return true;
+  }
+
+  void SdfFont::Dispose()
+  {
+    if (m_font)
+    {
+      TTF_CloseFont(m_font);
+      m_font = nullptr;
+    }
+    m_file.Close();
+    if (m_texture)
+    {
+      RenderState::Get().DeleteTextures(1, &m_texture);
+      m_texture = 0;
+    }
+    m_program.Dispose();
+    m_glyphs.clear();
+  }
+
+  template <typename Emit>
+  glm::vec2 SdfFont::Layout(const char* _text, glm::vec2 _position, float _lineHeight, Justification _just, Emit _emit)
+  {
+    if (_just == Justification::MIDDLE)
+    {
+      _position.x -= Measure(_text, _lineHeight).x / 2;
+    }
+    else if (_just == Justification::RIGHT)
+    {
+      _position.x -= Measure(_text, _lineHeight).x;
+    }
+    const float scale = _lineHeight / m_fontHeight;
+    glm::vec2 size(0.0f, _lineHeight);
+    glm::vec2 pen = _position;
+    while (*_text != 0)
+    {
+      const std::uint32_t codePoint = NextCodePoint(_text);
+      if (codePoint == '\n')
+      {
+        size.x = std::max(size.x, pen.x - _position.x);
+        size.y += _lineHeight;
+        pen = glm::vec2(_position.x, pen.y - _lineHeight);
+        continue;
+      }
+      const SdfGlyph& glyph = GetGlyph(codePoint);
+      //a space only advances
+      if (codePoint != ' ')
+      {
+        _emit(glm::vec4(pen - glm::vec2(SDF_SPREAD * scale), glyph.size * scale), glyph);
+      }
+      pen.x += glyph.advance * scale;
+    }
+    size.x = std::max(size.x, pen.x - _position.x);
+    return size;
+  }
+
+  glm::vec2 SdfFont::Measure(const char* _text, float _lineHeight)
+  {
+    return Layout(_text, glm::vec2(0.0f), _lineHeight, Justification::LEFT, [](const glm::vec4&, const SdfGlyph&) {});
+  }
+
+  glm::vec2 SdfFont::Draw(GlyphRecorder& _batch, const char* _text, const glm::vec2& _position, float _lineHeight, float _depth,
+    const ColorRGBA8& _tint, Justification _just /* = Justification::LEFT */)
+  {
+    return Layout(_text, _position, _lineHeight, _just, [&](const glm::vec4& _destRect, const SdfGlyph& _glyph)
+    {
+      _batch.Draw(_destRect, _glyph.uvRect, m_texture, _depth, _tint);
+    });
+  }
+
+  void SdfFont::Use(const glm::mat4& _projection)
+  {
+    m_program.Use();
+    glUniformMatrix4fv(m_projectionUniform, 1, GL_FALSE, &_projection[0][0]);
+  }
+
+  const SdfFont::SdfGlyph& SdfFont::GetGlyph(std::uint32_t _codePoint)
+  {
+    auto it = m_glyphs.find(_codePoint);
+    if (it != m_glyphs.end())
+    {
+      return it->second;
+    }
+    //SDL_ttf only renders the basic multilingual plane
+    if (_codePoint > 0xFFFF || !TTF_GlyphIsProvided(m_font, static_cast<Uint16>(_codePoint)))
+    {
+      return _codePoint != '?' ? GetGlyph('?') : m_missingGlyph;
+    }
+    SdfGlyph glyph;
+    if (!AddGlyph(static_cast<std::uint16_t>(_codePoint), glyph))
+    {
+      return m_missingGlyph;
+    }
+    //the map keeps its nodes where they are, the reference stays valid as more glyphs are added
+    return m_glyphs.emplace(_codePoint, glyph).first->second;
+  }
+
+  bool SdfFont::AddGlyph(std::uint16_t _codePoint, SdfGlyph& _glyph)
+  {
+    if (m_atlasFull)
+    {
+      return false;
+    }
+    SDL_Color fg = { 255, 255, 255, 255 };
+    SDL_Surface* surface = TTF_RenderGlyph_Blended(m_font, _codePoint, fg);
+    if (surface == nullptr)
+    {
+      return false;
+    }
+    const int width = surface->w + 2 * SDF_SPREAD;
+    const int height = surface->h + 2 * SDF_SPREAD;
+    //a texel between the cells, so the filtering of one doesn't read its neighbour
+    if (m_shelfX + width + 1 > SDF_ATLAS_SIZE)
+    {
+      m_shelfX = 1;
+      m_shelfY += m_shelfHeight + 1;
+      m_shelfHeight = 0;
+    }
+    if (m_shelfX + width + 1 > SDF_ATLAS_SIZE || m_shelfY + height + 1 > SDF_ATLAS_SIZE)
+    {
+      std::cout << "ERROR::SDF_FONT::The atlas is full, the glyphs which aren't in it yet are left blank" << std::endl;
+      m_atlasFull = true;
+      SDL_FreeSurface(surface);
+      return false;
+    }
+
+    //the glyph is inside where its coverage is over a half (the alpha of the blended ARGB pixels)
+    std::vector<unsigned char> inside(width * height, 0);
+    const unsigned char* pixels = static_cast<const unsigned char*>(surface->pixels);
+    for (int y = 0; y < surface->h; y++)
+    {
+      for (int x = 0; x < surface->w; x++)
+      {
+        inside[(y + SDF_SPREAD) * width + x + SDF_SPREAD] = pixels[y * surface->pitch + x * 4 + 3] >= 128;
+      }
+    }
+    SDL_FreeSurface(surface);
+
+    //the distance to the closest texel on the other side of the outline, searched within the spread. The rows are flipped so the
+    //cell goes up like the quads
+    m_distances.resize(width * height);
+    for (int y = 0; y < height; y++)
+    {
+      for (int x = 0; x < width; x++)
+      {
+        const unsigned char side = inside[y * width + x];
+        int closest = (SDF_SPREAD + 1) * (SDF_SPREAD + 1);
+        for (int dy = std::max(-SDF_SPREAD, -y); dy <= SDF_SPREAD && y + dy < height; dy++)
+        {
+          for (int dx = std::max(-SDF_SPREAD, -x); dx <= SDF_SPREAD && x + dx < width; dx++)
+          {
+            if (inside[(y + dy) * width + x + dx] != side)
+            {
+              closest = std::min(closest, dx * dx + dy * dy);
+            }
+          }
+        }
+        //half a texel to the outline between the two texels, 0.5 in the field
+        const float distance = std::min(std::sqrt(static_cast<float>(closest)), static_cast<float>(SDF_SPREAD)) - 0.5f;
+        const float field = 0.5f + (side ? distance : -distance) / (2.0f * SDF_SPREAD);
+        m_distances[(height - 1 - y) * width + x] = static_cast<unsigned char>(std::min(std::max(field, 0.0f), 1.0f) * 255.0f + 0.5f);
+      }
+    }
+
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, m_texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, m_shelfX, m_shelfY, width, height, GL_RED, GL_UNSIGNED_BYTE, m_distances.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+
+    _glyph.uvRect = glm::vec4(m_shelfX, m_shelfY, width, height) / static_cast<float>(SDF_ATLAS_SIZE);
+    _glyph.size = glm::vec2(width, height);
+    //the surface is as wide as the glyph advances, like the cells of SpriteFont
+    _glyph.advance = static_cast<float>(width - 2 * SDF_SPREAD);
+    m_shelfX += width + 1;
+    m_shelfHeight = std::max(m_shelfHeight, height);
+    return true;
+  }
+}
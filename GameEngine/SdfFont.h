@@ -0,0 +1,85 @@
+#pragma once
+#include <TTF/SDL_ttf.h>
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "GLSLProgram.h"
+#include "IOManager.h"
+#include "SpriteFont.h"
+#include "Vertex.h"
+
+namespace GameEngine
+{
+  class GlyphRecorder;
+
+  //the width and height of the distance field atlas
+  constexpr int SDF_ATLAS_SIZE{ 1024 };
+  //the pixels the distance field reaches around the outline of a glyph, the range a glyph can be outlined or softened in
+  constexpr int SDF_SPREAD{ 4 };
+
+  /** \brief A font drawn from signed distance fields, so one texture renders it sharp at any size (a SpriteFont is one size and
+   *  range of characters a texture). The glyphs are rasterized and added to the atlas the first time they're drawn, the font only
+   *  costs the characters a game shows, and any UTF-8 text of the basic multilingual plane can be drawn.
+   *  The glyphs go through a SpriteBatch, which has to be rendered with the program of the font (see Use) */
+  class SdfFont
+  {
+  public:
+    /** \brief Opens the font and creates the empty atlas and the program
+     *  \param _rasterSize the point size the glyphs are rasterized at, bigger is sharper corners but fewer glyphs fit the atlas */
+    bool Init(const char* _fontPath, int _rasterSize = 32);
+    // Closes the font, deletes the atlas and the program
+    void Dispose();
+
+    // The size of the text drawn with lines _lineHeight high
+    glm::vec2 Measure(const char* _text, float _lineHeight);
+    /** \brief Draws the UTF-8 text from the bottom left of its first line, the next lines go down
+     *  \return the size of the text */
+    glm::vec2 Draw(GlyphRecorder& _batch, const char* _text, const glm::vec2& _position, float _lineHeight, float _depth,
+      const ColorRGBA8& _tint, Justification _just = Justification::LEFT);
+
+    // Uses the program which renders the batches of the font, with the projection of the camera
+    void Use(const glm::mat4& _projection);
+    void UnUse() { m_program.UnUse(); }
+
+    // Getters
+    GLuint GetTexture() const { return m_texture; }
+    size_t GetNumGlyphs() const { return m_glyphs.size(); }
+
+  private:
+    struct SdfGlyph
+    {
+      glm::vec4 uvRect;  ///< the cell in the atlas, the field around the glyph included
+      glm::vec2 size;    ///< the cell in raster pixels
+      float advance{ 0.0f };
+    };
+
+    // The glyph of the code point, rasterized into the atlas the first time it's asked for
+    const SdfGlyph& GetGlyph(std::uint32_t _codePoint);
+    // Rasterizes the glyph, turns it into a distance field and copies it into the next free spot of the atlas
+    bool AddGlyph(std::uint16_t _codePoint, SdfGlyph& _glyph);
+    // Lays the text out, calls _emit with the dest rect and the glyph of every visible character
+    template <typename Emit>
+    glm::vec2 Layout(const char* _text, glm::vec2 _position, float _lineHeight, Justification _just, Emit _emit);
+
+    MappedFile m_file;           ///< the font file, SDL_ttf reads from it until the font is closed
+    TTF_Font* m_font{ nullptr };
+    int m_fontHeight{ 0 };
+
+    std::unordered_map<std::uint32_t, SdfGlyph> m_glyphs;
+    SdfGlyph m_missingGlyph;     ///< a blank space for the characters which don't fit the atlas anymore
+    std::vector<unsigned char> m_distances; ///< scratch for the field of a glyph
+
+    //the atlas is filled shelf by shelf, left to right
+    GLuint m_texture{ 0 };
+    int m_shelfX{ 0 };
+    int m_shelfY{ 0 };
+    int m_shelfHeight{ 0 };
+    bool m_atlasFull{ false };
+
+    GLSLProgram m_program;
+    GLint m_projectionUniform{ -1 };
+  };
+}
@@ -0,0 +1,99 @@
+#include "ShaderVariants.h"
+
+#include "GameEngineErrors.h"
+#include "MaterialBindings.h"
+
+namespace GameEngine
+{
+  void ShaderVariants::Init(const std::string& _vsFilePath, const std::string& _fsFilePath, const std::vector<std::string>& _features,
+    const std::string& _gsFilePath)
+  {
+    if (_features.size() > MAX_FEATURES)
+    {
+      FatalError("ShaderVariants: more than 32 features in " + _fsFilePath);
+    }
+    Dispose();
+    m_vsFilePath = _vsFilePath;
+    m_fsFilePath = _fsFilePath;
+    m_gsFilePath = _gsFilePath;
+    m_features = _features;
+  }
+
+  void ShaderVariants::Dispose()
+  {
+    for (auto& variant : m_variants)
+    {
+      variant.second->Dispose();
+    }
+    m_variants.clear();
+    m_textureFeatures.clear();
+  }
+
+  GLSLProgram& ShaderVariants::Get(Features _features)
+  {
+    auto it = m_variants.find(_features);
+    if (it != m_variants.end())
+    {
+      return *it->second;
+    }
+    std::vector<std::string> defines;
+    for (size_t i = 0; i < m_features.size(); i++)
+    {
+      if (_features & (Features(1) << i))
+      {
+        defines.push_back(m_features[i]);
+      }
+    }
+    std::unique_ptr<GLSLProgram> program(new GLSLProgram());
+    program->SetDefines(defines);
+    program->CompileShaders(m_vsFilePath, m_fsFilePath, m_gsFilePath);
+    GLSLProgram& result = *program;
+    m_variants.emplace(_features, std::move(program));
+    return result;
+  }
+
+  void ShaderVariants::Preload(const std::vector<Features>& _variants)
+  {
+    for (Features features : _variants)
+    {
+      Get(features);
+    }
+  }
+
+  ShaderVariants::Features ShaderVariants::GetFeature(const std::string& _name) const
+  {
+    for (size_t i = 0; i < m_features.size(); i++)
+    {
+      if (m_features[i] == _name)
+      {
+        return Features(1) << i;
+      }
+    }
+    return 0;
+  }
+
+  void ShaderVariants::MapTexture(const std::string& _textureType, const std::string& _feature)
+  {
+    TextureFeature textureFeature;
+    //the textures carry their type interned, so the type is compared as an id
+    textureFeature.type = AssetIds::Intern(_textureType);
+    textureFeature.feature = GetFeature(_feature);
+    m_textureFeatures.push_back(textureFeature);
+  }
+
+  ShaderVariants::Features ShaderVariants::GetFeatures(const MaterialBindings& _material) const
+  {
+    Features features = 0;
+    for (const GLTexture& texture : _material.GetTextures())
+    {
+      for (const TextureFeature& textureFeature : m_textureFeatures)
+      {
+        if (textureFeature.type == texture.type)
+        {
+          features |= textureFeature.feature;
+        }
+      }
+    }
+    return features;
+  }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AssetId.h"
+#include "GLSLProgram.h"
+
+namespace GameEngine
+{
+  class MaterialBindings;
+
+  /** \brief The programs built from one shader source for the sets of features its materials use, instead of one program which branches
+  * on uniforms for all of them. The source tests the features with #ifdef (e.g. #ifdef NORMAL_MAP), every set of features is its own
+  * GLSLProgram with their macros defined (see GLSLProgram::SetDefines), so a material only runs the code it needs. A variant is compiled
+  * the first time it's asked for, through CompileShaders, so it's in the binary cache, compiles in parallel and hot reloads like any
+  * other program. The programs keep their addresses, the uniforms set on a variant stay with it */
+  class ShaderVariants
+  {
+  public:
+    //a bit per feature, in the order of Init
+    using Features = std::uint32_t;
+    static constexpr size_t MAX_FEATURES{ 32 };
+
+    ShaderVariants() {}
+    ~ShaderVariants() { Dispose(); }
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    /** \brief Sets the files of the shader and the macros of its features, nothing is compiled yet
+    * \param[in] _features The macro names, the first is bit 0 of the Features
+    */
+    void Init(const std::string& _vsFilePath, const std::string& _fsFilePath, const std::vector<std::string>& _features,
+      const std::string& _gsFilePath = "");
+    void Dispose();
+
+    /** \brief The program with the macros of _features defined, compiled if it wasn't asked for before */
+    GLSLProgram& Get(Features _features);
+    /** \brief Compiles the variants up front (e.g. during a loading screen), so the first frame that draws them doesn't */
+    void Preload(const std::vector<Features>& _variants);
+
+    /** \brief The bit of the feature with the macro _name, 0 if the shader has none */
+    Features GetFeature(const std::string& _name) const;
+    /** \brief A material with a texture of _textureType (e.g. texture_normal) needs the feature with the macro _feature */
+    void MapTexture(const std::string& _textureType, const std::string& _feature);
+    /** \brief The least features a material needs: those of the texture types it has (see MapTexture) */
+    Features GetFeatures(const MaterialBindings& _material) const;
+
+    size_t GetNumVariants() const noexcept { return m_variants.size(); }
+
+  private:
+    struct TextureFeature
+    {
+      AssetId type{ AssetIds::NONE };
+      Features feature{ 0 };
+    };
+
+    std::string m_vsFilePath;
+    std::string m_fsFilePath;
+    std::string m_gsFilePath;
+    std::vector<std::string> m_features;   ///< the macro names by bit
+    std::vector<TextureFeature> m_textureFeatures;
+    std::unordered_map<Features, std::unique_ptr<GLSLProgram>> m_variants;
+  };
+}
@@ -0,0 +1,200 @@
+#include "SkinningPrepass.h"
+#include "AnimationSystem.h"
+#include "FrameStats.h"
+#include "Model.h"
+#include "RenderState.h"
+
+#include <algorithm>
+
+namespace GameEngine
+{
+  namespace
+  {
+    //position, normal, uv and tangent as floats, the interleaved outputs of the skinning shader
+    constexpr GLsizei SKINNED_VERTEX_FLOATS = 3 + 3 + 2 + 3;
+    constexpr GLsizei SKINNED_VERTEX_STRIDE = SKINNED_VERTEX_FLOATS * sizeof(float);
+  }
+
+  //the attributes of an animated mesh (see Mesh::SetVertexAttributes), the unused bone slots are bone 0 with no weight
+  const char* SKINNING_PREPASS_VERT_SRC = R"(#version 330 core
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 uv;
+layout (location = 3) in vec3 tangent;
+layout (location = 4) in uvec4 boneIDs;
+layout (location = 5) in vec4 weights;
+
+//captured with transform feedback, SKINNED_VERTEX_FLOATS floats a vertex
+out vec3 skinnedPosition;
+out vec3 skinnedNormal;
+out vec2 skinnedUV;
+out vec3 skinnedTangent;
+
+const int MAX_BONES = 100;
+
+//the bone palette of the skinned model, its range of the buffer of all the models (see GameEngine::AnimationSystem)
+layout (std140) uniform BonePalette
+{
+	mat4 gBones[MAX_BONES];
+};
+
+void main()
+{
+	mat4 boneTransform = gBones[boneIDs.x] * weights.x + gBones[boneIDs.y] * weights.y + gBones[boneIDs.z] * weights.z + gBones[boneIDs.w] * weights.w;
+	skinnedPosition = vec3(boneTransform * vec4(position, 1.0));
+	skinnedNormal = normalize(mat3(boneTransform) * normal);
+	skinnedUV = uv;
+	skinnedTangent = normalize(mat3(boneTransform) * tangent);
+})";
+
+  //never runs, the skinning is drawn with GL_RASTERIZER_DISCARD
+  const char* SKINNING_PREPASS_FRAG_SRC = R"(#version 330 core
+out vec4 color;
+void main()
+{
+    color = vec4(0.0);
+})";
+
+  void SkinningPrepass::Init()
+  {
+    m_program.SetTransformFeedbackVaryings({ "skinnedPosition", "skinnedNormal", "skinnedUV", "skinnedTangent" });
+    m_program.CompileShadersFromSource(SKINNING_PREPASS_VERT_SRC, SKINNING_PREPASS_FRAG_SRC);
+  }
+
+  void SkinningPrepass::Dispose()
+  {
+    for (std::vector<SkinnedMesh>& meshes : m_models)
+    {
+      Release(meshes);
+    }
+    m_models.clear();
+    m_system = nullptr;
+    m_program.Dispose();
+  }
+
+  void SkinningPrepass::Skin(const AnimationSystem& _system)
+  {
+    m_system = &_system;
+    const std::vector<SkinnedModel*>& models = _system.GetModels();
+    //the models removed from the system let go of their buffers
+    for (std::size_t i = models.size(); i < m_models.size(); i++)
+    {
+      Release(m_models[i]);
+    }
+    m_models.resize(models.size());
+
+    m_program.Use();
+    glEnable(GL_RASTERIZER_DISCARD);
+    for (std::size_t i = 0; i < models.size(); i++)
+    {
+      const std::shared_ptr<const SkeletonAsset>& asset = models[i]->GetAsset();
+      if (!asset || !_system.BindPalette(i))
+      {
+        Release(m_models[i]);
+        continue;
+      }
+      Prepare(i, asset->GetMeshes());
+      for (const SkinnedMesh& skinned : m_models[i])
+      {
+        //one point per vertex from the VAO of the mesh, captured into the buffer of the model
+        RenderState::Get().BindVertexArray(skinned.mesh->GetVAO());
+        //plain buffer binding rather than transform feedback objects, which need GL 4.0
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, skinned.VBO);
+        glBeginTransformFeedback(GL_POINTS);
+        FrameStats::Get().Add(STAT_DRAW_CALLS);
+        glDrawArrays(GL_POINTS, 0, skinned.mesh->GetNumVertices());
+        glEndTransformFeedback();
+      }
+    }
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, AnimationSystem::BONE_PALETTE_BINDING, 0);
+    RenderState::Get().BindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+    m_program.UnUse();
+  }
+
+  void SkinningPrepass::Draw(GLSLProgram& _shader) const
+  {
+    for (std::size_t i = 0; i < m_models.size(); i++)
+    {
+      DrawModel(_shader, i, 0);
+    }
+  }
+
+  void SkinningPrepass::Draw(GLSLProgram& _shader, const Camera3D& _camera) const
+  {
+    for (std::size_t i = 0; i < m_models.size(); i++)
+    {
+      if (!m_models[i].empty())
+      {
+        DrawModel(_shader, i, m_system->GetModels()[i]->SelectLod(_camera));
+      }
+    }
+  }
+
+  void SkinningPrepass::Prepare(std::size_t _model, const std::vector<Mesh>& _meshes)
+  {
+    std::vector<SkinnedMesh>& skinnedMeshes = m_models[_model];
+    const bool same = skinnedMeshes.size() == _meshes.size() && std::equal(skinnedMeshes.begin(), skinnedMeshes.end(), _meshes.begin(),
+      [](const SkinnedMesh& _skinned, const Mesh& _mesh) { return _skinned.mesh == &_mesh; });
+    if (same)
+    {
+      return;
+    }
+    //the model got another asset
+    Release(skinnedMeshes);
+    skinnedMeshes.resize(_meshes.size());
+    for (std::size_t i = 0; i < _meshes.size(); i++)
+    {
+      SkinnedMesh& skinned = skinnedMeshes[i];
+      skinned.mesh = &_meshes[i];
+      glGenBuffers(1, &skinned.VBO);
+      glBindBuffer(GL_ARRAY_BUFFER, skinned.VBO);
+      glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(skinned.mesh->GetNumVertices()) * SKINNED_VERTEX_STRIDE, nullptr, GL_DYNAMIC_COPY);
+
+      //the attribute locations of a static mesh, from floats, with the indices of the mesh
+      glGenVertexArrays(1, &skinned.VAO);
+      RenderState::Get().BindVertexArray(skinned.VAO);
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, skinned.mesh->GetEBO());
+      const GLint sizes[4] = { 3, 3, 2, 3 };
+      size_t offset = 0;
+      for (GLuint attribute = 0; attribute < 4; attribute++)
+      {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribPointer(attribute, sizes[attribute], GL_FLOAT, GL_FALSE, SKINNED_VERTEX_STRIDE, (GLvoid*)offset);
+        offset += sizes[attribute] * sizeof(float);
+      }
+      RenderState::Get().BindVertexArray(0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  void SkinningPrepass::Release(std::vector<SkinnedMesh>& _meshes)
+  {
+    for (SkinnedMesh& skinned : _meshes)
+    {
+      RenderState::Get().DeleteVertexArrays(1, &skinned.VAO);
+      glDeleteBuffers(1, &skinned.VBO);
+    }
+    _meshes.clear();
+  }
+
+  void SkinningPrepass::DrawModel(GLSLProgram& _shader, std::size_t _model, GLuint _lod) const
+  {
+    if (m_models[_model].empty())
+    {
+      return;
+    }
+    _shader.UploadValue("transformMatrix", m_system->GetModels()[_model]->GetModelMatrix());
+    for (const SkinnedMesh& skinned : m_models[_model])
+    {
+      const Mesh& mesh = *skinned.mesh;
+      const Mesh::Lod& lod = mesh.GetLods()[std::min(_lod, mesh.GetNumLods() - 1)];
+      mesh.GetMaterial().Bind(_shader);
+      _shader.UploadValue("baseModelMatrix", mesh.GetBaseModelMatrix());
+      RenderState::Get().BindVertexArray(skinned.VAO);
+      FrameStats::Get().Add(STAT_DRAW_CALLS);
+      glDrawElements(GL_TRIANGLES, lod.m_numIndices, GL_UNSIGNED_INT, (GLvoid*)(lod.m_firstIndex * sizeof(GLuint)));
+    }
+  }
+}
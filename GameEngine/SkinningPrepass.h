@@ -0,0 +1,58 @@
+#pragma once
+
+#include <GL\glew.h>
+#include <vector>
+
+#include "GLSLProgram.h"
+
+namespace GameEngine
+{
+  class AnimationSystem;
+  class Camera3D;
+  class Mesh;
+
+  /** \brief Skins the models of an AnimationSystem once a frame into vertex buffers of their own, so the passes after it (the faces of a
+  * shadow cubemap, a depth prepass, the lit pass) draw the characters as static meshes instead of skinning every vertex again in each.
+  * A vertex shader reads the palettes the system uploaded and the mesh as it is, and transform feedback captures the skinned vertices
+  * (no rasterization). The skinned vertices are still before the baseModelMatrix and the model matrix, so the static shaders
+  * (transformMatrix and baseModelMatrix, not instanced) draw them unchanged. Every model has its own buffers, a model sharing its
+  * meshes with others still has its own pose */
+  class SkinningPrepass
+  {
+  public:
+    SkinningPrepass() {}
+    ~SkinningPrepass() { Dispose(); }
+    SkinningPrepass(const SkinningPrepass&) = delete;
+    SkinningPrepass& operator=(const SkinningPrepass&) = delete;
+
+    /** \brief Compiles the skinning shader */
+    void Init();
+    void Dispose();
+
+    /** \brief Skins every model of _system with the pose its Update uploaded, all of the vertices (the LODs only index fewer of them) */
+    void Skin(const AnimationSystem& _system);
+
+    /** \brief Draws the skinned models of the last Skin with _shader, at LOD 0 */
+    void Draw(GLSLProgram& _shader) const;
+    /** \brief Same as Draw, every model at the LOD for its size on the screen of _camera (see SkinnedModel::SetLodScreenSize) */
+    void Draw(GLSLProgram& _shader, const Camera3D& _camera) const;
+
+  private:
+    /** \brief The skinned vertices of a mesh of a model and the VAO drawing them with the indices of the mesh */
+    struct SkinnedMesh
+    {
+      const Mesh* mesh{ nullptr };
+      GLuint VAO{ 0 };
+      GLuint VBO{ 0 };
+    };
+
+    /** \brief Makes the buffers of model _model for its meshes, unless it has them */
+    void Prepare(std::size_t _model, const std::vector<Mesh>& _meshes);
+    void Release(std::vector<SkinnedMesh>& _meshes);
+    void DrawModel(GLSLProgram& _shader, std::size_t _model, GLuint _lod) const;
+
+    GLSLProgram m_program;
+    const AnimationSystem* m_system{ nullptr }; ///< of the last Skin
+    std::vector<std::vector<SkinnedMesh>> m_models; ///< by the index of the model in the system
+  };
+}
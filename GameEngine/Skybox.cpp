@@ -19,22 +19,13 @@ namespace GameEngine
     m_shader = std::move(_shader);
     m_camera = _camera;
 
-    m_model = std::make_unique<StaticModel>();
-
-    if (_isSphere)
-    {
-      ResourceManager::GetStaticModel("Assets/Sphere/sphere.obj", m_model.get());
-    }
-    else
-    {
-      ResourceManager::GetStaticModel("Assets/Box/box2.obj", m_model.get());
-    }
+    m_model = ResourceManager::LoadStaticModel(_isSphere ? "Assets/Sphere/sphere.obj" : "Assets/Box/box2.obj");
   }
 
   void Skybox::Dispose()
   {
-    //delete the vao's and vbo's and reset them to 0
-    m_model->Dispose();
+    //the model is freed once no one else uses it either
+    m_model.Reset();
   }
 
   void Skybox::Render()
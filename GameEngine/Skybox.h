@@ -5,6 +5,7 @@
 #include "GLSLProgram.h"
 #include "Camera3D.h"
 #include "Model.h"
+#include "AssetHandle.h"
 
 namespace GameEngine
 {
@@ -32,7 +33,7 @@ namespace GameEngine
   private:
     std::unique_ptr<GLCubemap> m_cubemap;
     std::unique_ptr<GLSLProgram> m_shader;
-    std::unique_ptr<StaticModel> m_model;
+    Handle<StaticModel> m_model; ///< shared with everything else drawing the same file
     std::weak_ptr<Camera3D> m_camera;
   };
 }
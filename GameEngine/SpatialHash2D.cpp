@@ -0,0 +1,66 @@
+#include "SpatialHash2D.h"
+
+#include <cmath>
+
+namespace GameEngine
+{
+  SpatialHash2D::SpatialHash2D(float _cellSize) : m_cellSize(_cellSize)
+  {
+    Clear(0);
+  }
+
+  SpatialHash2D::~SpatialHash2D()
+  {
+  }
+
+  void SpatialHash2D::Clear(size_t _expectedCount)
+  {
+    //about two buckets per object keeps the chains short
+    size_t numBuckets = 16;
+    while (numBuckets < _expectedCount * 2)
+    {
+      numBuckets *= 2;
+    }
+    m_buckets.assign(numBuckets, NO_ENTRY);
+    m_entries.clear();
+    m_entries.reserve(_expectedCount);
+  }
+
+  void SpatialHash2D::Insert(int _id, const glm::vec2& _position)
+  {
+    Entry entry;
+    entry.m_cell = GetCell(_position);
+    entry.m_id = _id;
+    const size_t bucket = GetBucket(entry.m_cell);
+    entry.m_next = m_buckets[bucket];
+    m_buckets[bucket] = static_cast<int>(m_entries.size());
+    m_entries.push_back(entry);
+  }
+
+  void SpatialHash2D::Query(const glm::vec2& _center, float _radius, std::vector<int>& _ids) const
+  {
+    _ids.clear();
+    const glm::ivec2 first = GetCell(_center - glm::vec2(_radius));
+    const glm::ivec2 last = GetCell(_center + glm::vec2(_radius));
+    for (int y = first.y; y <= last.y; y++)
+    {
+      for (int x = first.x; x <= last.x; x++)
+      {
+        const glm::ivec2 cell(x, y);
+        for (int entry = m_buckets[GetBucket(cell)]; entry != NO_ENTRY; entry = m_entries[entry].m_next)
+        {
+          if (m_entries[entry].m_cell == cell)
+          {
+            _ids.push_back(m_entries[entry].m_id);
+          }
+        }
+      }
+    }
+  }
+
+  glm::ivec2 SpatialHash2D::GetCell(const glm::vec2& _position) const
+  {
+    //floor, so the cells left of and below the origin don't share cell 0
+    return glm::ivec2(static_cast<int>(std::floor(_position.x / m_cellSize)), static_cast<int>(std::floor(_position.y / m_cellSize)));
+  }
+}
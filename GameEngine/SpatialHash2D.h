@@ -0,0 +1,87 @@
+#pragma once
+#include <glm\glm.hpp>
+#include <vector>
+
+namespace GameEngine
+{
+  /** \brief A uniform grid broadphase for 2D objects, hashed so the world doesn't need bounds.
+  * The objects are inserted with a point (e.g. their center) every frame, and only the ones in the same or in adjacent cells are
+  * reported as pairs, so with a cell size of at least the largest object diameter every overlapping pair is found in linear time.
+  * The chains of the cells are kept in flat arrays which are reused, so a rebuild doesn't allocate once they have grown */
+  class SpatialHash2D
+  {
+  public:
+    /** \brief \param _cellSize - the width and height of a cell (at least the largest diameter of the objects) */
+    SpatialHash2D(float _cellSize = 32.0f);
+    ~SpatialHash2D();
+
+    /** \brief Removes all the objects and makes room for _expectedCount of them (the number of buckets follows it) */
+    void Clear(size_t _expectedCount);
+
+    /** \brief Adds an object
+    * \param _id - the id reported by the queries (e.g. the index of the object in its container)
+    * \param _position - the point the cell is taken from
+    */
+    void Insert(int _id, const glm::vec2& _position);
+
+    /** \brief Calls _function(idA, idB) once for every pair of objects in the same or in adjacent cells, in insertion order */
+    template <class Function>
+    void ForEachPair(Function _function) const
+    {
+      //the own cell and the 4 neighbors ahead of it, so every pair of neighboring cells is visited once
+      const glm::ivec2 offsets[4] = { glm::ivec2(1, 0), glm::ivec2(-1, 1), glm::ivec2(0, 1), glm::ivec2(1, 1) };
+      for (size_t entry = 0; entry < m_entries.size(); entry++)
+      {
+        const Entry& current = m_entries[entry];
+        //the entries after this one in the own cell (the chains run from the newest to the oldest)
+        for (int other = m_buckets[GetBucket(current.m_cell)]; other != NO_ENTRY; other = m_entries[other].m_next)
+        {
+          if (static_cast<size_t>(other) > entry && m_entries[other].m_cell == current.m_cell)
+          {
+            _function(current.m_id, m_entries[other].m_id);
+          }
+        }
+        for (const glm::ivec2& offset : offsets)
+        {
+          const glm::ivec2 cell = current.m_cell + offset;
+          for (int other = m_buckets[GetBucket(cell)]; other != NO_ENTRY; other = m_entries[other].m_next)
+          {
+            if (m_entries[other].m_cell == cell)
+            {
+              _function(current.m_id, m_entries[other].m_id);
+            }
+          }
+        }
+      }
+    }
+
+    /** \brief Gets the ids of the objects in the cells which overlap the circle (a superset of the objects inside it)
+    * \param _ids - filled with the ids (cleared first)
+    */
+    void Query(const glm::vec2& _center, float _radius, std::vector<int>& _ids) const;
+
+    size_t GetNumObjects() const { return m_entries.size(); }
+    float GetCellSize() const { return m_cellSize; }
+
+  private:
+    enum : int { NO_ENTRY = -1 };
+
+    struct Entry
+    {
+      glm::ivec2 m_cell; ///< the cell of the object
+      int m_id;
+      int m_next; ///< the next entry in the same bucket (NO_ENTRY for the last one)
+    };
+
+    glm::ivec2 GetCell(const glm::vec2& _position) const;
+    size_t GetBucket(const glm::ivec2& _cell) const
+    {
+      //the primes of the usual spatial hash, the bucket count is a power of 2
+      return (static_cast<unsigned int>(_cell.x) * 73856093u ^ static_cast<unsigned int>(_cell.y) * 19349663u) & (m_buckets.size() - 1);
+    }
+
+    float m_cellSize{ 32.0f };
+    std::vector<int> m_buckets; ///< the newest entry of every bucket
+    std::vector<Entry> m_entries;
+  };
+}
@@ -1,5 +1,17 @@
 #include "SpriteBatch.h"
+#include "FrameStats.h"
+#include "GameEngineErrors.h"
+#include "Profiler.h"
+#include "RenderState.h"
 #include <algorithm> // used for sorting
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#include <xmmintrin.h>
+#define SPRITEBATCH_USE_SSE
+#endif
 
 namespace GameEngine
 {
@@ -10,67 +22,75 @@ namespace GameEngine
 		{
 				//intialize the color, position and uv coordinate for the 4 vertices of the sprite
 				m_topLeft.m_color = _color;
-				m_topLeft.SetPosition(_destRect.x, _destRect.y + _destRect.w, 0.0f);
+				m_topLeft.SetPosition(_destRect.x, _destRect.y + _destRect.w);
 				m_topLeft.SetUV(_uvRect.x, _uvRect.y + _uvRect.w);
 
 				m_bottomLeft.m_color = _color;
-				m_bottomLeft.SetPosition(_destRect.x, _destRect.y, 0.0f);
+				m_bottomLeft.SetPosition(_destRect.x, _destRect.y);
 				m_bottomLeft.SetUV(_uvRect.x, _uvRect.y);
 
 				m_bottomRight.m_color = _color;
-				m_bottomRight.SetPosition(_destRect.x + _destRect.z, _destRect.y, 0.0f);
+				m_bottomRight.SetPosition(_destRect.x + _destRect.z, _destRect.y);
 				m_bottomRight.SetUV(_uvRect.x + _uvRect.z, _uvRect.y);
 
 				m_topRight.m_color = _color;
-				m_topRight.SetPosition(_destRect.x + _destRect.z, _destRect.y + _destRect.w, 0.0f);
+				m_topRight.SetPosition(_destRect.x + _destRect.z, _destRect.y + _destRect.w);
 				m_topRight.SetUV(_uvRect.x + _uvRect.z, _uvRect.y + _uvRect.w);
 
 		}
 
 		Glyph::Glyph(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, float _angle) :
+				Glyph(_destRect, _uvRect, _texture, _depth, _color, std::cos(_angle), std::sin(_angle))
+		{
+		}
+
+		Glyph::Glyph(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, float _cos, float _sin) :
 				m_texture(_texture),
 				m_depth(_depth)
 		{
-				glm::vec2 halfDims(_destRect.z / 2.0f, _destRect.w / 2.0f);
-
-				// Get points centered at origin
-				glm::vec2 tL(-halfDims.x, halfDims.y);
-				glm::vec2 bL(-halfDims.x, -halfDims.y);
-				glm::vec2 bR(halfDims.x, -halfDims.y);
-				glm::vec2 tR(halfDims.x, halfDims.y);
-
-				// Rotate the points
-				tL = RotatePoint(tL, _angle) + halfDims;
-				bL = RotatePoint(bL, _angle) + halfDims;
-				bR = RotatePoint(bR, _angle) + halfDims;
-				tR = RotatePoint(tR, _angle) + halfDims;
+				//the corners rotate around the center, the rotated half extents of the top right corner give all four
+				const glm::vec2 center(_destRect.x + _destRect.z * 0.5f, _destRect.y + _destRect.w * 0.5f);
+				const glm::vec2 halfX(_destRect.z * 0.5f * _cos, _destRect.z * 0.5f * _sin);
+				const glm::vec2 halfY(-_destRect.w * 0.5f * _sin, _destRect.w * 0.5f * _cos);
 
 				//intialize the color, position and uv coordinate for the 4 vertices of the sprite with the rotated points
 				m_topLeft.m_color = _color;
-				m_topLeft.SetPosition(_destRect.x + tL.x, _destRect.y + tL.y, 0.0f);
+				m_topLeft.SetPosition(center.x - halfX.x + halfY.x, center.y - halfX.y + halfY.y);
 				m_topLeft.SetUV(_uvRect.x, _uvRect.y + _uvRect.w);
 
 				m_bottomLeft.m_color = _color;
-				m_bottomLeft.SetPosition(_destRect.x + bL.x, _destRect.y + bL.y, 0.0f);
+				m_bottomLeft.SetPosition(center.x - halfX.x - halfY.x, center.y - halfX.y - halfY.y);
 				m_bottomLeft.SetUV(_uvRect.x, _uvRect.y);
 
 				m_bottomRight.m_color = _color;
-				m_bottomRight.SetPosition(_destRect.x + bR.x, _destRect.y + bR.y, 0.0f);
+				m_bottomRight.SetPosition(center.x + halfX.x - halfY.x, center.y + halfX.y - halfY.y);
 				m_bottomRight.SetUV(_uvRect.x + _uvRect.z, _uvRect.y);
 
 				m_topRight.m_color = _color;
-				m_topRight.SetPosition(_destRect.x + tR.x, _destRect.y + tR.y, 0.0f);
+				m_topRight.SetPosition(center.x + halfX.x + halfY.x, center.y + halfX.y + halfY.y);
 				m_topRight.SetUV(_uvRect.x + _uvRect.z, _uvRect.y + _uvRect.w);
-
 		}
 
-		glm::vec2 Glyph::RotatePoint(const glm::vec2& _pos, float _angle)
+		Glyph::Glyph(const glm::vec2& _topLeft, const glm::vec2& _bottomLeft, const glm::vec2& _bottomRight, const glm::vec2& _topRight,
+				const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color) :
+				m_texture(_texture),
+				m_depth(_depth)
 		{
-				//rotate a point
-				glm::vec2 newV;
-				newV.x = _pos.x * cos(_angle) - _pos.y * sin(_angle);
-				newV.y = _pos.x * sin(_angle) + _pos.y * cos(_angle);
-				return newV;
+				m_topLeft.m_color = _color;
+				m_topLeft.SetPosition(_topLeft.x, _topLeft.y);
+				m_topLeft.SetUV(_uvRect.x, _uvRect.y + _uvRect.w);
+
+				m_bottomLeft.m_color = _color;
+				m_bottomLeft.SetPosition(_bottomLeft.x, _bottomLeft.y);
+				m_bottomLeft.SetUV(_uvRect.x, _uvRect.y);
+
+				m_bottomRight.m_color = _color;
+				m_bottomRight.SetPosition(_bottomRight.x, _bottomRight.y);
+				m_bottomRight.SetUV(_uvRect.x + _uvRect.z, _uvRect.y);
+
+				m_topRight.m_color = _color;
+				m_topRight.SetPosition(_topRight.x, _topRight.y);
+				m_topRight.SetUV(_uvRect.x + _uvRect.z, _uvRect.y + _uvRect.w);
 		}
 
 		//initialize the vbo and vao to 0 when the spritebatch variable is created
@@ -83,17 +103,30 @@ namespace GameEngine
 		{
 		}
 
-		void SpriteBatch::Init()
+		void SpriteBatch::Init(BufferStreaming _streaming/* = BufferStreaming::ORPHAN*/)
 		{
+				m_streaming = _streaming;
+				//persistent mapping needs immutable buffer storage (core in 4.4), fall back to orphaning otherwise
+				if (m_streaming == BufferStreaming::PERSISTENT && !GLEW_ARB_buffer_storage)
+				{
+						m_streaming = BufferStreaming::ORPHAN;
+				}
 				CreateVertexArray();
+
+				if (m_streaming == BufferStreaming::PERSISTENT)
+				{
+						CreatePersistentBuffer(SPRITE_RING_SECTION_VERTICES);
+				}
 		}
 
 		void SpriteBatch::Dispose()
 		{
+				DestroyPersistentBuffer();
+
 				//delete the vao's and vbo's and reset them to 0
 				if (m_vao != 0)
 				{
-						glDeleteVertexArrays(1, &m_vao);
+						RenderState::Get().DeleteVertexArrays(1, &m_vao);
 						m_vao = 0;
 				}
 
@@ -104,17 +137,58 @@ namespace GameEngine
 				}
 		}
 
+		void SpriteBatch::Begin(GlyphSortType _sortType, const Camera2D& _camera)
+		{
+				Begin(_sortType, _camera.GetViewRect());
+		}
+
+		void SpriteBatch::Begin(GlyphSortType _sortType, const glm::vec4& _cullRect)
+		{
+				Begin(_sortType);
+				m_cullEnabled = true;
+				m_cullRect = _cullRect;
+				for (auto& recorder : m_recorders)
+				{
+						recorder->m_cullEnabled = true;
+						recorder->m_cullRect = _cullRect;
+				}
+		}
+
 		void SpriteBatch::Begin(GlyphSortType _sortType/* = GlyphSortType::TEXTURE*/)
 		{
 				m_sortType = _sortType;
+				m_cullEnabled = false;
 				m_renderBatches.clear();
 
 				/* Make m_glpyhs.size() == 0, however it does not free internal memory,
 						so when we later call emplace_back it doesn't need to internally call new. */
 				m_glyphs.clear();
+				for (auto& recorder : m_recorders)
+				{
+						recorder->Clear();
+						recorder->m_cullEnabled = false;
+				}
+				m_capacityAtBegin = GetBufferCapacity();
 		}
 		void SpriteBatch::End()
 		{
+				PROFILE_SCOPE("SpriteBatch::End");
+				//merge the glyphs of the recorders in index order, so the result doesn't depend on thread timing
+				size_t numGlyphs = m_glyphs.size();
+				for (auto& recorder : m_recorders)
+				{
+						numGlyphs += recorder->m_glyphs.size();
+				}
+				if (numGlyphs > m_glyphs.capacity())
+				{
+						//grow once for all the recorders instead of once per insert
+						m_glyphs.reserve(std::max(numGlyphs, m_glyphs.capacity() * 2));
+				}
+				for (auto& recorder : m_recorders)
+				{
+						m_glyphs.insert(m_glyphs.end(), recorder->m_glyphs.begin(), recorder->m_glyphs.end());
+						recorder->Clear();
+				}
 				//set up pointers for fast sorting
 				//resite the glyphPointers vectors to the number of glyphs so there is exactly as much space as it's needed
 				m_glyphPointers.resize(m_glyphs.size());
@@ -127,70 +201,243 @@ namespace GameEngine
 				SortGlyphs();
 				//create the render batches
 				CreateRenderBatches();
+
+				//after the warm-up every buffer should already be big enough, so a frame must not touch the heap
+				if (GetBufferCapacity() != m_capacityAtBegin && m_numFrames >= SPRITE_BATCH_WARMUP_FRAMES)
+				{
+						m_numReallocations++;
+						assert(!m_allocationCheck && "SpriteBatch reallocated after the warm-up frames, Reserve() more glyphs");
+				}
+				m_numFrames++;
 		}
 
-		void SpriteBatch::Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color)
+		void SpriteBatch::Reserve(size_t _numGlyphs)
 		{
+				m_glyphs.reserve(_numGlyphs);
+				m_glyphPointers.reserve(_numGlyphs);
+				m_sortKeys.reserve(_numGlyphs);
+				m_sortScratch.reserve(_numGlyphs);
+				m_renderBatches.reserve(_numGlyphs);
+				if (m_streaming == BufferStreaming::ORPHAN)
+				{
+						m_vertexScratch.reserve(_numGlyphs * 6);
+				}
+				m_capacityAtBegin = GetBufferCapacity();
+		}
+
+		size_t SpriteBatch::GetBufferCapacity() const
+		{
+				size_t capacity = m_glyphs.capacity() * sizeof(Glyph) +
+						m_glyphPointers.capacity() * sizeof(Glyph*) +
+						(m_sortKeys.capacity() + m_sortScratch.capacity()) * sizeof(GlyphSortKey) +
+						m_vertexScratch.capacity() * sizeof(Vertex2D) +
+						m_renderBatches.capacity() * sizeof(RenderBatches) +
+						m_recorders.capacity() * sizeof(std::unique_ptr<GlyphRecorder>);
+				for (auto& recorder : m_recorders)
+				{
+						capacity += recorder->m_glyphs.capacity() * sizeof(Glyph);
+				}
+				return capacity;
+		}
+
+		GlyphRecorder& SpriteBatch::GetRecorder(size_t _index)
+		{
+				while (m_recorders.size() <= _index)
+				{
+						m_recorders.push_back(std::make_unique<GlyphRecorder>());
+				}
+				//recorders created after Begin() cull like the batch itself
+				m_recorders[_index]->m_cullEnabled = m_cullEnabled;
+				m_recorders[_index]->m_cullRect = m_cullRect;
+				return *m_recorders[_index];
+		}
+
+		bool GlyphRecorder::IsCulled(const glm::vec4& _destRect, bool _rotated) const
+		{
+				if (!m_cullEnabled)
+				{
+						return false;
+				}
+				glm::vec2 minCorner(_destRect.x, _destRect.y);
+				glm::vec2 maxCorner(_destRect.x + _destRect.z, _destRect.y + _destRect.w);
+				if (_rotated)
+				{
+						//the quad rotates around its center, so test the square around its bounding circle
+						glm::vec2 center = (minCorner + maxCorner) * 0.5f;
+						float radius = glm::length(glm::vec2(_destRect.z, _destRect.w)) * 0.5f;
+						minCorner = center - glm::vec2(radius);
+						maxCorner = center + glm::vec2(radius);
+				}
+				return maxCorner.x < m_cullRect.x || minCorner.x > m_cullRect.x + m_cullRect.z ||
+						maxCorner.y < m_cullRect.y || minCorner.y > m_cullRect.y + m_cullRect.w;
+		}
+
+		void GlyphRecorder::Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color)
+		{
+				if (IsCulled(_destRect, false))
+				{
+						return;
+				}
 				m_glyphs.emplace_back(_destRect, _uvRect, _texture, _depth, _color);
 		}
 
-		void SpriteBatch::Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, float _angle)
+		void GlyphRecorder::Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, float _angle)
 		{
+				if (IsCulled(_destRect, true))
+				{
+						return;
+				}
 				m_glyphs.emplace_back(_destRect, _uvRect, _texture, _depth, _color, _angle);
 		}
 
-		void SpriteBatch::Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, const glm::vec2& _dir)
+		void GlyphRecorder::Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, const glm::vec2& _dir)
 		{
-				const glm::vec2 right(1.0f, 0.0f);
-
-				float angle = acos(glm::dot(right, _dir));
+				if (IsCulled(_destRect, true))
+				{
+						return;
+				}
+				//the cosine and sine of the direction's angle are the direction itself, once it's unit length
+				const float length = glm::length(_dir);
+				if (length > 0.0f)
+				{
+						m_glyphs.emplace_back(_destRect, _uvRect, _texture, _depth, _color, _dir.x / length, _dir.y / length);
+				}
+				else
+				{
+						m_glyphs.emplace_back(_destRect, _uvRect, _texture, _depth, _color);
+				}
+		}
 
-				if (_dir.y < 0.0f)
+		void GlyphRecorder::DrawRotated(const glm::vec4* _destRects, const glm::vec2* _directions, size_t _count, const glm::vec4& _uvRect,
+				GLuint _texture, float _depth, const ColorRGBA8& _color)
+		{
+				m_glyphs.reserve(m_glyphs.size() + _count);
+				size_t i = 0;
+#ifdef SPRITEBATCH_USE_SSE
+				const __m128 half = _mm_set1_ps(0.5f);
+				for (; i + 4 <= _count; i += 4)
 				{
-						angle = -angle;
+						//four rects in, four x, y, widths and heights out
+						__m128 x = _mm_loadu_ps(&_destRects[i].x);
+						__m128 y = _mm_loadu_ps(&_destRects[i + 1].x);
+						__m128 width = _mm_loadu_ps(&_destRects[i + 2].x);
+						__m128 height = _mm_loadu_ps(&_destRects[i + 3].x);
+						_MM_TRANSPOSE4_PS(x, y, width, height);
+						//four directions in, the cosines in the even floats and the sines in the odd ones
+						const __m128 dirs01 = _mm_loadu_ps(&_directions[i].x);
+						const __m128 dirs23 = _mm_loadu_ps(&_directions[i + 2].x);
+						const __m128 cosines = _mm_shuffle_ps(dirs01, dirs23, _MM_SHUFFLE(2, 0, 2, 0));
+						const __m128 sines = _mm_shuffle_ps(dirs01, dirs23, _MM_SHUFFLE(3, 1, 3, 1));
+
+						const __m128 halfWidth = _mm_mul_ps(width, half);
+						const __m128 halfHeight = _mm_mul_ps(height, half);
+						const __m128 centerX = _mm_add_ps(x, halfWidth);
+						const __m128 centerY = _mm_add_ps(y, halfHeight);
+						//the rotated half extents, as in the Glyph constructor
+						const __m128 halfXx = _mm_mul_ps(halfWidth, cosines);
+						const __m128 halfXy = _mm_mul_ps(halfWidth, sines);
+						const __m128 halfYx = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(halfHeight, sines));
+						const __m128 halfYy = _mm_mul_ps(halfHeight, cosines);
+
+						alignas(16) float corners[8][4];
+						_mm_store_ps(corners[0], _mm_add_ps(_mm_sub_ps(centerX, halfXx), halfYx)); //top left
+						_mm_store_ps(corners[1], _mm_add_ps(_mm_sub_ps(centerY, halfXy), halfYy));
+						_mm_store_ps(corners[2], _mm_sub_ps(_mm_sub_ps(centerX, halfXx), halfYx)); //bottom left
+						_mm_store_ps(corners[3], _mm_sub_ps(_mm_sub_ps(centerY, halfXy), halfYy));
+						_mm_store_ps(corners[4], _mm_sub_ps(_mm_add_ps(centerX, halfXx), halfYx)); //bottom right
+						_mm_store_ps(corners[5], _mm_sub_ps(_mm_add_ps(centerY, halfXy), halfYy));
+						_mm_store_ps(corners[6], _mm_add_ps(_mm_add_ps(centerX, halfXx), halfYx)); //top right
+						_mm_store_ps(corners[7], _mm_add_ps(_mm_add_ps(centerY, halfXy), halfYy));
+						for (size_t lane = 0; lane < 4; lane++)
+						{
+								if (!IsCulled(_destRects[i + lane], true))
+								{
+										m_glyphs.emplace_back(glm::vec2(corners[0][lane], corners[1][lane]), glm::vec2(corners[2][lane], corners[3][lane]),
+												glm::vec2(corners[4][lane], corners[5][lane]), glm::vec2(corners[6][lane], corners[7][lane]), _uvRect, _texture, _depth, _color);
+								}
+						}
+				}
+#endif
+				for (; i < _count; i++)
+				{
+						if (!IsCulled(_destRects[i], true))
+						{
+								m_glyphs.emplace_back(_destRects[i], _uvRect, _texture, _depth, _color, _directions[i].x, _directions[i].y);
+						}
 				}
+		}
 
-				m_glyphs.emplace_back(_destRect, _uvRect, _texture, _depth, _color, angle);
+		void GlyphRecorder::Draw(const std::vector<Glyph>& _glyphs, const glm::vec4& _bounds)
+		{
+				if (IsCulled(_bounds, false))
+				{
+						return;
+				}
+				m_glyphs.insert(m_glyphs.end(), _glyphs.begin(), _glyphs.end());
 		}
 
 		void SpriteBatch::RenderBatch()
 		{
 				/* Bind the VAO. This sets up the opengl state we need, including the
 							vertex attribute pointers and it binds the VBO */
-				glBindVertexArray(m_vao);
+				RenderState::Get().BindVertexArray(m_vao);
 
 				for (size_t i = 0; i < m_renderBatches.size(); i++)
 				{
-						glBindTexture(GL_TEXTURE_2D, m_renderBatches[i].m_texture);
+						RenderState::Get().BindTexture(0, GL_TEXTURE_2D, m_renderBatches[i].m_texture);
 
+						FrameStats::Get().Add(STAT_DRAW_CALLS);
 						glDrawArrays(GL_TRIANGLES, m_renderBatches[i].m_offset, m_renderBatches[i].m_numVertices);
 				}
 				//unbind the vao
-				glBindVertexArray(0);
+				RenderState::Get().BindVertexArray(0);
+
+				if (m_streaming == BufferStreaming::PERSISTENT && !m_renderBatches.empty())
+				{
+						//fence the section so it doesn't get overwritten while the GPU still reads from it
+						if (m_sectionFences[m_currentSection])
+						{
+								glDeleteSync(m_sectionFences[m_currentSection]);
+						}
+						m_sectionFences[m_currentSection] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				}
 		}
 
 		void SpriteBatch::CreateRenderBatches()
 		{
-				// This will store all the vertices that we need to upload
-				std::vector<Vertex> vertices;
-				// Resize the buffer to the exact size we need so we can treat it like an array
-				// Multiply the gP size by 6, because there are 6 vertices in a glyph (2 triangles)
-				vertices.resize(m_glyphPointers.size() * 6);
 				//check if the gP vector is empty
 				if (m_glyphPointers.empty())
 				{
 						return;
 				}
+				// Multiply the gP size by 6, because there are 6 vertices in a glyph (2 triangles)
+				GLsizei numVertices = static_cast<GLsizei>(m_glyphPointers.size() * 6);
+
+				FrameStats::Get().Add(STAT_GLYPHS, m_glyphPointers.size());
+				Vertex2D* destVertices = nullptr;
 				int offset = 0; //current offset
+				if (m_streaming == BufferStreaming::PERSISTENT)
+				{
+						//write straight into the mapped memory, the batch offsets point inside the acquired section
+						destVertices = AcquireRingSection(numVertices);
+						offset = m_currentSection * m_sectionCapacity;
+				}
+				else
+				{
+						/* The staging buffer keeps its capacity across frames, so resizing only allocates
+								when this frame has more vertices than any frame before it */
+						m_vertexScratch.resize(numVertices);
+						destVertices = m_vertexScratch.data();
+				}
 				int currentVertex = 0;
 				//Add the first batch
 				m_renderBatches.emplace_back(offset, 6, m_glyphPointers[0]->m_texture);
-				vertices[currentVertex++] = m_glyphPointers[0]->m_topLeft;
-				vertices[currentVertex++] = m_glyphPointers[0]->m_bottomLeft;
-				vertices[currentVertex++] = m_glyphPointers[0]->m_bottomRight;
-				vertices[currentVertex++] = m_glyphPointers[0]->m_bottomRight;
-				vertices[currentVertex++] = m_glyphPointers[0]->m_topRight;
-				vertices[currentVertex++] = m_glyphPointers[0]->m_topLeft;
+				destVertices[currentVertex++] = m_glyphPointers[0]->m_topLeft;
+				destVertices[currentVertex++] = m_glyphPointers[0]->m_bottomLeft;
+				destVertices[currentVertex++] = m_glyphPointers[0]->m_bottomRight;
+				destVertices[currentVertex++] = m_glyphPointers[0]->m_bottomRight;
+				destVertices[currentVertex++] = m_glyphPointers[0]->m_topRight;
+				destVertices[currentVertex++] = m_glyphPointers[0]->m_topLeft;
 				offset += 6;
 				//Add all the rest of the glyphs
 				//currentglyph is set to 1 rather than 0, because we already added the first batch
@@ -208,20 +455,27 @@ namespace GameEngine
 								// If its part of the current batch, just increase numVertices
 								m_renderBatches.back().m_numVertices += 6;
 						}
-						vertices[currentVertex++] = m_glyphPointers[currentGlyph]->m_topLeft;
-						vertices[currentVertex++] = m_glyphPointers[currentGlyph]->m_bottomLeft;
-						vertices[currentVertex++] = m_glyphPointers[currentGlyph]->m_bottomRight;
-						vertices[currentVertex++] = m_glyphPointers[currentGlyph]->m_bottomRight;
-						vertices[currentVertex++] = m_glyphPointers[currentGlyph]->m_topRight;
-						vertices[currentVertex++] = m_glyphPointers[currentGlyph]->m_topLeft;
+						destVertices[currentVertex++] = m_glyphPointers[currentGlyph]->m_topLeft;
+						destVertices[currentVertex++] = m_glyphPointers[currentGlyph]->m_bottomLeft;
+						destVertices[currentVertex++] = m_glyphPointers[currentGlyph]->m_bottomRight;
+						destVertices[currentVertex++] = m_glyphPointers[currentGlyph]->m_bottomRight;
+						destVertices[currentVertex++] = m_glyphPointers[currentGlyph]->m_topRight;
+						destVertices[currentVertex++] = m_glyphPointers[currentGlyph]->m_topLeft;
 						offset += 6;
 				}
+				if (m_streaming == BufferStreaming::PERSISTENT)
+				{
+						FrameStats::Get().Add(STAT_BYTES_UPLOADED, numVertices * sizeof(Vertex2D));
+						//the mapping is coherent, so there is nothing left to upload
+						return;
+				}
 				// Bind our VBO
 				glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
 				// Orphan the buffer (for speed)
-				glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), nullptr, GL_DYNAMIC_DRAW);
+				glBufferData(GL_ARRAY_BUFFER, numVertices * sizeof(Vertex2D), nullptr, GL_DYNAMIC_DRAW);
 				//upload the data
-				glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex), vertices.data());
+				FrameStats::Get().Add(STAT_BYTES_UPLOADED, numVertices * sizeof(Vertex2D));
+				glBufferSubData(GL_ARRAY_BUFFER, 0, numVertices * sizeof(Vertex2D), m_vertexScratch.data());
 				// Unbind the VBO
 				glBindBuffer(GL_ARRAY_BUFFER, 0);
 		}
@@ -233,7 +487,7 @@ namespace GameEngine
 						glGenVertexArrays(1, &m_vao);
 				}
 				// Bind the VAO. All subsequent opengl calls will modify it's state.
-				glBindVertexArray(m_vao);
+				RenderState::Get().BindVertexArray(m_vao);
 
 				//Generate the VBO if it isn't already generated
 				if (m_vbo == 0)
@@ -248,33 +502,201 @@ namespace GameEngine
 				glEnableVertexAttribArray(2);
 
 				//this is the position attribute pointer
-				glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Vertex::m_position));
+				glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex2D), (void*)offsetof(Vertex2D, Vertex2D::m_position));
 				//this is the color attribute pointer
-				glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, Vertex::m_color));
+				glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex2D), (void*)offsetof(Vertex2D, Vertex2D::m_color));
 				//this is the UV attribute pointer
-				glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Vertex::m_uv));
+				glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex2D), (void*)offsetof(Vertex2D, Vertex2D::m_uv));
 				//Unbind the vertex array
-				glBindVertexArray(0);
+				RenderState::Get().BindVertexArray(0);
+		}
+
+		void SpriteBatch::CreatePersistentBuffer(GLsizei _sectionCapacity)
+		{
+				m_sectionCapacity = _sectionCapacity;
+				m_currentSection = 0;
+
+				const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+				const GLsizeiptr bufferSize = SPRITE_RING_SECTIONS * m_sectionCapacity * sizeof(Vertex2D);
+
+				glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+				//immutable storage, so the buffer can stay mapped while it's being drawn from
+				glBufferStorage(GL_ARRAY_BUFFER, bufferSize, nullptr, flags);
+				m_mappedVertices = static_cast<Vertex2D*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferSize, flags));
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+				if (m_mappedVertices == nullptr)
+				{
+						FatalError("Failed to persistently map the SpriteBatch ring buffer");
+				}
+		}
+
+		void SpriteBatch::DestroyPersistentBuffer()
+		{
+				for (GLuint i = 0; i < SPRITE_RING_SECTIONS; i++)
+				{
+						if (m_sectionFences[i])
+						{
+								glDeleteSync(m_sectionFences[i]);
+								m_sectionFences[i] = nullptr;
+						}
+				}
+				if (m_mappedVertices != nullptr)
+				{
+						glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+						glUnmapBuffer(GL_ARRAY_BUFFER);
+						glBindBuffer(GL_ARRAY_BUFFER, 0);
+						m_mappedVertices = nullptr;
+				}
+		}
+
+		Vertex2D* SpriteBatch::AcquireRingSection(GLsizei _numVertices)
+		{
+				if (_numVertices > m_sectionCapacity)
+				{
+						/* The storage is immutable, so a bigger ring needs a new buffer.
+								Wait for the GPU to finish with all the sections before deleting it. */
+						glFinish();
+						DestroyPersistentBuffer();
+						glDeleteBuffers(1, &m_vbo);
+						m_vbo = 0;
+						//re-creates the vbo and re-points the vertex attributes of the vao to it
+						CreateVertexArray();
+						CreatePersistentBuffer(std::max(_numVertices, m_sectionCapacity * 2));
+				}
+				else
+				{
+						m_currentSection = (m_currentSection + 1) % SPRITE_RING_SECTIONS;
+				}
+
+				//block until the GPU has finished reading the section from SPRITE_RING_SECTIONS frames ago
+				GLsync& fence = m_sectionFences[m_currentSection];
+				if (fence)
+				{
+						GLenum waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+						while (waitResult == GL_TIMEOUT_EXPIRED)
+						{
+								waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+						}
+						glDeleteSync(fence);
+						fence = nullptr;
+				}
+				return m_mappedVertices + m_currentSection * m_sectionCapacity;
+		}
+
+		//maps a float to an unsigned int with the same ordering (flip the sign bit for positives, all bits for negatives)
+		static uint32_t FloatToSortableBits(float _value)
+		{
+				//treat -0.0f and 0.0f the same, like the comparison sort does
+				if (_value == 0.0f)
+				{
+						_value = 0.0f;
+				}
+				uint32_t bits;
+				std::memcpy(&bits, &_value, sizeof(bits));
+				return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+		}
+
+		void SpriteBatch::RadixSortGlyphs()
+		{
+				const size_t numGlyphs = m_glyphPointers.size();
+				m_sortKeys.resize(numGlyphs);
+				m_sortScratch.resize(numGlyphs);
+
+				//build the keys off the glyph array itself, so the sort never chases the pointers
+				for (size_t i = 0; i < numGlyphs; i++)
+				{
+						const Glyph& glyph = m_glyphs[i];
+						uint64_t key = 0;
+						switch (m_sortType)
+						{
+						case GlyphSortType::FRONT_TO_BACK:
+								key = FloatToSortableBits(glyph.m_depth);
+								break;
+						case GlyphSortType::BACK_TO_FRONT:
+								//inverted so that the biggest depth comes first
+								key = ~FloatToSortableBits(glyph.m_depth);
+								break;
+						case GlyphSortType::TEXTURE:
+								key = static_cast<uint64_t>(glyph.m_texture) << 32;
+								break;
+						default:
+								break;
+						}
+						m_sortKeys[i].m_key = key;
+						m_sortKeys[i].m_index = static_cast<uint32_t>(i);
+				}
+
+				//LSD radix sort, 8 bits per pass. Every pass is stable, so equal keys keep their submission order
+				GlyphSortKey* source = m_sortKeys.data();
+				GlyphSortKey* dest = m_sortScratch.data();
+				for (uint32_t shift = 0; shift < 64; shift += 8)
+				{
+						size_t counts[256] = { 0 };
+						for (size_t i = 0; i < numGlyphs; i++)
+						{
+								counts[(source[i].m_key >> shift) & 0xFF]++;
+						}
+						//all keys share this byte, so the pass would not change the order
+						if (counts[(source[0].m_key >> shift) & 0xFF] == numGlyphs)
+						{
+								continue;
+						}
+						size_t offset = 0;
+						for (size_t bucket = 0; bucket < 256; bucket++)
+						{
+								size_t count = counts[bucket];
+								counts[bucket] = offset;
+								offset += count;
+						}
+						for (size_t i = 0; i < numGlyphs; i++)
+						{
+								dest[counts[(source[i].m_key >> shift) & 0xFF]++] = source[i];
+						}
+						std::swap(source, dest);
+				}
+
+				for (size_t i = 0; i < numGlyphs; i++)
+				{
+						m_glyphPointers[i] = &m_glyphs[source[i].m_index];
+				}
+		}
+
+		//stable binary insertion sort, only used below RADIX_SORT_THRESHOLD (or with the radix sort disabled)
+		template<typename Compare>
+		static void InsertionSort(std::vector<Glyph*>& _glyphs, Compare _compare)
+		{
+				for (auto it = _glyphs.begin(); it != _glyphs.end(); ++it)
+				{
+						//upper_bound puts the glyph after all the equal ones, which keeps the order stable
+						std::rotate(std::upper_bound(_glyphs.begin(), it, *it, _compare), it, it + 1);
+				}
 		}
 
 		void SpriteBatch::SortGlyphs()
 		{
-				//sort the glyphs with stable_sort taken from <algorithm>
+				if (m_radixSort && m_sortType != GlyphSortType::NONE && m_glyphPointers.size() >= RADIX_SORT_THRESHOLD)
+				{
+						RadixSortGlyphs();
+						return;
+				}
+				/* Sort the glyphs with an in-place insertion sort. It's stable like std::stable_sort, but
+						std::stable_sort heap allocates its merge buffer on every call */
 				switch (m_sortType)
 				{
 				case GlyphSortType::FRONT_TO_BACK:
 				{
-						std::stable_sort(m_glyphPointers.begin(), m_glyphPointers.end(), [](Glyph* _a, Glyph* _b) { return (_a->m_depth < _b->m_depth); });
+						InsertionSort(m_glyphPointers, [](Glyph* _a, Glyph* _b) { return (_a->m_depth < _b->m_depth); });
 						break;
 				}
 				case GlyphSortType::BACK_TO_FRONT:
 				{
-						std::stable_sort(m_glyphPointers.begin(), m_glyphPointers.end(), [](Glyph* _a, Glyph* _b) { return (_a->m_depth > _b->m_depth); });
+						InsertionSort(m_glyphPointers, [](Glyph* _a, Glyph* _b) { return (_a->m_depth > _b->m_depth); });
 						break;
 				}
 				case GlyphSortType::TEXTURE:
 				{
-						std::stable_sort(m_glyphPointers.begin(), m_glyphPointers.end(), [](Glyph* _a, Glyph* _b) { return (_a->m_texture < _b->m_texture); });
+						InsertionSort(m_glyphPointers, [](Glyph* _a, Glyph* _b) { return (_a->m_texture < _b->m_texture); });
 						break;
 				}
 				default:
@@ -2,9 +2,13 @@
 #include <GL\glew.h>
 #include <glm\glm.hpp>
 #include <vector>
+#include <memory>
+#include <cstdint>
 
 #include "Vertex.h"
 #include "SpriteFont.h"
+#include "Camera2D.h"
+#include "MemoryTracker.h"
 
 namespace GameEngine
 {
@@ -17,6 +21,18 @@ namespace GameEngine
     TEXTURE
   };
 
+  // Determines how the vertex data is streamed to the GPU on every End()
+  enum class BufferStreaming
+  {
+    ORPHAN,    ///< orphan the VBO with glBufferData(nullptr) and re-upload with glBufferSubData
+    PERSISTENT ///< write straight into a triple-buffered, persistently mapped ring buffer (needs GL_ARB_buffer_storage)
+  };
+
+  // Number of sections in the persistently mapped ring buffer (one is written while the other ones are in flight)
+  constexpr GLuint SPRITE_RING_SECTIONS{ 3 };
+  // Initial number of vertices a single ring section can hold (it grows if a frame needs more)
+  constexpr GLsizei SPRITE_RING_SECTION_VERTICES{ 6 * 4096 };
+
   // A glyph is a single sprite (quad). They are added with SpriteBatch::Draw
   class Glyph
   {
@@ -25,19 +41,34 @@ namespace GameEngine
     Glyph(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color);
 
     Glyph(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, float _angle);
+    // Rotated by the angle of its cosine and sine (e.g. a unit direction), so nothing is computed twice
+    Glyph(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, float _cos, float _sin);
+    // With its corners already placed (see GlyphRecorder::DrawRotated)
+    Glyph(const glm::vec2& _topLeft, const glm::vec2& _bottomLeft, const glm::vec2& _bottomRight, const glm::vec2& _topRight,
+      const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color);
 
     GLuint m_texture{ 0 };
     float m_depth{ 0.0f };
 
-    Vertex m_topLeft;
-    Vertex m_bottomLeft;
-    Vertex m_topRight;
-    Vertex m_bottomRight;
+    Vertex2D m_topLeft;
+    Vertex2D m_bottomLeft;
+    Vertex2D m_topRight;
+    Vertex2D m_bottomRight;
+  };
 
-  private:
-    glm::vec2 RotatePoint(const glm::vec2& _pos, float _angle);
+  // 64-bit sort key (texture in the high bits, depth in the low bits) and the index of the glyph it belongs to
+  struct GlyphSortKey
+  {
+    uint64_t m_key{ 0 };
+    uint32_t m_index{ 0 };
   };
 
+  // Below this many glyphs an insertion sort is cheaper than the radix passes
+  constexpr size_t RADIX_SORT_THRESHOLD{ 256 };
+
+  // Number of Begin()/End() cycles the buffers of a SpriteBatch may still grow in before it counts as a steady state reallocation
+  constexpr unsigned int SPRITE_BATCH_WARMUP_FRAMES{ 2 };
+
   // Each render batch is used for a single draw call
   class RenderBatches
   {
@@ -50,33 +81,80 @@ namespace GameEngine
     GLuint m_texture{ 0 };
   };
 
+  /** \brief Records glyphs into its own vector. Recording is not synchronized, so every thread
+   *  that emits sprites needs its own recorder (see SpriteBatch::GetRecorder) */
+  class GlyphRecorder
+  {
+    friend class SpriteBatch;
+  public:
+    // Adds a glyph to the vector of glyphs
+    void Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color);
+    // Adds a glyph to the vector of glyphs with rotation
+    void Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, float _angle);
+    // Adds a glyph to the vector of glyphs with rotation
+    void Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, const glm::vec2& _dir);
+    /** \brief Adds _count sprites of the same look rotated toward their (unit) directions, e.g. all the zombies or bullets.
+     *  The corners of four sprites are placed at a time with SSE */
+    void DrawRotated(const glm::vec4* _destRects, const glm::vec2* _directions, size_t _count, const glm::vec4& _uvRect, GLuint _texture,
+      float _depth, const ColorRGBA8& _color);
+    // Adds glyphs built beforehand (e.g. a TextRun), culled together by the rect around them
+    void Draw(const std::vector<Glyph>& _glyphs, const glm::vec4& _bounds);
+    // Adds the glyphs of another recorder (e.g. the sprites of a FramePacket), they were culled when they were recorded
+    void Append(const GlyphRecorder& _recorder) { m_glyphs.insert(m_glyphs.end(), _recorder.m_glyphs.begin(), _recorder.m_glyphs.end()); }
+
+    // Removes the recorded glyphs (keeps the capacity)
+    void Clear() { m_glyphs.clear(); }
+    // Number of recorded glyphs
+    size_t GetNumGlyphs() const { return m_glyphs.size(); }
+
+  protected:
+    // Checks the dest rect (or the circle around it if rotated) against the cull rect
+    bool IsCulled(const glm::vec4& _destRect, bool _rotated) const;
+
+    std::vector<Glyph> m_glyphs; ///<these are the actual glyphs
+    glm::vec4 m_cullRect{ 0.0f }; ///< world space rect glyphs have to touch to be stored
+    bool m_cullEnabled{ false };
+  };
+
   // The SpriteBatch class is an efficient way of drawing sprites
-  class SpriteBatch
+  class SpriteBatch : public GlyphRecorder
   {
   public:
     SpriteBatch();
     ~SpriteBatch();
 
-    // Initializes the spritebatch
-    void Init();
+    // Initializes the spritebatch (falls back to ORPHAN if persistent mapping is not supported)
+    void Init(BufferStreaming _streaming = BufferStreaming::ORPHAN);
     //disposes of the spritebatch
     void Dispose();
 
     // Begins the spritebatch and chooses the sort type (by texture is default)
     void Begin(GlyphSortType _sortType = GlyphSortType::TEXTURE);
+    // Begins the spritebatch and rejects every glyph outside the _camera view in Draw()
+    void Begin(GlyphSortType _sortType, const Camera2D& _camera);
+    // Begins the spritebatch and rejects every glyph outside the world space _cullRect (x, y, width, height) in Draw()
+    void Begin(GlyphSortType _sortType, const glm::vec4& _cullRect);
 
-    // Ends the spritebatch
+    // Ends the spritebatch (merges the glyphs of all the recorders, so all the recording threads must be done by now)
     void End();
 
-    // Adds a glyph to the vector of glyphs
-    void Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color);
-    // Adds a glyph to the vector of glyphs with rotation
-    void Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, float _angle);
-    // Adds a glyph to the vector of glyphs with rotation
-    void Draw(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, const glm::vec2& _dir);
+    /** \brief Returns the recording context with _index, creating it if needed. Call it on the render thread
+     *  between Begin() and End(), then hand every recorder to a single worker thread */
+    GlyphRecorder& GetRecorder(size_t _index);
 
     // Renders the entire SpriteBatch to the screen
     void RenderBatch();
+
+    // Toggles the sort key + LSD radix sort path in SortGlyphs (same ordering as the comparison sort, enabled by default)
+    void SetRadixSort(bool _enabled) { m_radixSort = _enabled; }
+
+    /** \brief Makes debug builds assert when any buffer of the batch reallocates after the warm-up frames.
+     *  Reserve() enough up front for the heaviest frame before enabling it */
+    void SetAllocationCheck(bool _enabled) { m_allocationCheck = _enabled; }
+    // Reserves room for _numGlyphs glyphs in every per-frame buffer, so the first frames don't reallocate either
+    void Reserve(size_t _numGlyphs);
+    // Number of frames (after the warm-up) in which one of the per-frame buffers had to grow
+    size_t GetNumReallocations() const { return m_numReallocations; }
   private:
     // Creates all the needed RenderBatches
     void CreateRenderBatches();
@@ -84,15 +162,41 @@ namespace GameEngine
     void CreateVertexArray();
     // Sorts glyphs according to _sortType
     void SortGlyphs();
+    // Builds the sort keys for _sortType and radix sorts m_glyphPointers with them
+    void RadixSortGlyphs();
+    // Sum of the capacities of all the per-frame buffers, in bytes (changes whenever one of them reallocated)
+    size_t GetBufferCapacity() const;
+
+    // Allocates the immutable storage for the ring buffer and maps it persistently
+    void CreatePersistentBuffer(GLsizei _sectionCapacity);
+    // Unmaps the ring buffer and deletes all the pending fences
+    void DestroyPersistentBuffer();
+    // Waits until the next ring section is no longer used by the GPU and returns a pointer to it
+    Vertex2D* AcquireRingSection(GLsizei _numVertices);
 
     GLuint m_vbo{ 0 };
     GLuint m_vao{ 0 };
 
     GlyphSortType m_sortType;
+    BufferStreaming m_streaming{ BufferStreaming::ORPHAN };
+
+    Vertex2D* m_mappedVertices{ nullptr }; ///< base pointer of the persistently mapped ring buffer
+    GLsizei m_sectionCapacity{ 0 }; ///< number of vertices a single ring section can hold
+    GLuint m_currentSection{ 0 }; ///< the ring section the current render batches live in
+    GLsync m_sectionFences[SPRITE_RING_SECTIONS]{}; ///< fences signaled once the GPU is done reading a section
 
+    std::vector<std::unique_ptr<GlyphRecorder>> m_recorders; ///< per-thread recording contexts, merged in End()
     std::vector<Glyph*> m_glyphPointers; ///< this is for sorting
-    std::vector<Glyph> m_glyphs; ///<these are the actual glyphs
+    std::vector<GlyphSortKey> m_sortKeys; ///< sort keys of the glyphs (kept across frames to avoid reallocating)
+    std::vector<GlyphSortKey> m_sortScratch; ///< ping-pong buffer for the radix passes
+    TrackedVector<Vertex2D, MEMORY_RENDERING> m_vertexScratch; ///< staging vertices for ORPHAN uploads, reused every frame
+    bool m_radixSort{ true };
     std::vector<RenderBatches> m_renderBatches;
+
+    size_t m_capacityAtBegin{ 0 }; ///< GetBufferCapacity() when the current frame began
+    size_t m_numReallocations{ 0 };
+    unsigned int m_numFrames{ 0 };
+    bool m_allocationCheck{ false };
   };
 }
 
@@ -1,6 +1,8 @@
 #include "SpriteFont.h"
 
 #include "SpriteBatch.h"
+#include "RenderState.h"
+#include "IOManager.h"
 
 #include <SDL/SDL.h>
 
@@ -35,7 +37,9 @@ namespace GameEngine
     {
       TTF_Init();
     }
-    TTF_Font* f = TTF_OpenFont(font, size);
+    //from the mapped file (or pack), it has to stay open until the font is closed
+    MappedFile file;
+    TTF_Font* f = file.Open(font) ? TTF_OpenFontRW(SDL_RWFromConstMem(file.GetData(), static_cast<int>(file.GetSize())), 1, size) : nullptr;
     if (f == nullptr) {
       fprintf(stderr, "Failed to open TTF font %s\n", font);
       fflush(stderr);
@@ -100,7 +104,7 @@ namespace GameEngine
     }
     // Create the texture
     glGenTextures(1, &_texID);
-    glBindTexture(GL_TEXTURE_2D, _texID);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, _texID);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, bestWidth, bestHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 
     // Now draw all the glyphs
@@ -168,7 +172,7 @@ namespace GameEngine
     _glyphs[_regLength].size = _glyphs[0].size;
     _glyphs[_regLength].uvRect = glm::vec4(0, 0, (float)rs / (float)bestWidth, (float)rs / (float)bestHeight);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
     delete[] glyphRects;
     delete[] bestPartition;
     TTF_CloseFont(f);
@@ -176,7 +180,7 @@ namespace GameEngine
 
   void SpriteFont::dispose() {
     if (_texID != 0) {
-      glDeleteTextures(1, &_texID);
+      RenderState::Get().DeleteTextures(1, &_texID);
       _texID = 0;
     }
     if (_glyphs) {
@@ -216,7 +220,7 @@ namespace GameEngine
     return l;
   }
 
-  glm::vec2 SpriteFont::measure(const char* s) {
+  glm::vec2 SpriteFont::measure(const char* s) const {
     glm::vec2 size(0, _fontHeight);
     float cw = 0;
     for (int si = 0; s[si] != 0; si++) {
@@ -267,4 +271,35 @@ namespace GameEngine
       }
     }
   }
+
+  glm::vec2 SpriteFont::shape(const char* s, glm::vec2 position, glm::vec2 scaling, float depth, ColorRGBA8 tint,
+    Justification just, std::vector<Glyph>& glyphs) const {
+    const glm::vec2 size = measure(s) * scaling;
+    glm::vec2 tp = position;
+    // Apply justification
+    if (just == Justification::MIDDLE) {
+      tp.x -= size.x / 2;
+    }
+    else if (just == Justification::RIGHT) {
+      tp.x -= size.x;
+    }
+    const float left = tp.x;
+    for (int si = 0; s[si] != 0; si++) {
+      char c = s[si];
+      if (s[si] == '\n') {
+        tp.y += _fontHeight * scaling.y;
+        tp.x = left;
+      }
+      else {
+        // Check for correct glyph
+        int gi = c - _regStart;
+        if (gi < 0 || gi >= _regLength)
+          gi = _regLength;
+        glm::vec4 destRect(tp, _glyphs[gi].size * scaling);
+        glyphs.emplace_back(destRect, _glyphs[gi].uvRect, _texID, depth, tint);
+        tp.x += _glyphs[gi].size.x * scaling.x;
+      }
+    }
+    return size;
+  }
 }
\ No newline at end of file
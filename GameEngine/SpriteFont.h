@@ -35,6 +35,7 @@ namespace GameEngine
 {
   struct GLTexture;
   class SpriteBatch;
+  class Glyph;
 
   struct CharGlyph 
   {
@@ -71,11 +72,15 @@ namespace GameEngine
     }
 
     /// Measures the dimensions of the text
-    glm::vec2 measure(const char* s);
+    glm::vec2 measure(const char* s) const;
 
     /// Draws using a spritebatch
     void draw(SpriteBatch& batch, const char* s, glm::vec2 position, glm::vec2 scaling,
       float depth, ColorRGBA8 tint, Justification just = Justification::LEFT);
+
+    /// Appends the quads draw would emit to glyphs (see TextRun), returns the scaled size of the text
+    glm::vec2 shape(const char* s, glm::vec2 position, glm::vec2 scaling, float depth, ColorRGBA8 tint,
+      Justification just, std::vector<Glyph>& glyphs) const;
   private:
     static std::vector<int>* createRows(glm::ivec4* rects, int rectsLength, int r, int padding, int& w);
 
@@ -0,0 +1,34 @@
+#include "StartupReport.h"
+
+#include <iostream>
+
+namespace GameEngine
+{
+  void StartupReport::Add(const std::string& _name, float _milliseconds, bool _background)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Step step;
+    step.name = _name;
+    step.milliseconds = _milliseconds;
+    step.background = _background;
+    m_steps.push_back(step);
+  }
+
+  void StartupReport::Clear()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_steps.clear();
+    m_totalMilliseconds = 0.0f;
+  }
+
+  void StartupReport::Print() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::cout << "STARTUP::REPORT\n";
+    for (const Step& step : m_steps)
+    {
+      std::cout << (step.background ? "  [job] " : "  ") << step.name << ": " << step.milliseconds << " ms\n";
+    }
+    std::cout << "  total: " << m_totalMilliseconds << " ms" << std::endl;
+  }
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace GameEngine
+{
+  /** \brief How long the steps of the startup took (see IMainGame::Init), the ones on the main thread in the order they ran and the
+  * startup jobs the workers ran alongside them. Printed once the first screen is entered, to see what the first frame waits for */
+  class StartupReport
+  {
+  public:
+    struct Step
+    {
+      std::string name;
+      float milliseconds{ 0.0f };
+      bool background{ false }; ///< ran on a worker, alongside the main thread's steps
+    };
+
+    //thread safe, the startup jobs add themselves from the workers
+    void Add(const std::string& _name, float _milliseconds, bool _background = false);
+    void SetTotal(float _milliseconds) noexcept { m_totalMilliseconds = _milliseconds; }
+    void Clear();
+
+    void Print() const;
+
+    const std::vector<Step>& GetSteps() const noexcept { return m_steps; }
+    //from the start of IMainGame::Init to the first screen running
+    float GetTotal() const noexcept { return m_totalMilliseconds; }
+
+  private:
+    std::vector<Step> m_steps;
+    float m_totalMilliseconds{ 0.0f };
+    mutable std::mutex m_mutex;
+  };
+}
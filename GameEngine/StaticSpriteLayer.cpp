@@ -0,0 +1,185 @@
+#include "StaticSpriteLayer.h"
+#include "FrameStats.h"
+#include "RenderState.h"
+#include <algorithm>
+#include <numeric>
+
+namespace GameEngine
+{
+  StaticSpriteLayer::StaticSpriteLayer()
+  {
+  }
+
+  StaticSpriteLayer::~StaticSpriteLayer()
+  {
+  }
+
+  void StaticSpriteLayer::Init()
+  {
+    if (m_vao == 0)
+    {
+      glGenVertexArrays(1, &m_vao);
+    }
+    RenderState::Get().BindVertexArray(m_vao);
+
+    if (m_vbo == 0)
+    {
+      glGenBuffers(1, &m_vbo);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+
+    //same layout as the SpriteBatch, so the same shaders can be used
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex2D), (void*)offsetof(Vertex2D, Vertex2D::m_position));
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex2D), (void*)offsetof(Vertex2D, Vertex2D::m_color));
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex2D), (void*)offsetof(Vertex2D, Vertex2D::m_uv));
+
+    RenderState::Get().BindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  void StaticSpriteLayer::Dispose()
+  {
+    if (m_vao != 0)
+    {
+      RenderState::Get().DeleteVertexArrays(1, &m_vao);
+      m_vao = 0;
+    }
+    if (m_vbo != 0)
+    {
+      glDeleteBuffers(1, &m_vbo);
+      m_vbo = 0;
+    }
+    Clear();
+  }
+
+  size_t StaticSpriteLayer::Add(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, float _angle /* = 0.0f */)
+  {
+    if (_angle == 0.0f)
+    {
+      m_glyphs.emplace_back(_destRect, _uvRect, _texture, _depth, _color);
+    }
+    else
+    {
+      m_glyphs.emplace_back(_destRect, _uvRect, _texture, _depth, _color, _angle);
+    }
+    //the new sprite has to be sorted in with the rest
+    m_needsRebuild = true;
+    return m_glyphs.size() - 1;
+  }
+
+  void StaticSpriteLayer::Update(size_t _handle, const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, float _angle /* = 0.0f */)
+  {
+    Glyph& glyph = m_glyphs.at(_handle);
+    const bool textureChanged = glyph.m_texture != _texture;
+
+    glyph = (_angle == 0.0f) ? Glyph(_destRect, _uvRect, _texture, _depth, _color) : Glyph(_destRect, _uvRect, _texture, _depth, _color, _angle);
+
+    if (textureChanged)
+    {
+      //the batches depend on the texture order
+      m_needsRebuild = true;
+    }
+    else if (!m_needsRebuild)
+    {
+      WriteVertices(_handle);
+      const size_t first = m_slots[_handle] * 6;
+      if (m_dirtyBegin >= m_dirtyEnd)
+      {
+        m_dirtyBegin = first;
+        m_dirtyEnd = first + 6;
+      }
+      else
+      {
+        m_dirtyBegin = std::min(m_dirtyBegin, first);
+        m_dirtyEnd = std::max(m_dirtyEnd, first + 6);
+      }
+    }
+  }
+
+  void StaticSpriteLayer::Clear()
+  {
+    m_glyphs.clear();
+    m_slots.clear();
+    m_vertices.clear();
+    m_renderBatches.clear();
+    m_needsRebuild = false;
+    m_dirtyBegin = m_dirtyEnd = 0;
+  }
+
+  void StaticSpriteLayer::Render()
+  {
+    if (m_needsRebuild)
+    {
+      Rebuild();
+    }
+    else if (m_dirtyBegin < m_dirtyEnd)
+    {
+      //only upload what changed since the last frame
+      glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+      FrameStats::Get().Add(STAT_BYTES_UPLOADED, (m_dirtyEnd - m_dirtyBegin) * sizeof(Vertex2D));
+      glBufferSubData(GL_ARRAY_BUFFER, m_dirtyBegin * sizeof(Vertex2D), (m_dirtyEnd - m_dirtyBegin) * sizeof(Vertex2D), &m_vertices[m_dirtyBegin]);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+      m_dirtyBegin = m_dirtyEnd = 0;
+    }
+
+    RenderState::Get().BindVertexArray(m_vao);
+    for (size_t i = 0; i < m_renderBatches.size(); i++)
+    {
+      RenderState::Get().BindTexture(0, GL_TEXTURE_2D, m_renderBatches[i].m_texture);
+      FrameStats::Get().Add(STAT_DRAW_CALLS);
+      glDrawArrays(GL_TRIANGLES, m_renderBatches[i].m_offset, m_renderBatches[i].m_numVertices);
+    }
+    RenderState::Get().BindVertexArray(0);
+  }
+
+  void StaticSpriteLayer::Rebuild()
+  {
+    m_needsRebuild = false;
+    m_dirtyBegin = m_dirtyEnd = 0;
+    m_renderBatches.clear();
+
+    //sort the handles by texture, the sprites themselves keep their handles
+    std::vector<size_t> order(m_glyphs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](size_t _a, size_t _b) { return m_glyphs[_a].m_texture < m_glyphs[_b].m_texture; });
+
+    m_slots.resize(m_glyphs.size());
+    m_vertices.resize(m_glyphs.size() * 6);
+    for (size_t slot = 0; slot < order.size(); slot++)
+    {
+      const size_t handle = order[slot];
+      m_slots[handle] = slot;
+      WriteVertices(handle);
+
+      const GLuint texture = m_glyphs[handle].m_texture;
+      if (m_renderBatches.empty() || m_renderBatches.back().m_texture != texture)
+      {
+        m_renderBatches.emplace_back(static_cast<GLuint>(slot * 6), 6, texture);
+      }
+      else
+      {
+        m_renderBatches.back().m_numVertices += 6;
+      }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    //the layer rarely changes, so let the driver keep it in video memory
+    glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(Vertex2D), m_vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  void StaticSpriteLayer::WriteVertices(size_t _handle)
+  {
+    const Glyph& glyph = m_glyphs[_handle];
+    Vertex2D* vertices = &m_vertices[m_slots[_handle] * 6];
+    vertices[0] = glyph.m_topLeft;
+    vertices[1] = glyph.m_bottomLeft;
+    vertices[2] = glyph.m_bottomRight;
+    vertices[3] = glyph.m_bottomRight;
+    vertices[4] = glyph.m_topRight;
+    vertices[5] = glyph.m_topLeft;
+  }
+}
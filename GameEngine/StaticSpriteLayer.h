@@ -0,0 +1,61 @@
+#pragma once
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include <vector>
+
+#include "SpriteBatch.h"
+#include "Vertex.h"
+
+namespace GameEngine
+{
+  /** \brief Retained sprite layer for geometry that rarely changes (tiles, level geometry, backgrounds).
+   *  The vertices and render batches stay on the GPU across frames. Changing a sprite only re-uploads
+   *  the dirty vertex range, and adding sprites or changing a texture rebuilds the layer on the next Render() */
+  class StaticSpriteLayer
+  {
+  public:
+    StaticSpriteLayer();
+    ~StaticSpriteLayer();
+
+    // Generates the VAO and VBO
+    void Init();
+    // Disposes of the layer
+    void Dispose();
+
+    /** \brief Adds a sprite to the layer
+     *  \return handle used to update the sprite later */
+    size_t Add(const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, float _angle = 0.0f);
+
+    /** \brief Changes an existing sprite. Only its vertices are re-uploaded unless the texture changed */
+    void Update(size_t _handle, const glm::vec4& _destRect, const glm::vec4& _uvRect, GLuint _texture, float _depth, const ColorRGBA8& _color, float _angle = 0.0f);
+
+    // Removes all the sprites
+    void Clear();
+
+    // Uploads whatever changed since the last call and draws the layer
+    void Render();
+
+    // Getters
+    size_t GetNumSprites() const { return m_glyphs.size(); }
+    bool IsDirty() const { return m_needsRebuild || m_dirtyBegin < m_dirtyEnd; }
+
+  private:
+    // Sorts the sprites by texture, regenerates all the vertices and batches and uploads everything
+    void Rebuild();
+    // Writes the 6 vertices of the glyph with _handle into the CPU copy of the buffer
+    void WriteVertices(size_t _handle);
+
+    GLuint m_vbo{ 0 };
+    GLuint m_vao{ 0 };
+
+    std::vector<Glyph> m_glyphs;                ///< the sprites, indexed by handle
+    std::vector<size_t> m_slots;                ///< position of every handle in the texture sorted buffer
+    std::vector<Vertex2D> m_vertices;           ///< CPU copy of the GPU buffer, so dirty ranges can be uploaded
+    std::vector<RenderBatches> m_renderBatches;
+
+    bool m_needsRebuild{ false };
+    size_t m_dirtyBegin{ 0 }; ///< first dirty vertex
+    size_t m_dirtyEnd{ 0 };   ///< one past the last dirty vertex
+  };
+}
+
@@ -0,0 +1,61 @@
+#include "SystemScheduler.h"
+#include "EntityManager.h"
+
+#include "JobSystem.h"
+
+#include <algorithm>
+
+namespace GameEngine
+{
+  SystemScheduler::SystemScheduler()
+  {
+  }
+
+  SystemScheduler::~SystemScheduler()
+  {
+  }
+
+  void SystemScheduler::AddSystem(std::unique_ptr<System> _system)
+  {
+    //the new system has to run after every earlier system it conflicts with
+    std::size_t stage = 0;
+    for (std::size_t i = 0; i < m_stages.size(); i++)
+    {
+      for (System* system : m_stages[i])
+      {
+        if (system->ConflictsWith(*_system))
+        {
+          stage = i + 1;
+          break;
+        }
+      }
+    }
+    if (stage == m_stages.size())
+    {
+      m_stages.emplace_back();
+    }
+    m_stages[stage].push_back(_system.get());
+    m_systems.emplace_back(std::move(_system));
+  }
+
+  void SystemScheduler::Update(EntityManager& _manager, float _deltaTime)
+  {
+    for (auto& stage : m_stages)
+    {
+      if (stage.size() == 1)
+      {
+        stage[0]->Update(_manager, _deltaTime);
+        continue;
+      }
+      //the systems of a stage don't share any written components, this thread runs the first one
+      JobCounter counter;
+      for (std::size_t i = 1; i < stage.size(); i++)
+      {
+        System* system = stage[i];
+        JobSystem::Get().Run([system, &_manager, _deltaTime]() { system->Update(_manager, _deltaTime); }, &counter);
+      }
+      stage[0]->Update(_manager, _deltaTime);
+      JobSystem::Get().Wait(counter);
+    }
+  }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "Component.h"
+
+namespace GameEngine
+{
+  class EntityManager;
+
+  /** A system processes the entities with a set of components (usually through EntityManager::Each).
+  * It declares which component types it reads and writes, so the SystemScheduler knows which systems can run at the same time */
+  class System
+  {
+  public:
+    virtual ~System() {}
+
+    //process the entities, may run on a worker thread concurrently with systems that don't conflict with this one
+    virtual void Update(EntityManager& _manager, float _deltaTime) = 0;
+
+    const ComponentBitset& GetReads() const noexcept { return m_reads; }
+    const ComponentBitset& GetWrites() const noexcept { return m_writes; }
+
+    //whether the two systems touch the same component type and at least one of them writes it
+    bool ConflictsWith(const System& _other) const noexcept
+    {
+      return (m_writes & (_other.m_reads | _other.m_writes)).any() || (m_reads & _other.m_writes).any();
+    }
+
+  protected:
+    //declare the accessed component types, usually in the constructor of the derived system
+    template<typename... Ts> void Reads() { m_reads |= GetComponentSignature<Ts...>(); }
+    template<typename... Ts> void Writes() { m_writes |= GetComponentSignature<Ts...>(); }
+
+  private:
+    ComponentBitset m_reads;
+    ComponentBitset m_writes;
+  };
+
+  /** Runs the added systems every frame. The systems are grouped into stages: a system goes into the stage after
+  * the last earlier added system it conflicts with, and all the systems of a stage run concurrently.
+  * The systems must not add or remove entities or components while they run, do that after Update */
+  class SystemScheduler
+  {
+  public:
+    SystemScheduler();
+    ~SystemScheduler();
+
+    //the scheduler becomes responsible for the system, the order the systems are added in is the order conflicting ones run in
+    void AddSystem(std::unique_ptr<System> _system);
+
+    //runs all the stages one after the other
+    void Update(EntityManager& _manager, float _deltaTime);
+
+    //number of stages the systems were split into
+    std::size_t GetNumStages() const noexcept { return m_stages.size(); }
+
+  private:
+    std::vector<std::unique_ptr<System>> m_systems;
+    std::vector<std::vector<System*>> m_stages; ///< rebuilt whenever a system is added
+  };
+}
@@ -0,0 +1,44 @@
+#include "TextRun.h"
+
+namespace GameEngine
+{
+  bool TextRun::Set(const SpriteFont& _font, const std::string& _text, const glm::vec2& _position, const glm::vec2& _scaling,
+    float _depth, const ColorRGBA8& _tint, Justification _just)
+  {
+    if (m_font == &_font && m_text == _text && m_position == _position && m_scaling == _scaling && m_depth == _depth &&
+      m_tint.r == _tint.r && m_tint.g == _tint.g && m_tint.b == _tint.b && m_tint.a == _tint.a && m_just == _just)
+    {
+      return false;
+    }
+    m_font = &_font;
+    m_text = _text;
+    m_position = _position;
+    m_scaling = _scaling;
+    m_depth = _depth;
+    m_tint = _tint;
+    m_just = _just;
+
+    //the glyphs keep their capacity, a counter which grows a digit doesn't allocate every time
+    m_glyphs.clear();
+    const glm::vec2 size = _font.shape(_text.c_str(), _position, _scaling, _depth, _tint, _just, m_glyphs);
+    float left = _position.x;
+    if (_just == Justification::MIDDLE)
+    {
+      left -= size.x / 2;
+    }
+    else if (_just == Justification::RIGHT)
+    {
+      left -= size.x;
+    }
+    m_bounds = glm::vec4(left, _position.y, size);
+    return true;
+  }
+
+  void TextRun::Clear()
+  {
+    m_font = nullptr;
+    m_text.clear();
+    m_glyphs.clear();
+    m_bounds = glm::vec4(0.0f);
+  }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <glm\glm.hpp>
+#include <string>
+#include <vector>
+
+#include "SpriteBatch.h"
+#include "SpriteFont.h"
+#include "Vertex.h"
+
+namespace GameEngine
+{
+  /** \brief A string shaped once into glyph quads (see SpriteFont::shape). Set only shapes it again when the text, the font or the
+   *  layout changed, so a HUD string which stays the same (score, FPS, health) costs a copy of its glyphs into the batch a frame
+   *  instead of a walk over its characters */
+  class TextRun
+  {
+  public:
+    /** \brief Shapes the text if anything differs from the last call
+     *  \return true if it was shaped again */
+    bool Set(const SpriteFont& _font, const std::string& _text, const glm::vec2& _position, const glm::vec2& _scaling,
+      float _depth, const ColorRGBA8& _tint, Justification _just = Justification::LEFT);
+
+    // Adds the shaped glyphs to the batch, the whole run is culled by its bounds
+    void Draw(GlyphRecorder& _batch) const { _batch.Draw(m_glyphs, m_bounds); }
+
+    // Forgets the text, the next Set shapes again
+    void Clear();
+
+    // Getters
+    const std::string& GetText() const { return m_text; }
+    // bottom left x, y, width, height of the shaped text
+    const glm::vec4& GetBounds() const { return m_bounds; }
+
+  private:
+    const SpriteFont* m_font{ nullptr };
+    std::string m_text;
+    glm::vec2 m_position{ 0.0f };
+    glm::vec2 m_scaling{ 0.0f };
+    float m_depth{ 0.0f };
+    ColorRGBA8 m_tint;
+    Justification m_just{ Justification::LEFT };
+
+    std::vector<Glyph> m_glyphs; ///< the quads of the text, where they are drawn
+    glm::vec4 m_bounds{ 0.0f };
+  };
+}
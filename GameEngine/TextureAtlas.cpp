@@ -0,0 +1,243 @@
+#include "TextureAtlas.h"
+#include "GameEngineErrors.h"
+#include "RenderState.h"
+#include "ImageLoader.h"
+#include <algorithm>
+
+namespace GameEngine
+{
+  TextureAtlas::TextureAtlas()
+  {
+  }
+
+  TextureAtlas::~TextureAtlas()
+  {
+  }
+
+  void TextureAtlas::Init(int _pageWidth /* = 2048 */, int _pageHeight /* = 2048 */, int _padding /* = 2 */)
+  {
+    m_pageWidth = _pageWidth;
+    m_pageHeight = _pageHeight;
+    m_padding = _padding;
+  }
+
+  void TextureAtlas::Dispose()
+  {
+    for (auto& page : m_pages)
+    {
+      RenderState::Get().DeleteTextures(1, &page.id);
+    }
+    m_pages.clear();
+    m_regions.clear();
+  }
+
+  AtlasRegion TextureAtlas::Add(const std::string& _filePath)
+  {
+    AtlasRegion region;
+    if (Find(_filePath, region))
+    {
+      return region;
+    }
+
+    int width, height;
+    unsigned char* image = ImageLoader::DecodeImage(_filePath, true, width, height);
+    if (image == nullptr)
+    {
+      FatalError("Failed to load " + _filePath + " into the texture atlas");
+    }
+    region = AddPixels(_filePath, image, width, height);
+    ImageLoader::FreeImage(image);
+
+    return region;
+  }
+
+  AtlasRegion TextureAtlas::AddPixels(const std::string& _name, const unsigned char* _pixels, int _width, int _height)
+  {
+    AtlasRegion region;
+    if (Find(_name, region))
+    {
+      return region;
+    }
+    if (!IsInitialized())
+    {
+      Init();
+    }
+
+    const int paddedWidth = _width + m_padding;
+    const int paddedHeight = _height + m_padding;
+    if (paddedWidth > m_pageWidth || paddedHeight > m_pageHeight)
+    {
+      FatalError("Image " + _name + " is bigger than a texture atlas page");
+    }
+
+    //try the existing pages first, then open a new one
+    glm::ivec2 position;
+    size_t nodeIndex = 0;
+    size_t pageIndex = 0;
+    for (; pageIndex < m_pages.size(); pageIndex++)
+    {
+      if (FindPosition(m_pages[pageIndex], paddedWidth, paddedHeight, position, nodeIndex))
+      {
+        break;
+      }
+    }
+    if (pageIndex == m_pages.size())
+    {
+      AddPage();
+      FindPosition(m_pages.back(), paddedWidth, paddedHeight, position, nodeIndex);
+    }
+    Page& page = m_pages[pageIndex];
+    AddSkylineLevel(page, nodeIndex, position, paddedWidth, paddedHeight);
+
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, page.id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, position.x, position.y, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, _pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+
+    region.texture.id = page.id;
+    region.texture.width = m_pageWidth;
+    region.texture.height = m_pageHeight;
+    region.texture.asset = AssetIds::Intern(_name);
+    region.width = _width;
+    region.height = _height;
+    /* The first row of the image is at position.y in the page, the texture shaders invert v,
+       so the rect is flipped here to keep (0,0) the bottom left of the image, like a standalone texture */
+    region.uvRect.x = position.x / (float)m_pageWidth;
+    region.uvRect.y = 1.0f - (position.y + _height) / (float)m_pageHeight;
+    region.uvRect.z = _width / (float)m_pageWidth;
+    region.uvRect.w = _height / (float)m_pageHeight;
+
+    m_regions.insert(std::make_pair(_name, region));
+    return region;
+  }
+
+  bool TextureAtlas::Find(const std::string& _name, AtlasRegion& _region) const
+  {
+    auto it = m_regions.find(_name);
+    if (it == m_regions.end())
+    {
+      return false;
+    }
+    _region = it->second;
+    return true;
+  }
+
+  void TextureAtlas::Finalize()
+  {
+    for (auto& page : m_pages)
+    {
+      RenderState::Get().BindTexture(0, GL_TEXTURE_2D, page.id);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+      glGenerateMipmap(GL_TEXTURE_2D);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    }
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+  }
+
+  TextureAtlas::Page& TextureAtlas::AddPage()
+  {
+    Page page;
+    page.skyline.emplace_back(0, 0, m_pageWidth);
+
+    glGenTextures(1, &page.id);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, page.id);
+    //immutable storage for the whole chain, only level 0 is sampled until Finalize() generates the others
+    glTexStorage2D(GL_TEXTURE_2D, ImageLoader::GetNumMipLevels(m_pageWidth, m_pageHeight), GL_RGBA8, m_pageWidth, m_pageHeight);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    //no mipmaps until Finalize()
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+
+    m_pages.push_back(page);
+    return m_pages.back();
+  }
+
+  bool TextureAtlas::FindPosition(const Page& _page, int _width, int _height, glm::ivec2& _position, size_t& _nodeIndex) const
+  {
+    int bestTop = m_pageHeight + 1;
+    int bestWidth = m_pageWidth + 1;
+    bool found = false;
+
+    for (size_t i = 0; i < _page.skyline.size(); i++)
+    {
+      int y = Fit(_page, i, _width, _height);
+      if (y < 0)
+      {
+        continue;
+      }
+      //bottom-left rule: the lowest top edge, ties go to the narrowest segment
+      if (y + _height < bestTop || (y + _height == bestTop && _page.skyline[i].z < bestWidth))
+      {
+        bestTop = y + _height;
+        bestWidth = _page.skyline[i].z;
+        _position = glm::ivec2(_page.skyline[i].x, y);
+        _nodeIndex = i;
+        found = true;
+      }
+    }
+    return found;
+  }
+
+  int TextureAtlas::Fit(const Page& _page, size_t _index, int _width, int _height) const
+  {
+    const int x = _page.skyline[_index].x;
+    if (x + _width > m_pageWidth)
+    {
+      return -1;
+    }
+    int widthLeft = _width;
+    int y = _page.skyline[_index].y;
+    for (size_t i = _index; widthLeft > 0; i++)
+    {
+      y = std::max(y, _page.skyline[i].y);
+      if (y + _height > m_pageHeight)
+      {
+        return -1;
+      }
+      widthLeft -= _page.skyline[i].z;
+    }
+    return y;
+  }
+
+  void TextureAtlas::AddSkylineLevel(Page& _page, size_t _index, const glm::ivec2& _position, int _width, int _height)
+  {
+    auto& skyline = _page.skyline;
+    skyline.insert(skyline.begin() + _index, glm::ivec3(_position.x, _position.y + _height, _width));
+
+    //shrink or remove the segments now covered by the new one
+    for (size_t i = _index + 1; i < skyline.size();)
+    {
+      const glm::ivec3& previous = skyline[i - 1];
+      if (skyline[i].x >= previous.x + previous.z)
+      {
+        break;
+      }
+      int shrink = previous.x + previous.z - skyline[i].x;
+      skyline[i].x += shrink;
+      skyline[i].z -= shrink;
+      if (skyline[i].z > 0)
+      {
+        break;
+      }
+      skyline.erase(skyline.begin() + i);
+    }
+
+    //merge neighbouring segments at the same height
+    for (size_t i = 0; i + 1 < skyline.size();)
+    {
+      if (skyline[i].y == skyline[i + 1].y)
+      {
+        skyline[i].z += skyline[i + 1].z;
+        skyline.erase(skyline.begin() + i + 1);
+      }
+      else
+      {
+        i++;
+      }
+    }
+  }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "GLTexture.h"
+
+namespace GameEngine
+{
+  // A packed image: the page texture it lives in and its uv rect in the page (ready for SpriteBatch::Draw)
+  struct AtlasRegion
+  {
+    GLTexture texture;                             ///< the atlas page
+    glm::vec4 uvRect{ 0.0f, 0.0f, 1.0f, 1.0f };    ///< x, y, width, height in the page
+    int width{ 0 };                                ///< size of the packed image in pixels
+    int height{ 0 };
+
+    /** \brief Maps a uv rect local to the packed image (e.g. from TileSheet) into the page */
+    glm::vec4 ToPageUV(const glm::vec4& _localUV) const
+    {
+      return glm::vec4(uvRect.x + _localUV.x * uvRect.z, uvRect.y + _localUV.y * uvRect.w,
+        _localUV.z * uvRect.z, _localUV.w * uvRect.w);
+    }
+  };
+
+  /** \brief Packs images into big RGBA8 atlas pages with a bottom-left skyline packer,
+   *  so sprites with different source images can share a texture (and a draw call) */
+  class TextureAtlas
+  {
+  public:
+    TextureAtlas();
+    ~TextureAtlas();
+
+    // Sets the size of the pages (new pages are created when the current ones are full)
+    void Init(int _pageWidth = 2048, int _pageHeight = 2048, int _padding = 2);
+    // Deletes all the pages
+    void Dispose();
+
+    /** \brief Packs the png at _filePath (or returns the region if it's already packed) */
+    AtlasRegion Add(const std::string& _filePath);
+
+    /** \brief Packs raw RGBA8 pixels (first row first) under _name, e.g. for glyph sheets created at runtime */
+    AtlasRegion AddPixels(const std::string& _name, const unsigned char* _pixels, int _width, int _height);
+
+    /** \brief Looks up an already packed region
+     *  \return true if _name is in the atlas */
+    bool Find(const std::string& _name, AtlasRegion& _region) const;
+
+    // Generates the mipmaps of the pages, call after the level load packed everything
+    void Finalize();
+
+    bool IsInitialized() const { return m_pageWidth > 0; }
+    size_t GetNumPages() const { return m_pages.size(); }
+
+  private:
+    struct Page
+    {
+      GLuint id{ 0 };
+      std::vector<glm::ivec3> skyline; ///< skyline segments: x, y, width
+    };
+
+    // Creates a new empty page
+    Page& AddPage();
+    // Finds the lowest position in the page the rect fits in, returns false if it doesn't fit
+    bool FindPosition(const Page& _page, int _width, int _height, glm::ivec2& _position, size_t& _nodeIndex) const;
+    // Returns the height the rect would sit at if placed at skyline segment _index, or -1 if it doesn't fit
+    int Fit(const Page& _page, size_t _index, int _width, int _height) const;
+    // Adds the placed rect to the skyline of the page
+    void AddSkylineLevel(Page& _page, size_t _index, const glm::ivec2& _position, int _width, int _height);
+
+    int m_pageWidth{ 0 };
+    int m_pageHeight{ 0 };
+    int m_padding{ 0 };
+
+    std::vector<Page> m_pages;
+    std::map<std::string, AtlasRegion> m_regions;
+  };
+}
+
@@ -0,0 +1,310 @@
+#include "TextureCooker.h"
+#include "ImageLoader.h"
+#include "IOManager.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+
+namespace GameEngine
+{
+  namespace
+  {
+    const std::string COOKED_BC1_EXTENSION = ".bc1.dds";
+    const std::string COOKED_BC3_EXTENSION = ".bc3.dds";
+
+    //the dword indices of the DDS header fields the cooker writes, and their flags
+    enum : std::uint32_t
+    {
+      DDS_HEADER_DWORDS = 31,
+      DDS_FLAGS = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000, ///< caps, height, width, pixel format, mipmap count, linear size
+      DDS_CAPS = 0x1000 | 0x8 | 0x400000,                       ///< texture, complex, mipmap
+      DDS_PIXEL_FORMAT_FOURCC = 0x4
+    };
+
+    std::uint16_t To565(const float _color[3])
+    {
+      const int r = std::min(std::max(static_cast<int>(_color[0] * (31.0f / 255.0f) + 0.5f), 0), 31);
+      const int g = std::min(std::max(static_cast<int>(_color[1] * (63.0f / 255.0f) + 0.5f), 0), 63);
+      const int b = std::min(std::max(static_cast<int>(_color[2] * (31.0f / 255.0f) + 0.5f), 0), 31);
+      return static_cast<std::uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    void From565(std::uint16_t _packed, float _color[3])
+    {
+      const int r = (_packed >> 11) & 31, g = (_packed >> 5) & 63, b = _packed & 31;
+      _color[0] = static_cast<float>((r << 3) | (r >> 2));
+      _color[1] = static_cast<float>((g << 2) | (g >> 4));
+      _color[2] = static_cast<float>((b << 3) | (b >> 2));
+    }
+
+    //the 4 colour BC1 block of the 16 RGBA pixels: the endpoints span the pixels along their principal axis (range fit)
+    void EncodeColorBlock(const unsigned char* _pixels, unsigned char* _block)
+    {
+      float mean[3] = { 0.0f, 0.0f, 0.0f };
+      for (int i = 0; i < 16; i++)
+      {
+        for (int c = 0; c < 3; c++)
+        {
+          mean[c] += _pixels[i * 4 + c] / 16.0f;
+        }
+      }
+      float covariance[6] = {};
+      for (int i = 0; i < 16; i++)
+      {
+        const float r = _pixels[i * 4] - mean[0], g = _pixels[i * 4 + 1] - mean[1], b = _pixels[i * 4 + 2] - mean[2];
+        covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b;
+        covariance[3] += g * g; covariance[4] += g * b; covariance[5] += b * b;
+      }
+      //power iteration for the principal axis
+      float axis[3] = { 1.0f, 1.0f, 1.0f };
+      for (int iteration = 0; iteration < 8; iteration++)
+      {
+        const float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+        const float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+        const float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+        const float length = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+        if (length <= 0.0f)
+        {
+          break;
+        }
+        axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;
+      }
+      const float axisLength2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+      float minT = 0.0f, maxT = 0.0f;
+      for (int i = 0; i < 16; i++)
+      {
+        const float t = ((_pixels[i * 4] - mean[0]) * axis[0] + (_pixels[i * 4 + 1] - mean[1]) * axis[1] + (_pixels[i * 4 + 2] - mean[2]) * axis[2]) / axisLength2;
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+      }
+      float endpoint0[3], endpoint1[3];
+      for (int c = 0; c < 3; c++)
+      {
+        endpoint0[c] = mean[c] + axis[c] * maxT;
+        endpoint1[c] = mean[c] + axis[c] * minT;
+      }
+      std::uint16_t color0 = To565(endpoint0), color1 = To565(endpoint1);
+      //color0 > color1 selects the 4 colour mode
+      if (color0 < color1)
+      {
+        std::swap(color0, color1);
+      }
+
+      float palette[4][3];
+      From565(color0, palette[0]);
+      From565(color1, palette[1]);
+      for (int c = 0; c < 3; c++)
+      {
+        palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+        palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+      }
+      std::uint32_t indices = 0;
+      if (color0 != color1)
+      {
+        for (int i = 0; i < 16; i++)
+        {
+          int best = 0;
+          float bestDistance = 1e30f;
+          for (int p = 0; p < 4; p++)
+          {
+            const float r = _pixels[i * 4] - palette[p][0], g = _pixels[i * 4 + 1] - palette[p][1], b = _pixels[i * 4 + 2] - palette[p][2];
+            const float distance = r * r + g * g + b * b;
+            if (distance < bestDistance)
+            {
+              bestDistance = distance;
+              best = p;
+            }
+          }
+          indices |= static_cast<std::uint32_t>(best) << (i * 2);
+        }
+      }
+      _block[0] = color0 & 0xFF; _block[1] = color0 >> 8;
+      _block[2] = color1 & 0xFF; _block[3] = color1 >> 8;
+      for (int i = 0; i < 4; i++)
+      {
+        _block[4 + i] = (indices >> (i * 8)) & 0xFF;
+      }
+    }
+
+    //the 8 value BC3 alpha block of the 16 RGBA pixels, between their lowest and highest alpha
+    void EncodeAlphaBlock(const unsigned char* _pixels, unsigned char* _block)
+    {
+      int alpha0 = 0, alpha1 = 255;
+      for (int i = 0; i < 16; i++)
+      {
+        alpha0 = std::max(alpha0, static_cast<int>(_pixels[i * 4 + 3]));
+        alpha1 = std::min(alpha1, static_cast<int>(_pixels[i * 4 + 3]));
+      }
+      std::uint64_t indices = 0;
+      if (alpha0 != alpha1)
+      {
+        int palette[8] = { alpha0, alpha1 };
+        for (int p = 1; p < 7; p++)
+        {
+          palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+        }
+        for (int i = 0; i < 16; i++)
+        {
+          int best = 0;
+          for (int p = 1; p < 8; p++)
+          {
+            if (std::abs(palette[p] - _pixels[i * 4 + 3]) < std::abs(palette[best] - _pixels[i * 4 + 3]))
+            {
+              best = p;
+            }
+          }
+          indices |= static_cast<std::uint64_t>(best) << (i * 3);
+        }
+      }
+      _block[0] = static_cast<unsigned char>(alpha0);
+      _block[1] = static_cast<unsigned char>(alpha1);
+      for (int i = 0; i < 6; i++)
+      {
+        _block[2 + i] = (indices >> (i * 8)) & 0xFF;
+      }
+    }
+
+    //the next mip level of the RGBA pixels, a 2x2 box filter (the last row or column is repeated for odd sizes)
+    std::vector<unsigned char> Downsample(const std::vector<unsigned char>& _pixels, int _width, int _height)
+    {
+      const int width = std::max(_width / 2, 1), height = std::max(_height / 2, 1);
+      std::vector<unsigned char> result(static_cast<size_t>(width) * height * 4);
+      for (int y = 0; y < height; y++)
+      {
+        const int y0 = std::min(y * 2, _height - 1), y1 = std::min(y * 2 + 1, _height - 1);
+        for (int x = 0; x < width; x++)
+        {
+          const int x0 = std::min(x * 2, _width - 1), x1 = std::min(x * 2 + 1, _width - 1);
+          for (int c = 0; c < 4; c++)
+          {
+            const int sum = _pixels[(y0 * _width + x0) * 4 + c] + _pixels[(y0 * _width + x1) * 4 + c] +
+              _pixels[(y1 * _width + x0) * 4 + c] + _pixels[(y1 * _width + x1) * 4 + c];
+            result[(y * width + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+          }
+        }
+      }
+      return result;
+    }
+
+    //appends the blocks of one level, the blocks over the edge repeat the last pixels
+    void CompressLevel(const std::vector<unsigned char>& _pixels, int _width, int _height, bool _alpha, std::vector<unsigned char>& _data)
+    {
+      unsigned char block[16 * 4];
+      for (int blockY = 0; blockY < _height; blockY += 4)
+      {
+        for (int blockX = 0; blockX < _width; blockX += 4)
+        {
+          for (int i = 0; i < 16; i++)
+          {
+            const int x = std::min(blockX + i % 4, _width - 1), y = std::min(blockY + i / 4, _height - 1);
+            std::copy_n(&_pixels[(y * _width + x) * 4], 4, &block[i * 4]);
+          }
+          const size_t offset = _data.size();
+          _data.resize(offset + (_alpha ? 16 : 8));
+          if (_alpha)
+          {
+            EncodeAlphaBlock(block, &_data[offset]);
+            EncodeColorBlock(block, &_data[offset + 8]);
+          }
+          else
+          {
+            EncodeColorBlock(block, &_data[offset]);
+          }
+        }
+      }
+    }
+
+    bool WriteDDS(const std::string& _filePath, const CompressedImage& _image, bool _alpha)
+    {
+      std::uint32_t header[DDS_HEADER_DWORDS] = {};
+      header[0] = DDS_HEADER_DWORDS * 4;
+      header[1] = DDS_FLAGS;
+      header[2] = static_cast<std::uint32_t>(_image.height);
+      header[3] = static_cast<std::uint32_t>(_image.width);
+      header[4] = static_cast<std::uint32_t>(_image.levelOffsets[1]);
+      header[6] = static_cast<std::uint32_t>(_image.levelOffsets.size() - 1);
+      header[18] = 32;
+      header[19] = DDS_PIXEL_FORMAT_FOURCC;
+      header[20] = _alpha ? 0x35545844 : 0x31545844; //"DXT5" or "DXT1"
+      header[26] = DDS_CAPS;
+
+      std::ofstream file(_filePath, std::ios::binary);
+      if (file.fail())
+      {
+        return false;
+      }
+      file.write("DDS ", 4);
+      file.write(reinterpret_cast<const char*>(header), sizeof(header));
+      file.write(reinterpret_cast<const char*>(_image.data.data()), _image.data.size());
+      return !file.fail();
+    }
+  }
+
+  std::string TextureCooker::GetCookedPath(const std::string& _sourcePath, bool _alpha)
+  {
+    return _sourcePath + (_alpha ? COOKED_BC3_EXTENSION : COOKED_BC1_EXTENSION);
+  }
+
+  bool TextureCooker::IsCompressed(const std::string& _filePath)
+  {
+    if (_filePath.size() < 4)
+    {
+      return false;
+    }
+    std::string extension = _filePath.substr(_filePath.size() - 4);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char _c) { return static_cast<char>(std::tolower(_c)); });
+    return extension == ".dds";
+  }
+
+  bool TextureCooker::Cook(const std::string& _sourcePath, const std::string& _cookedPath, bool _alpha, CompressedImage& _image)
+  {
+    int width, height;
+    //the encoder always reads RGBA, BC1 just ignores the alpha
+    unsigned char* decoded = ImageLoader::DecodeImage(_sourcePath, true, width, height);
+    if (decoded == nullptr)
+    {
+      return false;
+    }
+    std::vector<unsigned char> pixels(decoded, decoded + static_cast<size_t>(width) * height * 4);
+    ImageLoader::FreeImage(decoded);
+
+    _image.format = _alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    _image.width = width;
+    _image.height = height;
+    _image.data.clear();
+    _image.levelOffsets.assign(1, 0);
+    for (;;)
+    {
+      CompressLevel(pixels, width, height, _alpha, _image.data);
+      _image.levelOffsets.push_back(_image.data.size());
+      if (width == 1 && height == 1)
+      {
+        break;
+      }
+      pixels = Downsample(pixels, width, height);
+      width = std::max(width / 2, 1);
+      height = std::max(height / 2, 1);
+    }
+    //a failed write only costs cooking again next time
+    WriteDDS(_cookedPath, _image, _alpha);
+    return true;
+  }
+
+  bool TextureCooker::LoadCompressed(const std::string& _sourcePath, bool _alpha, CompressedImage& _image)
+  {
+    if (IsCompressed(_sourcePath))
+    {
+      return ImageLoader::ReadDDS(_sourcePath, _alpha, _image);
+    }
+    const std::string cookedPath = GetCookedPath(_sourcePath, _alpha);
+    if (IOManager::IsNewerThan(cookedPath, _sourcePath) && ImageLoader::ReadDDS(cookedPath, _alpha, _image))
+    {
+      return true;
+    }
+    return Cook(_sourcePath, cookedPath, _alpha, _image);
+  }
+}
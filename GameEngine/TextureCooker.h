@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+
+namespace GameEngine
+{
+  struct CompressedImage;
+
+  /** \brief Compresses images into block compressed DDS files with their whole mip chain, so the textures upload with
+  * glCompressedTexImage2D and take a quarter (BC3) or an eighth (BC1) of the memory and bandwidth, without generating mipmaps at runtime.
+  * Like the ModelCooker, the Cache cooks a texture the first time it's loaded (see ResourceManager::SetCompressTextures) and loads the
+  * cooked file from then on, as long as it's newer than the source. Opaque textures become BC1, the ones loaded with alpha BC3.
+  * DDS files made by other tools load as they are, including BC7 */
+  class TextureCooker
+  {
+  public:
+    /** \brief The path of the cooked file of the image at _sourcePath, BC1 and BC3 are cooked into different files */
+    static std::string GetCookedPath(const std::string& _sourcePath, bool _alpha);
+
+    /** \brief Whether the file is a DDS already, which is loaded instead of cooked */
+    static bool IsCompressed(const std::string& _filePath);
+
+    /** \brief Decodes _sourcePath, generates its mipmaps, compresses all the levels and writes them to _cookedPath. Needs no GL context */
+    static bool Cook(const std::string& _sourcePath, const std::string& _cookedPath, bool _alpha, CompressedImage& _image);
+
+    /** \brief The compressed image of _sourcePath: the file itself for a DDS, else the cooked file, cooked first if it's missing or stale */
+    static bool LoadCompressed(const std::string& _sourcePath, bool _alpha, CompressedImage& _image);
+  };
+}
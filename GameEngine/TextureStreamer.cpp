@@ -0,0 +1,268 @@
+#include "TextureStreamer.h"
+#include "GLTexture.h"
+#include "ImageLoader.h"
+#include "GameEngineErrors.h"
+#include "RenderState.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace GameEngine
+{
+  namespace
+  {
+    size_t GetRowSize(int _width, bool _alpha)
+    {
+      return static_cast<size_t>(_width) * (_alpha ? 4 : 3);
+    }
+  }
+
+  TextureStreamer::TextureStreamer()
+  {
+  }
+
+  TextureStreamer::~TextureStreamer()
+  {
+    //the GL context may be gone already, only the pixels are freed
+    for (Upload& upload : m_uploads)
+    {
+      ImageLoader::FreeImage(upload.pixels);
+    }
+  }
+
+  void TextureStreamer::Add(unsigned char* _pixels, int _width, int _height, bool _alpha, const std::weak_ptr<GLTexture>& _target)
+  {
+    if (GetRowSize(_width, _alpha) > static_cast<size_t>(SECTION_SIZE))
+    {
+      FatalError("A row of the streamed texture doesn't fit in a section of the ring buffer");
+    }
+    Upload upload;
+    upload.pixels = _pixels;
+    upload.width = _width;
+    upload.height = _height;
+    upload.alpha = _alpha;
+    upload.target = _target;
+    m_uploads.push_back(std::move(upload));
+  }
+
+  void TextureStreamer::Update()
+  {
+    //the mipmaps of the textures whose rows were issued last frame, the texels of about a section per frame
+    GLsizeiptr mipmapTexels = 0;
+    size_t numMipmapped = 0;
+    for (; numMipmapped < m_mipmaps.size() && (numMipmapped == 0 || mipmapTexels < SECTION_SIZE); numMipmapped++)
+    {
+      Upload& upload = m_mipmaps[numMipmapped];
+      mipmapTexels += static_cast<GLsizeiptr>(upload.width) * upload.height;
+      Complete(upload);
+    }
+    m_mipmaps.erase(m_mipmaps.begin(), m_mipmaps.begin() + numMipmapped);
+
+    //the uploads nobody waits for anymore
+    m_uploads.erase(std::remove_if(m_uploads.begin(), m_uploads.end(), [](Upload& _upload)
+    {
+      if (!_upload.target.expired())
+      {
+        return false;
+      }
+      ImageLoader::FreeImage(_upload.pixels);
+      if (_upload.texture != 0)
+      {
+        RenderState::Get().DeleteTextures(1, &_upload.texture);
+      }
+      return true;
+    }), m_uploads.end());
+    if (m_uploads.empty())
+    {
+      return;
+    }
+
+    if (m_pbo == 0)
+    {
+      CreateRing();
+    }
+    unsigned char* section = AcquireSection();
+    const GLsizeiptr sectionOffset = static_cast<GLsizeiptr>(m_currentSection) * SECTION_SIZE;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+    //the rows of RGB images are tightly packed
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GLsizeiptr used = 0;
+    while (!m_uploads.empty())
+    {
+      Upload& upload = m_uploads.front();
+      const size_t rowSize = GetRowSize(upload.width, upload.alpha);
+      const int numRows = std::min(upload.height - upload.nextRow, static_cast<int>((SECTION_SIZE - used) / rowSize));
+      if (numRows <= 0)
+      {
+        //the section is full, the rest streams next frame
+        break;
+      }
+      if (upload.texture == 0)
+      {
+        CreateTexture(upload);
+      }
+      std::memcpy(section + used, upload.pixels + rowSize * upload.nextRow, rowSize * numRows);
+      RenderState::Get().BindTexture(0, GL_TEXTURE_2D, upload.texture);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, upload.nextRow, upload.width, numRows, upload.alpha ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE,
+        reinterpret_cast<const GLvoid*>(sectionOffset + used));
+      //the next copy starts 4 byte aligned
+      used += (static_cast<GLsizeiptr>(rowSize * numRows) + 3) & ~GLsizeiptr(3);
+      upload.nextRow += numRows;
+
+      if (upload.nextRow == upload.height)
+      {
+        ImageLoader::FreeImage(upload.pixels);
+        upload.pixels = nullptr;
+        m_mipmaps.push_back(std::move(upload));
+        m_uploads.pop_front();
+      }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+
+    //fence the section so it isn't overwritten while the GPU still copies from it
+    m_sectionFences[m_currentSection] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+
+  void TextureStreamer::Finish(const GLTexture* _target)
+  {
+    auto isTarget = [_target](const Upload& _upload) { return _upload.target.lock().get() == _target; };
+    auto mipmap = std::find_if(m_mipmaps.begin(), m_mipmaps.end(), isTarget);
+    if (mipmap != m_mipmaps.end())
+    {
+      Complete(*mipmap);
+      m_mipmaps.erase(mipmap);
+      return;
+    }
+    auto upload = std::find_if(m_uploads.begin(), m_uploads.end(), isTarget);
+    if (upload == m_uploads.end())
+    {
+      return;
+    }
+    if (upload->texture == 0)
+    {
+      CreateTexture(*upload);
+    }
+    //the rows the ring didn't get to yet come straight from the pixels
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, upload->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, upload->nextRow, upload->width, upload->height - upload->nextRow, upload->alpha ? GL_RGBA : GL_RGB,
+      GL_UNSIGNED_BYTE, upload->pixels + GetRowSize(upload->width, upload->alpha) * upload->nextRow);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    ImageLoader::FreeImage(upload->pixels);
+    upload->pixels = nullptr;
+    Complete(*upload);
+    m_uploads.erase(upload);
+  }
+
+  void TextureStreamer::Dispose()
+  {
+    while (!m_mipmaps.empty())
+    {
+      Complete(m_mipmaps.back());
+      m_mipmaps.pop_back();
+    }
+    while (!m_uploads.empty())
+    {
+      std::shared_ptr<GLTexture> target = m_uploads.front().target.lock();
+      if (target)
+      {
+        Finish(target.get());
+      }
+      else
+      {
+        ImageLoader::FreeImage(m_uploads.front().pixels);
+        if (m_uploads.front().texture != 0)
+        {
+          RenderState::Get().DeleteTextures(1, &m_uploads.front().texture);
+        }
+        m_uploads.pop_front();
+      }
+    }
+
+    for (GLuint i = 0; i < RING_SECTIONS; i++)
+    {
+      if (m_sectionFences[i])
+      {
+        glDeleteSync(m_sectionFences[i]);
+        m_sectionFences[i] = nullptr;
+      }
+    }
+    if (m_pbo != 0)
+    {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      glDeleteBuffers(1, &m_pbo);
+      m_pbo = 0;
+      m_mapped = nullptr;
+    }
+  }
+
+  void TextureStreamer::CreateRing()
+  {
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const GLsizeiptr bufferSize = RING_SECTIONS * SECTION_SIZE;
+
+    glGenBuffers(1, &m_pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+    //immutable storage, so the buffer can stay mapped while the GPU copies from it
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, bufferSize, nullptr, flags);
+    m_mapped = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bufferSize, flags));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    m_currentSection = RING_SECTIONS - 1;
+
+    if (m_mapped == nullptr)
+    {
+      FatalError("Failed to persistently map the texture streaming ring buffer");
+    }
+  }
+
+  unsigned char* TextureStreamer::AcquireSection()
+  {
+    m_currentSection = (m_currentSection + 1) % RING_SECTIONS;
+
+    //block until the GPU has finished copying from the section of RING_SECTIONS frames ago
+    GLsync& fence = m_sectionFences[m_currentSection];
+    if (fence)
+    {
+      GLenum waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+      while (waitResult == GL_TIMEOUT_EXPIRED)
+      {
+        waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+      }
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+    return m_mapped + m_currentSection * SECTION_SIZE;
+  }
+
+  void TextureStreamer::CreateTexture(Upload& _upload)
+  {
+    //immutable storage for the whole mip chain, the rows of level 0 arrive over the next frames
+    glGenTextures(1, &_upload.texture);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, _upload.texture);
+    glTexStorage2D(GL_TEXTURE_2D, ImageLoader::GetNumMipLevels(_upload.width, _upload.height), _upload.alpha ? GL_RGBA8 : GL_RGB8,
+      _upload.width, _upload.height);
+    ImageLoader::SetTextureParameters(_upload.alpha);
+  }
+
+  void TextureStreamer::Complete(Upload& _upload)
+  {
+    std::shared_ptr<GLTexture> target = _upload.target.lock();
+    if (!target)
+    {
+      RenderState::Get().DeleteTextures(1, &_upload.texture);
+      return;
+    }
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, _upload.texture);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+
+    target->id = _upload.texture;
+    target->width = _upload.width;
+    target->height = _upload.height;
+  }
+}
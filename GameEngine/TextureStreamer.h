@@ -0,0 +1,65 @@
+#pragma once
+#include <GL\glew.h>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace GameEngine
+{
+  struct GLTexture;
+
+  /** \brief Uploads decoded images without stalling the frame. The rows are copied into a persistently mapped pixel buffer ring and
+  * glTexSubImage2D reads them from there asynchronously, a ring section per frame, so a frame never copies more than SECTION_SIZE bytes.
+  * The mipmaps of a texture are generated a frame after its last rows, spread over the frames the same way. Only then the id and size
+  * are written into the target texture, which shows what it had before (the placeholder of the AsyncTextureLoader) until that */
+  class TextureStreamer
+  {
+  public:
+    enum : GLuint { RING_SECTIONS = 3 };
+    enum : GLsizeiptr { SECTION_SIZE = 4 * 1024 * 1024 }; ///< the bytes streamed per frame, and the texels whose mipmaps are generated
+
+    TextureStreamer();
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    /** \brief Queues the pixels for _target, the streamer frees them (ImageLoader::FreeImage). An upload whose target is gone is dropped */
+    void Add(unsigned char* _pixels, int _width, int _height, bool _alpha, const std::weak_ptr<GLTexture>& _target);
+
+    /** \brief Streams the next ring section and generates the mipmaps of the textures finished before, once per frame */
+    void Update();
+
+    /** \brief Finishes the upload of _target right away, from client memory */
+    void Finish(const GLTexture* _target);
+    /** \brief Finishes all the uploads from client memory and frees the ring (it's created again by the next upload) */
+    void Dispose();
+
+    size_t GetNumUploads() const { return m_uploads.size() + m_mipmaps.size(); }
+
+  private:
+    struct Upload
+    {
+      unsigned char* pixels{ nullptr };
+      int width{ 0 };
+      int height{ 0 };
+      bool alpha{ true };
+      std::weak_ptr<GLTexture> target;
+      GLuint texture{ 0 };
+      int nextRow{ 0 }; ///< the rows before it are in the texture or in flight from the ring
+    };
+
+    void CreateRing();
+    unsigned char* AcquireSection();
+    void CreateTexture(Upload& _upload);
+    void Complete(Upload& _upload);
+
+    GLuint m_pbo{ 0 };
+    unsigned char* m_mapped{ nullptr };
+    GLuint m_currentSection{ 0 };
+    GLsync m_sectionFences[RING_SECTIONS]{}; ///< signaled once the GPU is done reading a section
+
+    std::deque<Upload> m_uploads;  ///< rows still to stream, in order
+    std::vector<Upload> m_mipmaps; ///< all rows issued, the mipmaps are generated the next frame
+  };
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "GLTexture.h"
+#include "TextureAtlas.h"
 #include <glm\glm.hpp>
 
 namespace GameEngine
@@ -13,6 +14,14 @@ namespace GameEngine
     {
       this->texture = _texture;
       this->dims = _tileDims;
+      this->region = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    }
+    //initialize the tilesheet with a spritesheet that was packed into an atlas page
+    void Init(const AtlasRegion& _region, const glm::ivec2& _tileDims)
+    {
+      this->texture = _region.texture;
+      this->dims = _tileDims;
+      this->region = _region.uvRect;
     }
     //gets the UVs
     glm::vec4 GetUVs(int _index)
@@ -27,10 +36,17 @@ namespace GameEngine
       uvs.z = 1.0f / dims.x;
       uvs.w = 1.0f / dims.y;
 
+      //map the tile into the sheet's rect of the atlas page (identity for a standalone texture)
+      uvs.x = region.x + uvs.x * region.z;
+      uvs.y = region.y + uvs.y * region.w;
+      uvs.z *= region.z;
+      uvs.w *= region.w;
+
       return uvs;
     }
 
     GLTexture texture;
     glm::ivec2 dims{ 0, 0 };
+    glm::vec4 region{ 0.0f, 0.0f, 1.0f, 1.0f }; ///< uv rect of the sheet inside its texture
   };
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include "Timing.h"
+#include "Profiler.h"
 #include <SDL\SDL.h>
+#include <algorithm>
+#include <thread>
 namespace GameEngine
 {
 
@@ -20,64 +23,77 @@ namespace GameEngine
   //called at the start of the frame
   void FpsLimiter::BeginFrame()
   {
-    m_startTicks = SDL_GetTicks();
+    m_frameStart = Clock::now();
+    if (!m_started)
+    {
+      m_deadline = m_frameStart;
+      m_previousFrameEnd = m_frameStart;
+      m_started = true;
+    }
   }
 
   //called at the end of the frame
   float FpsLimiter::End()
   {
-    CalculateFPS();
-    float frameTicks = (float)SDL_GetTicks() - m_startTicks;
-    //check if the time it took this frame to be completed is lower than the desired frame time
-    if (1000.0f / m_maxFPS > frameTicks)
+    m_workTime = std::chrono::duration<float, std::milli>(Clock::now() - m_frameStart).count();
+    //check if the time it took this frame to be completed is lower than the desired frame time (no limit without a max fps)
+    if (m_pacing == FramePacing::SLEEP_SPIN && m_maxFPS > 0.0f)
     {
-      //if the frame was completed too fast, delay it to limit the fps
-      SDL_Delay((Uint32)(1000.0f / m_maxFPS - frameTicks));
+      WaitForDeadline();
     }
+    CalculateFPS();
     return m_fps;
   }
 
-  void FpsLimiter::CalculateFPS()
+  void FpsLimiter::WaitForDeadline()
   {
-    static constexpr float MS_PER_SECOND = 1000; // Number of milliseconds in a second
-    const float DESIRED_FRAMETIME = MS_PER_SECOND / m_maxFPS; // The desired frame time per frame
-
-    //The number of frames to average
-    static const int NUM_SAMPLES = 10;
-    //Stores all the frametimes for each frame that we will average
-    static float frameTimes[NUM_SAMPLES];
-    //The current frame we are on
-    static int currentFrame = 0;
-    //the ticks of the previous frame
-    static float previousTicks = static_cast<float>(SDL_GetTicks());
-    //Ticks for the current frame
-    float currentTicks = static_cast<float>(SDL_GetTicks());
-
-    //Calculate the number of ticks (ms) for this frame
-    m_frameTime = (float)currentTicks - previousTicks;
-
-    m_deltaTime = m_frameTime / DESIRED_FRAMETIME;
-    //currentFrame % NUM_SAMPLES -> makes sure that current frame isn't higher then the number of samples
-    frameTimes[currentFrame % NUM_SAMPLES] = m_frameTime;
-    //current ticks is now previous ticks
-    previousTicks = currentTicks;
-
-    int count;
-    currentFrame++;
-
-    if (currentFrame < NUM_SAMPLES)
+    PROFILE_SCOPE("FpsLimiter::Wait");
+    const Clock::duration frameDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(1.0f / m_maxFPS));
+    m_deadline += frameDuration;
+    Clock::time_point now = Clock::now();
+    //more than a frame late (a load, a breakpoint): start over from now instead of running fast to catch up
+    if (now > m_deadline + frameDuration)
     {
-      count = currentFrame;
+      m_deadline = now;
+      return;
     }
-    else
+    //sleeps of a millisecond (SDL sets the Windows timer to 1ms) while they can't overshoot, each measures what the OS oversleeps
+    while (m_deadline - now > m_sleepMargin)
+    {
+      const Clock::time_point sleepStart = now;
+      SDL_Delay(1);
+      now = Clock::now();
+      const Clock::duration overslept = (now - sleepStart) - std::chrono::milliseconds(1);
+      //the margin jumps up to a longer oversleep at once and eases back down
+      m_sleepMargin = std::max(overslept, m_sleepMargin - m_sleepMargin / 64);
+    }
+    //the rest is spun, it's shorter than a sleep is exact
+    while (Clock::now() < m_deadline)
     {
-      count = NUM_SAMPLES;
+      std::this_thread::yield();
     }
+  }
+
+  void FpsLimiter::CalculateFPS()
+  {
+    //the time between the ends of the frames, the whole frame with what it waited
+    const Clock::time_point now = Clock::now();
+    m_frameTime = std::chrono::duration<float, std::milli>(now - m_previousFrameEnd).count();
+    m_previousFrameEnd = now;
+
+    //in frames of the max fps, or of 60 without one
+    const float desiredFrameTime = 1000.0f / (m_maxFPS > 0.0f ? m_maxFPS : 60.0f);
+    m_deltaTime = m_frameTime / desiredFrameTime;
+    //currentFrame % FPS_SAMPLES -> makes sure that current frame isn't higher then the number of samples
+    m_frameTimes[m_currentFrame % FPS_SAMPLES] = m_frameTime;
+    m_currentFrame++;
+
+    const int count = m_currentFrame < FPS_SAMPLES ? m_currentFrame : FPS_SAMPLES;
     //Average all the frame times
     float frameTimeAvg = 0;
     for (int i = 0; i < count; i++)
     {
-      frameTimeAvg += frameTimes[i];
+      frameTimeAvg += m_frameTimes[i];
     }
     frameTimeAvg /= count;
     //Calculate FPS
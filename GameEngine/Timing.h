@@ -2,7 +2,18 @@
 #include <chrono>
 namespace GameEngine
 {
-  ///Calculates FPS and also limits FPS
+  //How FpsLimiter::End keeps the frames apart
+  enum class FramePacing
+  {
+    SLEEP_SPIN, ///< sleeps until close to the end of the frame and spins the rest, the sleeps are only as exact as the OS timer
+    VSYNC       ///< the buffer swap waits for the display (see Window::SetVSync), End only measures
+  };
+
+  //The number of frames the FPS is averaged over
+  constexpr int FPS_SAMPLES{ 10 };
+
+  ///Calculates FPS and also limits FPS. The frames end on a steady clock deadline which moves by the frame time, so an early or late
+  ///wake up is made up by the next frame instead of adding up
   class FpsLimiter
   {
   public:
@@ -14,6 +25,8 @@ namespace GameEngine
 
     // Sets the desired max FPS
     void SetMaxFPS(float _maxFPS);
+    // Sets how the frames are paced
+    void SetPacing(FramePacing _pacing) { m_pacing = _pacing; }
 
     //set the startTicks to the current frame ticks
     void BeginFrame();
@@ -23,16 +36,34 @@ namespace GameEngine
 
     float GetCurrentFPS() { return m_fps; }
     float GetCurrentDT() { return m_deltaTime; }
+    // Milliseconds the last frame took before End() delayed it, i.e. the actual work
+    float GetWorkTime() const { return m_workTime; }
+    // Milliseconds the sleeps are ended early by, what the OS oversleeps
+    float GetSleepMargin() const { return std::chrono::duration<float, std::milli>(m_sleepMargin).count(); }
 
   private:
+    using Clock = std::chrono::steady_clock;
+
     // Calculates the current FPS
     void CalculateFPS();
+    // Waits until the deadline of the frame
+    void WaitForDeadline();
 
     float m_maxFPS{ 0.0f };
     float m_fps{ 0.0f };
     float m_frameTime{ 0.0f };
     float m_deltaTime{ 0.0f };
-    unsigned int m_startTicks{ 0 };
+    float m_workTime{ 0.0f };
+    FramePacing m_pacing{ FramePacing::SLEEP_SPIN };
+
+    Clock::time_point m_frameStart;
+    Clock::time_point m_deadline;          ///< when the last frame was meant to end
+    Clock::time_point m_previousFrameEnd;
+    Clock::duration m_sleepMargin{ std::chrono::milliseconds(2) }; ///< spun instead of slept, grows with the measured oversleep
+    bool m_started{ false };
+
+    float m_frameTimes[FPS_SAMPLES]{};     ///< the milliseconds of the last frames
+    int m_currentFrame{ 0 };
   };
 
   class HRTimer
@@ -0,0 +1,126 @@
+#include "UniformBlocks.h"
+#include "FrameStats.h"
+#include "Camera3D.h"
+#include "Lights.h"
+
+namespace GameEngine
+{
+  namespace
+  {
+    GLuint CreateBuffer(GLsizeiptr _size)
+    {
+      GLuint buffer = 0;
+      glGenBuffers(1, &buffer);
+      glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+      glBufferData(GL_UNIFORM_BUFFER, _size, nullptr, GL_DYNAMIC_DRAW);
+      glBindBuffer(GL_UNIFORM_BUFFER, 0);
+      return buffer;
+    }
+
+    void WriteBuffer(GLuint _buffer, GLuint _binding, const void* _data, GLsizeiptr _size)
+    {
+      //glBindBufferBase binds the generic GL_UNIFORM_BUFFER target too
+      glBindBufferBase(GL_UNIFORM_BUFFER, _binding, _buffer);
+      FrameStats::Get().Add(STAT_BYTES_UPLOADED, _size);
+      glBufferSubData(GL_UNIFORM_BUFFER, 0, _size, _data);
+    }
+  }
+
+  // ------------------------- FRAME UNIFORMS ------------------------------------
+
+  void FrameUniforms::Init()
+  {
+    if (m_buffer == 0)
+    {
+      m_buffer = CreateBuffer(sizeof(FrameUniformData));
+    }
+  }
+
+  void FrameUniforms::Dispose()
+  {
+    if (m_buffer != 0)
+    {
+      glDeleteBuffers(1, &m_buffer);
+      m_buffer = 0;
+    }
+  }
+
+  void FrameUniforms::Update(const Camera3D& _camera, float _seconds)
+  {
+    m_data.projection = _camera.GetProjectionMatrix();
+    m_data.view = _camera.GetViewMatrix();
+    m_data.viewProjection = m_data.projection * m_data.view;
+    m_data.cameraPos = glm::vec4(_camera.GetPosition(), 1.0f);
+    m_data.frameTime = glm::vec4(_seconds, 0.0f, 0.0f, 0.0f);
+    m_data.inverseViewProjection = glm::inverse(m_data.viewProjection);
+    if (m_buffer != 0)
+    {
+      WriteBuffer(m_buffer, FRAME_UNIFORMS_BINDING, &m_data, sizeof(m_data));
+    }
+  }
+
+  // ------------------------- LIGHT BLOCK ------------------------------------
+
+  void LightBlock::Init()
+  {
+    if (m_buffer == 0)
+    {
+      m_buffer = CreateBuffer(sizeof(LightBlockData));
+    }
+  }
+
+  void LightBlock::Dispose()
+  {
+    if (m_buffer != 0)
+    {
+      glDeleteBuffers(1, &m_buffer);
+      m_buffer = 0;
+    }
+  }
+
+  void LightBlock::Clear()
+  {
+    m_data.lightCounts = glm::ivec4(0);
+  }
+
+  bool LightBlock::Add(const PointLight& _light)
+  {
+    int& count = m_data.lightCounts.x;
+    if (count == LightBlockData::MAX_POINT_LIGHTS)
+    {
+      return false;
+    }
+    _light.WriteTo(m_data.pointLights[count++]);
+    return true;
+  }
+
+  bool LightBlock::Add(const SpotLight& _light)
+  {
+    int& count = m_data.lightCounts.y;
+    if (count == LightBlockData::MAX_SPOT_LIGHTS)
+    {
+      return false;
+    }
+    _light.WriteTo(m_data.spotLights[count++]);
+    return true;
+  }
+
+  bool LightBlock::Add(const DirectionalLight& _light)
+  {
+    int& count = m_data.lightCounts.z;
+    if (count == LightBlockData::MAX_DIRECTIONAL_LIGHTS)
+    {
+      return false;
+    }
+    _light.WriteTo(m_data.directionalLights[count++]);
+    return true;
+  }
+
+  void LightBlock::Upload()
+  {
+    if (m_buffer != 0)
+    {
+      WriteBuffer(m_buffer, LIGHT_BLOCK_BINDING, &m_data, sizeof(m_data));
+    }
+  }
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <GL\glew.h>
+#include <glm\mat4x4.hpp>
+#include <glm\vec4.hpp>
+
+namespace GameEngine
+{
+  class Camera3D;
+  class PointLight;
+  class SpotLight;
+  class DirectionalLight;
+
+  //the uniform buffer binding points of the blocks every program shares. GLSLProgram binds the blocks a shader declares to them when it
+  //links, so a shader only declares the block (AnimationSystem::BONE_PALETTE_BINDING is 1)
+  enum : GLuint { FRAME_UNIFORMS_BINDING = 2, LIGHT_BLOCK_BINDING = 3, CASCADE_BLOCK_BINDING = 4 };
+
+  //the std140 layouts of the blocks. Every member is a vec4 (or made of them), so the C++ structs match the GLSL ones byte for byte
+
+  /** \brief The std140 block "FrameUniforms":
+  *   layout (std140) uniform FrameUniforms
+  *   {
+  *     mat4 projection;
+  *     mat4 view;
+  *     mat4 viewProjection;
+  *     vec4 cameraPos;   // w unused
+  *     vec4 frameTime;   // x the seconds since the start
+  *     mat4 inverseViewProjection;
+  *   }; */
+  struct FrameUniformData
+  {
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::mat4 viewProjection;
+    glm::vec4 cameraPos;
+    glm::vec4 frameTime;
+    glm::mat4 inverseViewProjection; ///< rebuilds world positions from depths, e.g. of a GBuffer
+  };
+
+  /** \brief A point light of the LightBlock, the GLSL struct has the same vec4 members */
+  struct PointLightData
+  {
+    glm::vec4 position;    ///< w unused
+    glm::vec4 color;       ///< w unused
+    glm::vec4 intensities; ///< ambient, diffuse, specular
+    glm::vec4 attenuation; ///< constant, linear, quadratic
+  };
+
+  /** \brief A spot light of the LightBlock */
+  struct SpotLightData
+  {
+    glm::vec4 position;
+    glm::vec4 direction;
+    glm::vec4 color;
+    glm::vec4 intensities; ///< ambient, diffuse, specular
+    glm::vec4 attenuation; ///< constant, linear, quadratic
+    glm::vec4 cutOffs;     ///< inner, outer
+  };
+
+  /** \brief A directional light of the LightBlock */
+  struct DirectionalLightData
+  {
+    glm::vec4 direction;
+    glm::vec4 color;
+    glm::vec4 intensities; ///< ambient, diffuse, specular
+  };
+
+  /** \brief The std140 block "LightBlock":
+  *   layout (std140) uniform LightBlock
+  *   {
+  *     PointLight pointLights[MAX_POINT_LIGHTS];
+  *     SpotLight spotLights[MAX_SPOT_LIGHTS];
+  *     DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHTS];
+  *     ivec4 lightCounts;  // point, spot, directional
+  *     vec4 shadowParams;  // x the far plane of the point light shadow cubemap
+  *   }; */
+  struct LightBlockData
+  {
+    enum : int { MAX_POINT_LIGHTS = 8, MAX_SPOT_LIGHTS = 4, MAX_DIRECTIONAL_LIGHTS = 2 };
+
+    PointLightData pointLights[MAX_POINT_LIGHTS];
+    SpotLightData spotLights[MAX_SPOT_LIGHTS];
+    DirectionalLightData directionalLights[MAX_DIRECTIONAL_LIGHTS];
+    glm::ivec4 lightCounts;
+    glm::vec4 shadowParams;
+  };
+
+  /** \brief The std140 block "CascadeBlock" of the cascaded shadow maps of a directional light (see CascadedShadowMap):
+  *   layout (std140) uniform CascadeBlock
+  *   {
+  *     mat4 cascadeMatrices[MAX_CASCADES];
+  *     vec4 cascadeSplits;   // the view depth where each cascade ends
+  *     vec4 cascadeParams;   // x the number of cascades, y the size of a texel of the maps (1 / resolution)
+  *   }; */
+  struct CascadeBlockData
+  {
+    enum : int { MAX_CASCADES = 4 };
+
+    glm::mat4 cascadeMatrices[MAX_CASCADES];
+    glm::vec4 cascadeSplits;
+    glm::vec4 cascadeParams;
+  };
+
+  static_assert(sizeof(FrameUniformData) == 4 * 64 + 2 * 16, "FrameUniformData has to match the std140 layout");
+  static_assert(sizeof(LightBlockData) == (LightBlockData::MAX_POINT_LIGHTS * 4 + LightBlockData::MAX_SPOT_LIGHTS * 6 +
+    LightBlockData::MAX_DIRECTIONAL_LIGHTS * 3 + 2) * 16, "LightBlockData has to match the std140 layout");
+  static_assert(sizeof(CascadeBlockData) == CascadeBlockData::MAX_CASCADES * 64 + 2 * 16, "CascadeBlockData has to match the std140 layout");
+
+  /** \brief The uniform buffer of the FrameUniforms block: the camera is written once a frame instead of into every program that
+  * draws with it, so switching programs uploads nothing */
+  class FrameUniforms
+  {
+  public:
+    FrameUniforms() {}
+    ~FrameUniforms() { Dispose(); }
+
+    void Init();
+    void Dispose();
+
+    //writes the matrices and the position of _camera and binds the buffer to FRAME_UNIFORMS_BINDING
+    void Update(const Camera3D& _camera, float _seconds);
+
+    const FrameUniformData& GetData() const noexcept { return m_data; }
+  private:
+    FrameUniformData m_data{};
+    GLuint m_buffer{ 0 };
+  };
+
+  /** \brief The uniform buffer of the LightBlock block. The lights of the frame are added after a Clear and written with one Upload */
+  class LightBlock
+  {
+  public:
+    LightBlock() {}
+    ~LightBlock() { Dispose(); }
+
+    void Init();
+    void Dispose();
+
+    //removes every light, the shadow parameters stay
+    void Clear();
+    //the Add functions return false when the block is full
+    bool Add(const PointLight& _light);
+    bool Add(const SpotLight& _light);
+    bool Add(const DirectionalLight& _light);
+    void SetShadowFarPlane(float _farPlane) { m_data.shadowParams.x = _farPlane; }
+
+    //writes the lights and binds the buffer to LIGHT_BLOCK_BINDING
+    void Upload();
+
+    const LightBlockData& GetData() const noexcept { return m_data; }
+  private:
+    LightBlockData m_data{};
+    GLuint m_buffer{ 0 };
+  };
+}
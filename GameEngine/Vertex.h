@@ -21,6 +21,40 @@ namespace GameEngine
     GLubyte a{ 0 };
   };
 
+  //Packed vertex for the 2D batchers (20 bytes), only what SpriteBatch actually uploads
+  struct Vertex2D
+  {
+    Vertex2D() {}
+    Vertex2D(const glm::vec2& _position, const ColorRGBA8& _color, const glm::vec2& _uv) :
+      m_position(_position), m_color(_color), m_uv(_uv) { }
+
+    //vertex position
+    glm::vec2 m_position{ 0.0f, 0.0f };
+
+    //vertex color
+    ColorRGBA8 m_color;
+
+    //vertex texture coordinates
+    glm::vec2 m_uv{ 0.0f, 0.0f };
+
+    void SetPosition(float _x, float _y)
+    {
+      m_position = glm::vec2(_x, _y);
+    }
+    void SetUV(float _x, float _y)
+    {
+      m_uv = glm::vec2(_x, _y);
+    }
+    void SetColor(const GLubyte& _r, const GLubyte& _g, const GLubyte& _b, const GLubyte& _a)
+    {
+      m_color.r = _r;
+      m_color.g = _g;
+      m_color.b = _b;
+      m_color.a = _a;
+    }
+  };
+  static_assert(sizeof(Vertex2D) == 20, "Vertex2D is expected to be tightly packed");
+
   //The vertex definition
   struct Vertex
   {
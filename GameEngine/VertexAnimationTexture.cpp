@@ -0,0 +1,114 @@
+#include "VertexAnimationTexture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm\vec3.hpp>
+
+#include "GLSLProgram.h"
+#include "Model.h"
+#include "RenderState.h"
+
+namespace GameEngine
+{
+  bool VertexAnimationTexture::Bake(const SkinnedModel& _model, const std::string& _animName, float _framesPerSecond, StaticModel& _crowdModel)
+  {
+    const std::shared_ptr<const SkeletonAsset>& asset = _model.GetAsset();
+    const GLuint clip = asset ? asset->FindClip(_animName) : SkeletonAsset::NO_CLIP;
+    if (clip == SkeletonAsset::NO_CLIP || _framesPerSecond <= 0.0f)
+    {
+      return false;
+    }
+
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    m_vertexOffsets.clear();
+    GLuint numVertices = 0;
+    for (const Mesh& mesh : asset->GetMeshes())
+    {
+      if (!mesh.HasCpuData())
+      {
+        return false;
+      }
+      m_vertexOffsets.push_back(numVertices);
+      numVertices += mesh.GetVertices().size();
+    }
+    const AnimationClip& animation = asset->GetClips()[clip];
+    const float duration = animation.m_duration / animation.m_ticksPerSecond;
+    const GLuint numFrames = std::max(1, static_cast<int>(std::ceil(duration * _framesPerSecond)));
+    if (numVertices == 0 || numVertices > static_cast<GLuint>(maxSize) || numFrames * 2 > static_cast<GLuint>(maxSize))
+    {
+      return false;
+    }
+
+    //the same skinning as Animation.vert, once per frame and vertex
+    std::vector<glm::vec3> texels(numVertices * numFrames * 2);
+    AnimationInstance instance;
+    instance.SetClip(*asset, clip);
+    for (GLuint frame = 0; frame < numFrames; frame++)
+    {
+      instance.Update(*asset, frame / _framesPerSecond);
+      const std::vector<glm::mat4>& pose = instance.GetPose();
+      glm::vec3* positions = &texels[frame * 2 * numVertices];
+      glm::vec3* normals = positions + numVertices;
+      for (GLuint m = 0; m < asset->GetMeshes().size(); m++)
+      {
+        const std::vector<Vertex>& vertices = asset->GetMeshes()[m].GetVertices();
+        for (GLuint v = 0; v < vertices.size(); v++)
+        {
+          const Vertex& vertex = vertices[v];
+          glm::mat4 boneTransform(0.0f);
+          for (GLuint b = 0; b < 4; b++)
+          {
+            if (vertex.m_boneIDs[b] >= 0 && vertex.m_boneIDs[b] < static_cast<int>(pose.size()))
+            {
+              boneTransform += pose[vertex.m_boneIDs[b]] * vertex.m_weights[b];
+            }
+          }
+          positions[m_vertexOffsets[m] + v] = glm::vec3(boneTransform * glm::vec4(vertex.m_position, 1.0f));
+          normals[m_vertexOffsets[m] + v] = glm::normalize(glm::vec3(boneTransform * glm::vec4(vertex.m_normal, 0.0f)));
+        }
+      }
+    }
+
+    Dispose();
+    glGenTextures(1, &m_texture.id);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, m_texture.id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, numVertices, numFrames * 2, 0, GL_RGB, GL_FLOAT, texels.data());
+    //fetched texel by texel, the frames are blended in the shader
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    RenderState::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+    m_texture.type = AssetIds::Intern("vertex_animation");
+    m_texture.width = numVertices;
+    m_texture.height = numFrames * 2;
+    m_numFrames = numFrames;
+    m_framesPerSecond = _framesPerSecond;
+
+    //static copies of the meshes, with the instance matrix attributes instead of the bone ones
+    _crowdModel.Dispose();
+    for (const Mesh& mesh : asset->GetMeshes())
+    {
+      _crowdModel.m_meshes.emplace_back(mesh.GetVertices(), mesh.GetIndices(), mesh.GetTextures(), false, mesh.GetBaseModelMatrix(), false, mesh.GetLods());
+    }
+    return true;
+  }
+
+  void VertexAnimationTexture::Dispose()
+  {
+    if (m_texture.id != 0)
+    {
+      m_texture.Dispose();
+    }
+    m_numFrames = 0;
+  }
+
+  void VertexAnimationTexture::Bind(GLSLProgram& _shader, float _time, int _slot) const
+  {
+    _shader.UploadValue("vatTexture", _slot, m_texture);
+    _shader.UploadValue("vatNumFrames", static_cast<int>(m_numFrames));
+    _shader.UploadValue("vatFramesPerSecond", m_framesPerSecond);
+    _shader.UploadValue("vatTime", _time);
+  }
+}
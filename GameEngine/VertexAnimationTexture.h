@@ -0,0 +1,47 @@
+#pragma once
+
+#include <GL\glew.h>
+#include <string>
+#include <vector>
+
+#include "GLTexture.h"
+
+namespace GameEngine
+{
+  class GLSLProgram;
+  class SkinnedModel;
+  class StaticModel;
+
+  /** \brief A clip of a skinned model baked into a float texture of its skinned vertex positions and normals, so far away crowds
+  * are drawn as instanced static models without any bone evaluation or skinning (see StaticModel::DrawInstanced).
+  * Every vertex of the model (the meshes one after the other) is a column, every frame two rows: the positions, then the normals.
+  * The shader ("Shaders/VertexAnimation.vert") fetches the two frames around the time of its instance by gl_VertexID and blends them */
+  class VertexAnimationTexture
+  {
+  public:
+    VertexAnimationTexture() {}
+    ~VertexAnimationTexture() { Dispose(); }
+
+    /** \brief Samples clip _animName of _model _framesPerSecond times a second and uploads the skinned vertices
+    * \param _crowdModel - gets static copies of the meshes of _model, the model to draw the texture with
+    * \return false if the model has no such clip, has too many vertices for a texture row or its meshes didn't keep their CPU data
+    * (see ResourceManager::GetSkinnedModel) */
+    bool Bake(const SkinnedModel& _model, const std::string& _animName, float _framesPerSecond, StaticModel& _crowdModel);
+    void Dispose();
+
+    /** \brief Binds the texture to "vatTexture" and uploads the uniforms of the shader, _time is in seconds */
+    void Bind(GLSLProgram& _shader, float _time, int _slot = 4) const;
+
+    GLuint GetNumFrames() const noexcept { return m_numFrames; }
+    GLuint GetNumVertices() const noexcept { return m_texture.width; }
+    /** \brief The first column of mesh _mesh */
+    GLuint GetVertexOffset(GLuint _mesh) const { return m_vertexOffsets.at(_mesh); }
+    const GLTexture& GetTexture() const noexcept { return m_texture; }
+
+  private:
+    GLTexture m_texture;
+    GLuint m_numFrames{ 0 };
+    float m_framesPerSecond{ 30.0f };
+    std::vector<GLuint> m_vertexOffsets; ///< by mesh
+  };
+}
@@ -1,5 +1,6 @@
 #include "Window.h"
 #include "GameEngineErrors.h"
+#include "Profiler.h"
 #include <iostream>
 
 namespace GameEngine
@@ -187,8 +188,18 @@ namespace GameEngine
 		}
 		void Window::SwapBuffer()
 		{
+				//waits for the GPU, or for the display with a swap interval
+				PROFILE_SCOPE("Window::SwapBuffer");
 				SDL_GL_SwapWindow(m_sdlWindow);
 		}
+		bool Window::SetVSync(bool _vsync)
+		{
+				if (!_vsync)
+				{
+						return SDL_GL_SetSwapInterval(0) == 0;
+				}
+				return SDL_GL_SetSwapInterval(-1) == 0 || SDL_GL_SetSwapInterval(1) == 0;
+		}
 		void Window::ChangeFullscreenState(const FullscreenState& _flags)
 		{
 				Uint32 screenType;
@@ -38,6 +38,8 @@ namespace GameEngine
 				void HandleEvent(SDL_Event& _event);
     //swap the buffer
     void SwapBuffer();
+    //the swap waits for the display's refresh, adaptively (a late frame tears instead of waiting a whole refresh) when the driver can
+    bool SetVSync(bool _vsync);
     //
     void ChangeFullscreenState(const FullscreenState& _flags);
 
@@ -47,6 +49,7 @@ namespace GameEngine
     //Getters
 				float GetAspectRatio()																const noexcept { return (float)m_screenWidth / (float)m_screenHeight; }
 				SDL_Window* GetWindow()															const noexcept { return m_sdlWindow;	 	 }
+				SDL_GLContext GetGLContext()											const noexcept { return m_glContext;	 	 }
 				int GetScreenWidth()																  const noexcept { return m_screenWidth;  }
     int GetScreenHeight()																	const noexcept { return m_screenHeight; }
 				bool HasMouseFocus()																		const noexcept { return m_mouseFocus;   }
@@ -0,0 +1,421 @@
+#include "MicroBenchmark.h"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <random>
+
+#include <AI_Game\Grid.h>
+#include <AI_Game\Heap.h>
+#include <GameEngine\AssetMap.h>
+#include <GameEngine\Component.h>
+#include <GameEngine\Entity.h>
+#include <GameEngine\EntityManager.h>
+#include <GameEngine\GLSLProgram.h>
+#include <GameEngine\ParticleBatch2D.h>
+#include <GameEngine\ResourceManager.h>
+#include <GameEngine\SpriteBatch.h>
+
+namespace
+{
+		//the same data every run, so the runs of two builds are comparable
+		constexpr unsigned int BENCHMARK_SEED = 1;
+
+		// SpriteBatch Begin/Draw/End with _state.GetArg() sprites over a few textures and depths, the vertices are uploaded but not drawn
+		void SpriteBatchFrame(BenchmarkState& _state, GameEngine::GlyphSortType _sortType)
+		{
+				const int numSprites = _state.GetArg();
+				std::mt19937 random(BENCHMARK_SEED);
+				std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+				std::uniform_int_distribution<int> texture(1, 8);
+				std::vector<glm::vec4> destRects(numSprites);
+				std::vector<GLuint> textures(numSprites);
+				std::vector<float> depths(numSprites);
+				for (int i = 0; i < numSprites; i++)
+				{
+						destRects[i] = glm::vec4(position(random), position(random), 32.0f, 32.0f);
+						//the ids are only sorted, nothing is bound
+						textures[i] = static_cast<GLuint>(texture(random));
+						depths[i] = position(random);
+				}
+				const glm::vec4 uvRect(0.0f, 0.0f, 1.0f, 1.0f);
+				const GameEngine::ColorRGBA8 color(255, 255);
+
+				GameEngine::SpriteBatch spriteBatch;
+				spriteBatch.Init();
+				while (_state.KeepRunning())
+				{
+						spriteBatch.Begin(_sortType);
+						for (int i = 0; i < numSprites; i++)
+						{
+								spriteBatch.Draw(destRects[i], uvRect, textures[i], depths[i], color);
+						}
+						spriteBatch.End();
+				}
+				glFinish();
+				spriteBatch.Dispose();
+				_state.SetItemsProcessed(_state.GetIterations() * numSprites);
+		}
+
+		// Pushes _state.GetArg() random values into a Heap and pops them all, like the open set of a search
+		void HeapPushPop(BenchmarkState& _state)
+		{
+				const int count = _state.GetArg();
+				std::mt19937 random(BENCHMARK_SEED);
+				std::vector<int> values(count);
+				for (int& value : values)
+				{
+						value = static_cast<int>(random() & 0xFFFFF);
+				}
+				Heap<int, std::vector<int>, std::greater<int>> heap;
+				while (_state.KeepRunning())
+				{
+						for (int value : values)
+						{
+								heap.Push(value);
+						}
+						while (!heap.IsEmpty())
+						{
+								DoNotOptimize(heap.Front());
+								heap.Pop();
+						}
+				}
+				_state.SetItemsProcessed(_state.GetIterations() * count);
+		}
+
+		// Heapifies _state.GetArg() values again after some of their priorities changed
+		void HeapUpdate(BenchmarkState& _state)
+		{
+				const int count = _state.GetArg();
+				std::mt19937 random(BENCHMARK_SEED);
+				Heap<int, std::vector<int>, std::greater<int>> heap;
+				for (int i = 0; i < count; i++)
+				{
+						heap.Push(static_cast<int>(random() & 0xFFFFF));
+				}
+				while (_state.KeepRunning())
+				{
+						//a tenth of the nodes found a cheaper path
+						_state.PauseTiming();
+						for (int i = 0; i < count / 10; i++)
+						{
+								heap.At(random() % count) -= 1;
+						}
+						_state.ResumeTiming();
+						heap.UpdateHeap();
+						DoNotOptimize(heap.Front());
+				}
+				_state.SetItemsProcessed(_state.GetIterations() * count);
+		}
+
+		// A _state.GetArg() squared grid with a fifth of the nodes walls, like a level
+		Grid MakeGrid(int _size)
+		{
+				Grid grid(_size, _size, 32.0f);
+				std::mt19937 random(BENCHMARK_SEED);
+				for (int y = 0; y < _size; y++)
+				{
+						for (int x = 0; x < _size; x++)
+						{
+								if (random() % 5 == 0)
+								{
+										grid.SetWalkableAt(glm::ivec2(x, y), false);
+								}
+						}
+				}
+				return grid;
+		}
+
+		// The neighbors of every node, with the diagonal mode of the zombies chosen at run time
+		void GridGetNeighbors(BenchmarkState& _state)
+		{
+				const Grid grid = MakeGrid(_state.GetArg());
+				const int numNodes = grid.GetNumNodes();
+				Grid::NeighborList neighbors;
+				while (_state.KeepRunning())
+				{
+						int total = 0;
+						for (int node = 0; node < numNodes; node++)
+						{
+								grid.GetNeighbors(node, Diagonal::IFNOWALLS, neighbors);
+								total += neighbors.size();
+						}
+						DoNotOptimize(total);
+				}
+				_state.SetItemsProcessed(_state.GetIterations() * numNodes);
+		}
+
+		// The same with the diagonal mode known at compile time, as the specialized searches call it
+		void GridGetNeighborsStatic(BenchmarkState& _state)
+		{
+				const Grid grid = MakeGrid(_state.GetArg());
+				const int numNodes = grid.GetNumNodes();
+				Grid::NeighborList neighbors;
+				while (_state.KeepRunning())
+				{
+						int total = 0;
+						for (int node = 0; node < numNodes; node++)
+						{
+								grid.GetNeighbors<Diagonal::IFNOWALLS>(node, neighbors);
+								total += neighbors.size();
+						}
+						DoNotOptimize(total);
+				}
+				_state.SetItemsProcessed(_state.GetIterations() * numNodes);
+		}
+
+		struct BenchmarkPosition : GameEngine::Component
+		{
+				void Init() override {}
+				void Update(float _deltaTime) override { m_position += m_velocity * _deltaTime; }
+				void Draw() override {}
+
+				glm::vec2 m_position{ 0.0f };
+				glm::vec2 m_velocity{ 1.0f, 0.5f };
+		};
+
+		struct BenchmarkHealth : GameEngine::Component
+		{
+				void Init() override {}
+				void Update(float _deltaTime) override { m_health = std::min(m_health + _deltaTime, 100.0f); }
+				void Draw() override {}
+
+				float m_health{ 50.0f };
+		};
+
+		GameEngine::Entity* AddBenchmarkEntity(GameEngine::EntityManager& _manager)
+		{
+				GameEngine::Entity* entity = _manager.AddEntity();
+				entity->AddComponent<BenchmarkPosition>();
+				entity->AddComponent<BenchmarkHealth>();
+				return entity;
+		}
+
+		// EntityManager::Update over _state.GetArg() entities with two components each
+		void EntityManagerUpdate(BenchmarkState& _state)
+		{
+				const int count = _state.GetArg();
+				GameEngine::EntityManager manager;
+				for (int i = 0; i < count; i++)
+				{
+						AddBenchmarkEntity(manager);
+				}
+				manager.Refresh();
+				while (_state.KeepRunning())
+				{
+						manager.Update(1.0f);
+				}
+				_state.SetItemsProcessed(_state.GetIterations() * count);
+		}
+
+		// EntityManager::Refresh after a tenth of _state.GetArg() entities died and as many spawned
+		void EntityManagerRefresh(BenchmarkState& _state)
+		{
+				const int count = _state.GetArg();
+				GameEngine::EntityManager manager;
+				std::vector<GameEngine::Entity*> entities;
+				for (int i = 0; i < count; i++)
+				{
+						entities.push_back(AddBenchmarkEntity(manager));
+				}
+				manager.Refresh();
+				std::mt19937 random(BENCHMARK_SEED);
+				while (_state.KeepRunning())
+				{
+						_state.PauseTiming();
+						for (int i = 0; i < std::max(count / 10, 1); i++)
+						{
+								GameEngine::Entity*& entity = entities[random() % entities.size()];
+								entity->Destroy();
+								entity = AddBenchmarkEntity(manager);
+						}
+						_state.ResumeTiming();
+						manager.Refresh();
+				}
+				_state.SetItemsProcessed(_state.GetIterations() * count);
+		}
+
+		// ParticleBatch2D::Update of _state.GetArg() particles which don't die, with _updateFunc or the SIMD kernel without one
+		void ParticleBatchUpdate(BenchmarkState& _state, std::function<void(GameEngine::Particle2D&, float)> _updateFunc)
+		{
+				const int count = _state.GetArg();
+				std::mt19937 random(BENCHMARK_SEED);
+				std::uniform_real_distribution<float> velocity(-1.0f, 1.0f);
+				GameEngine::ParticleBatch2D batch;
+				if (_updateFunc)
+				{
+						batch.Init(count, 0.0f, GameEngine::GLTexture(), _updateFunc);
+				}
+				else
+				{
+						batch.Init(count, 0.0f, GameEngine::GLTexture());
+				}
+				for (int i = 0; i < count; i++)
+				{
+						batch.AddParticle(glm::vec2(0.0f), glm::vec2(velocity(random), velocity(random)), GameEngine::ColorRGBA8(255, 255), 4.0f);
+				}
+				while (_state.KeepRunning())
+				{
+						batch.Update(0.01f);
+				}
+				_state.SetItemsProcessed(_state.GetIterations() * count);
+		}
+
+		const char* UNIFORM_VERTEX_SOURCE =
+				"#version 330 core\n"
+				"layout(location = 0) in vec2 vertexPosition;\n"
+				"uniform float time;\n"
+				"uniform vec2 offset;\n"
+				"void main() { gl_Position = vec4(vertexPosition + offset * time, 0.0, 1.0); }\n";
+		const char* UNIFORM_FRAGMENT_SOURCE =
+				"#version 330 core\n"
+				"uniform vec4 tint;\n"
+				"out vec4 color;\n"
+				"void main() { color = tint; }\n";
+
+		// GLSLProgram::UploadValue by the name of the uniform, the lookup included, or through a handle looked up once
+		void ProgramUploadValue(BenchmarkState& _state, bool _byHandle)
+		{
+				GameEngine::GLSLProgram program;
+				program.CompileShadersFromSource(UNIFORM_VERTEX_SOURCE, UNIFORM_FRAGMENT_SOURCE);
+				program.Use();
+				const GameEngine::UniformHandle time = program.GetUniform("time");
+				const GameEngine::UniformHandle offset = program.GetUniform("offset");
+				const GameEngine::UniformHandle tint = program.GetUniform("tint");
+				float value = 0.0f;
+				while (_state.KeepRunning())
+				{
+						value += 1.0f;
+						if (_byHandle)
+						{
+								program.UploadValue(time, value);
+								program.UploadValue(offset, glm::vec2(value));
+								program.UploadValue(tint, glm::vec4(value));
+						}
+						else
+						{
+								program.UploadValue("time", value);
+								program.UploadValue("offset", glm::vec2(value));
+								program.UploadValue("tint", glm::vec4(value));
+						}
+				}
+				program.UnUse();
+				program.Dispose();
+				_state.SetItemsProcessed(_state.GetIterations() * 3);
+		}
+
+		std::vector<std::string> MakeAssetPaths(int _count)
+		{
+				std::vector<std::string> paths;
+				for (int i = 0; i < _count; i++)
+				{
+						paths.push_back("Textures/Level/tile_" + std::to_string(i) + ".png");
+				}
+				return paths;
+		}
+
+		// What a cache hit costs: the hash of the path and the probe of the AssetMap of _state.GetArg() assets the caches key by it
+		void CacheLookup(BenchmarkState& _state)
+		{
+				const int count = _state.GetArg();
+				const std::vector<std::string> paths = MakeAssetPaths(count);
+				GameEngine::AssetMap<int> map;
+				for (int i = 0; i < count; i++)
+				{
+						map[GameEngine::AssetIds::Hash(paths[i])] = i;
+				}
+				std::mt19937 random(BENCHMARK_SEED);
+				std::vector<int> order(1024);
+				for (int& index : order)
+				{
+						index = static_cast<int>(random() % count);
+				}
+				while (_state.KeepRunning())
+				{
+						for (int index : order)
+						{
+								DoNotOptimize(map.Find(GameEngine::AssetIds::Hash(paths[index])));
+						}
+				}
+				_state.SetItemsProcessed(_state.GetIterations() * order.size());
+		}
+
+		// The same with the ids already hashed, as the code which keeps an AssetId looks them up
+		void CacheLookupById(BenchmarkState& _state)
+		{
+				const int count = _state.GetArg();
+				const std::vector<std::string> paths = MakeAssetPaths(count);
+				GameEngine::AssetMap<int> map;
+				std::vector<GameEngine::AssetId> ids;
+				for (int i = 0; i < count; i++)
+				{
+						ids.push_back(GameEngine::AssetIds::Hash(paths[i]));
+						map[ids.back()] = i;
+				}
+				std::mt19937 random(BENCHMARK_SEED);
+				std::vector<GameEngine::AssetId> order(1024);
+				for (GameEngine::AssetId& id : order)
+				{
+						id = ids[random() % count];
+				}
+				while (_state.KeepRunning())
+				{
+						for (GameEngine::AssetId id : order)
+						{
+								DoNotOptimize(map.Find(id));
+						}
+				}
+				_state.SetItemsProcessed(_state.GetIterations() * order.size());
+		}
+}
+
+void AddEngineBenchmarks(MicroBenchmarkRunner& _runner, const std::string& _texturePath)
+{
+		const std::vector<int> spriteCounts = { 1000, 10000, 100000 };
+		_runner.Add("SpriteBatch/TEXTURE", [](BenchmarkState& _state) { SpriteBatchFrame(_state, GameEngine::GlyphSortType::TEXTURE); },
+				spriteCounts, true);
+		_runner.Add("SpriteBatch/FRONT_TO_BACK", [](BenchmarkState& _state) { SpriteBatchFrame(_state, GameEngine::GlyphSortType::FRONT_TO_BACK); },
+				spriteCounts, true);
+		_runner.Add("SpriteBatch/NONE", [](BenchmarkState& _state) { SpriteBatchFrame(_state, GameEngine::GlyphSortType::NONE); },
+				spriteCounts, true);
+
+		_runner.Add("Heap/PushPop", HeapPushPop, { 64, 1024, 16384 });
+		_runner.Add("Heap/UpdateHeap", HeapUpdate, { 64, 1024, 16384 });
+
+		_runner.Add("Grid/GetNeighbors", GridGetNeighbors, { 64, 256 });
+		_runner.Add("Grid/GetNeighbors<IFNOWALLS>", GridGetNeighborsStatic, { 64, 256 });
+
+		_runner.Add("EntityManager/Update", EntityManagerUpdate, { 1000, 10000, 100000 });
+		_runner.Add("EntityManager/Refresh", EntityManagerRefresh, { 1000, 10000, 100000 });
+
+		_runner.Add("ParticleBatch2D/Update", [](BenchmarkState& _state) { ParticleBatchUpdate(_state, nullptr); }, { 1000, 10000, 100000 });
+		_runner.Add("ParticleBatch2D/UpdateCallback", [](BenchmarkState& _state)
+		{
+				ParticleBatchUpdate(_state, [](GameEngine::Particle2D& _particle, float _deltaTime)
+				{
+						_particle.m_velocity.y -= 0.1f * _deltaTime;
+						_particle.m_position += _particle.m_velocity * _deltaTime;
+				});
+		}, { 1000, 10000, 100000 });
+
+		_runner.Add("GLSLProgram/UploadValue(name)", [](BenchmarkState& _state) { ProgramUploadValue(_state, false); },
+				std::vector<int>(), true);
+		_runner.Add("GLSLProgram/UploadValue(handle)", [](BenchmarkState& _state) { ProgramUploadValue(_state, true); },
+				std::vector<int>(), true);
+
+		_runner.Add("Cache/Lookup", CacheLookup, { 64, 4096 });
+		_runner.Add("Cache/LookupById", CacheLookupById, { 64, 4096 });
+		//the whole Cache::GetTexture of a cached texture, with a real image since the first call loads it
+		if (!_texturePath.empty())
+		{
+				_runner.Add("Cache/GetTexture", [_texturePath](BenchmarkState& _state)
+				{
+						GameEngine::ResourceManager::GetTexture(_texturePath);
+						while (_state.KeepRunning())
+						{
+								DoNotOptimize(GameEngine::ResourceManager::GetTexture(_texturePath));
+						}
+						_state.SetItemsProcessed(_state.GetIterations());
+				}, std::vector<int>(), true);
+		}
+}
@@ -0,0 +1,107 @@
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include <GameEngine\GameEngine.h>
+#include <GameEngine\Window.h>
+
+#include "MicroBenchmark.h"
+
+namespace
+{
+		void PrintUsage()
+		{
+				std::printf("usage: MicroBenchmark [-filter text] [-mintime seconds] [-save file] [-compare file] [-texture file] [-nogl]\n"
+						"  -filter  - only runs the benchmarks whose name contains the text\n"
+						"  -mintime - the least time a measured run takes (0.5 by default)\n"
+						"  -save    - writes the results to the file, to compare a later build with\n"
+						"  -compare - prints the change of every benchmark against the results saved in the file\n"
+						"  -texture - an image for Cache/GetTexture, which is skipped without one\n"
+						"  -nogl    - doesn't create the hidden window, the benchmarks which need GL are skipped\n");
+		}
+}
+
+int main(int argc, char** argv)
+{
+		std::string filter;
+		double minSeconds = 0.5;
+		std::string savePath;
+		std::string comparePath;
+		std::string texturePath;
+		bool useGL = true;
+
+		for (int i = 1; i < argc; i++)
+		{
+				const std::string argument = argv[i];
+				const bool hasValue = i + 1 < argc;
+				if (argument == "-filter" && hasValue)
+				{
+						filter = argv[++i];
+				}
+				else if (argument == "-mintime" && hasValue)
+				{
+						minSeconds = std::atof(argv[++i]);
+				}
+				else if (argument == "-save" && hasValue)
+				{
+						savePath = argv[++i];
+				}
+				else if (argument == "-compare" && hasValue)
+				{
+						comparePath = argv[++i];
+				}
+				else if (argument == "-texture" && hasValue)
+				{
+						texturePath = argv[++i];
+				}
+				else if (argument == "-nogl")
+				{
+						useGL = false;
+				}
+				else
+				{
+						PrintUsage();
+						return 1;
+				}
+		}
+
+		try
+		{
+				std::vector<MicroBenchmarkResult> baseline;
+				if (!comparePath.empty())
+				{
+						baseline = MicroBenchmarkRunner::Load(comparePath);
+				}
+
+				//the GL benchmarks need a context, a hidden window gives them one
+				GameEngine::Init(!useGL);
+				GameEngine::Window window;
+				if (useGL)
+				{
+						window.Create("MicroBenchmark", 640, 480, GameEngine::WindowCreationFlags::INVISIBLE);
+				}
+
+				MicroBenchmarkRunner runner;
+				runner.SetFilter(filter);
+				runner.SetMinTime(minSeconds);
+				runner.SetHasGL(useGL);
+				AddEngineBenchmarks(runner, texturePath);
+				const std::vector<MicroBenchmarkResult> results = runner.Run(baseline);
+				if (!savePath.empty())
+				{
+						MicroBenchmarkRunner::Save(savePath, results);
+				}
+
+				if (useGL)
+				{
+						window.Close();
+				}
+		}
+		catch (const std::runtime_error& _error)
+		{
+				std::printf("%s\n", _error.what());
+				return 1;
+		}
+		return 0;
+}
@@ -0,0 +1,131 @@
+#include "MicroBenchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+		//the last byte DoNotOptimize read, a volatile write the compiler has to keep
+		volatile unsigned char g_sink = 0;
+
+		//the iterations never grow by more than this at a time, so a benchmark with a slow first run doesn't overshoot a lot
+		constexpr double MAX_GROWTH = 10.0;
+		constexpr std::uint64_t MAX_ITERATIONS = 1000000000;
+}
+
+void DoNotOptimize(const void* _value)
+{
+		g_sink = *static_cast<const volatile unsigned char*>(_value);
+}
+
+void MicroBenchmarkRunner::Add(const std::string& _name, Function _function, const std::vector<int>& _args, bool _needsGL)
+{
+		Benchmark benchmark;
+		benchmark.m_name = _name;
+		benchmark.m_function = std::move(_function);
+		benchmark.m_args = _args;
+		benchmark.m_needsGL = _needsGL;
+		m_benchmarks.push_back(std::move(benchmark));
+}
+
+std::vector<MicroBenchmarkResult> MicroBenchmarkRunner::Run(const std::vector<MicroBenchmarkResult>& _baseline)
+{
+		std::printf("%-44s %14s %12s %14s %9s\n", "benchmark", "ns/iteration", "iterations", "items/s", "change");
+		std::vector<MicroBenchmarkResult> results;
+		for (const Benchmark& benchmark : m_benchmarks)
+		{
+				if (!m_filter.empty() && benchmark.m_name.find(m_filter) == std::string::npos)
+				{
+						continue;
+				}
+				if (benchmark.m_needsGL && !m_hasGL)
+				{
+						std::printf("%-44s skipped, it needs a GL context\n", benchmark.m_name.c_str());
+						continue;
+				}
+				const std::vector<int> args = benchmark.m_args.empty() ? std::vector<int>(1, 0) : benchmark.m_args;
+				for (int arg : args)
+				{
+						MicroBenchmarkResult result = Measure(benchmark.m_function, arg);
+						result.m_name = benchmark.m_args.empty() ? benchmark.m_name : benchmark.m_name + "/" + std::to_string(arg);
+
+						std::printf("%-44s %14.1f %12llu ", result.m_name.c_str(), result.m_nanosecondsPerIteration,
+								static_cast<unsigned long long>(result.m_iterations));
+						if (result.m_itemsPerSecond > 0.0)
+						{
+								std::printf("%14.4g ", result.m_itemsPerSecond);
+						}
+						else
+						{
+								std::printf("%14s ", "-");
+						}
+						auto before = std::find_if(_baseline.begin(), _baseline.end(), [&result](const MicroBenchmarkResult& _before)
+						{
+								return _before.m_name == result.m_name;
+						});
+						if (before != _baseline.end() && before->m_nanosecondsPerIteration > 0.0)
+						{
+								//negative is faster
+								std::printf("%+8.1f%%", (result.m_nanosecondsPerIteration / before->m_nanosecondsPerIteration - 1.0) * 100.0);
+						}
+						std::printf("\n");
+						results.push_back(result);
+				}
+		}
+		return results;
+}
+
+MicroBenchmarkResult MicroBenchmarkRunner::Measure(const Function& _function, int _arg) const
+{
+		std::uint64_t iterations = 1;
+		while (true)
+		{
+				BenchmarkState state(_arg, iterations);
+				_function(state);
+				const double seconds = state.GetSeconds();
+				if (seconds >= m_minSeconds || iterations >= MAX_ITERATIONS)
+				{
+						MicroBenchmarkResult result;
+						result.m_iterations = iterations;
+						result.m_nanosecondsPerIteration = seconds * 1e9 / static_cast<double>(iterations);
+						result.m_itemsPerSecond = seconds > 0.0 ? static_cast<double>(state.GetItemsProcessed()) / seconds : 0.0;
+						return result;
+				}
+				//aims a bit past the minimum time from the speed of this run
+				const double growth = seconds > 0.0 ? std::min(m_minSeconds * 1.4 / seconds, MAX_GROWTH) : MAX_GROWTH;
+				iterations = std::min(std::max(static_cast<std::uint64_t>(static_cast<double>(iterations) * growth), iterations + 1),
+						MAX_ITERATIONS);
+		}
+}
+
+void MicroBenchmarkRunner::Save(const std::string& _filePath, const std::vector<MicroBenchmarkResult>& _results)
+{
+		std::ofstream file(_filePath.c_str());
+		if (file.fail())
+		{
+				throw std::runtime_error("File " + _filePath + " failed to open");
+		}
+		for (const MicroBenchmarkResult& result : _results)
+		{
+				file << result.m_name << ' ' << result.m_iterations << ' ' << result.m_nanosecondsPerIteration << ' '
+						<< result.m_itemsPerSecond << '\n';
+		}
+}
+
+std::vector<MicroBenchmarkResult> MicroBenchmarkRunner::Load(const std::string& _filePath)
+{
+		std::ifstream file(_filePath.c_str());
+		if (file.fail())
+		{
+				throw std::runtime_error("File " + _filePath + " failed to load");
+		}
+		std::vector<MicroBenchmarkResult> results;
+		MicroBenchmarkResult result;
+		while (file >> result.m_name >> result.m_iterations >> result.m_nanosecondsPerIteration >> result.m_itemsPerSecond)
+		{
+				results.push_back(result);
+		}
+		return results;
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/** \brief The loop of one benchmark run, in the style of Google Benchmark: the benchmark prepares its data, then times its work
+	*  with while (_state.KeepRunning()) { ... }. The runner calls it with more and more iterations until a run is long enough */
+class BenchmarkState
+{
+public:
+		BenchmarkState(int _arg, std::uint64_t _iterations) : m_arg(_arg), m_iterationsLeft(_iterations), m_iterations(_iterations) {}
+
+		/** \brief True while there are iterations left, the clock starts with the first call and stops with the last */
+		bool KeepRunning()
+		{
+				if (m_iterationsLeft == m_iterations && !m_running)
+				{
+						ResumeTiming();
+				}
+				if (m_iterationsLeft == 0)
+				{
+						PauseTiming();
+						return false;
+				}
+				m_iterationsLeft--;
+				return true;
+		}
+		/** \brief Leaves the work of an iteration out of the time (e.g. refilling what the iteration used up) */
+		void PauseTiming()
+		{
+				if (m_running)
+				{
+						m_elapsed += Clock::now() - m_start;
+						m_running = false;
+				}
+		}
+		void ResumeTiming()
+		{
+				if (!m_running)
+				{
+						m_start = Clock::now();
+						m_running = true;
+				}
+		}
+
+		/** \brief The argument of the run (e.g. the number of sprites), 0 for the benchmarks without one */
+		int GetArg() const noexcept { return m_arg; }
+		std::uint64_t GetIterations() const noexcept { return m_iterations; }
+		/** \brief The items all the iterations processed (e.g. sprites), printed as items per second */
+		void SetItemsProcessed(std::uint64_t _items) noexcept { m_items = _items; }
+		std::uint64_t GetItemsProcessed() const noexcept { return m_items; }
+		double GetSeconds() const { return std::chrono::duration<double>(m_elapsed).count(); }
+
+private:
+		using Clock = std::chrono::steady_clock;
+
+		int m_arg{ 0 };
+		std::uint64_t m_iterationsLeft{ 0 };
+		std::uint64_t m_iterations{ 0 };
+		std::uint64_t m_items{ 0 };
+		bool m_running{ false };
+		Clock::time_point m_start;
+		Clock::duration m_elapsed{ 0 };
+};
+
+/** \brief Keeps the compiler from optimizing away a result the benchmark doesn't use otherwise */
+void DoNotOptimize(const void* _value);
+template <typename T>
+void DoNotOptimize(const T& _value) { DoNotOptimize(static_cast<const void*>(&_value)); }
+
+/** \brief What one benchmark measured with one argument */
+struct MicroBenchmarkResult
+{
+		std::string m_name; ///< the name of the benchmark and its argument, e.g. Heap/PushPop/1024
+		std::uint64_t m_iterations{ 0 };
+		double m_nanosecondsPerIteration{ 0.0 };
+		double m_itemsPerSecond{ 0.0 }; ///< 0 if the benchmark doesn't count items
+};
+
+/** \brief The micro benchmarks of the engine's primitives and the runner timing them. Every benchmark runs with each of its arguments
+	*  until a run takes at least the minimum time, and the results can be saved and compared with the ones of an earlier build, so
+	*  an optimization comes with its before and after numbers */
+class MicroBenchmarkRunner
+{
+public:
+		using Function = std::function<void(BenchmarkState&)>;
+
+		/** \brief Adds a benchmark, run once per argument (once with 0 without any)
+		* \param _needsGL - it makes GL calls, it's skipped when the runner has no context
+		*/
+		void Add(const std::string& _name, Function _function, const std::vector<int>& _args = std::vector<int>(), bool _needsGL = false);
+
+		void SetMinTime(double _seconds) noexcept { m_minSeconds = _seconds; }
+		/** \brief Only the benchmarks whose name contains _filter run, all of them if it's empty */
+		void SetFilter(const std::string& _filter) { m_filter = _filter; }
+		void SetHasGL(bool _hasGL) noexcept { m_hasGL = _hasGL; }
+
+		/** \brief Runs the benchmarks and prints a row per run, with the change against _baseline if it has the same run */
+		std::vector<MicroBenchmarkResult> Run(const std::vector<MicroBenchmarkResult>& _baseline = std::vector<MicroBenchmarkResult>());
+
+		/** \brief Writes the results, one "name iterations nanoseconds items" line per run, for a later -compare */
+		static void Save(const std::string& _filePath, const std::vector<MicroBenchmarkResult>& _results);
+		/** \brief Reads the results Save wrote (throws std::runtime_error if the file can't be read) */
+		static std::vector<MicroBenchmarkResult> Load(const std::string& _filePath);
+
+private:
+		struct Benchmark
+		{
+				std::string m_name;
+				Function m_function;
+				std::vector<int> m_args;
+				bool m_needsGL{ false };
+		};
+
+		/** \brief Runs _function with more iterations until a run takes m_minSeconds */
+		MicroBenchmarkResult Measure(const Function& _function, int _arg) const;
+
+		std::vector<Benchmark> m_benchmarks;
+		std::string m_filter;
+		double m_minSeconds{ 0.5 };
+		bool m_hasGL{ false };
+};
+
+/** \brief Adds the benchmarks of the engine's primitives (see EngineBenchmarks.cpp) */
+void AddEngineBenchmarks(MicroBenchmarkRunner& _runner, const std::string& _texturePath);
@@ -0,0 +1,153 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "PathBenchmark.h"
+
+namespace
+{
+		void PrintUsage()
+		{
+				std::printf("usage: PathBenchmark [level] [-queries n] [-seed n] [-diagonal ALWAYS|NEVER|IFNOWALLS|IFLESSTHANTWOWALLS]\n"
+						"                     [-replay file] [-record file] [-algorithm name] [-landmarks n] [-replan]\n"
+						"  level      - the level file, ../AI_Game/Levels/level1.txt by default\n"
+						"  -queries   - the number of random start/goal pairs (1000 by default)\n"
+						"  -seed      - the seed of the random pairs (1 by default)\n"
+						"  -diagonal  - the diagonal movement (IFNOWALLS by default, like the zombies)\n"
+						"  -replay    - runs the pairs recorded in the file instead of random ones\n"
+						"  -record    - writes the pairs to the file, so the run can be replayed\n"
+						"  -algorithm - only runs this algorithm (the names of the table)\n"
+						"  -landmarks - bounds the heuristic of ASTAR with this many landmarks (none by default)\n"
+						"  -replan    - also blocks the middle of every path and times the D* Lite repair against a new A* search\n");
+		}
+
+		bool ParseDiagonal(const char* _name, Diagonal& _diagonal)
+		{
+				const char* names[] = { "ALWAYS", "NEVER", "IFNOWALLS", "IFLESSTHANTWOWALLS" };
+				for (size_t i = 0; i < 4; i++)
+				{
+						if (std::strcmp(_name, names[i]) == 0)
+						{
+								_diagonal = static_cast<Diagonal>(i + 1);
+								return true;
+						}
+				}
+				return false;
+		}
+}
+
+int main(int argc, char** argv)
+{
+		std::string levelPath = "../AI_Game/Levels/level1.txt";
+		size_t numQueries = 1000;
+		unsigned int seed = 1;
+		Diagonal diagonal = Diagonal::IFNOWALLS;
+		std::string replayPath;
+		std::string recordPath;
+		std::string algorithmName;
+		bool replan = false;
+		int numLandmarks = 0;
+
+		for (int i = 1; i < argc; i++)
+		{
+				const std::string argument = argv[i];
+				const bool hasValue = i + 1 < argc;
+				if (argument == "-queries" && hasValue)
+				{
+						numQueries = std::strtoul(argv[++i], nullptr, 10);
+				}
+				else if (argument == "-seed" && hasValue)
+				{
+						seed = std::strtoul(argv[++i], nullptr, 10);
+				}
+				else if (argument == "-diagonal" && hasValue)
+				{
+						if (!ParseDiagonal(argv[++i], diagonal))
+						{
+								PrintUsage();
+								return 1;
+						}
+				}
+				else if (argument == "-replay" && hasValue)
+				{
+						replayPath = argv[++i];
+				}
+				else if (argument == "-record" && hasValue)
+				{
+						recordPath = argv[++i];
+				}
+				else if (argument == "-algorithm" && hasValue)
+				{
+						algorithmName = argv[++i];
+				}
+				else if (argument == "-landmarks" && hasValue)
+				{
+						numLandmarks = std::atoi(argv[++i]);
+				}
+				else if (argument == "-replan")
+				{
+						replan = true;
+				}
+				else if (argument[0] != '-')
+				{
+						levelPath = argument;
+				}
+				else
+				{
+						PrintUsage();
+						return 1;
+				}
+		}
+
+		try
+		{
+				PathBenchmark benchmark(levelPath, diagonal);
+				if (replayPath.empty())
+				{
+						benchmark.GenerateQueries(numQueries, seed);
+				}
+				else
+				{
+						benchmark.LoadQueries(replayPath);
+				}
+				if (!recordPath.empty())
+				{
+						benchmark.SaveQueries(recordPath);
+				}
+				benchmark.SetLandmarks(numLandmarks);
+
+				std::printf("%s, %u queries\n", levelPath.c_str(), unsigned(benchmark.GetNumQueries()));
+				PathBenchmark::PrintHeader();
+				bool ranAny = false;
+				for (const Algorithm& algorithm : PathBenchmark::GetAlgorithms())
+				{
+						if (algorithmName.empty() || algorithmName == PathBenchmark::GetName(algorithm))
+						{
+								PathBenchmark::Print(benchmark.Run(algorithm));
+								if (PathBenchmark::HasOpenSetChoice(algorithm))
+								{
+										//the same queries with the bucket queue, against the binary heap of the row before
+										PathBenchmark::Print(benchmark.Run(algorithm, OpenSet::BUCKETS));
+								}
+								ranAny = true;
+						}
+				}
+				if (!ranAny)
+				{
+						std::printf("Unknown algorithm %s\n", algorithmName.c_str());
+						return 1;
+				}
+				if (replan)
+				{
+						PathBenchmark::Print(benchmark.RunReplanning());
+				}
+		}
+		catch (const std::runtime_error& _error)
+		{
+				std::printf("%s\n", _error.what());
+				return 1;
+		}
+		return 0;
+}
@@ -0,0 +1,465 @@
+#include "PathBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <new>
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+		//every operator new of the program goes through these, so the benchmark can count the allocations of a query
+		size_t g_numAllocations = 0;
+		size_t g_numAllocatedBytes = 0;
+
+		//the same cluster size as World's hierarchy
+		constexpr int BENCHMARK_CLUSTER_SIZE = 16;
+		constexpr float BENCHMARK_NODE_DIAMETER = 32.0f;
+}
+
+void* operator new(size_t _size)
+{
+		g_numAllocations++;
+		g_numAllocatedBytes += _size;
+		if (void* memory = std::malloc(_size == 0 ? 1 : _size))
+		{
+				return memory;
+		}
+		throw std::bad_alloc();
+}
+
+void operator delete(void* _memory) noexcept
+{
+		std::free(_memory);
+}
+
+PathBenchmark::PathBenchmark(const std::string& _levelPath, const Diagonal& _diagonal) :
+		m_diagonal(_diagonal)
+{
+		std::ifstream file(_levelPath.c_str());
+		if (file.fail())
+		{
+				throw std::runtime_error("File " + _levelPath + " failed to load");
+		}
+
+		std::vector<std::string> terrainData;
+		std::string terrainLine;
+		while (std::getline(file, terrainLine))
+		{
+				//the levels have windows line endings, which only the text mode of the windows runtime strips
+				if (!terrainLine.empty() && terrainLine.back() == '\r')
+				{
+						terrainLine.pop_back();
+				}
+				terrainData.push_back(terrainLine);
+		}
+		if (terrainData.empty())
+		{
+				throw std::runtime_error("File " + _levelPath + " is empty");
+		}
+
+		const size_t width = terrainData.at(0).size();
+		const size_t height = terrainData.size();
+		m_grid = std::make_shared<Grid>(width, height, BENCHMARK_NODE_DIAMETER);
+
+		//the walkability and the costs of the terrains of World
+		for (size_t i = 0; i < width * height; i++)
+		{
+				const int x = i % width;
+				const int y = i / width;
+				const char tile = terrainData.at(y).at(x);
+				switch (tile)
+				{
+				case 'b':
+				case 'B':
+				case 'g':
+				case 'G':
+				case 'l':
+				case 'L':
+						m_grid->SetWalkableAt(glm::ivec2(x, y), false);
+						m_grid->SetTerrainCost(glm::ivec2(x, y), 1);
+						break;
+				case 'w':
+				case 'W':
+						m_grid->SetWalkableAt(glm::ivec2(x, y), true);
+						m_grid->SetTerrainCost(glm::ivec2(x, y), 5);
+						break;
+				case '@':
+				case 'z':
+				case 'Z':
+				case 'p':
+				case 'P':
+				case '.':
+						m_grid->SetWalkableAt(glm::ivec2(x, y), true);
+						m_grid->SetTerrainCost(glm::ivec2(x, y), 1);
+						break;
+				default:
+						std::printf("Unexpected symbol %c at (%d,%d)\n", tile, x, y);
+						break;
+				}
+		}
+
+		m_hierarchy = std::make_shared<HierarchicalGrid>(m_grid, BENCHMARK_CLUSTER_SIZE, m_diagonal);
+		m_flowField = FlowField(m_grid, m_diagonal);
+}
+
+void PathBenchmark::GenerateQueries(size_t _count, unsigned int _seed)
+{
+		std::vector<int> walkable;
+		for (int i = 0; i < m_grid->GetNumNodes(); i++)
+		{
+				if (m_grid->IsWalkable(i))
+				{
+						walkable.push_back(i);
+				}
+		}
+		m_queries.clear();
+		if (walkable.empty())
+		{
+				return;
+		}
+
+		std::mt19937 generator(_seed);
+		std::uniform_int_distribution<size_t> pick(0, walkable.size() - 1);
+		for (size_t i = 0; i < _count; i++)
+		{
+				BenchmarkQuery query;
+				query.m_start = m_grid->GetCoord(walkable[pick(generator)]);
+				query.m_end = m_grid->GetCoord(walkable[pick(generator)]);
+				m_queries.push_back(query);
+		}
+}
+
+void PathBenchmark::LoadQueries(const std::string& _filePath)
+{
+		std::ifstream file(_filePath.c_str());
+		if (file.fail())
+		{
+				throw std::runtime_error("File " + _filePath + " failed to load");
+		}
+
+		m_queries.clear();
+		BenchmarkQuery query;
+		while (file >> query.m_start.x >> query.m_start.y >> query.m_end.x >> query.m_end.y)
+		{
+				if (!m_grid->IsWalkableAt(query.m_start) || !m_grid->IsWalkableAt(query.m_end))
+				{
+						//recorded on another version of the level, there is nothing to measure
+						std::printf("Skipping the query (%d,%d) to (%d,%d), it isn't walkable\n", query.m_start.x, query.m_start.y, query.m_end.x, query.m_end.y);
+						continue;
+				}
+				m_queries.push_back(query);
+		}
+}
+
+void PathBenchmark::SaveQueries(const std::string& _filePath) const
+{
+		std::ofstream file(_filePath.c_str());
+		if (file.fail())
+		{
+				throw std::runtime_error("File " + _filePath + " failed to open");
+		}
+		for (const auto& query : m_queries)
+		{
+				file << query.m_start.x << ' ' << query.m_start.y << ' ' << query.m_end.x << ' ' << query.m_end.y << '\n';
+		}
+}
+
+void PathBenchmark::SetLandmarks(int _count)
+{
+		m_landmarks = _count > 0 ? std::make_shared<LandmarkTable>(m_grid, _count, m_diagonal) : nullptr;
+		m_pathFinder.SetLandmarks(m_landmarks);
+}
+
+BenchmarkResult PathBenchmark::Run(const Algorithm& _algorithm, OpenSet _openSet)
+{
+		BenchmarkResult result;
+		result.m_algorithm = _algorithm;
+		result.m_openSet = _openSet;
+		m_pathFinder.SetAStarOpenSet(_openSet);
+		m_pathFinder.SetDijkstraOpenSet(_openSet);
+		result.m_numQueries = m_queries.size();
+		if (m_queries.empty())
+		{
+				return result;
+		}
+
+		//warm up, so the context and the open sets already have their capacity like in a running game
+		Solve(_algorithm, m_grid->GetIndex(m_queries.front().m_start), m_grid->GetIndex(m_queries.front().m_end));
+
+		std::vector<double> latencies;
+		latencies.reserve(m_queries.size());
+		double totalExpanded = 0.0;
+		double totalVisited = 0.0;
+		double totalLength = 0.0;
+		size_t totalAllocations = 0;
+		size_t totalBytes = 0;
+
+		for (const auto& query : m_queries)
+		{
+				const int start = m_grid->GetIndex(query.m_start);
+				const int end = m_grid->GetIndex(query.m_end);
+
+				const size_t allocations = g_numAllocations;
+				const size_t bytes = g_numAllocatedBytes;
+				const auto begin = std::chrono::steady_clock::now();
+				const std::vector<int> path = Solve(_algorithm, start, end);
+				const auto finish = std::chrono::steady_clock::now();
+				//the returned path is one of the allocations of the query
+				totalAllocations += g_numAllocations - allocations;
+				totalBytes += g_numAllocatedBytes - bytes;
+
+				latencies.push_back(std::chrono::duration<double, std::micro>(finish - begin).count());
+				int expanded = 0;
+				int visited = 0;
+				CountNodes(_algorithm, expanded, visited);
+				totalExpanded += expanded;
+				totalVisited += visited;
+				if (!path.empty() || start == end)
+				{
+						result.m_numFound++;
+						totalLength += path.size();
+				}
+		}
+
+		const double numQueries = double(m_queries.size());
+		result.m_expandedPerQuery = totalExpanded / numQueries;
+		result.m_visitedPerQuery = totalVisited / numQueries;
+		result.m_pathLengthPerQuery = result.m_numFound ? totalLength / double(result.m_numFound) : 0.0;
+		result.m_allocationsPerQuery = double(totalAllocations) / numQueries;
+		result.m_bytesPerQuery = double(totalBytes) / numQueries;
+
+		double totalLatency = 0.0;
+		for (double latency : latencies)
+		{
+				totalLatency += latency;
+		}
+		result.m_meanMicroseconds = totalLatency / numQueries;
+		std::sort(latencies.begin(), latencies.end());
+		result.m_p50Microseconds = latencies[latencies.size() / 2];
+		result.m_p99Microseconds = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+		return result;
+}
+
+ReplanResult PathBenchmark::RunReplanning()
+{
+		ReplanResult result;
+		//the A* searches it's compared with are the game's, on the binary heap
+		m_pathFinder.SetAStarOpenSet(OpenSet::BINARY_HEAP);
+		std::vector<double> repairLatencies;
+		std::vector<double> searchLatencies;
+		double totalRepairExpanded = 0.0;
+		double totalSearchExpanded = 0.0;
+
+		for (const auto& query : m_queries)
+		{
+				const int start = m_grid->GetIndex(query.m_start);
+				const int end = m_grid->GetIndex(query.m_end);
+				m_planner.Begin(start, end, *m_grid, m_diagonal);
+				if (m_planner.Run() != DStarLite::Status::FOUND)
+				{
+						continue;
+				}
+				const std::vector<int> path = m_planner.GetPath();
+				if (path.size() < 3)
+				{
+						//nothing to block between the start and the end
+						continue;
+				}
+				const glm::ivec2 blocked = m_grid->GetCoord(path[path.size() / 2]);
+				m_grid->SetWalkableAt(blocked, false);
+
+				const size_t expanded = m_planner.GetNumExpanded();
+				auto begin = std::chrono::steady_clock::now();
+				const DStarLite::Status status = m_planner.Run();
+				auto finish = std::chrono::steady_clock::now();
+				repairLatencies.push_back(std::chrono::duration<double, std::micro>(finish - begin).count());
+				totalRepairExpanded += double(m_planner.GetNumExpanded() - expanded);
+
+				begin = std::chrono::steady_clock::now();
+				const std::vector<int> searched = Solve(Algorithm::ASTAR, start, end);
+				finish = std::chrono::steady_clock::now();
+				searchLatencies.push_back(std::chrono::duration<double, std::micro>(finish - begin).count());
+				int visited = 0;
+				int closed = 0;
+				m_context.CountNodes(visited, closed);
+				totalSearchExpanded += closed;
+
+				const bool repaired = status == DStarLite::Status::FOUND;
+				if (repaired != !searched.empty() || (repaired && m_planner.GetCost() != GetPathCost(start, searched)))
+				{
+						result.m_numMismatches++;
+				}
+				m_grid->SetWalkableAt(blocked, true);
+				result.m_numQueries++;
+		}
+		if (result.m_numQueries == 0)
+		{
+				return result;
+		}
+
+		const double numQueries = double(result.m_numQueries);
+		result.m_repairExpandedPerQuery = totalRepairExpanded / numQueries;
+		result.m_searchExpandedPerQuery = totalSearchExpanded / numQueries;
+		double totalRepair = 0.0;
+		double totalSearch = 0.0;
+		for (size_t i = 0; i < result.m_numQueries; i++)
+		{
+				totalRepair += repairLatencies[i];
+				totalSearch += searchLatencies[i];
+		}
+		result.m_repairMeanMicroseconds = totalRepair / numQueries;
+		result.m_searchMeanMicroseconds = totalSearch / numQueries;
+		std::sort(repairLatencies.begin(), repairLatencies.end());
+		std::sort(searchLatencies.begin(), searchLatencies.end());
+		result.m_repairP50Microseconds = repairLatencies[repairLatencies.size() / 2];
+		result.m_searchP50Microseconds = searchLatencies[searchLatencies.size() / 2];
+		return result;
+}
+
+std::vector<int> PathBenchmark::Solve(const Algorithm& _algorithm, int _start, int _end)
+{
+		switch (_algorithm)
+		{
+				case Algorithm::BEST_FIRST:
+						return m_pathFinder.BestFirst(_start, _end, *m_grid, m_diagonal, m_context);
+				case Algorithm::ASTAR:
+						return m_pathFinder.AStar(_start, _end, *m_grid, m_diagonal, m_context);
+				case Algorithm::ASTARe:
+						return m_pathFinder.AStarEpsilon(_start, _end, *m_grid, m_diagonal, m_context);
+				case Algorithm::BREADTH_FIRST:
+						return m_pathFinder.BreadthFirst(_start, _end, *m_grid, m_diagonal, m_context);
+				case Algorithm::DEPTH_FIRST:
+						return m_pathFinder.DepthFirst(_start, _end, *m_grid, m_diagonal, m_context);
+				case Algorithm::DIJKSTRA:
+						return m_pathFinder.Dijkstra(_start, _end, *m_grid, m_diagonal, m_context);
+				case Algorithm::GREEDY_BEST_FIRST:
+						return m_pathFinder.GreedyBFirst(_start, _end, *m_grid, m_diagonal, m_context);
+				case Algorithm::JUMP_POINT:
+						return m_pathFinder.JumpPoint(_start, _end, *m_grid, m_diagonal, m_context);
+				case Algorithm::HIERARCHICAL:
+						return m_hierarchy->FindPath(_start, _end, m_context);
+				case Algorithm::FLOW_FIELD:
+				{
+						//the whole field towards the goal (kept if the goal didn't change), then the start follows it
+						m_flowField.SetGoal(m_grid->GetWorldPos(_end));
+						while (m_flowField.IsUpdating())
+						{
+								m_flowField.Update(std::numeric_limits<size_t>::max());
+						}
+						std::vector<int> path;
+						for (int node = m_flowField.GetNextNode(_start); node != -1 && path.size() < size_t(m_grid->GetNumNodes()); node = m_flowField.GetNextNode(node))
+						{
+								path.push_back(node);
+								if (node == _end)
+								{
+										break;
+								}
+						}
+						if (path.empty() || path.back() != _end)
+						{
+								return std::vector<int>();
+						}
+						std::reverse(path.begin(), path.end());
+						return path;
+				}
+				case Algorithm::BIDIRECTIONAL_ASTAR:
+						return m_pathFinder.BiAStar(_start, _end, *m_grid, m_diagonal, m_context);
+				case Algorithm::BIDIRECTIONAL_BREADTH_FIRST:
+						return m_pathFinder.BiBreadthFirst(_start, _end, *m_grid, m_diagonal, m_context);
+				default:
+						return std::vector<int>();
+		}
+}
+
+void PathBenchmark::CountNodes(const Algorithm& _algorithm, int& _expanded, int& _visited) const
+{
+		if (_algorithm == Algorithm::FLOW_FIELD)
+		{
+				//the field covers every node which can reach the goal
+				_visited = 0;
+				for (int i = 0; i < m_grid->GetNumNodes(); i++)
+				{
+						_visited += m_flowField.GetNextNode(i) != -1 ? 1 : 0;
+				}
+				_expanded = _visited;
+				return;
+		}
+		//for HIERARCHICAL this is the last search of the query (the refinement of its last abstract edge)
+		m_context.CountNodes(_visited, _expanded);
+}
+
+int PathBenchmark::GetPathCost(int _start, const std::vector<int>& _path) const
+{
+		const PathFinder::Heuristic stepCost = PathFinder::SelectHeuristic(m_diagonal);
+		int cost = 0;
+		int previous = _start;
+		for (auto node = _path.rbegin(); node != _path.rend(); ++node)
+		{
+				cost += stepCost(m_grid->GetCoord(previous), m_grid->GetCoord(*node)) + m_grid->GetTerrainCost(*node);
+				previous = *node;
+		}
+		return cost;
+}
+
+std::vector<Algorithm> PathBenchmark::GetAlgorithms()
+{
+		return { Algorithm::BEST_FIRST, Algorithm::ASTAR, Algorithm::ASTARe, Algorithm::BREADTH_FIRST, Algorithm::DEPTH_FIRST,
+				Algorithm::DIJKSTRA, Algorithm::GREEDY_BEST_FIRST, Algorithm::JUMP_POINT, Algorithm::HIERARCHICAL, Algorithm::FLOW_FIELD,
+				Algorithm::BIDIRECTIONAL_ASTAR, Algorithm::BIDIRECTIONAL_BREADTH_FIRST };
+}
+
+const char* PathBenchmark::GetName(const Algorithm& _algorithm)
+{
+		switch (_algorithm)
+		{
+				case Algorithm::BEST_FIRST: return "BEST.FIRST";
+				case Algorithm::ASTAR: return "ASTAR";
+				case Algorithm::ASTARe: return "ASTARe";
+				case Algorithm::BREADTH_FIRST: return "BREADTH.FIRST";
+				case Algorithm::DEPTH_FIRST: return "DEPTH.FIRST";
+				case Algorithm::DIJKSTRA: return "DIJKSTRA";
+				case Algorithm::GREEDY_BEST_FIRST: return "GREEDY.BEST.FIRST";
+				case Algorithm::JUMP_POINT: return "JUMP.POINT";
+				case Algorithm::HIERARCHICAL: return "HIERARCHICAL";
+				case Algorithm::FLOW_FIELD: return "FLOW.FIELD";
+				case Algorithm::BIDIRECTIONAL_ASTAR: return "BI.ASTAR";
+				case Algorithm::BIDIRECTIONAL_BREADTH_FIRST: return "BI.BREADTH.FIRST";
+				default: return "UNKNOWN";
+		}
+}
+
+bool PathBenchmark::HasOpenSetChoice(const Algorithm& _algorithm)
+{
+		return _algorithm == Algorithm::ASTAR || _algorithm == Algorithm::DIJKSTRA;
+}
+
+void PathBenchmark::PrintHeader()
+{
+		std::printf("%-18s %7s %10s %10s %8s %9s %9s %9s %9s %10s\n",
+				"algorithm", "found", "expanded", "visited", "length", "p50 us", "p99 us", "mean us", "allocs", "bytes");
+}
+
+void PathBenchmark::Print(const BenchmarkResult& _result)
+{
+		std::string name = GetName(_result.m_algorithm);
+		if (_result.m_openSet == OpenSet::BUCKETS)
+		{
+				name += ".BUCKETS";
+		}
+		std::printf("%-18s %7u %10.1f %10.1f %8.1f %9.2f %9.2f %9.2f %9.2f %10.1f\n",
+				name.c_str(), unsigned(_result.m_numFound), _result.m_expandedPerQuery, _result.m_visitedPerQuery,
+				_result.m_pathLengthPerQuery, _result.m_p50Microseconds, _result.m_p99Microseconds, _result.m_meanMicroseconds,
+				_result.m_allocationsPerQuery, _result.m_bytesPerQuery);
+}
+
+void PathBenchmark::Print(const ReplanResult& _result)
+{
+		std::printf("replanning %u blocked paths: D* Lite repair p50 %.2f us mean %.2f us expanded %.1f, A* search p50 %.2f us mean %.2f us expanded %.1f, mismatches %u\n",
+				unsigned(_result.m_numQueries), _result.m_repairP50Microseconds, _result.m_repairMeanMicroseconds, _result.m_repairExpandedPerQuery,
+				_result.m_searchP50Microseconds, _result.m_searchMeanMicroseconds, _result.m_searchExpandedPerQuery, unsigned(_result.m_numMismatches));
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <AI_Game\DStarLite.h>
+#include <AI_Game\PathRequestManager.h>
+
+/** \brief The start and goal node of one benchmark query (x,y indices in the grid) */
+struct BenchmarkQuery
+{
+		glm::ivec2 m_start{ 0, 0 };
+		glm::ivec2 m_end{ 0, 0 };
+};
+
+/** \brief What one algorithm measured over all the queries */
+struct BenchmarkResult
+{
+		Algorithm m_algorithm{ Algorithm::ASTAR };
+		OpenSet m_openSet{ OpenSet::BINARY_HEAP }; ///< the open set of ASTAR and DIJKSTRA, the others ignore it
+		size_t m_numQueries{ 0 };
+		size_t m_numFound{ 0 };
+		double m_expandedPerQuery{ 0.0 };   ///< the nodes closed by the search (the jump points for JUMP_POINT, the field for FLOW_FIELD, 0 without a closed set like BFS)
+		double m_visitedPerQuery{ 0.0 };    ///< the nodes the search touched at all
+		double m_pathLengthPerQuery{ 0.0 }; ///< the nodes of the found paths
+		double m_p50Microseconds{ 0.0 };
+		double m_p99Microseconds{ 0.0 };
+		double m_meanMicroseconds{ 0.0 };
+		double m_allocationsPerQuery{ 0.0 }; ///< the operator new calls during the queries
+		double m_bytesPerQuery{ 0.0 };
+};
+
+/** \brief What the incremental replanning measured: a wall is put in the middle of every path, then DStarLite repairs its path
+	*  and A* searches again from scratch */
+struct ReplanResult
+{
+		size_t m_numQueries{ 0 }; ///< the queries with a path long enough to block
+		size_t m_numMismatches{ 0 }; ///< the repaired paths which don't cost the same as the new A* path
+		double m_repairExpandedPerQuery{ 0.0 };
+		double m_repairP50Microseconds{ 0.0 };
+		double m_repairMeanMicroseconds{ 0.0 };
+		double m_searchExpandedPerQuery{ 0.0 };
+		double m_searchP50Microseconds{ 0.0 };
+		double m_searchMeanMicroseconds{ 0.0 };
+};
+
+/** \brief Runs the PathFinder searches over a level of the game without a window, to measure and regression test them.
+	*  The grid is built from the level file like World::LoadTerrainFromFile builds it, and every algorithm answers the same
+	*  queries with a reused SearchContext, like the workers of the PathRequestManager do */
+class PathBenchmark
+{
+public:
+		/** \brief Loads the level (throws std::runtime_error if it can't be read)
+		* \param _diagonal - the movement of all the searches (and of the hierarchy and the flow field)
+		*/
+		PathBenchmark(const std::string& _levelPath, const Diagonal& _diagonal);
+
+		/** \brief Replaces the queries with _count random pairs of walkable nodes (the same seed gives the same pairs) */
+		void GenerateQueries(size_t _count, unsigned int _seed);
+		/** \brief Replaces the queries with recorded ones, one "startX startY endX endY" line per query (throws if the file can't be read) */
+		void LoadQueries(const std::string& _filePath);
+		/** \brief Records the queries in the format of LoadQueries, so a run can be replayed later */
+		void SaveQueries(const std::string& _filePath) const;
+		size_t GetNumQueries() const noexcept { return m_queries.size(); }
+
+		/** \brief Builds _count landmarks (see LandmarkTable) for the heuristic of ASTAR, 0 removes them */
+		void SetLandmarks(int _count);
+
+		/** \brief Runs all the queries with _algorithm, the first one runs twice so the timings don't include the first allocation of the context
+		* \param _openSet - the open set of ASTAR and DIJKSTRA (see PathFinder::SetAStarOpenSet)
+		*/
+		BenchmarkResult Run(const Algorithm& _algorithm, OpenSet _openSet = OpenSet::BINARY_HEAP);
+
+		/** \brief Plans every query with DStarLite, blocks the node in the middle of its path and times the repair against a new A* search
+			*  (the node is walkable again afterwards) */
+		ReplanResult RunReplanning();
+
+		/** \brief All the algorithms of the Algorithm enum, in its order */
+		static std::vector<Algorithm> GetAlgorithms();
+		/** \brief The name of an algorithm as printed in the table (and accepted by the -algorithm option) */
+		static const char* GetName(const Algorithm& _algorithm);
+		/** \brief Check if the open set of the algorithm can be chosen, so it's run with both */
+		static bool HasOpenSetChoice(const Algorithm& _algorithm);
+
+		static void PrintHeader();
+		static void Print(const BenchmarkResult& _result);
+		static void Print(const ReplanResult& _result);
+
+private:
+		/** \brief Solves one query, the path is the node indices from the end to (not including) the start like PathFinder returns them */
+		std::vector<int> Solve(const Algorithm& _algorithm, int _start, int _end);
+		/** \brief Counts the nodes the last Solve() expanded and touched (not timed) */
+		void CountNodes(const Algorithm& _algorithm, int& _expanded, int& _visited) const;
+		/** \brief The cost of a path in the order Solve() returns it, the same costs the searches use */
+		int GetPathCost(int _start, const std::vector<int>& _path) const;
+
+		std::shared_ptr<Grid> m_grid;
+		std::shared_ptr<HierarchicalGrid> m_hierarchy; ///< the abstraction for HIERARCHICAL, with the same cluster size as the game's
+		std::shared_ptr<LandmarkTable> m_landmarks; ///< the landmarks of ASTAR, none unless SetLandmarks built them
+		FlowField m_flowField;
+		PathFinder m_pathFinder;
+		SearchContext m_context; ///< reused by all the queries
+		DStarLite m_planner; ///< for RunReplanning, an agent would keep its own
+		Diagonal m_diagonal;
+		std::vector<BenchmarkQuery> m_queries;
+};
@@ -18,6 +18,10 @@ void App::OnInit()
   m_screenWidth = 960;
   m_screenHeight = 540;
   m_windowFlags = GameEngine::WindowCreationFlags::RESIZABLE;
+#ifdef _DEBUG
+  //the edited textures, models and shaders show up without a restart
+  m_hotReload = true;
+#endif
   
 }
 // called when exiting
@@ -0,0 +1,56 @@
+#include "ClientPrediction.h"
+
+#include <algorithm>
+#include <glm\gtc\quaternion.hpp>
+
+void ClientPrediction::ApplyInput(EntityState& _state, const PlayerInput& _input)
+{
+  //the move is along the facing, which turns about the up axis
+  _state.orientation = glm::angleAxis(_input.yaw, glm::vec3(0.0f, 1.0f, 0.0f));
+  _state.position += _state.orientation * _input.move * (MOVE_SPEED * _input.deltaTime);
+}
+
+void ClientPrediction::Reset(const EntityState& _state)
+{
+  m_state = _state;
+  m_firstPending = 0;
+  m_numPending = 0;
+}
+
+const PlayerInput& ClientPrediction::Predict(const PlayerInput& _input)
+{
+  if (m_numPending == MAX_PENDING)
+  {
+    m_firstPending = (m_firstPending + 1) % MAX_PENDING;
+    m_numPending--;
+  }
+  PlayerInput& input = m_pending[(m_firstPending + m_numPending++) % MAX_PENDING];
+  input = NetProtocol::QuantizeInput(_input);
+  input.sequence = m_nextSequence++;
+  ApplyInput(m_state, input);
+  return input;
+}
+
+void ClientPrediction::Reconcile(const EntityState& _state, std::uint16_t _lastInput)
+{
+  while (m_numPending > 0 && static_cast<std::int16_t>(GetPending(0).sequence - _lastInput) <= 0)
+  {
+    m_firstPending = (m_firstPending + 1) % MAX_PENDING;
+    m_numPending--;
+  }
+  m_state = _state;
+  for (size_t i = 0; i < m_numPending; i++)
+  {
+    ApplyInput(m_state, GetPending(i));
+  }
+}
+
+size_t ClientPrediction::GetRecentInputs(PlayerInput* _inputs, size_t _max) const
+{
+  const size_t count = std::min(_max, m_numPending);
+  for (size_t i = 0; i < count; i++)
+  {
+    _inputs[i] = GetPending(m_numPending - count + i);
+  }
+  return count;
+}
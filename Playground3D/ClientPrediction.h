@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "NetProtocol.h"
+
+/** \brief Predicts the local player from its inputs instead of waiting for the server: every input is applied at once and kept until
+* a snapshot says the server ran it. Then the state of the snapshot replaces the predicted one and the inputs the server hasn't run
+* yet are applied again over it (reconciliation), so a correction of the server shows without dropping what the player did since.
+* The inputs are quantized as they're sent before they're applied, so the client and the server run the very same ones */
+class ClientPrediction
+{
+public:
+  // The inputs kept for the server, the oldest is dropped past this (a correction then misses it)
+  static constexpr size_t MAX_PENDING{ 64 };
+  // In units per second at a full move
+  static constexpr float MOVE_SPEED{ 5.0f };
+
+  // The simulation of an input, the server runs it too
+  static void ApplyInput(EntityState& _state, const PlayerInput& _input);
+
+  // Starts over from _state without pending inputs
+  void Reset(const EntityState& _state);
+  // Numbers and applies the input, it's kept until it's acknowledged. Returns it as it's sent
+  const PlayerInput& Predict(const PlayerInput& _input);
+  // The server's state after it ran _lastInput, the inputs up to it are dropped and the rest are applied again
+  void Reconcile(const EntityState& _state, std::uint16_t _lastInput);
+  // Copies the newest pending inputs (at most _max), oldest first, for the server
+  size_t GetRecentInputs(PlayerInput* _inputs, size_t _max) const;
+
+  const EntityState& GetState() const noexcept { return m_state; }
+  size_t GetNumPending() const noexcept { return m_numPending; }
+
+private:
+  const PlayerInput& GetPending(size_t _index) const { return m_pending[(m_firstPending + _index) % MAX_PENDING]; }
+
+  EntityState m_state;
+  PlayerInput m_pending[MAX_PENDING];  ///< a ring, oldest first
+  size_t m_firstPending = 0;
+  size_t m_numPending = 0;
+  std::uint16_t m_nextSequence = 0;
+};
@@ -28,6 +28,9 @@ struct CounterComponent : public GameEngine::Component
   }
 };
 
+//updated by every entity, so it gets a fixed ID
+GAMEENGINE_REGISTER_COMPONENT(CounterComponent, 0)
+
 struct KillCompontent : public GameEngine::Component
 {
   KillCompontent(void) {}
@@ -3,8 +3,39 @@
 
 #include <GameEngine\ResourceManager.h>
 #include <GameEngine\IMainGame.h>
+#include <GameEngine\GpuProfiler.h>
 #include <iostream>
 
+namespace
+{
+  /** \brief The small cubes inside the room */
+  struct CubePlacement
+  {
+    glm::vec3 position;
+    float scale;
+    glm::vec3 rotation;
+  };
+
+  //the passes of the render queue
+  enum : unsigned int { PASS_SHADOW, PASS_LIT, PASS_LAMP, PASS_SUN_SHADOW, PASS_SHADOW_DYNAMIC, PASS_DEPTH };
+
+  const CubePlacement CUBES[] =
+  {
+    { glm::vec3(4.0f, -3.5f, 0.0), 1.0f, glm::vec3(0.0f) },
+    { glm::vec3(2.0f, 3.0f, 1.0), 1.5f, glm::vec3(0.0f) },
+    { glm::vec3(-3.0f, -1.0f, 0.0), 1.0f, glm::vec3(0.0f) },
+    { glm::vec3(-1.5f, 1.0f, 1.5), 1.0f, glm::vec3(0.0f) },
+    { glm::vec3(-1.5f, 2.0f, -3.0), 1.5f, glm::vec3(60.0f, 0.0f, 60.0f) }
+  };
+
+  void PlaceCube(GameEngine::StaticModel& _cube, const CubePlacement& _placement)
+  {
+    _cube.SetScale(glm::vec3(_placement.scale));
+    _cube.SetPosition(_placement.position);
+    _cube.SetRotation(_placement.rotation);
+  }
+}
+
 GameplayScreen::GameplayScreen(GameEngine::Window* _window) : m_window(_window)
 {
   m_screenIndex = SCREEN_INDEX_GAMEPLAY;
@@ -50,7 +81,10 @@ void GameplayScreen::OnEntry()
   std::unique_ptr<GameEngine::GLSLProgram> m_skyboxShader = std::make_unique<GameEngine::GLSLProgram>();
   m_skyboxShader->CompileShaders("Shaders/Skybox.vert", "Shaders/Skybox.frag");
 
-  //m_screenShader.CompileShaders("Shaders/SimpleTransform.vert", "Shaders/SingleColor.frag");
+  m_blurShader.CompileShaders("Shaders/SimpleTransform.vert", "Shaders/Blur.frag");
+  m_compositeShaders.Init("Shaders/SimpleTransform.vert", "Shaders/Composite.frag", { "SHARPEN", "COLOR_GRADE", "VIGNETTE" });
+  m_compositeShaders.Preload({ 0 });
+  m_depthPrepassShader.CompileShaders("Shaders/DepthPrepass.vert", "Shaders/DepthPrepass.frag");
 
   //m_depthShader.CompileShaders("Shaders/SimpleDepth.vert", "Shaders/SimpleDepth.frag");
 
@@ -58,46 +92,107 @@ void GameplayScreen::OnEntry()
 
   m_lampShader.CompileShaders("Shaders/Lamp.vert", "Shaders/Lamp.frag");
 
-  m_cubemapShader.CompileShaders("Shaders/ShadowMap.vert", "Shaders/ShadowMap.frag", "Shaders/ShadowMap.gs");
-
-  m_pointLightShader.CompileShaders("Shaders/PointLighting.vert", "Shaders/PointLighting.frag");
-
-  /////////Set up the framebuffers for some post-processing
-  m_framebuffer.Init();
-  m_framebuffer.Bind(GL_FRAMEBUFFER, m_window->GetScreenWidth(), m_window->GetScreenHeight());
-  m_framebuffer.AttachTexture2D(m_window->GetScreenWidth(), m_window->GetScreenHeight(), false, false, true);
-  m_framebuffer.AttachRenderbuffer(m_window->GetScreenWidth(), m_window->GetScreenHeight(), true, true, true);
-  if (!m_framebuffer.CheckFramebufferStatus())
+  m_useLayeredShadows = GameEngine::RenderQueue3D::IsLayeredSupported();
+  if (m_useLayeredShadows)
+  {
+    m_cubemapShader.CompileShaders("Shaders/ShadowMapLayered.vert", "Shaders/ShadowMap.frag");
+  }
+  else
   {
-    std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+    m_cubemapShader.CompileShaders("Shaders/ShadowMap.vert", "Shaders/ShadowMap.frag", "Shaders/ShadowMap.gs");
   }
-  m_framebuffer.Unbind(GL_FRAMEBUFFER, m_window->GetScreenWidth(), m_window->GetScreenHeight());
+  m_shadowMatricesUniform = m_cubemapShader.GetUniform("shadowMatrices");
 
-  m_intermediateFB.Init();
-  m_intermediateFB.Bind(GL_FRAMEBUFFER, m_window->GetScreenWidth(), m_window->GetScreenHeight());
-  m_intermediateFB.AttachTexture2D(m_window->GetScreenWidth(), m_window->GetScreenHeight(), false, false, false);
-  if (!m_intermediateFB.CheckFramebufferStatus())
+  m_useClusteredLighting = GameEngine::LightClusters::IsSupported();
+  if (m_useClusteredLighting)
   {
-    std::cout << "ERROR::FRAMEBUFFER:: Intermediate Framebuffer is not complete!" << std::endl;
+    m_pointLightShader.CompileShaders("Shaders/PointLighting.vert", "Shaders/ClusteredLighting.frag");
+    m_lightClusters.Init();
+  }
+  else
+  {
+    m_pointLightShader.CompileShaders("Shaders/PointLighting.vert", "Shaders/PointLighting.frag");
   }
-  m_intermediateFB.Unbind(GL_FRAMEBUFFER, m_window->GetScreenWidth(), m_window->GetScreenHeight());
+
+  m_gBufferShader.CompileShaders("Shaders/PointLighting.vert", "Shaders/GBuffer.frag");
+  m_deferredLightingShader.CompileShaders("Shaders/DeferredLighting.vert", "Shaders/DeferredLighting.frag");
+  GameEngine::GBuffer::SetTextureUnits(m_deferredLightingShader);
+  m_deferredLightingShader.Use();
+  m_deferredLightingShader.UploadValue("cascadeShadowMap", 5);
+  m_deferredLightingShader.UnUse();
+  m_cascadeShader.CompileShaders("Shaders/CascadeShadow.vert", "Shaders/CascadeShadow.frag");
+  m_debugRenderer.Init();
+
+  m_frameUniforms.Init();
+  m_lightBlock.Init();
+
+  /////////The post-processing targets come from the pool when the passes of a frame need them
+  m_renderTargets.Init(m_window->GetScreenWidth(), m_window->GetScreenHeight());
+  m_postProcess.Init();
 
   m_depthMap.Init();
   m_depthMap.Bind(GL_FRAMEBUFFER);
   m_depthMap.AttachDepthCubemap();
+  m_depthMap.AttachStaticCache();
   if (!m_depthMap.CheckFramebufferStatus())
   {
     std::cout << "ERROR::FRAMEBUFFER:: Intermediate Framebuffer is not complete!" << std::endl;
   }
   m_depthMap.Unbind(GL_FRAMEBUFFER, m_window->GetScreenWidth(), m_window->GetScreenHeight());
 
+  if (!m_gBuffer.Init(m_window->GetScreenWidth(), m_window->GetScreenHeight()))
+  {
+    std::cout << "ERROR::FRAMEBUFFER:: G-buffer is not complete, the deferred path is off!" << std::endl;
+  }
+  if (!m_cascadedShadowMap.Init())
+  {
+    std::cout << "ERROR::FRAMEBUFFER:: Cascaded shadow maps are not complete, the sun is off!" << std::endl;
+  }
+
+  //the model textures are cooked to BC1/BC3 on their first load
+  GameEngine::ResourceManager::SetCompressTextures(true);
   //GameEngine::ResourceManager::GetSkinnedModel("Assets/MD5/Bob.md5mesh", &m_villager);
+  m_animationSystem.Init();
+  m_animationSystem.Add(&m_villager);
   GameEngine::ResourceManager::GetStaticModel("Assets/Quad/quad2.obj", &m_quad);
   GameEngine::ResourceManager::GetStaticModel("Assets/Box/box.obj", &m_cube);
 
+  //the small cubes don't move, so their draws are recorded once and every pass is a single multi draw
+  m_useCubePool = GameEngine::GeometryPool::IsSupported();
+  if (m_useCubePool)
+  {
+    const std::vector<size_t> cubeMeshes = m_cubePool.AddModel(m_cube);
+    m_cubePool.Begin();
+    for (const CubePlacement& cube : CUBES)
+    {
+      m_cube.SetScale(glm::vec3(cube.scale));
+      m_cube.SetPosition(cube.position);
+      m_cube.SetRotation(cube.rotation);
+      m_cubePool.Add(cubeMeshes, m_cube.GetModelMatrix());
+    }
+    m_cubePool.End();
+  }
+  //the cubes by their index in CUBES, for the queries of the passes
+  m_sceneTree.Clear();
+  const AABB cubeBox = m_cube.GetBoundingBox();
+  for (size_t i = 0; i < sizeof(CUBES) / sizeof(CUBES[0]); i++)
+  {
+    PlaceCube(m_cube, CUBES[i]);
+    m_sceneTree.Insert(cubeBox.Transformed(m_cube.GetModelMatrix()), static_cast<int>(i));
+  }
+
   m_pointLight.Init(glm::vec3(0.0f, 0.0f, 0.0f), 0.3f, 0.8f, 1.0f, 1.0f, 0.09f, 0.032f);
   m_pointLight.SetColor(glm::vec3(1.0f));
-  m_lightCamera.InitForPointLight(90.0f, 1024, 1024, 1.0f, 25.0f, m_pointLight.GetPosition());
+  m_sunLight.Init(glm::normalize(glm::vec3(-0.4f, -1.0f, -0.3f)), 0.05f, 0.6f, 0.5f);
+  m_sunLight.SetColor(glm::vec3(1.0f, 0.95f, 0.85f));
+  UpdateShadowCamera();
+  if (m_useClusteredLighting)
+  {
+    //the shadow camera doesn't change, the clustered shader gets its far plane once
+    m_pointLightShader.Use();
+    m_pointLightShader.UploadValue("farPlane", m_lightCamera.GetFarPlane());
+    m_pointLightShader.UnUse();
+  }
 
   std::unique_ptr<GameEngine::GLCubemap> skyboxCube = std::make_unique<GameEngine::GLCubemap>(GameEngine::ResourceManager::GetCubemap("Assets/Skybox/",
     "right.png",
@@ -118,8 +213,20 @@ void GameplayScreen::OnExit()
 {
   // Clean up
   m_skybox.Dispose();
-  m_framebuffer.Destroy();
-  m_intermediateFB.Destroy();
+  m_animationSystem.Dispose();
+  m_cubePool.Dispose();
+  m_sceneTree.Clear();
+  m_debugRenderer.Dispose();
+  m_frameUniforms.Dispose();
+  m_lightBlock.Dispose();
+  m_lightClusters.Dispose();
+  m_gBuffer.Dispose();
+  m_cascadedShadowMap.Dispose();
+  m_depthMap.DisposeStaticCache();
+  m_postProcess.Dispose();
+  m_renderTargets.Dispose();
+  m_dynamicResolution.Dispose();
+  m_compositeShaders.Dispose();
   GameEngine::ResourceManager::Clear();
 }
 
@@ -131,114 +238,154 @@ void GameplayScreen::Update()
 		{
 				//reset projection
 				m_camera->Resize(m_window->GetScreenWidth(), m_window->GetScreenHeight());
+				m_renderTargets.Resize(m_window->GetScreenWidth(), m_window->GetScreenHeight());
+				if (m_gBuffer.IsInitialized())
+				{
+						m_gBuffer.Resize(m_window->GetScreenWidth(), m_window->GetScreenHeight());
+				}
 				m_window->ResizeHandled();
 		}
   m_camera->Update();
-  //m_villager.Update(m_timer.Seconds());
+  m_animationSystem.Update(m_timer.Seconds());
  /* m_flashLight.SetDirection(m_camera.GetDirection());
   m_flashLight.SetPosition(m_camera.GetPosition());*/
 }
-void GameplayScreen::Draw()
+void GameplayScreen::QueueScene()
 {
-  // Move light position over time
-  // m_pointLight.SetPosition(glm::vec3(m_pointLight.GetPosition().x, m_pointLight.GetPosition().y, sinf(m_timer.Seconds() * 0.5f) * 3.0f));
+  m_renderQueue.Begin(m_camera->GetPosition(), 100.0f);
 
-  // 1. Render scene to depth cubemap
-  m_depthMap.Bind(GL_FRAMEBUFFER);
-  m_cubemapShader.Use();
-  for (GLuint i = 0; i < 6; ++i)
-  {
-    m_cubemapShader.UploadValue("shadowMatrices[" + std::to_string(i) + "]", m_lightCamera.GetLightTransforms().at(i));
-  }
-  m_cubemapShader.UploadValue("farPlane", m_lightCamera.GetFarPlane());
-  m_cubemapShader.UploadValue("lightPos", m_pointLight.GetPosition());
+  //the room and the cubes are static casters (PASS_SHADOW), only queued when the cached shadow is drawn again.
+  //The dynamic ones (none yet) go to PASS_SHADOW_DYNAMIC
+  const bool drawStaticShadow = !m_depthMap.IsStaticCacheValid();
+  //the camera passes skip what's off the screen, the shadow passes cull with their own frustums
+  const AABB cubeBox = m_cube.GetBoundingBox();
 
-  // Room cube
+  // Room cube, seen from inside (the lit one is drawn directly, only it has reversed normals)
   m_cube.SetScale(glm::vec3(10.0f));
   m_cube.SetPosition(glm::vec3(0.0f));
   m_cube.SetRotation(glm::vec3(0.0f));
-  glDisable(GL_CULL_FACE);
-  m_cube.Draw(m_cubemapShader);
-  glEnable(GL_CULL_FACE);
-
-  //Cubes
-  m_cube.SetScale(glm::vec3(1.0f));
-  m_cube.SetPosition(glm::vec3(4.0f, -3.5f, 0.0));
-  m_cube.Draw(m_cubemapShader);
-
-  m_cube.SetScale(glm::vec3(1.5f));
-  m_cube.SetPosition(glm::vec3(2.0f, 3.0f, 1.0));
-  m_cube.Draw(m_cubemapShader);
+  if (drawStaticShadow)
+  {
+    m_renderQueue.Submit(PASS_SHADOW, m_cubemapShader, m_cube, GameEngine::RenderQueue3D::DRAW_NO_CULL_FACE);
+  }
 
-  m_cube.SetScale(glm::vec3(1.0f));
-  m_cube.SetPosition(glm::vec3(-3.0f, -1.0f, 0.0));
-  m_cube.Draw(m_cubemapShader);
+  //Cubes, unless the pool draws them. The layered shadow pass culls every cube per face, so it takes them from the queue.
+  //The scene tree gathers the ones the light reaches and the ones on the screen
+  if ((!m_useCubePool || m_useLayeredShadows) && drawStaticShadow)
+  {
+    m_sceneObjects.clear();
+    m_sceneTree.QueryBox(m_lightCamera.GetCasterBounds(), m_sceneObjects);
+    for (int cube : m_sceneObjects)
+    {
+      PlaceCube(m_cube, CUBES[cube]);
+      m_renderQueue.Submit(PASS_SHADOW, m_cubemapShader, m_cube);
+    }
+  }
+  if (!m_useCubePool)
+  {
+    m_sceneObjects.clear();
+    m_sceneTree.QueryFrustum(m_camera->GetFrustumPlanes(), m_sceneObjects);
+    for (int cube : m_sceneObjects)
+    {
+      PlaceCube(m_cube, CUBES[cube]);
+      m_renderQueue.Submit(PASS_LIT, m_useDeferred ? m_gBufferShader : m_pointLightShader, m_cube);
+      if (m_useDepthPrepass && !m_useDeferred)
+      {
+        m_renderQueue.Submit(PASS_DEPTH, m_depthPrepassShader, m_cube);
+      }
+    }
+  }
 
-  m_cube.SetScale(glm::vec3(1.0f));
-  m_cube.SetPosition(glm::vec3(-1.5f, 1.0f, 1.5));
-  m_cube.Draw(m_cubemapShader);
+  //the casters of the sun, without the room: it reaches the cubes as if the walls were glass
+  if (m_useSunLight)
+  {
+    for (const CubePlacement& cube : CUBES)
+    {
+      PlaceCube(m_cube, cube);
+      m_renderQueue.Submit(PASS_SUN_SHADOW, m_cascadeShader, m_cube);
+    }
+  }
 
+  // Lamp
   m_cube.SetScale(glm::vec3(1.5f));
-  m_cube.SetPosition(glm::vec3(-1.5f, 2.0f, -3.0));
-  m_cube.SetRotation(glm::vec3(60.0f, 0.0f, 60.0f));
-  m_cube.Draw(m_cubemapShader);
-
-  m_depthMap.Unbind(GL_FRAMEBUFFER, m_window->GetScreenWidth(), m_window->GetScreenHeight());
-  m_cubemapShader.UnUse();
-
-  // 2. Render scene as normal 
-  m_pointLightShader.Use();
-  m_pointLightShader.UploadValue("projection", m_camera->GetProjectionMatrix());
-  m_pointLightShader.UploadValue("view", m_camera->GetViewMatrix());
-  m_pointLightShader.UploadValue("cameraPos", m_camera->GetPosition());
-  m_pointLightShader.UploadValue("farPlane", m_lightCamera.GetFarPlane());
-  m_pointLightShader.UploadValue("shadowMap", 2, m_depthMap.GetCubemap());
-  //m_pointLightShader.UploadValue("pointLightPos[0]", m_pointLight.GetPosition());
-  m_pointLight.UploadToShader(m_pointLightShader, "pointLights[0]");
-
-  // Room cube
-  m_cube.SetScale(glm::vec3(10.0f));
-  m_cube.SetPosition(glm::vec3(0.0f));
+  m_cube.SetPosition(m_pointLight.GetPosition());
   m_cube.SetRotation(glm::vec3(0.0f));
-  glDisable(GL_CULL_FACE);
-  m_pointLightShader.UploadValue("reverseNormals", 1);
-  m_cube.Draw(m_pointLightShader);
-  m_pointLightShader.UploadValue("reverseNormals", 0);
-  glEnable(GL_CULL_FACE);
-  //Cubes
-  m_cube.SetScale(glm::vec3(1.0f));
-  m_cube.SetPosition(glm::vec3(4.0f, -3.5f, 0.0));
-  m_cube.Draw(m_pointLightShader);
-
-  m_cube.SetScale(glm::vec3(1.5f));
-  m_cube.SetPosition(glm::vec3(2.0f, 3.0f, 1.0));
-  m_cube.Draw(m_pointLightShader);
-
-  m_cube.SetScale(glm::vec3(1.0f));
-  m_cube.SetPosition(glm::vec3(-3.0f, -1.0f, 0.0));
-  m_cube.Draw(m_pointLightShader);
-
-  m_cube.SetScale(glm::vec3(1.0f));
-  m_cube.SetPosition(glm::vec3(-1.5f, 1.0f, 1.5));
-  m_cube.Draw(m_pointLightShader);
+  if (m_camera->IsBoxVisible(cubeBox.Transformed(m_cube.GetModelMatrix())))
+  {
+    m_renderQueue.Submit(PASS_LAMP, m_lampShader, m_cube);
+  }
+}
 
-  m_cube.SetScale(glm::vec3(1.5f));
-  m_cube.SetPosition(glm::vec3(-1.5f, 2.0f, -3.0));
-  m_cube.SetRotation(glm::vec3(60.0f, 0.0f, 60.0f));
-  m_cube.Draw(m_pointLightShader);
+void GameplayScreen::Draw()
+{
+  if (m_useDynamicResolution)
+  {
+    //the scale of this frame, from the GPU time of the ones a few frames back
+    m_dynamicResolution.BeginFrame();
+  }
+  // Move light position over time
+  // m_pointLight.SetPosition(glm::vec3(m_pointLight.GetPosition().x, m_pointLight.GetPosition().y, sinf(m_timer.Seconds() * 0.5f) * 3.0f));
+  if (m_pointLight.GetPosition() != m_shadowLightPosition)
+  {
+    UpdateShadowCamera();
+  }
 
-  m_pointLightShader.UnUse();
+  QueueScene();
 
-  m_lampShader.Use();
-  m_lampShader.UploadValue("projection", m_camera->GetProjectionMatrix());
-  m_lampShader.UploadValue("view", m_camera->GetViewMatrix());
+  //the camera and the lights of every pass, one write each
+  m_frameUniforms.Update(*m_camera, m_timer.Seconds());
+  m_lightBlock.Clear();
+  m_lightBlock.Add(m_pointLight);
+  if (m_useSunLight)
+  {
+    m_lightBlock.Add(m_sunLight);
+    m_cascadedShadowMap.Update(*m_camera, m_sunLight.GetDirection(), 50.0f);
+  }
+  m_lightBlock.SetShadowFarPlane(m_lightCamera.GetFarPlane());
+  m_lightBlock.Upload();
+  if (m_useClusteredLighting)
+  {
+    m_lightClusters.Clear();
+    m_lightClusters.Add(m_pointLight);
+    m_lightClusters.Build(*m_camera);
+  }
 
-  m_cube.SetPosition(m_pointLight.GetPosition());
-  m_cube.SetRotation(glm::vec3(0.0f));
-  m_cube.Draw(m_lampShader);
-  m_lampShader.UnUse();
+  // 1. Render scene to depth cubemap: the static casters when their cache is out of date, then the dynamic ones over a copy of it
+  {
+    GPU_PROFILE_SCOPE("GPU::Shadows");
+    m_cubemapShader.Use();
+    if (!m_depthMap.IsStaticCacheValid())
+    {
+      m_depthMap.BindStaticCache();
+      DrawShadowCasters(PASS_SHADOW);
+      if (m_useCubePool && !m_useLayeredShadows)
+      {
+        m_cubePool.Draw(m_cubemapShader);
+      }
+    }
+    m_depthMap.BindWithStaticCache(GL_FRAMEBUFFER);
+    DrawShadowCasters(PASS_SHADOW_DYNAMIC);
+
+    m_depthMap.Unbind(GL_FRAMEBUFFER, m_window->GetScreenWidth(), m_window->GetScreenHeight());
+    m_cubemapShader.UnUse();
+
+    // and the sun's cascades, a draw per cube for all of them
+    if (m_useSunLight)
+    {
+      m_cascadedShadowMap.Render(m_renderQueue, PASS_SUN_SHADOW, m_window->GetScreenWidth(), m_window->GetScreenHeight());
+    }
+  }
 
-  m_skybox.Render();
+  // 2. and 3. at the dynamic resolution into a target of the post-processing, upscaled by its last pass
+  GameEngine::PostProcessGraph::Resource scene = GameEngine::PostProcessGraph::SCREEN;
+  if (m_useDynamicResolution)
+  {
+    scene = QueueScaledScene();
+  }
+  else
+  {
+    DrawScene(0, m_window->GetScreenWidth(), m_window->GetScreenHeight());
+  }
 
   /*m_villagerShader.Use();
 
@@ -246,29 +393,245 @@ void GameplayScreen::Draw()
   m_villagerShader.UploadValue("view", m_camera.GetViewMatrix());
   m_villager.SetPosition(glm::vec3(0.0f, 10.0f, 3.0f));
   m_villager.SetScale(glm::vec3(0.1f, 0.1f, 0.1f));
-  m_villager.Draw(m_villagerShader);
+  m_animationSystem.Draw(m_villagerShader, *m_camera);
 
   m_villagerShader.UnUse();*/
 
-  //m_screenShader.Use();
+  // 4. Post-processing over the finished frame, its last pass draws it on the screen with the color effects
+  GPU_PROFILE_SCOPE("GPU::PostProcess");
+  GameEngine::ShaderVariants::Features composite = m_colorEffects;
+  if (m_useBlur)
+  {
+    scene = QueueBlur(scene);
+  }
+  else if (scene != GameEngine::PostProcessGraph::SCREEN)
+  {
+    composite |= m_compositeShaders.GetFeature("SHARPEN");
+  }
+  if (scene != GameEngine::PostProcessGraph::SCREEN || composite != 0)
+  {
+    QueueComposite(scene, composite);
+  }
+  m_postProcess.Execute(m_renderTargets, m_window->GetScreenWidth(), m_window->GetScreenHeight());
+  m_renderTargets.EndFrame();
+  if (m_useDynamicResolution)
+  {
+    m_dynamicResolution.EndFrame();
+  }
+}
+
+void GameplayScreen::DrawScene(GLuint _output, int _width, int _height)
+{
+  //the G-buffer follows the size the scene is drawn at
+  if (m_useDeferred && (m_gBuffer.GetWidth() != _width || m_gBuffer.GetHeight() != _height))
+  {
+    m_gBuffer.Resize(_width, _height);
+    glBindFramebuffer(GL_FRAMEBUFFER, _output);
+  }
 
-  //glUniform1i(m_screenShader.GetUniformLocation("screenTexture"), 0);
-  ////m_depthMap.Render();
+  // 2. The depth of the forward pass first, so it shades every pixel once (GL_EQUAL) instead of every cube in front of the room
+  const bool depthPrepass = m_useDepthPrepass && !m_useDeferred;
+  if (depthPrepass)
+  {
+    GPU_PROFILE_SCOPE("GPU::DepthPrepass");
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    m_depthPrepassShader.Use();
+    m_cube.SetScale(glm::vec3(10.0f));
+    m_cube.SetPosition(glm::vec3(0.0f));
+    m_cube.SetRotation(glm::vec3(0.0f));
+    glDisable(GL_CULL_FACE);
+    m_cube.Draw(m_depthPrepassShader);
+    glEnable(GL_CULL_FACE);
+    if (m_useCubePool)
+    {
+      m_cubePool.Draw(m_depthPrepassShader);
+    }
+    m_renderQueue.Execute(PASS_DEPTH);
+    m_depthPrepassShader.UnUse();
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthFunc(GL_EQUAL);
+    glDepthMask(GL_FALSE);
+  }
+
+  // 2. Render scene as normal, or into the G-buffer
+  {
+    GPU_PROFILE_SCOPE("GPU::Scene");
+    GameEngine::GLSLProgram& litShader = m_useDeferred ? m_gBufferShader : m_pointLightShader;
+    if (m_useDeferred)
+    {
+      m_gBuffer.BindForGeometry();
+    }
+    litShader.Use();
+    if (!m_useDeferred)
+    {
+      litShader.UploadValue("shadowMap", 2, m_depthMap.GetCubemap());
+    }
+
+    // Room cube
+    m_cube.SetScale(glm::vec3(10.0f));
+    m_cube.SetPosition(glm::vec3(0.0f));
+    m_cube.SetRotation(glm::vec3(0.0f));
+    glDisable(GL_CULL_FACE);
+    litShader.UploadValue("reverseNormals", 1);
+    m_cube.Draw(litShader);
+    litShader.UploadValue("reverseNormals", 0);
+    glEnable(GL_CULL_FACE);
+    //Cubes
+    if (m_useCubePool)
+    {
+      m_cubePool.Draw(litShader);
+    }
+    m_renderQueue.Execute(PASS_LIT);
+
+    litShader.UnUse();
+    if (depthPrepass)
+    {
+      //the lamps and the sky test and write the depth as usual, the sky at the far plane behind everything
+      glDepthFunc(GL_LESS);
+      glDepthMask(GL_TRUE);
+    }
+  }
+
+  // 3. Light the G-buffer in one screen pass, the lamps and the sky are drawn over it with its depth
+  {
+    GPU_PROFILE_SCOPE("GPU::Lighting");
+    if (m_useDeferred)
+    {
+      m_gBuffer.Unbind(_output);
+      m_deferredLightingShader.Use();
+      m_deferredLightingShader.UploadValue("shadowMap", 4, m_depthMap.GetCubemap());
+      m_cascadedShadowMap.BindTexture(5);
+      m_gBuffer.RenderLighting();
+      m_deferredLightingShader.UnUse();
+      m_gBuffer.BlitDepth(_output);
+    }
+
+    m_lampShader.Use();
+    m_renderQueue.Execute(PASS_LAMP);
+    m_lampShader.UnUse();
+
+    m_skybox.Render();
+  }
+
+  if (m_showBounds)
+  {
+    DrawBounds();
+  }
+}
+
+void GameplayScreen::DrawBounds()
+{
+  const AABB cubeBox = m_cube.GetBoundingBox();
+  m_debugRenderer.SetCullFrustum(m_camera->GetFrustumPlanes());
+  m_sceneObjects.clear();
+  m_sceneTree.QueryFrustum(m_camera->GetFrustumPlanes(), m_sceneObjects);
+  for (int cube : m_sceneObjects)
+  {
+    PlaceCube(m_cube, CUBES[cube]);
+    m_debugRenderer.DrawBox(cubeBox.Transformed(m_cube.GetModelMatrix()), GameEngine::ColorRGBA8(0, 255, 0, 255));
+  }
+  m_debugRenderer.DrawBox(m_lightCamera.GetCasterBounds(), GameEngine::ColorRGBA8(255, 255, 0, 255));
+  m_debugRenderer.End();
+  m_debugRenderer.Render3D(m_camera->GetProjectionMatrix() * m_camera->GetViewMatrix(), 1.0f);
+}
+
+GameEngine::PostProcessGraph::Resource GameplayScreen::QueueScreenCopy()
+{
+  const int screenWidth = m_window->GetScreenWidth();
+  const int screenHeight = m_window->GetScreenHeight();
+  GameEngine::RenderTargetDesc sceneDesc;
+  const GameEngine::PostProcessGraph::Resource scene = m_postProcess.CreateTarget(sceneDesc);
+  m_postProcess.AddPass({}, scene, [screenWidth, screenHeight]()
+  {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, screenWidth, screenHeight, 0, 0, screenWidth, screenHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  });
+  return scene;
+}
 
-  //m_screenShader.UnUse();
+GameEngine::PostProcessGraph::Resource GameplayScreen::QueueScaledScene()
+{
+  GameEngine::RenderTargetDesc sceneDesc;
+  sceneDesc.scale = m_dynamicResolution.GetScale();
+  sceneDesc.depth = true;
+  int width = 0;
+  int height = 0;
+  m_renderTargets.GetSize(sceneDesc, width, height);
+
+  //a scale the controller left for a while isn't used by any frame, the pool frees its target
+  const GameEngine::PostProcessGraph::Resource scene = m_postProcess.CreateTarget(sceneDesc);
+  m_postProcess.AddPass({}, scene, [this, width, height]()
+  {
+    //the graph bound the target, the deferred path comes back to it after the G-buffer
+    GLint output = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &output);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    DrawScene(static_cast<GLuint>(output), width, height);
+  });
+  return scene;
+}
 
-  //m_framebuffer.Bind(GL_READ_FRAMEBUFFER);
-  //m_intermediateFB.Bind(GL_DRAW_FRAMEBUFFER);
-  //m_framebuffer.Blit(GL_COLOR_BUFFER_BIT, GL_NEAREST);
+void GameplayScreen::QueueComposite(GameEngine::PostProcessGraph::Resource _scene, GameEngine::ShaderVariants::Features _features)
+{
+  if (_scene == GameEngine::PostProcessGraph::SCREEN)
+  {
+    _scene = QueueScreenCopy();
+  }
+  //the variants keep their addresses
+  GameEngine::GLSLProgram& composite = m_compositeShaders.Get(_features);
+  m_postProcess.AddPass({ _scene }, GameEngine::PostProcessGraph::SCREEN, [this, &composite]()
+  {
+    composite.Use();
+    m_postProcess.DrawQuad();
+    composite.UnUse();
+  });
+}
 
-  //m_framebuffer.Unbind(GL_FRAMEBUFFER);
-  //glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+GameEngine::PostProcessGraph::Resource GameplayScreen::QueueBlur(GameEngine::PostProcessGraph::Resource _scene)
+{
+  GameEngine::RenderTargetDesc halfDesc;
+  halfDesc.scale = 0.5f;
 
-  //m_screenShader.Use();
+  //the frame is copied out of the screen (unless it was drawn into a target), then blurred twice at half size: the 4 half targets
+  //alias 2 textures of the pool
+  GameEngine::PostProcessGraph::Resource blurred = _scene == GameEngine::PostProcessGraph::SCREEN ? QueueScreenCopy() : _scene;
+  for (int i = 0; i < 4; i++)
+  {
+    const GameEngine::PostProcessGraph::Resource target = m_postProcess.CreateTarget(halfDesc);
+    const glm::vec2 direction = i % 2 == 0 ? glm::vec2(1.0f, 0.0f) : glm::vec2(0.0f, 1.0f);
+    m_postProcess.AddPass({ blurred }, target, [this, direction]()
+    {
+      m_blurShader.Use();
+      m_blurShader.UploadValue("direction", direction);
+      m_postProcess.DrawQuad();
+      m_blurShader.UnUse();
+    });
+    blurred = target;
+  }
+  return blurred;
+}
 
-  //m_intermediateFB.Render();
+void GameplayScreen::UpdateShadowCamera()
+{
+  m_shadowLightPosition = m_pointLight.GetPosition();
+  m_lightCamera.InitForPointLight(90.0f, 1024, 1024, 1.0f, 25.0f, m_shadowLightPosition);
+  //the faces only change with the light
+  m_cubemapShader.Use();
+  m_cubemapShader.UploadValues(m_shadowMatricesUniform, m_lightCamera.GetLightTransforms().data(), 6);
+  m_cubemapShader.UnUse();
+  m_depthMap.InvalidateStaticCache();
+}
 
-  //m_screenShader.UnUse();
+void GameplayScreen::DrawShadowCasters(unsigned int _pass)
+{
+  if (m_useLayeredShadows)
+  {
+    m_renderQueue.ExecuteLayered(_pass, m_lightCamera.GetLightTransforms());
+  }
+  else
+  {
+    m_renderQueue.Execute(_pass);
+  }
 }
 
 void GameplayScreen::CheckInput()
@@ -292,6 +655,52 @@ void GameplayScreen::CheckInput()
   {
     m_window->ChangeFullscreenState(GameEngine::FullscreenState::WINDOWED);
   }
+  if (m_game->inputManager.IsKeyPressed(SDLK_4))
+  {
+    m_useDeferred = !m_useDeferred && m_gBuffer.IsInitialized();
+  }
+  if (m_game->inputManager.IsKeyPressed(SDLK_5))
+  {
+    m_useSunLight = !m_useSunLight && m_cascadedShadowMap.IsInitialized();
+  }
+  if (m_game->inputManager.IsKeyPressed(SDLK_6))
+  {
+    m_useBlur = !m_useBlur;
+  }
+  if (m_game->inputManager.IsKeyPressed(SDLK_7))
+  {
+    m_showBounds = !m_showBounds;
+  }
+  if (m_game->inputManager.IsKeyPressed(SDLK_8))
+  {
+    m_useDynamicResolution = !m_useDynamicResolution;
+    if (m_useDynamicResolution)
+    {
+      //starts again at the full resolution, 60 fps with a little room
+      m_dynamicResolution.Init(15.0f, 0.5f, 1.0f);
+    }
+    else
+    {
+      m_dynamicResolution.Dispose();
+    }
+  }
+  if (m_game->inputManager.IsKeyPressed(SDLK_9))
+  {
+    m_useDepthPrepass = !m_useDepthPrepass;
+  }
+  if (m_game->inputManager.IsKeyPressed(SDLK_0))
+  {
+    m_colorEffects = m_colorEffects != 0 ? 0 : m_compositeShaders.GetFeature("COLOR_GRADE") | m_compositeShaders.GetFeature("VIGNETTE");
+  }
+  if (m_game->inputManager.IsKeyPressed(SDLK_F3))
+  {
+    //times the CPU scopes and the GPU passes
+    GameEngine::Profiler::Get().SetEnabled(!GameEngine::Profiler::Get().IsEnabled());
+  }
+  if (m_game->inputManager.IsKeyPressed(SDLK_F4))
+  {
+    GameEngine::Profiler::Get().WriteChromeTrace("Profile.json");
+  }
   if (m_game->inputManager.IsKeyDown(SDLK_ESCAPE))
   {
     m_currentState = GameEngine::ScreenState::EXIT_APPLICATION;
@@ -5,12 +5,24 @@
 #include <GameEngine\GLSLProgram.h>
 #include <GameEngine\Camera3D.h>
 #include <GameEngine\Model.h>
+#include <GameEngine\AnimationSystem.h>
 #include <GameEngine\Lights.h>
 #include <GameEngine\Random.h>
 #include <GameEngine\Skybox.h>
 #include <GameEngine\DepthMapFBO.h>
 #include <GameEngine\Timing.h>
 #include <GameEngine\LightCamera.h>
+#include <GameEngine\GeometryPool.h>
+#include <GameEngine\RenderQueue3D.h>
+#include <GameEngine\UniformBlocks.h>
+#include <GameEngine\LightClusters.h>
+#include <GameEngine\GBuffer.h>
+#include <GameEngine\CascadedShadowMap.h>
+#include <GameEngine\PostProcessGraph.h>
+#include <GameEngine\AABBTree.h>
+#include <GameEngine\DebugRenderer.h>
+#include <GameEngine\DynamicResolution.h>
+#include <GameEngine\ShaderVariants.h>
 #include <map>
 
 // Our custom gameplay screen that inherits from the IGameScreen
@@ -39,6 +51,24 @@ public:
 
 private:
 		void CheckInput();
+		/** \brief Submits the draws of the frame to m_renderQueue (the small cubes only when the pool can't draw them) */
+		void QueueScene();
+		/** \brief Builds the shadow cameras at the point light, its static shadow has to be drawn again */
+		void UpdateShadowCamera();
+		/** \brief Draws the shadow casters of _pass into the bound cubemap */
+		void DrawShadowCasters(unsigned int _pass);
+		/** \brief Adds the passes of the blur of _scene (SCREEN when the scene was drawn on it) to m_postProcess, returns the blurred target */
+		GameEngine::PostProcessGraph::Resource QueueBlur(GameEngine::PostProcessGraph::Resource _scene);
+		/** \brief Adds the pass copying the screen into a target, returns the target */
+		GameEngine::PostProcessGraph::Resource QueueScreenCopy();
+		/** \brief Draws the lit scene, the lamps, the sky and the bounds into the framebuffer _output (0 the screen) of _width x _height */
+		void DrawScene(GLuint _output, int _width, int _height);
+		/** \brief Adds the pass drawing the scene into a target at the scale of m_dynamicResolution, returns the target */
+		GameEngine::PostProcessGraph::Resource QueueScaledScene();
+		/** \brief Adds the last pass, which draws _scene (copied first if it's SCREEN) on the screen with the effects of _features */
+		void QueueComposite(GameEngine::PostProcessGraph::Resource _scene, GameEngine::ShaderVariants::Features _features);
+		/** \brief Draws the boxes of the cubes on the screen and the bounds of the light's shadow casters over the scene */
+		void DrawBounds();
 
 		glm::mat4 lightProjection, lightView;
 		glm::mat4 lightSpaceMatrix;
@@ -48,25 +78,66 @@ private:
 		GameEngine::PointLight m_pointLight;
 		GameEngine::LightCamera m_lightCamera;
 
+		//the shadow cubemap, the static casters are cached and only the dynamic ones are drawn every frame
 		GameEngine::DepthMapFBO m_depthMap;
-		GameEngine::Framebuffer m_framebuffer;
-		GameEngine::Framebuffer m_intermediateFB;
+		glm::vec3 m_shadowLightPosition{ 0.0f }; ///< where the light was when the cache was drawn
+		//the post-processing passes of the frame, their targets are shared through the pool
+		GameEngine::RenderTargetPool m_renderTargets;
+		GameEngine::PostProcessGraph m_postProcess;
+		GameEngine::GLSLProgram m_blurShader;
+		bool m_useBlur{ false }; ///< toggled with 6
+		//the scene is drawn at a scale of the screen picked from the GPU time of the frames (toggled with 8), then upscaled to it
+		GameEngine::DynamicResolution m_dynamicResolution;
+		bool m_useDynamicResolution{ false };
+		//the last pass of the post-processing, the upscale, the color grading and the vignette in one shader, a variant per set of them
+		GameEngine::ShaderVariants m_compositeShaders;
+		GameEngine::ShaderVariants::Features m_colorEffects{ 0 }; ///< the grading and the vignette, toggled with 0
+		//the forward pass writes the depth first (toggled with 9), then shades only the fragments which are left
+		GameEngine::GLSLProgram m_depthPrepassShader;
+		bool m_useDepthPrepass{ false };
 
 		GameEngine::Skybox m_skybox;
 
 		//the texturing program for sprites and lights
 		GameEngine::GLSLProgram m_villagerShader;
 		GameEngine::GLSLProgram m_asteroidShader;
-		GameEngine::GLSLProgram m_screenShader;
 		GameEngine::GLSLProgram m_depthShader;
 		GameEngine::GLSLProgram m_shadowShader;
 		GameEngine::GLSLProgram m_lampShader;
 		GameEngine::GLSLProgram m_cubemapShader;
 		GameEngine::GLSLProgram m_pointLightShader;
+		//the shadowMatrices array of m_cubemapShader, uploaded when the light camera changes
+		GameEngine::UniformHandle m_shadowMatricesUniform;
+		//the shadow cubemap is drawn with instanced layered draws culled per face, instead of the geometry shader copying every triangle
+		bool m_useLayeredShadows{ false };
+		//the camera and the lights, written once a frame for all the programs
+		GameEngine::FrameUniforms m_frameUniforms;
+		GameEngine::LightBlock m_lightBlock;
+		//the point and spot lights by cluster, when the driver has storage buffers m_pointLightShader reads them instead of the LightBlock
+		GameEngine::LightClusters m_lightClusters;
+		bool m_useClusteredLighting{ false };
+		//the deferred path (toggled with 4): the lit pass writes the G-buffer, then one screen pass lights every pixel
+		GameEngine::GBuffer m_gBuffer;
+		GameEngine::GLSLProgram m_gBufferShader;
+		GameEngine::GLSLProgram m_deferredLightingShader;
+		bool m_useDeferred{ false };
+		//the sun (toggled with 5, the deferred path lights it) and its cascaded shadow maps
+		GameEngine::DirectionalLight m_sunLight;
+		GameEngine::CascadedShadowMap m_cascadedShadowMap;
+		GameEngine::GLSLProgram m_cascadeShader;
+		bool m_useSunLight{ false };
 
 		GameEngine::SkinnedModel m_villager;
+		GameEngine::AnimationSystem m_animationSystem; ///< updates and uploads the poses of all the skinned models at once
 		GameEngine::StaticModel m_quad;
 		GameEngine::StaticModel m_cube;
+		GameEngine::GeometryPool m_cubePool; ///< the small cubes of the room
+		bool m_useCubePool{ false };
+		GameEngine::RenderQueue3D m_renderQueue; ///< the draws of the frame by pass, sorted by state
+		GameEngine::AABBTree m_sceneTree; ///< the small cubes, by their index in CUBES
+		std::vector<int> m_sceneObjects; ///< the result of the last query of m_sceneTree
+		GameEngine::DebugRenderer m_debugRenderer;
+		bool m_showBounds{ false }; ///< toggled with 7
 
 		GameEngine::HRTimer m_timer;
 
@@ -0,0 +1,105 @@
+#include "InterestManager.h"
+
+#include <algorithm>
+#include <cmath>
+
+void InterestGrid::Build(const std::vector<EntityState>& _entities)
+{
+  m_entities = _entities;
+  m_hash.Clear(m_entities.size());
+  for (size_t i = 0; i < m_entities.size(); i++)
+  {
+    m_hash.Insert(static_cast<int>(i), glm::vec2(m_entities[i].position.x, m_entities[i].position.z));
+  }
+}
+
+void InterestGrid::Query(const glm::vec3& _center, float _radius, std::vector<int>& _indices) const
+{
+  //the cells overlapping the circle, then the entities really in it
+  _indices.clear();
+  m_hash.Query(glm::vec2(_center.x, _center.z), _radius, m_candidates);
+  for (int index : m_candidates)
+  {
+    const float dx = m_entities[index].position.x - _center.x;
+    const float dz = m_entities[index].position.z - _center.z;
+    if (dx * dx + dz * dz <= _radius * _radius)
+    {
+      _indices.push_back(index);
+    }
+  }
+}
+
+float InterestGrid::GetImportance(std::uint16_t _id) const
+{
+  const auto it = m_importance.find(_id);
+  return it != m_importance.end() ? it->second : 1.0f;
+}
+
+void ClientInterest::Select(const InterestGrid& _grid, float _deltaTime, std::vector<int>& _sent, std::vector<std::uint16_t>& _held)
+{
+  _sent.clear();
+  _held.clear();
+  _grid.Query(m_viewer, m_radius, m_indices);
+
+  m_relevant.clear();
+  for (int index : m_indices)
+  {
+    const EntityState& entity = _grid.GetEntity(index);
+    const float dx = entity.position.x - m_viewer.x;
+    const float dz = entity.position.z - m_viewer.z;
+    const float distance = std::sqrt(dx * dx + dz * dz) / m_radius;
+    Accumulator relevant;
+    relevant.id = entity.id;
+    relevant.index = index;
+    relevant.isSent = false;
+    relevant.priority = _grid.GetImportance(entity.id) * (1.0f - (1.0f - EDGE_PRIORITY) * distance);
+    m_relevant.push_back(relevant);
+  }
+  std::sort(m_relevant.begin(), m_relevant.end(), [](const Accumulator& _a, const Accumulator& _b) { return _a.id < _b.id; });
+
+  //adds what was accumulated, the entities no longer relevant are dropped with the old accumulators
+  auto previous = m_accumulators.begin();
+  for (Accumulator& relevant : m_relevant)
+  {
+    while (previous != m_accumulators.end() && previous->id < relevant.id)
+    {
+      ++previous;
+    }
+    if (previous != m_accumulators.end() && previous->id == relevant.id)
+    {
+      relevant.priority += previous->priority;
+    }
+  }
+
+  //the highest priorities which fit in the bandwidth of the interval, at least one so a small budget doesn't stall everything
+  const size_t budget = static_cast<size_t>(static_cast<float>(m_bandwidth) * _deltaTime) / ENTITY_BYTES;
+  const size_t numSent = std::min(m_relevant.size(), std::max<size_t>(budget, 1));
+  m_byPriority.clear();
+  for (Accumulator& relevant : m_relevant)
+  {
+    m_byPriority.push_back(&relevant);
+  }
+  std::partial_sort(m_byPriority.begin(), m_byPriority.begin() + numSent, m_byPriority.end(), [](const Accumulator* _a, const Accumulator* _b)
+  {
+    return _a->priority > _b->priority;
+  });
+  for (size_t i = 0; i < numSent; i++)
+  {
+    m_byPriority[i]->priority = 0.0f;
+    m_byPriority[i]->isSent = true;
+  }
+
+  //both lists come out sorted by id as the relevant entities are
+  for (const Accumulator& relevant : m_relevant)
+  {
+    if (relevant.isSent)
+    {
+      _sent.push_back(relevant.index);
+    }
+    else
+    {
+      _held.push_back(relevant.id);
+    }
+  }
+  m_accumulators.swap(m_relevant);
+}
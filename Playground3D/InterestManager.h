@@ -0,0 +1,77 @@
+#pragma once
+
+#include <GameEngine\SpatialHash2D.h>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "NetProtocol.h"
+
+/** \brief The entities of a tick in a spatial grid on the ground plane (x and z), built once and queried for every client, so
+* finding what a client can see doesn't look at every entity. The importance of an entity scales how often it's sent */
+class InterestGrid
+{
+public:
+  static constexpr float DEFAULT_CELL_SIZE{ 32.0f };
+
+  InterestGrid(float _cellSize = DEFAULT_CELL_SIZE) : m_hash(_cellSize) {}
+
+  // Indexes the entities, they're kept until the next Build
+  void Build(const std::vector<EntityState>& _entities);
+  // Gets the indices of the entities within _radius of _center on the ground plane
+  void Query(const glm::vec3& _center, float _radius, std::vector<int>& _indices) const;
+
+  // 1 by default, an entity of 2 is sent twice as often as one of 1 at the same distance
+  void SetImportance(std::uint16_t _id, float _importance) { m_importance[_id] = _importance; }
+  float GetImportance(std::uint16_t _id) const;
+
+  const EntityState& GetEntity(int _index) const { return m_entities[_index]; }
+
+private:
+  GameEngine::SpatialHash2D m_hash;
+  std::vector<EntityState> m_entities;
+  std::unordered_map<std::uint16_t, float> m_importance;
+  mutable std::vector<int> m_candidates;
+};
+
+/** \brief What is sent to one client: the entities around its viewer (its relevancy set) and of them, as many as its bandwidth allows,
+* the ones with the highest accumulated priority. Every snapshot adds the priority of an entity (its importance, less with the
+* distance) to its accumulator and an entity sent starts over from 0, so the near and important entities go out most often and the far
+* ones still go out now and then. An entity which leaves the relevancy set loses its accumulator */
+class ClientInterest
+{
+public:
+  static constexpr float DEFAULT_RADIUS{ 128.0f };
+  static constexpr size_t DEFAULT_BANDWIDTH{ 16 * 1024 };  ///< bytes per second
+  // What an entity costs in a snapshot at most (its id, the flags and a full position and orientation), for the budget
+  static constexpr size_t ENTITY_BYTES{ 17 };
+  // The priority of an entity at the edge of the relevancy set, relative to one at the viewer
+  static constexpr float EDGE_PRIORITY{ 0.25f };
+
+  void SetViewer(const glm::vec3& _position, float _radius = DEFAULT_RADIUS) { m_viewer = _position; m_radius = _radius; }
+  void SetBandwidth(size_t _bytesPerSecond) { m_bandwidth = _bytesPerSecond; }
+  void Reset() { m_accumulators.clear(); }
+
+  /** \brief Picks the entities of the next snapshot, _deltaTime after the last one
+  * \param _sent - the indices in the grid of the entities to send, sorted by id
+  * \param _held - the ids of the relevant entities not sent this time, sorted. The client should keep them as they were
+  */
+  void Select(const InterestGrid& _grid, float _deltaTime, std::vector<int>& _sent, std::vector<std::uint16_t>& _held);
+
+private:
+  struct Accumulator
+  {
+    std::uint16_t id;
+    int index;        ///< in the grid, for this snapshot
+    float priority;
+    bool isSent;
+  };
+
+  glm::vec3 m_viewer{ 0.0f };
+  float m_radius = DEFAULT_RADIUS;
+  size_t m_bandwidth = DEFAULT_BANDWIDTH;
+  std::vector<Accumulator> m_accumulators;  ///< of the relevant entities, sorted by id
+  std::vector<Accumulator> m_relevant;
+  std::vector<Accumulator*> m_byPriority;
+  std::vector<int> m_indices;
+};
@@ -1,14 +1,11 @@
 #include "Multiplayer.h"
+#include <algorithm>
 #include <exception>
 
 #define DEFAULT_PORT "27015"
 
 Multiplayer::Multiplayer()
 {
-  m_connectSocket = INVALID_SOCKET;
-
-  struct addrinfo * ptr = nullptr, hints;
-
   int iResult;
 
   // Initialize Winsock
@@ -18,103 +15,299 @@ Multiplayer::Multiplayer()
     throw std::exception();
   }
 
-  ZeroMemory(&hints, sizeof(hints));
-  hints.ai_family = AF_UNSPEC;
-  hints.ai_socktype = SOCK_STREAM;
-  hints.ai_protocol = IPPROTO_TCP;
-
-  // Resolve the server address and port
-  iResult = getaddrinfo("localhost", DEFAULT_PORT, &hints, &m_result);
-  if (iResult != 0)
+  // Resolve the server address and port, UDP only sets the peer
+  if (!m_connection.Connect("localhost", DEFAULT_PORT))
   {
     CleanUp();
     throw std::exception();
   }
+  m_startTime = NetConnection::Now();
+  m_lastSnapshotTime = m_startTime;
+}
+
 
-  // Attempt to connect to an address until one succeeds
-  for (ptr = m_result; ptr != nullptr; ptr = ptr->ai_next)
+Multiplayer::~Multiplayer()
+{
+}
+
+void Multiplayer::Loop()
+{
+  m_connection.Poll();
+  ProcessMessages();
+
+  // The state is written as late as it can be, right before the packet which carries it
+  if (m_connection.IsSendDue())
   {
-    // Create a SOCKET for connecting to server
-    m_connectSocket = socket(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol);
-    if (m_connectSocket == INVALID_SOCKET)
+    if (m_hasPendingState)
     {
-      CleanUp();
-      throw std::exception();
+      WriteSnapshot();
     }
-    // Connect to server.
-    iResult = connect(m_connectSocket, ptr->ai_addr, (int)ptr->ai_addrlen);
-    if (iResult == SOCKET_ERROR)
+    if (m_hasLocalEntity && m_prediction.GetNumPending() > 0)
     {
-      closesocket(m_connectSocket);
-      m_connectSocket = INVALID_SOCKET;
-      continue;
+      WriteInputs();
     }
-    break;
   }
+  m_connection.Flush();
+}
 
-  freeaddrinfo(m_result);
+void Multiplayer::ProcessMessages()
+{
+  NetChannel channel;
+  std::vector<std::uint8_t> message;
+  while (m_connection.Receive(channel, message))
+  {
+    BitReader reader(message.data(), message.size());
+    switch (reader.Read(NetProtocol::MESSAGE_TYPE_BITS))
+    {
+    case NetProtocol::SNAPSHOT:
+      ProcessSnapshot(reader);
+      break;
+    case NetProtocol::ACK:
+      ProcessAck(reader);
+      break;
+    case NetProtocol::INPUT:
+      ProcessInputs(reader);
+      break;
+    default:
+      break;
+    }
+  }
+}
 
-  if (m_connectSocket == INVALID_SOCKET)
+void Multiplayer::ProcessSnapshot(BitReader& _reader)
+{
+  std::uint16_t sequence = 0;
+  std::uint16_t baselineSequence = 0;
+  bool hasBaseline = false;
+  NetProtocol::ReadSnapshotHeader(_reader, sequence, hasBaseline, baselineSequence);
+  // So late its slot already holds a newer one
+  if (m_hasLatest && static_cast<std::int16_t>(m_latestReceived - sequence) >= static_cast<std::int16_t>(SNAPSHOT_HISTORY))
   {
-    CleanUp();
-    throw std::exception();
+    return;
   }
+
+  const Snapshot* baseline = nullptr;
+  if (hasBaseline)
+  {
+    const std::uint16_t slot = baselineSequence % SNAPSHOT_HISTORY;
+    if (!m_hasReceived[slot] || m_received[slot].sequence != baselineSequence)
+    {
+      // The baseline isn't kept anymore, the snapshot can't be rebuilt. It isn't acknowledged, so the next ones come against an older one
+      return;
+    }
+    baseline = &m_received[slot];
+  }
+  Snapshot snapshot;
+  snapshot.sequence = sequence;
+  if (!NetProtocol::ReadSnapshot(_reader, baseline, snapshot))
+  {
+    return;
+  }
+  const std::uint16_t slot = sequence % SNAPSHOT_HISTORY;
+  m_received[slot] = std::move(snapshot);
+  m_hasReceived[slot] = true;
+  // The packets can come out of order, an older snapshot is only kept as a baseline
+  if (!m_hasLatest || static_cast<std::int16_t>(sequence - m_latestReceived) > 0)
+  {
+    m_latestReceived = sequence;
+    m_hasLatest = true;
+
+    const Snapshot& latest = m_received[slot];
+    m_interpolator.Push(latest, latest.time / 1000.0, NetConnection::Now());
+    const QuantizedEntityState* local = m_hasLocalEntity && latest.hasInput ? latest.Find(m_prediction.GetState().id) : nullptr;
+    if (local != nullptr)
+    {
+      m_prediction.Reconcile(NetProtocol::Dequantize(*local), latest.lastInput);
+    }
+  }
+
+  BitWriter ack;
+  ack.Write(NetProtocol::ACK, NetProtocol::MESSAGE_TYPE_BITS);
+  ack.Write(sequence, NetProtocol::SEQUENCE_BITS);
+  m_connection.Send(NetChannel::UNRELIABLE, ack.GetBytes());
 }
 
+void Multiplayer::ProcessAck(BitReader& _reader)
+{
+  const std::uint16_t sequence = static_cast<std::uint16_t>(_reader.Read(NetProtocol::SEQUENCE_BITS));
+  // Only a newer acknowledgement moves the baseline, the packets can come out of order
+  if (!_reader.IsOverflowed() && (!m_hasAck || static_cast<std::int16_t>(sequence - m_ackedSequence) > 0))
+  {
+    m_ackedSequence = sequence;
+    m_hasAck = true;
+  }
+}
 
-Multiplayer::~Multiplayer()
+void Multiplayer::ProcessInputs(BitReader& _reader)
 {
+  if (!NetProtocol::ReadInputs(_reader, m_readInputs))
+  {
+    return;
+  }
+  // The inputs come again in the next packets, only the ones newer than the last taken are new
+  for (const PlayerInput& input : m_readInputs)
+  {
+    if (!m_hasInputReceived || static_cast<std::int16_t>(input.sequence - m_lastInputReceived) > 0)
+    {
+      m_receivedInputs.push_back(input);
+      m_lastInputReceived = input.sequence;
+      m_hasInputReceived = true;
+    }
+  }
 }
 
-void Multiplayer::Loop()
+bool Multiplayer::PopInput(PlayerInput& _input)
+{
+  if (m_receivedInputs.empty())
+  {
+    return false;
+  }
+  _input = m_receivedInputs.front();
+  m_receivedInputs.pop_front();
+  return true;
+}
+
+void Multiplayer::SetLocalEntity(const EntityState& _state)
+{
+  m_prediction.Reset(_state);
+  m_hasLocalEntity = true;
+}
+
+void Multiplayer::SendInput(const PlayerInput& _input)
+{
+  if (m_hasLocalEntity)
+  {
+    m_prediction.Predict(_input);
+  }
+}
+
+void Multiplayer::WriteInputs()
+{
+  // Every input the server hasn't acknowledged yet, the newest if there are more, so a lost packet is covered by the next
+  PlayerInput inputs[NetProtocol::MAX_REDUNDANT_INPUTS];
+  const size_t numInputs = m_prediction.GetRecentInputs(inputs, NetProtocol::MAX_REDUNDANT_INPUTS);
+  BitWriter message;
+  message.Write(NetProtocol::INPUT, NetProtocol::MESSAGE_TYPE_BITS);
+  NetProtocol::WriteInputs(message, inputs, numInputs);
+  m_connection.Send(NetChannel::UNRELIABLE, message.GetBytes());
+}
+
+void Multiplayer::SendState(const std::vector<EntityState>& _entities)
 {
-  int iResult = 0;
+  m_pendingState = _entities;
+  m_hasPendingState = true;
+}
 
-  iResult = recv(m_connectSocket, m_recvbuf, m_recvbuflen, 0);
+void Multiplayer::SetPeerViewer(const glm::vec3& _position, float _radius)
+{
+  m_peerInterest.SetViewer(_position, _radius);
+  m_hasPeerViewer = true;
+}
 
-  for (int i = 0; i < iResult; i++)
+void Multiplayer::WriteSnapshot()
+{
+  const double now = NetConnection::Now();
+  const Snapshot* previous = m_nextSequence != 0 ? &m_sent[(m_nextSequence - 1) % SNAPSHOT_HISTORY] : nullptr;
+  Snapshot& snapshot = m_sent[m_nextSequence % SNAPSHOT_HISTORY];
+  snapshot.sequence = m_nextSequence++;
+  snapshot.time = static_cast<std::uint32_t>((now - m_startTime) * 1000.0);
+  snapshot.hasInput = m_hasInputReceived;
+  snapshot.lastInput = m_lastInputReceived;
+  snapshot.entities.clear();
+  if (m_hasPeerViewer)
   {
-    if (m_recvbuf[i] != '\n')
+    SelectEntities(snapshot, previous, static_cast<float>(now - m_lastSnapshotTime));
+  }
+  else
+  {
+    for (const EntityState& entity : m_pendingState)
     {
-      m_buffer += m_recvbuf[i];
+      snapshot.entities.push_back(NetProtocol::Quantize(entity));
     }
-    else
+    std::sort(snapshot.entities.begin(), snapshot.entities.end(), [](const QuantizedEntityState& _a, const QuantizedEntityState& _b)
     {
-      m_messages.push_back(m_buffer);
-      m_buffer = "";
-    }
+      return _a.id < _b.id;
+    });
   }
+  m_lastSnapshotTime = now;
 
-  ProcessMessages();
+  // Against the last snapshot the server acknowledged, if it's still kept (the slot of this one was just reused)
+  const Snapshot* baseline = nullptr;
+  if (m_hasAck && static_cast<std::uint16_t>(snapshot.sequence - m_ackedSequence) < SNAPSHOT_HISTORY)
+  {
+    baseline = &m_sent[m_ackedSequence % SNAPSHOT_HISTORY];
+  }
+  BitWriter message;
+  message.Write(NetProtocol::SNAPSHOT, NetProtocol::MESSAGE_TYPE_BITS);
+  NetProtocol::WriteSnapshot(message, snapshot, baseline);
+  m_lastSnapshotSize = message.GetBytes().size();
+  m_connection.Send(NetChannel::UNRELIABLE, message.GetBytes());
+  m_hasPendingState = false;
 }
 
-void Multiplayer::ProcessMessages()
+void Multiplayer::SelectEntities(Snapshot& _snapshot, const Snapshot* _previous, float _deltaTime)
 {
-  while (m_messages.size() > 0)
+  m_interestGrid.Build(m_pendingState);
+  m_peerInterest.Select(m_interestGrid, _deltaTime, m_sentEntities, m_heldEntities);
+
+  // The relevant entities not sent this time keep the state of the last snapshot, which costs nothing once the baseline has it.
+  // One relevant but never sent yet is left out until its turn comes
+  auto held = m_heldEntities.begin();
+  auto keepHeld = [&](std::uint32_t _until)
+  {
+    for (; held != m_heldEntities.end() && *held < _until; ++held)
+    {
+      const QuantizedEntityState* last = _previous != nullptr ? _previous->Find(*held) : nullptr;
+      if (last != nullptr)
+      {
+        _snapshot.entities.push_back(*last);
+      }
+    }
+  };
+  // Merged by id, the snapshot stays sorted
+  for (int index : m_sentEntities)
   {
-    // pos,6,4.3,8.9
-    m_messages.erase(m_messages.begin() + 0);
+    const QuantizedEntityState entity = NetProtocol::Quantize(m_interestGrid.GetEntity(index));
+    keepHeld(entity.id);
+    _snapshot.entities.push_back(entity);
   }
+  keepHeld(0x10000);
 }
 
-void Multiplayer::CleanUp()
+bool Multiplayer::GetLatestState(std::vector<EntityState>& _entities) const
 {
-  if (m_connectSocket != INVALID_SOCKET)
+  _entities.clear();
+  if (!m_hasLatest)
   {
-    closesocket(m_connectSocket);
+    return false;
   }
-  freeaddrinfo(m_result);
-  WSACleanup();
+  for (const QuantizedEntityState& entity : m_received[m_latestReceived % SNAPSHOT_HISTORY].entities)
+  {
+    _entities.push_back(NetProtocol::Dequantize(entity));
+  }
+  return true;
 }
-void Multiplayer::Send(const std::string& _message)
+
+bool Multiplayer::GetInterpolatedState(std::vector<EntityState>& _entities) const
 {
-  // Send an initial buffer
-  std::string toSend = _message + '\n';
-  int iResult;
-  iResult = send(m_connectSocket, toSend.c_str(), (int)(toSend.length()), 0);
-  if (iResult == SOCKET_ERROR)
+  if (!m_interpolator.Sample(NetConnection::Now(), _entities))
   {
-    CleanUp();
-    throw std::exception();
+    return false;
+  }
+  // The local entity is the predicted one
+  if (m_hasLocalEntity)
+  {
+    const std::uint16_t localId = m_prediction.GetState().id;
+    _entities.erase(std::remove_if(_entities.begin(), _entities.end(), [localId](const EntityState& _entity)
+    {
+      return _entity.id == localId;
+    }), _entities.end());
   }
+  return true;
+}
+
+void Multiplayer::CleanUp()
+{
+  m_connection.Close();
+  WSACleanup();
 }
@@ -3,30 +3,97 @@
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #include <windows.h>
-#include <string>
+#include <cstdint>
 #include <vector>
+#include <deque>
+#include "ClientPrediction.h"
+#include "InterestManager.h"
+#include "NetConnection.h"
+#include "NetProtocol.h"
+#include "SnapshotInterpolator.h"
 
-#define DEFAULT_BUFLEN 512
-
+// The connection to the server. The entity states go both ways as binary snapshots (see NetProtocol) on the unreliable channel of a
+// UDP connection (see NetConnection), each one delta coded against the last snapshot the other end acknowledged, and every snapshot
+// received is acknowledged. A lost snapshot isn't resent, the next one replaces it. Loop is polled every frame.
+// The local player is predicted from its inputs (see ClientPrediction), which go to the server with every packet until a snapshot
+// says it ran them; the other entities are shown a little in the past between the snapshots (see SnapshotInterpolator).
+// The inputs the other end sends are taken with PopInput, the snapshots sent say the last one taken.
+// With a viewer for the peer the snapshots only carry the entities around it, the nearest and most important most often under its
+// bandwidth (see ClientInterest); a server with several peers builds the InterestGrid once per tick and keeps a ClientInterest each
 class Multiplayer
 {
 public:
+  // The snapshots kept as baselines, a snapshot acknowledged later than this is sent whole
+  static constexpr std::uint16_t SNAPSHOT_HISTORY{ 32 };
+
   Multiplayer();
   ~Multiplayer();
 
+  // Receives and processes the messages which came, and sends a packet when the send rate allows it
   void Loop();
   void CleanUp();
-  void Send(const std::string& _message);
+  // The state of the entities sent as the next snapshot, with the next packet. A state not sent yet is replaced
+  void SendState(const std::vector<EntityState>& _entities);
+  // The entities of the latest snapshot received, false if none came yet
+  bool GetLatestState(std::vector<EntityState>& _entities) const;
+
+  // The entity the inputs move, predicted from _state on
+  void SetLocalEntity(const EntityState& _state);
+  // Applies the input to the local entity and sends it with the next packets
+  void SendInput(const PlayerInput& _input);
+  const EntityState& GetPredictedState() const noexcept { return m_prediction.GetState(); }
+  // The entities but the local one as they're shown now, interpolated between the snapshots. False if none came yet
+  bool GetInterpolatedState(std::vector<EntityState>& _entities) const;
+  // Takes the next input the other end sent, in order, false if there's none. The state sent after it has it applied
+  bool PopInput(PlayerInput& _input);
+
+  // Where the peer sees from (e.g. its player), the entities out of _radius aren't sent to it
+  void SetPeerViewer(const glm::vec3& _position, float _radius = ClientInterest::DEFAULT_RADIUS);
+  void SetPeerBandwidth(size_t _bytesPerSecond) { m_peerInterest.SetBandwidth(_bytesPerSecond); }
+  void SetImportance(std::uint16_t _id, float _importance) { m_interestGrid.SetImportance(_id, _importance); }
+
+  // The bytes of the last snapshot sent
+  size_t GetLastSnapshotSize() const noexcept { return m_lastSnapshotSize; }
+  const NetConnection& GetConnection() const noexcept { return m_connection; }
 
 private:
-  SOCKET m_connectSocket;
   WSADATA m_wsaData;
-  char m_recvbuf[DEFAULT_BUFLEN];
-  int m_recvbuflen = DEFAULT_BUFLEN;
-  struct addrinfo *m_result = nullptr;
-  std::vector<std::string> m_messages;
-  std::string m_buffer;
+  NetConnection m_connection;
+
+  std::vector<EntityState> m_pendingState;
+  bool m_hasPendingState = false;
+  Snapshot m_sent[SNAPSHOT_HISTORY];      ///< by sequence % SNAPSHOT_HISTORY
+  Snapshot m_received[SNAPSHOT_HISTORY];
+  bool m_hasReceived[SNAPSHOT_HISTORY] = {};
+  std::uint16_t m_nextSequence = 0;
+  std::uint16_t m_ackedSequence = 0;
+  bool m_hasAck = false;
+  std::uint16_t m_latestReceived = 0;
+  bool m_hasLatest = false;
+  size_t m_lastSnapshotSize = 0;
+  double m_startTime = 0.0;                ///< the zero of the snapshot times
+  double m_lastSnapshotTime = 0.0;
+
+  InterestGrid m_interestGrid;
+  ClientInterest m_peerInterest;
+  bool m_hasPeerViewer = false;
+  std::vector<int> m_sentEntities;
+  std::vector<std::uint16_t> m_heldEntities;
+
+  ClientPrediction m_prediction;
+  SnapshotInterpolator m_interpolator;
+  bool m_hasLocalEntity = false;
+
+  std::deque<PlayerInput> m_receivedInputs;
+  std::vector<PlayerInput> m_readInputs;
+  std::uint16_t m_lastInputReceived = 0;   ///< the newest input taken into m_receivedInputs
+  bool m_hasInputReceived = false;
 
   void ProcessMessages();
+  void ProcessSnapshot(BitReader& _reader);
+  void ProcessAck(BitReader& _reader);
+  void ProcessInputs(BitReader& _reader);
+  void WriteSnapshot();
+  void SelectEntities(Snapshot& _snapshot, const Snapshot* _previous, float _deltaTime);
+  void WriteInputs();
 };
-
@@ -0,0 +1,439 @@
+#include "NetConnection.h"
+
+#include <algorithm>
+#include <chrono>
+#include <initializer_list>
+
+namespace
+{
+  // The round trip and the loss are smoothed over about ten samples
+  constexpr float SMOOTHING{ 0.1f };
+  // A bad spell shortly after the conditions turned good doubles the time the next one has to last, ten good seconds halve it
+  constexpr double PENALTY_WINDOW{ 10.0 };
+  constexpr double MIN_PENALTY{ 1.0 };
+  constexpr double MAX_PENALTY{ 60.0 };
+  constexpr double MIN_RESEND_TIME{ 0.1 };
+}
+
+double NetConnection::Now()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool NetConnection::Connect(const std::string& _host, const std::string& _port)
+{
+  Close();
+
+  struct addrinfo hints;
+  struct addrinfo* result = nullptr;
+  ZeroMemory(&hints, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_DGRAM;
+  hints.ai_protocol = IPPROTO_UDP;
+  if (getaddrinfo(_host.c_str(), _port.c_str(), &hints, &result) != 0)
+  {
+    return false;
+  }
+  for (struct addrinfo* ptr = result; ptr != nullptr; ptr = ptr->ai_next)
+  {
+    m_socket = socket(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol);
+    if (m_socket == INVALID_SOCKET)
+    {
+      continue;
+    }
+    // Sets the peer, the packets of anyone else are dropped
+    if (connect(m_socket, ptr->ai_addr, (int)ptr->ai_addrlen) == SOCKET_ERROR)
+    {
+      closesocket(m_socket);
+      m_socket = INVALID_SOCKET;
+      continue;
+    }
+    break;
+  }
+  freeaddrinfo(result);
+  if (m_socket == INVALID_SOCKET)
+  {
+    return false;
+  }
+
+  u_long nonBlocking = 1;
+  ioctlsocket(m_socket, FIONBIO, &nonBlocking);
+  m_io.Start(m_socket);
+  const double now = Now();
+  m_nextSendTime = now;
+  m_conditionsTime = now;
+  m_penaltyReduceTime = now;
+  return true;
+}
+
+void NetConnection::Close()
+{
+  m_io.Stop();
+  if (m_socket != INVALID_SOCKET)
+  {
+    closesocket(m_socket);
+    m_socket = INVALID_SOCKET;
+  }
+}
+
+bool NetConnection::Send(NetChannel _channel, const std::vector<std::uint8_t>& _message)
+{
+  if (_message.size() > MAX_MESSAGE_SIZE)
+  {
+    return false;
+  }
+  if (_channel == NetChannel::UNRELIABLE)
+  {
+    if (m_numUnreliable == m_unreliable.size())
+    {
+      m_unreliable.emplace_back();
+    }
+    m_unreliable[m_numUnreliable++].assign(_message.begin(), _message.end());
+    return true;
+  }
+  ReliableChannel& channel = GetChannel(_channel);
+  // The peer only tells the resent messages apart within the history
+  if (channel.outgoing.size() >= HISTORY)
+  {
+    return false;
+  }
+  OutgoingMessage message;
+  message.id = channel.nextId++;
+  message.data = _message;
+  channel.outgoing.push_back(std::move(message));
+  return true;
+}
+
+bool NetConnection::Receive(NetChannel& _channel, std::vector<std::uint8_t>& _message)
+{
+  if (m_nextIncoming == m_numIncoming)
+  {
+    m_nextIncoming = 0;
+    m_numIncoming = 0;
+    return false;
+  }
+  const IncomingMessage& message = m_incoming[m_nextIncoming++];
+  _channel = message.channel;
+  _message.assign(message.data.begin(), message.data.end());
+  return true;
+}
+
+void NetConnection::Poll()
+{
+  NetIOThread::PacketRing& inbound = m_io.GetInbound();
+  while (const NetPacket* packet = inbound.Front())
+  {
+    ProcessPacket(packet->data, packet->size);
+    inbound.Pop();
+  }
+}
+
+bool NetConnection::IsSendDue() const
+{
+  return m_socket != INVALID_SOCKET && Now() >= m_nextSendTime;
+}
+
+void NetConnection::Flush()
+{
+  const double now = Now();
+  if (m_socket == INVALID_SOCKET || now < m_nextSendTime)
+  {
+    return;
+  }
+  UpdateConditions(now);
+  m_packet.Clear();
+  WritePacket(m_packet);
+  // With the outbound ring full the packet is lost like one dropped on the way
+  NetIOThread::PacketRing& outbound = m_io.GetOutbound();
+  if (NetPacket* packet = outbound.BeginPush())
+  {
+    packet->size = m_packet.GetBytes().size();
+    std::copy(m_packet.GetBytes().begin(), m_packet.GetBytes().end(), packet->data);
+    outbound.EndPush();
+  }
+
+  // At the rate, without a burst to catch up after a long frame
+  const double interval = 1.0 / GetSendRate();
+  m_nextSendTime = std::max(m_nextSendTime, now - interval) + interval;
+}
+
+void NetConnection::WritePacket(BitWriter& _writer)
+{
+  const double now = Now();
+  const std::uint16_t sequence = m_localSequence++;
+
+  // The packet which just left the acknowledgements is lost if they didn't have it
+  const std::uint16_t expired = static_cast<std::uint16_t>(sequence - ACK_BITS - 1);
+  const SentPacket& expiredPacket = m_sent[expired % HISTORY];
+  if (expiredPacket.isValid && expiredPacket.sequence == expired)
+  {
+    m_packetLoss += ((expiredPacket.isAcked ? 0.0f : 1.0f) - m_packetLoss) * SMOOTHING;
+  }
+
+  SentPacket& sent = m_sent[sequence % HISTORY];
+  sent.sequence = sequence;
+  sent.isValid = true;
+  sent.isAcked = false;
+  sent.time = now;
+  sent.messages.clear();
+
+  std::uint32_t ackBits = 0;
+  for (int i = 0; i < ACK_BITS; i++)
+  {
+    const std::uint16_t received = static_cast<std::uint16_t>(m_remoteSequence - 1 - i);
+    if (m_isReceived[received % HISTORY] && m_receivedSequences[received % HISTORY] == received)
+    {
+      ackBits |= 1u << i;
+    }
+  }
+  _writer.Write(PROTOCOL_ID, 16);
+  _writer.Write(sequence, 16);
+  _writer.WriteBool(m_hasRemote);
+  _writer.Write(m_remoteSequence, 16);
+  _writer.Write(ackBits, ACK_BITS);
+
+  // The messages which fit: the reliable ones due to be (re)sent first, they've waited longer, then the unreliable ones
+  std::vector<SelectedMessage>& selected = m_selected;
+  selected.clear();
+  size_t numBits = _writer.GetNumBits() + MESSAGE_COUNT_BITS;
+  const size_t maxMessages = (1u << MESSAGE_COUNT_BITS) - 1;
+  auto fits = [&](NetChannel _channel, size_t _size)
+  {
+    const size_t bits = 2 + (_channel != NetChannel::UNRELIABLE ? MESSAGE_ID_BITS : 0) + MESSAGE_SIZE_BITS + _size * 8;
+    if (selected.size() >= maxMessages || numBits + bits > MAX_PACKET_SIZE * 8)
+    {
+      return false;
+    }
+    numBits += bits;
+    return true;
+  };
+  const double resendTime = std::max(MIN_RESEND_TIME, 1.5 * m_roundTrip);
+  for (NetChannel channelType : { NetChannel::RELIABLE, NetChannel::ORDERED })
+  {
+    for (OutgoingMessage& message : GetChannel(channelType).outgoing)
+    {
+      if (message.lastSent >= 0.0 && now - message.lastSent < resendTime)
+      {
+        continue;
+      }
+      if (!fits(channelType, message.data.size()))
+      {
+        break;
+      }
+      message.lastSent = now;
+      selected.push_back({ channelType, message.id, &message.data });
+      sent.messages.emplace_back(channelType, message.id);
+    }
+  }
+  for (size_t i = 0; i < m_numUnreliable; i++)
+  {
+    if (fits(NetChannel::UNRELIABLE, m_unreliable[i].size()))
+    {
+      selected.push_back({ NetChannel::UNRELIABLE, 0, &m_unreliable[i] });
+    }
+  }
+
+  _writer.Write(static_cast<std::uint32_t>(selected.size()), MESSAGE_COUNT_BITS);
+  for (const SelectedMessage& message : selected)
+  {
+    _writer.Write(static_cast<std::uint32_t>(message.channel), 2);
+    if (message.channel != NetChannel::UNRELIABLE)
+    {
+      _writer.Write(message.id, MESSAGE_ID_BITS);
+    }
+    _writer.Write(static_cast<std::uint32_t>(message.data->size()), MESSAGE_SIZE_BITS);
+    for (std::uint8_t byte : *message.data)
+    {
+      _writer.Write(byte, 8);
+    }
+  }
+  // What didn't fit is stale by the next packet
+  m_numUnreliable = 0;
+}
+
+void NetConnection::ProcessPacket(const std::uint8_t* _data, size_t _size)
+{
+  BitReader reader(_data, _size);
+  if (reader.Read(16) != PROTOCOL_ID)
+  {
+    return;
+  }
+  const std::uint16_t sequence = static_cast<std::uint16_t>(reader.Read(16));
+  const bool hasAck = reader.ReadBool();
+  const std::uint16_t ack = static_cast<std::uint16_t>(reader.Read(16));
+  const std::uint32_t ackBits = reader.Read(ACK_BITS);
+  if (reader.IsOverflowed())
+  {
+    return;
+  }
+  // A duplicate, or so old it can't be told apart from one
+  if (m_hasRemote && !IsNewer(sequence, static_cast<std::uint16_t>(m_remoteSequence - HISTORY)))
+  {
+    return;
+  }
+  const std::uint16_t slot = sequence % HISTORY;
+  if (m_isReceived[slot] && m_receivedSequences[slot] == sequence)
+  {
+    return;
+  }
+
+  // The messages are read whole before anything of the packet is taken
+  const size_t numMessages = reader.Read(MESSAGE_COUNT_BITS);
+  if (m_packetMessages.size() < numMessages)
+  {
+    m_packetMessages.resize(numMessages);
+  }
+  for (size_t i = 0; i < numMessages; i++)
+  {
+    PacketMessage& message = m_packetMessages[i];
+    message.channel = static_cast<NetChannel>(reader.Read(2));
+    message.id = message.channel != NetChannel::UNRELIABLE ? static_cast<std::uint16_t>(reader.Read(MESSAGE_ID_BITS)) : 0;
+    message.data.resize(reader.Read(MESSAGE_SIZE_BITS));
+    for (std::uint8_t& byte : message.data)
+    {
+      byte = static_cast<std::uint8_t>(reader.Read(8));
+    }
+    if (reader.IsOverflowed() || message.channel >= NetChannel::NUM_CHANNELS)
+    {
+      return;
+    }
+  }
+
+  m_receivedSequences[slot] = sequence;
+  m_isReceived[slot] = true;
+  if (!m_hasRemote || IsNewer(sequence, m_remoteSequence))
+  {
+    m_remoteSequence = sequence;
+    m_hasRemote = true;
+  }
+
+  if (hasAck)
+  {
+    const double now = Now();
+    ProcessAck(ack, now);
+    for (int i = 0; i < ACK_BITS; i++)
+    {
+      if (ackBits & (1u << i))
+      {
+        ProcessAck(static_cast<std::uint16_t>(ack - 1 - i), now);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < numMessages; i++)
+  {
+    ReceiveMessage(m_packetMessages[i].channel, m_packetMessages[i].id, m_packetMessages[i].data);
+  }
+}
+
+void NetConnection::ProcessAck(std::uint16_t _sequence, double _now)
+{
+  SentPacket& packet = m_sent[_sequence % HISTORY];
+  if (!packet.isValid || packet.sequence != _sequence || packet.isAcked)
+  {
+    return;
+  }
+  packet.isAcked = true;
+  const float sample = static_cast<float>(_now - packet.time);
+  m_roundTrip = m_roundTrip == 0.0f ? sample : m_roundTrip + (sample - m_roundTrip) * SMOOTHING;
+
+  // Its reliable messages arrived, they're not resent anymore
+  for (const auto& sentMessage : packet.messages)
+  {
+    std::deque<OutgoingMessage>& outgoing = GetChannel(sentMessage.first).outgoing;
+    const auto it = std::find_if(outgoing.begin(), outgoing.end(), [&sentMessage](const OutgoingMessage& _message)
+    {
+      return _message.id == sentMessage.second;
+    });
+    if (it != outgoing.end())
+    {
+      outgoing.erase(it);
+    }
+  }
+  packet.messages.clear();
+}
+
+void NetConnection::PushIncoming(NetChannel _channel, const std::vector<std::uint8_t>& _data)
+{
+  if (m_numIncoming == m_incoming.size())
+  {
+    m_incoming.emplace_back();
+  }
+  IncomingMessage& message = m_incoming[m_numIncoming++];
+  message.channel = _channel;
+  message.data.assign(_data.begin(), _data.end());
+}
+
+void NetConnection::ReceiveMessage(NetChannel _channel, std::uint16_t _id, const std::vector<std::uint8_t>& _data)
+{
+  if (_channel == NetChannel::UNRELIABLE)
+  {
+    PushIncoming(_channel, _data);
+    return;
+  }
+  ReliableChannel& channel = GetChannel(_channel);
+  const std::uint16_t slot = _id % HISTORY;
+  if (_channel == NetChannel::RELIABLE)
+  {
+    // Resent because its acknowledgement was lost
+    if (channel.isReceived[slot] && channel.received[slot] == _id)
+    {
+      return;
+    }
+    channel.received[slot] = _id;
+    channel.isReceived[slot] = true;
+    PushIncoming(_channel, _data);
+    return;
+  }
+
+  // Ordered: delivered already, or held until the ones before it come
+  if (IsNewer(channel.nextDelivered, _id) || static_cast<std::uint16_t>(_id - channel.nextDelivered) >= HISTORY)
+  {
+    return;
+  }
+  if (!m_hasOrdered[slot])
+  {
+    m_ordered[slot].assign(_data.begin(), _data.end());
+    m_hasOrdered[slot] = true;
+  }
+  while (m_hasOrdered[channel.nextDelivered % HISTORY])
+  {
+    const std::uint16_t next = channel.nextDelivered % HISTORY;
+    PushIncoming(NetChannel::ORDERED, m_ordered[next]);
+    m_hasOrdered[next] = false;
+    channel.nextDelivered++;
+  }
+}
+
+void NetConnection::UpdateConditions(double _now)
+{
+  const bool isBad = m_roundTrip > BAD_ROUND_TRIP || m_packetLoss > BAD_PACKET_LOSS;
+  if (m_isGood)
+  {
+    if (isBad)
+    {
+      // Bad again soon after recovering, the next recovery has to hold longer
+      if (_now - m_conditionsTime < PENALTY_WINDOW)
+      {
+        m_penaltyTime = std::min(m_penaltyTime * 2.0, MAX_PENALTY);
+      }
+      m_isGood = false;
+      m_conditionsTime = _now;
+    }
+    else if (_now - m_penaltyReduceTime > PENALTY_WINDOW)
+    {
+      m_penaltyTime = std::max(m_penaltyTime / 2.0, MIN_PENALTY);
+      m_penaltyReduceTime = _now;
+    }
+  }
+  else if (isBad)
+  {
+    m_conditionsTime = _now;
+  }
+  else if (_now - m_conditionsTime > m_penaltyTime)
+  {
+    m_isGood = true;
+    m_conditionsTime = _now;
+    m_penaltyReduceTime = _now;
+  }
+}
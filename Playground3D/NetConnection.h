@@ -0,0 +1,159 @@
+#pragma once
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include "NetIOThread.h"
+#include "NetProtocol.h"
+
+// How the messages of a channel are delivered
+enum class NetChannel : std::uint32_t
+{
+  UNRELIABLE, ///< in the next packet only, lost with it. For states which the next one replaces
+  RELIABLE,   ///< resent until acknowledged, delivered once as it comes
+  ORDERED,    ///< resent until acknowledged, delivered once in the order it was sent
+  NUM_CHANNELS
+};
+
+/** \brief A connection to a peer over a UDP socket owned by a NetIOThread, polled from the game loop. Every packet has a sequence, the
+* latest sequence received from the peer and a bitfield of the 32 before it, so a packet is acknowledged by any of the next ones and
+* nothing waits on a lost one (no head-of-line blocking). The messages of the reliable channels are resent until a packet which
+* carried them is acknowledged. The packets are sent at a rate which drops when the round trip or the loss grow (see IsSendDue).
+* The packets and the unreliable and received messages reuse their buffers, only a reliable message allocates when it's queued */
+class NetConnection
+{
+public:
+  static constexpr size_t MAX_PACKET_SIZE{ NetPacket::MAX_SIZE };
+  static constexpr size_t MAX_MESSAGE_SIZE{ 1024 }; ///< a larger message isn't sent (no fragmentation)
+  static constexpr std::uint16_t PROTOCOL_ID{ 0x5033 };
+  // The packet rates, good conditions and bad ones
+  static constexpr float GOOD_SEND_RATE{ 30.0f };
+  static constexpr float BAD_SEND_RATE{ 10.0f };
+  // Past these the conditions are bad
+  static constexpr float BAD_ROUND_TRIP{ 0.25f };
+  static constexpr float BAD_PACKET_LOSS{ 0.1f };
+
+  // The clock of the connection, in seconds
+  static double Now();
+
+  NetConnection() {}
+  ~NetConnection() { Close(); }
+  NetConnection(const NetConnection&) = delete;
+  NetConnection& operator=(const NetConnection&) = delete;
+
+  // Resolves the peer and opens the socket (Winsock has to be started), false if it can't
+  bool Connect(const std::string& _host, const std::string& _port);
+  void Close();
+
+  // Queues a message for the next packets, false if it's too large
+  bool Send(NetChannel _channel, const std::vector<std::uint8_t>& _message);
+  // Takes the next message delivered, false if there's none
+  bool Receive(NetChannel& _channel, std::vector<std::uint8_t>& _message);
+
+  // Reads the packets the IO thread received, at the start of a frame
+  void Poll();
+  // The next packet goes out with this frame's Flush, the time to queue what should be as fresh as possible
+  bool IsSendDue() const;
+  // Hands a packet to the IO thread if one is due, with the acknowledgements even if no message is queued
+  void Flush();
+
+  // The packet logic without the socket
+  void ProcessPacket(const std::uint8_t* _data, size_t _size);
+  void WritePacket(BitWriter& _writer);
+
+  float GetRoundTripTime() const noexcept { return m_roundTrip; }
+  float GetPacketLoss() const noexcept { return m_packetLoss; }
+  float GetSendRate() const noexcept { return m_isGood ? GOOD_SEND_RATE : BAD_SEND_RATE; }
+
+private:
+  static constexpr std::uint16_t HISTORY{ 256 };  ///< sent and received packets, by sequence % HISTORY
+  static constexpr int ACK_BITS{ 32 };
+  static constexpr int MESSAGE_COUNT_BITS{ 6 };
+  static constexpr int MESSAGE_ID_BITS{ 16 };
+  static constexpr int MESSAGE_SIZE_BITS{ 11 };
+
+  struct SentPacket
+  {
+    std::uint16_t sequence = 0;
+    bool isValid = false;
+    bool isAcked = false;
+    double time = 0.0;
+    std::vector<std::pair<NetChannel, std::uint16_t>> messages; ///< the reliable ones it carried
+  };
+  struct OutgoingMessage
+  {
+    std::uint16_t id = 0;
+    std::vector<std::uint8_t> data;
+    double lastSent = -1.0; ///< never
+  };
+  struct ReliableChannel
+  {
+    std::deque<OutgoingMessage> outgoing; ///< not acknowledged yet, oldest first
+    std::uint16_t nextId = 0;
+    std::uint16_t received[HISTORY] = {};  ///< the ids received, by id % HISTORY, to drop the resent ones
+    bool isReceived[HISTORY] = {};
+    std::uint16_t nextDelivered = 0;       ///< ordered only
+  };
+  struct IncomingMessage
+  {
+    NetChannel channel = NetChannel::UNRELIABLE;
+    std::vector<std::uint8_t> data;
+  };
+  struct SelectedMessage
+  {
+    NetChannel channel;
+    std::uint16_t id;
+    const std::vector<std::uint8_t>* data;
+  };
+  struct PacketMessage
+  {
+    NetChannel channel = NetChannel::UNRELIABLE;
+    std::uint16_t id = 0;
+    std::vector<std::uint8_t> data;
+  };
+
+  static bool IsNewer(std::uint16_t _a, std::uint16_t _b) { return static_cast<std::int16_t>(_a - _b) > 0; }
+
+  ReliableChannel& GetChannel(NetChannel _channel) { return m_channels[_channel == NetChannel::ORDERED ? 1 : 0]; }
+  void ProcessAck(std::uint16_t _sequence, double _now);
+  void ReceiveMessage(NetChannel _channel, std::uint16_t _id, const std::vector<std::uint8_t>& _data);
+  void PushIncoming(NetChannel _channel, const std::vector<std::uint8_t>& _data);
+  void UpdateConditions(double _now);
+
+  SOCKET m_socket = INVALID_SOCKET;
+  NetIOThread m_io;
+  BitWriter m_packet; ///< the packet written, its bytes are kept
+
+  std::uint16_t m_localSequence = 0;
+  SentPacket m_sent[HISTORY];
+  std::uint16_t m_remoteSequence = 0;
+  bool m_hasRemote = false;
+  std::uint16_t m_receivedSequences[HISTORY] = {};
+  bool m_isReceived[HISTORY] = {};
+
+  // The pools below keep their elements and buffers, a count tells how many are in use
+  std::vector<std::vector<std::uint8_t>> m_unreliable;
+  size_t m_numUnreliable = 0;
+  ReliableChannel m_channels[2];     ///< reliable, ordered
+  std::vector<std::uint8_t> m_ordered[HISTORY]; ///< came ahead of the next ordered one, by id % HISTORY
+  bool m_hasOrdered[HISTORY] = {};
+  std::vector<IncomingMessage> m_incoming;
+  size_t m_numIncoming = 0;
+  size_t m_nextIncoming = 0;
+  std::vector<PacketMessage> m_packetMessages;   ///< the messages of the packet read
+  std::vector<SelectedMessage> m_selected;       ///< the messages of the packet written
+
+  // Round trip, loss and the send rate they give
+  float m_roundTrip = 0.0f;
+  float m_packetLoss = 0.0f;
+  bool m_isGood = true;
+  double m_nextSendTime = 0.0;
+  double m_conditionsTime = 0.0; ///< since when they've been as they are
+  double m_penaltyTime = 4.0;    ///< how long good conditions have to hold before the good rate again
+  double m_penaltyReduceTime = 0.0;
+};
@@ -0,0 +1,69 @@
+#include "NetIOThread.h"
+
+namespace
+{
+  // How long the thread waits for a packet before it looks at the outbound ring again, the most a queued packet waits
+  constexpr long WAIT_MICROSECONDS{ 1000 };
+}
+
+void NetIOThread::Start(SOCKET _socket)
+{
+  Stop();
+  m_socket = _socket;
+  m_stop = false;
+  m_thread = std::thread(&NetIOThread::Run, this);
+}
+
+void NetIOThread::Stop()
+{
+  m_stop = true;
+  if (m_thread.joinable())
+  {
+    m_thread.join();
+  }
+  m_socket = INVALID_SOCKET;
+}
+
+void NetIOThread::Run()
+{
+  NetPacket discarded;
+  while (!m_stop.load(std::memory_order_relaxed))
+  {
+    // Everything the game thread queued
+    while (NetPacket* packet = m_outbound.Front())
+    {
+      // A packet the socket can't take is lost like one dropped on the way
+      send(m_socket, reinterpret_cast<const char*>(packet->data), (int)packet->size, 0);
+      m_outbound.Pop();
+    }
+
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(m_socket, &readable);
+    timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = WAIT_MICROSECONDS;
+    if (select((int)m_socket + 1, &readable, nullptr, nullptr, &timeout) <= 0)
+    {
+      continue;
+    }
+    // Until the socket would block. An error (e.g. the port isn't open yet) drops the packet
+    while (true)
+    {
+      NetPacket* packet = m_inbound.BeginPush();
+      NetPacket* target = packet != nullptr ? packet : &discarded;
+      const int iResult = recv(m_socket, reinterpret_cast<char*>(target->data), (int)NetPacket::MAX_SIZE, 0);
+      if (iResult <= 0)
+      {
+        break;
+      }
+      if (packet == nullptr)
+      {
+        m_numDropped.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      packet->size = static_cast<size_t>(iResult);
+      m_inbound.EndPush();
+    }
+  }
+}
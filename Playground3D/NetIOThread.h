@@ -0,0 +1,53 @@
+#pragma once
+
+#include <winsock2.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include "SpscRing.h"
+
+// A datagram, in a buffer of the largest size so the rings never allocate
+struct NetPacket
+{
+  static constexpr size_t MAX_SIZE{ 1200 }; ///< under the usual MTU, a packet is never fragmented
+
+  size_t size = 0;
+  std::uint8_t data[MAX_SIZE];
+};
+
+/** \brief The thread which owns a socket: it receives the packets into a ring the game thread reads them from, and sends the ones the
+* game thread queues in another, so the frame never waits on a network syscall. The socket is only touched by this thread while it
+* runs. A full ring drops the packet, like the network would */
+class NetIOThread
+{
+public:
+  static constexpr size_t RING_SIZE{ 64 }; ///< a couple of seconds of packets at the send rate
+  using PacketRing = SpscRing<NetPacket, RING_SIZE>;
+
+  NetIOThread() {}
+  ~NetIOThread() { Stop(); }
+  NetIOThread(const NetIOThread&) = delete;
+  NetIOThread& operator=(const NetIOThread&) = delete;
+
+  void Start(SOCKET _socket);
+  // Joins the thread, the socket belongs to the caller again
+  void Stop();
+
+  // Game thread: the packets received, consumed with Front/Pop
+  PacketRing& GetInbound() noexcept { return m_inbound; }
+  // Game thread: the packets to send, filled with BeginPush/EndPush
+  PacketRing& GetOutbound() noexcept { return m_outbound; }
+
+  std::uint64_t GetNumDropped() const noexcept { return m_numDropped.load(std::memory_order_relaxed); }
+
+private:
+  void Run();
+
+  SOCKET m_socket = INVALID_SOCKET;
+  std::thread m_thread;
+  std::atomic<bool> m_stop{ false };
+  std::atomic<std::uint64_t> m_numDropped{ 0 }; ///< received with the inbound ring full
+  PacketRing m_inbound;
+  PacketRing m_outbound;
+};
@@ -0,0 +1,391 @@
+#include "NetProtocol.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+  const QuantizedEntityState ORIGIN = NetProtocol::Quantize(EntityState());
+
+  //the signed difference in the low bits, small either way
+  std::uint32_t ZigZag(std::int32_t _value)
+  {
+    return (static_cast<std::uint32_t>(_value) << 1) ^ static_cast<std::uint32_t>(_value >> 31);
+  }
+
+  std::int32_t UnZigZag(std::uint32_t _value)
+  {
+    return static_cast<std::int32_t>(_value >> 1) ^ -static_cast<std::int32_t>(_value & 1);
+  }
+
+  void WritePosition(BitWriter& _writer, const std::uint32_t* _position, const std::uint32_t* _base)
+  {
+    const std::int32_t limit = 1 << (NetProtocol::POSITION_DELTA_BITS - 1);
+    bool isClose = true;
+    for (int i = 0; i < 3; i++)
+    {
+      const std::int32_t delta = static_cast<std::int32_t>(_position[i]) - static_cast<std::int32_t>(_base[i]);
+      isClose = isClose && delta >= -limit && delta < limit;
+    }
+    _writer.WriteBool(isClose);
+    for (int i = 0; i < 3; i++)
+    {
+      if (isClose)
+      {
+        _writer.Write(ZigZag(static_cast<std::int32_t>(_position[i]) - static_cast<std::int32_t>(_base[i])), NetProtocol::POSITION_DELTA_BITS);
+      }
+      else
+      {
+        _writer.Write(_position[i], NetProtocol::POSITION_BITS);
+      }
+    }
+  }
+
+  void ReadPosition(BitReader& _reader, std::uint32_t* _position, const std::uint32_t* _base)
+  {
+    const bool isClose = _reader.ReadBool();
+    for (int i = 0; i < 3; i++)
+    {
+      if (isClose)
+      {
+        _position[i] = static_cast<std::uint32_t>(static_cast<std::int32_t>(_base[i]) + UnZigZag(_reader.Read(NetProtocol::POSITION_DELTA_BITS)));
+      }
+      else
+      {
+        _position[i] = _reader.Read(NetProtocol::POSITION_BITS);
+      }
+    }
+  }
+
+  //the ids are written in order, the next one after the last is the common case and takes a bit
+  void WriteId(BitWriter& _writer, std::uint16_t _id, int& _previousId)
+  {
+    const bool isNext = _id == _previousId + 1;
+    _writer.WriteBool(isNext);
+    if (!isNext)
+    {
+      _writer.Write(_id, NetProtocol::ENTITY_ID_BITS);
+    }
+    _previousId = _id;
+  }
+
+  std::uint16_t ReadId(BitReader& _reader, int& _previousId)
+  {
+    const std::uint16_t id = _reader.ReadBool() ? static_cast<std::uint16_t>(_previousId + 1) :
+      static_cast<std::uint16_t>(_reader.Read(NetProtocol::ENTITY_ID_BITS));
+    _previousId = id;
+    return id;
+  }
+
+  bool IsLess(const QuantizedEntityState& _a, const QuantizedEntityState& _b)
+  {
+    return _a.id < _b.id;
+  }
+
+  constexpr float TWO_PI{ 6.28318530718f };
+
+  //a value in [_min, _max] in _numBits steps
+  std::uint32_t QuantizeRange(float _value, float _min, float _max, int _numBits)
+  {
+    const float steps = static_cast<float>((1u << _numBits) - 1);
+    const float normalized = (std::min(std::max(_value, _min), _max) - _min) / (_max - _min);
+    return static_cast<std::uint32_t>(normalized * steps + 0.5f);
+  }
+
+  float DequantizeRange(std::uint32_t _value, float _min, float _max, int _numBits)
+  {
+    const float steps = static_cast<float>((1u << _numBits) - 1);
+    return _min + static_cast<float>(_value) / steps * (_max - _min);
+  }
+
+  //the yaw turned into [0, 2 pi)
+  float WrapYaw(float _yaw)
+  {
+    const float wrapped = std::fmod(_yaw, TWO_PI);
+    return wrapped < 0.0f ? wrapped + TWO_PI : wrapped;
+  }
+}
+
+void BitWriter::Write(std::uint32_t _value, int _numBits)
+{
+  for (int i = 0; i < _numBits; i++)
+  {
+    if (m_numBits % 8 == 0)
+    {
+      m_bytes.push_back(0);
+    }
+    if ((_value >> i) & 1u)
+    {
+      m_bytes.back() |= static_cast<std::uint8_t>(1u << (m_numBits % 8));
+    }
+    m_numBits++;
+  }
+}
+
+std::uint32_t BitReader::Read(int _numBits)
+{
+  if (m_position + _numBits > m_numBits)
+  {
+    m_isOverflowed = true;
+    m_position = m_numBits;
+    return 0;
+  }
+  std::uint32_t value = 0;
+  for (int i = 0; i < _numBits; i++)
+  {
+    if ((m_data[m_position / 8] >> (m_position % 8)) & 1u)
+    {
+      value |= 1u << i;
+    }
+    m_position++;
+  }
+  return value;
+}
+
+bool QuantizedEntityState::operator==(const QuantizedEntityState& _other) const
+{
+  return id == _other.id && std::equal(position, position + 3, _other.position) &&
+    std::equal(orientation.m_bits, orientation.m_bits + 3, _other.orientation.m_bits);
+}
+
+const QuantizedEntityState* Snapshot::Find(std::uint16_t _id) const
+{
+  QuantizedEntityState key;
+  key.id = _id;
+  const auto it = std::lower_bound(entities.begin(), entities.end(), key, IsLess);
+  return it != entities.end() && it->id == _id ? &*it : nullptr;
+}
+
+namespace NetProtocol
+{
+  QuantizedEntityState Quantize(const EntityState& _state)
+  {
+    const float steps = static_cast<float>((1u << POSITION_BITS) - 1);
+    QuantizedEntityState quantized;
+    quantized.id = _state.id;
+    for (int i = 0; i < 3; i++)
+    {
+      const float normalized = (std::min(std::max(_state.position[i], POSITION_MIN), POSITION_MAX) - POSITION_MIN) / (POSITION_MAX - POSITION_MIN);
+      quantized.position[i] = static_cast<std::uint32_t>(normalized * steps + 0.5f);
+    }
+    quantized.orientation = GameEngine::PackQuat(_state.orientation);
+    return quantized;
+  }
+
+  PlayerInput QuantizeInput(const PlayerInput& _input)
+  {
+    PlayerInput quantized;
+    quantized.sequence = _input.sequence;
+    quantized.deltaTime = static_cast<float>(QuantizeRange(_input.deltaTime * 1000.0f, 0.0f, 255.0f, INPUT_DELTA_TIME_BITS)) / 1000.0f;
+    for (int i = 0; i < 3; i++)
+    {
+      quantized.move[i] = DequantizeRange(QuantizeRange(_input.move[i], -1.0f, 1.0f, INPUT_MOVE_BITS), -1.0f, 1.0f, INPUT_MOVE_BITS);
+    }
+    //a full turn is the same yaw, the steps are of [0, 2 pi)
+    const std::uint32_t yaw = static_cast<std::uint32_t>(WrapYaw(_input.yaw) / TWO_PI * static_cast<float>(1u << INPUT_YAW_BITS) + 0.5f);
+    quantized.yaw = static_cast<float>(yaw & ((1u << INPUT_YAW_BITS) - 1)) / static_cast<float>(1u << INPUT_YAW_BITS) * TWO_PI;
+    return quantized;
+  }
+
+  EntityState Dequantize(const QuantizedEntityState& _state)
+  {
+    const float steps = static_cast<float>((1u << POSITION_BITS) - 1);
+    EntityState state;
+    state.id = _state.id;
+    for (int i = 0; i < 3; i++)
+    {
+      state.position[i] = POSITION_MIN + static_cast<float>(_state.position[i]) / steps * (POSITION_MAX - POSITION_MIN);
+    }
+    state.orientation = GameEngine::UnpackQuat(_state.orientation);
+    return state;
+  }
+
+  void WriteSnapshot(BitWriter& _writer, const Snapshot& _snapshot, const Snapshot* _baseline)
+  {
+    _writer.Write(_snapshot.sequence, SEQUENCE_BITS);
+    _writer.WriteBool(_baseline != nullptr);
+    if (_baseline != nullptr)
+    {
+      _writer.Write(_baseline->sequence, SEQUENCE_BITS);
+    }
+    _writer.Write(_snapshot.time, 32);
+    _writer.WriteBool(_snapshot.hasInput);
+    if (_snapshot.hasInput)
+    {
+      _writer.Write(_snapshot.lastInput, SEQUENCE_BITS);
+    }
+
+    //the entities which changed, an entity the baseline doesn't have is written against the origin
+    std::vector<const QuantizedEntityState*> changed;
+    for (const QuantizedEntityState& entity : _snapshot.entities)
+    {
+      const QuantizedEntityState* base = _baseline != nullptr ? _baseline->Find(entity.id) : nullptr;
+      if (base == nullptr || *base != entity)
+      {
+        changed.push_back(&entity);
+      }
+    }
+    const size_t numChanged = std::min(changed.size(), MAX_ENTITIES);
+    _writer.Write(static_cast<std::uint32_t>(numChanged), ENTITY_COUNT_BITS);
+    int previousId = -1;
+    for (size_t i = 0; i < numChanged; i++)
+    {
+      const QuantizedEntityState& entity = *changed[i];
+      const QuantizedEntityState* base = _baseline != nullptr ? _baseline->Find(entity.id) : nullptr;
+      if (base == nullptr)
+      {
+        base = &ORIGIN;
+      }
+      WriteId(_writer, entity.id, previousId);
+      const bool hasMoved = !std::equal(entity.position, entity.position + 3, base->position);
+      const bool hasTurned = !std::equal(entity.orientation.m_bits, entity.orientation.m_bits + 3, base->orientation.m_bits);
+      _writer.WriteBool(hasMoved);
+      if (hasMoved)
+      {
+        WritePosition(_writer, entity.position, base->position);
+      }
+      _writer.WriteBool(hasTurned);
+      if (hasTurned)
+      {
+        for (std::uint16_t bits : entity.orientation.m_bits)
+        {
+          _writer.Write(bits, 16);
+        }
+      }
+    }
+
+    //the entities gone since the baseline
+    std::vector<std::uint16_t> removed;
+    if (_baseline != nullptr)
+    {
+      for (const QuantizedEntityState& entity : _baseline->entities)
+      {
+        if (_snapshot.Find(entity.id) == nullptr)
+        {
+          removed.push_back(entity.id);
+        }
+      }
+    }
+    const size_t numRemoved = std::min(removed.size(), MAX_ENTITIES);
+    _writer.Write(static_cast<std::uint32_t>(numRemoved), ENTITY_COUNT_BITS);
+    previousId = -1;
+    for (size_t i = 0; i < numRemoved; i++)
+    {
+      WriteId(_writer, removed[i], previousId);
+    }
+  }
+
+  void ReadSnapshotHeader(BitReader& _reader, std::uint16_t& _sequence, bool& _hasBaseline, std::uint16_t& _baselineSequence)
+  {
+    _sequence = static_cast<std::uint16_t>(_reader.Read(SEQUENCE_BITS));
+    _hasBaseline = _reader.ReadBool();
+    _baselineSequence = _hasBaseline ? static_cast<std::uint16_t>(_reader.Read(SEQUENCE_BITS)) : 0;
+  }
+
+  bool ReadSnapshot(BitReader& _reader, const Snapshot* _baseline, Snapshot& _snapshot)
+  {
+    _snapshot.time = _reader.Read(32);
+    _snapshot.hasInput = _reader.ReadBool();
+    _snapshot.lastInput = _snapshot.hasInput ? static_cast<std::uint16_t>(_reader.Read(SEQUENCE_BITS)) : 0;
+
+    //what isn't written is as it was in the baseline
+    _snapshot.entities.clear();
+    if (_baseline != nullptr)
+    {
+      _snapshot.entities = _baseline->entities;
+    }
+
+    const size_t numChanged = _reader.Read(ENTITY_COUNT_BITS);
+    int previousId = -1;
+    for (size_t i = 0; i < numChanged && !_reader.IsOverflowed(); i++)
+    {
+      QuantizedEntityState entity;
+      entity.id = ReadId(_reader, previousId);
+      const QuantizedEntityState* found = _baseline != nullptr ? _baseline->Find(entity.id) : nullptr;
+      const QuantizedEntityState& base = found != nullptr ? *found : ORIGIN;
+      std::copy(base.position, base.position + 3, entity.position);
+      entity.orientation = base.orientation;
+      if (_reader.ReadBool())
+      {
+        ReadPosition(_reader, entity.position, base.position);
+      }
+      if (_reader.ReadBool())
+      {
+        for (std::uint16_t& bits : entity.orientation.m_bits)
+        {
+          bits = static_cast<std::uint16_t>(_reader.Read(16));
+        }
+      }
+      const auto it = std::lower_bound(_snapshot.entities.begin(), _snapshot.entities.end(), entity, IsLess);
+      if (it != _snapshot.entities.end() && it->id == entity.id)
+      {
+        *it = entity;
+      }
+      else
+      {
+        _snapshot.entities.insert(it, entity);
+      }
+    }
+
+    const size_t numRemoved = _reader.Read(ENTITY_COUNT_BITS);
+    previousId = -1;
+    for (size_t i = 0; i < numRemoved && !_reader.IsOverflowed(); i++)
+    {
+      QuantizedEntityState key;
+      key.id = ReadId(_reader, previousId);
+      const auto it = std::lower_bound(_snapshot.entities.begin(), _snapshot.entities.end(), key, IsLess);
+      if (it != _snapshot.entities.end() && it->id == key.id)
+      {
+        _snapshot.entities.erase(it);
+      }
+    }
+    return !_reader.IsOverflowed();
+  }
+
+  void WriteInputs(BitWriter& _writer, const PlayerInput* _inputs, size_t _numInputs)
+  {
+    _numInputs = std::min(_numInputs, MAX_REDUNDANT_INPUTS);
+    _writer.Write(static_cast<std::uint32_t>(_numInputs), INPUT_COUNT_BITS);
+    if (_numInputs == 0)
+    {
+      return;
+    }
+    _writer.Write(_inputs[0].sequence, SEQUENCE_BITS);
+    for (size_t i = 0; i < _numInputs; i++)
+    {
+      const PlayerInput& input = _inputs[i];
+      _writer.Write(QuantizeRange(input.deltaTime * 1000.0f, 0.0f, 255.0f, INPUT_DELTA_TIME_BITS), INPUT_DELTA_TIME_BITS);
+      for (int axis = 0; axis < 3; axis++)
+      {
+        _writer.Write(QuantizeRange(input.move[axis], -1.0f, 1.0f, INPUT_MOVE_BITS), INPUT_MOVE_BITS);
+      }
+      const std::uint32_t yaw = static_cast<std::uint32_t>(WrapYaw(input.yaw) / TWO_PI * static_cast<float>(1u << INPUT_YAW_BITS) + 0.5f);
+      _writer.Write(yaw & ((1u << INPUT_YAW_BITS) - 1), INPUT_YAW_BITS);
+    }
+  }
+
+  bool ReadInputs(BitReader& _reader, std::vector<PlayerInput>& _inputs)
+  {
+    _inputs.clear();
+    const size_t numInputs = _reader.Read(INPUT_COUNT_BITS);
+    if (numInputs == 0)
+    {
+      return !_reader.IsOverflowed();
+    }
+    const std::uint16_t first = static_cast<std::uint16_t>(_reader.Read(SEQUENCE_BITS));
+    for (size_t i = 0; i < numInputs && !_reader.IsOverflowed(); i++)
+    {
+      PlayerInput input;
+      input.sequence = static_cast<std::uint16_t>(first + i);
+      input.deltaTime = static_cast<float>(_reader.Read(INPUT_DELTA_TIME_BITS)) / 1000.0f;
+      for (int axis = 0; axis < 3; axis++)
+      {
+        input.move[axis] = DequantizeRange(_reader.Read(INPUT_MOVE_BITS), -1.0f, 1.0f, INPUT_MOVE_BITS);
+      }
+      input.yaw = static_cast<float>(_reader.Read(INPUT_YAW_BITS)) / static_cast<float>(1u << INPUT_YAW_BITS) * TWO_PI;
+      _inputs.push_back(input);
+    }
+    return !_reader.IsOverflowed();
+  }
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <GameEngine\AnimationCompression.h>
+#include <glm\vec3.hpp>
+#include <glm\gtc\quaternion.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Writes values of any width up to 32 bits back to back, the bytes are filled from their lowest bit
+class BitWriter
+{
+public:
+  void Write(std::uint32_t _value, int _numBits);
+  void WriteBool(bool _value) { Write(_value ? 1u : 0u, 1); }
+  void Clear() { m_bytes.clear(); m_numBits = 0; }
+
+  const std::vector<std::uint8_t>& GetBytes() const noexcept { return m_bytes; }
+  size_t GetNumBits() const noexcept { return m_numBits; }
+
+private:
+  std::vector<std::uint8_t> m_bytes;
+  size_t m_numBits = 0;
+};
+
+// Reads what a BitWriter wrote. Reading past the end gives zeros and marks the reader overflowed, the message is then dropped
+class BitReader
+{
+public:
+  BitReader(const std::uint8_t* _data, size_t _size) : m_data(_data), m_numBits(_size * 8) {}
+
+  std::uint32_t Read(int _numBits);
+  bool ReadBool() { return Read(1) != 0; }
+
+  bool IsOverflowed() const noexcept { return m_isOverflowed; }
+
+private:
+  const std::uint8_t* m_data;
+  size_t m_numBits;
+  size_t m_position = 0;
+  bool m_isOverflowed = false;
+};
+
+// The state of an entity as the game has it
+struct EntityState
+{
+  std::uint16_t id = 0;
+  glm::vec3 position{ 0.0f };
+  glm::quat orientation{ 1.0f, 0.0f, 0.0f, 0.0f };
+};
+
+// The state of an entity as it's sent: the position in steps of the world bounds and the orientation as its three smallest components
+// (see GameEngine::PackQuat). Two states are only compared and delta coded in this form, so both ends agree on them exactly
+struct QuantizedEntityState
+{
+  std::uint16_t id = 0;
+  std::uint32_t position[3] = { 0, 0, 0 };
+  GameEngine::PackedQuat orientation{ { 0, 0, 0 } };
+
+  bool operator==(const QuantizedEntityState& _other) const;
+  bool operator!=(const QuantizedEntityState& _other) const { return !(*this == _other); }
+};
+
+// What a player did for a frame, the client predicts it and the server runs it (see ClientPrediction::ApplyInput)
+struct PlayerInput
+{
+  std::uint16_t sequence = 0;
+  float deltaTime = 0.0f;     ///< in seconds
+  glm::vec3 move{ 0.0f };     ///< the direction wanted, each axis in [-1, 1]
+  float yaw = 0.0f;           ///< in radians
+};
+
+// The states of all the entities at one tick, sorted by id
+struct Snapshot
+{
+  std::uint16_t sequence = 0;
+  std::uint32_t time = 0;        ///< when the sender took it, in milliseconds of its clock
+  std::uint16_t lastInput = 0;   ///< the last input of the receiver the state includes, if hasInput
+  bool hasInput = false;
+  std::vector<QuantizedEntityState> entities;
+
+  const QuantizedEntityState* Find(std::uint16_t _id) const;
+};
+
+namespace NetProtocol
+{
+  // The positions are in these bounds, in steps of (MAX - MIN) / 2^POSITION_BITS, about a millimeter
+  constexpr float POSITION_MIN{ -1024.0f };
+  constexpr float POSITION_MAX{ 1024.0f };
+  constexpr int POSITION_BITS{ 21 };
+  // A position moving less than this many steps on every axis since the baseline is sent as the differences
+  constexpr int POSITION_DELTA_BITS{ 9 };
+  constexpr int SEQUENCE_BITS{ 16 };
+  constexpr int ENTITY_ID_BITS{ 16 };
+  constexpr int ENTITY_COUNT_BITS{ 11 };
+  constexpr size_t MAX_ENTITIES{ (1 << ENTITY_COUNT_BITS) - 1 };
+
+  enum MessageType : std::uint32_t { SNAPSHOT, ACK, INPUT, NUM_MESSAGE_TYPES };
+  constexpr int MESSAGE_TYPE_BITS{ 2 };
+  // The inputs are sent again in the next packets until the server has them, so one lost doesn't stall it
+  constexpr size_t MAX_REDUNDANT_INPUTS{ 15 };
+  constexpr int INPUT_COUNT_BITS{ 4 };
+  constexpr int INPUT_MOVE_BITS{ 8 };
+  constexpr int INPUT_YAW_BITS{ 16 };
+  constexpr int INPUT_DELTA_TIME_BITS{ 8 }; ///< in milliseconds
+
+  QuantizedEntityState Quantize(const EntityState& _state);
+  EntityState Dequantize(const QuantizedEntityState& _state);
+  // The input as the other end reads it, the client predicts with this so both run the same one
+  PlayerInput QuantizeInput(const PlayerInput& _input);
+
+  /** \brief Writes _snapshot as the difference to _baseline, a snapshot the other end has (the last one it acknowledged), or whole
+  * without one. Only the entities which changed are written and only their fields which changed, a position by how many steps it
+  * moved when it's close; the entities gone since the baseline are listed by id */
+  void WriteSnapshot(BitWriter& _writer, const Snapshot& _snapshot, const Snapshot* _baseline);
+  /** \brief Reads the header of a snapshot, the sequence of the baseline it was written against (if _hasBaseline) and its own */
+  void ReadSnapshotHeader(BitReader& _reader, std::uint16_t& _sequence, bool& _hasBaseline, std::uint16_t& _baselineSequence);
+  /** \brief Reads the entities of a snapshot after its header, _baseline must be the one of the header. False if the message is cut short */
+  bool ReadSnapshot(BitReader& _reader, const Snapshot* _baseline, Snapshot& _snapshot);
+
+  /** \brief Writes the inputs, oldest first with consecutive sequences (at most MAX_REDUNDANT_INPUTS) */
+  void WriteInputs(BitWriter& _writer, const PlayerInput* _inputs, size_t _numInputs);
+  /** \brief Reads the inputs of a message, false if it's cut short */
+  bool ReadInputs(BitReader& _reader, std::vector<PlayerInput>& _inputs);
+}
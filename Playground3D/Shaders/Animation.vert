@@ -21,7 +21,11 @@ uniform mat4 transformMatrix;
 uniform mat4 baseModelMatrix;
 uniform mat4 projection;
 uniform mat4 view;
-uniform mat4 gBones[MAX_BONES];
+//the bone palette of the drawn model, its range of the buffer of all the models (see GameEngine::AnimationSystem)
+layout (std140) uniform BonePalette
+{
+	mat4 gBones[MAX_BONES];
+};
 
 void main()
 {
@@ -0,0 +1,28 @@
+#version 330 core
+
+uniform sampler2D screenTexture;
+//(1, 0) blurs along x, (0, 1) along y, the two passes make a 2D gaussian
+uniform vec2 direction;
+
+in VS_OUT
+{
+	vec2 uv;
+} fs_in;
+
+out vec4 color;
+
+//a 9 tap gaussian in 5 linear lookups, the filtering blends each pair of taps
+const float offsets[3] = float[](0.0, 1.3846153846, 3.2307692308);
+const float weights[3] = float[](0.2270270270, 0.3162162162, 0.0702702703);
+
+void main()
+{
+	vec2 texelStep = direction / vec2(textureSize(screenTexture, 0));
+	vec3 result = texture(screenTexture, fs_in.uv).rgb * weights[0];
+	for(int i = 1; i < 3; ++i)
+	{
+		result += texture(screenTexture, fs_in.uv + texelStep * offsets[i]).rgb * weights[i];
+		result += texture(screenTexture, fs_in.uv - texelStep * offsets[i]).rgb * weights[i];
+	}
+	color = vec4(result, 1.0);
+}
@@ -0,0 +1,19 @@
+#version 330 core
+
+struct Material
+{
+	sampler2D texture_diffuse1;
+	sampler2D texture_specular1;
+	sampler2D texture_reflection1;
+	sampler2D texture_normal1;
+	float shininess;
+};
+
+uniform Material material;
+
+//only the depth, the polygon offset of the pass is the bias (see GameEngine::CascadedShadowMap::Render)
+void main()
+{
+	//the material is bound to every program of the queue, like in ShadowMap.frag
+	float annoying = material.shininess;
+}
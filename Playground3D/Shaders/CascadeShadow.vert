@@ -0,0 +1,32 @@
+#version 330 core
+//gl_Layer in the vertex shader, see GameEngine::RenderQueue3D::IsLayeredSupported
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+layout (location = 0) in vec3 position;
+
+uniform mat4 transformMatrix;
+uniform mat4 baseModelMatrix;
+//the cascades the draw reaches, 3 bits each: instance i renders cascade (layerFaces >> (3 * i)) & 7 (see RenderQueue3D::ExecuteLayered)
+uniform int layerFaces;
+
+const int MAX_CASCADES = 4;
+
+//the cascades of the sun, written once a frame (see GameEngine::CascadedShadowMap)
+layout (std140) uniform CascadeBlock
+{
+	mat4 cascadeMatrices[MAX_CASCADES];
+	//the view depth where each cascade ends
+	vec4 cascadeSplits;
+	//x the number of cascades, y the size of a texel of the maps
+	vec4 cascadeParams;
+};
+
+void main()
+{
+	int cascade = (layerFaces >> (3 * gl_InstanceID)) & 7;
+	gl_Position = cascadeMatrices[cascade] * baseModelMatrix * transformMatrix * vec4(position, 1.0);
+	//without it the cascade's layer is the one attached (see GameEngine::CascadedShadowMap::Render)
+#if defined(GL_ARB_shader_viewport_layer_array) || defined(GL_AMD_vertex_shader_layer)
+	gl_Layer = cascade;
+#endif
+}
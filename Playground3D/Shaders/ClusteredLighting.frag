@@ -0,0 +1,189 @@
+#version 430 core
+
+const float PI = 3.14159265;
+
+out vec4 color;
+
+in VS_OUT
+{
+	vec3 position;
+	vec2 uv;
+	mat3 TBN;
+} fs_in;
+
+struct Material
+{
+	sampler2D texture_diffuse1;
+	sampler2D texture_specular1;
+	sampler2D texture_reflection1;
+	sampler2D texture_normal1;
+	float shininess;
+};
+
+struct PointLight
+{
+	//w the range
+	vec4 position;
+	vec4 color;
+	//ambient, diffuse, specular
+	vec4 intensities;
+	//constant, linear, quadratic
+	vec4 attenuation;
+};
+
+struct SpotLight
+{
+	//w the range
+	vec4 position;
+	vec4 direction;
+	vec4 color;
+	vec4 intensities;
+	vec4 attenuation;
+	//the cosines of the inner and outer cut offs
+	vec4 cutOffs;
+};
+
+//the camera, written once a frame (see GameEngine::FrameUniforms)
+layout (std140) uniform FrameUniforms
+{
+	mat4 projection;
+	mat4 view;
+	mat4 viewProjection;
+	vec4 cameraPos;
+	vec4 frameTime;
+	mat4 inverseViewProjection;
+};
+
+//the lights and their clusters (see GameEngine::LightClusters)
+layout (std430, binding = 4) readonly buffer ClusterPointLights { PointLight pointLights[]; };
+layout (std430, binding = 5) readonly buffer ClusterSpotLights { SpotLight spotLights[]; };
+layout (std430, binding = 6) readonly buffer LightGrid
+{
+	//tiles x, tiles y, depth slices, the number of point lights
+	uvec4 gridSize;
+	//slice = floor(log(view depth) * x - y)
+	vec4 depthSlicing;
+	//the offset and count of the lights of every cluster in lightIndices
+	uvec2 clusters[];
+};
+layout (std430, binding = 7) readonly buffer LightIndices { uint lightIndices[]; };
+
+uniform Material material;
+//the shadow of the first point light
+uniform samplerCube shadowMap;
+uniform float farPlane;
+
+// array of offset direction for sampling
+vec3 gridSamplingDisk[20] = vec3[]
+(
+   vec3(1, 1, 1), vec3(1, -1, 1), vec3(-1, -1, 1), vec3(-1, 1, 1), 
+   vec3(1, 1, -1), vec3(1, -1, -1), vec3(-1, -1, -1), vec3(-1, 1, -1),
+   vec3(1, 1, 0), vec3(1, -1, 0), vec3(-1, -1, 0), vec3(-1, 1, 0),
+   vec3(1, 0, 1), vec3(-1, 0, 1), vec3(1, 0, -1), vec3(-1, 0, -1),
+   vec3(0, 1, 1), vec3(0, -1, 1), vec3(0, -1, -1), vec3(0, 1, -1)
+);
+
+uint GetCluster(vec3 _fragPos);
+float CalculateShadow(vec3 _fragPos, vec3 _lightPos);
+vec3 CalcLight(vec3 _lightPos, vec3 _lightColor, vec4 _intensities, vec4 _attenuation, float _shadow, vec3 _normal, vec3 _fragPos, vec3 _viewDir);
+
+void main()
+{
+	// Obtain normal from normal map in range [0;1]
+	vec3 normal = texture(material.texture_normal1, fs_in.uv).rgb;
+	//Transform the normal vector to range [-1;1].
+	normal = normalize(normal * 2.0 - 1.0); //< the normal in tangent space
+	//Use the TBN matrix to transform the tangent space normal to world space
+	normal = normalize(fs_in.TBN * normal);
+	
+	vec3 viewDir = normalize(cameraPos.xyz - fs_in.position);
+	vec3 result = vec3(0.0, 0.0, 0.0);
+	vec3 textureColor = texture(material.texture_diffuse1, fs_in.uv).rgb;
+
+	//only the lights that reach the cluster of the fragment
+	uvec2 cluster = clusters[GetCluster(fs_in.position)];
+	for(uint i = cluster.x; i < cluster.x + cluster.y; ++i)
+	{
+		uint index = lightIndices[i];
+		if(index < gridSize.w)
+		{
+			PointLight light = pointLights[index];
+			float shadow = index == 0u ? CalculateShadow(fs_in.position, light.position.xyz) : 0.0;
+			result += CalcLight(light.position.xyz, light.color.rgb, light.intensities, light.attenuation, shadow, normal, fs_in.position, viewDir);
+		}
+		else
+		{
+			SpotLight light = spotLights[index - gridSize.w];
+			vec3 lightDir = normalize(light.position.xyz - fs_in.position);
+			//soft edges between the inner and the outer cone
+			float theta = dot(lightDir, normalize(-light.direction.xyz));
+			float intensity = clamp((theta - light.cutOffs.y) / (light.cutOffs.x - light.cutOffs.y), 0.0, 1.0);
+			result += intensity * CalcLight(light.position.xyz, light.color.rgb, light.intensities, light.attenuation, 0.0, normal, fs_in.position, viewDir);
+		}
+	}
+	
+	result *= textureColor;
+	color = vec4(result, 1.0f);
+}
+uint GetCluster(vec3 _fragPos)
+{
+	//the tile from the clip space position, the slice from the view depth
+	vec4 clipPos = viewProjection * vec4(_fragPos, 1.0);
+	vec2 tile = clamp((clipPos.xy / clipPos.w * 0.5 + 0.5) * vec2(gridSize.xy), vec2(0.0), vec2(gridSize.xy) - 1.0);
+	float viewDepth = -(view * vec4(_fragPos, 1.0)).z;
+	float slice = clamp(floor(log(max(viewDepth, depthSlicing.z)) * depthSlicing.x - depthSlicing.y), 0.0, float(gridSize.z - 1u));
+	return uint(tile.x) + (uint(tile.y) + uint(slice) * gridSize.y) * gridSize.x;
+}
+float CalculateShadow(vec3 _fragPos, vec3 _lightPos)
+{	
+	vec3 fragToLight = _fragPos - _lightPos;
+	//retrieve the depth value between the current fragment and the light source which we can easily obtain by taking the length of fragToLight
+	float currentDepth = length(fragToLight);
+	
+	// Test for shadows with PCF
+    float shadow = 0.0;
+    float bias = 0.15;
+    int samples = 20;
+	
+	float viewDistance = length(cameraPos.xyz - _fragPos);
+    float diskRadius = (1.0 + (viewDistance / farPlane)) / 25.0;
+	
+	float closestDepth = 0.0f;
+	
+	for(int i = 0; i < samples; ++i)
+    {
+        closestDepth = texture(shadowMap, fragToLight + gridSamplingDisk[i] * diskRadius).r;
+		//The closestDepth value is currently in the range [0,1] so we first transform it back to [0,far_plane] by multiplying it with far_plane
+        closestDepth *= farPlane;
+		
+        if(currentDepth - bias > closestDepth)
+		{
+			shadow += 1.0;
+		}
+    }
+    shadow /= float(samples);
+	
+	return shadow;
+}
+vec3 CalcLight(vec3 _lightPos, vec3 _lightColor, vec4 _intensities, vec4 _attenuation, float _shadow, vec3 _normal, vec3 _fragPos, vec3 _viewDir)
+{
+	vec3 lightDir = normalize(_lightPos - _fragPos);
+
+	//diffuse
+	float diff = max(dot(_normal, lightDir), 0.0);
+	
+	float energyConservation = ( 8.0 + material.shininess ) / ( 8.0 * PI ); 
+	vec3 halfwayDir = normalize(lightDir + _viewDir);
+	float spec = energyConservation * pow(max(dot(_normal, halfwayDir), 0.0), material.shininess); 
+	
+	//attenuation
+	float rdistance = length(_lightPos - _fragPos);
+	float attenuation = 1.0f / (_attenuation.x + _attenuation.y * rdistance + _attenuation.z * (rdistance * rdistance));
+	
+	//Combine result, the ambient fades too, the light only reaches its clusters
+	vec3 ambient  = _intensities.x * _lightColor;
+	vec3 diffuse  = _intensities.y * diff * _lightColor;
+	vec3 specular = _intensities.z * spec * _lightColor;
+	
+	return attenuation * (ambient + (1.0f - _shadow) * (diffuse + specular));
+}
@@ -0,0 +1,41 @@
+#version 330 core
+
+uniform sampler2D screenTexture;
+
+in VS_OUT
+{
+	vec2 uv;
+} fs_in;
+
+out vec4 color;
+
+//the edges the dynamic resolution blurred are won back with an unsharp mask, 0 would be a plain bilinear upscale
+const float SHARPNESS = 0.25;
+//how dark the corners get
+const float VIGNETTE_STRENGTH = 0.35;
+const float CONTRAST = 1.1;
+const float SATURATION = 1.15;
+
+//the last pass of the frame: the effects which only need their own pixel run here together (compiled in by their defines, see
+//GameEngine::ShaderVariants) while the target is copied to the screen, instead of a pass each
+void main()
+{
+	vec3 scene = texture(screenTexture, fs_in.uv).rgb;
+#ifdef SHARPEN
+	//the 4 neighbours of the source pixel, the filtering of the target does the bilinear part of the upscale
+	vec2 texel = 1.0 / vec2(textureSize(screenTexture, 0));
+	vec3 neighbours = texture(screenTexture, fs_in.uv + vec2(texel.x, 0.0)).rgb + texture(screenTexture, fs_in.uv - vec2(texel.x, 0.0)).rgb +
+		texture(screenTexture, fs_in.uv + vec2(0.0, texel.y)).rgb + texture(screenTexture, fs_in.uv - vec2(0.0, texel.y)).rgb;
+	scene = max(scene + (scene - neighbours * 0.25) * SHARPNESS, 0.0);
+#endif
+#ifdef COLOR_GRADE
+	float luminance = dot(scene, vec3(0.2126, 0.7152, 0.0722));
+	scene = mix(vec3(luminance), scene, SATURATION);
+	scene = (scene - 0.5) * CONTRAST + 0.5;
+#endif
+#ifdef VIGNETTE
+	vec2 offset = fs_in.uv - 0.5;
+	scene *= 1.0 - VIGNETTE_STRENGTH * smoothstep(0.2, 0.8, dot(offset, offset) * 2.0);
+#endif
+	color = vec4(clamp(scene, 0.0, 1.0), 1.0);
+}
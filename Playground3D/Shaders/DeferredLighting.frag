@@ -0,0 +1,223 @@
+#version 330 core
+
+const float PI = 3.14159265;
+
+out vec4 color;
+
+in VS_OUT
+{
+	vec2 uv;
+} fs_in;
+
+const int MAX_POINT_LIGHTS = 8;
+const int MAX_SPOT_LIGHTS = 4;
+const int MAX_DIRECTIONAL_LIGHTS = 2;
+
+struct PointLight
+{
+	vec4 position;
+	vec4 color;
+	//ambient, diffuse, specular
+	vec4 intensities;
+	//constant, linear, quadratic
+	vec4 attenuation;
+};
+
+struct SpotLight
+{
+	vec4 position;
+	vec4 direction;
+	vec4 color;
+	vec4 intensities;
+	vec4 attenuation;
+	//inner, outer
+	vec4 cutOffs;
+};
+
+struct DirectionalLight
+{
+	vec4 direction;
+	vec4 color;
+	vec4 intensities;
+};
+
+//the lights of the frame, written once a frame (see GameEngine::LightBlock)
+layout (std140) uniform LightBlock
+{
+	PointLight pointLights[MAX_POINT_LIGHTS];
+	SpotLight spotLights[MAX_SPOT_LIGHTS];
+	DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHTS];
+	//point, spot, directional
+	ivec4 lightCounts;
+	//x the far plane of the shadow cubemap
+	vec4 shadowParams;
+};
+
+//the camera, written once a frame (see GameEngine::FrameUniforms)
+layout (std140) uniform FrameUniforms
+{
+	mat4 projection;
+	mat4 view;
+	mat4 viewProjection;
+	vec4 cameraPos;
+	vec4 frameTime;
+	mat4 inverseViewProjection;
+};
+
+const int MAX_CASCADES = 4;
+
+//the cascades of the first directional light, written once a frame (see GameEngine::CascadedShadowMap)
+layout (std140) uniform CascadeBlock
+{
+	mat4 cascadeMatrices[MAX_CASCADES];
+	//the view depth where each cascade ends
+	vec4 cascadeSplits;
+	//x the number of cascades, y the size of a texel of the maps
+	vec4 cascadeParams;
+};
+
+//the G-buffer (see GameEngine::GBuffer)
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gMaterial;
+uniform sampler2D gDepth;
+//the shadow of the first point light
+uniform samplerCube shadowMap;
+//the shadow of the first directional light, a layer a cascade
+uniform sampler2DArrayShadow cascadeShadowMap;
+
+// array of offset direction for sampling
+vec3 gridSamplingDisk[20] = vec3[]
+(
+   vec3(1, 1, 1), vec3(1, -1, 1), vec3(-1, -1, 1), vec3(-1, 1, 1), 
+   vec3(1, 1, -1), vec3(1, -1, -1), vec3(-1, -1, -1), vec3(-1, 1, -1),
+   vec3(1, 1, 0), vec3(1, -1, 0), vec3(-1, -1, 0), vec3(-1, 1, 0),
+   vec3(1, 0, 1), vec3(-1, 0, 1), vec3(1, 0, -1), vec3(-1, 0, -1),
+   vec3(0, 1, 1), vec3(0, -1, 1), vec3(0, -1, -1), vec3(0, 1, -1)
+);
+
+float CalculateShadow(vec3 _fragPos, vec3 _lightPos);
+float CalculateCascadeShadow(vec3 _fragPos, vec3 _normal);
+vec3 CalcLight(vec3 _lightDir, vec3 _lightColor, vec4 _intensities, float _attenuation, float _shadow, vec3 _normal, vec3 _viewDir, float _shininess);
+
+void main()
+{
+	float depth = texture(gDepth, fs_in.uv).r;
+	//nothing was drawn there, the sky comes later
+	if(depth == 1.0)
+	{
+		discard;
+	}
+	//the world position back from the depth
+	vec4 worldPos = inverseViewProjection * vec4(vec3(fs_in.uv, depth) * 2.0 - 1.0, 1.0);
+	vec3 fragPos = worldPos.xyz / worldPos.w;
+	vec3 normal = texture(gNormal, fs_in.uv).xyz;
+	vec3 albedo = texture(gAlbedo, fs_in.uv).rgb;
+	float shininess = texture(gMaterial, fs_in.uv).r * 256.0;
+	vec3 viewDir = normalize(cameraPos.xyz - fragPos);
+	vec3 result = vec3(0.0, 0.0, 0.0);
+
+	for(int i = 0; i < lightCounts.x; ++i)
+	{
+		vec3 lightPos = pointLights[i].position.xyz;
+		vec4 att = pointLights[i].attenuation;
+		float rdistance = length(lightPos - fragPos);
+		float attenuation = 1.0 / (att.x + att.y * rdistance + att.z * (rdistance * rdistance));
+		float shadow = i == 0 ? CalculateShadow(fragPos, lightPos) : 0.0;
+		result += CalcLight(normalize(lightPos - fragPos), pointLights[i].color.rgb, pointLights[i].intensities, attenuation, shadow, normal, viewDir, shininess);
+	}
+	for(int i = 0; i < lightCounts.y; ++i)
+	{
+		vec3 lightPos = spotLights[i].position.xyz;
+		vec3 lightDir = normalize(lightPos - fragPos);
+		vec4 att = spotLights[i].attenuation;
+		float rdistance = length(lightPos - fragPos);
+		float attenuation = 1.0 / (att.x + att.y * rdistance + att.z * (rdistance * rdistance));
+		//soft edges between the inner and the outer cone
+		float theta = dot(lightDir, normalize(-spotLights[i].direction.xyz));
+		vec4 cutOffs = spotLights[i].cutOffs;
+		attenuation *= clamp((theta - cutOffs.y) / (cutOffs.x - cutOffs.y), 0.0, 1.0);
+		result += CalcLight(lightDir, spotLights[i].color.rgb, spotLights[i].intensities, attenuation, 0.0, normal, viewDir, shininess);
+	}
+	for(int i = 0; i < lightCounts.z; ++i)
+	{
+		float shadow = i == 0 ? CalculateCascadeShadow(fragPos, normal) : 0.0;
+		result += CalcLight(normalize(-directionalLights[i].direction.xyz), directionalLights[i].color.rgb, directionalLights[i].intensities, 1.0, shadow, normal, viewDir, shininess);
+	}
+	
+	color = vec4(result * albedo, 1.0f);
+}
+float CalculateShadow(vec3 _fragPos, vec3 _lightPos)
+{	
+	vec3 fragToLight = _fragPos - _lightPos;
+	float currentDepth = length(fragToLight);
+	
+	// Test for shadows with PCF
+    float shadow = 0.0;
+    float bias = 0.15;
+    int samples = 20;
+	float farPlane = shadowParams.x;
+	
+	float viewDistance = length(cameraPos.xyz - _fragPos);
+    float diskRadius = (1.0 + (viewDistance / farPlane)) / 25.0;
+	
+	for(int i = 0; i < samples; ++i)
+    {
+		//the depths of the cubemap are in [0;1] of the far plane
+        float closestDepth = texture(shadowMap, fragToLight + gridSamplingDisk[i] * diskRadius).r * farPlane;
+        if(currentDepth - bias > closestDepth)
+		{
+			shadow += 1.0;
+		}
+    }
+	return shadow / float(samples);
+}
+float CalculateCascadeShadow(vec3 _fragPos, vec3 _normal)
+{
+	//the first cascade that reaches the depth, past the last one there's no shadow
+	float viewDepth = -(view * vec4(_fragPos, 1.0)).z;
+	int numCascades = int(cascadeParams.x);
+	int cascade = 0;
+	while(cascade < numCascades && viewDepth > cascadeSplits[cascade])
+	{
+		++cascade;
+	}
+	if(cascade == numCascades)
+	{
+		return 0.0;
+	}
+	//pushed along the normal by a texel of the cascade against the acne of the surfaces facing away from the light
+	float texelSize = cascadeParams.y;
+	//the first row of the matrix is the light's right axis over the half width of the cascade
+	mat4 cascadeMatrix = cascadeMatrices[cascade];
+	float texelWorldSize = 2.0 * texelSize / length(vec3(cascadeMatrix[0][0], cascadeMatrix[1][0], cascadeMatrix[2][0]));
+	vec4 lightSpacePos = cascadeMatrix * vec4(_fragPos + _normal * texelWorldSize, 1.0);
+	vec3 mapPos = lightSpacePos.xyz * 0.5 + 0.5;
+	
+	// 3x3 PCF, each lookup compares the 4 nearest depths already
+	float lit = 0.0;
+	for(int x = -1; x <= 1; ++x)
+	{
+		for(int y = -1; y <= 1; ++y)
+		{
+			lit += texture(cascadeShadowMap, vec4(mapPos.xy + vec2(x, y) * texelSize, float(cascade), mapPos.z));
+		}
+	}
+	return 1.0 - lit / 9.0;
+}
+vec3 CalcLight(vec3 _lightDir, vec3 _lightColor, vec4 _intensities, float _attenuation, float _shadow, vec3 _normal, vec3 _viewDir, float _shininess)
+{
+	//diffuse
+	float diff = max(dot(_normal, _lightDir), 0.0);
+	
+	float energyConservation = ( 8.0 + _shininess ) / ( 8.0 * PI ); 
+	vec3 halfwayDir = normalize(_lightDir + _viewDir);
+	float spec = energyConservation * pow(max(dot(_normal, halfwayDir), 0.0), _shininess); 
+	
+	//Combine result, the ambient isn't attenuated like in PointLighting.frag
+	vec3 ambient  = _intensities.x * _lightColor;
+	vec3 diffuse  = _intensities.y * diff * _lightColor * _attenuation;
+	vec3 specular = _intensities.z * spec * _lightColor * _attenuation;
+	
+	return ambient + (1.0f - _shadow) * (diffuse + specular);
+}
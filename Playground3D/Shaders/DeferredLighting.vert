@@ -0,0 +1,14 @@
+#version 330 core
+layout (location = 0) in vec2 position;
+layout (location = 1) in vec2 uv;
+
+out VS_OUT
+{
+	vec2 uv;
+} vs_out;
+
+void main()
+{
+	gl_Position = vec4(position.x, position.y, 0.0f, 1.0f);
+	vs_out.uv = uv;
+}
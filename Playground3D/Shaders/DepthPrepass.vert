@@ -0,0 +1,29 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+//the model matrix of the instance in a GeometryPool draw
+layout (location = 4) in mat4 modelInstanced;
+
+uniform mat4 transformMatrix;
+uniform mat4 baseModelMatrix;
+//the camera, written once a frame (see GameEngine::FrameUniforms)
+layout (std140) uniform FrameUniforms
+{
+	mat4 projection;
+	mat4 view;
+	mat4 viewProjection;
+	vec4 cameraPos;
+	vec4 frameTime;
+	mat4 inverseViewProjection;
+};
+
+uniform bool instanced;
+
+//the lit pass tests GL_EQUAL against this depth, PointLighting.vert computes its position the same way
+invariant gl_Position;
+
+void main()
+{
+	mat4 model = instanced ? modelInstanced : baseModelMatrix * transformMatrix;
+	gl_Position = viewProjection * model * vec4(position, 1.0);
+}
@@ -0,0 +1,37 @@
+#version 330 core
+
+//the surface of the pixel, lit later by DeferredLighting.frag (see GameEngine::GBuffer)
+layout (location = 0) out vec4 gAlbedo;
+layout (location = 1) out vec4 gNormal;
+layout (location = 2) out vec4 gMaterial;
+
+in VS_OUT
+{
+	vec3 position;
+	vec2 uv;
+	mat3 TBN;
+} fs_in;
+
+struct Material
+{
+	sampler2D texture_diffuse1;
+	sampler2D texture_specular1;
+	sampler2D texture_reflection1;
+	sampler2D texture_normal1;
+	float shininess;
+};
+
+uniform Material material;
+
+void main()
+{
+	// Obtain normal from normal map in range [0;1]
+	vec3 normal = texture(material.texture_normal1, fs_in.uv).rgb;
+	//Transform the normal vector to range [-1;1].
+	normal = normalize(normal * 2.0 - 1.0); //< the normal in tangent space
+	//Use the TBN matrix to transform the tangent space normal to world space
+	gNormal = vec4(normalize(fs_in.TBN * normal), 0.0);
+	
+	gAlbedo = vec4(texture(material.texture_diffuse1, fs_in.uv).rgb, 1.0);
+	gMaterial = vec4(material.shininess / 256.0, 0.0, 0.0, 0.0);
+}
@@ -4,12 +4,20 @@ layout (location = 0) in vec3 position;
 
 uniform mat4 transformMatrix;
 uniform mat4 baseModelMatrix;
-uniform mat4 view;
-uniform mat4 projection;
+//the camera, written once a frame (see GameEngine::FrameUniforms)
+layout (std140) uniform FrameUniforms
+{
+	mat4 projection;
+	mat4 view;
+	mat4 viewProjection;
+	vec4 cameraPos;
+	vec4 frameTime;
+	mat4 inverseViewProjection;
+};
 
 void main()
 {
 	mat4 model = baseModelMatrix * transformMatrix;
 	//the vertex position in clip space
-	gl_Position = projection * view * model * vec4(position, 1.0);
+	gl_Position = viewProjection * model * vec4(position, 1.0);
 }
\ No newline at end of file
@@ -1,6 +1,5 @@
 #version 330 core
 
-const int POINT_LIGHT_NUMBER = 1;
 const float PI = 3.14159265;
 
 out vec4 color;
@@ -21,28 +20,63 @@ struct Material
 	float shininess;
 };
 
+const int MAX_POINT_LIGHTS = 8;
+const int MAX_SPOT_LIGHTS = 4;
+const int MAX_DIRECTIONAL_LIGHTS = 2;
+
 struct PointLight
 {
-	//position of the light
-	vec3 position;
-	//light color
-	vec3 color;
-	//intensities
-	float ambient;
-	float diffuse;
-	float specular;
-	
-	//attenuation
-	float constant;
-    float linear;
-    float quadratic;
+	vec4 position;
+	vec4 color;
+	//ambient, diffuse, specular
+	vec4 intensities;
+	//constant, linear, quadratic
+	vec4 attenuation;
+};
+
+struct SpotLight
+{
+	vec4 position;
+	vec4 direction;
+	vec4 color;
+	vec4 intensities;
+	vec4 attenuation;
+	//inner, outer
+	vec4 cutOffs;
+};
+
+struct DirectionalLight
+{
+	vec4 direction;
+	vec4 color;
+	vec4 intensities;
+};
+
+//the lights of the frame, written once a frame (see GameEngine::LightBlock)
+layout (std140) uniform LightBlock
+{
+	PointLight pointLights[MAX_POINT_LIGHTS];
+	SpotLight spotLights[MAX_SPOT_LIGHTS];
+	DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHTS];
+	//point, spot, directional
+	ivec4 lightCounts;
+	//x the far plane of the shadow cubemap
+	vec4 shadowParams;
+};
+
+//the camera, written once a frame (see GameEngine::FrameUniforms)
+layout (std140) uniform FrameUniforms
+{
+	mat4 projection;
+	mat4 view;
+	mat4 viewProjection;
+	vec4 cameraPos;
+	vec4 frameTime;
+	mat4 inverseViewProjection;
 };
 
-uniform PointLight pointLights[POINT_LIGHT_NUMBER];
 uniform Material material;
 uniform samplerCube shadowMap;
-uniform vec3 cameraPos;
-uniform float farPlane;
 
 // array of offset direction for sampling
 vec3 gridSamplingDisk[20] = vec3[]
@@ -66,12 +100,12 @@ void main()
 	//Use the TBN matrix to transform the tangent space normal to world space
 	normal = normalize(fs_in.TBN * normal);
 	
-	vec3 viewDir = normalize(cameraPos - fs_in.position);
+	vec3 viewDir = normalize(cameraPos.xyz - fs_in.position);
 	vec3 result = vec3(0.0, 0.0, 0.0);
 	vec3 textureColor = texture(material.texture_diffuse1, fs_in.uv).rgb;
 
 	//Calc all the point lights
-	for(int i = 0; i < POINT_LIGHT_NUMBER; ++i)
+	for(int i = 0; i < lightCounts.x; ++i)
 	{
 		result += CalcPointLight(pointLights[i], normal, fs_in.position, viewDir);
 	}
@@ -90,7 +124,8 @@ float CalculateShadow(vec3 _fragPos, vec3 _lightPos)
     float bias = 0.15;
     int samples = 20;
 	
-	float viewDistance = length(cameraPos - _fragPos);
+	float farPlane = shadowParams.x;
+	float viewDistance = length(cameraPos.xyz - _fragPos);
     float diskRadius = (1.0 + (viewDistance / farPlane)) / 25.0;
 	
 	float closestDepth = 0.0f;
@@ -115,9 +150,10 @@ float CalculateShadow(vec3 _fragPos, vec3 _lightPos)
 }
 vec3 CalcPointLight(PointLight _light, vec3 _normal, vec3 _fragPos, vec3 _viewDir)
 {
-	vec3 lightDir = normalize(_light.position - _fragPos);
+	vec3 lightPosition = _light.position.xyz;
+	vec3 lightDir = normalize(lightPosition - _fragPos);
 	
-	float shadowFactor = CalculateShadow(_fragPos, _light.position);
+	float shadowFactor = CalculateShadow(_fragPos, lightPosition);
 
 	//diffuse
 	float diff = max(dot(_normal, lightDir), 0.0);
@@ -129,13 +165,13 @@ vec3 CalcPointLight(PointLight _light, vec3 _normal, vec3 _fragPos, vec3 _viewDi
 	spec = energyConservation * pow(max(dot(_normal, halfwayDir), 0.0), material.shininess); 
 	
 	//attenuation
-	float rdistance = length(_light.position - _fragPos);
-	float attenuation = 1.0f / (_light.constant + _light.linear * rdistance + _light.quadratic * (rdistance * rdistance));
+	float rdistance = length(lightPosition - _fragPos);
+	float attenuation = 1.0f / (_light.attenuation.x + _light.attenuation.y * rdistance + _light.attenuation.z * (rdistance * rdistance));
 	
 	//Combine result
-	vec3 ambient  = _light.ambient  * _light.color;
-	vec3 diffuse  = _light.diffuse  * diff * _light.color;
-	vec3 specular = _light.specular * spec * _light.color;
+	vec3 ambient  = _light.intensities.x * _light.color.rgb;
+	vec3 diffuse  = _light.intensities.y * diff * _light.color.rgb;
+	vec3 specular = _light.intensities.z * spec * _light.color.rgb;
 	
 	//ambient *= attenuation;
 	diffuse *= attenuation;
@@ -4,6 +4,8 @@ layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 normal;
 layout (location = 2) in vec2 uv;
 layout (location = 3) in vec3 tangent;
+//the model matrix of the instance in a GeometryPool draw
+layout (location = 4) in mat4 modelInstanced;
 
 out VS_OUT
 {
@@ -14,16 +16,28 @@ out VS_OUT
 
 uniform mat4 transformMatrix;
 uniform mat4 baseModelMatrix;
-uniform mat4 projection;
-uniform mat4 view;
+//the camera, written once a frame (see GameEngine::FrameUniforms)
+layout (std140) uniform FrameUniforms
+{
+	mat4 projection;
+	mat4 view;
+	mat4 viewProjection;
+	vec4 cameraPos;
+	vec4 frameTime;
+	mat4 inverseViewProjection;
+};
 
 uniform bool reverseNormals;
+uniform bool instanced;
+
+//the same position as DepthPrepass.vert, the lit pass tests GL_EQUAL against the depth of the prepass
+invariant gl_Position;
 
 void main()
 {
-	mat4 model = baseModelMatrix * transformMatrix;
+	mat4 model = instanced ? modelInstanced : baseModelMatrix * transformMatrix;
 	//the vertex position in clip space
-	gl_Position = projection * view * model * vec4(position, 1.0);
+	gl_Position = viewProjection * model * vec4(position, 1.0);
 	
 	//get the normal model matrix
 	mat3 normalMatrix = mat3(transpose(inverse(model)));
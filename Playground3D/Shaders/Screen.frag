@@ -0,0 +1,16 @@
+#version 330 core
+
+uniform sampler2D screenTexture;
+
+in VS_OUT
+{
+	vec2 uv;
+} fs_in;
+
+out vec4 color;
+
+//copies a post-processing target to the screen
+void main()
+{
+	color = vec4(texture(screenTexture, fs_in.uv).rgb, 1.0);
+}
@@ -13,8 +13,50 @@ in vec4 worldSpacePos; //position of the fragment in world space (output per emi
 
 out vec4 color;
 
-uniform vec3 lightPos;
-uniform float farPlane;
+const int MAX_POINT_LIGHTS = 8;
+const int MAX_SPOT_LIGHTS = 4;
+const int MAX_DIRECTIONAL_LIGHTS = 2;
+
+struct PointLight
+{
+	vec4 position;
+	vec4 color;
+	//ambient, diffuse, specular
+	vec4 intensities;
+	//constant, linear, quadratic
+	vec4 attenuation;
+};
+
+struct SpotLight
+{
+	vec4 position;
+	vec4 direction;
+	vec4 color;
+	vec4 intensities;
+	vec4 attenuation;
+	//inner, outer
+	vec4 cutOffs;
+};
+
+struct DirectionalLight
+{
+	vec4 direction;
+	vec4 color;
+	vec4 intensities;
+};
+
+//the lights of the frame, written once a frame (see GameEngine::LightBlock)
+layout (std140) uniform LightBlock
+{
+	PointLight pointLights[MAX_POINT_LIGHTS];
+	SpotLight spotLights[MAX_SPOT_LIGHTS];
+	DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHTS];
+	//point, spot, directional
+	ivec4 lightCounts;
+	//x the far plane of the shadow cubemap
+	vec4 shadowParams;
+};
+
 uniform Material material;
 
 void main()
@@ -22,10 +64,11 @@ void main()
 	//why am I forced to use shininess ?????
 	float annoying = material.shininess;
     // get distance between fragment and light source
-	float lightDistance = length(worldSpacePos.xyz - lightPos);
+	//the cubemap is the shadow of the first point light
+	float lightDistance = length(worldSpacePos.xyz - pointLights[0].position.xyz);
 	
 	// map to [0;1] range by dividing by farPlane
-    lightDistance = lightDistance / farPlane;
+    lightDistance = lightDistance / shadowParams.x;
 	
 	//write this as modified depth
 	gl_FragDepth = lightDistance;
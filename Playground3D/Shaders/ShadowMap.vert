@@ -1,11 +1,14 @@
 #version 330 core
 layout (location = 0) in vec3 position;
+//the model matrix of the instance in a GeometryPool draw
+layout (location = 4) in mat4 modelInstanced;
 
 uniform mat4 transformMatrix;
 uniform mat4 baseModelMatrix;
+uniform bool instanced;
 
 void main()
 {
-	mat4 model = baseModelMatrix * transformMatrix;
+	mat4 model = instanced ? modelInstanced : baseModelMatrix * transformMatrix;
     gl_Position = model * vec4(position, 1.0);
 }  
\ No newline at end of file
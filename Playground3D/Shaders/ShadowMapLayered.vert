@@ -0,0 +1,21 @@
+#version 330 core
+//gl_Layer in the vertex shader, see GameEngine::RenderQueue3D::IsLayeredSupported
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+layout (location = 0) in vec3 position;
+
+uniform mat4 transformMatrix;
+uniform mat4 baseModelMatrix;
+uniform mat4 shadowMatrices[6]; //The matrices to transform to light space
+//the cube faces the draw reaches, 3 bits each: instance i renders face (layerFaces >> (3 * i)) & 7 (see RenderQueue3D::ExecuteLayered)
+uniform int layerFaces;
+
+out vec4 worldSpacePos; //position of the fragment in world space
+
+void main()
+{
+	int face = (layerFaces >> (3 * gl_InstanceID)) & 7;
+	worldSpacePos = baseModelMatrix * transformMatrix * vec4(position, 1.0);
+	gl_Position = shadowMatrices[face] * worldSpacePos;
+	gl_Layer = face;
+}
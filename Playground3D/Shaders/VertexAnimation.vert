@@ -0,0 +1,45 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 uv;
+layout (location = 4) in mat4 modelInstanced;
+layout (location = 8) in float timeOffset;
+
+out VS_OUT
+{
+	vec3 position;
+	vec3 normal;
+	vec2 uv;
+} vs_out;
+
+uniform mat4 baseModelMatrix;
+uniform mat4 projection;
+uniform mat4 view;
+
+//the baked clip (see GameEngine::VertexAnimationTexture), a column per vertex, a row of positions then a row of normals per frame
+uniform sampler2D vatTexture;
+uniform int vatVertexOffset;
+uniform int vatNumFrames;
+uniform float vatFramesPerSecond;
+uniform float vatTime;
+
+void main()
+{
+	//the two frames around the time of this instance, the clip loops
+	float frame = mod((vatTime + timeOffset) * vatFramesPerSecond, float(vatNumFrames));
+	int frame0 = int(frame);
+	int frame1 = (frame0 + 1) % vatNumFrames;
+	float factor = fract(frame);
+	int column = vatVertexOffset + gl_VertexID;
+
+	vec3 animPosition = mix(texelFetch(vatTexture, ivec2(column, frame0 * 2), 0).xyz, texelFetch(vatTexture, ivec2(column, frame1 * 2), 0).xyz, factor);
+	vec3 animNormal = mix(texelFetch(vatTexture, ivec2(column, frame0 * 2 + 1), 0).xyz, texelFetch(vatTexture, ivec2(column, frame1 * 2 + 1), 0).xyz, factor);
+
+	mat4 model = baseModelMatrix * modelInstanced;
+	//the vertex position in clip space
+	gl_Position = projection * view * model * vec4(animPosition, 1.0);
+	vs_out.normal = mat3(transpose(inverse(model))) * normalize(animNormal);
+	vs_out.position = vec3(model * vec4(animPosition, 1.0));
+	vs_out.uv = uv;
+}
@@ -0,0 +1,103 @@
+#include "SnapshotInterpolator.h"
+
+#include <glm\gtc\quaternion.hpp>
+
+namespace
+{
+  //how fast the smoothed values follow, per snapshot
+  constexpr double INTERVAL_SMOOTHING{ 0.1 };
+  constexpr double OFFSET_DRIFT{ 0.01 };
+}
+
+void SnapshotInterpolator::Clear()
+{
+  m_first = 0;
+  m_count = 0;
+  m_clockOffset = 0.0;
+  m_interval = 0.0;
+}
+
+void SnapshotInterpolator::Push(const Snapshot& _snapshot, double _remoteTime, double _now)
+{
+  const double offset = _now - _remoteTime;
+  if (m_count == 0)
+  {
+    m_clockOffset = offset;
+  }
+  else
+  {
+    const double interval = _remoteTime - GetEntry(m_count - 1).time;
+    if (interval <= 0.0)
+    {
+      return;
+    }
+    m_interval = m_interval == 0.0 ? interval : m_interval + (interval - m_interval) * INTERVAL_SMOOTHING;
+    //a faster packet is closer to the real offset, a slower one only moves it a little (the clocks drift)
+    m_clockOffset = offset < m_clockOffset ? offset : m_clockOffset + (offset - m_clockOffset) * OFFSET_DRIFT;
+  }
+
+  if (m_count == CAPACITY)
+  {
+    m_first = (m_first + 1) % CAPACITY;
+    m_count--;
+  }
+  Entry& entry = m_entries[(m_first + m_count++) % CAPACITY];
+  entry.time = _remoteTime;
+  entry.entities.clear();
+  for (const QuantizedEntityState& entity : _snapshot.entities)
+  {
+    entry.entities.push_back(NetProtocol::Dequantize(entity));
+  }
+}
+
+bool SnapshotInterpolator::Sample(double _now, std::vector<EntityState>& _entities) const
+{
+  _entities.clear();
+  if (m_count == 0)
+  {
+    return false;
+  }
+  const double renderTime = _now - m_clockOffset - GetDelay();
+
+  //the last snapshot at or before the render time, the first one if they're all after it
+  size_t from = 0;
+  while (from + 1 < m_count && GetEntry(from + 1).time <= renderTime)
+  {
+    from++;
+  }
+  const Entry& a = GetEntry(from);
+  if (from + 1 == m_count || renderTime <= a.time)
+  {
+    _entities = a.entities;
+    return true;
+  }
+
+  const Entry& b = GetEntry(from + 1);
+  const float t = static_cast<float>((renderTime - a.time) / (b.time - a.time));
+  //both are sorted by id, an entity only in the later one shows as it is there and one only in the earlier one is gone
+  auto itA = a.entities.begin();
+  for (const EntityState& to : b.entities)
+  {
+    while (itA != a.entities.end() && itA->id < to.id)
+    {
+      ++itA;
+    }
+    if (itA == a.entities.end() || itA->id != to.id)
+    {
+      _entities.push_back(to);
+      continue;
+    }
+    EntityState entity;
+    entity.id = to.id;
+    entity.position = itA->position + (to.position - itA->position) * t;
+    entity.orientation = glm::slerp(itA->orientation, to.orientation, t);
+    _entities.push_back(entity);
+  }
+  return true;
+}
+
+double SnapshotInterpolator::GetDelay() const noexcept
+{
+  const double delay = m_interval * DELAY_INTERVALS;
+  return delay > MIN_DELAY ? delay : MIN_DELAY;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "NetProtocol.h"
+
+/** \brief Shows the remote entities a little in the past, between the two snapshots around that time, so they move smoothly however
+* the packets come. The delay holds a few snapshot intervals (at least MIN_DELAY), so one lost or late snapshot is bridged by the
+* next. The time of a snapshot is the sender's, it's mapped to the local clock by the smallest offset seen (the fastest packet),
+* which then follows the drift of the clocks slowly. Past the newest snapshot the entities stay where it has them */
+class SnapshotInterpolator
+{
+public:
+  static constexpr size_t CAPACITY{ 32 };
+  // In seconds
+  static constexpr double MIN_DELAY{ 0.1 };
+  // The snapshot intervals the delay holds
+  static constexpr double DELAY_INTERVALS{ 2.5 };
+
+  void Clear();
+  // A snapshot taken at _remoteTime on the sender's clock, received at _now (seconds). One not newer than the last is ignored
+  void Push(const Snapshot& _snapshot, double _remoteTime, double _now);
+  // The entities at _now minus the delay, false if no snapshot came yet
+  bool Sample(double _now, std::vector<EntityState>& _entities) const;
+
+  double GetDelay() const noexcept;
+
+private:
+  struct Entry
+  {
+    double time = 0.0;                    ///< on the sender's clock
+    std::vector<EntityState> entities;    ///< sorted by id
+  };
+  const Entry& GetEntry(size_t _index) const { return m_entries[(m_first + _index) % CAPACITY]; }
+
+  Entry m_entries[CAPACITY];  ///< a ring, oldest first
+  size_t m_first = 0;
+  size_t m_count = 0;
+  double m_clockOffset = 0.0; ///< the local time minus the sender's
+  double m_interval = 0.0;    ///< between snapshots, smoothed
+};
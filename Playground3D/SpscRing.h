@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// A ring of preallocated items between one producer thread and one consumer thread, without locks: the producer fills the item
+// BeginPush gives it and publishes it with EndPush, the consumer reads Front and gives it back with Pop. Nothing is allocated or
+// copied by the ring, the items are reused in place. Capacity is a power of two
+template <typename T, size_t Capacity>
+class SpscRing
+{
+  static_assert((Capacity & (Capacity - 1)) == 0, "SpscRing: the capacity has to be a power of two");
+
+public:
+  // Producer: the next free item, nullptr if the ring is full
+  T* BeginPush()
+  {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+    {
+      return nullptr;
+    }
+    return &m_items[tail & (Capacity - 1)];
+  }
+  // Producer: publishes the item of BeginPush
+  void EndPush() { m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  // Consumer: the oldest item, nullptr if the ring is empty
+  T* Front()
+  {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire))
+    {
+      return nullptr;
+    }
+    return &m_items[head & (Capacity - 1)];
+  }
+  // Consumer: gives the item of Front back to the producer
+  void Pop() { m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+private:
+  std::atomic<size_t> m_head{ 0 }; ///< written by the consumer
+  // Padded to their own cache lines, the two threads don't invalidate each other's (not alignas, the ring is allocated with new)
+  char m_padding[64];
+  std::atomic<size_t> m_tail{ 0 }; ///< written by the producer
+  char m_itemsPadding[64];
+  T m_items[Capacity];
+};